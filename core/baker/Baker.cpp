@@ -0,0 +1,75 @@
+#include "Application.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    const char* StoreKey = "baker";
+
+    const char* Usage =
+        "Builds meshes of all quadkeys in bounding box and writes them to mesh package.\n"
+        "Usage: UtyMap.Baker --style <mapcss> --bbox <minLat,minLon,maxLat,maxLon> --lod <start,end>\n"
+        "                    --output <package> [--data <file>] [--store <directory>]\n"
+        "                    [--strings <directory>] [--elevation <directory>] [--threads <count>]\n";
+
+    bool hasErrors = false;
+
+    void onError(const char* message)
+    {
+        hasErrors = true;
+        std::cerr << message << std::endl;
+    }
+
+    /// Parses comma separated list of numbers.
+    template <typename T>
+    std::vector<T> parseList(const std::string& value)
+    {
+        std::vector<T> values;
+        std::stringstream ss(value);
+        std::string item;
+        while (std::getline(ss, item, ','))
+            values.push_back(static_cast<T>(std::atof(item.c_str())));
+        return values;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::map<std::string, std::string> options = {
+        { "--strings", "." }, { "--elevation", "." },
+        { "--threads", std::to_string(std::max(1u, std::thread::hardware_concurrency())) }
+    };
+    for (int i = 1; i + 1 < argc; i += 2)
+        options[argv[i]] = argv[i + 1];
+
+    auto bbox = parseList<double>(options["--bbox"]);
+    auto lods = parseList<int>(options["--lod"]);
+    const auto& style = options["--style"];
+    const auto& output = options["--output"];
+    if (argc % 2 == 0 || bbox.size() != 4 || lods.size() != 2 || style.empty() || output.empty() ||
+        (options["--data"].empty() && options["--store"].empty())) {
+        std::cerr << Usage;
+        return 1;
+    }
+
+    Application application(options["--strings"].c_str(), options["--elevation"].c_str(), onError);
+    utymap::BoundingBox boundingBox(utymap::GeoCoordinate(bbox[0], bbox[1]), utymap::GeoCoordinate(bbox[2], bbox[3]));
+    utymap::LodRange range(lods[0], lods[1]);
+
+    if (!options["--store"].empty()) {
+        application.registerPersistentStore(StoreKey, options["--store"].c_str());
+    } else {
+        application.registerInMemoryStore(StoreKey);
+        application.addToStore(StoreKey, style.c_str(), options["--data"].c_str(), boundingBox, range, onError);
+    }
+
+    application.bakeMeshPackage(style.c_str(), boundingBox, range, output.c_str(),
+                                std::atoi(options["--threads"].c_str()), onError);
+    return hasErrors ? 1 : 0;
+}
@@ -0,0 +1,196 @@
+#ifndef BENCHMARKS_BENCHMARK_HPP_DEFINED
+#define BENCHMARKS_BENCHMARK_HPP_DEFINED
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <ctime>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace utymap { namespace benchmarks {
+
+/// Keeps value alive, so compiler cannot remove computation of it.
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+    static volatile const void* sink;
+    sink = &value;
+}
+
+/// Runs registered benchmarks and writes their results as json.
+class BenchmarkRunner final
+{
+public:
+    /// Runs given amount of operations.
+    typedef std::function<void(std::size_t)> Body;
+    /// Prepares benchmark state and returns benchmark body. It is not measured.
+    typedef std::function<Body()> Setup;
+
+    /// Registers benchmark: body is run given amount of repetitions with given amount
+    /// of operations each time.
+    void add(const std::string& name, std::size_t operations, std::size_t repetitions, const Setup& setup)
+    {
+        benchmarks_.push_back(Benchmark { name, operations, repetitions, setup });
+    }
+
+    /// Runs benchmarks which name contains filter and writes results to output in json schema
+    /// of Google Benchmark: every repetition is reported as iteration run followed by mean,
+    /// median, stddev and p95 aggregates, so results can be compared by compare.py.
+    void run(const std::string& filter, std::ostream& output) const
+    {
+        output << "{\n  \"context\": ";
+        writeContext(output);
+        output << ",\n  \"benchmarks\": [";
+        bool isFirst = true;
+        for (const auto& benchmark : benchmarks_) {
+            if (benchmark.name.find(filter) == std::string::npos)
+                continue;
+
+            auto body = benchmark.setup();
+            // NOTE first run warms up caches and is not measured.
+            body(1);
+
+            std::vector<Measurement> measurements;
+            for (std::size_t i = 0; i < benchmark.repetitions; ++i) {
+                std::clock_t cpuStart = std::clock();
+                auto start = std::chrono::steady_clock::now();
+                body(benchmark.operations);
+                auto end = std::chrono::steady_clock::now();
+                std::clock_t cpuEnd = std::clock();
+                measurements.push_back(Measurement {
+                    std::chrono::duration<double, std::nano>(end - start).count() / benchmark.operations,
+                    1E9 * (cpuEnd - cpuStart) / CLOCKS_PER_SEC / benchmark.operations });
+            }
+
+            for (std::size_t i = 0; i < measurements.size(); ++i) {
+                output << (isFirst ? "\n" : ",\n");
+                writeRun(output, benchmark, measurements[i], i);
+                isFirst = false;
+            }
+            writeAggregates(output, benchmark, measurements);
+            output.flush();
+        }
+        output << "\n  ]\n}\n";
+    }
+
+private:
+    struct Benchmark final
+    {
+        std::string name;
+        std::size_t operations;
+        std::size_t repetitions;
+        Setup setup;
+    };
+
+    /// Time of single operation in nanoseconds.
+    struct Measurement final
+    {
+        double realTime;
+        double cpuTime;
+    };
+
+    static void writeContext(std::ostream& output)
+    {
+        char date[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+#ifdef NDEBUG
+        const char* buildType = "release";
+#else
+        const char* buildType = "debug";
+#endif
+        output << "{ \"date\": \"" << date << "\""
+               << ", \"executable\": \"UtyMap.Benchmarks\""
+               << ", \"num_cpus\": " << std::max(1u, std::thread::hardware_concurrency())
+               << ", \"library_build_type\": \"" << buildType << "\" }";
+    }
+
+    static void writeRun(std::ostream& output, const Benchmark& benchmark, const Measurement& measurement,
+                         std::size_t index)
+    {
+        output << "    { \"name\": \"" << benchmark.name << "\""
+               << ", \"run_name\": \"" << benchmark.name << "\""
+               << ", \"run_type\": \"iteration\""
+               << ", \"repetitions\": " << benchmark.repetitions
+               << ", \"repetition_index\": " << index
+               << ", \"threads\": 1"
+               << ", \"iterations\": " << benchmark.operations
+               << ", \"real_time\": " << measurement.realTime
+               << ", \"cpu_time\": " << measurement.cpuTime
+               << ", \"time_unit\": \"ns\" }";
+    }
+
+    static void writeAggregate(std::ostream& output, const Benchmark& benchmark, const std::string& aggregate,
+                               const Measurement& measurement)
+    {
+        output << ",\n    { \"name\": \"" << benchmark.name << "_" << aggregate << "\""
+               << ", \"run_name\": \"" << benchmark.name << "\""
+               << ", \"run_type\": \"aggregate\""
+               << ", \"repetitions\": " << benchmark.repetitions
+               << ", \"threads\": 1"
+               << ", \"aggregate_name\": \"" << aggregate << "\""
+               << ", \"iterations\": " << benchmark.repetitions
+               << ", \"real_time\": " << measurement.realTime
+               << ", \"cpu_time\": " << measurement.cpuTime
+               << ", \"time_unit\": \"ns\" }";
+    }
+
+    static void writeAggregates(std::ostream& output, const Benchmark& benchmark,
+                                const std::vector<Measurement>& measurements)
+    {
+        std::vector<double> realTimes, cpuTimes;
+        for (const auto& measurement : measurements) {
+            realTimes.push_back(measurement.realTime);
+            cpuTimes.push_back(measurement.cpuTime);
+        }
+        std::sort(realTimes.begin(), realTimes.end());
+        std::sort(cpuTimes.begin(), cpuTimes.end());
+
+        writeAggregate(output, benchmark, "mean", Measurement { getMean(realTimes), getMean(cpuTimes) });
+        writeAggregate(output, benchmark, "median", Measurement { getPercentile(realTimes, 50), getPercentile(cpuTimes, 50) });
+        writeAggregate(output, benchmark, "stddev", Measurement { getStdDev(realTimes), getStdDev(cpuTimes) });
+        writeAggregate(output, benchmark, "p95", Measurement { getPercentile(realTimes, 95), getPercentile(cpuTimes, 95) });
+    }
+
+    static double getMean(const std::vector<double>& values)
+    {
+        double sum = 0;
+        for (double value : values)
+            sum += value;
+        return sum / values.size();
+    }
+
+    static double getStdDev(const std::vector<double>& values)
+    {
+        if (values.size() < 2)
+            return 0;
+        double mean = getMean(values), sum = 0;
+        for (double value : values)
+            sum += (value - mean) * (value - mean);
+        return std::sqrt(sum / (values.size() - 1));
+    }
+
+    /// Returns percentile of sorted values using nearest rank.
+    static double getPercentile(const std::vector<double>& values, double percent)
+    {
+        std::size_t rank = static_cast<std::size_t>(std::ceil(percent / 100 * values.size()));
+        return values[std::max<std::size_t>(rank, 1) - 1];
+    }
+
+    std::vector<Benchmark> benchmarks_;
+};
+
+/// Registers benchmarks of separate components.
+void registerMicroBenchmarks(BenchmarkRunner& runner, const std::string& workDirectory);
+
+/// Registers benchmarks of import and quadkey build using test data.
+void registerMacroBenchmarks(BenchmarkRunner& runner, const std::string& workDirectory);
+
+}}
+
+#endif // BENCHMARKS_BENCHMARK_HPP_DEFINED
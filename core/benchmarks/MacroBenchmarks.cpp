@@ -0,0 +1,63 @@
+#include "Benchmark.hpp"
+#include "config.hpp"
+
+#include "Application.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace utymap::benchmarks;
+
+namespace {
+    const char* StoreKey = "benchmark";
+    /// Quadkey in the center of test data.
+    const utymap::QuadKey BenchmarkQuadKey(16, 35205, 21489);
+
+    void onError(const char* message)
+    {
+        throw std::runtime_error(message);
+    }
+
+    void onMesh(const char*, const double*, int, const int*, int, const int*, int, const double*, int)
+    {
+    }
+
+    void onElement(std::uint64_t, const char**, int, const double*, int, const char**, int)
+    {
+    }
+
+    std::unique_ptr<Application> createApplication(const std::string& workDirectory)
+    {
+        auto application = utymap::utils::make_unique<Application>(workDirectory.c_str(), TEST_ELEVATION_DIRECTORY, onError);
+        application->registerInMemoryStore(StoreKey);
+        return application;
+    }
+}
+
+namespace utymap { namespace benchmarks {
+
+void registerMacroBenchmarks(BenchmarkRunner& runner, const std::string& workDirectory)
+{
+    runner.add("Import.pbf.quadkey", 1, 3, [=]() {
+        return [=](std::size_t operations) {
+            for (std::size_t i = 0; i < operations; ++i) {
+                auto application = createApplication(workDirectory);
+                application->addToStore(StoreKey, TEST_MAPCSS_DEFAULT, TEST_PBF_FILE, BenchmarkQuadKey, onError);
+            }
+        };
+    });
+
+    // NOTE every repetition builds single tile, so p95 aggregate is p95 of tile build time.
+    runner.add("QuadKeyBuilder.build.xml", 1, 20, [=]() {
+        std::shared_ptr<Application> application = createApplication(workDirectory);
+        application->addToStore(StoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, BenchmarkQuadKey, onError);
+        application->preloadElevation(BenchmarkQuadKey);
+        return [=](std::size_t operations) {
+            for (std::size_t i = 0; i < operations; ++i)
+                application->loadQuadKey(TEST_MAPCSS_DEFAULT, BenchmarkQuadKey, onMesh, onElement, onError);
+        };
+    });
+}
+
+}}
@@ -0,0 +1,221 @@
+#include "Benchmark.hpp"
+#include "config.hpp"
+
+#include "QuadKey.hpp"
+#include "builders/BuilderContext.hpp"
+#include "builders/terrain/LineGridSplitter.hpp"
+#include "builders/terrain/TerraBuilder.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "heightmap/FlatElevationProvider.hpp"
+#include "heightmap/SrtmElevationProvider.hpp"
+#include "index/PolygonSplitter.hpp"
+#include "index/StringTable.hpp"
+#include "mapcss/ColorGradient.hpp"
+#include "mapcss/MapCssParser.hpp"
+#include "mapcss/StyleProvider.hpp"
+#include "meshing/MeshBuilder.hpp"
+#include "meshing/Polygon.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::benchmarks;
+using namespace utymap::builders;
+using namespace utymap::entities;
+using namespace utymap::heightmap;
+using namespace utymap::index;
+using namespace utymap::mapcss;
+using namespace utymap::meshing;
+
+namespace {
+    /// NOTE generator is seeded with constant, so every run uses the same data.
+    const unsigned Seed = 42;
+    const std::size_t StringCount = 10000;
+    const int LevelOfDetail = 16;
+
+    /// Returns strings which look like tag values: some of them are numbers.
+    std::vector<std::string> createStrings()
+    {
+        std::mt19937 generator(Seed);
+        std::uniform_int_distribution<int> distribution(0, 1000000);
+        std::vector<std::string> strings;
+        strings.reserve(StringCount);
+        for (std::size_t i = 0; i < StringCount; ++i)
+            strings.push_back((i % 3 == 0 ? "" : "value_") + std::to_string(distribution(generator)));
+        return strings;
+    }
+
+    StyleSheet parseDefaultStylesheet()
+    {
+        std::string path = TEST_MAPCSS_DEFAULT;
+        std::ifstream file(path);
+        return MapCssParser(path.substr(0, path.find_last_of("\\/") + 1)).parse(file);
+    }
+
+    void registerStringTable(BenchmarkRunner& runner, const std::string& workDirectory)
+    {
+        runner.add("StringTable.getId.existing", StringCount * 10, 5, [=]() {
+            auto stringTable = std::make_shared<StringTable>(workDirectory);
+            auto strings = std::make_shared<std::vector<std::string>>(createStrings());
+            for (const auto& string : *strings)
+                stringTable->getId(string);
+            return [=](std::size_t operations) {
+                for (std::size_t i = 0; i < operations; ++i)
+                    doNotOptimize(stringTable->getId((*strings)[i % strings->size()]));
+            };
+        });
+
+        runner.add("StringTable.getString", StringCount * 10, 5, [=]() {
+            auto stringTable = std::make_shared<StringTable>(workDirectory);
+            for (const auto& string : createStrings())
+                stringTable->getId(string);
+            return [=](std::size_t operations) {
+                for (std::size_t i = 0; i < operations; ++i)
+                    doNotOptimize(stringTable->getString(static_cast<std::uint32_t>(i % StringCount)));
+            };
+        });
+    }
+
+    void registerStyleProvider(BenchmarkRunner& runner, const std::string& workDirectory)
+    {
+        runner.add("StyleProvider.forElement.building", 10000, 5, [=]() {
+            auto stringTable = std::make_shared<StringTable>(workDirectory);
+            auto styleProvider = std::make_shared<StyleProvider>(parseDefaultStylesheet(), *stringTable);
+            auto area = std::make_shared<Area>();
+            area->id = 1;
+            area->tags = {
+                Tag(stringTable->getId("building"), stringTable->getId("yes")),
+                Tag(stringTable->getId("height"), stringTable->getId("20")),
+                Tag(stringTable->getId("roof:shape"), stringTable->getId("flat"))
+            };
+            return [=](std::size_t operations) {
+                for (std::size_t i = 0; i < operations; ++i)
+                    doNotOptimize(styleProvider->forElement(*area, LevelOfDetail));
+            };
+        });
+    }
+
+    void registerMeshBuilder(BenchmarkRunner& runner)
+    {
+        runner.add("MeshBuilder.addPolygon", 100, 5, []() {
+            auto eleProvider = std::make_shared<FlatElevationProvider>();
+            auto builder = std::make_shared<MeshBuilder>(QuadKey(1, 1, 0), *eleProvider);
+            auto gradient = std::make_shared<ColorGradient>();
+            return [=](std::size_t operations) {
+                MeshBuilder::GeometryOptions geometryOptions(1, 0, 0, 0);
+                MeshBuilder::AppearanceOptions appearanceOptions(*gradient, 0, TextureRegion(), 0);
+                for (std::size_t i = 0; i < operations; ++i) {
+                    Mesh mesh("");
+                    Polygon polygon(8, 1);
+                    polygon.addContour({ Vector2(0, 0), Vector2(20, 0), Vector2(20, 20), Vector2(0, 20) });
+                    polygon.addHole({ Vector2(5, 5), Vector2(5, 15), Vector2(15, 15), Vector2(15, 5) });
+                    builder->addPolygon(mesh, polygon, geometryOptions, appearanceOptions);
+                    doNotOptimize(mesh.triangles.size());
+                }
+            };
+        });
+    }
+
+    void registerLineGridSplitter(BenchmarkRunner& runner)
+    {
+        runner.add("LineGridSplitter.split", 10000, 5, []() {
+            return [](std::size_t operations) {
+                const double scale = 1E7;
+                LineGridSplitter splitter;
+                splitter.setParams(scale, 0.001);
+                std::vector<Vector2> result;
+                for (std::size_t i = 0; i < operations; ++i) {
+                    result.clear();
+                    splitter.split(ClipperLib::IntPoint(134000000, 525000000),
+                                   ClipperLib::IntPoint(134100000 + static_cast<int>(i % 100), 525070000), result);
+                    doNotOptimize(result.size());
+                }
+            };
+        });
+    }
+
+    /// Builds terrain of tile with large water polygon which is kept whole or split by store.
+    void registerTerraBuilder(BenchmarkRunner& runner, const std::string& workDirectory)
+    {
+        const std::string stylesheet =
+            "canvas|z10 { grid-cell-size: 1%; layer-priority: water; ele-noise-freq: 0; color-noise-freq: 0;"
+            "color:gradient(red); max-area: 5%; water-ele-noise-freq: 0; water-color-noise-freq: 0;"
+            "water-color:gradient(blue); water-max-area: 5%; }"
+            "relation|z10[natural=water], area|z10[natural=water] { builders:terrain; terrain-layer:water; }";
+        const QuadKey quadKey(10, 550, 335);
+        const std::size_t vertexCount = 8000;
+
+        for (bool isSplit : { false, true }) {
+            runner.add(isSplit ? "TerraBuilder.complete.pieces" : "TerraBuilder.complete.whole", 1, 10, [=]() {
+                auto stringTable = std::make_shared<StringTable>(workDirectory);
+                auto styleProvider = std::make_shared<StyleProvider>(MapCssParser().parse(stylesheet), *stringTable);
+                auto eleProvider = std::make_shared<FlatElevationProvider>();
+
+                // NOTE polygon is jagged circle inside tile, so its pieces have many vertices too.
+                BoundingBox bbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey);
+                GeoCoordinate center = bbox.center();
+                double radius = (bbox.maxPoint.latitude - bbox.minPoint.latitude) * 0.45;
+                auto area = std::make_shared<Area>();
+                area->tags = { Tag(stringTable->getId("natural"), stringTable->getId("water")) };
+                for (std::size_t i = 0; i < vertexCount; ++i) {
+                    double angle = 2 * M_PI * i / vertexCount;
+                    double r = radius * (i % 2 == 0 ? 1 : 0.97);
+                    area->coordinates.push_back(GeoCoordinate(center.latitude + r * std::sin(angle),
+                                                              center.longitude + r * std::cos(angle)));
+                }
+                std::shared_ptr<Element> element = area;
+                if (isSplit)
+                    element = utymap::index::PolygonSplitter(500).split(*area, quadKey);
+
+                return [=](std::size_t operations) {
+                    for (std::size_t i = 0; i < operations; ++i) {
+                        std::size_t triangles = 0;
+                        BuilderContext context(quadKey, *styleProvider, *stringTable, *eleProvider,
+                            [&](const Mesh& mesh) { triangles += mesh.triangles.size(); }, nullptr);
+                        TerraBuilder builder(context);
+                        element->accept(builder);
+                        builder.complete();
+                        doNotOptimize(triangles);
+                    }
+                };
+            });
+        }
+    }
+
+    void registerSrtm(BenchmarkRunner& runner)
+    {
+        runner.add("SrtmElevationProvider.getElevation", 100000, 5, []() {
+            auto eleProvider = std::make_shared<SrtmElevationProvider>(TEST_ELEVATION_DIRECTORY);
+            auto bbox = BoundingBox(GeoCoordinate(52.4, 13.3), GeoCoordinate(52.6, 13.5));
+            eleProvider->preload(bbox);
+            return [=](std::size_t operations) {
+                std::mt19937 generator(Seed);
+                std::uniform_real_distribution<double> latitude(bbox.minPoint.latitude, bbox.maxPoint.latitude);
+                std::uniform_real_distribution<double> longitude(bbox.minPoint.longitude, bbox.maxPoint.longitude);
+                for (std::size_t i = 0; i < operations; ++i)
+                    doNotOptimize(eleProvider->getElevation(latitude(generator), longitude(generator)));
+            };
+        });
+    }
+}
+
+namespace utymap { namespace benchmarks {
+
+void registerMicroBenchmarks(BenchmarkRunner& runner, const std::string& workDirectory)
+{
+    registerStringTable(runner, workDirectory);
+    registerStyleProvider(runner, workDirectory);
+    registerMeshBuilder(runner);
+    registerLineGridSplitter(runner);
+    registerTerraBuilder(runner, workDirectory);
+    registerSrtm(runner);
+}
+
+}}
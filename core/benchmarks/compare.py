@@ -0,0 +1,62 @@
+#!/usr/bin/env python
+"""Compares two results of UtyMap.Benchmarks (or any Google Benchmark json output).
+
+Prints relative change of every aggregate present in both files and fails if change of
+gated aggregate exceeds threshold for benchmarks which name contains filter:
+
+    compare.py baseline.json contender.json --aggregate p95 --filter QuadKeyBuilder --threshold 5
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        results = json.load(f)
+    runs = {}
+    for run in results['benchmarks']:
+        key = (run['run_name'], run.get('aggregate_name', 'repetition %d' % run.get('repetition_index', 0)))
+        runs[key] = run
+    return runs
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compares two benchmark results.')
+    parser.add_argument('baseline', help='json results of baseline build')
+    parser.add_argument('contender', help='json results of contender build')
+    parser.add_argument('--aggregate', default='p95', help='aggregate which is gated (default: p95)')
+    parser.add_argument('--filter', default='', help='substring of gated benchmark names')
+    parser.add_argument('--threshold', type=float, default=5.0,
+                        help='max allowed increase of gated real time in percent (default: 5)')
+    parser.add_argument('--all', action='store_true', help='print every repetition, not only aggregates')
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    contender = load(args.contender)
+
+    regressions = []
+    print('%-48s %-10s %14s %14s %9s' % ('Benchmark', 'Aggregate', 'Baseline ns', 'Contender ns', 'Change'))
+    for key in sorted(baseline):
+        if key not in contender:
+            continue
+        name, aggregate = key
+        if not args.all and baseline[key]['run_type'] != 'aggregate':
+            continue
+
+        old = baseline[key]['real_time']
+        new = contender[key]['real_time']
+        change = (new - old) / old * 100 if old > 0 else 0.0
+        print('%-48s %-10s %14.1f %14.1f %+8.1f%%' % (name, aggregate, old, new, change))
+
+        if aggregate == args.aggregate and args.filter in name and change > args.threshold:
+            regressions.append((name, change))
+
+    for name, change in regressions:
+        print('Regression: %s %s is %.1f%% slower (threshold %.1f%%)' % (name, args.aggregate, change, args.threshold))
+    return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,51 @@
+#include "Benchmark.hpp"
+
+#include <boost/filesystem/operations.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+using namespace utymap::benchmarks;
+
+namespace {
+    const char* Usage =
+        "Runs benchmarks and writes results in Google Benchmark json format, see compare.py.\n"
+        "Usage: UtyMap.Benchmarks [--filter <substring>] [--output <file>] [--work <directory>]\n";
+}
+
+int main(int argc, char* argv[])
+{
+    std::map<std::string, std::string> options = { { "--work", "benchmark_data" } };
+    for (int i = 1; i + 1 < argc; i += 2)
+        options[argv[i]] = argv[i + 1];
+    if (argc % 2 == 0) {
+        std::cerr << Usage;
+        return 1;
+    }
+
+    std::string workDirectory = options["--work"] + "/";
+    boost::filesystem::remove_all(workDirectory);
+    boost::filesystem::create_directories(workDirectory);
+
+    BenchmarkRunner runner;
+    registerMicroBenchmarks(runner, workDirectory);
+    registerMacroBenchmarks(runner, workDirectory);
+
+    try {
+        if (options["--output"].empty()) {
+            runner.run(options["--filter"], std::cout);
+        } else {
+            std::ofstream output(options["--output"]);
+            runner.run(options["--filter"], output);
+        }
+    }
+    catch (std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return 1;
+    }
+
+    boost::filesystem::remove_all(workDirectory);
+    return 0;
+}
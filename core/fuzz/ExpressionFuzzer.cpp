@@ -0,0 +1,34 @@
+#include "FuzzUtils.hpp"
+#include "entities/Element.hpp"
+#include "index/StringTable.hpp"
+#include "mapcss/StyleEvaluator.hpp"
+
+using namespace utymap::entities;
+using namespace utymap::index;
+using namespace utymap::mapcss;
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size)
+{
+    static const std::string directory = [] {
+        std::string path = utymap::fuzz::getTempPath("expression");
+        boost::filesystem::create_directories(path);
+        return path + "/";
+    }();
+    static StringTable stringTable(directory);
+    static const std::vector<Tag> tags = {
+        Tag(stringTable.getId("height"), stringTable.getId("10")),
+        Tag(stringTable.getId("min_height"), stringTable.getId("2"))
+    };
+
+    std::string expression(reinterpret_cast<const char*>(data), size);
+    try {
+        StyleEvaluator::parse(expression);
+        auto program = StyleEvaluator::compile(expression, stringTable);
+        if (program != nullptr)
+            StyleEvaluator::evaluate<double>(*program, tags, stringTable);
+    }
+    catch (const std::exception&) {
+        // Rejected expression is expected result.
+    }
+    return 0;
+}
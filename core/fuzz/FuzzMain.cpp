@@ -0,0 +1,65 @@
+#include "FuzzUtils.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+    const char* Usage =
+        "Replays inputs of fuzz target. Input which is processed longer than timeout is reported as finding.\n"
+        "Usage: <target> [-timeout=<seconds>] <file or directory>...\n";
+
+    /// Adds given file or all files of given directory.
+    void addInputs(const boost::filesystem::path& path, std::vector<boost::filesystem::path>& inputs)
+    {
+        if (!boost::filesystem::is_directory(path)) {
+            inputs.push_back(path);
+            return;
+        }
+        for (boost::filesystem::recursive_directory_iterator it(path), end; it != end; ++it) {
+            if (boost::filesystem::is_regular_file(it->path()))
+                inputs.push_back(it->path());
+        }
+    }
+}
+
+/// Standalone replacement of libFuzzer driver for compilers without it. Options of libFuzzer
+/// except timeout are accepted and ignored, so the same command line works for both.
+int main(int argc, char* argv[])
+{
+    double timeout = UTYMAP_FUZZ_TIMEOUT;
+    std::vector<boost::filesystem::path> inputs;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 9, "-timeout=") == 0)
+            timeout = std::atof(arg.c_str() + 9);
+        else if (arg[0] != '-')
+            addInputs(arg, inputs);
+    }
+
+    if (inputs.empty()) {
+        std::cerr << Usage;
+        return 1;
+    }
+
+    int findings = 0;
+    for (const auto& input : inputs) {
+        std::ifstream file(input.string(), std::ios::binary);
+        std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        auto start = std::chrono::steady_clock::now();
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (timeout > 0 && elapsed.count() > timeout) {
+            ++findings;
+            std::cerr << "Timeout: " << input.string() << " took " << elapsed.count() << " s" << std::endl;
+        }
+    }
+
+    std::cout << "Executed " << inputs.size() << " inputs, " << findings << " timeouts" << std::endl;
+    return findings > 0 ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+#ifndef FUZZ_FUZZUTILS_HPP_DEFINED
+#define FUZZ_FUZZUTILS_HPP_DEFINED
+
+#include <boost/filesystem.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/// Entry point of fuzz target called for every input by libFuzzer or standalone driver.
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size);
+
+namespace utymap { namespace fuzz {
+
+/// Returns path of file or directory with given name in temporary directory of process.
+/// Directory is unique for process, so that fuzzers can run in parallel, and removed on exit.
+inline std::string getTempPath(const std::string& name)
+{
+    struct TempDirectory final
+    {
+        TempDirectory() : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("utymap-fuzz-%%%%%%%%"))
+        {
+            boost::filesystem::create_directories(path);
+        }
+
+        ~TempDirectory()
+        {
+            boost::system::error_code error;
+            boost::filesystem::remove_all(path, error);
+        }
+
+        const boost::filesystem::path path;
+    };
+
+    static const TempDirectory directory;
+    return (directory.path / name).string();
+}
+
+/// Splits input into given amount of sections: all sections except last one are prefixed by size
+/// as four bytes little endian value. Returns false if input is too short.
+inline bool splitInput(const std::uint8_t* data, std::size_t size, std::size_t count,
+                       std::vector<std::string>& sections)
+{
+    sections.clear();
+    for (std::size_t i = 0; i + 1 < count; ++i) {
+        if (size < 4)
+            return false;
+        std::size_t length = data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<std::size_t>(data[3]) << 24);
+        data += 4;
+        size -= 4;
+        if (length > size)
+            return false;
+        sections.emplace_back(reinterpret_cast<const char*>(data), length);
+        data += length;
+        size -= length;
+    }
+    sections.emplace_back(reinterpret_cast<const char*>(data), size);
+    return true;
+}
+
+/// Writes content to file replacing existing one.
+inline void writeFile(const std::string& path, const std::string& content)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+}
+
+}}
+
+#endif // FUZZ_FUZZUTILS_HPP_DEFINED
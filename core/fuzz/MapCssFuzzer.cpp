@@ -0,0 +1,18 @@
+#include "FuzzUtils.hpp"
+#include "Exceptions.hpp"
+#include "mapcss/MapCssParser.hpp"
+
+using namespace utymap::mapcss;
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size)
+{
+    // NOTE imports are resolved relative to not existing directory, so input cannot read files.
+    static const MapCssParser parser(utymap::fuzz::getTempPath("mapcss"));
+    try {
+        parser.parse(std::string(reinterpret_cast<const char*>(data), size));
+    }
+    catch (const std::exception&) {
+        // Rejected stylesheet is expected result.
+    }
+    return 0;
+}
@@ -0,0 +1,29 @@
+#include "FuzzUtils.hpp"
+#include "formats/osm/xml/OsmXmlParser.hpp"
+
+#include <sstream>
+
+using namespace utymap::formats;
+
+namespace {
+    struct OsmDataVisitor final
+    {
+        void visitBounds(utymap::BoundingBox) {}
+        void visitNode(std::uint64_t, utymap::GeoCoordinate&, Tags&) {}
+        void visitWay(std::uint64_t, std::vector<std::uint64_t>&, Tags&) {}
+        void visitRelation(std::uint64_t, RelationMembers&, Tags&) {}
+    };
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size)
+{
+    std::istringstream stream(std::string(reinterpret_cast<const char*>(data), size));
+    OsmDataVisitor visitor;
+    try {
+        OsmXmlParser<OsmDataVisitor>().parse(stream, visitor);
+    }
+    catch (const std::exception&) {
+        // Rejected data is expected result.
+    }
+    return 0;
+}
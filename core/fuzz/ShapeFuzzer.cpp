@@ -0,0 +1,35 @@
+#include "FuzzUtils.hpp"
+#include "formats/shape/ShapeParser.hpp"
+
+using namespace utymap::formats;
+
+namespace {
+    struct ShapeDataVisitor final
+    {
+        void visitNode(utymap::GeoCoordinate&, Tags&) {}
+        void visitWay(Coordinates&, Tags&, bool) {}
+        void visitRelation(PolygonMembers&, Tags&) {}
+    };
+}
+
+/// Input consists of shp, shx and dbf file content: shp and shx are prefixed by their sizes.
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size)
+{
+    static const std::string path = utymap::fuzz::getTempPath("shape");
+    std::vector<std::string> sections;
+    if (!utymap::fuzz::splitInput(data, size, 3, sections))
+        return 0;
+
+    utymap::fuzz::writeFile(path + ".shp", sections[0]);
+    utymap::fuzz::writeFile(path + ".shx", sections[1]);
+    utymap::fuzz::writeFile(path + ".dbf", sections[2]);
+
+    ShapeDataVisitor visitor;
+    try {
+        ShapeParser<ShapeDataVisitor>().parse(path, visitor);
+    }
+    catch (const std::exception&) {
+        // Rejected data is expected result.
+    }
+    return 0;
+}
@@ -697,7 +697,7 @@ void ReversePolyPtLinks(OutPt *pp)
 }
 //------------------------------------------------------------------------------
 
-void DisposeOutPts(OutPt*& pp)
+void DisposeOutPts(OutPt*& pp, ObjectPool<OutPt>& pool)
 {
   if (pp == 0) return;
     pp->Prev->Next = 0;
@@ -705,7 +705,7 @@ void DisposeOutPts(OutPt*& pp)
   {
     OutPt *tmpPp = pp;
     pp = pp->Next;
-    delete tmpPp;
+    pool.Release(tmpPp);
   }
 }
 //------------------------------------------------------------------------------
@@ -1387,6 +1387,7 @@ bool Clipper::Execute(ClipType clipType, Paths &solution,
   bool succeeded = ExecuteInternal();
   if (succeeded) BuildResult(solution);
   DisposeAllOutRecs();
+  ResetPools();
   m_ExecuteLocked = false;
   return succeeded;
 }
@@ -1404,6 +1405,7 @@ bool Clipper::Execute(ClipType clipType, PolyTree& polytree,
   bool succeeded = ExecuteInternal();
   if (succeeded) BuildResult2(polytree);
   DisposeAllOutRecs();
+  ResetPools();
   m_ExecuteLocked = false;
   return succeeded;
 }
@@ -1504,12 +1506,22 @@ void Clipper::DisposeAllOutRecs(){
 void Clipper::DisposeOutRec(PolyOutList::size_type index)
 {
   OutRec *outRec = m_PolyOuts[index];
-  if (outRec->Pts) DisposeOutPts(outRec->Pts);
-  delete outRec;
+  if (outRec->Pts) DisposeOutPts(outRec->Pts, m_OutPtPool);
+  m_OutRecPool.Release(outRec);
   m_PolyOuts[index] = 0;
 }
 //------------------------------------------------------------------------------
 
+void Clipper::ResetPools()
+{
+  //NOTE all objects are released at this point, so blocks can be reused from the start.
+  m_OutPtPool.Reset();
+  m_OutRecPool.Reset();
+  m_JoinPool.Reset();
+  m_IntersectPool.Reset();
+}
+//------------------------------------------------------------------------------
+
 void Clipper::SetWindingCount(TEdge &edge)
 {
   TEdge *e = edge.PrevInAEL;
@@ -1812,7 +1824,7 @@ void Clipper::CopyAELToSEL()
 
 void Clipper::AddJoin(OutPt *op1, OutPt *op2, const IntPoint& OffPt)
 {
-  Join* j = new Join;
+  Join* j = m_JoinPool.Get();
   j->OutPt1 = op1;
   j->OutPt2 = op2;
   j->OffPt = OffPt;
@@ -1823,7 +1835,7 @@ void Clipper::AddJoin(OutPt *op1, OutPt *op2, const IntPoint& OffPt)
 void Clipper::ClearJoins()
 {
   for (JoinList::size_type i = 0; i < m_Joins.size(); i++)
-    delete m_Joins[i];
+    m_JoinPool.Release(m_Joins[i]);
   m_Joins.resize(0);
 }
 //------------------------------------------------------------------------------
@@ -1831,14 +1843,14 @@ void Clipper::ClearJoins()
 void Clipper::ClearGhostJoins()
 {
   for (JoinList::size_type i = 0; i < m_GhostJoins.size(); i++)
-    delete m_GhostJoins[i];
+    m_JoinPool.Release(m_GhostJoins[i]);
   m_GhostJoins.resize(0);
 }
 //------------------------------------------------------------------------------
 
 void Clipper::AddGhostJoin(OutPt *op, const IntPoint& OffPt)
 {
-  Join* j = new Join;
+  Join* j = m_JoinPool.Get();
   j->OutPt1 = op;
   j->OutPt2 = 0;
   j->OffPt = OffPt;
@@ -2335,7 +2347,7 @@ void Clipper::AppendPolygon(TEdge *e1, TEdge *e2)
 
 OutRec* Clipper::CreateOutRec()
 {
-  OutRec* result = new OutRec;
+  OutRec* result = m_OutRecPool.Get();
   result->IsHole = false;
   result->IsOpen = false;
   result->FirstLeft = 0;
@@ -2355,7 +2367,7 @@ OutPt* Clipper::AddOutPt(TEdge *e, const IntPoint &pt)
   {
     OutRec *outRec = CreateOutRec();
     outRec->IsOpen = (e->WindDelta == 0);
-    OutPt* newOp = new OutPt;
+    OutPt* newOp = m_OutPtPool.Get();
     outRec->Pts = newOp;
     newOp->Idx = outRec->Idx;
     newOp->Pt = pt;
@@ -2374,7 +2386,7 @@ OutPt* Clipper::AddOutPt(TEdge *e, const IntPoint &pt)
     if (ToFront && (pt == op->Pt)) return op;
     else if (!ToFront && (pt == op->Prev->Pt)) return op->Prev;
 
-    OutPt* newOp = new OutPt;
+    OutPt* newOp = m_OutPtPool.Get();
     newOp->Idx = outRec->Idx;
     newOp->Pt = pt;
     newOp->Next = op;
@@ -2726,7 +2738,7 @@ bool Clipper::ProcessIntersections(const cInt topY)
 void Clipper::DisposeIntersectNodes()
 {
   for (size_t i = 0; i < m_IntersectList.size(); ++i )
-    delete m_IntersectList[i];
+    m_IntersectPool.Release(m_IntersectList[i]);
   m_IntersectList.clear();
 }
 //------------------------------------------------------------------------------
@@ -2759,7 +2771,7 @@ void Clipper::BuildIntersectList(const cInt topY)
       if(e->Curr.X > eNext->Curr.X)
       {
         IntersectPoint(*e, *eNext, Pt);
-        IntersectNode * newNode = new IntersectNode;
+        IntersectNode * newNode = m_IntersectPool.Get();
         newNode->Edge1 = e;
         newNode->Edge2 = eNext;
         newNode->Pt = Pt;
@@ -2789,7 +2801,7 @@ void Clipper::ProcessIntersectList()
       IntersectEdges( iNode->Edge1, iNode->Edge2, iNode->Pt);
       SwapPositionsInAEL( iNode->Edge1 , iNode->Edge2 );
     }
-    delete iNode;
+    m_IntersectPool.Release(iNode);
   }
   m_IntersectList.clear();
 }
@@ -2994,7 +3006,7 @@ void Clipper::FixupOutPolygon(OutRec &outrec)
   {
     if (pp->Prev == pp || pp->Prev == pp->Next )
     {
-      DisposeOutPts(pp);
+      DisposeOutPts(pp, m_OutPtPool);
       outrec.Pts = 0;
       return;
     }
@@ -3010,7 +3022,7 @@ void Clipper::FixupOutPolygon(OutRec &outrec)
       pp->Prev->Next = pp->Next;
       pp->Next->Prev = pp->Prev;
       pp = pp->Prev;
-      delete tmp;
+      m_OutPtPool.Release(tmp);
     }
     else if (pp == lastOK) break;
     else
@@ -3187,9 +3199,9 @@ void Clipper::InsertEdgeIntoAEL(TEdge *edge, TEdge* startEdge)
 }
 //----------------------------------------------------------------------
 
-OutPt* DupOutPt(OutPt* outPt, bool InsertAfter)
+OutPt* DupOutPt(OutPt* outPt, bool InsertAfter, ObjectPool<OutPt>& pool)
 {
-  OutPt* result = new OutPt;
+  OutPt* result = pool.Get();
   result->Pt = outPt->Pt;
   result->Idx = outPt->Idx;
   if (InsertAfter)
@@ -3211,7 +3223,7 @@ OutPt* DupOutPt(OutPt* outPt, bool InsertAfter)
 //------------------------------------------------------------------------------
 
 bool JoinHorz(OutPt* op1, OutPt* op1b, OutPt* op2, OutPt* op2b,
-    const IntPoint& Pt, bool DiscardLeft)
+    const IntPoint& Pt, bool DiscardLeft, ObjectPool<OutPt>& pool)
 {
   Direction Dir1 = (op1->Pt.X > op1b->Pt.X ? dRightToLeft : dLeftToRight);
   Direction Dir2 = (op2->Pt.X > op2b->Pt.X ? dRightToLeft : dLeftToRight);
@@ -3228,12 +3240,12 @@ bool JoinHorz(OutPt* op1, OutPt* op1b, OutPt* op2, OutPt* op2b,
       op1->Next->Pt.X >= op1->Pt.X && op1->Next->Pt.Y == Pt.Y)  
         op1 = op1->Next;
     if (DiscardLeft && (op1->Pt.X != Pt.X)) op1 = op1->Next;
-    op1b = DupOutPt(op1, !DiscardLeft);
+    op1b = DupOutPt(op1, !DiscardLeft, pool);
     if (op1b->Pt != Pt) 
     {
       op1 = op1b;
       op1->Pt = Pt;
-      op1b = DupOutPt(op1, !DiscardLeft);
+      op1b = DupOutPt(op1, !DiscardLeft, pool);
     }
   } 
   else
@@ -3242,12 +3254,12 @@ bool JoinHorz(OutPt* op1, OutPt* op1b, OutPt* op2, OutPt* op2b,
       op1->Next->Pt.X <= op1->Pt.X && op1->Next->Pt.Y == Pt.Y) 
         op1 = op1->Next;
     if (!DiscardLeft && (op1->Pt.X != Pt.X)) op1 = op1->Next;
-    op1b = DupOutPt(op1, DiscardLeft);
+    op1b = DupOutPt(op1, DiscardLeft, pool);
     if (op1b->Pt != Pt)
     {
       op1 = op1b;
       op1->Pt = Pt;
-      op1b = DupOutPt(op1, DiscardLeft);
+      op1b = DupOutPt(op1, DiscardLeft, pool);
     }
   }
 
@@ -3257,12 +3269,12 @@ bool JoinHorz(OutPt* op1, OutPt* op1b, OutPt* op2, OutPt* op2b,
       op2->Next->Pt.X >= op2->Pt.X && op2->Next->Pt.Y == Pt.Y)
         op2 = op2->Next;
     if (DiscardLeft && (op2->Pt.X != Pt.X)) op2 = op2->Next;
-    op2b = DupOutPt(op2, !DiscardLeft);
+    op2b = DupOutPt(op2, !DiscardLeft, pool);
     if (op2b->Pt != Pt)
     {
       op2 = op2b;
       op2->Pt = Pt;
-      op2b = DupOutPt(op2, !DiscardLeft);
+      op2b = DupOutPt(op2, !DiscardLeft, pool);
     };
   } else
   {
@@ -3270,12 +3282,12 @@ bool JoinHorz(OutPt* op1, OutPt* op1b, OutPt* op2, OutPt* op2b,
       op2->Next->Pt.X <= op2->Pt.X && op2->Next->Pt.Y == Pt.Y) 
         op2 = op2->Next;
     if (!DiscardLeft && (op2->Pt.X != Pt.X)) op2 = op2->Next;
-    op2b = DupOutPt(op2, DiscardLeft);
+    op2b = DupOutPt(op2, DiscardLeft, pool);
     if (op2b->Pt != Pt)
     {
       op2 = op2b;
       op2->Pt = Pt;
-      op2b = DupOutPt(op2, DiscardLeft);
+      op2b = DupOutPt(op2, DiscardLeft, pool);
     };
   };
 
@@ -3327,8 +3339,8 @@ bool Clipper::JoinPoints(Join *j, OutRec* outRec1, OutRec* outRec2)
     if (reverse1 == reverse2) return false;
     if (reverse1)
     {
-      op1b = DupOutPt(op1, false);
-      op2b = DupOutPt(op2, true);
+      op1b = DupOutPt(op1, false, m_OutPtPool);
+      op2b = DupOutPt(op2, true, m_OutPtPool);
       op1->Prev = op2;
       op2->Next = op1;
       op1b->Next = op2b;
@@ -3338,8 +3350,8 @@ bool Clipper::JoinPoints(Join *j, OutRec* outRec1, OutRec* outRec2)
       return true;
     } else
     {
-      op1b = DupOutPt(op1, true);
-      op2b = DupOutPt(op2, false);
+      op1b = DupOutPt(op1, true, m_OutPtPool);
+      op2b = DupOutPt(op2, false, m_OutPtPool);
       op1->Next = op2;
       op2->Prev = op1;
       op1b->Prev = op2b;
@@ -3395,7 +3407,7 @@ bool Clipper::JoinPoints(Join *j, OutRec* outRec1, OutRec* outRec2)
       Pt = op2b->Pt; DiscardLeftSide = (op2b->Pt.X > op2->Pt.X);
     }
     j->OutPt1 = op1; j->OutPt2 = op2;
-    return JoinHorz(op1, op1b, op2, op2b, Pt, DiscardLeftSide);
+    return JoinHorz(op1, op1b, op2, op2b, Pt, DiscardLeftSide, m_OutPtPool);
   } else
   {
     //nb: For non-horizontal joins ...
@@ -3431,8 +3443,8 @@ bool Clipper::JoinPoints(Join *j, OutRec* outRec1, OutRec* outRec2)
 
     if (Reverse1)
     {
-      op1b = DupOutPt(op1, false);
-      op2b = DupOutPt(op2, true);
+      op1b = DupOutPt(op1, false, m_OutPtPool);
+      op2b = DupOutPt(op2, true, m_OutPtPool);
       op1->Prev = op2;
       op2->Next = op1;
       op1b->Next = op2b;
@@ -3442,8 +3454,8 @@ bool Clipper::JoinPoints(Join *j, OutRec* outRec1, OutRec* outRec2)
       return true;
     } else
     {
-      op1b = DupOutPt(op1, true);
-      op2b = DupOutPt(op2, false);
+      op1b = DupOutPt(op1, true, m_OutPtPool);
+      op2b = DupOutPt(op2, false, m_OutPtPool);
       op1->Next = op2;
       op2->Prev = op1;
       op1b->Prev = op2b;
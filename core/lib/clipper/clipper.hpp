@@ -205,6 +205,55 @@ struct OutPt;
 struct OutRec;
 struct Join;
 
+//ObjectPool allocates internal structures in blocks which are owned by clipper:
+//released objects are reused by next allocations and all objects are returned
+//at once by Reset, so clipper which is reused for many operations does not
+//allocate output points, output records, joins and intersections per object.
+template <typename T>
+class ObjectPool
+{
+public:
+  ObjectPool(): m_Free(0), m_Used(0) {}
+  ~ObjectPool()
+  {
+    for (typename std::vector<T*>::size_type i = 0; i < m_Blocks.size(); ++i)
+      delete [] m_Blocks[i];
+  }
+  T* Get()
+  {
+    if (m_Free)
+    {
+      T* result = m_Free;
+      std::memcpy(&m_Free, result, sizeof(T*));
+      return result;
+    }
+    if (m_Used == m_Blocks.size() * BlockSize)
+      m_Blocks.push_back(new T[BlockSize]);
+    T* result = &m_Blocks[m_Used / BlockSize][m_Used % BlockSize];
+    ++m_Used;
+    return result;
+  }
+  //released object keeps link to the next free object in its own memory
+  void Release(T* obj)
+  {
+    std::memcpy(obj, &m_Free, sizeof(T*));
+    m_Free = obj;
+  }
+  //makes all objects available again keeping allocated blocks
+  void Reset()
+  {
+    m_Free = 0;
+    m_Used = 0;
+  }
+private:
+  static const std::size_t BlockSize = 256;
+  ObjectPool(const ObjectPool&);
+  ObjectPool& operator=(const ObjectPool&);
+  std::vector<T*> m_Blocks;
+  T* m_Free;
+  std::size_t m_Used;
+};
+
 typedef std::vector < OutRec* > PolyOutList;
 typedef std::vector < TEdge* > EdgeList;
 typedef std::vector < Join* > JoinList;
@@ -276,6 +325,10 @@ private:
   JoinList          m_Joins;
   JoinList          m_GhostJoins;
   IntersectList     m_IntersectList;
+  ObjectPool<OutPt>         m_OutPtPool;
+  ObjectPool<OutRec>        m_OutRecPool;
+  ObjectPool<Join>          m_JoinPool;
+  ObjectPool<IntersectNode> m_IntersectPool;
   ClipType          m_ClipType;
   typedef std::priority_queue<cInt> ScanbeamList;
   ScanbeamList      m_Scanbeam;
@@ -317,6 +370,7 @@ private:
   OutRec* CreateOutRec();
   OutPt* AddOutPt(TEdge *e, const IntPoint &pt);
   void DisposeAllOutRecs();
+  void ResetPools();
   void DisposeOutRec(PolyOutList::size_type index);
   bool ProcessIntersections(const cInt topY);
   void BuildIntersectList(const cInt topY);
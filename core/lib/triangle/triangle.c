@@ -648,17 +648,25 @@ struct memorypool {
 
 
 /* Global constants.                                                         */
-
-REAL splitter;       /* Used to split REAL factors for exact multiplication. */
-REAL epsilon;                             /* Floating-point machine epsilon. */
-REAL resulterrbound;
-REAL ccwerrboundA, ccwerrboundB, ccwerrboundC;
-REAL iccerrboundA, iccerrboundB, iccerrboundC;
-REAL o3derrboundA, o3derrboundB, o3derrboundC;
+/*   They are recomputed on each call, so each thread keeps its own copy to  */
+/*   allow triangulating different meshes concurrently.                      */
+
+#ifdef _MSC_VER
+#define THREADLOCAL __declspec(thread)
+#else /* not _MSC_VER */
+#define THREADLOCAL __thread
+#endif /* not _MSC_VER */
+
+THREADLOCAL REAL splitter;  /* Used to split REAL factors for exact multiplication. */
+THREADLOCAL REAL epsilon;                        /* Floating-point machine epsilon. */
+THREADLOCAL REAL resulterrbound;
+THREADLOCAL REAL ccwerrboundA, ccwerrboundB, ccwerrboundC;
+THREADLOCAL REAL iccerrboundA, iccerrboundB, iccerrboundC;
+THREADLOCAL REAL o3derrboundA, o3derrboundB, o3derrboundC;
 
 /* Random number seed is not constant, but I've made it global anyway.       */
 
-unsigned long randomseed;                     /* Current random number seed. */
+THREADLOCAL unsigned long randomseed;            /* Current random number seed. */
 
 
 /* Mesh data structure.  Triangle operates on only one mesh, but the mesh    */
@@ -1426,6 +1434,30 @@ int status;
   exit(status);
 }
 
+/* Optional allocator installed by application. If not set, standard malloc()  */
+/*   and free() are used.                                                     */
+
+#ifdef ANSI_DECLARATORS
+static VOID *(*trimallochook)(int) = (VOID *(*)(int)) NULL;
+static void (*trifreehook)(VOID *) = (void (*)(VOID *)) NULL;
+#else /* not ANSI_DECLARATORS */
+static VOID *(*trimallochook)() = (VOID *(*)()) NULL;
+static void (*trifreehook)() = (void (*)()) NULL;
+#endif /* not ANSI_DECLARATORS */
+
+#ifdef ANSI_DECLARATORS
+void trisetallocator(VOID *(*mallocfunc)(int), void (*freefunc)(VOID *))
+#else /* not ANSI_DECLARATORS */
+void trisetallocator(mallocfunc, freefunc)
+VOID *(*mallocfunc)();
+void (*freefunc)();
+#endif /* not ANSI_DECLARATORS */
+
+{
+  trimallochook = mallocfunc;
+  trifreehook = freefunc;
+}
+
 #ifdef ANSI_DECLARATORS
 VOID *trimalloc(int size)
 #else /* not ANSI_DECLARATORS */
@@ -1436,7 +1468,11 @@ int size;
 {
   VOID *memptr;
 
-  memptr = (VOID *) malloc((unsigned int) size);
+  if (trimallochook != NULL) {
+    memptr = trimallochook(size);
+  } else {
+    memptr = (VOID *) malloc((unsigned int) size);
+  }
   if (memptr == (VOID *) NULL) {
     printf("Error:  Out of memory.\n");
     triexit(1);
@@ -1452,7 +1488,11 @@ VOID *memptr;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  free(memptr);
+  if (trifreehook != NULL) {
+    trifreehook(memptr);
+  } else {
+    free(memptr);
+  }
 }
 
 /**                                                                         **/
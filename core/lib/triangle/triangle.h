@@ -289,7 +289,12 @@ void triangulate(char *, struct triangulateio *, struct triangulateio *,
 extern "C"
 #endif
 void trifree(int *memptr);
+#ifdef __cplusplus
+extern "C"
+#endif
+void trisetallocator(int *(*mallocfunc)(int), void (*freefunc)(int *));
 #else /* not ANSI_DECLARATORS */
 void triangulate();
 void trifree();
+void trisetallocator();
 #endif /* not ANSI_DECLARATORS */
@@ -0,0 +1,206 @@
+#include "Application.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using utymap::utils::Statistics;
+
+    const char* Usage =
+        "Replays recorded session and reports latency percentiles of quadkey loads and their stages.\n"
+        "Usage: UtyMap.Replay --session <file> [--strings <directory>] [--elevation <directory>]\n"
+        "                     [--output <json>] [--realtime <0|1>]\n";
+
+    int errorCount = 0;
+
+    void onError(const char* message)
+    {
+        ++errorCount;
+        std::cerr << message << std::endl;
+    }
+
+    /// Latencies of loaded quadkey in milliseconds.
+    struct TileLatency final
+    {
+        std::string quadKey;
+        double total;
+        std::vector<double> stages;
+        /// Amount of heap allocations made by quadkey build in all threads.
+        double allocations;
+    };
+
+    /// Returns percentile of sorted values using nearest rank.
+    double getPercentile(const std::vector<double>& values, double percent)
+    {
+        if (values.empty())
+            return 0;
+        std::size_t rank = static_cast<std::size_t>(std::ceil(percent / 100 * values.size()));
+        return values[std::max<std::size_t>(rank, 1) - 1];
+    }
+
+    void writePercentiles(std::ostream& stream, std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        stream << "{\"p50\":" << getPercentile(values, 50) << ",\"p90\":" << getPercentile(values, 90)
+               << ",\"p99\":" << getPercentile(values, 99) << ",\"max\":" << getPercentile(values, 100) << "}";
+    }
+
+    void writeReport(std::ostream& stream, const std::vector<TileLatency>& tiles)
+    {
+        std::vector<double> totals, allocations;
+        stream << "{\"tiles\":[";
+        for (std::size_t i = 0; i < tiles.size(); ++i) {
+            stream << (i == 0 ? "" : ",") << "{\"quadkey\":\"" << tiles[i].quadKey << "\",\"ms\":" << tiles[i].total << "}";
+            totals.push_back(tiles[i].total);
+            allocations.push_back(tiles[i].allocations);
+        }
+        stream << "],\"latency\":";
+        writePercentiles(stream, totals);
+        if (utymap::utils::AllocationCounter::isEnabled()) {
+            stream << ",\"allocations\":";
+            writePercentiles(stream, allocations);
+        }
+
+        stream << ",\"stages\":{";
+        for (int stage = 0; stage < static_cast<int>(Statistics::Stage::Count); ++stage) {
+            std::vector<double> values;
+            for (const auto& tile : tiles)
+                values.push_back(tile.stages[stage]);
+            stream << (stage == 0 ? "" : ",") << "\"" << Statistics::getName(static_cast<Statistics::Stage>(stage)) << "\":";
+            writePercentiles(stream, values);
+        }
+        stream << "}}" << std::endl;
+    }
+
+    /// Adds latency of finished load to tiles unless it has failed.
+    void addTile(const std::string& name, std::chrono::steady_clock::time_point start, std::uint64_t allocations,
+                 int previousErrors, std::vector<TileLatency>& tiles)
+    {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        // NOTE failed loads are not measured: their latency is not comparable.
+        if (errorCount != previousErrors)
+            return;
+
+        TileLatency tile { name, elapsed.count(), {},
+            static_cast<double>(utymap::utils::AllocationCounter::total() - allocations) };
+        for (int stage = 0; stage < static_cast<int>(Statistics::Stage::Count); ++stage)
+            tile.stages.push_back(Statistics::instance().getNanoseconds(static_cast<Statistics::Stage>(stage)) / 1E6);
+        tiles.push_back(tile);
+    }
+
+    /// Executes recorded command. Quadkey loads are measured and added to tiles: batch load is
+    /// measured as whole, its stages are summed over all threads.
+    void execute(Application& application, const SessionRecorder::Command& command, std::vector<TileLatency>& tiles)
+    {
+        const auto& args = command.arguments;
+        auto getInt = [&](std::size_t index) { return std::atoi(args.at(index).c_str()); };
+        auto getDouble = [&](std::size_t index) { return std::atof(args.at(index).c_str()); };
+
+        if (command.name == "store_in_memory")
+            application.registerInMemoryStore(args.at(0).c_str());
+        else if (command.name == "store_persistent")
+            application.registerPersistentStore(args.at(0).c_str(), args.at(1).c_str());
+        else if (command.name == "store_package")
+            application.registerPackageStore(args.at(0).c_str(), args.at(1).c_str());
+        else if (command.name == "elevation_pyramid")
+            application.registerElevationPyramid(args.at(0).c_str());
+        else if (command.name == "elevation_tiles")
+            application.registerElevationTiles(args.at(0).c_str(), getInt(1));
+        else if (command.name == "add_quadkey")
+            application.addToStore(args.at(0).c_str(), args.at(1).c_str(), args.at(2).c_str(),
+                                   utymap::QuadKey(getInt(3), getInt(4), getInt(5)), onError);
+        else if (command.name == "add_bbox")
+            application.addToStore(args.at(0).c_str(), args.at(1).c_str(), args.at(2).c_str(),
+                                   utymap::BoundingBox(utymap::GeoCoordinate(getDouble(3), getDouble(4)),
+                                                       utymap::GeoCoordinate(getDouble(5), getDouble(6))),
+                                   utymap::LodRange(getInt(7), getInt(8)), onError);
+        else if (command.name == "add_range")
+            application.addToStore(args.at(0).c_str(), args.at(1).c_str(), args.at(2).c_str(),
+                                   utymap::LodRange(getInt(3), getInt(4)), onError);
+        else if (command.name == "preload_elevation")
+            application.preloadElevation(utymap::QuadKey(getInt(0), getInt(1), getInt(2)));
+        else if (command.name == "load_quadkey") {
+            Statistics::instance().reset();
+            int previousErrors = errorCount;
+            std::uint64_t allocations = utymap::utils::AllocationCounter::total();
+            auto start = std::chrono::steady_clock::now();
+            application.loadQuadKey(args.at(0).c_str(), utymap::QuadKey(getInt(1), getInt(2), getInt(3)),
+                [](const char*, const double*, int, const int*, int, const int*, int, const double*, int) {},
+                [](std::uint64_t, const char**, int, const double*, int, const char**, int) {},
+                onError);
+            addTile(args.at(1) + "/" + args.at(2) + "/" + args.at(3), start, allocations, previousErrors, tiles);
+        }
+        else if (command.name == "load_quadkeys") {
+            std::vector<utymap::QuadKey> quadKeys;
+            for (std::size_t i = 2; i + 2 < args.size(); i += 3)
+                quadKeys.push_back(utymap::QuadKey(getInt(i), getInt(i + 1), getInt(i + 2)));
+
+            Statistics::instance().reset();
+            int previousErrors = errorCount;
+            std::uint64_t allocations = utymap::utils::AllocationCounter::total();
+            auto start = std::chrono::steady_clock::now();
+            application.loadQuadKeys(args.at(0).c_str(), quadKeys, getInt(1),
+                [](const char*, const double*, int, const int*, int, const int*, int, const double*, int) {},
+                [](std::uint64_t, const char**, int, const double*, int, const char**, int) {},
+                [](int, int, int) {},
+                onError);
+            addTile("batch/" + std::to_string(quadKeys.size()), start, allocations, previousErrors, tiles);
+        }
+        else
+            onError(("Unknown session command: " + command.name).c_str());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::map<std::string, std::string> options = { { "--strings", "." }, { "--elevation", "." }, { "--realtime", "0" } };
+    for (int i = 1; i + 1 < argc; i += 2)
+        options[argv[i]] = argv[i + 1];
+
+    if (argc % 2 == 0 || options["--session"].empty()) {
+        std::cerr << Usage;
+        return 1;
+    }
+
+    std::vector<SessionRecorder::Command> commands;
+    try {
+        commands = SessionRecorder::read(options["--session"]);
+    }
+    catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return 1;
+    }
+
+    // NOTE commands are replayed in recorded order on single thread, so results are deterministic.
+    Application application(options["--strings"].c_str(), options["--elevation"].c_str(), onError);
+    std::vector<TileLatency> tiles;
+    bool isRealtime = options["--realtime"] == "1";
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& command : commands) {
+        if (isRealtime)
+            std::this_thread::sleep_until(start + std::chrono::microseconds(static_cast<std::int64_t>(command.time * 1000)));
+        try {
+            execute(application, command, tiles);
+        }
+        catch (const std::exception& ex) {
+            onError(ex.what());
+        }
+    }
+
+    if (options["--output"].empty())
+        writeReport(std::cout, tiles);
+    else {
+        std::ofstream file(options["--output"]);
+        writeReport(file, tiles);
+    }
+    return errorCount > 0 ? 1 : 0;
+}
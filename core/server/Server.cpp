@@ -0,0 +1,413 @@
+#include "Application.hpp"
+#include "JobScheduler.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+    const char* StoreKey = "server";
+
+    const char* Usage =
+        "Serves tiles built from persistent store over HTTP: GET /{lod}/{x}/{y}.{glb|mesh|json}.\n"
+        "glb is binary glTF, mesh is list of encoded meshes and json is elements of tile.\n"
+        "Usage: UtyMap.Server --style <mapcss> --store <directory> [--port <port>]\n"
+        "                     [--strings <directory>] [--elevation <directory>] [--threads <count>]\n"
+        "                     [--cache <tile count>] [--shared <0|1>]\n";
+
+    /// Max size of request head which is read from connection.
+    const std::size_t MaxRequestSize = 8 * 1024;
+    /// Timeout of reading request and writing response in seconds.
+    const int SocketTimeout = 30;
+
+    /// Sinks of callbacks of application which are plain functions: tile is built
+    /// synchronously on thread which handles request, so they are per thread.
+    thread_local std::string* errorSink = nullptr;
+    thread_local std::string* meshSink = nullptr;
+    thread_local std::string* elementSink = nullptr;
+
+    void onError(const char* message)
+    {
+        if (errorSink != nullptr)
+            errorSink->append(message).append("\n");
+        else
+            std::cerr << message << std::endl;
+    }
+
+    void onMeshBuilt(const char*, const double*, int, const int*, int, const int*, int, const double*, int) { }
+
+    template <typename T>
+    void writeValue(std::string& buffer, T value)
+    {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    /// Writes mesh as its name and encoded data, both prefixed by 4b size.
+    void onEncodedMeshBuilt(const char* name, const char* data, int dataSize)
+    {
+        std::size_t nameSize = std::strlen(name);
+        writeValue(*meshSink, static_cast<std::uint32_t>(nameSize));
+        meshSink->append(name, nameSize);
+        writeValue(*meshSink, static_cast<std::uint32_t>(dataSize));
+        meshSink->append(data, static_cast<std::size_t>(dataSize));
+    }
+
+    void writeJsonString(std::string& buffer, const char* str)
+    {
+        buffer.push_back('"');
+        for (; *str != '\0'; ++str) {
+            char c = *str;
+            if (c == '"' || c == '\\') {
+                buffer.push_back('\\');
+                buffer.push_back(c);
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                buffer.append(escaped);
+            } else {
+                buffer.push_back(c);
+            }
+        }
+        buffer.push_back('"');
+    }
+
+    void writeJsonObject(std::string& buffer, const char** pairs, int size)
+    {
+        buffer.push_back('{');
+        for (int i = 0; i + 1 < size; i += 2) {
+            if (i > 0)
+                buffer.push_back(',');
+            writeJsonString(buffer, pairs[i]);
+            buffer.push_back(':');
+            writeJsonString(buffer, pairs[i + 1]);
+        }
+        buffer.push_back('}');
+    }
+
+    /// Writes element as json object, elements are separated by comma.
+    void onElementLoaded(std::uint64_t id, const char** tags, int tagsSize,
+                         const double* vertices, int vertexSize,
+                         const char** style, int styleSize)
+    {
+        std::string& buffer = *elementSink;
+        if (buffer.size() > 1)
+            buffer.push_back(',');
+        buffer.append("{\"id\":").append(std::to_string(id)).append(",\"tags\":");
+        writeJsonObject(buffer, tags, tagsSize);
+        buffer.append(",\"style\":");
+        writeJsonObject(buffer, style, styleSize);
+        buffer.append(",\"vertices\":[");
+        std::ostringstream stream;
+        stream.precision(10);
+        for (int i = 0; i < vertexSize; ++i)
+            stream << (i > 0 ? "," : "") << vertices[i];
+        buffer.append(stream.str()).append("]}");
+    }
+
+    /// Keeps responses of recently requested tiles. Concurrent requests of the same tile
+    /// wait for the first one instead of building tile again. Failed builds are not kept.
+    class TileCache final
+    {
+    public:
+        typedef std::shared_ptr<const std::string> Data;
+        /// Builds data of tile, returns null if tile cannot be built.
+        typedef std::function<Data()> Builder;
+
+        explicit TileCache(std::size_t capacity) : capacity_(capacity) { }
+
+        Data get(const std::string& key, const Builder& build)
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            auto entry = entries_.find(key);
+            if (entry != entries_.end()) {
+                if (entry->second.isReady) {
+                    usage_.splice(usage_.begin(), usage_, entry->second.usage);
+                    return entry->second.data;
+                }
+                auto pending = entry->second.pending;
+                condition_.wait(lock, [&]() { return pending->isDone; });
+                return pending->data;
+            }
+
+            auto pending = std::make_shared<Pending>();
+            entries_.emplace(key, Entry { nullptr, false, usage_.end(), pending });
+            lock.unlock();
+
+            Data data = nullptr;
+            try {
+                data = build();
+            } catch (...) { }
+
+            lock.lock();
+            pending->data = data;
+            pending->isDone = true;
+            entry = entries_.find(key);
+            if (data == nullptr || capacity_ == 0)
+                entries_.erase(entry);
+            else {
+                usage_.push_front(key);
+                entry->second = Entry { data, true, usage_.begin(), nullptr };
+                while (usage_.size() > capacity_) {
+                    entries_.erase(usage_.back());
+                    usage_.pop_back();
+                }
+            }
+            condition_.notify_all();
+            return data;
+        }
+
+    private:
+        /// Result of build which is awaited by concurrent requests.
+        struct Pending final
+        {
+            Data data = nullptr;
+            bool isDone = false;
+        };
+
+        struct Entry final
+        {
+            Data data;
+            bool isReady;
+            /// Position in usage list, only ready entries are there.
+            std::list<std::string>::iterator usage;
+            std::shared_ptr<Pending> pending;
+        };
+
+        const std::size_t capacity_;
+        std::mutex lock_;
+        std::condition_variable condition_;
+        std::unordered_map<std::string, Entry> entries_;
+        std::list<std::string> usage_;
+    };
+
+    /// Response of request.
+    struct Response final
+    {
+        int status;
+        std::string contentType;
+        TileCache::Data body;
+    };
+
+    /// Builds tiles using application which is safe to use from several threads.
+    class TileService final
+    {
+    public:
+        TileService(Application& application, const std::string& style, std::size_t cacheSize) :
+            application_(application), style_(style), cache_(cacheSize)
+        {
+        }
+
+        Response handle(const std::string& path)
+        {
+            int lod, x, y;
+            char format[8] = {};
+            int consumed = 0;
+            if (std::sscanf(path.c_str(), "/%d/%d/%d.%7[a-z]%n", &lod, &x, &y, format, &consumed) != 4 ||
+                static_cast<std::size_t>(consumed) != path.size() ||
+                lod < 1 || lod > 19 || x < 0 || y < 0 || x >= (1 << lod) || y >= (1 << lod))
+                return error(404, "Not found");
+
+            std::string type = format;
+            std::string contentType = type == "glb" ? "model/gltf-binary"
+                : type == "mesh" ? "application/octet-stream"
+                : type == "json" ? "application/json" : "";
+            if (contentType.empty())
+                return error(404, "Unknown format");
+
+            utymap::QuadKey quadKey(lod, x, y);
+            auto data = cache_.get(path, [&]() { return build(quadKey, type); });
+            if (data == nullptr)
+                return error(500, "Tile cannot be built");
+            return Response { 200, contentType, data };
+        }
+
+    private:
+        static Response error(int status, const std::string& message)
+        {
+            return Response { status, "text/plain", std::make_shared<const std::string>(message + "\n") };
+        }
+
+        TileCache::Data build(const utymap::QuadKey& quadKey, const std::string& type)
+        {
+            std::string errors, data;
+            errorSink = &errors;
+            if (type == "glb") {
+                std::ostringstream stream;
+                application_.writeQuadKeyGlb(style_.c_str(), quadKey, stream, onError);
+                data = stream.str();
+            } else if (type == "mesh") {
+                meshSink = &data;
+                application_.loadQuadKeyEncoded(style_.c_str(), quadKey, true, onEncodedMeshBuilt, nullptr, onError);
+            } else {
+                data = "[";
+                elementSink = &data;
+                application_.loadQuadKey(style_.c_str(), quadKey, onMeshBuilt, onElementLoaded, onError);
+                data.push_back(']');
+            }
+            errorSink = meshSink = elementSink = nullptr;
+
+            if (!errors.empty()) {
+                std::cerr << quadKey.levelOfDetail << "/" << quadKey.tileX << "/" << quadKey.tileY
+                          << ": " << errors;
+                return nullptr;
+            }
+            return std::make_shared<const std::string>(std::move(data));
+        }
+
+        Application& application_;
+        const std::string style_;
+        TileCache cache_;
+    };
+
+    bool sendAll(int socket, const char* data, std::size_t size)
+    {
+        while (size > 0) {
+            ssize_t sent = ::send(socket, data, size, MSG_NOSIGNAL);
+            if (sent <= 0)
+                return false;
+            data += sent;
+            size -= static_cast<std::size_t>(sent);
+        }
+        return true;
+    }
+
+    /// Reads request head and returns path of GET request or empty string.
+    std::string readPath(int socket, bool& isGet)
+    {
+        std::string request;
+        char buffer[1024];
+        isGet = false;
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < MaxRequestSize) {
+            ssize_t received = ::recv(socket, buffer, sizeof(buffer), 0);
+            if (received <= 0)
+                return "";
+            request.append(buffer, static_cast<std::size_t>(received));
+        }
+
+        std::istringstream stream(request.substr(0, request.find("\r\n")));
+        std::string method, target, version;
+        stream >> method >> target >> version;
+        isGet = method == "GET";
+        return target.substr(0, target.find('?'));
+    }
+
+    const char* getReason(int status)
+    {
+        switch (status) {
+            case 200: return "OK";
+            case 400: return "Bad Request";
+            case 404: return "Not Found";
+            case 405: return "Method Not Allowed";
+            default: return "Internal Server Error";
+        }
+    }
+
+    /// Handles single request and closes connection.
+    void handleConnection(int socket, TileService& service)
+    {
+        timeval timeout = { SocketTimeout, 0 };
+        ::setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        ::setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        bool isGet;
+        std::string path = readPath(socket, isGet);
+        Response response = !isGet
+            ? Response { path.empty() ? 400 : 405, "text/plain", std::make_shared<const std::string>() }
+            : service.handle(path);
+
+        std::ostringstream head;
+        head << "HTTP/1.1 " << response.status << " " << getReason(response.status) << "\r\n"
+             << "Content-Type: " << response.contentType << "\r\n"
+             << "Content-Length: " << response.body->size() << "\r\n"
+             << "Connection: close\r\n\r\n";
+        std::string data = head.str();
+        if (sendAll(socket, data.data(), data.size()))
+            sendAll(socket, response.body->data(), response.body->size());
+        ::close(socket);
+    }
+
+    int listenOn(int port)
+    {
+        int socket = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (socket < 0)
+            return -1;
+
+        int reuse = 1;
+        ::setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(static_cast<std::uint16_t>(port));
+        if (::bind(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+            ::listen(socket, SOMAXCONN) < 0) {
+            ::close(socket);
+            return -1;
+        }
+        return socket;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::map<std::string, std::string> options = {
+        { "--strings", "." }, { "--elevation", "." }, { "--port", "8080" }, { "--cache", "1024" },
+        { "--shared", "0" }, { "--threads", std::to_string(std::max(1u, std::thread::hardware_concurrency())) }
+    };
+    for (int i = 1; i + 1 < argc; i += 2)
+        options[argv[i]] = argv[i + 1];
+
+    const auto& style = options["--style"];
+    const auto& store = options["--store"];
+    if (argc % 2 == 0 || style.empty() || store.empty()) {
+        std::cerr << Usage;
+        return 1;
+    }
+
+    Application application(options["--strings"].c_str(), options["--elevation"].c_str(), onError,
+                            options["--shared"] == "1");
+    application.registerPersistentStore(StoreKey, store.c_str());
+    application.registerStylesheet(style.c_str());
+    TileService service(application, style, static_cast<std::size_t>(std::atoi(options["--cache"].c_str())));
+
+    int port = std::atoi(options["--port"].c_str());
+    int listener = listenOn(port);
+    if (listener < 0) {
+        std::cerr << "Cannot listen on port " << port << std::endl;
+        return 1;
+    }
+    std::cout << "Listening on port " << port << std::endl;
+
+    // NOTE connections are handled in order they are accepted, builds of tiles use task
+    // scheduler of library for their parallel stages.
+    std::atomic<std::uint64_t> sequence(0);
+    JobScheduler scheduler(static_cast<std::size_t>(std::max(std::atoi(options["--threads"].c_str()), 1)));
+    while (true) {
+        int socket = ::accept(listener, nullptr, nullptr);
+        if (socket < 0)
+            continue;
+        double priority = static_cast<double>(sequence++);
+        scheduler.submit([priority]() { return priority; },
+            [socket, &service]() { handleConnection(socket, service); },
+            [socket](int, bool isCancelled) { if (isCancelled) ::close(socket); });
+    }
+}
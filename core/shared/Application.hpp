@@ -5,71 +5,254 @@
 #include "QuadKey.hpp"
 #include "LodRange.hpp"
 #include "builders/BuilderContext.hpp"
+#include "builders/MeshCache.hpp"
 #include "builders/QuadKeyBuilder.hpp"
 #include "builders/buildings/BuildingBuilder.hpp"
 #include "builders/misc/BarrierBuilder.hpp"
 #include "builders/poi/TreeBuilder.hpp"
 #include "builders/terrain/TerraBuilder.hpp"
+#include "entities/ElementCopier.hpp"
 #include "heightmap/FlatElevationProvider.hpp"
+#include "heightmap/PyramidElevationProvider.hpp"
 #include "heightmap/SrtmElevationProvider.hpp"
+#include "heightmap/TerrainRgbElevationProvider.hpp"
 #include "index/GeoStore.hpp"
 #include "index/InMemoryElementStore.hpp"
+#include "index/PackageElementStore.hpp"
 #include "index/PersistentElementStore.hpp"
+#include "index/RemoteElementStore.hpp"
+#include "mapcss/CompiledStyleSheet.hpp"
 #include "mapcss/MapCssParser.hpp"
 #include "mapcss/StyleSheet.hpp"
+#include "meshing/CartesianProjection.hpp"
+#include "meshing/GlbWriter.hpp"
+#include "meshing/MeshBvh.hpp"
+#include "meshing/MeshCodec.hpp"
+#include "meshing/MeshPackage.hpp"
+#include "meshing/MeshSplitter.hpp"
 #include "meshing/MeshTypes.hpp"
+#include "meshing/PackedMesh.hpp"
 #include "utils/CoreUtils.hpp"
 #include "utils/GeoUtils.hpp"
+#include "utils/SharedMutex.hpp"
+#include "utils/Statistics.hpp"
+#include "utils/TaskScheduler.hpp"
+#include "utils/TraceRecorder.hpp"
 
 #include "Callbacks.hpp"
+#include "ExportElementBatch.hpp"
+#include "ExportElementIdVisitor.hpp"
 #include "ExportElementVisitor.hpp"
+#include "JobScheduler.hpp"
+#include "MeshRegistry.hpp"
+#include "ResultQueue.hpp"
+#include "SessionRecorder.hpp"
 
+#include <algorithm>
+#include <condition_variable>
 #include <exception>
 #include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
-/// Exposes API for external usage.
+/// Exposes API for external usage. Methods can be called from different threads: quadkeys
+/// are built and data is added to stores in parallel. Stylesheet reload and elevation pyramid
+/// registration wait for running operations and block new ones until they are completed, so
+/// they should not be called from callbacks.
 class Application
 {
     const int SrtmElevationLodStart = 42; // NOTE: disable for initial MVP
+    /// Seconds of camera motion which quadkeys are prefetched for.
+    const double PrefetchHorizon = 10;
+    /// Max amount of quadkeys predicted by single camera update.
+    const std::size_t MaxPrefetchQuadKeys = 16;
+    /// Added to priority of prefetch jobs, so they run after any pending load job.
+    const double PrefetchPriorityOffset = 1E9;
+    /// Max amount of prefetched quadkeys which are not prefetched again.
+    const std::size_t MaxPrefetchedQuadKeys = 1024;
 public:
 
-    /// Composes object graph.
+    /// Composes object graph. Shared string table is only read from files, so processes which
+    /// use the same directory share its pages. Persistent and package stores reject elements with
+    /// strings missing in its files as their ids are known only to this process. Style providers
+    /// are built by every process and are not shared.
     Application(const char* stringPath, 
                 const char* elePath, 
-                OnError* errorCallback) :
-        stringTable_(stringPath), geoStore_(stringTable_), flatEleProvider_(),
-        srtmEleProvider_(elePath), quadKeyBuilder_(geoStore_, stringTable_)
+                OnError* errorCallback,
+                bool isSharedStringTable = false) :
+        stringTable_(stringPath, isSharedStringTable), geoStore_(stringTable_), flatEleProvider_(),
+        srtmEleProvider_(elePath), quadKeyBuilder_(geoStore_, stringTable_),
+        sharedStyleRules_(std::make_shared<utymap::mapcss::SharedStyleRules>(stringTable_)),
+        camera_(), hasCamera_(false), isPickingEnabled_(false), resultQueue_(), lastSteppedJobId_(0), scheduler_()
     {
         registerDefaultBuilders();
     }
 
+    /// Sets amount of threads of task scheduler shared by parallel paths of library: zero means
+    /// hardware concurrency. Threads are bound to cores if isPinned is set. Should be called
+    /// before quadkeys are loaded asynchronously as their job workers are created once.
+    void configureScheduler(int threadCount, bool isPinned)
+    {
+        utymap::utils::TaskScheduler::instance().configure(static_cast<std::size_t>(std::max(threadCount, 0)), isPinned);
+    }
+
     /// Registers stylesheet.
     void registerStylesheet(const char* path)
     {
         getStyleProvider(path);
     }
 
+    /// Reparses registered stylesheet and updates its style provider. Returns levels of details
+    /// which have changed styles. Stylesheet is registered if it is not yet.
+    std::vector<int> reloadStylesheet(const char* path, OnError* errorCallback)
+    {
+        std::vector<int> levelOfDetails;
+        safeExecute([&]() {
+            utymap::mapcss::StyleProvider* styleProvider = nullptr;
+            {
+                std::lock_guard<std::recursive_mutex> lock(providersLock_);
+                auto pair = styleProviders_.find(path);
+                if (pair == styleProviders_.end()) {
+                    getStyleProvider(path);
+                    return;
+                }
+                styleProvider = pair->second.get();
+            }
+            // NOTE stylesheet is parsed before builds are blocked.
+            auto stylesheet = parseStylesheet(path);
+            auto styleHash = hashStylesheet(path);
+            std::lock_guard<utymap::utils::SharedMutex> lock(buildLock_);
+            dropSteppedJobs();
+            levelOfDetails = styleProvider->reload(stylesheet);
+            std::lock_guard<std::recursive_mutex> providersLock(providersLock_);
+            styleHashes_[path] = styleHash;
+        }, errorCallback);
+        return levelOfDetails;
+    }
+
     /// Registers new in-memory store.
     void registerInMemoryStore(const char* key)
     {
+        recordSetupCommand("store_in_memory", { key });
         geoStore_.registerStore(key, utymap::utils::make_unique<utymap::index::InMemoryElementStore>(stringTable_));
     }
 
     /// Registers new persistent store.
     void registerPersistentStore(const char* key, const char* dataPath)
     {
+        recordSetupCommand("store_persistent", { key, dataPath });
         geoStore_.registerStore(key, utymap::utils::make_unique<utymap::index::PersistentElementStore>(dataPath, stringTable_));
     }
 
-    /// Preloads elevation data. Not thread safe.
+    /// Registers new store which keeps all tiles in single package file.
+    void registerPackageStore(const char* key, const char* packagePath)
+    {
+        recordSetupCommand("store_package", { key, packagePath });
+        geoStore_.registerStore(key, utymap::utils::make_unique<utymap::index::PackageElementStore>(packagePath, stringTable_));
+    }
+
+    /// Registers new read only store which fetches tiles of persistent store from remote endpoint
+    /// using callback and caches them in given directory. Endpoint should publish string table
+    /// of store next to its manifest.
+    void registerRemoteStore(const char* key, const char* cachePath, OnFileFetch* fetchCallback)
+    {
+        recordSetupCommand("store_remote", { key, cachePath });
+        auto store = utymap::utils::make_unique<utymap::index::RemoteElementStore>(cachePath, stringTable_,
+            [fetchCallback](const std::string& path, const std::string& destinationPath) {
+                return fetchCallback(path.c_str(), destinationPath.c_str());
+            });
+        {
+            std::lock_guard<std::mutex> lock(remoteStoresLock_);
+            remoteStores_[key] = store.get();
+        }
+        geoStore_.registerStore(key, std::move(store));
+    }
+
+    /// Fetches tile of remote store with given key in background if it is not cached yet.
+    void prefetchRemoteTile(const char* key, const utymap::QuadKey& quadKey, OnError* errorCallback)
+    {
+        safeExecute([&]() {
+            std::lock_guard<std::mutex> lock(remoteStoresLock_);
+            auto store = remoteStores_.find(key);
+            if (store == remoteStores_.end())
+                throw std::domain_error("Remote store is not registered: " + std::string(key));
+            store->second->prefetch(quadKey);
+        }, errorCallback);
+    }
+
+    /// Registers directory with precomputed heightmap pyramid. It is used as elevation source
+    /// for levels of details which do not use SRTM data. Waits for running builds.
+    void registerElevationPyramid(const char* path)
+    {
+        recordSetupCommand("elevation_pyramid", { path });
+        std::lock_guard<utymap::utils::SharedMutex> buildLock(buildLock_);
+        dropSteppedJobs();
+        std::lock_guard<std::recursive_mutex> lock(providersLock_);
+        pyramidPath_ = path;
+        pyramidEleProviders_.clear();
+        terrainRgbEleProvider_.reset();
+    }
+
+    /// Registers directory with terrain-RGB tiles of given zoom. It is used as elevation source
+    /// instead of heightmap pyramid for levels of details which do not use SRTM data. Waits for
+    /// running builds.
+    void registerElevationTiles(const char* path, int zoom)
+    {
+        recordSetupCommand("elevation_tiles", { path, std::to_string(zoom) });
+        std::lock_guard<utymap::utils::SharedMutex> buildLock(buildLock_);
+        dropSteppedJobs();
+        std::lock_guard<std::recursive_mutex> lock(providersLock_);
+        pyramidPath_.clear();
+        pyramidEleProviders_.clear();
+        terrainRgbEleProvider_ = utymap::utils::make_unique<utymap::heightmap::TerrainRgbElevationProvider>(path, zoom);
+        elevationTilesKey_ = std::string(path) + "/" + std::to_string(zoom);
+    }
+
+    /// Preloads elevation data. Elevation data is also loaded on demand, so this is optional.
     void preloadElevation(const utymap::QuadKey& quadKey)
     {
+        recordCommand("preload_elevation", { std::to_string(quadKey.levelOfDetail),
+                                             std::to_string(quadKey.tileX), std::to_string(quadKey.tileY) });
+        utymap::utils::SharedLock lock(buildLock_);
         getElevationProvider(quadKey).preload(utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey));
     }
 
+    /// Prepares application for the first quadkeys in background instead of doing it lazily on
+    /// first requests: stylesheets are parsed, store tiles and elevation of quadkeys which intersect
+    /// bounding box at given level of details are prefetched. All of it runs in parallel on task
+    /// scheduler. Returns id of job which completion callback is called when application is warmed
+    /// up; the first error, if any, is reported before it.
+    int warmup(const std::vector<std::string>& styleFiles,
+               const utymap::BoundingBox& bbox,
+               int levelOfDetail,
+               OnError* errorCallback,
+               OnJobCompleted* completionCallback)
+    {
+        std::vector<utymap::QuadKey> quadKeys;
+        utymap::utils::GeoUtils::visitTileRange(bbox, levelOfDetail, [&](const utymap::QuadKey& quadKey, const utymap::BoundingBox&) {
+            if (quadKeys.size() < MaxPrefetchedQuadKeys)
+                quadKeys.push_back(quadKey);
+        });
+
+        std::lock_guard<std::mutex> lock(schedulerLock_);
+        if (scheduler_ == nullptr)
+            scheduler_ = utymap::utils::make_unique<JobScheduler>(utymap::utils::TaskScheduler::instance().getThreadCount());
+
+        return scheduler_->submit(
+            []() { return 0.; },
+            [this, styleFiles, quadKeys, errorCallback]() { warmup(styleFiles, quadKeys, errorCallback); },
+            [completionCallback](int jobId, bool isCancelled) { completionCallback(jobId, isCancelled); });
+    }
+
     /// Adds data to store.
     void addToStore(const char* key, 
                     const char* styleFile, 
@@ -77,7 +260,10 @@ public:
                     const utymap::QuadKey& quadKey, 
                     OnError* errorCallback)
     {
+        recordCommand("add_quadkey", { key, styleFile, path, std::to_string(quadKey.levelOfDetail),
+                                       std::to_string(quadKey.tileX), std::to_string(quadKey.tileY) });
         safeExecute([&]() {
+            utymap::utils::SharedLock lock(buildLock_);
             geoStore_.add(key, path, quadKey, getStyleProvider(styleFile));
         }, errorCallback);
     }
@@ -90,7 +276,12 @@ public:
                     const utymap::LodRange& range, 
                     OnError* errorCallback)
     {
+        recordCommand("add_bbox", { key, styleFile, path,
+                                    toString(bbox.minPoint.latitude), toString(bbox.minPoint.longitude),
+                                    toString(bbox.maxPoint.latitude), toString(bbox.maxPoint.longitude),
+                                    std::to_string(range.start), std::to_string(range.end) });
         safeExecute([&]() {
+            utymap::utils::SharedLock lock(buildLock_);
             geoStore_.add(key, path, bbox, range, getStyleProvider(styleFile));
         }, errorCallback);
     }
@@ -102,11 +293,27 @@ public:
                     const utymap::LodRange& range, 
                     OnError* errorCallback)
     {
+        recordCommand("add_range", { key, styleFile, path, std::to_string(range.start), std::to_string(range.end) });
         safeExecute([&]() {
+            utymap::utils::SharedLock lock(buildLock_);
             geoStore_.add(key, path, range, getStyleProvider(styleFile));
         }, errorCallback);
     }
 
+    /// Imports files concurrently into store under single commit.
+    void addToStore(const char* key,
+                    const char* styleFile,
+                    const std::vector<std::string>& paths,
+                    const utymap::LodRange& range,
+                    std::size_t threadCount,
+                    OnError* errorCallback)
+    {
+        safeExecute([&]() {
+            utymap::utils::SharedLock lock(buildLock_);
+            geoStore_.add(key, paths, range, getStyleProvider(styleFile), threadCount);
+        }, errorCallback);
+    }
+
     /// Adds element to store.
     void addToStore(const char* key,
                     const char* styleFile, 
@@ -115,49 +322,1156 @@ public:
                     OnError* errorCallback)
     {
         safeExecute([&]() {
+            utymap::utils::SharedLock lock(buildLock_);
             geoStore_.add(key, element, range, getStyleProvider(styleFile));
         }, errorCallback);
     }
 
+    /// Adds elements to store under single commit.
+    void addToStore(const char* key,
+                    const char* styleFile,
+                    const std::vector<std::shared_ptr<utymap::entities::Element>>& elements,
+                    const utymap::LodRange& range,
+                    OnError* errorCallback)
+    {
+        safeExecute([&]() {
+            utymap::utils::SharedLock lock(buildLock_);
+            geoStore_.add(key, elements, range, getStyleProvider(styleFile));
+        }, errorCallback);
+    }
+
+    /// Enables or disables tracking of builders which consume elements of built quadkeys, so
+    /// loaded quadkey can be rebuilt partially when its element is added. Waits for running operations.
+    void enableRebuild(bool isEnabled)
+    {
+        std::lock_guard<utymap::utils::SharedMutex> lock(buildLock_);
+        quadKeyBuilder_.enableDependencyTracking(isEnabled);
+    }
+
+    /// Adds element to store and rebuilds it in given loaded quadkey: only meshes of builders
+    /// which consume element are reported, even if they are empty, so they replace meshes with
+    /// the same names. Ids of elements which meshes are not built anymore are reported by removed
+    /// callback. Whole quadkey is built if rebuild is not enabled or quadkey is not built recently.
+    /// NOTE pick index of quadkey is released as it does not match rebuilt meshes.
+    void addToStore(const char* key,
+                    const char* styleFile,
+                    const utymap::entities::Element& element,
+                    const utymap::LodRange& range,
+                    const utymap::QuadKey& quadKey,
+                    OnMeshBuilt* meshCallback,
+                    OnElementLoaded* elementCallback,
+                    OnElementsRemoved* removedCallback,
+                    OnError* errorCallback)
+    {
+        safeExecute([&]() {
+            utymap::utils::SharedLock lock(buildLock_);
+            auto& styleProvider = getStyleProvider(styleFile);
+            geoStore_.add(key, element, range, styleProvider);
+
+            ExportElementVisitor elementVisitor(stringTable_, styleProvider, quadKey.levelOfDetail, elementCallback);
+            auto removed = quadKeyBuilder_.rebuild(quadKey, { element.id }, styleProvider, getElevationProvider(quadKey),
+                [&meshCallback](const utymap::meshing::Mesh& mesh) {
+                    meshCallback(mesh.name.data(),
+                        mesh.vertices.data(), static_cast<int>(mesh.vertices.size()),
+                        mesh.triangles.data(), static_cast<int>(mesh.triangles.size()),
+                        mesh.colors.data(), static_cast<int>(mesh.colors.size()),
+                        mesh.uvs.data(), static_cast<int>(mesh.uvs.size()));
+                }, [&](const utymap::entities::Element& built) {
+                    if (elementCallback != nullptr)
+                        built.accept(elementVisitor);
+                });
+            releasePicking(quadKey);
+            if (removedCallback != nullptr)
+                removedCallback(removed.data(), static_cast<int>(removed.size()));
+        }, errorCallback);
+    }
+
+    /// Compacts store with given key: data of removed elements is dropped and oversized tiles
+    /// of persistent store are split, so their searches read less data.
+    void compactStore(const char* key, OnError* errorCallback)
+    {
+        safeExecute([&]() {
+            utymap::utils::SharedLock lock(buildLock_);
+            geoStore_.compact(key);
+        }, errorCallback);
+    }
+
+    /// Enables profiling of file imports: callback receives throughput by element type, fragments
+    /// per level of detail and given amount of tiles with the most bytes written. Null callback
+    /// disables profiling. Waits for running operations.
+    void setImportProfiling(int tileCount, OnImportProfiled* profileCallback)
+    {
+        std::lock_guard<utymap::utils::SharedMutex> lock(buildLock_);
+        if (profileCallback == nullptr) {
+            geoStore_.setImportProfileCallback(nullptr);
+            return;
+        }
+        std::size_t count = static_cast<std::size_t>(std::max(tileCount, 0));
+        geoStore_.setImportProfileCallback([count, profileCallback](const utymap::index::ImportProfile& profile) {
+            profileCallback(profile.toJson(count).c_str());
+        });
+    }
+
     bool hasData(const utymap::QuadKey& quadKey)
     {
         return geoStore_.hasData(quadKey);
     }
 
+    /// Reports element with given id as it is stored at given level of detail with its style.
+    /// Returns false if element is not found.
+    bool getElement(const char* styleFile,
+                    std::uint64_t id,
+                    int levelOfDetail,
+                    OnElementLoaded* elementCallback,
+                    OnError* errorCallback)
+    {
+        bool isFound = false;
+        safeExecute([&]() {
+            utymap::utils::SharedLock lock(buildLock_);
+            ExportElementVisitor elementVisitor(stringTable_, getStyleProvider(styleFile), levelOfDetail, elementCallback);
+            isFound = geoStore_.getElement(id, levelOfDetail, elementVisitor);
+        }, errorCallback);
+        return isFound;
+    }
+
+    /// Enables or disables keeping of triangle hierarchy for every loaded quadkey, so its
+    /// elements can be picked. Disabling releases hierarchies of loaded quadkeys.
+    void enablePicking(bool isEnabled)
+    {
+        std::lock_guard<std::mutex> lock(pickLock_);
+        isPickingEnabled_ = isEnabled;
+        if (!isEnabled)
+            pickIndices_.clear();
+    }
+
+    /// Releases triangle hierarchy of given quadkey when it is unloaded.
+    bool releasePicking(const utymap::QuadKey& quadKey)
+    {
+        std::lock_guard<std::mutex> lock(pickLock_);
+        return pickIndices_.erase(quadKey) > 0;
+    }
+
+    /// Picks element of loaded quadkey which triangle is hit first by ray. Ray is defined in
+    /// mesh coordinates: longitude, latitude and elevation.
+    bool pick(const utymap::QuadKey& quadKey, const double origin[3], const double direction[3],
+              utymap::meshing::MeshBvh::Hit& hit)
+    {
+        std::lock_guard<std::mutex> lock(pickLock_);
+        auto pair = pickIndices_.find(quadKey);
+        return pair != pickIndices_.end() && pair->second->pick(origin, direction, hit);
+    }
+
+    /// Picks topmost element of loaded quadkey at given point.
+    bool pick(const utymap::QuadKey& quadKey, const utymap::GeoCoordinate& coordinate,
+              utymap::meshing::MeshBvh::Hit& hit)
+    {
+        std::lock_guard<std::mutex> lock(pickLock_);
+        auto pair = pickIndices_.find(quadKey);
+        return pair != pickIndices_.end() && pair->second->pick(coordinate, hit);
+    }
+
+    /// Finds elements which names start with given prefix in all stores and reports given
+    /// amount of closest to coordinate ones ordered by distance.
+    void searchByName(const char* prefix,
+                      const utymap::GeoCoordinate& coordinate,
+                      int maxResults,
+                      OnNamesFound* namesCallback,
+                      OnError* errorCallback)
+    {
+        safeExecute([&]() {
+            utymap::utils::SharedLock lock(buildLock_);
+            auto matches = geoStore_.searchByName(prefix, coordinate, static_cast<std::size_t>(std::max(maxResults, 0)));
+            std::vector<std::uint64_t> ids;
+            std::vector<const char*> names;
+            std::vector<double> coordinates, distances;
+            for (const auto& match : matches) {
+                ids.push_back(match.id);
+                names.push_back(match.name.c_str());
+                coordinates.push_back(match.coordinate.longitude);
+                coordinates.push_back(match.coordinate.latitude);
+                distances.push_back(match.distance);
+            }
+            namesCallback(ids.data(), names.data(), coordinates.data(), distances.data(), static_cast<int>(matches.size()));
+        }, errorCallback);
+    }
+
     /// Loads given quadKey.
     void loadQuadKey(const char* styleFile, 
                      const utymap::QuadKey& quadKey, 
                      OnMeshBuilt* meshCallback,
                      OnElementLoaded* elementCallback, 
                      OnError* errorCallback)
+    {
+        loadQuadKey(styleFile, quadKey, [&meshCallback](const utymap::meshing::Mesh& mesh) {
+            meshCallback(mesh.name.data(),
+                mesh.vertices.data(), static_cast<int>(mesh.vertices.size()),
+                mesh.triangles.data(), static_cast<int>(mesh.triangles.size()),
+                mesh.colors.data(), static_cast<int>(mesh.colors.size()),
+                mesh.uvs.data(), static_cast<int>(mesh.uvs.size()));
+        }, elementCallback, errorCallback);
+    }
+
+    /// Loads given quadKey progressively: coarse terrain preview is reported first, so there
+    /// is no hole while the quadkey is built, then meshes and elements are reported as usual.
+    void loadQuadKeyProgressive(const char* styleFile,
+                                const utymap::QuadKey& quadKey,
+                                OnMeshBuilt* meshCallback,
+                                OnElementLoaded* elementCallback,
+                                OnError* errorCallback)
+    {
+        auto meshFunc = [&meshCallback](const utymap::meshing::Mesh& mesh) {
+            meshCallback(mesh.name.data(),
+                mesh.vertices.data(), static_cast<int>(mesh.vertices.size()),
+                mesh.triangles.data(), static_cast<int>(mesh.triangles.size()),
+                mesh.colors.data(), static_cast<int>(mesh.colors.size()),
+                mesh.uvs.data(), static_cast<int>(mesh.uvs.size()));
+        };
+        safeExecute([&]() {
+            utymap::utils::SharedLock lock(buildLock_);
+            utymap::builders::BuilderContext context(quadKey, getStyleProvider(styleFile), stringTable_,
+                getElevationProvider(quadKey), meshFunc, nullptr);
+            utymap::builders::TerraBuilder::buildPreview(context);
+        }, errorCallback);
+        loadQuadKey(styleFile, quadKey, meshFunc, elementCallback, errorCallback);
+    }
+
+    /// Loads given quadKey reporting meshes in packed format with positions relative to
+    /// south west corner of quadkey. Meshes of quadkeys which are in registered mesh package
+    /// are read from it without building: elements are not reported then.
+    void loadQuadKeyPacked(const char* styleFile,
+                           const utymap::QuadKey& quadKey,
+                           OnPackedMeshBuilt* meshCallback,
+                           OnElementLoaded* elementCallback,
+                           OnError* errorCallback)
+    {
+        loadQuadKeyPacked(styleFile, quadKey, [&](const char* name, const utymap::GeoCoordinate& origin,
+                                                  const utymap::meshing::PackedVertex* vertices, std::size_t vertexCount,
+                                                  const int* triangles, std::size_t triangleCount) {
+            meshCallback(name, origin.longitude, origin.latitude,
+                vertices, static_cast<int>(vertexCount), triangles, static_cast<int>(triangleCount));
+        }, elementCallback, errorCallback);
+    }
+
+    /// Loads given quadKey as loadQuadKeyPacked does, but meshes which have more vertices than
+    /// 16 bit indices can address are split into spatially coherent chunks with the same name.
+    void loadQuadKeyPackedShort(const char* styleFile,
+                                const utymap::QuadKey& quadKey,
+                                OnShortPackedMeshBuilt* meshCallback,
+                                OnElementLoaded* elementCallback,
+                                OnError* errorCallback)
+    {
+        utymap::meshing::MeshSplitter splitter;
+        loadQuadKeyPacked(styleFile, quadKey, [&](const char* name, const utymap::GeoCoordinate& origin,
+                                                  const utymap::meshing::PackedVertex* vertices, std::size_t vertexCount,
+                                                  const int* triangles, std::size_t triangleCount) {
+            splitter.split(vertices, vertexCount, triangles, triangleCount,
+                [&](const utymap::meshing::PackedVertex* chunkVertices, std::size_t chunkVertexCount,
+                    const std::uint16_t* chunkTriangles, std::size_t chunkTriangleCount) {
+                meshCallback(name, origin.longitude, origin.latitude, chunkVertices, static_cast<int>(chunkVertexCount),
+                    chunkTriangles, static_cast<int>(chunkTriangleCount));
+            });
+        }, elementCallback, errorCallback);
+    }
+
+    /// Loads given quadKey reporting meshes with vertices projected by projection which is set
+    /// by setProjection, so client does not have to project every vertex itself. If requested,
+    /// vertex normals are calculated too.
+    void loadQuadKeyProjected(const char* styleFile,
+                              const utymap::QuadKey& quadKey,
+                              bool hasNormals,
+                              OnProjectedMeshBuilt* meshCallback,
+                              OnElementLoaded* elementCallback,
+                              OnError* errorCallback)
+    {
+        std::unique_ptr<utymap::meshing::CartesianProjection> projection;
+        {
+            std::lock_guard<std::mutex> lock(projectionLock_);
+            if (projection_ != nullptr)
+                projection = utymap::utils::make_unique<utymap::meshing::CartesianProjection>(*projection_);
+        }
+        if (projection == nullptr) {
+            errorCallback("Projection is not set.");
+            return;
+        }
+
+        std::vector<float> vertices, normals;
+        loadQuadKey(styleFile, quadKey, [&](const utymap::meshing::Mesh& mesh) {
+            projection->project(mesh, vertices);
+            if (hasNormals)
+                utymap::meshing::CartesianProjection::calculateNormals(vertices, mesh.triangles, normals);
+            meshCallback(mesh.name.data(),
+                vertices.data(), static_cast<int>(vertices.size()),
+                normals.data(), static_cast<int>(normals.size()),
+                mesh.triangles.data(), static_cast<int>(mesh.triangles.size()),
+                mesh.colors.data(), static_cast<int>(mesh.colors.size()),
+                mesh.uvs.data(), static_cast<int>(mesh.uvs.size()));
+        }, elementCallback, errorCallback);
+    }
+
+    /// Loads given quadKey reporting meshes in quantized and optionally compressed format.
+    void loadQuadKeyEncoded(const char* styleFile,
+                            const utymap::QuadKey& quadKey,
+                            bool isCompressed,
+                            OnEncodedMeshBuilt* meshCallback,
+                            OnElementLoaded* elementCallback,
+                            OnError* errorCallback)
+    {
+        // NOTE meshes of quadkey share quantization grid, so their common vertices are the same.
+        auto tileBounds = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey);
+        loadQuadKey(styleFile, quadKey, [&](const utymap::meshing::Mesh& mesh) {
+            std::string data = utymap::meshing::MeshCodec::encode(mesh, tileBounds, isCompressed);
+            meshCallback(mesh.name.data(), data.data(), static_cast<int>(data.size()));
+        }, elementCallback, errorCallback);
+    }
+
+    /// Builds given quadKey and writes its meshes to binary glTF file. Positions are in meters
+    /// relative to south west corner of quadkey.
+    void exportQuadKeyGlb(const char* styleFile,
+                          const utymap::QuadKey& quadKey,
+                          const char* path,
+                          OnError* errorCallback)
     {
         safeExecute([&]() {
+            std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+            writeQuadKeyGlb(styleFile, quadKey, file, errorCallback);
+            if (!file.good())
+                throw std::domain_error(std::string("Cannot write glTF file: ") + path);
+        }, errorCallback);
+    }
+
+    /// Builds given quadKey and writes its meshes to stream as binary glTF.
+    void writeQuadKeyGlb(const char* styleFile,
+                         const utymap::QuadKey& quadKey,
+                         std::ostream& stream,
+                         OnError* errorCallback)
+    {
+        utymap::meshing::GlbWriter writer(utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey).minPoint);
+        loadQuadKey(styleFile, quadKey, [&](const utymap::meshing::Mesh& mesh) {
+            writer.add(mesh);
+        }, nullptr, errorCallback);
+
+        safeExecute([&]() { writer.write(stream); }, errorCallback);
+    }
+
+    /// Loads given quadKey reporting all its elements by single callback after the meshes.
+    void loadQuadKeyElementBatch(const char* styleFile,
+                                 const utymap::QuadKey& quadKey,
+                                 OnMeshBuilt* meshCallback,
+                                 OnElementsLoaded* elementsCallback,
+                                 OnError* errorCallback)
+    {
+        loadQuadKey(styleFile, quadKey, [&meshCallback](const utymap::meshing::Mesh& mesh) {
+            meshCallback(mesh.name.data(),
+                mesh.vertices.data(), static_cast<int>(mesh.vertices.size()),
+                mesh.triangles.data(), static_cast<int>(mesh.triangles.size()),
+                mesh.colors.data(), static_cast<int>(mesh.colors.size()),
+                mesh.uvs.data(), static_cast<int>(mesh.uvs.size()));
+        }, nullptr, errorCallback, nullptr, elementsCallback);
+    }
+
+    /// Loads given quadKey reporting elements with string table ids instead of strings.
+    void loadQuadKeyWithIds(const char* styleFile,
+                            const utymap::QuadKey& quadKey,
+                            OnMeshBuilt* meshCallback,
+                            OnElementIdsLoaded* elementCallback,
+                            OnError* errorCallback)
+    {
+        loadQuadKey(styleFile, quadKey, [&meshCallback](const utymap::meshing::Mesh& mesh) {
+            meshCallback(mesh.name.data(),
+                mesh.vertices.data(), static_cast<int>(mesh.vertices.size()),
+                mesh.triangles.data(), static_cast<int>(mesh.triangles.size()),
+                mesh.colors.data(), static_cast<int>(mesh.colors.size()),
+                mesh.uvs.data(), static_cast<int>(mesh.uvs.size()));
+        }, nullptr, errorCallback, nullptr, nullptr, elementCallback);
+    }
+
+    /// Loads given quadKey handing mesh buffers over to callback without copying. Buffers
+    /// are valid until mesh is released by its handle.
+    void loadQuadKeyOwned(const char* styleFile,
+                          const utymap::QuadKey& quadKey,
+                          OnMeshHandleBuilt* meshCallback,
+                          OnElementLoaded* elementCallback,
+                          OnError* errorCallback)
+    {
+        loadQuadKey(styleFile, quadKey, [&](const utymap::meshing::Mesh& mesh) {
+            // NOTE builders do not use mesh after it is reported, so its buffers are taken.
+            const utymap::meshing::Mesh* owned = nullptr;
+            int handle = meshRegistry_.add(const_cast<utymap::meshing::Mesh&>(mesh), owned);
+            meshCallback(handle, owned->name.data(),
+                owned->vertices.data(), static_cast<int>(owned->vertices.size()),
+                owned->triangles.data(), static_cast<int>(owned->triangles.size()),
+                owned->colors.data(), static_cast<int>(owned->colors.size()),
+                owned->uvs.data(), static_cast<int>(owned->uvs.size()));
+        }, elementCallback, errorCallback);
+    }
+
+    /// Releases mesh which buffers were handed over. Returns false if handle is unknown.
+    bool releaseMesh(int handle)
+    {
+        return meshRegistry_.release(handle);
+    }
+
+    /// Loads given quadKey reporting element ranges of batched meshes after the meshes.
+    void loadQuadKeyBatched(const char* styleFile,
+                            const utymap::QuadKey& quadKey,
+                            OnMeshBuilt* meshCallback,
+                            OnElementRangesBuilt* rangesCallback,
+                            OnElementLoaded* elementCallback,
+                            OnError* errorCallback)
+    {
+        loadQuadKey(styleFile, quadKey, [&](const utymap::meshing::Mesh& mesh) {
+            meshCallback(mesh.name.data(),
+                mesh.vertices.data(), static_cast<int>(mesh.vertices.size()),
+                mesh.triangles.data(), static_cast<int>(mesh.triangles.size()),
+                mesh.colors.data(), static_cast<int>(mesh.colors.size()),
+                mesh.uvs.data(), static_cast<int>(mesh.uvs.size()));
+            if (!mesh.elementRanges.empty())
+                rangesCallback(mesh.name.data(), mesh.elementRanges.data(), static_cast<int>(mesh.elementRanges.size()));
+        }, elementCallback, errorCallback);
+    }
+
+    /// Loads given quadKey reporting repeated geometry, e.g. trees, as instances of
+    /// prototype mesh instead of merging it into meshes.
+    void loadQuadKeyInstanced(const char* styleFile,
+                              const utymap::QuadKey& quadKey,
+                              OnMeshBuilt* meshCallback,
+                              OnInstancesBuilt* instancesCallback,
+                              OnElementLoaded* elementCallback,
+                              OnError* errorCallback)
+    {
+        loadQuadKey(styleFile, quadKey, [&meshCallback](const utymap::meshing::Mesh& mesh) {
+            meshCallback(mesh.name.data(),
+                mesh.vertices.data(), static_cast<int>(mesh.vertices.size()),
+                mesh.triangles.data(), static_cast<int>(mesh.triangles.size()),
+                mesh.colors.data(), static_cast<int>(mesh.colors.size()),
+                mesh.uvs.data(), static_cast<int>(mesh.uvs.size()));
+        }, elementCallback, errorCallback, [&instancesCallback](const utymap::meshing::MeshInstances& instances) {
+            const auto& prototype = instances.prototype;
+            instancesCallback(prototype.name.data(),
+                prototype.vertices.data(), static_cast<int>(prototype.vertices.size()),
+                prototype.triangles.data(), static_cast<int>(prototype.triangles.size()),
+                prototype.colors.data(), static_cast<int>(prototype.colors.size()),
+                instances.transforms.data(), static_cast<int>(instances.transforms.size()));
+        });
+    }
+
+    /// Loads given quadKey on worker thread and returns id of the job. Pending jobs closest
+    /// to camera position run first. Callbacks are called on worker thread; completion
+    /// callback is called last, also if job is cancelled before run.
+    int loadQuadKeyAsync(const char* styleFile,
+                         const utymap::QuadKey& quadKey,
+                         OnMeshBuilt* meshCallback,
+                         OnElementLoaded* elementCallback,
+                         OnError* errorCallback,
+                         OnJobCompleted* completionCallback)
+    {
+        std::string stylePath = styleFile;
+        auto center = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey).center();
+        std::lock_guard<std::mutex> lock(schedulerLock_);
+        if (scheduler_ == nullptr)
+            scheduler_ = utymap::utils::make_unique<JobScheduler>(utymap::utils::TaskScheduler::instance().getThreadCount());
+
+        return scheduler_->submit(
+            [this, center]() { return getCameraDistance(center); },
+            [=]() { loadQuadKey(stylePath.c_str(), quadKey, meshCallback, elementCallback, errorCallback); },
+            [completionCallback](int jobId, bool isCancelled) { completionCallback(jobId, isCancelled); });
+    }
+
+    /// Loads quadkey on worker thread and returns job id. Meshes, elements, errors and job completion
+    /// are pushed to result queue instead of calling client code on worker thread.
+    int loadQuadKeyQueued(const char* styleFile, const utymap::QuadKey& quadKey)
+    {
+        recordLoad(styleFile, quadKey);
+        std::string stylePath = styleFile;
+        auto center = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey).center();
+        std::lock_guard<std::mutex> lock(schedulerLock_);
+        if (scheduler_ == nullptr)
+            scheduler_ = utymap::utils::make_unique<JobScheduler>(utymap::utils::TaskScheduler::instance().getThreadCount());
+
+        // NOTE job id is known only after submit: it is assigned under scheduler lock, so action
+        // reads it under the same lock.
+        auto jobIdPtr = std::make_shared<int>(0);
+        int id = scheduler_->submit(
+            [this, center]() { return getCameraDistance(center); },
+            [this, stylePath, quadKey, jobIdPtr]() {
+                int jobId;
+                {
+                    std::lock_guard<std::mutex> lock(schedulerLock_);
+                    jobId = *jobIdPtr;
+                }
+                try {
+                    utymap::utils::SharedLock buildLock(buildLock_);
+                    auto& styleProvider = getStyleProvider(stylePath.c_str());
+                    ResultQueue::ElementWriter elementWriter(resultQueue_, jobId, stringTable_, styleProvider, quadKey.levelOfDetail);
+                    buildQuadKey(stylePath.c_str(), quadKey, styleProvider, [&](const utymap::meshing::Mesh& mesh) {
+                        // NOTE builders do not use mesh after it is reported, so its buffers are taken.
+                        resultQueue_.pushMesh(jobId, const_cast<utymap::meshing::Mesh&>(mesh));
+                    }, [&](const utymap::entities::Element& element) {
+                        element.accept(elementWriter);
+                    }, nullptr);
+                }
+                catch (std::exception& ex) {
+                    resultQueue_.pushError(jobId, ex.what());
+                }
+            },
+            [this](int jobId, bool isCancelled) { resultQueue_.pushCompleted(jobId, isCancelled); });
+        *jobIdPtr = id;
+        return id;
+    }
+
+    /// Fills buffer with up to given amount of results of queued jobs and returns their amount.
+    /// Data of results is valid until next call which should be made from the same thread.
+    int pollResults(PolledResult* results, int maxCount)
+    {
+        return resultQueue_.poll(results, std::max(maxCount, 0));
+    }
+
+    /// Loads given quadkeys on worker pool and returns when all of them are processed. Quadkeys
+    /// closest to camera position are built first. Results are reported per quadkey as soon as
+    /// it is built: its meshes, then its elements and then quadkey callback. Callbacks are called
+    /// on worker threads, but never concurrently.
+    void loadQuadKeys(const char* styleFile,
+                      const std::vector<utymap::QuadKey>& quadKeys,
+                      int threadCount,
+                      OnMeshBuilt* meshCallback,
+                      OnElementLoaded* elementCallback,
+                      OnQuadKeyLoaded* quadKeyCallback,
+                      OnError* errorCallback)
+    {
+        if (sessionRecorder_.isStarted()) {
+            std::vector<std::string> arguments = { styleFile, std::to_string(threadCount) };
+            for (const auto& quadKey : quadKeys) {
+                arguments.push_back(std::to_string(quadKey.levelOfDetail));
+                arguments.push_back(std::to_string(quadKey.tileX));
+                arguments.push_back(std::to_string(quadKey.tileY));
+            }
+            recordCommand("load_quadkeys", arguments);
+        }
+
+        std::mutex lock;
+        std::condition_variable condition;
+        std::size_t pending = quadKeys.size();
+        // NOTE data of all quadkeys is requested at once before they are built.
+        for (const auto& quadKey : quadKeys)
+            geoStore_.prefetch(quadKey);
+        {
+            JobScheduler scheduler(static_cast<std::size_t>(std::max(threadCount, 1)));
+            for (const auto& quadKey : quadKeys) {
+                auto center = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey).center();
+                scheduler.submit([this, center]() { return getCameraDistance(center); }, [&, quadKey]() {
+                    std::vector<std::unique_ptr<utymap::meshing::Mesh>> meshes;
+                    std::vector<std::shared_ptr<utymap::entities::Element>> elements;
+                    safeExecute([&]() {
+                        utymap::utils::SharedLock buildLock(buildLock_);
+                        auto& styleProvider = getStyleProvider(styleFile);
+                        buildQuadKey(styleFile, quadKey, styleProvider, [&](const utymap::meshing::Mesh& mesh) {
+                            // NOTE builders do not use mesh after it is reported, so its buffers are taken.
+                            auto& built = const_cast<utymap::meshing::Mesh&>(mesh);
+                            meshes.push_back(utymap::utils::make_unique<utymap::meshing::Mesh>(mesh.name));
+                            std::swap(meshes.back()->vertices, built.vertices);
+                            std::swap(meshes.back()->triangles, built.triangles);
+                            std::swap(meshes.back()->colors, built.colors);
+                            std::swap(meshes.back()->uvs, built.uvs);
+                        }, [&](const utymap::entities::Element& element) {
+                            if (elementCallback == nullptr)
+                                return;
+                            utymap::entities::ElementCopier copier;
+                            element.accept(copier);
+                            elements.push_back(copier.element);
+                        }, nullptr);
+
+                        std::lock_guard<std::mutex> guard(lock);
+                        for (const auto& mesh : meshes)
+                            meshCallback(mesh->name.data(),
+                                mesh->vertices.data(), static_cast<int>(mesh->vertices.size()),
+                                mesh->triangles.data(), static_cast<int>(mesh->triangles.size()),
+                                mesh->colors.data(), static_cast<int>(mesh->colors.size()),
+                                mesh->uvs.data(), static_cast<int>(mesh->uvs.size()));
+                        ExportElementVisitor elementVisitor(stringTable_, styleProvider, quadKey.levelOfDetail, elementCallback);
+                        for (const auto& element : elements)
+                            element->accept(elementVisitor);
+                    }, errorCallback);
+                }, [&, quadKey](int, bool) {
+                    std::lock_guard<std::mutex> guard(lock);
+                    quadKeyCallback(quadKey.tileX, quadKey.tileY, quadKey.levelOfDetail);
+                    --pending;
+                    condition.notify_one();
+                });
+            }
+
+            std::unique_lock<std::mutex> guard(lock);
+            condition.wait(guard, [&]() { return pending == 0; });
+        }
+    }
+
+    /// Creates job which builds quadkey in steps run by stepQuadKeyJob on calling thread, so hosts
+    /// without threads can spread build over frames. Returns id of job or zero if it cannot be
+    /// created. Jobs are dropped by stylesheet reload and elevation registration as they change
+    /// their inputs. NOTE mesh cache and picking are not used by stepped build.
+    int createQuadKeyJob(const char* styleFile,
+                         const utymap::QuadKey& quadKey,
+                         OnMeshBuilt* meshCallback,
+                         OnElementLoaded* elementCallback,
+                         OnError* errorCallback)
+    {
+        int jobId = 0;
+        safeExecute([&]() {
+            utymap::utils::SharedLock lock(buildLock_);
             auto& styleProvider = getStyleProvider(styleFile);
-            ExportElementVisitor elementVisitor(stringTable_, styleProvider, quadKey.levelOfDetail, elementCallback);
-            quadKeyBuilder_.build(quadKey, styleProvider, getElevationProvider(quadKey),
-                [&meshCallback](const utymap::meshing::Mesh& mesh) {
-                // NOTE do not notify if mesh is empty.
-                if (!mesh.vertices.empty()) {
-                    meshCallback(mesh.name.data(),
-                        mesh.vertices.data(), static_cast<int>(mesh.vertices.size()),
-                        mesh.triangles.data(), static_cast<int>(mesh.triangles.size()),
-                        mesh.colors.data(), static_cast<int>(mesh.colors.size()),
-                        mesh.uvs.data(), static_cast<int>(mesh.uvs.size()));
+            auto elementVisitor = std::make_shared<ExportElementVisitor>(stringTable_, styleProvider, quadKey.levelOfDetail, elementCallback);
+            auto job = quadKeyBuilder_.createJob(quadKey, styleProvider, getElevationProvider(quadKey),
+                [meshCallback](const utymap::meshing::Mesh& mesh) {
+                    // NOTE do not notify if mesh is empty.
+                    if (!mesh.vertices.empty())
+                        meshCallback(mesh.name.data(),
+                            mesh.vertices.data(), static_cast<int>(mesh.vertices.size()),
+                            mesh.triangles.data(), static_cast<int>(mesh.triangles.size()),
+                            mesh.colors.data(), static_cast<int>(mesh.colors.size()),
+                            mesh.uvs.data(), static_cast<int>(mesh.uvs.size()));
+                }, [elementVisitor, elementCallback](const utymap::entities::Element& element) {
+                    if (elementCallback != nullptr)
+                        element.accept(*elementVisitor);
+                });
+            std::lock_guard<std::mutex> jobsLock(steppedJobsLock_);
+            jobId = ++lastSteppedJobId_;
+            steppedJobs_[jobId] = std::move(job);
+        }, errorCallback);
+        return jobId;
+    }
+
+    /// Runs steps of quadkey job till given time budget in milliseconds is spent. Returns true
+    /// when job is completed: it is released then. Failed or unknown job is reported as error
+    /// and is completed too.
+    bool stepQuadKeyJob(int jobId, double budget, OnError* errorCallback)
+    {
+        std::unique_ptr<utymap::builders::QuadKeyBuilder::Job> job;
+        {
+            std::lock_guard<std::mutex> lock(steppedJobsLock_);
+            auto pair = steppedJobs_.find(jobId);
+            if (pair != steppedJobs_.end()) {
+                job = std::move(pair->second);
+                steppedJobs_.erase(pair);
+            }
+        }
+        if (job == nullptr) {
+            errorCallback(("Quadkey job is not found: " + std::to_string(jobId)).c_str());
+            return true;
+        }
+
+        bool isCompleted = true;
+        safeExecute([&]() {
+            utymap::utils::SharedLock lock(buildLock_);
+            isCompleted = job->step(budget);
+            // NOTE job is returned under build lock, so it is not stepped after its inputs are changed.
+            if (!isCompleted) {
+                std::lock_guard<std::mutex> jobsLock(steppedJobsLock_);
+                steppedJobs_[jobId] = std::move(job);
+            }
+        }, errorCallback);
+        return isCompleted;
+    }
+
+    /// Releases quadkey job which is not completed. Returns false if job is unknown.
+    bool releaseQuadKeyJob(int jobId)
+    {
+        std::lock_guard<std::mutex> lock(steppedJobsLock_);
+        return steppedJobs_.erase(jobId) > 0;
+    }
+
+    /// Cancels asynchronous job if it is not yet started. Returns true if job is cancelled.
+    bool cancelJob(int jobId)
+    {
+        std::lock_guard<std::mutex> lock(schedulerLock_);
+        return scheduler_ != nullptr && scheduler_->cancel(jobId);
+    }
+
+    /// Sets camera position which is used to prioritize asynchronous jobs.
+    void setCameraPosition(const utymap::GeoCoordinate& coordinate)
+    {
+        std::lock_guard<std::mutex> lock(cameraLock_);
+        camera_ = coordinate;
+        hasCamera_ = true;
+    }
+
+    /// Sets camera position and motion: heading is in degrees clockwise from north, velocity is
+    /// in meters per second. Quadkeys of given level of details which camera is expected to reach
+    /// soon are prefetched in background: store data and elevation, and also meshes if style file
+    /// is set and mesh cache is enabled. Prefetch jobs run after pending load jobs, the ones which
+    /// are not predicted anymore are cancelled. Returns amount of newly submitted prefetch jobs.
+    int setCameraMotion(const utymap::GeoCoordinate& coordinate,
+                        double heading,
+                        double velocity,
+                        int levelOfDetail,
+                        const char* styleFile)
+    {
+        setCameraPosition(coordinate);
+
+        std::vector<utymap::QuadKey> quadKeys;
+        double distance = std::max(0.0, velocity) * PrefetchHorizon;
+        // NOTE steps are in degrees per meter of path.
+        double degreesPerMeter = utymap::utils::GeoUtils::getOffset(coordinate, 1);
+        double latitudeStep = std::cos(utymap::utils::deg2Rad(heading)) * degreesPerMeter;
+        double longitudeStep = std::sin(utymap::utils::deg2Rad(heading)) * degreesPerMeter /
+            std::max(0.01, std::cos(utymap::utils::deg2Rad(coordinate.latitude)));
+        // NOTE path is sampled with half of tile width, so no quadkey on it is skipped.
+        double step = utymap::utils::GeoUtils::getTileWidth(levelOfDetail) / 2 /
+            std::max(std::abs(latitudeStep) + std::abs(longitudeStep), 1E-12);
+        for (double offset = 0; offset <= distance && quadKeys.size() < MaxPrefetchQuadKeys; offset += step) {
+            utymap::GeoCoordinate point(coordinate.latitude + latitudeStep * offset, coordinate.longitude + longitudeStep * offset);
+            auto quadKey = utymap::utils::GeoUtils::latLonToQuadKey(point, levelOfDetail);
+            if (std::find(quadKeys.begin(), quadKeys.end(), quadKey) == quadKeys.end())
+                quadKeys.push_back(quadKey);
+        }
+
+        std::vector<int> cancelled;
+        std::vector<utymap::QuadKey> submitted;
+        {
+            std::lock_guard<std::mutex> lock(prefetchLock_);
+            for (auto it = prefetchJobs_.begin(); it != prefetchJobs_.end(); ++it) {
+                if (std::find(quadKeys.begin(), quadKeys.end(), it->first) == quadKeys.end())
+                    cancelled.push_back(it->second);
+            }
+            for (const auto& quadKey : quadKeys) {
+                if (prefetchJobs_.find(quadKey) == prefetchJobs_.end() &&
+                    prefetchedQuadKeys_.find(quadKey) == prefetchedQuadKeys_.end())
+                    submitted.push_back(quadKey);
+            }
+        }
+
+        std::string stylePath = styleFile != nullptr ? styleFile : "";
+        std::lock_guard<std::mutex> lock(schedulerLock_);
+        if (scheduler_ == nullptr)
+            scheduler_ = utymap::utils::make_unique<JobScheduler>(utymap::utils::TaskScheduler::instance().getThreadCount());
+        // NOTE completion of cancelled job removes it from prefetch jobs.
+        for (int jobId : cancelled)
+            scheduler_->cancel(jobId);
+        for (const auto& quadKey : submitted) {
+            auto center = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey).center();
+            // NOTE job is registered before it can complete.
+            std::lock_guard<std::mutex> prefetchLock(prefetchLock_);
+            prefetchJobs_[quadKey] = scheduler_->submit(
+                [this, center]() { return PrefetchPriorityOffset + getCameraDistance(center); },
+                [this, stylePath, quadKey]() { prefetchQuadKey(stylePath, quadKey); },
+                [this, quadKey](int jobId, bool isCancelled) { completePrefetch(quadKey, jobId, isCancelled); });
+        }
+        return static_cast<int>(submitted.size());
+    }
+
+    /// Sets origin and scale of projection which is used by projected quadkey loading.
+    void setProjection(const utymap::GeoCoordinate& origin, double scale)
+    {
+        std::lock_guard<std::mutex> lock(projectionLock_);
+        projection_ = utymap::utils::make_unique<utymap::meshing::CartesianProjection>(origin, scale);
+    }
+
+    /// Registers mesh package which is used by packed quadkey loading.
+    void registerMeshPackage(const char* path, OnError* errorCallback)
+    {
+        safeExecute([&]() {
+            auto package = utymap::utils::make_unique<utymap::meshing::MeshPackageReader>(path);
+            std::lock_guard<std::mutex> lock(packagesLock_);
+            meshPackages_.push_back(std::move(package));
+        }, errorCallback);
+    }
+
+    /// Builds all quadkeys which intersect bounding box in given range of levels of details
+    /// using given amount of threads and writes their packed meshes to package file.
+    void bakeMeshPackage(const char* styleFile,
+                         const utymap::BoundingBox& bbox,
+                         const utymap::LodRange& range,
+                         const char* path,
+                         int threadCount,
+                         OnError* errorCallback)
+    {
+        safeExecute([&]() {
+            std::vector<utymap::QuadKey> quadKeys;
+            for (int lod = range.start; lod <= range.end; ++lod) {
+                utymap::utils::GeoUtils::visitTileRange(bbox, lod, [&](const utymap::QuadKey& quadKey, const utymap::BoundingBox&) {
+                    quadKeys.push_back(quadKey);
+                });
+            }
+
+            utymap::meshing::MeshPackageWriter writer(path);
+            std::mutex lock;
+            std::condition_variable condition;
+            std::size_t pending = quadKeys.size();
+            {
+                JobScheduler scheduler(static_cast<std::size_t>(std::max(threadCount, 1)));
+                for (std::size_t i = 0; i < quadKeys.size(); ++i) {
+                    // NOTE quadkeys are built in order they are submitted.
+                    double priority = static_cast<double>(i);
+                    auto quadKey = quadKeys[i];
+                    scheduler.submit([priority]() { return priority; }, [&, quadKey]() {
+                        auto origin = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey).minPoint;
+                        std::vector<utymap::meshing::PackedMesh> meshes;
+                        loadQuadKey(styleFile, quadKey, [&](const utymap::meshing::Mesh& mesh) {
+                            meshes.push_back(utymap::meshing::PackedMesh::pack(mesh, origin));
+                        }, nullptr, errorCallback);
+                        safeExecute([&]() { writer.add(quadKey, meshes); }, errorCallback);
+                    }, [&](int, bool) {
+                        std::lock_guard<std::mutex> guard(lock);
+                        --pending;
+                        condition.notify_one();
+                    });
                 }
-            }, [&elementVisitor](const utymap::entities::Element& element) {
-                element.accept(elementVisitor);
-            });
+
+                std::unique_lock<std::mutex> guard(lock);
+                condition.wait(guard, [&]() { return pending == 0; });
+            }
+            writer.finish();
         }, errorCallback);
     }
 
+    /// Enables cache of built quadkeys: given amount of recently used ones is kept in memory,
+    /// all of them are written to directory if it is not empty. Cached quadkey is replayed
+    /// while its stylesheet, data and elevation source are not changed. Disk entries are keyed
+    /// by version of quadkey data in stores, e.g. sizes and modification times of tile files,
+    /// so they are reused by another application instance. Quadkeys which have data in memory
+    /// stores are kept only in memory.
+    void enableMeshCache(const char* directory, int capacity)
+    {
+        std::lock_guard<utymap::utils::SharedMutex> lock(buildLock_);
+        meshCache_ = utymap::utils::make_unique<utymap::builders::MeshCache>(stringTable_, directory,
+            static_cast<std::size_t>(std::max(capacity, 1)));
+    }
+
+    /// Gets calls and time of quadkey build stages collected since start or last reset.
+    std::string getStatistics() const
+    {
+        return utymap::utils::Statistics::instance().toJson();
+    }
+
+    /// Resets collected statistics.
+    void resetStatistics()
+    {
+        utymap::utils::Statistics::instance().reset();
+    }
+
+    /// Gets approximate amount of bytes kept in memory by subsystems as json: element stores
+    /// by their keys, string table, mapped srtm cells, style providers, mesh cache, pick indices
+    /// of loaded quadkeys and meshes registered for external code.
+    std::string getMemoryReport()
+    {
+        utymap::utils::SharedLock buildLock(buildLock_);
+        std::ostringstream stream;
+
+        stream << "{\"element_stores\":{";
+        bool isFirst = true;
+        for (const auto& pair : geoStore_.getMemoryUsage()) {
+            stream << (isFirst ? "" : ",") << "\"" << pair.first << "\":" << pair.second;
+            isFirst = false;
+        }
+        stream << "}";
+
+        std::size_t styleUsage = 0;
+        {
+            std::lock_guard<std::recursive_mutex> lock(providersLock_);
+            for (const auto& pair : styleProviders_)
+                styleUsage += pair.second->getMemoryUsage();
+            styleUsage += sharedStyleRules_->getMemoryUsage();
+        }
+
+        stream << ",\"string_table\":" << stringTable_.getMemoryUsage()
+               << ",\"srtm\":" << srtmEleProvider_.getMemoryUsage()
+               << ",\"style_providers\":" << styleUsage
+               << ",\"mesh_cache\":" << (meshCache_ != nullptr ? meshCache_->getMemoryUsage() : 0)
+               << ",\"pick_indices\":" << getPickMemoryUsage()
+               << ",\"mesh_registry\":" << meshRegistry_.getMemoryUsage()
+               << "}";
+        return stream.str();
+    }
+
+    /// Starts recording of trace events discarding previously recorded ones.
+    void startTracing()
+    {
+        utymap::utils::TraceRecorder::instance().start();
+    }
+
+    /// Stops recording of trace events and writes them to file in chrome trace format.
+    void stopTracing(const char* path, OnError* errorCallback)
+    {
+        safeExecute([&]() {
+            utymap::utils::TraceRecorder::instance().stop(path);
+        }, errorCallback);
+    }
+
+    /// Starts recording of session inputs to file: store registrations, data imports from files and
+    /// quadkey loads with their time. Stores registered before are written first, batch loads are
+    /// recorded as single command. Elements added directly are not recorded.
+    void startRecording(const char* path, OnError* errorCallback)
+    {
+        safeExecute([&]() {
+            sessionRecorder_.start(path);
+        }, errorCallback);
+    }
+
+    /// Stops recording of session inputs.
+    void stopRecording()
+    {
+        sessionRecorder_.stop();
+    }
+
     /// Gets id for the string.
     std::uint32_t getStringId(const char* str) const
     {
         return stringTable_.getId(str);
     }
 
+    /// Gets ids for the strings.
+    std::vector<std::uint32_t> getStringIds(const std::vector<const char*>& strings) const
+    {
+        return stringTable_.getIds(strings);
+    }
+
+    /// Gets amount of strings in string table.
+    std::uint32_t getStringCount() const
+    {
+        return stringTable_.size();
+    }
+
+    /// Reports strings with ids in [fromId, toId) range which is clamped to string table size.
+    /// Strings are never changed once added, so external code can cache them by id.
+    void getStrings(std::uint32_t fromId, std::uint32_t toId, OnStringsLoaded* stringsCallback) const
+    {
+        toId = std::min(toId, stringTable_.size());
+        std::vector<std::string> strings;
+        std::vector<const char*> cstrings;
+        strings.reserve(toId > fromId ? toId - fromId : 0);
+        for (std::uint32_t id = fromId; id < toId; ++id)
+            strings.push_back(stringTable_.getString(id));
+        cstrings.reserve(strings.size());
+        for (const auto& string : strings)
+            cstrings.push_back(string.c_str());
+        stringsCallback(cstrings.data(), static_cast<int>(cstrings.size()));
+    }
+
 private:
 
+    /// Callback which receives packed mesh: name, origin, vertices and triangles.
+    typedef std::function<void(const char*, const utymap::GeoCoordinate&,
+                               const utymap::meshing::PackedVertex*, std::size_t,
+                               const int*, std::size_t)> PackedMeshCallback;
+
+    void loadQuadKeyPacked(const char* styleFile,
+                           const utymap::QuadKey& quadKey,
+                           const PackedMeshCallback& meshCallback,
+                           OnElementLoaded* elementCallback,
+                           OnError* errorCallback)
+    {
+        bool isRead = false;
+        safeExecute([&]() {
+            std::lock_guard<std::mutex> lock(packagesLock_);
+            for (const auto& package : meshPackages_) {
+                isRead = package->read(quadKey, [&](const char* name, const utymap::GeoCoordinate& origin,
+                                                    const utymap::meshing::PackedVertex* vertices, std::size_t vertexCount,
+                                                    const int* triangles, std::size_t triangleCount) {
+                    meshCallback(name, origin, vertices, vertexCount, triangles, triangleCount);
+                });
+                if (isRead) break;
+            }
+        }, errorCallback);
+        if (isRead)
+            return;
+
+        auto origin = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey).minPoint;
+        loadQuadKey(styleFile, quadKey, [&](const utymap::meshing::Mesh& mesh) {
+            auto packed = utymap::meshing::PackedMesh::pack(mesh, origin);
+            meshCallback(packed.name.data(), origin, packed.vertices.data(), packed.vertices.size(),
+                packed.triangles.data(), packed.triangles.size());
+        }, elementCallback, errorCallback);
+    }
+
+    void loadQuadKey(const char* styleFile,
+                     const utymap::QuadKey& quadKey,
+                     const std::function<void(const utymap::meshing::Mesh&)>& meshCallback,
+                     OnElementLoaded* elementCallback,
+                     OnError* errorCallback,
+                     const std::function<void(const utymap::meshing::MeshInstances&)>& instancesCallback = nullptr,
+                     OnElementsLoaded* elementsCallback = nullptr,
+                     OnElementIdsLoaded* elementIdsCallback = nullptr)
+    {
+        recordLoad(styleFile, quadKey);
+        safeExecute([&]() {
+            utymap::utils::SharedLock lock(buildLock_);
+            auto& styleProvider = getStyleProvider(styleFile);
+            ExportElementVisitor elementVisitor(stringTable_, styleProvider, quadKey.levelOfDetail, elementCallback);
+            ExportElementBatch elementBatch(stringTable_, styleProvider, quadKey.levelOfDetail);
+            ExportElementIdVisitor elementIdVisitor(styleProvider, quadKey.levelOfDetail, elementIdsCallback);
+            auto elementFunc = [&](const utymap::entities::Element& element) {
+                if (elementsCallback != nullptr)
+                    element.accept(elementBatch);
+                else if (elementIdsCallback != nullptr)
+                    element.accept(elementIdVisitor);
+                else if (elementCallback != nullptr)
+                    element.accept(elementVisitor);
+            };
+
+            std::unique_ptr<utymap::meshing::MeshBvh> pickIndex;
+            {
+                std::lock_guard<std::mutex> pickLock(pickLock_);
+                if (isPickingEnabled_)
+                    pickIndex = utymap::utils::make_unique<utymap::meshing::MeshBvh>();
+            }
+
+            if (pickIndex == nullptr)
+                buildQuadKey(styleFile, quadKey, styleProvider, meshCallback, elementFunc, instancesCallback);
+            else {
+                buildQuadKey(styleFile, quadKey, styleProvider, [&](const utymap::meshing::Mesh& mesh) {
+                    pickIndex->add(mesh);
+                    meshCallback(mesh);
+                }, elementFunc, instancesCallback);
+                pickIndex->build();
+                std::lock_guard<std::mutex> pickLock(pickLock_);
+                if (isPickingEnabled_)
+                    pickIndices_[quadKey] = std::move(pickIndex);
+            }
+
+            if (elementsCallback != nullptr)
+                elementBatch.flush(elementsCallback);
+        }, errorCallback);
+    }
+
+    /// Builds quadkey using mesh cache if it is enabled. Build lock should be taken by caller.
+    void buildQuadKey(const char* styleFile,
+                      const utymap::QuadKey& quadKey,
+                      const utymap::mapcss::StyleProvider& styleProvider,
+                      const std::function<void(const utymap::meshing::Mesh&)>& meshCallback,
+                      const std::function<void(const utymap::entities::Element&)>& elementCallback,
+                      const std::function<void(const utymap::meshing::MeshInstances&)>& instancesCallback)
+    {
+        auto& eleProvider = getElevationProvider(quadKey);
+        auto build = [&](const utymap::builders::QuadKeyBuilder::MeshCallback& meshFunc,
+                         const utymap::builders::QuadKeyBuilder::ElementCallback& elementFunc) {
+            quadKeyBuilder_.build(quadKey, styleProvider, eleProvider, [&meshFunc](const utymap::meshing::Mesh& mesh) {
+                // NOTE do not notify if mesh is empty.
+                if (!mesh.vertices.empty())
+                    meshFunc(mesh);
+            }, elementFunc, instancesCallback);
+        };
+
+        // NOTE instances are not cached: they are requested only by specific clients.
+        if (meshCache_ == nullptr || instancesCallback != nullptr)
+            build(meshCallback, elementCallback);
+        else {
+            bool isPersistentKey;
+            std::string key = getCacheKey(styleFile, quadKey, isPersistentKey);
+            meshCache_->build(key, meshCallback, elementCallback, build, isPersistentKey);
+        }
+    }
+
+    std::size_t getPickMemoryUsage()
+    {
+        std::lock_guard<std::mutex> lock(pickLock_);
+        std::size_t usage = 0;
+        for (const auto& pair : pickIndices_)
+            usage += pair.second->getMemoryUsage();
+        return usage;
+    }
+
+    /// Prefetches data of given quadkey ignoring errors: quadkey is loaded again on request.
+    void prefetchQuadKey(const std::string& stylePath, const utymap::QuadKey& quadKey)
+    {
+        try {
+            bool isCached;
+            {
+                // NOTE elevation providers can be replaced under exclusive lock while preloading.
+                utymap::utils::SharedLock lock(buildLock_);
+                geoStore_.prefetch(quadKey);
+                getElevationProvider(quadKey).preload(utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey));
+                isCached = meshCache_ != nullptr;
+            }
+            // NOTE meshes are built only to be kept in cache.
+            if (isCached && !stylePath.empty())
+                loadQuadKey(stylePath.c_str(), quadKey, [](const utymap::meshing::Mesh&) {}, nullptr, [](const char*) {});
+        }
+        catch (...) { }
+    }
+
+    /// Runs tasks of warmup in parallel and waits for them.
+    void warmup(const std::vector<std::string>& styleFiles, const std::vector<utymap::QuadKey>& quadKeys, OnError* errorCallback)
+    {
+        std::mutex errorLock;
+        std::string error;
+        auto execute = [&](const std::function<void()>& action) {
+            try {
+                action();
+            }
+            catch (std::exception& ex) {
+                std::lock_guard<std::mutex> lock(errorLock);
+                if (error.empty())
+                    error = ex.what();
+            }
+        };
+
+        utymap::utils::TaskGroup tasks(utymap::utils::TaskPriority::High);
+        for (const auto& styleFile : styleFiles)
+            tasks.run([&, styleFile]() { execute([&]() { warmupStylesheet(styleFile); }); });
+        for (const auto& quadKey : quadKeys) {
+            tasks.run([&, quadKey]() {
+                execute([&]() {
+                    geoStore_.prefetch(quadKey);
+                    utymap::utils::SharedLock buildLock(buildLock_);
+                    getElevationProvider(quadKey).preload(utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey));
+                });
+            });
+        }
+        tasks.wait();
+
+        // NOTE camera motion does not prefetch warmed up quadkeys again.
+        {
+            std::lock_guard<std::mutex> lock(prefetchLock_);
+            for (const auto& quadKey : quadKeys) {
+                if (prefetchedQuadKeys_.size() >= MaxPrefetchedQuadKeys)
+                    break;
+                prefetchedQuadKeys_.insert(quadKey);
+            }
+        }
+        if (!error.empty())
+            errorCallback(error.c_str());
+    }
+
+    /// Registers style provider of stylesheet parsing it without lock, so several stylesheets
+    /// are parsed in parallel.
+    void warmupStylesheet(const std::string& stylePath)
+    {
+        {
+            std::lock_guard<std::recursive_mutex> lock(providersLock_);
+            if (styleProviders_.find(stylePath) != styleProviders_.end())
+                return;
+        }
+
+        auto styleProvider = utymap::utils::make_unique<utymap::mapcss::StyleProvider>(
+            parseStylesheet(stylePath), stringTable_, sharedStyleRules_);
+        auto styleHash = hashStylesheet(stylePath);
+
+        std::lock_guard<std::recursive_mutex> lock(providersLock_);
+        if (styleProviders_.find(stylePath) != styleProviders_.end())
+            return;
+        styleProviders_.emplace(stylePath, std::move(styleProvider));
+        styleHashes_[stylePath] = styleHash;
+    }
+
+    void completePrefetch(const utymap::QuadKey& quadKey, int jobId, bool isCancelled)
+    {
+        std::lock_guard<std::mutex> lock(prefetchLock_);
+        auto job = prefetchJobs_.find(quadKey);
+        if (job != prefetchJobs_.end() && job->second == jobId)
+            prefetchJobs_.erase(job);
+        if (isCancelled)
+            return;
+        if (prefetchedQuadKeys_.size() >= MaxPrefetchedQuadKeys)
+            prefetchedQuadKeys_.clear();
+        prefetchedQuadKeys_.insert(quadKey);
+    }
+
+    /// Returns distance from camera to given point. Jobs are run in submission order
+    /// until camera position is set.
+    double getCameraDistance(const utymap::GeoCoordinate& coordinate)
+    {
+        std::lock_guard<std::mutex> lock(cameraLock_);
+        return hasCamera_ ? utymap::utils::GeoUtils::distance(camera_, coordinate) : 0;
+    }
+
     static void safeExecute(const std::function<void()>& action, 
                      OnError* errorCallback)
     {
@@ -171,17 +1485,110 @@ private:
 
     utymap::heightmap::ElevationProvider& getElevationProvider(const utymap::QuadKey& quadKey)
     {
-        return quadKey.levelOfDetail <= SrtmElevationLodStart
-            ? flatEleProvider_
-            : static_cast<utymap::heightmap::ElevationProvider&>(srtmEleProvider_);
+        std::lock_guard<std::recursive_mutex> lock(providersLock_);
+        if (quadKey.levelOfDetail > SrtmElevationLodStart)
+            return srtmEleProvider_;
+
+        if (terrainRgbEleProvider_ != nullptr)
+            return *terrainRgbEleProvider_;
+
+        if (pyramidPath_.empty())
+            return flatEleProvider_;
+
+        auto pair = pyramidEleProviders_.find(quadKey.levelOfDetail);
+        if (pair != pyramidEleProviders_.end())
+            return *pair->second;
+
+        return *pyramidEleProviders_.emplace(quadKey.levelOfDetail,
+            utymap::utils::make_unique<utymap::heightmap::PyramidElevationProvider>(pyramidPath_, quadKey.levelOfDetail)).first->second;
+    }
+
+    /// Drops stepped quadkey jobs as their inputs are changed. Build lock should be taken exclusively.
+    void dropSteppedJobs()
+    {
+        std::lock_guard<std::mutex> lock(steppedJobsLock_);
+        steppedJobs_.clear();
+    }
+
+    /// Records command of session if recording is started.
+    void recordCommand(const char* name, const std::vector<std::string>& arguments)
+    {
+        if (sessionRecorder_.isStarted())
+            sessionRecorder_.record(name, arguments);
+    }
+
+    /// Records command which sets up application for every later session.
+    void recordSetupCommand(const char* name, const std::vector<std::string>& arguments)
+    {
+        sessionRecorder_.recordSetup(name, arguments);
+    }
+
+    /// Records load of single quadkey.
+    void recordLoad(const char* styleFile, const utymap::QuadKey& quadKey)
+    {
+        recordCommand("load_quadkey", { styleFile, std::to_string(quadKey.levelOfDetail),
+                                        std::to_string(quadKey.tileX), std::to_string(quadKey.tileY) });
+    }
+
+    static std::string toString(double value)
+    {
+        std::ostringstream stream;
+        stream << std::setprecision(12) << value;
+        return stream.str();
     }
 
     const utymap::mapcss::StyleProvider& getStyleProvider(const std::string& stylePath)
     {
+        std::lock_guard<std::recursive_mutex> lock(providersLock_);
         auto pair = styleProviders_.find(stylePath);
         if (pair != styleProviders_.end())
             return *pair->second;
 
+        styleProviders_.emplace(
+            stylePath, 
+            utymap::utils::make_unique<utymap::mapcss::StyleProvider>(parseStylesheet(stylePath), stringTable_, sharedStyleRules_));
+        styleHashes_[stylePath] = hashStylesheet(stylePath);
+
+        return *styleProviders_[stylePath];
+    }
+
+    /// Returns hash of stylesheet file content. NOTE imported files are not included.
+    static std::size_t hashStylesheet(const std::string& stylePath)
+    {
+        std::ifstream styleFile(stylePath, std::ios::in | std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(styleFile)), std::istreambuf_iterator<char>());
+        return std::hash<std::string>()(content);
+    }
+
+    /// Returns key of mesh cache entry which changes with stylesheet, data and elevation source.
+    /// Key is persistent if data version of quadkey is the same in every process, otherwise it
+    /// uses modification counter of this instance.
+    std::string getCacheKey(const std::string& stylePath, const utymap::QuadKey& quadKey, bool& isPersistent)
+    {
+        std::uint64_t hash;
+        {
+            std::lock_guard<std::recursive_mutex> lock(providersLock_);
+            hash = styleHashes_[stylePath];
+            hash ^= std::hash<std::string>()(pyramidPath_) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            if (terrainRgbEleProvider_ != nullptr)
+                hash ^= std::hash<std::string>()(elevationTilesKey_) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        }
+        std::uint64_t dataVersion;
+        isPersistent = geoStore_.getDataVersion(quadKey, dataVersion);
+        if (!isPersistent)
+            dataVersion = geoStore_.getVersion();
+        hash ^= std::hash<std::uint64_t>()(dataVersion) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+
+        std::stringstream ss;
+        ss << quadKey.levelOfDetail << "_" << quadKey.tileX << "_" << quadKey.tileY << "_" << std::hex << hash;
+        return ss.str();
+    }
+
+    static utymap::mapcss::StyleSheet parseStylesheet(const std::string& stylePath)
+    {
+        if (utymap::mapcss::CompiledStyleSheet::isCompiled(stylePath))
+            return utymap::mapcss::CompiledStyleSheet::read(stylePath);
+
         std::ifstream styleFile(stylePath);
         if (!styleFile.good())
             throw std::invalid_argument(std::string("Cannot read mapcss file:") + stylePath);
@@ -189,13 +1596,7 @@ private:
         // NOTE not safe, but don't want to use boost filesystem only for this task.
         std::string dir = stylePath.substr(0, stylePath.find_last_of("\\/") + 1);
         utymap::mapcss::MapCssParser parser(dir);
-        utymap::mapcss::StyleSheet stylesheet = parser.parse(styleFile);
-      
-        styleProviders_.emplace(
-            stylePath, 
-            utymap::utils::make_unique<const utymap::mapcss::StyleProvider>(stylesheet, stringTable_));
-
-        return *styleProviders_[stylePath];
+        return parser.parse(styleFile);
     }
 
     void registerDefaultBuilders()
@@ -219,12 +1620,59 @@ private:
 
     utymap::index::StringTable stringTable_;
     utymap::index::GeoStore geoStore_;
+    /// Remote stores which are owned by geo store.
+    std::mutex remoteStoresLock_;
+    std::unordered_map<std::string, utymap::index::RemoteElementStore*> remoteStores_;
 
     utymap::heightmap::FlatElevationProvider flatEleProvider_;
     utymap::heightmap::SrtmElevationProvider srtmEleProvider_;
+    std::string pyramidPath_;
+    std::unordered_map<int, std::unique_ptr<utymap::heightmap::PyramidElevationProvider>> pyramidEleProviders_;
+    /// Provider of registered terrain-RGB tiles and their directory with zoom.
+    std::unique_ptr<utymap::heightmap::TerrainRgbElevationProvider> terrainRgbEleProvider_;
+    std::string elevationTilesKey_;
 
     utymap::builders::QuadKeyBuilder quadKeyBuilder_;
-    std::unordered_map<std::string, std::unique_ptr<const utymap::mapcss::StyleProvider>> styleProviders_;
+    /// Compiled declarations shared by registered stylesheets, so related themes are compiled once.
+    std::shared_ptr<utymap::mapcss::SharedStyleRules> sharedStyleRules_;
+    std::unordered_map<std::string, std::unique_ptr<utymap::mapcss::StyleProvider>> styleProviders_;
+    /// Guards lazily created providers which are requested from worker threads.
+    std::recursive_mutex providersLock_;
+    std::unordered_map<std::string, std::size_t> styleHashes_;
+    std::unique_ptr<utymap::builders::MeshCache> meshCache_;
+    /// Shared by operations which use providers, exclusive for their replacement.
+    utymap::utils::SharedMutex buildLock_;
+
+    std::mutex projectionLock_;
+    std::unique_ptr<utymap::meshing::CartesianProjection> projection_;
+    std::mutex cameraLock_;
+    utymap::GeoCoordinate camera_;
+    bool hasCamera_;
+    /// Guards pending prefetch jobs by quadkey and quadkeys which are prefetched already.
+    std::mutex prefetchLock_;
+    std::unordered_map<utymap::QuadKey, int, utymap::QuadKeyHash> prefetchJobs_;
+    std::unordered_set<utymap::QuadKey, utymap::QuadKeyHash> prefetchedQuadKeys_;
+
+    MeshRegistry meshRegistry_;
+    std::mutex pickLock_;
+    bool isPickingEnabled_;
+    std::unordered_map<utymap::QuadKey, std::unique_ptr<utymap::meshing::MeshBvh>, utymap::QuadKeyHash> pickIndices_;
+    SessionRecorder sessionRecorder_;
+
+    std::mutex packagesLock_;
+    std::vector<std::unique_ptr<utymap::meshing::MeshPackageReader>> meshPackages_;
+
+    /// Results of queued jobs which are polled by client.
+    ResultQueue resultQueue_;
+
+    /// Quadkey jobs which are stepped by client.
+    std::mutex steppedJobsLock_;
+    std::unordered_map<int, std::unique_ptr<utymap::builders::QuadKeyBuilder::Job>> steppedJobs_;
+    int lastSteppedJobId_;
+
+    /// NOTE declared last to stop workers before other members are destroyed.
+    std::mutex schedulerLock_;
+    std::unique_ptr<JobScheduler> scheduler_;
 };
 
 #endif // APPLICATION_HPP_DEFINED
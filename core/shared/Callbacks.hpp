@@ -10,12 +10,106 @@ typedef void OnMeshBuilt(const char* name,
                          const int* colors, int colorSize,
                          const double* uvs, int uvSize);
 
+/// Callback which is called when mesh is built and its buffers are handed over: they stay
+/// valid after callback returns until mesh is released by handle.
+typedef void OnMeshHandleBuilt(int handle, const char* name,
+                               const double* vertices, int vertexSize,
+                               const int* triangles, int triSize,
+                               const int* colors, int colorSize,
+                               const double* uvs, int uvSize);
+
+/// Callback which is called when mesh is built in packed format. Vertices are interleaved
+/// 24 byte records: x, y, z as floats relative to origin, r, g, b, a as bytes and u, v as floats.
+typedef void OnPackedMeshBuilt(const char* name,
+                               double originLongitude, double originLatitude,
+                               const void* vertices, int vertexCount,
+                               const int* triangles, int triSize);
+
+/// Callback which is called when packed mesh or its chunk is built with 16 bit indices.
+/// Vertex layout is the same as in packed mesh callback.
+typedef void OnShortPackedMeshBuilt(const char* name,
+                                    double originLongitude, double originLatitude,
+                                    const void* vertices, int vertexCount,
+                                    const std::uint16_t* triangles, int triSize);
+
+/// Callback which is called when mesh is built with vertices projected to local metric space:
+/// interleaved x (east), y (up) and z (north) floats relative to projection origin. Normals
+/// use the same layout and are empty if they are not requested.
+typedef void OnProjectedMeshBuilt(const char* name,
+                                  const float* vertices, int vertexSize,
+                                  const float* normals, int normalSize,
+                                  const int* triangles, int triSize,
+                                  const int* colors, int colorSize,
+                                  const double* uvs, int uvSize);
+
+/// Callback which is called when mesh is built in encoded format, see MeshCodec.
+typedef void OnEncodedMeshBuilt(const char* name, const char* data, int dataSize);
+
+/// Callback which is called when instances of prototype mesh are built. Transforms are
+/// interleaved 6 value records: longitude, latitude, elevation, scale, rotation around
+/// vertical axis in radians and color seed.
+typedef void OnInstancesBuilt(const char* name,
+                              const double* vertices, int vertexSize,
+                              const int* triangles, int triSize,
+                              const int* colors, int colorSize,
+                              const double* transforms, int transformSize);
+
+/// Callback which is called after mesh which contains merged elements is built. Ranges
+/// are interleaved element id, index of first triangle and amount of triangles.
+typedef void OnElementRangesBuilt(const char* name, const std::uint64_t* ranges, int rangeSize);
+
 /// Callback which is called when element is loaded.
 typedef void OnElementLoaded(std::uint64_t id, const char** tags, int tagsSize,
                              const double* vertices, int vertexSize,
                              const char** style, int styleSize);
 
+/// Callback which is called when element is loaded. Tags are interleaved key and value ids of
+/// string table strings. Style keys are string table ids, style values are passed as strings
+/// as they are evaluated for element.
+typedef void OnElementIdsLoaded(std::uint64_t id, const std::uint32_t* tags, int tagSize,
+                                const double* vertices, int vertexSize,
+                                const std::uint32_t* styleKeys, const char** styleValues, int styleSize);
+
+/// Callback which is called with ids of elements which meshes are removed by rebuild.
+typedef void OnElementsRemoved(const std::uint64_t* ids, int count);
+
+/// Callback which is called with strings of string table starting from requested id.
+typedef void OnStringsLoaded(const char** strings, int count);
+
+/// Callback which is called once for all elements of quadkey. Every element has id and record of
+/// six values: offset and size of its tags, coordinates and styles. Tags and styles are interleaved
+/// key and value indices of strings, coordinates are interleaved longitude and latitude.
+typedef void OnElementsLoaded(const std::uint64_t* ids, const int* records, int elementCount,
+                              const int* tags, int tagSize,
+                              const double* coordinates, int coordinateSize,
+                              const int* styles, int styleSize,
+                              const char** strings, int stringCount);
+
+/// Callback which is called when all results of quadkey are reported.
+typedef void OnQuadKeyLoaded(int tileX, int tileY, int levelOfDetail);
+
+/// Callback which is called with statistics of quadkey build stages in json format.
+typedef void OnStatisticsLoaded(const char* json);
+
+/// Callback which is called with memory usage of subsystems in json format.
+typedef void OnMemoryReportLoaded(const char* json);
+
+/// Callback which is called with profile of file import in json format.
+typedef void OnImportProfiled(const char* json);
+
+/// Callback which is called with elements found by name. Coordinates are interleaved longitude
+/// and latitude, distances are in meters.
+typedef void OnNamesFound(const std::uint64_t* ids, const char** names,
+                          const double* coordinates, const double* distances, int count);
+
+/// Callback which fetches file with given path relative to remote store root into destination
+/// path. Returns false if file cannot be fetched. It is called from worker threads.
+typedef bool OnFileFetch(const char* path, const char* destinationPath);
+
 /// Callback which is called when operation is completed.
 typedef void OnError(const char* errorMessage);
 
+/// Callback which is called when asynchronous job is completed or it is cancelled before run.
+typedef void OnJobCompleted(int jobId, bool isCancelled);
+
 #endif // CALLBACKS_HPP_DEFINED
@@ -0,0 +1,140 @@
+#ifndef EXPORTELEMENTBATCH_HPP_DEFINED
+#define EXPORTELEMENTBATCH_HPP_DEFINED
+
+#include "Callbacks.hpp"
+#include "GeoCoordinate.hpp"
+#include "entities/Element.hpp"
+#include "entities/Node.hpp"
+#include "entities/Area.hpp"
+#include "entities/Way.hpp"
+#include "entities/Relation.hpp"
+#include "mapcss/StyleProvider.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Collects elements of quadkey into flat buffers which are exported by single callback.
+/// Strings are kept once in shared pool and referenced by index from tags and styles.
+class ExportElementBatch final : public utymap::entities::ElementVisitor
+{
+public:
+    /// Amount of values in element record.
+    static const int RecordSize = 6;
+
+    ExportElementBatch(utymap::index::StringTable& stringTable,
+                       const utymap::mapcss::StyleProvider& styleProvider,
+                       int levelOfDetail) :
+        stringTable_(stringTable), styleProvider_(styleProvider), levelOfDetail_(levelOfDetail)
+    {
+    }
+
+    void visitNode(const utymap::entities::Node& node) override
+    {
+        addElement(node, &node.coordinate, 1);
+    }
+
+    void visitWay(const utymap::entities::Way& way) override
+    {
+        addElement(way, way.coordinates.data(), way.coordinates.size());
+    }
+
+    void visitArea(const utymap::entities::Area& area) override
+    {
+        addElement(area, area.coordinates.data(), area.coordinates.size());
+    }
+
+    void visitRelation(const utymap::entities::Relation& relation) override
+    {
+        // TODO not supported yet.
+    }
+
+    /// Reports collected elements and clears buffers.
+    void flush(OnElementsLoaded* elementsCallback)
+    {
+        std::vector<const char*> strings;
+        strings.reserve(strings_.size());
+        for (const auto& string : strings_)
+            strings.push_back(string.c_str());
+
+        elementsCallback(ids_.data(), records_.data(), static_cast<int>(ids_.size()),
+            tags_.data(), static_cast<int>(tags_.size()),
+            coordinates_.data(), static_cast<int>(coordinates_.size()),
+            styles_.data(), static_cast<int>(styles_.size()),
+            strings.data(), static_cast<int>(strings.size()));
+
+        ids_.clear();
+        records_.clear();
+        tags_.clear();
+        coordinates_.clear();
+        styles_.clear();
+    }
+
+private:
+    void addElement(const utymap::entities::Element& element,
+                    const utymap::GeoCoordinate* coordinates,
+                    std::size_t count)
+    {
+        ids_.push_back(element.id);
+        records_.insert(records_.end(), {
+            static_cast<int>(tags_.size()), static_cast<int>(element.tags.size() * 2),
+            static_cast<int>(coordinates_.size()), static_cast<int>(count * 2) });
+
+        for (const auto& tag : element.tags) {
+            tags_.push_back(getStringIndex(tag.key));
+            tags_.push_back(getStringIndex(tag.value));
+        }
+
+        for (std::size_t i = 0; i < count; ++i) {
+            coordinates_.push_back(coordinates[i].longitude);
+            coordinates_.push_back(coordinates[i].latitude);
+        }
+
+        utymap::mapcss::Style style = styleProvider_.forElement(element, levelOfDetail_);
+        auto declarations = style.declarations();
+        records_.insert(records_.end(), {
+            static_cast<int>(styles_.size()), static_cast<int>(declarations.size() * 2) });
+        for (const auto& declaration : declarations) {
+            styles_.push_back(getStringIndex(declaration->key()));
+            styles_.push_back(getStringIndex(declaration->value()));
+        }
+    }
+
+    /// Returns index of string table string in pool.
+    int getStringIndex(std::uint32_t id)
+    {
+        auto pair = idIndices_.find(id);
+        if (pair != idIndices_.end())
+            return pair->second;
+
+        int index = getStringIndex(stringTable_.getString(id));
+        idIndices_.emplace(id, index);
+        return index;
+    }
+
+    int getStringIndex(const std::string& string)
+    {
+        auto pair = stringIndices_.emplace(string, static_cast<int>(strings_.size()));
+        if (pair.second)
+            strings_.push_back(string);
+        return pair.first->second;
+    }
+
+    utymap::index::StringTable& stringTable_;
+    const utymap::mapcss::StyleProvider& styleProvider_;
+    int levelOfDetail_;
+
+    std::vector<std::uint64_t> ids_;
+    std::vector<int> records_;
+    std::vector<int> tags_;
+    std::vector<double> coordinates_;
+    std::vector<int> styles_;
+
+    /// String pool is kept between flushes, so indices stay valid.
+    std::vector<std::string> strings_;
+    std::unordered_map<std::string, int> stringIndices_;
+    std::unordered_map<std::uint32_t, int> idIndices_;
+};
+
+#endif // EXPORTELEMENTBATCH_HPP_DEFINED
@@ -0,0 +1,93 @@
+#ifndef EXPORTELEMENTIDVISITOR_HPP_DEFINED
+#define EXPORTELEMENTIDVISITOR_HPP_DEFINED
+
+#include "Callbacks.hpp"
+#include "GeoCoordinate.hpp"
+#include "entities/Element.hpp"
+#include "entities/Node.hpp"
+#include "entities/Area.hpp"
+#include "entities/Way.hpp"
+#include "entities/Relation.hpp"
+#include "mapcss/StyleProvider.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/// Exports elements to external code using string table ids instead of strings.
+/// External code resolves ids once using incremental string table synchronization.
+/// Style values are unique for many elements, so they are passed as strings instead of
+/// growing string table.
+class ExportElementIdVisitor final : public utymap::entities::ElementVisitor
+{
+public:
+    ExportElementIdVisitor(const utymap::mapcss::StyleProvider& styleProvider,
+                           int levelOfDetail,
+                           OnElementIdsLoaded* elementCallback) :
+        styleProvider_(styleProvider), levelOfDetail_(levelOfDetail), elementCallback_(elementCallback)
+    {
+    }
+
+    void visitNode(const utymap::entities::Node& node) override
+    {
+        visitElement(node, &node.coordinate, 1);
+    }
+
+    void visitWay(const utymap::entities::Way& way) override
+    {
+        visitElement(way, way.coordinates.data(), way.coordinates.size());
+    }
+
+    void visitArea(const utymap::entities::Area& area) override
+    {
+        visitElement(area, area.coordinates.data(), area.coordinates.size());
+    }
+
+    void visitRelation(const utymap::entities::Relation& relation) override
+    {
+        // TODO not supported yet.
+    }
+
+private:
+    void visitElement(const utymap::entities::Element& element,
+                      const utymap::GeoCoordinate* coordinates,
+                      std::size_t count)
+    {
+        tags_.clear();
+        for (const auto& tag : element.tags) {
+            tags_.push_back(tag.key);
+            tags_.push_back(tag.value);
+        }
+
+        coordinates_.clear();
+        for (std::size_t i = 0; i < count; ++i) {
+            coordinates_.push_back(coordinates[i].longitude);
+            coordinates_.push_back(coordinates[i].latitude);
+        }
+
+        // NOTE values are owned by declarations which are kept alive by style during callback.
+        styleKeys_.clear();
+        styleValues_.clear();
+        utymap::mapcss::Style style = styleProvider_.forElement(element, levelOfDetail_);
+        for (const auto& declaration : style.declarations()) {
+            styleKeys_.push_back(declaration->key());
+            styleValues_.push_back(declaration->value().c_str());
+        }
+
+        elementCallback_(element.id,
+            tags_.data(), static_cast<int>(tags_.size()),
+            coordinates_.data(), static_cast<int>(coordinates_.size()),
+            styleKeys_.data(), styleValues_.data(), static_cast<int>(styleKeys_.size()));
+    }
+
+    const utymap::mapcss::StyleProvider& styleProvider_;
+    int levelOfDetail_;
+    OnElementIdsLoaded* elementCallback_;
+
+    /// Buffers are reused between elements.
+    std::vector<std::uint32_t> tags_;
+    std::vector<double> coordinates_;
+    std::vector<std::uint32_t> styleKeys_;
+    std::vector<const char*> styleValues_;
+};
+
+#endif // EXPORTELEMENTIDVISITOR_HPP_DEFINED
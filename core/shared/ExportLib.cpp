@@ -10,6 +10,50 @@
 
 static Application* applicationPtr = nullptr;
 
+namespace {
+    /// Creates node from single vertex, area from closed ring of vertices or way otherwise.
+    std::shared_ptr<utymap::entities::Element> createElement(std::uint64_t id,
+                                                             const double* vertices,
+                                                             int vertexLength,
+                                                             const std::uint32_t* tagIds,
+                                                             std::size_t tagIdLength)
+    {
+        std::vector<utymap::entities::Tag> elementTags;
+        elementTags.reserve(tagIdLength / 2);
+        for (std::size_t i = 0; i + 1 < tagIdLength; i += 2)
+            elementTags.push_back(utymap::entities::Tag(tagIds[i], tagIds[i + 1]));
+
+        // Node
+        if (vertexLength / 2 == 1) {
+            auto node = std::make_shared<utymap::entities::Node>();
+            node->id = id;
+            node->tags = elementTags;
+            node->coordinate = utymap::GeoCoordinate(vertices[0], vertices[1]);
+            return node;
+        }
+
+        std::vector<utymap::GeoCoordinate> coordinates;
+        coordinates.reserve(static_cast<std::size_t>(vertexLength / 2));
+        for (int i = 0; i < vertexLength; i += 2) {
+            coordinates.push_back(utymap::GeoCoordinate(vertices[i], vertices[i + 1]));
+        }
+
+        // Way or Area
+        if (coordinates[0] == coordinates[coordinates.size() - 1]) {
+            auto area = std::make_shared<utymap::entities::Area>();
+            area->id = id;
+            area->coordinates = coordinates;
+            area->tags = elementTags;
+            return area;
+        }
+        auto way = std::make_shared<utymap::entities::Way>();
+        way->id = id;
+        way->coordinates = coordinates;
+        way->tags = elementTags;
+        return way;
+    }
+}
+
 extern "C"
 {
     /// Composes object graph.
@@ -20,6 +64,23 @@ extern "C"
         applicationPtr = new Application(stringPath, elePath, errorCallback);
     }
 
+    /// Composes object graph which only reads string table files, e.g. for several
+    /// processes which build tiles from the same data on one host. Elements with strings
+    /// missing in string table files cannot be added to persistent stores.
+    void EXPORT_API configureShared(const char* stringPath,  // path to string table directory
+                                    const char* elePath,     // path to elevation directory
+                                    OnError* errorCallback)  // completion callback.
+    {
+        applicationPtr = new Application(stringPath, elePath, errorCallback, true);
+    }
+
+    /// Sets amount of threads used by library for parallel work: zero means amount of cores.
+    /// Threads can be pinned to cores, e.g. to leave others to job system of host engine.
+    void EXPORT_API configureScheduler(int threadCount, bool isPinned)
+    {
+        applicationPtr->configureScheduler(threadCount, isPinned);
+    }
+
     /// Performs cleanup.
     void EXPORT_API cleanup()
     {
@@ -32,6 +93,39 @@ extern "C"
         applicationPtr->registerStylesheet(path);
     }
 
+    /// Reloads registered stylesheet. Returns bit mask of levels of details whose styles are changed:
+    /// bit i is set if level of details i is affected.
+    int EXPORT_API reloadStylesheet(const char* path,        // path to stylesheet
+                                    OnError* errorCallback)  // error callback
+    {
+        int mask = 0;
+        for (int levelOfDetails : applicationPtr->reloadStylesheet(path, errorCallback)) {
+            if (levelOfDetails >= 0 && levelOfDetails < 32)
+                mask |= 1 << levelOfDetails;
+        }
+        return mask;
+    }
+
+    /// Registers directory with precomputed heightmap pyramid.
+    void EXPORT_API registerElevationPyramid(const char* path)
+    {
+        applicationPtr->registerElevationPyramid(path);
+    }
+
+    /// Registers directory with terrain-RGB tiles stored as "<zoom>/<x>/<y>.png".
+    void EXPORT_API registerElevationTiles(const char* path, // path to directory
+                                           int zoom)         // zoom of tiles
+    {
+        applicationPtr->registerElevationTiles(path, zoom);
+    }
+
+    /// Enables cache of built quadkeys. Empty directory keeps them only in memory.
+    void EXPORT_API enableMeshCache(const char* directory, // directory for cached quadkeys
+                                    int capacity)          // amount of quadkeys kept in memory
+    {
+        applicationPtr->enableMeshCache(directory, capacity);
+    }
+
     /// Preloads elevation data.
     void EXPORT_API preloadElevation(int tileX,        // tile x
                                      int tileY,        // tile y
@@ -40,6 +134,23 @@ extern "C"
         applicationPtr->preloadElevation(utymap::QuadKey(levelOfDetail, tileX, tileY));
     }
 
+    /// Warms up stylesheets, stores and elevation for quadkeys of region in background and
+    /// returns job id. Completion callback is called on worker thread when it is done.
+    int EXPORT_API warmup(const char** styleFiles,              // style files
+                          int styleCount,                       // amount of style files
+                          double minLat,                        // minimal latitude
+                          double minLon,                        // minimal longitude
+                          double maxLat,                        // maximal latitude
+                          double maxLon,                        // maximal longitude
+                          int levelOfDetail,                    // level of detail
+                          OnError* errorCallback,               // error callback
+                          OnJobCompleted* completionCallback)   // completion callback
+    {
+        std::vector<std::string> styles(styleFiles, styleFiles + std::max(styleCount, 0));
+        utymap::BoundingBox bbox(utymap::GeoCoordinate(minLat, minLon), utymap::GeoCoordinate(maxLat, maxLon));
+        return applicationPtr->warmup(styles, bbox, levelOfDetail, errorCallback, completionCallback);
+    }
+
     /// Registers new in-memory store.
     void EXPORT_API registerInMemoryStore(const char* key)
     {
@@ -52,6 +163,26 @@ extern "C"
         applicationPtr->registerPersistentStore(key, dataPath);
     }
 
+    /// Registers new store which keeps all tiles in single package file.
+    void EXPORT_API registerPackageStore(const char* key, const char* packagePath)
+    {
+        applicationPtr->registerPackageStore(key, packagePath);
+    }
+
+    /// Registers store which fetches tiles of persistent store using callback and caches them.
+    void EXPORT_API registerRemoteStore(const char* key,            // store key
+                                        const char* cachePath,      // path to cache directory
+                                        OnFileFetch* fetchCallback) // fetches file of store
+    {
+        applicationPtr->registerRemoteStore(key, cachePath, fetchCallback);
+    }
+
+    /// Fetches tile of remote store in background.
+    void EXPORT_API prefetchRemoteTile(const char* key, int tileX, int tileY, int levelOfDetail, OnError* errorCallback)
+    {
+        applicationPtr->prefetchRemoteTile(key, utymap::QuadKey(levelOfDetail, tileX, tileY), errorCallback);
+    }
+
     /// Adds data to store to specific level of details range.
     void EXPORT_API addToStoreInRange(const char* key,           // store key
                                       const char* styleFile,     // style file
@@ -63,6 +194,21 @@ extern "C"
         applicationPtr->addToStore(key, styleFile, path, utymap::LodRange(startLod, endLod), errorCallback);
    }
 
+    /// Imports several files concurrently to store to specific level of details range.
+    void EXPORT_API addFilesToStoreInRange(const char* key,           // store key
+                                           const char* styleFile,     // style file
+                                           const char** paths,        // paths to data
+                                           int pathCount,             // amount of paths
+                                           int startLod,              // start zoom level
+                                           int endLod,                // end zoom level
+                                           int threadCount,           // amount of threads, zero for all cores
+                                           OnError* errorCallback)    // completion callback
+    {
+        std::vector<std::string> files(paths, paths + pathCount);
+        std::size_t threads = static_cast<std::size_t>(std::max(threadCount, 0));
+        applicationPtr->addToStore(key, styleFile, files, utymap::LodRange(startLod, endLod), threads, errorCallback);
+    }
+
     /// Adds data to store to specific level of details range.
     void EXPORT_API addToStoreInBoundingBox(const char* key,           // store key
                                             const char* styleFile,     // style file
@@ -105,44 +251,67 @@ extern "C"
                                       OnError* errorCallback)    // completion callback
     {
         utymap::LodRange lod(startLod, endLod);
-        std::vector<utymap::entities::Tag> elementTags;
-        elementTags.reserve(static_cast<std::size_t>(tagLength / 2));
-        for (std::size_t i = 0; i < tagLength; i += 2) {
-            auto keyId = applicationPtr->getStringId(tags[i]);
-            auto valueId = applicationPtr->getStringId(tags[i + 1]);
-            elementTags.push_back(utymap::entities::Tag(keyId, valueId));
-        }
+        auto ids = applicationPtr->getStringIds(std::vector<const char*>(tags, tags + tagLength));
+        auto element = createElement(id, vertices, vertexLength, ids.data(), ids.size());
+        applicationPtr->addToStore(key, styleFile, *element, lod, errorCallback);
+    }
 
-        // Node
-        if (vertexLength / 2 == 1) {
-            utymap::entities::Node node;
-            node.id = id;
-            node.tags = elementTags;
-            node.coordinate = utymap::GeoCoordinate(vertices[0], vertices[1]);
-            applicationPtr->addToStore(key, styleFile, node, lod, errorCallback);
-            return;
-        }
+    /// Adds element to store and rebuilds it in given loaded quadkey. Only meshes of builders which
+    /// consume element are reported. NOTE: relation is not yet supported.
+    void EXPORT_API addToStoreElementAndRebuild(const char* key,                    // store key
+                                                const char* styleFile,              // style file
+                                                std::uint64_t id,                   // element id
+                                                const double* vertices,             // vertex array
+                                                int vertexLength,                   // vertex array length
+                                                const char** tags,                  // tag array
+                                                int tagLength,                      // tag array length
+                                                int startLod,                       // start zoom level
+                                                int endLod,                         // end zoom level
+                                                int tileX, int tileY,               // rebuilt quadkey tile
+                                                int levelOfDetail,                  // rebuilt quadkey level of detail
+                                                OnMeshBuilt* meshCallback,          // mesh callback
+                                                OnElementLoaded* elementCallback,   // element callback
+                                                OnElementsRemoved* removedCallback, // removed elements callback
+                                                OnError* errorCallback)             // completion callback
+    {
+        utymap::LodRange lod(startLod, endLod);
+        auto ids = applicationPtr->getStringIds(std::vector<const char*>(tags, tags + tagLength));
+        auto element = createElement(id, vertices, vertexLength, ids.data(), ids.size());
+        applicationPtr->addToStore(key, styleFile, *element, lod, utymap::QuadKey(levelOfDetail, tileX, tileY),
+                                   meshCallback, elementCallback, removedCallback, errorCallback);
+    }
 
-        std::vector<utymap::GeoCoordinate> coordinates;
-        coordinates.reserve(static_cast<std::size_t>(vertexLength / 2));
-        for (int i = 0; i < vertexLength; i+=2) {
-            coordinates.push_back(utymap::GeoCoordinate(vertices[i], vertices[i + 1]));
+    /// Adds elements to store under single commit. Vertices and tags of element i are in
+    /// [offsets[i], offsets[i + 1]) ranges of vertex and tag arrays. NOTE: relation is not yet supported.
+    void EXPORT_API addToStoreElements(const char* key,              // store key
+                                       const char* styleFile,        // style file
+                                       const std::uint64_t* ids,     // element ids
+                                       int elementCount,             // amount of elements
+                                       const double* vertices,       // vertex array of all elements
+                                       const int* vertexOffsets,     // vertex offsets, elementCount + 1
+                                       const char** tags,            // tag array of all elements
+                                       const int* tagOffsets,        // tag offsets, elementCount + 1
+                                       int startLod,                 // start zoom level
+                                       int endLod,                   // end zoom level
+                                       OnError* errorCallback)       // completion callback
+    {
+        utymap::LodRange lod(startLod, endLod);
+        // NOTE tags of all elements are resolved at once.
+        auto tagIds = applicationPtr->getStringIds(std::vector<const char*>(tags, tags + tagOffsets[elementCount]));
+        std::vector<std::shared_ptr<utymap::entities::Element>> elements;
+        elements.reserve(static_cast<std::size_t>(elementCount));
+        for (int i = 0; i < elementCount; ++i) {
+            elements.push_back(createElement(ids[i], vertices + vertexOffsets[i], vertexOffsets[i + 1] - vertexOffsets[i],
+                tagIds.data() + tagOffsets[i], static_cast<std::size_t>(tagOffsets[i + 1] - tagOffsets[i])));
         }
+        applicationPtr->addToStore(key, styleFile, elements, lod, errorCallback);
+    }
 
-        // Way or Area
-        if (coordinates[0] == coordinates[coordinates.size() - 1]) {
-            utymap::entities::Area area;
-            area.id = id;
-            area.coordinates = coordinates;
-            area.tags = elementTags;
-            applicationPtr->addToStore(key, styleFile, area, lod, errorCallback);
-        } else {
-            utymap::entities::Way way;
-            way.id = id;
-            way.coordinates = coordinates;
-            way.tags = elementTags;
-            applicationPtr->addToStore(key, styleFile, way, lod, errorCallback);
-        }
+    /// Compacts store: data of removed elements is dropped and oversized tiles are split.
+    void EXPORT_API compactStore(const char* key,           // store key
+                                 OnError* errorCallback)    // completion callback
+    {
+        applicationPtr->compactStore(key, errorCallback);
     }
 
     /// Loads quadkey.
@@ -156,9 +325,402 @@ extern "C"
         applicationPtr->loadQuadKey(styleFile, quadKey, meshCallback, elementCallback, errorCallback);
     }
 
+    /// Loads quadkey reporting meshes in packed single precision format.
+    void EXPORT_API loadQuadKeyPacked(const char* styleFile,                   // style file
+                                      int tileX, int tileY, int levelOfDetail, // quadkey info
+                                      OnPackedMeshBuilt* meshCallback,         // packed mesh callback
+                                      OnElementLoaded* elementCallback,        // element callback
+                                      OnError* errorCallback)                  // completion callback
+    {
+        utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+        applicationPtr->loadQuadKeyPacked(styleFile, quadKey, meshCallback, elementCallback, errorCallback);
+    }
+
+    /// Loads quadkey reporting meshes in packed format split into chunks with 16 bit indices.
+    void EXPORT_API loadQuadKeyPackedShort(const char* styleFile,                   // style file
+                                           int tileX, int tileY, int levelOfDetail, // quadkey info
+                                           OnShortPackedMeshBuilt* meshCallback,    // packed mesh chunk callback
+                                           OnElementLoaded* elementCallback,        // element callback
+                                           OnError* errorCallback)                  // completion callback
+    {
+        utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+        applicationPtr->loadQuadKeyPackedShort(styleFile, quadKey, meshCallback, elementCallback, errorCallback);
+    }
+
+    /// Loads quadkey reporting meshes with vertices projected to local metric space and
+    /// optionally with vertex normals.
+    void EXPORT_API loadQuadKeyProjected(const char* styleFile,                   // style file
+                                         int tileX, int tileY, int levelOfDetail, // quadkey info
+                                         bool hasNormals,                         // whether to calculate normals
+                                         OnProjectedMeshBuilt* meshCallback,      // projected mesh callback
+                                         OnElementLoaded* elementCallback,        // element callback
+                                         OnError* errorCallback)                  // completion callback
+    {
+        utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+        applicationPtr->loadQuadKeyProjected(styleFile, quadKey, hasNormals, meshCallback, elementCallback, errorCallback);
+    }
+
+    /// Loads quadkey reporting meshes in quantized format which is compressed if requested.
+    void EXPORT_API loadQuadKeyEncoded(const char* styleFile,                   // style file
+                                       int tileX, int tileY, int levelOfDetail, // quadkey info
+                                       bool isCompressed,                       // compression flag
+                                       OnEncodedMeshBuilt* meshCallback,        // encoded mesh callback
+                                       OnElementLoaded* elementCallback,        // element callback
+                                       OnError* errorCallback)                  // completion callback
+    {
+        utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+        applicationPtr->loadQuadKeyEncoded(styleFile, quadKey, isCompressed, meshCallback, elementCallback, errorCallback);
+    }
+
+    /// Builds quadkey and writes its meshes to binary glTF file.
+    void EXPORT_API exportQuadKeyGlb(const char* styleFile,                   // style file
+                                     int tileX, int tileY, int levelOfDetail, // quadkey info
+                                     const char* path,                        // path to glb file
+                                     OnError* errorCallback)                  // completion callback
+    {
+        utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+        applicationPtr->exportQuadKeyGlb(styleFile, quadKey, path, errorCallback);
+    }
+
+    /// Loads quadkey reporting coarse terrain preview before its meshes and elements.
+    void EXPORT_API loadQuadKeyProgressive(const char* styleFile,                   // style file
+                                           int tileX, int tileY, int levelOfDetail, // quadkey info
+                                           OnMeshBuilt* meshCallback,               // mesh callback
+                                           OnElementLoaded* elementCallback,        // element callback
+                                           OnError* errorCallback)                  // completion callback
+    {
+        utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+        applicationPtr->loadQuadKeyProgressive(styleFile, quadKey, meshCallback, elementCallback, errorCallback);
+    }
+
+    /// Loads quadkey reporting all its elements by single callback.
+    void EXPORT_API loadQuadKeyElementBatch(const char* styleFile,                   // style file
+                                            int tileX, int tileY, int levelOfDetail, // quadkey info
+                                            OnMeshBuilt* meshCallback,               // mesh callback
+                                            OnElementsLoaded* elementsCallback,      // elements callback
+                                            OnError* errorCallback)                  // completion callback
+    {
+        utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+        applicationPtr->loadQuadKeyElementBatch(styleFile, quadKey, meshCallback, elementsCallback, errorCallback);
+    }
+
+    /// Loads quadkey reporting tags and styles of elements as string table ids.
+    void EXPORT_API loadQuadKeyWithIds(const char* styleFile,                   // style file
+                                       int tileX, int tileY, int levelOfDetail, // quadkey info
+                                       OnMeshBuilt* meshCallback,               // mesh callback
+                                       OnElementIdsLoaded* elementCallback,     // element callback
+                                       OnError* errorCallback)                  // completion callback
+    {
+        utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+        applicationPtr->loadQuadKeyWithIds(styleFile, quadKey, meshCallback, elementCallback, errorCallback);
+    }
+
+    /// Reports calls and time of quadkey build stages as json. Statistics are empty
+    /// if library is built without UTYMAP_STATISTICS.
+    void EXPORT_API getStatistics(OnStatisticsLoaded* statisticsCallback)
+    {
+        statisticsCallback(applicationPtr->getStatistics().c_str());
+    }
+
+    /// Resets statistics of quadkey build stages.
+    void EXPORT_API resetStatistics()
+    {
+        applicationPtr->resetStatistics();
+    }
+
+    /// Reports approximate amount of bytes kept in memory by subsystems as json.
+    void EXPORT_API getMemoryReport(OnMemoryReportLoaded* memoryReportCallback)
+    {
+        memoryReportCallback(applicationPtr->getMemoryReport().c_str());
+    }
+
+    /// Starts recording of trace events. Events are recorded only if library is built
+    /// with UTYMAP_STATISTICS.
+    void EXPORT_API startTracing()
+    {
+        applicationPtr->startTracing();
+    }
+
+    /// Stops recording of trace events and writes them to file in chrome trace format.
+    void EXPORT_API stopTracing(const char* path, OnError* errorCallback)
+    {
+        applicationPtr->stopTracing(path, errorCallback);
+    }
+
+    /// Enables profiling of file imports: json profile with given amount of heaviest tiles is
+    /// reported after every import. Null callback disables profiling.
+    void EXPORT_API setImportProfiling(int tileCount, OnImportProfiled* profileCallback)
+    {
+        applicationPtr->setImportProfiling(tileCount, profileCallback);
+    }
+
+    /// Starts recording of session inputs to file which can be replayed by UtyMap.Replay.
+    void EXPORT_API startRecording(const char* path, OnError* errorCallback)
+    {
+        applicationPtr->startRecording(path, errorCallback);
+    }
+
+    /// Stops recording of session inputs.
+    void EXPORT_API stopRecording()
+    {
+        applicationPtr->stopRecording();
+    }
+
+    /// Gets amount of strings in string table: ids of all known strings are below it.
+    int EXPORT_API getStringCount()
+    {
+        return static_cast<int>(applicationPtr->getStringCount());
+    }
+
+    /// Reports strings with ids in [fromId, toId) range.
+    void EXPORT_API getStrings(int fromId, int toId, OnStringsLoaded* stringsCallback)
+    {
+        applicationPtr->getStrings(static_cast<std::uint32_t>(std::max(fromId, 0)),
+                                   static_cast<std::uint32_t>(std::max(toId, 0)), stringsCallback);
+    }
+
+    /// Loads quadkey handing mesh buffers over: they are valid until mesh is released.
+    void EXPORT_API loadQuadKeyOwned(const char* styleFile,                   // style file
+                                     int tileX, int tileY, int levelOfDetail, // quadkey info
+                                     OnMeshHandleBuilt* meshCallback,         // mesh callback
+                                     OnElementLoaded* elementCallback,        // element callback
+                                     OnError* errorCallback)                  // completion callback
+    {
+        utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+        applicationPtr->loadQuadKeyOwned(styleFile, quadKey, meshCallback, elementCallback, errorCallback);
+    }
+
+    /// Releases mesh buffers which were handed over by loadQuadKeyOwned.
+    bool EXPORT_API releaseMesh(int handle)
+    {
+        return applicationPtr->releaseMesh(handle);
+    }
+
+    /// Enables or disables partial rebuild of loaded quadkeys when their elements are added.
+    void EXPORT_API enableRebuild(bool isEnabled)
+    {
+        applicationPtr->enableRebuild(isEnabled);
+    }
+
+    /// Enables keeping of triangle hierarchies of loaded quadkeys, so their elements can be
+    /// picked without mesh colliders. Disabling releases all hierarchies.
+    void EXPORT_API enablePicking(bool isEnabled)
+    {
+        applicationPtr->enablePicking(isEnabled);
+    }
+
+    /// Releases triangle hierarchy of unloaded quadkey.
+    bool EXPORT_API releasePicking(int tileX, int tileY, int levelOfDetail)
+    {
+        return applicationPtr->releasePicking(utymap::QuadKey(levelOfDetail, tileX, tileY));
+    }
+
+    /// Picks element of loaded quadkey hit first by ray defined by origin and direction as
+    /// longitude, latitude and elevation. Returns false if there is no hit.
+    bool EXPORT_API pickRay(int tileX, int tileY, int levelOfDetail,
+                            const double* origin, const double* direction,
+                            std::uint64_t* id, double* distance)
+    {
+        utymap::meshing::MeshBvh::Hit hit;
+        if (!applicationPtr->pick(utymap::QuadKey(levelOfDetail, tileX, tileY), origin, direction, hit))
+            return false;
+        *id = hit.id;
+        *distance = hit.distance;
+        return true;
+    }
+
+    /// Picks topmost element of loaded quadkey at given point, e.g. building by its roof.
+    bool EXPORT_API pickPoint(int tileX, int tileY, int levelOfDetail,
+                              double latitude, double longitude, std::uint64_t* id)
+    {
+        utymap::meshing::MeshBvh::Hit hit;
+        if (!applicationPtr->pick(utymap::QuadKey(levelOfDetail, tileX, tileY),
+                                  utymap::GeoCoordinate(latitude, longitude), hit))
+            return false;
+        *id = hit.id;
+        return true;
+    }
+
+    /// Loads quadkey reporting element ranges of batched meshes.
+    void EXPORT_API loadQuadKeyBatched(const char* styleFile,                   // style file
+                                       int tileX, int tileY, int levelOfDetail, // quadkey info
+                                       OnMeshBuilt* meshCallback,               // mesh callback
+                                       OnElementRangesBuilt* rangesCallback,    // element ranges callback
+                                       OnElementLoaded* elementCallback,        // element callback
+                                       OnError* errorCallback)                  // completion callback
+    {
+        utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+        applicationPtr->loadQuadKeyBatched(styleFile, quadKey, meshCallback, rangesCallback, elementCallback, errorCallback);
+    }
+
+    /// Loads quadkey reporting trees as instances of prototype mesh.
+    void EXPORT_API loadQuadKeyInstanced(const char* styleFile,                   // style file
+                                         int tileX, int tileY, int levelOfDetail, // quadkey info
+                                         OnMeshBuilt* meshCallback,               // mesh callback
+                                         OnInstancesBuilt* instancesCallback,     // instances callback
+                                         OnElementLoaded* elementCallback,        // element callback
+                                         OnError* errorCallback)                  // completion callback
+    {
+        utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+        applicationPtr->loadQuadKeyInstanced(styleFile, quadKey, meshCallback, instancesCallback, elementCallback, errorCallback);
+    }
+
+    /// Loads quadkey on worker thread and returns job id. Callbacks are called on worker thread.
+    int EXPORT_API loadQuadKeyAsync(const char* styleFile,                   // style file
+                                    int tileX, int tileY, int levelOfDetail, // quadkey info
+                                    OnMeshBuilt* meshCallback,               // mesh callback
+                                    OnElementLoaded* elementCallback,        // element callback
+                                    OnError* errorCallback,                  // error callback
+                                    OnJobCompleted* completionCallback)      // completion callback
+    {
+        utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+        return applicationPtr->loadQuadKeyAsync(styleFile, quadKey, meshCallback, elementCallback,
+                                                errorCallback, completionCallback);
+    }
+
+    /// Creates job which builds quadkey in steps on calling thread and returns its id or zero.
+    int EXPORT_API createQuadKeyJob(const char* styleFile,                   // style file
+                                    int tileX, int tileY, int levelOfDetail, // quadkey info
+                                    OnMeshBuilt* meshCallback,               // mesh callback
+                                    OnElementLoaded* elementCallback,        // element callback
+                                    OnError* errorCallback)                  // error callback
+    {
+        utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+        return applicationPtr->createQuadKeyJob(styleFile, quadKey, meshCallback, elementCallback, errorCallback);
+    }
+
+    /// Runs steps of quadkey job till time budget is spent. Returns true when job is completed.
+    /// Callbacks of job are called on calling thread.
+    bool EXPORT_API stepQuadKeyJob(int jobId,              // job id
+                                   double budget,          // time budget in milliseconds
+                                   OnError* errorCallback) // error callback
+    {
+        return applicationPtr->stepQuadKeyJob(jobId, budget, errorCallback);
+    }
+
+    /// Releases quadkey job which is not completed. Returns false if job is unknown.
+    bool EXPORT_API releaseQuadKeyJob(int jobId)
+    {
+        return applicationPtr->releaseQuadKeyJob(jobId);
+    }
+
+    /// Loads quadkey on worker thread and returns job id. Results are not reported by callbacks:
+    /// they are queued and taken by pollResults, so worker thread never calls client code.
+    int EXPORT_API loadQuadKeyQueued(const char* styleFile,                   // style file
+                                     int tileX, int tileY, int levelOfDetail) // quadkey info
+    {
+        return applicationPtr->loadQuadKeyQueued(styleFile, utymap::QuadKey(levelOfDetail, tileX, tileY));
+    }
+
+    /// Takes up to given amount of queued results into buffer and returns their amount. Every job
+    /// ends with completion result. Data of results stays valid until next call.
+    int EXPORT_API pollResults(PolledResult* results, // results buffer
+                               int maxCount)          // buffer capacity
+    {
+        return applicationPtr->pollResults(results, maxCount);
+    }
+
+    /// Loads quadkeys given as interleaved tile x, tile y and level of detail on worker pool.
+    /// Results are reported per quadkey, callbacks are called on worker threads one at a time.
+    void EXPORT_API loadQuadKeys(const char* styleFile,              // style file
+                                 const int* quadKeys, int quadKeySize, // quadkeys info
+                                 int threadCount,                    // amount of worker threads
+                                 OnMeshBuilt* meshCallback,          // mesh callback
+                                 OnElementLoaded* elementCallback,   // element callback
+                                 OnQuadKeyLoaded* quadKeyCallback,   // quadkey callback
+                                 OnError* errorCallback)             // error callback
+    {
+        std::vector<utymap::QuadKey> keys;
+        keys.reserve(quadKeySize / 3);
+        for (int i = 0; i + 2 < quadKeySize; i += 3)
+            keys.push_back(utymap::QuadKey(quadKeys[i + 2], quadKeys[i], quadKeys[i + 1]));
+        applicationPtr->loadQuadKeys(styleFile, keys, threadCount, meshCallback, elementCallback,
+                                     quadKeyCallback, errorCallback);
+    }
+
+    /// Cancels asynchronous job if it is not yet started.
+    bool EXPORT_API cancelJob(int jobId)
+    {
+        return applicationPtr->cancelJob(jobId);
+    }
+
+    /// Sets camera position used to prioritize asynchronous jobs: closest quadkeys are loaded first.
+    void EXPORT_API setCameraPosition(double latitude, double longitude)
+    {
+        applicationPtr->setCameraPosition(utymap::GeoCoordinate(latitude, longitude));
+    }
+
+    /// Sets camera position and motion used to prioritize asynchronous jobs and to prefetch
+    /// quadkeys which camera is expected to reach. Returns amount of new prefetch jobs.
+    int EXPORT_API setCameraMotion(double latitude,      // camera latitude
+                                   double longitude,     // camera longitude
+                                   double heading,       // degrees clockwise from north
+                                   double velocity,      // meters per second
+                                   int levelOfDetail,    // level of details to prefetch
+                                   const char* styleFile) // style file used to build meshes, can be null
+    {
+        return applicationPtr->setCameraMotion(utymap::GeoCoordinate(latitude, longitude),
+                                               heading, velocity, levelOfDetail, styleFile);
+    }
+
+    /// Sets projection origin and scale used to load quadkeys with projected vertices.
+    void EXPORT_API setProjection(double latitude, double longitude, double scale)
+    {
+        applicationPtr->setProjection(utymap::GeoCoordinate(latitude, longitude), scale);
+    }
+
+    /// Registers mesh package which is used to load quadkeys in packed format without building.
+    void EXPORT_API registerMeshPackage(const char* path,       // path to mesh package
+                                        OnError* errorCallback) // error callback
+    {
+        applicationPtr->registerMeshPackage(path, errorCallback);
+    }
+
+    /// Builds quadkeys of bounding box in level of details range and writes them to mesh package.
+    void EXPORT_API bakeMeshPackage(const char* styleFile,     // style file
+                                    double minLat,             // minimal latitude
+                                    double minLon,             // minimal longitude
+                                    double maxLat,             // maximal latitude
+                                    double maxLon,             // maximal longitude
+                                    int startLod,              // start zoom level
+                                    int endLod,                // end zoom level
+                                    const char* path,          // path to mesh package
+                                    int threadCount,           // amount of threads
+                                    OnError* errorCallback)    // error callback
+    {
+        utymap::BoundingBox bbox(utymap::GeoCoordinate(minLat, minLon), utymap::GeoCoordinate(maxLat, maxLon));
+        applicationPtr->bakeMeshPackage(styleFile, bbox, utymap::LodRange(startLod, endLod),
+                                        path, threadCount, errorCallback);
+    }
+
     /// Checks whether there is data for given quadkey
     bool EXPORT_API hasData(int tileX, int tileY, int levelOfDetail)
     {
         return applicationPtr->hasData(utymap::QuadKey(levelOfDetail, tileX, tileY));
     }
+
+    /// Reports element with given id as it is stored at given level of detail. Element is
+    /// found through id index of stores without scanning tiles. Returns false if it is not found.
+    bool EXPORT_API getElement(const char* styleFile,
+                               std::uint64_t id,
+                               int levelOfDetail,
+                               OnElementLoaded* elementCallback,
+                               OnError* errorCallback)
+    {
+        return applicationPtr->getElement(styleFile, id, levelOfDetail, elementCallback, errorCallback);
+    }
+
+    /// Finds elements in all stores which names start with given prefix. Names are normalized:
+    /// case of latin letters and separators are ignored. Given amount of closest to coordinate
+    /// elements is reported ordered by distance.
+    void EXPORT_API searchByName(const char* prefix,
+                                 double latitude,
+                                 double longitude,
+                                 int maxResults,
+                                 OnNamesFound* namesCallback,
+                                 OnError* errorCallback)
+    {
+        applicationPtr->searchByName(prefix, utymap::GeoCoordinate(latitude, longitude), maxResults,
+                                     namesCallback, errorCallback);
+    }
 }
@@ -0,0 +1,132 @@
+#ifndef JOBSCHEDULER_HPP_DEFINED
+#define JOBSCHEDULER_HPP_DEFINED
+
+#include "utils/TraceRecorder.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Runs jobs on fixed pool of worker threads. Pending job with the lowest priority value
+/// runs first. Priority is evaluated when worker picks next job, so it can depend on state
+/// which changes over time, e.g. distance to camera. Every submitted job gets exactly one
+/// completion notification: after it is run or when it is cancelled before run.
+class JobScheduler final
+{
+public:
+    /// Returns priority of job: lower value runs earlier.
+    typedef std::function<double()> Priority;
+    /// Action which is executed by worker. It should not throw.
+    typedef std::function<void()> Action;
+    /// Completion notification with job id and flag whether job was cancelled instead of being run.
+    typedef std::function<void(int, bool)> Completion;
+
+    explicit JobScheduler(std::size_t workerCount) :
+        jobs_(), workers_(), nextId_(1), isStopped_(false)
+    {
+        workerCount = std::max<std::size_t>(1, workerCount);
+        for (std::size_t i = 0; i < workerCount; ++i)
+            workers_.emplace_back([this]() { work(); });
+    }
+
+    JobScheduler(const JobScheduler&) = delete;
+    JobScheduler& operator=(const JobScheduler&) = delete;
+
+    /// Cancels pending jobs and waits for running ones.
+    ~JobScheduler()
+    {
+        std::vector<Job> pending;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            isStopped_ = true;
+            pending.swap(jobs_);
+        }
+        condition_.notify_all();
+        for (auto& worker : workers_)
+            worker.join();
+        for (const auto& job : pending)
+            job.completion(job.id, true);
+    }
+
+    /// Adds job to queue and returns its id.
+    int submit(const Priority& priority, const Action& action, const Completion& completion)
+    {
+        int id;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            id = nextId_++;
+            jobs_.push_back(Job { id, priority, action, completion });
+        }
+        condition_.notify_one();
+        return id;
+    }
+
+    /// Removes job from queue if it is not yet started. Returns false if job is already
+    /// started or completed: running job cannot be interrupted.
+    bool cancel(int id)
+    {
+        Job job;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            auto it = std::find_if(jobs_.begin(), jobs_.end(), [id](const Job& j) { return j.id == id; });
+            if (it == jobs_.end())
+                return false;
+            job = std::move(*it);
+            jobs_.erase(it);
+        }
+        job.completion(job.id, true);
+        return true;
+    }
+
+private:
+    struct Job
+    {
+        int id;
+        Priority priority;
+        Action action;
+        Completion completion;
+    };
+
+    void work()
+    {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(lock_);
+                condition_.wait(lock, [this]() { return isStopped_ || !jobs_.empty(); });
+                if (isStopped_)
+                    return;
+                // NOTE queue is expected to be short (visible tiles), so it is scanned instead
+                // of being kept in heap which would be invalidated by priority changes.
+                auto next = jobs_.begin();
+                double nextPriority = next->priority();
+                for (auto it = next + 1; it != jobs_.end(); ++it) {
+                    double priority = it->priority();
+                    if (priority < nextPriority) {
+                        next = it;
+                        nextPriority = priority;
+                    }
+                }
+                job = std::move(*next);
+                jobs_.erase(next);
+            }
+            {
+                UTYMAP_TRACE_SCOPE("job", "worker");
+                job.action();
+            }
+            job.completion(job.id, false);
+        }
+    }
+
+    std::vector<Job> jobs_;
+    std::vector<std::thread> workers_;
+    int nextId_;
+    bool isStopped_;
+    std::mutex lock_;
+    std::condition_variable condition_;
+};
+
+#endif // JOBSCHEDULER_HPP_DEFINED
@@ -0,0 +1,79 @@
+#ifndef MESHREGISTRY_HPP_DEFINED
+#define MESHREGISTRY_HPP_DEFINED
+
+#include "meshing/MeshTypes.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/// Owns meshes whose buffers are handed to external code, so it can read them without copying.
+/// Every mesh is kept until it is released by its handle. Thread safe.
+class MeshRegistry final
+{
+public:
+    MeshRegistry() : meshes_(), nextHandle_(1)
+    {
+    }
+
+    MeshRegistry(const MeshRegistry&) = delete;
+    MeshRegistry& operator=(const MeshRegistry&) = delete;
+
+    /// Takes buffers of given mesh and returns handle of registered mesh which owns them.
+    int add(utymap::meshing::Mesh& mesh, const utymap::meshing::Mesh*& registered)
+    {
+        auto owned = utymap::utils::make_unique<utymap::meshing::Mesh>(mesh.name);
+        owned->vertices.swap(mesh.vertices);
+        owned->triangles.swap(mesh.triangles);
+        owned->colors.swap(mesh.colors);
+        owned->uvs.swap(mesh.uvs);
+        owned->elementRanges.swap(mesh.elementRanges);
+        registered = owned.get();
+
+        std::lock_guard<std::mutex> lock(lock_);
+        int handle = nextHandle_++;
+        meshes_.emplace(handle, std::move(owned));
+        return handle;
+    }
+
+    /// Releases mesh. Returns false if there is no mesh with given handle.
+    bool release(int handle)
+    {
+        std::unique_ptr<utymap::meshing::Mesh> mesh;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            auto pair = meshes_.find(handle);
+            if (pair == meshes_.end())
+                return false;
+            mesh = std::move(pair->second);
+            meshes_.erase(pair);
+        }
+        // NOTE buffers are freed outside of lock.
+        return true;
+    }
+
+    /// Returns amount of meshes which are not released.
+    std::size_t size()
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        return meshes_.size();
+    }
+
+    /// Returns amount of bytes used by meshes which are not released.
+    std::size_t getMemoryUsage()
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        std::size_t usage = 0;
+        for (const auto& pair : meshes_)
+            usage += pair.second->memoryUsage();
+        return usage;
+    }
+
+private:
+    std::unordered_map<int, std::unique_ptr<utymap::meshing::Mesh>> meshes_;
+    int nextHandle_;
+    std::mutex lock_;
+};
+
+#endif // MESHREGISTRY_HPP_DEFINED
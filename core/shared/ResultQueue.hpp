@@ -0,0 +1,288 @@
+#ifndef RESULTQUEUE_HPP_DEFINED
+#define RESULTQUEUE_HPP_DEFINED
+
+#include "GeoCoordinate.hpp"
+#include "entities/Element.hpp"
+#include "entities/ElementVisitor.hpp"
+#include "entities/Node.hpp"
+#include "entities/Area.hpp"
+#include "entities/Way.hpp"
+#include "entities/Relation.hpp"
+#include "index/StringTable.hpp"
+#include "mapcss/StyleProvider.hpp"
+#include "meshing/MeshTypes.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Kind of polled result.
+enum PolledResultKind
+{
+    MeshResult = 0,
+    ElementResult = 1,
+    ErrorResult = 2,
+    JobCompletedResult = 3
+};
+
+/// Result of queued job which is returned by polling. Arrays have the same layout as arguments
+/// of mesh and element callbacks and stay valid until next poll. Name is mesh name or error message.
+struct PolledResult
+{
+    int kind;
+    int jobId;
+    std::uint64_t id;
+    const char* name;
+    const double* vertices;
+    int vertexSize;
+    const int* triangles;
+    int triSize;
+    const int* colors;
+    int colorSize;
+    const double* uvs;
+    int uvSize;
+    const char** tags;
+    int tagSize;
+    const char** styles;
+    int styleSize;
+    bool isCancelled;
+};
+
+/// Queue of results which are pushed by build threads and polled by client on its own thread,
+/// so build threads never call into client code. Push is lock free (intrusive list of Vyukov),
+/// poll should be called by single thread at time.
+class ResultQueue final
+{
+    /// Owns data of single result.
+    struct Entry final
+    {
+        explicit Entry(int kind, int jobId) : next(nullptr), kind(kind), jobId(jobId), id(0), isCancelled(false)
+        {
+        }
+
+        std::atomic<Entry*> next;
+        int kind;
+        int jobId;
+        std::uint64_t id;
+        std::string name;
+        std::vector<double> vertices;
+        std::vector<int> triangles;
+        std::vector<int> colors;
+        std::vector<double> uvs;
+        std::vector<std::string> strings;
+        std::vector<const char*> tags;
+        std::vector<const char*> styles;
+        bool isCancelled;
+    };
+
+public:
+    /// Converts visited elements to results of job: tags and styles are resolved to strings.
+    class ElementWriter final : public utymap::entities::ElementVisitor
+    {
+    public:
+        ElementWriter(ResultQueue& queue,
+                      int jobId,
+                      utymap::index::StringTable& stringTable,
+                      const utymap::mapcss::StyleProvider& styleProvider,
+                      int levelOfDetail) :
+            queue_(queue), jobId_(jobId), stringTable_(stringTable),
+            styleProvider_(styleProvider), levelOfDetail_(levelOfDetail)
+        {
+        }
+
+        void visitNode(const utymap::entities::Node& node) override
+        {
+            push(node, &node.coordinate, 1);
+        }
+
+        void visitWay(const utymap::entities::Way& way) override
+        {
+            push(way, way.coordinates.data(), way.coordinates.size());
+        }
+
+        void visitArea(const utymap::entities::Area& area) override
+        {
+            push(area, area.coordinates.data(), area.coordinates.size());
+        }
+
+        void visitRelation(const utymap::entities::Relation& relation) override
+        {
+            // NOTE relations are not exported by element callback either.
+        }
+
+    private:
+        void push(const utymap::entities::Element& element, const utymap::GeoCoordinate* coordinates, std::size_t size)
+        {
+            auto entry = utymap::utils::make_unique<Entry>(ElementResult, jobId_);
+            entry->id = element.id;
+            entry->vertices.reserve(size * 2);
+            for (std::size_t i = 0; i < size; ++i) {
+                entry->vertices.push_back(coordinates[i].longitude);
+                entry->vertices.push_back(coordinates[i].latitude);
+            }
+
+            // NOTE pointers to strings are taken when all strings are added.
+            auto declarations = styleProvider_.forElement(element, levelOfDetail_).declarations();
+            entry->strings.reserve(element.tags.size() * 2 + declarations.size() * 2);
+            for (const auto& tag : element.tags) {
+                entry->strings.push_back(stringTable_.getString(tag.key));
+                entry->strings.push_back(stringTable_.getString(tag.value));
+            }
+            for (const auto& declaration : declarations) {
+                entry->strings.push_back(stringTable_.getString(declaration->key()));
+                entry->strings.push_back(declaration->value());
+            }
+            std::size_t tagSize = element.tags.size() * 2;
+            for (std::size_t i = 0; i < entry->strings.size(); ++i)
+                (i < tagSize ? entry->tags : entry->styles).push_back(entry->strings[i].c_str());
+
+            queue_.push(std::move(entry));
+        }
+
+        ResultQueue& queue_;
+        const int jobId_;
+        utymap::index::StringTable& stringTable_;
+        const utymap::mapcss::StyleProvider& styleProvider_;
+        const int levelOfDetail_;
+    };
+
+    ResultQueue() : stub_(0, 0), head_(&stub_), tail_(&stub_), polled_()
+    {
+    }
+
+    ResultQueue(const ResultQueue&) = delete;
+    ResultQueue& operator=(const ResultQueue&) = delete;
+
+    ~ResultQueue()
+    {
+        releasePolled();
+        while (Entry* entry = pop())
+            delete entry;
+    }
+
+    /// Pushes mesh taking its buffers.
+    void pushMesh(int jobId, utymap::meshing::Mesh& mesh)
+    {
+        auto entry = utymap::utils::make_unique<Entry>(MeshResult, jobId);
+        entry->name = mesh.name;
+        std::swap(entry->vertices, mesh.vertices);
+        std::swap(entry->triangles, mesh.triangles);
+        std::swap(entry->colors, mesh.colors);
+        std::swap(entry->uvs, mesh.uvs);
+        push(std::move(entry));
+    }
+
+    void pushError(int jobId, const char* message)
+    {
+        auto entry = utymap::utils::make_unique<Entry>(ErrorResult, jobId);
+        entry->name = message;
+        push(std::move(entry));
+    }
+
+    /// Pushes the last result of job.
+    void pushCompleted(int jobId, bool isCancelled)
+    {
+        auto entry = utymap::utils::make_unique<Entry>(JobCompletedResult, jobId);
+        entry->isCancelled = isCancelled;
+        push(std::move(entry));
+    }
+
+    /// Fills buffer with up to given amount of results in order they are pushed by each thread
+    /// and returns their amount. Results of previous poll are released.
+    int poll(PolledResult* results, int maxCount)
+    {
+        releasePolled();
+        int count = 0;
+        while (count < maxCount) {
+            Entry* entry = pop();
+            if (entry == nullptr)
+                break;
+            polled_.push_back(entry);
+            fill(*entry, results[count++]);
+        }
+        return count;
+    }
+
+private:
+    void push(std::unique_ptr<Entry> entry)
+    {
+        pushNode(entry.release());
+    }
+
+    void pushNode(Entry* node)
+    {
+        Entry* previous = head_.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    /// Takes the oldest entry or returns null if queue is empty or entry is being pushed.
+    Entry* pop()
+    {
+        Entry* tail = tail_;
+        Entry* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (next == nullptr)
+                return nullptr;
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            tail_ = next;
+            return tail;
+        }
+        if (tail != head_.load(std::memory_order_acquire))
+            return nullptr;
+
+        // NOTE stub is pushed back, so the last entry can be taken.
+        stub_.next.store(nullptr, std::memory_order_relaxed);
+        pushNode(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr)
+            return nullptr;
+        tail_ = next;
+        return tail;
+    }
+
+    void releasePolled()
+    {
+        for (Entry* entry : polled_)
+            delete entry;
+        polled_.clear();
+    }
+
+    static void fill(Entry& entry, PolledResult& result)
+    {
+        result.kind = entry.kind;
+        result.jobId = entry.jobId;
+        result.id = entry.id;
+        result.name = entry.name.c_str();
+        result.vertices = entry.vertices.data();
+        result.vertexSize = static_cast<int>(entry.vertices.size());
+        result.triangles = entry.triangles.data();
+        result.triSize = static_cast<int>(entry.triangles.size());
+        result.colors = entry.colors.data();
+        result.colorSize = static_cast<int>(entry.colors.size());
+        result.uvs = entry.uvs.data();
+        result.uvSize = static_cast<int>(entry.uvs.size());
+        result.tags = entry.tags.data();
+        result.tagSize = static_cast<int>(entry.tags.size());
+        result.styles = entry.styles.data();
+        result.styleSize = static_cast<int>(entry.styles.size());
+        result.isCancelled = entry.isCancelled;
+    }
+
+    /// Placeholder which keeps list non empty.
+    Entry stub_;
+    /// The last pushed entry.
+    std::atomic<Entry*> head_;
+    /// The oldest entry, accessed only by polling thread.
+    Entry* tail_;
+    /// Entries returned by the last poll.
+    std::vector<Entry*> polled_;
+};
+
+#endif // RESULTQUEUE_HPP_DEFINED
@@ -0,0 +1,138 @@
+#ifndef SESSIONRECORDER_HPP_DEFINED
+#define SESSIONRECORDER_HPP_DEFINED
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Records calls which define inputs of session: store registrations, data imports and quadkey
+/// loads with time since start. Every call is written as one line of tab separated fields:
+/// time in milliseconds, command name and its arguments. Session file is replayed by UtyMap.Replay.
+/// Setup commands, e.g. store registrations, are remembered even if recording is not started:
+/// session starts with all of them, so it can be replayed when recording is started later.
+/// Thread safe.
+class SessionRecorder final
+{
+public:
+    /// Represents recorded call.
+    struct Command final
+    {
+        /// Time since start of recording in milliseconds.
+        double time;
+        std::string name;
+        std::vector<std::string> arguments;
+    };
+
+    SessionRecorder() : file_(), start_(), isStarted_(false), setupCommands_()
+    {
+    }
+
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+    /// Starts recording to given file replacing its content.
+    void start(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        file_.close();
+        file_.clear();
+        file_.open(path, std::ios::out | std::ios::trunc);
+        if (!file_.good())
+            throw std::domain_error("Cannot create session file: " + path);
+        file_ << header() << '\n' << std::fixed << std::setprecision(3);
+        start_ = std::chrono::steady_clock::now();
+        isStarted_ = true;
+        for (const auto& command : setupCommands_)
+            write(command.name, command.arguments);
+    }
+
+    /// Stops recording and closes file.
+    void stop()
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (!isStarted_)
+            return;
+        isStarted_ = false;
+        file_.close();
+    }
+
+    bool isStarted() const
+    {
+        return isStarted_;
+    }
+
+    /// Writes command with given arguments if recording is started.
+    void record(const std::string& name, const std::vector<std::string>& arguments)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (isStarted_)
+            write(name, arguments);
+    }
+
+    /// Remembers setup command which is written at start of every recording and writes it
+    /// if recording is started.
+    void recordSetup(const std::string& name, const std::vector<std::string>& arguments)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        setupCommands_.push_back(Command { 0, name, arguments });
+        if (isStarted_)
+            write(name, arguments);
+    }
+
+    /// Reads commands of recorded session.
+    static std::vector<Command> read(const std::string& path)
+    {
+        std::ifstream file(path);
+        std::string line;
+        if (!std::getline(file, line) || line != header())
+            throw std::domain_error("Invalid session file: " + path);
+
+        std::vector<Command> commands;
+        while (std::getline(file, line)) {
+            if (line.empty())
+                continue;
+
+            std::vector<std::string> fields;
+            std::stringstream stream(line);
+            std::string field;
+            while (std::getline(stream, field, '\t'))
+                fields.push_back(field);
+            if (fields.size() < 2)
+                throw std::domain_error("Invalid session command: " + line);
+
+            Command command = { std::stod(fields[0]), fields[1],
+                                std::vector<std::string>(fields.begin() + 2, fields.end()) };
+            commands.push_back(command);
+        }
+        return commands;
+    }
+
+private:
+    static const char* header() { return "utymap-session 1"; }
+
+    /// Writes command with time since start. Should be called under lock.
+    void write(const std::string& name, const std::vector<std::string>& arguments)
+    {
+        std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start_;
+        file_ << time.count() << '\t' << name;
+        for (const auto& argument : arguments)
+            file_ << '\t' << argument;
+        file_ << '\n';
+        // NOTE session should be usable even if application is not closed properly.
+        file_.flush();
+    }
+
+    std::mutex lock_;
+    std::ofstream file_;
+    std::chrono::steady_clock::time_point start_;
+    std::atomic<bool> isStarted_;
+    std::vector<Command> setupCommands_;
+};
+
+#endif // SESSIONRECORDER_HPP_DEFINED
@@ -2,8 +2,10 @@
 #define BOUNDINGBOX_HPP_DEFINED
 
 #include "GeoCoordinate.hpp"
+#include "utils/GeometryKernels.hpp"
 
 #include <algorithm>
+#include <vector>
 
 namespace utymap {
 
@@ -68,6 +70,19 @@ struct BoundingBox final
             expand(*begin);
     }
 
+    /// Expands bounding box from contiguous coordinates using vectorized kernel.
+    void expand(std::vector<GeoCoordinate>::const_iterator begin, std::vector<GeoCoordinate>::const_iterator end)
+    {
+        if (begin != end)
+            utymap::utils::expandBounds(&*begin, static_cast<std::size_t>(end - begin), minPoint, maxPoint);
+    }
+
+    /// Expands bounding box from contiguous coordinates using vectorized kernel.
+    void expand(std::vector<GeoCoordinate>::iterator begin, std::vector<GeoCoordinate>::iterator end)
+    {
+        expand(std::vector<GeoCoordinate>::const_iterator(begin), std::vector<GeoCoordinate>::const_iterator(end));
+    }
+
     /// Checks whether given bounding box inside the current one.
     bool contains(const BoundingBox& bbox) const
     {
@@ -2,6 +2,7 @@
 #define GEOCOORDINATE_HPP_DEFINED
 
 #include <cmath>
+#include <cstdint>
 #include <limits>
 
 namespace utymap {
@@ -39,6 +40,47 @@ struct GeoCoordinate final
     }
 };
 
+/// Represents geocoordinate as fixed point values with precision of osm data (1E-7 degree).
+/// Takes half of GeoCoordinate size, so it is used to keep geometry in stores and import structures.
+/// Coordinates which are not finite or out of range are kept as invalid ones.
+struct CompactCoordinate final
+{
+    /// Latitude in 1E-7 degrees.
+    std::int32_t latitude;
+    /// Longitude in 1E-7 degrees.
+    std::int32_t longitude;
+
+    CompactCoordinate() : latitude(Invalid), longitude(Invalid)
+    {
+    }
+
+    explicit CompactCoordinate(const GeoCoordinate& coordinate) :
+        latitude(toFixed(coordinate.latitude)), longitude(toFixed(coordinate.longitude))
+    {
+        if (latitude == Invalid || longitude == Invalid)
+            latitude = longitude = Invalid;
+    }
+
+    GeoCoordinate toGeoCoordinate() const
+    {
+        return latitude == Invalid
+            ? GeoCoordinate()
+            : GeoCoordinate(latitude / Precision, longitude / Precision);
+    }
+
+private:
+    static constexpr double Precision = 1E7;
+    static constexpr std::int32_t Invalid = std::numeric_limits<std::int32_t>::min();
+
+    static std::int32_t toFixed(double value)
+    {
+        double fixed = std::round(value * Precision);
+        return fixed > Invalid && fixed <= std::numeric_limits<std::int32_t>::max()
+            ? static_cast<std::int32_t>(fixed)
+            : Invalid;
+    }
+};
+
 }
 
 #endif // GEOCOORDINATE_HPP_DEFINED
@@ -1,6 +1,10 @@
 #ifndef QUADKEY_HPP_DEFINED
 #define QUADKEY_HPP_DEFINED
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
 namespace utymap {
 
 /// Represents quadkey: a node of quadtree
@@ -29,5 +33,107 @@ struct QuadKey final
     }
 };
 
+/// Represents quadkey packed into 64 bits: level of details is kept in the highest six bits and
+/// tile coordinates are interleaved in the lowest ones (Morton code, x bits are even). So, keys of
+/// the same level are ordered along Z curve and neighbouring tiles are close to each other. Base 4
+/// digits of Morton code are digits of quadkey string.
+struct PackedQuadKey final
+{
+    std::uint64_t value;
+
+    PackedQuadKey() : value(0)
+    {
+    }
+
+    explicit PackedQuadKey(const QuadKey& quadKey) :
+        value((static_cast<std::uint64_t>(quadKey.levelOfDetail) << LevelShift) |
+              spread(static_cast<std::uint32_t>(quadKey.tileX)) |
+              (spread(static_cast<std::uint32_t>(quadKey.tileY)) << 1))
+    {
+    }
+
+    static PackedQuadKey fromValue(std::uint64_t value)
+    {
+        PackedQuadKey key;
+        key.value = value;
+        return key;
+    }
+
+    int levelOfDetail() const { return static_cast<int>(value >> LevelShift); }
+
+    /// Returns interleaved tile coordinates.
+    std::uint64_t morton() const { return value & MortonMask; }
+
+    QuadKey unpack() const
+    {
+        return QuadKey(levelOfDetail(), static_cast<int>(compact(morton())), static_cast<int>(compact(morton() >> 1)));
+    }
+
+    /// Returns key of parent tile. Should not be called for root.
+    PackedQuadKey parent() const
+    {
+        return fromValue((static_cast<std::uint64_t>(levelOfDetail() - 1) << LevelShift) | (morton() >> 2));
+    }
+
+    /// Returns key of child tile with given index: one bit for x and higher bit for y.
+    PackedQuadKey child(int index) const
+    {
+        return fromValue((static_cast<std::uint64_t>(levelOfDetail() + 1) << LevelShift) |
+                         (morton() << 2) | static_cast<std::uint64_t>(index & 3));
+    }
+
+    /// Returns quadkey digit at given level starting from one.
+    int digit(int levelOfDetail) const
+    {
+        return static_cast<int>((morton() >> (2 * (this->levelOfDetail() - levelOfDetail))) & 3);
+    }
+
+    bool operator==(const PackedQuadKey& other) const { return value == other.value; }
+    bool operator!=(const PackedQuadKey& other) const { return value != other.value; }
+    bool operator<(const PackedQuadKey& other) const { return value < other.value; }
+
+private:
+    static const int LevelShift = 58;
+    static const std::uint64_t MortonMask = (static_cast<std::uint64_t>(1) << LevelShift) - 1;
+
+    /// Inserts zero bit before every bit of value.
+    static std::uint64_t spread(std::uint32_t value)
+    {
+        std::uint64_t x = value;
+        x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+        x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+        x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        x = (x | (x << 2)) & 0x3333333333333333ULL;
+        x = (x | (x << 1)) & 0x5555555555555555ULL;
+        return x;
+    }
+
+    /// Removes every odd bit of value: reverse of spread.
+    static std::uint32_t compact(std::uint64_t value)
+    {
+        std::uint64_t x = value & 0x5555555555555555ULL;
+        x = (x | (x >> 1)) & 0x3333333333333333ULL;
+        x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+        x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+        x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+        x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+        return static_cast<std::uint32_t>(x);
+    }
+};
+
+/// Hashes quadkey using its packed representation to use it as key in unordered containers.
+struct QuadKeyHash final
+{
+    std::size_t operator()(const QuadKey& quadKey) const
+    {
+        return std::hash<std::uint64_t>()(PackedQuadKey(quadKey).value);
+    }
+
+    std::size_t operator()(const PackedQuadKey& quadKey) const
+    {
+        return std::hash<std::uint64_t>()(quadKey.value);
+    }
+};
+
 }
 #endif // QUADKEY_HPP_DEFINED
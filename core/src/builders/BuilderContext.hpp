@@ -4,10 +4,12 @@
 #include "BoundingBox.hpp"
 #include "QuadKey.hpp"
 #include "heightmap/ElevationProvider.hpp"
+#include "heightmap/GridElevationProvider.hpp"
 #include "mapcss/StyleProvider.hpp"
 #include "meshing/MeshBuilder.hpp"
 #include "meshing/MeshTypes.hpp"
 #include "utils/GeoUtils.hpp"
+#include "utils/MetricScale.hpp"
 
 #include <functional>
 
@@ -20,33 +22,45 @@ struct BuilderContext final
     const utymap::QuadKey quadKey;
     /// Bounding box if the quadkey.
     const utymap::BoundingBox boundingBox;
+    /// Converts style values in meters to degrees inside the quadkey.
+    const utymap::utils::MetricScale metricScale;
     /// Current style provider.
     const utymap::mapcss::StyleProvider& styleProvider;
     /// String table.
     utymap::index::StringTable& stringTable;
-    /// Current elevation provider.
+    /// Elevation grid of the quadkey which is sampled once and shared by all builders.
+    const utymap::heightmap::GridElevationProvider eleGrid;
+    /// Current elevation provider: uses elevation grid for points inside the quadkey.
     const utymap::heightmap::ElevationProvider& eleProvider;
-    /// Mesh callback should be called once mesh is constructed.
+    /// Mesh callback should be called once mesh is constructed. Builders do not use mesh after
+    /// it is reported, so receiver may take its buffers.
     std::function<void(const utymap::meshing::Mesh&)> meshCallback;
     /// Element callback is called to process original element by external logic.
     std::function<void(const utymap::entities::Element&)> elementCallback;
     /// Mesh builder.
     const utymap::meshing::MeshBuilder meshBuilder;
+    /// Instances callback is optional: if set, repeated geometry is reported as instances of
+    /// prototype mesh instead of being merged into mesh.
+    std::function<void(const utymap::meshing::MeshInstances&)> instancesCallback;
 
     BuilderContext(const utymap::QuadKey& quadKey,
                    const utymap::mapcss::StyleProvider& styleProvider,
                    utymap::index::StringTable& stringTable,
                    const utymap::heightmap::ElevationProvider& eleProvider,
                    std::function<void(const utymap::meshing::Mesh&)> meshCallback,
-                   std::function<void(const utymap::entities::Element&)> elementCallback) :
+                   std::function<void(const utymap::entities::Element&)> elementCallback,
+                   std::function<void(const utymap::meshing::MeshInstances&)> instancesCallback = nullptr) :
         quadKey(quadKey),
         boundingBox(utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey)),
+        metricScale(boundingBox),
         styleProvider(styleProvider),
         stringTable(stringTable),
-        eleProvider(eleProvider),
+        eleGrid(eleProvider, boundingBox, quadKey.levelOfDetail),
+        eleProvider(eleGrid),
         meshCallback(meshCallback),
         elementCallback(elementCallback),
-        meshBuilder(quadKey, eleProvider)
+        meshBuilder(quadKey, eleGrid),
+        instancesCallback(instancesCallback)
     {
     }
 };
@@ -2,7 +2,9 @@
 #define BUILDERS_ELEMENTBUILDER_HPP_DEFINED
 
 #include "builders/BuilderContext.hpp"
+#include "entities/Element.hpp"
 #include "entities/ElementVisitor.hpp"
+#include "mapcss/Style.hpp"
 
 namespace utymap { namespace builders {
 
@@ -11,15 +13,47 @@ class ElementBuilder : public utymap::entities::ElementVisitor
 {
 public:
     explicit  ElementBuilder(const utymap::builders::BuilderContext& context) :
-        context_(context)
+        context_(context), styledElement_(nullptr), style_(nullptr)
     {
     }
 
     /// Called when all objects for the corresponding quadkey are processed.
     virtual void complete() = 0;
 
+    /// Runs next part of completion. Returns true if there are more parts, so build job can
+    /// yield between them. Completes at once by default.
+    virtual bool completeStep()
+    {
+        complete();
+        return false;
+    }
+
+    /// Returns true if every element visited so far is reported as separate mesh named by its
+    /// id, so changed element can be rebuilt without the rest elements of quadkey.
+    virtual bool hasElementMeshes() const { return false; }
+
+    /// Sets style of element which is visited next, so it is not computed again by builder.
+    /// Style should stay alive while element is visited.
+    virtual void prepareStyle(const utymap::entities::Element& element, const utymap::mapcss::Style& style)
+    {
+        styledElement_ = &element;
+        style_ = &style;
+    }
+
 protected:
+    /// Returns style of element: prepared one if it is set for this element.
+    utymap::mapcss::Style getStyle(const utymap::entities::Element& element) const
+    {
+        return styledElement_ == &element
+            ? *style_
+            : context_.styleProvider.forElement(element, context_.quadKey.levelOfDetail);
+    }
+
     const utymap::builders::BuilderContext& context_;
+
+private:
+    const utymap::entities::Element* styledElement_;
+    const utymap::mapcss::Style* style_;
 };
 
 }}
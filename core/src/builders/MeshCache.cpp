@@ -0,0 +1,365 @@
+#include "builders/MeshCache.hpp"
+#include "entities/ElementCopier.hpp"
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "index/ElementSnapshot.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+using namespace utymap::builders;
+using namespace utymap::entities;
+using namespace utymap::index;
+using namespace utymap::meshing;
+
+namespace {
+    /// Mesh file layout: magic (4b), result count (8b), then results in build order. Every
+    /// result is kind byte followed by mesh name and arrays for mesh. Elements are kept in
+    /// snapshot file with the same name.
+    const std::uint32_t MeshCacheMagic = 0x31434D55;
+    const char MeshResult = 0;
+    const char ElementResult = 1;
+
+    const std::string MeshExtension = ".mesh";
+    const std::string ElementExtension = ".uts";
+
+    /// Results of single tile build.
+    struct Entry final
+    {
+        std::vector<std::unique_ptr<Mesh>> meshes;
+        std::vector<std::shared_ptr<Element>> elements;
+        /// Kinds of results in the order they are reported.
+        std::vector<char> order;
+    };
+
+    /// Sums approximate amount of bytes used by visited elements.
+    struct MemoryUsageVisitor final : public ElementVisitor
+    {
+        std::size_t usage = 0;
+
+        void visitNode(const Node& node) override
+        {
+            usage += sizeof(Node) + getTagsUsage(node);
+        }
+
+        void visitWay(const Way& way) override
+        {
+            usage += sizeof(Way) + getTagsUsage(way) + way.coordinates.capacity() * sizeof(utymap::GeoCoordinate);
+        }
+
+        void visitArea(const Area& area) override
+        {
+            usage += sizeof(Area) + getTagsUsage(area) + area.coordinates.capacity() * sizeof(utymap::GeoCoordinate);
+        }
+
+        void visitRelation(const Relation& relation) override
+        {
+            usage += sizeof(Relation) + getTagsUsage(relation) +
+                relation.elements.capacity() * sizeof(std::shared_ptr<Element>);
+            for (const auto& element : relation.elements)
+                element->accept(*this);
+        }
+
+    private:
+        static std::size_t getTagsUsage(const Element& element)
+        {
+            return element.tags.capacity() * sizeof(Tag);
+        }
+    };
+
+    /// Returns approximate amount of bytes used by entry.
+    std::size_t getEntryUsage(const Entry& entry)
+    {
+        MemoryUsageVisitor visitor;
+        for (const auto& element : entry.elements)
+            element->accept(visitor);
+        std::size_t usage = sizeof(Entry) + visitor.usage + entry.order.capacity() +
+            entry.meshes.capacity() * sizeof(std::unique_ptr<Mesh>) +
+            entry.elements.capacity() * sizeof(std::shared_ptr<Element>);
+        for (const auto& mesh : entry.meshes)
+            usage += mesh->memoryUsage();
+        return usage;
+    }
+
+    std::unique_ptr<Mesh> copyMesh(const Mesh& mesh)
+    {
+        auto copy = utymap::utils::make_unique<Mesh>(mesh.name);
+        copy->vertices = mesh.vertices;
+        copy->triangles = mesh.triangles;
+        copy->colors = mesh.colors;
+        copy->uvs = mesh.uvs;
+        copy->elementRanges = mesh.elementRanges;
+        return copy;
+    }
+
+    template <typename T>
+    void write(std::ostream& stream, const T& value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    void write(std::ostream& stream, const std::vector<T>& values)
+    {
+        write(stream, static_cast<std::uint64_t>(values.size()));
+        stream.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    template <typename T>
+    void read(std::istream& stream, T& value)
+    {
+        stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    void read(std::istream& stream, std::vector<T>& values)
+    {
+        std::uint64_t size = 0;
+        read(stream, size);
+        if (!stream.good())
+            return;
+        values.resize(static_cast<std::size_t>(size));
+        stream.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T));
+    }
+}
+
+class MeshCache::MeshCacheImpl
+{
+    typedef std::list<std::string> KeyList;
+    typedef std::pair<std::shared_ptr<const Entry>, KeyList::iterator> CacheItem;
+
+public:
+    MeshCacheImpl(StringTable& stringTable, const std::string& directory, std::size_t capacity) :
+        stringTable_(stringTable), directory_(directory), capacity_(capacity > 0 ? capacity : 1)
+    {
+        if (!directory_.empty() && directory_.back() != '/' && directory_.back() != '\\')
+            directory_ += '/';
+    }
+
+    void build(const std::string& key, const QuadKeyBuilder::MeshCallback& meshFunc,
+               const QuadKeyBuilder::ElementCallback& elementFunc, const BuildFunction& buildFunc,
+               bool isPersistentKey)
+    {
+        bool hasDiskTier = isPersistentKey && !directory_.empty();
+        auto entry = get(key);
+        if (entry == nullptr && hasDiskTier) {
+            entry = readEntry(key);
+            if (entry != nullptr)
+                put(key, entry);
+        }
+
+        if (entry != nullptr) {
+            replay(*entry, meshFunc, elementFunc);
+            return;
+        }
+
+        auto recorded = std::make_shared<Entry>();
+        buildFunc([&](const Mesh& mesh) {
+            recorded->meshes.push_back(copyMesh(mesh));
+            recorded->order.push_back(MeshResult);
+            meshFunc(mesh);
+        }, [&](const Element& element) {
+            ElementCopier copier;
+            element.accept(copier);
+            recorded->elements.push_back(copier.element);
+            recorded->order.push_back(ElementResult);
+            elementFunc(element);
+        });
+
+        put(key, recorded);
+        if (hasDiskTier)
+            writeEntry(key, *recorded);
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        keys_.clear();
+        items_.clear();
+    }
+
+    std::size_t getMemoryUsage()
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        std::size_t usage = 0;
+        for (const auto& item : items_)
+            usage += item.first.capacity() + getEntryUsage(*item.second.first);
+        return usage;
+    }
+
+private:
+    static void replay(const Entry& entry, const QuadKeyBuilder::MeshCallback& meshFunc,
+                       const QuadKeyBuilder::ElementCallback& elementFunc)
+    {
+        std::size_t meshIndex = 0, elementIndex = 0;
+        for (char kind : entry.order) {
+            // NOTE receiver may take buffers of reported mesh, so cached one is copied.
+            if (kind == MeshResult)
+                meshFunc(*copyMesh(*entry.meshes[meshIndex++]));
+            else
+                elementFunc(*entry.elements[elementIndex++]);
+        }
+    }
+
+    std::shared_ptr<const Entry> get(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto item = items_.find(key);
+        if (item == items_.end())
+            return nullptr;
+        keys_.splice(keys_.begin(), keys_, item->second.second);
+        return item->second.first;
+    }
+
+    void put(const std::string& key, const std::shared_ptr<const Entry>& entry)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto item = items_.find(key);
+        if (item != items_.end()) {
+            item->second.first = entry;
+            keys_.splice(keys_.begin(), keys_, item->second.second);
+            return;
+        }
+
+        keys_.push_front(key);
+        items_.emplace(key, CacheItem(entry, keys_.begin()));
+        if (items_.size() > capacity_) {
+            items_.erase(keys_.back());
+            keys_.pop_back();
+        }
+    }
+
+    /// Reads entry from files. Returns null if there is no complete entry.
+    std::shared_ptr<const Entry> readEntry(const std::string& key)
+    {
+        std::ifstream file(directory_ + key + MeshExtension, std::ios::in | std::ios::binary);
+        std::uint32_t magic = 0;
+        read(file, magic);
+        if (!file.good() || magic != MeshCacheMagic)
+            return nullptr;
+
+        auto entry = std::make_shared<Entry>();
+        try {
+            ElementSnapshotReader::read(directory_ + key + ElementExtension, stringTable_, [&](Element& element) {
+                ElementCopier copier;
+                element.accept(copier);
+                entry->elements.push_back(copier.element);
+                return true;
+            });
+        }
+        catch (const std::exception&) {
+            return nullptr;
+        }
+
+        std::uint64_t count = 0;
+        read(file, count);
+        for (std::uint64_t i = 0; i < count && file.good(); ++i) {
+            char kind = 0;
+            read(file, kind);
+            entry->order.push_back(kind);
+            if (kind != MeshResult)
+                continue;
+
+            std::vector<char> name;
+            read(file, name);
+            auto mesh = utymap::utils::make_unique<Mesh>(std::string(name.begin(), name.end()));
+            read(file, mesh->vertices);
+            read(file, mesh->triangles);
+            read(file, mesh->colors);
+            read(file, mesh->uvs);
+            read(file, mesh->elementRanges);
+            entry->meshes.push_back(std::move(mesh));
+        }
+
+        std::size_t elementCount = entry->order.size() - entry->meshes.size();
+        if (!file.good() || entry->order.size() != count || elementCount != entry->elements.size())
+            return nullptr;
+        return entry;
+    }
+
+    /// Writes entry to files. Mesh file is written last, so its presence marks complete entry.
+    void writeEntry(const std::string& key, const Entry& entry)
+    {
+        std::lock_guard<std::mutex> lock(fileLock_);
+        std::string meshPath = directory_ + key + MeshExtension;
+        std::string tempPath = meshPath + ".tmp";
+
+        ElementSnapshotWriter writer(directory_ + key + ElementExtension, stringTable_);
+        for (const auto& element : entry.elements)
+            writer.add(*element);
+        writer.finish();
+
+        {
+            std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+            write(file, MeshCacheMagic);
+            write(file, static_cast<std::uint64_t>(entry.order.size()));
+            std::size_t meshIndex = 0;
+            for (char kind : entry.order) {
+                write(file, kind);
+                if (kind != MeshResult)
+                    continue;
+
+                const auto& mesh = *entry.meshes[meshIndex++];
+                write(file, std::vector<char>(mesh.name.begin(), mesh.name.end()));
+                write(file, mesh.vertices);
+                write(file, mesh.triangles);
+                write(file, mesh.colors);
+                write(file, mesh.uvs);
+                write(file, mesh.elementRanges);
+            }
+            if (!file.good())
+                throw std::domain_error("Cannot write mesh cache file: " + tempPath);
+        }
+
+        std::remove(meshPath.c_str());
+        if (std::rename(tempPath.c_str(), meshPath.c_str()) != 0)
+            std::remove(tempPath.c_str());
+    }
+
+    StringTable& stringTable_;
+    std::string directory_;
+    std::size_t capacity_;
+
+    std::mutex lock_;
+    KeyList keys_;
+    std::unordered_map<std::string, CacheItem> items_;
+
+    std::mutex fileLock_;
+};
+
+MeshCache::MeshCache(StringTable& stringTable, const std::string& directory, std::size_t capacity) :
+    pimpl_(utymap::utils::make_unique<MeshCacheImpl>(stringTable, directory, capacity))
+{
+}
+
+MeshCache::~MeshCache()
+{
+}
+
+void MeshCache::build(const std::string& key,
+                      const QuadKeyBuilder::MeshCallback& meshFunc,
+                      const QuadKeyBuilder::ElementCallback& elementFunc,
+                      const BuildFunction& buildFunc,
+                      bool isPersistentKey)
+{
+    pimpl_->build(key, meshFunc, elementFunc, buildFunc, isPersistentKey);
+}
+
+void MeshCache::clear()
+{
+    pimpl_->clear();
+}
+
+std::size_t MeshCache::getMemoryUsage()
+{
+    return pimpl_->getMemoryUsage();
+}
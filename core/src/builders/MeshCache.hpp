@@ -0,0 +1,52 @@
+#ifndef BUILDERS_MESHCACHE_HPP_DEFINED
+#define BUILDERS_MESHCACHE_HPP_DEFINED
+
+#include "builders/QuadKeyBuilder.hpp"
+#include "index/StringTable.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace utymap { namespace builders {
+
+/// Keeps results of tile builds: meshes and elements in order they are reported. Recently
+/// used tiles are kept in memory, tiles with persistent keys are written to directory if it is
+/// set. Key should describe all inputs of the build, e.g. stylesheet, quadkey and data version,
+/// so stale entries are never requested. Thread safe.
+class MeshCache final
+{
+public:
+    /// Builds tile reporting results via callbacks passed to it.
+    typedef std::function<void(const QuadKeyBuilder::MeshCallback&,
+                               const QuadKeyBuilder::ElementCallback&)> BuildFunction;
+
+    /// Creates cache for given amount of tiles in memory. Empty directory disables disk tier.
+    MeshCache(utymap::index::StringTable& stringTable, const std::string& directory, std::size_t capacity);
+
+    ~MeshCache();
+
+    /// Replays results of tile with given key if they are cached, otherwise builds tile
+    /// and caches its results. Nothing is cached if build throws. Persistent key describes
+    /// inputs the same way in every process, so only such tiles are read from and written
+    /// to directory.
+    void build(const std::string& key,
+               const QuadKeyBuilder::MeshCallback& meshFunc,
+               const QuadKeyBuilder::ElementCallback& elementFunc,
+               const BuildFunction& buildFunc,
+               bool isPersistentKey = true);
+
+    /// Removes all tiles from memory. Files are kept as they are addressed by key.
+    void clear();
+
+    /// Returns approximate amount of bytes used by tiles in memory.
+    std::size_t getMemoryUsage();
+
+private:
+    class MeshCacheImpl;
+    std::unique_ptr<MeshCacheImpl> pimpl_;
+};
+
+}}
+
+#endif // BUILDERS_MESHCACHE_HPP_DEFINED
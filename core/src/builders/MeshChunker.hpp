@@ -0,0 +1,67 @@
+#ifndef BUILDERS_MESHCHUNKER_HPP_DEFINED
+#define BUILDERS_MESHCHUNKER_HPP_DEFINED
+
+#include "meshing/MeshPool.hpp"
+#include "meshing/MeshTypes.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace utymap { namespace builders {
+
+/// Reports mesh which grows during build in chunks of bounded size, so receiver can release
+/// geometry of reported chunks while builder continues. Chunks are named "<name>#<index>" with
+/// index starting from zero, so names are the same for every build of given input. Separator
+/// differs from "<name>:<id>" of single element meshes, so chunk index is never taken as element
+/// id by picking. If max amount of vertices is zero, mesh is reported once using its name.
+class MeshChunker final
+{
+public:
+    typedef std::function<void(const utymap::meshing::Mesh&)> MeshCallback;
+
+    MeshChunker(const MeshCallback& callback, const std::string& name, std::size_t maxVertices) :
+        callback_(callback), name_(name), maxVertices_(maxVertices), chunkCount_(0)
+    {
+    }
+
+    /// Reports mesh and replaces it with empty one if it has at least max amount of vertices.
+    /// Returns true if mesh is reported.
+    bool flushIfNecessary(utymap::meshing::MeshPool::MeshPtr& mesh)
+    {
+        if (maxVertices_ == 0 || mesh->vertices.size() / 3 < maxVertices_)
+            return false;
+
+        report(*mesh);
+        mesh = utymap::meshing::MeshPool::local().acquire(name_, mesh->isIndexed);
+        return true;
+    }
+
+    /// Reports rest of mesh. Empty rest is skipped if chunks are reported already.
+    void flush(utymap::meshing::Mesh& mesh)
+    {
+        if (chunkCount_ == 0 || !mesh.vertices.empty())
+            report(mesh);
+    }
+
+    /// Returns amount of reported chunks.
+    std::size_t getChunkCount() const { return chunkCount_; }
+
+private:
+    void report(utymap::meshing::Mesh& mesh)
+    {
+        if (maxVertices_ > 0)
+            mesh.name = name_ + "#" + std::to_string(chunkCount_);
+        ++chunkCount_;
+        callback_(mesh);
+    }
+
+    const MeshCallback& callback_;
+    const std::string name_;
+    const std::size_t maxVertices_;
+    std::size_t chunkCount_;
+};
+
+}}
+
+#endif // BUILDERS_MESHCHUNKER_HPP_DEFINED
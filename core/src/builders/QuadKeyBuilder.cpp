@@ -1,11 +1,30 @@
 #include "builders/BuilderContext.hpp"
 #include "builders/ExternalBuilder.hpp"
 #include "builders/QuadKeyBuilder.hpp"
+#include "entities/ElementCopier.hpp"
+#include "entities/ElementDispatch.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
+#include "index/ElementPrefilter.hpp"
+#include "index/StyleFingerprint.hpp"
+#include "meshing/MeshDecimator.hpp"
+#include "meshing/MeshOptimizer.hpp"
+#include "utils/Arena.hpp"
+#include "utils/GeoUtils.hpp"
 #include "utils/CoreUtils.hpp"
+#include "utils/Statistics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
 
 using namespace utymap;
 using namespace utymap::builders;
@@ -16,129 +35,756 @@ using namespace utymap::mapcss;
 using namespace utymap::meshing;
 
 const std::string BuilderKeyName = "builders";
+/// Canvas key which lists prefixes of mesh names to optimize for vertex cache.
+const std::string MeshOptimizationKeyName = "mesh-optimization";
+/// Canvas key which specifies max error of mesh decimation in meters.
+const std::string MeshDecimationKeyName = "mesh-decimation";
+/// Max amount of quadkeys which builder dependencies are kept for rebuild.
+const std::size_t MaxTrackedQuadKeys = 64;
 
-class QuadKeyBuilder::QuadKeyBuilderImpl
-{
-private:
-
-    typedef std::unordered_map<std::string, ElementBuilderFactory> BuilderFactoryMap;
+namespace {
+    typedef std::unordered_map<std::string, QuadKeyBuilder::ElementBuilderFactory> BuilderFactoryMap;
+    /// Index of builder name in builder names.
+    typedef std::uint16_t BuilderId;
 
-class AggregateElementVisitor : public ElementVisitor
-{
-public:
-    AggregateElementVisitor(const QuadKey& quadKey,
-                           const StyleProvider& styleProvider,
-                           StringTable& stringTable,
-                           const ElevationProvider& eleProvider,
-                           const MeshCallback& meshFunc,
-                           const ElementCallback& elementFunc,
-                           BuilderFactoryMap& builderFactoryMap,
-                           std::uint32_t builderKeyId) :
-        context_(quadKey, styleProvider, stringTable, eleProvider, meshFunc, elementFunc),
-        builderFactoryMap_(builderFactoryMap),
-        builderKeyId_(builderKeyId)
+    /// Maps builder names to indices which are stable for the builder lifetime, so dependencies
+    /// do not keep name strings per element. Thread safe.
+    class BuilderNames final
     {
-    }
-
-    void visitNode(const Node& node) override { visitElement(node); }
-
-    void visitWay(const Way& way) override { visitElement(way); }
+    public:
+        BuilderId getId(const std::string& name)
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            auto pair = ids_.find(name);
+            if (pair != ids_.end())
+                return pair->second;
+            if (names_.size() > std::numeric_limits<BuilderId>::max())
+                throw std::domain_error("Too many builder names: " + name);
+            BuilderId id = static_cast<BuilderId>(names_.size());
+            names_.push_back(name);
+            ids_.emplace(name, id);
+            return id;
+        }
 
-    void visitArea(const Area& area) override { visitElement(area); }
+        std::string getName(BuilderId id)
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            return names_.at(id);
+        }
 
-    void visitRelation(const Relation& relation) override { visitElement(relation); }
+    private:
+        std::mutex lock_;
+        std::unordered_map<std::string, BuilderId> ids_;
+        std::vector<std::string> names_;
+    };
 
-    void complete()
+    /// Builders which consumed elements of quadkey in its last build.
+    struct TileDependencies final
     {
-        for (const auto& builder : builders_)
-            builder.second->complete();
-    }
+        /// Fingerprint version of style provider used by build.
+        std::uint64_t version;
+        /// Builders which visited element by element id.
+        std::unordered_map<std::uint64_t, std::vector<BuilderId>> elements;
+        /// Builders which merge several elements into one mesh, so changed element cannot be
+        /// rebuilt by them alone.
+        std::unordered_set<BuilderId> aggregateBuilders;
+    };
 
-private:
-    /// Calls appropriate visitor for given element
-    void visitElement(const Element& element)
+    /// Keeps dependencies of recently built quadkeys. Thread safe.
+    class DependencyRegistry final
     {
-        Style style = context_.styleProvider.forElement(element, context_.quadKey.levelOfDetail);
+    public:
+        std::shared_ptr<const TileDependencies> get(const QuadKey& quadKey)
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            auto entry = entries_.find(quadKey);
+            return entry != entries_.end() ? entry->second.first : nullptr;
+        }
 
-        // we don't know how to build it. Skip.
-        if (!style.has(builderKeyId_))
-            return;
+        void put(const QuadKey& quadKey, std::shared_ptr<const TileDependencies> dependencies)
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            auto entry = entries_.find(quadKey);
+            if (entry != entries_.end()) {
+                entry->second.first = std::move(dependencies);
+                order_.splice(order_.end(), order_, entry->second.second);
+                return;
+            }
+
+            order_.push_back(quadKey);
+            entries_.emplace(quadKey, std::make_pair(std::move(dependencies), std::prev(order_.end())));
+            if (entries_.size() > MaxTrackedQuadKeys) {
+                entries_.erase(order_.front());
+                order_.pop_front();
+            }
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            entries_.clear();
+            order_.clear();
+        }
+
+    private:
+        std::mutex lock_;
+        std::unordered_map<QuadKey, std::pair<std::shared_ptr<const TileDependencies>, std::list<QuadKey>::iterator>, QuadKeyHash> entries_;
+        std::list<QuadKey> order_;
+    };
 
-        std::stringstream ss(style.get(builderKeyId_).value());
+    /// Returns names of builders listed in declaration value.
+    std::vector<std::string> parseBuilderNames(const std::string& value)
+    {
+        std::vector<std::string> names;
+        std::stringstream ss(value);
         while (ss.good()) {
             std::string name;
             getline(ss, name, ',');
-            element.accept(getBuilder(name));
+            names.push_back(name);
         }
+        return names;
+    }
+
+    /// Returns statistics stage of builder with given name.
+    utymap::utils::Statistics::Stage getBuilderStage(const std::string& name)
+    {
+        using Stage = utymap::utils::Statistics::Stage;
+        if (name == "terrain") return Stage::TerrainBuilder;
+        if (name == "building") return Stage::BuildingBuilder;
+        if (name == "tree") return Stage::TreeBuilder;
+        if (name == "barrier") return Stage::BarrierBuilder;
+        return Stage::OtherBuilder;
     }
 
-    ElementBuilder& getBuilder(const std::string& name)
+    /// Visits element by builder adding time to statistics of builder's stage. NOTE element
+    /// has known type, so builder is called without dispatch by element.
+    template <typename T>
+    void visitTimed(const T& element, ElementBuilder& builder, utymap::utils::Statistics::Stage stage)
     {
-        auto builderPair = builders_.find(name);
-        if (builderPair != builders_.end()) {
-            return *builderPair->second;
+#ifdef UTYMAP_STATISTICS
+        utymap::utils::Statistics::Scope scope(stage);
+#endif
+        utymap::entities::visit(element, builder);
+    }
+
+    /// Decimates and optimizes built meshes as it is specified by canvas before they are reported.
+    class MeshProcessor final
+    {
+    public:
+        MeshProcessor(const QuadKey& quadKey,
+                      const Style& canvasStyle,
+                      std::uint32_t meshDecimationKeyId,
+                      std::uint32_t meshOptimizationKeyId,
+                      const QuadKeyBuilder::MeshCallback& meshFunc) :
+            decimator_(utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey), canvasStyle.getValue(meshDecimationKeyId, 0.)),
+            optimizer_(canvasStyle.getString(meshOptimizationKeyId)),
+            meshFunc_(meshFunc)
+        {
+        }
+
+        void process(const Mesh& mesh) const
+        {
+            UTYMAP_STATISTICS_SCOPE(MeshCallback);
+            std::unique_ptr<Mesh> decimated;
+            // NOTE non-indexed meshes cannot be simplified, see MeshDecimator.
+            if (decimator_.isEnabled() && mesh.isIndexed) {
+                decimated = utymap::utils::make_unique<Mesh>(mesh.name, mesh.isIndexed);
+                decimator_.decimate(mesh, *decimated);
+            }
+            const Mesh& current = decimated != nullptr ? *decimated : mesh;
+            if (!optimizer_.canOptimize(mesh.name)) {
+                meshFunc_(current);
+                return;
+            }
+            Mesh optimized(mesh.name, mesh.isIndexed);
+            optimizer_.optimize(current, optimized);
+            meshFunc_(optimized);
+        }
+
+    private:
+        const MeshDecimator decimator_;
+        const MeshOptimizer optimizer_;
+        const QuadKeyBuilder::MeshCallback meshFunc_;
+    };
+
+    class AggregateElementVisitor final : public FingerprintElementVisitor, public ElementPrefilter
+    {
+    public:
+        AggregateElementVisitor(const QuadKey& quadKey,
+                                const StyleProvider& styleProvider,
+                                StringTable& stringTable,
+                                const ElevationProvider& eleProvider,
+                                const QuadKeyBuilder::MeshCallback& meshFunc,
+                                const QuadKeyBuilder::ElementCallback& elementFunc,
+                                const QuadKeyBuilder::InstancesCallback& instancesFunc,
+                                const BuilderFactoryMap& builderFactoryMap,
+                                BuilderNames& builderNames,
+                                std::uint32_t builderKeyId) :
+            context_(quadKey, styleProvider, stringTable, eleProvider, meshFunc, elementFunc, instancesFunc),
+            builderFactoryMap_(builderFactoryMap),
+            builderNames_(builderNames),
+            builderKeyId_(builderKeyId),
+            hasFingerprint_(false),
+            completed_(0),
+            dependencies_(nullptr),
+            builderFilter_(nullptr)
+        {
+        }
+
+        /// Sets dependencies which receive builders of visited elements or null.
+        void setDependencies(TileDependencies* dependencies) { dependencies_ = dependencies; }
+
+        /// Sets builders which are allowed to visit next elements or null if all are.
+        void setBuilderFilter(const std::unordered_set<BuilderId>* builderFilter) { builderFilter_ = builderFilter; }
+
+        /// Creates given builders if they are not created yet, so they are completed even if
+        /// no element is visited by them.
+        void createBuilders(const std::unordered_set<BuilderId>& ids)
+        {
+            for (auto id : ids)
+                getBuilder(builderNames_.getName(id));
+        }
+
+        /// Adds created builders which merge elements into shared meshes.
+        void addAggregateBuilders(std::unordered_set<BuilderId>& ids) const
+        {
+            for (const auto& builder : builders_)
+                if (!builder.second->hasElementMeshes())
+                    ids.insert(builderNames_.getId(builder.first));
+        }
+
+        void setFingerprint(const StyleFingerprint* fingerprint) override
+        {
+            hasFingerprint_ = fingerprint != nullptr &&
+                              fingerprint->version == context_.styleProvider.getFingerprintVersion();
+            if (hasFingerprint_)
+                fingerprint_ = *fingerprint;
+        }
+
+        void visitNode(const Node& node) override { visitElement(node); }
+
+        void visitWay(const Way& way) override { visitElement(way); }
+
+        void visitArea(const Area& area) override { visitElement(area); }
+
+        void visitRelation(const Relation& relation) override { visitElement(relation); }
+
+        /// Rejects element without style at current level of detail, so its geometry is not decoded.
+        bool accepts(const Element& element) override
+        {
+            return context_.styleProvider.hasStyle(element, context_.quadKey.levelOfDetail);
+        }
+
+        void complete()
+        {
+            while (completeNext()) { }
+        }
+
+        /// Runs the next completion step of builder. Returns false if all builders are completed.
+        /// NOTE elements should not be visited after completion is started.
+        bool completeNext()
+        {
+            if (completed_ == 0) {
+                completing_.clear();
+                for (const auto& builder : builders_)
+                    completing_.push_back(std::make_pair(builder.first, builder.second.get()));
+            }
+            if (completed_ == completing_.size())
+                return false;
+
+            const auto& builder = completing_[completed_];
+#ifdef UTYMAP_STATISTICS
+            utymap::utils::Statistics::Scope scope(getBuilderStage(builder.first));
+#endif
+            if (!builder.second->completeStep())
+                ++completed_;
+            return true;
+        }
+
+    private:
+        /// Calls appropriate visitor for given element
+        template <typename T>
+        void visitElement(const T& element)
+        {
+            // NOTE style resolved at import time is used if it is still valid.
+            Style style = hasFingerprint_
+                ? context_.styleProvider.forFingerprint(element, fingerprint_.id)
+                : context_.styleProvider.forElement(element, context_.quadKey.levelOfDetail);
+            hasFingerprint_ = false;
+
+            // we don't know how to build it. Skip.
+            if (!style.has(builderKeyId_))
+                return;
+
+            for (const auto& builder : getBuilders(style.get(builderKeyId_))) {
+                if (builderFilter_ != nullptr && builderFilter_->find(builder.id) == builderFilter_->end())
+                    continue;
+                if (dependencies_ != nullptr)
+                    dependencies_->elements[element.id].push_back(builder.id);
+                builder.builder->prepareStyle(element, style);
+                visitTimed(element, *builder.builder, builder.stage);
+            }
+        }
+
+        /// Builder listed in declaration.
+        struct DeclarationBuilder final
+        {
+            BuilderId id;
+            ElementBuilder* builder;
+            utymap::utils::Statistics::Stage stage;
+        };
+
+        /// Returns builders listed in declaration with their statistics stages. List is parsed
+        /// once per declaration.
+        const std::vector<DeclarationBuilder>& getBuilders(const StyleDeclaration& declaration)
+        {
+            auto pair = declarationBuilders_.find(&declaration);
+            if (pair != declarationBuilders_.end())
+                return pair->second;
+
+            std::vector<DeclarationBuilder> builders;
+            for (const auto& name : parseBuilderNames(declaration.value())) {
+                ElementBuilder& builder = getBuilder(name);
+                builders.push_back(DeclarationBuilder { builderNames_.getId(name), &builder, getBuilderStage(name) });
+            }
+            return declarationBuilders_.emplace(&declaration, std::move(builders)).first->second;
+        }
+
+        ElementBuilder& getBuilder(const std::string& name)
+        {
+            auto builderPair = builders_.find(name);
+            if (builderPair != builders_.end()) {
+                return *builderPair->second;
+            }
+
+            auto factory = builderFactoryMap_.find(name);
+            if (factory == builderFactoryMap_.end()) {
+                // use external builder by default
+                builders_.emplace(name, utymap::utils::make_unique<ExternalBuilder>(context_));
+            } else {
+                builders_.emplace(name, factory->second(context_));
+            }
+
+            return *builders_[name];
+        }
+
+        const BuilderContext context_;
+        const BuilderFactoryMap& builderFactoryMap_;
+        BuilderNames& builderNames_;
+        std::uint32_t builderKeyId_;
+        /// Fingerprint of element which is visited next if it is valid.
+        bool hasFingerprint_;
+        StyleFingerprint fingerprint_;
+        std::unordered_map<std::string, std::unique_ptr<ElementBuilder>> builders_;
+        /// NOTE declarations are owned by style sheet which outlives the build.
+        std::unordered_map<const StyleDeclaration*, std::vector<DeclarationBuilder>> declarationBuilders_;
+        /// Builders in order of completion and amount of completed ones.
+        std::vector<std::pair<std::string, ElementBuilder*>> completing_;
+        std::size_t completed_;
+        TileDependencies* dependencies_;
+        const std::unordered_set<BuilderId>* builderFilter_;
+    };
+
+    /// Copies found elements with their fingerprints, so they can be visited later.
+    class ElementCollector final : public FingerprintElementVisitor
+    {
+    public:
+        struct Entry
+        {
+            std::shared_ptr<Element> element;
+            bool hasFingerprint;
+            StyleFingerprint fingerprint;
+        };
+
+        /// Creates collector which copies elements accepted by filter or all if it is not set.
+        /// Copies are allocated from given arena.
+        explicit ElementCollector(utymap::utils::Arena& arena, std::function<bool(const Element&)> filter = nullptr) :
+            entries(), arena_(arena), filter_(std::move(filter)), hasFingerprint_(false), fingerprint_()
+        {
+        }
+
+        void setFingerprint(const StyleFingerprint* fingerprint) override
+        {
+            hasFingerprint_ = fingerprint != nullptr;
+            if (hasFingerprint_)
+                fingerprint_ = *fingerprint;
+        }
+
+        void visitNode(const Node& node) override { add(node); }
+
+        void visitWay(const Way& way) override { add(way); }
+
+        void visitArea(const Area& area) override { add(area); }
+
+        void visitRelation(const Relation& relation) override { add(relation); }
+
+        std::vector<Entry> entries;
+
+    private:
+        void add(const Element& element)
+        {
+            if (filter_ && !filter_(element)) {
+                hasFingerprint_ = false;
+                return;
+            }
+
+            ElementCopier copier(&arena_);
+            element.accept(copier);
+            entries.push_back(Entry { copier.element, hasFingerprint_, fingerprint_ });
+            hasFingerprint_ = false;
         }
 
-        auto factory = builderFactoryMap_.find(name);
-        if (factory == builderFactoryMap_.end()) {
-            // use external builder by default
-            builders_.emplace(name, utymap::utils::make_unique<ExternalBuilder>(context_));
-        } else {
-            builders_.emplace(name, factory->second(context_));
+        utymap::utils::Arena& arena_;
+        const std::function<bool(const Element&)> filter_;
+        bool hasFingerprint_;
+        StyleFingerprint fingerprint_;
+    };
+}
+
+class QuadKeyBuilder::Job::JobImpl final
+{
+    enum class Stage { Search, Elements, Completion, Done };
+
+public:
+    JobImpl(const QuadKey& quadKey,
+            const StyleProvider& styleProvider,
+            StringTable& stringTable,
+            const ElevationProvider& eleProvider,
+            GeoStore& geoStore,
+            const MeshCallback& meshFunc,
+            const ElementCallback& elementFunc,
+            const InstancesCallback& instancesFunc,
+            const std::shared_ptr<const BuilderFactoryMap>& builderFactory,
+            BuilderNames& builderNames,
+            std::uint32_t builderKeyId,
+            std::uint32_t meshDecimationKeyId,
+            std::uint32_t meshOptimizationKeyId,
+            const std::shared_ptr<DependencyRegistry>& dependencyRegistry) :
+        arena_(),
+        quadKey_(quadKey),
+        styleProvider_(styleProvider),
+        geoStore_(geoStore),
+        builderFactory_(builderFactory),
+        meshProcessor_(quadKey, styleProvider.forCanvas(quadKey.levelOfDetail), meshDecimationKeyId, meshOptimizationKeyId, meshFunc),
+        elementVisitor_(quadKey, styleProvider, stringTable, eleProvider, [this](const Mesh& mesh) {
+            meshProcessor_.process(mesh);
+        }, elementFunc, instancesFunc, *builderFactory_, builderNames, builderKeyId),
+        collector_(arena_),
+        dependencyRegistry_(dependencyRegistry),
+        dependencies_(dependencyRegistry != nullptr ? std::make_shared<TileDependencies>() : nullptr),
+        next_(0),
+        stage_(Stage::Search)
+    {
+        if (dependencies_ != nullptr) {
+            dependencies_->version = styleProvider.getFingerprintVersion();
+            elementVisitor_.setDependencies(dependencies_.get());
         }
+    }
 
-        return *builders_[name];
+    bool step(double budget)
+    {
+        auto start = std::chrono::steady_clock::now();
+        do {
+            if (!next())
+                return true;
+        } while (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() < budget);
+        return stage_ == Stage::Done;
     }
 
-    const BuilderContext context_;
-    BuilderFactoryMap& builderFactoryMap_;
-    std::uint32_t builderKeyId_;
-    std::unordered_map<std::string, std::unique_ptr<ElementBuilder>> builders_;
+    bool isCompleted() const { return stage_ == Stage::Done; }
+
+private:
+    /// Runs next step. Returns false if build is completed.
+    bool next()
+    {
+        switch (stage_) {
+            case Stage::Search:
+                geoStore_.search(quadKey_, styleProvider_, collector_);
+                stage_ = Stage::Elements;
+                return true;
+            case Stage::Elements:
+                if (next_ < collector_.entries.size()) {
+                    auto& entry = collector_.entries[next_++];
+                    elementVisitor_.setFingerprint(entry.hasFingerprint ? &entry.fingerprint : nullptr);
+                    utymap::entities::visit(*entry.element, elementVisitor_);
+                    // NOTE visited element is not needed anymore.
+                    entry.element.reset();
+                    return true;
+                }
+                if (dependencies_ != nullptr) {
+                    elementVisitor_.addAggregateBuilders(dependencies_->aggregateBuilders);
+                    dependencyRegistry_->put(quadKey_, dependencies_);
+                }
+                stage_ = Stage::Completion;
+                return true;
+            case Stage::Completion:
+                if (elementVisitor_.completeNext())
+                    return true;
+                stage_ = Stage::Done;
+                return false;
+            default:
+                return false;
+        }
+    }
+
+    /// NOTE job can be stepped by different threads, so it has own arena.
+    utymap::utils::Arena arena_;
+    const QuadKey quadKey_;
+    const StyleProvider& styleProvider_;
+    GeoStore& geoStore_;
+    const std::shared_ptr<const BuilderFactoryMap> builderFactory_;
+    const MeshProcessor meshProcessor_;
+    AggregateElementVisitor elementVisitor_;
+    ElementCollector collector_;
+    /// NOTE registry and dependencies are null if dependency tracking is disabled.
+    const std::shared_ptr<DependencyRegistry> dependencyRegistry_;
+    const std::shared_ptr<TileDependencies> dependencies_;
+    std::size_t next_;
+    Stage stage_;
 };
 
+class QuadKeyBuilder::QuadKeyBuilderImpl
+{
 public:
     QuadKeyBuilderImpl(GeoStore& geoStore, StringTable& stringTable) :
         geoStore_(geoStore),
         stringTable_(stringTable),
         builderKeyId_(stringTable.getId(BuilderKeyName)),
-        builderFactory_()
+        meshOptimizationKeyId_(stringTable.getId(MeshOptimizationKeyName)),
+        meshDecimationKeyId_(stringTable.getId(MeshDecimationKeyName)),
+        builderFactory_(std::make_shared<const BuilderFactoryMap>()),
+        builderNames_(),
+        isTrackingEnabled_(false),
+        dependencyRegistry_(std::make_shared<DependencyRegistry>())
     {
     }
 
+    void enableDependencyTracking(bool isEnabled)
+    {
+        isTrackingEnabled_ = isEnabled;
+        if (!isEnabled)
+            dependencyRegistry_->clear();
+    }
+
+    /// NOTE factories are replaced by copy, so builds which are in progress keep using
+    /// their snapshot and do not need lock.
     void registerElementVisitor(const std::string& name, ElementBuilderFactory factory)
     {
-        builderFactory_[name] = factory;
+        std::lock_guard<std::mutex> lock(factoryLock_);
+        auto updated = std::make_shared<BuilderFactoryMap>(*builderFactory_);
+        (*updated)[name] = factory;
+        builderFactory_ = updated;
     }
 
     void build(const QuadKey& quadKey,
                const StyleProvider& styleProvider,
                const ElevationProvider& eleProvider,
                const MeshCallback& meshFunc,
-               const ElementCallback& elementFunc)
+               const ElementCallback& elementFunc,
+               const InstancesCallback& instancesFunc)
     {
+        auto builderFactory = getBuilderFactory();
+        UTYMAP_STATISTICS_SCOPE(QuadKeyBuild);
+        MeshProcessor meshProcessor(quadKey, styleProvider.forCanvas(quadKey.levelOfDetail),
+                                    meshDecimationKeyId_, meshOptimizationKeyId_, meshFunc);
         AggregateElementVisitor elementVisitor(quadKey, styleProvider, stringTable_,
-            eleProvider, meshFunc, elementFunc, builderFactory_, builderKeyId_);
+            eleProvider, [&meshProcessor](const Mesh& mesh) {
+                meshProcessor.process(mesh);
+            }, elementFunc, instancesFunc, *builderFactory, builderNames_, builderKeyId_);
+
+        if (!isTrackingEnabled_) {
+            geoStore_.search(quadKey, styleProvider, elementVisitor);
+            elementVisitor.complete();
+            return;
+        }
+
+        auto dependencies = std::make_shared<TileDependencies>();
+        dependencies->version = styleProvider.getFingerprintVersion();
+        elementVisitor.setDependencies(dependencies.get());
 
         geoStore_.search(quadKey, styleProvider, elementVisitor);
+        elementVisitor.addAggregateBuilders(dependencies->aggregateBuilders);
+        dependencyRegistry_->put(quadKey, dependencies);
         elementVisitor.complete();
     }
 
+    std::vector<std::uint64_t> rebuild(const QuadKey& quadKey,
+                                       const std::vector<std::uint64_t>& elementIds,
+                                       const StyleProvider& styleProvider,
+                                       const ElevationProvider& eleProvider,
+                                       const MeshCallback& meshFunc,
+                                       const ElementCallback& elementFunc,
+                                       const InstancesCallback& instancesFunc)
+    {
+        auto previous = isTrackingEnabled_ ? dependencyRegistry_->get(quadKey) : nullptr;
+        if (previous == nullptr || previous->version != styleProvider.getFingerprintVersion()) {
+            build(quadKey, styleProvider, eleProvider, meshFunc, elementFunc, instancesFunc);
+            return {};
+        }
+
+        // 1. collect changed elements and elements of builders which merge them.
+        utymap::utils::Arena& arena = utymap::utils::Arena::local();
+        utymap::utils::Arena::Scope arenaScope(arena);
+        std::unordered_set<std::uint64_t> changed(elementIds.begin(), elementIds.end());
+        ElementCollector collector(arena, [&](const Element& element) {
+            if (changed.find(element.id) != changed.end())
+                return true;
+            auto ids = previous->elements.find(element.id);
+            if (ids == previous->elements.end())
+                return false;
+            for (auto builderId : ids->second)
+                if (previous->aggregateBuilders.find(builderId) != previous->aggregateBuilders.end())
+                    return true;
+            return false;
+        });
+        geoStore_.search(quadKey, styleProvider, collector);
+
+        // 2. find builders which consumed changed elements before or consume them now.
+        std::unordered_set<BuilderId> affected;
+        for (auto id : changed) {
+            auto ids = previous->elements.find(id);
+            if (ids != previous->elements.end())
+                affected.insert(ids->second.begin(), ids->second.end());
+        }
+        for (const auto& entry : collector.entries) {
+            if (changed.find(entry.element->id) == changed.end())
+                continue;
+            Style style = styleProvider.forElement(*entry.element, quadKey.levelOfDetail);
+            if (style.has(builderKeyId_))
+                for (const auto& name : parseBuilderNames(style.getString(builderKeyId_)))
+                    affected.insert(builderNames_.getId(name));
+        }
+        std::unordered_set<BuilderId> affectedAggregates;
+        for (auto builderId : affected)
+            if (previous->aggregateBuilders.find(builderId) != previous->aggregateBuilders.end())
+                affectedAggregates.insert(builderId);
+
+        // 3. visit changed elements by affected builders and the rest by affected aggregates.
+        auto dependencies = std::make_shared<TileDependencies>(*previous);
+        for (auto id : changed)
+            dependencies->elements.erase(id);
+
+        auto builderFactory = getBuilderFactory();
+        UTYMAP_STATISTICS_SCOPE(QuadKeyBuild);
+        MeshProcessor meshProcessor(quadKey, styleProvider.forCanvas(quadKey.levelOfDetail),
+                                    meshDecimationKeyId_, meshOptimizationKeyId_, meshFunc);
+        AggregateElementVisitor elementVisitor(quadKey, styleProvider, stringTable_,
+            eleProvider, [&meshProcessor](const Mesh& mesh) {
+                meshProcessor.process(mesh);
+            }, elementFunc, instancesFunc, *builderFactory, builderNames_, builderKeyId_);
+
+        for (const auto& entry : collector.entries) {
+            bool isChanged = changed.find(entry.element->id) != changed.end();
+            elementVisitor.setDependencies(isChanged ? dependencies.get() : nullptr);
+            elementVisitor.setBuilderFilter(isChanged ? &affected : &affectedAggregates);
+            elementVisitor.setFingerprint(entry.hasFingerprint ? &entry.fingerprint : nullptr);
+            utymap::entities::visit(*entry.element, elementVisitor);
+        }
+        // NOTE aggregate builder reports its mesh without removed element even if it is empty.
+        elementVisitor.createBuilders(affectedAggregates);
+        elementVisitor.addAggregateBuilders(dependencies->aggregateBuilders);
+
+        // 4. report changed elements which own meshes are not built anymore.
+        std::vector<std::uint64_t> removed;
+        for (auto id : changed) {
+            auto oldIds = previous->elements.find(id);
+            if (oldIds == previous->elements.end())
+                continue;
+            auto newIds = dependencies->elements.find(id);
+            for (auto builderId : oldIds->second) {
+                bool isRemoved = previous->aggregateBuilders.find(builderId) == previous->aggregateBuilders.end() &&
+                    (newIds == dependencies->elements.end() ||
+                     std::find(newIds->second.begin(), newIds->second.end(), builderId) == newIds->second.end());
+                if (isRemoved) {
+                    removed.push_back(id);
+                    break;
+                }
+            }
+        }
+
+        dependencyRegistry_->put(quadKey, dependencies);
+        elementVisitor.complete();
+        return removed;
+    }
+
+    std::unique_ptr<Job> createJob(const QuadKey& quadKey,
+                                   const StyleProvider& styleProvider,
+                                   const ElevationProvider& eleProvider,
+                                   const MeshCallback& meshFunc,
+                                   const ElementCallback& elementFunc,
+                                   const InstancesCallback& instancesFunc)
+    {
+        return utymap::utils::make_unique<Job>(utymap::utils::make_unique<Job::JobImpl>(
+            quadKey, styleProvider, stringTable_, eleProvider, geoStore_, meshFunc, elementFunc, instancesFunc,
+            getBuilderFactory(), builderNames_, builderKeyId_, meshDecimationKeyId_, meshOptimizationKeyId_,
+            isTrackingEnabled_ ? dependencyRegistry_ : nullptr));
+    }
+
 private:
+    std::shared_ptr<const BuilderFactoryMap> getBuilderFactory()
+    {
+        std::lock_guard<std::mutex> lock(factoryLock_);
+        return builderFactory_;
+    }
+
     GeoStore& geoStore_;
     StringTable& stringTable_;
     std::uint32_t builderKeyId_;
-    BuilderFactoryMap builderFactory_;
+    std::uint32_t meshOptimizationKeyId_;
+    std::uint32_t meshDecimationKeyId_;
+    std::mutex factoryLock_;
+    std::shared_ptr<const BuilderFactoryMap> builderFactory_;
+    BuilderNames builderNames_;
+    std::atomic<bool> isTrackingEnabled_;
+    const std::shared_ptr<DependencyRegistry> dependencyRegistry_;
 };
 
+QuadKeyBuilder::Job::Job(std::unique_ptr<JobImpl> pimpl) :
+    pimpl_(std::move(pimpl))
+{
+}
+
+QuadKeyBuilder::Job::~Job()
+{
+}
+
+bool QuadKeyBuilder::Job::step(double budget)
+{
+    return pimpl_->step(budget);
+}
+
+bool QuadKeyBuilder::Job::isCompleted() const
+{
+    return pimpl_->isCompleted();
+}
+
 void QuadKeyBuilder::registerElementBuilder(const std::string& name, ElementBuilderFactory factory)
 {
     pimpl_->registerElementVisitor(name, factory);
 }
 
-void QuadKeyBuilder::build(const QuadKey& quadKey, const StyleProvider& styleProvider, const ElevationProvider& eleProvider, 
-    MeshCallback meshFunc, ElementCallback elementFunc)
+void QuadKeyBuilder::enableDependencyTracking(bool isEnabled)
+{
+    pimpl_->enableDependencyTracking(isEnabled);
+}
+
+void QuadKeyBuilder::build(const QuadKey& quadKey, const StyleProvider& styleProvider, const ElevationProvider& eleProvider,
+    MeshCallback meshFunc, ElementCallback elementFunc, InstancesCallback instancesFunc)
+{
+    pimpl_->build(quadKey, styleProvider, eleProvider, meshFunc, elementFunc, instancesFunc);
+}
+
+std::vector<std::uint64_t> QuadKeyBuilder::rebuild(const QuadKey& quadKey, const std::vector<std::uint64_t>& elementIds,
+    const StyleProvider& styleProvider, const ElevationProvider& eleProvider, MeshCallback meshFunc,
+    ElementCallback elementFunc, InstancesCallback instancesFunc)
+{
+    return pimpl_->rebuild(quadKey, elementIds, styleProvider, eleProvider, meshFunc, elementFunc, instancesFunc);
+}
+
+std::unique_ptr<QuadKeyBuilder::Job> QuadKeyBuilder::createJob(const QuadKey& quadKey, const StyleProvider& styleProvider,
+    const ElevationProvider& eleProvider, MeshCallback meshFunc, ElementCallback elementFunc, InstancesCallback instancesFunc)
 {
-    pimpl_->build(quadKey, styleProvider, eleProvider, meshFunc, elementFunc);
+    return pimpl_->createJob(quadKey, styleProvider, eleProvider, meshFunc, elementFunc, instancesFunc);
 }
 
 QuadKeyBuilder::QuadKeyBuilder(GeoStore& geoStore, StringTable& stringTable) :
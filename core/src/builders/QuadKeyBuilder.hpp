@@ -10,21 +10,47 @@
 #include "mapcss/StyleProvider.hpp"
 #include "meshing/MeshTypes.hpp"
 
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace utymap { namespace builders {
 
-/// Responsible for building single quadkey.
+/// Responsible for building single quadkey. Different quadkeys can be built in parallel.
 class QuadKeyBuilder final
 {
 public:
     typedef std::function<void(const utymap::meshing::Mesh&)> MeshCallback;
     typedef std::function<void(const utymap::entities::Element&)> ElementCallback;
+    typedef std::function<void(const utymap::meshing::MeshInstances&)> InstancesCallback;
     /// Factory of element builders
     typedef std::function<std::unique_ptr<utymap::builders::ElementBuilder>(const utymap::builders::BuilderContext&)> ElementBuilderFactory;
 
+    /// Build of single quadkey which is done in steps: store search, visit of every element by
+    /// builders and completion steps of every builder, e.g. every terrain layer. Builder state
+    /// is kept between steps, so build can be spread over several frames on platforms without
+    /// threads. Arguments of build should outlive the job.
+    class Job final
+    {
+    public:
+        class JobImpl;
+
+        explicit Job(std::unique_ptr<JobImpl> pimpl);
+
+        ~Job();
+
+        /// Runs steps till given time budget in milliseconds is spent. Step is not interrupted,
+        /// so the last one can exceed budget. Returns true when build is completed.
+        bool step(double budget);
+
+        bool isCompleted() const;
+
+    private:
+        std::unique_ptr<JobImpl> pimpl_;
+    };
+
     QuadKeyBuilder(utymap::index::GeoStore& geoStore,
                    utymap::index::StringTable& stringTable);
 
@@ -33,12 +59,42 @@ public:
     /// Registers factory method for element builder.
     void registerElementBuilder(const std::string& name, ElementBuilderFactory factory);
 
-    /// Builds tile for given quadkey.
+    /// Enables or disables tracking of builders which consume elements of recently built
+    /// quadkeys. It is needed by rebuild only, so it is disabled by default. Disabling releases
+    /// tracked dependencies.
+    void enableDependencyTracking(bool isEnabled);
+
+    /// Builds tile for given quadkey. If instances callback is set, builders report
+    /// repeated geometry as instances.
     void build(const utymap::QuadKey& quadKey,
                const utymap::mapcss::StyleProvider& styleProvider,
                const utymap::heightmap::ElevationProvider& eleProvider,
                MeshCallback meshFunc,
-               ElementCallback elementFunc);
+               ElementCallback elementFunc,
+               InstancesCallback instancesFunc = nullptr);
+
+    /// Rebuilds given changed elements of quadkey which was built recently. Only builders which
+    /// visited these elements in previous build or visit them now are run, so only their meshes
+    /// are reported with the same names. Builders which report separate mesh per element visit
+    /// changed elements only, the rest visit all elements they consumed. Builds whole quadkey
+    /// if it was not built with the same style or dependency tracking is disabled. Returns ids of changed elements which meshes
+    /// are not built anymore, so they should be removed by caller.
+    std::vector<std::uint64_t> rebuild(const utymap::QuadKey& quadKey,
+                                       const std::vector<std::uint64_t>& elementIds,
+                                       const utymap::mapcss::StyleProvider& styleProvider,
+                                       const utymap::heightmap::ElevationProvider& eleProvider,
+                                       MeshCallback meshFunc,
+                                       ElementCallback elementFunc,
+                                       InstancesCallback instancesFunc = nullptr);
+
+    /// Creates job which builds tile for given quadkey in steps. Found elements are copied, so
+    /// it uses more memory than build.
+    std::unique_ptr<Job> createJob(const utymap::QuadKey& quadKey,
+                                   const utymap::mapcss::StyleProvider& styleProvider,
+                                   const utymap::heightmap::ElevationProvider& eleProvider,
+                                   MeshCallback meshFunc,
+                                   ElementCallback elementFunc,
+                                   InstancesCallback instancesFunc = nullptr);
 
 private:
     class QuadKeyBuilderImpl;
@@ -1,3 +1,4 @@
+#include "Exceptions.hpp"
 #include "GeoCoordinate.hpp"
 #include "builders/MeshContext.hpp"
 #include "entities/Node.hpp"
@@ -5,6 +6,7 @@
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
 #include "builders/buildings/BuildingBuilder.hpp"
+#include "builders/buildings/SharedWallDetector.hpp"
 #include "builders/buildings/facades/CylinderFacadeBuilder.hpp"
 #include "builders/buildings/facades/FlatFacadeBuilder.hpp"
 #include "builders/buildings/facades/SphereFacadeBuilder.hpp"
@@ -12,10 +14,20 @@
 #include "builders/buildings/roofs/FlatRoofBuilder.hpp"
 #include "builders/buildings/roofs/PyramidalRoofBuilder.hpp"
 #include "builders/buildings/roofs/MansardRoofBuilder.hpp"
+#include "builders/buildings/roofs/SkeletonRoofBuilder.hpp"
+#include "meshing/MeshFaceMerger.hpp"
+#include "meshing/MeshPool.hpp"
 #include "utils/CoreUtils.hpp"
 #include "utils/ElementUtils.hpp"
+#include "utils/GeometryUtils.hpp"
+#include "utils/GeoUtils.hpp"
 #include "utils/GradientUtils.hpp"
+#include "utils/TaskScheduler.hpp"
 
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <memory>
 #include <unordered_map>
 
 using namespace utymap;
@@ -34,80 +46,87 @@ namespace {
 
     const std::string FacadeTypeKey = "facade-type";
     const std::string FacadeColorKey = "facade-color";
+    const std::string FacadeTextureAtlasKey = "facade-texture-atlas";
+    const std::string FacadeTextureMaterialKey = "facade-texture-material";
+    /// Size of facade texture region in meters.
+    const std::string FacadeTextureScaleKey = "facade-texture-scale";
 
     const std::string HeightKey = "height";
     const std::string MinHeightKey = "min-height";
 
-    const std::string MeshNamePrefix = "building:";
+    const std::string BuildingKey = "building";
+    const std::string MultipolygonKey = "multipolygon";
 
-    /// Defines roof builder which does nothing.
-    class EmptyRoofBuilder : public RoofBuilder {
-    public:
-        EmptyRoofBuilder(const BuilderContext& bc, MeshContext& mc)
-            : RoofBuilder(bc, mc) { }
-        void build(utymap::meshing::Polygon&) override {}
+    const std::string MeshNamePrefix = "building:";
+    const std::string BatchMeshNamePrefix = "buildings:";
+
+    const std::string MeshBatchKey = "mesh-batch";
+    const std::string MeshBatchSizeKey = "mesh-batch-size";
+    const std::string BuildingTasksKey = "building-tasks";
+    /// Default max amount of vertices in batch: fits 16 bit indices.
+    const double DefaultBatchSize = 65000;
+
+    /// Footprint simplification tolerance in tile pixels.
+    const std::string FootprintToleranceKey = "footprint-tolerance";
+    /// Level of detail below which all roofs are flat.
+    const std::string FlatRoofLodKey = "flat-roof-lod";
+    /// Footprint bounding box area in square tile pixels below which building is built as block.
+    const std::string BlockAreaKey = "block-area";
+    /// Merges coplanar faces of the same color of building before it is reported.
+    const std::string MergeFacesKey = "merge-faces";
+    /// Batch of blocks of buildings which do not specify their own batch.
+    const std::string BlockBatchName = "blocks";
+    const double TileSize = 256;
+
+    enum class RoofType { None, Flat, Dome, Pyramidal, Mansard, Hipped, Gabled };
+
+    enum class FacadeType { Flat, Cylinder, Sphere };
+
+    const std::unordered_map<std::string, RoofType> RoofTypes =
+    {
+        { "none", RoofType::None },
+        { "flat", RoofType::Flat },
+        { "dome", RoofType::Dome },
+        { "pyramidal", RoofType::Pyramidal },
+        { "mansard", RoofType::Mansard },
+        { "hipped", RoofType::Hipped },
+        { "gabled", RoofType::Gabled }
     };
 
-    typedef std::function<std::unique_ptr<RoofBuilder>(const BuilderContext&, MeshContext&)> RoofBuilderFactory;
-    std::unordered_map<std::string, RoofBuilderFactory> RoofBuilderFactoryMap =
+    const std::unordered_map<std::string, FacadeType> FacadeTypes =
     {
-        {
-            "none",
-            [](const BuilderContext& builderContext, MeshContext& meshContext) {
-                return utymap::utils::make_unique<EmptyRoofBuilder>(builderContext, meshContext);
-            }
-        },
-        {
-            "flat",
-            [](const BuilderContext& builderContext, MeshContext& meshContext) {
-                return utymap::utils::make_unique<FlatRoofBuilder>(builderContext, meshContext);
-            }
-        },
-        {
-            "dome",
-            [](const BuilderContext& builderContext, MeshContext& meshContext) {
-                return utymap::utils::make_unique<DomeRoofBuilder>(builderContext, meshContext);
-            }
-        },
-        {
-            "pyramidal",
-            [](const BuilderContext& builderContext, MeshContext& meshContext) {
-                return utymap::utils::make_unique<PyramidalRoofBuilder>(builderContext, meshContext);
-            }
-        },
-        {
-            "mansard",
-            [](const BuilderContext& builderContext, MeshContext& meshContext) {
-                return utymap::utils::make_unique<MansardRoofBuilder>(builderContext, meshContext);
-            }
-        }
+        { "flat", FacadeType::Flat },
+        { "cylinder", FacadeType::Cylinder },
+        { "sphere", FacadeType::Sphere }
     };
 
-    typedef std::function<std::unique_ptr<FacadeBuilder>(const BuilderContext&, MeshContext&)> FacadeBuilderFactory;
-    std::unordered_map<std::string, FacadeBuilderFactory> FacadeBuilderFactoryMap =
+    /// Resolves type from style value. Types of not evaluated declarations are cached by
+    /// declaration, so type name is looked up once per distinct style value.
+    template <typename Type>
+    Type resolveType(const Style& style,
+                     std::uint32_t keyId,
+                     const std::unordered_map<std::string, Type>& types,
+                     std::unordered_map<const StyleDeclaration*, Type>& cache)
     {
-        {
-            "flat",
-            [](const BuilderContext& builderContext, MeshContext& meshContext) {
-                return utymap::utils::make_unique<FlatFacadeBuilder>(builderContext, meshContext);
-            }
-        },
-        {
-            "cylinder",
-            [](const BuilderContext& builderContext, MeshContext& meshContext) {
-                return utymap::utils::make_unique<CylinderFacadeBuilder>(builderContext, meshContext);
-            }
-        },
-        {
-            "sphere",
-            [](const BuilderContext& builderContext, MeshContext& meshContext) {
-                return utymap::utils::make_unique<SphereFacadeBuilder>(builderContext, meshContext);
-            }
+        const StyleDeclaration* declaration = style.has(keyId) ? &style.get(keyId) : nullptr;
+        if (declaration != nullptr && !declaration->isEval()) {
+            auto cached = cache.find(declaration);
+            if (cached != cache.end())
+                return cached->second;
         }
-    };
 
-    /// Creates points for polygon
-    std::vector<Vector2> toPoints(const std::vector<GeoCoordinate>& coordinates)
+        std::string name = style.getString(keyId);
+        auto type = types.find(name);
+        if (type == types.end())
+            throw MapCssException("Unknown building part type: " + name);
+
+        if (declaration != nullptr && !declaration->isEval())
+            cache.emplace(declaration, type->second);
+        return type->second;
+    }
+
+    /// Creates points for polygon simplifying them with given tolerance.
+    std::vector<Vector2> toPoints(const std::vector<GeoCoordinate>& coordinates, double tolerance)
     {
         std::vector<Vector2> points;
         points.reserve(coordinates.size());
@@ -115,7 +134,9 @@ namespace {
             points.push_back(Vector2(coordinate.longitude, coordinate.latitude));
         }
 
-        return std::move(points);
+        return tolerance > 0
+            ? utymap::utils::simplifyContour(points, tolerance)
+            : points;
     }
 
     /// NOTE this method exists due to special processing of all buildings parts of the
@@ -135,8 +156,8 @@ namespace {
     {
     public:
 
-        explicit MultiPolygonVisitor(Polygon& polygon) :
-                polygon_(polygon)
+        MultiPolygonVisitor(Polygon& polygon, double tolerance) :
+                polygon_(polygon), tolerance_(tolerance)
         {
         }
 
@@ -149,9 +170,9 @@ namespace {
         void visitArea(const utymap::entities::Area& area) override
         {
             if (!utymap::utils::isClockwise(area.coordinates))
-                polygon_.addContour(toPoints(area.coordinates));
+                polygon_.addContour(toPoints(area.coordinates, tolerance_));
             else
-                polygon_.addHole(toPoints(area.coordinates));
+                polygon_.addHole(toPoints(area.coordinates, tolerance_));
         }
 
     private:
@@ -160,6 +181,7 @@ namespace {
             throw std::domain_error("Unexpected element in multipolygon: " + utymap::utils::toString(element.id));
         }
         Polygon& polygon_;
+        double tolerance_;
     };
 }
 
@@ -169,7 +191,28 @@ class BuildingBuilder::BuildingBuilderImpl : public ElementBuilder
 {
 public:
     explicit BuildingBuilderImpl(const utymap::builders::BuilderContext& context) :
-        ElementBuilder(context)
+        ElementBuilder(context),
+        roofTypeKeyId_(context.stringTable.getId(RoofTypeKey)),
+        roofHeightKeyId_(context.stringTable.getId(RoofHeightKey)),
+        roofColorKeyId_(context.stringTable.getId(RoofColorKey)),
+        facadeTypeKeyId_(context.stringTable.getId(FacadeTypeKey)),
+        facadeColorKeyId_(context.stringTable.getId(FacadeColorKey)),
+        facadeTextureAtlasKeyId_(context.stringTable.getId(FacadeTextureAtlasKey)),
+        facadeTextureMaterialKeyId_(context.stringTable.getId(FacadeTextureMaterialKey)),
+        facadeTextureScaleKeyId_(context.stringTable.getId(FacadeTextureScaleKey)),
+        heightKeyId_(context.stringTable.getId(HeightKey)),
+        minHeightKeyId_(context.stringTable.getId(MinHeightKey)),
+        buildingKeyId_(context.stringTable.getId(BuildingKey)),
+        multipolygonKeyId_(context.stringTable.getId(MultipolygonKey)),
+        meshBatchKeyId_(context.stringTable.getId(MeshBatchKey)),
+        meshBatchSizeKeyId_(context.stringTable.getId(MeshBatchSizeKey)),
+        footprintToleranceKeyId_(context.stringTable.getId(FootprintToleranceKey)),
+        flatRoofLodKeyId_(context.stringTable.getId(FlatRoofLodKey)),
+        blockAreaKeyId_(context.stringTable.getId(BlockAreaKey)),
+        mergeFacesKeyId_(context.stringTable.getId(MergeFacesKey)),
+        pixelSize_(getPixelSize(context.quadKey)),
+        maxTasks_(static_cast<std::size_t>(std::max(context.styleProvider
+            .forCanvas(context.quadKey.levelOfDetail).getValue(BuildingTasksKey), 0.)))
     {
     }
 
@@ -179,17 +222,17 @@ public:
 
     void visitArea(const utymap::entities::Area& area) override
     {
-        Style style = context_.styleProvider.forElement(area, context_.quadKey.levelOfDetail);
+        Style style = getStyle(area);
 
         // NOTE this might happen if relation contains not a building
         if (!isBuilding(style))
             return;
 
         bool justCreated = ensureContext(area);
-        polygon_->addContour(toPoints(area.coordinates));
+        polygon_->addContour(toPoints(area.coordinates, getTolerance(style)));
         build(area, style);
 
-        completeIfNecessary(justCreated);
+        completeIfNecessary(justCreated, style);
     }
 
     void visitRelation(const utymap::entities::Relation& relation) override
@@ -199,10 +242,10 @@ public:
 
         bool justCreated = ensureContext(relation);
 
-        Style style = context_.styleProvider.forElement(relation, context_.quadKey.levelOfDetail);
+        Style style = getStyle(relation);
 
         if (isMultipolygon(style) && isBuilding(style)) {
-            MultiPolygonVisitor visitor(*polygon_);
+            MultiPolygonVisitor visitor(*polygon_, getTolerance(style));
 
             for (const auto& element : relation.elements)
                 element->accept(visitor);
@@ -214,115 +257,417 @@ public:
                 element->accept(*this);
         }
 
-        completeIfNecessary(justCreated);
+        completeIfNecessary(justCreated, style);
     }
 
+    bool hasElementMeshes() const override { return batches_.empty(); }
+
     void complete() override
     {
+        completeTasks();
+        for (auto& batch : batches_)
+            flushBatch(batch.second);
+        batches_.clear();
     }
 
 private:
 
+    /// Geometry parameters of single building part resolved from style.
+    struct Part final
+    {
+        std::unique_ptr<Polygon> polygon;
+        /// NOTE style is only referenced by mesh contexts: it is not read by part builders.
+        std::shared_ptr<const Style> style;
+        const ColorGradient* roofGradient;
+        const ColorGradient* facadeGradient;
+        /// Facade texture: windows and floors are drawn by texture instead of geometry.
+        TextureRegion facadeTexture;
+        double facadeTextureScale;
+        RoofType roofType;
+        FacadeType facadeType;
+        double roofHeight;
+        double elevation;
+        double height;
+        bool hasFloors;
+    };
+
+    /// Merged geometry of buildings which share the same batch name.
+    struct Batch final
+    {
+        std::string name;
+        std::size_t maxVertices;
+        /// Amount of already reported meshes.
+        std::size_t count;
+        MeshPool::MeshPtr mesh;
+    };
+
+    /// Building which geometry can be generated on any thread.
+    struct Task final
+    {
+        MeshPool::MeshPtr mesh;
+        std::vector<Part> parts;
+        std::uint64_t id;
+        /// Batch of building or null if building has its own mesh.
+        Batch* batch;
+        /// True if building is too small and is built as block.
+        bool isBlock;
+        /// True if coplanar faces are merged after geometry is generated.
+        bool mergeFaces;
+        /// Group which generates geometry on scheduler or null if it is generated immediately.
+        std::unique_ptr<utymap::utils::TaskGroup> group;
+    };
+    typedef std::unique_ptr<Task> TaskPtr;
+
     bool ensureContext(const Element& element)
     {
         if (polygon_ == nullptr)
             polygon_ = utymap::utils::make_unique<Polygon>(1, 0);
 
-        if (mesh_ == nullptr) {
-            mesh_ = utymap::utils::make_unique<Mesh>(utymap::utils::getMeshName(MeshNamePrefix, element));
+        if (task_ == nullptr) {
+            task_ = utymap::utils::make_unique<Task>();
+            task_->mesh = MeshPool::local().acquire(utymap::utils::getMeshName(MeshNamePrefix, element));
+            task_->id = element.id;
+            task_->batch = nullptr;
+            task_->isBlock = false;
+            task_->mergeFaces = false;
             return true;
         }
 
         return false;
     }
 
-    void completeIfNecessary(bool justCreated)
+    void completeIfNecessary(bool justCreated, const Style& style)
+    {
+        if (!justCreated)
+            return;
+
+        std::string batchName = style.getString(meshBatchKeyId_);
+        if (batchName.empty() && task_->isBlock)
+            batchName = BlockBatchName;
+        if (!batchName.empty())
+            task_->batch = &getBatch(batchName, style);
+
+        scheduleTask(std::move(task_));
+    }
+
+    /// Generates building immediately or schedules it if there are building tasks.
+    void scheduleTask(TaskPtr task)
     {
-        if (justCreated) {
-            context_.meshCallback(*mesh_);
-            mesh_.reset();
+        if (maxTasks_ == 0) {
+            buildParts(*task);
+            completeTask(*task);
+            return;
         }
+
+        if (tasks_.size() >= maxTasks_) {
+            completeTask(*tasks_.front());
+            tasks_.pop_front();
+        }
+
+        Task& taskRef = *task;
+        task->group = utymap::utils::make_unique<utymap::utils::TaskGroup>();
+        task->group->run([this, &taskRef]() { buildParts(taskRef); });
+        tasks_.push_back(std::move(task));
     }
 
-    static bool isBuilding(const Style& style)
+    /// Waits for building geometry and reports it. Called in order of scheduling.
+    void completeTask(Task& task)
     {
-        return style.getString("building") == "true";
+        if (task.group != nullptr)
+            task.group->wait();
+
+        if (task.batch == nullptr)
+            context_.meshCallback(*task.mesh);
+        else
+            addToBatch(*task.batch, task.id, *task.mesh);
     }
 
-    static bool isMultipolygon(const Style& style)
+    void completeTasks()
     {
-        return style.getString("multipolygon") == "true";
+        for (const auto& task : tasks_)
+            completeTask(*task);
+        tasks_.clear();
     }
 
+    Batch& getBatch(const std::string& name, const Style& style)
+    {
+        auto batch = batches_.find(name);
+        if (batch != batches_.end())
+            return batch->second;
+
+        double maxVertices = style.getValue(meshBatchSizeKeyId_);
+        return batches_.emplace(name, Batch{ name,
+            static_cast<std::size_t>(maxVertices > 0 ? maxVertices : DefaultBatchSize), 0, nullptr }).first->second;
+    }
+
+    /// Appends building mesh to batch reporting batch mesh first if it would exceed vertex limit.
+    void addToBatch(Batch& batch, std::uint64_t id, const Mesh& mesh)
+    {
+        if (batch.mesh != nullptr &&
+            (batch.mesh->vertices.size() + mesh.vertices.size()) / 3 > batch.maxVertices)
+            flushBatch(batch);
+
+        if (batch.mesh == nullptr)
+            batch.mesh = MeshPool::local().acquire(BatchMeshNamePrefix + batch.name + ":" + std::to_string(batch.count));
+
+        Mesh& destination = *batch.mesh;
+        int startIndex = static_cast<int>(destination.vertices.size() / 3);
+        destination.elementRanges.insert(destination.elementRanges.end(), {
+            id, destination.triangles.size() / 3, mesh.triangles.size() / 3 });
+
+        destination.vertices.insert(destination.vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+        destination.colors.insert(destination.colors.end(), mesh.colors.begin(), mesh.colors.end());
+        destination.uvs.insert(destination.uvs.end(), mesh.uvs.begin(), mesh.uvs.end());
+        destination.triangles.reserve(destination.triangles.size() + mesh.triangles.size());
+        for (int index : mesh.triangles)
+            destination.triangles.push_back(index + startIndex);
+    }
+
+    void flushBatch(Batch& batch)
+    {
+        if (batch.mesh == nullptr)
+            return;
+
+        context_.meshCallback(*batch.mesh);
+        batch.mesh.reset();
+        ++batch.count;
+    }
+
+    /// Returns footprint simplification tolerance in degrees.
+    double getTolerance(const Style& style) const
+    {
+        return style.getValue(footprintToleranceKeyId_) * pixelSize_;
+    }
+
+    /// Returns width of tile pixel in degrees.
+    static double getPixelSize(const QuadKey& quadKey)
+    {
+        auto bbox = GeoUtils::quadKeyToBoundingBox(quadKey);
+        return (bbox.maxPoint.longitude - bbox.minPoint.longitude) / TileSize;
+    }
+
+    bool isBuilding(const Style& style) const
+    {
+        return style.getString(buildingKeyId_) == "true";
+    }
+
+    bool isMultipolygon(const Style& style) const
+    {
+        return style.getString(multipolygonKeyId_) == "true";
+    }
+
+    /// Resolves style of building part: geometry is generated later by buildParts.
     void build(const Element& element, const Style& style)
     {
         auto geoCoordinate = GeoCoordinate(polygon_->points[1], polygon_->points[0]);
 
-        double height = style.getValue(HeightKey);
+        double height = style.getValue(heightKeyId_);
         // NOTE do not allow height to be zero. This might happen due to the issues in input osm data.
         if (height == 0)
             height = 10;
 
-        double minHeight = style.getValue(MinHeightKey);
+        double minHeight = style.getValue(minHeightKeyId_);
 
         double elevation = context_.eleProvider.getElevation(geoCoordinate) + minHeight;
 
         height -= minHeight;
 
-        attachRoof(*mesh_, style, elevation, height);
-
+        // NOTE tiny buildings are replaced by prisms of their bounding boxes and merged.
+        double blockArea = style.getValue(blockAreaKeyId_) * pixelSize_ * pixelSize_;
+        bool isBlock = blockArea > 0 && polygon_->rectangle.width() * polygon_->rectangle.height() < blockArea;
+        if (isBlock) {
+            const auto rectangle = polygon_->rectangle;
+            polygon_ = utymap::utils::make_unique<Polygon>(4, 0);
+            polygon_->addContour({ { rectangle.xMin, rectangle.yMin }, { rectangle.xMax, rectangle.yMin },
+                                   { rectangle.xMax, rectangle.yMax }, { rectangle.xMin, rectangle.yMax } });
+            task_->isBlock = true;
+        }
+        bool isFlat = isBlock || context_.quadKey.levelOfDetail < style.getValue(flatRoofLodKeyId_);
+
+        Part part;
+        part.polygon = std::move(polygon_);
+        part.style = std::make_shared<const Style>(style);
+        part.roofGradient = &GradientUtils::evaluateGradient(context_.styleProvider, style, roofColorKeyId_);
+        part.facadeGradient = &GradientUtils::evaluateGradient(context_.styleProvider, style, facadeColorKeyId_);
+        part.facadeTexture = context_.styleProvider
+            .getTexture(style.getString(facadeTextureAtlasKeyId_), style.getString(facadeTextureMaterialKeyId_))
+            .random(static_cast<std::uint32_t>(element.id));
+        part.facadeTextureScale = style.getValue(facadeTextureScaleKeyId_);
+        part.roofType = isFlat ? RoofType::Flat : resolveType(style, roofTypeKeyId_, RoofTypes, roofTypes_);
+        part.facadeType = isBlock ? FacadeType::Flat : resolveType(style, facadeTypeKeyId_, FacadeTypes, facadeTypes_);
+        part.roofHeight = style.getValue(roofHeightKeyId_);
+        part.elevation = elevation;
+        part.height = height;
         // NOTE so far, attach floors only for buildings with minHeight
-        if (minHeight > 0)
-            attachFloors(*mesh_, style, elevation, height);
+        part.hasFloors = minHeight > 0 && !isBlock;
+        task_->parts.push_back(std::move(part));
+        task_->mergeFaces = task_->mergeFaces || style.has(mergeFacesKeyId_, "true");
+    }
+
+    /// Generates geometry of all building parts. Can be called from any thread.
+    void buildParts(Task& task) const
+    {
+        // NOTE walls shared by parts or by parts and outline are hidden.
+        SharedWallDetector wallDetector;
+        if (task.parts.size() > 1)
+            for (const auto& part : task.parts)
+                wallDetector.add(*part.polygon, part.elevation, part.elevation + part.height);
+        const auto& hiddenWalls = wallDetector.detect();
 
-        attachFacade(*mesh_, style, elevation, height);
+        for (std::size_t i = 0; i < task.parts.size(); ++i) {
+            const auto& part = task.parts[i];
+            attachRoof(*task.mesh, part);
+
+            if (part.hasFloors)
+                attachFloors(*task.mesh, part);
+
+            attachFacade(*task.mesh, part, hiddenWalls.empty() ? nullptr : &hiddenWalls[i]);
+        }
+        task.parts.clear();
 
-        polygon_.reset();
+        if (task.mergeFaces)
+            mergeFaces(*task.mesh);
     }
 
-    void attachRoof(Mesh& mesh, const Style& style, double elevation, double height) const
+    /// Replaces geometry of building mesh with merged one.
+    static void mergeFaces(Mesh& mesh)
     {
-        const auto& gradient = GradientUtils::evaluateGradient(context_.styleProvider, style, RoofColorKey);
-        MeshContext roofMeshContext(mesh, style, gradient, utymap::mapcss::TextureRegion());
+        Mesh merged(mesh.name);
+        MeshFaceMerger().merge(mesh, merged);
+        mesh.vertices.swap(merged.vertices);
+        mesh.triangles.swap(merged.triangles);
+        mesh.colors.swap(merged.colors);
+        mesh.uvs.swap(merged.uvs);
+        mesh.vertexIndex.clear();
+    }
 
-        auto roofType = roofMeshContext.style.getString(RoofTypeKey);
-        double roofHeight = roofMeshContext.style.getValue(RoofHeightKey);
+    /// NOTE builders are cheap to create on stack: they only keep references and parameters.
+    void attachRoof(Mesh& mesh, const Part& part) const
+    {
+        MeshContext roofMeshContext(mesh, *part.style, *part.roofGradient, utymap::mapcss::TextureRegion());
+
+        switch (part.roofType) {
+            case RoofType::None:
+                break;
+            case RoofType::Flat: {
+                FlatRoofBuilder roofBuilder(context_, roofMeshContext);
+                attachRoof(roofBuilder, part);
+                break;
+            }
+            case RoofType::Dome: {
+                DomeRoofBuilder roofBuilder(context_, roofMeshContext);
+                attachRoof(roofBuilder, part);
+                break;
+            }
+            case RoofType::Pyramidal: {
+                PyramidalRoofBuilder roofBuilder(context_, roofMeshContext);
+                attachRoof(roofBuilder, part);
+                break;
+            }
+            case RoofType::Mansard: {
+                MansardRoofBuilder roofBuilder(context_, roofMeshContext);
+                attachRoof(roofBuilder, part);
+                break;
+            }
+            case RoofType::Hipped: {
+                SkeletonRoofBuilder roofBuilder(context_, roofMeshContext, SkeletonRoofBuilder::Form::Hipped);
+                attachRoof(roofBuilder, part);
+                break;
+            }
+            case RoofType::Gabled: {
+                SkeletonRoofBuilder roofBuilder(context_, roofMeshContext, SkeletonRoofBuilder::Form::Gabled);
+                attachRoof(roofBuilder, part);
+                break;
+            }
+        }
+    }
 
-        auto roofBuilder = RoofBuilderFactoryMap.find(roofType)->second(context_, roofMeshContext);
-        roofBuilder->setHeight(roofHeight);
-        roofBuilder->setMinHeight(elevation + height);
-        roofBuilder->setColorNoiseFreq(0);
-        roofBuilder->build(*polygon_);
+    void attachRoof(RoofBuilder& roofBuilder, const Part& part) const
+    {
+        roofBuilder.setHeight(part.roofHeight);
+        roofBuilder.setMinHeight(part.elevation + part.height);
+        roofBuilder.setColorNoiseFreq(0);
+        roofBuilder.build(*part.polygon);
     }
 
-    void attachFloors(Mesh& mesh, const Style& style, double elevation, double height) const
+    void attachFloors(Mesh& mesh, const Part& part) const
     {
-        const auto& gradient = GradientUtils::evaluateGradient(context_.styleProvider, style, RoofColorKey);
-        MeshContext floorMeshContext(mesh, style, gradient, utymap::mapcss::TextureRegion());
+        MeshContext floorMeshContext(mesh, *part.style, *part.roofGradient, utymap::mapcss::TextureRegion());
 
         FlatRoofBuilder floorBuilder(context_, floorMeshContext);
-        floorBuilder.setMinHeight(elevation);
+        floorBuilder.setMinHeight(part.elevation);
         floorBuilder.setColorNoiseFreq(0);
         floorBuilder.flipSide();
-        floorBuilder.build(*polygon_);
+        floorBuilder.build(*part.polygon);
     }
 
-    void attachFacade(Mesh& mesh, const Style& style, double elevation, double height) const
+    void attachFacade(Mesh& mesh, const Part& part, const std::vector<bool>* hiddenWalls) const
     {
-        const auto& gradient = GradientUtils::evaluateGradient(context_.styleProvider, style, FacadeColorKey);
-        MeshContext facadeMeshContext(mesh, style, gradient, utymap::mapcss::TextureRegion());
-
-        auto facadeType = facadeMeshContext.style.getString(FacadeTypeKey);
-        auto facadeBuilder = FacadeBuilderFactoryMap.find(facadeType)->second(context_, facadeMeshContext);
+        MeshContext facadeMeshContext(mesh, *part.style, *part.facadeGradient, part.facadeTexture);
+        facadeMeshContext.appearanceOptions.textureScale = part.facadeTextureScale;
+
+        switch (part.facadeType) {
+            case FacadeType::Flat: {
+                FlatFacadeBuilder facadeBuilder(context_, facadeMeshContext);
+                if (hiddenWalls != nullptr)
+                    facadeBuilder.setHiddenWalls(*hiddenWalls);
+                attachFacade(facadeBuilder, part);
+                break;
+            }
+            case FacadeType::Cylinder: {
+                CylinderFacadeBuilder facadeBuilder(context_, facadeMeshContext);
+                attachFacade(facadeBuilder, part);
+                break;
+            }
+            case FacadeType::Sphere: {
+                SphereFacadeBuilder facadeBuilder(context_, facadeMeshContext);
+                attachFacade(facadeBuilder, part);
+                break;
+            }
+        }
+    }
 
-        facadeBuilder->setHeight(height);
-        facadeBuilder->setMinHeight(elevation);
-        facadeBuilder->setColorNoiseFreq(0);
-        facadeBuilder->build(*polygon_);
+    void attachFacade(FacadeBuilder& facadeBuilder, const Part& part) const
+    {
+        facadeBuilder.setHeight(part.height);
+        facadeBuilder.setMinHeight(part.elevation);
+        facadeBuilder.setColorNoiseFreq(0);
+        facadeBuilder.build(*part.polygon);
     }
 
+    std::uint32_t roofTypeKeyId_;
+    std::uint32_t roofHeightKeyId_;
+    std::uint32_t roofColorKeyId_;
+    std::uint32_t facadeTypeKeyId_;
+    std::uint32_t facadeColorKeyId_;
+    std::uint32_t facadeTextureAtlasKeyId_;
+    std::uint32_t facadeTextureMaterialKeyId_;
+    std::uint32_t facadeTextureScaleKeyId_;
+    std::uint32_t heightKeyId_;
+    std::uint32_t minHeightKeyId_;
+    std::uint32_t buildingKeyId_;
+    std::uint32_t multipolygonKeyId_;
+    std::uint32_t meshBatchKeyId_;
+    std::uint32_t meshBatchSizeKeyId_;
+    std::uint32_t footprintToleranceKeyId_;
+    std::uint32_t flatRoofLodKeyId_;
+    std::uint32_t blockAreaKeyId_;
+    std::uint32_t mergeFacesKeyId_;
+    /// Width of tile pixel in degrees: level of detail tolerances are given in pixels.
+    double pixelSize_;
+
+    /// Resolved types of style declarations.
+    std::unordered_map<const StyleDeclaration*, RoofType> roofTypes_;
+    std::unordered_map<const StyleDeclaration*, FacadeType> facadeTypes_;
+
     std::unique_ptr<Polygon> polygon_;
-    std::unique_ptr<Mesh> mesh_;
+    /// Building which is being visited.
+    TaskPtr task_;
+    /// Max amount of buildings generated at the same time: zero means no parallel generation.
+    std::size_t maxTasks_;
+    std::deque<TaskPtr> tasks_;
+    /// Key: batch name. Ordered, so batches are reported in the same order.
+    std::map<std::string, Batch> batches_;
 };
 
 BuildingBuilder::BuildingBuilder(const BuilderContext& context)
@@ -343,6 +688,16 @@ void BuildingBuilder::complete()
     pimpl_->complete();
 }
 
+bool BuildingBuilder::hasElementMeshes() const
+{
+    return pimpl_->hasElementMeshes();
+}
+
+void BuildingBuilder::prepareStyle(const utymap::entities::Element& element, const Style& style)
+{
+    pimpl_->prepareStyle(element, style);
+}
+
 void BuildingBuilder::visitRelation(const utymap::entities::Relation& relation)
 {
     if (!shouldBeIgnored(relation))
@@ -8,7 +8,12 @@
 
 namespace utymap { namespace builders {
 
-/// Responsible for building generation.
+/// Responsible for building generation. Buildings which have "mesh-batch" in style are
+/// merged into meshes shared by all buildings with the same batch name. Mesh is reported
+/// once it reaches "mesh-batch-size" vertices or when builder is completed; element ranges
+/// of the mesh tell which triangles belong to which building.
+/// If "building-tasks" is specified in canvas style, geometry of that many buildings is
+/// generated in parallel, but meshes are reported in order of visiting.
 class BuildingBuilder final: public utymap::builders::ElementBuilder
 {
 public:
@@ -26,6 +31,11 @@ public:
 
     void complete() override;
 
+    /// Buildings which use mesh batches share meshes.
+    bool hasElementMeshes() const override;
+
+    void prepareStyle(const utymap::entities::Element&, const utymap::mapcss::Style&) override;
+
 private:
     class BuildingBuilderImpl;
     std::unique_ptr<BuildingBuilderImpl> pimpl_;
@@ -0,0 +1,98 @@
+#ifndef BUILDERS_BUILDINGS_SHAREDWALLDETECTOR_HPP_DEFINED
+#define BUILDERS_BUILDINGS_SHAREDWALLDETECTOR_HPP_DEFINED
+
+#include "meshing/Polygon.hpp"
+
+#include <array>
+#include <map>
+#include <vector>
+
+namespace utymap { namespace builders {
+
+/// Detects facade walls of building parts which cannot be seen: walls between adjacent
+/// parts and walls duplicated by other part or building outline. Wall is hidden only if
+/// other wall covers its whole height. Walls are matched by exact coordinates of their
+/// points as parts of the same building share nodes.
+class SharedWallDetector final
+{
+    /// Wall points ordered so that part is on the left side.
+    typedef std::array<double, 4> Segment;
+
+    struct Wall
+    {
+        std::size_t part;
+        std::size_t point;
+        double minHeight;
+        double maxHeight;
+    };
+
+public:
+    /// Adds footprint of part with its vertical range.
+    void add(const utymap::meshing::Polygon& polygon, double minHeight, double maxHeight)
+    {
+        std::size_t part = hidden_.size();
+        hidden_.push_back(std::vector<bool>(polygon.points.size() / 2, false));
+        for (const auto& range : polygon.outers)
+            addRange(polygon, range, true, Wall { part, 0, minHeight, maxHeight });
+        for (const auto& range : polygon.inners)
+            addRange(polygon, range, false, Wall { part, 0, minHeight, maxHeight });
+    }
+
+    /// Returns flags of hidden walls for every added part. Wall between point and next point
+    /// of its contour has index of the point.
+    const std::vector<std::vector<bool>>& detect()
+    {
+        for (const auto& entry : walls_) {
+            const Segment& segment = entry.first;
+            auto opposite = walls_.find(Segment {{ segment[2], segment[3], segment[0], segment[1] }});
+            for (const auto& wall : entry.second) {
+                bool isHidden = false;
+                // wall between adjacent parts.
+                if (opposite != walls_.end())
+                    for (const auto& other : opposite->second)
+                        isHidden |= other.part != wall.part && covers(other, wall);
+                // the same wall of other part: keep the highest or the first one.
+                for (const auto& other : entry.second)
+                    isHidden |= other.part != wall.part && covers(other, wall) &&
+                        (!covers(wall, other) || other.part < wall.part);
+                if (isHidden)
+                    hidden_[wall.part][wall.point] = true;
+            }
+        }
+        return hidden_;
+    }
+
+private:
+    void addRange(const utymap::meshing::Polygon& polygon, const utymap::meshing::Polygon::Range& range,
+                  bool isOuter, Wall wall)
+    {
+        const auto& points = polygon.points;
+        double area = 0;
+        for (std::size_t i = range.first; i < range.second; i += 2) {
+            std::size_t next = i + 2 == range.second ? range.first : i + 2;
+            area += points[i] * points[next + 1] - points[next] * points[i + 1];
+        }
+        bool isLeft = (area > 0) == isOuter;
+
+        for (std::size_t i = range.first; i < range.second; i += 2) {
+            std::size_t next = i + 2 == range.second ? range.first : i + 2;
+            wall.point = i / 2;
+            Segment segment = isLeft
+                ? Segment {{ points[i], points[i + 1], points[next], points[next + 1] }}
+                : Segment {{ points[next], points[next + 1], points[i], points[i + 1] }};
+            walls_[segment].push_back(wall);
+        }
+    }
+
+    static bool covers(const Wall& wall, const Wall& other)
+    {
+        return wall.minHeight <= other.minHeight && wall.maxHeight >= other.maxHeight;
+    }
+
+    std::map<Segment, std::vector<Wall>> walls_;
+    std::vector<std::vector<bool>> hidden_;
+};
+
+}}
+
+#endif // BUILDERS_BUILDINGS_SHAREDWALLDETECTOR_HPP_DEFINED
@@ -4,6 +4,8 @@
 #include "builders/buildings/facades/FacadeBuilder.hpp"
 #include "meshing/MeshBuilder.hpp"
 
+#include <vector>
+
 namespace utymap { namespace builders {
 
 /// Responsible for building facade wall in low poly quality.
@@ -12,8 +14,16 @@ class FlatFacadeBuilder : public FacadeBuilder
 public:
     FlatFacadeBuilder(const utymap::builders::BuilderContext& builderContext,
                       utymap::builders::MeshContext& meshContext) : 
-        FacadeBuilder(builderContext, meshContext)
+        FacadeBuilder(builderContext, meshContext), hiddenWalls_(nullptr)
+    {
+    }
+
+    /// Sets flags of walls which should not be built: wall between point and next point
+    /// has index of the point.
+    FlatFacadeBuilder& setHiddenWalls(const std::vector<bool>& hiddenWalls)
     {
+        hiddenWalls_ = &hiddenWalls;
+        return *this;
     }
 
   void build(utymap::meshing::Polygon& polygon) override
@@ -36,8 +46,11 @@ private:
         std::int64_t first = static_cast<std::int64_t>(range.first);
         std::int64_t last = static_cast<std::int64_t>(range.second) - 2;
         for (auto  i = last; i >= first; i -= 2) {
-            utymap::meshing::Vector2 p1(polygon.points[i], polygon.points[i + 1]);
             auto j = i == first ? last : i - 2;
+            if (hiddenWalls_ != nullptr && (*hiddenWalls_)[static_cast<std::size_t>(j / 2)])
+                continue;
+
+            utymap::meshing::Vector2 p1(polygon.points[i], polygon.points[i + 1]);
             utymap::meshing::Vector2 p2(polygon.points[j], polygon.points[j + 1]);
 
             builderContext_.meshBuilder.addPlane(meshContext_.mesh,
@@ -49,6 +62,8 @@ private:
                 meshContext_.appearanceOptions);
         }
     }
+
+    const std::vector<bool>* hiddenWalls_;
 };
 
 }}
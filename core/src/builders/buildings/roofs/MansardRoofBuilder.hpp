@@ -1,7 +1,7 @@
 #ifndef BUILDERS_BUILDINGS_ROOFS_MANSARDROOFBUILDER_HPP_DEFINED
 #define BUILDERS_BUILDINGS_ROOFS_MANSARDROOFBUILDER_HPP_DEFINED
 
-#include "builders/buildings/roofs/FlatRoofBuilder.hpp"
+#include "builders/buildings/roofs/SkeletonRoofBuilder.hpp"
 #include "clipper/clipper.hpp"
 #include "meshing/MeshBuilder.hpp"
 #include "meshing/MeshTypes.hpp"
@@ -13,20 +13,24 @@
 
 namespace utymap { namespace builders {
 
-/// Builds mansard roof.
-class MansardRoofBuilder final : public FlatRoofBuilder
+/// Builds mansard roof from straight skeleton of footprint. Falls back to offsetting
+/// footprint by its minimal side if skeleton cannot be used.
+class MansardRoofBuilder final : public SkeletonRoofBuilder
 {
     const double Scale = 1E7;
 
 public:
     MansardRoofBuilder(const utymap::builders::BuilderContext& builderContext,
                        utymap::builders::MeshContext& meshContext)
-        : FlatRoofBuilder(builderContext, meshContext)
+        : SkeletonRoofBuilder(builderContext, meshContext, Form::Mansard)
     {
     }
 
     void build(utymap::meshing::Polygon& polygon) override
     {
+        if (buildSkeleton(polygon))
+            return;
+
         ClipperLib::ClipperOffset offset;
         ClipperLib::Path path;
         path.reserve(polygon.points.size() / 2);
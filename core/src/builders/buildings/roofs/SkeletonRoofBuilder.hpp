@@ -0,0 +1,214 @@
+#ifndef BUILDERS_BUILDINGS_ROOFS_SKELETONROOFBUILDER_HPP_DEFINED
+#define BUILDERS_BUILDINGS_ROOFS_SKELETONROOFBUILDER_HPP_DEFINED
+
+#include "builders/buildings/roofs/FlatRoofBuilder.hpp"
+#include "meshing/MeshBuilder.hpp"
+#include "meshing/MeshTypes.hpp"
+#include "meshing/Polygon.hpp"
+#include "meshing/StraightSkeleton.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace utymap { namespace builders {
+
+/// Builds roof from straight skeleton of footprint. Skeleton is computed once per footprint
+/// and every roof slope is its face lifted by distance of face nodes to footprint edge.
+/// Footprints with holes or many outers are built as flat roof.
+class SkeletonRoofBuilder : public FlatRoofBuilder
+{
+    /// Point of skeleton face in local metric coordinates.
+    struct RoofPoint
+    {
+        utymap::meshing::Vector2 position;
+        double time;
+    };
+
+    /// Part of skeleton time where lower slope of mansard roof ends.
+    const double MansardBreak = 0.2;
+
+public:
+    /// Shape of roof derived from skeleton.
+    enum class Form { Hipped, Gabled, Mansard };
+
+    SkeletonRoofBuilder(const utymap::builders::BuilderContext& builderContext,
+                        utymap::builders::MeshContext& meshContext,
+                        Form form = Form::Hipped)
+        : FlatRoofBuilder(builderContext, meshContext), form_(form),
+          longitude_(0), latitude_(0), scale_(1), breakTime_(0)
+    {
+    }
+
+    void build(utymap::meshing::Polygon& polygon) override
+    {
+        if (!buildSkeleton(polygon))
+            FlatRoofBuilder::build(polygon);
+    }
+
+protected:
+    /// Builds roof slopes from skeleton. Returns false if footprint is not supported.
+    bool buildSkeleton(const utymap::meshing::Polygon& polygon)
+    {
+        if (polygon.outers.size() != 1 || !polygon.inners.empty())
+            return false;
+
+        // NOTE longitude is scaled to have the same metric as latitude.
+        const auto& range = polygon.outers[0];
+        longitude_ = polygon.points[range.first];
+        latitude_ = polygon.points[range.first + 1];
+        scale_ = std::cos(latitude_ * std::acos(-1) / 180);
+
+        std::vector<utymap::meshing::Vector2> contour;
+        contour.reserve((range.second - range.first) / 2);
+        for (std::size_t i = range.first; i < range.second; i += 2)
+            contour.push_back(utymap::meshing::Vector2((polygon.points[i] - longitude_) * scale_,
+                                                       polygon.points[i + 1] - latitude_));
+
+        utymap::meshing::StraightSkeleton skeleton(contour);
+        if (!skeleton.isValid())
+            return false;
+
+        const auto& nodes = skeleton.getNodes();
+        const auto& faces = skeleton.getFaces();
+        breakTime_ = form_ == Form::Mansard
+            ? skeleton.getMaxTime() * MansardBreak
+            : skeleton.getMaxTime();
+
+        std::vector<utymap::meshing::Vector2> positions;
+        positions.reserve(nodes.size());
+        for (const auto& node : nodes)
+            positions.push_back(node.position);
+        if (form_ == Form::Gabled)
+            moveGableApexes(faces, positions);
+
+        meshContext_.geometryOptions.elevation = std::numeric_limits<double>::lowest();
+        meshContext_.geometryOptions.heightOffset = 0;
+
+        std::vector<RoofPoint> face, lower, upper;
+        for (const auto& indices : faces) {
+            face.clear();
+            for (std::size_t index : indices)
+                face.push_back(RoofPoint { positions[index], nodes[index].time });
+
+            if (form_ == Form::Mansard) {
+                splitFace(face, lower, upper);
+                addFace(lower);
+                addFace(upper);
+            }
+            else
+                addFace(face);
+        }
+        return true;
+    }
+
+private:
+    /// Moves apex of every triangular face to its edge, so the face becomes vertical gable.
+    void moveGableApexes(const std::vector<utymap::meshing::StraightSkeleton::Face>& faces,
+                         std::vector<utymap::meshing::Vector2>& positions) const
+    {
+        std::vector<bool> isMoved(positions.size(), false);
+        for (const auto& face : faces) {
+            if (face.size() != 3 || isMoved[face[2]])
+                continue;
+
+            const auto& start = positions[face[0]];
+            const auto& end = positions[face[1]];
+            auto& apex = positions[face[2]];
+            double dx = end.x - start.x, dy = end.y - start.y;
+            double ratio = ((apex.x - start.x) * dx + (apex.y - start.y) * dy) / (dx * dx + dy * dy);
+            apex = utymap::meshing::Vector2(start.x + dx * ratio, start.y + dy * ratio);
+            isMoved[face[2]] = true;
+        }
+    }
+
+    /// Splits face by break time of mansard roof into lower and upper parts.
+    void splitFace(const std::vector<RoofPoint>& face, std::vector<RoofPoint>& lower, std::vector<RoofPoint>& upper) const
+    {
+        lower.clear();
+        upper.clear();
+        for (std::size_t i = 0; i < face.size(); ++i) {
+            const auto& current = face[i];
+            const auto& next = face[(i + 1) % face.size()];
+            if (current.time <= breakTime_) lower.push_back(current);
+            if (current.time >= breakTime_) upper.push_back(current);
+
+            if ((current.time - breakTime_) * (next.time - breakTime_) < 0) {
+                double ratio = (breakTime_ - current.time) / (next.time - current.time);
+                RoofPoint point { utymap::meshing::Vector2(
+                    current.position.x + (next.position.x - current.position.x) * ratio,
+                    current.position.y + (next.position.y - current.position.y) * ratio), breakTime_ };
+                lower.push_back(point);
+                upper.push_back(point);
+            }
+        }
+    }
+
+    /// Triangulates counter clockwise face using ear clipping.
+    void addFace(const std::vector<RoofPoint>& face) const
+    {
+        if (face.size() < 3)
+            return;
+
+        std::vector<std::size_t> indices(face.size());
+        for (std::size_t i = 0; i < indices.size(); ++i)
+            indices[i] = i;
+
+        while (indices.size() > 3) {
+            std::size_t count = indices.size(), ear = count;
+            for (std::size_t i = 0; i < count && ear == count; ++i) {
+                const auto& a = face[indices[(i + count - 1) % count]].position;
+                const auto& b = face[indices[i]].position;
+                const auto& c = face[indices[(i + 1) % count]].position;
+                if (cross(a, b, c) <= 0)
+                    continue;
+
+                bool isEar = true;
+                for (std::size_t j = 0; j < count && isEar; ++j) {
+                    const auto& p = face[indices[j]].position;
+                    if (j == i || j == (i + 1) % count || j == (i + count - 1) % count)
+                        continue;
+                    isEar = cross(a, b, p) < 0 || cross(b, c, p) < 0 || cross(c, a, p) < 0;
+                }
+                if (isEar)
+                    ear = i;
+            }
+            // NOTE degenerated face: fallback to fan triangulation of the rest.
+            if (ear == count)
+                break;
+
+            addTriangle(face[indices[(ear + count - 1) % count]], face[indices[ear]], face[indices[(ear + 1) % count]]);
+            indices.erase(indices.begin() + static_cast<std::ptrdiff_t>(ear));
+        }
+
+        for (std::size_t i = 1; i + 1 < indices.size(); ++i)
+            addTriangle(face[indices[0]], face[indices[i]], face[indices[i + 1]]);
+    }
+
+    /// Adds counter clockwise triangle in local coordinates.
+    void addTriangle(const RoofPoint& a, const RoofPoint& b, const RoofPoint& c) const
+    {
+        builderContext_.meshBuilder.addTriangle(meshContext_.mesh, toVertex(a), toVertex(c), toVertex(b),
+            meshContext_.geometryOptions, meshContext_.appearanceOptions);
+    }
+
+    utymap::meshing::Vector3 toVertex(const RoofPoint& point) const
+    {
+        return utymap::meshing::Vector3(point.position.x / scale_ + longitude_,
+                                        minHeight_ + height_ * std::min(point.time / breakTime_, 1.),
+                                        point.position.y + latitude_);
+    }
+
+    static double cross(const utymap::meshing::Vector2& a, const utymap::meshing::Vector2& b, const utymap::meshing::Vector2& c)
+    {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+
+    const Form form_;
+    double longitude_, latitude_, scale_, breakTime_;
+};
+
+}}
+
+#endif // BUILDERS_BUILDINGS_ROOFS_SKELETONROOFBUILDER_HPP_DEFINED
@@ -60,9 +60,10 @@ protected:
                                  meshContext_.appearanceOptions);
     }
 
-private:
     const utymap::builders::BuilderContext& builderContext_;
     utymap::builders::MeshContext& meshContext_;
+
+private:
     double vertNoiseFreq_;
 };
 
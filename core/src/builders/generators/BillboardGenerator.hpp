@@ -0,0 +1,70 @@
+#ifndef BUILDERS_GENERATORS_BILLBOARDGENERATOR_HPP_DEFINED
+#define BUILDERS_GENERATORS_BILLBOARDGENERATOR_HPP_DEFINED
+
+#include "builders/generators/AbstractGenerator.hpp"
+
+namespace utymap { namespace builders {
+
+/// Generates two crossed double sided vertical quads which replace volume of
+/// object seen from distance, e.g. tree at low level of detail.
+class BillboardGenerator : public AbstractGenerator
+{
+public:
+
+    BillboardGenerator(const utymap::builders::BuilderContext& builderContext,
+                       utymap::builders::MeshContext& meshContext) :
+            AbstractGenerator(builderContext, meshContext),
+            center_(), width_(0), depth_(0), height_(0)
+    {
+    }
+
+    /// Sets center of bottom side.
+    BillboardGenerator& setCenter(const utymap::meshing::Vector3& center)
+    {
+        center_ = center;
+        return *this;
+    }
+
+    /// Sets half sizes of quads along x and z axes.
+    BillboardGenerator& setSize(double width, double depth)
+    {
+        width_ = width;
+        depth_ = depth;
+        return *this;
+    }
+
+    /// Sets height of quads.
+    BillboardGenerator& setHeight(double height)
+    {
+        height_ = height;
+        return *this;
+    }
+
+    void generate() override
+    {
+        addQuad(utymap::meshing::Vector3(center_.x - width_, center_.y, center_.z),
+                utymap::meshing::Vector3(center_.x + width_, center_.y, center_.z));
+        addQuad(utymap::meshing::Vector3(center_.x, center_.y, center_.z - depth_),
+                utymap::meshing::Vector3(center_.x, center_.y, center_.z + depth_));
+    }
+
+private:
+    /// Adds vertical quad with both sides visible.
+    void addQuad(const utymap::meshing::Vector3& first, const utymap::meshing::Vector3& second) const
+    {
+        utymap::meshing::Vector3 firstTop(first.x, first.y + height_, first.z);
+        utymap::meshing::Vector3 secondTop(second.x, second.y + height_, second.z);
+
+        addTriangle(first, secondTop, second);
+        addTriangle(firstTop, secondTop, first);
+
+        addTriangle(first, second, secondTop);
+        addTriangle(firstTop, first, secondTop);
+    }
+
+    utymap::meshing::Vector3 center_;
+    double width_, depth_, height_;
+};
+}}
+
+#endif // BUILDERS_GENERATORS_BILLBOARDGENERATOR_HPP_DEFINED
@@ -2,9 +2,11 @@
 #define BUILDERS_GENERATORS_CYLINDERGENERATOR_HPP_DEFINED
 
 #include "builders/generators/AbstractGenerator.hpp"
+#include "builders/generators/TemplateCache.hpp"
 #include "utils/MathUtils.hpp"
 
 #include <cmath>
+#include <vector>
 
 namespace utymap { namespace builders {
 
@@ -58,19 +60,19 @@ public:
         int heightSegments = static_cast<int>(std::ceil(height_ / maxSegmentHeight_));
 
         double heightStep = height_ / heightSegments;
-        double angleStep = 2 * pi / radialSegments_;
+        const auto& circle = getUnitCircle(radialSegments_);
 
         for (int j = 0; j < radialSegments_; j++) {
-            double firstAngle = j * angleStep;
-            double secondAngle = (j == radialSegments_ - 1 ? 0 : j + 1) * angleStep;
+            const auto& firstPoint = circle[j];
+            const auto& secondPoint = circle[j == radialSegments_ - 1 ? 0 : j + 1];
 
             auto first = utymap::meshing::Vector2(
-                    radius_ * std::cos(firstAngle) + center_.x,
-                    radius_ * std::sin(firstAngle) + center_.z);
+                    radius_ * firstPoint.x + center_.x,
+                    radius_ * firstPoint.y + center_.z);
 
             auto second = utymap::meshing::Vector2(
-                    radius_ * std::cos(secondAngle) + center_.x,
-                    radius_ * std::sin(secondAngle) + center_.z);
+                    radius_ * secondPoint.x + center_.x,
+                    radius_ * secondPoint.y + center_.z);
 
             // bottom cap
             addTriangle(center_,
@@ -98,6 +100,20 @@ public:
     }
 
 private:
+    /// Returns cosines and sines of segment angles from process wide cache.
+    static const std::vector<utymap::meshing::Vector2>& getUnitCircle(int radialSegments)
+    {
+        static TemplateCache<int, std::vector<utymap::meshing::Vector2>> cache;
+        return cache.get(radialSegments, [radialSegments]() {
+            double angleStep = 2 * pi / radialSegments;
+            std::vector<utymap::meshing::Vector2> circle;
+            circle.reserve(static_cast<std::size_t>(radialSegments));
+            for (int j = 0; j < radialSegments; j++)
+                circle.push_back(utymap::meshing::Vector2(std::cos(j * angleStep), std::sin(j * angleStep)));
+            return circle;
+        });
+    }
+
     utymap::meshing::Vector3 center_;
     int radialSegments_;
     double radius_, height_, maxSegmentHeight_;
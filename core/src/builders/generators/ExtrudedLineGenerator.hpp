@@ -0,0 +1,167 @@
+#ifndef BUILDERS_GENERATORS_EXTRUDEDLINEGENERATOR_HPP_DEFINED
+#define BUILDERS_GENERATORS_EXTRUDEDLINEGENERATOR_HPP_DEFINED
+
+#include "builders/generators/AbstractGenerator.hpp"
+#include "meshing/MeshTypes.hpp"
+#include "utils/NoiseUtils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace utymap { namespace builders {
+
+/// Generates wall of given thickness along polyline: two sides, top and end caps. Every
+/// line point has four vertices shared by all adjacent triangles, so mesh is built without
+/// clipping and triangulation. Joins are mitered, ends are squared.
+class ExtrudedLineGenerator final : public AbstractGenerator
+{
+    /// Max ratio of miter length to offset. Sharper joins are clamped.
+    const double MiterLimit = 2;
+
+    /// Vertices of line point.
+    enum { LeftBottom = 0, LeftTop = 1, RightTop = 2, RightBottom = 3, VertexCount = 4 };
+
+public:
+    ExtrudedLineGenerator(const utymap::builders::BuilderContext& builderContext,
+                          utymap::builders::MeshContext& meshContext) :
+        AbstractGenerator(builderContext, meshContext),
+        points_(), offset_(0), height_(0), minHeight_(0)
+    {
+    }
+
+    /// Sets line points. Line is closed if its first and last points are the same.
+    ExtrudedLineGenerator& setPoints(const std::vector<utymap::meshing::Vector2>& points)
+    {
+        points_.clear();
+        points_.reserve(points.size());
+        for (const auto& point : points)
+            if (points_.empty() || point.x != points_.back().x || point.y != points_.back().y)
+                points_.push_back(point);
+        return *this;
+    }
+
+    /// Sets distance from line to wall sides.
+    ExtrudedLineGenerator& setOffset(double offset)
+    {
+        offset_ = offset;
+        return *this;
+    }
+
+    ExtrudedLineGenerator& setHeight(double height)
+    {
+        height_ = height;
+        return *this;
+    }
+
+    /// Sets elevation of wall bottom.
+    ExtrudedLineGenerator& setMinHeight(double minHeight)
+    {
+        minHeight_ = minHeight;
+        return *this;
+    }
+
+    void generate() override
+    {
+        bool isClosed = points_.size() > 2 &&
+            points_.front().x == points_.back().x && points_.front().y == points_.back().y;
+        std::size_t count = isClosed ? points_.size() - 1 : points_.size();
+        if (count < 2)
+            return;
+
+        auto& mesh = meshContext_.mesh;
+        int first = static_cast<int>(mesh.vertices.size() / 3);
+        mesh.vertices.reserve(mesh.vertices.size() + count * VertexCount * 3);
+        mesh.colors.reserve(mesh.colors.size() + count * VertexCount);
+        mesh.uvs.reserve(mesh.uvs.size() + count * VertexCount * 2);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            utymap::meshing::Vector2 point = points_[i];
+            utymap::meshing::Vector2 side = getSide(i, count, isClosed);
+            // NOTE ends are extended by offset as square caps.
+            if (!isClosed && (i == 0 || i + 1 == count)) {
+                auto direction = getDirection(i == 0 ? 0 : i - 1);
+                double sign = i == 0 ? -offset_ : offset_;
+                point = utymap::meshing::Vector2(point.x + direction.x * sign, point.y + direction.y * sign);
+            }
+            utymap::meshing::Vector2 left(point.x - side.x, point.y - side.y);
+            utymap::meshing::Vector2 right(point.x + side.x, point.y + side.y);
+            addVertex(left, minHeight_);
+            addVertex(left, minHeight_ + height_);
+            addVertex(right, minHeight_ + height_);
+            addVertex(right, minHeight_);
+        }
+
+        std::size_t segments = isClosed ? count : count - 1;
+        mesh.triangles.reserve(mesh.triangles.size() + segments * 18 + (isClosed ? 0 : 12));
+        for (std::size_t i = 0; i < segments; ++i) {
+            int a = first + static_cast<int>(i * VertexCount);
+            int b = first + static_cast<int>(((i + 1) % count) * VertexCount);
+            // wall sides are visible on the right of their direction.
+            addQuad(a + RightBottom, b + RightBottom, b + RightTop, a + RightTop);
+            addQuad(b + LeftBottom, a + LeftBottom, a + LeftTop, b + LeftTop);
+            addQuad(a + RightTop, b + RightTop, b + LeftTop, a + LeftTop);
+        }
+
+        if (!isClosed) {
+            int last = first + static_cast<int>((count - 1) * VertexCount);
+            addQuad(first + LeftBottom, first + RightBottom, first + RightTop, first + LeftTop);
+            addQuad(last + RightBottom, last + LeftBottom, last + LeftTop, last + RightTop);
+        }
+    }
+
+private:
+    /// Returns direction of segment which starts at given point.
+    utymap::meshing::Vector2 getDirection(std::size_t index) const
+    {
+        const auto& start = points_[index];
+        const auto& end = points_[(index + 1) % points_.size()];
+        utymap::meshing::Vector2 direction(end.x - start.x, end.y - start.y);
+        double length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+        return utymap::meshing::Vector2(direction.x / length, direction.y / length);
+    }
+
+    /// Returns offset from line point to its right side point.
+    utymap::meshing::Vector2 getSide(std::size_t index, std::size_t count, bool isClosed) const
+    {
+        bool hasPrev = isClosed || index > 0;
+        bool hasNext = isClosed || index + 1 < count;
+        auto next = getDirection(hasNext ? index : index - 1);
+        auto prev = hasPrev ? getDirection(index == 0 ? count - 1 : index - 1) : next;
+
+        utymap::meshing::Vector2 nextNormal(next.y, -next.x);
+        utymap::meshing::Vector2 prevNormal(prev.y, -prev.x);
+        utymap::meshing::Vector2 miter(nextNormal.x + prevNormal.x, nextNormal.y + prevNormal.y);
+        double length = std::sqrt(miter.x * miter.x + miter.y * miter.y);
+        if (length < 1E-9)
+            return utymap::meshing::Vector2(nextNormal.x * offset_, nextNormal.y * offset_);
+
+        miter = utymap::meshing::Vector2(miter.x / length, miter.y / length);
+        double cosine = miter.x * nextNormal.x + miter.y * nextNormal.y;
+        double distance = offset_ * std::min(1 / cosine, MiterLimit);
+        return utymap::meshing::Vector2(miter.x * distance, miter.y * distance);
+    }
+
+    void addVertex(const utymap::meshing::Vector2& point, double elevation) const
+    {
+        auto& mesh = meshContext_.mesh;
+        const auto& appearance = meshContext_.appearanceOptions;
+        double noise = utymap::utils::NoiseUtils::perlin2D(point.x, point.y, appearance.colorNoiseFreq);
+        mesh.vertices.insert(mesh.vertices.end(), { point.x, point.y, elevation });
+        mesh.colors.push_back(static_cast<int>(appearance.gradient.lookup((noise + 1) / 2)));
+        mesh.uvs.insert(mesh.uvs.end(), { 0, 0 });
+    }
+
+    /// Adds quad which vertices go counter clockwise when seen from its visible side.
+    void addQuad(int v0, int v1, int v2, int v3) const
+    {
+        meshContext_.mesh.triangles.insert(meshContext_.mesh.triangles.end(), { v0, v2, v1, v3, v2, v0 });
+    }
+
+    std::vector<utymap::meshing::Vector2> points_;
+    double offset_, height_, minHeight_;
+};
+
+}}
+
+#endif // BUILDERS_GENERATORS_EXTRUDEDLINEGENERATOR_HPP_DEFINED
@@ -2,9 +2,11 @@
 #define BUILDERS_GENERATORS_ICOSPHEREGENERATOR_HPP_DEFINED
 
 #include "builders/generators/AbstractGenerator.hpp"
+#include "builders/generators/TemplateCache.hpp"
 
 #include <algorithm>
 #include <cstdint>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 
@@ -12,6 +14,7 @@ namespace utymap { namespace builders {
 
 /// Builds icosphere.
 /// See http://blog.andreaskahler.com/2009/06/creating-icosphere-mesh-in-code.html
+/// Unit icosphere is built once per recursion level and kind, then only transformed.
 class IcoSphereGenerator final : public AbstractGenerator
 {
     /// Helper class for calculations
@@ -63,26 +66,57 @@ public:
 
     void generate() override
     {
+        const auto& sphere = getUnitSphere(recursionLevel_, isSemiSphere_);
+        for (const auto& face : sphere.faces) {
+            addTriangle(
+                scale(sphere.vertices[face.V1]) + center_,
+                scale(sphere.vertices[face.V2]) + center_,
+                scale(sphere.vertices[face.V3]) + center_);
+        }
+    }
+
+private:
+    /// Icosphere of unit radius.
+    struct UnitSphere
+    {
+        std::vector<utymap::meshing::Vector3> vertices;
+        std::vector<TriangleIndices> faces;
+    };
+
+    /// Returns unit sphere from process wide cache.
+    static const UnitSphere& getUnitSphere(int recursionLevel, bool isSemiSphere)
+    {
+        static TemplateCache<std::pair<int, bool>, UnitSphere> cache;
+        return cache.get(std::make_pair(recursionLevel, isSemiSphere), [&]() {
+            return createUnitSphere(recursionLevel, isSemiSphere);
+        });
+    }
+
+    static UnitSphere createUnitSphere(int recursionLevel, bool isSemiSphere)
+    {
+        UnitSphere sphere;
+        auto& vertexList = sphere.vertices;
+
         // create 12 vertices of a icosahedron
         double t = (1 + std::sqrt(5)) / 2;
 
-        vertexList_.push_back(utymap::meshing::Vector3(-1, t, 0).normalized());
-        vertexList_.push_back(utymap::meshing::Vector3(1, t, 0).normalized());
-        vertexList_.push_back(utymap::meshing::Vector3(-1, -t, 0).normalized());
-        vertexList_.push_back(utymap::meshing::Vector3(1, -t, 0).normalized());
+        vertexList.push_back(utymap::meshing::Vector3(-1, t, 0).normalized());
+        vertexList.push_back(utymap::meshing::Vector3(1, t, 0).normalized());
+        vertexList.push_back(utymap::meshing::Vector3(-1, -t, 0).normalized());
+        vertexList.push_back(utymap::meshing::Vector3(1, -t, 0).normalized());
 
-        vertexList_.push_back(utymap::meshing::Vector3(0, -1, t).normalized());
-        vertexList_.push_back(utymap::meshing::Vector3(0, 1, t).normalized());
-        vertexList_.push_back(utymap::meshing::Vector3(0., -1, -t).normalized());
-        vertexList_.push_back(utymap::meshing::Vector3(0, 1, -t).normalized());
+        vertexList.push_back(utymap::meshing::Vector3(0, -1, t).normalized());
+        vertexList.push_back(utymap::meshing::Vector3(0, 1, t).normalized());
+        vertexList.push_back(utymap::meshing::Vector3(0., -1, -t).normalized());
+        vertexList.push_back(utymap::meshing::Vector3(0, 1, -t).normalized());
 
-        vertexList_.push_back(utymap::meshing::Vector3(t, 0, -1).normalized());
-        vertexList_.push_back(utymap::meshing::Vector3(t, 0, 1).normalized());
-        vertexList_.push_back(utymap::meshing::Vector3(-t, 0, -1).normalized());
-        vertexList_.push_back(utymap::meshing::Vector3(-t, 0, 1).normalized());
+        vertexList.push_back(utymap::meshing::Vector3(t, 0, -1).normalized());
+        vertexList.push_back(utymap::meshing::Vector3(t, 0, 1).normalized());
+        vertexList.push_back(utymap::meshing::Vector3(-t, 0, -1).normalized());
+        vertexList.push_back(utymap::meshing::Vector3(-t, 0, 1).normalized());
 
         // create 20 triangles of the icosahedron
-        std::vector<TriangleIndices> faces;
+        auto& faces = sphere.faces;
         // 5 faces around point 0
         faces.push_back(TriangleIndices(0, 11, 5));
         faces.push_back(TriangleIndices(0, 5, 1));
@@ -93,14 +127,14 @@ public:
         // 5 adjacent faces
         faces.push_back(TriangleIndices(1, 5, 9));
         faces.push_back(TriangleIndices(5, 11, 4));
-        if (!isSemiSphere_)
+        if (!isSemiSphere)
             faces.push_back(TriangleIndices(11, 10, 2));
 
         faces.push_back(TriangleIndices(10, 7, 6));
         faces.push_back(TriangleIndices(7, 1, 8));
 
         // 5 faces around point 3
-        if (!isSemiSphere_) {
+        if (!isSemiSphere) {
             faces.push_back(TriangleIndices(3, 9, 4));
             faces.push_back(TriangleIndices(3, 4, 2));
             faces.push_back(TriangleIndices(3, 2, 6));
@@ -110,7 +144,7 @@ public:
 
         // 5 adjacent faces
         faces.push_back(TriangleIndices(4, 9, 5));
-        if (!isSemiSphere_) {
+        if (!isSemiSphere) {
             faces.push_back(TriangleIndices(2, 4, 11));
             faces.push_back(TriangleIndices(6, 2, 10));
         }
@@ -118,31 +152,30 @@ public:
         faces.push_back(TriangleIndices(9, 8, 1));
 
         // refine triangles
-        for (int i = 0; i < recursionLevel_; i++) {
+        std::unordered_map<std::uint64_t, std::size_t> middlePointIndexCache;
+        for (int i = 0; i < recursionLevel; i++) {
             std::vector<TriangleIndices> faces2;
+            faces2.reserve(faces.size() * 4);
             for (const auto& tri : faces) {
                 // replace triangle by 4 triangles
-                auto a = getMiddlePoint(tri.V1, tri.V2);
-                auto b = getMiddlePoint(tri.V2, tri.V3);
-                auto c = getMiddlePoint(tri.V3, tri.V1);
+                auto a = getMiddlePoint(tri.V1, tri.V2, vertexList, middlePointIndexCache);
+                auto b = getMiddlePoint(tri.V2, tri.V3, vertexList, middlePointIndexCache);
+                auto c = getMiddlePoint(tri.V3, tri.V1, vertexList, middlePointIndexCache);
 
                 faces2.push_back(TriangleIndices(tri.V1, a, c));
                 faces2.push_back(TriangleIndices(tri.V2, b, a));
                 faces2.push_back(TriangleIndices(tri.V3, c, b));
                 faces2.push_back(TriangleIndices(a, b, c));
             }
-            faces = faces2;
+            faces.swap(faces2);
         }
-        generateMesh(faces);
-
-        // clear state to allow reusage
-        middlePointIndexCache_.clear();
-        vertexList_.clear();
+        return sphere;
     }
 
-private:
     ///  Returns index of point in the middle of p1 and p2.
-    std::size_t getMiddlePoint(std::size_t p1, std::size_t p2)
+    static std::size_t getMiddlePoint(std::size_t p1, std::size_t p2,
+                                      std::vector<utymap::meshing::Vector3>& vertexList,
+                                      std::unordered_map<std::uint64_t, std::size_t>& middlePointIndexCache)
     {
         // first check if we have it already
         bool firstIsSmaller = p1 < p2;
@@ -150,13 +183,13 @@ private:
         std::uint64_t greaterIndex = firstIsSmaller ? p2 : p1;
         std::uint64_t key = (smallerIndex << 32) + greaterIndex;
 
-        auto ret = middlePointIndexCache_.find(key);
-        if (ret != middlePointIndexCache_.end())
+        auto ret = middlePointIndexCache.find(key);
+        if (ret != middlePointIndexCache.end())
             return ret->second;
 
         // not in cache, calculate it
-        utymap::meshing::Vector3 point1 = vertexList_[p1];
-        utymap::meshing::Vector3 point2 = vertexList_[p2];
+        utymap::meshing::Vector3 point1 = vertexList[p1];
+        utymap::meshing::Vector3 point2 = vertexList[p2];
         utymap::meshing::Vector3 middle
         (
             (point1.x + point2.x) / 2,
@@ -165,27 +198,15 @@ private:
         );
 
         // add vertex makes sure point is on unit sphere
-        std::size_t size = vertexList_.size();
-        vertexList_.push_back(middle.normalized());
+        std::size_t size = vertexList.size();
+        vertexList.push_back(middle.normalized());
 
         // store it, return index
-        middlePointIndexCache_.insert(std::make_pair(key, size));
+        middlePointIndexCache.insert(std::make_pair(key, size));
 
         return size;
     }
 
-    void generateMesh(const std::vector<TriangleIndices>& faces)
-    {
-        for (auto i = 0; i < faces.size(); ++i) {
-            auto face = faces[i];
-            addTriangle(
-                scale(vertexList_[face.V1]) + center_,
-                scale(vertexList_[face.V2]) + center_,
-                scale(vertexList_[face.V3]) + center_);
-
-        }
-    }
-
     utymap::meshing::Vector3 scale(const utymap::meshing::Vector3& v) const
     {
         return utymap::meshing::Vector3(
@@ -199,9 +220,6 @@ double radius_, height_;
 int recursionLevel_;
 bool isSemiSphere_;
 
-std::unordered_map<std::uint64_t, std::size_t> middlePointIndexCache_;
-std::vector<utymap::meshing::Vector3> vertexList_;
-
 };
 
 }}
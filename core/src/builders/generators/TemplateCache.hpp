@@ -0,0 +1,37 @@
+#ifndef BUILDERS_GENERATORS_TEMPLATECACHE_HPP_DEFINED
+#define BUILDERS_GENERATORS_TEMPLATECACHE_HPP_DEFINED
+
+#include "utils/CoreUtils.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace utymap { namespace builders {
+
+/// Keeps unit geometry which generators transform instead of computing it for every mesh.
+/// Templates are created once per key and never removed, so returned references stay
+/// valid. Thread safe.
+template <typename Key, typename Template>
+class TemplateCache final
+{
+public:
+    /// Returns template for given key creating it with factory if necessary.
+    template <typename Factory>
+    const Template& get(const Key& key, Factory factory)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto entry = templates_.find(key);
+        if (entry == templates_.end())
+            entry = templates_.emplace(key, utymap::utils::make_unique<Template>(factory())).first;
+        return *entry->second;
+    }
+
+private:
+    std::mutex lock_;
+    std::map<Key, std::unique_ptr<Template>> templates_;
+};
+
+}}
+
+#endif // BUILDERS_GENERATORS_TEMPLATECACHE_HPP_DEFINED
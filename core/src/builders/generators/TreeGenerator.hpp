@@ -2,6 +2,7 @@
 #define BUILDERS_GENERATORS_TREEGENERATOR_HPP_DEFINED
 
 #include "builders/generators/AbstractGenerator.hpp"
+#include "builders/generators/BillboardGenerator.hpp"
 #include "builders/generators/CylinderGenerator.hpp"
 #include "builders/generators/IcoSphereGenerator.hpp"
 #include "meshing/MeshTypes.hpp"
@@ -21,12 +22,15 @@ public:
 
             trunkGenerator(builderContext, trunkGeneratorMeshContext),
             foliageGenerator(builderContext, foliageGeneratorMeshContext),
+            trunkBillboardGenerator(builderContext, trunkGeneratorMeshContext),
+            foliageBillboardGenerator(builderContext, foliageGeneratorMeshContext),
 
             position_(),
             trunkHeight_(0),
             trunkRadius_(0),
             foliageRadius_(0),
-            foliageHeight_(0)
+            foliageHeight_(0),
+            isBillboard_(false)
     {
     }
 
@@ -75,8 +79,21 @@ public:
         return *this;
     }
 
+    /// Sets whether tree is generated as crossed quads instead of trunk cylinder and
+    /// foliage sphere. Used at low levels of detail where trees are not seen closely.
+    TreeGenerator& setBillboard(bool isBillboard)
+    {
+        isBillboard_ = isBillboard;
+        return *this;
+    }
+
     void generate()
     {
+        if (isBillboard_) {
+            generateBillboard();
+            return;
+        }
+
         // generate trunk
         trunkGenerator
             .setCenter(position_)
@@ -100,12 +117,35 @@ public:
     }
 
 private:
+    /// Generates quads which have the same bounds as trunk and foliage.
+    void generateBillboard()
+    {
+        trunkBillboardGenerator
+            .setCenter(position_)
+            .setSize(trunkRadius_, trunkRadius_)
+            .setHeight(trunkHeight_)
+            .generate();
+
+        // NOTE foliage sphere is stretched along x axis.
+        foliageBillboardGenerator
+            .setCenter(utymap::meshing::Vector3(
+                position_.x,
+                position_.y + trunkHeight_ + foliageRadius_ - foliageHeight_,
+                position_.z))
+            .setSize(foliageRadius_ * 1.5, foliageRadius_)
+            .setHeight(2 * foliageHeight_)
+            .generate();
+    }
+
     utymap::builders::MeshContext trunkGeneratorMeshContext;
     utymap::builders::MeshContext foliageGeneratorMeshContext;
     CylinderGenerator trunkGenerator;
     IcoSphereGenerator foliageGenerator;
+    BillboardGenerator trunkBillboardGenerator;
+    BillboardGenerator foliageBillboardGenerator;
     meshing::Vector3 position_;
     double trunkHeight_, trunkRadius_, foliageRadius_, foliageHeight_;
+    bool isBillboard_;
 };
 }}
 
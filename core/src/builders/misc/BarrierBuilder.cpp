@@ -1,12 +1,9 @@
-#include "builders/buildings/roofs/FlatRoofBuilder.hpp"
-#include "builders/buildings/facades/FlatFacadeBuilder.hpp"
+#include "builders/generators/ExtrudedLineGenerator.hpp"
 #include "builders/misc/BarrierBuilder.hpp"
-#include "clipper/clipper.hpp"
 #include "entities/Way.hpp"
-#include "utils/GeometryUtils.hpp"
+#include "meshing/MeshPool.hpp"
 #include "utils/GradientUtils.hpp"
 
-using namespace ClipperLib;
 using namespace utymap::builders;
 using namespace utymap::entities;
 using namespace utymap::mapcss;
@@ -14,7 +11,6 @@ using namespace utymap::meshing;
 using namespace utymap::utils;
 
 namespace {
-    const double Scale = 1E7;
     const std::string HeightKey = "height";
     const std::string MinHeightKey = "min-height";
     const std::string ColorKey = "color";
@@ -22,71 +18,44 @@ namespace {
     const std::string MeshNamePrefix = "barrier:";
 }
 
-void BarrierBuilder::visitWay(const Way& way)
+BarrierBuilder::BarrierBuilder(const BuilderContext& context) :
+    ElementBuilder(context),
+    heightKeyId_(context.stringTable.getId(HeightKey)),
+    minHeightKeyId_(context.stringTable.getId(MinHeightKey)),
+    colorKeyId_(context.stringTable.getId(ColorKey)),
+    offsetKeyId_(context.stringTable.getId(OffsetKey))
 {
-    Style style = context_.styleProvider.forElement(way, context_.quadKey.levelOfDetail);
-
-    ClipperOffset offset;
-    Path path;
-    path.reserve(way.coordinates.size());
-
-    for (const auto& coord : way.coordinates) {
-        path.push_back(IntPoint(static_cast<ClipperLib::cInt>(coord.longitude * Scale), 
-                                static_cast<ClipperLib::cInt>(coord.latitude * Scale)));
-    }
-
-    if (path[0] == path[path.size() - 1])
-        path.pop_back();
-
-    offset.AddPath(path, JoinType::jtMiter, EndType::etOpenSquare);
-
-    Paths solution;
-    double offsetInMeters = style.getValue(OffsetKey);
-    double offsetInGrads = GeoUtils::getOffset(way.coordinates[0], offsetInMeters);
-    offset.Execute(solution, offsetInGrads * Scale);
-    auto& shape = solution[0];
-
-    // NOTE ensure proper orientation which is required by facade builder
-    // used below
-    if (!ClipperLib::Orientation(shape))
-        std::reverse(shape.begin(), shape.end());
-
-    // get polygon
-    Polygon polygon(shape.size(), 0);
-    std::vector<Vector2> vertices;
-    vertices.reserve(shape.size());
-    for (const auto& p : shape) {
-        vertices.push_back(Vector2(p.X / Scale, p.Y / Scale));
-    }
-
-    polygon.addContour(vertices);
-
-    buildFromPolygon(way, style, polygon);
 }
 
-void BarrierBuilder::buildFromPolygon(const Way& way, const Style& style, Polygon& polygon) const
+void BarrierBuilder::visitWay(const Way& way)
 {
-    double height = style.getValue(HeightKey);
-    double minHeight = style.getValue(MinHeightKey);
+    if (way.coordinates.size() < 2)
+        return;
+
+    Style style = getStyle(way);
+
+    double height = style.getValue(heightKeyId_);
+    double minHeight = style.getValue(minHeightKeyId_);
     double elevation = context_.eleProvider.getElevation(way.coordinates[0]) + minHeight;
+    double offset = context_.metricScale.toDegrees(way.coordinates[0], style.getValue(offsetKeyId_));
 
-    const auto& gradient = GradientUtils::evaluateGradient(context_.styleProvider, style, ColorKey);
+    std::vector<Vector2> points;
+    points.reserve(way.coordinates.size());
+    for (const auto& coordinate : way.coordinates)
+        points.push_back(Vector2(coordinate.longitude, coordinate.latitude));
 
-    Mesh mesh(utymap::utils::getMeshName(MeshNamePrefix, way));
-    MeshContext meshContext(mesh, style, gradient, TextureRegion());
+    const auto& gradient = GradientUtils::evaluateGradient(context_.styleProvider, style, colorKeyId_);
 
-    // NOTE: Reuse building builders.
-    FlatRoofBuilder(context_, meshContext)
-        .setHeight(0)
-        .setMinHeight(elevation + height)
-        .setColorNoiseFreq(0)
-        .build(polygon);
+    auto mesh = MeshPool::local().acquire(utymap::utils::getMeshName(MeshNamePrefix, way));
+    MeshContext meshContext(*mesh, style, gradient, TextureRegion());
 
-    FlatFacadeBuilder(context_, meshContext)
+    ExtrudedLineGenerator(context_, meshContext)
+        .setPoints(points)
+        .setOffset(offset)
         .setHeight(height)
         .setMinHeight(elevation)
         .setColorNoiseFreq(0)
-        .build(polygon);
+        .generate();
 
-    context_.meshCallback(mesh);
-}
\ No newline at end of file
+    context_.meshCallback(*mesh);
+}
@@ -3,7 +3,6 @@
 
 #include "builders/ElementBuilder.hpp"
 #include "mapcss/Style.hpp"
-#include "meshing/Polygon.hpp"
 
 namespace utymap { namespace builders {
 
@@ -12,10 +11,7 @@ class BarrierBuilder final : public ElementBuilder
 {
 
 public:
-    explicit BarrierBuilder(const utymap::builders::BuilderContext& context) :
-            ElementBuilder(context)
-    {
-    }
+    explicit BarrierBuilder(const utymap::builders::BuilderContext& context);
 
     void visitNode(const utymap::entities::Node&) override { }
 
@@ -26,11 +22,14 @@ public:
     void visitRelation(const utymap::entities::Relation&) override { }
 
     void complete() override { }
-   
+
+    bool hasElementMeshes() const override { return true; }
+
 private:
-    void buildFromPolygon(const utymap::entities::Way& way, 
-                          const utymap::mapcss::Style& style,
-                          utymap::meshing::Polygon& polygon) const;
+    std::uint32_t heightKeyId_;
+    std::uint32_t minHeightKeyId_;
+    std::uint32_t colorKeyId_;
+    std::uint32_t offsetKeyId_;
 };
 
 }}
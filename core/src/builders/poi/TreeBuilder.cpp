@@ -1,6 +1,10 @@
 #include "builders/poi/TreeBuilder.hpp"
+#include "meshing/MeshPool.hpp"
 #include "utils/GradientUtils.hpp"
 #include "utils/MeshUtils.hpp"
+#include "utils/NoiseUtils.hpp"
+
+#include <cmath>
 
 using namespace utymap::builders;
 using namespace utymap::entities;
@@ -12,42 +16,142 @@ namespace {
     const std::string NodeMeshNamePrefix = "tree:";
     const std::string WayMeshNamePrefix = "trees:";
 
+    const std::string InstancesMeshNamePrefix = "trees:prototype:";
+
     const std::string TreeStepKey = "tree-step";
+    const std::string TreeScaleVarianceKey = "tree-scale-variance";
 
     const std::string FoliageColorKey = "foliage-color";
     const std::string TrunkColorKey = "trunk-color";
     const std::string FoliageRadius = "foliage-radius";
     const std::string TrunkRadius = "trunk-radius";
     const std::string TrunkHeight = "trunk-height";
+    /// Max level of detail where trees are generated as billboards.
+    const std::string BillboardLod = "tree-billboard-lod";
+
+    const double Pi = std::acos(-1);
+}
+
+TreeBuilder::GeneratorKeys::GeneratorKeys(utymap::index::StringTable& stringTable) :
+    foliageColor(stringTable.getId(FoliageColorKey)),
+    trunkColor(stringTable.getId(TrunkColorKey)),
+    foliageRadius(stringTable.getId(FoliageRadius)),
+    trunkRadius(stringTable.getId(TrunkRadius)),
+    trunkHeight(stringTable.getId(TrunkHeight)),
+    billboardLod(stringTable.getId(BillboardLod))
+{
+}
+
+TreeBuilder::TreeBuilder(const BuilderContext& context) :
+    ElementBuilder(context),
+    keys_(context.stringTable),
+    treeStepKeyId_(context.stringTable.getId(TreeStepKey)),
+    treeScaleVarianceKeyId_(context.stringTable.getId(TreeScaleVarianceKey))
+{
 }
 
 void TreeBuilder::visitNode(const utymap::entities::Node& node)
 {
-    Mesh mesh(utymap::utils::getMeshName(NodeMeshNamePrefix, node));
-    Style style = context_.styleProvider.forElement(node, context_.quadKey.levelOfDetail);
-    MeshContext meshContext(mesh, style, utymap::mapcss::ColorGradient(), utymap::mapcss::TextureRegion());
+    if (context_.instancesCallback) {
+        Style style = getStyle(node);
+        addInstance(getInstances(style), style, node.coordinate);
+        return;
+    }
+
+    auto mesh = MeshPool::local().acquire(utymap::utils::getMeshName(NodeMeshNamePrefix, node), true);
+    Style style = getStyle(node);
+    MeshContext meshContext(*mesh, style, utymap::mapcss::ColorGradient(), utymap::mapcss::TextureRegion());
 
-    auto generator = createGenerator(context_, meshContext);
+    auto generator = createGenerator(context_, meshContext, keys_);
 
     double elevation = context_.eleProvider.getElevation(node.coordinate);
     generator->setPosition(Vector3(node.coordinate.longitude, elevation, node.coordinate.latitude));
     generator->generate();
 
-    context_.meshCallback(mesh);
+    context_.meshCallback(*mesh);
 }
 
 void TreeBuilder::visitWay(const utymap::entities::Way& way)
 {
-    Mesh treeMesh("");
-    Mesh newMesh(utymap::utils::getMeshName(WayMeshNamePrefix, way));
-    Style style = context_.styleProvider.forElement(way, context_.quadKey.levelOfDetail);
+    if (context_.instancesCallback) {
+        Style style = getStyle(way);
+        auto& instances = getInstances(style);
+        forEachTreePosition(way, style, [&](const GeoCoordinate& position) {
+            addInstance(instances, style, position);
+        });
+        return;
+    }
+
+    Mesh treeMesh("", true);
+    auto newMesh = MeshPool::local().acquire(utymap::utils::getMeshName(WayMeshNamePrefix, way));
+    Style style = getStyle(way);
     MeshContext meshContext(treeMesh, style, utymap::mapcss::ColorGradient(), utymap::mapcss::TextureRegion());
 
-    auto generator = TreeBuilder::createGenerator(context_, meshContext);
+    auto generator = TreeBuilder::createGenerator(context_, meshContext, keys_);
     generator->setPosition(Vector3(0, 0, 0)); // NOTE we will override coordinates later
     generator->generate();
 
-    double treeStepInMeters = style.getValue(TreeStepKey);
+    forEachTreePosition(way, style, [&](const GeoCoordinate& position) {
+        double elevation = context_.eleProvider.getElevation(position);
+        utymap::utils::copyMesh(Vector3(position.longitude, elevation, position.latitude), treeMesh, *newMesh);
+    });
+
+    context_.meshCallback(*newMesh);
+}
+
+void TreeBuilder::visitRelation(const utymap::entities::Relation& relation)
+{
+    for (const auto& element : relation.elements) {
+        element->accept(*this);
+    }
+}
+
+void TreeBuilder::complete()
+{
+    for (const auto& instances : instances_)
+        if (instances->size() > 0)
+            context_.instancesCallback(*instances);
+    instances_.clear();
+    prototypes_.clear();
+}
+
+MeshInstances& TreeBuilder::getInstances(const Style& style)
+{
+    std::string key = style.getString(keys_.foliageColor) + '|' + style.getString(keys_.trunkColor) + '|' +
+                      style.getString(keys_.foliageRadius) + '|' + style.getString(keys_.trunkRadius) + '|' +
+                      style.getString(keys_.trunkHeight);
+    auto prototype = prototypes_.find(key);
+    if (prototype != prototypes_.end())
+        return *instances_[prototype->second];
+
+    auto instances = utymap::utils::make_unique<MeshInstances>(InstancesMeshNamePrefix + std::to_string(instances_.size()));
+    instances->prototype.isIndexed = true;
+    MeshContext meshContext(instances->prototype, style, utymap::mapcss::ColorGradient(), utymap::mapcss::TextureRegion());
+    auto generator = createGenerator(context_, meshContext, keys_);
+    generator->setPosition(Vector3(0, 0, 0));
+    generator->generate();
+
+    prototypes_.emplace(key, instances_.size());
+    instances_.push_back(std::move(instances));
+    return *instances_.back();
+}
+
+void TreeBuilder::addInstance(MeshInstances& instances, const Style& style, const GeoCoordinate& position) const
+{
+    double x = position.longitude, y = position.latitude;
+    double scaleVariance = style.getValue(treeScaleVarianceKeyId_);
+    instances.transforms.insert(instances.transforms.end(), {
+        x, y, context_.eleProvider.getElevation(position),
+        1 + scaleVariance * (2 * NoiseUtils::random(x, y, 0) - 1),
+        2 * Pi * NoiseUtils::random(x, y, 1),
+        NoiseUtils::random(x, y, 2)
+    });
+}
+
+template <typename Function>
+void TreeBuilder::forEachTreePosition(const Way& way, const Style& style, Function function) const
+{
+    double treeStepInMeters = style.getValue(treeStepKeyId_);
 
     for (std::size_t i = 0; i < way.coordinates.size() - 1; ++i) {
         const auto& p1 = way.coordinates[i];
@@ -56,42 +160,39 @@ void TreeBuilder::visitWay(const utymap::entities::Way& way)
         double distanceInMeters = GeoUtils::distance(p1, p2);
         int treeCount = static_cast<int>(distanceInMeters / treeStepInMeters);
 
-        for (int j = 0; j < treeCount; ++j) {
-            GeoCoordinate position = GeoUtils::newPoint(p1, p2, static_cast<double>(j) / treeCount);
-            
-            double elevation = context_.eleProvider.getElevation(position);
-            utymap::utils::copyMesh(Vector3(position.longitude, elevation, position.latitude), treeMesh, newMesh);
-        }
+        for (int j = 0; j < treeCount; ++j)
+            function(GeoUtils::newPoint(p1, p2, static_cast<double>(j) / treeCount));
     }
-
-    context_.meshCallback(newMesh);
 }
 
-void TreeBuilder::visitRelation(const utymap::entities::Relation& relation)
+std::unique_ptr<TreeGenerator> TreeBuilder::createGenerator(const BuilderContext& builderContext, const MeshContext& meshContext)
 {
-    for (const auto& element : relation.elements) {
-        element->accept(*this);
-    }
+    return createGenerator(builderContext, meshContext, GeneratorKeys(builderContext.stringTable));
 }
 
-std::unique_ptr<TreeGenerator> TreeBuilder::createGenerator(const BuilderContext& builderContext, const MeshContext& meshContext)
+std::unique_ptr<TreeGenerator> TreeBuilder::createGenerator(const BuilderContext& builderContext,
+                                                            const MeshContext& meshContext,
+                                                            const GeneratorKeys& keys)
 {
     double relativeSize = builderContext.boundingBox.maxPoint.latitude - builderContext.boundingBox.minPoint.latitude;
     GeoCoordinate relativeCoordinate = builderContext.boundingBox.center();
 
-    double foliageRadiusInDegrees = meshContext.style.getValue(FoliageRadius, relativeSize, relativeCoordinate);
-    double foliageRadiusInMeters = meshContext.style.getValue(FoliageRadius, relativeSize);
+    double foliageRadiusInDegrees = meshContext.style.getValue(keys.foliageRadius, relativeSize, relativeCoordinate,
+                                                                builderContext.metricScale);
+    double foliageRadiusInMeters = meshContext.style.getValue(keys.foliageRadius, relativeSize);
 
-    const auto& trunkGradient = GradientUtils::evaluateGradient(builderContext.styleProvider, meshContext.style, TrunkColorKey);
-    const auto& foliageGradient = GradientUtils::evaluateGradient(builderContext.styleProvider, meshContext.style, FoliageColorKey);
+    const auto& trunkGradient = GradientUtils::evaluateGradient(builderContext.styleProvider, meshContext.style, keys.trunkColor);
+    const auto& foliageGradient = GradientUtils::evaluateGradient(builderContext.styleProvider, meshContext.style, keys.foliageColor);
 
     auto generator = utymap::utils::make_unique<TreeGenerator>(builderContext, meshContext, trunkGradient, foliageGradient);
 
     generator->setFoliageColorNoiseFreq(0);
     generator->setFoliageRadius(foliageRadiusInDegrees, foliageRadiusInMeters);
     generator->setTrunkColorNoiseFreq(0);
-    generator->setTrunkRadius(meshContext.style.getValue(TrunkRadius, relativeSize, relativeCoordinate));
-    generator->setTrunkHeight(meshContext.style.getValue(TrunkHeight, relativeSize));
+    generator->setTrunkRadius(meshContext.style.getValue(keys.trunkRadius, relativeSize, relativeCoordinate,
+                                                        builderContext.metricScale));
+    generator->setTrunkHeight(meshContext.style.getValue(keys.trunkHeight, relativeSize));
+    generator->setBillboard(builderContext.quadKey.levelOfDetail <= meshContext.style.getValue(keys.billboardLod));
 
     return generator;
 }
\ No newline at end of file
@@ -11,6 +11,9 @@
 #include "entities/Relation.hpp"
 
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace utymap { namespace builders {
 
@@ -18,10 +21,20 @@ namespace utymap { namespace builders {
 class TreeBuilder final : public utymap::builders::ElementBuilder
 {
 public:
-    explicit TreeBuilder(const utymap::builders::BuilderContext& context) :
-                         utymap::builders::ElementBuilder(context)
+    /// Ids of style keys used to create tree generator.
+    struct GeneratorKeys final
     {
-    }
+        explicit GeneratorKeys(utymap::index::StringTable& stringTable);
+
+        std::uint32_t foliageColor;
+        std::uint32_t trunkColor;
+        std::uint32_t foliageRadius;
+        std::uint32_t trunkRadius;
+        std::uint32_t trunkHeight;
+        std::uint32_t billboardLod;
+    };
+
+    explicit TreeBuilder(const utymap::builders::BuilderContext& context);
 
     void visitNode(const utymap::entities::Node& node) override;
 
@@ -31,11 +44,46 @@ public:
 
     void visitRelation(const utymap::entities::Relation& relation) override;
 
-    void complete() override { }
+    /// Reports collected tree instances if context has instances callback.
+    void complete() override;
+
+    /// Trees are merged into instances if context has instances callback.
+    bool hasElementMeshes() const override { return !context_.instancesCallback; }
 
-    /// Creates tree generator which can be used to produce multiple trees inside mesh.
+    /// Creates tree generator which can be used to produce multiple trees inside mesh. Trees
+    /// are generated as billboards up to level of detail set by "tree-billboard-lod".
+    /// NOTE resolves style keys on each call.
     static std::unique_ptr<TreeGenerator> createGenerator(const utymap::builders::BuilderContext& builderContext,
                                                           const utymap::builders::MeshContext& meshContext);
+
+    /// Creates tree generator using style keys resolved in advance.
+    static std::unique_ptr<TreeGenerator> createGenerator(const utymap::builders::BuilderContext& builderContext,
+                                                          const utymap::builders::MeshContext& meshContext,
+                                                          const GeneratorKeys& keys);
+
+private:
+    /// Returns instances of prototype tree which matches style, generates prototype if
+    /// there is no such one yet.
+    utymap::meshing::MeshInstances& getInstances(const utymap::mapcss::Style& style);
+
+    /// Adds instance of prototype tree at given position.
+    void addInstance(utymap::meshing::MeshInstances& instances,
+                     const utymap::mapcss::Style& style,
+                     const utymap::GeoCoordinate& position) const;
+
+    /// Calls function for each tree position along the way.
+    template <typename Function>
+    void forEachTreePosition(const utymap::entities::Way& way,
+                             const utymap::mapcss::Style& style,
+                             Function function) const;
+
+    const GeneratorKeys keys_;
+    std::uint32_t treeStepKeyId_;
+    std::uint32_t treeScaleVarianceKeyId_;
+    /// Instances of prototype trees in order of creation. Used only with instances callback.
+    std::vector<std::unique_ptr<utymap::meshing::MeshInstances>> instances_;
+    /// Key: tree parameters from style, value: index of prototype in instances.
+    std::unordered_map<std::string, std::size_t> prototypes_;
 };
 
 }}
@@ -0,0 +1,147 @@
+#ifndef BUILDERS_TERRAIN_CLIPPATHINDEX_HPP_DEFINED
+#define BUILDERS_TERRAIN_CLIPPATHINDEX_HPP_DEFINED
+
+#include "clipper/clipper.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace utymap { namespace builders {
+
+/// Keeps clip paths in uniform grid, so only paths which bounding boxes overlap given area
+/// can be found without visiting all of them. Paths outside of grid bounds are stored in
+/// border cells.
+class ClipPathIndex final
+{
+public:
+    ClipPathIndex(const ClipperLib::IntRect& bounds, int cellsPerSide = 16) :
+        bounds_(bounds), cellsPerSide_(std::max(cellsPerSide, 1)),
+        cells_(static_cast<std::size_t>(cellsPerSide_ * cellsPerSide_)), query_(0)
+    {
+    }
+
+    /// Adds paths to index.
+    void add(const ClipperLib::Paths& paths)
+    {
+        for (const auto& path : paths)
+            if (path.size() >= 3)
+                addPath(ClipperLib::Path(path));
+    }
+
+    /// Adds paths to index taking their memory.
+    void add(ClipperLib::Paths&& paths)
+    {
+        for (auto& path : paths)
+            if (path.size() >= 3)
+                addPath(std::move(path));
+    }
+
+    /// Appends paths which bounding boxes intersect given one preserving order of adding.
+    void query(const ClipperLib::IntRect& bbox, ClipperLib::Paths& result) const
+    {
+        ++query_;
+        std::vector<std::size_t> found;
+        int minX = getCellX(bbox.left), maxX = getCellX(bbox.right);
+        int minY = getCellY(bbox.top), maxY = getCellY(bbox.bottom);
+        for (int y = minY; y <= maxY; ++y)
+            for (int x = minX; x <= maxX; ++x)
+                for (std::size_t index : cells_[y * cellsPerSide_ + x]) {
+                    if (marks_[index] == query_ || !intersects(bboxes_[index], bbox))
+                        continue;
+                    marks_[index] = query_;
+                    found.push_back(index);
+                }
+
+        std::sort(found.begin(), found.end());
+        for (std::size_t index : found)
+            result.push_back(paths_[index]);
+    }
+
+    /// Returns amount of indexed paths.
+    std::size_t size() const { return paths_.size(); }
+
+    /// Returns bounding box of path.
+    static ClipperLib::IntRect getBounds(const ClipperLib::Path& path)
+    {
+        ClipperLib::IntRect bbox = createEmpty();
+        for (const auto& point : path)
+            expand(bbox, point);
+        return bbox;
+    }
+
+    /// Returns bounding box of all paths.
+    static ClipperLib::IntRect getBounds(const ClipperLib::Paths& paths)
+    {
+        ClipperLib::IntRect bbox = createEmpty();
+        for (const auto& path : paths)
+            for (const auto& point : path)
+                expand(bbox, point);
+        return bbox;
+    }
+
+private:
+    void addPath(ClipperLib::Path&& path)
+    {
+        std::size_t index = paths_.size();
+        ClipperLib::IntRect bbox = getBounds(path);
+        paths_.push_back(std::move(path));
+        bboxes_.push_back(bbox);
+        marks_.push_back(0);
+
+        int minX = getCellX(bbox.left), maxX = getCellX(bbox.right);
+        int minY = getCellY(bbox.top), maxY = getCellY(bbox.bottom);
+        for (int y = minY; y <= maxY; ++y)
+            for (int x = minX; x <= maxX; ++x)
+                cells_[y * cellsPerSide_ + x].push_back(index);
+    }
+
+    static ClipperLib::IntRect createEmpty()
+    {
+        ClipperLib::IntRect bbox;
+        bbox.left = bbox.top = std::numeric_limits<ClipperLib::cInt>::max();
+        bbox.right = bbox.bottom = std::numeric_limits<ClipperLib::cInt>::lowest();
+        return bbox;
+    }
+
+    static void expand(ClipperLib::IntRect& bbox, const ClipperLib::IntPoint& point)
+    {
+        bbox.left = std::min(bbox.left, point.X);
+        bbox.top = std::min(bbox.top, point.Y);
+        bbox.right = std::max(bbox.right, point.X);
+        bbox.bottom = std::max(bbox.bottom, point.Y);
+    }
+
+    static bool intersects(const ClipperLib::IntRect& a, const ClipperLib::IntRect& b)
+    {
+        return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+    }
+
+    int getCellX(ClipperLib::cInt x) const { return getCell(x, bounds_.left, bounds_.right); }
+
+    int getCellY(ClipperLib::cInt y) const { return getCell(y, bounds_.top, bounds_.bottom); }
+
+    int getCell(ClipperLib::cInt value, ClipperLib::cInt min, ClipperLib::cInt max) const
+    {
+        if (value <= min || max <= min)
+            return 0;
+        if (value >= max)
+            return cellsPerSide_ - 1;
+        return static_cast<int>(static_cast<double>(value - min) / (max - min) * cellsPerSide_);
+    }
+
+    const ClipperLib::IntRect bounds_;
+    const int cellsPerSide_;
+    ClipperLib::Paths paths_;
+    std::vector<ClipperLib::IntRect> bboxes_;
+    std::vector<std::vector<std::size_t>> cells_;
+    /// Id of the last query which has visited path: used to skip duplicates.
+    mutable std::vector<std::uint32_t> marks_;
+    mutable std::uint32_t query_;
+};
+
+}}
+
+#endif // BUILDERS_TERRAIN_CLIPPATHINDEX_HPP_DEFINED
@@ -18,26 +18,6 @@ class LineGridSplitter final
     typedef utymap::meshing::Vector2 Point;
     typedef std::vector<Point> Points;
 
-    struct sort_x
-    {
-        bool operator() (const Point& a, const Point& b) const { return a.x < b.x; }
-    };
-
-    struct sort_reverse_x
-    {
-        bool operator() (const Point& a, const Point& b) const { return a.x > b.x; }
-    };
-
-    struct sort_y
-    {
-        bool operator() (const Point& a, const Point& b) const { return a.y < b.y; }
-    };
-
-    struct sort_reverse_y
-    {
-        bool operator() (const Point& a, const Point& b) const { return a.y > b.y; }
-    };
-
 public:
     LineGridSplitter() : scale_(1), step_(1)
     {
@@ -49,128 +29,85 @@ public:
         step_ = step;
     }
 
-    /// Splits line to segments.
+    /// Splits line to segments appending start point, grid intersections in order from start
+    /// to end and end point to result. Points equal to the last one from result are skipped.
     void split(const ClipperLib::IntPoint& start, const ClipperLib::IntPoint& end, Points& result) const
     {
         Point s(start.X / scale_, start.Y / scale_);
         Point e(end.X / scale_, end.Y / scale_);
+        double dx = e.x - s.x;
+        double dy = e.y - s.y;
+
+        append(s, result);
+
+        // NOTE grid lines are enumerated by integer index, so intersections are produced
+        // in order along the line by merging two monotonic sequences without sorting.
+        std::int64_t xIndex, yIndex;
+        int xDir, yDir;
+        std::int64_t xCount = getCrossings(s.x, e.x, xIndex, xDir);
+        std::int64_t yCount = getCrossings(s.y, e.y, yIndex, yDir);
+
+        const double infinity = std::numeric_limits<double>::infinity();
+        while (xCount > 0 || yCount > 0) {
+            double gridX = xIndex * step_;
+            double gridY = yIndex * step_;
+            double tx = xCount > 0 ? (gridX - s.x) / dx : infinity;
+            double ty = yCount > 0 ? (gridY - s.y) / dy : infinity;
+
+            if (tx < ty) {
+                append(Point(gridX, s.y + (gridX - s.x) * dy / dx), result);
+                next(xIndex, xDir, xCount);
+            }
+            else if (ty < tx) {
+                append(Point(s.x + (gridY - s.y) * dx / dy, gridY), result);
+                next(yIndex, yDir, yCount);
+            }
+            else {
+                append(Point(gridX, gridY), result);
+                next(xIndex, xDir, xCount);
+                next(yIndex, yDir, yCount);
+            }
+        }
 
-        Points points;
-        points.reserve(2);
-        points.push_back(s);
-
-        double slope = (e.y - s.y) / (e.x - s.x);
-        if (std::isinf(slope) || std::abs(slope) < std::numeric_limits<double>::epsilon())
-            zeroSlope(s, e, points);
-        else
-            normalCase(s, e, slope, points);
-
-        points.push_back(e);
-
-        mergeResults(points, result);
+        append(e, result);
     }
 
 private:
 
-    inline double ceil(double value) const
+    /// Finds grid lines strictly between start and end values. Returns their amount and sets
+    /// index of the first one and direction of indices.
+    std::int64_t getCrossings(double start, double end, std::int64_t& index, int& direction) const
     {
-        return std::ceil(value / step_) * step_;
-    }
-
-    void zeroSlope(Point start, Point end, Points& points) const
-    {
-        if ((start.x - end.x) == 0)
-        {
-            bool isBottomTop = start.y < end.y;
-            if (!isBottomTop)
-            {
-                Point tmp = start;
-                start = end;
-                end = tmp;
-            }
-
-            double yStart = ceil(start.y);
-            double yEnd = end.y;
-            for (double y = yStart; y < yEnd; y += step_)
-                points.push_back(Point(start.x, y));
-
-            if (isBottomTop)
-                std::sort(points.begin(), points.end(), sort_y());
-            else
-                std::sort(points.begin(), points.end(), sort_reverse_y());
+        if (start < end) {
+            index = static_cast<std::int64_t>(std::floor(start / step_)) + 1;
+            direction = 1;
+            return std::max<std::int64_t>(0, static_cast<std::int64_t>(std::ceil(end / step_)) - index);
         }
-        else
-        {
-            bool isLeftRight = start.x < end.x;
-            if (!isLeftRight)
-            {
-                Point tmp = start;
-                start = end;
-                end = tmp;
-            }
-
-            double xStart = ceil(start.x);
-            double xEnd = end.x;
-            for (double x = xStart; x < xEnd; x += step_)
-                points.push_back(Point(x, start.y));
-
-            if (isLeftRight)
-                std::sort(points.begin(), points.end(), sort_x());
-            else
-                std::sort(points.begin(), points.end(), sort_reverse_x());
+        if (start > end) {
+            index = static_cast<std::int64_t>(std::ceil(start / step_)) - 1;
+            direction = -1;
+            return std::max<std::int64_t>(0, index - static_cast<std::int64_t>(std::floor(end / step_)));
         }
+        index = 0;
+        direction = 0;
+        return 0;
     }
 
-    void normalCase(Point start, Point end, double slope, Points& points) const
+    static void next(std::int64_t& index, int direction, std::int64_t& count)
     {
-        double inverseSlope = 1 / slope;
-        double b = start.y - slope * start.x;
-
-        bool isLeftRight = start.x < end.x;
-        if (!isLeftRight)
-        {
-            Point tmp = start;
-            start = end;
-            end = tmp;
-        }
-
-        double xStart = ceil(start.x);
-        double xEnd = end.x;
-        for (double x = xStart; x < xEnd; x += step_)
-            points.push_back(Point(x, slope * x + b));
-
-        bool isBottomTop = start.y < end.y;
-        if (!isBottomTop)
-        {
-            Point tmp = start;
-            start = end;
-            end = tmp;
-        }
-
-        double yStart = ceil(start.y);
-        double yEnd = end.y;
-        for (double y = yStart; y < yEnd; y += step_)
-            points.push_back(Point((y - b) * inverseSlope, y));
-
-        if (isLeftRight)
-            std::sort(points.begin(), points.end(), sort_x());
-        else
-            std::sort(points.begin(), points.end(), sort_reverse_x());
+        index += direction;
+        --count;
     }
 
-    void mergeResults(const Points& points, Points& result) const
+    static void append(const Point& point, Points& result)
     {
-        for (std::size_t i = 0; i < points.size(); ++i) {
-            Point candidate = points[i];
-            if (result.size() > 0)  {
-                Point last = result[result.size() - 1];
-                if (std::abs(last.x - candidate.x) < std::numeric_limits<double>::epsilon() &&
-                    std::abs(last.y - candidate.y) < std::numeric_limits<double>::epsilon())
-                    continue;
-            }
-
-            result.push_back(candidate);
+        if (!result.empty()) {
+            const Point& last = result.back();
+            if (std::abs(last.x - point.x) < std::numeric_limits<double>::epsilon() &&
+                std::abs(last.y - point.y) < std::numeric_limits<double>::epsilon())
+                return;
         }
+        result.push_back(point);
     }
 
     double scale_;
@@ -0,0 +1,105 @@
+#ifndef BUILDERS_TERRAIN_OFFSETPATHCACHE_HPP_DEFINED
+#define BUILDERS_TERRAIN_OFFSETPATHCACHE_HPP_DEFINED
+
+#include "clipper/clipper.hpp"
+#include "hashing/MurmurHash3.h"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace utymap { namespace builders {
+
+/// Keeps results of offsetting line geometry, so the same way is not buffered again when
+/// tile is rebuilt. Size is bounded by total amount of cached points: least recently used
+/// results are removed first. Thread safe.
+class OffsetPathCache final
+{
+    struct Entry
+    {
+        ClipperLib::Paths paths;
+        std::size_t points;
+        /// Position in list of recently used keys.
+        std::list<std::uint64_t>::iterator usage;
+    };
+
+public:
+    explicit OffsetPathCache(std::size_t maxPoints) : maxPoints_(maxPoints), points_(0)
+    {
+    }
+
+    /// Creates key from element id, level of detail, offset width and source geometry.
+    static std::uint64_t createKey(std::uint64_t id, int levelOfDetail, ClipperLib::cInt width, const ClipperLib::Paths& paths)
+    {
+        std::vector<ClipperLib::cInt> data = { static_cast<ClipperLib::cInt>(id), levelOfDetail, width };
+        for (const auto& path : paths) {
+            data.push_back(static_cast<ClipperLib::cInt>(path.size()));
+            for (const auto& point : path) {
+                data.push_back(point.X);
+                data.push_back(point.Y);
+            }
+        }
+
+        std::uint64_t hash[2];
+        MurmurHash3_x64_128(data.data(), static_cast<int>(data.size() * sizeof(ClipperLib::cInt)), 0, hash);
+        return hash[0];
+    }
+
+    /// Copies cached paths to result. Returns false if there is no such key.
+    bool get(std::uint64_t key, ClipperLib::Paths& result)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto entry = entries_.find(key);
+        if (entry == entries_.end())
+            return false;
+
+        usage_.splice(usage_.begin(), usage_, entry->second.usage);
+        result = entry->second.paths;
+        return true;
+    }
+
+    /// Stores paths evicting least recently used ones if needed.
+    void put(std::uint64_t key, const ClipperLib::Paths& paths)
+    {
+        std::size_t points = 0;
+        for (const auto& path : paths)
+            points += path.size();
+        if (points > maxPoints_)
+            return;
+
+        std::lock_guard<std::mutex> lock(lock_);
+        if (entries_.find(key) != entries_.end())
+            return;
+
+        usage_.push_front(key);
+        entries_.emplace(key, Entry { paths, points, usage_.begin() });
+        points_ += points;
+
+        while (points_ > maxPoints_) {
+            auto last = entries_.find(usage_.back());
+            points_ -= last->second.points;
+            entries_.erase(last);
+            usage_.pop_back();
+        }
+    }
+
+    /// Returns amount of cached results.
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        return entries_.size();
+    }
+
+private:
+    const std::size_t maxPoints_;
+    std::size_t points_;
+    mutable std::mutex lock_;
+    std::unordered_map<std::uint64_t, Entry> entries_;
+    std::list<std::uint64_t> usage_;
+};
+
+}}
+
+#endif // BUILDERS_TERRAIN_OFFSETPATHCACHE_HPP_DEFINED
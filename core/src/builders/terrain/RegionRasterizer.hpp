@@ -0,0 +1,94 @@
+#ifndef BUILDERS_TERRAIN_REGIONRASTERIZER_HPP_DEFINED
+#define BUILDERS_TERRAIN_REGIONRASTERIZER_HPP_DEFINED
+
+#include "clipper/clipper.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace utymap { namespace builders {
+
+/// Assigns region ids to vertices of regular grid using scanline rasterization of region
+/// paths with non zero fill rule. Vertex keeps id of the first region which covers it.
+class RegionRasterizer final
+{
+public:
+    static const int NoRegion = -1;
+
+    RegionRasterizer(const ClipperLib::IntRect& bounds, int columns, int rows) :
+        bounds_(bounds), columns_(columns), rows_(rows),
+        ids_(static_cast<std::size_t>((columns + 1) * (rows + 1)), static_cast<int>(NoRegion))
+    {
+    }
+
+    /// Assigns given id to not yet covered vertices inside paths.
+    void fill(const ClipperLib::Paths& paths, int id)
+    {
+        std::vector<std::pair<double, int>> crossings;
+        for (int row = 0; row <= rows_; ++row) {
+            double y = getY(row);
+
+            crossings.clear();
+            for (const auto& path : paths) {
+                for (std::size_t i = 0; i < path.size(); ++i) {
+                    const auto& a = path[i];
+                    const auto& b = path[i + 1 == path.size() ? 0 : i + 1];
+                    // NOTE half open interval prevents counting shared vertices twice.
+                    bool isUpward = a.Y <= y && y < b.Y;
+                    bool isDownward = b.Y <= y && y < a.Y;
+                    if (!isUpward && !isDownward)
+                        continue;
+                    double x = a.X + (y - a.Y) * static_cast<double>(b.X - a.X) / (b.Y - a.Y);
+                    crossings.push_back(std::make_pair(x, isUpward ? 1 : -1));
+                }
+            }
+            std::sort(crossings.begin(), crossings.end());
+
+            int winding = 0;
+            int column = 0;
+            for (std::size_t i = 0; i + 1 < crossings.size() && column <= columns_; ++i) {
+                winding += crossings[i].second;
+                if (winding == 0)
+                    continue;
+
+                while (column <= columns_ && getX(column) < crossings[i].first)
+                    ++column;
+                for (; column <= columns_ && getX(column) < crossings[i + 1].first; ++column) {
+                    int& vertexId = ids_[row * (columns_ + 1) + column];
+                    if (vertexId == NoRegion)
+                        vertexId = id;
+                }
+            }
+        }
+    }
+
+    /// Returns region id of vertex or NoRegion.
+    int get(int column, int row) const { return ids_[row * (columns_ + 1) + column]; }
+
+    int getColumns() const { return columns_; }
+
+    int getRows() const { return rows_; }
+
+    /// Returns x coordinate of vertex column.
+    double getX(int column) const
+    {
+        return bounds_.left + static_cast<double>(bounds_.right - bounds_.left) * column / columns_;
+    }
+
+    /// Returns y coordinate of vertex row.
+    double getY(int row) const
+    {
+        return bounds_.top + static_cast<double>(bounds_.bottom - bounds_.top) * row / rows_;
+    }
+
+private:
+    const ClipperLib::IntRect bounds_;
+    const int columns_;
+    const int rows_;
+    std::vector<int> ids_;
+};
+
+}}
+
+#endif // BUILDERS_TERRAIN_REGIONRASTERIZER_HPP_DEFINED
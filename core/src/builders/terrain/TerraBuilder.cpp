@@ -1,17 +1,21 @@
 #include "BoundingBox.hpp"
 #include "clipper/clipper.hpp"
 #include "builders/BuilderContext.hpp"
+#include "builders/terrain/OffsetPathCache.hpp"
 #include "builders/terrain/TerraBuilder.hpp"
 #include "builders/terrain/TerraGenerator.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
+#include "meshing/Polygon.hpp"
 
 #include "utils/CoreUtils.hpp"
 #include "utils/GeoUtils.hpp"
 #include "utils/GeometryUtils.hpp"
 
+#include <limits>
+
 using namespace ClipperLib;
 using namespace utymap::builders;
 using namespace utymap::entities;
@@ -25,6 +29,21 @@ namespace {
     const double Scale = 1E7;
     const std::string TerrainLayerKey = "terrain-layer";
     const std::string WidthKey = "width";
+    const std::string GradientKey = "color";
+    const std::string TextureAtlasKey = "texture-atlas";
+    const std::string TextureMaterialKey = "texture-material";
+    const std::string PreviewMeshName = "terrain_preview";
+    /// Amount of preview triangles along quadkey side: elevation is sampled only in their vertices.
+    const double PreviewCells = 4;
+    /// Max amount of points in cached offset results shared by all builders.
+    const std::size_t MaxOffsetCachePoints = 4 * 1024 * 1024;
+
+    /// Returns cache of offset ways which survives tile rebuilds.
+    OffsetPathCache& getOffsetCache()
+    {
+        static OffsetPathCache cache(MaxOffsetCachePoints);
+        return cache;
+    }
 
     /// Converts coordinate to clipper's IntPoint.
     IntPoint toIntPoint(double x, double y)
@@ -69,7 +88,10 @@ public:
         ElementBuilder(context), 
         style_(context.styleProvider.forCanvas(context.quadKey.levelOfDetail)), 
         clipper_(),
-        generator_(context, style_, clipper_)
+        generator_(context, style_),
+        terrainLayerKeyId_(context.stringTable.getId(TerrainLayerKey)),
+        widthKeyId_(context.stringTable.getId(WidthKey)),
+        relationDepth_(0)
     {
         tileRect_.push_back(toIntPoint(context.boundingBox.minPoint.longitude, context.boundingBox.minPoint.latitude));
         tileRect_.push_back(toIntPoint(context.boundingBox.maxPoint.longitude, context.boundingBox.minPoint.latitude));
@@ -85,18 +107,23 @@ public:
 
     void visitWay(const utymap::entities::Way& way) override
     {
-        Style style = context_.styleProvider.forElement(way, context_.quadKey.levelOfDetail);
+        Style style = getStyle(way);
         auto region = createRegion(style, way.coordinates);
 
         // make polygon from line by offsetting it using width specified
-        double width = style.getValue(WidthKey, 
+        double width = style.getValue(widthKeyId_, 
             context_.boundingBox.maxPoint.latitude - context_.boundingBox.minPoint.latitude,
-            context_.boundingBox.center());
+            context_.boundingBox.center(), context_.metricScale);
 
         Paths solution;
-        offset_.AddPaths(region->points, jtMiter, etOpenSquare);
-        offset_.Execute(solution, width *  Scale);
-        offset_.Clear();
+        auto key = OffsetPathCache::createKey(way.id, context_.quadKey.levelOfDetail,
+            static_cast<cInt>(width * Scale), region->points);
+        if (!getOffsetCache().get(key, solution)) {
+            offset_.AddPaths(region->points, jtMiter, etOpenSquare);
+            offset_.Execute(solution, width *  Scale);
+            offset_.Clear();
+            getOffsetCache().put(key, solution);
+        }
        
         clipper_.AddPaths(solution, ptSubject, true);
         clipper_.Execute(ctIntersection, solution);
@@ -104,17 +131,17 @@ public:
 
         region->points = solution;
         std::string type = region->isLayer
-            ? style.getString(TerrainLayerKey)
+            ? style.getString(terrainLayerKeyId_)
             : "";
         generator_.addRegion(type, std::move(region));
     }
 
     void visitArea(const utymap::entities::Area& area) override
     {
-        Style style = context_.styleProvider.forElement(area, context_.quadKey.levelOfDetail);
+        Style style = getStyle(area);
         auto region = createRegion(style, area.coordinates);
         std::string type = region->isLayer
-            ? style.getString(TerrainLayerKey)
+            ? style.getString(terrainLayerKeyId_)
             : "";
         generator_.addRegion(type, std::move(region));
     }
@@ -123,7 +150,10 @@ public:
     {
         auto region = utymap::utils::make_unique<TerraGenerator::Region>();
         RelationVisitor visitor(*this, rel, *region);
+        // NOTE relation which is member of relation is piece of split polygon.
+        region->isPiece = relationDepth_ > 0;
 
+        ++relationDepth_;
         for (const auto& element : rel.elements) {
             // if there are no tags, then this element is result of clipping
             if (element->tags.empty())
@@ -132,15 +162,16 @@ public:
             if (context_.styleProvider.hasStyle(*element, context_.quadKey.levelOfDetail))
                 element->accept(visitor);
         }
+        --relationDepth_;
 
         if (!region->points.empty()) {
-            Style style = context_.styleProvider.forElement(rel, context_.quadKey.levelOfDetail);
-            region->isLayer = style.has(context_.stringTable.getId(TerrainLayerKey));
+            Style style = getStyle(rel);
+            region->isLayer = style.has(terrainLayerKeyId_);
             if (!region->isLayer)
                 region->context = utymap::utils::make_unique<TerraGenerator::RegionContext>(generator_.createRegionContext(style, ""));
 
             std::string type = region->isLayer 
-                ? style.getString(TerrainLayerKey)
+                ? style.getString(terrainLayerKeyId_)
                 : "";
             generator_.addRegion(type, std::move(region));
         }
@@ -148,9 +179,14 @@ public:
 
     /// builds tile mesh using data provided.
     void complete() override
+    {
+        while (completeStep()) { }
+    }
+
+    bool completeStep() override
     {
         clipper_.Clear();
-        generator_.generate(tileRect_);
+        return generator_.generateNext(tileRect_);
     }
 
 private:
@@ -165,7 +201,7 @@ private:
 
         region->points.push_back(path);
 
-        region->isLayer = style.has(context_.stringTable.getId(TerrainLayerKey));
+        region->isLayer = style.has(terrainLayerKeyId_);
         if (!region->isLayer)
             region->context = utymap::utils::make_unique<TerraGenerator::RegionContext>(generator_.createRegionContext(style, ""));
 
@@ -179,6 +215,10 @@ private:
     ClipperOffset offset_;
     TerraGenerator generator_;
     ClipperLib::Path tileRect_;
+    std::uint32_t terrainLayerKeyId_;
+    std::uint32_t widthKeyId_;
+    /// Depth of visited relation members.
+    int relationDepth_;
 };
 
 void TerraBuilder::visitNode(const utymap::entities::Node& node) { pimpl_->visitNode(node); }
@@ -191,6 +231,39 @@ void TerraBuilder::visitRelation(const utymap::entities::Relation& relation) { p
 
 void TerraBuilder::complete() { pimpl_->complete(); }
 
+bool TerraBuilder::completeStep() { return pimpl_->completeStep(); }
+
+void TerraBuilder::prepareStyle(const utymap::entities::Element& element, const Style& style)
+{
+    pimpl_->prepareStyle(element, style);
+}
+
+void TerraBuilder::buildPreview(const BuilderContext& context)
+{
+    Style style = context.styleProvider.forCanvas(context.quadKey.levelOfDetail);
+    const BoundingBox& bbox = context.boundingBox;
+    double cellSize = (bbox.maxPoint.latitude - bbox.minPoint.latitude) / PreviewCells;
+
+    Polygon polygon(4, 0);
+    polygon.addContour(std::vector<Vector2> {
+        Vector2(bbox.minPoint.longitude, bbox.minPoint.latitude),
+        Vector2(bbox.maxPoint.longitude, bbox.minPoint.latitude),
+        Vector2(bbox.maxPoint.longitude, bbox.maxPoint.latitude),
+        Vector2(bbox.minPoint.longitude, bbox.maxPoint.latitude)
+    });
+
+    MeshBuilder::GeometryOptions geometryOptions(cellSize * cellSize, 0,
+        std::numeric_limits<double>::lowest(), 0);
+    MeshBuilder::AppearanceOptions appearanceOptions(
+        context.styleProvider.getGradient(style.getString(GradientKey)), 0,
+        context.styleProvider.getTexture(style.getString(TextureAtlasKey),
+                                         style.getString(TextureMaterialKey)).random(0), 1);
+
+    Mesh mesh(PreviewMeshName);
+    context.meshBuilder.addPolygon(mesh, polygon, geometryOptions, appearanceOptions);
+    context.meshCallback(mesh);
+}
+
 TerraBuilder::~TerraBuilder() { }
 
 TerraBuilder::TerraBuilder(const BuilderContext& context) :
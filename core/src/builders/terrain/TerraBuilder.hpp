@@ -27,6 +27,15 @@ public:
 
     void complete() override;
 
+    /// Runs completion by generation steps: layer by layer, then background.
+    bool completeStep() override;
+
+    void prepareStyle(const utymap::entities::Element&, const utymap::mapcss::Style&) override;
+
+    /// Builds coarse terrain of the whole quadkey using background style of canvas only.
+    /// It is cheap, so it can be reported before the quadkey is built to avoid holes.
+    static void buildPreview(const utymap::builders::BuilderContext&);
+
 private:
     class TerraBuilderImpl;
     std::unique_ptr<TerraBuilderImpl> pimpl_;
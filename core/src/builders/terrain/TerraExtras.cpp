@@ -1,18 +1,46 @@
 #include "builders/terrain/TerraExtras.hpp"
 #include "builders/poi/TreeBuilder.hpp"
+#include "meshing/MeshPool.hpp"
 #include "utils/MeshUtils.hpp"
+#include "utils/NoiseUtils.hpp"
 
 #include <algorithm>
+#include <cmath>
 
 using namespace utymap::builders;
 using namespace utymap::meshing;
+using namespace utymap::utils;
 
 namespace {
     const std::string TreeFrequencyKey = "tree-frequency";
+    const std::string TreeScaleVarianceKey = "tree-scale-variance";
+    const double Pi = std::acos(-1);
+
+    /// Calls function with centroid of every n-th triangle of mesh region.
+    template <typename Function>
+    void forEachTreePosition(const TerraExtras::Context& extrasContext, Function function)
+    {
+        int step = 3 * static_cast<int>(std::max(extrasContext.style.getValue(TreeFrequencyKey), 1.));
+        for (auto i = extrasContext.startTriangle; i < extrasContext.mesh.triangles.size(); i += step) {
+            double centroidX = 0;
+            double centroidY = 0;
+            for (int j = 0; j < 3; j++) {
+                int index = extrasContext.mesh.triangles[i + j] * 3;
+                centroidX += extrasContext.mesh.vertices[index];
+                centroidY += extrasContext.mesh.vertices[index + 1];
+            }
+            function(centroidX / 3, centroidY / 3);
+        }
+    }
 }
 
 void TerraExtras::addForest(const BuilderContext& builderContext, TerraExtras::Context& extrasContext)
 {
+    if (builderContext.instancesCallback) {
+        addForestInstances(builderContext, extrasContext);
+        return;
+    }
+
     // generate tree mesh
     Mesh treeMesh("");
     MeshContext meshContext(treeMesh, extrasContext.style, utymap::mapcss::ColorGradient(), utymap::mapcss::TextureRegion());
@@ -21,29 +49,37 @@ void TerraExtras::addForest(const BuilderContext& builderContext, TerraExtras::C
     generator->generate();
 
     // forest mesh contains all trees
-    Mesh forestMesh("forest");
-  
+    auto forestMesh = MeshPool::local().acquire("forest");
+
     // go through mesh region triangles and insert copy of the tree
-    int step = 3 * static_cast<int>(std::max(extrasContext.style.getValue(TreeFrequencyKey), 1.)); 
-    for (auto i = extrasContext.startTriangle; i < extrasContext.mesh.triangles.size(); i += step) {
-
-        double centroidX = 0;
-        double centroidY = 0;
-        for (int j = 0; j < 3; j++) {
-            int index = extrasContext.mesh.triangles[i + j] * 3;
-            centroidX += extrasContext.mesh.vertices[index];
-            centroidY += extrasContext.mesh.vertices[index + 1];
-        }
+    forEachTreePosition(extrasContext, [&](double x, double y) {
+        double elevation = builderContext.eleProvider.getElevation(x, y);
+        utymap::utils::copyMesh(Vector3(x, elevation, y), treeMesh, *forestMesh);
+    });
 
-        centroidX /= 3;
-        centroidY /= 3;
+    builderContext.meshCallback(*forestMesh);
+}
 
-        double elevation = builderContext.eleProvider.getElevation(centroidX, centroidY);
+void TerraExtras::addForestInstances(const BuilderContext& builderContext, TerraExtras::Context& extrasContext)
+{
+    MeshInstances forest("forest");
+    MeshContext meshContext(forest.prototype, extrasContext.style, utymap::mapcss::ColorGradient(), utymap::mapcss::TextureRegion());
+    auto generator = TreeBuilder::createGenerator(builderContext, meshContext);
+    generator->setPosition(Vector3(0, 0, 0));
+    generator->generate();
 
-        utymap::utils::copyMesh(Vector3(centroidX, elevation, centroidY), treeMesh, forestMesh);
-    }
+    double scaleVariance = extrasContext.style.getValue(TreeScaleVarianceKey);
+    forEachTreePosition(extrasContext, [&](double x, double y) {
+        forest.transforms.insert(forest.transforms.end(), {
+            x, y, builderContext.eleProvider.getElevation(x, y),
+            1 + scaleVariance * (2 * NoiseUtils::random(x, y, 0) - 1),
+            2 * Pi * NoiseUtils::random(x, y, 1),
+            NoiseUtils::random(x, y, 2)
+        });
+    });
 
-    builderContext.meshCallback(forestMesh);
+    if (forest.size() > 0)
+        builderContext.instancesCallback(forest);
 }
 
 void TerraExtras::addWater(const BuilderContext& builderContext, TerraExtras::Context& eeshContext)
@@ -35,9 +35,14 @@ public:
     /// Specifies Extras function signature.
     typedef std::function<void(const utymap::builders::BuilderContext&, TerraExtras::Context&)> ExtrasFunc;
 
-    /// Extends mesh with trees.
+    /// Extends mesh with trees. If builder context has instances callback, trees are reported
+    /// as instances of single tree mesh instead.
     static void addForest(const utymap::builders::BuilderContext& builderContext, TerraExtras::Context& extrasContext);
 
+    /// Reports trees as instances of single tree mesh: each has position, scale varied by
+    /// "tree-scale-variance", rotation and color seed.
+    static void addForestInstances(const utymap::builders::BuilderContext& builderContext, TerraExtras::Context& extrasContext);
+
     /// Extends mesh with water surface.
     static void addWater(const utymap::builders::BuilderContext& builderContext, TerraExtras::Context& extrasContext);
 };
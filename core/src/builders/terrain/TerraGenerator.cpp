@@ -1,5 +1,10 @@
+#include "builders/terrain/RegionRasterizer.hpp"
 #include "builders/terrain/TerraGenerator.hpp"
+#include "utils/NoiseUtils.hpp"
+#include "utils/CoreUtils.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <functional>
 #include <unordered_map>
 
@@ -28,25 +33,134 @@ namespace {
     const std::string MeshNameKey = "mesh-name";
     const std::string MeshExtrasKey = "mesh-extras";
     const std::string GridCellSize = "grid-cell-size";
+    const std::string MeshTasksKey = "mesh-tasks";
+    const std::string MeshChunkSizeKey = "mesh-chunk-size";
+    const std::string GridLodKey = "grid-lod";
+    const std::string SkirtDepthKey = "skirt-depth";
+    const std::string TerrainModeKey = "terrain-mode";
+    const std::string GridTerrainMode = "grid";
+    const std::string TerrainCacheKey = "terrain-cache";
+    /// Max amount of tiles which results are cached.
+    const std::size_t MaxCachedTiles = 16;
+    /// Keys of region declarations which affect its mesh.
+    const std::vector<std::string> ResultContextKeys =
+    {
+        MaxAreaKey, EleNoiseFreqKey, HeightOffsetKey, TextureScaleKey, TextureAtlasKey,
+        TextureMaterialKey, ColorNoiseFreqKey, GradientKey, MeshNameKey, MeshExtrasKey
+    };
+    /// Max amount of cells along one side of tile in grid mode.
+    const int MaxGridCells = 1024;
+    /// Max amount of buffers kept by one thread.
+    const std::size_t MaxPooledBuffers = 4;
 
     const std::unordered_map<std::string, TerraExtras::ExtrasFunc> ExtrasFuncs = 
     {
         { "forest", std::bind(&TerraExtras::addForest, _1, _2) },
         { "water", std::bind(&TerraExtras::addWater, _1, _2) },
     };
+
+    /// Returns bounds of tile in clipper coordinates.
+    IntRect createTileRect(const utymap::BoundingBox& bbox)
+    {
+        IntRect rect;
+        rect.left = static_cast<cInt>(bbox.minPoint.longitude * Scale);
+        rect.top = static_cast<cInt>(bbox.minPoint.latitude * Scale);
+        rect.right = static_cast<cInt>(bbox.maxPoint.longitude * Scale);
+        rect.bottom = static_cast<cInt>(bbox.maxPoint.latitude * Scale);
+        return rect;
+    }
+
+    /// Returns cache shared by all generators.
+    TerrainCache& getTerrainCache()
+    {
+        static TerrainCache cache(MaxCachedTiles);
+        return cache;
+    }
+
+    /// Combines hash value with seed.
+    std::uint64_t combineHash(std::uint64_t seed, std::uint64_t value)
+    {
+        return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    }
+
+    /// Combines hash of points of given paths with seed.
+    std::uint64_t hashPaths(std::uint64_t seed, const Paths& paths)
+    {
+        for (const auto& path : paths) {
+            seed = combineHash(seed, path.size());
+            for (const auto& point : path)
+                seed = combineHash(combineHash(seed, static_cast<std::uint64_t>(point.X)),
+                                   static_cast<std::uint64_t>(point.Y));
+        }
+        return seed;
+    }
+
+    /// Expands bounds to include given one.
+    void expandBounds(IntRect& bounds, const IntRect& other)
+    {
+        bounds.left = std::min(bounds.left, other.left);
+        bounds.top = std::min(bounds.top, other.top);
+        bounds.right = std::max(bounds.right, other.right);
+        bounds.bottom = std::max(bounds.bottom, other.bottom);
+    }
+
+    bool intersects(const IntRect& a, const IntRect& b)
+    {
+        return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+    }
+
+    /// Appends all geometry of source mesh to destination one.
+    void appendMesh(const Mesh& source, Mesh& destination)
+    {
+        int startIndex = static_cast<int>(destination.vertices.size() / 3);
+        destination.vertices.insert(destination.vertices.end(), source.vertices.begin(), source.vertices.end());
+        destination.colors.insert(destination.colors.end(), source.colors.begin(), source.colors.end());
+        destination.uvs.insert(destination.uvs.end(), source.uvs.begin(), source.uvs.end());
+        destination.triangles.reserve(destination.triangles.size() + source.triangles.size());
+        for (int index : source.triangles)
+            destination.triangles.push_back(index + startIndex);
+    }
 };
 
-TerraGenerator::TerraGenerator(const BuilderContext& context, const Style& style, ClipperEx& foregroundClipper) :
+TerraGenerator::TerraGenerator(const BuilderContext& context, const Style& style) :
     context_(context),
     style_(style),
-    foregroundClipper_(foregroundClipper),
+    foreground_(createTileRect(context.boundingBox)),
     backGroundClipper_(),
-    mesh_(TerrainMeshName),
+    mesh_(MeshPool::local().acquire(TerrainMeshName)),
+    chunker_(context.meshCallback, TerrainMeshName,
+             static_cast<std::size_t>(std::max(style.getValue(MeshChunkSizeKey), 0.))),
     rect_(context.boundingBox.minPoint.longitude,
           context.boundingBox.minPoint.latitude,
           context.boundingBox.maxPoint.longitude,
-          context.boundingBox.maxPoint.latitude)
+          context.boundingBox.maxPoint.latitude),
+    maxTasks_(0),
+    stage_(Stage::Start),
+    cellSize_(0),
+    tileKey_(0),
+    layerNames_(),
+    nextLayer_(0)
+{
+    auto& pool = getBuffersPool();
+    if (pool.empty())
+        buffers_ = utymap::utils::make_unique<Buffers>();
+    else {
+        buffers_ = std::move(pool.back());
+        pool.pop_back();
+    }
+}
+
+TerraGenerator::~TerraGenerator()
 {
+    auto& pool = getBuffersPool();
+    if (pool.size() < MaxPooledBuffers)
+        pool.push_back(std::move(buffers_));
+}
+
+std::vector<TerraGenerator::BuffersPtr>& TerraGenerator::getBuffersPool()
+{
+    static thread_local std::vector<BuffersPtr> pool;
+    return pool;
 }
 
 void TerraGenerator::addRegion(const std::string& type, std::unique_ptr<Region> region)
@@ -56,46 +170,105 @@ void TerraGenerator::addRegion(const std::string& type, std::unique_ptr<Region>
 
 void TerraGenerator::generate(Path& tileRect)
 {
-    double size = style_.getValue(GridCellSize,
-        context_.boundingBox.maxPoint.latitude - context_.boundingBox.minPoint.latitude, 
-        context_.boundingBox.center());
-    splitter_.setParams(Scale, size);
-
-    buildLayers();
-    buildBackground(tileRect);
+    while (generateNext(tileRect)) { }
+}
 
-    context_.meshCallback(mesh_);
+bool TerraGenerator::generateNext(Path& tileRect)
+{
+    switch (stage_) {
+        case Stage::Start:
+            start();
+            return true;
+        case Stage::Layers:
+            // 1. process layers: regions with shared properties.
+            while (nextLayer_ < layerNames_.size()) {
+                const std::string& name = layerNames_[nextLayer_++];
+                auto layer = layers_.find(name);
+                if (layer != layers_.end()) {
+                    buildFromRegions(layer->second, createRegionContext(style_, name + "-"));
+                    layers_.erase(layer);
+                    return true;
+                }
+            }
+            stage_ = Stage::Regions;
+            return true;
+        case Stage::Regions:
+            // 2. Process the rest: each region has already its own properties.
+            while (!layers_.empty()) {
+                auto layer = layers_.begin();
+                if (layer->second.empty()) {
+                    layers_.erase(layer);
+                    continue;
+                }
+                buildFromRegion(*layer->second.top());
+                layer->second.pop();
+                return true;
+            }
+            stage_ = Stage::Background;
+            return true;
+        case Stage::Background:
+            buildBackground(tileRect);
+            completeTasks();
+            if (results_ != nullptr)
+                getTerrainCache().put(tileKey_, results_);
+            stage_ = Stage::Skirts;
+            return true;
+        case Stage::Skirts:
+        {
+            double skirtDepth = style_.getValue(SkirtDepthKey);
+            if (skirtDepth > 0)
+                buildSkirts(tileRect, skirtDepth);
+
+            chunker_.flush(*mesh_);
+            stage_ = Stage::Done;
+            return false;
+        }
+        default:
+            return false;
+    }
 }
 
-/// process all found layers.
-void TerraGenerator::buildLayers()
+void TerraGenerator::start()
 {
-    // 1. process layers: regions with shared properties.
+    double gridLod = style_.getValue(GridLodKey);
+    cellSize_ = gridLod > 0
+        ? 360. / std::pow(2, gridLod)
+        : style_.getValue(GridCellSize,
+            context_.boundingBox.maxPoint.latitude - context_.boundingBox.minPoint.latitude,
+            context_.boundingBox.center(), context_.metricScale);
+    splitter_.setParams(Scale, cellSize_);
+    maxTasks_ = static_cast<std::size_t>(std::max(style_.getValue(MeshTasksKey), 0.));
+
+    if (style_.getString(TerrainModeKey) == GridTerrainMode) {
+        buildGrid(cellSize_);
+        stage_ = Stage::Skirts;
+        return;
+    }
+
+    if (style_.getValue(TerrainCacheKey) > 0) {
+        const utymap::QuadKey& quadKey = context_.quadKey;
+        tileKey_ = combineHash(combineHash(quadKey.levelOfDetail, quadKey.tileX), quadKey.tileY);
+        tileKey_ = combineHash(tileKey_, context_.styleProvider.getFingerprintVersion());
+        tileKey_ = combineHash(tileKey_, reinterpret_cast<std::uintptr_t>(&context_.eleProvider));
+        tileKey_ = combineHash(tileKey_, std::hash<double>()(cellSize_));
+        cachedResults_ = getTerrainCache().get(tileKey_);
+        results_ = std::make_shared<TerrainCache::TileResults>();
+    }
+
     std::stringstream ss(style_.getString(LayerPriorityKey));
     while (ss.good()) {
         std::string name;
         getline(ss, name, ',');
-        auto layer = layers_.find(name);
-        if (layer != layers_.end()) {
-            buildFromRegions(layer->second, createRegionContext(style_, name + "-"));
-            layers_.erase(layer);
-        }
+        layerNames_.push_back(name);
     }
-
-    // 2. Process the rest: each region has already its own properties.
-    for (auto& layer : layers_)
-        while (!layer.second.empty()) {
-            auto& region = layer.second.top();
-            buildFromPaths(region->points, *region->context);
-            layer.second.pop();
-        }
+    stage_ = Stage::Layers;
 }
 
 /// process the rest area.
 void TerraGenerator::buildBackground(Path& tileRect)
 {
     backGroundClipper_.AddPath(tileRect, ptSubject, true);
-    Paths background;
+    Paths& background = buffers_->solution;
     backGroundClipper_.Execute(ctDifference, background, pftNonZero, pftNonZero);
     backGroundClipper_.Clear();
 
@@ -103,6 +276,107 @@ void TerraGenerator::buildBackground(Path& tileRect)
         populateMesh(background, createRegionContext(style_, ""));
 }
 
+void TerraGenerator::buildGrid(double cellSize)
+{
+    const BoundingBox& bbox = context_.boundingBox;
+    double width = bbox.maxPoint.longitude - bbox.minPoint.longitude;
+    double height = bbox.maxPoint.latitude - bbox.minPoint.latitude;
+    auto getCells = [&](double size) {
+        return cellSize > 0 ? std::max(1, std::min(MaxGridCells, static_cast<int>(std::round(size / cellSize)))) : 1;
+    };
+    RegionRasterizer rasterizer(createTileRect(bbox), getCells(width), getCells(height));
+
+    // 1. rasterize regions in the same order as they are clipped in default mode.
+    std::vector<std::unique_ptr<RegionContext>> contexts;
+    std::stringstream ss(style_.getString(LayerPriorityKey));
+    while (ss.good()) {
+        std::string name;
+        getline(ss, name, ',');
+        auto layer = layers_.find(name);
+        if (layer == layers_.end())
+            continue;
+
+        Paths paths;
+        for (; !layer->second.empty(); layer->second.pop())
+            paths.insert(paths.end(), layer->second.top()->points.begin(), layer->second.top()->points.end());
+        rasterizer.fill(paths, static_cast<int>(contexts.size()));
+        contexts.push_back(utymap::utils::make_unique<RegionContext>(createRegionContext(style_, name + "-")));
+        layers_.erase(layer);
+    }
+
+    for (auto& layer : layers_)
+        for (; !layer.second.empty(); layer.second.pop()) {
+            const auto& region = layer.second.top();
+            rasterizer.fill(region->points, static_cast<int>(contexts.size()));
+            contexts.push_back(utymap::utils::make_unique<RegionContext>(*region->context));
+        }
+    RegionContext background = createRegionContext(style_, "");
+
+    // 2. create vertices using appearance of region.
+    int columns = rasterizer.getColumns();
+    int rows = rasterizer.getRows();
+    std::size_t count = static_cast<std::size_t>((columns + 1) * (rows + 1));
+    std::vector<double> points;
+    points.reserve(count * 2);
+    for (int row = 0; row <= rows; ++row)
+        for (int column = 0; column <= columns; ++column) {
+            points.push_back(rasterizer.getX(column) / Scale);
+            points.push_back(rasterizer.getY(row) / Scale);
+        }
+    std::vector<double> elevations(count);
+    context_.eleProvider.getElevations(points.data(), count, elevations.data());
+
+    int startIndex = static_cast<int>(mesh_->vertices.size() / 3);
+    mesh_->vertices.reserve(mesh_->vertices.size() + count * 3);
+    mesh_->colors.reserve(mesh_->colors.size() + count);
+    mesh_->uvs.reserve(mesh_->uvs.size() + count * 2);
+    for (std::size_t i = 0; i < count; ++i) {
+        int id = rasterizer.get(static_cast<int>(i % (columns + 1)), static_cast<int>(i / (columns + 1)));
+        const RegionContext& regionContext = id == RegionRasterizer::NoRegion ? background : *contexts[id];
+        const auto& appearance = regionContext.appearanceOptions;
+        double x = points[i * 2];
+        double y = points[i * 2 + 1];
+
+        mesh_->vertices.push_back(x);
+        mesh_->vertices.push_back(y);
+        mesh_->vertices.push_back(elevations[i] + NoiseUtils::perlin2D(x, y, regionContext.geometryOptions.eleNoiseFreq));
+
+        double colorNoise = NoiseUtils::perlin2D(x, y, appearance.colorNoiseFreq);
+        mesh_->colors.push_back(static_cast<int>(appearance.gradient.lookup((colorNoise + 1) / 2)));
+
+        Vector2 uv = appearance.textureRegion.isEmpty()
+            ? Vector2(0, 0)
+            : appearance.textureRegion.map(Vector2((x - bbox.minPoint.longitude) / width * appearance.textureScale,
+                                                   (y - bbox.minPoint.latitude) / height * appearance.textureScale));
+        mesh_->uvs.push_back(uv.x);
+        mesh_->uvs.push_back(uv.y);
+    }
+
+    // 3. create two triangles per cell with the same orientation as triangulated ones.
+    mesh_->triangles.reserve(mesh_->triangles.size() + static_cast<std::size_t>(columns * rows * 6));
+    for (int row = 0; row < rows; ++row)
+        for (int column = 0; column < columns; ++column) {
+            int v00 = startIndex + row * (columns + 1) + column;
+            int v10 = v00 + 1;
+            int v01 = v00 + columns + 1;
+            int v11 = v01 + 1;
+            mesh_->triangles.insert(mesh_->triangles.end(), { v00, v11, v10, v00, v01, v11 });
+        }
+}
+
+void TerraGenerator::buildSkirts(const Path& tileRect, double depth)
+{
+    RegionContext regionContext = createRegionContext(style_, "");
+    // NOTE boundary vertices have no elevation noise, so skirt is attached to them exactly.
+    auto geometryOptions = regionContext.geometryOptions;
+    geometryOptions.eleNoiseFreq = 0;
+    geometryOptions.heightOffset = -depth;
+
+    Points points;
+    restorePoints(tileRect, points);
+    context_.meshBuilder.addWalls(*mesh_, points, geometryOptions, regionContext.appearanceOptions);
+}
+
 TerraGenerator::RegionContext TerraGenerator::createRegionContext(const Style& style, const std::string& prefix) const
 {
     double quadKeyWidth = context_.boundingBox.maxPoint.latitude - context_.boundingBox.minPoint.latitude;
@@ -136,97 +410,291 @@ TerraGenerator::RegionContext TerraGenerator::createRegionContext(const Style& s
 void TerraGenerator::buildFromRegions(Regions& regions, const RegionContext& regionContext)
 {
     // merge all regions together
-    Clipper clipper;
+    // NOTE clipper copies added paths, so region is released as soon as it is added.
+    Clipper& clipper = buffers_->clipper;
+    std::uint64_t inputHash = 0;
+    IntRect bounds = ClipPathIndex::getBounds(Paths());
+    std::vector<Paths> pieces;
+    bool hasMerged = false;
     while (!regions.empty()) {
-        clipper.AddPaths(regions.top()->points, ptSubject, true);
+        Region& region = *regions.top();
+        if (region.isPiece) {
+            pieces.push_back(std::move(region.points));
+            regions.pop();
+            continue;
+        }
+        if (results_ != nullptr) {
+            inputHash = hashPaths(inputHash, region.points);
+            expandBounds(bounds, ClipPathIndex::getBounds(region.points));
+        }
+        clipper.AddPaths(region.points, ptSubject, true);
+        hasMerged = true;
         regions.pop();
     }
 
-    Paths result;
-    clipper.Execute(ctUnion, result, pftNonZero, pftNonZero);
+    if (hasMerged) {
+        std::uint64_t key = results_ != nullptr ? createResultKey(inputHash, bounds, regionContext) : 0;
+        if (reuseResult(key, regionContext))
+            clipper.Clear();
+        else {
+            Paths& result = buffers_->regions;
+            clipper.Execute(ctUnion, result, pftNonZero, pftNonZero);
+            clipper.Clear();
+            buildFromPaths(result, regionContext, key);
+        }
+    }
+
+    // NOTE pieces do not overlap each other and merged regions are subtracted from them as foreground.
+    for (auto& piece : pieces) {
+        std::uint64_t key = results_ != nullptr
+            ? createResultKey(hashPaths(0, piece), ClipPathIndex::getBounds(piece), regionContext)
+            : 0;
+        if (!reuseResult(key, regionContext))
+            buildFromPaths(piece, regionContext, key);
+    }
+}
 
-    buildFromPaths(result, regionContext);
+void TerraGenerator::buildFromRegion(Region& region)
+{
+    const RegionContext& regionContext = *region.context;
+    std::uint64_t key = results_ != nullptr
+        ? createResultKey(hashPaths(0, region.points), ClipPathIndex::getBounds(region.points), regionContext)
+        : 0;
+    if (!reuseResult(key, regionContext))
+        buildFromPaths(region.points, regionContext, key);
 }
 
-void TerraGenerator::buildFromPaths(const Paths& paths, const RegionContext& regionContext)
+std::uint64_t TerraGenerator::createResultKey(std::uint64_t inputHash,
+                                              const IntRect& bounds,
+                                              const RegionContext& regionContext)
 {
-    Paths solution;
-    foregroundClipper_.AddPaths(paths, ptSubject, true);
-    foregroundClipper_.Execute(ctDifference, solution, pftNonZero, pftNonZero);
-    foregroundClipper_.moveSubjectToClip();
+    const Style& style = regionContext.style;
+    for (const auto& key : ResultContextKeys)
+        inputHash = combineHash(inputHash, std::hash<std::string>()(style.getString(regionContext.prefix + key)));
+
+    // NOTE result depends on all processed paths which can overlap these ones.
+    std::uint64_t resultKey = combineHash(inputHash, inputs_.size());
+    for (const auto& input : inputs_)
+        if (intersects(input.first, bounds))
+            resultKey = combineHash(resultKey, input.second);
+    inputs_.push_back(std::make_pair(bounds, inputHash));
+
+    return resultKey;
+}
 
-    populateMesh(solution, regionContext);
+bool TerraGenerator::reuseResult(std::uint64_t key, const RegionContext& regionContext)
+{
+    if (cachedResults_ == nullptr)
+        return false;
+    auto entry = cachedResults_->find(key);
+    if (entry == cachedResults_->end())
+        return false;
+
+    const TerrainCache::Result& result = *entry->second;
+    foreground_.add(Paths(result.foreground));
+    backGroundClipper_.AddPaths(result.clipped, ptClip, true);
+    results_->insert(*entry);
+
+    if (result.planes == nullptr)
+        return true;
+
+    auto task = utymap::utils::make_unique<MeshTask>();
+    task->regionContext = utymap::utils::make_unique<RegionContext>(regionContext);
+    task->meshName = regionContext.style.getString(regionContext.prefix + MeshNameKey);
+    task->hasPolygon = result.mesh != nullptr;
+    task->planes = MeshPool::local().acquire(TerrainMeshName);
+    task->mesh = MeshPool::local().acquire(task->meshName.empty() ? TerrainMeshName : task->meshName);
+    appendMesh(*result.planes, *task->planes);
+    if (task->hasPolygon)
+        appendMesh(*result.mesh, *task->mesh);
+    addFilledTask(std::move(task));
+    return true;
 }
 
-void TerraGenerator::populateMesh(Paths& paths, const RegionContext& regionContext)
+void TerraGenerator::buildFromPaths(Paths& paths, const RegionContext& regionContext, std::uint64_t key)
+{
+    // NOTE only paths which can overlap region affect difference.
+    Paths& clipPaths = buffers_->clip;
+    clipPaths.clear();
+    foreground_.query(ClipPathIndex::getBounds(paths), clipPaths);
+
+    Paths& solution = buffers_->solution;
+    Clipper& clipper = buffers_->clipper;
+    clipper.AddPaths(paths, ptSubject, true);
+    clipper.AddPaths(clipPaths, ptClip, true);
+    clipper.Execute(ctDifference, solution, pftNonZero, pftNonZero);
+    clipper.Clear();
+
+    std::shared_ptr<TerrainCache::Result> result;
+    if (key != 0) {
+        result = std::make_shared<TerrainCache::Result>();
+        result->foreground = paths;
+        results_->emplace(key, result);
+    }
+    foreground_.add(std::move(paths));
+    paths.clear();
+
+    populateMesh(solution, regionContext, result);
+}
+
+void TerraGenerator::populateMesh(Paths& paths, const RegionContext& regionContext,
+                                  const std::shared_ptr<TerrainCache::Result>& result)
 {
     ClipperLib::SimplifyPolygons(paths);
     ClipperLib::CleanPolygons(paths);
 
-    bool hasHeightOffset = std::abs(regionContext.geometryOptions.heightOffset) > 1E-8;
-    // calculate approximate size of overall points
-    double size = 0;
-    for (std::size_t i = 0; i < paths.size(); ++i)
-        size += paths[i].size() * 1.5;
-
-    Polygon polygon(static_cast<std::size_t>(size));
+    // restore contours first, so polygon is allocated with exact size.
+    auto& contours = buffers_->contours;
+    auto& isHole = buffers_->isHole;
+    std::size_t contourCount = 0, pointCount = 0, holeCount = 0;
+    isHole.clear();
     for (const Path& path : paths) {
         double area = ClipperLib::Area(path);
-        bool isHole = area < 0;
         if (std::abs(area) < AreaTolerance)
             continue;
 
         backGroundClipper_.AddPath(path, ptClip, true);
+        if (result != nullptr)
+            result->clipped.push_back(path);
+
+        if (contourCount == contours.size())
+            contours.emplace_back();
+        Points& points = contours[contourCount++];
+        points.clear();
+        restorePoints(path, points);
+
+        pointCount += points.size();
+        holeCount += area < 0 ? 1 : 0;
+        isHole.push_back(area < 0);
+    }
 
-        Points points = restorePoints(path);
-        if (isHole)
-            polygon.addHole(points);
+    if (contourCount == 0)
+        return;
+
+    bool hasHeightOffset = std::abs(regionContext.geometryOptions.heightOffset) > 1E-8;
+    auto task = utymap::utils::make_unique<MeshTask>();
+    task->polygon = utymap::utils::make_unique<Polygon>(pointCount, holeCount);
+    Polygon& polygon = *task->polygon;
+    for (std::size_t i = 0; i < contourCount; ++i) {
+        if (isHole[i])
+            polygon.addHole(contours[i]);
         else
-            polygon.addContour(points);
+            polygon.addContour(contours[i]);
 
         if (hasHeightOffset)
-            processHeightOffset(points, regionContext);
+            task->offsetContours.push_back(std::move(contours[i]));
     }
 
-    if (!polygon.points.empty())
-        fillMesh(polygon, regionContext);
+    if (polygon.points.empty() && task->offsetContours.empty())
+        return;
+
+    task->regionContext = utymap::utils::make_unique<RegionContext>(regionContext);
+    task->meshName = regionContext.style.getString(regionContext.prefix + MeshNameKey);
+    task->hasPolygon = !polygon.points.empty();
+    task->result = result;
+    scheduleTask(std::move(task));
 }
 
 // restores mesh points from clipper points and injects new ones according to grid.
-TerraGenerator::Points TerraGenerator::restorePoints(const Path& path) const
+void TerraGenerator::restorePoints(const Path& path, Points& points) const
 {
     auto lastItemIndex = path.size() - 1;
-    Points points;
-    points.reserve(path.size());
+    points.reserve(points.size() + path.size());
     for (int i = 0; i <= lastItemIndex; i++)
         splitter_.split(path[i], path[i == lastItemIndex ? 0 : i + 1], points);
-
-    return std::move(points);
 }
 
-void TerraGenerator::fillMesh(Polygon& polygon, const RegionContext& regionContext)
+void TerraGenerator::fillMesh(MeshTask& task) const
 {
-    std::string meshName = regionContext.style.getString(regionContext.prefix + MeshNameKey);
-    if (!meshName.empty()) {
-        Mesh polygonMesh(meshName);
-        TerraExtras::Context extrasContext(polygonMesh, regionContext.style);
-        context_.meshBuilder.addPolygon(polygonMesh, 
-                                        polygon, 
-                                        regionContext.geometryOptions, 
+    const RegionContext& regionContext = *task.regionContext;
+    for (const auto& points : task.offsetContours)
+        processHeightOffset(points, regionContext, *task.planes);
+
+    if (task.hasPolygon)
+        context_.meshBuilder.addPolygon(*task.mesh,
+                                        *task.polygon,
+                                        regionContext.geometryOptions,
                                         regionContext.appearanceOptions);
-        addExtrasIfNecessary(polygonMesh, extrasContext, regionContext);
-        context_.meshCallback(polygonMesh);
+}
+
+void TerraGenerator::scheduleTask(MeshTaskPtr task)
+{
+    // NOTE meshes are taken from pool of this thread as they are released here.
+    task->planes = MeshPool::local().acquire(TerrainMeshName);
+    task->mesh = MeshPool::local().acquire(task->meshName.empty() ? TerrainMeshName : task->meshName);
+
+    if (maxTasks_ == 0) {
+        fillMesh(*task);
+        completeTask(*task);
+        return;
     }
-    else {
-        TerraExtras::Context extrasContext(mesh_, regionContext.style);
-        context_.meshBuilder.addPolygon(mesh_,
-                                        polygon, 
-                                        regionContext.geometryOptions, 
-                                        regionContext.appearanceOptions);
-        addExtrasIfNecessary(mesh_, extrasContext, regionContext);
+
+    reserveTask();
+    MeshTask& taskRef = *task;
+    task->group = utymap::utils::make_unique<utymap::utils::TaskGroup>();
+    task->group->run([this, &taskRef]() { fillMesh(taskRef); });
+    tasks_.push_back(std::move(task));
+}
+
+void TerraGenerator::addFilledTask(MeshTaskPtr task)
+{
+    if (maxTasks_ == 0) {
+        completeTask(*task);
+        return;
+    }
+
+    reserveTask();
+    tasks_.push_back(std::move(task));
+}
+
+void TerraGenerator::reserveTask()
+{
+    if (tasks_.size() >= maxTasks_) {
+        completeTask(*tasks_.front());
+        tasks_.pop_front();
     }
 }
 
+void TerraGenerator::completeTask(MeshTask& task)
+{
+    if (task.group != nullptr)
+        task.group->wait();
+
+    // NOTE meshes are copied before extras are added, so cached ones keep only polygon geometry.
+    if (task.result != nullptr) {
+        task.result->planes = utymap::utils::make_unique<Mesh>(TerrainMeshName);
+        appendMesh(*task.planes, *task.result->planes);
+        if (task.hasPolygon) {
+            task.result->mesh = utymap::utils::make_unique<Mesh>(task.mesh->name);
+            appendMesh(*task.mesh, *task.result->mesh);
+        }
+    }
+
+    const RegionContext& regionContext = *task.regionContext;
+    appendMesh(*task.planes, *mesh_);
+
+    // NOTE extras report meshes through callback, so they are added here in order of layers.
+    if (task.hasPolygon && !task.meshName.empty()) {
+        TerraExtras::Context extrasContext(*task.mesh, regionContext.style);
+        addExtrasIfNecessary(*task.mesh, extrasContext, regionContext);
+        context_.meshCallback(*task.mesh);
+    }
+    else if (task.hasPolygon) {
+        TerraExtras::Context extrasContext(*mesh_, regionContext.style);
+        appendMesh(*task.mesh, *mesh_);
+        addExtrasIfNecessary(*mesh_, extrasContext, regionContext);
+    }
+
+    chunker_.flushIfNecessary(mesh_);
+}
+
+void TerraGenerator::completeTasks()
+{
+    for (const auto& task : tasks_)
+        completeTask(*task);
+    tasks_.clear();
+}
+
 void TerraGenerator::addExtrasIfNecessary(utymap::meshing::Mesh& mesh,
                                           TerraExtras::Context& extrasContext,
                                           const RegionContext& regionContext) const
@@ -238,20 +706,15 @@ void TerraGenerator::addExtrasIfNecessary(utymap::meshing::Mesh& mesh,
     ExtrasFuncs.at(meshExtras)(context_, extrasContext);
 }
 
-void TerraGenerator::processHeightOffset(const Points& points, const RegionContext& regionContext)
+void TerraGenerator::processHeightOffset(const Points& points, const RegionContext& regionContext, Mesh& mesh) const
 {
     // do not use elevation noise for height offset.
     auto newGeometryOptions = regionContext.geometryOptions;
     newGeometryOptions.eleNoiseFreq = 0;
 
-    for (std::size_t i = 0; i < points.size(); ++i) {
-        Vector2 p1 = points[i];
-        Vector2 p2 = points[i == (points.size() - 1) ? 0 : i + 1];
-
-        // check whether two points are on cell rect
-        if (rect_.isOnBorder(p1) && rect_.isOnBorder(p2))
-            continue;
-
-        context_.meshBuilder.addPlane(mesh_, p1, p2, newGeometryOptions, regionContext.appearanceOptions);
-    }
+    // skip edges which are on cell rect
+    context_.meshBuilder.addWalls(mesh, points, newGeometryOptions, regionContext.appearanceOptions,
+        [&](const Vector2& p1, const Vector2& p2) {
+            return !rect_.isOnBorder(p1) || !rect_.isOnBorder(p2);
+        });
 }
@@ -3,11 +3,18 @@
 
 #include "clipper/clipper.hpp"
 #include "builders/BuilderContext.hpp"
+#include "builders/MeshChunker.hpp"
+#include "builders/terrain/ClipPathIndex.hpp"
 #include "builders/terrain/LineGridSplitter.hpp"
 #include "builders/terrain/TerraExtras.hpp"
+#include "builders/terrain/TerrainCache.hpp"
 #include "meshing/MeshBuilder.hpp"
+#include "meshing/MeshPool.hpp"
 #include "meshing/MeshTypes.hpp"
+#include "utils/TaskScheduler.hpp"
 
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <unordered_map>
 #include <queue>
@@ -15,7 +22,19 @@
 
 namespace utymap { namespace builders {
 
-/// Provides the way to generate terrain mesh.
+/// Provides the way to generate terrain mesh. Clipping of layers is always done in priority
+/// order, but their triangulation can be done in parallel if "mesh-tasks" is specified in
+/// canvas style: its value is max amount of layers triangulated at the same time.
+/// If "grid-lod" is specified, paths are split by grid of tile size at given level of detail,
+/// so neighbour tiles of any level of detail have the same vertices on shared edges, and
+/// "skirt-depth" adds vertical stripes of given depth in meters along tile border to hide cracks.
+/// If "terrain-mode" is "grid", regular grid mesh with grid cell size is generated instead:
+/// each vertex gets elevation and appearance of the first region which covers it.
+/// If "terrain-cache" is set in default mode, results of clipping and triangulation of
+/// recently built tiles are kept, so tile rebuilt after local edit processes only layers and
+/// regions which can overlap changed ones. Background is always rebuilt.
+/// If "mesh-chunk-size" is set, terrain mesh is reported as chunks named "terrain#<index>" once
+/// it has at least given amount of vertices after merging of layer or region.
 class TerraGenerator final
 {
 public:
@@ -45,12 +64,12 @@ public:
     struct Region final
     {
         Region() : 
-            isLayer(false), area(0), context(nullptr), points() 
+            isLayer(false), isPiece(false), area(0), context(nullptr), points() 
         {
         }
 
         Region(Region&& other) :
-            isLayer(other.isLayer), area(other.area), 
+            isLayer(other.isLayer), isPiece(other.isPiece), area(other.area), 
             context(std::move(other.context)), points(std::move(other.points))
         {
         };
@@ -60,14 +79,18 @@ public:
         Region&operator=(Region&&) = delete;
 
         bool isLayer;
+        /// Region is piece of polygon split by store: it is not merged with other regions of
+        /// its layer, so large polygon is clipped and triangulated piece by piece.
+        bool isPiece;
         double area;
         std::unique_ptr<RegionContext> context; // optional: might be empty if polygon is layer
         ClipperLib::Paths points;
     };
 
     TerraGenerator(const BuilderContext& context,
-                   const utymap::mapcss::Style& style,
-                   ClipperLib::ClipperEx& foregroundClipper_);
+                   const utymap::mapcss::Style& style);
+
+    ~TerraGenerator();
 
     /// Adds region
     void addRegion(const std::string& type, std::unique_ptr<Region> region);
@@ -75,6 +98,10 @@ public:
     /// Generates mesh and calls callback from context.
     void generate(ClipperLib::Path& tileRect);
 
+    /// Runs next step of generation: setup, every prioritized layer, every other region,
+    /// background and skirts. Returns false when mesh is generated and reported.
+    bool generateNext(ClipperLib::Path& tileRect);
+
     /// Creates region  context.
     RegionContext createRegionContext(const utymap::mapcss::Style& style,
                                       const std::string& prefix) const;
@@ -95,37 +122,139 @@ private:
     typedef std::priority_queue<RegionPtr, std::vector<RegionPtr>, GreaterThanByArea> Regions;
     typedef std::unordered_map<std::string, Regions> Layers;
 
-    /// Builds all objects for quadkey organized by layers
-    void buildLayers();
+    /// Meshing work of clipped paths which does not depend on other layers.
+    struct MeshTask final
+    {
+        std::unique_ptr<RegionContext> regionContext;
+        std::unique_ptr<utymap::meshing::Polygon> polygon;
+        /// Contours which have height offset planes.
+        std::vector<Points> offsetContours;
+        /// Name of separate mesh or empty if polygon is part of terrain mesh.
+        std::string meshName;
+        /// Whether polygon has points: mesh is empty otherwise.
+        bool hasPolygon;
+        /// Geometry of polygon.
+        utymap::meshing::MeshPool::MeshPtr mesh;
+        /// Height offset planes which are part of terrain mesh.
+        utymap::meshing::MeshPool::MeshPtr planes;
+        /// Group which fills meshes on scheduler or null if they are filled immediately.
+        std::unique_ptr<utymap::utils::TaskGroup> group;
+        /// Cached result which receives copy of meshes when task is completed or null.
+        std::shared_ptr<TerrainCache::Result> result;
+    };
+    typedef std::unique_ptr<MeshTask> MeshTaskPtr;
+
+    /// Temporary paths and points which keep their memory between layers. They are returned
+    /// to thread local pool when generator is destroyed, so next tile reuses them.
+    struct Buffers final
+    {
+        /// Union of layer regions.
+        ClipperLib::Paths regions;
+        /// Foreground paths which overlap processed paths.
+        ClipperLib::Paths clip;
+        /// Result of clipping which is meshed.
+        ClipperLib::Paths solution;
+        /// Restored contours of mesh: only first contourCount are in use.
+        std::vector<Points> contours;
+        std::vector<bool> isHole;
+        /// Merges and subtracts regions: its object pools are kept between operations.
+        ClipperLib::Clipper clipper;
+    };
+    typedef std::unique_ptr<Buffers> BuffersPtr;
+
+    /// Returns pool of buffers of calling thread.
+    static std::vector<BuffersPtr>& getBuffersPool();
+
+    /// Stages of generation which are run by generateNext.
+    enum class Stage { Start, Layers, Regions, Background, Skirts, Done };
+
+    /// Reads generation parameters and builds grid mesh in grid mode.
+    void start();
 
     /// Builds background as clip area of layers
     void buildBackground(ClipperLib::Path& tileRect);
 
+    /// Builds regular grid mesh instead of triangulating regions.
+    void buildGrid(double cellSize);
+
+    /// Builds skirts along tile border.
+    void buildSkirts(const ClipperLib::Path& tileRect, double depth);
+
+    /// Merges regions of layer and builds mesh from them. Pieces are built separately after merged regions.
     void buildFromRegions(Regions& regions, const RegionContext& regionContext);
 
-    void buildFromPaths(const ClipperLib::Paths& paths, const RegionContext& regionContext);
+    /// Builds mesh from region which has own context.
+    void buildFromRegion(Region& region);
+
+    /// Builds mesh from paths. NOTE paths are moved to foreground. If key is not zero,
+    /// result is cached by it.
+    void buildFromPaths(ClipperLib::Paths& paths, const RegionContext& regionContext, std::uint64_t key = 0);
+
+    void populateMesh(ClipperLib::Paths& paths, const RegionContext& regionContext,
+                      const std::shared_ptr<TerrainCache::Result>& result = nullptr);
+
+    /// Creates key of cached result from input data of layer or region with given bounds
+    /// and input of processed ones which can overlap it.
+    std::uint64_t createResultKey(std::uint64_t inputHash,
+                                  const ClipperLib::IntRect& bounds,
+                                  const RegionContext& regionContext);
+
+    /// Uses cached result with given key if it exists instead of clipping and triangulation.
+    bool reuseResult(std::uint64_t key, const RegionContext& regionContext);
+
+    /// Appends mesh points restored from clipper path to given ones.
+    void restorePoints(const ClipperLib::Path& path, Points& points) const;
+
+    /// Triangulates polygon of task. Can be called from any thread.
+    void fillMesh(MeshTask& task) const;
+
+    /// Schedules task or executes it immediately if there is no parallel meshing.
+    void scheduleTask(MeshTaskPtr task);
+
+    /// Adds task which meshes are filled already, so it is completed in order of scheduling.
+    void addFilledTask(MeshTaskPtr task);
 
-    void populateMesh(ClipperLib::Paths& paths, const RegionContext& regionContext);
+    /// Completes the oldest scheduled task if limit of parallel tasks is reached.
+    void reserveTask();
 
-    Points restorePoints(const ClipperLib::Path& path) const;
+    /// Waits for task and merges its result into terrain mesh or reports it.
+    void completeTask(MeshTask& task);
 
-    void fillMesh(utymap::meshing::Polygon& polygon, const RegionContext& regionContext);
+    /// Completes all scheduled tasks in order of scheduling.
+    void completeTasks();
 
     /// Adds extras to mesh, e.g. trees, water surface if meshExtras are specified in options.
     void addExtrasIfNecessary(utymap::meshing::Mesh& mesh,
                               TerraExtras::Context& extrasContext,
                               const RegionContext& regionContext) const;
 
-    void processHeightOffset(const Points& points, const RegionContext& regionContext);
+    void processHeightOffset(const Points& points, const RegionContext& regionContext, utymap::meshing::Mesh& mesh) const;
 
     const BuilderContext& context_;
     const utymap::mapcss::Style& style_;
-    ClipperLib::ClipperEx& foregroundClipper_;
+    /// Paths of already processed regions which are subtracted from next ones.
+    ClipPathIndex foreground_;
     ClipperLib::ClipperEx backGroundClipper_;
     LineGridSplitter splitter_;
-    utymap::meshing::Mesh mesh_;
+    utymap::meshing::MeshPool::MeshPtr mesh_;
+    MeshChunker chunker_;
     Layers layers_;
     utymap::meshing::Rectangle rect_;
+    std::size_t maxTasks_;
+    std::deque<MeshTaskPtr> tasks_;
+    BuffersPtr buffers_;
+    /// Results of previous build of tile and results of this build: null if caching is disabled.
+    std::shared_ptr<const TerrainCache::TileResults> cachedResults_;
+    std::shared_ptr<TerrainCache::TileResults> results_;
+    /// Bounds and input hashes of already processed layers and regions.
+    std::vector<std::pair<ClipperLib::IntRect, std::uint64_t>> inputs_;
+    Stage stage_;
+    double cellSize_;
+    /// Key of tile results in terrain cache or zero.
+    std::uint64_t tileKey_;
+    /// Layers in order of priority and index of the next one.
+    std::vector<std::string> layerNames_;
+    std::size_t nextLayer_;
 };
 
 }}
@@ -0,0 +1,89 @@
+#ifndef BUILDERS_TERRAIN_TERRAINCACHE_HPP_DEFINED
+#define BUILDERS_TERRAIN_TERRAINCACHE_HPP_DEFINED
+
+#include "clipper/clipper.hpp"
+#include "meshing/MeshTypes.hpp"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace utymap { namespace builders {
+
+/// Keeps intermediate results of terrain generation of recently built tiles, so tile which is
+/// rebuilt after local edit clips and triangulates only regions which can be affected by it.
+/// Results of tile are stored by keys built from input of region and input of regions clipped
+/// before it which can overlap it. Size is bounded by amount of tiles. Thread safe.
+class TerrainCache final
+{
+public:
+    /// Result of clipping and triangulation of single layer or region.
+    struct Result final
+    {
+        /// Paths which are subtracted from regions clipped later.
+        ClipperLib::Paths foreground;
+        /// Clipped paths which are subtracted from background.
+        ClipperLib::Paths clipped;
+        /// Height offset planes and geometry of polygon: null if nothing is triangulated,
+        /// polygon geometry is also null if polygon has no points.
+        std::unique_ptr<utymap::meshing::Mesh> mesh;
+        std::unique_ptr<utymap::meshing::Mesh> planes;
+    };
+    typedef std::shared_ptr<const Result> ResultPtr;
+    /// Results of single tile by key.
+    typedef std::unordered_map<std::uint64_t, ResultPtr> TileResults;
+
+    explicit TerrainCache(std::size_t maxTiles) : maxTiles_(maxTiles)
+    {
+    }
+
+    /// Returns results of tile with given key or null if tile is not cached.
+    std::shared_ptr<const TileResults> get(std::uint64_t tileKey)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto entry = entries_.find(tileKey);
+        if (entry == entries_.end())
+            return nullptr;
+
+        usage_.splice(usage_.begin(), usage_, entry->second.second);
+        return entry->second.first;
+    }
+
+    /// Replaces results of tile evicting least recently used tile if needed.
+    void put(std::uint64_t tileKey, const std::shared_ptr<const TileResults>& results)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto entry = entries_.find(tileKey);
+        if (entry != entries_.end()) {
+            entry->second.first = results;
+            usage_.splice(usage_.begin(), usage_, entry->second.second);
+            return;
+        }
+
+        usage_.push_front(tileKey);
+        entries_.emplace(tileKey, std::make_pair(results, usage_.begin()));
+        while (entries_.size() > maxTiles_) {
+            entries_.erase(usage_.back());
+            usage_.pop_back();
+        }
+    }
+
+    /// Returns amount of cached tiles.
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        return entries_.size();
+    }
+
+private:
+    const std::size_t maxTiles_;
+    mutable std::mutex lock_;
+    std::unordered_map<std::uint64_t, std::pair<std::shared_ptr<const TileResults>, std::list<std::uint64_t>::iterator>> entries_;
+    std::list<std::uint64_t> usage_;
+};
+
+}}
+
+#endif // BUILDERS_TERRAIN_TERRAINCACHE_HPP_DEFINED
@@ -0,0 +1,45 @@
+#ifndef ENTITIES_BOUNDINGBOXVISITOR_HPP_DEFINED
+#define ENTITIES_BOUNDINGBOXVISITOR_HPP_DEFINED
+
+#include "BoundingBox.hpp"
+#include "entities/ElementDispatch.hpp"
+#include "entities/ElementVisitor.hpp"
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+
+namespace utymap { namespace entities {
+
+/// Creates bounding box of given element.
+class BoundingBoxVisitor final : public ElementVisitor
+{
+public:
+    BoundingBox boundingBox;
+
+    void visitNode(const Node& node) override
+    {
+        boundingBox.expand(node.coordinate);
+    }
+
+    void visitWay(const Way& way) override
+    {
+        boundingBox.expand(way.coordinates.cbegin(), way.coordinates.cend());
+    }
+
+    void visitArea(const Area& area) override
+    {
+        boundingBox.expand(area.coordinates.cbegin(), area.coordinates.cend());
+    }
+
+    void visitRelation(const Relation& relation) override
+    {
+        for (const auto& element: relation.elements) {
+            visit(*element, *this);
+        }
+    }
+};
+
+}}
+
+#endif // ENTITIES_BOUNDINGBOXVISITOR_HPP_DEFINED
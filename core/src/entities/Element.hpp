@@ -26,6 +26,9 @@ struct Tag
     bool operator<(const Tag& a) const { return key < a.key; }
 };
 
+/// Type of element: allows to dispatch element without virtual call.
+enum class ElementType : std::uint8_t { Node, Way, Area, Relation };
+
 /// Represents element stored in index.
 struct Element
 {
@@ -33,6 +36,8 @@ struct Element
     std::uint64_t id;
     /// Returns tag collection represented by vector of tuple<uint,uint>.
     std::vector<Tag> tags;
+    /// Returns type of element which matches its class.
+    ElementType type;
 
     virtual ~Element() = default;
 
@@ -52,6 +57,9 @@ struct Element
         return stm.str();
     }
     // TODO prevent copy/move/assign functions for base class
+
+protected:
+    explicit Element(ElementType type) : id(0), tags(), type(type) { }
 };
 
 }}
@@ -0,0 +1,331 @@
+#ifndef ENTITIES_ELEMENTBATCH_HPP_DEFINED
+#define ENTITIES_ELEMENTBATCH_HPP_DEFINED
+
+#include "GeoCoordinate.hpp"
+#include "entities/Element.hpp"
+#include "entities/ElementDispatch.hpp"
+#include "entities/ElementVisitor.hpp"
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace utymap { namespace entities {
+
+/// Keeps elements in flat arrays: ids, types, tag ranges and coordinate ranges of all elements
+/// share few buffers instead of separate heap objects. Coordinates are kept as compact ones.
+/// Relation members are stored as entries which follow their relation. Elements are read back
+/// by visitor adapter which reuses node, way and area instances, so they should be copied if
+/// they are used after visit.
+class ElementBatch final
+{
+public:
+    typedef ElementType Type;
+
+    ElementBatch() : count_(0)
+    {
+        tagOffsets_.push_back(0);
+        coordinateOffsets_.push_back(0);
+    }
+
+    /// Adds deep copy of element.
+    void add(const Element& element)
+    {
+        Writer writer(*this);
+        visit(element, writer);
+        ++count_;
+    }
+
+    /// Returns amount of added elements without relation members.
+    std::size_t size() const { return count_; }
+
+    bool empty() const { return count_ == 0; }
+
+    void clear()
+    {
+        ids_.clear();
+        types_.clear();
+        ends_.clear();
+        tags_.clear();
+        coordinates_.clear();
+        tagOffsets_.resize(1);
+        coordinateOffsets_.resize(1);
+        count_ = 0;
+    }
+
+    /// Checks whether there is element with given id.
+    bool contains(std::uint64_t id) const
+    {
+        for (std::size_t entry = 0; entry < ids_.size(); entry = ends_[entry]) {
+            if (ids_[entry] == id)
+                return true;
+        }
+        return false;
+    }
+
+    /// Removes all elements with given id. Returns true if any is removed.
+    bool erase(std::uint64_t id)
+    {
+        std::size_t entry = 0, target = 0, removed = 0;
+        std::uint32_t tagShift = 0, coordinateShift = 0;
+        while (entry < ids_.size()) {
+            std::size_t end = ends_[entry];
+            if (ids_[entry] == id) {
+                tagShift += tagOffsets_[end] - tagOffsets_[entry];
+                coordinateShift += coordinateOffsets_[end] - coordinateOffsets_[entry];
+                ++removed;
+                entry = end;
+                continue;
+            }
+            std::size_t shift = entry - target;
+            for (; entry < end; ++entry, ++target)
+                moveEntry(entry, target, shift, tagShift, coordinateShift);
+        }
+
+        if (removed == 0)
+            return false;
+
+        ids_.resize(target);
+        types_.resize(target);
+        ends_.resize(target);
+        tags_.resize(tags_.size() - tagShift);
+        coordinates_.resize(coordinates_.size() - coordinateShift);
+        tagOffsets_.resize(target + 1);
+        coordinateOffsets_.resize(target + 1);
+        count_ -= removed;
+        return true;
+    }
+
+    /// Calls function for every element in order they are added.
+    void forEach(const std::function<void(Element&)>& function) const
+    {
+        Node node;
+        Way way;
+        Area area;
+        for (std::size_t entry = 0; entry < ids_.size(); entry = ends_[entry])
+            read(entry, node, way, area, function);
+    }
+
+    /// Calls function for elements in order they are added until it returns false.
+    void forEachWhile(const std::function<bool(Element&)>& function) const
+    {
+        Node node;
+        Way way;
+        Area area;
+        bool proceed = true;
+        for (std::size_t entry = 0; entry < ids_.size() && proceed; entry = ends_[entry])
+            read(entry, node, way, area, [&](Element& element) { proceed = function(element); });
+    }
+
+    /// Calls function for elements at given ascending positions in order they are added.
+    void forEach(const std::vector<std::uint32_t>& positions, const std::function<void(Element&)>& function) const
+    {
+        Node node;
+        Way way;
+        Area area;
+        std::size_t entry = 0;
+        std::uint32_t position = 0;
+        for (auto target : positions) {
+            for (; position < target && entry < ids_.size(); ++position)
+                entry = ends_[entry];
+            if (entry >= ids_.size())
+                return;
+            read(entry, node, way, area, function);
+        }
+    }
+
+    /// Calls function for every element with given id without reading other elements.
+    void forEachWithId(std::uint64_t id, const std::function<void(Element&)>& function) const
+    {
+        Node node;
+        Way way;
+        Area area;
+        for (std::size_t entry = 0; entry < ids_.size(); entry = ends_[entry]) {
+            if (ids_[entry] == id)
+                read(entry, node, way, area, function);
+        }
+    }
+
+    /// Visits every element in order they are added.
+    void accept(ElementVisitor& visitor) const
+    {
+        forEach([&](Element& element) { element.accept(visitor); });
+    }
+
+    /// Returns amount of bytes used by elements.
+    std::size_t getSize() const
+    {
+        return ids_.size() * (sizeof(std::uint64_t) + sizeof(Type) + 3 * sizeof(std::uint32_t)) +
+               tags_.size() * sizeof(Tag) + coordinates_.size() * sizeof(CompactCoordinate);
+    }
+
+    /// Returns amount of bytes allocated by buffers.
+    std::size_t getMemoryUsage() const
+    {
+        return ids_.capacity() * sizeof(std::uint64_t) + types_.capacity() * sizeof(Type) +
+               ends_.capacity() * sizeof(std::uint32_t) + tags_.capacity() * sizeof(Tag) +
+               coordinates_.capacity() * sizeof(CompactCoordinate) +
+               (tagOffsets_.capacity() + coordinateOffsets_.capacity()) * sizeof(std::uint32_t);
+    }
+
+private:
+    /// Appends entries of visited element and its members.
+    class Writer final : public ElementVisitor
+    {
+    public:
+        explicit Writer(ElementBatch& batch) : batch_(batch) {}
+
+        void visitNode(const Node& node) override
+        {
+            batch_.coordinates_.push_back(CompactCoordinate(node.coordinate));
+            batch_.addEntry(node, Type::Node, batch_.ids_.size() + 1);
+        }
+
+        void visitWay(const Way& way) override
+        {
+            batch_.addCoordinates(way.coordinates);
+            batch_.addEntry(way, Type::Way, batch_.ids_.size() + 1);
+        }
+
+        void visitArea(const Area& area) override
+        {
+            batch_.addCoordinates(area.coordinates);
+            batch_.addEntry(area, Type::Area, batch_.ids_.size() + 1);
+        }
+
+        void visitRelation(const Relation& relation) override
+        {
+            std::size_t entry = batch_.ids_.size();
+            batch_.addEntry(relation, Type::Relation, entry + 1);
+            for (const auto& element : relation.elements)
+                visit(*element, *this);
+            batch_.ends_[entry] = static_cast<std::uint32_t>(batch_.ids_.size());
+        }
+
+    private:
+        ElementBatch& batch_;
+    };
+
+    void addCoordinates(const std::vector<GeoCoordinate>& coordinates)
+    {
+        coordinates_.reserve(coordinates_.size() + coordinates.size());
+        for (const auto& coordinate : coordinates)
+            coordinates_.push_back(CompactCoordinate(coordinate));
+    }
+
+    /// Adds entry for element which coordinates are already appended.
+    void addEntry(const Element& element, Type type, std::size_t end)
+    {
+        ids_.push_back(element.id);
+        types_.push_back(type);
+        ends_.push_back(static_cast<std::uint32_t>(end));
+        tags_.insert(tags_.end(), element.tags.begin(), element.tags.end());
+        tagOffsets_.push_back(static_cast<std::uint32_t>(tags_.size()));
+        coordinateOffsets_.push_back(static_cast<std::uint32_t>(coordinates_.size()));
+    }
+
+    /// Moves entry to target position shifting its ranges to the left.
+    void moveEntry(std::size_t entry, std::size_t target, std::size_t shift,
+                   std::uint32_t tagShift, std::uint32_t coordinateShift)
+    {
+        for (std::uint32_t i = tagOffsets_[entry]; i < tagOffsets_[entry + 1]; ++i)
+            tags_[i - tagShift] = tags_[i];
+        for (std::uint32_t i = coordinateOffsets_[entry]; i < coordinateOffsets_[entry + 1]; ++i)
+            coordinates_[i - coordinateShift] = coordinates_[i];
+
+        ids_[target] = ids_[entry];
+        types_[target] = types_[entry];
+        ends_[target] = static_cast<std::uint32_t>(ends_[entry] - shift);
+        tagOffsets_[target + 1] = tagOffsets_[entry + 1] - tagShift;
+        coordinateOffsets_[target + 1] = coordinateOffsets_[entry + 1] - coordinateShift;
+    }
+
+    /// Reads element of given entry into one of reused instances and calls function for it.
+    void read(std::size_t entry, Node& node, Way& way, Area& area, const std::function<void(Element&)>& function) const
+    {
+        switch (types_[entry]) {
+            case Type::Node: function(readNode(entry, node)); break;
+            case Type::Way: function(readWithCoordinates(entry, way)); break;
+            case Type::Area: function(readWithCoordinates(entry, area)); break;
+            default: function(*readRelation(entry)); break;
+        }
+    }
+
+    void readElement(std::size_t entry, Element& element) const
+    {
+        element.id = ids_[entry];
+        element.tags.assign(tags_.begin() + tagOffsets_[entry], tags_.begin() + tagOffsets_[entry + 1]);
+    }
+
+    Node& readNode(std::size_t entry, Node& node) const
+    {
+        readElement(entry, node);
+        node.coordinate = coordinates_[coordinateOffsets_[entry]].toGeoCoordinate();
+        return node;
+    }
+
+    template <typename T>
+    T& readWithCoordinates(std::size_t entry, T& element) const
+    {
+        readElement(entry, element);
+        element.coordinates.clear();
+        element.coordinates.reserve(coordinateOffsets_[entry + 1] - coordinateOffsets_[entry]);
+        for (std::uint32_t i = coordinateOffsets_[entry]; i < coordinateOffsets_[entry + 1]; ++i)
+            element.coordinates.push_back(coordinates_[i].toGeoCoordinate());
+        return element;
+    }
+
+    /// Reads relation as new instance as members have to be owned by it.
+    std::shared_ptr<Relation> readRelation(std::size_t entry) const
+    {
+        auto relation = std::make_shared<Relation>();
+        readElement(entry, *relation);
+        for (std::size_t member = entry + 1; member < ends_[entry]; member = ends_[member]) {
+            switch (types_[member]) {
+                case Type::Node: {
+                    auto node = std::make_shared<Node>();
+                    relation->elements.push_back(node);
+                    readNode(member, *node);
+                    break;
+                }
+                case Type::Way: {
+                    auto way = std::make_shared<Way>();
+                    relation->elements.push_back(way);
+                    readWithCoordinates(member, *way);
+                    break;
+                }
+                case Type::Area: {
+                    auto area = std::make_shared<Area>();
+                    relation->elements.push_back(area);
+                    readWithCoordinates(member, *area);
+                    break;
+                }
+                default:
+                    relation->elements.push_back(readRelation(member));
+                    break;
+            }
+        }
+        return relation;
+    }
+
+    std::vector<std::uint64_t> ids_;
+    std::vector<Type> types_;
+    /// Index of entry which follows element and its members.
+    std::vector<std::uint32_t> ends_;
+    /// Start of entry tags in tags buffer: entry tags end where next entry tags start.
+    std::vector<std::uint32_t> tagOffsets_;
+    std::vector<Tag> tags_;
+    /// Start of entry coordinates in coordinates buffer.
+    std::vector<std::uint32_t> coordinateOffsets_;
+    std::vector<CompactCoordinate> coordinates_;
+    std::size_t count_;
+};
+
+}}
+
+#endif // ENTITIES_ELEMENTBATCH_HPP_DEFINED
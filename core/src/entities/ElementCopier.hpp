@@ -0,0 +1,46 @@
+#ifndef ENTITIES_ELEMENTCOPIER_HPP_DEFINED
+#define ENTITIES_ELEMENTCOPIER_HPP_DEFINED
+
+#include "entities/ElementVisitor.hpp"
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "utils/Arena.hpp"
+
+#include <memory>
+
+namespace utymap { namespace entities {
+
+/// Copies visited element as builders may reuse element instances. If arena is set, copies
+/// are allocated from it, so they should not outlive its reset.
+class ElementCopier final : public ElementVisitor
+{
+public:
+    explicit ElementCopier(utymap::utils::Arena* arena = nullptr) : arena_(arena) { }
+
+    void visitNode(const Node& node) override { element = copy(node); }
+
+    void visitWay(const Way& way) override { element = copy(way); }
+
+    void visitArea(const Area& area) override { element = copy(area); }
+
+    void visitRelation(const Relation& relation) override { element = copy(relation); }
+
+    std::shared_ptr<Element> element;
+
+private:
+    template <typename T>
+    std::shared_ptr<Element> copy(const T& element) const
+    {
+        return arena_ == nullptr
+            ? std::make_shared<T>(element)
+            : std::allocate_shared<T>(utymap::utils::ArenaAllocator<T>(*arena_), element);
+    }
+
+    utymap::utils::Arena* arena_;
+};
+
+}}
+
+#endif // ENTITIES_ELEMENTCOPIER_HPP_DEFINED
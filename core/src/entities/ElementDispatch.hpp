@@ -0,0 +1,41 @@
+#ifndef ENTITIES_ELEMENTDISPATCH_HPP_DEFINED
+#define ENTITIES_ELEMENTDISPATCH_HPP_DEFINED
+
+#include "entities/Element.hpp"
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+
+namespace utymap { namespace entities {
+
+/// Calls visitor method for element of known type, so call of final visitor is not virtual.
+template <typename Visitor>
+inline void visit(const Node& node, Visitor& visitor) { visitor.visitNode(node); }
+
+template <typename Visitor>
+inline void visit(const Way& way, Visitor& visitor) { visitor.visitWay(way); }
+
+template <typename Visitor>
+inline void visit(const Area& area, Visitor& visitor) { visitor.visitArea(area); }
+
+template <typename Visitor>
+inline void visit(const Relation& relation, Visitor& visitor) { visitor.visitRelation(relation); }
+
+/// Calls visitor method using type of element instead of virtual accept. Methods of final
+/// visitor are inlined, so it is used in hot loops. Accept is still used by visitors which
+/// type is not known, e.g. external builders.
+template <typename Visitor>
+inline void visit(const Element& element, Visitor& visitor)
+{
+    switch (element.type) {
+        case ElementType::Node: visitor.visitNode(static_cast<const Node&>(element)); break;
+        case ElementType::Way: visitor.visitWay(static_cast<const Way&>(element)); break;
+        case ElementType::Area: visitor.visitArea(static_cast<const Area&>(element)); break;
+        case ElementType::Relation: visitor.visitRelation(static_cast<const Relation&>(element)); break;
+    }
+}
+
+}}
+
+#endif // ENTITIES_ELEMENTDISPATCH_HPP_DEFINED
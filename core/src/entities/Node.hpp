@@ -13,6 +13,8 @@ struct Node final: public Element
     /// Returns coordinate on map.
     GeoCoordinate coordinate;
 
+    Node() : Element(ElementType::Node) { }
+
     /// Accepts visitor.
     void accept(ElementVisitor& visitor) const override
     {
@@ -14,6 +14,8 @@ struct Relation final : public Element
 {
     std::vector<std::shared_ptr<Element>> elements;
 
+    Relation() : Element(ElementType::Relation) { }
+
     /// Accepts visitor.
     void accept(ElementVisitor& visitor) const override
     {
@@ -15,6 +15,8 @@ struct Way final : public Element
     /// Returns way's coordinates on map.
     std::vector<GeoCoordinate> coordinates;
 
+    Way() : Element(ElementType::Way) { }
+
     /// Accepts visitor.
     void accept(ElementVisitor& visitor) const override
     {
@@ -13,7 +13,17 @@ enum class FormatType
 {
     Pbf = 0,
     Xml = 1,
-    Shape = 2
+    Shape = 2,
+    OsmChange = 3,
+    Snapshot = 4
+};
+
+/// Specifies action of osm change file section.
+enum class ChangeAction
+{
+    Create = 0,
+    Modify = 1,
+    Delete = 2
 };
 
 struct Tag final
@@ -1,3 +1,4 @@
+#include "BoundingBox.hpp"
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
@@ -8,6 +9,7 @@
 #include "utils/GeometryUtils.hpp"
 
 #include <algorithm>
+#include <unordered_map>
 
 using namespace utymap;
 using namespace utymap::entities;
@@ -17,14 +19,38 @@ using namespace utymap::index;
 typedef std::deque<GeoCoordinate> Coords;
 typedef std::vector<int> Ints;
 
+namespace {
+    /// Hashes coordinate by its exact value: ends of adjacent ways are copies of the same node coordinate.
+    struct CoordinateHash final
+    {
+        std::size_t operator()(const GeoCoordinate& coordinate) const
+        {
+            return std::hash<double>()(coordinate.latitude + 0.0) * 31 ^ std::hash<double>()(coordinate.longitude + 0.0);
+        }
+    };
+
+    struct CoordinateEqual final
+    {
+        bool operator()(const GeoCoordinate& left, const GeoCoordinate& right) const
+        {
+            return left.latitude == right.latitude && left.longitude == right.longitude;
+        }
+    };
+
+    /// Maps end coordinates to indices of sequences which start or end there.
+    typedef std::unordered_map<GeoCoordinate, std::vector<std::size_t>, CoordinateHash, CoordinateEqual> EndpointMap;
+}
 
 struct MultipolygonProcessor::CoordinateSequence final
 {
     std::uint64_t id;
     Coords coordinates;
 
+    /// Bounding box of closed ring. Calculated once ring is assembled.
+    BoundingBox bbox;
+
     CoordinateSequence(std::uint64_t id, const Coordinates& coordinates) :
-        id(id), coordinates(coordinates.begin(), coordinates.end())
+        id(id), coordinates(coordinates.begin(), coordinates.end()), bbox()
     {
     }
 
@@ -67,19 +93,24 @@ struct MultipolygonProcessor::CoordinateSequence final
         return coordinates.size() > 1 && coordinates[0] == coordinates[coordinates.size() - 1]; 
     }
 
-    bool containsRing(const Coords& other) const
+    /// Checks whether other ring is inside this one: bounding boxes are compared first,
+    /// points are tested against polygon only if other box is inside.
+    bool containsRing(const CoordinateSequence& other) const
     {
-        return std::all_of(other.begin(), other.end(), [&](const GeoCoordinate& c) {
+        if (!bbox.contains(other.bbox))
+            return false;
+
+        return std::all_of(other.coordinates.begin(), other.coordinates.end(), [&](const GeoCoordinate& c) {
             return utymap::utils::GeoUtils::isPointInPolygon(c, coordinates.begin(), coordinates.end());
         });
     }
 
-private:
-
     GeoCoordinate first() const { return coordinates[0]; }
 
     GeoCoordinate last() const { return coordinates[coordinates.size() - 1]; }
 
+private:
+
     void addToBegin(const Coords& other) { coordinates.insert(coordinates.begin(), other.begin(), other.end()); }
 
     void addToEnd(const Coords& other) { coordinates.insert(coordinates.end(), other.begin(), other.end()); }
@@ -188,38 +219,57 @@ void MultipolygonProcessor::complexCase(CoordinateSequences& sequences) const
 
 std::vector<std::shared_ptr<MultipolygonProcessor::CoordinateSequence>> MultipolygonProcessor::createRings(CoordinateSequences& sequences) const
 {
-    CoordinateSequences closedRings;
-    std::shared_ptr<MultipolygonProcessor::CoordinateSequence> currentRing = nullptr;
-    while (!sequences.empty()) {
-        if (currentRing == nullptr) {
-            // start a new ring with any remaining node sequence
-            auto lastIndex = sequences.size() - 1;
-            currentRing = sequences[lastIndex];
-            sequences.erase(sequences.begin() + lastIndex);
+    // NOTE ends of sequences are indexed, so every step looks up only sequences which touch
+    // the ring instead of scanning all of them. Used sequences are skipped lazily.
+    EndpointMap endpoints;
+    for (std::size_t i = 0; i < sequences.size(); ++i) {
+        endpoints[sequences[i]->first()].push_back(i);
+        endpoints[sequences[i]->last()].push_back(i);
+    }
+    std::vector<bool> isUsed(sequences.size(), false);
+
+    auto tryAdd = [&](CoordinateSequence& ring, const GeoCoordinate& end) {
+        auto endpointPair = endpoints.find(end);
+        if (endpointPair == endpoints.end())
+            return false;
+        for (auto index : endpointPair->second) {
+            if (isUsed[index] || !ring.tryAdd(*sequences[index]))
+                continue;
+            isUsed[index] = true;
+            return true;
         }
-        else {
-            // try to continue the ring by appending a node sequence
-            bool isFound = false;
-            for (auto it = sequences.begin(); it != sequences.end(); ++it) {
-                if (!currentRing->tryAdd(**it)) continue;
-                isFound = true;
-                sequences.erase(it);
-                break;
-            }
+        return false;
+    };
 
-            if (!isFound) 
+    CoordinateSequences closedRings;
+    std::size_t remaining = sequences.size();
+    for (std::size_t start = sequences.size(); start > 0; --start) {
+        // start a new ring with any remaining node sequence
+        if (isUsed[start - 1])
+            continue;
+        auto currentRing = sequences[start - 1];
+        isUsed[start - 1] = true;
+        --remaining;
+
+        // try to continue the ring by appending a node sequence
+        while (!currentRing->isClosed()) {
+            // NOTE incomplete last ring is dropped.
+            if (remaining == 0)
+                return closedRings;
+            if (!tryAdd(*currentRing, currentRing->last()) && !tryAdd(*currentRing, currentRing->first()))
                 return CoordinateSequences();
+            --remaining;
         }
 
-        // check whether the ring under construction is closed
-        if (currentRing != nullptr && currentRing->isClosed()) {
-            // TODO check that it isn't self-intersecting!
-            closedRings.push_back(currentRing);
-            currentRing = nullptr;
-        }
+        // TODO check that it isn't self-intersecting!
+        currentRing->bbox.expand(currentRing->coordinates.begin(), currentRing->coordinates.end());
+        closedRings.push_back(currentRing);
+        if (remaining == 0)
+            break;
     }
 
-    return std::move(closedRings);
+    sequences.clear();
+    return closedRings;
 }
 
 void MultipolygonProcessor::fillRelation(CoordinateSequences& rings) const
@@ -230,7 +280,7 @@ void MultipolygonProcessor::fillRelation(CoordinateSequences& rings) const
         for (auto candidate = rings.begin(); candidate != rings.end(); ++candidate) {
             bool containedInOtherRings = false;
             for (auto other = rings.begin(); other != rings.end(); ++other) {
-                if (other != candidate && (*other)->containsRing((*candidate)->coordinates)) {
+                if (other != candidate && (*other)->containsRing(**candidate)) {
                     containedInOtherRings = true;
                     break;
                 }
@@ -244,10 +294,10 @@ void MultipolygonProcessor::fillRelation(CoordinateSequences& rings) const
         // find inner rings of that ring
         CoordinateSequences inners;
         for (auto ring = rings.begin(); ring != rings.end();) {
-            if (outer->containsRing((*ring)->coordinates)) {
+            if (outer->containsRing(**ring)) {
                 bool containedInOthers = false;
                 for (auto other = rings.begin(); other != rings.end(); ++other) {
-                    if (other != ring && (*other)->containsRing((*ring)->coordinates)) {
+                    if (other != ring && (*other)->containsRing(**ring)) {
                         containedInOthers = true;
                         break;
                     }
@@ -0,0 +1,167 @@
+#include "formats/osm/NodeCoordinateStore.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::formats;
+
+namespace {
+    /// Amount of node ids in one mapped chunk of file.
+    const std::uint64_t ChunkBits = 20;
+    const std::uint64_t ChunkSize = 1ull << ChunkBits;
+
+    /// Coordinate is stored as two unsigned fixed point values shifted by offset, so zero value
+    /// of sparse file means that there is no coordinate.
+    const double CoordinatePrecision = 1E7;
+    const std::int64_t LatitudeOffset = 900000001;
+    const std::int64_t LongitudeOffset = 1800000001;
+
+    struct FixedCoordinate final
+    {
+        std::uint32_t latitude;
+        std::uint32_t longitude;
+    };
+    static_assert(sizeof(FixedCoordinate) == 8, "Unexpected fixed coordinate size.");
+}
+
+class NodeCoordinateStore::NodeCoordinateStoreImpl
+{
+public:
+    virtual ~NodeCoordinateStoreImpl() = default;
+    virtual void set(std::uint64_t id, const GeoCoordinate& coordinate) = 0;
+    virtual bool get(std::uint64_t id, GeoCoordinate& coordinate) const = 0;
+};
+
+class NodeCoordinateStore::MemoryImpl final : public NodeCoordinateStore::NodeCoordinateStoreImpl
+{
+public:
+    void set(std::uint64_t id, const GeoCoordinate& coordinate) override
+    {
+        coordinates_[id] = CompactCoordinate(coordinate);
+    }
+
+    bool get(std::uint64_t id, GeoCoordinate& coordinate) const override
+    {
+        auto coordinatePair = coordinates_.find(id);
+        if (coordinatePair == coordinates_.end())
+            return false;
+        coordinate = coordinatePair->second.toGeoCoordinate();
+        return true;
+    }
+
+private:
+    std::unordered_map<std::uint64_t, CompactCoordinate> coordinates_;
+};
+
+/// Maps file by chunks on demand. File is extended by writing its last byte, so unused
+/// regions stay sparse on file systems which support it.
+class NodeCoordinateStore::FileImpl final : public NodeCoordinateStore::NodeCoordinateStoreImpl
+{
+public:
+    explicit FileImpl(const std::string& path) : path_(path), fileSize_(0), chunks_()
+    {
+        std::ofstream file(path_, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.good())
+            throw std::domain_error("Cannot create node coordinate file: " + path_);
+    }
+
+    ~FileImpl()
+    {
+        chunks_.clear();
+        mapping_.reset();
+        std::remove(path_.c_str());
+    }
+
+    void set(std::uint64_t id, const GeoCoordinate& coordinate) override
+    {
+        FixedCoordinate* chunk = getChunk(id >> ChunkBits, true);
+        FixedCoordinate& fixed = chunk[id & (ChunkSize - 1)];
+        fixed.latitude = static_cast<std::uint32_t>(std::llround(coordinate.latitude * CoordinatePrecision) + LatitudeOffset);
+        fixed.longitude = static_cast<std::uint32_t>(std::llround(coordinate.longitude * CoordinatePrecision) + LongitudeOffset);
+    }
+
+    bool get(std::uint64_t id, GeoCoordinate& coordinate) const override
+    {
+        const FixedCoordinate* chunk = const_cast<FileImpl*>(this)->getChunk(id >> ChunkBits, false);
+        if (chunk == nullptr)
+            return false;
+
+        const FixedCoordinate& fixed = chunk[id & (ChunkSize - 1)];
+        if (fixed.latitude == 0)
+            return false;
+
+        coordinate.latitude = (static_cast<std::int64_t>(fixed.latitude) - LatitudeOffset) / CoordinatePrecision;
+        coordinate.longitude = (static_cast<std::int64_t>(fixed.longitude) - LongitudeOffset) / CoordinatePrecision;
+        return true;
+    }
+
+private:
+    /// Returns mapped chunk with given index. If it does not exist, it is created only if requested.
+    FixedCoordinate* getChunk(std::uint64_t index, bool create)
+    {
+        auto chunkPair = chunks_.find(index);
+        if (chunkPair != chunks_.end())
+            return static_cast<FixedCoordinate*>(chunkPair->second->get_address());
+        if (!create)
+            return nullptr;
+
+        using namespace boost::interprocess;
+        const std::uint64_t chunkBytes = ChunkSize * sizeof(FixedCoordinate);
+        std::uint64_t requiredSize = (index + 1) * chunkBytes;
+        if (requiredSize > fileSize_) {
+            std::fstream file(path_, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(static_cast<std::streamoff>(requiredSize - 1));
+            file.put(0);
+            if (!file.good())
+                throw std::domain_error("Cannot extend node coordinate file: " + path_);
+            fileSize_ = requiredSize;
+        }
+
+        if (mapping_ == nullptr)
+            mapping_ = utymap::utils::make_unique<file_mapping>(path_.c_str(), read_write);
+
+        auto region = utymap::utils::make_unique<mapped_region>(*mapping_, read_write,
+            static_cast<offset_t>(index * chunkBytes), static_cast<std::size_t>(chunkBytes));
+        auto address = static_cast<FixedCoordinate*>(region->get_address());
+        chunks_.emplace(index, std::move(region));
+        return address;
+    }
+
+    const std::string path_;
+    std::uint64_t fileSize_;
+    std::unique_ptr<boost::interprocess::file_mapping> mapping_;
+    std::unordered_map<std::uint64_t, std::unique_ptr<boost::interprocess::mapped_region>> chunks_;
+};
+
+NodeCoordinateStore::NodeCoordinateStore() :
+    pimpl_(utymap::utils::make_unique<MemoryImpl>())
+{
+}
+
+NodeCoordinateStore::NodeCoordinateStore(const std::string& path) :
+    pimpl_(utymap::utils::make_unique<FileImpl>(path))
+{
+}
+
+NodeCoordinateStore::~NodeCoordinateStore()
+{
+}
+
+void NodeCoordinateStore::set(std::uint64_t id, const GeoCoordinate& coordinate)
+{
+    pimpl_->set(id, coordinate);
+}
+
+bool NodeCoordinateStore::get(std::uint64_t id, GeoCoordinate& coordinate) const
+{
+    return pimpl_->get(id, coordinate);
+}
@@ -0,0 +1,44 @@
+#ifndef FORMATS_OSM_NODECOORDINATESTORE_HPP_DEFINED
+#define FORMATS_OSM_NODECOORDINATESTORE_HPP_DEFINED
+
+#include "GeoCoordinate.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace utymap { namespace formats {
+
+/// Stores node coordinates by node id to resolve way geometry during import.
+/// Default store keeps compact coordinates in hash map. File backed store uses dense array indexed
+/// by node id with fixed point coordinates which is kept in sparse memory mapped file.
+class NodeCoordinateStore final
+{
+public:
+    /// Creates store which keeps coordinates in memory.
+    NodeCoordinateStore();
+
+    /// Creates store backed by file at given path. File is removed when store is destroyed.
+    explicit NodeCoordinateStore(const std::string& path);
+
+    NodeCoordinateStore(const NodeCoordinateStore&) = delete;
+    NodeCoordinateStore& operator=(const NodeCoordinateStore&) = delete;
+
+    ~NodeCoordinateStore();
+
+    /// Sets coordinate of node with given id.
+    void set(std::uint64_t id, const utymap::GeoCoordinate& coordinate);
+
+    /// Gets coordinate of node with given id. Returns false if there is no such node.
+    bool get(std::uint64_t id, utymap::GeoCoordinate& coordinate) const;
+
+private:
+    class NodeCoordinateStoreImpl;
+    class MemoryImpl;
+    class FileImpl;
+    std::unique_ptr<NodeCoordinateStoreImpl> pimpl_;
+};
+
+}}
+
+#endif // FORMATS_OSM_NODECOORDINATESTORE_HPP_DEFINED
@@ -0,0 +1,95 @@
+#ifndef FORMATS_OSM_NODEREFERENCEVISITOR_HPP_DEFINED
+#define FORMATS_OSM_NODEREFERENCEVISITOR_HPP_DEFINED
+
+#include "GeoCoordinate.hpp"
+#include "entities/Element.hpp"
+#include "formats/FormatTypes.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace utymap { namespace formats {
+
+/// Keeps set of node ids as bitmap split into pages of consecutive ids, so only ranges of
+/// ids which are used take memory: one bit per id of allocated page.
+class NodeIdSet final
+{
+    static const std::uint64_t PageBits = 16;
+    static const std::uint64_t PageSize = 1 << PageBits;
+    static const std::uint64_t WordsPerPage = PageSize / 64;
+
+public:
+    NodeIdSet() : pages_(), size_(0) { }
+
+    void insert(std::uint64_t id)
+    {
+        auto& page = pages_[id >> PageBits];
+        if (page == nullptr)
+            page.reset(new std::uint64_t[WordsPerPage]());
+
+        std::uint64_t& word = page[(id & (PageSize - 1)) >> 6];
+        std::uint64_t mask = std::uint64_t(1) << (id & 63);
+        if ((word & mask) == 0) {
+            word |= mask;
+            ++size_;
+        }
+    }
+
+    bool contains(std::uint64_t id) const
+    {
+        auto page = pages_.find(id >> PageBits);
+        return page != pages_.end() &&
+               (page->second[(id & (PageSize - 1)) >> 6] & (std::uint64_t(1) << (id & 63))) != 0;
+    }
+
+    /// Returns amount of ids in set.
+    std::size_t size() const { return size_; }
+
+    /// Returns amount of bytes used by pages.
+    std::size_t getMemoryUsage() const { return pages_.size() * WordsPerPage * sizeof(std::uint64_t); }
+
+private:
+    std::unordered_map<std::uint64_t, std::unique_ptr<std::uint64_t[]>> pages_;
+    std::size_t size_;
+};
+
+/// Collects ids of nodes referenced by ways and relations on the first pass of two pass import,
+/// so the second pass keeps only nodes which are tagged or referenced. Tags are not used: node
+/// tags are not decoded and strings are not mapped to ids.
+class NodeReferenceVisitor final
+{
+public:
+    /// Nodes used as way geometry.
+    NodeIdSet wayNodes;
+    /// Nodes which are relation members.
+    NodeIdSet relationNodes;
+
+    bool needsTags(const utymap::GeoCoordinate&) const { return false; }
+
+    std::vector<std::uint32_t> getStringIds(const std::vector<const char*>& strings)
+    {
+        return std::vector<std::uint32_t>(strings.size(), 0);
+    }
+
+    void visitNode(std::uint64_t, utymap::GeoCoordinate&, std::vector<utymap::entities::Tag>&) { }
+
+    void visitWay(std::uint64_t, std::vector<std::uint64_t>& nodeIds, std::vector<utymap::entities::Tag>&)
+    {
+        for (auto id : nodeIds)
+            wayNodes.insert(id);
+    }
+
+    void visitRelation(std::uint64_t, RelationMembers& members, std::vector<utymap::entities::Tag>&)
+    {
+        for (const auto& member : members) {
+            if (member.type == "n")
+                relationNodes.insert(member.refId);
+        }
+    }
+};
+
+}}
+
+#endif // FORMATS_OSM_NODEREFERENCEVISITOR_HPP_DEFINED
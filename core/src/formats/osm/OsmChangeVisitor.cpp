@@ -0,0 +1,122 @@
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Relation.hpp"
+#include "formats/osm/OsmChangeVisitor.hpp"
+#include "formats/osm/OsmElementId.hpp"
+
+using namespace utymap;
+using namespace utymap::entities;
+using namespace utymap::formats;
+using namespace utymap::index;
+
+OsmChangeVisitor::OsmChangeVisitor(StringTable& stringTable, std::function<bool(Element&, ChangeAction)> apply) :
+    apply_(apply),
+    dataVisitor_(stringTable, [&](Element& element) {
+        return !isLastAction(element.id, ChangeAction::Delete) ? apply_(element, actions_[element.id]) : true;
+    }),
+    action_(ChangeAction::Create),
+    extent_(),
+    actions_(),
+    coordinates_(),
+    deleted_()
+{
+}
+
+void OsmChangeVisitor::setNodeResolver(std::function<bool(std::uint64_t, GeoCoordinate&)> resolver)
+{
+    dataVisitor_.setNodeResolver(resolver);
+}
+
+void OsmChangeVisitor::visitChange(ChangeAction action)
+{
+    action_ = action;
+}
+
+void OsmChangeVisitor::visitBounds(BoundingBox bbox)
+{
+    extent_.expand(bbox);
+}
+
+void OsmChangeVisitor::visitNode(std::uint64_t id, GeoCoordinate& coordinate, Tags& tags)
+{
+    setAction(id);
+    if (coordinate.isValid()) {
+        coordinates_[id] = coordinate;
+        extent_.expand(coordinate);
+    }
+
+    if (action_ != ChangeAction::Delete) {
+        dataVisitor_.visitNode(id, coordinate, tags);
+        return;
+    }
+
+    auto node = std::make_shared<Node>();
+    node->id = id;
+    node->coordinate = coordinate;
+    deleted_.push_back(node);
+}
+
+void OsmChangeVisitor::visitWay(std::uint64_t id, std::vector<std::uint64_t>& nodeIds, Tags& tags)
+{
+    setAction(OsmElementId::way(id));
+    if (action_ != ChangeAction::Delete) {
+        dataVisitor_.visitWay(id, nodeIds, tags);
+        return;
+    }
+
+    auto way = std::make_shared<Way>();
+    way->id = OsmElementId::way(id);
+    for (auto nodeId : nodeIds) {
+        auto coordinatePair = coordinates_.find(nodeId);
+        if (coordinatePair == coordinates_.end()) {
+            way->coordinates.clear();
+            break;
+        }
+        way->coordinates.push_back(coordinatePair->second);
+    }
+    deleted_.push_back(way);
+}
+
+void OsmChangeVisitor::visitRelation(std::uint64_t id, RelationMembers& members, Tags& tags)
+{
+    setAction(OsmElementId::relation(id));
+    if (action_ != ChangeAction::Delete) {
+        dataVisitor_.visitRelation(id, members, tags);
+        return;
+    }
+
+    auto relation = std::make_shared<Relation>();
+    relation->id = OsmElementId::relation(id);
+    deleted_.push_back(relation);
+}
+
+void OsmChangeVisitor::complete()
+{
+    for (const auto& element : deleted_) {
+        if (isLastAction(element->id, ChangeAction::Delete))
+            apply_(*element, ChangeAction::Delete);
+    }
+
+    dataVisitor_.complete();
+}
+
+const BoundingBox& OsmChangeVisitor::extent() const
+{
+    return extent_;
+}
+
+void OsmChangeVisitor::setAction(std::uint64_t id)
+{
+    auto actionPair = actions_.find(id);
+    // NOTE element created after it was changed in the same file replaces previous version.
+    if (actionPair != actions_.end())
+        actionPair->second = action_ == ChangeAction::Create ? ChangeAction::Modify : action_;
+    else
+        actions_.emplace(id, action_);
+}
+
+bool OsmChangeVisitor::isLastAction(std::uint64_t id, ChangeAction action) const
+{
+    auto actionPair = actions_.find(id);
+    return actionPair != actions_.end() && actionPair->second == action;
+}
@@ -0,0 +1,62 @@
+#ifndef FORMATS_OSM_OSMCHANGEVISITOR_HPP_DEFINED
+#define FORMATS_OSM_OSMCHANGEVISITOR_HPP_DEFINED
+
+#include "BoundingBox.hpp"
+#include "GeoCoordinate.hpp"
+#include "entities/Element.hpp"
+#include "formats/FormatTypes.hpp"
+#include "formats/osm/OsmDataVisitor.hpp"
+#include "index/StringTable.hpp"
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace utymap { namespace formats {
+
+/// Builds elements from osm change data and reports them with the last action applied to them.
+/// Deleted elements have geometry only if it can be resolved from change data itself.
+/// Actions are tracked by element ids which are distinct for nodes, ways and relations with the same osm id.
+class OsmChangeVisitor final
+{
+public:
+    OsmChangeVisitor(utymap::index::StringTable& stringTable,
+                     std::function<bool(utymap::entities::Element&, ChangeAction)> apply);
+
+    /// Sets function which resolves coordinate of node which is not part of change data.
+    void setNodeResolver(std::function<bool(std::uint64_t, utymap::GeoCoordinate&)> resolver);
+
+    void visitChange(ChangeAction action);
+
+    void visitBounds(utymap::BoundingBox bbox);
+
+    void visitNode(std::uint64_t id, utymap::GeoCoordinate& coordinate, utymap::formats::Tags& tags);
+
+    void visitWay(std::uint64_t id, std::vector<std::uint64_t>& nodeIds, utymap::formats::Tags& tags);
+
+    void visitRelation(std::uint64_t id, utymap::formats::RelationMembers& members, utymap::formats::Tags& tags);
+
+    /// Reports deleted elements first, then created and modified ones.
+    void complete();
+
+    /// Returns bounding box of all coordinates and bounds found in change data.
+    const utymap::BoundingBox& extent() const;
+
+private:
+    void setAction(std::uint64_t id);
+    bool isLastAction(std::uint64_t id, ChangeAction action) const;
+
+    std::function<bool(utymap::entities::Element&, ChangeAction)> apply_;
+    utymap::formats::OsmDataVisitor dataVisitor_;
+    ChangeAction action_;
+    utymap::BoundingBox extent_;
+    /// Last actions by element id, see OsmElementId.
+    std::unordered_map<std::uint64_t, ChangeAction> actions_;
+    std::unordered_map<std::uint64_t, utymap::GeoCoordinate> coordinates_;
+    std::vector<std::shared_ptr<utymap::entities::Element>> deleted_;
+};
+
+}}
+
+#endif // FORMATS_OSM_OSMCHANGEVISITOR_HPP_DEFINED
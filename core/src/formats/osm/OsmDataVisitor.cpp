@@ -2,14 +2,20 @@
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
+#include "entities/BoundingBoxVisitor.hpp"
 #include "formats/osm/BuildingProcessor.hpp"
 #include "formats/osm/MultipolygonProcessor.hpp"
 #include "formats/osm/RelationProcessor.hpp"
 #include "formats/osm/OsmDataVisitor.hpp"
+#include "formats/osm/OsmElementId.hpp"
+#include "utils/CoreUtils.hpp"
 #include "utils/ElementUtils.hpp"
 #include "utils/GeometryUtils.hpp"
+#include "utils/TaskScheduler.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <exception>
 #include <vector>
 #include <unordered_set>
 
@@ -51,6 +57,78 @@ namespace {
     {
         "no", "No", "NO", "false", "False", "FALSE", "0"
     };
+
+    /// Disjoint set of relation indices.
+    class RelationSets final
+    {
+    public:
+        explicit RelationSets(std::size_t size) : parents_(size)
+        {
+            for (std::size_t i = 0; i < size; ++i)
+                parents_[i] = i;
+        }
+
+        std::size_t find(std::size_t index)
+        {
+            while (parents_[index] != index) {
+                parents_[index] = parents_[parents_[index]];
+                index = parents_[index];
+            }
+            return index;
+        }
+
+        void merge(std::size_t first, std::size_t second)
+        {
+            parents_[find(first)] = find(second);
+        }
+
+    private:
+        std::vector<std::size_t> parents_;
+    };
+}
+
+void OsmDataVisitor::setFilter(const BoundingBox& bbox, std::function<bool(const Element&)> predicate)
+{
+    hasFilter_ = true;
+    filterBbox_ = bbox;
+    predicate_ = predicate;
+}
+
+void OsmDataVisitor::setNodeCoordinateFile(const std::string& path)
+{
+    coordinates_ = utymap::utils::make_unique<NodeCoordinateStore>(path);
+    isCoordinateFile_ = true;
+}
+
+void OsmDataVisitor::setNodeResolver(std::function<bool(std::uint64_t, GeoCoordinate&)> resolver)
+{
+    nodeResolver_ = resolver;
+}
+
+void OsmDataVisitor::setReferencedNodes(const NodeIdSet& wayNodes, const NodeIdSet& relationNodes)
+{
+    wayNodes_ = &wayNodes;
+    relationNodes_ = &relationNodes;
+}
+
+bool OsmDataVisitor::isSkipped(std::uint64_t id, bool hasTags, const GeoCoordinate& coordinate)
+{
+    if (wayNodes_ == nullptr || hasTags || relationNodes_->contains(id))
+        return false;
+
+    if (wayNodes_->contains(id))
+        coordinates_->set(id, coordinate);
+    return true;
+}
+
+bool OsmDataVisitor::isCoordinateOnly(bool hasTags, const GeoCoordinate& coordinate) const
+{
+    return (hasFilter_ || isCoordinateFile_) && (!hasTags || !needsTags(coordinate));
+}
+
+bool OsmDataVisitor::needsTags(const GeoCoordinate& coordinate) const
+{
+    return !hasFilter_ || filterBbox_.contains(coordinate);
 }
 
 void OsmDataVisitor::visitBounds(BoundingBox bbox)
@@ -58,23 +136,50 @@ void OsmDataVisitor::visitBounds(BoundingBox bbox)
 }
 
 void OsmDataVisitor::visitNode(std::uint64_t id, GeoCoordinate& coordinate, utymap::formats::Tags& tags)
+{
+    if (isSkipped(id, !tags.empty(), coordinate))
+        return;
+    if (isCoordinateOnly(!tags.empty(), coordinate))
+        coordinates_->set(id, coordinate);
+    else
+        addNode(id, coordinate, utymap::utils::convertTags(stringTable_, tags));
+}
+
+void OsmDataVisitor::addNode(std::uint64_t id, const GeoCoordinate& coordinate, std::vector<utymap::entities::Tag>&& tags)
 {
     auto node = std::make_shared<Node>();
     node->id = id;
     node->coordinate = coordinate;
-    utymap::utils::setTags(stringTable_, *node, tags);
-    context_.nodeMap[id] = node;
+    node->tags = std::move(tags);
+    if (isCoordinateOnly(!node->tags.empty(), coordinate) || (hasFilter_ && !predicate_(*node)))
+        coordinates_->set(id, coordinate);
+    else
+        context_.nodeMap[id] = node;
 }
 
 void OsmDataVisitor::visitWay(std::uint64_t id, std::vector<std::uint64_t>& nodeIds, utymap::formats::Tags& tags)
+{
+    addWay(OsmElementId::way(id), nodeIds, utymap::utils::convertTags(stringTable_, tags), isArea(tags));
+}
+
+void OsmDataVisitor::addWay(std::uint64_t id, std::vector<std::uint64_t>& nodeIds, std::vector<utymap::entities::Tag>&& tags, bool isArea)
 {
     std::vector<GeoCoordinate> coordinates;
     coordinates.reserve(nodeIds.size());
     for (auto nodeId : nodeIds) {
-        coordinates.push_back(context_.nodeMap[nodeId]->coordinate);
+        auto nodePair = context_.nodeMap.find(nodeId);
+        if (nodePair != context_.nodeMap.end()) {
+            coordinates.push_back(nodePair->second->coordinate);
+            continue;
+        }
+        GeoCoordinate coordinate;
+        // NOTE way cannot be built without all its nodes: skip.
+        if (!coordinates_->get(nodeId, coordinate) && (!nodeResolver_ || !nodeResolver_(nodeId, coordinate)))
+            return;
+        coordinates.push_back(coordinate);
     }
 
-    if (coordinates.size() > 2 && isArea(tags)) {
+    if (coordinates.size() > 2 && isArea) {
         if (coordinates.at(0) == coordinates.at(coordinates.size() - 1)) {
             // NOTE three coordinates are invalid here: skip.
             // TODO should it be considered as way instead?
@@ -90,30 +195,64 @@ void OsmDataVisitor::visitWay(std::uint64_t id, std::vector<std::uint64_t>& node
             std::reverse(coordinates.begin(), coordinates.end());
         }
         area->coordinates = std::move(coordinates);
-        utymap::utils::setTags(stringTable_, *area, tags);
+        area->tags = std::move(tags);
         context_.areaMap[id] = area;
 
     } else {
         auto way = std::make_shared<Way>();
         way->id = id;
         way->coordinates = std::move(coordinates);
-        utymap::utils::setTags(stringTable_, *way, tags);
+        way->tags = std::move(tags);
         context_.wayMap[id] = way;
     }
 }
 
 void OsmDataVisitor::visitRelation(std::uint64_t id, RelationMembers& members, utymap::formats::Tags& tags)
+{
+    addRelation(OsmElementId::relation(id), members, utymap::utils::convertTags(stringTable_, tags));
+}
+
+void OsmDataVisitor::addRelation(std::uint64_t id, const RelationMembers& members, std::vector<utymap::entities::Tag>&& tags)
 {
     auto relation = std::make_shared<Relation>();
     relation->id = id;
-    relation->tags = utymap::utils::convertTags(stringTable_, tags);
+    relation->tags = std::move(tags);
 
     // NOTE Assume, relation may refer to another relations which are not yet processed.
     // So, store all relation members to resolve them once all relations are visited.
-    relationMembers_[id] = members;
+    auto& elementMembers = relationMembers_[id];
+    elementMembers = members;
+    for (auto& member : elementMembers)
+        member.refId = OsmElementId::member(member);
     context_.relationMap[id] = relation;
 }
 
+std::vector<std::uint32_t> OsmDataVisitor::getStringIds(const std::vector<const char*>& strings)
+{
+    return stringTable_.getIds(strings);
+}
+
+void OsmDataVisitor::visitNode(std::uint64_t id, GeoCoordinate& coordinate, std::vector<utymap::entities::Tag>& tags)
+{
+    if (isSkipped(id, !tags.empty(), coordinate))
+        return;
+    if (isCoordinateOnly(!tags.empty(), coordinate))
+        coordinates_->set(id, coordinate);
+    else
+        addNode(id, coordinate, std::vector<utymap::entities::Tag>(tags));
+}
+
+void OsmDataVisitor::visitWay(std::uint64_t id, std::vector<std::uint64_t>& nodeIds, std::vector<utymap::entities::Tag>& tags)
+{
+    bool isAreaWay = isArea(tags);
+    addWay(OsmElementId::way(id), nodeIds, std::vector<utymap::entities::Tag>(tags), isAreaWay);
+}
+
+void OsmDataVisitor::visitRelation(std::uint64_t id, RelationMembers& members, std::vector<utymap::entities::Tag>& tags)
+{
+    addRelation(OsmElementId::relation(id), members, std::vector<utymap::entities::Tag>(tags));
+}
+
 bool OsmDataVisitor::isArea(const utymap::formats::Tags& tags) const
 {
     for (const auto& tag : tags) {
@@ -125,9 +264,22 @@ bool OsmDataVisitor::isArea(const utymap::formats::Tags& tags) const
     return false;
 }
 
-bool OsmDataVisitor::hasTag(const std::string& key, const std::string& value, const std::vector<utymap::entities::Tag>& tags) const
+bool OsmDataVisitor::isArea(const std::vector<utymap::entities::Tag>& tags)
 {
-    return utymap::utils::hasTag(stringTable_.getId(key), stringTable_.getId(value), tags);
+    if (areaKeyIds_.empty()) {
+        for (const auto& key : AreaKeys)
+            areaKeyIds_.insert(stringTable_.getId(key));
+        for (const auto& value : FalseKeys)
+            falseValueIds_.insert(stringTable_.getId(value));
+    }
+
+    for (const auto& tag : tags) {
+        if (areaKeyIds_.find(tag.key) != areaKeyIds_.end() &&
+            falseValueIds_.find(tag.value) == falseValueIds_.end())
+            return true;
+    }
+
+    return false;
 }
 
 void OsmDataVisitor::resolve(Relation& relation)
@@ -139,26 +291,145 @@ void OsmDataVisitor::resolve(Relation& relation)
 
     auto resolveFunc = std::bind(&OsmDataVisitor::resolve, this, std::placeholders::_1);
 
-    if (hasTag("type", "multipolygon", relation.tags))
+    if (utymap::utils::hasTag(typeKeyId_, multipolygonValueId_, relation.tags))
         MultipolygonProcessor(relation, membersPair->second, context_, resolveFunc).process();
-    else if (hasTag("type", "building", relation.tags))
+    else if (utymap::utils::hasTag(typeKeyId_, buildingValueId_, relation.tags))
         BuildingProcessor(relation, membersPair->second, context_, resolveFunc).process();
     else {
         RelationProcessor(relation, membersPair->second, context_, relationMembers_, resolveFunc).process();
     }
 }
 
+std::vector<std::vector<std::uint64_t>> OsmDataVisitor::groupRelations() const
+{
+    std::vector<std::uint64_t> ids;
+    std::unordered_map<std::uint64_t, std::size_t> indices;
+    for (const auto& membersPair : relationMembers_) {
+        if (context_.relationMap.find(membersPair.first) == context_.relationMap.end())
+            continue;
+        indices[membersPair.first] = ids.size();
+        ids.push_back(membersPair.first);
+    }
+
+    // NOTE relations are dependent when one refers to another or when they share member of
+    // building relation as its processor modifies tags of members.
+    RelationSets sets(ids.size());
+    std::unordered_map<std::uint64_t, std::size_t> buildingMembers;
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        bool isBuilding = utymap::utils::hasTag(typeKeyId_, buildingValueId_, context_.relationMap.at(ids[i])->tags);
+        for (const auto& member : relationMembers_.at(ids[i])) {
+            auto indexPair = indices.find(member.refId);
+            if (indexPair != indices.end())
+                sets.merge(i, indexPair->second);
+            else if (isBuilding) {
+                auto ownerPair = buildingMembers.emplace(member.refId, i);
+                sets.merge(i, ownerPair.first->second);
+            }
+        }
+    }
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        for (const auto& member : relationMembers_.at(ids[i])) {
+            auto ownerPair = buildingMembers.find(member.refId);
+            if (ownerPair != buildingMembers.end())
+                sets.merge(i, ownerPair->second);
+        }
+    }
+
+    // Depth first post order puts referenced relations first. Cycles are broken by visited flag.
+    std::vector<bool> isVisited(ids.size(), false);
+    std::vector<std::size_t> order;
+    order.reserve(ids.size());
+    std::vector<std::pair<std::size_t, std::size_t>> stack;
+    for (std::size_t start = 0; start < ids.size(); ++start) {
+        if (isVisited[start])
+            continue;
+        isVisited[start] = true;
+        stack.emplace_back(start, 0);
+        while (!stack.empty()) {
+            auto& top = stack.back();
+            const auto& members = relationMembers_.at(ids[top.first]);
+            if (top.second == members.size()) {
+                order.push_back(top.first);
+                stack.pop_back();
+                continue;
+            }
+            auto indexPair = indices.find(members[top.second++].refId);
+            if (indexPair != indices.end() && !isVisited[indexPair->second]) {
+                isVisited[indexPair->second] = true;
+                stack.emplace_back(indexPair->second, 0);
+            }
+        }
+    }
+
+    std::unordered_map<std::size_t, std::size_t> groupIndices;
+    std::vector<std::vector<std::uint64_t>> groups;
+    for (auto index : order) {
+        auto groupPair = groupIndices.emplace(sets.find(index), groups.size());
+        if (groupPair.second)
+            groups.emplace_back();
+        groups[groupPair.first->second].push_back(ids[index]);
+    }
+
+    // NOTE large groups are started first to balance workers.
+    std::stable_sort(groups.begin(), groups.end(),
+        [](const std::vector<std::uint64_t>& left, const std::vector<std::uint64_t>& right) {
+        return left.size() > right.size();
+    });
+    return groups;
+}
+
+void OsmDataVisitor::resolveRelations()
+{
+    typeKeyId_ = stringTable_.getId("type");
+    multipolygonValueId_ = stringTable_.getId("multipolygon");
+    buildingValueId_ = stringTable_.getId("building");
+
+    auto groups = groupRelations();
+    auto resolveGroup = [&](const std::vector<std::uint64_t>& group) {
+        for (auto id : group)
+            resolve(*context_.relationMap.at(id));
+    };
+
+    std::size_t workerCount = std::min(threads_, groups.size());
+    if (workerCount < 2) {
+        for (const auto& group : groups)
+            resolveGroup(group);
+        return;
+    }
+
+    // NOTE groups are taken one by one, so task count limits concurrency. Failed
+    // group cancels the rest: its exception is rethrown by wait.
+    std::atomic<std::size_t> nextGroup(0);
+    utymap::utils::TaskGroup tasks;
+    auto worker = [&]() {
+        try {
+            for (auto index = nextGroup++; index < groups.size() && !tasks.isCancelled(); index = nextGroup++)
+                resolveGroup(groups[index]);
+        }
+        catch (...) {
+            tasks.cancel();
+            throw;
+        }
+    };
+
+    for (std::size_t i = 0; i < workerCount; ++i)
+        tasks.run(worker);
+    tasks.wait();
+}
+
+void OsmDataVisitor::setConcurrency(std::size_t threads)
+{
+    threads_ = threads;
+}
+
 void OsmDataVisitor::complete()
 {
     // All relations are visited can start to resolve them
-    for (auto& membersPair : relationMembers_) {
-        auto relationPair = context_.relationMap.find(membersPair.first);
-        if (relationPair != context_.relationMap.end())
-            resolve(*relationPair->second);
-    }
+    resolveRelations();
 
     for (const auto& pair : context_.relationMap) {
-        add_(*pair.second);
+        if (!isFiltered(*pair.second))
+            add_(*pair.second);
     }
 
     for (const auto& pair : context_.nodeMap) {
@@ -166,16 +437,31 @@ void OsmDataVisitor::complete()
     }
 
     for (const auto& pair : context_.wayMap) {
-        add_(*pair.second);
+        if (!isFiltered(*pair.second))
+            add_(*pair.second);
     }
 
     for (const auto& pair : context_.areaMap) {
-        add_(*pair.second);
+        if (!isFiltered(*pair.second))
+            add_(*pair.second);
     }
   
 }
 
+bool OsmDataVisitor::isFiltered(const Element& element) const
+{
+    if (!hasFilter_)
+        return false;
+
+    BoundingBoxVisitor bboxVisitor;
+    utymap::entities::visit(element, bboxVisitor);
+    return !filterBbox_.intersects(bboxVisitor.boundingBox);
+}
+
 OsmDataVisitor::OsmDataVisitor(StringTable& stringTable, std::function<bool(Element&)> add) 
-    : stringTable_(stringTable), add_(add), context_()
+    : stringTable_(stringTable), add_(add), context_(), relationMembers_(),
+      coordinates_(utymap::utils::make_unique<NodeCoordinateStore>()), isCoordinateFile_(false),
+      wayNodes_(nullptr), relationNodes_(nullptr), hasFilter_(false), filterBbox_(), predicate_(), nodeResolver_(), threads_(0),
+      typeKeyId_(0), multipolygonValueId_(0), buildingValueId_(0)
 {
 }
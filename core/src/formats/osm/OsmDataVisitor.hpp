@@ -5,16 +5,22 @@
 #include "GeoCoordinate.hpp"
 #include "entities/Element.hpp"
 #include "formats/FormatTypes.hpp"
+#include "formats/osm/NodeCoordinateStore.hpp"
+#include "formats/osm/NodeReferenceVisitor.hpp"
 #include "formats/osm/OsmDataContext.hpp"
 #include "index/StringTable.hpp"
 
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace utymap { namespace formats {
 
+/// Builds elements from osm data. Ids of ways and relations are mapped to element ids by OsmElementId
+/// as elements are identified by id only in stores.
 class OsmDataVisitor final
 {
 public:
@@ -22,6 +28,31 @@ public:
     OsmDataVisitor(utymap::index::StringTable& stringTable,
                    std::function<bool(utymap::entities::Element&)> add);
 
+    /// Restricts data to given bounding box: nodes outside of it, without tags or rejected by predicate
+    /// are kept only as coordinates, elements which do not intersect it are not reported.
+    void setFilter(const utymap::BoundingBox& bbox,
+                   std::function<bool(const utymap::entities::Element&)> predicate);
+
+    /// Keeps node coordinates in dense file backed store at given path instead of memory.
+    /// Only nodes with tags are created as elements then.
+    void setNodeCoordinateFile(const std::string& path);
+
+    /// Keeps only nodes which are tagged or referenced by ways or relations collected by first pass
+    /// over data. Untagged nodes referenced only by ways are kept as coordinates. Sets should live
+    /// till complete is called.
+    void setReferencedNodes(const NodeIdSet& wayNodes, const NodeIdSet& relationNodes);
+
+    /// Sets function which resolves coordinate of node which is not part of data, e.g. of node
+    /// stored by previous import. Ways with nodes which cannot be resolved are skipped.
+    void setNodeResolver(std::function<bool(std::uint64_t, utymap::GeoCoordinate&)> resolver);
+
+    /// Sets amount of threads which resolve independent relations on complete. Zero or one resolves them
+    /// on calling thread.
+    void setConcurrency(std::size_t threads);
+
+    /// Checks whether tags of node with given coordinate are used. NOTE can be called from decoding threads.
+    bool needsTags(const utymap::GeoCoordinate& coordinate) const;
+
     void visitBounds(utymap::BoundingBox bbox);
 
     void visitNode(std::uint64_t id, utymap::GeoCoordinate& coordinate, utymap::formats::Tags& tags);
@@ -30,18 +61,55 @@ public:
 
     void visitRelation(std::uint64_t id, utymap::formats::RelationMembers& members, utymap::formats::Tags& tags);
 
+    /// Maps strings to ids. Parsers which support it pass tags as string ids to visit methods.
+    /// NOTE can be called from decoding threads of parser.
+    std::vector<std::uint32_t> getStringIds(const std::vector<const char*>& strings);
+
+    void visitNode(std::uint64_t id, utymap::GeoCoordinate& coordinate, std::vector<utymap::entities::Tag>& tags);
+
+    void visitWay(std::uint64_t id, std::vector<std::uint64_t>& nodeIds, std::vector<utymap::entities::Tag>& tags);
+
+    void visitRelation(std::uint64_t id, utymap::formats::RelationMembers& members, std::vector<utymap::entities::Tag>& tags);
+
     void complete();
 
 private:
 
     bool isArea(const utymap::formats::Tags& tags) const;
-    bool hasTag(const std::string& key, const std::string& value, const std::vector<utymap::entities::Tag>& tags) const;
+    bool isArea(const std::vector<utymap::entities::Tag>& tags);
+    bool isCoordinateOnly(bool hasTags, const utymap::GeoCoordinate& coordinate) const;
+    bool isSkipped(std::uint64_t id, bool hasTags, const utymap::GeoCoordinate& coordinate);
+    void addNode(std::uint64_t id, const utymap::GeoCoordinate& coordinate, std::vector<utymap::entities::Tag>&& tags);
+    void addWay(std::uint64_t id, std::vector<std::uint64_t>& nodeIds, std::vector<utymap::entities::Tag>&& tags, bool isArea);
+    void addRelation(std::uint64_t id, const utymap::formats::RelationMembers& members, std::vector<utymap::entities::Tag>&& tags);
+    bool isFiltered(const utymap::entities::Element& element) const;
+    /// Splits relations into groups which can be resolved independently. Relations inside group
+    /// are ordered so that referenced relations precede relations which refer to them.
+    std::vector<std::vector<std::uint64_t>> groupRelations() const;
+    void resolveRelations();
     void resolve(utymap::entities::Relation& relation);
     
     utymap::index::StringTable& stringTable_;
     std::function<bool(utymap::entities::Element&)> add_;
     utymap::formats::OsmDataContext context_;
     std::unordered_map<std::uint64_t, utymap::formats::RelationMembers> relationMembers_;
+    /// Coordinates of nodes which are not created as elements due to filter.
+    std::unique_ptr<utymap::formats::NodeCoordinateStore> coordinates_;
+    bool isCoordinateFile_;
+    const NodeIdSet* wayNodes_;
+    const NodeIdSet* relationNodes_;
+    bool hasFilter_;
+    utymap::BoundingBox filterBbox_;
+    std::function<bool(const utymap::entities::Element&)> predicate_;
+    std::function<bool(std::uint64_t, utymap::GeoCoordinate&)> nodeResolver_;
+    std::size_t threads_;
+    /// Ids of strings which define relation type. Filled on complete.
+    std::uint32_t typeKeyId_;
+    std::uint32_t multipolygonValueId_;
+    std::uint32_t buildingValueId_;
+    /// Ids of area keys and false values. Filled on first use.
+    std::unordered_set<std::uint32_t> areaKeyIds_;
+    std::unordered_set<std::uint32_t> falseValueIds_;
 };
 
 }}
@@ -0,0 +1,51 @@
+#ifndef FORMATS_OSM_OSMELEMENTID_HPP_DEFINED
+#define FORMATS_OSM_OSMELEMENTID_HPP_DEFINED
+
+#include "entities/Element.hpp"
+#include "formats/FormatTypes.hpp"
+
+#include <cstdint>
+
+namespace utymap { namespace formats {
+
+/// Maps osm ids to element ids. Osm has separate id spaces for nodes, ways and relations while
+/// element stores identify elements by id only, so ids of ways and relations get type bit set.
+/// NOTE node ids are kept as is: node coordinate stores and references of ways use them.
+struct OsmElementId final
+{
+    static const std::uint64_t WayBit = static_cast<std::uint64_t>(1) << 61;
+    static const std::uint64_t RelationBit = static_cast<std::uint64_t>(1) << 62;
+
+    static std::uint64_t way(std::uint64_t id) { return id | WayBit; }
+
+    static std::uint64_t relation(std::uint64_t id) { return id | RelationBit; }
+
+    /// Returns element id of relation member.
+    static std::uint64_t member(const RelationMember& member)
+    {
+        if (member.type == "w")
+            return way(member.refId);
+        if (member.type == "r")
+            return relation(member.refId);
+        return member.refId;
+    }
+
+    /// Returns element id of osm element of given type which is stored with osm id, e.g. by
+    /// store written before type bits are used. Areas are built from ways or from outer ways
+    /// of multipolygons, so they have way ids. Id which has type bit already is not changed.
+    static std::uint64_t element(std::uint64_t id, utymap::entities::ElementType type)
+    {
+        if (id == 0 || (id & (WayBit | RelationBit)) != 0)
+            return id;
+        switch (type) {
+            case utymap::entities::ElementType::Way:
+            case utymap::entities::ElementType::Area: return way(id);
+            case utymap::entities::ElementType::Relation: return relation(id);
+            default: return id;
+        }
+    }
+};
+
+}}
+
+#endif // FORMATS_OSM_OSMELEMENTID_HPP_DEFINED
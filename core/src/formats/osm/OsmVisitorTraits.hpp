@@ -0,0 +1,58 @@
+#ifndef FORMATS_OSM_OSMVISITORTRAITS_HPP_DEFINED
+#define FORMATS_OSM_OSMVISITORTRAITS_HPP_DEFINED
+
+#include "GeoCoordinate.hpp"
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace utymap { namespace formats {
+
+/// Detects whether visitor can map strings to ids, so it accepts tags as string ids.
+template<typename Visitor>
+class HasStringIds final
+{
+    template<typename U>
+    static auto check(int) -> decltype(std::declval<U&>().getStringIds(std::declval<const std::vector<const char*>&>()), std::true_type());
+    template<typename>
+    static std::false_type check(...);
+public:
+    static const bool value = decltype(check<Visitor>(0))::value;
+};
+
+/// Detects whether visitor can tell that tags of node are not used.
+template<typename Visitor>
+class HasNodeFilter final
+{
+    template<typename U>
+    static auto check(int) -> decltype(std::declval<const U&>().needsTags(std::declval<const GeoCoordinate&>()), std::true_type());
+    template<typename>
+    static std::false_type check(...);
+public:
+    static const bool value = decltype(check<Visitor>(0))::value;
+};
+
+template<typename Visitor>
+inline bool needsNodeTags(const Visitor& visitor, const GeoCoordinate& coordinate, std::true_type)
+{
+    return visitor.needsTags(coordinate);
+}
+
+template<typename Visitor>
+inline bool needsNodeTags(const Visitor&, const GeoCoordinate&, std::false_type)
+{
+    return true;
+}
+
+/// Checks whether parser should read tags of node with given coordinate.
+template<typename Visitor>
+inline bool needsNodeTags(const Visitor& visitor, const GeoCoordinate& coordinate)
+{
+    return needsNodeTags(visitor, coordinate, std::integral_constant<bool, HasNodeFilter<Visitor>::value>());
+}
+
+}}
+
+#endif // FORMATS_OSM_OSMVISITORTRAITS_HPP_DEFINED
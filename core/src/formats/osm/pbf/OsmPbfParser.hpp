@@ -2,15 +2,32 @@
 #define FORMATS_PBF_OSMPBFPARSER_HPP_INCLUDED
 
 #include "BoundingBox.hpp"
+#include "entities/Element.hpp"
 #include "formats/FormatTypes.hpp"
+#include "formats/osm/OsmVisitorTraits.hpp"
+#include "utils/BoundedQueue.hpp"
 
+#include <google/protobuf/stubs/common.h>
+#if GOOGLE_PROTOBUF_VERSION >= 3000000
+#include <google/protobuf/arena.h>
+#endif
 #include <fileformat.pb.h>
 #include <osmformat.pb.h>
 #include <zlib.h>
 
+#include <algorithm>
+#include <condition_variable>
 #include <cstdint>
+#include <cstring>
+#include <exception>
+#include <future>
 #include <istream>
+#include <map>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace utymap { namespace formats {
@@ -26,12 +43,29 @@ public:
     OsmPbfParser() : 
         buffer_(MaxUncompressedBlobSize), 
         unpack_buffer_(MaxUncompressedBlobSize), 
-        finished_(false)
+        finished_(false),
+        workerCount_(0),
+        isOrdered_(true)
     {
     }
 
+    /// Enables decoding of data blocks by given amount of worker threads while file is read by
+    /// another one. Visitor is still called from the parsing thread: in file order or, if isOrdered
+    /// is false, in order blocks are decoded. Only getStringIds is called from worker threads.
+    /// Zero disables concurrent decoding.
+    void setConcurrency(std::size_t workerCount, bool isOrdered = true)
+    {
+        workerCount_ = workerCount;
+        isOrdered_ = isOrdered;
+    }
+
     void parse(std::istream& stream, Visitor& visitor)
     {
+        if (workerCount_ > 0) {
+            parseConcurrently(stream, visitor);
+            return;
+        }
+
         finished_ = false;
 
         while (!stream.eof() && !stream.fail() && !finished_) {
@@ -39,7 +73,8 @@ public:
             if (!finished_) {
                 std::int32_t sz = readBlob(header, stream);
                 if (header.type() == "OSMData") {
-                    parsePrimitiveBlock(sz, visitor);
+                    sz = unpackBlob(buffer_.data(), sz, unpack_buffer_);
+                    parsePrimitiveBlock(unpack_buffer_.data(), sz, visitor);
                 }
                 else if (header.type() == "OSMHeader") {
                     // used to be skipped
@@ -50,9 +85,298 @@ public:
 
 private:
 
+    /// Represents data blob which is read from file, but not decoded yet.
+    struct RawBlock final
+    {
+        std::size_t index;
+        std::string data;
+    };
+
+    /// Provides string ids mapping of visitor to block recorder if visitor supports it.
+    template<bool HasIds, typename = void>
+    class StringIdSource
+    {
+    public:
+        explicit StringIdSource(Visitor&) {}
+    };
+
+    template<typename T>
+    class StringIdSource<true, T>
+    {
+    public:
+        explicit StringIdSource(Visitor& visitor) : visitor_(&visitor) {}
+
+        /// NOTE called from decoding threads.
+        std::vector<std::uint32_t> getStringIds(const std::vector<const char*>& strings)
+        {
+            return visitor_->getStringIds(strings);
+        }
+
+    private:
+        Visitor* visitor_;
+    };
+
+    /// Records visitor calls made for decoded block to replay them later on parsing thread.
+    class BlockRecorder final : public StringIdSource<HasStringIds<Visitor>::value>
+    {
+        typedef typename std::conditional<HasStringIds<Visitor>::value,
+            std::vector<utymap::entities::Tag>, Tags>::type RecordedTags;
+
+        struct Record
+        {
+            char type;
+            std::uint64_t id;
+            GeoCoordinate coordinate;
+            std::vector<std::uint64_t> nodeIds;
+            RelationMembers members;
+            RecordedTags tags;
+        };
+
+    public:
+        explicit BlockRecorder(Visitor& visitor) :
+            StringIdSource<HasStringIds<Visitor>::value>(visitor), visitor_(&visitor), records_()
+        {
+        }
+
+        /// NOTE called from decoding threads.
+        bool needsTags(const GeoCoordinate& coordinate) const
+        {
+            return needsNodeTags(*visitor_, coordinate);
+        }
+
+        void visitNode(std::uint64_t id, GeoCoordinate& coordinate, RecordedTags& tags)
+        {
+            records_.push_back(Record { 'n', id, coordinate, {}, {}, std::move(tags) });
+        }
+
+        void visitWay(std::uint64_t id, std::vector<std::uint64_t>& nodeIds, RecordedTags& tags)
+        {
+            records_.push_back(Record { 'w', id, GeoCoordinate(), std::move(nodeIds), {}, std::move(tags) });
+        }
+
+        void visitRelation(std::uint64_t id, RelationMembers& members, RecordedTags& tags)
+        {
+            records_.push_back(Record { 'r', id, GeoCoordinate(), {}, std::move(members), std::move(tags) });
+        }
+
+        void replay(Visitor& visitor)
+        {
+            for (auto& record : records_) {
+                if (record.type == 'n')
+                    visitor.visitNode(record.id, record.coordinate, record.tags);
+                else if (record.type == 'w')
+                    visitor.visitWay(record.id, record.nodeIds, record.tags);
+                else
+                    visitor.visitRelation(record.id, record.members, record.tags);
+            }
+            records_.clear();
+        }
+
+    private:
+        Visitor* visitor_;
+        std::vector<Record> records_;
+    };
+
+    /// Sets tags as strings which reuse already allocated memory.
+    class StringTagWriter final
+    {
+    public:
+        typedef Tags Container;
+
+        explicit StringTagWriter(const OSMPBF::StringTable& strings) : strings_(strings) {}
+
+        void set(Tags& tags, std::size_t index, std::uint32_t key, std::uint32_t value) const
+        {
+            if (index >= tags.size())
+                tags.resize(index + 1);
+            tags[index].key.assign(strings_.s(key));
+            tags[index].value.assign(strings_.s(value));
+        }
+
+        void complete(Tags& tags, std::size_t count) const
+        {
+            tags.resize(count);
+        }
+
+    private:
+        const OSMPBF::StringTable& strings_;
+    };
+
+    /// Sets tags as string ids. Strings of block string table are mapped by visitor when they
+    /// are used by element first time, so strings of skipped elements are not mapped.
+    template<typename BlockVisitor>
+    class IdTagWriter final
+    {
+        enum : std::uint32_t { UnmappedId = 0xFFFFFFFF, RequestedId = 0xFFFFFFFE };
+
+    public:
+        typedef std::vector<utymap::entities::Tag> Container;
+
+        IdTagWriter(const OSMPBF::StringTable& strings, BlockVisitor& visitor) :
+            strings_(strings), visitor_(visitor),
+            ids_(static_cast<std::size_t>(strings.s_size()), static_cast<std::uint32_t>(UnmappedId)), requested_(), values_()
+        {
+        }
+
+        /// NOTE tag keeps indices of block strings till it is mapped by complete.
+        void set(Container& tags, std::size_t index, std::uint32_t key, std::uint32_t value) const
+        {
+            if (index >= tags.size())
+                tags.resize(index + 1);
+            tags[index] = utymap::entities::Tag(key, value);
+        }
+
+        void complete(Container& tags, std::size_t count) const
+        {
+            tags.resize(count);
+            for (const auto& tag : tags) {
+                request(tag.key);
+                request(tag.value);
+            }
+
+            // NOTE strings used by element first time are mapped at once.
+            if (!requested_.empty()) {
+                auto mapped = visitor_.getStringIds(values_);
+                for (std::size_t i = 0; i < requested_.size(); ++i)
+                    ids_[requested_[i]] = mapped[i];
+                requested_.clear();
+                values_.clear();
+            }
+
+            for (auto& tag : tags)
+                tag = utymap::entities::Tag(ids_[tag.key], ids_[tag.value]);
+            // NOTE: tags should be sorted to speed up mapcss styling
+            std::sort(tags.begin(), tags.end());
+        }
+
+    private:
+        void request(std::uint32_t index) const
+        {
+            if (ids_.at(index) != UnmappedId)
+                return;
+            ids_[index] = RequestedId;
+            requested_.push_back(index);
+            values_.push_back(strings_.s(static_cast<int>(index)).c_str());
+        }
+
+        const OSMPBF::StringTable& strings_;
+        BlockVisitor& visitor_;
+        mutable std::vector<std::uint32_t> ids_;
+        mutable std::vector<std::uint32_t> requested_;
+        mutable std::vector<const char*> values_;
+    };
+
     std::vector<char> buffer_;
     std::vector<char> unpack_buffer_;
     bool finished_;
+    std::size_t workerCount_;
+    bool isOrdered_;
+
+    /// Reads blobs on separate thread, decodes them on worker threads and replays decoded blocks.
+    void parseConcurrently(std::istream& stream, Visitor& visitor)
+    {
+        const std::size_t capacity = 2 * workerCount_;
+        utymap::utils::BoundedQueue<RawBlock> rawBlocks(capacity);
+
+        // NOTE decoded blocks are guarded by lock. Block expected next in ordered mode is
+        // always accepted, so workers cannot wait for each other.
+        std::mutex lock;
+        std::condition_variable changed;
+        std::map<std::size_t, BlockRecorder> decoded;
+        std::size_t nextIndex = 0;
+        std::size_t activeWorkers = workerCount_;
+        bool isCancelled = false;
+        std::exception_ptr exception;
+
+        auto fail = [&]() {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!exception)
+                    exception = std::current_exception();
+                isCancelled = true;
+                changed.notify_all();
+            }
+            rawBlocks.cancel();
+        };
+
+        auto reader = std::async(std::launch::async, [&]() {
+            try {
+                finished_ = false;
+                std::size_t index = 0;
+                while (!stream.eof() && !stream.fail() && !finished_) {
+                    OSMPBF::BlobHeader header = readHeader(stream);
+                    if (finished_)
+                        break;
+                    std::int32_t sz = readBlob(header, stream);
+                    if (header.type() != "OSMData")
+                        continue;
+                    if (!rawBlocks.push(RawBlock { index++, std::string(buffer_.data(), sz) }))
+                        break;
+                }
+                rawBlocks.close();
+            }
+            catch (...) { fail(); }
+        });
+
+        auto worker = [&]() {
+            try {
+                std::vector<char> unpacked(MaxUncompressedBlobSize);
+                RawBlock block;
+                while (rawBlocks.pop(block)) {
+                    BlockRecorder recorder(visitor);
+                    std::int32_t sz = unpackBlob(block.data.data(), static_cast<std::int32_t>(block.data.size()), unpacked);
+                    parsePrimitiveBlock(unpacked.data(), sz, recorder);
+
+                    std::unique_lock<std::mutex> guard(lock);
+                    changed.wait(guard, [&]() {
+                        return isCancelled || decoded.size() < capacity || (isOrdered_ && block.index == nextIndex);
+                    });
+                    if (isCancelled)
+                        break;
+                    decoded.emplace(block.index, std::move(recorder));
+                    changed.notify_all();
+                }
+            }
+            catch (...) { fail(); }
+
+            std::lock_guard<std::mutex> guard(lock);
+            --activeWorkers;
+            changed.notify_all();
+        };
+
+        std::vector<std::future<void>> workers;
+        for (std::size_t i = 0; i < workerCount_; ++i)
+            workers.push_back(std::async(std::launch::async, worker));
+
+        try {
+            for (;;) {
+                BlockRecorder recorder(visitor);
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    auto isReady = [&]() {
+                        return !decoded.empty() && (!isOrdered_ || decoded.begin()->first == nextIndex);
+                    };
+                    changed.wait(guard, [&]() { return isCancelled || isReady() || activeWorkers == 0; });
+                    if (isCancelled || !isReady())
+                        break;
+
+                    recorder = std::move(decoded.begin()->second);
+                    decoded.erase(decoded.begin());
+                    ++nextIndex;
+                    changed.notify_all();
+                }
+                recorder.replay(visitor);
+            }
+        }
+        catch (...) { fail(); }
+
+        for (auto& result : workers)
+            result.get();
+        reader.get();
+
+        if (exception)
+            std::rethrow_exception(exception);
+    }
 
     OSMPBF::BlobHeader readHeader(std::istream& stream)
     {
@@ -81,10 +405,9 @@ private:
         return result;
     }
 
+    /// Reads serialized blob into buffer and returns its size.
     std::int32_t readBlob(const OSMPBF::BlobHeader& header, std::istream& stream)
     {
-        OSMPBF::Blob blob;
-
         std::int32_t sz = header.datasize();
 
         if (sz > MaxUncompressedBlobSize)
@@ -93,13 +416,21 @@ private:
         if (!stream.read(buffer_.data(), sz))
             throw std::domain_error("Unable to read blob from file");
 
-        if (!blob.ParseFromArray(buffer_.data(), sz))
+        return sz;
+    }
+
+    /// Parses serialized blob and writes its uncompressed content to output. Returns content size.
+    static std::int32_t unpackBlob(const char* data, std::int32_t sz, std::vector<char>& output)
+    {
+        OSMPBF::Blob blob;
+
+        if (!blob.ParseFromArray(data, sz))
             throw std::domain_error("Unable to parse blob");
 
         // uncompressed
         if (blob.has_raw()) {
             sz = static_cast<std::int32_t>(blob.raw().size());
-            memcpy(unpack_buffer_.data(), buffer_.data(), sz);
+            memcpy(output.data(), blob.raw().data(), sz);
             return sz;
         }
 
@@ -109,7 +440,7 @@ private:
             z_stream z;
             z.next_in = (unsigned char*)blob.zlib_data().c_str();
             z.avail_in = sz;
-            z.next_out = reinterpret_cast<unsigned char*>(unpack_buffer_.data());
+            z.next_out = reinterpret_cast<unsigned char*>(output.data());
             z.avail_out = blob.raw_size();
             z.zalloc = Z_NULL;
             z.zfree = Z_NULL;
@@ -133,98 +464,124 @@ private:
         return 0;
     }
 
-    void parsePrimitiveBlock(int32_t sz, Visitor& visitor)
+    /// Parses primitive block calling visitor for every element. Messages are allocated in arena and
+    /// accessed by reference; tag and member containers are reused between elements of the block.
+    template<typename BlockVisitor>
+    static void parsePrimitiveBlock(const char* data, int32_t sz, BlockVisitor& visitor)
     {
+#if GOOGLE_PROTOBUF_VERSION >= 3000000
+        google::protobuf::Arena arena;
+        auto& primblock = *google::protobuf::Arena::CreateMessage<OSMPBF::PrimitiveBlock>(&arena);
+#else
         OSMPBF::PrimitiveBlock primblock;
-
-        if (!primblock.ParseFromArray(unpack_buffer_.data(), sz))
+#endif
+        if (!primblock.ParseFromArray(data, sz))
             throw std::domain_error("Unable to parse primitive block");
 
+        visitBlock(primblock, visitor, std::integral_constant<bool, HasStringIds<BlockVisitor>::value>());
+    }
+
+    /// Visits elements with tags as string ids: strings of block string table are mapped by
+    /// visitor once when they are used first time.
+    template<typename BlockVisitor>
+    static void visitBlock(const OSMPBF::PrimitiveBlock& primblock, BlockVisitor& visitor, std::true_type)
+    {
+        visitElements(primblock, IdTagWriter<BlockVisitor>(primblock.stringtable(), visitor), visitor);
+    }
+
+    /// Visits elements with tags as strings copied from block string table.
+    template<typename BlockVisitor>
+    static void visitBlock(const OSMPBF::PrimitiveBlock& primblock, BlockVisitor& visitor, std::false_type)
+    {
+        visitElements(primblock, StringTagWriter(primblock.stringtable()), visitor);
+    }
+
+    template<typename TagWriter, typename BlockVisitor>
+    static void visitElements(const OSMPBF::PrimitiveBlock& primblock, const TagWriter& tagWriter, BlockVisitor& visitor)
+    {
+        const double granularity = 0.000000001 * primblock.granularity();
+        const double latOffset = 0.000000001 * primblock.lat_offset();
+        const double lonOffset = 0.000000001 * primblock.lon_offset();
+
+        typename TagWriter::Container tags;
+        std::vector<uint64_t> nodeIds;
+        RelationMembers members;
+
         for (int i = 0, l = primblock.primitivegroup_size(); i < l; i++) {
-            OSMPBF::PrimitiveGroup pg = primblock.primitivegroup(i);
+            const OSMPBF::PrimitiveGroup& pg = primblock.primitivegroup(i);
 
             // simple nodes
             for (int i = 0; i < pg.nodes_size(); ++i) {
-                OSMPBF::Node n = pg.nodes(i);
-                GeoCoordinate coordinate;
-                coordinate.latitude = 0.000000001 * (primblock.lat_offset() + (primblock.granularity() * n.lat()));
-                coordinate.longitude = 0.000000001 * (primblock.lon_offset() + (primblock.granularity() * n.lon()));
-                uint64_t id = n.id();
-                Tags tags;
-                setTags(n, primblock, tags);
-                visitor.visitNode(id, coordinate, tags);
+                const OSMPBF::Node& n = pg.nodes(i);
+                GeoCoordinate coordinate(latOffset + granularity * n.lat(), lonOffset + granularity * n.lon());
+                if (needsNodeTags(visitor, coordinate))
+                    setTags(n, tagWriter, tags);
+                else
+                    tagWriter.complete(tags, 0);
+                visitor.visitNode(n.id(), coordinate, tags);
             }
 
             // dense nodes
             if (pg.has_dense()) {
-                OSMPBF::DenseNodes dn = pg.dense();
+                const OSMPBF::DenseNodes& dn = pg.dense();
                 uint64_t id = 0;
-                double lon = 0;
-                double lat = 0;
+                int64_t lat = 0;
+                int64_t lon = 0;
 
                 int current_kv = 0;
 
                 for (int i = 0; i < dn.id_size(); ++i) {
                     id += dn.id(i);
-                    lat += 0.000000001 * (primblock.lat_offset() + (primblock.granularity() * dn.lat(i)));
-                    lon += 0.000000001 * (primblock.lon_offset() + (primblock.granularity() * dn.lon(i)));
+                    lat += dn.lat(i);
+                    lon += dn.lon(i);
 
-                    Tags tags;
-                    tags.reserve(2);
+                    GeoCoordinate coordinate(latOffset + granularity * lat, lonOffset + granularity * lon);
+                    bool hasTags = needsNodeTags(visitor, coordinate);
+                    std::size_t count = 0;
                     while (current_kv < dn.keys_vals_size() && dn.keys_vals(current_kv) != 0) {
-                        auto key = dn.keys_vals(current_kv);
-                        auto val = dn.keys_vals(current_kv + 1);
-                        Tag tag;
-                        tag.key = primblock.stringtable().s(key);
-                        tag.value = primblock.stringtable().s(val);
+                        if (hasTags)
+                            tagWriter.set(tags, count++, dn.keys_vals(current_kv), dn.keys_vals(current_kv + 1));
                         current_kv += 2;
-                        tags.push_back(tag);
                     }
+                    tagWriter.complete(tags, count);
                     ++current_kv;
-                    GeoCoordinate coordinate(lat, lon);
                     visitor.visitNode(id, coordinate, tags);
                 }
             }
 
             for (int i = 0; i < pg.ways_size(); ++i) {
-                OSMPBF::Way w = pg.ways(i);
+                const OSMPBF::Way& w = pg.ways(i);
 
                 uint64_t ref = 0;
-                std::vector<uint64_t> nodeIds;
+                nodeIds.clear();
                 nodeIds.reserve(w.refs_size());
                 for (int j = 0; j < w.refs_size(); ++j) {
                     ref += w.refs(j);
                     nodeIds.push_back(ref);
                 }
-                uint64_t id = w.id();
-                Tags tags;
-                setTags(w, primblock, tags);
-                visitor.visitWay(id, nodeIds, tags);
+                setTags(w, tagWriter, tags);
+                visitor.visitWay(w.id(), nodeIds, tags);
             }
 
             for (int i = 0; i < pg.relations_size(); ++i) {
-                OSMPBF::Relation rel = pg.relations(i);
+                const OSMPBF::Relation& rel = pg.relations(i);
                 uint64_t id = 0;
-                RelationMembers refs;
-                refs.reserve(rel.memids_size());
+                members.resize(rel.memids_size());
                 for (int l = 0; l < rel.memids_size(); ++l) {
                     id += rel.memids(l);
-                    RelationMember member;
+                    RelationMember& member = members[l];
                     member.refId = id;
                     member.type = parseType(rel, l);
-                    member.role = primblock.stringtable().s(rel.roles_sid(l));
-                    refs.push_back(member);
+                    member.role.assign(primblock.stringtable().s(rel.roles_sid(l)));
                 }
 
-                uint64_t rel_id = rel.id();
-                Tags tags;
-                setTags(rel, primblock, tags);
-                visitor.visitRelation(rel_id, refs, tags);
+                setTags(rel, tagWriter, tags);
+                visitor.visitRelation(rel.id(), members, tags);
             }
         }
     }
 
-    static std::string parseType(OSMPBF::Relation& rel, int index)
+    static const char* parseType(const OSMPBF::Relation& rel, int index)
     {
         switch (rel.types(index)) {
         case OSMPBF::Relation::NODE:
@@ -237,18 +594,13 @@ private:
         }
     }
 
-    template<typename T>
-    void setTags(T object, const OSMPBF::PrimitiveBlock& primblock, Tags& tags)
+    template<typename T, typename TagWriter>
+    static void setTags(const T& object, const TagWriter& tagWriter, typename TagWriter::Container& tags)
     {
-        tags.reserve(object.keys_size());
-        for (int i = 0; i < object.keys_size(); ++i) {
-            Tag tag;
-            auto key = object.keys(i);
-            auto val = object.vals(i);
-            tag.key = primblock.stringtable().s(key);
-            tag.value = primblock.stringtable().s(val);
-            tags.push_back(tag);
-        }
+        std::size_t count = static_cast<std::size_t>(object.keys_size());
+        for (std::size_t i = 0; i < count; ++i)
+            tagWriter.set(tags, i, object.keys(i), object.vals(i));
+        tagWriter.complete(tags, count);
     }
 };
 
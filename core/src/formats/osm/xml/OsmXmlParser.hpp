@@ -3,142 +3,186 @@
 
 #include "BoundingBox.hpp"
 #include "formats/FormatTypes.hpp"
-
-#include <boost/foreach.hpp>
-#include <boost/property_tree/xml_parser.hpp>
-#include <boost/property_tree/ptree.hpp>
+#include "formats/osm/OsmVisitorTraits.hpp"
+#include "formats/osm/xml/XmlReader.hpp"
 
 #include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
 
 namespace utymap { namespace formats {
 
+/// Parses osm xml data as stream: elements are visited once they are read,
+/// so memory usage does not depend on data size.
 template<typename Visitor>
 class OsmXmlParser
 {
-    using ptree = boost::property_tree::ptree;
+    using Event = XmlReader::Event;
 
 public:
     // Parses osm xml data from stream calling visitor
     void parse(std::istream& istream, Visitor& visitor)
     {
-        ptree pt;
-        read_xml(istream, pt);
-
-        BOOST_FOREACH(ptree::value_type const& child, pt.get_child("osm"))
-        {
-            if (child.first == "node")
-                parseNode(visitor, child);
-            else if (child.first == "way")
-                parseWays(visitor, child);
-            else if (child.first == "relation")
-                parseRelations(visitor, child);
-            else if (child.first == "bounds")
-                parseBounds(visitor, child);
+        XmlReader reader(istream);
+        for (Event event = reader.next(); event != Event::End; event = reader.next()) {
+            if (event != Event::StartElement)
+                continue;
+
+            if (!parseElement(reader, visitor) && reader.name() == "bounds")
+                parseBounds(reader, visitor);
+        }
+    }
+
+    // Parses osm change data from stream calling visitor for every action section
+    void parseChange(std::istream& istream, Visitor& visitor)
+    {
+        XmlReader reader(istream);
+        for (Event event = reader.next(); event != Event::End; event = reader.next()) {
+            if (event != Event::StartElement || parseElement(reader, visitor))
+                continue;
+
+            const std::string& name = reader.name();
+            if (name == "create")
+                visitor.visitChange(ChangeAction::Create);
+            else if (name == "modify")
+                visitor.visitChange(ChangeAction::Modify);
+            else if (name == "delete")
+                visitor.visitChange(ChangeAction::Delete);
         }
     }
 
 private:
 
-    static void parseBounds(Visitor& visitor, ptree::value_type const& node)
+    /// Parses node, way or relation which starts at current element. Returns false for other elements.
+    static bool parseElement(XmlReader& reader, Visitor& visitor)
+    {
+        const std::string& name = reader.name();
+        if (name == "node")
+            parseNode(reader, visitor);
+        else if (name == "way")
+            parseWay(reader, visitor);
+        else if (name == "relation")
+            parseRelation(reader, visitor);
+        else
+            return false;
+        return true;
+    }
+
+    static const std::string& getAttribute(const XmlReader& reader, const char* name)
+    {
+        const std::string* value = reader.attribute(name);
+        if (value == nullptr)
+            throw std::domain_error(std::string("Missing attribute '") + name + "' of " + reader.name());
+        return *value;
+    }
+
+    static std::uint64_t getId(const XmlReader& reader, const char* name)
+    {
+        return std::strtoull(getAttribute(reader, name).c_str(), nullptr, 10);
+    }
+
+    static double getDouble(const XmlReader& reader, const char* name)
     {
-        const ptree & attributes = node.second.get_child("<xmlattr>");
+        return std::strtod(getAttribute(reader, name).c_str(), nullptr);
+    }
+
+    /// Reads events until current element is closed calling handler for every child start element.
+    template<typename Handler>
+    static void parseChildren(XmlReader& reader, const char* elementName, const Handler& handler)
+    {
+        for (Event event = reader.next(); event != Event::End; event = reader.next()) {
+            if (event == Event::StartElement)
+                handler();
+            else if (reader.name() == elementName)
+                return;
+        }
+        throw std::domain_error(std::string("Unexpected end of data in ") + elementName);
+    }
 
+    static void parseBounds(XmlReader& reader, Visitor& visitor)
+    {
         GeoCoordinate minPoint, maxPoint;
-        minPoint.latitude = attributes.get_child("minlat").get_value<double>();
-        minPoint.longitude = attributes.get_child("minlon").get_value<double>();
-        maxPoint.latitude = attributes.get_child("maxlat").get_value<double>();
-        maxPoint.longitude = attributes.get_child("maxlon").get_value<double>();
+        minPoint.latitude = getDouble(reader, "minlat");
+        minPoint.longitude = getDouble(reader, "minlon");
+        maxPoint.latitude = getDouble(reader, "maxlat");
+        maxPoint.longitude = getDouble(reader, "maxlon");
 
         visitor.visitBounds(BoundingBox(minPoint, maxPoint));
     }
 
-    static void parseTag(ptree::value_type const& node, Tags& tags)
+    static void parseTag(const XmlReader& reader, Tags& tags)
     {
-        const ptree & attributes = node.second.get_child("<xmlattr>");
-
         Tag tag;
-        tag.key = attributes.get_child("k").data();
-        tag.value = attributes.get_child("v").data();
+        tag.key = getAttribute(reader, "k");
+        tag.value = getAttribute(reader, "v");
         tags.push_back(tag);
     }
 
-    static void parseNode(Visitor& visitor, ptree::value_type const& node)
+    static void parseNode(XmlReader& reader, Visitor& visitor)
     {
-        const ptree & attributes = node.second.get_child("<xmlattr>");
-
         GeoCoordinate coordinate;
-        uint64_t id = attributes.get_child("id").get_value<uint64_t>();
-        coordinate.latitude = attributes.get_child("lat").get_value<double>();
-        coordinate.longitude = attributes.get_child("lon").get_value<double>();
+        uint64_t id = getId(reader, "id");
+        // NOTE deleted nodes in change files may have no coordinate.
+        const std::string* latitude = reader.attribute("lat");
+        const std::string* longitude = reader.attribute("lon");
+        if (latitude != nullptr && longitude != nullptr) {
+            coordinate.latitude = std::strtod(latitude->c_str(), nullptr);
+            coordinate.longitude = std::strtod(longitude->c_str(), nullptr);
+        }
 
         Tags tags;
-        tags.reserve(2);
-        BOOST_FOREACH(ptree::value_type const& child, node.second)
-        {
-            if (child.first == "tag")
-                parseTag(child, tags);
-        }
+        bool needsTags = needsNodeTags(visitor, coordinate);
+        parseChildren(reader, "node", [&]() {
+            if (needsTags && reader.name() == "tag")
+                parseTag(reader, tags);
+        });
 
         visitor.visitNode(id, coordinate, tags);
     }
 
-    static void parseWays(Visitor& visitor, ptree::value_type const& node)
+    static void parseWay(XmlReader& reader, Visitor& visitor)
     {
-        uint64_t id = node.second.get_child("<xmlattr>")
-            .get_child("id")
-            .get_value<uint64_t>();
+        uint64_t id = getId(reader, "id");
 
         std::vector<uint64_t> nodeIds;
         Tags tags;
         nodeIds.reserve(4);
         tags.reserve(2);
-        BOOST_FOREACH(ptree::value_type const& child, node.second)
-        {
-            if (child.first == "nd")
-            {
-                uint64_t refId = child.second.get_child("<xmlattr>")
-                    .get_child("ref")
-                    .get_value<uint64_t>();
-                nodeIds.push_back(refId);
-            }
-            else if (child.first == "tag")
-                parseTag(child, tags);
-        }
+        parseChildren(reader, "way", [&]() {
+            if (reader.name() == "nd")
+                nodeIds.push_back(getId(reader, "ref"));
+            else if (reader.name() == "tag")
+                parseTag(reader, tags);
+        });
 
         visitor.visitWay(id, nodeIds, tags);
     }
 
-    static void parseRelations(Visitor& visitor, ptree::value_type const& node)
+    static void parseRelation(XmlReader& reader, Visitor& visitor)
     {
-        uint64_t id = node.second.get_child("<xmlattr>")
-            .get_child("id")
-            .get_value<uint64_t>();
+        uint64_t id = getId(reader, "id");
 
         Tags tags;
         RelationMembers members;
         tags.reserve(2);
         members.reserve(2);
-        BOOST_FOREACH(ptree::value_type const& child, node.second)
-        {
-            if (child.first == "member")
-            {
+        parseChildren(reader, "relation", [&]() {
+            if (reader.name() == "member") {
                 RelationMember member;
-                const ptree& attributes = child.second.get_child("<xmlattr>");
-
-                member.refId = attributes.get_child("ref").get_value<uint64_t>();
-                member.type = getType(attributes);
-                member.role = attributes.get_child("role").get_value<std::string>();
+                member.refId = getId(reader, "ref");
+                member.type = getType(getAttribute(reader, "type"));
+                member.role = getAttribute(reader, "role");
                 members.push_back(member);
             }
-            else if (child.first == "tag")
-                parseTag(child, tags);
-        }
+            else if (reader.name() == "tag")
+                parseTag(reader, tags);
+        });
         visitor.visitRelation(id, members, tags);
     }
 
-    static std::string getType(const ptree& attributes)
+    static std::string getType(const std::string& type)
     {
-        auto type = attributes.get_child("type").get_value<std::string>();
         if (type == "node")
             return "n";
         if (type == "way")
@@ -0,0 +1,224 @@
+#include "formats/osm/xml/XmlReader.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+using namespace utymap::formats;
+
+namespace {
+    const std::size_t BufferSize = 64 * 1024;
+    const int EndOfData = -1;
+
+    bool isSpace(int c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    bool isNameEnd(int c)
+    {
+        return c == EndOfData || isSpace(c) || c == '/' || c == '>' || c == '=';
+    }
+
+    /// Appends code point encoded as utf-8.
+    void appendUtf8(std::string& value, unsigned long code)
+    {
+        if (code < 0x80) {
+            value.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            value.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            value.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            value.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            value.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            value.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            value.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            value.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            value.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            value.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+}
+
+XmlReader::XmlReader(std::istream& istream) :
+    istream_(istream), buffer_(BufferSize), position_(0), size_(0),
+    name_(), attributes_(), attributeCount_(0), isEmptyElement_(false)
+{
+}
+
+XmlReader::Event XmlReader::next()
+{
+    if (isEmptyElement_) {
+        isEmptyElement_ = false;
+        attributeCount_ = 0;
+        return Event::EndElement;
+    }
+
+    while (true) {
+        int c = get();
+        while (c != '<') {
+            if (c == EndOfData)
+                return Event::End;
+            c = get();
+        }
+
+        c = peek();
+        if (c == '?') {
+            skipUntil("?>");
+        } else if (c == '!') {
+            get();
+            if (peek() == '-') skipUntil("-->");
+            else if (peek() == '[') skipUntil("]]>");
+            else skipUntil(">");
+        } else if (c == '/') {
+            get();
+            readName(name_);
+            skipUntil(">");
+            attributeCount_ = 0;
+            return Event::EndElement;
+        } else {
+            readName(name_);
+            if (name_.empty())
+                throw std::domain_error("Invalid xml: element name is expected.");
+            readAttributes();
+            return Event::StartElement;
+        }
+    }
+}
+
+const std::string* XmlReader::attribute(const char* name) const
+{
+    for (std::size_t i = 0; i < attributeCount_; ++i) {
+        if (attributes_[i].first == name)
+            return &attributes_[i].second;
+    }
+    return nullptr;
+}
+
+int XmlReader::get()
+{
+    if (position_ == size_)
+        fill();
+    return position_ < size_ ? static_cast<unsigned char>(buffer_[position_++]) : EndOfData;
+}
+
+int XmlReader::peek()
+{
+    if (position_ == size_)
+        fill();
+    return position_ < size_ ? static_cast<unsigned char>(buffer_[position_]) : EndOfData;
+}
+
+void XmlReader::fill()
+{
+    istream_.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    size_ = static_cast<std::size_t>(istream_.gcount());
+    position_ = 0;
+}
+
+void XmlReader::skipSpaces()
+{
+    while (isSpace(peek()))
+        get();
+}
+
+void XmlReader::skipUntil(const char* terminator)
+{
+    const std::size_t length = std::strlen(terminator);
+    std::size_t matched = 0;
+    while (matched < length) {
+        int c = get();
+        if (c == EndOfData)
+            throw std::domain_error("Invalid xml: unexpected end of data.");
+        if (c == terminator[matched])
+            ++matched;
+        else if (c != terminator[0])
+            matched = 0;
+        else if (matched == 0 || terminator[matched - 1] != c)
+            matched = 1;
+    }
+}
+
+void XmlReader::readName(std::string& name)
+{
+    name.clear();
+    while (!isNameEnd(peek()))
+        name.push_back(static_cast<char>(get()));
+}
+
+void XmlReader::readAttributes()
+{
+    attributeCount_ = 0;
+    while (true) {
+        skipSpaces();
+        int c = peek();
+        if (c == '>') {
+            get();
+            return;
+        }
+        if (c == '/') {
+            get();
+            skipUntil(">");
+            isEmptyElement_ = true;
+            return;
+        }
+        if (c == EndOfData)
+            throw std::domain_error("Invalid xml: unexpected end of data.");
+
+        if (attributeCount_ == attributes_.size())
+            attributes_.emplace_back();
+        auto& attribute = attributes_[attributeCount_++];
+        readName(attribute.first);
+        skipSpaces();
+        if (get() != '=')
+            throw std::domain_error("Invalid xml: attribute value is expected.");
+        skipSpaces();
+        int quote = get();
+        if (quote != '"' && quote != '\'')
+            throw std::domain_error("Invalid xml: quoted attribute value is expected.");
+        readValue(attribute.second, quote);
+    }
+}
+
+void XmlReader::readValue(std::string& value, int quote)
+{
+    value.clear();
+    while (true) {
+        int c = get();
+        if (c == quote)
+            return;
+        if (c == EndOfData)
+            throw std::domain_error("Invalid xml: unexpected end of data.");
+        if (c == '&')
+            readEntity(value);
+        else
+            value.push_back(static_cast<char>(c));
+    }
+}
+
+void XmlReader::readEntity(std::string& value)
+{
+    char entity[12];
+    std::size_t length = 0;
+    int c = get();
+    while (c != ';') {
+        if (c == EndOfData || length == sizeof(entity) - 1)
+            throw std::domain_error("Invalid xml: bad entity reference.");
+        entity[length++] = static_cast<char>(c);
+        c = get();
+    }
+    entity[length] = '\0';
+
+    if (std::strcmp(entity, "amp") == 0) value.push_back('&');
+    else if (std::strcmp(entity, "lt") == 0) value.push_back('<');
+    else if (std::strcmp(entity, "gt") == 0) value.push_back('>');
+    else if (std::strcmp(entity, "quot") == 0) value.push_back('"');
+    else if (std::strcmp(entity, "apos") == 0) value.push_back('\'');
+    else if (entity[0] == '#' && entity[1] == 'x')
+        appendUtf8(value, std::strtoul(entity + 2, nullptr, 16));
+    else if (entity[0] == '#')
+        appendUtf8(value, std::strtoul(entity + 1, nullptr, 10));
+    else
+        throw std::domain_error("Invalid xml: unknown entity reference.");
+}
@@ -0,0 +1,59 @@
+#ifndef FORMATS_XML_XMLREADER_HPP_INCLUDED
+#define FORMATS_XML_XMLREADER_HPP_INCLUDED
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace utymap { namespace formats {
+
+/// Streaming pull reader of xml elements. Keeps only current element name and attributes
+/// in memory, so data is read by small chunks regardless of its size. Text content,
+/// comments, processing instructions and declarations are skipped.
+class XmlReader final
+{
+public:
+    /// Type of read event.
+    enum class Event { StartElement, EndElement, End };
+
+    explicit XmlReader(std::istream& istream);
+
+    XmlReader(const XmlReader&) = delete;
+    XmlReader& operator=(const XmlReader&) = delete;
+
+    /// Reads next event. Empty element produces start and end events.
+    Event next();
+
+    /// Returns name of current element.
+    const std::string& name() const { return name_; }
+
+    /// Returns value of attribute of current start element or nullptr if there is no such attribute.
+    const std::string* attribute(const char* name) const;
+
+private:
+    int get();
+    int peek();
+    void fill();
+    void skipSpaces();
+    void skipUntil(const char* terminator);
+    void readName(std::string& name);
+    void readAttributes();
+    void readValue(std::string& value, int quote);
+    void readEntity(std::string& value);
+
+    std::istream& istream_;
+    std::vector<char> buffer_;
+    std::size_t position_;
+    std::size_t size_;
+    std::string name_;
+    /// Attributes of current element. Strings are reused between elements to avoid allocations.
+    std::vector<std::pair<std::string, std::string>> attributes_;
+    std::size_t attributeCount_;
+    bool isEmptyElement_;
+};
+
+}}
+
+#endif  // FORMATS_XML_XMLREADER_HPP_INCLUDED
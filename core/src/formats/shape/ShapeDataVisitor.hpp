@@ -15,6 +15,7 @@
 #include <functional>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace utymap { namespace formats {
 
@@ -35,23 +36,41 @@ struct ShapeDataVisitor final
     {
     }
 
+    /// Maps strings to ids, so parser passes tags as string ids. NOTE can be called from reading threads.
+    std::vector<std::uint32_t> getStringIds(const std::vector<const char*>& strings)
+    {
+        return stringTable_.getIds(strings);
+    }
+
     void visitNode(utymap::GeoCoordinate& coordinate, utymap::formats::Tags& tags)
+    {
+        auto convertedTags = utymap::utils::convertTags(stringTable_, tags);
+        visitNode(coordinate, convertedTags);
+    }
+
+    void visitNode(utymap::GeoCoordinate& coordinate, std::vector<utymap::entities::Tag>& tags)
     {
         utymap::entities::Node node;
         node.id = 0;
         node.coordinate = coordinate;
-        utymap::utils::setTags(stringTable_, node, tags);
+        node.tags = std::move(tags);
         if (functor_(node))
             nodes++;
     }
 
     void visitWay(utymap::formats::Coordinates& coordinates, utymap::formats::Tags& tags, bool isRing)
+    {
+        auto convertedTags = utymap::utils::convertTags(stringTable_, tags);
+        visitWay(coordinates, convertedTags, isRing);
+    }
+
+    void visitWay(utymap::formats::Coordinates& coordinates, std::vector<utymap::entities::Tag>& tags, bool isRing)
     {
         if (isRing) {
             utymap::entities::Area area;
             area.id = 0;
             area.coordinates = std::move(coordinates);
-            utymap::utils::setTags(stringTable_, area, tags);
+            area.tags = std::move(tags);
             if (functor_(area))
                 areas++;
         }
@@ -59,17 +78,23 @@ struct ShapeDataVisitor final
             utymap::entities::Way way;
             way.id = 0;
             way.coordinates = std::move(coordinates);
-            utymap::utils::setTags(stringTable_, way, tags);
+            way.tags = std::move(tags);
             if (functor_(way))
                 ways++;
         }
     }
 
     void visitRelation(utymap::formats::PolygonMembers& members, utymap::formats::Tags& tags)
+    {
+        auto convertedTags = utymap::utils::convertTags(stringTable_, tags);
+        visitRelation(members, convertedTags);
+    }
+
+    void visitRelation(utymap::formats::PolygonMembers& members, std::vector<utymap::entities::Tag>& tags)
     {
         utymap::entities::Relation relation;
         relation.id = 0;
-        utymap::utils::setTags(stringTable_, relation, tags);
+        relation.tags = std::move(tags);
         for (const auto& member : members) {
             if (member.coordinates.size() == 1) {
                 auto node = std::make_shared<utymap::entities::Node>();
@@ -0,0 +1,314 @@
+#include "formats/shape/ShapeIndex.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <unordered_set>
+
+using namespace utymap;
+using namespace utymap::formats;
+
+namespace {
+    ///                                      Index file format
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Header       |  "SQT" (3b), byte order: 1 - LSB, 2 - MSB (1b), version (1b), reserved (3b),      |
+    ///                  |  amount of shapes (4b) and max depth of tree (4b)                                 |
+    ///------------------------------------------------------------------------------------------------------|
+    ///      Node        |  Size of child nodes in bytes (4b), bounds: min x, min y, max x, max y (4 x 8b),  |
+    ///                  |  amount of shape ids (4b), shape ids (4b each), amount of child nodes (4b)        |
+    ///                  |  and child nodes in the same format.                                              |
+    ///------------------------------------------------------------------------------------------------------|
+    const std::string IndexFileExtension = ".qix";
+    const char Signature[] = "SQT";
+    const std::size_t HeaderSize = 16;
+    const int MaxDefaultDepth = 12;
+    /// Part of node extent which is taken by each of two halves, so they overlap.
+    const double SplitRatio = 0.55;
+    /// Size of record header, shape type and bounds of non point shape in shp file.
+    const std::size_t RecordBoundsSize = 8 + 4 + 4 * 8;
+
+    bool isLittleEndian()
+    {
+        const std::uint16_t value = 1;
+        return *reinterpret_cast<const std::uint8_t*>(&value) == 1;
+    }
+
+    /// Gets path of index file for shape file path which may have extension.
+    std::string getIndexPath(const std::string& path)
+    {
+        std::string base = path;
+        if (base.size() > 4 && (base.compare(base.size() - 4, 4, ".shp") == 0 ||
+                                base.compare(base.size() - 4, 4, ".SHP") == 0))
+            base.resize(base.size() - 4);
+        return base + IndexFileExtension;
+    }
+
+    /// Reads values of index file checking its size.
+    class IndexReader final
+    {
+    public:
+        IndexReader(const std::vector<char>& data, bool needSwap) :
+            data_(data), position_(HeaderSize), needSwap_(needSwap)
+        {
+        }
+
+        template <typename T>
+        bool read(T& value)
+        {
+            if (position_ + sizeof(T) > data_.size())
+                return false;
+            char bytes[sizeof(T)];
+            std::memcpy(bytes, &data_[position_], sizeof(T));
+            if (needSwap_)
+                std::reverse(bytes, bytes + sizeof(T));
+            std::memcpy(&value, bytes, sizeof(T));
+            position_ += sizeof(T);
+            return true;
+        }
+
+    private:
+        const std::vector<char>& data_;
+        std::size_t position_;
+        const bool needSwap_;
+    };
+
+    template <typename T>
+    void writeValue(std::ostream& stream, const T& value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    /// Bounds of shape or node as min x, min y, max x and max y.
+    struct Bounds final
+    {
+        double minX, minY, maxX, maxY;
+
+        bool contains(const Bounds& other) const
+        {
+            return minX <= other.minX && minY <= other.minY && maxX >= other.maxX && maxY >= other.maxY;
+        }
+    };
+
+    /// Splits bounds into two overlapping halves along the longer side.
+    void split(const Bounds& bounds, Bounds& first, Bounds& second)
+    {
+        first = second = bounds;
+        if (bounds.maxX - bounds.minX > bounds.maxY - bounds.minY) {
+            double range = bounds.maxX - bounds.minX;
+            first.maxX = bounds.minX + range * SplitRatio;
+            second.minX = bounds.maxX - range * SplitRatio;
+        } else {
+            double range = bounds.maxY - bounds.minY;
+            first.maxY = bounds.minY + range * SplitRatio;
+            second.minY = bounds.maxY - range * SplitRatio;
+        }
+    }
+}
+
+ShapeIndex::ShapeIndex(const std::string& path, SHPHandle shp, int recordCount) :
+    root_(), recordCount_(recordCount), maxDepth_(0), isRead_(false)
+{
+    isRead_ = read(path, recordCount);
+    if (isRead_)
+        return;
+
+    build(shp, recordCount);
+    // NOTE existing index is not replaced as it might be maintained by other tools.
+    std::ifstream existing(getIndexPath(path));
+    if (!existing.good())
+        write(path);
+}
+
+std::vector<int> ShapeIndex::find(const BoundingBox& bbox) const
+{
+    std::vector<int> ids;
+    std::vector<const Node*> nodes = { &root_ };
+    while (!nodes.empty()) {
+        const Node* node = nodes.back();
+        nodes.pop_back();
+        if (node->minX > bbox.maxPoint.longitude || node->maxX < bbox.minPoint.longitude ||
+            node->minY > bbox.maxPoint.latitude || node->maxY < bbox.minPoint.latitude)
+            continue;
+
+        ids.insert(ids.end(), node->ids.begin(), node->ids.end());
+        for (const auto& child : node->children)
+            nodes.push_back(&child);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+bool ShapeIndex::read(const std::string& path, int recordCount)
+{
+    std::ifstream file(getIndexPath(path), std::ios::in | std::ios::binary);
+    if (!file.good())
+        return false;
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < HeaderSize || std::memcmp(data.data(), Signature, 3) != 0)
+        return false;
+
+    bool needSwap = (data[3] == 1) != isLittleEndian();
+    IndexReader reader(data, needSwap);
+    std::int32_t shapeCount, maxDepth;
+    std::memcpy(&shapeCount, &data[8], sizeof(shapeCount));
+    std::memcpy(&maxDepth, &data[12], sizeof(maxDepth));
+    if (needSwap) {
+        std::reverse(reinterpret_cast<char*>(&shapeCount), reinterpret_cast<char*>(&shapeCount) + 4);
+        std::reverse(reinterpret_cast<char*>(&maxDepth), reinterpret_cast<char*>(&maxDepth) + 4);
+    }
+    if (shapeCount != recordCount)
+        return false;
+
+    // NOTE index is used only if every record is referenced: stale index would drop records.
+    std::unordered_set<int> ids;
+    std::vector<Node*> nodes = { &root_ };
+    while (!nodes.empty()) {
+        Node& node = *nodes.back();
+        nodes.pop_back();
+
+        std::int32_t offset, idCount, childCount;
+        if (!reader.read(offset) || !reader.read(node.minX) || !reader.read(node.minY) ||
+            !reader.read(node.maxX) || !reader.read(node.maxY) || !reader.read(idCount) || idCount < 0)
+            return false;
+
+        node.ids.resize(static_cast<std::size_t>(idCount));
+        for (auto& id : node.ids) {
+            if (!reader.read(id) || id < 0 || id >= recordCount)
+                return false;
+            ids.insert(id);
+        }
+
+        if (!reader.read(childCount) || childCount < 0 || childCount > 4)
+            return false;
+        node.children.resize(static_cast<std::size_t>(childCount));
+        // NOTE children are read in file order.
+        for (auto child = node.children.rbegin(); child != node.children.rend(); ++child)
+            nodes.push_back(&*child);
+    }
+
+    maxDepth_ = maxDepth;
+    return ids.size() == static_cast<std::size_t>(recordCount);
+}
+
+void ShapeIndex::build(SHPHandle shp, int recordCount)
+{
+    // NOTE depth is chosen like shapelib does: about eight shapes per leaf.
+    maxDepth_ = 0;
+    for (int nodeCount = 1; nodeCount * 4 < recordCount; nodeCount *= 2)
+        ++maxDepth_;
+    maxDepth_ = std::min(maxDepth_, MaxDefaultDepth);
+
+    // NOTE only record header with bounds is read: geometry is skipped.
+    std::vector<Bounds> bounds(static_cast<std::size_t>(recordCount));
+    Bounds total = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+                     std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest() };
+    for (int k = 0; k < recordCount; ++k) {
+        unsigned char buffer[RecordBoundsSize] = {};
+        std::size_t size = std::min<std::size_t>(RecordBoundsSize, shp->panRecSize[k] + 8);
+        shp->sHooks.FSeek(shp->fpSHP, shp->panRecOffset[k], SEEK_SET);
+        if (size < 12 || shp->sHooks.FRead(buffer, size, 1, shp->fpSHP) != 1)
+            throw std::domain_error("Unable to read shape bounds.");
+
+        std::int32_t shapeType;
+        double values[4];
+        std::memcpy(&shapeType, buffer + 8, sizeof(shapeType));
+        std::memcpy(values, buffer + 12, size - 12);
+        Bounds& shapeBounds = bounds[static_cast<std::size_t>(k)];
+        if (shapeType == SHPT_POINT || shapeType == SHPT_POINTZ || shapeType == SHPT_POINTM)
+            shapeBounds = { values[0], values[1], values[0], values[1] };
+        else if (size == RecordBoundsSize)
+            shapeBounds = { values[0], values[1], values[2], values[3] };
+        else
+            shapeBounds = { 0, 0, 0, 0 };
+
+        total.minX = std::min(total.minX, shapeBounds.minX);
+        total.minY = std::min(total.minY, shapeBounds.minY);
+        total.maxX = std::max(total.maxX, shapeBounds.maxX);
+        total.maxY = std::max(total.maxY, shapeBounds.maxY);
+    }
+
+    root_ = Node { total.minX, total.minY, total.maxX, total.maxY, {}, {} };
+    for (int k = 0; k < recordCount; ++k) {
+        const Bounds& shapeBounds = bounds[static_cast<std::size_t>(k)];
+        Node* node = &root_;
+        // NOTE shape goes down while one of quadrants contains it.
+        for (int depth = 1; depth < maxDepth_; ++depth) {
+            Bounds nodeBounds = { node->minX, node->minY, node->maxX, node->maxY };
+            Bounds halves[2], quadrants[4];
+            split(nodeBounds, halves[0], halves[1]);
+            split(halves[0], quadrants[0], quadrants[1]);
+            split(halves[1], quadrants[2], quadrants[3]);
+
+            int quadrant = 0;
+            while (quadrant < 4 && !quadrants[quadrant].contains(shapeBounds))
+                ++quadrant;
+            if (quadrant == 4)
+                break;
+
+            if (node->children.empty()) {
+                for (const auto& q : quadrants)
+                    node->children.push_back(Node { q.minX, q.minY, q.maxX, q.maxY, {}, {} });
+            }
+            node = &node->children[static_cast<std::size_t>(quadrant)];
+        }
+        node->ids.push_back(k);
+    }
+    trim(root_);
+}
+
+bool ShapeIndex::write(const std::string& path) const
+{
+    std::ofstream file(getIndexPath(path), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.good())
+        return false;
+
+    file.write(Signature, 3);
+    file.put(isLittleEndian() ? 1 : 2);
+    file.put(1);
+    file.write("\0\0\0", 3);
+    writeValue(file, static_cast<std::int32_t>(recordCount_));
+    writeValue(file, static_cast<std::int32_t>(maxDepth_));
+    writeNode(file, root_);
+    return file.good();
+}
+
+void ShapeIndex::trim(Node& node)
+{
+    for (auto& child : node.children)
+        trim(child);
+    node.children.erase(std::remove_if(node.children.begin(), node.children.end(), [](const Node& child) {
+        return child.ids.empty() && child.children.empty();
+    }), node.children.end());
+}
+
+std::size_t ShapeIndex::getSize(const Node& node)
+{
+    std::size_t size = 4 + 4 * sizeof(double) + 4 + 4 * node.ids.size() + 4;
+    for (const auto& child : node.children)
+        size += getSize(child);
+    return size;
+}
+
+void ShapeIndex::writeNode(std::ostream& stream, const Node& node)
+{
+    std::size_t childrenSize = 0;
+    for (const auto& child : node.children)
+        childrenSize += getSize(child);
+
+    writeValue(stream, static_cast<std::int32_t>(childrenSize));
+    writeValue(stream, node.minX);
+    writeValue(stream, node.minY);
+    writeValue(stream, node.maxX);
+    writeValue(stream, node.maxY);
+    writeValue(stream, static_cast<std::int32_t>(node.ids.size()));
+    for (auto id : node.ids)
+        writeValue(stream, static_cast<std::int32_t>(id));
+    writeValue(stream, static_cast<std::int32_t>(node.children.size()));
+    for (const auto& child : node.children)
+        writeNode(stream, child);
+}
@@ -0,0 +1,56 @@
+#ifndef FORMATS_SHAPE_SHAPEINDEX_HPP_INCLUDED
+#define FORMATS_SHAPE_SHAPEINDEX_HPP_INCLUDED
+
+#include "BoundingBox.hpp"
+
+#include "shapefile/shapefil.h"
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace utymap { namespace formats {
+
+/// Spatial index of shape file records stored in quadtree (.qix) format of shapelib and mapserver.
+/// Index is read from file next to shape file or built from record bounds and written there.
+class ShapeIndex final
+{
+public:
+    /// Opens index of shape file with given path. Existing index which does not cover all records
+    /// is ignored. Built index is saved only if there is no index file.
+    ShapeIndex(const std::string& path, SHPHandle shp, int recordCount);
+
+    /// Returns ids of records in file order which may intersect given bounding box.
+    std::vector<int> find(const utymap::BoundingBox& bbox) const;
+
+    /// Returns true if index is read from file.
+    bool isRead() const { return isRead_; }
+
+private:
+    struct Node final
+    {
+        double minX, minY, maxX, maxY;
+        std::vector<int> ids;
+        std::vector<Node> children;
+    };
+
+    bool read(const std::string& path, int recordCount);
+    void build(SHPHandle shp, int recordCount);
+    bool write(const std::string& path) const;
+
+    /// Removes child nodes without shapes.
+    static void trim(Node& node);
+    /// Gets size of node with its children in index file.
+    static std::size_t getSize(const Node& node);
+    static void writeNode(std::ostream& stream, const Node& node);
+
+    Node root_;
+    int recordCount_;
+    int maxDepth_;
+    bool isRead_;
+};
+
+}}
+
+#endif  // FORMATS_SHAPE_SHAPEINDEX_HPP_INCLUDED
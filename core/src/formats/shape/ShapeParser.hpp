@@ -1,98 +1,410 @@
 #ifndef FORMATS_SHAPE_SHAPEPARSER_HPP_INCLUDED
 #define FORMATS_SHAPE_SHAPEPARSER_HPP_INCLUDED
 
+#include "BoundingBox.hpp"
 #include "GeoCoordinate.hpp"
 #include "entities/Element.hpp"
 #include "formats/FormatTypes.hpp"
+#include "formats/osm/OsmVisitorTraits.hpp"
+#include "formats/shape/ShapeIndex.hpp"
 #include "utils/CoreUtils.hpp"
 
 #include "shapefile/shapefil.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
 #include <string>
 #include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 namespace utymap { namespace formats {
 
+/// Parses shape files. Records can be read by chunks on worker threads, each of them uses
+/// own file handles. Visitor is always called on calling thread in record order except
+/// getStringIds which is called from worker threads if visitor supports string ids.
 template<typename Visitor>
 class ShapeParser final
 {
+    /// Tags are passed as string ids if visitor can map strings to ids.
+    using RecordTags = typename std::conditional<HasStringIds<Visitor>::value,
+                                                 std::vector<utymap::entities::Tag>,
+                                                 utymap::formats::Tags>::type;
+
+    /// Default amount of records read by worker at once.
+    static const int DefaultChunkSize = 1024;
+
+    /// Describes dbf field. Its key is converted once per file.
+    struct Field final
+    {
+        std::string name;
+        DBFFieldType type;
+        char nativeType;
+        int offset;
+        int size;
+        std::uint32_t keyId;
+    };
+
+    /// Owns handles of shp and dbf files.
+    struct ShapeFile final
+    {
+        SHPHandle shp;
+        DBFHandle dbf;
+
+        explicit ShapeFile(const std::string& path) :
+            shp(SHPOpen(path.c_str(), "rb")), dbf(nullptr)
+        {
+            if (shp == NULL)
+                throw std::domain_error("Cannot open shp file.");
+
+            dbf = DBFOpen(path.c_str(), "rb");
+            if (dbf == NULL) {
+                SHPClose(shp);
+                throw std::domain_error("Cannot open dbf file.");
+            }
+        }
+
+        ShapeFile(const ShapeFile&) = delete;
+        ShapeFile& operator=(const ShapeFile&) = delete;
+
+        ~ShapeFile()
+        {
+            DBFClose(dbf);
+            SHPClose(shp);
+        }
+    };
+
+    struct ShapeDeleter final
+    {
+        void operator()(SHPObject* shape) const { SHPDestroyObject(shape); }
+    };
+
+    struct Record final
+    {
+        std::unique_ptr<SHPObject, ShapeDeleter> shape;
+        RecordTags tags;
+    };
+
+    /// Buffers reused between records of one thread.
+    struct RecordBuffers final
+    {
+        std::vector<std::string> values;
+        std::vector<std::size_t> fields;
+        std::vector<const char*> strings;
+    };
+
 public:
 
+    ShapeParser() : workerCount_(0), chunkSize_(DefaultChunkSize), bbox_()
+    {
+    }
+
+    /// Restricts parsing to records which intersect bounding box. Candidates are found using
+    /// spatial index of file which is built and saved next to it on first use.
+    void setBoundingBox(const utymap::BoundingBox& bbox)
+    {
+        bbox_ = bbox;
+    }
+
+    /// Sets amount of threads which read records and amount of records read by thread at once.
+    /// Zero or one thread reads them on calling thread.
+    void setConcurrency(std::size_t workerCount, int chunkSize = DefaultChunkSize)
+    {
+        workerCount_ = workerCount;
+        chunkSize_ = std::max(chunkSize, 1);
+    }
+
     void parse(const std::string& path, Visitor& visitor) const
     {
-        SHPHandle shpFile = SHPOpen(path.c_str(), "rb");
-        if (shpFile == NULL)
-            throw std::domain_error("Cannot open shp file.");
+        ShapeFile file(path);
 
         int shapeType, entityCount;
         double adfMinBound[4], adfMaxBound[4];
-        SHPGetInfo(shpFile, &entityCount, &shapeType, adfMinBound, adfMaxBound);
+        SHPGetInfo(file.shp, &entityCount, &shapeType, adfMinBound, adfMaxBound);
 
-        DBFHandle dbfFile = DBFOpen(path.c_str(), "rb");
-        if (dbfFile == NULL)
-            throw std::domain_error("Cannot open dbf file.");
-
-        if (DBFGetFieldCount(dbfFile) == 0)
+        if (DBFGetFieldCount(file.dbf) == 0)
             throw std::domain_error("There are no fields in dbf table.");
 
-        if (entityCount != DBFGetRecordCount(dbfFile))
+        if (entityCount != DBFGetRecordCount(file.dbf))
             throw std::domain_error("dbf file has different entity count.");
 
-        for (int k = 0; k < entityCount; k++) {
-            SHPObject* shape = SHPReadObject(shpFile, k);
-            if (shape == NULL)
-                throw std::domain_error("Unable to read shape:" + utymap::utils::toString(k));
+        std::vector<Field> fields = readFields(file.dbf);
+        mapKeys(fields, visitor, std::integral_constant<bool, HasStringIds<Visitor>::value>());
 
-            Tags tags = parseTags(dbfFile, k);
-            visitShape(*shape, tags, visitor);
+        std::vector<int> records;
+        if (bbox_.isValid())
+            records = ShapeIndex(path, file.shp, entityCount).find(bbox_);
+        else {
+            records.resize(static_cast<std::size_t>(entityCount));
+            std::iota(records.begin(), records.end(), 0);
+        }
 
-            SHPDestroyObject(shape);
+        int recordCount = static_cast<int>(records.size());
+        std::size_t chunkCount = static_cast<std::size_t>((recordCount + chunkSize_ - 1) / chunkSize_);
+        if (workerCount_ > 1 && chunkCount > 1) {
+            parseConcurrently(path, chunkCount, records, fields, visitor);
+            return;
         }
 
-        DBFClose(dbfFile);
-        SHPClose(shpFile);
+        RecordBuffers buffers;
+        for (int k : records) {
+            Record record = readRecord(file, k, fields, visitor, buffers);
+            if (record.shape != nullptr)
+                visitShape(*record.shape, record.tags, visitor);
+        }
     }
 
 private:
 
-    Tags parseTags(DBFHandle dbfFile, int k) const
+    /// Reads chunks of records on worker threads and visits them in record order.
+    void parseConcurrently(const std::string& path, std::size_t chunkCount, const std::vector<int>& indices,
+                           const std::vector<Field>& fields, Visitor& visitor) const
     {
-        char title[12];
-        int fieldCount = DBFGetFieldCount(dbfFile);
-        Tags tags;
-        tags.reserve(fieldCount);
-        for (int i = 0; i < fieldCount; i++) {
-            if (DBFIsAttributeNULL(dbfFile, k, i))
-                continue;
+        // NOTE workers take only chunks within window after the chunk expected next, so
+        // amount of decoded records is limited and the chunk expected next is always taken.
+        const std::size_t capacity = 2 * workerCount_;
+        std::mutex lock;
+        std::condition_variable changed;
+        std::map<std::size_t, std::vector<Record>> decoded;
+        std::size_t takenChunks = 0;
+        std::size_t nextIndex = 0;
+        std::size_t activeWorkers = workerCount_;
+        bool isCancelled = false;
+        std::exception_ptr exception;
 
-            utymap::formats::Tag tag;
-            int width, decimals;
-            DBFFieldType eType = DBFGetFieldInfo(dbfFile, i, title, &width, &decimals);
-            tag.key = std::string(title);
-            {
-                switch (eType)
+        auto fail = [&]() {
+            std::lock_guard<std::mutex> guard(lock);
+            if (!exception)
+                exception = std::current_exception();
+            isCancelled = true;
+            changed.notify_all();
+        };
+
+        // NOTE shapelib writes static state on open, so handles are opened here one at a time.
+        std::vector<std::unique_ptr<ShapeFile>> files;
+        files.reserve(workerCount_);
+        for (std::size_t i = 0; i < workerCount_; ++i)
+            files.push_back(std::unique_ptr<ShapeFile>(new ShapeFile(path)));
+
+        auto worker = [&](ShapeFile& file) {
+            try {
+                RecordBuffers buffers;
+                for (;;) {
+                    std::size_t chunk;
+                    {
+                        std::unique_lock<std::mutex> guard(lock);
+                        changed.wait(guard, [&]() {
+                            return isCancelled || takenChunks == chunkCount || takenChunks < nextIndex + capacity;
+                        });
+                        if (isCancelled || takenChunks == chunkCount)
+                            break;
+                        chunk = takenChunks++;
+                    }
+
+                    int begin = static_cast<int>(chunk) * chunkSize_;
+                    int end = std::min(begin + chunkSize_, static_cast<int>(indices.size()));
+                    std::vector<Record> records;
+                    records.reserve(static_cast<std::size_t>(end - begin));
+                    for (int i = begin; i < end; ++i) {
+                        Record record = readRecord(file, indices[i], fields, visitor, buffers);
+                        if (record.shape != nullptr)
+                            records.push_back(std::move(record));
+                    }
+
+                    std::lock_guard<std::mutex> guard(lock);
+                    decoded.emplace(chunk, std::move(records));
+                    changed.notify_all();
+                }
+            }
+            catch (...) { fail(); }
+
+            std::lock_guard<std::mutex> guard(lock);
+            --activeWorkers;
+            changed.notify_all();
+        };
+
+        std::vector<std::future<void>> workers;
+        for (std::size_t i = 0; i < workerCount_; ++i)
+            workers.push_back(std::async(std::launch::async, worker, std::ref(*files[i])));
+
+        try {
+            while (nextIndex < chunkCount) {
+                std::vector<Record> records;
                 {
-                    case FTString:
-                        tag.value = DBFReadStringAttribute(dbfFile, k, i);
-                        break;
-                    case FTInteger:
-                        tag.value = utymap::utils::toString(DBFReadIntegerAttribute(dbfFile, k, i));
-                        break;
-                    case FTDouble:
-                        tag.value = utymap::utils::toString(DBFReadDoubleAttribute(dbfFile, k, i));
-                        break;
-                    default:
+                    std::unique_lock<std::mutex> guard(lock);
+                    auto isReady = [&]() { return !decoded.empty() && decoded.begin()->first == nextIndex; };
+                    changed.wait(guard, [&]() { return isCancelled || isReady() || activeWorkers == 0; });
+                    if (isCancelled || !isReady())
                         break;
+
+                    records = std::move(decoded.begin()->second);
+                    decoded.erase(decoded.begin());
+                    ++nextIndex;
+                    changed.notify_all();
                 }
+                for (auto& record : records)
+                    visitShape(*record.shape, record.tags, visitor);
             }
+        }
+        catch (...) { fail(); }
+
+        for (auto& result : workers)
+            result.get();
+
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+
+    static std::vector<Field> readFields(DBFHandle dbfFile)
+    {
+        char title[12];
+        int fieldCount = DBFGetFieldCount(dbfFile);
+        std::vector<Field> fields;
+        fields.reserve(fieldCount);
+        for (int i = 0; i < fieldCount; i++) {
+            int width, decimals;
+            DBFFieldType type = DBFGetFieldInfo(dbfFile, i, title, &width, &decimals);
+            fields.push_back(Field { std::string(title), type, DBFGetNativeFieldType(dbfFile, i),
+                                     dbfFile->panFieldOffset[i], dbfFile->panFieldSize[i], 0 });
+        }
+        return fields;
+    }
+
+    static void mapKeys(std::vector<Field>& fields, Visitor& visitor, std::true_type)
+    {
+        std::vector<const char*> names;
+        names.reserve(fields.size());
+        for (const auto& field : fields)
+            names.push_back(field.name.c_str());
+
+        std::vector<std::uint32_t> ids = visitor.getStringIds(names);
+        for (std::size_t i = 0; i < fields.size(); ++i)
+            fields[i].keyId = ids[i];
+    }
+
+    static void mapKeys(std::vector<Field>&, Visitor&, std::false_type)
+    {
+    }
+
+    Record readRecord(const ShapeFile& file, int k, const std::vector<Field>& fields,
+                      Visitor& visitor, RecordBuffers& buffers) const
+    {
+        Record record;
+        record.shape.reset(SHPReadObject(file.shp, k));
+        if (record.shape == nullptr)
+            throw std::domain_error("Unable to read shape:" + utymap::utils::toString(k));
+
+        // NOTE index returns candidates: records outside of bounding box are dropped before tags are read.
+        if (bbox_.isValid() && !intersects(*record.shape)) {
+            record.shape.reset();
+            return record;
+        }
+
+        // NOTE all field values are taken from raw record which is read once.
+        const char* tuple = DBFReadTuple(file.dbf, k);
+        if (tuple == nullptr)
+            throw std::domain_error("Unable to read dbf record:" + utymap::utils::toString(k));
+
+        buffers.values.resize(fields.size());
+        buffers.fields.clear();
+        for (std::size_t i = 0; i < fields.size(); ++i) {
+            if (readValue(tuple, fields[i], buffers.values[i]))
+                buffers.fields.push_back(i);
+        }
+
+        createTags(fields, buffers, visitor, record.tags);
+        return record;
+    }
+
+    /// Reads value of field from raw record. Returns false if value is null.
+    static bool readValue(const char* tuple, const Field& field, std::string& value)
+    {
+        const char* begin = tuple + field.offset;
+        const char* end = std::find(begin, begin + field.size, '\0');
+        // NOTE shapelib trims string values as TRIM_DBF_WHITESPACE is defined.
+        while (begin < end && *begin == ' ')
+            ++begin;
+        while (end > begin && *(end - 1) == ' ')
+            --end;
+
+        std::size_t length = static_cast<std::size_t>(end - begin);
+        switch (field.nativeType) {
+            case 'N':
+            case 'F':
+                if (length == 0 || *begin == '*')
+                    return false;
+                break;
+            case 'D':
+                if (length >= 8 && std::strncmp(begin, "00000000", 8) == 0)
+                    return false;
+                break;
+            case 'L':
+                if (length > 0 && *begin == '?')
+                    return false;
+                break;
+            default:
+                if (length == 0)
+                    return false;
+                break;
+        }
+
+        value.assign(begin, end);
+        switch (field.type) {
+            case FTString:
+                break;
+            case FTInteger:
+                value = utymap::utils::toString(static_cast<int>(std::atof(value.c_str())));
+                break;
+            case FTDouble:
+                value = utymap::utils::toString(std::atof(value.c_str()));
+                break;
+            default:
+                value.clear();
+                break;
+        }
+        return true;
+    }
+
+    static void createTags(const std::vector<Field>& fields, const RecordBuffers& buffers,
+                           Visitor&, utymap::formats::Tags& tags)
+    {
+        tags.reserve(buffers.fields.size());
+        for (auto index : buffers.fields) {
+            utymap::formats::Tag tag;
+            tag.key = fields[index].name;
+            tag.value = buffers.values[index];
             tags.push_back(tag);
         }
-        return std::move(tags);
     }
 
-    void visitShape(const SHPObject& shape, Tags& tags, Visitor& visitor) const
+    static void createTags(const std::vector<Field>& fields, RecordBuffers& buffers,
+                           Visitor& visitor, std::vector<utymap::entities::Tag>& tags)
+    {
+        buffers.strings.clear();
+        for (auto index : buffers.fields)
+            buffers.strings.push_back(buffers.values[index].c_str());
+        std::vector<std::uint32_t> ids = visitor.getStringIds(buffers.strings);
+
+        tags.reserve(ids.size());
+        for (std::size_t i = 0; i < ids.size(); ++i)
+            tags.push_back(utymap::entities::Tag(fields[buffers.fields[i]].keyId, ids[i]));
+
+        // NOTE: tags should be sorted to speed up mapcss styling
+        std::sort(tags.begin(), tags.end());
+    }
+
+    void visitShape(const SHPObject& shape, RecordTags& tags, Visitor& visitor) const
     {
         switch (shape.nSHPType)
         {
@@ -123,13 +435,19 @@ private:
         }
     }
 
-    void visitPoint(const SHPObject& shape, Tags& tags, Visitor& visitor) const
+    bool intersects(const SHPObject& shape) const
+    {
+        return shape.dfXMin <= bbox_.maxPoint.longitude && shape.dfXMax >= bbox_.minPoint.longitude &&
+               shape.dfYMin <= bbox_.maxPoint.latitude && shape.dfYMax >= bbox_.minPoint.latitude;
+    }
+
+    void visitPoint(const SHPObject& shape, RecordTags& tags, Visitor& visitor) const
     {
         utymap::GeoCoordinate coordinate(shape.padfY[0], shape.padfX[0]);
         visitor.visitNode(coordinate, tags);
     }
 
-    void visitArc(const SHPObject& shape, Tags& tags, Visitor& visitor) const
+    void visitArc(const SHPObject& shape, RecordTags& tags, Visitor& visitor) const
     {
         if (shape.nParts > 1) {
             std::cerr << "Arc type has more than one part.";
@@ -145,7 +463,7 @@ private:
         visitor.visitWay(coordinates, tags,coordinates[0] == coordinates[coordinates.size() - 1]);
     }
 
-    void visitPolygon(const SHPObject& shape, Tags& tags, Visitor& visitor) const
+    void visitPolygon(const SHPObject& shape, RecordTags& tags, Visitor& visitor) const
     {
         PolygonMembers members;
         members.reserve(shape.nParts);
@@ -168,6 +486,10 @@ private:
         }
         visitor.visitRelation(members, tags);
     }
+
+    std::size_t workerCount_;
+    int chunkSize_;
+    utymap::BoundingBox bbox_;
 };
 
 }}
@@ -4,6 +4,8 @@
 #include "BoundingBox.hpp"
 #include "GeoCoordinate.hpp"
 
+#include <cstddef>
+
 namespace utymap { namespace heightmap {
 
 /// Provides the way to get elevation for given location.
@@ -19,6 +21,13 @@ public:
     /// Gets elevation for given geocoordinate.
     virtual double getElevation(double latitude, double longitude) const = 0;
 
+    /// Gets elevations for given amount of points stored as interleaved longitude and latitude values.
+    virtual void getElevations(const double* points, std::size_t count, double* elevations) const
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            elevations[i] = getElevation(points[i * 2 + 1], points[i * 2]);
+    }
+
     virtual ~ElevationProvider() = default;
 };
 
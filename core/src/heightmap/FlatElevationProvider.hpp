@@ -3,6 +3,8 @@
 
 #include "heightmap/ElevationProvider.hpp"
 
+#include <algorithm>
+
 namespace utymap { namespace heightmap {
 
 /// Simple implementation of ElevationProvider which returns zero for all places.
@@ -15,6 +17,11 @@ public:
     double getElevation(const utymap::GeoCoordinate&) const override { return 0; }
 
     double getElevation(double, double) const override { return 0; };
+
+    void getElevations(const double*, std::size_t count, double* elevations) const override
+    {
+        std::fill(elevations, elevations + count, 0);
+    }
 };
 
 }}
@@ -0,0 +1,104 @@
+#ifndef HEIGHTMAP_GRIDELEVATIONPROVIDER_HPP_DEFINED
+#define HEIGHTMAP_GRIDELEVATIONPROVIDER_HPP_DEFINED
+
+#include "heightmap/ElevationProvider.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace utymap { namespace heightmap {
+
+/// Caches elevation of bounding box as regular grid sampled once from another provider.
+/// Points inside bounding box are bilinearly interpolated from grid, others are delegated
+/// to source provider.
+class GridElevationProvider final : public ElevationProvider
+{
+    /// Approximate distance between grid points in meters: matches SRTM-1 resolution.
+    const double GridSpacing = 30;
+    const int MinCells = 16;
+    const int MaxCells = 256;
+    const double EquatorLength = 40075016.686;
+
+public:
+    /// Samples grid for bounding box of quadkey with given level of detail.
+    GridElevationProvider(const ElevationProvider& source, const utymap::BoundingBox& bbox, int levelOfDetail) :
+        source_(source), bbox_(bbox)
+    {
+        double tileSize = EquatorLength / std::pow(2, levelOfDetail);
+        int cells = std::max(MinCells, std::min(MaxCells, static_cast<int>(tileSize / GridSpacing)));
+        resolution_ = cells + 1;
+        build();
+    }
+
+    void preload(const utymap::BoundingBox&) override {}
+
+    double getElevation(const utymap::GeoCoordinate& coordinate) const override
+    {
+        return getElevationImpl(coordinate.latitude, coordinate.longitude);
+    }
+
+    double getElevation(double latitude, double longitude) const override
+    {
+        return getElevationImpl(latitude, longitude);
+    }
+
+    void getElevations(const double* points, std::size_t count, double* elevations) const override
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            elevations[i] = getElevationImpl(points[i * 2 + 1], points[i * 2]);
+    }
+
+    /// Returns amount of grid points along one side.
+    int getResolution() const { return resolution_; }
+
+private:
+
+    void build()
+    {
+        std::size_t count = static_cast<std::size_t>(resolution_) * resolution_;
+        std::vector<double> points;
+        points.reserve(count * 2);
+        for (int y = 0; y < resolution_; ++y) {
+            double latitude = bbox_.minPoint.latitude + latStep() * y;
+            for (int x = 0; x < resolution_; ++x) {
+                points.push_back(bbox_.minPoint.longitude + lonStep() * x);
+                points.push_back(latitude);
+            }
+        }
+
+        heights_.resize(count);
+        source_.getElevations(points.data(), count, heights_.data());
+    }
+
+    double getElevationImpl(double latitude, double longitude) const
+    {
+        if (!bbox_.contains(utymap::GeoCoordinate(latitude, longitude)))
+            return source_.getElevation(latitude, longitude);
+
+        int last = resolution_ - 1;
+        double fx = (longitude - bbox_.minPoint.longitude) / lonStep();
+        double fy = (latitude - bbox_.minPoint.latitude) / latStep();
+        int x = std::max(0, std::min(static_cast<int>(fx), last - 1));
+        int y = std::max(0, std::min(static_cast<int>(fy), last - 1));
+        double dx = fx - x;
+        double dy = fy - y;
+
+        const double* row = heights_.data() + y * resolution_ + x;
+        return row[0] * (1 - dx) * (1 - dy) + row[1] * dx * (1 - dy) +
+               row[resolution_] * (1 - dx) * dy + row[resolution_ + 1] * dx * dy;
+    }
+
+    double latStep() const { return (bbox_.maxPoint.latitude - bbox_.minPoint.latitude) / (resolution_ - 1); }
+
+    double lonStep() const { return (bbox_.maxPoint.longitude - bbox_.minPoint.longitude) / (resolution_ - 1); }
+
+    const ElevationProvider& source_;
+    const utymap::BoundingBox bbox_;
+    int resolution_;
+    std::vector<double> heights_;
+};
+
+}}
+
+#endif // HEIGHTMAP_GRIDELEVATIONPROVIDER_HPP_DEFINED
@@ -0,0 +1,347 @@
+#include "heightmap/PyramidElevationProvider.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::heightmap;
+using namespace utymap::utils;
+
+namespace {
+    ///                                      Tile file format
+    ///------------------------------------------------------------------------------------------------------|
+    ///   DESCRIPTION    |                       DETAILS                                                     |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Header       |  Magic (4b), resolution (4b) and size of uncompressed heights (4b)                |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Heights      |  zlib compressed grid of resolution x resolution heights starting from south     |
+    ///                  |  west corner of quadkey, row by row                                              |
+    ///------------------------------------------------------------------------------------------------------|
+    /// Heights are quantized to decimeters and stored as 16 bit deltas from the previous height in row
+    /// or, for the first height of row, from the first height of previous row. Delta which does not fit
+    /// is stored as escape value followed by quantized height (4b).
+    const std::string TileFileExtension = ".ele";
+    const std::uint32_t TileMagic = 0x50454C55;
+    const std::size_t HeaderSize = 3 * sizeof(std::uint32_t);
+
+    const double HeightPrecision = 10;
+    const std::int16_t EscapeDelta = -32768;
+
+    /// Decoded heightmap tile.
+    struct Tile final
+    {
+        BoundingBox bbox;
+        int resolution;
+        std::vector<float> heights;
+
+        /// Returns bilinearly interpolated height for given point.
+        double sample(double latitude, double longitude) const
+        {
+            int last = resolution - 1;
+            double fx = (longitude - bbox.minPoint.longitude) / (bbox.maxPoint.longitude - bbox.minPoint.longitude) * last;
+            double fy = (latitude - bbox.minPoint.latitude) / (bbox.maxPoint.latitude - bbox.minPoint.latitude) * last;
+            fx = std::max(0., std::min(fx, static_cast<double>(last)));
+            fy = std::max(0., std::min(fy, static_cast<double>(last)));
+
+            int x = std::min(static_cast<int>(fx), last - 1);
+            int y = std::min(static_cast<int>(fy), last - 1);
+            double dx = fx - x;
+            double dy = fy - y;
+
+            const float* row = heights.data() + y * resolution + x;
+            return row[0] * (1 - dx) * (1 - dy) + row[1] * dx * (1 - dy) +
+                   row[resolution] * (1 - dx) * dy + row[resolution + 1] * dx * dy;
+        }
+    };
+
+    typedef std::shared_ptr<const Tile> TilePtr;
+
+    std::string getTilePath(const std::string& directory, const QuadKey& quadKey)
+    {
+        return directory + GeoUtils::quadKeyToString(quadKey) + TileFileExtension;
+    }
+
+    template<typename T>
+    void append(std::string& output, T value)
+    {
+        output.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    T read(const char* data, std::size_t size, std::size_t& position)
+    {
+        if (position + sizeof(T) > size)
+            throw std::domain_error("Unexpected end of elevation tile.");
+        T value;
+        std::memcpy(&value, data + position, sizeof(T));
+        position += sizeof(T);
+        return value;
+    }
+
+    /// Encodes quantized heights as deltas.
+    std::string encodeHeights(const std::vector<std::int32_t>& heights, int resolution)
+    {
+        std::string output;
+        output.reserve(heights.size() * sizeof(std::int16_t));
+        for (std::size_t i = 0; i < heights.size(); ++i) {
+            std::int32_t predicted = i % resolution != 0 ? heights[i - 1] : (i > 0 ? heights[i - resolution] : 0);
+            std::int64_t delta = static_cast<std::int64_t>(heights[i]) - predicted;
+            if (delta > EscapeDelta && delta <= 32767)
+                append(output, static_cast<std::int16_t>(delta));
+            else {
+                append(output, EscapeDelta);
+                append(output, heights[i]);
+            }
+        }
+        return output;
+    }
+
+    /// Decodes heights encoded by encodeHeights.
+    std::vector<float> decodeHeights(const std::string& data, int resolution)
+    {
+        std::size_t count = static_cast<std::size_t>(resolution) * resolution;
+        std::vector<std::int32_t> quantized(count);
+        std::size_t position = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            auto delta = read<std::int16_t>(data.data(), data.size(), position);
+            if (delta == EscapeDelta)
+                quantized[i] = read<std::int32_t>(data.data(), data.size(), position);
+            else {
+                std::int32_t predicted = i % resolution != 0 ? quantized[i - 1] : (i > 0 ? quantized[i - resolution] : 0);
+                quantized[i] = predicted + delta;
+            }
+        }
+
+        std::vector<float> heights(count);
+        for (std::size_t i = 0; i < count; ++i)
+            heights[i] = static_cast<float>(quantized[i] / HeightPrecision);
+        return heights;
+    }
+
+    /// Reads tile from memory mapped file. Returns null if there is no file.
+    TilePtr readTile(const std::string& directory, const QuadKey& quadKey)
+    {
+        std::string path = getTilePath(directory, quadKey);
+        // NOTE mapping of empty or non existing file is not possible.
+        std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!file.good() || file.tellg() <= 0)
+            return nullptr;
+        file.close();
+
+        using namespace boost::interprocess;
+        file_mapping mapping(path.c_str(), read_only);
+        mapped_region region(mapping, read_only);
+        const char* data = static_cast<const char*>(region.get_address());
+        std::size_t size = region.get_size();
+
+        std::size_t position = 0;
+        if (read<std::uint32_t>(data, size, position) != TileMagic)
+            throw std::domain_error(std::string("Cannot load elevation tile:") + path);
+        auto resolution = read<std::uint32_t>(data, size, position);
+        auto rawSize = read<std::uint32_t>(data, size, position);
+        if (resolution < 2 || resolution > 4097)
+            throw std::domain_error(std::string("Cannot load elevation tile:") + path);
+
+        std::string raw(rawSize, '\0');
+        uLongf destSize = rawSize;
+        if (uncompress(reinterpret_cast<Bytef*>(&raw[0]), &destSize,
+                       reinterpret_cast<const Bytef*>(data + HeaderSize), static_cast<uLong>(size - HeaderSize)) != Z_OK ||
+            destSize != rawSize)
+            throw std::domain_error(std::string("Cannot load elevation tile:") + path);
+
+        auto tile = std::make_shared<Tile>();
+        tile->bbox = GeoUtils::quadKeyToBoundingBox(quadKey);
+        tile->resolution = static_cast<int>(resolution);
+        tile->heights = decodeHeights(raw, tile->resolution);
+        return tile;
+    }
+}
+
+class PyramidElevationProvider::PyramidElevationProviderImpl final
+{
+    struct CacheEntry
+    {
+        /// Decoded tile or null if there is no such tile.
+        TilePtr tile;
+        /// Position in list of recently used tiles.
+        std::list<QuadKey>::iterator usage;
+    };
+
+public:
+    PyramidElevationProviderImpl(const std::string& directory, int levelOfDetail, int maxCacheSize) :
+        directory_(directory), levelOfDetail_(levelOfDetail),
+        maxCacheSize_(static_cast<std::size_t>(std::max(maxCacheSize, 1)))
+    {
+    }
+
+    void preload(const BoundingBox& bbox)
+    {
+        GeoUtils::visitTileRange(bbox, levelOfDetail_, [&](const QuadKey& quadKey, const BoundingBox&) {
+            findTile(quadKey);
+        });
+    }
+
+    double getElevation(double latitude, double longitude) const
+    {
+        QuadKey quadKey = GeoUtils::latLonToQuadKey(GeoCoordinate(latitude, longitude), levelOfDetail_);
+        TilePtr tile = findTile(quadKey);
+        return tile ? tile->sample(latitude, longitude) : 0;
+    }
+
+    void getElevations(const double* points, std::size_t count, double* elevations) const
+    {
+        TilePtr tile;
+        QuadKey lastQuadKey(-1, 0, 0);
+        for (std::size_t i = 0; i < count; ++i) {
+            double longitude = points[i * 2];
+            double latitude = points[i * 2 + 1];
+            QuadKey quadKey = GeoUtils::latLonToQuadKey(GeoCoordinate(latitude, longitude), levelOfDetail_);
+            if (!(quadKey == lastQuadKey)) {
+                tile = findTile(quadKey);
+                lastQuadKey = quadKey;
+            }
+            elevations[i] = tile ? tile->sample(latitude, longitude) : 0;
+        }
+    }
+
+private:
+    /// Returns tile for given quadkey or the nearest parent tile which exists.
+    TilePtr findTile(QuadKey quadKey) const
+    {
+        for (; quadKey.levelOfDetail >= GeoUtils::MinLevelOfDetails;
+             quadKey = QuadKey(quadKey.levelOfDetail - 1, quadKey.tileX / 2, quadKey.tileY / 2)) {
+            TilePtr tile = getTile(quadKey);
+            if (tile)
+                return tile;
+        }
+        return nullptr;
+    }
+
+    /// Returns cached tile or loads it unmapping least recently used tiles.
+    TilePtr getTile(const QuadKey& quadKey) const
+    {
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            auto entry = tiles_.find(quadKey);
+            if (entry != tiles_.end()) {
+                usage_.splice(usage_.begin(), usage_, entry->second.usage);
+                return entry->second.tile;
+            }
+        }
+
+        // NOTE tile is decoded outside of lock: it can be decoded twice by different threads.
+        TilePtr tile = readTile(directory_, quadKey);
+
+        std::lock_guard<std::mutex> lock(lock_);
+        auto entry = tiles_.find(quadKey);
+        if (entry != tiles_.end())
+            return entry->second.tile;
+
+        usage_.push_front(quadKey);
+        tiles_.emplace(quadKey, CacheEntry { tile, usage_.begin() });
+        while (tiles_.size() > maxCacheSize_) {
+            tiles_.erase(usage_.back());
+            usage_.pop_back();
+        }
+        return tile;
+    }
+
+    const std::string directory_;
+    const int levelOfDetail_;
+    const std::size_t maxCacheSize_;
+
+    mutable std::mutex lock_;
+    mutable std::unordered_map<QuadKey, CacheEntry, QuadKeyHash> tiles_;
+    /// Quadkeys of tiles from most to least recently used.
+    mutable std::list<QuadKey> usage_;
+};
+
+PyramidElevationProvider::PyramidElevationProvider(const std::string& directory, int levelOfDetail, int maxCacheSize) :
+    pimpl_(new PyramidElevationProviderImpl(directory, levelOfDetail, maxCacheSize))
+{
+}
+
+PyramidElevationProvider::~PyramidElevationProvider()
+{
+}
+
+void PyramidElevationProvider::preload(const BoundingBox& bbox)
+{
+    pimpl_->preload(bbox);
+}
+
+double PyramidElevationProvider::getElevation(const GeoCoordinate& coordinate) const
+{
+    return pimpl_->getElevation(coordinate.latitude, coordinate.longitude);
+}
+
+double PyramidElevationProvider::getElevation(double latitude, double longitude) const
+{
+    return pimpl_->getElevation(latitude, longitude);
+}
+
+void PyramidElevationProvider::getElevations(const double* points, std::size_t count, double* elevations) const
+{
+    pimpl_->getElevations(points, count, elevations);
+}
+
+void PyramidElevationProvider::buildTile(const ElevationProvider& source,
+                                         const QuadKey& quadKey,
+                                         const std::string& directory,
+                                         int resolution)
+{
+    if (resolution < 2)
+        throw std::invalid_argument("Elevation tile resolution should be at least 2.");
+
+    BoundingBox bbox = GeoUtils::quadKeyToBoundingBox(quadKey);
+    std::size_t count = static_cast<std::size_t>(resolution) * resolution;
+    std::vector<double> points;
+    points.reserve(count * 2);
+    for (int y = 0; y < resolution; ++y) {
+        double latitude = bbox.minPoint.latitude + (bbox.maxPoint.latitude - bbox.minPoint.latitude) * y / (resolution - 1);
+        for (int x = 0; x < resolution; ++x) {
+            points.push_back(bbox.minPoint.longitude + (bbox.maxPoint.longitude - bbox.minPoint.longitude) * x / (resolution - 1));
+            points.push_back(latitude);
+        }
+    }
+
+    std::vector<double> elevations(count);
+    source.getElevations(points.data(), count, elevations.data());
+
+    std::vector<std::int32_t> quantized(count);
+    for (std::size_t i = 0; i < count; ++i)
+        quantized[i] = static_cast<std::int32_t>(std::lround(elevations[i] * HeightPrecision));
+
+    std::string raw = encodeHeights(quantized, resolution);
+    uLongf compressedSize = compressBound(static_cast<uLong>(raw.size()));
+    std::string compressed(compressedSize, '\0');
+    if (compress(reinterpret_cast<Bytef*>(&compressed[0]), &compressedSize,
+                 reinterpret_cast<const Bytef*>(raw.data()), static_cast<uLong>(raw.size())) != Z_OK)
+        throw std::domain_error("Failed to compress elevation tile.");
+
+    std::string path = getTilePath(directory, quadKey);
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.good())
+        throw std::domain_error(std::string("Cannot write elevation tile:") + path);
+
+    std::string header;
+    append(header, TileMagic);
+    append(header, static_cast<std::uint32_t>(resolution));
+    append(header, static_cast<std::uint32_t>(raw.size()));
+    file.write(header.data(), header.size());
+    file.write(compressed.data(), compressedSize);
+}
@@ -0,0 +1,47 @@
+#ifndef HEIGHTMAP_PYRAMIDELEVATIONPROVIDER_HPP_DEFINED
+#define HEIGHTMAP_PYRAMIDELEVATIONPROVIDER_HPP_DEFINED
+
+#include "QuadKey.hpp"
+#include "heightmap/ElevationProvider.hpp"
+
+#include <memory>
+#include <string>
+
+namespace utymap { namespace heightmap {
+
+/// Provides elevation from precomputed pyramid of heightmap tiles aligned with quadkeys.
+/// Each tile is a compressed grid of heights sampled for specific level of detail, so low
+/// zoom levels get real relief without reading full resolution data. If tile is missing,
+/// tile of lower level of detail which covers the same area is used. Thread safe.
+class PyramidElevationProvider final : public ElevationProvider
+{
+public:
+    /// Creates provider which reads tiles of given level of detail from directory and keeps
+    /// at most maxCacheSize of them decoded.
+    PyramidElevationProvider(const std::string& directory, int levelOfDetail, int maxCacheSize = 16);
+
+    ~PyramidElevationProvider();
+
+    void preload(const utymap::BoundingBox& bbox) override;
+
+    double getElevation(const utymap::GeoCoordinate& coordinate) const override;
+
+    double getElevation(double latitude, double longitude) const override;
+
+    void getElevations(const double* points, std::size_t count, double* elevations) const override;
+
+    /// Builds tile of pyramid for given quadkey sampling resolution x resolution grid of
+    /// heights from source provider and writes it to directory.
+    static void buildTile(const ElevationProvider& source,
+                          const utymap::QuadKey& quadKey,
+                          const std::string& directory,
+                          int resolution = 65);
+
+private:
+    class PyramidElevationProviderImpl;
+    std::unique_ptr<PyramidElevationProviderImpl> pimpl_;
+};
+
+}}
+
+#endif // HEIGHTMAP_PYRAMIDELEVATIONPROVIDER_HPP_DEFINED
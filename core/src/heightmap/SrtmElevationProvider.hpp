@@ -2,13 +2,21 @@
 #define HEIGHTMAP_SRTMELEVATIONPROVIDER_HPP_DEFINED
 
 #include "heightmap/ElevationProvider.hpp"
+#include "utils/TraceRecorder.hpp"
 
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <future>
+#include <mutex>
 #include <cmath>
-#include <fstream>
 #include <sstream>
 #include <string>
 #include <stdexcept>
+#include <list>
 #include <map>
 #include <memory>
 #include <iomanip>
@@ -16,6 +24,9 @@
 namespace utymap { namespace heightmap {
 
 // Provides the way to get elevation for given location from SRTM data.
+// HGT files are memory mapped on first access and at most maxCacheSize of them are kept mapped:
+// least recently used cells are unmapped first. Thread safe: cell is loaded once even if it is
+// requested by several threads at the same time, readers keep unmapped cells alive while using them.
 class SrtmElevationProvider final : public ElevationProvider
 {
     struct HgtCellKey
@@ -34,29 +45,35 @@ class SrtmElevationProvider final : public ElevationProvider
     {
         int totalPx, secondsPerPx;
         int offset;
-        char* data;
+        boost::interprocess::mapped_region region;
+        const char* data;
         std::size_t size;
        
-        HgtCell(int totalPx, int secondsPerPx, char* data, std::size_t size) :
+        HgtCell(int totalPx, int secondsPerPx, boost::interprocess::mapped_region&& region) :
             totalPx(totalPx), secondsPerPx(secondsPerPx), 
-            offset((totalPx * totalPx - totalPx) * 2), data(data), size(size)
+            offset((totalPx * totalPx - totalPx) * 2), region(std::move(region)),
+            data(static_cast<const char*>(this->region.get_address())), size(this->region.get_size())
         {
         }
     };
 
     typedef std::shared_ptr<HgtCell> CellPtr;
 
+    struct CacheEntry
+    {
+        /// Cell which is ready or being loaded by another thread.
+        std::shared_future<CellPtr> cell;
+        /// Position in list of recently used cells.
+        std::list<HgtCellKey>::iterator usage;
+        /// Distinguishes entries of the same cell which are reloaded after unmapping.
+        std::uint64_t version;
+    };
+
 public:
 
     SrtmElevationProvider(std::string dataDirectory, int maxCacheSize = 4) :
-        dataDirectory_(dataDirectory), maxCacheSize_(maxCacheSize)
-    {
-    }
-
-    ~SrtmElevationProvider()
+        dataDirectory_(dataDirectory), maxCacheSize_(maxCacheSize), version_(0)
     {
-        for (const auto& pair : cells_)
-            delete pair.second->data;
     }
 
     void preload(const utymap::BoundingBox& bbox) override
@@ -70,18 +87,37 @@ public:
         int latDiff = maxLat - minLat;
         int lonDiff = maxLon - minLon;
 
+        // cells of given bounding box are kept even if there are more of them than cache size.
+        std::size_t requiredCells = static_cast<std::size_t>((latDiff + 1) * (lonDiff + 1));
         for (int j = 0; j <= latDiff; j++)
-            for (int i = 0; i <= lonDiff; i++) {
-                HgtCellKey cellKey(minLat + j, minLon + i);
+            for (int i = 0; i <= lonDiff; i++)
+                getCell(HgtCellKey(minLat + j, minLon + i), requiredCells);
+    }
 
-                if (cells_.find(cellKey) != cells_.end()) 
-                    continue;
+    /// Returns amount of mapped cells.
+    std::size_t getCellCount() const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        return cells_.size();
+    }
 
-                std::string path = getFilePath(cellKey);
-                CellPtr cell = readCell(path);
-                // TODO limit loaded cells.
-                cells_[cellKey] = cell;
+    /// Returns amount of bytes of mapped cells. Cells which are being loaded are not included.
+    std::size_t getMemoryUsage() const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        std::size_t usage = 0;
+        for (const auto& entry : cells_) {
+            const auto& cell = entry.second.cell;
+            if (cell.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                continue;
+            try {
+                usage += cell.get()->size;
+            }
+            catch (...) {
+                // NOTE failed cell is removed by its loader.
             }
+        }
+        return usage;
     }
 
     double getElevation(const utymap::GeoCoordinate& coordinate) const override 
@@ -94,6 +130,52 @@ public:
         return getElevationImpl(latitude, longitude);
     }
 
+    /// Processes points in blocks: cells are looked up only when point moves to another cell and
+    /// interpolation is done in separate pass over contiguous arrays, so compiler can vectorize it.
+    void getElevations(const double* points, std::size_t count, double* elevations) const override
+    {
+        const std::size_t BlockSize = 64;
+        double dx[BlockSize], dy[BlockSize];
+        int height0[BlockSize], height1[BlockSize], height2[BlockSize], height3[BlockSize];
+
+        CellPtr cell;
+        HgtCellKey cellKey(0, 0);
+
+        for (std::size_t start = 0; start < count; start += BlockSize) {
+            std::size_t size = std::min(BlockSize, count - start);
+            const double* block = points + start * 2;
+
+            // lookup pass: reads pixels of cell.
+            for (std::size_t i = 0; i < size; ++i) {
+                double longitude = block[i * 2];
+                double latitude = block[i * 2 + 1];
+                int latDec = static_cast<int>(latitude);
+                int lonDec = static_cast<int>(longitude);
+                if (cell == nullptr || cellKey.lat != latDec || cellKey.lon != lonDec) {
+                    cellKey = HgtCellKey(latDec, lonDec);
+                    cell = getCell(cellKey, 1);
+                }
+
+                double secondsLat = (latitude - latDec) * 3600;
+                double secondsLon = (longitude - lonDec) * 3600;
+                int y = static_cast<int>(secondsLat / cell->secondsPerPx);
+                int x = static_cast<int>(secondsLon / cell->secondsPerPx);
+
+                height2[i] = readPx(*cell, y, x);
+                height0[i] = readPx(*cell, y + 1, x);
+                height3[i] = readPx(*cell, y, x + 1);
+                height1[i] = readPx(*cell, y + 1, x + 1);
+                dy[i] = std::fmod(secondsLat, cell->secondsPerPx) / cell->secondsPerPx;
+                dx[i] = std::fmod(secondsLon, cell->secondsPerPx) / cell->secondsPerPx;
+            }
+
+            // interpolation pass.
+            double* result = elevations + start;
+            for (std::size_t i = 0; i < size; ++i)
+                result[i] = interpolate(height0[i], height1[i], height2[i], height3[i], dx[i], dy[i]);
+        }
+    }
+
 private:
 
     double getElevationImpl(double latitude, double longitude) const
@@ -104,7 +186,7 @@ private:
         double secondsLat = (latitude - latDec) * 3600;
         double secondsLon = (longitude - lonDec) * 3600;
 
-        auto cell = cells_.find(HgtCellKey(latDec, lonDec))->second;
+        CellPtr cell = getCell(HgtCellKey(latDec, lonDec), 1);
 
         // load tile
         //X coresponds to x/y values,
@@ -122,10 +204,10 @@ private:
         int x = static_cast<int>(secondsLon / cell->secondsPerPx);
 
         //get norther and easter points
-        int height2 = readPx(cell, y, x);
-        int height0 = readPx(cell, y + 1, x);
-        int height3 = readPx(cell, y, x + 1);
-        int height1 = readPx(cell, y + 1, x + 1);
+        int height2 = readPx(*cell, y, x);
+        int height0 = readPx(*cell, y + 1, x);
+        int height3 = readPx(*cell, y, x + 1);
+        int height1 = readPx(*cell, y + 1, x + 1);
 
         //ratio where X lays
         double dy = std::fmod(secondsLat, cell->secondsPerPx) / cell->secondsPerPx;
@@ -140,25 +222,85 @@ private:
         // |       |
         // h2------------h3   
 
+        return interpolate(height0, height1, height2, height3, dx, dy);
+    }
+
+    /// Returns cell loading it if necessary. Unmaps least recently used cells if there are more
+    /// than cache size of them, but keeps given amount of most recently used ones.
+    CellPtr getCell(const HgtCellKey& key, std::size_t pinnedCells) const
+    {
+        std::promise<CellPtr> promise;
+        std::shared_future<CellPtr> cell;
+        std::uint64_t version = 0;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            auto entry = cells_.find(key);
+            if (entry != cells_.end()) {
+                usage_.splice(usage_.begin(), usage_, entry->second.usage);
+                cell = entry->second.cell;
+            }
+            else {
+                version = ++version_;
+                usage_.push_front(key);
+                cells_.emplace(key, CacheEntry { promise.get_future().share(), usage_.begin(), version });
+
+                std::size_t maxSize = std::max(pinnedCells, static_cast<std::size_t>(maxCacheSize_));
+                while (maxCacheSize_ > 0 && cells_.size() > maxSize) {
+                    cells_.erase(usage_.back());
+                    usage_.pop_back();
+                }
+            }
+        }
+
+        if (cell.valid())
+            return cell.get();
+
+        // NOTE file is mapped outside of lock: other threads wait only for this cell.
+        try {
+            CellPtr loaded = readCell(getFilePath(key));
+            promise.set_value(loaded);
+            return loaded;
+        }
+        catch (...) {
+            promise.set_exception(std::current_exception());
+            std::lock_guard<std::mutex> lock(lock_);
+            auto entry = cells_.find(key);
+            if (entry != cells_.end() && entry->second.version == version) {
+                usage_.erase(entry->second.usage);
+                cells_.erase(entry);
+            }
+            throw;
+        }
+    }
+
+    static double interpolate(int height0, int height1, int height2, int height3, double dx, double dy)
+    {
         return height0*dy*(1 - dx) + height1*dy*(dx)+height2*(1 - dy)*(1 - dx) + height3*(1 - dy)*dx;
     }
 
-    static int readPx(CellPtr cell, int y, int x)
+    static int readPx(const HgtCell& cell, int y, int x)
     {
-        int pos = cell->offset + 2 * (x - cell->totalPx*y);
+        int pos = cell.offset + 2 * (x - cell.totalPx*y);
         // TODO ensure that it works on all platforms
-        return *((cell->data + pos)) << 8 |
-               *((cell->data + pos + 1));
+        return *((cell.data + pos)) << 8 |
+               *((cell.data + pos + 1));
     }
 
-   static CellPtr readCell(const std::string& path)
+    static CellPtr readCell(const std::string& path)
     {
-        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::app);
-        file.seekg(0, std::ios::end);
-        auto size = file.tellg();
+        UTYMAP_TRACE_SCOPE("srtm_read", "io");
+        using namespace boost::interprocess;
+        mapped_region region;
+        try {
+            file_mapping mapping(path.c_str(), read_only);
+            region = mapped_region(mapping, read_only);
+        }
+        catch (const interprocess_exception&) {
+            throw std::domain_error(std::string("Cannot load srtm file:") + path);
+        }
 
         int totalPx, secondsPerPx;
-        switch (size) {
+        switch (region.get_size()) {
             case 1201 * 1201 * 2: // SRTM-3
                 totalPx = 1201;
                 secondsPerPx = 3;
@@ -168,16 +310,10 @@ private:
                 secondsPerPx = 1;
                 break;
             default:
-                file.close();
                 throw std::domain_error(std::string("Cannot load srtm file:") + path);
         }
 
-        char* data = new char[size];
-        file.seekg(0, std::ios::beg);
-        file.read(data, size);
-        file.close();
-
-        return std::make_shared<HgtCell>(totalPx, secondsPerPx, data, size);
+        return std::make_shared<HgtCell>(totalPx, secondsPerPx, std::move(region));
     }
 
     std::string getFilePath(const HgtCellKey& key) const
@@ -193,7 +329,11 @@ private:
         return stream.str();
     }
 
-    std::map<HgtCellKey, CellPtr> cells_;
+    mutable std::mutex lock_;
+    mutable std::map<HgtCellKey, CacheEntry> cells_;
+    /// Keys of cells from most to least recently used.
+    mutable std::list<HgtCellKey> usage_;
+    mutable std::uint64_t version_;
     std::string dataDirectory_;
     int maxCacheSize_;
 };
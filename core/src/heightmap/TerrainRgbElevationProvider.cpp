@@ -0,0 +1,372 @@
+#include "heightmap/TerrainRgbElevationProvider.hpp"
+#include "QuadKey.hpp"
+#include "utils/GeoUtils.hpp"
+#include "utils/MathUtils.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::heightmap;
+using namespace utymap::utils;
+
+namespace {
+    const std::string TileFileExtension = ".png";
+    const char PngSignature[] = { '\x89', 'P', 'N', 'G', '\r', '\n', '\x1A', '\n' };
+
+    const double MinHeight = -10000;
+    const double HeightPrecision = 0.1;
+
+    /// Decoded terrain-RGB tile: heights are stored row by row starting from north west corner.
+    struct Tile final
+    {
+        int width, height;
+        std::vector<float> heights;
+
+        /// Returns height of pixel clamping its coordinates to tile.
+        double at(int x, int y) const
+        {
+            x = std::max(0, std::min(x, width - 1));
+            y = std::max(0, std::min(y, height - 1));
+            return heights[static_cast<std::size_t>(y) * width + x];
+        }
+
+        /// Checks whether point interpolated by sample uses pixels of this tile only.
+        bool isInner(double fx, double fy) const
+        {
+            fx = fx * width - 0.5;
+            fy = fy * height - 0.5;
+            return fx >= 0 && fy >= 0 && fx <= width - 1 && fy <= height - 1;
+        }
+
+        /// Returns bilinearly interpolated height for given pixel coordinates inside tile.
+        /// NOTE points between edge pixel centers and tile edge use edge pixels.
+        double sample(double fx, double fy) const
+        {
+            fx = std::max(0., std::min(fx * width - 0.5, width - 1.));
+            fy = std::max(0., std::min(fy * height - 0.5, height - 1.));
+
+            int x = std::min(static_cast<int>(fx), std::max(width - 2, 0));
+            int y = std::min(static_cast<int>(fy), std::max(height - 2, 0));
+            int nextX = std::min(x + 1, width - 1) - x;
+            int nextY = (std::min(y + 1, height - 1) - y) * width;
+            double dx = fx - x;
+            double dy = fy - y;
+
+            const float* row = heights.data() + y * width + x;
+            return row[0] * (1 - dx) * (1 - dy) + row[nextX] * dx * (1 - dy) +
+                   row[nextY] * (1 - dx) * dy + row[nextY + nextX] * dx * dy;
+        }
+    };
+
+    typedef std::shared_ptr<const Tile> TilePtr;
+
+    std::uint32_t readBigEndian(const std::string& data, std::size_t position)
+    {
+        if (position + 4 > data.size())
+            throw std::domain_error("Unexpected end of terrain tile.");
+        const auto* bytes = reinterpret_cast<const unsigned char*>(data.data() + position);
+        return static_cast<std::uint32_t>(bytes[0]) << 24 | static_cast<std::uint32_t>(bytes[1]) << 16 |
+               static_cast<std::uint32_t>(bytes[2]) << 8 | bytes[3];
+    }
+
+    int paeth(int left, int up, int upLeft)
+    {
+        int p = left + up - upLeft;
+        int pa = std::abs(p - left), pb = std::abs(p - up), pc = std::abs(p - upLeft);
+        return pa <= pb && pa <= pc ? left : (pb <= pc ? up : upLeft);
+    }
+
+    /// Reverses PNG filters of scanlines in place. Each scanline starts from filter type byte.
+    void unfilter(std::vector<unsigned char>& data, std::size_t stride, std::size_t rows, std::size_t bpp)
+    {
+        for (std::size_t y = 0; y < rows; ++y) {
+            unsigned char* line = data.data() + y * (stride + 1);
+            unsigned char* current = line + 1;
+            const unsigned char* previous = y > 0 ? line - stride : nullptr;
+            for (std::size_t i = 0; i < stride; ++i) {
+                int left = i >= bpp ? current[i - bpp] : 0;
+                int up = previous ? previous[i] : 0;
+                int upLeft = previous && i >= bpp ? previous[i - bpp] : 0;
+                switch (line[0]) {
+                    case 0: break;
+                    case 1: current[i] = static_cast<unsigned char>(current[i] + left); break;
+                    case 2: current[i] = static_cast<unsigned char>(current[i] + up); break;
+                    case 3: current[i] = static_cast<unsigned char>(current[i] + (left + up) / 2); break;
+                    case 4: current[i] = static_cast<unsigned char>(current[i] + paeth(left, up, upLeft)); break;
+                    default: throw std::domain_error("Unsupported png filter in terrain tile.");
+                }
+            }
+        }
+    }
+
+    /// Decodes 8 bit RGB or RGBA non interlaced PNG image into heights.
+    TilePtr decodeTile(const std::string& data)
+    {
+        if (data.size() < sizeof(PngSignature) || std::memcmp(data.data(), PngSignature, sizeof(PngSignature)) != 0)
+            throw std::domain_error("Terrain tile is not png image.");
+
+        int width = 0, height = 0;
+        std::size_t bpp = 0;
+        std::string compressed;
+        for (std::size_t position = sizeof(PngSignature); position < data.size();) {
+            std::uint32_t length = readBigEndian(data, position);
+            if (position + 12 + length > data.size())
+                throw std::domain_error("Unexpected end of terrain tile.");
+            std::string type = data.substr(position + 4, 4);
+            std::size_t start = position + 8;
+            position = start + length + 4;
+
+            if (type == "IHDR") {
+                width = static_cast<int>(readBigEndian(data, start));
+                height = static_cast<int>(readBigEndian(data, start + 4));
+                const char* header = data.data() + start + 8;
+                if (length < 13 || header[0] != 8 || (header[1] != 2 && header[1] != 6) || header[4] != 0 ||
+                    width <= 0 || height <= 0 || width > 8192 || height > 8192)
+                    throw std::domain_error("Unsupported terrain tile format.");
+                bpp = header[1] == 2 ? 3 : 4;
+            }
+            else if (type == "IDAT")
+                compressed.append(data, start, length);
+            else if (type == "IEND")
+                break;
+        }
+        if (bpp == 0 || compressed.empty())
+            throw std::domain_error("Terrain tile has no image data.");
+
+        std::size_t stride = width * bpp;
+        std::vector<unsigned char> raw((stride + 1) * height);
+        uLongf rawSize = static_cast<uLongf>(raw.size());
+        if (uncompress(raw.data(), &rawSize, reinterpret_cast<const Bytef*>(compressed.data()),
+                       static_cast<uLong>(compressed.size())) != Z_OK || rawSize != raw.size())
+            throw std::domain_error("Cannot decompress terrain tile.");
+        unfilter(raw, stride, static_cast<std::size_t>(height), bpp);
+
+        auto tile = std::make_shared<Tile>();
+        tile->width = width;
+        tile->height = height;
+        tile->heights.resize(static_cast<std::size_t>(width) * height);
+        for (int y = 0; y < height; ++y) {
+            const unsigned char* pixel = raw.data() + y * (stride + 1) + 1;
+            float* row = tile->heights.data() + y * width;
+            for (int x = 0; x < width; ++x, pixel += bpp)
+                row[x] = static_cast<float>(MinHeight + (pixel[0] * 65536 + pixel[1] * 256 + pixel[2]) * HeightPrecision);
+        }
+        return tile;
+    }
+
+    /// Reads tile from file. Returns null if there is no file.
+    TilePtr readTile(const std::string& directory, const QuadKey& quadKey)
+    {
+        std::string path = directory + std::to_string(quadKey.levelOfDetail) + "/" +
+                           std::to_string(quadKey.tileX) + "/" + std::to_string(quadKey.tileY) + TileFileExtension;
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        if (!file.good())
+            return nullptr;
+
+        std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        try {
+            return decodeTile(data);
+        }
+        catch (const std::domain_error& ex) {
+            throw std::domain_error(std::string(ex.what()) + " " + path);
+        }
+    }
+}
+
+class TerrainRgbElevationProvider::TerrainRgbElevationProviderImpl final
+{
+    struct CacheEntry
+    {
+        /// Decoded tile or null if there is no such tile.
+        TilePtr tile;
+        /// Position in list of recently used tiles.
+        std::list<QuadKey>::iterator usage;
+    };
+
+    /// Position of point in web mercator tiles of provider's zoom.
+    struct TilePoint
+    {
+        QuadKey quadKey;
+        double fx, fy;
+    };
+
+public:
+    TerrainRgbElevationProviderImpl(const std::string& directory, int zoom, int maxCacheSize) :
+        directory_(directory), zoom_(zoom),
+        maxCacheSize_(static_cast<std::size_t>(std::max(maxCacheSize, 1)))
+    {
+    }
+
+    void preload(const BoundingBox& bbox)
+    {
+        GeoUtils::visitTileRange(bbox, zoom_, [&](const QuadKey& quadKey, const BoundingBox&) {
+            getTile(quadKey);
+        });
+    }
+
+    double getElevation(double latitude, double longitude) const
+    {
+        TilePoint point = getTilePoint(latitude, longitude);
+        TilePtr tile = getTile(point.quadKey);
+        return tile ? sample(*tile, point) : 0;
+    }
+
+    void getElevations(const double* points, std::size_t count, double* elevations) const
+    {
+        TilePtr tile;
+        QuadKey lastQuadKey(-1, 0, 0);
+        for (std::size_t i = 0; i < count; ++i) {
+            TilePoint point = getTilePoint(points[i * 2 + 1], points[i * 2]);
+            if (!(point.quadKey == lastQuadKey)) {
+                tile = getTile(point.quadKey);
+                lastQuadKey = point.quadKey;
+            }
+            elevations[i] = tile ? sample(*tile, point) : 0;
+        }
+    }
+
+    std::size_t getTileCount() const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        return tiles_.size();
+    }
+
+private:
+    /// Projects point to tile and its relative position inside tile.
+    TilePoint getTilePoint(double latitude, double longitude) const
+    {
+        latitude = std::max(-85.05112877, std::min(latitude, 85.05112877));
+        longitude = std::max(-180., std::min(longitude, 180.));
+        double tiles = std::ldexp(1., zoom_);
+        double lat = latitude * pi / 180;
+        double x = (longitude + 180) / 360 * tiles;
+        double y = (1 - std::log(std::tan(lat) + 1 / std::cos(lat)) / pi) / 2 * tiles;
+
+        int tileX = std::min(static_cast<int>(x), static_cast<int>(tiles) - 1);
+        int tileY = std::min(static_cast<int>(y), static_cast<int>(tiles) - 1);
+        return TilePoint { QuadKey(zoom_, tileX, tileY), x - tileX, y - tileY };
+    }
+
+    /// Returns bilinearly interpolated height of point. Points between edge pixel centers and
+    /// tile edge are interpolated with pixels of neighbour tiles, so there are no seams.
+    double sample(const Tile& tile, const TilePoint& point) const
+    {
+        if (tile.isInner(point.fx, point.fy))
+            return tile.sample(point.fx, point.fy);
+
+        double fx = point.fx * tile.width - 0.5;
+        double fy = point.fy * tile.height - 0.5;
+        int x = static_cast<int>(std::floor(fx));
+        int y = static_cast<int>(std::floor(fy));
+        double dx = fx - x;
+        double dy = fy - y;
+        return getHeight(tile, point.quadKey, x, y) * (1 - dx) * (1 - dy) +
+               getHeight(tile, point.quadKey, x + 1, y) * dx * (1 - dy) +
+               getHeight(tile, point.quadKey, x, y + 1) * (1 - dx) * dy +
+               getHeight(tile, point.quadKey, x + 1, y + 1) * dx * dy;
+    }
+
+    /// Returns height of pixel which may be outside of given tile: then it is read from neighbour
+    /// tile. Longitude wraps around. Pixels of missing neighbours are clamped to given tile.
+    double getHeight(const Tile& tile, const QuadKey& quadKey, int x, int y) const
+    {
+        int offsetX = x < 0 ? -1 : (x >= tile.width ? 1 : 0);
+        int offsetY = y < 0 ? -1 : (y >= tile.height ? 1 : 0);
+        if (offsetX == 0 && offsetY == 0)
+            return tile.at(x, y);
+
+        int tiles = 1 << zoom_;
+        int tileY = quadKey.tileY + offsetY;
+        if (tileY >= 0 && tileY < tiles) {
+            TilePtr neighbour = getTile(QuadKey(zoom_, (quadKey.tileX + offsetX + tiles) % tiles, tileY));
+            if (neighbour && neighbour->width == tile.width && neighbour->height == tile.height)
+                return neighbour->at(x - offsetX * tile.width, y - offsetY * tile.height);
+        }
+        return tile.at(x, y);
+    }
+
+    /// Returns cached tile or decodes it evicting least recently used tiles.
+    TilePtr getTile(const QuadKey& quadKey) const
+    {
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            auto entry = tiles_.find(quadKey);
+            if (entry != tiles_.end()) {
+                usage_.splice(usage_.begin(), usage_, entry->second.usage);
+                return entry->second.tile;
+            }
+        }
+
+        // NOTE tile is decoded outside of lock: it can be decoded twice by different threads.
+        TilePtr tile = readTile(directory_, quadKey);
+
+        std::lock_guard<std::mutex> lock(lock_);
+        auto entry = tiles_.find(quadKey);
+        if (entry != tiles_.end())
+            return entry->second.tile;
+
+        usage_.push_front(quadKey);
+        tiles_.emplace(quadKey, CacheEntry { tile, usage_.begin() });
+        while (tiles_.size() > maxCacheSize_) {
+            tiles_.erase(usage_.back());
+            usage_.pop_back();
+        }
+        return tile;
+    }
+
+    const std::string directory_;
+    const int zoom_;
+    const std::size_t maxCacheSize_;
+
+    mutable std::mutex lock_;
+    mutable std::unordered_map<QuadKey, CacheEntry, QuadKeyHash> tiles_;
+    /// Quadkeys of tiles from most to least recently used.
+    mutable std::list<QuadKey> usage_;
+};
+
+TerrainRgbElevationProvider::TerrainRgbElevationProvider(const std::string& directory, int zoom, int maxCacheSize) :
+    pimpl_(new TerrainRgbElevationProviderImpl(directory, zoom, maxCacheSize))
+{
+}
+
+TerrainRgbElevationProvider::~TerrainRgbElevationProvider()
+{
+}
+
+void TerrainRgbElevationProvider::preload(const BoundingBox& bbox)
+{
+    pimpl_->preload(bbox);
+}
+
+double TerrainRgbElevationProvider::getElevation(const GeoCoordinate& coordinate) const
+{
+    return pimpl_->getElevation(coordinate.latitude, coordinate.longitude);
+}
+
+double TerrainRgbElevationProvider::getElevation(double latitude, double longitude) const
+{
+    return pimpl_->getElevation(latitude, longitude);
+}
+
+void TerrainRgbElevationProvider::getElevations(const double* points, std::size_t count, double* elevations) const
+{
+    pimpl_->getElevations(points, count, elevations);
+}
+
+std::size_t TerrainRgbElevationProvider::getTileCount() const
+{
+    return pimpl_->getTileCount();
+}
@@ -0,0 +1,45 @@
+#ifndef HEIGHTMAP_TERRAINRGBELEVATIONPROVIDER_HPP_DEFINED
+#define HEIGHTMAP_TERRAINRGBELEVATIONPROVIDER_HPP_DEFINED
+
+#include "heightmap/ElevationProvider.hpp"
+
+#include <memory>
+#include <string>
+
+namespace utymap { namespace heightmap {
+
+/// Provides elevation from terrain-RGB tiles: PNG images in web mercator tile scheme where
+/// height in decimeters offset by 10 km is packed into red, green and blue channels. Tiles
+/// are stored as "<zoom>/<x>/<y>.png" files of single zoom, so large elevation models are
+/// read by blocks: only tiles covering requested points are decoded. At most maxCacheSize
+/// decoded tiles are kept and shared by single point and batch requests. Points near tile
+/// edges are interpolated with pixels of neighbour tiles. Points of missing tiles have zero
+/// elevation. Thread safe.
+class TerrainRgbElevationProvider final : public ElevationProvider
+{
+public:
+    /// Creates provider which reads tiles of given zoom from directory.
+    TerrainRgbElevationProvider(const std::string& directory, int zoom, int maxCacheSize = 16);
+
+    ~TerrainRgbElevationProvider();
+
+    void preload(const utymap::BoundingBox& bbox) override;
+
+    double getElevation(const utymap::GeoCoordinate& coordinate) const override;
+
+    double getElevation(double latitude, double longitude) const override;
+
+    /// Looks up tile only when point moves to another tile.
+    void getElevations(const double* points, std::size_t count, double* elevations) const override;
+
+    /// Returns amount of decoded tiles.
+    std::size_t getTileCount() const;
+
+private:
+    class TerrainRgbElevationProviderImpl;
+    std::unique_ptr<TerrainRgbElevationProviderImpl> pimpl_;
+};
+
+}}
+
+#endif // HEIGHTMAP_TERRAINRGBELEVATIONPROVIDER_HPP_DEFINED
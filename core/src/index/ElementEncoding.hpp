@@ -0,0 +1,482 @@
+#ifndef INDEX_ELEMENTENCODING_HPP_DEFINED
+#define INDEX_ELEMENTENCODING_HPP_DEFINED
+
+#include "BoundingBox.hpp"
+#include "GeoCoordinate.hpp"
+#include "entities/BoundingBoxVisitor.hpp"
+#include "entities/Element.hpp"
+#include "entities/ElementDispatch.hpp"
+#include "entities/ElementVisitor.hpp"
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "hashing/MurmurHash3.h"
+#include "utils/VarintUtils.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Defines encoding of elements and their index entries shared by persistent element stores.
+/// See PersistentElementStore.cpp for description of formats.
+namespace utymap { namespace index {
+
+const std::uint8_t CompactFlag = 0x4;
+/// Marks relation which is written as flat list of area rings.
+const std::uint8_t RingsFlag = 0x8;
+const double CoordinatePrecision = 1E7;
+
+/// Converts coordinate component to fixed point representation.
+inline std::int64_t toFixed(double value)
+{
+    return static_cast<std::int64_t>(std::llround(value * CoordinatePrecision));
+}
+
+/// Represents entry of index file.
+struct IndexEntry final
+{
+    std::uint64_t id;
+    std::uint32_t offset;
+    std::uint32_t mask;
+    std::int32_t minLatitude;
+    std::int32_t minLongitude;
+    std::int32_t maxLatitude;
+    std::int32_t maxLongitude;
+};
+static_assert(sizeof(IndexEntry) == 32, "Unexpected index entry size.");
+
+const std::size_t LegacyIndexEntrySize = sizeof(std::uint64_t) + sizeof(std::uint32_t);
+const std::uint32_t TombstoneOffset = 0xFFFFFFFF;
+
+/// Creates entry which marks element as removed.
+inline IndexEntry createTombstone(std::uint64_t id)
+{
+    IndexEntry entry = {};
+    entry.id = id;
+    entry.offset = TombstoneOffset;
+    return entry;
+}
+
+/// Creates entry for legacy index record which matches any search criteria.
+inline IndexEntry createLegacyEntry(std::uint64_t id, std::uint32_t offset)
+{
+    IndexEntry entry;
+    entry.id = id;
+    entry.offset = offset;
+    entry.mask = 0xFFFFFFFF;
+    entry.minLatitude = std::numeric_limits<std::int32_t>::min();
+    entry.minLongitude = std::numeric_limits<std::int32_t>::min();
+    entry.maxLatitude = std::numeric_limits<std::int32_t>::max();
+    entry.maxLongitude = std::numeric_limits<std::int32_t>::max();
+    return entry;
+}
+
+/// Gets mask bit for builder name.
+inline std::uint32_t getBuilderMask(const std::string& name)
+{
+    std::uint32_t hash;
+    MurmurHash3_x86_32(name.c_str(), static_cast<int>(name.size()), 0, &hash);
+    return 1u << (4 + hash % 28);
+}
+
+/// Creates index entry for element stored at given offset.
+inline IndexEntry createIndexEntry(const utymap::entities::Element& element, std::uint32_t offset, std::uint8_t elementType, const std::string& builders)
+{
+    utymap::entities::BoundingBoxVisitor bboxVisitor;
+    utymap::entities::visit(element, bboxVisitor);
+    const BoundingBox& bbox = bboxVisitor.boundingBox;
+
+    IndexEntry entry;
+    entry.id = element.id;
+    entry.offset = offset;
+    entry.mask = 1u << elementType;
+    // NOTE bounding box is rounded outwards to not miss element on search.
+    entry.minLatitude = static_cast<std::int32_t>(std::floor(bbox.minPoint.latitude * CoordinatePrecision));
+    entry.minLongitude = static_cast<std::int32_t>(std::floor(bbox.minPoint.longitude * CoordinatePrecision));
+    entry.maxLatitude = static_cast<std::int32_t>(std::ceil(bbox.maxPoint.latitude * CoordinatePrecision));
+    entry.maxLongitude = static_cast<std::int32_t>(std::ceil(bbox.maxPoint.longitude * CoordinatePrecision));
+
+    std::stringstream ss(builders);
+    while (ss.good()) {
+        std::string name;
+        std::getline(ss, name, ',');
+        if (!name.empty())
+            entry.mask |= getBuilderMask(name);
+    }
+    return entry;
+}
+
+/// Checks whether index entry satisfies search criteria.
+inline bool matches(const IndexEntry& entry, const BoundingBox& bbox, std::uint32_t mask)
+{
+    return (entry.mask & mask) == mask &&
+        entry.minLatitude <= std::ceil(bbox.maxPoint.latitude * CoordinatePrecision) &&
+        entry.minLongitude <= std::ceil(bbox.maxPoint.longitude * CoordinatePrecision) &&
+        entry.maxLatitude >= std::floor(bbox.minPoint.latitude * CoordinatePrecision) &&
+        entry.maxLongitude >= std::floor(bbox.minPoint.longitude * CoordinatePrecision);
+}
+
+/// Writes element to in-memory buffer using compact encoding.
+class ElementWriter final : public utymap::entities::ElementVisitor
+{
+public:
+    ElementWriter(std::string& buffer, const GeoCoordinate& origin) :
+        buffer_(buffer), originLatitude_(toFixed(origin.latitude)), originLongitude_(toFixed(origin.longitude))
+    {
+    }
+
+    void visitNode(const utymap::entities::Node& node) override
+    {
+        writeFlags(0);
+        writeTags(node.tags);
+        writeCoordinates(&node.coordinate, &node.coordinate + 1);
+    }
+
+    void visitWay(const utymap::entities::Way& way) override
+    {
+        writeFlags(1);
+        writeTags(way.tags);
+        writeVarint(way.coordinates.size());
+        writeCoordinates(way.coordinates.data(), way.coordinates.data() + way.coordinates.size());
+    }
+
+    void visitArea(const utymap::entities::Area& area) override
+    {
+        writeFlags(2);
+        writeTags(area.tags);
+        writeVarint(area.coordinates.size());
+        writeCoordinates(area.coordinates.data(), area.coordinates.data() + area.coordinates.size());
+    }
+
+    void visitRelation(const utymap::entities::Relation& relation) override
+    {
+        // NOTE resolved multipolygon is written without nested element records.
+        RingCollector collector;
+        for (const auto& element : relation.elements)
+            utymap::entities::visit(*element, collector);
+        if (collector.isFlat && !collector.rings.empty()) {
+            writeRings(relation, collector.rings);
+            return;
+        }
+
+        writeFlags(3);
+        writeTags(relation.tags);
+        writeVarint(relation.elements.size());
+        for (const auto& element : relation.elements) {
+            writeVarint(element->id);
+            utymap::entities::visit(*element, *this);
+        }
+    }
+
+private:
+    /// Collects members of relation which consists of areas without tags.
+    struct RingCollector final : public utymap::entities::ElementVisitor
+    {
+        std::vector<const utymap::entities::Area*> rings;
+        bool isFlat = true;
+
+        void visitNode(const utymap::entities::Node&) override { isFlat = false; }
+        void visitWay(const utymap::entities::Way&) override { isFlat = false; }
+        void visitRelation(const utymap::entities::Relation&) override { isFlat = false; }
+
+        void visitArea(const utymap::entities::Area& area) override
+        {
+            if (area.tags.empty())
+                rings.push_back(&area);
+            else
+                isFlat = false;
+        }
+    };
+
+    void writeRings(const utymap::entities::Relation& relation, const std::vector<const utymap::entities::Area*>& rings)
+    {
+        buffer_.push_back(static_cast<char>(3 | CompactFlag | RingsFlag));
+        writeTags(relation.tags);
+        writeVarint(rings.size());
+        // NOTE the first coordinate of ring is relative to the last coordinate of previous one.
+        std::int64_t latitude = originLatitude_;
+        std::int64_t longitude = originLongitude_;
+        for (const auto* ring : rings) {
+            writeVarint(ring->id);
+            writeVarint(ring->coordinates.size());
+            writeCoordinates(ring->coordinates.data(), ring->coordinates.data() + ring->coordinates.size(), latitude, longitude);
+        }
+    }
+
+    void writeFlags(const std::uint8_t flags)
+    {
+        buffer_.push_back(static_cast<char>(flags | CompactFlag));
+    }
+
+    void writeTags(const std::vector<utymap::entities::Tag>& tags)
+    {
+        writeVarint(tags.size());
+        for (const auto& tag : tags) {
+            writeVarint(tag.key);
+            writeVarint(tag.value);
+        }
+    }
+
+    void writeCoordinates(const GeoCoordinate* begin, const GeoCoordinate* end)
+    {
+        std::int64_t latitude = originLatitude_;
+        std::int64_t longitude = originLongitude_;
+        writeCoordinates(begin, end, latitude, longitude);
+    }
+
+    /// Writes coordinates as deltas from given one which is updated to the last written.
+    void writeCoordinates(const GeoCoordinate* begin, const GeoCoordinate* end, std::int64_t& latitude, std::int64_t& longitude)
+    {
+        for (; begin != end; ++begin) {
+            std::int64_t currentLatitude = toFixed(begin->latitude);
+            std::int64_t currentLongitude = toFixed(begin->longitude);
+            writeVarint(utymap::utils::zigzag(currentLatitude - latitude));
+            writeVarint(utymap::utils::zigzag(currentLongitude - longitude));
+            latitude = currentLatitude;
+            longitude = currentLongitude;
+        }
+    }
+
+    inline void writeVarint(std::uint64_t value)
+    {
+        utymap::utils::writeVarint(buffer_, value);
+    }
+
+    std::string& buffer_;
+    const std::int64_t originLatitude_;
+    const std::int64_t originLongitude_;
+};
+
+/// Reads element from memory mapped data file. Supports raw and compact encodings.
+class ElementReader final
+{
+public:
+    ElementReader(const char* data, std::size_t size, const GeoCoordinate& origin) :
+        data_(data), size_(size), position_(0),
+        originLatitude_(toFixed(origin.latitude)), originLongitude_(toFixed(origin.longitude))
+    {
+    }
+
+    std::shared_ptr<utymap::entities::Element> readElement(std::uint64_t id, std::uint32_t offset)
+    {
+        position_ = offset;
+        auto element = readElement();
+        element->id = id;
+        return element;
+    }
+
+    /// Reads only type and tags of element at given offset: coordinates and members are left
+    /// empty, so tags can be checked before the rest of element is decoded. Returned element
+    /// is owned by reader and is overwritten by next call.
+    const utymap::entities::Element& readHeader(std::uint64_t id, std::uint32_t offset)
+    {
+        position_ = offset;
+        std::uint8_t flags = read<std::uint8_t>();
+        utymap::entities::Element* element;
+        switch (flags & 0x3) {
+        case 0: element = &node_; break;
+        case 1: element = &way_; break;
+        case 2: element = &area_; break;
+        default: element = &relation_; break;
+        }
+        element->id = id;
+        element->tags = readTags((flags & CompactFlag) != 0);
+        return *element;
+    }
+
+private:
+
+    std::shared_ptr<utymap::entities::Element> readElement()
+    {
+        std::uint8_t flags = read<std::uint8_t>();
+        std::uint8_t elementType = flags & 0x3;
+        bool isCompact = (flags & CompactFlag) != 0;
+        if (elementType == 3 && (flags & RingsFlag) != 0)
+            return readRings();
+
+        switch (elementType) {
+        case 0:
+            return readNode(isCompact);
+        case 1:
+            return readWay(isCompact);
+        case 2:
+            return readArea(isCompact);
+        default:
+            return readRelation(isCompact);
+        }
+    }
+
+    std::shared_ptr<utymap::entities::Node> readNode(bool isCompact)
+    {
+        auto node = std::make_shared<utymap::entities::Node>();
+        node->tags = readTags(isCompact);
+        if (isCompact)
+            readCoordinates(&node->coordinate, 1);
+        else
+            node->coordinate = readCoordinate();
+        return node;
+    }
+
+    std::shared_ptr<utymap::entities::Way> readWay(bool isCompact)
+    {
+        auto way = std::make_shared<utymap::entities::Way>();
+        way->tags = readTags(isCompact);
+        way->coordinates = readCoordinates(isCompact);
+        return way;
+    }
+
+    std::shared_ptr<utymap::entities::Area> readArea(bool isCompact)
+    {
+        auto area = std::make_shared<utymap::entities::Area>();
+        area->tags = readTags(isCompact);
+        area->coordinates = readCoordinates(isCompact);
+        return area;
+    }
+
+    std::shared_ptr<utymap::entities::Relation> readRelation(bool isCompact)
+    {
+        auto relation = std::make_shared<utymap::entities::Relation>();
+        relation->tags = readTags(isCompact);
+        std::size_t elementSize = readSize(isCompact);
+
+        relation->elements.reserve(elementSize);
+        for (std::size_t i = 0; i < elementSize; ++i) {
+            std::uint64_t id = isCompact ? readVarint() : read<std::uint64_t>();
+            auto element = readElement();
+            element->id = id;
+            relation->elements.push_back(element);
+        }
+        return relation;
+    }
+
+    /// Reads relation written as flat list of rings: they are restored as area members.
+    std::shared_ptr<utymap::entities::Relation> readRings()
+    {
+        auto relation = std::make_shared<utymap::entities::Relation>();
+        relation->tags = readTags(true);
+        std::size_t ringSize = readSize(true);
+
+        relation->elements.reserve(ringSize);
+        std::int64_t latitude = originLatitude_;
+        std::int64_t longitude = originLongitude_;
+        for (std::size_t i = 0; i < ringSize; ++i) {
+            auto area = std::make_shared<utymap::entities::Area>();
+            area->id = readVarint();
+            area->coordinates.resize(readSize(true));
+            readCoordinates(area->coordinates.data(), area->coordinates.size(), latitude, longitude);
+            relation->elements.push_back(area);
+        }
+        return relation;
+    }
+
+    inline GeoCoordinate readCoordinate()
+    {
+        GeoCoordinate coord;
+        coord.latitude = read<double>();
+        coord.longitude = read<double>();
+        return coord;
+    }
+
+    inline void readCoordinates(GeoCoordinate* coordinates, std::size_t size)
+    {
+        std::int64_t latitude = originLatitude_;
+        std::int64_t longitude = originLongitude_;
+        readCoordinates(coordinates, size, latitude, longitude);
+    }
+
+    /// Reads coordinates as deltas from given one which is updated to the last read.
+    inline void readCoordinates(GeoCoordinate* coordinates, std::size_t size, std::int64_t& latitude, std::int64_t& longitude)
+    {
+        for (std::size_t i = 0; i < size; ++i) {
+            latitude += utymap::utils::unzigzag(readVarint());
+            longitude += utymap::utils::unzigzag(readVarint());
+            coordinates[i].latitude = latitude / CoordinatePrecision;
+            coordinates[i].longitude = longitude / CoordinatePrecision;
+        }
+    }
+
+    inline std::vector<GeoCoordinate> readCoordinates(bool isCompact)
+    {
+        std::size_t coordSize = readSize(isCompact);
+
+        std::vector<GeoCoordinate> coordinates;
+        if (isCompact) {
+            coordinates.resize(coordSize);
+            readCoordinates(coordinates.data(), coordSize);
+        } else {
+            coordinates.reserve(coordSize);
+            for (std::size_t i = 0; i < coordSize; ++i) {
+                coordinates.push_back(readCoordinate());
+            }
+        }
+
+        return std::move(coordinates);
+    }
+
+    inline std::vector<utymap::entities::Tag> readTags(bool isCompact)
+    {
+        std::size_t tagSize = readSize(isCompact);
+
+        std::vector<utymap::entities::Tag> tags;
+        tags.reserve(tagSize);
+        for (std::size_t i = 0; i < tagSize; ++i) {
+            utymap::entities::Tag tag;
+            tag.key = isCompact ? static_cast<std::uint32_t>(readVarint()) : read<std::uint32_t>();
+            tag.value = isCompact ? static_cast<std::uint32_t>(readVarint()) : read<std::uint32_t>();
+            tags.push_back(tag);
+        }
+
+        return std::move(tags);
+    }
+
+    inline std::size_t readSize(bool isCompact)
+    {
+        return isCompact 
+            ? static_cast<std::size_t>(readVarint())
+            : read<std::uint16_t>();
+    }
+
+    inline std::uint64_t readVarint()
+    {
+        std::uint64_t value;
+        if (!utymap::utils::readVarint(data_, size_, position_, value))
+            throw std::domain_error("Invalid varint in data file.");
+        return value;
+    }
+
+    /// Reads value of given type at current position. Memcpy is used as data is not aligned.
+    template <typename T>
+    inline T read()
+    {
+        if (position_ + sizeof(T) > size_)
+            throw std::domain_error("Unexpected end of data file.");
+
+        T value;
+        std::memcpy(&value, data_ + position_, sizeof(T));
+        position_ += sizeof(T);
+        return value;
+    }
+
+    const char* data_;
+    std::size_t size_;
+    std::size_t position_;
+    const std::int64_t originLatitude_;
+    const std::int64_t originLongitude_;
+
+    /// Elements returned by readHeader.
+    utymap::entities::Node node_;
+    utymap::entities::Way way_;
+    utymap::entities::Area area_;
+    utymap::entities::Relation relation_;
+};
+
+}}
+
+#endif // INDEX_ELEMENTENCODING_HPP_DEFINED
@@ -1,5 +1,6 @@
 #include "BoundingBox.hpp"
 #include "QuadKey.hpp"
+#include "entities/BoundingBoxVisitor.hpp"
 #include "entities/Element.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
@@ -7,6 +8,13 @@
 #include "entities/Relation.hpp"
 #include "index/ElementStore.hpp"
 #include "index/ElementGeometryClipper.hpp"
+#include "utils/GeometryUtils.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
 
 using namespace utymap;
 using namespace utymap::entities;
@@ -19,41 +27,85 @@ namespace {
 
     using PointLocation = utymap::index::ElementGeometryClipper::PointLocation;
 
-    PointLocation checkWay(const BoundingBox& bbox, const Way& way, ClipperLib::Path& wayShape) {
-        wayShape.reserve(way.coordinates.size());
-        bool allInside = true;
-        bool allOutside = true;
-        for (const GeoCoordinate& coord : way.coordinates) {
-            bool contains = bbox.contains(coord);
-            allInside &= contains;
-            allOutside &= !contains;
+    ClipperLib::Path createPathFromBoundingBox(const BoundingBox& quadKeyBbox)
+    {
+        double xMin = quadKeyBbox.minPoint.longitude, yMin = quadKeyBbox.minPoint.latitude,
+            xMax = quadKeyBbox.maxPoint.longitude, yMax = quadKeyBbox.maxPoint.latitude;
+        ClipperLib::Path rect;
+        rect.push_back(ClipperLib::IntPoint(static_cast<ClipperLib::cInt>(xMin*Scale),
+            static_cast<ClipperLib::cInt>(yMin*Scale)));
 
-            auto x = static_cast<ClipperLib::cInt>(coord.longitude * Scale);
-            auto y = static_cast<ClipperLib::cInt>(coord.latitude * Scale);
-            wayShape.push_back(ClipperLib::IntPoint(x, y));
+        rect.push_back(ClipperLib::IntPoint(static_cast<ClipperLib::cInt>(xMax*Scale),
+            static_cast<ClipperLib::cInt>(yMin*Scale)));
+
+        rect.push_back(ClipperLib::IntPoint(static_cast<ClipperLib::cInt>(xMax*Scale),
+            static_cast<ClipperLib::cInt>(yMax*Scale)));
+
+        rect.push_back(ClipperLib::IntPoint(static_cast<ClipperLib::cInt>(xMin*Scale),
+            static_cast<ClipperLib::cInt>(yMax*Scale)));
+        return std::move(rect);
+    }
+
+    /// Provides clipper which clip path is quadkey rectangle. The path is added on first use
+    /// only as most of elements are clipped without clipper.
+    struct ClipContext final
+    {
+        ClipContext(ClipperLib::ClipperEx& clipper, bool& hasClipPath, const BoundingBox& bbox) :
+            bbox(bbox), clipper_(clipper), hasClipPath_(hasClipPath)
+        {
         }
 
-        return allInside ? PointLocation::AllInside :
-            (allOutside ? PointLocation::AllOutside : PointLocation::Mixed);
+        ClipperLib::ClipperEx& getClipper()
+        {
+            if (!hasClipPath_) {
+                clipper_.Clear();
+                clipper_.AddPath(createPathFromBoundingBox(bbox), ClipperLib::ptClip, true);
+                hasClipPath_ = true;
+            }
+            return clipper_;
+        }
+
+        const BoundingBox& bbox;
+
+    private:
+        ClipperLib::ClipperEx& clipper_;
+        bool& hasClipPath_;
+    };
+
+    /// Checks whether geometry bounding box is inside bbox including its border: geometry
+    /// clipped by parent tile lies on borders of children.
+    bool isInside(const BoundingBox& bbox, const BoundingBox& geometryBbox)
+    {
+        return geometryBbox.minPoint.latitude >= bbox.minPoint.latitude &&
+               geometryBbox.minPoint.longitude >= bbox.minPoint.longitude &&
+               geometryBbox.maxPoint.latitude <= bbox.maxPoint.latitude &&
+               geometryBbox.maxPoint.longitude <= bbox.maxPoint.longitude;
     }
 
-    PointLocation checkArea(const BoundingBox& bbox, const Area& area, ClipperLib::Path& areaShape) {
-        bool allInside = true;
-        auto areaBbox = BoundingBox();
+    /// Classifies geometry by its bounding box: it is cheaper than point by point check.
+    PointLocation checkGeometry(const BoundingBox& bbox, const BoundingBox& geometryBbox)
+    {
+        return isInside(bbox, geometryBbox) ? PointLocation::AllInside :
+            (bbox.intersects(geometryBbox) ? PointLocation::Mixed : PointLocation::AllOutside);
+    }
 
-        areaShape.reserve(area.coordinates.size());
-        for (const GeoCoordinate& coord : area.coordinates) {
-            bool contains = bbox.contains(coord);
-            areaBbox.expand(coord);
-            allInside &= contains;
+    PointLocation checkGeometry(const BoundingBox& bbox, const std::vector<GeoCoordinate>& coordinates)
+    {
+        BoundingBox geometryBbox;
+        geometryBbox.expand(coordinates.begin(), coordinates.end());
+        return checkGeometry(bbox, geometryBbox);
+    }
 
+    ClipperLib::Path createPath(const std::vector<GeoCoordinate>& coordinates)
+    {
+        ClipperLib::Path path;
+        path.reserve(coordinates.size());
+        for (const GeoCoordinate& coord : coordinates) {
             auto x = static_cast<ClipperLib::cInt>(coord.longitude * Scale);
             auto y = static_cast<ClipperLib::cInt>(coord.latitude * Scale);
-            areaShape.push_back(ClipperLib::IntPoint(x, y));
+            path.push_back(ClipperLib::IntPoint(x, y));
         }
-
-        return allInside ? PointLocation::AllInside :
-            (bbox.intersects(areaBbox) ? PointLocation::Mixed : PointLocation::AllOutside);
+        return path;
     }
 
     template<typename T>
@@ -71,65 +123,240 @@ namespace {
         setCoordinates<T>(t, path);
     }
 
-    ClipperLib::Path createPathFromBoundingBox(const BoundingBox& quadKeyBbox)
+    // region Cohen-Sutherland
+
+    enum OutCode { Inside = 0, Left = 1, Right = 2, Bottom = 4, Top = 8 };
+
+    int getOutCode(const BoundingBox& bbox, const GeoCoordinate& coordinate)
     {
-        double xMin = quadKeyBbox.minPoint.longitude, yMin = quadKeyBbox.minPoint.latitude,
-            xMax = quadKeyBbox.maxPoint.longitude, yMax = quadKeyBbox.maxPoint.latitude;
-        ClipperLib::Path rect;
-        rect.push_back(ClipperLib::IntPoint(static_cast<ClipperLib::cInt>(xMin*Scale),
-            static_cast<ClipperLib::cInt>(yMin*Scale)));
+        int code = Inside;
+        if (coordinate.longitude < bbox.minPoint.longitude) code |= Left;
+        else if (coordinate.longitude > bbox.maxPoint.longitude) code |= Right;
+        if (coordinate.latitude < bbox.minPoint.latitude) code |= Bottom;
+        else if (coordinate.latitude > bbox.maxPoint.latitude) code |= Top;
+        return code;
+    }
 
-        rect.push_back(ClipperLib::IntPoint(static_cast<ClipperLib::cInt>(xMax*Scale),
-            static_cast<ClipperLib::cInt>(yMin*Scale)));
+    GeoCoordinate getAtLongitude(const GeoCoordinate& start, const GeoCoordinate& end, double longitude)
+    {
+        double ratio = (longitude - start.longitude) / (end.longitude - start.longitude);
+        return GeoCoordinate(start.latitude + ratio * (end.latitude - start.latitude), longitude);
+    }
 
-        rect.push_back(ClipperLib::IntPoint(static_cast<ClipperLib::cInt>(xMax*Scale),
-            static_cast<ClipperLib::cInt>(yMax*Scale)));
+    GeoCoordinate getAtLatitude(const GeoCoordinate& start, const GeoCoordinate& end, double latitude)
+    {
+        double ratio = (latitude - start.latitude) / (end.latitude - start.latitude);
+        return GeoCoordinate(latitude, start.longitude + ratio * (end.longitude - start.longitude));
+    }
 
-        rect.push_back(ClipperLib::IntPoint(static_cast<ClipperLib::cInt>(xMin*Scale),
-            static_cast<ClipperLib::cInt>(yMax*Scale)));
-        return std::move(rect);
+    /// Clips segment by bounding box. Returns false if segment is outside.
+    bool clipSegment(const BoundingBox& bbox, GeoCoordinate& start, GeoCoordinate& end)
+    {
+        int startCode = getOutCode(bbox, start);
+        int endCode = getOutCode(bbox, end);
+        while (true) {
+            if ((startCode | endCode) == Inside)
+                return true;
+            if ((startCode & endCode) != Inside)
+                return false;
+
+            int code = startCode != Inside ? startCode : endCode;
+            GeoCoordinate point;
+            if (code & Top)
+                point = getAtLatitude(start, end, bbox.maxPoint.latitude);
+            else if (code & Bottom)
+                point = getAtLatitude(start, end, bbox.minPoint.latitude);
+            else if (code & Right)
+                point = getAtLongitude(start, end, bbox.maxPoint.longitude);
+            else
+                point = getAtLongitude(start, end, bbox.minPoint.longitude);
+
+            if (code == startCode) {
+                start = point;
+                startCode = getOutCode(bbox, start);
+            } else {
+                end = point;
+                endCode = getOutCode(bbox, end);
+            }
+        }
     }
 
-    std::shared_ptr<Element> processWay(ClipperLib::ClipperEx& clipper, const BoundingBox& bbox, const Way& way)
+    /// Clips polyline by bounding box keeping its direction. Returns parts inside bounding box.
+    std::vector<std::vector<GeoCoordinate>> clipPolyline(const BoundingBox& bbox, const std::vector<GeoCoordinate>& coordinates)
     {
-        ClipperLib::Path wayShape;
-        PointLocation pointLocation = checkWay(bbox, way, wayShape);
-        // 1. all geometry inside current quadkey: no need to truncate.
-        if (pointLocation == PointLocation::AllInside) {
-            return std::make_shared<Way>(way);
+        std::vector<std::vector<GeoCoordinate>> parts;
+        std::vector<GeoCoordinate> part;
+        auto flush = [&]() {
+            if (part.size() > 1)
+                parts.push_back(std::move(part));
+            part.clear();
+        };
+
+        for (std::size_t i = 1; i < coordinates.size(); ++i) {
+            GeoCoordinate start = coordinates[i - 1];
+            GeoCoordinate end = coordinates[i];
+            if (!clipSegment(bbox, start, end)) {
+                flush();
+                continue;
+            }
+
+            // NOTE segment which touches bounding box in single point is skipped.
+            if (!(start == end)) {
+                if (!part.empty() && !(part.back() == start))
+                    flush();
+                if (part.empty())
+                    part.push_back(start);
+                part.push_back(end);
+            }
+
+            // segment leaves bounding box: next one starts new part.
+            if (!(end == coordinates[i]))
+                flush();
         }
+        flush();
 
-        // 2. all geometry outside : way should be skipped
-        if (pointLocation == PointLocation::AllOutside) {
-            return nullptr;
+        return parts;
+    }
+
+    // endregion
+
+    // region Sutherland-Hodgman
+
+    /// Checks whether polygon is convex: all turns have the same direction and it winds only once.
+    bool isConvex(const std::vector<GeoCoordinate>& coordinates)
+    {
+        std::size_t size = coordinates.size();
+        if (size < 3)
+            return false;
+
+        int sign = 0, latitudeFlips = 0, longitudeFlips = 0;
+        double lastLatitudeDelta = 0, lastLongitudeDelta = 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            const GeoCoordinate& a = coordinates[i];
+            const GeoCoordinate& b = coordinates[(i + 1) % size];
+            const GeoCoordinate& c = coordinates[(i + 2) % size];
+
+            double cross = (b.longitude - a.longitude) * (c.latitude - b.latitude) -
+                           (b.latitude - a.latitude) * (c.longitude - b.longitude);
+            if (cross != 0) {
+                int current = cross > 0 ? 1 : -1;
+                if (sign != 0 && current != sign)
+                    return false;
+                sign = current;
+            }
+
+            double latitudeDelta = b.latitude - a.latitude;
+            double longitudeDelta = b.longitude - a.longitude;
+            if (latitudeDelta != 0) {
+                if (lastLatitudeDelta * latitudeDelta < 0)
+                    ++latitudeFlips;
+                lastLatitudeDelta = latitudeDelta;
+            }
+            if (longitudeDelta != 0) {
+                if (lastLongitudeDelta * longitudeDelta < 0)
+                    ++longitudeFlips;
+                lastLongitudeDelta = longitudeDelta;
+            }
         }
 
-        ClipperLib::PolyTree solution;
-        clipper.AddPath(wayShape, ClipperLib::ptSubject, false);
-        clipper.Execute(ClipperLib::ctIntersection, solution);
-        clipper.removeSubject();
-        
-        std::size_t count = static_cast<std::size_t>(solution.Total());
+        return sign != 0 && latitudeFlips <= 2 && longitudeFlips <= 2;
+    }
+
+    /// Clips polygon by half plane defined by one of bounding box sides.
+    template<typename Inside, typename Intersect>
+    void clipBySide(const std::vector<GeoCoordinate>& input, std::vector<GeoCoordinate>& output,
+                    Inside isInside, Intersect intersect)
+    {
+        output.clear();
+        if (input.empty())
+            return;
+
+        GeoCoordinate previous = input.back();
+        bool isPreviousInside = isInside(previous);
+        for (const GeoCoordinate& current : input) {
+            bool isCurrentInside = isInside(current);
+            if (isCurrentInside != isPreviousInside)
+                output.push_back(intersect(previous, current));
+            if (isCurrentInside)
+                output.push_back(current);
+            previous = current;
+            isPreviousInside = isCurrentInside;
+        }
+    }
 
-        // 3. way intersects border only once: store a copy with clipped geometry
-        if (count == 1) {
+    /// Removes repeated and collinear points of closed polygon.
+    void simplify(std::vector<GeoCoordinate>& coordinates)
+    {
+        bool isChanged = true;
+        while (isChanged && coordinates.size() > 2) {
+            isChanged = false;
+            for (std::size_t i = 0; i < coordinates.size() && coordinates.size() > 2;) {
+                const GeoCoordinate& previous = coordinates[(i + coordinates.size() - 1) % coordinates.size()];
+                const GeoCoordinate& current = coordinates[i];
+                const GeoCoordinate& next = coordinates[(i + 1) % coordinates.size()];
+                double cross = (current.longitude - previous.longitude) * (next.latitude - current.latitude) -
+                               (current.latitude - previous.latitude) * (next.longitude - current.longitude);
+                if (current == previous || std::abs(cross) < std::numeric_limits<double>::epsilon()) {
+                    coordinates.erase(coordinates.begin() + i);
+                    isChanged = true;
+                } else
+                    ++i;
+            }
+        }
+    }
+
+    /// Clips convex polygon by bounding box. Result is counterclockwise or empty.
+    std::vector<GeoCoordinate> clipConvexPolygon(const BoundingBox& bbox, const std::vector<GeoCoordinate>& coordinates)
+    {
+        double minLat = bbox.minPoint.latitude, minLon = bbox.minPoint.longitude,
+            maxLat = bbox.maxPoint.latitude, maxLon = bbox.maxPoint.longitude;
+
+        std::vector<GeoCoordinate> result, buffer;
+        clipBySide(coordinates, buffer, [&](const GeoCoordinate& c) { return c.longitude >= minLon; },
+            [&](const GeoCoordinate& s, const GeoCoordinate& e) { return getAtLongitude(s, e, minLon); });
+        clipBySide(buffer, result, [&](const GeoCoordinate& c) { return c.longitude <= maxLon; },
+            [&](const GeoCoordinate& s, const GeoCoordinate& e) { return getAtLongitude(s, e, maxLon); });
+        clipBySide(result, buffer, [&](const GeoCoordinate& c) { return c.latitude >= minLat; },
+            [&](const GeoCoordinate& s, const GeoCoordinate& e) { return getAtLatitude(s, e, minLat); });
+        clipBySide(buffer, result, [&](const GeoCoordinate& c) { return c.latitude <= maxLat; },
+            [&](const GeoCoordinate& s, const GeoCoordinate& e) { return getAtLatitude(s, e, maxLat); });
+
+        simplify(result);
+        if (result.size() < 3)
+            return std::vector<GeoCoordinate>();
+
+        // NOTE keep orientation which clipper produces for outer contours.
+        if (utymap::utils::isClockwise(result))
+            std::reverse(result.begin(), result.end());
+
+        return result;
+    }
+
+    // endregion
+
+    std::shared_ptr<Element> clipWay(const BoundingBox& bbox, const Way& way)
+    {
+        auto parts = clipPolyline(bbox, way.coordinates);
+
+        // 1. way intersects border only once: store a copy with clipped geometry
+        if (parts.size() == 1) {
             auto clippedWay = std::make_shared<Way>();
-            setData(*clippedWay, way, solution.GetFirst()->Contour);
+            clippedWay->id = way.id;
+            clippedWay->tags = way.tags;
+            clippedWay->coordinates = std::move(parts[0]);
             return clippedWay;
         }
-        // 4. in this case, result should be stored as relation (collection of ways)
-        if (count > 1) {
+        // 2. in this case, result should be stored as relation (collection of ways)
+        if (parts.size() > 1) {
             auto relation = std::make_shared<Relation>();
             relation->id = way.id;
             relation->tags = way.tags;
-            relation->elements.reserve(count);
-            ClipperLib::PolyNode* polyNode = solution.GetFirst();
-            while (polyNode) {
+            relation->elements.reserve(parts.size());
+            for (auto& part : parts) {
                 auto clippedWay = std::make_shared<Way>();
                 clippedWay->id = way.id;
-                setCoordinates(*clippedWay, polyNode->Contour);
+                clippedWay->coordinates = std::move(part);
                 relation->elements.push_back(clippedWay);
-                polyNode = polyNode->GetNext();
             }
             return relation;
         }
@@ -138,32 +365,22 @@ namespace {
         return nullptr;
     }
 
-    std::shared_ptr<Element> processArea(ClipperLib::ClipperEx& clipper, const BoundingBox& bbox, const Area& area)
+    /// Clips area using general polygon clipping.
+    std::shared_ptr<Element> clipComplexArea(ClipContext& context, const Area& area)
     {
-        ClipperLib::Path areaShape;
-        PointLocation pointLocation = checkArea(bbox, area, areaShape);
-        // 1. all geometry inside current quadkey: no need to truncate.
-        if (pointLocation == PointLocation::AllInside) {
-            return std::make_shared<Area>(area);
-        }
-
-        // 2. all geometry outside: use geometry of quadkey
-        if (pointLocation == PointLocation::AllOutside) {
-            return nullptr;
-        }
-
+        ClipperLib::ClipperEx& clipper = context.getClipper();
         ClipperLib::Paths solution;
-        clipper.AddPath(areaShape, ClipperLib::ptSubject, true);
+        clipper.AddPath(createPath(area.coordinates), ClipperLib::ptSubject, true);
         clipper.Execute(ClipperLib::ctIntersection, solution);
         clipper.removeSubject();
 
-        // 3. way intersects border only once: store a copy with clipped geometry
+        // 1. area intersects border only once: store a copy with clipped geometry
         if (solution.size() == 1) {
             auto clippedArea = std::make_shared<Area>();
             setData(*clippedArea, area, solution[0]);
             return clippedArea;
         }
-        // 4. in this case, result should be stored as relation (collection of areas)
+        // 2. in this case, result should be stored as relation (collection of areas)
         if (solution.size() > 0) {
             auto relation = std::make_shared<Relation>();
             relation->id = area.id;
@@ -181,19 +398,56 @@ namespace {
         return nullptr;
     }
 
-    std::shared_ptr<Element> processRelation(ClipperLib::ClipperEx& clipper, const BoundingBox& bbox, const Relation& relation);
+    std::shared_ptr<Element> clipArea(ClipContext& context, const Area& area)
+    {
+        // NOTE convex polygon clipped by rectangle is single convex polygon
+        if (!isConvex(area.coordinates))
+            return clipComplexArea(context, area);
+
+        auto coordinates = clipConvexPolygon(context.bbox, area.coordinates);
+        if (coordinates.empty())
+            return nullptr;
+
+        auto clippedArea = std::make_shared<Area>();
+        clippedArea->id = area.id;
+        clippedArea->tags = area.tags;
+        clippedArea->coordinates = std::move(coordinates);
+        return clippedArea;
+    }
+
+    std::shared_ptr<Element> processWay(ClipContext& context, const Way& way)
+    {
+        switch (checkGeometry(context.bbox, way.coordinates)) {
+            case PointLocation::AllInside: return std::make_shared<Way>(way);
+            case PointLocation::AllOutside: return nullptr;
+            default: return clipWay(context.bbox, way);
+        }
+    }
+
+    /// NOTE members of relation are clipped by clipper: outer and inner contours
+    /// should be processed by the same algorithm.
+    std::shared_ptr<Element> processArea(ClipContext& context, const Area& area)
+    {
+        switch (checkGeometry(context.bbox, area.coordinates)) {
+            case PointLocation::AllInside: return std::make_shared<Area>(area);
+            case PointLocation::AllOutside: return nullptr;
+            default: return clipComplexArea(context, area);
+        }
+    }
+
+    std::shared_ptr<Element> processRelation(ClipContext& context, const Relation& relation);
  
     /// Visits relation and collects clipped elements
     struct RelationVisitor : public ElementVisitor
     {
-        RelationVisitor(ClipperLib::ClipperEx& clipper, const BoundingBox& quadKeyBbox) :
-            relation(nullptr), clipper_(clipper), bbox_(quadKeyBbox)
+        explicit RelationVisitor(ClipContext& context) :
+            relation(nullptr), context_(context)
         {
         }
 
         void visitNode(const Node& node) override
         {
-            if (bbox_.contains(node.coordinate)) {
+            if (context_.bbox.contains(node.coordinate)) {
                 ensureRelation();
                 relation->elements.push_back(std::make_shared<Node>(node));
             }
@@ -201,17 +455,17 @@ namespace {
 
         void visitWay(const Way& way) override
         {
-            addElement(processWay(clipper_, bbox_, way), way);
+            addElement(processWay(context_, way), way);
         }
 
         void visitArea(const Area& area) override
         {
-            addElement(processArea(clipper_, bbox_, area),area);
+            addElement(processArea(context_, area),area);
         }
 
         void visitRelation(const Relation& relation) override
         {
-            addElement(processRelation(clipper_, bbox_, relation), relation);
+            addElement(processRelation(context_, relation), relation);
         }
 
         std::shared_ptr<Relation> relation;
@@ -237,13 +491,12 @@ namespace {
             relation->elements.push_back(element);
         }
 
-        ClipperLib::ClipperEx& clipper_;
-        const BoundingBox& bbox_;
+        ClipContext& context_;
     };
 
-    std::shared_ptr<Element> processRelation(ClipperLib::ClipperEx& clipper, const BoundingBox& bbox, const Relation& relation)
+    std::shared_ptr<Element> processRelation(ClipContext& context, const Relation& relation)
     {
-        RelationVisitor visitor(clipper, bbox);
+        RelationVisitor visitor(context);
 
         for (const auto& element : relation.elements) 
             element->accept(visitor);
@@ -265,44 +518,120 @@ namespace {
 namespace utymap { namespace index {
 
 ElementGeometryClipper::ElementGeometryClipper(Callback callback) :
-    callback_(callback), quadKey_(), quadKeyBbox_(), clipper_()
+    callback_(callback), quadKeyBbox_(), clipper_(), hasClipPath_(false),
+    result_(nullptr), clipped_()
 {
 }
 
 void ElementGeometryClipper::clipAndCall(const Element& element, const QuadKey& quadKey, const BoundingBox& quadKeyBbox)
 {
-    quadKey_ = quadKey;
-    quadKeyBbox_ = quadKeyBbox;
-    clipper_.Clear();
-    clipper_.AddPath(createPathFromBoundingBox(quadKeyBbox_), ClipperLib::ptClip, true);
+    Part part = clip(element, quadKeyBbox);
+    if (part.element != nullptr)
+        callback_(*part.element, quadKey);
+}
+
+void ElementGeometryClipper::clipAndCall(const Element& element,
+                                         const QuadKey& quadKey,
+                                         const BoundingBox& quadKeyBbox,
+                                         const LodRange& range,
+                                         const BoundingBox& region,
+                                         const TileFilter& filter)
+{
+    Part part = clip(element, quadKeyBbox);
+    if (part.element != nullptr)
+        clipChildren(*part.element, quadKey, quadKeyBbox, range, region, filter);
+}
+
+ElementGeometryClipper::Part ElementGeometryClipper::clip(const Element& element, const BoundingBox& bbox)
+{
+    quadKeyBbox_ = bbox;
+    hasClipPath_ = false;
+    result_ = nullptr;
+    clipped_.reset();
     element.accept(*this);
+    return Part { result_, std::move(clipped_) };
+}
+
+void ElementGeometryClipper::clipChildren(const Element& part,
+                                          const QuadKey& quadKey,
+                                          const BoundingBox& quadKeyBbox,
+                                          const LodRange& range,
+                                          const BoundingBox& region,
+                                          const TileFilter& filter)
+{
+    if (quadKey.levelOfDetail >= range.start && filter(quadKey, quadKeyBbox))
+        callback_(part, quadKey);
+
+    if (quadKey.levelOfDetail >= range.end)
+        return;
+
+    BoundingBoxVisitor bboxVisitor;
+    utymap::entities::visit(part, bboxVisitor);
+    const BoundingBox& partBbox = bboxVisitor.boundingBox;
+
+    for (int i = 0; i < 4; ++i) {
+        QuadKey child(quadKey.levelOfDetail + 1, quadKey.tileX * 2 + i % 2, quadKey.tileY * 2 + i / 2);
+        BoundingBox childBbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(child);
+        if (!childBbox.intersects(region) || !childBbox.intersects(partBbox))
+            continue;
+
+        // NOTE part strictly inside child needs no clipping.
+        if (childBbox.contains(partBbox)) {
+            clipChildren(part, child, childBbox, range, region, filter);
+            continue;
+        }
+
+        Part childPart = clip(part, childBbox);
+        if (childPart.element != nullptr)
+            clipChildren(*childPart.element, child, childBbox, range, region, filter);
+    }
 }
 
 void ElementGeometryClipper:: visitNode(const Node& node)
 {
     if (quadKeyBbox_.contains(node.coordinate))
-        callback_(node, quadKey_);
+        result_ = &node;
 }
 
 void ElementGeometryClipper::visitWay(const Way& way)
 {
-    auto element = processWay(clipper_, quadKeyBbox_, way);
-    if (element != nullptr)
-        callback_(*element, quadKey_);
+    // NOTE element inside quadkey is passed as is: no copy is needed.
+    switch (checkGeometry(quadKeyBbox_, way.coordinates)) {
+        case PointLocation::AllInside: result_ = &way; return;
+        case PointLocation::AllOutside: return;
+        default: break;
+    }
+
+    clipped_ = clipWay(quadKeyBbox_, way);
+    result_ = clipped_.get();
 }
 
 void ElementGeometryClipper::visitArea(const Area& area)
 {
-    auto element = processArea(clipper_, quadKeyBbox_, area);
-    if (element != nullptr)
-        callback_(*element, quadKey_);
+    switch (checkGeometry(quadKeyBbox_, area.coordinates)) {
+        case PointLocation::AllInside: result_ = &area; return;
+        case PointLocation::AllOutside: return;
+        default: break;
+    }
+
+    ClipContext context(clipper_, hasClipPath_, quadKeyBbox_);
+    clipped_ = clipArea(context, area);
+    result_ = clipped_.get();
 }
 
 void ElementGeometryClipper::visitRelation(const Relation& relation)
 {
-    auto element = processRelation(clipper_, quadKeyBbox_, relation);
-    if (element != nullptr)
-        callback_(*element, quadKey_);
+    BoundingBoxVisitor bboxVisitor;
+    utymap::entities::visit(relation, bboxVisitor);
+    switch (checkGeometry(quadKeyBbox_, bboxVisitor.boundingBox)) {
+        case PointLocation::AllInside: result_ = &relation; return;
+        case PointLocation::AllOutside: return;
+        default: break;
+    }
+
+    ClipContext context(clipper_, hasClipPath_, quadKeyBbox_);
+    clipped_ = processRelation(context, relation);
+    result_ = clipped_.get();
 }
 
 }}
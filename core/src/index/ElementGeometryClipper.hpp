@@ -3,6 +3,7 @@
 
 #include "clipper/clipper.hpp"
 #include "BoundingBox.hpp"
+#include "LodRange.hpp"
 #include "QuadKey.hpp"
 #include "entities/Element.hpp"
 #include "entities/Node.hpp"
@@ -10,18 +11,23 @@
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
 #include "entities/ElementVisitor.hpp"
-#include "index/ElementStore.hpp"
 
 #include <functional>
+#include <memory>
 
 namespace utymap { namespace index {
 
-/// Modifies geometry of element by bounding box clipping.
+/// Modifies geometry of element by bounding box clipping. Elements are classified by their
+/// bounding box first: elements inside are passed as is, elements outside are skipped. Ways are
+/// clipped by Cohen-Sutherland and convex areas by Sutherland-Hodgman algorithms, clipper is used
+/// for other areas and relations only.
 class ElementGeometryClipper final : private utymap::entities::ElementVisitor
 {
 public:
     /// Defines callback
     typedef std::function<void(const utymap::entities::Element& element, const utymap::QuadKey& quadKey)> Callback;
+    /// Decides whether clipped element should be passed to callback for given tile.
+    typedef std::function<bool(const utymap::QuadKey& quadKey, const utymap::BoundingBox& quadKeyBbox)> TileFilter;
     /// Defines polygon points location relative to current quadkey.
     enum class PointLocation { AllInside, AllOutside, Mixed };
 
@@ -29,7 +35,37 @@ public:
 
     void clipAndCall(const utymap::entities::Element& element, const QuadKey& quadKey, const BoundingBox& quadKeyBbox);
 
+    /// Clips element into given quadkey and then into all its descendants till end of level of
+    /// details range which intersect region. Every tile is clipped from part of its parent, so
+    /// element is clipped in one sweep. Callback is called for tiles within range accepted by filter.
+    /// Root quadkey (zero level of details) clips element into all tiles of range at once.
+    void clipAndCall(const utymap::entities::Element& element,
+                     const QuadKey& quadKey,
+                     const BoundingBox& quadKeyBbox,
+                     const utymap::LodRange& range,
+                     const BoundingBox& region,
+                     const TileFilter& filter);
+
 private:
+    /// Represents element clipped by bounding box.
+    struct Part final
+    {
+        /// Clipped element or null if nothing is left. Either original element or held one.
+        const utymap::entities::Element* element;
+        /// Keeps clipped element if it is not the original one.
+        std::shared_ptr<const utymap::entities::Element> holder;
+    };
+
+    /// Clips element by given bounding box.
+    Part clip(const utymap::entities::Element& element, const BoundingBox& bbox);
+
+    /// Passes part of given quadkey to callback and clips it into children.
+    void clipChildren(const utymap::entities::Element& part,
+                      const QuadKey& quadKey,
+                      const BoundingBox& quadKeyBbox,
+                      const utymap::LodRange& range,
+                      const BoundingBox& region,
+                      const TileFilter& filter);
 
     void visitNode(const utymap::entities::Node& node);
 
@@ -40,9 +76,13 @@ private:
     void visitRelation(const utymap::entities::Relation& relation);
 
     Callback callback_;
-    QuadKey quadKey_;
     BoundingBox quadKeyBbox_;
     ClipperLib::ClipperEx clipper_;
+    /// Whether quadkey rectangle is added to clipper as clip path.
+    bool hasClipPath_;
+    /// Result of last visit: original element, held clipped one or null.
+    const utymap::entities::Element* result_;
+    std::shared_ptr<const utymap::entities::Element> clipped_;
 };
 
 }}
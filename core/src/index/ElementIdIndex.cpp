@@ -0,0 +1,162 @@
+#include "index/ElementIdIndex.hpp"
+#include "utils/VarintUtils.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+using namespace utymap;
+using namespace utymap::index;
+using namespace utymap::utils;
+
+namespace {
+    ///                                  Element id index file format
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Header       |  Magic (4b) and amount of pairs (4b)                                              |
+    ///------------------------------------------------------------------------------------------------------|
+    ///      Pairs       |  Sorted by id and packed quadkey: delta of id from previous pair and packed       |
+    ///                  |  quadkey, both are varints.                                                       |
+    ///------------------------------------------------------------------------------------------------------|
+    const std::uint32_t Magic = 0x31444955;
+}
+
+ElementIdIndex::ElementIdIndex() :
+    entries_(), sortedCount_(0), isChanged_(false), sequence_(0), lock_()
+{
+}
+
+void ElementIdIndex::add(std::uint64_t id, const QuadKey& quadKey)
+{
+    addEntry(id, quadKey, false);
+}
+
+void ElementIdIndex::remove(std::uint64_t id, const QuadKey& quadKey)
+{
+    addEntry(id, quadKey, true);
+}
+
+std::vector<QuadKey> ElementIdIndex::find(std::uint64_t id) const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    prepare();
+
+    std::vector<QuadKey> quadKeys;
+    auto entry = std::lower_bound(entries_.begin(), entries_.end(), id, [](const Entry& left, std::uint64_t value) {
+        return left.id < value;
+    });
+    for (; entry != entries_.end() && entry->id == id; ++entry)
+        quadKeys.push_back(PackedQuadKey::fromValue(entry->quadKey).unpack());
+    return quadKeys;
+}
+
+bool ElementIdIndex::read(const std::string& path)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.good())
+        return false;
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::uint32_t header[2];
+    if (data.size() < sizeof(header))
+        return false;
+    std::memcpy(header, data.data(), sizeof(header));
+    if (header[0] != Magic)
+        return false;
+
+    std::vector<Entry> entries;
+    entries.reserve(header[1]);
+    std::size_t position = sizeof(header);
+    std::uint64_t id = 0;
+    for (std::uint32_t i = 0; i < header[1]; ++i) {
+        std::uint64_t delta, quadKey;
+        if (!readVarint(data, position, delta) || !readVarint(data, position, quadKey))
+            return false;
+        id += delta;
+        entries.push_back(Entry { id, quadKey, 0, false });
+    }
+
+    std::lock_guard<std::mutex> lock(lock_);
+    entries_.swap(entries);
+    sortedCount_ = entries_.size();
+    isChanged_ = false;
+    return true;
+}
+
+void ElementIdIndex::write(const std::string& path) const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    prepare();
+    if (!isChanged_)
+        return;
+
+    std::uint32_t header[2] = { Magic, static_cast<std::uint32_t>(entries_.size()) };
+    std::string data(reinterpret_cast<const char*>(header), sizeof(header));
+    std::uint64_t id = 0;
+    for (const auto& entry : entries_) {
+        writeVarint(data, entry.id - id);
+        writeVarint(data, entry.quadKey);
+        id = entry.id;
+    }
+
+    // NOTE file is replaced only when it is completely written.
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(data.data(), data.size());
+        if (!file.good())
+            return;
+    }
+    std::remove(path.c_str());
+    isChanged_ = std::rename(tmpPath.c_str(), path.c_str()) != 0;
+}
+
+std::size_t ElementIdIndex::size() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    prepare();
+    return entries_.size();
+}
+
+std::size_t ElementIdIndex::getMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return entries_.capacity() * sizeof(Entry);
+}
+
+void ElementIdIndex::addEntry(std::uint64_t id, const QuadKey& quadKey, bool isRemoved)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    entries_.push_back(Entry { id, PackedQuadKey(quadKey).value, ++sequence_, isRemoved });
+    isChanged_ = true;
+}
+
+void ElementIdIndex::prepare() const
+{
+    if (sortedCount_ == entries_.size())
+        return;
+
+    auto order = [](const Entry& left, const Entry& right) {
+        if (left.id != right.id)
+            return left.id < right.id;
+        return left.quadKey != right.quadKey ? left.quadKey < right.quadKey : left.sequence > right.sequence;
+    };
+    // NOTE only appended entries are sorted: they are merged with sorted ones in linear time.
+    std::sort(entries_.begin() + sortedCount_, entries_.end(), order);
+    std::inplace_merge(entries_.begin(), entries_.begin() + sortedCount_, entries_.end(), order);
+
+    // NOTE the first entry of every pair is the latest change, pair is dropped if it is removal.
+    std::size_t count = 0;
+    std::uint64_t previousId = 0, previousQuadKey = 0;
+    for (std::size_t i = 0; i < entries_.size(); ++i) {
+        Entry entry = entries_[i];
+        bool isSamePair = i > 0 && entry.id == previousId && entry.quadKey == previousQuadKey;
+        previousId = entry.id;
+        previousQuadKey = entry.quadKey;
+        if (!isSamePair && !entry.isRemoved)
+            entries_[count++] = entry;
+    }
+    entries_.resize(count);
+    sortedCount_ = entries_.size();
+}
@@ -0,0 +1,69 @@
+#ifndef INDEX_ELEMENTIDINDEX_HPP_DEFINED
+#define INDEX_ELEMENTIDINDEX_HPP_DEFINED
+
+#include "QuadKey.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace utymap { namespace index {
+
+/// Reverse index from element id to quadkeys where element is stored. Keeps pairs of id and
+/// packed quadkey in sorted array: changes are appended and merged into it on next lookup.
+class ElementIdIndex final
+{
+public:
+    ElementIdIndex();
+
+    /// Records that element with given id is stored in quadkey.
+    void add(std::uint64_t id, const utymap::QuadKey& quadKey);
+
+    /// Records that element with given id is removed from quadkey.
+    void remove(std::uint64_t id, const utymap::QuadKey& quadKey);
+
+    /// Returns quadkeys of element ordered by level of detail and then along Z curve.
+    std::vector<utymap::QuadKey> find(std::uint64_t id) const;
+
+    /// Reads index from file replacing current one. Returns false if file is missing or invalid.
+    bool read(const std::string& path);
+
+    /// Writes index to file if it is changed since it is read or written. File is written aside
+    /// and replaces existing one when it is complete.
+    void write(const std::string& path) const;
+
+    /// Returns amount of element and quadkey pairs.
+    std::size_t size() const;
+
+    /// Returns approximate amount of bytes used by index.
+    std::size_t getMemoryUsage() const;
+
+private:
+    struct Entry final
+    {
+        std::uint64_t id;
+        std::uint64_t quadKey;
+        /// Order of change: the latest change of the same pair wins.
+        std::uint64_t sequence;
+        bool isRemoved;
+    };
+
+    void addEntry(std::uint64_t id, const utymap::QuadKey& quadKey, bool isRemoved);
+
+    /// Merges appended entries into sorted ones keeping only the latest change of every pair.
+    /// Should be called under lock.
+    void prepare() const;
+
+    mutable std::vector<Entry> entries_;
+    /// Amount of sorted entries at the beginning.
+    mutable std::size_t sortedCount_;
+    mutable bool isChanged_;
+    std::uint64_t sequence_;
+    mutable std::mutex lock_;
+};
+
+}}
+
+#endif // INDEX_ELEMENTIDINDEX_HPP_DEFINED
@@ -0,0 +1,29 @@
+#ifndef INDEX_ELEMENTPREFILTER_HPP_DEFINED
+#define INDEX_ELEMENTPREFILTER_HPP_DEFINED
+
+#include "entities/Element.hpp"
+#include "entities/ElementVisitor.hpp"
+
+namespace utymap { namespace index {
+
+/// Implemented by element visitor which can reject element by its id and tags. Stores which keep
+/// elements encoded call it before geometry is decoded, so given element has no coordinates or
+/// members and only its type, id and tags can be used.
+class ElementPrefilter
+{
+public:
+    /// Returns false if element is not going to be used by visitor.
+    virtual bool accepts(const utymap::entities::Element& element) = 0;
+
+    virtual ~ElementPrefilter() = default;
+
+    /// Returns prefilter implemented by visitor or null.
+    static ElementPrefilter* of(utymap::entities::ElementVisitor& visitor)
+    {
+        return dynamic_cast<ElementPrefilter*>(&visitor);
+    }
+};
+
+}}
+
+#endif // INDEX_ELEMENTPREFILTER_HPP_DEFINED
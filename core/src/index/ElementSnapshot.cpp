@@ -0,0 +1,399 @@
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "index/ElementSnapshot.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/VarintUtils.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::entities;
+using namespace utymap::index;
+using namespace utymap::utils;
+
+namespace {
+    ///                                     Snapshot file format
+    ///------------------------------------------------------------------------------------------------------|
+    ///   DESCRIPTION    |                       DETAILS                                                     |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Header       |  Magic (4b)                                                                       |
+    ///------------------------------------------------------------------------------------------------------|
+    ///    Elements      |  List of entries, each is represented by element id (varint) and element          |
+    ///------------------------------------------------------------------------------------------------------|
+    ///  String table    |  Amount of strings (varint), each is represented by its size (varint) and data    |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Footer       |  Offset of string table (8b) and magic (4b)                                       |
+    ///------------------------------------------------------------------------------------------------------|
+    /// Element: type (1b: 0 - Node, 1 - Way, 2 - Area, 3 - Relation), tags as amount and key-value pairs of
+    /// snapshot string indices (varints), then coordinates as amount and fixed point (1e-7 degree) zigzag
+    /// varint deltas or, for relation, amount of members and member entries in the same format.
+    const std::uint32_t SnapshotMagic = 0x31535455;
+    const std::size_t FooterSize = sizeof(std::uint64_t) + sizeof(std::uint32_t);
+    const double CoordinatePrecision = 1E7;
+
+    /// Converts coordinate component to fixed point representation.
+    inline std::int64_t toFixed(double value)
+    {
+        return static_cast<std::int64_t>(std::llround(value * CoordinatePrecision));
+    }
+
+    /// Encodes element to buffer replacing string ids with snapshot string indices.
+    class SnapshotEncoder final : public ElementVisitor
+    {
+    public:
+        SnapshotEncoder(std::string& buffer, std::unordered_map<std::uint32_t, std::uint32_t>& indices,
+                        std::vector<std::uint32_t>& strings) :
+            buffer_(buffer), indices_(indices), strings_(strings)
+        {
+        }
+
+        void visitNode(const Node& node) override
+        {
+            buffer_.push_back(0);
+            writeTags(node.tags);
+            writeCoordinates(&node.coordinate, &node.coordinate + 1);
+        }
+
+        void visitWay(const Way& way) override
+        {
+            buffer_.push_back(1);
+            writeTags(way.tags);
+            writeCoordinates(way.coordinates.data(), way.coordinates.data() + way.coordinates.size());
+        }
+
+        void visitArea(const Area& area) override
+        {
+            buffer_.push_back(2);
+            writeTags(area.tags);
+            writeCoordinates(area.coordinates.data(), area.coordinates.data() + area.coordinates.size());
+        }
+
+        void visitRelation(const Relation& relation) override
+        {
+            buffer_.push_back(3);
+            writeTags(relation.tags);
+            writeVarint(buffer_, relation.elements.size());
+            for (const auto& element : relation.elements) {
+                writeVarint(buffer_, element->id);
+                element->accept(*this);
+            }
+        }
+
+    private:
+        void writeTags(const std::vector<Tag>& tags)
+        {
+            writeVarint(buffer_, tags.size());
+            for (const auto& tag : tags) {
+                writeVarint(buffer_, getIndex(tag.key));
+                writeVarint(buffer_, getIndex(tag.value));
+            }
+        }
+
+        void writeCoordinates(const GeoCoordinate* begin, const GeoCoordinate* end)
+        {
+            writeVarint(buffer_, static_cast<std::uint64_t>(end - begin));
+            std::int64_t latitude = 0, longitude = 0;
+            for (; begin != end; ++begin) {
+                std::int64_t currentLatitude = toFixed(begin->latitude);
+                std::int64_t currentLongitude = toFixed(begin->longitude);
+                writeVarint(buffer_, zigzag(currentLatitude - latitude));
+                writeVarint(buffer_, zigzag(currentLongitude - longitude));
+                latitude = currentLatitude;
+                longitude = currentLongitude;
+            }
+        }
+
+        std::uint32_t getIndex(std::uint32_t id)
+        {
+            auto indexPair = indices_.emplace(id, static_cast<std::uint32_t>(strings_.size()));
+            if (indexPair.second)
+                strings_.push_back(id);
+            return indexPair.first->second;
+        }
+
+        std::string& buffer_;
+        std::unordered_map<std::uint32_t, std::uint32_t>& indices_;
+        std::vector<std::uint32_t>& strings_;
+    };
+
+    /// Decodes elements from mapped snapshot data.
+    class SnapshotDecoder final
+    {
+    public:
+        SnapshotDecoder(const char* data, std::size_t size) :
+            data_(data), size_(size), position_(0), ids_()
+        {
+        }
+
+        /// Reads string table at given offset and maps its strings to ids.
+        void readStrings(std::size_t offset, StringTable& stringTable)
+        {
+            position_ = offset;
+            std::size_t count = static_cast<std::size_t>(readVarint());
+            std::vector<std::string> strings;
+            strings.reserve(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                std::size_t length = static_cast<std::size_t>(readVarint());
+                if (position_ + length > size_)
+                    throw std::domain_error("Unexpected end of snapshot.");
+                strings.emplace_back(data_ + position_, length);
+                position_ += length;
+            }
+
+            std::vector<const char*> values;
+            values.reserve(strings.size());
+            for (const auto& string : strings)
+                values.push_back(string.c_str());
+            ids_ = stringTable.getIds(values);
+        }
+
+        /// Reads elements between given offsets.
+        void readElements(std::size_t begin, std::size_t end, const std::function<bool(Element&)>& functor)
+        {
+            position_ = begin;
+            while (position_ < end) {
+                std::uint64_t id = readVarint();
+                auto element = readElement();
+                element->id = id;
+                functor(*element);
+            }
+        }
+
+    private:
+        std::shared_ptr<Element> readElement()
+        {
+            std::uint8_t type = read();
+            if (type == 0) {
+                auto node = std::make_shared<Node>();
+                node->tags = readTags();
+                auto coordinates = readCoordinates();
+                if (coordinates.size() != 1)
+                    throw std::domain_error("Invalid node in snapshot.");
+                node->coordinate = coordinates[0];
+                return node;
+            }
+            if (type == 1) {
+                auto way = std::make_shared<Way>();
+                way->tags = readTags();
+                way->coordinates = readCoordinates();
+                return way;
+            }
+            if (type == 2) {
+                auto area = std::make_shared<Area>();
+                area->tags = readTags();
+                area->coordinates = readCoordinates();
+                return area;
+            }
+            if (type == 3) {
+                auto relation = std::make_shared<Relation>();
+                relation->tags = readTags();
+                std::size_t count = static_cast<std::size_t>(readVarint());
+                relation->elements.reserve(count);
+                for (std::size_t i = 0; i < count; ++i) {
+                    std::uint64_t id = readVarint();
+                    auto element = readElement();
+                    element->id = id;
+                    relation->elements.push_back(element);
+                }
+                return relation;
+            }
+            throw std::domain_error("Unknown element type in snapshot.");
+        }
+
+        std::vector<Tag> readTags()
+        {
+            std::size_t count = static_cast<std::size_t>(readVarint());
+            std::vector<Tag> tags;
+            tags.reserve(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                std::uint32_t key = getId(readVarint());
+                std::uint32_t value = getId(readVarint());
+                tags.push_back(Tag(key, value));
+            }
+            // NOTE: ids differ from ones used on write, so tags should be sorted again.
+            std::sort(tags.begin(), tags.end());
+            return tags;
+        }
+
+        std::vector<GeoCoordinate> readCoordinates()
+        {
+            std::size_t count = static_cast<std::size_t>(readVarint());
+            std::vector<GeoCoordinate> coordinates;
+            coordinates.reserve(count);
+            std::int64_t latitude = 0, longitude = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                latitude += unzigzag(readVarint());
+                longitude += unzigzag(readVarint());
+                coordinates.push_back(GeoCoordinate(latitude / CoordinatePrecision, longitude / CoordinatePrecision));
+            }
+            return coordinates;
+        }
+
+        std::uint32_t getId(std::uint64_t index) const
+        {
+            if (index >= ids_.size())
+                throw std::domain_error("Invalid string index in snapshot.");
+            return ids_[static_cast<std::size_t>(index)];
+        }
+
+        std::uint64_t readVarint()
+        {
+            std::uint64_t value;
+            if (!utymap::utils::readVarint(data_, size_, position_, value))
+                throw std::domain_error("Invalid varint in snapshot.");
+            return value;
+        }
+
+        std::uint8_t read()
+        {
+            if (position_ >= size_)
+                throw std::domain_error("Unexpected end of snapshot.");
+            return static_cast<std::uint8_t>(data_[position_++]);
+        }
+
+        const char* data_;
+        std::size_t size_;
+        std::size_t position_;
+        std::vector<std::uint32_t> ids_;
+    };
+}
+
+class ElementSnapshotWriter::ElementSnapshotWriterImpl final
+{
+    /// Max amount of bytes kept in buffer before it is written to file.
+    static const std::size_t BufferSize = 1024 * 1024;
+
+public:
+    ElementSnapshotWriterImpl(const std::string& path, const StringTable& stringTable) :
+        stringTable_(stringTable),
+        file_(path, std::ios::out | std::ios::binary | std::ios::trunc),
+        buffer_(), indices_(), strings_(), offset_(0), isFinished_(false)
+    {
+        if (!file_.good())
+            throw std::domain_error("Cannot create snapshot file: " + path);
+        buffer_.append(reinterpret_cast<const char*>(&SnapshotMagic), sizeof(SnapshotMagic));
+    }
+
+    void add(const Element& element)
+    {
+        if (isFinished_)
+            throw std::domain_error("Snapshot is already finished.");
+
+        writeVarint(buffer_, element.id);
+        SnapshotEncoder encoder(buffer_, indices_, strings_);
+        element.accept(encoder);
+        if (buffer_.size() >= BufferSize)
+            flush();
+    }
+
+    void finish()
+    {
+        if (isFinished_)
+            return;
+        isFinished_ = true;
+
+        flush();
+        std::uint64_t stringsOffset = offset_;
+        writeVarint(buffer_, strings_.size());
+        for (auto id : strings_) {
+            std::string string = stringTable_.getString(id);
+            writeVarint(buffer_, string.size());
+            buffer_.append(string);
+            if (buffer_.size() >= BufferSize)
+                flush();
+        }
+        buffer_.append(reinterpret_cast<const char*>(&stringsOffset), sizeof(stringsOffset));
+        buffer_.append(reinterpret_cast<const char*>(&SnapshotMagic), sizeof(SnapshotMagic));
+        flush();
+        file_.close();
+        if (file_.fail())
+            throw std::domain_error("Cannot write snapshot file.");
+    }
+
+private:
+    void flush()
+    {
+        file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        offset_ += buffer_.size();
+        buffer_.clear();
+    }
+
+    const StringTable& stringTable_;
+    std::ofstream file_;
+    std::string buffer_;
+    /// Maps string ids to indices of snapshot string table.
+    std::unordered_map<std::uint32_t, std::uint32_t> indices_;
+    std::vector<std::uint32_t> strings_;
+    std::uint64_t offset_;
+    bool isFinished_;
+};
+
+ElementSnapshotWriter::ElementSnapshotWriter(const std::string& path, const StringTable& stringTable) :
+    pimpl_(utymap::utils::make_unique<ElementSnapshotWriterImpl>(path, stringTable))
+{
+}
+
+ElementSnapshotWriter::~ElementSnapshotWriter()
+{
+    try {
+        pimpl_->finish();
+    }
+    catch (...) {
+        // NOTE destructor must not throw: call finish explicitly to get errors.
+    }
+}
+
+void ElementSnapshotWriter::add(const Element& element)
+{
+    pimpl_->add(element);
+}
+
+void ElementSnapshotWriter::finish()
+{
+    pimpl_->finish();
+}
+
+bool ElementSnapshotReader::isSnapshot(const std::string& path)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    std::uint32_t magic = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    return file.good() && magic == SnapshotMagic;
+}
+
+void ElementSnapshotReader::read(const std::string& path, StringTable& stringTable,
+                                 const std::function<bool(Element&)>& functor)
+{
+    if (!isSnapshot(path))
+        throw std::domain_error("Invalid snapshot file: " + path);
+
+    using namespace boost::interprocess;
+    file_mapping mapping(path.c_str(), read_only);
+    mapped_region region(mapping, read_only);
+    const char* data = static_cast<const char*>(region.get_address());
+    std::size_t size = region.get_size();
+    if (size < sizeof(SnapshotMagic) + FooterSize)
+        throw std::domain_error("Invalid snapshot file: " + path);
+
+    std::uint64_t stringsOffset;
+    std::uint32_t magic;
+    std::memcpy(&stringsOffset, data + size - FooterSize, sizeof(stringsOffset));
+    std::memcpy(&magic, data + size - sizeof(magic), sizeof(magic));
+    if (magic != SnapshotMagic || stringsOffset < sizeof(SnapshotMagic) || stringsOffset > size - FooterSize)
+        throw std::domain_error("Snapshot file is not finished: " + path);
+
+    SnapshotDecoder decoder(data, size - FooterSize);
+    decoder.readStrings(static_cast<std::size_t>(stringsOffset), stringTable);
+    decoder.readElements(sizeof(SnapshotMagic), static_cast<std::size_t>(stringsOffset), functor);
+}
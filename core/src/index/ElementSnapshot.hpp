@@ -0,0 +1,54 @@
+#ifndef INDEX_ELEMENTSNAPSHOT_HPP_DEFINED
+#define INDEX_ELEMENTSNAPSHOT_HPP_DEFINED
+
+#include "entities/Element.hpp"
+#include "index/StringTable.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace utymap { namespace index {
+
+/// Writes resolved elements to binary snapshot file which can be imported instead of source data,
+/// so parsing and relation assembly are skipped. Snapshot has own string table, so it does not
+/// depend on string ids of the string table used to import it.
+class ElementSnapshotWriter final
+{
+public:
+    ElementSnapshotWriter(const std::string& path, const utymap::index::StringTable& stringTable);
+
+    ElementSnapshotWriter(const ElementSnapshotWriter&) = delete;
+    ElementSnapshotWriter& operator=(const ElementSnapshotWriter&) = delete;
+
+    /// Finishes snapshot if it is not finished yet.
+    ~ElementSnapshotWriter();
+
+    /// Appends element to snapshot.
+    void add(const utymap::entities::Element& element);
+
+    /// Writes string table and closes file. No elements can be added after that.
+    void finish();
+
+private:
+    class ElementSnapshotWriterImpl;
+    std::unique_ptr<ElementSnapshotWriterImpl> pimpl_;
+};
+
+/// Reads elements of snapshot file using memory mapping.
+class ElementSnapshotReader final
+{
+public:
+    /// Checks whether file at given path is snapshot.
+    static bool isSnapshot(const std::string& path);
+
+    /// Reads all elements of snapshot calling functor for each of them. Strings are mapped
+    /// to ids of given string table once per snapshot.
+    static void read(const std::string& path,
+                     utymap::index::StringTable& stringTable,
+                     const std::function<bool(utymap::entities::Element&)>& functor);
+};
+
+}}
+
+#endif // INDEX_ELEMENTSNAPSHOT_HPP_DEFINED
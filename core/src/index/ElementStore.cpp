@@ -1,5 +1,7 @@
 #include "BoundingBox.hpp"
 #include "QuadKey.hpp"
+#include "entities/BoundingBoxVisitor.hpp"
+#include "entities/ElementDispatch.hpp"
 #include "entities/Element.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
@@ -7,6 +9,16 @@
 #include "entities/Relation.hpp"
 #include "formats/FormatTypes.hpp"
 #include "index/ElementGeometryClipper.hpp"
+#include "index/ElementStore.hpp"
+#include "index/PolygonSplitter.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/GeometryUtils.hpp"
+#include "utils/TaskScheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
 
 using namespace utymap;
 using namespace utymap::entities;
@@ -17,53 +29,301 @@ namespace {
     const std::string ClipKey = "clip";
     const std::string SkipKey = "skip";
     const std::string SizeKey = "size";
+    const std::string SimplifyKey = "simplify";
+    const std::string SplitVerticesKey = "split-vertices";
+    /// Min amount of tiles per thread to clip element concurrently.
+    const std::size_t MinTilesPerThread = 4;
+    /// Region which does not restrict clipped tiles.
+    const utymap::BoundingBox WorldBoundingBox(utymap::GeoCoordinate(-90, -180), utymap::GeoCoordinate(90, 180));
 
-    /// Creates bounding box of given element.
-    class BoundingBoxVisitor : public ElementVisitor
+    /// Passes to visitor only elements with given id.
+    class IdFilterVisitor final : public ElementVisitor
     {
     public:
-        BoundingBox boundingBox;
-
-        void visitNode(const Node& node) override
+        IdFilterVisitor(std::uint64_t id, ElementVisitor& visitor) :
+            id_(id), visitor_(visitor)
         {
-            boundingBox.expand(node.coordinate);
         }
 
-        void visitWay(const Way& way) override
+        void visitNode(const Node& node) override { visitIfNecessary(node); }
+
+        void visitWay(const Way& way) override { visitIfNecessary(way); }
+
+        void visitArea(const Area& area) override { visitIfNecessary(area); }
+
+        void visitRelation(const Relation& relation) override { visitIfNecessary(relation); }
+
+    private:
+        template <typename T>
+        void visitIfNecessary(const T& element)
         {
-            boundingBox.expand(way.coordinates.cbegin(), way.coordinates.cend());
+            if (element.id == id_)
+                utymap::entities::visit(element, visitor_);
         }
 
-        void visitArea(const Area& area) override
+        const std::uint64_t id_;
+        ElementVisitor& visitor_;
+    };
+
+    /// Passes to visitor only elements which have all given tags.
+    class TagFilterVisitor final : public ElementVisitor
+    {
+    public:
+        TagFilterVisitor(const std::vector<utymap::entities::Tag>& tags, ElementVisitor& visitor) :
+            tags_(tags), visitor_(visitor)
         {
-            boundingBox.expand(area.coordinates.cbegin(), area.coordinates.cend());
         }
 
-        void visitRelation(const Relation& relation) override
+        void visitNode(const Node& node) override { visitIfNecessary(node); }
+
+        void visitWay(const Way& way) override { visitIfNecessary(way); }
+
+        void visitArea(const Area& area) override { visitIfNecessary(area); }
+
+        void visitRelation(const Relation& relation) override { visitIfNecessary(relation); }
+
+    private:
+        template <typename T>
+        void visitIfNecessary(const T& element)
         {
-            for (const auto& element: relation.elements) {
-                element->accept(*this);
+            for (const auto& tag : tags_) {
+                if (std::none_of(element.tags.begin(), element.tags.end(), [&](const utymap::entities::Tag& elementTag) {
+                    return elementTag.key == tag.key && elementTag.value == tag.value;
+                }))
+                    return;
             }
+            utymap::entities::visit(element, visitor_);
         }
+
+        const std::vector<utymap::entities::Tag>& tags_;
+        ElementVisitor& visitor_;
     };
 
-    bool checkSize(const utymap::BoundingBox& quadKeyBBox, const utymap::BoundingBox& elementBbox, double minSize) {
-        return elementBbox.width() / quadKeyBBox.width() > minSize;
+    bool checkSize(int levelOfDetail, const utymap::BoundingBox& elementBbox, double minSize) {
+        return elementBbox.width() / utymap::utils::GeoUtils::getTileWidth(levelOfDetail) > minSize;
     }
+
+    /// Creates simplified copy of way or area. Areas which would change orientation or become
+    /// self intersecting are kept as they are.
+    struct ElementSimplifier final : public ElementVisitor
+    {
+        explicit ElementSimplifier(double tolerance) : tolerance(tolerance), result() {}
+
+        void visitNode(const Node&) override {}
+
+        void visitWay(const Way& way) override
+        {
+            std::vector<GeoCoordinate> coordinates;
+            if (utymap::utils::simplifyPath(way.coordinates, tolerance, false, coordinates))
+                result = copy(way, coordinates);
+        }
+
+        void visitArea(const Area& area) override
+        {
+            std::vector<GeoCoordinate> coordinates;
+            if (utymap::utils::simplifyPath(area.coordinates, tolerance, true, coordinates) &&
+                utymap::utils::isClockwise(coordinates) == utymap::utils::isClockwise(area.coordinates) &&
+                utymap::utils::isSimplePolygon(coordinates))
+                result = copy(area, coordinates);
+        }
+
+        // NOTE relation members are not simplified as their rings might start to intersect each other.
+        void visitRelation(const Relation&) override {}
+
+        const double tolerance;
+        /// Simplified element or null if element is not changed.
+        std::shared_ptr<Element> result;
+
+    private:
+        template <typename T>
+        static std::shared_ptr<Element> copy(const T& element, std::vector<GeoCoordinate>& coordinates)
+        {
+            auto simplified = std::make_shared<T>();
+            simplified->id = element.id;
+            simplified->tags = element.tags;
+            simplified->coordinates.swap(coordinates);
+            return simplified;
+        }
+    };
 }
 
 namespace utymap { namespace index {
 
 ElementStore::ElementStore(StringTable& stringTable) :
+    stringTable_(stringTable),
     clipKeyId_(stringTable.getId(ClipKey)),
     skipKeyId_(stringTable.getId(SkipKey)),
-    sizeKeyId_(stringTable.getId(SizeKey))
+    sizeKeyId_(stringTable.getId(SizeKey)),
+    simplifyKeyId_(stringTable.getId(SimplifyKey)),
+    splitVerticesKeyId_(stringTable.getId(SplitVerticesKey)),
+    concurrency_(1),
+    profile_(),
+    nameIndex_(),
+    idIndex_()
+{
+}
+
+ElementStore::~ElementStore()
+{
+}
+
+std::vector<NameIndex::Match> ElementStore::searchByName(const std::string& prefix, const GeoCoordinate& coordinate, std::size_t maxResults) const
+{
+    return nameIndex_ != nullptr
+        ? nameIndex_->find(prefix, coordinate, maxResults)
+        : std::vector<NameIndex::Match>();
+}
+
+NameIndex& ElementStore::enableNameIndex()
+{
+    if (nameIndex_ == nullptr)
+        nameIndex_ = utymap::utils::make_unique<NameIndex>(stringTable_);
+    return *nameIndex_;
+}
+
+std::vector<QuadKey> ElementStore::findQuadKeys(std::uint64_t id) const
+{
+    return idIndex_ != nullptr ? idIndex_->find(id) : std::vector<QuadKey>();
+}
+
+ElementIdIndex& ElementStore::enableIdIndex()
+{
+    if (idIndex_ == nullptr)
+        idIndex_ = utymap::utils::make_unique<ElementIdIndex>();
+    return *idIndex_;
+}
+
+void ElementStore::setConcurrency(std::size_t threadCount)
+{
+    concurrency_ = threadCount > 0 ? threadCount : 1;
+}
+
+void ElementStore::setImportProfile(const std::shared_ptr<ImportProfile>& profile)
+{
+    std::atomic_store(&profile_, profile);
+}
+
+void ElementStore::checkPersistentStrings(const Element& element) const
+{
+    for (const auto& tag : element.tags) {
+        if (!stringTable_.isPersistent(tag.key) || !stringTable_.isPersistent(tag.value))
+            throw std::domain_error("Cannot persist string which is not in shared string table: " +
+                                    stringTable_.getString(stringTable_.isPersistent(tag.key) ? tag.value : tag.key));
+    }
+    if (element.type == ElementType::Relation) {
+        for (const auto& member : static_cast<const Relation&>(element).elements)
+            checkPersistentStrings(*member);
+    }
+}
+
+void ElementStore::addWrittenBytes(const QuadKey& quadKey, std::size_t bytes)
+{
+    auto profile = std::atomic_load(&profile_);
+    if (profile != nullptr)
+        profile->addBytes(quadKey, bytes);
+}
+
+void ElementStore::storeFragment(const Element& element, const QuadKey& quadKey, const Style& style,
+                                 const StyleFingerprint& fingerprint)
+{
+    auto profile = std::atomic_load(&profile_);
+    if (profile != nullptr)
+        profile->addFragment(quadKey);
+    storeImpl(element, quadKey, style);
+    // NOTE elements without id cannot be distinguished.
+    if (element.id != 0) {
+        storeFingerprint(element.id, quadKey, fingerprint);
+        if (idIndex_ != nullptr)
+            idIndex_->add(element.id, quadKey);
+    }
+}
+
+void ElementStore::storeFragments(const Element& element, const std::vector<QuadKey>& quadKeys, const Style& style,
+                                  const StyleFingerprint& fingerprint)
+{
+    if (quadKeys.size() == 1) {
+        storeFragment(element, quadKeys.front(), style, fingerprint);
+        return;
+    }
+
+    auto profile = std::atomic_load(&profile_);
+    if (profile != nullptr) {
+        for (const auto& quadKey : quadKeys)
+            profile->addFragment(quadKey);
+    }
+    storeSharedImpl(element, quadKeys, style);
+    if (element.id != 0) {
+        for (const auto& quadKey : quadKeys) {
+            storeFingerprint(element.id, quadKey, fingerprint);
+            if (idIndex_ != nullptr)
+                idIndex_->add(element.id, quadKey);
+        }
+    }
+}
+
+void ElementStore::storeSharedImpl(const Element& element, const std::vector<QuadKey>& quadKeys, const Style& style)
+{
+    for (const auto& quadKey : quadKeys)
+        storeImpl(element, quadKey, style);
+}
+
+void ElementStore::remove(std::uint64_t id, const BoundingBox& bbox, const utymap::LodRange& range)
+{
+    if (nameIndex_ != nullptr)
+        nameIndex_->remove(id);
+
+    // NOTE element is removed from tiles where it is indexed: its stored geometry is unknown.
+    if (!bbox.isValid()) {
+        if (idIndex_ == nullptr)
+            return;
+        for (const auto& quadKey : idIndex_->find(id)) {
+            if (quadKey.levelOfDetail < range.start || quadKey.levelOfDetail > range.end || !hasData(quadKey))
+                continue;
+            removeImpl(id, quadKey);
+            idIndex_->remove(id, quadKey);
+        }
+        return;
+    }
+
+    for (int lod = range.start; lod <= range.end; ++lod) {
+        utymap::utils::GeoUtils::visitTileRange(bbox, lod, [&](const QuadKey& quadKey, const BoundingBox&) {
+            if (!hasData(quadKey))
+                return;
+            removeImpl(id, quadKey);
+            if (idIndex_ != nullptr)
+                idIndex_->remove(id, quadKey);
+        });
+    }
+}
+
+bool ElementStore::update(const Element& element, const utymap::LodRange& range, const StyleProvider& styleProvider)
+{
+    BoundingBoxVisitor bboxVisitor;
+    utymap::entities::visit(element, bboxVisitor);
+    remove(element.id, bboxVisitor.boundingBox, range);
+    return store(element, range, styleProvider);
+}
+
+void ElementStore::search(const QuadKey& quadKey, const BoundingBox&, ElementVisitor& visitor)
+{
+    search(quadKey, visitor);
+}
+
+void ElementStore::searchById(const QuadKey& quadKey, std::uint64_t id, ElementVisitor& visitor)
+{
+    IdFilterVisitor filter(id, visitor);
+    search(quadKey, filter);
+}
+
+void ElementStore::searchByTag(const QuadKey& quadKey, const BoundingBox& bbox, const std::vector<utymap::entities::Tag>& tags, ElementVisitor& visitor)
 {
+    TagFilterVisitor filter(tags, visitor);
+    search(quadKey, bbox, filter);
 }
 
 bool ElementStore::store(const Element& element, const utymap::LodRange& range, const StyleProvider& styleProvider)
 {
-    return store(element, range, styleProvider, [&](const BoundingBox&, const BoundingBox&) {
+    return store(element, range, styleProvider, WorldBoundingBox, [&](const BoundingBox&, const BoundingBox&) {
         return true;
     });
 }
@@ -71,9 +331,12 @@ bool ElementStore::store(const Element& element, const utymap::LodRange& range,
 bool ElementStore::store(const Element& element, const QuadKey& quadKey, const StyleProvider& styleProvider)
 {
     const BoundingBox expectedQuadKeyBbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey);
+    // NOTE center of quadkey lies on border of no other tile, so only its ancestors are clipped.
+    const GeoCoordinate center = expectedQuadKeyBbox.center();
     return store(element, 
                 LodRange(quadKey.levelOfDetail, quadKey.levelOfDetail), 
                 styleProvider, 
+                BoundingBox(center, center),
                 [&](const BoundingBox& elementBoundingBox, const BoundingBox& quadKeyBbox) {
                     return elementBoundingBox.intersects(expectedQuadKeyBbox) &&
                            expectedQuadKeyBbox.center() == quadKeyBbox.center();
@@ -82,51 +345,183 @@ bool ElementStore::store(const Element& element, const QuadKey& quadKey, const S
 
 bool ElementStore::store(const Element& element, const BoundingBox& bbox, const utymap::LodRange& range, const StyleProvider& styleProvider)
 {
-    return store(element, range, styleProvider, [&](const BoundingBox& elementBoundingBox, const BoundingBox& quadKeyBbox) {
+    return store(element, range, styleProvider, WorldBoundingBox, [&](const BoundingBox& elementBoundingBox, const BoundingBox& quadKeyBbox) {
         return elementBoundingBox.intersects(bbox);
     });
 }
 
 template <typename Visitor>
-bool ElementStore::store(const Element& element, const LodRange& range, const StyleProvider& styleProvider, const Visitor& visitor)
+bool ElementStore::store(const Element& element, const LodRange& range, const StyleProvider& styleProvider,
+                         const BoundingBox& region, const Visitor& visitor)
 {
     BoundingBoxVisitor bboxVisitor;
-    using namespace std::placeholders;
-    ElementGeometryClipper geometryClipper(std::bind(&ElementStore::storeImpl, this, _1, _2));
+    auto profile = std::atomic_load(&profile_);
+    if (profile != nullptr)
+        profile->addElement(element);
     bool wasStored = false;
     double size = -1; // match all by default
+    // NOTE styles of clipped levels are kept to clip all of them in one sweep.
+    std::vector<const Style*> clipStyles(range.end - range.start + 1, nullptr);
+    std::vector<StyleFingerprint> fingerprints(range.end - range.start + 1);
+    // NOTE simplified levels have own geometry, so they are clipped separately.
+    std::vector<std::shared_ptr<Element>> simplifiedElements(range.end - range.start + 1);
+    int clipStart = range.end + 1, clipEnd = range.start - 1;
+    // NOTE not clipped element is stored in all tiles of level at once.
+    std::vector<QuadKey> quadKeys;
+    // NOTE styles are built once for all range.
+    LodStyles lodStyles = styleProvider.forElement(element, range);
+    std::uint64_t fingerprintVersion = styleProvider.getFingerprintVersion();
     for (int lod = range.start; lod <= range.end; ++lod) {
-        if (!styleProvider.hasStyle(element, lod))
+        int styleIndex = lodStyles.indices[lod - range.start];
+        if (styleIndex < 0)
             continue;
-        Style style = styleProvider.forElement(element, lod);
+        const Style& style = lodStyles.styles[styleIndex];
+        const StyleFingerprint fingerprint = { fingerprintVersion, lodStyles.fingerprints[styleIndex] };
+        fingerprints[lod - range.start] = fingerprint;
         if (style.has(skipKeyId_, "true")) continue;
 
         // initialize bounding box and size only once
         if (!bboxVisitor.boundingBox.isValid()) {
-            element.accept(bboxVisitor);
+            utymap::entities::visit(element, bboxVisitor);
             // read size if present
             if (style.has(sizeKeyId_))
                 size = style.getValue(sizeKeyId_, 1, bboxVisitor.boundingBox.center());
         }
 
-         utymap::utils::GeoUtils::visitTileRange(bboxVisitor.boundingBox, lod,
-                                                 [&](const QuadKey& quadKey, const BoundingBox& quadKeyBbox) {
-             if (!visitor(bboxVisitor.boundingBox, quadKeyBbox) ||
-                 !checkSize(quadKeyBbox, bboxVisitor.boundingBox, size)) // can be optimized (quadkey widht is const for lod)
-                 return;
+        // NOTE tile width is the same for all tiles of level.
+        if (!checkSize(lod, bboxVisitor.boundingBox, size))
+            continue;
 
-            if (style.has(clipKeyId_, "true"))
-                geometryClipper.clipAndCall(element, quadKey, quadKeyBbox);
-            else
-                storeImpl(element, quadKey);
+        // NOTE percent tolerance is relative to tile width of level.
+        const Element* levelElement = &element;
+        if (style.has(simplifyKeyId_)) {
+            ElementSimplifier simplifier(style.getValue(simplifyKeyId_, utymap::utils::GeoUtils::getTileWidth(lod),
+                                                        bboxVisitor.boundingBox.center()));
+            element.accept(simplifier);
+            simplifiedElements[lod - range.start] = simplifier.result;
+            if (simplifier.result != nullptr)
+                levelElement = simplifier.result.get();
+        }
 
-            wasStored = true;
+        if (style.has(clipKeyId_, "true")) {
+            clipStyles[lod - range.start] = &style;
+            if (levelElement == &element) {
+                clipStart = std::min(clipStart, lod);
+                clipEnd = std::max(clipEnd, lod);
+            }
+            continue;
+        }
+
+        quadKeys.clear();
+        utymap::utils::GeoUtils::visitTileRange(bboxVisitor.boundingBox, lod,
+                                                [&](const QuadKey& quadKey, const BoundingBox& quadKeyBbox) {
+            if (visitor(bboxVisitor.boundingBox, quadKeyBbox))
+                quadKeys.push_back(quadKey);
         });
 
+        if (!quadKeys.empty()) {
+            storeFragments(*levelElement, quadKeys, style, fingerprint);
+            wasStored = true;
+        }
+    }
+
+    const BoundingBox& elementBbox = bboxVisitor.boundingBox;
+    std::atomic<bool> wasClipped(false);
+    ElementGeometryClipper::Callback callback = [&](const Element& clippedElement, const QuadKey& quadKey) {
+        int index = quadKey.levelOfDetail - range.start;
+        const Style& style = *clipStyles[index];
+        // NOTE large polygons are stored as pieces, so builders do not process them at once.
+        if (style.has(splitVerticesKeyId_)) {
+            PolygonSplitter splitter(static_cast<std::size_t>(style.getValue(splitVerticesKeyId_)));
+            auto pieces = splitter.split(clippedElement, quadKey);
+            if (pieces != nullptr) {
+                storeFragment(*pieces, quadKey, style, fingerprints[index]);
+                wasClipped = true;
+                return;
+            }
+        }
+        storeFragment(clippedElement, quadKey, style, fingerprints[index]);
+        wasClipped = true;
+    };
+
+    // NOTE levels with original geometry are clipped in one sweep.
+    if (clipStart <= clipEnd) {
+        clip(element, LodRange(clipStart, clipEnd), elementBbox, region,
+             [&](const QuadKey& quadKey, const BoundingBox& quadKeyBbox) {
+                 int index = quadKey.levelOfDetail - range.start;
+                 return clipStyles[index] != nullptr && simplifiedElements[index] == nullptr &&
+                        visitor(elementBbox, quadKeyBbox);
+             }, callback);
+    }
+
+    for (int lod = range.start; lod <= range.end; ++lod) {
+        int index = lod - range.start;
+        if (clipStyles[index] == nullptr || simplifiedElements[index] == nullptr)
+            continue;
+        clip(*simplifiedElements[index], LodRange(lod, lod), elementBbox, region,
+             [&](const QuadKey&, const BoundingBox& quadKeyBbox) {
+                 return visitor(elementBbox, quadKeyBbox);
+             }, callback);
     }
 
     // NOTE still might be clipped and then skipped
-    return wasStored;
+    bool isStored = wasStored || wasClipped;
+    if (isStored && nameIndex_ != nullptr && element.id != 0)
+        nameIndex_->add(element, bboxVisitor.boundingBox.center());
+    return isStored;
+}
+
+void ElementStore::clip(const Element& element,
+                        const LodRange& range,
+                        const BoundingBox& elementBbox,
+                        const BoundingBox& region,
+                        const ElementGeometryClipper::TileFilter& filter,
+                        const ElementGeometryClipper::Callback& callback)
+{
+    // NOTE collect tiles first to partition them between threads.
+    std::vector<std::pair<QuadKey, BoundingBox>> tiles;
+    if (concurrency_ > 1) {
+        utymap::utils::GeoUtils::visitTileRange(elementBbox, range.start,
+                                                [&](const QuadKey& quadKey, const BoundingBox& quadKeyBbox) {
+            if (quadKeyBbox.intersects(region))
+                tiles.push_back(std::make_pair(quadKey, quadKeyBbox));
+        });
+    }
+
+    if (tiles.size() < MinTilesPerThread * 2) {
+        // NOTE root tile covers the world: every level of range is derived from its parent.
+        QuadKey root(0, 0, 0);
+        ElementGeometryClipper geometryClipper(callback);
+        geometryClipper.clipAndCall(element, root, utymap::utils::GeoUtils::quadKeyToBoundingBox(root),
+                                    range, region, filter);
+    }
+    else
+        clipConcurrently(element, tiles, range, region, filter, callback);
+}
+
+void ElementStore::clipConcurrently(const Element& element,
+                                    const std::vector<std::pair<QuadKey, BoundingBox>>& tiles,
+                                    const LodRange& range,
+                                    const BoundingBox& region,
+                                    const ElementGeometryClipper::TileFilter& filter,
+                                    const ElementGeometryClipper::Callback& callback)
+{
+    std::size_t threadCount = std::min(concurrency_, tiles.size() / MinTilesPerThread);
+    std::atomic<std::size_t> next(0);
+
+    // NOTE tiles are taken one by one as clipping cost differs a lot between tiles.
+    auto worker = [&]() {
+        ElementGeometryClipper geometryClipper(callback);
+        for (std::size_t i = next++; i < tiles.size(); i = next++)
+            geometryClipper.clipAndCall(element, tiles[i].first, tiles[i].second, range, region, filter);
+    };
+
+    utymap::utils::TaskGroup workers;
+    for (std::size_t i = 1; i < threadCount; ++i)
+        workers.run(worker);
+
+    worker();
+    workers.wait();
 }
 
 }}
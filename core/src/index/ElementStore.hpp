@@ -6,9 +6,19 @@
 #include "entities/Element.hpp"
 #include "entities/ElementVisitor.hpp"
 #include "LodRange.hpp"
+#include "index/ElementIdIndex.hpp"
+#include "index/ImportProfile.hpp"
+#include "index/NameIndex.hpp"
+#include "index/StyleFingerprint.hpp"
 #include "mapcss/StyleProvider.hpp"
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace utymap { namespace index {
 
@@ -18,15 +28,63 @@ class ElementStore
 public:
     explicit ElementStore(utymap::index::StringTable& stringTable);
 
-    virtual ~ElementStore() = default;
+    virtual ~ElementStore();
 
     /// Searches for elements for given quadKey
     virtual void search(const utymap::QuadKey& quadKey,
                         utymap::entities::ElementVisitor& visitor) = 0;
 
+    /// Searches for elements of given quadKey which may intersect bounding box.
+    /// Stores without spatial index return all elements of quadkey.
+    virtual void search(const utymap::QuadKey& quadKey,
+                        const utymap::BoundingBox& bbox,
+                        utymap::entities::ElementVisitor& visitor);
+
+    /// Searches for elements of given quadkey which have all given tags and may intersect
+    /// bounding box. Stores without tag index filter all elements of quadkey.
+    virtual void searchByTag(const utymap::QuadKey& quadKey,
+                              const utymap::BoundingBox& bbox,
+                              const std::vector<utymap::entities::Tag>& tags,
+                              utymap::entities::ElementVisitor& visitor);
+
+    /// Searches for element with given id in given quadkey. Stores without id lookup
+    /// filter all elements of quadkey.
+    virtual void searchById(const utymap::QuadKey& quadKey,
+                            std::uint64_t id,
+                            utymap::entities::ElementVisitor& visitor);
+
+    /// Returns quadkeys where element with given id is stored ordered by level of detail.
+    /// Stores without id index return nothing.
+    std::vector<utymap::QuadKey> findQuadKeys(std::uint64_t id) const;
+
+    /// Finds stored elements which have name starting with given prefix ordered by distance
+    /// to coordinate. Stores without name index return nothing.
+    std::vector<NameIndex::Match> searchByName(const std::string& prefix,
+                                               const utymap::GeoCoordinate& coordinate,
+                                               std::size_t maxResults) const;
+
     /// Checks whether there is data for given quadkey.
     virtual bool hasData(const utymap::QuadKey& quadKey) const = 0;
 
+    /// Prepares data of given quadkey for coming search in background. Stores which keep data
+    /// locally do nothing.
+    virtual void prefetch(const utymap::QuadKey& quadKey) {}
+
+    /// Gets version of data of given quadkey which is the same in every process while data is
+    /// not changed, so results built from it can be persisted. By default, only quadkey without
+    /// data has such version: stores which keep data in memory cannot provide it.
+    virtual bool getDataVersion(const utymap::QuadKey& quadKey, std::uint64_t& version)
+    {
+        version = 0;
+        return !hasData(quadKey);
+    }
+
+    /// Finds style fingerprint recorded when element with given id was stored in quadkey.
+    /// Stores which do not keep fingerprints return false.
+    virtual bool findFingerprint(const utymap::QuadKey& quadKey,
+                                 std::uint64_t id,
+                                 StyleFingerprint& fingerprint) const { return false; }
+
     /// Stores element in storage in all affected tiles at given level of details range.
     bool store(const utymap::entities::Element& element, 
                const utymap::LodRange& range,
@@ -43,21 +101,121 @@ public:
                const utymap::LodRange& range,
                const utymap::mapcss::StyleProvider& styleProvider);
 
+    /// Removes element with given id from all tiles at given level of details range
+    /// which intersect bounding box. If bounding box is invalid, e.g. element geometry is unknown
+    /// or changed since it was stored, stores with id index remove it from all tiles of range
+    /// where it is indexed while other stores do nothing.
+    /// NOTE element ids should be unique across element types: osm ids are mapped by OsmElementId.
+    void remove(std::uint64_t id,
+                const utymap::BoundingBox& bbox,
+                const utymap::LodRange& range);
+
+    /// Replaces element with the same id in all tiles intersecting its bounding box. If element
+    /// geometry is moved away from some tiles, old version should be removed from them explicitly.
+    bool update(const utymap::entities::Element& element,
+                const utymap::LodRange& range,
+                const utymap::mapcss::StyleProvider& styleProvider);
+
     /// Commits changes done in element store.
     virtual void commit() = 0;
 
+    /// Rewrites stored data without removed elements. Stores which do not keep data of removed
+    /// elements do nothing.
+    virtual void compact() {}
+
+    /// Returns approximate amount of bytes kept in memory by stored elements.
+    virtual std::size_t getMemoryUsage() const { return 0; }
+
+    /// Sets amount of threads used to clip element into tiles of single level of detail.
+    /// If it is greater than one, storeImpl might be called concurrently.
+    void setConcurrency(std::size_t threadCount);
+
+    /// Sets profile which collects stored elements, fragments and written bytes. Null disables
+    /// profiling. Profile is shared by all operations, so it should be set only for single import.
+    /// Every operation keeps its own reference, so profile outlives operations still running
+    /// when it is replaced.
+    void setImportProfile(const std::shared_ptr<ImportProfile>& profile);
+
 protected:
-    /// Stores element in given quadkey.
-    virtual void storeImpl(const utymap::entities::Element& element, const utymap::QuadKey& quadKey) = 0;
+    /// Enables index of names of stored elements or returns enabled one. Removed elements are
+    /// dropped from it. Should be called by store which provides name search.
+    NameIndex& enableNameIndex();
+
+    /// Enables index of quadkeys where elements with id are stored or returns enabled one.
+    /// Should be called by store which provides element lookup by id.
+    ElementIdIndex& enableIdIndex();
+
+    /// Stores element in given quadkey. Style is the one used to store element at quadkey's level of detail.
+    virtual void storeImpl(const utymap::entities::Element& element,
+                           const utymap::QuadKey& quadKey,
+                           const utymap::mapcss::Style& style) = 0;
+
+    /// Stores the same element in several quadkeys of one level of detail. Stores which can keep
+    /// element once and reference it from quadkeys override it, by default it is stored in every quadkey.
+    virtual void storeSharedImpl(const utymap::entities::Element& element,
+                                 const std::vector<utymap::QuadKey>& quadKeys,
+                                 const utymap::mapcss::Style& style);
+
+    /// Records fingerprint of style used to store element with given id in quadkey.
+    virtual void storeFingerprint(std::uint64_t id,
+                                  const utymap::QuadKey& quadKey,
+                                  const StyleFingerprint& fingerprint) {}
+
+    /// Removes element with given id from quadkey which has data.
+    virtual void removeImpl(std::uint64_t id, const utymap::QuadKey& quadKey) = 0;
+
+    /// Throws domain_error if element or its members have tag strings which are known only to
+    /// this process, e.g. added to shared string table. Should be called by store which persists
+    /// string ids before element is written.
+    void checkPersistentStrings(const utymap::entities::Element& element) const;
+
+    /// Reports amount of bytes written by storeImpl to given quadkey for import profile.
+    void addWrittenBytes(const utymap::QuadKey& quadKey, std::size_t bytes);
 
 private:
     template <typename Visitor>
     bool store(const utymap::entities::Element& element,
                const utymap::LodRange& range,
                const utymap::mapcss::StyleProvider& styleProvider,
+               const utymap::BoundingBox& region,
                const Visitor& visitor);
 
-    std::uint32_t clipKeyId_, skipKeyId_, sizeKeyId_;
+    /// Clips element into all tiles of range which pass filter. Element bounding box defines
+    /// tiles which are distributed between threads.
+    void clip(const utymap::entities::Element& element,
+              const utymap::LodRange& range,
+              const utymap::BoundingBox& elementBbox,
+              const utymap::BoundingBox& region,
+              const std::function<bool(const utymap::QuadKey&, const utymap::BoundingBox&)>& filter,
+              const std::function<void(const utymap::entities::Element&, const utymap::QuadKey&)>& callback);
+
+    /// Clips element into given tiles and their descendants till range end using multiple threads.
+    void clipConcurrently(const utymap::entities::Element& element,
+                          const std::vector<std::pair<utymap::QuadKey, utymap::BoundingBox>>& tiles,
+                          const utymap::LodRange& range,
+                          const utymap::BoundingBox& region,
+                          const std::function<bool(const utymap::QuadKey&, const utymap::BoundingBox&)>& filter,
+                          const std::function<void(const utymap::entities::Element&, const utymap::QuadKey&)>& callback);
+
+    /// Stores element part in given quadkey counting it in import profile.
+    void storeFragment(const utymap::entities::Element& element,
+                       const utymap::QuadKey& quadKey,
+                       const utymap::mapcss::Style& style,
+                       const StyleFingerprint& fingerprint);
+
+    /// Stores not clipped element in given quadkeys of one level of detail.
+    void storeFragments(const utymap::entities::Element& element,
+                        const std::vector<utymap::QuadKey>& quadKeys,
+                        const utymap::mapcss::Style& style,
+                        const StyleFingerprint& fingerprint);
+
+    utymap::index::StringTable& stringTable_;
+    std::uint32_t clipKeyId_, skipKeyId_, sizeKeyId_, simplifyKeyId_, splitVerticesKeyId_;
+    std::size_t concurrency_;
+    /// Accessed by atomic_load and atomic_store only.
+    std::shared_ptr<ImportProfile> profile_;
+    std::unique_ptr<NameIndex> nameIndex_;
+    std::unique_ptr<ElementIdIndex> idIndex_;
 };
 
 }}
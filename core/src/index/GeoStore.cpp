@@ -1,32 +1,503 @@
 #include "entities/Element.hpp"
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "entities/BoundingBoxVisitor.hpp"
+#include "entities/ElementDispatch.hpp"
+#include "entities/ElementBatch.hpp"
 #include "LodRange.hpp"
 #include "formats/shape/ShapeDataVisitor.hpp"
 #include "formats/shape/ShapeParser.hpp"
 #include "formats/osm/xml/OsmXmlParser.hpp"
 #include "formats/osm/pbf/OsmPbfParser.hpp"
+#include "formats/osm/NodeReferenceVisitor.hpp"
+#include "formats/osm/OsmChangeVisitor.hpp"
 #include "formats/osm/OsmDataVisitor.hpp"
+#include "index/ElementPrefilter.hpp"
+#include "index/ElementSnapshot.hpp"
 #include "index/GeoStore.hpp"
 #include "index/InMemoryElementStore.hpp"
+#include "index/SearchControl.hpp"
+#include "utils/BoundedQueue.hpp"
 #include "utils/CoreUtils.hpp"
+#include "utils/GeoUtils.hpp"
+#include "utils/MathUtils.hpp"
+#include "utils/Statistics.hpp"
+#include "utils/TaskScheduler.hpp"
+#include "utils/TraceRecorder.hpp"
 
-#include <set>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <iomanip>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 using namespace utymap::entities;
 using namespace utymap::formats;
 using namespace utymap::index;
 using namespace utymap::mapcss;
+using namespace utymap::utils;
+
+namespace {
+    /// Max latitude supported by quadkey projection.
+    const double MaxLatitude = 85.05112878;
+
+    /// Max amount of elements passed between import stages at once.
+    const std::size_t ImportBatchSize = 256;
+
+    ///                                 Import checkpoint file format
+    ///------------------------------------------------------------------------------------------------------|
+    ///  Magic (4b), size of source file (8b), amount of stored snapshot elements (8b), start and end of   |
+    ///  level of details range (4b each), stylesheet hash (8b), store key size (4b) and key, source path  |
+    ///  size (4b) and path. Snapshot of source file is kept next to checkpoint till import is finished.   |
+    ///  Files are named by hash of store key and source path, so imports of different files or into       |
+    ///  different stores keep separate checkpoints.                                                         |
+    ///------------------------------------------------------------------------------------------------------|
+    const std::string CheckpointFilePrefix = "import.";
+    const std::string CheckpointFileExtension = ".chk";
+    const std::string CheckpointSnapshotExtension = ".uts";
+    const std::uint32_t CheckpointMagic = 0x32504B43;
+
+    /// Progress of checkpointed import.
+    struct ImportCheckpoint final
+    {
+        std::uint64_t sourceSize;
+        std::uint64_t elements;
+        std::int32_t startLod;
+        std::int32_t endLod;
+        std::uint64_t stylesheetHash;
+        std::string storeKey;
+        std::string sourcePath;
+
+        /// Checks whether progress is recorded for the same import.
+        bool isSameImport(const ImportCheckpoint& other) const
+        {
+            return sourceSize == other.sourceSize && startLod == other.startLod && endLod == other.endLod &&
+                   stylesheetHash == other.stylesheetHash && storeKey == other.storeKey && sourcePath == other.sourcePath;
+        }
+    };
+
+    std::uint64_t getFileSize(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+        return file.good() ? static_cast<std::uint64_t>(file.tellg()) : 0;
+    }
+
+    /// Gets name of checkpoint files without extension for import of source file into store.
+    std::string getCheckpointName(const std::string& storeKey, const std::string& sourcePath)
+    {
+        // NOTE FNV-1a: name should be the same when import is restarted by other process.
+        std::uint64_t hash = 14695981039346656037ull;
+        for (char c : storeKey + '\0' + sourcePath) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        std::ostringstream name;
+        name << CheckpointFilePrefix << std::hex << std::setw(16) << std::setfill('0') << hash;
+        return name.str();
+    }
+
+    bool readString(std::istream& stream, std::string& value)
+    {
+        std::uint32_t size = 0;
+        if (!stream.read(reinterpret_cast<char*>(&size), sizeof(size)))
+            return false;
+        value.resize(size);
+        return size == 0 || stream.read(&value[0], size);
+    }
+
+    void writeString(std::ostream& stream, const std::string& value)
+    {
+        std::uint32_t size = static_cast<std::uint32_t>(value.size());
+        stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        stream.write(value.data(), size);
+    }
+
+    /// Reads checkpoint from file. Returns false if there is no valid checkpoint.
+    bool readCheckpoint(const std::string& path, ImportCheckpoint& checkpoint)
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        std::uint32_t magic = 0;
+        file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        file.read(reinterpret_cast<char*>(&checkpoint.sourceSize), sizeof(checkpoint.sourceSize));
+        file.read(reinterpret_cast<char*>(&checkpoint.elements), sizeof(checkpoint.elements));
+        file.read(reinterpret_cast<char*>(&checkpoint.startLod), sizeof(checkpoint.startLod));
+        file.read(reinterpret_cast<char*>(&checkpoint.endLod), sizeof(checkpoint.endLod));
+        file.read(reinterpret_cast<char*>(&checkpoint.stylesheetHash), sizeof(checkpoint.stylesheetHash));
+        if (!file || magic != CheckpointMagic)
+            return false;
+
+        return readString(file, checkpoint.storeKey) && readString(file, checkpoint.sourcePath);
+    }
+
+    /// Writes checkpoint to temporary file and replaces previous one with it.
+    void writeCheckpoint(const std::string& path, const ImportCheckpoint& checkpoint)
+    {
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&CheckpointMagic), sizeof(CheckpointMagic));
+            file.write(reinterpret_cast<const char*>(&checkpoint.sourceSize), sizeof(checkpoint.sourceSize));
+            file.write(reinterpret_cast<const char*>(&checkpoint.elements), sizeof(checkpoint.elements));
+            file.write(reinterpret_cast<const char*>(&checkpoint.startLod), sizeof(checkpoint.startLod));
+            file.write(reinterpret_cast<const char*>(&checkpoint.endLod), sizeof(checkpoint.endLod));
+            file.write(reinterpret_cast<const char*>(&checkpoint.stylesheetHash), sizeof(checkpoint.stylesheetHash));
+            writeString(file, checkpoint.storeKey);
+            writeString(file, checkpoint.sourcePath);
+            if (!file.good())
+                throw std::domain_error("Cannot write import checkpoint: " + tempPath);
+        }
+        std::remove(path.c_str());
+        if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+            throw std::domain_error("Cannot write import checkpoint: " + path);
+    }
+
+    /// Specifies region and predicate which osm data should satisfy to be imported.
+    struct ImportFilter final
+    {
+        utymap::BoundingBox bbox;
+        std::function<bool(const Element&)> predicate;
+    };
+
+    /// Checks whether element geometry is closer than radius to center. Geometry is projected
+    /// to local plane with center as origin, which is precise enough for small radius.
+    class RadiusVisitor final : public ElementVisitor
+    {
+    public:
+        RadiusVisitor(const utymap::GeoCoordinate& center, double radius) :
+            isInside(false),
+            center_(center),
+            radius_(radius),
+            metersPerDegree_(1 / GeoUtils::getOffset(center, 1)),
+            lonScale_(std::cos(deg2Rad(center.latitude)))
+        {
+        }
+
+        void visitNode(const Node& node) override
+        {
+            isInside = GeoUtils::distance(center_, node.coordinate) <= radius_;
+        }
+
+        void visitWay(const Way& way) override
+        {
+            isInside = isCloseToLine(way.coordinates, false);
+        }
+
+        void visitArea(const Area& area) override
+        {
+            isInside = GeoUtils::isPointInPolygon(center_, area.coordinates.begin(), area.coordinates.end()) ||
+                       isCloseToLine(area.coordinates, true);
+        }
+
+        void visitRelation(const Relation& relation) override
+        {
+            for (const auto& element : relation.elements) {
+                element->accept(*this);
+                if (isInside)
+                    return;
+            }
+            isInside = false;
+        }
+
+        bool isInside;
+
+    private:
+        bool isCloseToLine(const std::vector<utymap::GeoCoordinate>& coordinates, bool isClosed) const
+        {
+            if (coordinates.size() == 1)
+                return GeoUtils::distance(center_, coordinates[0]) <= radius_;
+
+            for (std::size_t i = 1; i < coordinates.size(); ++i) {
+                if (getSegmentDistance(coordinates[i - 1], coordinates[i]) <= radius_)
+                    return true;
+            }
+
+            return isClosed && coordinates.size() > 2 &&
+                   getSegmentDistance(coordinates.back(), coordinates.front()) <= radius_;
+        }
+
+        /// Gets distance in meters from center to segment.
+        double getSegmentDistance(const utymap::GeoCoordinate& start, const utymap::GeoCoordinate& end) const
+        {
+            double x1 = (start.longitude - center_.longitude) * lonScale_ * metersPerDegree_;
+            double y1 = (start.latitude - center_.latitude) * metersPerDegree_;
+            double x2 = (end.longitude - center_.longitude) * lonScale_ * metersPerDegree_;
+            double y2 = (end.latitude - center_.latitude) * metersPerDegree_;
+
+            double dx = x2 - x1, dy = y2 - y1;
+            double lengthSquare = dx * dx + dy * dy;
+            double t = lengthSquare > 0 ? clamp(-(x1 * dx + y1 * dy) / lengthSquare, 0., 1.) : 0;
+
+            double x = x1 + t * dx, y = y1 + t * dy;
+            return std::sqrt(x * x + y * y);
+        }
+
+        const utymap::GeoCoordinate& center_;
+        const double radius_;
+        const double metersPerDegree_;
+        const double lonScale_;
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    double getSeconds(Clock::duration duration)
+    {
+        return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+    }
+
+    /// Passes to visitor only elements which are inside radius.
+    class RadiusFilterVisitor final : public ElementVisitor, public SearchControl
+    {
+    public:
+        RadiusFilterVisitor(const utymap::GeoCoordinate& center, double radius, ElementVisitor& visitor) :
+            radiusVisitor_(center, radius), visitor_(visitor), control_(SearchControl::of(visitor))
+        {
+        }
+
+        bool isStopped() const override { return SearchControl::isStopped(control_); }
+
+        void visitNode(const Node& node) override { visitIfNecessary(node); }
+
+        void visitWay(const Way& way) override { visitIfNecessary(way); }
+
+        void visitArea(const Area& area) override { visitIfNecessary(area); }
+
+        void visitRelation(const Relation& relation) override { visitIfNecessary(relation); }
+
+    private:
+        template <typename T>
+        void visitIfNecessary(const T& element)
+        {
+            utymap::entities::visit(element, radiusVisitor_);
+            if (radiusVisitor_.isInside)
+                utymap::entities::visit(element, visitor_);
+        }
+
+        RadiusVisitor radiusVisitor_;
+        ElementVisitor& visitor_;
+        const SearchControl* control_;
+    };
+
+    /// Passes to visitor only elements which intersect bounding box.
+    class BoundingBoxFilterVisitor final : public ElementVisitor, public SearchControl
+    {
+    public:
+        BoundingBoxFilterVisitor(const utymap::BoundingBox& bbox, ElementVisitor& visitor) :
+            bbox_(bbox), visitor_(visitor), control_(SearchControl::of(visitor))
+        {
+        }
+
+        bool isStopped() const override { return SearchControl::isStopped(control_); }
+
+        void visitNode(const Node& node) override { visitIfNecessary(node); }
+
+        void visitWay(const Way& way) override { visitIfNecessary(way); }
+
+        void visitArea(const Area& area) override { visitIfNecessary(area); }
+
+        void visitRelation(const Relation& relation) override { visitIfNecessary(relation); }
+
+    private:
+        template <typename T>
+        void visitIfNecessary(const T& element)
+        {
+            BoundingBoxVisitor bboxVisitor;
+            utymap::entities::visit(element, bboxVisitor);
+            if (bbox_.intersects(bboxVisitor.boundingBox))
+                utymap::entities::visit(element, visitor_);
+        }
+
+        const utymap::BoundingBox& bbox_;
+        ElementVisitor& visitor_;
+        const SearchControl* control_;
+    };
+
+    /// Passes to visitor only the first visited element and stops search once it is found.
+    class FirstElementVisitor final : public ElementVisitor, public SearchControl
+    {
+    public:
+        explicit FirstElementVisitor(ElementVisitor& visitor) :
+            isFound(false), visitor_(visitor)
+        {
+        }
+
+        void visitNode(const Node& node) override { visitIfNecessary(node); }
+
+        void visitWay(const Way& way) override { visitIfNecessary(way); }
+
+        void visitArea(const Area& area) override { visitIfNecessary(area); }
+
+        void visitRelation(const Relation& relation) override { visitIfNecessary(relation); }
+
+        bool isStopped() const override { return isFound; }
+
+        bool isFound;
+
+    private:
+        template <typename T>
+        void visitIfNecessary(const T& element)
+        {
+            if (isFound)
+                return;
+            isFound = true;
+            utymap::entities::visit(element, visitor_);
+        }
+
+        ElementVisitor& visitor_;
+    };
+
+    /// Flat open addressing set of element ids. Zero id is used as empty slot marker
+    /// as elements with zero id are never deduplicated.
+    class IdSet final
+    {
+        /// Initial capacity, should be power of two.
+        static const std::size_t InitialCapacity = 1024;
+    public:
+        IdSet() : slots_(InitialCapacity, 0), size_(0)
+        {
+        }
+
+        /// Inserts id. Returns false if id is already present.
+        bool insert(std::uint64_t id)
+        {
+            if ((size_ + 1) * 2 > slots_.size())
+                grow();
+
+            std::size_t mask = slots_.size() - 1;
+            for (std::size_t i = hash(id) & mask;; i = (i + 1) & mask) {
+                if (slots_[i] == id)
+                    return false;
+                if (slots_[i] == 0) {
+                    slots_[i] = id;
+                    ++size_;
+                    return true;
+                }
+            }
+        }
+
+        /// Checks whether id is present.
+        bool contains(std::uint64_t id) const
+        {
+            std::size_t mask = slots_.size() - 1;
+            for (std::size_t i = hash(id) & mask;; i = (i + 1) & mask) {
+                if (slots_[i] == id)
+                    return true;
+                if (slots_[i] == 0)
+                    return false;
+            }
+        }
+
+        /// Removes all ids keeping allocated memory.
+        void clear()
+        {
+            if (size_ == 0)
+                return;
+            std::fill(slots_.begin(), slots_.end(), 0);
+            size_ = 0;
+        }
+
+    private:
+        static std::size_t hash(std::uint64_t id)
+        {
+            // NOTE ids are often sequential, so mix bits to avoid clustering.
+            id ^= id >> 33;
+            id *= 0xff51afd7ed558ccdULL;
+            id ^= id >> 33;
+            return static_cast<std::size_t>(id);
+        }
+
+        void grow()
+        {
+            std::vector<std::uint64_t> slots(slots_.size() * 2, 0);
+            slots_.swap(slots);
+            size_ = 0;
+            for (std::uint64_t id : slots) {
+                if (id != 0)
+                    insert(id);
+            }
+        }
+
+        std::vector<std::uint64_t> slots_;
+        std::size_t size_;
+    };
+
+    /// Takes id set from pool of calling thread while it is alive, so memory is kept between
+    /// searches and nested searches on the same thread get own sets.
+    class ScopedIdSet final
+    {
+    public:
+        ScopedIdSet() : ids_(acquire())
+        {
+        }
+
+        ScopedIdSet(const ScopedIdSet&) = delete;
+        ScopedIdSet& operator=(const ScopedIdSet&) = delete;
+
+        ~ScopedIdSet()
+        {
+            ids_->clear();
+            pool().push_back(std::move(ids_));
+        }
+
+        IdSet& get() { return *ids_; }
+
+    private:
+        static std::vector<std::unique_ptr<IdSet>>& pool()
+        {
+            static thread_local std::vector<std::unique_ptr<IdSet>> sets;
+            return sets;
+        }
+
+        static std::unique_ptr<IdSet> acquire()
+        {
+            auto& sets = pool();
+            if (sets.empty())
+                return utymap::utils::make_unique<IdSet>();
+            std::unique_ptr<IdSet> ids = std::move(sets.back());
+            sets.pop_back();
+            return ids;
+        }
+
+        std::unique_ptr<IdSet> ids_;
+    };
+}
 
 class GeoStore::GeoStoreImpl final
 {
-    /// Prevents to visit element twice if it exists in multiply stores.
-    class FilterElementVisitor : public ElementVisitor
+    /// Prevents to visit element twice if it exists in multiply stores. Passes fingerprints
+    /// recorded by current store to visitor which can use them. Stores may ask it to reject
+    /// element by tags before geometry is decoded.
+    class FilterElementVisitor : public ElementVisitor, public ElementPrefilter, public SearchControl
     {
     public:
-        FilterElementVisitor(const QuadKey& quadKey, const StyleProvider& styleProvider, ElementVisitor& visitor)
-                : visitor_(visitor), quadKey_(quadKey), styleProvider_(styleProvider), ids_()
+        FilterElementVisitor(ElementVisitor& visitor, IdSet& ids) :
+            visitor_(visitor), ids_(ids),
+            fingerprintVisitor_(dynamic_cast<FingerprintElementVisitor*>(&visitor)),
+            prefilter_(ElementPrefilter::of(visitor)),
+            control_(SearchControl::of(visitor)),
+            store_(nullptr), quadKey_(nullptr), fingerprint_(), fingerprintId_(0), hasFingerprint_(false)
         {
+            ids_.clear();
+        }
+
+        /// Sets store and quadkey of elements which are visited next.
+        void setSource(const ElementStore& store, const QuadKey& quadKey)
+        {
+            store_ = &store;
+            quadKey_ = &quadKey;
+            fingerprintId_ = 0;
         }
 
         void visitNode(const Node& node) override { visitIfNecessary(node); }
@@ -37,75 +508,541 @@ class GeoStore::GeoStoreImpl final
 
         void visitRelation(const Relation& relation) override { visitIfNecessary(relation); }
 
+        bool accepts(const Element& element) override
+        {
+            if (isStopped() || (element.id != 0 && ids_.contains(element.id)))
+                return false;
+
+            // NOTE element with fingerprint is built by recorded style, so its tags are not checked.
+            if (fingerprintVisitor_ != nullptr && findFingerprint(element.id) != nullptr)
+                return true;
+
+            return prefilter_ == nullptr || prefilter_->accepts(element);
+        }
+
+        /// Returns true if wrapped visitor does not need more elements.
+        bool isStopped() const override { return SearchControl::isStopped(control_); }
+
+        std::size_t getRemaining() const override { return SearchControl::getRemaining(control_); }
+
     private:
 
-        void visitIfNecessary(const Element& element)
+        template <typename T>
+        void visitIfNecessary(const T& element)
         {
-            if (element.id == 0 || ids_.find(element.id) == ids_.end() ||
-                    styleProvider_.hasStyle(element, quadKey_.levelOfDetail)) {
-                element.accept(visitor_);
-                ids_.insert(element.id);
+            // NOTE elements without id cannot be deduplicated.
+            if (isStopped() || (element.id != 0 && !ids_.insert(element.id)))
+                return;
+
+            if (fingerprintVisitor_ != nullptr)
+                fingerprintVisitor_->setFingerprint(findFingerprint(element.id));
+            utymap::entities::visit(element, visitor_);
+        }
+
+        /// Finds fingerprint of element in current store. Result of the last lookup is kept, so
+        /// element accepted by prefilter is not looked up again when it is visited.
+        const StyleFingerprint* findFingerprint(std::uint64_t id)
+        {
+            if (store_ == nullptr || id == 0)
+                return nullptr;
+            if (id != fingerprintId_) {
+                fingerprintId_ = id;
+                hasFingerprint_ = store_->findFingerprint(*quadKey_, id, fingerprint_);
             }
+            return hasFingerprint_ ? &fingerprint_ : nullptr;
         }
 
-        const QuadKey& quadKey_;
-        const StyleProvider& styleProvider_;
         ElementVisitor& visitor_;
+        IdSet& ids_;
+        FingerprintElementVisitor* fingerprintVisitor_;
+        ElementPrefilter* prefilter_;
+        const SearchControl* control_;
+        const ElementStore* store_;
+        const QuadKey* quadKey_;
+        StyleFingerprint fingerprint_;
+        /// Id of element which fingerprint was looked up last or zero.
+        std::uint64_t fingerprintId_;
+        bool hasFingerprint_;
+    };
+
+    /// Keeps copies of visited elements in batch as stores may reuse element instances between visits.
+    class BatchCollector final : public ElementVisitor, public SearchControl
+    {
+    public:
+        /// Collects at most given amount of elements while search of control is not stopped.
+        BatchCollector(std::size_t maxElements, const SearchControl* control) :
+            elements(), maxElements_(maxElements), control_(control)
+        {
+        }
+
+        void visitNode(const Node& node) override { elements.add(node); }
+
+        void visitWay(const Way& way) override { elements.add(way); }
+
+        void visitArea(const Area& area) override { elements.add(area); }
+
+        void visitRelation(const Relation& relation) override { elements.add(relation); }
+
+        bool isStopped() const override { return isTruncated() || SearchControl::isStopped(control_); }
+
+        /// Checks whether search is stopped by amount of collected elements.
+        bool isTruncated() const { return elements.size() >= maxElements_; }
+
+        ElementBatch elements;
 
-        std::set<std::uint64_t> ids_;
+    private:
+        const std::size_t maxElements_;
+        const SearchControl* control_;
     };
 
 public:
 
     explicit GeoStoreImpl(StringTable& stringTable) :
-        stringTable_(stringTable)
+        stringTable_(stringTable), version_(0), isParallelSearch_(false), storeThreads_(0), queueCapacity_(0), decodeThreads_(0), nodeCoordinateFile_(),
+        isTwoPassImport_(false), checkpointDirectory_(), checkpointInterval_(0), statisticsCallback_(nullptr), profileCallback_(nullptr)
+    {
+    }
+
+    void setImportProfileCallback(const ImportProfileCallback& profileCallback)
+    {
+        profileCallback_ = profileCallback;
+    }
+
+    void setImportPipeline(std::size_t storeThreads, std::size_t queueCapacity, const ImportStatisticsCallback& statisticsCallback)
+    {
+        storeThreads_ = storeThreads;
+        queueCapacity_ = queueCapacity;
+        statisticsCallback_ = statisticsCallback;
+    }
+
+    void setDecodeConcurrency(std::size_t threads)
+    {
+        decodeThreads_ = threads;
+    }
+
+    void setNodeCoordinateFile(const std::string& path)
     {
+        nodeCoordinateFile_ = path;
+    }
+
+    void setTwoPassImport(bool isEnabled)
+    {
+        isTwoPassImport_ = isEnabled;
+    }
+
+    void setImportCheckpoint(const std::string& directory, std::size_t interval)
+    {
+        checkpointDirectory_ = directory;
+        checkpointInterval_ = std::max<std::size_t>(interval, 1);
+    }
+
+    void setParallelSearch(bool isEnabled)
+    {
+        isParallelSearch_ = isEnabled;
     }
 
     void registerStore(const std::string& storeKey, std::unique_ptr<ElementStore> store)
     {
+        std::lock_guard<std::mutex> lock(storeLock_);
         storeMap_.emplace(storeKey, std::move(store));
+        ++version_;
     }
 
     void add(const std::string& storeKey, const Element& element, const LodRange& range, const StyleProvider& styleProvider)
     {
-        auto& elementStore = storeMap_[storeKey];
+        auto elementStore = getStore(storeKey);
         elementStore->store(element, range, styleProvider);
         elementStore->commit();
+        ++version_;
+    }
+
+    void add(const std::string& storeKey, const std::vector<std::shared_ptr<Element>>& elements, const LodRange& range,
+             const StyleProvider& styleProvider)
+    {
+        auto elementStore = getStore(storeKey);
+        for (const auto& element : elements)
+            elementStore->store(*element, range, styleProvider);
+        elementStore->commit();
+        ++version_;
+    }
+
+    void update(const std::string& storeKey, const Element& element, const LodRange& range, const StyleProvider& styleProvider)
+    {
+        auto elementStore = getStore(storeKey);
+        elementStore->update(element, range, styleProvider);
+        elementStore->commit();
+        ++version_;
+    }
+
+    void remove(const std::string& storeKey, std::uint64_t id, const BoundingBox& bbox, const LodRange& range)
+    {
+        auto elementStore = getStore(storeKey);
+        elementStore->remove(id, bbox, range);
+        elementStore->commit();
+        ++version_;
+    }
+
+    void compact(const std::string& storeKey)
+    {
+        getStore(storeKey)->compact();
+        ++version_;
     }
 
     void add(const std::string& storeKey, const std::string& path, const QuadKey& quadKey, const StyleProvider& styleProvider)
     {
-        auto& elementStore = storeMap_[storeKey];
-        add(path, styleProvider, [&](Element& element) {
+        auto elementStore = getStore(storeKey);
+        auto functor = [&](Element& element) {
             return elementStore->store(element, quadKey, styleProvider);
+        };
+        BoundingBox bbox = GeoUtils::quadKeyToBoundingBox(quadKey);
+        profile(*elementStore, [&]() {
+            if (getFormatTypeFromPath(path) == FormatType::OsmChange)
+                applyChange(*elementStore, path, &bbox, LodRange(quadKey.levelOfDetail, quadKey.levelOfDetail), functor);
+            else
+                add(path, styleProvider, functor);
+            elementStore->commit();
         });
-        elementStore->commit();
+        ++version_;
     }
 
     void add(const std::string& storeKey, const std::string& path, const LodRange& range, const StyleProvider& styleProvider)
     {
-        auto& elementStore = storeMap_[storeKey];
-        add(path, styleProvider, [&](Element& element) {
+        auto elementStore = getStore(storeKey);
+        auto functor = [&](Element& element) {
             return elementStore->store(element, range, styleProvider);
+        };
+        profile(*elementStore, [&]() {
+            if (getFormatTypeFromPath(path) == FormatType::OsmChange)
+                applyChange(*elementStore, path, nullptr, range, functor);
+            else if (!checkpointDirectory_.empty())
+                addCheckpointed(*elementStore, storeKey, path, range, styleProvider, functor);
+            else
+                add(path, styleProvider, functor);
+            elementStore->commit();
         });
-        elementStore->commit();
+        ++version_;
+    }
+
+    void add(const std::string& storeKey, const std::vector<std::string>& paths, const LodRange& range,
+             const StyleProvider& styleProvider, std::size_t threadCount)
+    {
+        auto elementStore = getStore(storeKey);
+        auto functor = [&](Element& element) {
+            return elementStore->store(element, range, styleProvider);
+        };
+
+        // NOTE change files remove elements, so they are not reordered with each other.
+        std::vector<std::string> files, changeFiles;
+        for (const auto& path : paths)
+            (getFormatTypeFromPath(path) == FormatType::OsmChange ? changeFiles : files).push_back(path);
+
+        profile(*elementStore, [&]() {
+            UTYMAP_TRACE_SCOPE("import_files", "import");
+            std::size_t workerCount = threadCount > 0 ? threadCount : utymap::utils::TaskScheduler::instance().getThreadCount();
+            workerCount = std::min(workerCount, files.size());
+            std::atomic<std::size_t> next(0);
+
+            // NOTE files are taken one by one as their sizes differ a lot. Node coordinate file is
+            // truncated on open and removed afterwards, so concurrent files cannot share it.
+            auto worker = [&]() {
+                for (std::size_t i = next++; i < files.size(); i = next++) {
+                    parse(files[i], functor, nullptr, nodeCoordinateFile_.empty() || workerCount < 2
+                        ? nodeCoordinateFile_
+                        : nodeCoordinateFile_ + '.' + std::to_string(i));
+                }
+            };
+
+            utymap::utils::TaskGroup workers;
+            for (std::size_t i = 1; i < workerCount; ++i)
+                workers.run(worker);
+
+            // NOTE first exception is rethrown after all workers are stopped.
+            std::exception_ptr exception;
+            try { if (workerCount > 0) worker(); }
+            catch (...) { exception = std::current_exception(); next = files.size(); }
+            try { workers.wait(); }
+            catch (...) { if (!exception) exception = std::current_exception(); }
+            if (exception)
+                std::rethrow_exception(exception);
+
+            for (const auto& path : changeFiles)
+                applyChange(*elementStore, path, nullptr, range, functor);
+            elementStore->commit();
+        });
+        ++version_;
     }
 
     void add(const std::string& storeKey, const std::string& path, const BoundingBox& bbox, const LodRange& range, const StyleProvider& styleProvider)
     {
-        auto& elementStore = storeMap_[storeKey];
-        add(path, styleProvider, [&](Element& element) {
+        auto elementStore = getStore(storeKey);
+        auto functor = [&](Element& element) {
             return elementStore->store(element, bbox, range, styleProvider);
+        };
+        // NOTE osm data outside of bounding box or without style is dropped by parser.
+        ImportFilter filter = { bbox, [&](const Element& element) {
+            for (int lod = range.start; lod <= range.end; ++lod) {
+                if (styleProvider.hasStyle(element, lod))
+                    return true;
+            }
+            return false;
+        } };
+        profile(*elementStore, [&]() {
+            if (getFormatTypeFromPath(path) == FormatType::OsmChange)
+                applyChange(*elementStore, path, &bbox, range, functor);
+            else
+                add(path, styleProvider, functor, &filter);
+            elementStore->commit();
         });
-        elementStore->commit();
+        ++version_;
+    }
+
+    void add(const std::string& path, const StyleProvider& styleProvider, const std::function<bool(Element&)>& functor,
+             const ImportFilter* filter = nullptr)
+    {
+        UTYMAP_TRACE_SCOPE("import", "import");
+        if (storeThreads_ == 0)
+            parse(path, functor, filter);
+        else
+            addPipelined(path, functor, filter);
+    }
+
+    /// Parses file in separate thread and passes element copies to store threads via queue.
+    /// Copies are passed in batches, so queue operations and allocations are not done per element.
+    void addPipelined(const std::string& path, const std::function<bool(Element&)>& functor, const ImportFilter* filter)
+    {
+        // NOTE queue capacity is specified in elements.
+        std::size_t batchSize = std::max<std::size_t>(1, std::min(ImportBatchSize, queueCapacity_));
+        utymap::utils::BoundedQueue<ElementBatch> queue(std::max<std::size_t>(1, queueCapacity_ / batchSize));
+
+        ImportStageStatistics parseStatistics = { "parse", 0, 0, 0 };
+        auto producer = std::async(std::launch::async, [&]() {
+            UTYMAP_TRACE_SCOPE("parse", "import");
+            auto start = Clock::now();
+            Clock::duration waitTime(0);
+            try {
+                ElementBatch batch;
+                auto push = [&]() {
+                    auto pushStart = Clock::now();
+                    bool isPushed = queue.push(std::move(batch));
+                    waitTime += Clock::now() - pushStart;
+                    batch = ElementBatch();
+                    return isPushed;
+                };
+                bool isPushed = true;
+                parse(path, [&](Element& element) {
+                    batch.add(element);
+                    ++parseStatistics.elements;
+                    if (batch.size() >= batchSize)
+                        isPushed = push();
+                    return isPushed;
+                }, filter);
+                if (isPushed && !batch.empty())
+                    push();
+            }
+            catch (...) {
+                queue.cancel();
+                throw;
+            }
+            queue.close();
+            parseStatistics.waitSeconds = getSeconds(waitTime);
+            parseStatistics.busySeconds = getSeconds(Clock::now() - start - waitTime);
+        });
+
+        std::vector<ImportStageStatistics> storeStatistics(storeThreads_, ImportStageStatistics { "store", 0, 0, 0 });
+        auto consumer = [&](ImportStageStatistics& statistics) {
+            UTYMAP_TRACE_SCOPE("store", "import");
+            Clock::duration waitTime(0), busyTime(0);
+            try {
+                for (;;) {
+                    ElementBatch batch;
+                    auto popStart = Clock::now();
+                    if (!queue.pop(batch))
+                        break;
+                    auto storeStart = Clock::now();
+                    waitTime += storeStart - popStart;
+
+                    batch.forEach([&](Element& element) { functor(element); });
+                    statistics.elements += batch.size();
+                    busyTime += Clock::now() - storeStart;
+                }
+            }
+            catch (...) {
+                queue.cancel();
+                throw;
+            }
+            statistics.waitSeconds = getSeconds(waitTime);
+            statistics.busySeconds = getSeconds(busyTime);
+        };
+
+        std::vector<std::future<void>> consumers;
+        for (std::size_t i = 1; i < storeThreads_; ++i)
+            consumers.push_back(std::async(std::launch::async, consumer, std::ref(storeStatistics[i])));
+
+        // NOTE first exception is rethrown after all stages are stopped.
+        std::exception_ptr exception;
+        try { consumer(storeStatistics[0]); }
+        catch (...) { exception = std::current_exception(); }
+        for (auto& result : consumers) {
+            try { result.get(); }
+            catch (...) { if (!exception) exception = std::current_exception(); }
+        }
+        try { producer.get(); }
+        catch (...) { if (!exception) exception = std::current_exception(); }
+        if (exception)
+            std::rethrow_exception(exception);
+
+        if (statisticsCallback_ != nullptr) {
+            ImportStageStatistics total = { "store", 0, 0, 0 };
+            for (const auto& statistics : storeStatistics) {
+                total.elements += statistics.elements;
+                total.busySeconds += statistics.busySeconds;
+                total.waitSeconds += statistics.waitSeconds;
+            }
+            statisticsCallback_({ parseStatistics, total });
+        }
+    }
+
+    /// Applies osm change file: deleted and modified elements are removed from tiles where
+    /// they can be found, created and modified ones are stored using functor. Nodes of ways
+    /// which are not part of change are resolved from nodes stored in element store.
+    void applyChange(ElementStore& elementStore, const std::string& path, const BoundingBox* region,
+                     const LodRange& range, const std::function<bool(Element&)>& functor)
+    {
+        std::ifstream changeFile(path);
+        OsmXmlParser<OsmChangeVisitor> parser;
+        OsmChangeVisitor visitor(stringTable_, [&](Element& element, ChangeAction action) {
+            if (action == ChangeAction::Create)
+                return functor(element);
+
+            BoundingBoxVisitor bboxVisitor;
+            utymap::entities::visit(element, bboxVisitor);
+            // NOTE stored element can have different geometry, so it is removed from tiles found
+            // by id index of store. Otherwise, tiles of new geometry are used and deleted element
+            // without geometry is searched in whole import region.
+            BoundingBox bbox;
+            if (elementStore.findQuadKeys(element.id).empty()) {
+                bbox = bboxVisitor.boundingBox;
+                if (!bbox.isValid())
+                    bbox = region != nullptr ? *region : visitor.extent();
+            }
+            elementStore.remove(element.id, bbox, range);
+
+            return action == ChangeAction::Modify ? functor(element) : true;
+        });
+        visitor.setNodeResolver([&](std::uint64_t id, GeoCoordinate& coordinate) {
+            return findNode(elementStore, id, coordinate);
+        });
+        parser.parseChange(changeFile, visitor);
+        visitor.complete();
+    }
+
+    /// Finds coordinate of node stored with given id using id index of store.
+    static bool findNode(ElementStore& elementStore, std::uint64_t id, GeoCoordinate& coordinate)
+    {
+        struct NodeVisitor final : public ElementVisitor
+        {
+            GeoCoordinate* coordinate = nullptr;
+            bool isFound = false;
+            void visitNode(const Node& node) override { *coordinate = node.coordinate; isFound = true; }
+            void visitWay(const Way&) override { }
+            void visitArea(const Area&) override { }
+            void visitRelation(const Relation&) override { }
+        } visitor;
+        visitor.coordinate = &coordinate;
+
+        // NOTE node is not clipped, so any tile has its coordinate.
+        for (const auto& quadKey : elementStore.findQuadKeys(id)) {
+            elementStore.searchById(quadKey, id, visitor);
+            if (visitor.isFound)
+                return true;
+        }
+        return false;
     }
 
-    void add(const std::string& path, const StyleProvider& styleProvider, const std::function<bool(Element&)>& functor)
+    /// Stores elements of file from its snapshot committing store with checkpoint after every
+    /// interval of elements. Elements stored before last checkpoint of the same import, i.e. of
+    /// the same file into the same store with the same level of details range and stylesheet,
+    /// are skipped.
+    void addCheckpointed(ElementStore& elementStore, const std::string& storeKey, const std::string& path,
+                         const LodRange& range, const StyleProvider& styleProvider,
+                         const std::function<bool(Element&)>& functor)
+    {
+        UTYMAP_TRACE_SCOPE("import_checkpointed", "import");
+        std::string checkpointName = checkpointDirectory_ + getCheckpointName(storeKey, path);
+        std::string checkpointPath = checkpointName + CheckpointFileExtension;
+        bool isSnapshot = getFormatTypeFromPath(path) == FormatType::Snapshot;
+        std::string snapshotPath = isSnapshot ? path : checkpointName + CheckpointSnapshotExtension;
+
+        ImportCheckpoint expected { getFileSize(path), 0, range.start, range.end,
+                                    styleProvider.getStylesheetHash(), storeKey, path };
+        ImportCheckpoint checkpoint;
+        if (!readCheckpoint(checkpointPath, checkpoint) || !checkpoint.isSameImport(expected)) {
+            // NOTE snapshot fixes order of elements, so skipped ones are the same on restart.
+            if (!isSnapshot)
+                createSnapshot(path, snapshotPath);
+            checkpoint = expected;
+            writeCheckpoint(checkpointPath, checkpoint);
+        }
+
+        std::uint64_t index = 0;
+        ElementSnapshotReader::read(snapshotPath, stringTable_, [&](Element& element) {
+            if (index++ < checkpoint.elements)
+                return false;
+            bool isStored = functor(element);
+            if (index % checkpointInterval_ == 0) {
+                elementStore.commit();
+                checkpoint.elements = index;
+                writeCheckpoint(checkpointPath, checkpoint);
+            }
+            return isStored;
+        });
+
+        elementStore.commit();
+        std::remove(checkpointPath.c_str());
+        if (!isSnapshot)
+            std::remove(snapshotPath.c_str());
+    }
+
+    /// Parses file and calls functor for every element.
+    void createSnapshot(const std::string& path, const std::string& snapshotPath)
+    {
+        ElementSnapshotWriter writer(snapshotPath, stringTable_);
+        parse(path, [&](Element& element) {
+            writer.add(element);
+            return true;
+        });
+        writer.finish();
+    }
+
+    void parse(const std::string& path, const std::function<bool(Element&)>& functor, const ImportFilter* filter = nullptr)
+    {
+        parse(path, functor, filter, nodeCoordinateFile_);
+    }
+
+    /// Parses file keeping node coordinates of osm data in given file unless path is empty.
+    void parse(const std::string& path, const std::function<bool(Element&)>& functor, const ImportFilter* filter,
+               const std::string& nodeCoordinateFile)
     {
         switch (getFormatTypeFromPath(path)) {
+            case FormatType::Snapshot: {
+                // NOTE snapshot has resolved elements: filter is applied to them directly.
+                ElementSnapshotReader::read(path, stringTable_, [&](Element& element) {
+                    if (filter != nullptr) {
+                        BoundingBoxVisitor bboxVisitor;
+                        utymap::entities::visit(element, bboxVisitor);
+                        if (!filter->bbox.intersects(bboxVisitor.boundingBox) || !filter->predicate(element))
+                            return false;
+                    }
+                    return functor(element);
+                });
+                break;
+            }
             case FormatType::Shape: {
                 ShapeParser<ShapeDataVisitor> parser;
+                parser.setConcurrency(decodeThreads_);
+                // NOTE records outside of bounding box are skipped using spatial index.
+                if (filter != nullptr)
+                    parser.setBoundingBox(filter->bbox);
                 ShapeDataVisitor visitor(stringTable_, functor);
                 parser.parse(path, visitor);
                 visitor.complete();
@@ -115,14 +1052,35 @@ public:
                 OsmXmlParser<OsmDataVisitor> parser;
                 std::ifstream xmlFile(path);
                 OsmDataVisitor visitor(stringTable_, functor);
+                if (filter != nullptr)
+                    visitor.setFilter(filter->bbox, filter->predicate);
+                if (!nodeCoordinateFile.empty())
+                    visitor.setNodeCoordinateFile(nodeCoordinateFile);
+                visitor.setConcurrency(decodeThreads_);
                 parser.parse(xmlFile, visitor);
                 visitor.complete();
                 break;
             }
             case FormatType::Pbf: {
                 OsmPbfParser<OsmDataVisitor> parser;
+                // NOTE ways are built from already visited nodes, so file order is preserved.
+                parser.setConcurrency(decodeThreads_);
                 std::ifstream pbfFile(path, std::ios::in | std::ios::binary);
                 OsmDataVisitor visitor(stringTable_, functor);
+                if (filter != nullptr)
+                    visitor.setFilter(filter->bbox, filter->predicate);
+                if (!nodeCoordinateFile.empty())
+                    visitor.setNodeCoordinateFile(nodeCoordinateFile);
+                visitor.setConcurrency(decodeThreads_);
+                // NOTE first pass reads the file to find referenced nodes, so others are not kept.
+                NodeReferenceVisitor references;
+                if (isTwoPassImport_) {
+                    OsmPbfParser<NodeReferenceVisitor> referenceParser;
+                    referenceParser.setConcurrency(decodeThreads_);
+                    std::ifstream referenceFile(path, std::ios::in | std::ios::binary);
+                    referenceParser.parse(referenceFile, references);
+                    visitor.setReferencedNodes(references.wayNodes, references.relationNodes);
+                }
                 parser.parse(pbfFile, visitor);
                 visitor.complete();
                 break;
@@ -134,31 +1092,255 @@ public:
 
     void search(const QuadKey& quadKey, const utymap::mapcss::StyleProvider& styleProvider, ElementVisitor& visitor)
     {
-        FilterElementVisitor filter(quadKey, styleProvider, visitor);
-        for (const auto& pair : storeMap_) {
-            // Search only if store has data
-            if (pair.second->hasData(quadKey))
-                pair.second->search(quadKey, filter);
+        UTYMAP_STATISTICS_SCOPE(GeoStoreSearch);
+        ScopedIdSet ids;
+        FilterElementVisitor filter(visitor, ids.get());
+
+        // Search only if store has data
+        std::vector<ElementStore*> stores;
+        for (auto store : getStores()) {
+            if (store->hasData(quadKey))
+                stores.push_back(store);
+        }
+
+        if (!isParallelSearch_ || stores.size() < 2) {
+            for (auto store : stores) {
+                if (filter.isStopped())
+                    return;
+                UTYMAP_STATISTICS_SCOPE(ElementStoreSearch);
+                filter.setSource(*store, quadKey);
+                store->search(quadKey, filter);
+            }
+            return;
+        }
+
+        // NOTE store searches stop after as many elements as visitor accepts: limit is not
+        // changed while they run as visitor gets elements only after they are finished.
+        std::size_t remaining = filter.getRemaining();
+        std::vector<ElementBatch> results(stores.size());
+        std::vector<char> isTruncated(stores.size(), 0);
+        utymap::utils::TaskGroup searches(utymap::utils::TaskPriority::High);
+        for (std::size_t i = 0; i < stores.size(); ++i) {
+            searches.run([&, i]() {
+                UTYMAP_STATISTICS_SCOPE(ElementStoreSearch);
+                BatchCollector collector(remaining, &filter);
+                stores[i]->search(quadKey, collector);
+                isTruncated[i] = collector.isTruncated();
+                results[i] = std::move(collector.elements);
+            });
+        }
+        searches.wait();
+
+        // NOTE merge results in store order to keep output deterministic. Collected elements can
+        // be rejected as duplicates, so truncated store is searched again if limit is not reached.
+        for (std::size_t i = 0; i < results.size() && !filter.isStopped(); ++i) {
+            filter.setSource(*stores[i], quadKey);
+            results[i].accept(filter);
+            if (isTruncated[i] && !filter.isStopped())
+                stores[i]->search(quadKey, filter);
+        }
+    }
+
+    void search(const GeoCoordinate& coordinate, double radius, int levelOfDetail, const StyleProvider&, ElementVisitor& visitor)
+    {
+        ScopedIdSet ids;
+        FilterElementVisitor filter(visitor, ids.get());
+        RadiusFilterVisitor radiusFilter(coordinate, radius, filter);
+
+        // NOTE only tiles which intersect circle's bounding box are searched.
+        double latOffset = GeoUtils::getOffset(coordinate, radius);
+        double lonOffset = latOffset / std::max(std::cos(deg2Rad(coordinate.latitude)), 1E-6);
+        BoundingBox bbox(
+            GeoCoordinate(clamp(coordinate.latitude - latOffset, -MaxLatitude, MaxLatitude),
+                          clamp(coordinate.longitude - lonOffset, -180., 180.)),
+            GeoCoordinate(clamp(coordinate.latitude + latOffset, -MaxLatitude, MaxLatitude),
+                          clamp(coordinate.longitude + lonOffset, -180., 180.)));
+
+        auto stores = getStores();
+        prefetch(stores, bbox, levelOfDetail);
+        GeoUtils::visitTileRange(bbox, levelOfDetail, [&](const QuadKey& quadKey, const BoundingBox&) {
+            for (auto store : stores) {
+                if (!filter.isStopped() && store->hasData(quadKey))
+                    store->search(quadKey, bbox, radiusFilter);
+            }
+        });
+    }
+
+    void searchByTag(const BoundingBox& bbox, int levelOfDetail, const std::vector<utymap::entities::Tag>& tags, ElementVisitor& visitor)
+    {
+        ScopedIdSet ids;
+        FilterElementVisitor filter(visitor, ids.get());
+        BoundingBoxFilterVisitor bboxFilter(bbox, filter);
+
+        auto stores = getStores();
+        prefetch(stores, bbox, levelOfDetail);
+        GeoUtils::visitTileRange(bbox, levelOfDetail, [&](const QuadKey& quadKey, const BoundingBox&) {
+            for (auto store : stores) {
+                if (!filter.isStopped() && store->hasData(quadKey))
+                    store->searchByTag(quadKey, bbox, tags, bboxFilter);
+            }
+        });
+    }
+
+    bool getElement(std::uint64_t id, int levelOfDetail, ElementVisitor& visitor)
+    {
+        FirstElementVisitor first(visitor);
+        for (auto store : getStores()) {
+            for (const auto& quadKey : store->findQuadKeys(id)) {
+                if (quadKey.levelOfDetail != levelOfDetail || !store->hasData(quadKey))
+                    continue;
+                store->searchById(quadKey, id, first);
+                if (first.isFound)
+                    return true;
+            }
         }
+        return false;
     }
 
-    void search(const GeoCoordinate& coordinate, double radius, const StyleProvider& styleProvider, ElementVisitor& visitor)
+    std::vector<NameIndex::Match> searchByName(const std::string& prefix, const GeoCoordinate& coordinate, std::size_t maxResults)
     {
-        throw std::domain_error("Not implemented");
+        std::vector<NameIndex::Match> matches;
+        for (auto store : getStores()) {
+            auto storeMatches = store->searchByName(prefix, coordinate, maxResults);
+            matches.insert(matches.end(), storeMatches.begin(), storeMatches.end());
+        }
+
+        // NOTE element which exists in several stores is reported once.
+        std::stable_sort(matches.begin(), matches.end(), [](const NameIndex::Match& left, const NameIndex::Match& right) {
+            return left.distance < right.distance;
+        });
+        std::vector<NameIndex::Match> result;
+        for (auto& match : matches) {
+            if (result.size() == maxResults)
+                break;
+            if (std::none_of(result.begin(), result.end(), [&](const NameIndex::Match& other) { return other.id == match.id; }))
+                result.push_back(std::move(match));
+        }
+        return result;
     }
 
     bool hasData(const QuadKey& quadKey)
     {
-        for (const auto& pair : storeMap_) {
-            if (pair.second->hasData(quadKey))
+        for (auto store : getStores()) {
+            if (store->hasData(quadKey))
                 return true;
         }
         return false;
     }
 
+    void prefetch(const QuadKey& quadKey)
+    {
+        for (auto store : getStores()) {
+            if (store->hasData(quadKey))
+                store->prefetch(quadKey);
+        }
+    }
+
+    std::uint64_t getVersion() const
+    {
+        return version_;
+    }
+
+    bool getDataVersion(const QuadKey& quadKey, std::uint64_t& version)
+    {
+        std::vector<std::pair<std::string, ElementStore*>> stores;
+        {
+            std::lock_guard<std::mutex> lock(storeLock_);
+            for (const auto& pair : storeMap_)
+                stores.emplace_back(pair.first, pair.second.get());
+        }
+
+        // NOTE stores are ordered by key, so version does not depend on registration order.
+        version = 0;
+        for (const auto& pair : stores) {
+            std::uint64_t storeVersion;
+            if (!pair.second->getDataVersion(quadKey, storeVersion))
+                return false;
+            version ^= std::hash<std::string>()(pair.first) + 0x9e3779b97f4a7c15ULL + (version << 6) + (version >> 2);
+            version ^= storeVersion + 0x9e3779b97f4a7c15ULL + (version << 6) + (version >> 2);
+        }
+        return true;
+    }
+
+    std::map<std::string, std::size_t> getMemoryUsage()
+    {
+        std::lock_guard<std::mutex> lock(storeLock_);
+        std::map<std::string, std::size_t> usage;
+        for (const auto& pair : storeMap_)
+            usage.emplace(pair.first, pair.second->getMemoryUsage());
+        return usage;
+    }
+
 private:
+    /// Runs import collecting its profile if profiling is enabled.
+    void profile(ElementStore& elementStore, const std::function<void()>& import)
+    {
+        UTYMAP_STATISTICS_SCOPE(Import);
+        if (profileCallback_ == nullptr) {
+            import();
+            return;
+        }
+
+        auto profile = std::make_shared<ImportProfile>();
+        elementStore.setImportProfile(profile);
+        try {
+            import();
+        }
+        catch (...) {
+            elementStore.setImportProfile(nullptr);
+            throw;
+        }
+        elementStore.setImportProfile(nullptr);
+        profile->finish();
+        profileCallback_(*profile);
+    }
+
+    /// Prefetches all tiles of range before they are searched one by one.
+    void prefetch(const std::vector<ElementStore*>& stores, const BoundingBox& bbox, int levelOfDetail)
+    {
+        GeoUtils::visitTileRange(bbox, levelOfDetail, [&](const QuadKey& quadKey, const BoundingBox&) {
+            for (auto store : stores) {
+                if (store->hasData(quadKey))
+                    store->prefetch(quadKey);
+            }
+        });
+    }
+
+    /// Returns registered store. Stores are never removed, so pointer stays valid without lock.
+    ElementStore* getStore(const std::string& storeKey)
+    {
+        std::lock_guard<std::mutex> lock(storeLock_);
+        auto pair = storeMap_.find(storeKey);
+        if (pair == storeMap_.end())
+            throw std::domain_error("Unknown element store: " + storeKey);
+        return pair->second.get();
+    }
+
+    /// Returns snapshot of registered stores, so they are searched without lock.
+    std::vector<ElementStore*> getStores()
+    {
+        std::lock_guard<std::mutex> lock(storeLock_);
+        std::vector<ElementStore*> stores;
+        stores.reserve(storeMap_.size());
+        for (const auto& pair : storeMap_)
+            stores.push_back(pair.second.get());
+        return stores;
+    }
+
     StringTable& stringTable_;
+    std::mutex storeLock_;
     std::map<std::string, std::unique_ptr<ElementStore>> storeMap_;
+    std::atomic<std::uint64_t> version_;
+    bool isParallelSearch_;
+    std::size_t storeThreads_;
+    std::size_t queueCapacity_;
+    std::size_t decodeThreads_;
+    std::string nodeCoordinateFile_;
+    bool isTwoPassImport_;
+    std::string checkpointDirectory_;
+    std::size_t checkpointInterval_;
+    ImportStatisticsCallback statisticsCallback_;
+    ImportProfileCallback profileCallback_;
 
     static FormatType getFormatTypeFromPath(const std::string& path)
     {
@@ -166,6 +1348,10 @@ private:
             return FormatType::Pbf;
         if (utymap::utils::endsWith(path, "xml"))
             return FormatType::Xml;
+        if (utymap::utils::endsWith(path, "osc"))
+            return FormatType::OsmChange;
+        if (utymap::utils::endsWith(path, "uts"))
+            return FormatType::Snapshot;
 
         return FormatType::Shape;
     }
@@ -191,11 +1377,38 @@ void utymap::index::GeoStore::add(const std::string& storeKey, const Element& el
     pimpl_->add(storeKey, element, range, styleProvider);
 }
 
+void utymap::index::GeoStore::add(const std::string& storeKey, const std::vector<std::shared_ptr<Element>>& elements,
+                                  const LodRange& range, const StyleProvider& styleProvider)
+{
+    pimpl_->add(storeKey, elements, range, styleProvider);
+}
+
+void utymap::index::GeoStore::update(const std::string& storeKey, const Element& element, const LodRange& range, const StyleProvider& styleProvider)
+{
+    pimpl_->update(storeKey, element, range, styleProvider);
+}
+
+void utymap::index::GeoStore::remove(const std::string& storeKey, std::uint64_t id, const utymap::BoundingBox& bbox, const LodRange& range)
+{
+    pimpl_->remove(storeKey, id, bbox, range);
+}
+
+void utymap::index::GeoStore::compact(const std::string& storeKey)
+{
+    pimpl_->compact(storeKey);
+}
+
 void utymap::index::GeoStore::add(const std::string& storeKey, const std::string& path, const LodRange& range, const StyleProvider& styleProvider)
 {
     pimpl_->add(storeKey, path, range, styleProvider);
 }
 
+void utymap::index::GeoStore::add(const std::string& storeKey, const std::vector<std::string>& paths, const LodRange& range,
+                                  const StyleProvider& styleProvider, std::size_t threadCount)
+{
+    pimpl_->add(storeKey, paths, range, styleProvider, threadCount);
+}
+
 void utymap::index::GeoStore::add(const std::string& storeKey, const std::string& path, const QuadKey& quadKey, const StyleProvider& styleProvider)
 {
     pimpl_->add(storeKey, path, quadKey, styleProvider);
@@ -206,17 +1419,92 @@ void utymap::index::GeoStore::add(const std::string &storeKey, const std::string
     pimpl_->add(storeKey, path, bbox, range, styleProvider);
 }
 
+void utymap::index::GeoStore::createSnapshot(const std::string& path, const std::string& snapshotPath)
+{
+    pimpl_->createSnapshot(path, snapshotPath);
+}
+
+void utymap::index::GeoStore::setImportPipeline(std::size_t storeThreads, std::size_t queueCapacity, ImportStatisticsCallback statisticsCallback)
+{
+    pimpl_->setImportPipeline(storeThreads, queueCapacity, statisticsCallback);
+}
+
+void utymap::index::GeoStore::setImportProfileCallback(ImportProfileCallback profileCallback)
+{
+    pimpl_->setImportProfileCallback(profileCallback);
+}
+
+void utymap::index::GeoStore::setDecodeConcurrency(std::size_t threads)
+{
+    pimpl_->setDecodeConcurrency(threads);
+}
+
+void utymap::index::GeoStore::setNodeCoordinateFile(const std::string& path)
+{
+    pimpl_->setNodeCoordinateFile(path);
+}
+
+void utymap::index::GeoStore::setTwoPassImport(bool isEnabled)
+{
+    pimpl_->setTwoPassImport(isEnabled);
+}
+
+void utymap::index::GeoStore::setImportCheckpoint(const std::string& directory, std::size_t interval)
+{
+    pimpl_->setImportCheckpoint(directory, interval);
+}
+
+void utymap::index::GeoStore::setParallelSearch(bool isEnabled)
+{
+    pimpl_->setParallelSearch(isEnabled);
+}
+
 void utymap::index::GeoStore::search(const QuadKey& quadKey, const utymap::mapcss::StyleProvider& styleProvider, ElementVisitor& visitor)
 {
     pimpl_->search(quadKey, styleProvider, visitor);
 }
 
-void utymap::index::GeoStore::search(const GeoCoordinate& coordinate, double radius, const StyleProvider& styleProvider, ElementVisitor& visitor)
+void utymap::index::GeoStore::search(const GeoCoordinate& coordinate, double radius, int levelOfDetail, const StyleProvider& styleProvider, ElementVisitor& visitor)
+{
+    pimpl_->search(coordinate, radius, levelOfDetail, styleProvider, visitor);
+}
+
+void utymap::index::GeoStore::searchByTag(const BoundingBox& bbox, int levelOfDetail, const std::vector<utymap::entities::Tag>& tags, ElementVisitor& visitor)
 {
-    pimpl_->search(coordinate, radius, styleProvider, visitor);
+    pimpl_->searchByTag(bbox, levelOfDetail, tags, visitor);
+}
+
+bool utymap::index::GeoStore::getElement(std::uint64_t id, int levelOfDetail, ElementVisitor& visitor)
+{
+    return pimpl_->getElement(id, levelOfDetail, visitor);
+}
+
+std::vector<NameIndex::Match> utymap::index::GeoStore::searchByName(const std::string& prefix, const GeoCoordinate& coordinate, std::size_t maxResults)
+{
+    return pimpl_->searchByName(prefix, coordinate, maxResults);
 }
 
 bool utymap::index::GeoStore::hasData(const QuadKey& quadKey)
 {
     return pimpl_->hasData(quadKey);
 }
+
+void utymap::index::GeoStore::prefetch(const QuadKey& quadKey)
+{
+    pimpl_->prefetch(quadKey);
+}
+
+std::uint64_t utymap::index::GeoStore::getVersion() const
+{
+    return pimpl_->getVersion();
+}
+
+bool utymap::index::GeoStore::getDataVersion(const QuadKey& quadKey, std::uint64_t& version)
+{
+    return pimpl_->getDataVersion(quadKey, version);
+}
+
+std::map<std::string, std::size_t> utymap::index::GeoStore::getMemoryUsage()
+{
+    return pimpl_->getMemoryUsage();
+}
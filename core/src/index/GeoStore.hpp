@@ -11,11 +11,29 @@
 #include "index/StringTable.hpp"
 #include "mapcss/StyleProvider.hpp"
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace utymap { namespace index {
 
+/// Represents statistics of single import pipeline stage.
+struct ImportStageStatistics final
+{
+    /// Name of the stage.
+    std::string name;
+    /// Amount of processed elements.
+    std::size_t elements;
+    /// Time spent on processing excluding waiting for other stages, summed for all threads.
+    double busySeconds;
+    /// Time spent on waiting for other stages, summed for all threads.
+    double waitSeconds;
+};
+
 /// Provides API to store and access geo data using different underlying data stores.
 class GeoStore final
 {
@@ -24,6 +42,12 @@ public:
 
     ~GeoStore();
 
+    /// Defines callback which receives statistics of pipeline stages after file import.
+    typedef std::function<void(const std::vector<ImportStageStatistics>&)> ImportStatisticsCallback;
+
+    /// Defines callback which receives profile of file import.
+    typedef std::function<void(const ImportProfile&)> ImportProfileCallback;
+
     /// Adds underlying element store for usage.
     void registerStore(const std::string& storeKey, 
                        std::unique_ptr<ElementStore> store);
@@ -34,12 +58,46 @@ public:
              const utymap::LodRange& range, 
              const utymap::mapcss::StyleProvider& styleProvider);
 
+    /// Adds elements to selected store committing it once after all of them are stored.
+    void add(const std::string& storeKey,
+             const std::vector<std::shared_ptr<utymap::entities::Element>>& elements,
+             const utymap::LodRange& range,
+             const utymap::mapcss::StyleProvider& styleProvider);
+
+    /// Replaces element with the same id in selected store.
+    void update(const std::string& storeKey,
+                const utymap::entities::Element& element,
+                const utymap::LodRange& range,
+                const utymap::mapcss::StyleProvider& styleProvider);
+
+    /// Removes element with given id from selected store in tiles intersecting bounding box.
+    void remove(const std::string& storeKey,
+                std::uint64_t id,
+                const utymap::BoundingBox& bbox,
+                const utymap::LodRange& range);
+
+    /// Compacts selected store: data of removed elements is dropped and persistent store splits
+    /// its oversized tiles into buckets.
+    void compact(const std::string& storeKey);
+
     /// Adds all data from file to selected store in given level of detail range.
+    /// Osm change files (.osc) are applied to the store: only elements listed there are
+    /// created, replaced or removed. Snapshot files (.uts) are imported without parsing.
     void add(const std::string& storeKey, 
              const std::string& path,
              const utymap::LodRange& range, 
              const utymap::mapcss::StyleProvider& styleProvider);
 
+    /// Imports files concurrently into selected store in given level of detail range using given
+    /// amount of threads (zero means amount of hardware threads). Every thread parses its own file,
+    /// styles and clips its elements while tile writes are serialized by store. Osm change files
+    /// are applied afterwards in given order. Store is committed once when all files are imported.
+    void add(const std::string& storeKey,
+             const std::vector<std::string>& paths,
+             const utymap::LodRange& range,
+             const utymap::mapcss::StyleProvider& styleProvider,
+             std::size_t threadCount);
+
     /// Adds all data from file to selected store in given quad key.
     void add(const std::string& storeKey,
              const std::string& path,
@@ -53,20 +111,99 @@ public:
              const utymap::LodRange& range,
              const utymap::mapcss::StyleProvider& styleProvider);
 
+    /// Parses file and writes its resolved elements to snapshot file (.uts). Snapshot can be passed
+    /// to add methods instead of source file: parsing and relation assembly are skipped then.
+    void createSnapshot(const std::string& path, const std::string& snapshotPath);
+
+    /// Enables pipelined file import: one thread parses file and resolves relations while
+    /// given amount of threads styles, clips and stores elements. Stages are connected by queue
+    /// of given capacity in elements which are passed in batches. Zero thread count disables pipeline.
+    void setImportPipeline(std::size_t storeThreads,
+                           std::size_t queueCapacity,
+                           ImportStatisticsCallback statisticsCallback = nullptr);
+
+    /// Enables profiling of file imports: callback receives throughput by element type, fragments
+    /// per level of detail and bytes written per tile after every import. Null disables profiling.
+    void setImportProfileCallback(ImportProfileCallback profileCallback);
+
+    /// Sets amount of threads which decode data blocks of pbf files, read records of shape files
+    /// and resolve relations of osm data.
+    /// Zero disables concurrent decoding.
+    void setDecodeConcurrency(std::size_t threads);
+
+    /// Sets path of temporary file which keeps node coordinates of osm data during import.
+    /// Useful for large files: only tagged nodes are kept in memory. Empty path disables it.
+    /// Files imported concurrently use own files with index of file appended to path.
+    void setNodeCoordinateFile(const std::string& path);
+
+    /// Enables two pass import of pbf files: first pass collects ids of nodes referenced by ways
+    /// and relations, so the second one keeps only them and tagged nodes in memory. Every block is
+    /// read and inflated twice.
+    void setTwoPassImport(bool isEnabled);
+
+    /// Enables checkpointed import of files added in level of detail range. File is written to
+    /// snapshot in given directory first, then its elements are stored and store is committed
+    /// together with checkpoint after every given amount of them. Import of the same file into
+    /// the same store with the same level of detail range and stylesheet which is restarted after
+    /// failure continues after last checkpoint. Every store and file has own checkpoint files.
+    /// Empty directory disables it.
+    void setImportCheckpoint(const std::string& directory, std::size_t interval);
+
+    /// Enables or disables concurrent search of registered stores. Results are
+    /// still visited in order of stores.
+    void setParallelSearch(bool isEnabled);
+
     /// Searches for elements inside quadkey.
     void search(const QuadKey& quadKey,
                 const utymap::mapcss::StyleProvider& styleProvider,
                 utymap::entities::ElementVisitor& visitor);
 
-    /// Searches for elements inside circle with given parameters.
+    /// Searches for elements stored at given level of detail which are closer than
+    /// radius (in meters) to given coordinate.
     void search(const GeoCoordinate& coordinate,
                 double radius,
+                int levelOfDetail,
                 const utymap::mapcss::StyleProvider& styleProvider,
                 utymap::entities::ElementVisitor& visitor);
 
+    /// Searches for elements stored at given level of detail which intersect bounding box
+    /// and have all given tags. Stores use their tag indices when they have them.
+    void searchByTag(const BoundingBox& bbox,
+                      int levelOfDetail,
+                      const std::vector<utymap::entities::Tag>& tags,
+                      utymap::entities::ElementVisitor& visitor);
+
+    /// Visits element with given id as it is stored at given level of detail: clipped element
+    /// is read from the first of its tiles. Stores are checked in registration order using
+    /// their id indices. Returns false if element is not found.
+    bool getElement(std::uint64_t id,
+                    int levelOfDetail,
+                    utymap::entities::ElementVisitor& visitor);
+
+    /// Finds elements of all stores which have name starting with given prefix. Returns given
+    /// amount of elements closest to coordinate ordered by distance.
+    std::vector<NameIndex::Match> searchByName(const std::string& prefix,
+                                               const GeoCoordinate& coordinate,
+                                               std::size_t maxResults);
+
     /// Checks whether there is data for given quadkey.
     bool hasData(const QuadKey& quadKey);
 
+    /// Prepares data of given quadkey in stores which have it, so coming search is faster.
+    void prefetch(const QuadKey& quadKey);
+
+    /// Returns counter of data modifications: it is changed when store is registered or
+    /// data is added, updated or removed. Starts from zero for every instance.
+    std::uint64_t getVersion() const;
+
+    /// Gets version of data of quadkey in all registered stores which is the same in every
+    /// process while stores and their data are not changed. Returns false if some store keeps
+    /// data of quadkey only in memory.
+    bool getDataVersion(const QuadKey& quadKey, std::uint64_t& version);
+
+    /// Returns approximate amount of bytes kept in memory by every registered store.
+    std::map<std::string, std::size_t> getMemoryUsage();
+
 private:
     class GeoStoreImpl;
     std::unique_ptr<GeoStoreImpl> pimpl_;
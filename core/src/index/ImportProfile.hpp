@@ -0,0 +1,183 @@
+#ifndef INDEX_IMPORTPROFILE_HPP_DEFINED
+#define INDEX_IMPORTPROFILE_HPP_DEFINED
+
+#include "QuadKey.hpp"
+#include "entities/Element.hpp"
+#include "entities/ElementVisitor.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace utymap { namespace index {
+
+/// Amount of data imported into single tile.
+struct TileImportSize final
+{
+    utymap::QuadKey quadKey;
+    /// Amount of element parts stored in tile.
+    std::size_t fragments;
+    /// Amount of bytes written by store before compression.
+    std::size_t bytes;
+};
+
+/// Collects throughput and tile sizes of single file import: imported elements by type, stored
+/// fragments (clipped or whole elements) per level of detail and bytes written per tile. Thread safe.
+class ImportProfile final
+{
+public:
+    enum class ElementType { Node, Way, Area, Relation, Count };
+
+    ImportProfile() : start_(std::chrono::steady_clock::now()), seconds_(0)
+    {
+        for (auto& count : elements_)
+            count = 0;
+    }
+
+    ImportProfile(const ImportProfile&) = delete;
+    ImportProfile& operator=(const ImportProfile&) = delete;
+
+    /// Counts element which is passed to store.
+    void addElement(const utymap::entities::Element& element)
+    {
+        TypeVisitor visitor;
+        element.accept(visitor);
+        elements_[static_cast<int>(visitor.type)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Counts fragment stored in given tile.
+    void addFragment(const utymap::QuadKey& quadKey)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        ++getTile(quadKey).fragments;
+        if (quadKey.levelOfDetail >= static_cast<int>(fragments_.size()))
+            fragments_.resize(quadKey.levelOfDetail + 1, 0);
+        ++fragments_[quadKey.levelOfDetail];
+    }
+
+    /// Adds bytes written to given tile.
+    void addBytes(const utymap::QuadKey& quadKey, std::size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        getTile(quadKey).bytes += bytes;
+    }
+
+    /// Stops time measurement.
+    void finish()
+    {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+        seconds_ = elapsed.count();
+    }
+
+    double getSeconds() const { return seconds_; }
+
+    std::size_t getElementCount(ElementType type) const
+    {
+        return elements_[static_cast<int>(type)].load(std::memory_order_relaxed);
+    }
+
+    /// Returns amount of fragments stored at given level of detail.
+    std::size_t getFragmentCount(int levelOfDetail) const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        return levelOfDetail >= 0 && levelOfDetail < static_cast<int>(fragments_.size())
+            ? fragments_[levelOfDetail]
+            : 0;
+    }
+
+    /// Returns given amount of tiles with the most bytes written, heaviest first.
+    std::vector<TileImportSize> getHeaviestTiles(std::size_t count) const
+    {
+        std::vector<TileImportSize> tiles;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            tiles.reserve(tiles_.size());
+            for (const auto& pair : tiles_)
+                tiles.push_back(pair.second);
+        }
+        count = std::min(count, tiles.size());
+        std::partial_sort(tiles.begin(), tiles.begin() + count, tiles.end(),
+            [](const TileImportSize& left, const TileImportSize& right) { return left.bytes > right.bytes; });
+        tiles.resize(count);
+        return tiles;
+    }
+
+    /// Returns profile as json object with given amount of heaviest tiles.
+    std::string toJson(std::size_t tileCount) const
+    {
+        static const char* typeNames[] = { "node", "way", "area", "relation" };
+        double seconds = std::max(seconds_, 1E-9);
+
+        std::stringstream ss;
+        ss << "{\"seconds\":" << seconds_ << ",\"elements\":{";
+        for (int i = 0; i < static_cast<int>(ElementType::Count); ++i) {
+            std::size_t count = getElementCount(static_cast<ElementType>(i));
+            ss << (i == 0 ? "" : ",") << "\"" << typeNames[i] << "\":{\"count\":" << count
+               << ",\"per_second\":" << count / seconds << "}";
+        }
+
+        ss << "},\"fragments\":{";
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            bool isFirst = true;
+            for (std::size_t lod = 0; lod < fragments_.size(); ++lod) {
+                if (fragments_[lod] == 0)
+                    continue;
+                ss << (isFirst ? "" : ",") << "\"" << lod << "\":" << fragments_[lod];
+                isFirst = false;
+            }
+            ss << "},\"tiles\":" << tiles_.size();
+        }
+
+        ss << ",\"heaviest_tiles\":[";
+        auto tiles = getHeaviestTiles(tileCount);
+        for (std::size_t i = 0; i < tiles.size(); ++i) {
+            const auto& tile = tiles[i];
+            ss << (i == 0 ? "" : ",") << "{\"lod\":" << tile.quadKey.levelOfDetail << ",\"x\":" << tile.quadKey.tileX
+               << ",\"y\":" << tile.quadKey.tileY << ",\"fragments\":" << tile.fragments << ",\"bytes\":" << tile.bytes << "}";
+        }
+        ss << "]}";
+        return ss.str();
+    }
+
+private:
+    typedef std::tuple<int, int, int> TileKey;
+
+    struct TypeVisitor final : public utymap::entities::ElementVisitor
+    {
+        ElementType type = ElementType::Node;
+
+        void visitNode(const utymap::entities::Node&) override { type = ElementType::Node; }
+        void visitWay(const utymap::entities::Way&) override { type = ElementType::Way; }
+        void visitArea(const utymap::entities::Area&) override { type = ElementType::Area; }
+        void visitRelation(const utymap::entities::Relation&) override { type = ElementType::Relation; }
+    };
+
+    /// Returns tile size adding it if necessary. Should be called under lock.
+    TileImportSize& getTile(const utymap::QuadKey& quadKey)
+    {
+        auto pair = tiles_.emplace(TileKey(quadKey.levelOfDetail, quadKey.tileX, quadKey.tileY),
+                                   TileImportSize { quadKey, 0, 0 });
+        return pair.first->second;
+    }
+
+    const std::chrono::steady_clock::time_point start_;
+    double seconds_;
+    std::array<std::atomic<std::size_t>, static_cast<int>(ElementType::Count)> elements_;
+
+    mutable std::mutex lock_;
+    std::vector<std::size_t> fragments_;
+    std::map<TileKey, TileImportSize> tiles_;
+};
+
+}}
+
+#endif // INDEX_IMPORTPROFILE_HPP_DEFINED
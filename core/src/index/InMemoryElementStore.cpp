@@ -1,101 +1,394 @@
+#include "entities/ElementBatch.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
 #include "index/InMemoryElementStore.hpp"
+#include "index/SearchControl.hpp"
+#include "index/TagIndex.hpp"
 
-#include <map>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 using namespace utymap;
 using namespace utymap::index;
 using namespace utymap::entities;
 using namespace utymap::mapcss;
+using namespace utymap::utils;
 
-namespace {
-    struct QuadKeyComparator
+class InMemoryElementStore::InMemoryElementStoreImpl
+{
+    /// Elements are split into segments which are shared with running searches: segment which
+    /// is pinned by search is never changed, so writes append new segment or copy changed one.
+    typedef std::vector<std::shared_ptr<ElementBatch>> Segments;
+    /// Pinned segments of tile which are visited by search without lock.
+    typedef std::vector<std::shared_ptr<const ElementBatch>> Snapshot;
+
+    /// Amount of segments after which tile segments are merged into one.
+    static const std::size_t MaxSegments = 16;
+
+    /// Elements of single quadkey with tile position in LRU list.
+    struct Tile final
     {
-        bool operator() (const QuadKey& lhs, const QuadKey& rhs) const
+        Segments segments;
+        /// Key: element id, value: fingerprint of style used to store element.
+        std::unordered_map<std::uint64_t, StyleFingerprint> fingerprints;
+        /// Index of element tags built by first tag search and reset by changes.
+        std::shared_ptr<const TagIndex> tagIndex;
+        /// Version of store when tile was changed last time.
+        std::uint64_t version;
+        std::list<std::uint64_t>::iterator lruPosition;
+        int levelOfDetail;
+    };
+
+    /// Calls spill callback for every visited element.
+    class SpillVisitor final : public ElementVisitor
+    {
+    public:
+        SpillVisitor(const QuadKey& quadKey, const SpillCallback& callback) :
+            quadKey_(quadKey), callback_(callback)
         {
-            if (lhs.levelOfDetail == rhs.levelOfDetail) {
-                if (lhs.tileX == rhs.tileX) {
-                    return lhs.tileY < rhs.tileY;
-                }
-                return lhs.tileX < rhs.tileX;
-            }
-            return lhs.levelOfDetail < rhs.levelOfDetail;
         }
+
+        void visitNode(const Node& node) override { callback_(node, quadKey_); }
+
+        void visitWay(const Way& way) override { callback_(way, quadKey_); }
+
+        void visitArea(const Area& area) override { callback_(area, quadKey_); }
+
+        void visitRelation(const Relation& relation) override { callback_(relation, quadKey_); }
+
+    private:
+        const QuadKey& quadKey_;
+        const SpillCallback& callback_;
     };
 
-    typedef std::vector<std::shared_ptr<Element>> Elements;
-    typedef std::map<QuadKey, Elements, QuadKeyComparator> ElementMap;
+ public:
+    InMemoryElementStoreImpl(std::size_t memoryLimit, const SpillCallback& spillCallback) :
+        memoryLimit_(memoryLimit), spillCallback_(spillCallback), usedBytes_(0),
+        memoryUsage_(GeoUtils::MaxLevelOfDetails + 1, 0), tiles_(), lru_(), version_(0)
+    {
+    }
 
-    class ElementMapVisitor : public ElementVisitor
+    /// Stores element and returns amount of written bytes.
+    std::size_t store(const Element& element, const QuadKey& quadKey)
     {
-    public:
-        ElementMapVisitor(const QuadKey& quadKey, ElementMap& elementsMap) :
-            quadKey_(quadKey), elementsMap_(elementsMap)
-        {
+        std::lock_guard<std::mutex> lock(lock_);
+        std::uint64_t key = PackedQuadKey(quadKey).value;
+        Tile& tile = getTile(key, quadKey.levelOfDetail);
+        std::size_t memoryUsage = getMemoryUsage(tile);
+
+        ElementBatch& elements = getTail(tile);
+        std::size_t size = elements.getSize();
+        elements.add(element);
+        tile.tagIndex.reset();
+        tile.version = ++version_;
+        std::size_t writtenBytes = elements.getSize() - size;
+
+        updateUsage(tile.levelOfDetail, memoryUsage, getMemoryUsage(tile));
+        evictIfNecessary(key);
+        return writtenBytes;
+    }
+
+    void remove(std::uint64_t id, const QuadKey& quadKey)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto tilePair = tiles_.find(PackedQuadKey(quadKey).value);
+        if (tilePair == tiles_.end())
+            return;
+
+        Tile& tile = tilePair->second;
+        std::size_t memoryUsage = getMemoryUsage(tile);
+        bool isRemoved = false;
+        for (auto it = tile.segments.begin(); it != tile.segments.end();) {
+            if (!(*it)->contains(id)) {
+                ++it;
+                continue;
+            }
+            // NOTE only segment with element is copied if it is pinned by search.
+            if (it->use_count() > 1)
+                *it = std::make_shared<ElementBatch>(**it);
+            (*it)->erase(id);
+            isRemoved = true;
+            it = (*it)->empty() ? tile.segments.erase(it) : it + 1;
         }
+        if (!isRemoved)
+            return;
 
-        void visitNode(const utymap::entities::Node& node) override
-        {
-            elementsMap_[quadKey_].push_back(std::make_shared<Node>(node));
+        tile.fingerprints.erase(id);
+        tile.tagIndex.reset();
+        tile.version = ++version_;
+        updateUsage(tile.levelOfDetail, memoryUsage, getMemoryUsage(tile));
+
+        if (tile.segments.empty()) {
+            lru_.erase(tile.lruPosition);
+            tiles_.erase(tilePair);
         }
+    }
 
-        void visitWay(const utymap::entities::Way& way) override
-        {
-            elementsMap_[quadKey_].push_back(std::make_shared<Way>(way));
+    void storeFingerprint(std::uint64_t id, const QuadKey& quadKey, const StyleFingerprint& fingerprint)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        // NOTE tile might be already evicted by concurrent store.
+        auto tilePair = tiles_.find(PackedQuadKey(quadKey).value);
+        if (tilePair != tiles_.end())
+            tilePair->second.fingerprints[id] = fingerprint;
+    }
+
+    bool findFingerprint(const QuadKey& quadKey, std::uint64_t id, StyleFingerprint& fingerprint) const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto tilePair = tiles_.find(PackedQuadKey(quadKey).value);
+        if (tilePair == tiles_.end())
+            return false;
+
+        auto fingerprintPair = tilePair->second.fingerprints.find(id);
+        if (fingerprintPair == tilePair->second.fingerprints.end())
+            return false;
+
+        fingerprint = fingerprintPair->second;
+        return true;
+    }
+
+    void search(const QuadKey& quadKey, ElementVisitor& visitor)
+    {
+        // NOTE elements are visited without lock: they are kept alive and unchanged by pin.
+        Snapshot segments = pin(quadKey);
+
+        const SearchControl* control = SearchControl::of(visitor);
+        for (const auto& elements : segments) {
+            if (SearchControl::isStopped(control))
+                return;
+            elements->forEachWhile([&](Element& element) {
+                element.accept(visitor);
+                return !SearchControl::isStopped(control);
+            });
         }
+    }
 
-        void visitArea(const utymap::entities::Area& area) override
+    void searchByTag(const QuadKey& quadKey, const std::vector<Tag>& tags, ElementVisitor& visitor)
+    {
+        std::shared_ptr<const TagIndex> tagIndex;
+        std::uint64_t version;
+        Snapshot segments;
         {
-            elementsMap_[quadKey_].push_back(std::make_shared<Area>(area));
+            std::lock_guard<std::mutex> lock(lock_);
+            auto tilePair = tiles_.find(PackedQuadKey(quadKey).value);
+            if (tilePair == tiles_.end())
+                return;
+
+            // NOTE positions refer to pinned elements which are not changed by concurrent store.
+            Tile& tile = tilePair->second;
+            touch(tile);
+            tagIndex = tile.tagIndex;
+            version = tile.version;
+            segments.assign(tile.segments.begin(), tile.segments.end());
         }
 
-        void visitRelation(const utymap::entities::Relation& relation) override
-        {
-            elementsMap_[quadKey_].push_back(std::make_shared<Relation>(relation));
+        // NOTE index is built from pinned segments without lock and kept only if tile is not
+        // changed meanwhile: version is unique across tiles, so recreated tile does not match.
+        if (tagIndex == nullptr) {
+            auto builtIndex = std::make_shared<TagIndex>();
+            std::uint32_t position = 0;
+            for (const auto& elements : segments)
+                elements->forEach([&](Element& element) { builtIndex->add(position++, element.tags); });
+            tagIndex = builtIndex;
+
+            std::lock_guard<std::mutex> lock(lock_);
+            auto tilePair = tiles_.find(PackedQuadKey(quadKey).value);
+            if (tilePair != tiles_.end() && tilePair->second.version == version)
+                tilePair->second.tagIndex = tagIndex;
         }
-    private:
-        const QuadKey& quadKey_;
-        ElementMap& elementsMap_;
-    };
-}
+        std::vector<std::uint32_t> positions = tagIndex->find(tags);
 
-class InMemoryElementStore::InMemoryElementStoreImpl
-{
- public:
-    ElementMap elementsMap;
+        // NOTE positions are counted through all segments, so they are shifted to segment ones.
+        const SearchControl* control = SearchControl::of(visitor);
+        std::uint32_t offset = 0;
+        auto position = positions.begin();
+        for (const auto& elements : segments) {
+            std::uint32_t end = offset + static_cast<std::uint32_t>(elements->size());
+            std::vector<std::uint32_t> segmentPositions;
+            for (; position != positions.end() && *position < end; ++position)
+                segmentPositions.push_back(*position - offset);
+            elements->forEach(segmentPositions, [&](Element& element) {
+                if (!SearchControl::isStopped(control))
+                    element.accept(visitor);
+            });
+            offset = end;
+        }
+    }
 
-    ElementMap::const_iterator begin(const utymap::QuadKey& quadKey) const
+    void searchById(const QuadKey& quadKey, std::uint64_t id, ElementVisitor& visitor)
     {
-        return elementsMap.find(quadKey);
+        for (const auto& elements : pin(quadKey))
+            elements->forEachWithId(id, [&](Element& element) { element.accept(visitor); });
     }
 
-    ElementMap::const_iterator end() const
+    bool hasData(const utymap::QuadKey& quadKey) const
     {
-        return elementsMap.cend();
+        std::lock_guard<std::mutex> lock(lock_);
+        return tiles_.find(PackedQuadKey(quadKey).value) != tiles_.end();
     }
 
-    bool hasData(const utymap::QuadKey& quadKey) const
+    std::size_t getMemoryUsage(int levelOfDetail) const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        return levelOfDetail >= 0 && levelOfDetail < static_cast<int>(memoryUsage_.size())
+            ? memoryUsage_[levelOfDetail]
+            : 0;
+    }
+
+    std::size_t getMemoryUsage() const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        return usedBytes_;
+    }
+
+private:
+    /// Gets existing or creates new tile and marks it as most recently used.
+    Tile& getTile(std::uint64_t key, int levelOfDetail)
+    {
+        auto tilePair = tiles_.find(key);
+        if (tilePair != tiles_.end()) {
+            touch(tilePair->second);
+            return tilePair->second;
+        }
+
+        lru_.push_front(key);
+        Tile& tile = tiles_[key];
+        tile.lruPosition = lru_.begin();
+        tile.levelOfDetail = levelOfDetail;
+        tile.version = ++version_;
+        return tile;
+    }
+
+    /// Returns last segment of tile which can be appended: new segment is started if last one
+    /// is pinned by search. Segments are merged if there are too many of them.
+    static ElementBatch& getTail(Tile& tile)
+    {
+        if (!tile.segments.empty() && tile.segments.back().use_count() == 1)
+            return *tile.segments.back();
+
+        if (tile.segments.size() >= MaxSegments) {
+            auto merged = std::make_shared<ElementBatch>();
+            for (const auto& elements : tile.segments)
+                elements->forEach([&](Element& element) { merged->add(element); });
+            tile.segments.assign(1, merged);
+            return *merged;
+        }
+
+        tile.segments.push_back(std::make_shared<ElementBatch>());
+        return *tile.segments.back();
+    }
+
+    static std::size_t getMemoryUsage(const Tile& tile)
+    {
+        std::size_t memoryUsage = 0;
+        for (const auto& elements : tile.segments)
+            memoryUsage += elements->getMemoryUsage();
+        return memoryUsage;
+    }
+
+    /// Returns segments of tile marking it as most recently used. Empty if there is no tile.
+    Snapshot pin(const QuadKey& quadKey)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto tilePair = tiles_.find(PackedQuadKey(quadKey).value);
+        if (tilePair == tiles_.end())
+            return Snapshot();
+
+        touch(tilePair->second);
+        return Snapshot(tilePair->second.segments.begin(), tilePair->second.segments.end());
+    }
+
+    /// Marks tile as most recently used. Should be called under lock as searches reorder list too.
+    void touch(Tile& tile)
     {
-        return elementsMap.find(quadKey) != elementsMap.end();
-    }  
+        lru_.splice(lru_.begin(), lru_, tile.lruPosition);
+    }
+
+    void updateUsage(int levelOfDetail, std::size_t oldSize, std::size_t newSize)
+    {
+        usedBytes_ += newSize - oldSize;
+        memoryUsage_[levelOfDetail] += newSize - oldSize;
+    }
+
+    /// Evicts least recently used tiles while memory limit is exceeded. Current tile is never evicted.
+    void evictIfNecessary(std::uint64_t currentKey)
+    {
+        if (memoryLimit_ == 0)
+            return;
+
+        while (usedBytes_ > memoryLimit_ && lru_.back() != currentKey) {
+            std::uint64_t key = lru_.back();
+            auto tilePair = tiles_.find(key);
+            Tile& tile = tilePair->second;
+
+            if (spillCallback_ != nullptr) {
+                QuadKey quadKey = PackedQuadKey::fromValue(key).unpack();
+                SpillVisitor visitor(quadKey, spillCallback_);
+                for (const auto& elements : tile.segments)
+                    elements->accept(visitor);
+            }
+
+            updateUsage(tile.levelOfDetail, getMemoryUsage(tile), 0);
+            tiles_.erase(tilePair);
+            lru_.pop_back();
+        }
+    }
+
+    const std::size_t memoryLimit_;
+    const SpillCallback spillCallback_;
+    std::size_t usedBytes_;
+    /// Used bytes per level of detail.
+    std::vector<std::size_t> memoryUsage_;
+    /// Key: packed quadkey, value: tile elements.
+    std::unordered_map<std::uint64_t, Tile> tiles_;
+    /// Packed quadkeys ordered from most to least recently used.
+    std::list<std::uint64_t> lru_;
+    /// Incremented by every change of any tile.
+    std::uint64_t version_;
+    /// Guards tiles and LRU list: held by searches only while tile is found and pinned.
+    mutable std::mutex lock_;
 };
 
 InMemoryElementStore::InMemoryElementStore(StringTable& stringTable) :
-    ElementStore(stringTable), pimpl_(utymap::utils::make_unique<InMemoryElementStoreImpl>())
+    InMemoryElementStore(stringTable, 0, nullptr)
 {
 }
 
+InMemoryElementStore::InMemoryElementStore(StringTable& stringTable, std::size_t memoryLimit, SpillCallback spillCallback) :
+    ElementStore(stringTable), pimpl_(utymap::utils::make_unique<InMemoryElementStoreImpl>(memoryLimit, spillCallback))
+{
+    enableNameIndex();
+    enableIdIndex();
+}
+
 InMemoryElementStore::~InMemoryElementStore()
 {
 }
 
-void InMemoryElementStore::storeImpl(const utymap::entities::Element& element, const QuadKey& quadKey)
+void InMemoryElementStore::storeImpl(const utymap::entities::Element& element, const QuadKey& quadKey, const Style&)
+{
+    addWrittenBytes(quadKey, pimpl_->store(element, quadKey));
+}
+
+void InMemoryElementStore::storeFingerprint(std::uint64_t id, const QuadKey& quadKey, const StyleFingerprint& fingerprint)
+{
+    pimpl_->storeFingerprint(id, quadKey, fingerprint);
+}
+
+bool InMemoryElementStore::findFingerprint(const QuadKey& quadKey, std::uint64_t id, StyleFingerprint& fingerprint) const
 {
-    ElementMapVisitor visitor(quadKey, pimpl_->elementsMap);
-    element.accept(visitor);
+    return pimpl_->findFingerprint(quadKey, id, fingerprint);
+}
+
+void InMemoryElementStore::removeImpl(std::uint64_t id, const QuadKey& quadKey)
+{
+    pimpl_->remove(id, quadKey);
 }
 
 bool InMemoryElementStore::hasData(const utymap::QuadKey& quadKey) const
@@ -105,15 +398,30 @@ bool InMemoryElementStore::hasData(const utymap::QuadKey& quadKey) const
 
 void InMemoryElementStore::search(const utymap::QuadKey& quadKey, utymap::entities::ElementVisitor& visitor)
 {
-    auto it = pimpl_->begin(quadKey);
+    pimpl_->search(quadKey, visitor);
+}
 
-    // No elements for this quadkey
-    if (it == pimpl_->end())
-        return;
+void InMemoryElementStore::searchById(const QuadKey& quadKey, std::uint64_t id, ElementVisitor& visitor)
+{
+    pimpl_->searchById(quadKey, id, visitor);
+}
 
-    for (const auto& element : it->second) {
-        element->accept(visitor);
-    }
+void InMemoryElementStore::searchByTag(const QuadKey& quadKey, const BoundingBox&, const std::vector<Tag>& tags, ElementVisitor& visitor)
+{
+    if (tags.empty())
+        pimpl_->search(quadKey, visitor);
+    else
+        pimpl_->searchByTag(quadKey, tags, visitor);
+}
+
+std::size_t InMemoryElementStore::getMemoryUsage(int levelOfDetail) const
+{
+    return pimpl_->getMemoryUsage(levelOfDetail);
+}
+
+std::size_t InMemoryElementStore::getMemoryUsage() const
+{
+    return pimpl_->getMemoryUsage();
 }
 
 void InMemoryElementStore::commit()
@@ -5,8 +5,10 @@
 #include "entities/Element.hpp"
 #include "index/ElementStore.hpp"
 
+#include <functional>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace utymap { namespace index {
 
@@ -14,19 +16,56 @@ namespace utymap { namespace index {
 class InMemoryElementStore final : public ElementStore
 {
 public:
+    /// Defines callback which receives elements of evicted tiles.
+    typedef std::function<void(const utymap::entities::Element&, const utymap::QuadKey&)> SpillCallback;
+
     explicit InMemoryElementStore(utymap::index::StringTable& stringTable);
 
+    /// Creates store which evicts least recently used tiles when memory limit in bytes is exceeded.
+    /// Evicted elements are passed to spill callback if it is set, e.g. to store them in persistent store.
+    InMemoryElementStore(utymap::index::StringTable& stringTable,
+                         std::size_t memoryLimit,
+                         SpillCallback spillCallback = nullptr);
+
     virtual ~InMemoryElementStore();
 
     void search(const utymap::QuadKey& quadKey, 
                 utymap::entities::ElementVisitor& visitor) override;
 
+    void searchById(const utymap::QuadKey& quadKey,
+                    std::uint64_t id,
+                    utymap::entities::ElementVisitor& visitor) override;
+
+    /// Uses tag index of tile which is built by first search and kept till tile is changed.
+    void searchByTag(const utymap::QuadKey& quadKey,
+                      const utymap::BoundingBox& bbox,
+                      const std::vector<utymap::entities::Tag>& tags,
+                      utymap::entities::ElementVisitor& visitor) override;
+
     bool hasData(const utymap::QuadKey& quadKey) const override;
 
+    bool findFingerprint(const utymap::QuadKey& quadKey,
+                         std::uint64_t id,
+                         StyleFingerprint& fingerprint) const override;
+
     void commit() override;
 
+    /// Returns amount of bytes used by elements at given level of detail.
+    std::size_t getMemoryUsage(int levelOfDetail) const;
+
+    /// Returns amount of bytes used by elements at all levels of detail.
+    std::size_t getMemoryUsage() const override;
+
 protected:
-    void storeImpl(const utymap::entities::Element& element, const utymap::QuadKey& quadKey) override;
+    void storeImpl(const utymap::entities::Element& element,
+                   const utymap::QuadKey& quadKey,
+                   const utymap::mapcss::Style& style) override;
+
+    void storeFingerprint(std::uint64_t id,
+                          const utymap::QuadKey& quadKey,
+                          const StyleFingerprint& fingerprint) override;
+
+    void removeImpl(std::uint64_t id, const utymap::QuadKey& quadKey) override;
 
 private:
     class InMemoryElementStoreImpl;
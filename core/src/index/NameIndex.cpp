@@ -0,0 +1,292 @@
+#include "index/NameIndex.hpp"
+#include "utils/GeoUtils.hpp"
+#include "utils/VarintUtils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+
+using namespace utymap;
+using namespace utymap::entities;
+using namespace utymap::index;
+
+namespace {
+    ///                                     Name index file format
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Header       |  Magic (4b) and amount of names (4b)                                              |
+    ///------------------------------------------------------------------------------------------------------|
+    ///      Names       |  Sorted by normalized name. Every name is length of prefix shared with previous   |
+    ///                  |  normalized name, length and bytes of the rest of it, length and bytes of         |
+    ///                  |  original name (zero if it is the same), element id, latitude and longitude.      |
+    ///------------------------------------------------------------------------------------------------------|
+    /// Lengths and id are varints, coordinates are fixed point (1e-7 degree) 4b values.
+    const std::uint32_t Magic = 0x31494E55;
+    const std::string NameKeyPrefix = "name";
+    const double CoordinatePrecision = 1E7;
+
+    /// Reads values of index file checking its size.
+    class IndexReader final
+    {
+    public:
+        IndexReader(const std::string& data, std::size_t position) :
+            data_(data), position_(position)
+        {
+        }
+
+        bool readVarint(std::uint64_t& value)
+        {
+            return utymap::utils::readVarint(data_, position_, value);
+        }
+
+        bool readString(std::size_t size, std::string& value)
+        {
+            if (position_ + size > data_.size())
+                return false;
+            value.append(data_, position_, size);
+            position_ += size;
+            return true;
+        }
+
+        bool readCoordinate(double& value)
+        {
+            std::int32_t fixed;
+            if (position_ + sizeof(fixed) > data_.size())
+                return false;
+            std::memcpy(&fixed, &data_[position_], sizeof(fixed));
+            position_ += sizeof(fixed);
+            value = fixed / CoordinatePrecision;
+            return true;
+        }
+
+    private:
+        const std::string& data_;
+        std::size_t position_;
+    };
+
+    void writeCoordinate(std::string& data, double value)
+    {
+        std::int32_t fixed = static_cast<std::int32_t>(std::lround(value * CoordinatePrecision));
+        data.append(reinterpret_cast<const char*>(&fixed), sizeof(fixed));
+    }
+
+    bool isSeparator(char c)
+    {
+        return std::strchr(" \t\r\n-_.,;:'\"()/", c) != nullptr;
+    }
+}
+
+NameIndex::NameIndex(const StringTable& stringTable) :
+    stringTable_(stringTable), entries_(), isSorted_(true), isChanged_(false), sequence_(0),
+    removals_(), nameKeys_(), lock_()
+{
+}
+
+void NameIndex::add(const Element& element, const GeoCoordinate& coordinate)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    for (const auto& tag : element.tags) {
+        if (!isNameKey(tag.key))
+            continue;
+
+        std::string name = stringTable_.getString(tag.value);
+        std::string key = normalize(name);
+        if (key.empty())
+            continue;
+        if (key == name)
+            name.clear();
+
+        entries_.push_back(Entry { std::move(key), std::move(name), element.id, coordinate, ++sequence_ });
+        isSorted_ = false;
+        isChanged_ = true;
+    }
+}
+
+void NameIndex::remove(std::uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    removals_[id] = ++sequence_;
+    isSorted_ = false;
+}
+
+std::vector<NameIndex::Match> NameIndex::find(const std::string& prefix, const GeoCoordinate& coordinate, std::size_t maxResults) const
+{
+    std::string key = normalize(prefix);
+    std::vector<Match> matches;
+    if (key.empty() || maxResults == 0)
+        return matches;
+
+    std::lock_guard<std::mutex> lock(lock_);
+    prepare();
+
+    auto begin = std::lower_bound(entries_.begin(), entries_.end(), key, [](const Entry& entry, const std::string& value) {
+        return entry.key < value;
+    });
+    std::unordered_set<std::uint64_t> ids;
+    for (auto entry = begin; entry != entries_.end() && entry->key.compare(0, key.size(), key) == 0; ++entry) {
+        // NOTE element with several matching names is reported by the first one.
+        if (!ids.insert(entry->id).second)
+            continue;
+        matches.push_back(Match { entry->id, entry->name.empty() ? entry->key : entry->name, entry->coordinate,
+                                  utymap::utils::GeoUtils::distance(coordinate, entry->coordinate) });
+    }
+
+    auto last = matches.begin() + std::min(maxResults, matches.size());
+    std::partial_sort(matches.begin(), last, matches.end(), [](const Match& left, const Match& right) {
+        return left.distance < right.distance;
+    });
+    matches.erase(last, matches.end());
+    return matches;
+}
+
+bool NameIndex::read(const std::string& path)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.good())
+        return false;
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::uint32_t header[2];
+    if (data.size() < sizeof(header))
+        return false;
+    std::memcpy(header, data.data(), sizeof(header));
+    if (header[0] != Magic)
+        return false;
+
+    std::vector<Entry> entries;
+    entries.reserve(header[1]);
+    IndexReader reader(data, sizeof(header));
+    std::string key;
+    for (std::uint32_t i = 0; i < header[1]; ++i) {
+        std::uint64_t sharedSize, suffixSize, nameSize, id;
+        Entry entry;
+        if (!reader.readVarint(sharedSize) || sharedSize > key.size() || !reader.readVarint(suffixSize))
+            return false;
+        key.resize(static_cast<std::size_t>(sharedSize));
+        if (!reader.readString(static_cast<std::size_t>(suffixSize), key) ||
+            !reader.readVarint(nameSize) || !reader.readString(static_cast<std::size_t>(nameSize), entry.name) ||
+            !reader.readVarint(id) ||
+            !reader.readCoordinate(entry.coordinate.latitude) || !reader.readCoordinate(entry.coordinate.longitude))
+            return false;
+
+        entry.key = key;
+        entry.id = id;
+        entry.sequence = 0;
+        entries.push_back(std::move(entry));
+    }
+
+    std::lock_guard<std::mutex> lock(lock_);
+    entries_.swap(entries);
+    removals_.clear();
+    isSorted_ = true;
+    isChanged_ = false;
+    return true;
+}
+
+void NameIndex::write(const std::string& path) const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    prepare();
+    if (!isChanged_)
+        return;
+
+    std::uint32_t header[2] = { Magic, static_cast<std::uint32_t>(entries_.size()) };
+    std::string data(reinterpret_cast<const char*>(header), sizeof(header));
+    const std::string* previous = nullptr;
+    for (const auto& entry : entries_) {
+        std::size_t sharedSize = 0;
+        if (previous != nullptr) {
+            std::size_t maxSize = std::min(previous->size(), entry.key.size());
+            while (sharedSize < maxSize && (*previous)[sharedSize] == entry.key[sharedSize])
+                ++sharedSize;
+        }
+        utymap::utils::writeVarint(data, sharedSize);
+        utymap::utils::writeVarint(data, entry.key.size() - sharedSize);
+        data.append(entry.key, sharedSize, std::string::npos);
+        utymap::utils::writeVarint(data, entry.name.size());
+        data.append(entry.name);
+        utymap::utils::writeVarint(data, entry.id);
+        writeCoordinate(data, entry.coordinate.latitude);
+        writeCoordinate(data, entry.coordinate.longitude);
+        previous = &entry.key;
+    }
+
+    // NOTE file is replaced only when it is completely written.
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(data.data(), data.size());
+        if (!file.good())
+            return;
+    }
+    std::remove(path.c_str());
+    isChanged_ = std::rename(tmpPath.c_str(), path.c_str()) != 0;
+}
+
+std::size_t NameIndex::size() const
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    prepare();
+    return entries_.size();
+}
+
+std::string NameIndex::normalize(const std::string& name)
+{
+    std::string result;
+    result.reserve(name.size());
+    bool hasSeparator = false;
+    for (char c : name) {
+        if (isSeparator(c)) {
+            hasSeparator = !result.empty();
+            continue;
+        }
+        if (hasSeparator)
+            result.push_back(' ');
+        hasSeparator = false;
+        // NOTE only ascii letters are folded: bytes of utf-8 sequences are kept as they are.
+        result.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c);
+    }
+    return result;
+}
+
+void NameIndex::prepare() const
+{
+    if (isSorted_)
+        return;
+
+    if (!removals_.empty()) {
+        auto end = std::remove_if(entries_.begin(), entries_.end(), [&](const Entry& entry) {
+            auto removal = removals_.find(entry.id);
+            return removal != removals_.end() && removal->second > entry.sequence;
+        });
+        isChanged_ = isChanged_ || end != entries_.end();
+        entries_.erase(end, entries_.end());
+        removals_.clear();
+    }
+
+    // NOTE the latest entry is kept when the same name of element is added again.
+    std::sort(entries_.begin(), entries_.end(), [](const Entry& left, const Entry& right) {
+        int order = left.key.compare(right.key);
+        if (order != 0)
+            return order < 0;
+        return left.id != right.id ? left.id < right.id : left.sequence > right.sequence;
+    });
+    entries_.erase(std::unique(entries_.begin(), entries_.end(), [](const Entry& left, const Entry& right) {
+        return left.key == right.key && left.id == right.id;
+    }), entries_.end());
+    isSorted_ = true;
+}
+
+bool NameIndex::isNameKey(std::uint32_t key) const
+{
+    auto nameKey = nameKeys_.find(key);
+    if (nameKey != nameKeys_.end())
+        return nameKey->second;
+
+    bool isName = stringTable_.getString(key).compare(0, NameKeyPrefix.size(), NameKeyPrefix) == 0;
+    nameKeys_[key] = isName;
+    return isName;
+}
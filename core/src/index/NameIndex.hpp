@@ -0,0 +1,95 @@
+#ifndef INDEX_NAMEINDEX_HPP_DEFINED
+#define INDEX_NAMEINDEX_HPP_DEFINED
+
+#include "GeoCoordinate.hpp"
+#include "entities/Element.hpp"
+#include "index/StringTable.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace utymap { namespace index {
+
+/// Index of element names for offline geocoding. Values of tags which keys start with "name"
+/// are normalized and kept sorted, so elements are found by name prefix.
+class NameIndex final
+{
+public:
+    /// Element which name starts with searched prefix.
+    struct Match final
+    {
+        std::uint64_t id;
+        /// Original name value.
+        std::string name;
+        /// Position of element: center of its bounding box.
+        utymap::GeoCoordinate coordinate;
+        /// Distance in meters to position of search.
+        double distance;
+    };
+
+    explicit NameIndex(const utymap::index::StringTable& stringTable);
+
+    /// Adds names of element with given position. Element without name tags is ignored.
+    void add(const utymap::entities::Element& element, const utymap::GeoCoordinate& coordinate);
+
+    /// Removes names of element with given id added before.
+    void remove(std::uint64_t id);
+
+    /// Finds elements which have name starting with given prefix and returns given amount of
+    /// the closest to coordinate ones ordered by distance. Every element is returned once.
+    std::vector<Match> find(const std::string& prefix,
+                            const utymap::GeoCoordinate& coordinate,
+                            std::size_t maxResults) const;
+
+    /// Reads index from file replacing current names. Returns false if file is missing or invalid.
+    bool read(const std::string& path);
+
+    /// Writes index to file if it is changed since it is read or written. File is written aside
+    /// and replaces existing one when it is complete.
+    void write(const std::string& path) const;
+
+    /// Returns amount of indexed names.
+    std::size_t size() const;
+
+    /// Returns name in the form used for search: lower case with separators replaced by single space.
+    static std::string normalize(const std::string& name);
+
+private:
+    struct Entry final
+    {
+        /// Normalized name.
+        std::string key;
+        /// Original name, empty if it is the same as key.
+        std::string name;
+        std::uint64_t id;
+        utymap::GeoCoordinate coordinate;
+        /// Order of addition used to apply removals.
+        std::uint64_t sequence;
+    };
+
+    /// Sorts added entries dropping removed and duplicate ones. Should be called under lock.
+    void prepare() const;
+
+    /// Checks whether tag key is name key. Should be called under lock.
+    bool isNameKey(std::uint32_t key) const;
+
+    const utymap::index::StringTable& stringTable_;
+    mutable std::vector<Entry> entries_;
+    /// Whether entries are added or removed since they are sorted.
+    mutable bool isSorted_;
+    mutable bool isChanged_;
+    std::uint64_t sequence_;
+    /// Key: element id, value: sequence of its removal.
+    mutable std::unordered_map<std::uint64_t, std::uint64_t> removals_;
+    /// Key: tag key id, value: whether it is name key.
+    mutable std::unordered_map<std::uint32_t, bool> nameKeys_;
+    mutable std::mutex lock_;
+};
+
+}}
+
+#endif // INDEX_NAMEINDEX_HPP_DEFINED
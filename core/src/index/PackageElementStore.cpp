@@ -0,0 +1,644 @@
+#include "BoundingBox.hpp"
+#include "index/ElementEncoding.hpp"
+#include "index/ElementPrefilter.hpp"
+#include "index/PackageElementStore.hpp"
+#include "index/SearchControl.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/FileUtils.hpp"
+#include "utils/GeoUtils.hpp"
+#include "utils/MappedFile.hpp"
+#include "utils/TraceRecorder.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::index;
+using namespace utymap::entities;
+using namespace utymap::mapcss;
+using namespace utymap::utils;
+
+namespace {
+    ///                                      Package file format
+    ///   DESCRIPTION    |                       DETAILS                                                     |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Header       |  Magic (4b), version (4b), amount of tiles (4b), reserved (4b) and                |
+    ///                  |  directory offset (8b)                                                            |
+    ///------------------------------------------------------------------------------------------------------|
+    ///   Tile blocks    |  Amount of index entries (4b), data size (4b), amount of previous blocks of tile  |
+    ///                  |  (4b), reserved (4b), offset (8b) and size (8b) of previous block of tile or zero,|
+    ///                  |  index entries and element data                                                   |
+    ///------------------------------------------------------------------------------------------------------|
+    ///    Directory     |  Tiles sorted by packed quadkey: key (8b), offset (8b) and size (8b) of the last  |
+    ///                  |  block of tile                                                                    |
+    ///------------------------------------------------------------------------------------------------------|
+    /// Index entries and element data use encoding of persistent store, entry offsets are relative to
+    /// element data of the block. Changed tiles are written as new blocks at the end of file which keep
+    /// only new entries and tombstones of removed elements, so tombstone hides entries of previous
+    /// blocks. When tile has too many blocks, they are merged into one without tombstones. New blocks
+    /// are followed by new directory and header is updated last, so interrupted write keeps previous
+    /// content. Replaced blocks stay in file until it is compacted. Blocks of the first version have
+    /// only amount of entries and data size: such package is compacted when it is opened.
+    const std::uint32_t PackageMagic = 0x474B5055;
+    const std::uint32_t PackageVersion = 2;
+    const std::uint32_t LegacyPackageVersion = 1;
+
+    struct PackageHeader final
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t tileCount;
+        std::uint32_t reserved;
+        std::uint64_t directoryOffset;
+    };
+    static_assert(sizeof(PackageHeader) == 24, "Unexpected package header size.");
+
+    /// Represents entry of tile directory.
+    struct TileBlock final
+    {
+        std::uint64_t key;
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+    static_assert(sizeof(TileBlock) == 24, "Unexpected tile block size.");
+
+    struct BlockHeader final
+    {
+        std::uint32_t entryCount;
+        std::uint32_t dataSize;
+        std::uint32_t depth;
+        std::uint32_t reserved;
+        std::uint64_t previousOffset;
+        std::uint64_t previousSize;
+    };
+    static_assert(sizeof(BlockHeader) == 32, "Unexpected block header size.");
+    const std::size_t LegacyBlockHeaderSize = 2 * sizeof(std::uint32_t);
+
+    /// Max amount of previous blocks of tile before its blocks are merged.
+    const std::uint32_t MaxBlockDepth = 7;
+
+    /// Points to content of tile block in mapped package or to pending data of tile.
+    struct BlockView final
+    {
+        std::uint32_t entryCount;
+        const char* entries;
+        std::uint32_t dataSize;
+        const char* data;
+        std::uint32_t depth;
+        std::uint64_t previousOffset;
+        std::uint64_t previousSize;
+    };
+
+    const std::string BuilderKey = "builders";
+    const BoundingBox WorldBoundingBox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
+
+    bool isLessKey(const TileBlock& block, std::uint64_t key)
+    {
+        return block.key < key;
+    }
+
+    /// Creates tile block from index entries and element data which is linked to previous block.
+    std::string createBlock(const std::string& indexBuffer, const std::string& dataBuffer,
+                            std::uint32_t depth, const TileBlock& previous)
+    {
+        BlockHeader header = { static_cast<std::uint32_t>(indexBuffer.size() / sizeof(IndexEntry)),
+                               static_cast<std::uint32_t>(dataBuffer.size()), depth, 0,
+                               previous.offset, previous.size };
+        std::string block;
+        block.reserve(sizeof(header) + indexBuffer.size() + dataBuffer.size());
+        block.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        block.append(indexBuffer).append(dataBuffer);
+        return block;
+    }
+}
+
+class PackageElementStore::PackageElementStoreImpl final
+{
+    /// Max amount of bytes kept in write buffers before they are written to package.
+    const std::size_t MaxBufferedBytes = 16 * 1024 * 1024;
+
+    /// Holds pending changes of single tile.
+    struct PendingTile final
+    {
+        std::string indexBuffer;
+        std::string dataBuffer;
+    };
+
+    /// NOTE tiles are ordered by packed quadkey, so changed blocks are written in directory order.
+    /// Tile is shared with searches which read it without lock, so it is copied before it is changed.
+    typedef std::map<std::uint64_t, std::shared_ptr<PendingTile>> PendingTiles;
+
+public:
+    PackageElementStoreImpl(const std::string& path, std::uint32_t builderKeyId)
+            : path_(path), builderKeyId_(builderKeyId), file_(), directory_(), isLegacy_(false),
+              pendingTiles_(), bufferedBytes_(0)
+    {
+        open();
+        if (isLegacy_)
+            compact();
+    }
+
+    /// Stores element and returns amount of written bytes.
+    std::size_t store(const Element& element, const QuadKey& quadKey, const Style& style)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        PendingTile& tile = getPendingTile(PackedQuadKey(quadKey).value);
+        std::size_t bufferedBytes = tile.dataBuffer.size() + tile.indexBuffer.size();
+
+        std::uint32_t offset = static_cast<std::uint32_t>(tile.dataBuffer.size());
+        ElementWriter writer(tile.dataBuffer, GeoUtils::quadKeyToBoundingBox(quadKey).minPoint);
+        element.accept(writer);
+
+        // NOTE element type is taken from flags which are just written
+        std::uint8_t elementType = tile.dataBuffer[offset] & 0x3;
+        IndexEntry entry = createIndexEntry(element, offset, elementType, style.getString(builderKeyId_));
+        tile.indexBuffer.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+
+        std::size_t writtenBytes = tile.dataBuffer.size() + tile.indexBuffer.size() - bufferedBytes;
+        bufferedBytes_ += writtenBytes;
+        if (bufferedBytes_ > MaxBufferedBytes)
+            flush();
+        return writtenBytes;
+    }
+
+    void remove(std::uint64_t id, const QuadKey& quadKey)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        IndexEntry entry = createTombstone(id);
+        getPendingTile(PackedQuadKey(quadKey).value).indexBuffer.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        bufferedBytes_ += sizeof(entry);
+        if (bufferedBytes_ > MaxBufferedBytes)
+            flush();
+    }
+
+    void search(const QuadKey& quadKey, const BoundingBox& bbox, std::uint32_t mask, ElementVisitor& visitor)
+    {
+        UTYMAP_TRACE_SCOPE("package_search", "io");
+        std::uint64_t key = PackedQuadKey(quadKey).value;
+
+        // NOTE elements are read without lock: mapping is kept alive even if package is rewritten
+        // and pending tile is copied by writer instead of being changed.
+        std::shared_ptr<const MappedFile> file;
+        TileBlock block = {};
+        std::shared_ptr<const PendingTile> tile;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            file = file_;
+            findBlock(key, block);
+            auto tilePair = pendingTiles_.find(key);
+            if (tilePair != pendingTiles_.end())
+                tile = tilePair->second;
+        }
+
+        std::vector<BlockView> views = getBlockViews(*file, block);
+        if (tile != nullptr)
+            views.push_back(getPendingView(*tile));
+
+        GeoCoordinate origin = GeoUtils::quadKeyToBoundingBox(quadKey).minPoint;
+        std::vector<ElementReader> readers;
+        readers.reserve(views.size());
+        for (const auto& view : views)
+            readers.emplace_back(view.data, view.dataSize, origin);
+        ElementPrefilter* prefilter = ElementPrefilter::of(visitor);
+        const SearchControl* control = SearchControl::of(visitor);
+        visitEntries(views, [&](const IndexEntry& entry, std::size_t viewIndex) {
+            if (SearchControl::isStopped(control) || !matches(entry, bbox, mask))
+                return;
+            ElementReader& reader = readers[viewIndex];
+            // NOTE geometry of element rejected by its tags is not decoded.
+            if (prefilter == nullptr || prefilter->accepts(reader.readHeader(entry.id, entry.offset)))
+                reader.readElement(entry.id, entry.offset)->accept(visitor);
+        });
+    }
+
+    /// Checks whether tile has elements which are not removed.
+    bool hasData(const QuadKey& quadKey) const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        std::uint64_t key = PackedQuadKey(quadKey).value;
+        TileBlock block = {};
+        bool hasBlock = findBlock(key, block);
+        auto tilePair = pendingTiles_.find(key);
+        // NOTE tile without live elements is dropped from directory when it is written.
+        if (tilePair == pendingTiles_.end())
+            return hasBlock;
+
+        return countLiveEntries(block, *tilePair->second) > 0;
+    }
+
+    bool getDataVersion(const QuadKey& quadKey, std::uint64_t& version) const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        std::uint64_t key = PackedQuadKey(quadKey).value;
+        if (pendingTiles_.find(key) != pendingTiles_.end())
+            return false;
+
+        TileBlock block = { key, 0, 0 };
+        findBlock(key, block);
+        version = utymap::utils::getFileVersion(path_);
+        version ^= block.offset + 0x9e3779b97f4a7c15ULL + (version << 6) + (version >> 2);
+        version ^= block.size + 0x9e3779b97f4a7c15ULL + (version << 6) + (version >> 2);
+        return true;
+    }
+
+    void commit()
+    {
+        UTYMAP_TRACE_SCOPE("package_commit", "io");
+        std::lock_guard<std::mutex> lock(lock_);
+        flush();
+    }
+
+    std::size_t getMemoryUsage() const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        return bufferedBytes_;
+    }
+
+    /// Rewrites package to temporary file keeping only live elements and replaces it. Every tile
+    /// gets single block.
+    void compact()
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        flush();
+        if (file_->size() == 0)
+            return;
+
+        std::string tempPath = path_ + ".tmp";
+        std::vector<TileBlock> directory;
+        directory.reserve(directory_.size());
+        {
+            std::ofstream output(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+            writeHeader(output, 0, sizeof(PackageHeader));
+            std::uint64_t position = sizeof(PackageHeader);
+            for (const auto& block : directory_) {
+                std::string indexBuffer, dataBuffer;
+                GeoCoordinate origin = GeoUtils::quadKeyToBoundingBox(PackedQuadKey::fromValue(block.key).unpack()).minPoint;
+                std::vector<BlockView> views = getBlockViews(*file_, block);
+                std::vector<ElementReader> readers;
+                readers.reserve(views.size());
+                for (const auto& view : views)
+                    readers.emplace_back(view.data, view.dataSize, origin);
+                visitEntries(views, [&](const IndexEntry& entry, std::size_t viewIndex) {
+                    IndexEntry compacted = entry;
+                    compacted.offset = static_cast<std::uint32_t>(dataBuffer.size());
+                    ElementWriter writer(dataBuffer, origin);
+                    readers[viewIndex].readElement(entry.id, entry.offset)->accept(writer);
+                    indexBuffer.append(reinterpret_cast<const char*>(&compacted), sizeof(compacted));
+                });
+                if (indexBuffer.empty())
+                    continue;
+
+                std::string content = createBlock(indexBuffer, dataBuffer, 0, TileBlock { block.key, 0, 0 });
+                output.write(content.data(), content.size());
+                directory.push_back(TileBlock { block.key, position, content.size() });
+                position += content.size();
+            }
+            writeDirectory(output, directory, position);
+        }
+
+        // NOTE package should not be mapped when it is replaced.
+        file_ = std::make_shared<const MappedFile>("");
+        std::remove(path_.c_str());
+        if (std::rename(tempPath.c_str(), path_.c_str()) != 0)
+            throw std::domain_error("Cannot replace package file: " + path_);
+        open();
+    }
+
+    ~PackageElementStoreImpl()
+    {
+        try {
+            flush();
+        }
+        catch (...) {
+            // NOTE destructor must not throw: call commit explicitly to get errors.
+        }
+    }
+
+private:
+    /// Reads header and tile directory of package if it exists.
+    void open()
+    {
+        file_ = std::make_shared<const MappedFile>(path_);
+        directory_.clear();
+        isLegacy_ = false;
+        if (file_->size() == 0)
+            return;
+
+        PackageHeader header;
+        if (file_->size() < sizeof(header))
+            throw std::domain_error("Invalid package file: " + path_);
+        std::memcpy(&header, file_->data(), sizeof(header));
+        if (header.magic != PackageMagic ||
+            (header.version != PackageVersion && header.version != LegacyPackageVersion) ||
+            header.directoryOffset + header.tileCount * sizeof(TileBlock) > file_->size())
+            throw std::domain_error("Invalid package file: " + path_);
+
+        isLegacy_ = header.version == LegacyPackageVersion;
+        directory_.resize(header.tileCount);
+        if (!directory_.empty())
+            std::memcpy(directory_.data(), file_->data() + header.directoryOffset, directory_.size() * sizeof(TileBlock));
+    }
+
+    /// Gets pending tile to change it. Tile which is read by search is replaced by its copy.
+    /// Should be called under lock.
+    PendingTile& getPendingTile(std::uint64_t key)
+    {
+        std::shared_ptr<PendingTile>& tile = pendingTiles_[key];
+        // NOTE searches take their references under lock, so tile which is not shared stays so.
+        if (tile == nullptr)
+            tile = std::make_shared<PendingTile>();
+        else if (tile.use_count() > 1)
+            tile = std::make_shared<PendingTile>(*tile);
+        return *tile;
+    }
+
+    /// Finds the last block of given tile using binary search in directory.
+    bool findBlock(std::uint64_t key, TileBlock& block) const
+    {
+        auto blockIt = std::lower_bound(directory_.begin(), directory_.end(), key, isLessKey);
+        if (blockIt == directory_.end() || blockIt->key != key)
+            return false;
+        block = *blockIt;
+        return true;
+    }
+
+    /// Gets content of block. Block with zero size represents tile without data.
+    BlockView getBlockView(const MappedFile& file, const TileBlock& block) const
+    {
+        BlockView view = { 0, nullptr, 0, nullptr, 0, 0, 0 };
+        if (block.size == 0)
+            return view;
+
+        BlockHeader header = {};
+        std::size_t headerSize = isLegacy_ ? LegacyBlockHeaderSize : sizeof(header);
+        if (block.size < headerSize || block.offset + block.size > file.size())
+            throw std::domain_error("Invalid tile block in package file: " + path_);
+        std::memcpy(&header, file.data() + block.offset, headerSize);
+        if (headerSize + static_cast<std::uint64_t>(header.entryCount) * sizeof(IndexEntry) + header.dataSize != block.size)
+            throw std::domain_error("Invalid tile block in package file: " + path_);
+
+        view.entryCount = header.entryCount;
+        view.entries = file.data() + block.offset + headerSize;
+        view.dataSize = header.dataSize;
+        view.data = view.entries + header.entryCount * sizeof(IndexEntry);
+        view.depth = header.depth;
+        view.previousOffset = header.previousOffset;
+        view.previousSize = header.previousSize;
+        return view;
+    }
+
+    /// Gets views of all blocks of tile starting from the oldest one.
+    std::vector<BlockView> getBlockViews(const MappedFile& file, const TileBlock& block) const
+    {
+        std::vector<BlockView> views;
+        TileBlock current = block;
+        while (current.size > 0) {
+            BlockView view = getBlockView(file, current);
+            // NOTE depth decreases along links, so invalid link cannot make a cycle.
+            if ((!views.empty() && view.depth + 1 != views.back().depth) || (view.depth == 0) != (view.previousSize == 0))
+                throw std::domain_error("Invalid tile block in package file: " + path_);
+            views.push_back(view);
+            current = TileBlock { block.key, view.previousOffset, view.previousSize };
+        }
+        std::reverse(views.begin(), views.end());
+        return views;
+    }
+
+    static BlockView getPendingView(const PendingTile& tile)
+    {
+        return BlockView { static_cast<std::uint32_t>(tile.indexBuffer.size() / sizeof(IndexEntry)), tile.indexBuffer.data(),
+                           static_cast<std::uint32_t>(tile.dataBuffer.size()), tile.dataBuffer.data(), 0, 0, 0 };
+    }
+
+    /// Counts elements of tile with given block and pending changes which are not removed.
+    std::size_t countLiveEntries(const TileBlock& block, const PendingTile& tile) const
+    {
+        std::vector<BlockView> views = getBlockViews(*file_, block);
+        views.push_back(getPendingView(tile));
+        std::size_t count = 0;
+        visitEntries(views, [&](const IndexEntry&, std::size_t) { ++count; });
+        return count;
+    }
+
+    /// Calls functor with entry and index of its view for every entry of views which is not removed.
+    /// Tombstone hides entries of element which precede it.
+    template <typename Functor>
+    void visitEntries(const std::vector<BlockView>& views, const Functor& functor) const
+    {
+        auto getEntry = [](const BlockView& view, std::size_t i) {
+            IndexEntry entry;
+            std::memcpy(&entry, view.entries + i * sizeof(IndexEntry), sizeof(IndexEntry));
+            return entry;
+        };
+
+        // Key: element id, value: position of its last tombstone across views.
+        std::unordered_map<std::uint64_t, std::size_t> tombstones;
+        std::size_t position = 0;
+        for (const auto& view : views) {
+            for (std::size_t i = 0; i < view.entryCount; ++i, ++position) {
+                IndexEntry entry = getEntry(view, i);
+                if (entry.offset == TombstoneOffset)
+                    tombstones[entry.id] = position;
+            }
+        }
+
+        position = 0;
+        for (std::size_t viewIndex = 0; viewIndex < views.size(); ++viewIndex) {
+            const BlockView& view = views[viewIndex];
+            for (std::size_t i = 0; i < view.entryCount; ++i, ++position) {
+                IndexEntry entry = getEntry(view, i);
+                if (entry.offset == TombstoneOffset)
+                    continue;
+
+                auto tombstone = tombstones.empty() ? tombstones.end() : tombstones.find(entry.id);
+                if (tombstone == tombstones.end() || tombstone->second < position)
+                    functor(entry, viewIndex);
+            }
+        }
+    }
+
+    /// Writes pending tiles as new blocks followed by new directory. Should be called under lock.
+    void flush()
+    {
+        if (pendingTiles_.empty())
+            return;
+
+        UTYMAP_TRACE_SCOPE("package_flush", "io");
+
+        {
+            std::ifstream file(path_, std::ios::in | std::ios::binary);
+            if (!file.good()) {
+                std::ofstream output(path_, std::ios::out | std::ios::binary | std::ios::trunc);
+                writeHeader(output, 0, sizeof(PackageHeader));
+            }
+        }
+
+        std::fstream output(path_, std::ios::in | std::ios::out | std::ios::binary);
+        output.seekp(0, std::ios::end);
+        std::uint64_t position = static_cast<std::uint64_t>(output.tellp());
+
+        // Changed blocks in directory order: block with zero size means that tile has no data anymore.
+        std::vector<TileBlock> changes;
+        changes.reserve(pendingTiles_.size());
+        for (const auto& pair : pendingTiles_) {
+            TileBlock block = { pair.first, 0, 0 };
+            findBlock(pair.first, block);
+            std::vector<BlockView> views = getBlockViews(*file_, block);
+            views.push_back(getPendingView(*pair.second));
+
+            std::size_t liveCount = 0;
+            visitEntries(views, [&](const IndexEntry&, std::size_t) { ++liveCount; });
+            if (liveCount == 0) {
+                changes.push_back(TileBlock { pair.first, 0, 0 });
+                continue;
+            }
+
+            // NOTE pending changes are appended as new block, existing blocks are kept as they
+            // are till tile has too many of them. Then their data is copied to single block and
+            // only entries of removed elements are dropped.
+            std::uint32_t depth = static_cast<std::uint32_t>(views.size() - 1);
+            std::string content;
+            if (depth <= MaxBlockDepth)
+                content = createBlock(pair.second->indexBuffer, pair.second->dataBuffer, depth, block);
+            else {
+                std::string indexBuffer, dataBuffer;
+                std::vector<std::uint32_t> dataOffsets;
+                for (const auto& view : views) {
+                    dataOffsets.push_back(static_cast<std::uint32_t>(dataBuffer.size()));
+                    dataBuffer.append(view.data, view.dataSize);
+                }
+                visitEntries(views, [&](const IndexEntry& entry, std::size_t viewIndex) {
+                    IndexEntry merged = entry;
+                    merged.offset += dataOffsets[viewIndex];
+                    indexBuffer.append(reinterpret_cast<const char*>(&merged), sizeof(merged));
+                });
+                content = createBlock(indexBuffer, dataBuffer, 0, TileBlock { pair.first, 0, 0 });
+            }
+            output.write(content.data(), content.size());
+            changes.push_back(TileBlock { pair.first, position, content.size() });
+            position += content.size();
+        }
+
+        std::vector<TileBlock> directory;
+        directory.reserve(directory_.size() + changes.size());
+        auto current = directory_.begin();
+        for (const auto& change : changes) {
+            for (; current != directory_.end() && current->key < change.key; ++current)
+                directory.push_back(*current);
+            if (current != directory_.end() && current->key == change.key)
+                ++current;
+            if (change.size > 0)
+                directory.push_back(change);
+        }
+        directory.insert(directory.end(), current, directory_.end());
+
+        writeDirectory(output, directory, position);
+        output.close();
+
+        pendingTiles_.clear();
+        bufferedBytes_ = 0;
+        open();
+    }
+
+    void writeHeader(std::ostream& output, std::uint32_t tileCount, std::uint64_t directoryOffset) const
+    {
+        PackageHeader header = { PackageMagic, PackageVersion, tileCount, 0, directoryOffset };
+        output.seekp(0, std::ios::beg);
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    /// Writes directory at given position and then updates header to point to it.
+    void writeDirectory(std::ostream& output, const std::vector<TileBlock>& directory, std::uint64_t position) const
+    {
+        output.seekp(static_cast<std::streamoff>(position), std::ios::beg);
+        output.write(reinterpret_cast<const char*>(directory.data()), directory.size() * sizeof(TileBlock));
+        output.flush();
+        writeHeader(output, static_cast<std::uint32_t>(directory.size()), position);
+        output.flush();
+        if (!output.good())
+            throw std::domain_error("Cannot write package file: " + path_);
+    }
+
+    const std::string path_;
+    const std::uint32_t builderKeyId_;
+
+    /// Mapped package. Readers keep their copy while they visit elements.
+    std::shared_ptr<const MappedFile> file_;
+    /// The last blocks of tiles with data sorted by packed quadkey.
+    std::vector<TileBlock> directory_;
+    /// Whether package has blocks of the first version. It is compacted right after it is opened.
+    bool isLegacy_;
+    PendingTiles pendingTiles_;
+    /// Total amount of pending bytes.
+    std::size_t bufferedBytes_;
+    /// Serializes store calls and guards package state.
+    mutable std::mutex lock_;
+};
+
+PackageElementStore::PackageElementStore(const std::string& path, StringTable& stringTable) :
+    ElementStore(stringTable),
+    pimpl_(utymap::utils::make_unique<PackageElementStoreImpl>(path, stringTable.getId(BuilderKey)))
+{
+}
+
+PackageElementStore::~PackageElementStore()
+{
+}
+
+void PackageElementStore::storeImpl(const Element& element, const QuadKey& quadKey, const Style& style)
+{
+    checkPersistentStrings(element);
+    addWrittenBytes(quadKey, pimpl_->store(element, quadKey, style));
+}
+
+void PackageElementStore::removeImpl(std::uint64_t id, const QuadKey& quadKey)
+{
+    pimpl_->remove(id, quadKey);
+}
+
+void PackageElementStore::compact()
+{
+    pimpl_->compact();
+}
+
+void PackageElementStore::search(const QuadKey& quadKey, ElementVisitor& visitor)
+{
+    pimpl_->search(quadKey, WorldBoundingBox, 0, visitor);
+}
+
+void PackageElementStore::search(const QuadKey& quadKey, const BoundingBox& bbox, ElementVisitor& visitor)
+{
+    pimpl_->search(quadKey, bbox, 0, visitor);
+}
+
+void PackageElementStore::search(const QuadKey& quadKey, const BoundingBox& bbox, const std::string& builderName, ElementVisitor& visitor)
+{
+    pimpl_->search(quadKey, bbox, builderName.empty() ? 0 : getBuilderMask(builderName), visitor);
+}
+
+bool PackageElementStore::hasData(const QuadKey& quadKey) const
+{
+    return pimpl_->hasData(quadKey);
+}
+
+bool PackageElementStore::getDataVersion(const QuadKey& quadKey, std::uint64_t& version)
+{
+    return pimpl_->getDataVersion(quadKey, version);
+}
+
+std::size_t PackageElementStore::getMemoryUsage() const
+{
+    return pimpl_->getMemoryUsage();
+}
+
+void PackageElementStore::commit()
+{
+    pimpl_->commit();
+}
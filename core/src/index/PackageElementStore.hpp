@@ -0,0 +1,70 @@
+#ifndef INDEX_PACKAGEELEMENTSTORE_HPP_DEFINED
+#define INDEX_PACKAGEELEMENTSTORE_HPP_DEFINED
+
+#include "BoundingBox.hpp"
+#include "QuadKey.hpp"
+#include "entities/Element.hpp"
+#include "index/ElementStore.hpp"
+
+#include <string>
+#include <memory>
+
+namespace utymap { namespace index {
+
+/// Provides API to store elements of all tiles in single package file. Package is memory mapped
+/// and elements of every tile are read from its blocks: changes are appended as new block linked
+/// to previous one, so existing data is not rewritten till tile has too many blocks.
+class PackageElementStore final : public ElementStore
+{
+public:
+    /// Creates store which uses package file with given path. File is created on first commit.
+    PackageElementStore(const std::string& path, utymap::index::StringTable& stringTable);
+
+    virtual ~PackageElementStore();
+
+    void search(const utymap::QuadKey& quadKey,
+                utymap::entities::ElementVisitor& visitor) override;
+
+    /// Searches for elements of given quadkey which intersect bounding box using index entries.
+    void search(const utymap::QuadKey& quadKey,
+                const utymap::BoundingBox& bbox,
+                utymap::entities::ElementVisitor& visitor) override;
+
+    /// Searches for elements of given quadkey which intersect bounding box. If builder name is
+    /// not empty, elements which are not built by it are skipped without reading their data.
+    void search(const utymap::QuadKey& quadKey,
+                const utymap::BoundingBox& bbox,
+                const std::string& builderName,
+                utymap::entities::ElementVisitor& visitor);
+
+    /// Checks whether tile has elements which are not removed.
+    bool hasData(const utymap::QuadKey& quadKey) const override;
+
+    /// Gets version from package file and tile block. Tile with pending data has no version.
+    bool getDataVersion(const utymap::QuadKey& quadKey, std::uint64_t& version) override;
+
+    void commit() override;
+
+    /// Returns amount of bytes kept in write buffers.
+    std::size_t getMemoryUsage() const override;
+
+    /// Rewrites package without data of removed and replaced elements. Blocks of every tile are
+    /// merged into one and tiles are written in directory order. Can be called from background
+    /// thread: it is serialized with store calls.
+    void compact() override;
+
+protected:
+    void storeImpl(const utymap::entities::Element& element,
+                   const utymap::QuadKey& quadKey,
+                   const utymap::mapcss::Style& style) override;
+
+    void removeImpl(std::uint64_t id, const utymap::QuadKey& quadKey) override;
+
+private:
+    class PackageElementStoreImpl;
+    std::unique_ptr<PackageElementStoreImpl> pimpl_;
+};
+
+}}
+
+#endif // INDEX_PACKAGEELEMENTSTORE_HPP_DEFINED
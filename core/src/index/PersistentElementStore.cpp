@@ -1,13 +1,46 @@
 #include "BoundingBox.hpp"
+#include "entities/BoundingBoxVisitor.hpp"
+#include "entities/ElementDispatch.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
+#include "formats/osm/OsmElementId.hpp"
+#include "index/ElementEncoding.hpp"
+#include "index/ElementPrefilter.hpp"
 #include "index/PersistentElementStore.hpp"
+#include "index/SearchControl.hpp"
+#include "index/TagIndex.hpp"
 #include "utils/CoreUtils.hpp"
+#include "utils/FileUtils.hpp"
+#include "utils/MappedFile.hpp"
+#include "utils/SharedMutex.hpp"
+#include "utils/TaskScheduler.hpp"
+#include "utils/TraceRecorder.hpp"
 
+#include <zlib.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <functional>
+#include <limits>
+#include <list>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 using namespace utymap;
 using namespace utymap::index;
@@ -19,334 +52,1841 @@ namespace {
     ///                                      Index file format
     ///   DESCRIPTION    |                       DETAILS                                                     |
     ///------------------------------------------------------------------------------------------------------|
-    ///     Element      |  List of entries, each is represented by element id (8b) and file offset (4b)     |
+    ///     Element      |  List of entries, each is represented by element id (8b), file offset (4b),       |
+    ///                  |  mask (4b) and bounding box: fixed point min/max latitude/longitude (4 x 4b)      |
     ///------------------------------------------------------------------------------------------------------|
-    const std::string IndexFileExtension = ".idf";
+    /// Mask: bits 0-3 - element type (one bit per type), bits 4-31 - bloom filter of builder names.
+    /// Tombstone entry has offset 0xFFFFFFFF and hides all previous entries with the same element id.
+    /// Legacy index file has entries of element id (8b) and file offset (4b) only: they are always visited.
+    /// Entry without element type bits (except tombstone) references element in shared data file of the
+    /// level: see below. Its offset points to that file, so offsets of tile data use all 32 bits.
+    const std::string IndexFileExtension = ".idx";
+    /// Compacted files are written with this extension appended and then replace published ones.
+    const std::string TemporaryFileExtension = ".tmp";
+    const std::string LegacyIndexFileExtension = ".idf";
 
     ///                                      Data file format
     ///------------------------------------------------------------------------------------------------------|
     ///   DESCRIPTION    |                       DETAILS                                                     |
     ///------------------------------------------------------------------------------------------------------|
-    ///  (1b) Flags      |  00 00 00 AA, where:                                                              |
+    ///  (1b) Flags      |  00 00 RC AA, where:                                                              |
     ///                  |    AA - Element type (00 - Node, 01 - Way, 10 - Area, 11 - Relation)              |
+    ///                  |    C  - Encoding (0 - raw, 1 - compact)                                           |
+    ///                  |    R  - Relation is written as rings (compact only)                               |
     ///------------------------------------------------------------------------------------------------------|
-    ///  (2b) Tags Size  |  Size of tag list where each tag represented by key-value pair (4b + 4b)          |
+    ///  Tags Size       |  Size of tag list where each tag represented by key-value pair                    |
     ///------------------------------------------------------------------------------------------------------|
-    ///      Tags        |               Tags data with size (2b)                                            |
+    ///      Tags        |               Tags data                                                           |
     ///------------------------------------------------------------------------------------------------------|
     ///    Geometry      |             Geometry for Node, Way or Area                                        |
     ///       or         |                                                                                   |
     ///    Element List  |             Element list in the same format + id                                  |
     ///                  |                                                                                   |
     ///------------------------------------------------------------------------------------------------------|
+    /// Raw encoding: sizes are 2b, tag key and value are 4b + 4b, coordinate is two 8b doubles.
+    /// Compact encoding: sizes, ids and string ids are varints, coordinate is fixed point (1e-7 degree)
+    /// zigzag varint delta: the first coordinate is relative to tile origin, others to the previous one.
+    /// Relation of areas without tags (resolved multipolygon) is written as rings: tags, amount of rings
+    /// and for every ring its id, amount of coordinates and coordinates which continue previous ring.
+    ///
+    /// Data file can be compressed: then it begins with header byte and consists of zlib blocks
+    /// where each block is represented by raw size (4b), compressed size (4b) and data.
+    /// Offsets in index file always point to uncompressed data.
     const std::string DataFileExtension = ".dat";
 
-    /// Writes element to file stream.
-    class ElementWriter final : public ElementVisitor
+    /// Element which is not clipped and stored in several tiles of level is written once to shared data
+    /// file "shared.dat" of level directory and every tile index has entry referencing it. Shared data
+    /// file has data file format, but it is never compressed and compact encoding is relative to (0, 0).
+    /// Shared data file is compacted with tile indices which reference it when most of its elements
+    /// are removed.
+    const std::string SharedFileName = "shared";
+    /// Journal lists files changed by compaction at once, so interrupted changes are finished when
+    /// store is opened. Every change is represented by operation (1b: 0 - file is replaced by its
+    /// temporary version, 1 - file is removed), length of path (4b) and path relative to store directory.
+    const std::string JournalFileName = "files.jrn";
+    const std::uint32_t ElementTypeMask = 0xF;
+    /// Offset flag which marks shared entry in index of older version.
+    const std::uint32_t SharedOffsetFlag = 0x80000000;
+    /// Amount of bytes of shared data file read ahead for every element referenced by prefetched tile.
+    const std::size_t SharedPrefetchSize = 16 * 1024;
+    /// Max amount of decoded shared elements kept for searches of neighbour tiles.
+    const std::size_t MaxSharedElements = 4096;
+    /// Max amount of tag indices of tiles kept for tag searches. Index maps tag to ordinal
+    /// of live entry in tile index, so it is rebuilt when tile is changed.
+    const std::size_t MaxTagIndices = 256;
+
+    ///                                    Manifest file format
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Header       |  Magic (4b) and amount of tiles (4b)                                              |
+    ///------------------------------------------------------------------------------------------------------|
+    ///      Tiles       |  Packed quadkeys of tiles which have data (8b), sorted                            |
+    ///------------------------------------------------------------------------------------------------------|
+    /// Tiles missing in manifest are checked on disk once as they can be written by older version.
+    /// Older manifest keeps level of detail, x and y (3 x 4b) per tile: it is still read.
+    /// Magic defines version of store: stores of older versions keep osm ids of ways and relations
+    /// without type bits (see OsmElementId), so their tiles are migrated when store is opened.
+    /// Indices of older versions mark shared entries by offset flag: they are converted on open.
+    const std::string ManifestFileName = "tiles.mft";
+    const std::uint32_t ManifestMagic = 0x3446544D;
+    const std::uint32_t SharedOffsetManifestMagic = 0x3346544D;
+    const std::uint32_t UntypedManifestMagic = 0x3246544D;
+    const std::uint32_t LegacyManifestMagic = 0x3146544D;
+
+    /// Names of stored elements are kept in name index file, see NameIndex.
+    const std::string NameIndexFileName = "names.idx";
+    /// Quadkeys of stored elements with id are kept in id index file, see ElementIdIndex.
+    const std::string IdIndexFileName = "ids.idx";
+
+    ///                                     Bucket file format
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Header       |  Magic (4b), amount of buckets (4b), amount of split entries (4b) and size of     |
+    ///                  |  their uncompressed data (4b)                                                     |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Buckets      |  First entry (4b), amount of entries (4b) and their bounding box: fixed point     |
+    ///                  |  min/max latitude/longitude (4 x 4b)                                              |
+    ///------------------------------------------------------------------------------------------------------|
+    /// Compaction splits tile which data exceeds split size: entries are grouped by cells of tile grid and
+    /// consecutive cells are merged into buckets of about quarter of split size. Data of bucket follows data
+    /// of previous one and is written as own block if compressed, so search inflates only blocks which are
+    /// referenced by entries of buckets intersecting its bounding box. Entries written after split follow
+    /// split ones and are always visited. Tile without bucket file is not split.
+    const std::string BucketFileExtension = ".bkt";
+    const std::uint32_t BucketMagic = 0x31544B42;
+    /// Tile grid has 2^SplitDepth cells per side, they are ordered along Z curve.
+    const int SplitDepth = 3;
+    /// Default size of uncompressed data of tile which is split by compaction.
+    const std::size_t DefaultSplitSize = 4 * 1024 * 1024;
+    /// Min size of used uncompressed data which is inflated in parallel.
+    const std::size_t ParallelInflateSize = 1024 * 1024;
+
+    /// Bucket of split tile.
+    struct TileBucket final
     {
-    public:
-        explicit ElementWriter(std::fstream& dataFile) : dataFile_(dataFile)
-        {
+        std::uint32_t firstEntry;
+        std::uint32_t entryCount;
+        std::int32_t minLatitude;
+        std::int32_t minLongitude;
+        std::int32_t maxLatitude;
+        std::int32_t maxLongitude;
+    };
+    static_assert(sizeof(TileBucket) == 24, "Unexpected bucket size.");
+
+    ///                                   Fingerprint file format
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Records      |  Element id (8b), version of style provider (8b), style id (4b) and reserved (4b) |
+    ///------------------------------------------------------------------------------------------------------|
+    /// Fingerprints of style used to store elements of tile. Records are appended when tile is flushed and
+    /// the last record of element wins. Compaction keeps only records of live elements.
+    const std::string FingerprintFileExtension = ".fpr";
+    /// Max amount of fingerprints of tiles kept for searches.
+    const std::size_t MaxFingerprintTiles = 256;
+
+    struct FingerprintRecord final
+    {
+        std::uint64_t id;
+        std::uint64_t version;
+        std::uint32_t styleId;
+        std::uint32_t reserved;
+    };
+    static_assert(sizeof(FingerprintRecord) == 24, "Unexpected fingerprint record size.");
+
+    /// Fingerprints of tile elements by element id.
+    typedef std::unordered_map<std::uint64_t, StyleFingerprint> Fingerprints;
+
+    void appendFingerprint(std::uint64_t id, const StyleFingerprint& fingerprint, std::string& buffer)
+    {
+        FingerprintRecord record = { id, fingerprint.version, fingerprint.id, 0 };
+        buffer.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+
+    /// Reads fingerprints from file. Missing file has no fingerprints.
+    Fingerprints readFingerprints(const std::string& path)
+    {
+        Fingerprints fingerprints;
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        FingerprintRecord record;
+        while (file.read(reinterpret_cast<char*>(&record), sizeof(record)))
+            fingerprints[record.id] = StyleFingerprint { record.version, record.styleId };
+        return fingerprints;
+    }
+
+    const std::string BuilderKey = "builders";
+    const BoundingBox WorldBoundingBox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
+
+    const std::uint8_t CompressedHeader = 0x80;
+
+    /// Compresses data to block and appends it to output.
+    void compressBlock(const std::string& data, std::string& output)
+    {
+        uLongf compressedSize = compressBound(static_cast<uLong>(data.size()));
+        std::string block(compressedSize, '\0');
+        if (compress(reinterpret_cast<Bytef*>(&block[0]), &compressedSize,
+                     reinterpret_cast<const Bytef*>(data.data()), static_cast<uLong>(data.size())) != Z_OK)
+            throw std::domain_error("Failed to compress data block.");
+
+        std::uint32_t rawSize = static_cast<std::uint32_t>(data.size());
+        std::uint32_t blockSize = static_cast<std::uint32_t>(compressedSize);
+        output.append(reinterpret_cast<const char*>(&rawSize), sizeof(rawSize));
+        output.append(reinterpret_cast<const char*>(&blockSize), sizeof(blockSize));
+        output.append(block.data(), blockSize);
+    }
+
+    /// Starts reading of whole file into page cache without waiting for it, so following reads of
+    /// mapped file are not limited by latency of device. Where system has no read ahead advice,
+    /// file is read by worker of task scheduler.
+    void prefetchFile(const std::string& path)
+    {
+#ifdef __linux__
+        int descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            return;
+        ::posix_fadvise(descriptor, 0, 0, POSIX_FADV_WILLNEED);
+        ::close(descriptor);
+#else
+        TaskScheduler::instance().submit([path]() {
+            std::ifstream file(path, std::ios::in | std::ios::binary);
+            char buffer[64 * 1024];
+            while (file.read(buffer, sizeof(buffer))) { }
+        }, TaskPriority::Low);
+#endif
+    }
+
+    /// Checks whether index entry references element in shared data file.
+    bool isShared(const IndexEntry& entry)
+    {
+        return entry.offset != TombstoneOffset && (entry.mask & ElementTypeMask) == 0;
+    }
+
+    /// Starts reading of parts of file which begin at given offsets into page cache. Size of
+    /// element is not known before it is decoded, so fixed amount of bytes is read from every
+    /// offset and overlapping parts are merged. Should be called by worker of task scheduler.
+    void prefetchParts(const std::string& path, std::vector<std::uint32_t>& offsets)
+    {
+        if (offsets.empty())
+            return;
+
+        std::sort(offsets.begin(), offsets.end());
+        std::vector<std::pair<std::size_t, std::size_t>> ranges;
+        for (std::uint32_t offset : offsets) {
+            if (!ranges.empty() && offset <= ranges.back().second)
+                ranges.back().second = std::max<std::size_t>(ranges.back().second, offset + SharedPrefetchSize);
+            else
+                ranges.emplace_back(offset, offset + SharedPrefetchSize);
         }
 
-        void visitNode(const Node& node) override
-        {
-            writeFlags(0);
-            writeTags(node.tags);
-            writeCoordinate(node.coordinate);
+#ifdef __linux__
+        int descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            return;
+        for (const auto& range : ranges)
+            ::posix_fadvise(descriptor, static_cast<off_t>(range.first), static_cast<off_t>(range.second - range.first), POSIX_FADV_WILLNEED);
+        ::close(descriptor);
+#else
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        std::string buffer;
+        for (const auto& range : ranges) {
+            buffer.resize(range.second - range.first);
+            file.clear();
+            file.seekg(static_cast<std::streamoff>(range.first));
+            file.read(&buffer[0], buffer.size());
         }
+#endif
+    }
 
-        void visitWay(const Way& way) override
-        {
-            writeFlags(1);
-            writeTags(way.tags);
-            std::uint16_t size = static_cast<std::uint16_t>(way.coordinates.size());
-            dataFile_.write(reinterpret_cast<const char*>(&size), sizeof(size));
-            for (const auto& coord : way.coordinates) {
-                writeCoordinate(coord);
-            }
+    /// Block of compressed data file.
+    struct DataBlock final
+    {
+        /// Position of compressed data in file.
+        std::size_t position;
+        std::uint32_t blockSize;
+        /// Offset of block data in uncompressed data.
+        std::uint32_t offset;
+        std::uint32_t rawSize;
+    };
+
+    /// Reads headers of all blocks of compressed data file skipping header.
+    std::vector<DataBlock> readBlocks(const char* data, std::size_t size)
+    {
+        std::vector<DataBlock> blocks;
+        std::uint32_t offset = 0;
+        std::size_t position = sizeof(CompressedHeader);
+        while (position + 2 * sizeof(std::uint32_t) <= size) {
+            std::uint32_t rawSize, blockSize;
+            std::memcpy(&rawSize, data + position, sizeof(rawSize));
+            std::memcpy(&blockSize, data + position + sizeof(rawSize), sizeof(blockSize));
+            position += 2 * sizeof(std::uint32_t);
+            if (position + blockSize > size)
+                throw std::domain_error("Unexpected end of data file.");
+
+            blocks.push_back(DataBlock { position, blockSize, offset, rawSize });
+            offset += rawSize;
+            position += blockSize;
         }
+        return blocks;
+    }
 
-        void visitArea(const Area& area) override
-        {
-            writeFlags(2);
-            writeTags(area.tags);
-            // NOTE do not write the last one
-            std::uint16_t size = static_cast<std::uint16_t>(area.coordinates.size());
-            dataFile_.write(reinterpret_cast<const char*>(&size), sizeof(size));
-            for (const auto& coord : area.coordinates) {
-                writeCoordinate(coord);
+    /// Decompresses block to given output.
+    void inflateBlock(const char* data, const DataBlock& block, char* output)
+    {
+        uLongf destSize = block.rawSize;
+        if (uncompress(reinterpret_cast<Bytef*>(output), &destSize,
+                       reinterpret_cast<const Bytef*>(data + block.position), block.blockSize) != Z_OK)
+            throw std::domain_error("Failed to decompress data block.");
+    }
+
+    /// Decompresses used blocks to buffer of whole uncompressed data: other blocks are left zeroed.
+    /// Large blocks are decompressed by workers of task scheduler.
+    std::string inflateBlocks(const char* data, const std::vector<DataBlock>& blocks, const std::vector<bool>& isUsed)
+    {
+        std::string output(blocks.empty() ? 0 : blocks.back().offset + blocks.back().rawSize, '\0');
+        std::size_t usedSize = 0, usedCount = 0;
+        for (std::size_t i = 0; i < blocks.size(); ++i) {
+            if (isUsed[i]) {
+                usedSize += blocks[i].rawSize;
+                ++usedCount;
             }
         }
+        if (usedCount == 0)
+            return output;
 
-        void visitRelation(const Relation& relation) override
-        {
-            writeFlags(3);
-            writeTags(relation.tags);
-            std::uint16_t elementSize = static_cast<std::uint16_t>(relation.elements.size());
-            dataFile_.write(reinterpret_cast<const char*>(&elementSize), sizeof(elementSize));
-            for (const auto& element : relation.elements) {
-                dataFile_.write(reinterpret_cast<const char*>(&element->id), sizeof(element->id));
-                element->accept(*this);
+        char* buffer = &output[0];
+        if (usedCount == 1 || usedSize < ParallelInflateSize) {
+            for (std::size_t i = 0; i < blocks.size(); ++i)
+                if (isUsed[i])
+                    inflateBlock(data, blocks[i], buffer + blocks[i].offset);
+            return output;
+        }
+
+        TaskGroup group;
+        for (std::size_t i = 0; i < blocks.size(); ++i) {
+            if (isUsed[i]) {
+                const DataBlock& block = blocks[i];
+                group.run([data, &block, buffer]() { inflateBlock(data, block, buffer + block.offset); });
             }
         }
+        group.wait();
+        return output;
+    }
 
-    private:
+    /// Returns index of block which contains given offset of uncompressed data.
+    std::size_t findBlock(const std::vector<DataBlock>& blocks, std::uint32_t offset)
+    {
+        auto block = std::upper_bound(blocks.begin(), blocks.end(), offset, [](std::uint32_t value, const DataBlock& block) {
+            return value < block.offset;
+        });
+        return block == blocks.begin() ? 0 : static_cast<std::size_t>(block - blocks.begin() - 1);
+    }
 
-        void writeFlags(const std::uint8_t flags)
+    /// Returns index of cell of tile grid along Z curve which contains center of entry bounding box.
+    std::size_t getCell(const IndexEntry& entry, const BoundingBox& bbox)
+    {
+        const int size = 1 << SplitDepth;
+        double latitude = (static_cast<double>(entry.minLatitude) + entry.maxLatitude) / 2 / CoordinatePrecision;
+        double longitude = (static_cast<double>(entry.minLongitude) + entry.maxLongitude) / 2 / CoordinatePrecision;
+        double y = std::floor((latitude - bbox.minPoint.latitude) / (bbox.maxPoint.latitude - bbox.minPoint.latitude) * size);
+        double x = std::floor((longitude - bbox.minPoint.longitude) / bbox.width() * size);
+        int row = y < 0 ? 0 : (y >= size ? size - 1 : static_cast<int>(y));
+        int column = x < 0 ? 0 : (x >= size ? size - 1 : static_cast<int>(x));
+
+        std::size_t cell = 0;
+        for (int bit = SplitDepth - 1; bit >= 0; --bit)
+            cell = (cell << 2) | (((row >> bit) & 1) << 1) | ((column >> bit) & 1);
+        return cell;
+    }
+
+    /// Checks whether bucket has entries which may intersect bounding box.
+    bool intersects(const TileBucket& bucket, const BoundingBox& bbox)
+    {
+        IndexEntry bounds = {};
+        bounds.minLatitude = bucket.minLatitude;
+        bounds.minLongitude = bucket.minLongitude;
+        bounds.maxLatitude = bucket.maxLatitude;
+        bounds.maxLongitude = bucket.maxLongitude;
+        return matches(bounds, bbox, 0);
+    }
+}
+
+class PersistentElementStore::PersistentElementStoreImpl final
+{
+    /// Max amount of quadkeys with opened files.
+    const std::size_t MaxOpenedTiles = 64;
+    /// Max amount of bytes kept in write buffers before they are flushed to disk.
+    const std::size_t MaxBufferedBytes = 16 * 1024 * 1024;
+
+    /// Sizes of files of single quadkey which are visible to searches. Writes go beyond them
+    /// and become visible at once when store is committed.
+    struct TileVersion final
+    {
+        /// Size of index file in bytes.
+        std::uint32_t indexSize;
+        /// Size of data file in bytes: compressed data is inflated only up to it.
+        std::uint32_t dataSize;
+        /// Sequence of commit which published the sizes.
+        std::uint64_t sequence;
+    };
+
+    /// Holds opened data and index files of single quadkey with pending writes.
+    struct TileFiles final
+    {
+        QuadKey quadKey;
+        std::fstream dataFile;
+        std::fstream indexFile;
+        /// Sizes of files on disk including flushed, but not published data.
+        std::uint32_t dataFileSize;
+        std::uint32_t indexFileSize;
+        /// Origin of quadkey used by compact encoding.
+        GeoCoordinate origin;
+        /// Whether data file consists of compressed blocks.
+        bool isCompressed;
+        /// Size of uncompressed data stored on disk.
+        std::uint32_t dataSize;
+        /// Pending data file content.
+        std::string dataBuffer;
+        /// Pending index file content.
+        std::string indexBuffer;
+        /// Pending fingerprint file content.
+        std::string fingerprintBuffer;
+        /// Size of uncompressed data of split entries or zero if tile is not split.
+        std::uint32_t splitDataSize;
+    };
+
+    typedef std::list<std::pair<QuadKey, std::unique_ptr<TileFiles>>> TileFilesList;
+    typedef std::unordered_map<QuadKey, TileFilesList::iterator, QuadKeyHash> TileFilesMap;
+
+    struct Snapshot;
+
+    /// Reads elements of index entries of single quadkey. Shared data file is read as it is mapped by snapshot.
+    class EntryReader final
+    {
+    public:
+        EntryReader(PersistentElementStoreImpl& store, const Snapshot& snapshot, ElementReader& reader) :
+            store_(store), snapshot_(snapshot), reader_(reader), sharedReader_()
         {
-            dataFile_.write(reinterpret_cast<const char*>(&flags), sizeof(flags));
         }
 
-        void writeTags(const std::vector<Tag>& tags)
+        /// Reads element of entry. Shared elements are cached, so they should not be changed.
+        std::shared_ptr<const Element> read(const IndexEntry& entry)
         {
-            std::uint16_t size = static_cast<std::uint16_t>(tags.size());
-            dataFile_.write(reinterpret_cast<const char*>(&size), sizeof(size));
-            for (const auto& tag : tags) {
-                dataFile_.write(reinterpret_cast<const char*>(&tag.key), sizeof(tag.key));
-                dataFile_.write(reinterpret_cast<const char*>(&tag.value), sizeof(tag.value));
+            if (!isShared(entry))
+                return reader_.readElement(entry.id, entry.offset);
+
+            if (sharedReader_ == nullptr) {
+                const MappedFile& sharedFile = *snapshot_.sharedFile;
+                sharedReader_ = utymap::utils::make_unique<ElementReader>(sharedFile.data(), sharedFile.size(), GeoCoordinate(0, 0));
             }
+            return store_.readShared(snapshot_, entry, *sharedReader_);
         }
 
-        void writeCoordinate(const GeoCoordinate& coord)
+        /// Reads element of entry and visits it if prefilter accepts its tags. Geometry of
+        /// rejected element is not decoded.
+        void visit(const IndexEntry& entry, ElementVisitor& visitor, ElementPrefilter* prefilter)
         {
-            dataFile_.write(reinterpret_cast<const char*>(&coord.latitude), sizeof(coord.latitude));
-            dataFile_.write(reinterpret_cast<const char*>(&coord.longitude), sizeof(coord.longitude));
+            // NOTE shared elements are decoded once and cached, so they are checked as they are.
+            if (prefilter == nullptr)
+                read(entry)->accept(visitor);
+            else if (isShared(entry)) {
+                auto element = read(entry);
+                if (prefilter->accepts(*element))
+                    element->accept(visitor);
+            }
+            else if (prefilter->accepts(reader_.readHeader(entry.id, entry.offset)))
+                read(entry)->accept(visitor);
         }
 
-        std::fstream& dataFile_;
+    private:
+        PersistentElementStoreImpl& store_;
+        const Snapshot& snapshot_;
+        ElementReader& reader_;
+        std::unique_ptr<ElementReader> sharedReader_;
     };
 
-    /// Reads element from file stream.
-    class ElementReader final
+    /// Files of single quadkey mapped as they are published by the last commit, so search sees
+    /// consistent version of tile while it is written or compacted.
+    struct Snapshot final
     {
-    public:
-        explicit ElementReader(std::fstream& dataFile) : dataFile_(dataFile)
+        Snapshot(PersistentElementStoreImpl& store, const QuadKey& quadKey) :
+            quadKey(quadKey), indexFile(), legacyIndexFile(), dataFile(), bucketFile(), sharedFile(),
+            indexSize(0), dataSize(0), sequence(0), sharedGeneration(0)
         {
+            SharedLock lock(store.versionsLock_);
+            indexFile = utymap::utils::make_unique<MappedFile>(store.getFilePath(quadKey, IndexFileExtension));
+            legacyIndexFile = utymap::utils::make_unique<MappedFile>(store.getFilePath(quadKey, LegacyIndexFileExtension));
+            dataFile = utymap::utils::make_unique<MappedFile>(store.getFilePath(quadKey, DataFileExtension));
+            bucketFile = utymap::utils::make_unique<MappedFile>(store.getFilePath(quadKey, BucketFileExtension));
+            // NOTE shared data file is mapped with index as its compaction changes offsets of entries.
+            sharedFile = store.getSharedData(quadKey.levelOfDetail);
+            sharedGeneration = store.sharedGeneration_;
+            indexSize = indexFile->size();
+            dataSize = dataFile->size();
+
+            // NOTE tile which is not written since store is opened is visible completely.
+            auto version = store.versions_.find(quadKey);
+            if (version != store.versions_.end()) {
+                indexSize = std::min<std::size_t>(indexSize, version->second.indexSize);
+                dataSize = std::min<std::size_t>(dataSize, version->second.dataSize);
+                sequence = version->second.sequence;
+            }
         }
 
-        std::shared_ptr<Element> readElement(std::uint64_t id, std::uint32_t offset)
-        {
-            dataFile_.seekg(offset, std::ios::beg);
-            auto element = readElement();
-            element->id = id;
-            return element;
+        const QuadKey quadKey;
+        std::unique_ptr<MappedFile> indexFile;
+        std::unique_ptr<MappedFile> legacyIndexFile;
+        std::unique_ptr<MappedFile> dataFile;
+        std::unique_ptr<MappedFile> bucketFile;
+        std::shared_ptr<const MappedFile> sharedFile;
+        std::size_t indexSize;
+        std::size_t dataSize;
+        std::uint64_t sequence;
+        /// Generation of shared data file which is changed by its compaction.
+        std::uint64_t sharedGeneration;
+    };
+
+public:
+    /// Returns new id of element stored in quadkey.
+    typedef std::function<std::uint64_t(const Element&, const QuadKey&)> IdMapper;
+
+    PersistentElementStoreImpl(const std::string& dataPath, bool compressData, std::uint32_t builderKeyId)
+            : dataPath_(dataPath), compressData_(compressData), builderKeyId_(builderKeyId),
+              tileFilesList_(), tileFilesMap_(), sharedFiles_(), bufferedBytes_(0), splitSize_(DefaultSplitSize), compactedTiles_(), sharedElements_(),
+              sharedData_(), sharedGeneration_(0),
+              tagIndices_(), fingerprints_(), versions_(), pendingVersions_(), sequence_(0), tiles_(), missingTiles_(), isManifestChanged_(false),
+              hasUntypedIds_(false)
+    {
+        finishJournal();
+        readManifest();
+    }
+
+    /// Stores element and returns amount of written bytes before compression.
+    std::size_t store(const Element& element, const QuadKey& quadKey, const Style& style)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        return storeTile(element, quadKey, style);
+    }
+
+    /// Stores element once in shared data file of level and references it from index of every quadkey.
+    /// Calls callback with amount of bytes written for every quadkey.
+    template <typename Callback>
+    void storeShared(const Element& element, const std::vector<QuadKey>& quadKeys, const Style& style, const Callback& callback)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        TileFiles& shared = getSharedFiles(quadKeys.front().levelOfDetail);
+        std::size_t offset = shared.dataSize + shared.dataBuffer.size();
+        // NOTE offset cannot be referenced when shared data file is too large.
+        if (offset >= TombstoneOffset) {
+            for (const auto& quadKey : quadKeys)
+                callback(quadKey, storeTile(element, quadKey, style));
+            return;
         }
 
-    private:
+        ElementWriter visitor(shared.dataBuffer, shared.origin);
+        utymap::entities::visit(element, visitor);
+        std::size_t dataBytes = shared.dataSize + shared.dataBuffer.size() - offset;
+
+        std::uint8_t elementType = shared.dataBuffer[offset - shared.dataSize] & 0x3;
+        IndexEntry entry = createIndexEntry(element, static_cast<std::uint32_t>(offset), elementType, style.getString(builderKeyId_));
+        entry.mask &= ~ElementTypeMask;
+        for (std::size_t i = 0; i < quadKeys.size(); ++i) {
+            TileFiles& files = getFiles(quadKeys[i]);
+            addTile(quadKeys[i]);
+            files.indexBuffer.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+            // NOTE shared data is accounted to the first quadkey.
+            callback(quadKeys[i], sizeof(entry) + (i == 0 ? dataBytes : 0));
+        }
+
+        bufferedBytes_ += dataBytes + quadKeys.size() * sizeof(entry);
+        if (bufferedBytes_ > MaxBufferedBytes)
+            flushAll();
+    }
+
+    void remove(std::uint64_t id, const QuadKey& quadKey)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        TileFiles& files = getFiles(quadKey);
+        addTile(quadKey);
+        IndexEntry entry = createTombstone(id);
+        files.indexBuffer.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        bufferedBytes_ += sizeof(entry);
+        compactedTiles_.insert(quadKey);
+    }
+
+    void storeFingerprint(std::uint64_t id, const QuadKey& quadKey, const StyleFingerprint& fingerprint)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        appendFingerprint(id, fingerprint, getFiles(quadKey).fingerprintBuffer);
+    }
 
-        std::shared_ptr<Element> readElement()
+    /// Finds fingerprint in fingerprints of tile which are read once and cached.
+    bool findFingerprint(const QuadKey& quadKey, std::uint64_t id, StyleFingerprint& fingerprint) const
+    {
+        std::shared_ptr<const Fingerprints> fingerprints;
         {
-            std::uint8_t flags;
-            dataFile_.read(reinterpret_cast<char*>(&flags), sizeof(flags));
-            std::uint8_t elementType = flags & 0x3;
-
-            switch (elementType) {
-            case 0:
-                return readNode();
-            case 1:
-                return readWay();
-            case 2:
-                return readArea();
-            default:
-                return readRelation();
+            std::lock_guard<std::mutex> lock(fingerprintsLock_);
+            auto cached = fingerprints_.find(quadKey);
+            if (cached != fingerprints_.end())
+                fingerprints = cached->second;
+        }
+        if (fingerprints == nullptr) {
+            fingerprints = std::make_shared<const Fingerprints>(readFingerprints(getFilePath(quadKey, FingerprintFileExtension)));
+            std::lock_guard<std::mutex> lock(fingerprintsLock_);
+            if (fingerprints_.size() >= MaxFingerprintTiles)
+                fingerprints_.clear();
+            fingerprints_.emplace(quadKey, fingerprints);
+        }
+
+        auto fingerprintPair = fingerprints->find(id);
+        if (fingerprintPair == fingerprints->end())
+            return false;
+        fingerprint = fingerprintPair->second;
+        return true;
+    }
+
+    void search(const QuadKey& quadKey, const BoundingBox& bbox, std::uint32_t mask, ElementVisitor& visitor)
+    {
+        UTYMAP_TRACE_SCOPE("persistent_search", "io");
+        ElementPrefilter* prefilter = ElementPrefilter::of(visitor);
+        visitEntries(Snapshot(*this, quadKey), bbox, [&](const IndexEntry& entry, EntryReader& reader) {
+            if (matches(entry, bbox, mask))
+                reader.visit(entry, visitor, prefilter);
+        }, SearchControl::of(visitor));
+    }
+
+    void searchById(const QuadKey& quadKey, std::uint64_t id, ElementVisitor& visitor)
+    {
+        visitEntries(quadKey, [&](const IndexEntry& entry, EntryReader& reader) {
+            if (entry.id == id)
+                reader.read(entry)->accept(visitor);
+        }, SearchControl::of(visitor));
+    }
+
+    void searchByTag(const QuadKey& quadKey, const BoundingBox& bbox, const std::vector<Tag>& tags, ElementVisitor& visitor)
+    {
+        UTYMAP_TRACE_SCOPE("persistent_tag_search", "io");
+        // NOTE positions refer to the same version of tile as entries which are visited.
+        Snapshot snapshot(*this, quadKey);
+        std::vector<std::uint32_t> positions = getTagIndex(snapshot)->find(tags);
+        if (positions.empty())
+            return;
+
+        // NOTE only elements of found entries are read.
+        std::size_t current = 0;
+        std::uint32_t position = 0;
+        ElementPrefilter* prefilter = ElementPrefilter::of(visitor);
+        visitEntries(snapshot, [&](const IndexEntry& entry, EntryReader& reader) {
+            if (current < positions.size() && positions[current] == position++) {
+                ++current;
+                if (matches(entry, bbox, 0))
+                    reader.visit(entry, visitor, prefilter);
             }
+        }, SearchControl::of(visitor));
+    }
+
+    /// Sets size of uncompressed data of tile which is split by compaction. Zero disables split.
+    void setSplitSize(std::size_t size)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        splitSize_ = size;
+    }
+
+    /// Rewrites files of tiles with removed elements keeping only live elements and splits
+    /// large tiles. Pending writes are published first as compacted files replace them.
+    void compact()
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        flushAll();
+        publish();
+        std::unordered_set<int> levels;
+        for (const auto& quadKey : compactedTiles_) {
+            compact(quadKey);
+            levels.insert(quadKey.levelOfDetail);
         }
+        compactedTiles_.clear();
+        // NOTE shared data becomes garbage only when elements are removed from tiles.
+        for (int levelOfDetail : levels)
+            compactShared(levelOfDetail);
+    }
 
-        std::shared_ptr<Node> readNode()
+    /// Checks whether store is written by older version which keeps osm ids without type bits.
+    bool hasUntypedIds() const
+    {
+        return hasUntypedIds_;
+    }
+
+    /// Rewrites all tiles replacing ids of their elements by given mapper. Pending writes are
+    /// published first. Manifest of current version is written by next commit, so interrupted
+    /// migration is repeated when store is opened again.
+    void migrateIds(const IdMapper& mapId)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        flushAll();
+        publish();
+        std::vector<QuadKey> quadKeys;
         {
-            auto node = std::make_shared<Node>();
-            node->tags = readTags();
-            node->coordinate = readCoordinate();
-            return node;
+            std::lock_guard<std::mutex> tilesLock(tilesLock_);
+            quadKeys.assign(tiles_.begin(), tiles_.end());
         }
-
-        std::shared_ptr<Way> readWay()
+        for (const auto& quadKey : quadKeys)
+            compact(quadKey, mapId);
+        compactedTiles_.clear();
         {
-            auto way = std::make_shared<Way>();
-            way->tags = readTags();
-            way->coordinates = readCoordinates();
-            return way;
+            // NOTE decoded shared elements keep previous ids.
+            std::lock_guard<SharedMutex> versionsLock(versionsLock_);
+            ++sharedGeneration_;
         }
+        hasUntypedIds_ = false;
+    }
 
-        std::shared_ptr<Area> readArea()
+    /// Calls callback for every live element of published tiles.
+    void visitElements(const std::function<void(const Element&, const QuadKey&)>& callback)
+    {
+        std::vector<QuadKey> quadKeys;
         {
-            auto area = std::make_shared<Area>();
-            area->tags = readTags();
-            area->coordinates = readCoordinates();
-            return area;
+            std::lock_guard<std::mutex> tilesLock(tilesLock_);
+            quadKeys.assign(tiles_.begin(), tiles_.end());
+        }
+        for (const auto& quadKey : quadKeys) {
+            visitEntries(quadKey, [&](const IndexEntry& entry, EntryReader& reader) {
+                callback(*reader.read(entry), quadKey);
+            });
         }
+    }
 
-        std::shared_ptr<Relation> readRelation()
-        {
-            auto relation = std::make_shared<Relation>();
-            relation->tags = readTags();
-            std::uint16_t elementSize;
-            dataFile_.read(reinterpret_cast<char*>(&elementSize), sizeof(elementSize));
-
-            for (std::uint16_t i = 0; i < elementSize; ++i) {
-                std::uint64_t id;
-                dataFile_.read(reinterpret_cast<char*>(&id), sizeof(id));
-                auto element = readElement();
-                element->id = id;
-                relation->elements.push_back(element);
+    /// Requests read ahead of tile files and of shared elements referenced by given quadkey.
+    void prefetch(const QuadKey& quadKey)
+    {
+        std::string indexPath = getFilePath(quadKey, IndexFileExtension);
+        prefetchFile(indexPath);
+        prefetchFile(getFilePath(quadKey, DataFileExtension));
+
+        // NOTE shared data file is shared by all tiles of level: only elements referenced by tile are
+        // read. Index is read by worker, so prefetch does not wait for device.
+        std::string sharedPath = getSharedFilePath(quadKey.levelOfDetail);
+        TaskScheduler::instance().submit([indexPath, sharedPath]() {
+            std::ifstream file(indexPath, std::ios::in | std::ios::binary);
+            std::vector<std::uint32_t> offsets;
+            IndexEntry entry;
+            while (file.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
+                if (isShared(entry))
+                    offsets.push_back(entry.offset);
             }
-            return relation;
+            prefetchParts(sharedPath, offsets);
+        }, TaskPriority::Low);
+    }
+
+    /// Gets version of tile files as they are published. NOTE shared data file is not included:
+    /// tile index is changed when it references new shared element.
+    std::uint64_t getDataVersion(const QuadKey& quadKey)
+    {
+        SharedLock lock(versionsLock_);
+        // NOTE like snapshot, tile which is not written since store is opened is visible completely.
+        std::uint64_t indexSize = utymap::utils::getFileSize(getFilePath(quadKey, IndexFileExtension));
+        std::uint64_t dataSize = utymap::utils::getFileSize(getFilePath(quadKey, DataFileExtension));
+        auto published = versions_.find(quadKey);
+        if (published != versions_.end()) {
+            indexSize = std::min<std::uint64_t>(indexSize, published->second.indexSize);
+            dataSize = std::min<std::uint64_t>(dataSize, published->second.dataSize);
+        }
+        std::uint64_t version = indexSize;
+        version ^= dataSize + 0x9e3779b97f4a7c15ULL + (version << 6) + (version >> 2);
+        for (const auto& extension : { IndexFileExtension, LegacyIndexFileExtension, DataFileExtension, BucketFileExtension }) {
+            std::uint64_t fileVersion = utymap::utils::getFileVersion(getFilePath(quadKey, extension));
+            version ^= fileVersion + 0x9e3779b97f4a7c15ULL + (version << 6) + (version >> 2);
         }
+        return version;
+    }
 
-        inline GeoCoordinate readCoordinate()
-        {
-            GeoCoordinate coord;
-            dataFile_.read(reinterpret_cast<char*>(&coord.latitude), sizeof(coord.latitude));
-            dataFile_.read(reinterpret_cast<char*>(&coord.longitude), sizeof(coord.longitude));
-            return coord;
+    bool hasData(const QuadKey& quadKey) const
+    {
+        std::lock_guard<std::mutex> lock(tilesLock_);
+        if (tiles_.find(quadKey) != tiles_.end())
+            return true;
+        if (missingTiles_.find(quadKey) != missingTiles_.end())
+            return false;
+
+        // NOTE tile can be written by older version which does not maintain manifest.
+        std::ifstream file(getFilePath(quadKey, DataFileExtension));
+        if (!file.good()) {
+            missingTiles_.insert(quadKey);
+            return false;
+        }
+        tiles_.insert(quadKey);
+        isManifestChanged_ = true;
+        return true;
+    }
+
+    void commit()
+    {
+        UTYMAP_TRACE_SCOPE("persistent_commit", "io");
+        std::lock_guard<std::mutex> lock(lock_);
+        flushAll();
+        publish();
+        // NOTE files are closed by destructors.
+        tileFilesMap_.clear();
+        tileFilesList_.clear();
+        sharedFiles_.clear();
+        writeManifest();
+    }
+
+    ~PersistentElementStoreImpl()
+    {
+        try {
+            flushAll();
+            writeManifest();
+        }
+        catch (...) {
+            // NOTE destructor must not throw: call commit explicitly to get errors.
+        }
+    }
+
+private:
+    /// Stores element in data file of quadkey. Should be called under lock.
+    std::size_t storeTile(const Element& element, const QuadKey& quadKey, const Style& style)
+    {
+        TileFiles& files = getFiles(quadKey);
+        addTile(quadKey);
+        std::size_t bufferedBytes = files.dataBuffer.size() + files.indexBuffer.size();
+
+        // write element data
+        std::uint32_t offset = static_cast<std::uint32_t>(files.dataSize + files.dataBuffer.size());
+
+        ElementWriter visitor(files.dataBuffer, files.origin);
+        utymap::entities::visit(element, visitor);
+
+        // write element index. NOTE element type is taken from flags which are just written
+        std::uint8_t elementType = files.dataBuffer[offset - files.dataSize] & 0x3;
+        IndexEntry entry = createIndexEntry(element, offset, elementType, style.getString(builderKeyId_));
+        files.indexBuffer.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+
+        std::size_t writtenBytes = files.dataBuffer.size() + files.indexBuffer.size() - bufferedBytes;
+        bufferedBytes_ += writtenBytes;
+        if (bufferedBytes_ > MaxBufferedBytes)
+            flushAll();
+        return writtenBytes;
+    }
+
+    /// Calls functor for every index entry of published version of quadkey which is not removed.
+    template <typename Functor>
+    void visitEntries(const QuadKey& quadKey, const Functor& functor, const SearchControl* control = nullptr)
+    {
+        visitEntries(Snapshot(*this, quadKey), functor, control);
+    }
+
+    template <typename Functor>
+    void visitEntries(const Snapshot& snapshot, const Functor& functor, const SearchControl* control = nullptr)
+    {
+        visitEntries(snapshot, WorldBoundingBox, functor, control);
+    }
+
+    /// Calls functor for live entries skipping buckets of split tile which do not intersect bounding
+    /// box. Compressed data is inflated only for entries which intersect it. Blocks of these entries
+    /// are inflated before the first entry is visited, so they can be inflated in parallel. Stops as
+    /// soon as search control is stopped, so the rest of entries is not read.
+    template <typename Functor>
+    void visitEntries(const Snapshot& snapshot,
+                      const BoundingBox& bbox,
+                      const Functor& functor,
+                      const SearchControl* control = nullptr)
+    {
+        if (SearchControl::isStopped(control))
+            return;
+
+        const QuadKey& quadKey = snapshot.quadKey;
+        const MappedFile& indexFile = *snapshot.indexFile;
+        const MappedFile& legacyIndexFile = *snapshot.legacyIndexFile;
+
+        std::size_t count = snapshot.indexSize / sizeof(IndexEntry);
+        auto readEntry = [&](std::size_t i) {
+            IndexEntry entry;
+            std::memcpy(&entry, indexFile.data() + i * sizeof(IndexEntry), sizeof(IndexEntry));
+            return entry;
+        };
+
+        // Key: element id, value: position of its last tombstone.
+        std::unordered_map<std::uint64_t, std::size_t> tombstones;
+        for (std::size_t i = 0; i < count; ++i) {
+            IndexEntry entry = readEntry(i);
+            if (entry.offset == TombstoneOffset)
+                tombstones[entry.id] = i;
+        }
+        auto isLive = [&](const IndexEntry& entry, std::size_t i) {
+            if (entry.offset == TombstoneOffset)
+                return false;
+            auto tombstone = tombstones.find(entry.id);
+            return tombstone == tombstones.end() || tombstone->second < i;
+        };
+
+        std::vector<std::pair<std::size_t, std::size_t>> ranges = getEntryRanges(snapshot, count, bbox);
+        std::size_t legacyCount = legacyIndexFile.size() / LegacyIndexEntrySize;
+
+        std::string inflatedData;
+        const char* data = snapshot.dataFile->data();
+        std::size_t dataSize = snapshot.dataSize;
+        if (dataSize > 0 && static_cast<std::uint8_t>(data[0]) == CompressedHeader) {
+            // NOTE legacy entries have no bounding box, so they need all blocks.
+            std::vector<DataBlock> blocks = readBlocks(data, dataSize);
+            std::vector<bool> isUsed(blocks.size(), legacyCount > 0);
+            for (const auto& range : ranges) {
+                for (std::size_t i = range.first; i < range.second; ++i) {
+                    IndexEntry entry = readEntry(i);
+                    if (!blocks.empty() && isLive(entry, i) && !isShared(entry) && matches(entry, bbox, 0))
+                        isUsed[findBlock(blocks, entry.offset)] = true;
+                }
+            }
+            inflatedData = inflateBlocks(data, blocks, isUsed);
+            data = inflatedData.data();
+            dataSize = inflatedData.size();
         }
 
-        inline std::vector<GeoCoordinate> readCoordinates()
+        ElementReader tileReader(data, dataSize, GeoUtils::quadKeyToBoundingBox(quadKey).minPoint);
+        EntryReader reader(*this, snapshot, tileReader);
+
+        const char* legacyEntry = legacyIndexFile.data();
+        for (std::size_t i = 0; i < legacyCount; ++i, legacyEntry += LegacyIndexEntrySize) {
+            std::uint64_t id;
+            std::uint32_t offset;
+            std::memcpy(&id, legacyEntry, sizeof(id));
+            std::memcpy(&offset, legacyEntry + sizeof(id), sizeof(offset));
+
+            // NOTE legacy entries precede entries of index file.
+            if (SearchControl::isStopped(control))
+                return;
+            if (tombstones.find(id) == tombstones.end())
+                functor(createLegacyEntry(id, offset), reader);
+        }
+
+        for (const auto& range : ranges) {
+            for (std::size_t i = range.first; i < range.second; ++i) {
+                if (SearchControl::isStopped(control))
+                    return;
+                IndexEntry entry = readEntry(i);
+                if (isLive(entry, i))
+                    functor(entry, reader);
+            }
+        }
+    }
+
+    /// Returns ranges of entries which are visited by search in bounding box: entries of buckets
+    /// which intersect it and entries written after split. Tile which is not split has single range.
+    static std::vector<std::pair<std::size_t, std::size_t>> getEntryRanges(const Snapshot& snapshot, std::size_t count, const BoundingBox& bbox)
+    {
+        std::vector<std::pair<std::size_t, std::size_t>> ranges;
+        const MappedFile& bucketFile = *snapshot.bucketFile;
+        std::uint32_t header[4];
+        if (bucketFile.size() < sizeof(header)) {
+            ranges.emplace_back(0, count);
+            return ranges;
+        }
+
+        std::memcpy(header, bucketFile.data(), sizeof(header));
+        if (header[0] != BucketMagic || header[2] > count ||
+            sizeof(header) + static_cast<std::size_t>(header[1]) * sizeof(TileBucket) > bucketFile.size())
+            throw std::domain_error("Invalid bucket file of tile.");
+
+        for (std::uint32_t i = 0; i < header[1]; ++i) {
+            TileBucket bucket;
+            std::memcpy(&bucket, bucketFile.data() + sizeof(header) + i * sizeof(TileBucket), sizeof(TileBucket));
+            if (static_cast<std::size_t>(bucket.firstEntry) + bucket.entryCount > header[2])
+                throw std::domain_error("Invalid bucket file of tile.");
+            if (bucket.entryCount == 0 || !intersects(bucket, bbox))
+                continue;
+            // NOTE buckets are written in order of their entries, so adjacent ones are merged.
+            if (!ranges.empty() && ranges.back().second == bucket.firstEntry)
+                ranges.back().second += bucket.entryCount;
+            else
+                ranges.emplace_back(bucket.firstEntry, bucket.firstEntry + bucket.entryCount);
+        }
+        if (header[2] < count)
+            ranges.emplace_back(header[2], count);
+        return ranges;
+    }
+
+    /// Live entries of tile cell with their data: offsets are relative to it.
+    struct CellEntries final
+    {
+        std::vector<IndexEntry> entries;
+        std::string data;
+    };
+
+    /// Rewrites files of given quadkey without removed elements. Tile with data larger than split
+    /// size is split into buckets. Ids of elements are replaced if mapper is set. Should be called
+    /// under lock.
+    void compact(const QuadKey& quadKey, const IdMapper& mapId = nullptr)
+    {
+        BoundingBox tileBox = GeoUtils::quadKeyToBoundingBox(quadKey);
+        std::vector<CellEntries> buckets;
+        std::string fingerprintBuffer;
+        bool isSplit = false;
         {
-            std::uint16_t coordSize;
-            dataFile_.read(reinterpret_cast<char*>(&coordSize), sizeof(coordSize));
+            // NOTE pending fingerprints are flushed with pending entries before compaction.
+            Fingerprints fingerprints = readFingerprints(getFilePath(quadKey, FingerprintFileExtension));
+            Snapshot snapshot(*this, quadKey);
+            isSplit = splitSize_ > 0 && getDataSize(snapshot) > splitSize_;
+            std::vector<CellEntries> cells(isSplit ? std::size_t(1) << (2 * SplitDepth) : 1);
+            visitEntries(snapshot, [&](const IndexEntry& entry, EntryReader& reader) {
+                CellEntries& cell = cells[isSplit ? getCell(entry, tileBox) : 0];
+                // NOTE entries of shared elements keep referencing shared data file.
+                IndexEntry compacted = entry;
+                std::shared_ptr<const Element> element;
+                if (!isShared(entry) || mapId)
+                    element = reader.read(entry);
+                if (mapId)
+                    compacted.id = mapId(*element, quadKey);
+                auto fingerprint = fingerprints.find(entry.id);
+                if (fingerprint != fingerprints.end())
+                    appendFingerprint(compacted.id, fingerprint->second, fingerprintBuffer);
+                if (!isShared(entry)) {
+                    compacted.offset = static_cast<std::uint32_t>(cell.data.size());
+                    ElementWriter writer(cell.data, tileBox.minPoint);
+                    utymap::entities::visit(*element, writer);
+                }
+                cell.entries.push_back(compacted);
+            });
+            buckets = isSplit ? mergeCells(cells, splitSize_ / 4) : std::move(cells);
+        }
 
-            std::vector<GeoCoordinate> coordinates;
-            coordinates.reserve(coordSize);
-            for (std::size_t i = 0; i < coordSize; ++i) {
-                coordinates.push_back(readCoordinate());
+        std::string dataBuffer, indexBuffer, bucketBuffer;
+        if (compressData_)
+            dataBuffer.push_back(static_cast<char>(CompressedHeader));
+        std::uint32_t dataSize = 0;
+        for (const auto& bucket : buckets) {
+            TileBucket record = { static_cast<std::uint32_t>(indexBuffer.size() / sizeof(IndexEntry)),
+                                  static_cast<std::uint32_t>(bucket.entries.size()),
+                                  std::numeric_limits<std::int32_t>::max(), std::numeric_limits<std::int32_t>::max(),
+                                  std::numeric_limits<std::int32_t>::min(), std::numeric_limits<std::int32_t>::min() };
+            for (IndexEntry entry : bucket.entries) {
+                if (!isShared(entry))
+                    entry.offset += dataSize;
+                indexBuffer.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+                record.minLatitude = std::min(record.minLatitude, entry.minLatitude);
+                record.minLongitude = std::min(record.minLongitude, entry.minLongitude);
+                record.maxLatitude = std::max(record.maxLatitude, entry.maxLatitude);
+                record.maxLongitude = std::max(record.maxLongitude, entry.maxLongitude);
             }
+            bucketBuffer.append(reinterpret_cast<const char*>(&record), sizeof(record));
 
-            return std::move(coordinates);
+            // NOTE every bucket is compressed separately, so it is inflated only when it is searched.
+            if (compressData_)
+                compressBlock(bucket.data, dataBuffer);
+            else
+                dataBuffer.append(bucket.data);
+            dataSize += static_cast<std::uint32_t>(bucket.data.size());
         }
 
-        inline std::vector<Tag> readTags()
+        // NOTE compacted files are written aside and replace published ones at once.
+        std::string dataPath = getFilePath(quadKey, DataFileExtension);
+        std::string indexPath = getFilePath(quadKey, IndexFileExtension);
+        std::string bucketPath = getFilePath(quadKey, BucketFileExtension);
+        std::string fingerprintPath = getFilePath(quadKey, FingerprintFileExtension);
+        std::uint32_t dataFileSize = 0;
+        isSplit = isSplit && !indexBuffer.empty();
+        if (!indexBuffer.empty()) {
+            dataFileSize = static_cast<std::uint32_t>(dataBuffer.size());
+            writeFile(dataPath + TemporaryFileExtension, dataBuffer);
+            writeFile(indexPath + TemporaryFileExtension, indexBuffer);
+        }
+        if (isSplit) {
+            std::uint32_t header[4] = { BucketMagic, static_cast<std::uint32_t>(buckets.size()),
+                                        static_cast<std::uint32_t>(indexBuffer.size() / sizeof(IndexEntry)), dataSize };
+            bucketBuffer.insert(0, reinterpret_cast<const char*>(header), sizeof(header));
+            writeFile(bucketPath + TemporaryFileExtension, bucketBuffer);
+        }
+        if (!fingerprintBuffer.empty())
+            writeFile(fingerprintPath + TemporaryFileExtension, fingerprintBuffer);
+
+        // NOTE files should be closed before they are replaced.
+        auto filesPair = tileFilesMap_.find(quadKey);
+        if (filesPair != tileFilesMap_.end()) {
+            tileFilesList_.erase(filesPair->second);
+            tileFilesMap_.erase(filesPair);
+        }
+
+        std::vector<FileChange> changes = {
+            { dataPath, indexBuffer.empty() },
+            { indexPath, indexBuffer.empty() },
+            { bucketPath, !isSplit },
+            { getFilePath(quadKey, LegacyIndexFileExtension), true },
+            { fingerprintPath, fingerprintBuffer.empty() }
+        };
+        writeJournal(changes);
         {
-            std::uint16_t tagSize;
-            dataFile_.read(reinterpret_cast<char*>(&tagSize), sizeof(tagSize));
-
-            std::vector<Tag> tags;
-            for (std::size_t i = 0; i < tagSize; ++i) {
-                Tag tag;
-                dataFile_.read(reinterpret_cast<char*>(&tag.key), sizeof(tag.key));
-                dataFile_.read(reinterpret_cast<char*>(&tag.value), sizeof(tag.value));
-                tags.push_back(tag);
+            std::lock_guard<SharedMutex> lock(versionsLock_);
+            for (const auto& change : changes) {
+                if (!applyChange(change))
+                    throw std::domain_error("Unable to replace compacted files of " + indexPath);
             }
+            versions_[quadKey] = TileVersion { static_cast<std::uint32_t>(indexBuffer.size()), dataFileSize, ++sequence_ };
+        }
+        std::remove(getJournalPath().c_str());
+        {
+            std::lock_guard<std::mutex> lock(fingerprintsLock_);
+            fingerprints_.erase(quadKey);
+        }
 
-            return std::move(tags);
+        if (indexBuffer.empty())
+            removeTile(quadKey);
+    }
+
+    /// Merges consecutive non empty cells into buckets which have at least given size of data.
+    static std::vector<CellEntries> mergeCells(std::vector<CellEntries>& cells, std::size_t bucketSize)
+    {
+        std::vector<CellEntries> buckets;
+        for (auto& cell : cells) {
+            if (cell.entries.empty())
+                continue;
+            if (buckets.empty() || buckets.back().data.size() >= bucketSize) {
+                buckets.push_back(std::move(cell));
+                continue;
+            }
+
+            CellEntries& bucket = buckets.back();
+            for (IndexEntry entry : cell.entries) {
+                if (!isShared(entry))
+                    entry.offset += static_cast<std::uint32_t>(bucket.data.size());
+                bucket.entries.push_back(entry);
+            }
+            bucket.data.append(cell.data);
         }
+        return buckets;
+    }
 
-        std::fstream& dataFile_;
+    /// Returns size of uncompressed data of tile version.
+    static std::size_t getDataSize(const Snapshot& snapshot)
+    {
+        const char* data = snapshot.dataFile->data();
+        if (snapshot.dataSize == 0 || static_cast<std::uint8_t>(data[0]) != CompressedHeader)
+            return snapshot.dataSize;
+
+        std::vector<DataBlock> blocks = readBlocks(data, snapshot.dataSize);
+        return blocks.empty() ? 0 : blocks.back().offset + blocks.back().rawSize;
+    }
+
+    /// Writes content to file replacing existing one.
+    static void writeFile(const std::string& path, const std::string& content)
+    {
+        std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(content.data(), content.size());
+        if (!file.good())
+            throw std::domain_error("Unable to write " + path);
+    }
+
+    /// Change of file made by compaction.
+    struct FileChange final
+    {
+        std::string path;
+        bool isRemoved;
     };
-}
 
-class PersistentElementStore::PersistentElementStoreImpl final
-{
-public:
-    explicit PersistentElementStoreImpl(const std::string& dataPath)
-            : dataPath_(dataPath)
+    std::string getJournalPath() const { return dataPath_ + JournalFileName; }
+
+    /// Writes journal of changes before they are applied. Temporary versions of replacing files
+    /// should be complete.
+    void writeJournal(const std::vector<FileChange>& changes) const
     {
+        std::string journal;
+        for (const auto& change : changes) {
+            std::string path = change.path.substr(dataPath_.size());
+            std::uint32_t size = static_cast<std::uint32_t>(path.size());
+            journal.push_back(change.isRemoved ? 1 : 0);
+            journal.append(reinterpret_cast<const char*>(&size), sizeof(size));
+            journal.append(path);
+        }
+        std::string journalPath = getJournalPath();
+        writeFile(journalPath + TemporaryFileExtension, journal);
+        if (!utymap::utils::replaceFile(journalPath + TemporaryFileExtension, journalPath))
+            throw std::domain_error("Unable to write " + journalPath);
     }
 
-    void store(const Element& element, const QuadKey& quadKey)
+    /// Applies change of file. Replacing file is renamed over existing one, so readers which open it
+    /// never miss it. Returns false if file cannot be replaced.
+    static bool applyChange(const FileChange& change)
     {
-        ensureFiles(quadKey);
+        if (change.isRemoved) {
+            std::remove(change.path.c_str());
+            return true;
+        }
+        return utymap::utils::replaceFile(change.path + TemporaryFileExtension, change.path);
+    }
 
-        // write element data
-        std::uint32_t offset = static_cast<std::uint32_t>(dataFile_.tellg());
+    /// Finishes changes of files interrupted by compaction. Files which are already replaced have
+    /// no temporary versions and are skipped.
+    void finishJournal()
+    {
+        std::string journalPath = getJournalPath();
+        std::ifstream file(journalPath, std::ios::in | std::ios::binary);
+        if (!file.good())
+            return;
 
-        ElementWriter visitor(dataFile_);
-        element.accept(visitor);
+        char operation;
+        std::uint32_t size;
+        while (file.get(operation) && file.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+            std::string path(size, '\0');
+            if (size > 0 && !file.read(&path[0], size))
+                break;
+            FileChange change = { dataPath_ + path, operation != 0 };
+            if (change.isRemoved || std::ifstream(change.path + TemporaryFileExtension).good())
+                applyChange(change);
+        }
+        file.close();
+        std::remove(journalPath.c_str());
+    }
 
-        // write element index
-        indexFile_.seekg(0, std::ios::end);
-        indexFile_.write(reinterpret_cast<const char*>(&element.id), sizeof(element.id));
-        indexFile_.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    /// Rewrites shared data file of level keeping only elements referenced by live entries of its tiles
+    /// when most of its data is removed. Indices of tiles which reference it are rewritten with new offsets
+    /// and replaced with it at once. Should be called under lock when pending data is published.
+    void compactShared(int levelOfDetail)
+    {
+        std::string sharedPath = getSharedFilePath(levelOfDetail);
+        MappedFile sharedFile(sharedPath);
+        if (sharedFile.size() == 0)
+            return;
+
+        std::vector<QuadKey> quadKeys;
+        {
+            std::lock_guard<std::mutex> lock(tilesLock_);
+            for (const auto& quadKey : tiles_) {
+                if (quadKey.levelOfDetail == levelOfDetail)
+                    quadKeys.push_back(quadKey);
+            }
+        }
+
+        // Key: offset in shared data file, value: offset in compacted one.
+        std::unordered_map<std::uint32_t, std::uint32_t> offsets;
+        std::string sharedBuffer;
+        std::vector<std::pair<QuadKey, std::string>> indices;
+        ElementReader reader(sharedFile.data(), sharedFile.size(), GeoCoordinate(0, 0));
+        for (const auto& quadKey : quadKeys) {
+            Snapshot snapshot(*this, quadKey);
+            std::string indexBuffer(snapshot.indexFile->data(), snapshot.indexSize - snapshot.indexSize % sizeof(IndexEntry));
+            std::vector<IndexEntry> entries(indexBuffer.size() / sizeof(IndexEntry));
+            if (!entries.empty())
+                std::memcpy(entries.data(), indexBuffer.data(), indexBuffer.size());
+
+            // NOTE entries hidden by later tombstones are never read, so they keep previous offsets.
+            std::unordered_set<std::uint64_t> removedIds;
+            bool hasShared = false;
+            for (std::size_t i = entries.size(); i > 0; --i) {
+                IndexEntry& entry = entries[i - 1];
+                if (entry.offset == TombstoneOffset)
+                    removedIds.insert(entry.id);
+                if (!isShared(entry) || removedIds.find(entry.id) != removedIds.end())
+                    continue;
+
+                auto offset = offsets.find(entry.offset);
+                if (offset == offsets.end()) {
+                    offset = offsets.emplace(entry.offset, static_cast<std::uint32_t>(sharedBuffer.size())).first;
+                    ElementWriter writer(sharedBuffer, GeoCoordinate(0, 0));
+                    utymap::entities::visit(*reader.readElement(entry.id, entry.offset), writer);
+                }
+                entry.offset = offset->second;
+                hasShared = true;
+            }
+            if (hasShared) {
+                std::memcpy(&indexBuffer[0], entries.data(), indexBuffer.size());
+                indices.emplace_back(quadKey, std::move(indexBuffer));
+            }
+        }
+        if (sharedBuffer.size() * 2 > sharedFile.size())
+            return;
+
+        // NOTE files should be closed before they are replaced.
+        sharedFiles_.erase(levelOfDetail);
+        writeFile(sharedPath + TemporaryFileExtension, sharedBuffer);
+        std::vector<FileChange> changes = { { sharedPath, false } };
+        for (const auto& index : indices) {
+            auto filesPair = tileFilesMap_.find(index.first);
+            if (filesPair != tileFilesMap_.end()) {
+                tileFilesList_.erase(filesPair->second);
+                tileFilesMap_.erase(filesPair);
+            }
+            std::string indexPath = getFilePath(index.first, IndexFileExtension);
+            writeFile(indexPath + TemporaryFileExtension, index.second);
+            changes.push_back(FileChange { indexPath, false });
+        }
+
+        writeJournal(changes);
+        {
+            std::lock_guard<SharedMutex> lock(versionsLock_);
+            for (const auto& change : changes) {
+                if (!applyChange(change))
+                    throw std::domain_error("Unable to replace compacted shared data of " + sharedPath);
+            }
+            ++sequence_;
+            for (const auto& index : indices) {
+                auto version = versions_.find(index.first);
+                if (version != versions_.end())
+                    version->second.sequence = sequence_;
+            }
+            ++sharedGeneration_;
+            std::lock_guard<std::mutex> sharedLock(sharedDataLock_);
+            sharedData_.erase(levelOfDetail);
+        }
+        std::remove(getJournalPath().c_str());
     }
 
-    void search(const QuadKey& quadKey, ElementVisitor& visitor)
+    /// Converts entries of tile indices written by older version which mark shared entries by offset
+    /// flag. Converted entries have no flag, so interrupted conversion is repeated when store is opened.
+    void convertSharedOffsets()
     {
-        ensureFiles(quadKey);
+        for (const auto& quadKey : tiles_) {
+            std::string indexPath = getFilePath(quadKey, IndexFileExtension);
+            std::vector<IndexEntry> entries;
+            {
+                MappedFile indexFile(indexPath);
+                entries.resize(indexFile.size() / sizeof(IndexEntry));
+                if (entries.empty())
+                    continue;
+                std::memcpy(entries.data(), indexFile.data(), entries.size() * sizeof(IndexEntry));
+            }
 
-        std::uint32_t count = static_cast<std::uint32_t>(indexFile_.tellg() /
-                (sizeof(std::uint64_t) + sizeof(std::uint32_t)));
+            bool isChanged = false;
+            for (auto& entry : entries) {
+                if (entry.offset == TombstoneOffset || (entry.offset & SharedOffsetFlag) == 0)
+                    continue;
+                entry.offset &= ~SharedOffsetFlag;
+                entry.mask &= ~ElementTypeMask;
+                isChanged = true;
+            }
+            if (!isChanged)
+                continue;
 
-        ElementReader reader(dataFile_);
+            writeFile(indexPath + TemporaryFileExtension,
+                      std::string(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(IndexEntry)));
+            if (!applyChange(FileChange { indexPath, false }))
+                throw std::domain_error("Unable to replace " + indexPath);
+        }
+    }
 
-        indexFile_.seekg(0, std::ios::beg);
-        for (std::uint32_t i = 0; i < count; ++i) {
-            std::uint64_t id;
-            std::uint32_t offset;
-            indexFile_.read(reinterpret_cast<char*>(&id), sizeof(id));
-            indexFile_.read(reinterpret_cast<char*>(&offset), sizeof(offset));
+    /// Gets tag index of tile version building it from all live entries if necessary.
+    std::shared_ptr<const TagIndex> getTagIndex(const Snapshot& snapshot)
+    {
+        {
+            std::lock_guard<std::mutex> lock(tagIndicesLock_);
+            auto tagIndex = tagIndices_.find(snapshot.quadKey);
+            // NOTE index of other version is rebuilt: ordinals of entries are changed.
+            if (tagIndex != tagIndices_.end() && tagIndex->second.first == snapshot.sequence)
+                return tagIndex->second.second;
+        }
+
+        auto tagIndex = std::make_shared<TagIndex>();
+        std::uint32_t position = 0;
+        visitEntries(snapshot, [&](const IndexEntry& entry, EntryReader& reader) {
+            tagIndex->add(position++, reader.read(entry)->tags);
+        });
+
+        std::lock_guard<std::mutex> lock(tagIndicesLock_);
+        if (tagIndices_.size() >= MaxTagIndices)
+            tagIndices_.clear();
+        auto& cached = tagIndices_[snapshot.quadKey];
+        if (cached.second == nullptr || cached.first < snapshot.sequence)
+            cached = std::make_pair(snapshot.sequence, tagIndex);
+        return tagIndex;
+    }
 
-            reader.readElement(id, offset)->accept(visitor);
+    /// Marks tile as having data. Called on every change of tile.
+    void addTile(const QuadKey& quadKey)
+    {
+        std::lock_guard<std::mutex> lock(tilesLock_);
+        if (tiles_.insert(quadKey).second) {
+            missingTiles_.erase(quadKey);
+            isManifestChanged_ = true;
         }
     }
 
-    bool hasData(const QuadKey& quadKey) const
+    /// Marks tile as having no data.
+    void removeTile(const QuadKey& quadKey)
     {
-        std::ifstream file(getFilePath(quadKey, DataFileExtension));
-        return file.good();
+        std::lock_guard<std::mutex> lock(tilesLock_);
+        if (tiles_.erase(quadKey) > 0)
+            isManifestChanged_ = true;
+        missingTiles_.insert(quadKey);
     }
 
-    void commit()
+    /// Loads tiles from manifest file if it exists.
+    void readManifest()
     {
-        closeFiles();
-        currentQuadKey_ = QuadKey();
+        std::ifstream file(dataPath_ + ManifestFileName, std::ios::in | std::ios::binary);
+        std::uint32_t header[2];
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header)))
+            return;
+
+        if (header[0] == ManifestMagic || header[0] == SharedOffsetManifestMagic || header[0] == UntypedManifestMagic) {
+            std::vector<std::uint64_t> keys(header[1]);
+            if (!keys.empty() && !file.read(reinterpret_cast<char*>(keys.data()), keys.size() * sizeof(std::uint64_t)))
+                return;
+
+            tiles_.reserve(header[1]);
+            for (std::uint64_t key : keys)
+                tiles_.insert(PackedQuadKey::fromValue(key).unpack());
+            hasUntypedIds_ = header[0] == UntypedManifestMagic && !tiles_.empty();
+            isManifestChanged_ = hasUntypedIds_;
+        }
+        else if (header[0] == LegacyManifestMagic) {
+            std::vector<std::int32_t> keys(3 * static_cast<std::size_t>(header[1]));
+            if (!keys.empty() && !file.read(reinterpret_cast<char*>(keys.data()), keys.size() * sizeof(std::int32_t)))
+                return;
+
+            tiles_.reserve(header[1]);
+            for (std::size_t i = 0; i < keys.size(); i += 3)
+                tiles_.insert(QuadKey(keys[i], keys[i + 1], keys[i + 2]));
+            hasUntypedIds_ = !tiles_.empty();
+            // NOTE rewrite manifest in current format on next commit.
+            isManifestChanged_ = true;
+        }
+        else
+            return;
+
+        if (header[0] != ManifestMagic) {
+            convertSharedOffsets();
+            file.close();
+            // NOTE manifest of store with untyped ids is written when they are migrated.
+            isManifestChanged_ = true;
+            if (!hasUntypedIds_)
+                writeManifest();
+        }
+    }
+
+    /// Writes manifest file if set of tiles is changed.
+    void writeManifest()
+    {
+        std::lock_guard<std::mutex> lock(tilesLock_);
+        if (!isManifestChanged_)
+            return;
+
+        // NOTE keys are sorted by level and then along Z curve.
+        std::vector<std::uint64_t> keys;
+        keys.reserve(tiles_.size());
+        for (const auto& quadKey : tiles_)
+            keys.push_back(PackedQuadKey(quadKey).value);
+        std::sort(keys.begin(), keys.end());
+
+        std::uint32_t header[2] = { ManifestMagic, static_cast<std::uint32_t>(keys.size()) };
+        std::ofstream file(dataPath_ + ManifestFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(keys.data()), keys.size() * sizeof(std::uint64_t));
+        isManifestChanged_ = !file.good();
     }
 
-private:
     /// Gets full file path for given quadkey
     inline std::string getFilePath(const QuadKey& quadKey, const std::string& extension) const
     {
-        std::stringstream ss;
-        ss << dataPath_ << quadKey.levelOfDetail << "/" << GeoUtils::quadKeyToString(quadKey) << extension;
-        return ss.str();
+        // NOTE path is built in single buffer: it is called for every opened tile file.
+        std::string levelOfDetail = std::to_string(quadKey.levelOfDetail);
+        std::string path;
+        path.reserve(dataPath_.size() + levelOfDetail.size() + quadKey.levelOfDetail + extension.size() + 1);
+        path.append(dataPath_).append(levelOfDetail).append(1, '/');
+        std::size_t position = path.size();
+        path.append(static_cast<std::size_t>(quadKey.levelOfDetail), '0');
+        GeoUtils::writeQuadKeyDigits(PackedQuadKey(quadKey), &path[position]);
+        return path.append(extension);
+    }
+
+    /// Gets opened files for given quadkey. Least recently used files are closed when limit is reached.
+    TileFiles& getFiles(const QuadKey& quadKey)
+    {
+        auto filesPair = tileFilesMap_.find(quadKey);
+        if (filesPair != tileFilesMap_.end()) {
+            // move to the front as most recently used
+            tileFilesList_.splice(tileFilesList_.begin(), tileFilesList_, filesPair->second);
+            return *filesPair->second->second;
+        }
+
+        if (tileFilesList_.size() >= MaxOpenedTiles) {
+            // NOTE index entries should not reference shared data which is not written yet.
+            flushShared(tileFilesList_.back().first.levelOfDetail);
+            flush(*tileFilesList_.back().second);
+            tileFilesMap_.erase(tileFilesList_.back().first);
+            tileFilesList_.pop_back();
+        }
+
+        using std::ios;
+        auto files = utymap::utils::make_unique<TileFiles>();
+        files->quadKey = quadKey;
+        files->dataFile.open(getFilePath(quadKey, DataFileExtension), ios::in | ios::out | ios::binary | ios::app | ios::ate);
+        files->indexFile.open(getFilePath(quadKey, IndexFileExtension), ios::in | ios::out | ios::binary | ios::app | ios::ate);
+        files->origin = GeoUtils::quadKeyToBoundingBox(quadKey).minPoint;
+        files->dataFileSize = static_cast<std::uint32_t>(files->dataFile.tellg());
+        files->indexFileSize = static_cast<std::uint32_t>(files->indexFile.tellg());
+        files->dataSize = files->dataFileSize;
+        files->isCompressed = files->dataSize > 0 ? readCompressedSize(*files) : compressData_;
+        files->splitDataSize = readSplitDataSize(quadKey);
+
+        // NOTE existing content is published before it is appended, so searches do not see appends.
+        {
+            std::lock_guard<SharedMutex> lock(versionsLock_);
+            versions_.emplace(quadKey, TileVersion { files->indexFileSize, files->dataFileSize, 0 });
+        }
+
+        tileFilesList_.emplace_front(quadKey, std::move(files));
+        tileFilesMap_[quadKey] = tileFilesList_.begin();
+
+        return *tileFilesList_.front().second;
     }
 
-    /// Ensures that open/close function is called on files.
-    inline void ensureFiles(const QuadKey& quadKey)
+    /// Writes pending data of given quadkey files to disk.
+    void flush(TileFiles& files)
     {
-        if (quadKey == currentQuadKey_)
+        if (!files.fingerprintBuffer.empty())
+            flushFingerprints(files);
+        if (files.dataBuffer.empty() && files.indexBuffer.empty())
             return;
 
-        closeFiles();
-        
+        UTYMAP_TRACE_SCOPE("persistent_flush", "io");
+
+        if (files.isCompressed) {
+            std::string block;
+            if (files.dataSize == 0)
+                block.push_back(static_cast<char>(CompressedHeader));
+            compressBlock(files.dataBuffer, block);
+            files.dataFile.write(block.data(), block.size());
+            files.dataFileSize += static_cast<std::uint32_t>(block.size());
+        } else {
+            files.dataFile.write(files.dataBuffer.data(), files.dataBuffer.size());
+            files.dataFileSize += static_cast<std::uint32_t>(files.dataBuffer.size());
+        }
+        // NOTE data is flushed first as index entries reference it.
+        files.dataFile.flush();
+        // NOTE shared data file has no index file: it is referenced only by published entries.
+        if (files.indexFile.is_open()) {
+            files.indexFile.write(files.indexBuffer.data(), files.indexBuffer.size());
+            files.indexFile.flush();
+            files.indexFileSize += static_cast<std::uint32_t>(files.indexBuffer.size());
+            pendingVersions_[files.quadKey] = TileVersion { files.indexFileSize, files.dataFileSize, 0 };
+        }
+
+        files.dataSize += static_cast<std::uint32_t>(files.dataBuffer.size());
+        // NOTE split tile is split again only when its data is doubled.
+        if (files.indexFile.is_open() && splitSize_ > 0 && files.dataSize > splitSize_ &&
+            files.dataSize > 2 * static_cast<std::size_t>(files.splitDataSize))
+            compactedTiles_.insert(files.quadKey);
+        bufferedBytes_ -= files.dataBuffer.size() + files.indexBuffer.size();
+
+        files.dataBuffer.clear();
+        files.indexBuffer.clear();
+    }
+
+    /// Appends pending fingerprints to fingerprint file of tile and drops its cached fingerprints.
+    /// NOTE fingerprints are written before entries are published, so search of previous version
+    /// of replaced element may get fingerprint of the new one: it is built by newer style then.
+    void flushFingerprints(TileFiles& files)
+    {
+        std::string path = getFilePath(files.quadKey, FingerprintFileExtension);
+        std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::app);
+        file.write(files.fingerprintBuffer.data(), files.fingerprintBuffer.size());
+        if (!file.good())
+            throw std::domain_error("Unable to write " + path);
+        files.fingerprintBuffer.clear();
+
+        std::lock_guard<std::mutex> lock(fingerprintsLock_);
+        fingerprints_.erase(files.quadKey);
+    }
+
+    /// Checks whether existing data file is compressed. If so, sets its uncompressed size.
+    bool readCompressedSize(TileFiles& files)
+    {
+        std::uint32_t fileSize = files.dataSize;
+        char header;
+        files.dataFile.seekg(0, std::ios::beg);
+        files.dataFile.read(&header, sizeof(header));
+        if (static_cast<std::uint8_t>(header) != CompressedHeader) {
+            files.dataFile.seekg(0, std::ios::end);
+            return false;
+        }
+
+        files.dataSize = 0;
+        std::uint32_t position = sizeof(header);
+        while (position + 2 * sizeof(std::uint32_t) <= fileSize) {
+            std::uint32_t rawSize, blockSize;
+            files.dataFile.read(reinterpret_cast<char*>(&rawSize), sizeof(rawSize));
+            files.dataFile.read(reinterpret_cast<char*>(&blockSize), sizeof(blockSize));
+            files.dataSize += rawSize;
+            position += 2 * sizeof(std::uint32_t) + blockSize;
+            files.dataFile.seekg(position, std::ios::beg);
+        }
+        files.dataFile.seekg(0, std::ios::end);
+        return true;
+    }
+
+    /// Reads size of uncompressed data of split entries from bucket file of quadkey.
+    std::uint32_t readSplitDataSize(const QuadKey& quadKey) const
+    {
+        std::ifstream file(getFilePath(quadKey, BucketFileExtension), std::ios::in | std::ios::binary);
+        std::uint32_t header[4];
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != BucketMagic)
+            return 0;
+        return header[3];
+    }
+
+    /// Gets path of shared data file for given level of detail.
+    std::string getSharedFilePath(int levelOfDetail) const
+    {
+        return dataPath_ + std::to_string(levelOfDetail) + '/' + SharedFileName + DataFileExtension;
+    }
+
+    /// Gets opened shared data file of given level of detail.
+    TileFiles& getSharedFiles(int levelOfDetail)
+    {
+        auto filesPair = sharedFiles_.find(levelOfDetail);
+        if (filesPair != sharedFiles_.end())
+            return *filesPair->second;
+
         using std::ios;
-        dataFile_.open(getFilePath(quadKey, DataFileExtension), ios::in | ios::out | ios::binary | ios::app | ios::ate);
-        indexFile_.open(getFilePath(quadKey, IndexFileExtension),ios::in | ios::out | ios::binary | ios::app | ios::ate);
+        auto files = utymap::utils::make_unique<TileFiles>();
+        files->dataFile.open(getSharedFilePath(levelOfDetail), ios::in | ios::out | ios::binary | ios::app | ios::ate);
+        files->origin = GeoCoordinate(0, 0);
+        files->dataFileSize = static_cast<std::uint32_t>(files->dataFile.tellg());
+        files->indexFileSize = 0;
+        files->dataSize = files->dataFileSize;
+        files->isCompressed = false;
+        files->splitDataSize = 0;
+        return *(sharedFiles_[levelOfDetail] = std::move(files));
+    }
 
-        currentQuadKey_ = quadKey;
+    /// Writes pending data of shared data file of given level of detail.
+    void flushShared(int levelOfDetail)
+    {
+        auto filesPair = sharedFiles_.find(levelOfDetail);
+        if (filesPair != sharedFiles_.end())
+            flush(*filesPair->second);
     }
 
-    inline void closeFiles()
+    /// Gets mapping of shared data file of given level of detail. Mappings are kept till data is
+    /// published, so searches do not map file every time. Should be called under versions lock.
+    std::shared_ptr<const MappedFile> getSharedData(int levelOfDetail)
     {
-        if (dataFile_.good()) dataFile_.close();
-        if (indexFile_.good()) indexFile_.close();
+        std::string path = getSharedFilePath(levelOfDetail);
+        std::uint64_t version = utymap::utils::getFileVersion(path);
+        std::lock_guard<std::mutex> lock(sharedDataLock_);
+        auto sharedData = sharedData_.find(levelOfDetail);
+        if (sharedData != sharedData_.end()) {
+            if (sharedData->second.first == version)
+                return sharedData->second.second;
+            // NOTE file is replaced since it is mapped, e.g. it is fetched into cache of remote
+            // store, so its decoded elements are not used.
+            ++sharedGeneration_;
+        }
+        auto sharedFile = std::make_shared<const MappedFile>(path);
+        sharedData_[levelOfDetail] = std::make_pair(version, sharedFile);
+        return sharedFile;
+    }
+
+    /// Reads element from shared data file mapped by snapshot. Decoded elements are cached as they are
+    /// usually requested by searches of neighbour tiles. Cached element is used only by snapshots of
+    /// the same generation of shared data file.
+    std::shared_ptr<const Element> readShared(const Snapshot& snapshot, const IndexEntry& entry, ElementReader& reader)
+    {
+        std::uint64_t key = (static_cast<std::uint64_t>(snapshot.quadKey.levelOfDetail) << 32) | entry.offset;
+        {
+            std::lock_guard<std::mutex> lock(sharedElementsLock_);
+            auto element = sharedElements_.find(key);
+            if (element != sharedElements_.end() && element->second.first == snapshot.sharedGeneration)
+                return element->second.second;
+        }
+
+        std::shared_ptr<const Element> element = reader.readElement(entry.id, entry.offset);
+        std::lock_guard<std::mutex> lock(sharedElementsLock_);
+        if (sharedElements_.size() >= MaxSharedElements)
+            sharedElements_.clear();
+        sharedElements_[key] = std::make_pair(snapshot.sharedGeneration, element);
+        return element;
+    }
+
+    /// Writes all pending data to disk.
+    void flushAll()
+    {
+        // NOTE shared data goes first as index entries reference it.
+        for (auto& pair : sharedFiles_)
+            flush(*pair.second);
+        for (auto& pair : tileFilesList_)
+            flush(*pair.second);
+    }
+
+    /// Makes flushed data of all tiles visible to searches at once. Should be called under lock.
+    void publish()
+    {
+        if (pendingVersions_.empty())
+            return;
+
+        std::lock_guard<SharedMutex> lock(versionsLock_);
+        ++sequence_;
+        for (const auto& pair : pendingVersions_)
+            versions_[pair.first] = TileVersion { pair.second.indexSize, pair.second.dataSize, sequence_ };
+        pendingVersions_.clear();
+        // NOTE published entries can reference shared data which is flushed after file is mapped.
+        std::lock_guard<std::mutex> sharedLock(sharedDataLock_);
+        sharedData_.clear();
     }
 
     const std::string dataPath_;
-    
-    QuadKey currentQuadKey_;
+    const bool compressData_;
+    const std::uint32_t builderKeyId_;
 
-    std::fstream indexFile_;
-    std::fstream dataFile_;
+    /// Opened files ordered from most to least recently used.
+    TileFilesList tileFilesList_;
+    TileFilesMap tileFilesMap_;
+    /// Opened shared data files per level of detail.
+    std::unordered_map<int, std::unique_ptr<TileFiles>> sharedFiles_;
+    /// Total amount of pending bytes.
+    std::size_t bufferedBytes_;
+    /// Size of uncompressed data of tile which is split by compaction or zero.
+    std::size_t splitSize_;
+    /// Tiles which are rewritten by next compaction: they have removed elements or should be split.
+    std::unordered_set<QuadKey, QuadKeyHash> compactedTiles_;
+    /// Decoded shared elements with generation of shared data file by level of detail and offset.
+    std::unordered_map<std::uint64_t, std::pair<std::uint64_t, std::shared_ptr<const Element>>> sharedElements_;
+    std::mutex sharedElementsLock_;
+    /// Mappings of shared data files by level of detail with versions of files they are mapped from.
+    /// They are dropped by publication.
+    std::unordered_map<int, std::pair<std::uint64_t, std::shared_ptr<const MappedFile>>> sharedData_;
+    std::mutex sharedDataLock_;
+    /// Generation of shared data files changed by compaction or when file is replaced since it is mapped.
+    std::atomic<std::uint64_t> sharedGeneration_;
+    /// Tag indices of recently searched tiles with sequence of tile version they are built for.
+    std::unordered_map<QuadKey, std::pair<std::uint64_t, std::shared_ptr<const TagIndex>>, QuadKeyHash> tagIndices_;
+    std::mutex tagIndicesLock_;
+    /// Fingerprints of recently searched tiles. Tile entry is dropped when its fingerprints are written.
+    mutable std::unordered_map<QuadKey, std::shared_ptr<const Fingerprints>, QuadKeyHash> fingerprints_;
+    mutable std::mutex fingerprintsLock_;
+    /// Published versions of tiles which are written since store is opened.
+    std::unordered_map<QuadKey, TileVersion, QuadKeyHash> versions_;
+    /// Versions of flushed tiles which are published by next commit.
+    std::unordered_map<QuadKey, TileVersion, QuadKeyHash> pendingVersions_;
+    /// Sequence of last publication.
+    std::uint64_t sequence_;
+    /// Shared by searches while they map tile files, exclusive for publication.
+    SharedMutex versionsLock_;
+    /// Serializes concurrent store calls.
+    std::mutex lock_;
+    /// Tiles which have data.
+    mutable std::unordered_set<QuadKey, QuadKeyHash> tiles_;
+    /// Tiles which are checked on disk and have no data.
+    mutable std::unordered_set<QuadKey, QuadKeyHash> missingTiles_;
+    mutable bool isManifestChanged_;
+    /// Whether store is written by version which keeps osm ids without type bits.
+    bool hasUntypedIds_;
+    /// Guards tile sets which are accessed by hasData.
+    mutable std::mutex tilesLock_;
 };
 
-PersistentElementStore::PersistentElementStore(const std::string& dataPath, StringTable& stringTable) :
-    ElementStore(stringTable), pimpl_(utymap::utils::make_unique<PersistentElementStoreImpl>(dataPath))
+PersistentElementStore::PersistentElementStore(const std::string& dataPath, StringTable& stringTable, bool compressData) :
+    ElementStore(stringTable),
+    pimpl_(utymap::utils::make_unique<PersistentElementStoreImpl>(dataPath, compressData, stringTable.getId(BuilderKey))),
+    dataPath_(dataPath)
 {
+    NameIndex& nameIndex = enableNameIndex();
+    ElementIdIndex& idIndex = enableIdIndex();
+    bool hasNames = nameIndex.read(dataPath_ + NameIndexFileName);
+    bool hasIds = idIndex.read(dataPath_ + IdIndexFileName);
+    if (!hasNames || !hasIds) {
+        // NOTE missing or invalid indices are rebuilt from stored elements. Name of clipped element
+        // is positioned by center of its last fragment.
+        pimpl_->visitElements([&](const Element& element, const QuadKey& quadKey) {
+            if (element.id == 0)
+                return;
+            if (!hasIds)
+                idIndex.add(element.id, quadKey);
+            if (!hasNames) {
+                BoundingBoxVisitor bboxVisitor;
+                utymap::entities::visit(element, bboxVisitor);
+                nameIndex.add(element, bboxVisitor.boundingBox.center());
+            }
+        });
+    }
+    if (!pimpl_->hasUntypedIds())
+        return;
+
+    // NOTE ids of relation members are kept as they are written: they are not used to find elements.
+    std::unordered_set<std::uint64_t> renamedIds;
+    pimpl_->migrateIds([&](const Element& element, const QuadKey& quadKey) {
+        std::uint64_t id = utymap::formats::OsmElementId::element(element.id, element.type);
+        if (id == element.id)
+            return id;
+        idIndex.remove(element.id, quadKey);
+        idIndex.add(id, quadKey);
+        if (renamedIds.insert(id).second) {
+            nameIndex.remove(element.id);
+            Node named;
+            named.id = id;
+            named.tags = element.tags;
+            BoundingBoxVisitor bboxVisitor;
+            utymap::entities::visit(element, bboxVisitor);
+            nameIndex.add(named, bboxVisitor.boundingBox.center());
+        }
+        return id;
+    });
+    // NOTE indices are written before manifest of current version.
+    commit();
 }
 
 PersistentElementStore::~PersistentElementStore()
 {
+    enableNameIndex().write(dataPath_ + NameIndexFileName);
+    enableIdIndex().write(dataPath_ + IdIndexFileName);
+}
+
+void PersistentElementStore::storeImpl(const Element& element, const QuadKey& quadKey, const Style& style)
+{
+    checkPersistentStrings(element);
+    addWrittenBytes(quadKey, pimpl_->store(element, quadKey, style));
+}
+
+void PersistentElementStore::storeSharedImpl(const Element& element, const std::vector<QuadKey>& quadKeys, const Style& style)
+{
+    checkPersistentStrings(element);
+    pimpl_->storeShared(element, quadKeys, style, [&](const QuadKey& quadKey, std::size_t bytes) {
+        addWrittenBytes(quadKey, bytes);
+    });
+}
+
+void PersistentElementStore::storeFingerprint(std::uint64_t id, const QuadKey& quadKey, const StyleFingerprint& fingerprint)
+{
+    pimpl_->storeFingerprint(id, quadKey, fingerprint);
+}
+
+bool PersistentElementStore::findFingerprint(const QuadKey& quadKey, std::uint64_t id, StyleFingerprint& fingerprint) const
+{
+    return pimpl_->findFingerprint(quadKey, id, fingerprint);
+}
+
+void PersistentElementStore::removeImpl(std::uint64_t id, const QuadKey& quadKey)
+{
+    pimpl_->remove(id, quadKey);
+}
+
+void PersistentElementStore::compact()
+{
+    pimpl_->compact();
 }
 
-void PersistentElementStore::storeImpl(const Element& element, const QuadKey& quadKey)
+void PersistentElementStore::setSplitSize(std::size_t size)
 {
-    pimpl_->store(element, quadKey);
+    pimpl_->setSplitSize(size);
 }
 
 void PersistentElementStore::search(const QuadKey& quadKey, ElementVisitor& visitor)
 {
-    pimpl_->search(quadKey, visitor);
+    pimpl_->search(quadKey, WorldBoundingBox, 0, visitor);
+}
+
+void PersistentElementStore::search(const QuadKey& quadKey, const BoundingBox& bbox, ElementVisitor& visitor)
+{
+    pimpl_->search(quadKey, bbox, 0, visitor);
+}
+
+void PersistentElementStore::searchById(const QuadKey& quadKey, std::uint64_t id, ElementVisitor& visitor)
+{
+    pimpl_->searchById(quadKey, id, visitor);
+}
+
+void PersistentElementStore::searchByTag(const QuadKey& quadKey, const BoundingBox& bbox, const std::vector<Tag>& tags, ElementVisitor& visitor)
+{
+    if (tags.empty())
+        pimpl_->search(quadKey, bbox, 0, visitor);
+    else
+        pimpl_->searchByTag(quadKey, bbox, tags, visitor);
+}
+
+void PersistentElementStore::search(const QuadKey& quadKey, const BoundingBox& bbox, const std::string& builderName, ElementVisitor& visitor)
+{
+    pimpl_->search(quadKey, bbox, builderName.empty() ? 0 : getBuilderMask(builderName), visitor);
 }
 
 bool PersistentElementStore::hasData(const QuadKey& quadKey) const
@@ -354,7 +1894,20 @@ bool PersistentElementStore::hasData(const QuadKey& quadKey) const
     return pimpl_->hasData(quadKey);
 }
 
+void PersistentElementStore::prefetch(const QuadKey& quadKey)
+{
+    pimpl_->prefetch(quadKey);
+}
+
+bool PersistentElementStore::getDataVersion(const QuadKey& quadKey, std::uint64_t& version)
+{
+    version = pimpl_->getDataVersion(quadKey);
+    return true;
+}
+
 void PersistentElementStore::commit()
 {
     pimpl_->commit();
+    enableNameIndex().write(dataPath_ + NameIndexFileName);
+    enableIdIndex().write(dataPath_ + IdIndexFileName);
 }
@@ -1,37 +1,109 @@
 #ifndef INDEX_PERSISTENTELEMENTSTORE_HPP_DEFINED
 #define INDEX_PERSISTENTELEMENTSTORE_HPP_DEFINED
 
+#include "BoundingBox.hpp"
 #include "QuadKey.hpp"
 #include "entities/Element.hpp"
 #include "index/ElementStore.hpp"
 
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace utymap { namespace index {
 
-/// Provides API to store elements in persistent store.
+/// Provides API to store elements in persistent store. Searches can run while elements are
+/// stored: they see tiles as they are published by the last commit or compaction.
 class PersistentElementStore final : public ElementStore
 {
 public:
-    explicit PersistentElementStore(const std::string& path,
-                           utymap::index::StringTable& stringTable);
+    /// Creates store in given directory. If compressData is set, new data files are zlib compressed.
+    /// Store written by older version which keeps osm ids without type bits is migrated on open:
+    /// its tiles are rewritten with ids mapped by OsmElementId. Ids of relation members are not changed.
+    PersistentElementStore(const std::string& path,
+                           utymap::index::StringTable& stringTable,
+                           bool compressData = false);
 
     virtual ~PersistentElementStore();
 
     void search(const utymap::QuadKey& quadKey, 
                 utymap::entities::ElementVisitor& visitor) override;
 
+    /// Searches for elements of given quadkey which intersect bounding box using index entries.
+    void search(const utymap::QuadKey& quadKey,
+                const utymap::BoundingBox& bbox,
+                utymap::entities::ElementVisitor& visitor) override;
+
+    /// Searches for elements of given quadkey which intersect bounding box. If builder name is
+    /// not empty, elements which are not built by it are skipped without reading their data.
+    void search(const utymap::QuadKey& quadKey,
+                const utymap::BoundingBox& bbox,
+                const std::string& builderName,
+                utymap::entities::ElementVisitor& visitor);
+
+    /// Reads only elements of index entries with given id.
+    void searchById(const utymap::QuadKey& quadKey,
+                    std::uint64_t id,
+                    utymap::entities::ElementVisitor& visitor) override;
+
+    /// Uses tag index of tile which is built from its elements by first search and kept
+    /// till tile is changed. Only elements of found entries are read.
+    void searchByTag(const utymap::QuadKey& quadKey,
+                      const utymap::BoundingBox& bbox,
+                      const std::vector<utymap::entities::Tag>& tags,
+                      utymap::entities::ElementVisitor& visitor) override;
+
     bool hasData(const utymap::QuadKey& quadKey) const override;
 
+    /// Reads fingerprints of tile file once and keeps them till tile fingerprints are written.
+    bool findFingerprint(const utymap::QuadKey& quadKey,
+                         std::uint64_t id,
+                         StyleFingerprint& fingerprint) const override;
+
+    /// Asks system to read index and data files of tile and parts of shared data file referenced
+    /// by tile in background. Reads of many tiles are served by device at once, so following
+    /// searches do not wait for every read in turn.
+    void prefetch(const utymap::QuadKey& quadKey) override;
+
+    /// Gets version from sizes of published tile files and their modification times.
+    bool getDataVersion(const utymap::QuadKey& quadKey, std::uint64_t& version) override;
+
+    /// Writes pending data and publishes it to searches at once for all tiles.
     void commit() override;
 
+    /// Rewrites files of tiles which have removed elements publishing pending data. Tiles which
+    /// data exceeds split size are split into buckets, so search of their part reads only
+    /// intersecting buckets. Shared data file of level is rewritten when most of its elements are
+    /// removed. Can be called from background thread: it is serialized with store and remove calls.
+    /// NOTE buckets are used by search only: quadkey builder still builds tile as single task as
+    /// aggregate builders, e.g. terrain, need all elements of tile. Parallel build of buckets is
+    /// deferred till builders can merge partial results.
+    void compact() override;
+
+    /// Sets size of uncompressed data of tile which is split by compaction. Zero disables split.
+    void setSplitSize(std::size_t size);
+
 protected:
-    void storeImpl(const utymap::entities::Element& element, const utymap::QuadKey& quadKey) override;
+    void storeImpl(const utymap::entities::Element& element,
+                   const utymap::QuadKey& quadKey,
+                   const utymap::mapcss::Style& style) override;
+
+    /// Writes element once to shared data file of level and references it from every quadkey.
+    void storeSharedImpl(const utymap::entities::Element& element,
+                         const std::vector<utymap::QuadKey>& quadKeys,
+                         const utymap::mapcss::Style& style) override;
+
+    /// Appends fingerprint to tile fingerprint file when tile is flushed.
+    void storeFingerprint(std::uint64_t id,
+                          const utymap::QuadKey& quadKey,
+                          const StyleFingerprint& fingerprint) override;
+
+    void removeImpl(std::uint64_t id, const utymap::QuadKey& quadKey) override;
 
 private:
     class PersistentElementStoreImpl;
     std::unique_ptr<PersistentElementStoreImpl> pimpl_;
+    const std::string dataPath_;
 };
 
 }}
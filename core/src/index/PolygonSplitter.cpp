@@ -0,0 +1,90 @@
+#include "entities/ElementDispatch.hpp"
+#include "index/ElementGeometryClipper.hpp"
+#include "index/PolygonSplitter.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <functional>
+
+using namespace utymap;
+using namespace utymap::entities;
+
+namespace {
+    /// Counts vertices of areas, other vertices are ignored.
+    struct VertexCounter final
+    {
+        std::size_t count = 0;
+        bool hasOther = false;
+
+        void visitNode(const Node&) { hasOther = true; }
+
+        void visitWay(const Way&) { hasOther = true; }
+
+        void visitArea(const Area& area) { count += area.coordinates.size(); }
+
+        void visitRelation(const Relation& relation)
+        {
+            for (const auto& element : relation.elements)
+                utymap::entities::visit(*element, *this);
+        }
+    };
+
+    /// Wraps clipped part into relation which owns its copy.
+    std::shared_ptr<Element> createPiece(const Element& part, const Element& original)
+    {
+        std::shared_ptr<Relation> piece;
+        if (part.type == ElementType::Relation)
+            piece = std::make_shared<Relation>(static_cast<const Relation&>(part));
+        else {
+            piece = std::make_shared<Relation>();
+            piece->elements.push_back(std::make_shared<Area>(static_cast<const Area&>(part)));
+        }
+        piece->id = original.id;
+        piece->tags = original.tags;
+        return piece;
+    }
+}
+
+namespace utymap { namespace index {
+
+PolygonSplitter::PolygonSplitter(std::size_t maxVertices, int maxDepth) :
+    maxVertices_(maxVertices), maxDepth_(maxDepth)
+{
+}
+
+std::size_t PolygonSplitter::countVertices(const Element& element)
+{
+    VertexCounter counter;
+    utymap::entities::visit(element, counter);
+    return counter.count;
+}
+
+std::shared_ptr<Element> PolygonSplitter::split(const Element& element, const QuadKey& quadKey) const
+{
+    VertexCounter counter;
+    utymap::entities::visit(element, counter);
+    if (counter.hasOther || counter.count <= maxVertices_)
+        return nullptr;
+
+    auto result = std::make_shared<Relation>();
+    result->id = element.id;
+    result->tags = element.tags;
+
+    std::function<void(const Element&, const QuadKey&)> splitPart = [&](const Element& part, const QuadKey& partQuadKey) {
+        if (partQuadKey.levelOfDetail - quadKey.levelOfDetail >= maxDepth_ || countVertices(part) <= maxVertices_) {
+            result->elements.push_back(createPiece(part, element));
+            return;
+        }
+
+        // NOTE clipper is recreated for every child as callback splits clipped part further.
+        for (int i = 0; i < 4; ++i) {
+            QuadKey child(partQuadKey.levelOfDetail + 1, partQuadKey.tileX * 2 + i % 2, partQuadKey.tileY * 2 + i / 2);
+            ElementGeometryClipper clipper(splitPart);
+            clipper.clipAndCall(part, child, utymap::utils::GeoUtils::quadKeyToBoundingBox(child));
+        }
+    };
+    splitPart(element, quadKey);
+
+    return result;
+}
+
+}}
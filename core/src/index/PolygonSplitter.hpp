@@ -0,0 +1,38 @@
+#ifndef INDEX_POLYGONSPLITTER_HPP_DEFINED
+#define INDEX_POLYGONSPLITTER_HPP_DEFINED
+
+#include "QuadKey.hpp"
+#include "entities/Element.hpp"
+
+#include <cstddef>
+#include <memory>
+
+namespace utymap { namespace index {
+
+/// Splits large polygons, e.g. land and water of coast, into pieces along quadtree of their
+/// tile, so each piece has limited amount of vertices. Pieces are clipped by child tiles
+/// till they are small enough or max depth is reached. Result is relation with id and tags
+/// of polygon where every member is piece relation, so builders process pieces separately.
+class PolygonSplitter final
+{
+public:
+    /// Creates splitter which keeps at most maxVertices per piece and descends at most
+    /// maxDepth levels below tile.
+    explicit PolygonSplitter(std::size_t maxVertices, int maxDepth = 6);
+
+    /// Returns pieces of area or relation which is stored in given tile or null if element
+    /// is small enough or is not polygon.
+    std::shared_ptr<utymap::entities::Element> split(const utymap::entities::Element& element,
+                                                     const utymap::QuadKey& quadKey) const;
+
+    /// Returns amount of vertices of polygons of element.
+    static std::size_t countVertices(const utymap::entities::Element& element);
+
+private:
+    const std::size_t maxVertices_;
+    const int maxDepth_;
+};
+
+}}
+
+#endif // INDEX_POLYGONSPLITTER_HPP_DEFINED
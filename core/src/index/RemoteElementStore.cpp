@@ -0,0 +1,444 @@
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "index/ElementPrefilter.hpp"
+#include "index/PersistentElementStore.hpp"
+#include "index/RemoteElementStore.hpp"
+#include "index/SearchControl.hpp"
+#include "index/StringTable.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/GeoUtils.hpp"
+#include "utils/TaskScheduler.hpp"
+#include "utils/TraceRecorder.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::index;
+using namespace utymap::entities;
+using namespace utymap::mapcss;
+using namespace utymap::utils;
+
+namespace {
+    /// Files use names of persistent store.
+    const std::string ManifestFileName = "tiles.mft";
+    const std::string IndexFileExtension = ".idx";
+    const std::string DataFileExtension = ".dat";
+    const std::string SharedFileName = "shared";
+    const std::string TemporaryFileExtension = ".tmp";
+    /// Files of string table which ids are used by remote tiles. Packed strings are optional.
+    const std::string StringIndexFileName = "string.idx";
+    const std::string StringDataFileName = "string.dat";
+    const std::string StringPackedFileName = "string.fcd";
+    const std::string StringHashFileName = "string.hsh";
+    /// Keeps version of shared data of level which cached tile index references.
+    const std::string VersionFileExtension = ".ver";
+
+    /// Gets path of tile files relative to store root without extension.
+    std::string getTilePath(const QuadKey& quadKey)
+    {
+        return std::to_string(quadKey.levelOfDetail) + '/' + GeoUtils::quadKeyToString(quadKey);
+    }
+
+    bool exists(const std::string& path)
+    {
+        return std::ifstream(path).good();
+    }
+
+    /// Gets version of file as FNV-1a hash of its content continuing given hash, so versions
+    /// of several files can be chained. Missing file keeps given hash.
+    std::uint64_t getContentVersion(const std::string& path, std::uint64_t hash = 14695981039346656037ull)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.good())
+            return hash;
+
+        char buffer[4096];
+        while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+            for (std::streamsize i = 0; i < file.gcount(); ++i)
+                hash = (hash ^ static_cast<std::uint8_t>(buffer[i])) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::uint64_t readVersion(const std::string& path)
+    {
+        std::uint64_t version = 0;
+        std::ifstream(path) >> version;
+        return version;
+    }
+
+    /// Maps string ids of remote string table to ids of local one and back. Thread safe.
+    class StringMapper final
+    {
+    public:
+        StringMapper(StringTable& localTable, StringTable& remoteTable) :
+            localTable_(localTable), remoteTable_(remoteTable), localIds_(), remoteIds_()
+        {
+        }
+
+        std::uint32_t toLocal(std::uint32_t id) { return map(id, remoteTable_, localTable_, localIds_); }
+
+        std::uint32_t toRemote(std::uint32_t id) { return map(id, localTable_, remoteTable_, remoteIds_); }
+
+        /// Copies element with its members replacing remote ids of tags with local ones.
+        std::shared_ptr<Element> toLocal(const Element& element)
+        {
+            std::shared_ptr<Element> copy;
+            switch (element.type) {
+                case ElementType::Node: copy = std::make_shared<Node>(static_cast<const Node&>(element)); break;
+                case ElementType::Way: copy = std::make_shared<Way>(static_cast<const Way&>(element)); break;
+                case ElementType::Area: copy = std::make_shared<Area>(static_cast<const Area&>(element)); break;
+                default: {
+                    auto relation = std::make_shared<Relation>();
+                    relation->id = element.id;
+                    for (const auto& member : static_cast<const Relation&>(element).elements)
+                        relation->elements.push_back(toLocal(*member));
+                    copy = relation;
+                    break;
+                }
+            }
+            copy->tags.resize(element.tags.size());
+            for (std::size_t i = 0; i < element.tags.size(); ++i)
+                copy->tags[i] = Tag(toLocal(element.tags[i].key), toLocal(element.tags[i].value));
+            // NOTE tags are kept sorted by key id.
+            std::sort(copy->tags.begin(), copy->tags.end());
+            return copy;
+        }
+
+    private:
+        std::uint32_t map(std::uint32_t id, StringTable& source, StringTable& target,
+                          std::unordered_map<std::uint32_t, std::uint32_t>& ids)
+        {
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                auto pair = ids.find(id);
+                if (pair != ids.end())
+                    return pair->second;
+            }
+            std::uint32_t targetId = target.getId(source.getString(id));
+            std::lock_guard<std::mutex> lock(lock_);
+            ids.emplace(id, targetId);
+            return targetId;
+        }
+
+        StringTable& localTable_;
+        StringTable& remoteTable_;
+        std::unordered_map<std::uint32_t, std::uint32_t> localIds_;
+        std::unordered_map<std::uint32_t, std::uint32_t> remoteIds_;
+        std::mutex lock_;
+    };
+
+    /// Passes elements of remote tiles to visitor with tags of local string table. Fingerprints,
+    /// prefilter and search control of visitor are forwarded.
+    class LocalStringVisitor final : public FingerprintElementVisitor, public ElementPrefilter, public SearchControl
+    {
+    public:
+        LocalStringVisitor(ElementVisitor& visitor, StringMapper& mapper) :
+            visitor_(visitor),
+            fingerprintVisitor_(dynamic_cast<FingerprintElementVisitor*>(&visitor)),
+            prefilter_(ElementPrefilter::of(visitor)),
+            control_(SearchControl::of(visitor)),
+            mapper_(mapper)
+        {
+        }
+
+        void visitNode(const Node& node) override { mapper_.toLocal(node)->accept(visitor_); }
+
+        void visitWay(const Way& way) override { mapper_.toLocal(way)->accept(visitor_); }
+
+        void visitArea(const Area& area) override { mapper_.toLocal(area)->accept(visitor_); }
+
+        void visitRelation(const Relation& relation) override { mapper_.toLocal(relation)->accept(visitor_); }
+
+        void setFingerprint(const StyleFingerprint* fingerprint) override
+        {
+            if (fingerprintVisitor_ != nullptr)
+                fingerprintVisitor_->setFingerprint(fingerprint);
+        }
+
+        bool accepts(const Element& element) override
+        {
+            return prefilter_ == nullptr || prefilter_->accepts(*mapper_.toLocal(element));
+        }
+
+        bool isStopped() const override { return SearchControl::isStopped(control_); }
+
+        std::size_t getRemaining() const override { return SearchControl::getRemaining(control_); }
+
+    private:
+        ElementVisitor& visitor_;
+        FingerprintElementVisitor* fingerprintVisitor_;
+        ElementPrefilter* prefilter_;
+        const SearchControl* control_;
+        StringMapper& mapper_;
+    };
+}
+
+class RemoteElementStore::RemoteElementStoreImpl final
+{
+    /// State of files which are requested by key.
+    enum class FetchState { Running, Done };
+
+public:
+    RemoteElementStoreImpl(const std::string& cachePath, StringTable& stringTable, const Fetcher& fetcher) :
+        cachePath_(cachePath), fetcher_(fetcher), stringsVersion_(0), states_(), versions_(),
+        prefetches_(TaskPriority::Low)
+    {
+        // NOTE manifest and strings are refreshed on every start, cached ones are used when
+        // they cannot be fetched.
+        fetch({ ManifestFileName });
+        fetchStrings();
+        // NOTE remote table is only mapped: strings which remote tiles do not use are kept in memory.
+        remoteStringTable_ = utymap::utils::make_unique<StringTable>(cachePath, true);
+        mapper_ = utymap::utils::make_unique<StringMapper>(stringTable, *remoteStringTable_);
+        store_ = utymap::utils::make_unique<PersistentElementStore>(cachePath, *remoteStringTable_);
+    }
+
+    ~RemoteElementStoreImpl()
+    {
+        prefetches_.cancel();
+        prefetches_.wait();
+    }
+
+    /// Searches fetched tile with visitor which receives tags of local string table.
+    template <typename Search>
+    void search(const QuadKey& quadKey, ElementVisitor& visitor, const Search& search)
+    {
+        ensure(quadKey);
+        LocalStringVisitor localVisitor(visitor, *mapper_);
+        search(*store_, localVisitor);
+    }
+
+    /// Converts tags of local string table to tags of remote one.
+    std::vector<Tag> toRemote(const std::vector<Tag>& tags)
+    {
+        std::vector<Tag> remoteTags;
+        remoteTags.reserve(tags.size());
+        for (const auto& tag : tags)
+            remoteTags.push_back(Tag(mapper_->toRemote(tag.key), mapper_->toRemote(tag.value)));
+        return remoteTags;
+    }
+
+    bool hasData(const QuadKey& quadKey) const
+    {
+        return store_->hasData(quadKey);
+    }
+
+    bool getDataVersion(const QuadKey& quadKey, std::uint64_t& version)
+    {
+        // NOTE search fetches tile, so version is taken from files which are searched.
+        ensure(quadKey);
+        return store_->getDataVersion(quadKey, version);
+    }
+
+    void prefetch(const QuadKey& quadKey)
+    {
+        prefetches_.run([this, quadKey]() { ensure(quadKey); });
+    }
+
+private:
+    /// Fetches string table of remote store. Cached hash index is dropped as it is built for
+    /// previous strings.
+    void fetchStrings()
+    {
+        if (fetch({ StringIndexFileName, StringDataFileName })) {
+            if (!fetch({ StringPackedFileName }))
+                std::remove((cachePath_ + StringPackedFileName).c_str());
+            std::remove((cachePath_ + StringHashFileName).c_str());
+        }
+        else if (!exists(cachePath_ + StringIndexFileName))
+            throw std::domain_error("Cannot fetch string table of remote store.");
+
+        stringsVersion_ = getContentVersion(cachePath_ + StringIndexFileName);
+        stringsVersion_ = getContentVersion(cachePath_ + StringDataFileName, stringsVersion_);
+        stringsVersion_ = getContentVersion(cachePath_ + StringPackedFileName, stringsVersion_);
+    }
+
+    /// Fetches files of tile and shared data of its level unless they are cached already.
+    void ensure(const QuadKey& quadKey)
+    {
+        if (!store_->hasData(quadKey))
+            return;
+
+        std::string levelPath = std::to_string(quadKey.levelOfDetail) + '/';
+        std::string tilePath = getTilePath(quadKey);
+        // NOTE shared data is fetched first: tile index may reference it. It is not requested
+        // again when it is missing as level may have no shared elements.
+        coalesce(levelPath + SharedFileName, [&]() {
+            fetch({ levelPath + SharedFileName + DataFileExtension });
+            // NOTE tiles reference ids of remote strings, so they are fetched again when strings change.
+            std::uint64_t version = getContentVersion(cachePath_ + levelPath + SharedFileName + DataFileExtension, stringsVersion_);
+            std::lock_guard<std::mutex> lock(lock_);
+            versions_[quadKey.levelOfDetail] = version;
+            return true;
+        });
+        coalesce(tilePath, [&]() {
+            std::uint64_t version = getVersion(quadKey.levelOfDetail);
+            std::string cachedPath = cachePath_ + tilePath;
+            if (exists(cachedPath + DataFileExtension) &&
+                readVersion(cachedPath + VersionFileExtension) == version)
+                return true;
+
+            // NOTE index of tile cached before remote store was regenerated references offsets
+            // of previous shared data, so it is not kept even if it cannot be fetched again.
+            std::remove((cachedPath + DataFileExtension).c_str());
+            std::remove((cachedPath + IndexFileExtension).c_str());
+            if (!fetch({ tilePath + DataFileExtension, tilePath + IndexFileExtension }))
+                return false;
+            std::ofstream(cachedPath + VersionFileExtension, std::ios::trunc) << version;
+            return true;
+        });
+    }
+
+    std::uint64_t getVersion(int levelOfDetail)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        return versions_[levelOfDetail];
+    }
+
+    /// Runs action once for given key till it succeeds. Concurrent callers wait for running action.
+    template <typename Action>
+    void coalesce(const std::string& key, const Action& action)
+    {
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            auto state = states_.find(key);
+            while (state != states_.end() && state->second == FetchState::Running) {
+                fetched_.wait(lock);
+                state = states_.find(key);
+            }
+            if (state != states_.end())
+                return;
+            states_.emplace(key, FetchState::Running);
+        }
+
+        bool isDone = false;
+        try { isDone = action(); }
+        catch (...) { }
+
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            // NOTE failed fetch is requested again by next caller.
+            if (isDone)
+                states_[key] = FetchState::Done;
+            else
+                states_.erase(key);
+        }
+        fetched_.notify_all();
+    }
+
+    /// Fetches given files into temporary ones and moves them into cache only if all of them
+    /// are fetched, so persistent store never sees part of tile.
+    bool fetch(const std::vector<std::string>& paths)
+    {
+        UTYMAP_TRACE_SCOPE("remote_fetch", "io");
+        bool isFetched = true;
+        for (const auto& path : paths)
+            isFetched = isFetched && fetcher_(path, cachePath_ + path + TemporaryFileExtension);
+
+        for (const auto& path : paths) {
+            std::string cachedPath = cachePath_ + path;
+            std::string temporaryPath = cachedPath + TemporaryFileExtension;
+            if (isFetched) {
+                std::remove(cachedPath.c_str());
+                std::rename(temporaryPath.c_str(), cachedPath.c_str());
+            }
+            else
+                std::remove(temporaryPath.c_str());
+        }
+        return isFetched;
+    }
+
+    const std::string cachePath_;
+    const Fetcher fetcher_;
+    std::unique_ptr<StringTable> remoteStringTable_;
+    std::unique_ptr<StringMapper> mapper_;
+    std::unique_ptr<PersistentElementStore> store_;
+    /// Version of fetched string table.
+    std::uint64_t stringsVersion_;
+    std::unordered_map<std::string, FetchState> states_;
+    /// Versions of shared data of levels fetched by this store.
+    std::unordered_map<int, std::uint64_t> versions_;
+    std::mutex lock_;
+    std::condition_variable fetched_;
+    TaskGroup prefetches_;
+};
+
+RemoteElementStore::RemoteElementStore(const std::string& cachePath, StringTable& stringTable, const Fetcher& fetcher) :
+    ElementStore(stringTable),
+    pimpl_(utymap::utils::make_unique<RemoteElementStoreImpl>(cachePath, stringTable, fetcher))
+{
+}
+
+RemoteElementStore::~RemoteElementStore()
+{
+}
+
+void RemoteElementStore::search(const QuadKey& quadKey, ElementVisitor& visitor)
+{
+    pimpl_->search(quadKey, visitor, [&](PersistentElementStore& store, ElementVisitor& localVisitor) {
+        store.search(quadKey, localVisitor);
+    });
+}
+
+void RemoteElementStore::search(const QuadKey& quadKey, const BoundingBox& bbox, ElementVisitor& visitor)
+{
+    pimpl_->search(quadKey, visitor, [&](PersistentElementStore& store, ElementVisitor& localVisitor) {
+        store.search(quadKey, bbox, localVisitor);
+    });
+}
+
+void RemoteElementStore::searchById(const QuadKey& quadKey, std::uint64_t id, ElementVisitor& visitor)
+{
+    pimpl_->search(quadKey, visitor, [&](PersistentElementStore& store, ElementVisitor& localVisitor) {
+        store.searchById(quadKey, id, localVisitor);
+    });
+}
+
+void RemoteElementStore::searchByTag(const QuadKey& quadKey, const BoundingBox& bbox,
+                                     const std::vector<utymap::entities::Tag>& tags, ElementVisitor& visitor)
+{
+    std::vector<Tag> remoteTags = pimpl_->toRemote(tags);
+    pimpl_->search(quadKey, visitor, [&](PersistentElementStore& store, ElementVisitor& localVisitor) {
+        store.searchByTag(quadKey, bbox, remoteTags, localVisitor);
+    });
+}
+
+bool RemoteElementStore::hasData(const QuadKey& quadKey) const
+{
+    return pimpl_->hasData(quadKey);
+}
+
+void RemoteElementStore::commit()
+{
+}
+
+void RemoteElementStore::prefetch(const QuadKey& quadKey)
+{
+    pimpl_->prefetch(quadKey);
+}
+
+bool RemoteElementStore::getDataVersion(const QuadKey& quadKey, std::uint64_t& version)
+{
+    return pimpl_->getDataVersion(quadKey, version);
+}
+
+void RemoteElementStore::storeImpl(const Element&, const QuadKey&, const Style&)
+{
+    throw std::domain_error("Remote store is read only.");
+}
+
+void RemoteElementStore::removeImpl(std::uint64_t, const QuadKey&)
+{
+    throw std::domain_error("Remote store is read only.");
+}
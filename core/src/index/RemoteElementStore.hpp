@@ -0,0 +1,87 @@
+#ifndef INDEX_REMOTEELEMENTSTORE_HPP_DEFINED
+#define INDEX_REMOTEELEMENTSTORE_HPP_DEFINED
+
+#include "BoundingBox.hpp"
+#include "QuadKey.hpp"
+#include "entities/Element.hpp"
+#include "index/ElementStore.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace utymap { namespace index {
+
+/// Provides read only access to elements of persistent store published by remote endpoint.
+/// Files of tiles are fetched on first access into local cache directory which is read by
+/// persistent store. Manifest is fetched on creation, so tiles without data are not requested.
+/// Shared data of level is fetched again by every store: cached tiles fetched with different
+/// shared data are fetched again too as their indices reference it.
+/// Tiles use ids of string table of remote store, so its files (string.idx, string.dat and
+/// optional string.fcd) should be published in store root. They are fetched on creation and
+/// tags of found elements are mapped to ids of local string table. Cached tiles fetched with
+/// different strings are fetched again.
+class RemoteElementStore final : public ElementStore
+{
+public:
+    /// Fetches file with given path relative to store root (e.g. "1/0.dat") into destination
+    /// path. Returns false if file cannot be fetched. Called concurrently from scheduler threads.
+    typedef std::function<bool(const std::string&, const std::string&)> Fetcher;
+
+    /// Creates store which caches fetched files in given directory. Level of detail directories
+    /// should exist in it as for persistent store. Throws domain_error if remote string table
+    /// can be neither fetched nor found in cache.
+    RemoteElementStore(const std::string& cachePath,
+                       utymap::index::StringTable& stringTable,
+                       const Fetcher& fetcher);
+
+    /// Waits for running prefetches, pending ones are skipped.
+    virtual ~RemoteElementStore();
+
+    void search(const utymap::QuadKey& quadKey,
+                utymap::entities::ElementVisitor& visitor) override;
+
+    void search(const utymap::QuadKey& quadKey,
+                const utymap::BoundingBox& bbox,
+                utymap::entities::ElementVisitor& visitor) override;
+
+    void searchById(const utymap::QuadKey& quadKey,
+                    std::uint64_t id,
+                    utymap::entities::ElementVisitor& visitor) override;
+
+    void searchByTag(const utymap::QuadKey& quadKey,
+                      const utymap::BoundingBox& bbox,
+                      const std::vector<utymap::entities::Tag>& tags,
+                      utymap::entities::ElementVisitor& visitor) override;
+
+    /// Checks remote manifest, so tile is not fetched.
+    bool hasData(const utymap::QuadKey& quadKey) const override;
+
+    /// Does nothing: store is read only.
+    void commit() override;
+
+    /// Fetches files of given tile in background. Concurrent requests of the same tile are
+    /// coalesced with each other and with searches: files are fetched once.
+    void prefetch(const utymap::QuadKey& quadKey) override;
+
+    /// Fetches tile if it is not cached yet and gets version of cached files.
+    bool getDataVersion(const utymap::QuadKey& quadKey, std::uint64_t& version) override;
+
+protected:
+    /// Throws domain_error: store is read only.
+    void storeImpl(const utymap::entities::Element& element,
+                   const utymap::QuadKey& quadKey,
+                   const utymap::mapcss::Style& style) override;
+
+    /// Throws domain_error: store is read only.
+    void removeImpl(std::uint64_t id, const utymap::QuadKey& quadKey) override;
+
+private:
+    class RemoteElementStoreImpl;
+    std::unique_ptr<RemoteElementStoreImpl> pimpl_;
+};
+
+}}
+
+#endif // INDEX_REMOTEELEMENTSTORE_HPP_DEFINED
@@ -0,0 +1,125 @@
+#ifndef INDEX_SEARCHCONTROL_HPP_DEFINED
+#define INDEX_SEARCHCONTROL_HPP_DEFINED
+
+#include "entities/Element.hpp"
+#include "entities/ElementDispatch.hpp"
+#include "entities/ElementVisitor.hpp"
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "index/ElementPrefilter.hpp"
+#include "index/StyleFingerprint.hpp"
+#include "utils/TaskScheduler.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+namespace utymap { namespace index {
+
+/// Implemented by element visitor which can stop search. Stores check it before every element,
+/// so the rest of tile is not read once visitor does not need more elements.
+class SearchControl
+{
+public:
+    /// Returns true if no more elements should be visited.
+    virtual bool isStopped() const = 0;
+
+    /// Returns max amount of elements which visitor still accepts.
+    virtual std::size_t getRemaining() const { return std::numeric_limits<std::size_t>::max(); }
+
+    virtual ~SearchControl() = default;
+
+    /// Returns search control implemented by visitor or null.
+    static const SearchControl* of(const utymap::entities::ElementVisitor& visitor)
+    {
+        return dynamic_cast<const SearchControl*>(&visitor);
+    }
+
+    /// Checks whether visitor stops search.
+    static bool isStopped(const SearchControl* control)
+    {
+        return control != nullptr && control->isStopped();
+    }
+
+    /// Returns max amount of elements which visitor of control still accepts.
+    static std::size_t getRemaining(const SearchControl* control)
+    {
+        return control != nullptr ? control->getRemaining() : std::numeric_limits<std::size_t>::max();
+    }
+};
+
+/// Passes elements to visitor until limit of visited elements is reached or search is cancelled,
+/// e.g. to check existence or to drop search of tile which is not needed anymore. Fingerprints and
+/// prefilter of visitor are forwarded.
+class LimitedElementVisitor final : public FingerprintElementVisitor, public ElementPrefilter, public SearchControl
+{
+public:
+    explicit LimitedElementVisitor(utymap::entities::ElementVisitor& visitor,
+                                   std::size_t maxResults = std::numeric_limits<std::size_t>::max(),
+                                   const utymap::utils::CancellationToken& token = utymap::utils::CancellationToken()) :
+        visitor_(visitor),
+        fingerprintVisitor_(dynamic_cast<FingerprintElementVisitor*>(&visitor)),
+        prefilter_(ElementPrefilter::of(visitor)),
+        control_(SearchControl::of(visitor)),
+        maxResults_(maxResults),
+        token_(token),
+        count_(0)
+    {
+    }
+
+    void visitNode(const utymap::entities::Node& node) override { visitIfNecessary(node); }
+
+    void visitWay(const utymap::entities::Way& way) override { visitIfNecessary(way); }
+
+    void visitArea(const utymap::entities::Area& area) override { visitIfNecessary(area); }
+
+    void visitRelation(const utymap::entities::Relation& relation) override { visitIfNecessary(relation); }
+
+    void setFingerprint(const StyleFingerprint* fingerprint) override
+    {
+        if (fingerprintVisitor_ != nullptr)
+            fingerprintVisitor_->setFingerprint(fingerprint);
+    }
+
+    bool accepts(const utymap::entities::Element& element) override
+    {
+        return !isStopped() && (prefilter_ == nullptr || prefilter_->accepts(element));
+    }
+
+    bool isStopped() const override
+    {
+        return count_ >= maxResults_ || token_.isCancelled() || SearchControl::isStopped(control_);
+    }
+
+    std::size_t getRemaining() const override
+    {
+        return std::min(count_ >= maxResults_ ? 0 : maxResults_ - count_, SearchControl::getRemaining(control_));
+    }
+
+    /// Returns amount of visited elements.
+    std::size_t getCount() const { return count_; }
+
+private:
+    template <typename T>
+    void visitIfNecessary(const T& element)
+    {
+        if (isStopped())
+            return;
+        ++count_;
+        utymap::entities::visit(element, visitor_);
+    }
+
+    utymap::entities::ElementVisitor& visitor_;
+    FingerprintElementVisitor* fingerprintVisitor_;
+    ElementPrefilter* prefilter_;
+    const SearchControl* control_;
+    const std::size_t maxResults_;
+    const utymap::utils::CancellationToken token_;
+    std::size_t count_;
+};
+
+}}
+
+#endif // INDEX_SEARCHCONTROL_HPP_DEFINED
@@ -1,130 +1,803 @@
 #include "hashing/MurmurHash3.h"
 #include "index/StringTable.hpp"
 #include "utils/CoreUtils.hpp"
+#include "utils/VarintUtils.hpp"
 
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <zlib.h>
+
+#include <atomic>
 #include <cstdio>
+#include <cstring>
+#include <deque>
 #include <fstream>
+#include <iterator>
 #include <memory>
 #include <mutex>
-#include <unordered_map>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
 using std::ios;
 using namespace utymap::index;
 
-/// Naive implementation of string table: reads all the time string from file; acquires lock
-/// TODO optimize it to avoid locks and expensive file reads.
+namespace {
+    /// Header of persisted hash index file.
+    struct HashIndexHeader final
+    {
+        std::uint32_t magic;
+        /// Amount of strings covered by index.
+        std::uint32_t count;
+        /// Amount of slots, power of two.
+        std::uint32_t capacity;
+        std::uint32_t reserved;
+    };
+
+    const std::uint32_t HashIndexMagic = 0x31485355;
+
+    ///                                  Front coded data file format
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Header       |  Magic (4b), amount of strings (4b), amount of strings in block (4b), size (4b)   |
+    ///                  |  and hash (4b) of index file which strings are packed from                        |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Offsets      |  Offset of every block from file start (4b) and offset of file end (4b)           |
+    ///------------------------------------------------------------------------------------------------------|
+    ///      Blocks      |  Raw size (4b), compressed size (4b) or zero if block is not compressed, data     |
+    ///------------------------------------------------------------------------------------------------------|
+    /// Raw block data has every string as varint length of prefix shared with previous string of the block,
+    /// varint length of the rest and its characters. Block is compressed by zlib only if it gets smaller.
+    /// Packed strings have the first ids: strings added later are written to index and data files.
+    /// Index and data files are truncated after packed file is written: if index file is still the one
+    /// which strings are packed from, packing was interrupted and its strings are packed already.
+    struct PackedHeader final
+    {
+        std::uint32_t magic;
+        std::uint32_t count;
+        std::uint32_t blockStrings;
+        std::uint32_t indexSize;
+        std::uint32_t indexHash;
+    };
+
+    const std::uint32_t PackedMagic = 0x32435346;
+    /// Header of the first version has no index size and hash.
+    const std::uint32_t LegacyPackedMagic = 0x31435346;
+    const std::size_t LegacyPackedHeaderSize = 3 * sizeof(std::uint32_t);
+    const std::uint32_t PackedBlockStrings = 64;
+    const std::string PackedFileName = "string.fcd";
+
+    /// Returns size of file or zero if file does not exist.
+    std::size_t getFileSize(const std::string& path)
+    {
+        std::ifstream file(path, ios::in | ios::binary | ios::ate);
+        return file.good() ? static_cast<std::size_t>(file.tellg()) : 0;
+    }
+
+    /// Maps whole file into memory. File should not be empty.
+    boost::interprocess::mapped_region mapFile(const std::string& path, boost::interprocess::mode_t mode)
+    {
+        using namespace boost::interprocess;
+        file_mapping mapping(path.c_str(), read_only);
+        return mapped_region(mapping, mode);
+    }
+
+    /// Reads whole file or returns empty string if file does not exist.
+    std::string readFile(const std::string& path)
+    {
+        std::ifstream file(path, ios::in | ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    std::uint32_t getContentHash(const std::string& content)
+    {
+        std::uint32_t hash;
+        MurmurHash3_x86_32(content.data(), static_cast<int>(content.size()), 0, &hash);
+        return hash;
+    }
+
+    /// Writes strings to front coded data file replacing existing one. Content of index file
+    /// which strings are packed from is recorded in header.
+    void writePackedFile(const std::string& path, const std::vector<std::string>& strings, const std::string& index)
+    {
+        auto count = static_cast<std::uint32_t>(strings.size());
+        std::uint32_t blockCount = (count + PackedBlockStrings - 1) / PackedBlockStrings;
+        PackedHeader header = { PackedMagic, count, PackedBlockStrings,
+                                static_cast<std::uint32_t>(index.size()), getContentHash(index) };
+        std::vector<std::uint32_t> offsets;
+        offsets.reserve(blockCount + 1);
+        std::string blocks;
+
+        std::uint32_t start = sizeof(header) + (blockCount + 1) * sizeof(std::uint32_t);
+        for (std::uint32_t block = 0; block < blockCount; ++block) {
+            std::string raw;
+            const std::string* previous = nullptr;
+            for (std::uint32_t id = block * PackedBlockStrings; id < std::min(count, (block + 1) * PackedBlockStrings); ++id) {
+                const std::string& str = strings[id];
+                std::size_t prefix = 0;
+                if (previous != nullptr)
+                    while (prefix < str.size() && prefix < previous->size() && str[prefix] == (*previous)[prefix])
+                        ++prefix;
+                utymap::utils::writeVarint(raw, prefix);
+                utymap::utils::writeVarint(raw, str.size() - prefix);
+                raw.append(str, prefix, std::string::npos);
+                previous = &str;
+            }
+
+            uLongf compressedSize = compressBound(static_cast<uLong>(raw.size()));
+            std::string compressed(compressedSize, '\0');
+            if (compress(reinterpret_cast<Bytef*>(&compressed[0]), &compressedSize,
+                         reinterpret_cast<const Bytef*>(raw.data()), static_cast<uLong>(raw.size())) != Z_OK)
+                throw std::domain_error("Failed to compress string block.");
+            bool isCompressed = compressedSize < raw.size();
+
+            std::uint32_t sizes[2] = { static_cast<std::uint32_t>(raw.size()),
+                                       isCompressed ? static_cast<std::uint32_t>(compressedSize) : 0 };
+            offsets.push_back(start + static_cast<std::uint32_t>(blocks.size()));
+            blocks.append(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+            blocks.append(isCompressed ? compressed.data() : raw.data(), isCompressed ? compressedSize : raw.size());
+        }
+        offsets.push_back(start + static_cast<std::uint32_t>(blocks.size()));
+
+        // NOTE file is replaced only when it is completely written.
+        std::string tmpPath = path + ".tmp";
+        {
+            std::ofstream file(tmpPath, ios::out | ios::binary | ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(std::uint32_t));
+            file.write(blocks.data(), blocks.size());
+            if (!file.good())
+                throw std::domain_error("Cannot write string data file: " + path);
+        }
+        std::remove(path.c_str());
+        if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+            throw std::domain_error("Cannot replace string data file: " + path);
+    }
+}
+
+/// Keeps all strings in append only arena: string data and entries are never moved
+/// once they are published, so getString reads without lock. New entries are published by
+/// atomic increment of size. Writes are serialized by lock and duplicated to files.
+/// Strings which exist on startup are read from memory mapped files and hash index is
+/// mapped from its persisted copy. If persisted copy is stale, it is rebuilt in background.
+/// Shared table does not open files for writing: its new strings exist only in the arena.
+/// Packed strings are read from front coded data file: its blocks are decoded on demand and
+/// kept in per block slots which are read without lock. Only decoding of block which is not
+/// cached takes cache lock to evict the oldest one.
 class StringTable::StringTableImpl
 {
-    typedef std::vector<std::uint32_t> IdList;
-    typedef std::unordered_map<std::uint32_t, IdList> HashIdMap;
+    /// Represents string inside arena.
+    struct Entry final
+    {
+        const char* data;
+        std::uint32_t size;
+    };
+
+    /// Strings of packed block: data of every string is followed by data of the next one.
+    struct DecodedBlock final
+    {
+        std::string data;
+        std::vector<std::uint32_t> offsets;
+    };
+    typedef std::shared_ptr<const DecodedBlock> DecodedBlockPtr;
+
+    /// Represents slot of open addressing hash index.
+    struct Slot final
+    {
+        std::uint32_t hash;
+        std::uint32_t id;
+    };
+
+    /// Entries are allocated in chunks which are never reallocated.
+    static const std::uint32_t ChunkBits = 14;
+    static const std::uint32_t ChunkSize = 1 << ChunkBits;
+    static const std::uint32_t MaxChunks = 1 << 14;
+    /// Size of arena block for new strings.
+    static const std::size_t BlockSize = 64 * 1024;
+    /// Initial capacity of hash index, should be power of two.
+    static const std::uint32_t InitialCapacity = 1 << 16;
+    /// Marks empty slot of hash index.
+    static const std::uint32_t EmptyId = 0xFFFFFFFF;
+    /// Marks number which is not parsed yet. It is NaN which is never produced by parsing.
+    static const std::uint64_t NotParsedNumber = 0xFFFFFFFFFFFFFFFFull;
+    /// Max amount of decoded blocks of packed strings.
+    static const std::size_t MaxCachedBlocks = 256;
 
 public:
-    StringTableImpl(const std::string& indexPath, const std::string& dataPath, std::uint32_t seed) :
-        indexFile_(indexPath, ios::in | ios::out | ios::binary | ios::ate | ios::app),
-        dataFile_(dataPath, ios::in | ios::out | ios::binary | ios::app),
+    StringTableImpl(const std::string& indexPath, const std::string& dataPath, const std::string& hashPath,
+                    const std::string& packedPath, std::uint32_t seed, bool isShared) :
+        indexFile_(),
+        dataFile_(),
+        hashPath_(hashPath),
         seed_(seed),
-        nextId_(0),
-        map_(),
-        offsets_()
-    {
-        nextId_ = static_cast<std::uint32_t>(indexFile_.tellg() / (sizeof(std::uint32_t) * 2));
-        if (nextId_ > 0) {
-            int32_t count = nextId_;
-            offsets_.reserve(count);
-            indexFile_.seekg(0, ios::beg);
-            for (int i = 0; i < count; ++i) {
-                std::uint32_t hash, offset;
-                indexFile_.read(reinterpret_cast<char*>(&hash), sizeof(hash));
-                indexFile_.read(reinterpret_cast<char*>(&offset), sizeof(offset));
-                offsets_.push_back(offset);
-                map_[hash].push_back(i);
-            }
+        isShared_(isShared),
+        size_(0),
+        indexRegion_(),
+        dataRegion_(),
+        hashRegion_(),
+        mappedIndex_(nullptr),
+        mappedData_(nullptr),
+        mappedCount_(0),
+        mappedDataSize_(0),
+        packedRegion_(),
+        packedData_(nullptr),
+        packedOffsets_(nullptr),
+        packedCount_(0),
+        blockStrings_(PackedBlockStrings),
+        packedIndexSize_(0),
+        packedIndexHash_(0),
+        cachedBlocks_(),
+        blockOrder_(),
+        ownedSlots_(),
+        slots_(nullptr),
+        capacity_(0),
+        slotCount_(0),
+        isDirty_(false),
+        indexBuilder_(),
+        chunks_(MaxChunks),
+        numberChunks_(MaxChunks),
+        blocks_(),
+        blockPosition_(BlockSize),
+        dataSize_(0)
+    {
+        openPackedFile(packedPath);
+        // NOTE shared table cannot complete interrupted packing, so it skips packed strings.
+        bool isPacked = isPackedIndex(indexPath);
+        if (isPacked && !isShared_) {
+            std::ofstream(indexPath, ios::out | ios::binary | ios::trunc);
+            std::ofstream(dataPath, ios::out | ios::binary | ios::trunc);
+            isPacked = false;
+        }
+        if (!isShared_) {
+            indexFile_.open(indexPath, ios::in | ios::out | ios::binary | ios::ate | ios::app);
+            dataFile_.open(dataPath, ios::in | ios::out | ios::binary | ios::ate | ios::app);
+        }
+
+        std::uint32_t count = isPacked ? 0 : static_cast<std::uint32_t>(getFileSize(indexPath) / (sizeof(std::uint32_t) * 2));
+        dataSize_ = isPacked ? 0 : static_cast<std::uint32_t>(getFileSize(dataPath));
+
+        // NOTE mapping of empty file is not possible.
+        if (count > 0) {
+            indexRegion_ = mapFile(indexPath, boost::interprocess::read_only);
+            dataRegion_ = mapFile(dataPath, boost::interprocess::read_only);
+            mappedIndex_ = static_cast<const std::uint32_t*>(indexRegion_.get_address());
+            mappedData_ = static_cast<const char*>(dataRegion_.get_address());
+            mappedCount_ = count;
+            mappedDataSize_ = dataSize_;
+        }
+        count += packedCount_;
+        if (count > 0) {
+            for (std::uint32_t chunk = 0; chunk <= (count - 1) >> ChunkBits; ++chunk)
+                addNumberChunk(chunk);
+        }
+
+        if (!openHashIndex(count)) {
+            ownedSlots_.assign(InitialCapacity, Slot { 0, EmptyId });
+            slots_ = ownedSlots_.data();
+            capacity_ = InitialCapacity;
+            isDirty_ = !isShared_;
+            if (count > 0)
+                indexBuilder_ = std::thread(&StringTableImpl::buildHashIndex, this);
         }
+
+        size_.store(count, std::memory_order_release);
+    }
+
+    ~StringTableImpl()
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        flushImpl();
     }
 
     std::uint32_t getId(const std::string& str)
     {
-        std::uint32_t hash;
-        MurmurHash3_x86_32(str.c_str(), static_cast<int>(str.size()), seed_, &hash);
+        std::uint32_t hash = getHash(str.data(), str.size());
 
-        // TODO avoid lock there
         std::lock_guard<std::mutex> lock(lock_);
-        HashIdMap::iterator hashLookupResult = map_.find(hash);
-        if (hashLookupResult != map_.end()) {
-            for (std::uint32_t id : hashLookupResult->second) {
-                std::string data;
-                readString(id, data);
-                if (str == data)
-                    return id;
-            }
+        waitForHashIndex();
+        return getId(hash, str.data(), str.size());
+    }
+
+    std::vector<std::uint32_t> getIds(const std::vector<const char*>& strings)
+    {
+        // NOTE hashes are calculated before lock is taken.
+        std::vector<std::size_t> sizes(strings.size());
+        std::vector<std::uint32_t> ids(strings.size());
+        for (std::size_t i = 0; i < strings.size(); ++i) {
+            sizes[i] = std::strlen(strings[i]);
+            ids[i] = getHash(strings[i], sizes[i]);
+        }
+
+        std::lock_guard<std::mutex> lock(lock_);
+        waitForHashIndex();
+        for (std::size_t i = 0; i < strings.size(); ++i)
+            ids[i] = getId(ids[i], strings[i], sizes[i]);
+
+        return ids;
+    }
+
+    std::string getString(std::uint32_t id) const
+    {
+        // NOTE entry is immutable once its id is below published size.
+        if (id >= size_.load(std::memory_order_acquire))
+            return "";
+
+        return readString(id);
+    }
+
+    double getNumber(std::uint32_t id) const
+    {
+        if (id >= size_.load(std::memory_order_acquire))
+            return 0;
+
+        // NOTE concurrent threads may parse the same string, they store the same value.
+        std::atomic<std::uint64_t>& cached = numberChunks_[id >> ChunkBits][id & (ChunkSize - 1)];
+        std::uint64_t bits = cached.load(std::memory_order_relaxed);
+        double number;
+        if (bits == NotParsedNumber) {
+            number = utymap::utils::parseDouble(readString(id));
+            std::memcpy(&bits, &number, sizeof(bits));
+            cached.store(bits, std::memory_order_relaxed);
+        } else {
+            std::memcpy(&number, &bits, sizeof(number));
         }
+        return number;
+    }
+
+    std::uint32_t size() const
+    {
+        return size_.load(std::memory_order_acquire);
+    }
 
-        writeString(hash, str);
-        return nextId_++;
+    bool isPersistent(std::uint32_t id) const
+    {
+        // NOTE mapped and packed strings are fixed on startup.
+        return !isShared_ || id < packedCount_ + mappedCount_;
     }
 
-    std::string getString(std::uint32_t id)
+    void flush()
     {
-        std::string str;
-        // TODO avoid lock there
         std::lock_guard<std::mutex> lock(lock_);
-        readString(id, str);
-        return str;
+        flushImpl();
     }
 
-    void flush() { /* TODO */ }
+    std::size_t getMemoryUsage()
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        std::size_t usage = ownedSlots_.capacity() * sizeof(Slot) +
+            blocks_.size() * BlockSize +
+            (chunks_.capacity() + numberChunks_.capacity() + blocks_.capacity()) * sizeof(void*);
+        for (std::uint32_t chunk = 0; chunk < MaxChunks; ++chunk) {
+            if (chunks_[chunk] != nullptr)
+                usage += ChunkSize * sizeof(Entry);
+            if (numberChunks_[chunk] != nullptr)
+                usage += ChunkSize * sizeof(std::atomic<std::uint64_t>);
+        }
+
+        std::lock_guard<std::mutex> cacheLock(cacheLock_);
+        usage += blockOrder_.size() * sizeof(std::uint32_t);
+        for (std::uint32_t block : blockOrder_) {
+            DecodedBlockPtr decoded = std::atomic_load(&cachedBlocks_[block]);
+            if (decoded != nullptr)
+                usage += sizeof(DecodedBlock) + decoded->data.capacity() + decoded->offsets.capacity() * sizeof(std::uint32_t);
+        }
+        if (cachedBlocks_ != nullptr)
+            usage += getBlockCount() * sizeof(DecodedBlockPtr);
+        return usage;
+    }
 
 private:
 
-    /// Reads string by id.
-    void readString(std::uint32_t id, std::string& data)
+    std::uint32_t getHash(const char* data, std::size_t size) const
+    {
+        std::uint32_t hash;
+        MurmurHash3_x86_32(data, static_cast<int>(size), seed_, &hash);
+        return hash;
+    }
+
+    /// Finds id of the string or adds it. Should be called under lock.
+    std::uint32_t getId(std::uint32_t hash, const char* data, std::size_t size)
+    {
+        std::uint32_t mask = capacity_ - 1;
+        for (std::uint32_t i = hash & mask; slots_[i].id != EmptyId; i = (i + 1) & mask) {
+            const Slot& slot = slots_[i];
+            if (slot.hash != hash)
+                continue;
+            if (slot.id < packedCount_) {
+                std::string str = readPacked(slot.id);
+                if (str.size() == size && std::memcmp(str.data(), data, size) == 0)
+                    return slot.id;
+                continue;
+            }
+            Entry entry = getEntry(slot.id);
+            if (entry.size == size && std::memcmp(entry.data, data, size) == 0)
+                return slot.id;
+        }
+
+        return addString(hash, data, size);
+    }
+
+    /// Returns entry of string which is not packed. Size of mapped string is taken from offset
+    /// of the next one, so strings are not scanned and may contain null characters.
+    Entry getEntry(std::uint32_t id) const
+    {
+        if (id < packedCount_ + mappedCount_) {
+            std::uint32_t index = id - packedCount_;
+            std::uint32_t offset = mappedIndex_[index * 2 + 1];
+            std::uint32_t end = index + 1 < mappedCount_ ? mappedIndex_[index * 2 + 3] : mappedDataSize_;
+            // NOTE every string is followed by null terminator.
+            return Entry { mappedData_ + offset, end - offset - 1 };
+        }
+        return chunks_[id >> ChunkBits][id & (ChunkSize - 1)];
+    }
+
+    std::string readString(std::uint32_t id) const
+    {
+        if (id < packedCount_)
+            return readPacked(id);
+        Entry entry = getEntry(id);
+        return std::string(entry.data, entry.size);
+    }
+
+    /// Maps front coded data file if it exists.
+    void openPackedFile(const std::string& path)
     {
-        if (id < offsets_.size()) {
-            std::uint32_t offset = offsets_[id];
-            std::string::size_type size = id + 1 < nextId_ ? offsets_[id] : 8;
-            data.reserve(size);
+        std::size_t fileSize = getFileSize(path);
+        if (fileSize == 0)
+            return;
 
-            dataFile_.seekg(offset, ios::beg);
-            std::getline(dataFile_, data, '\0');
+        packedRegion_ = mapFile(path, boost::interprocess::read_only);
+        packedData_ = static_cast<const char*>(packedRegion_.get_address());
+        PackedHeader header = { 0, 0, 0, 0, 0 };
+        std::memcpy(&header, packedData_, std::min(fileSize, sizeof(header)));
+        std::size_t headerSize = header.magic == LegacyPackedMagic ? LegacyPackedHeaderSize : sizeof(header);
+        std::size_t blockCount = header.blockStrings > 0 ? (header.count + header.blockStrings - 1) / header.blockStrings : 0;
+        if (fileSize < headerSize || (header.magic != PackedMagic && header.magic != LegacyPackedMagic) ||
+            header.blockStrings == 0 || fileSize < headerSize + (blockCount + 1) * sizeof(std::uint32_t))
+            throw std::domain_error("Invalid string data file: " + path);
+
+        packedOffsets_ = reinterpret_cast<const std::uint32_t*>(packedData_ + headerSize);
+        packedCount_ = header.count;
+        blockStrings_ = header.blockStrings;
+        if (header.magic == PackedMagic) {
+            packedIndexSize_ = header.indexSize;
+            packedIndexHash_ = header.indexHash;
         }
+        cachedBlocks_.reset(new DecodedBlockPtr[blockCount]);
+    }
+
+    std::size_t getBlockCount() const
+    {
+        return (packedCount_ + blockStrings_ - 1) / blockStrings_;
+    }
+
+    /// Checks whether index file is the one which packed strings are taken from.
+    bool isPackedIndex(const std::string& indexPath) const
+    {
+        // NOTE content is compared only if size is the same which is rare.
+        return packedIndexSize_ > 0 &&
+               getFileSize(indexPath) == packedIndexSize_ &&
+               getContentHash(readFile(indexPath)) == packedIndexHash_;
     }
 
-    /// Writes string to index.
-    void writeString(std::uint32_t hash, const std::string& data)
+    /// Gets packed string through cache of decoded blocks.
+    std::string readPacked(std::uint32_t id) const
     {
-        // get offset as file size
-        dataFile_.seekg(0, ios::end);
-        std::uint32_t offset = static_cast<std::uint32_t>(dataFile_.tellg());
+        std::uint32_t block = id / blockStrings_;
+        DecodedBlockPtr decoded = std::atomic_load(&cachedBlocks_[block]);
 
-        // write string
-        dataFile_.seekp(0, ios::end);
-        dataFile_ << data.c_str() << '\0';
+        // NOTE concurrent threads may decode the same block, only the first copy is kept.
+        if (decoded == nullptr) {
+            decoded = decodeBlock(block);
+            DecodedBlockPtr expected;
+            if (std::atomic_compare_exchange_strong(&cachedBlocks_[block], &expected, decoded)) {
+                std::lock_guard<std::mutex> lock(cacheLock_);
+                blockOrder_.push_back(block);
+                if (blockOrder_.size() > MaxCachedBlocks) {
+                    std::atomic_store(&cachedBlocks_[blockOrder_.front()], DecodedBlockPtr());
+                    blockOrder_.pop_front();
+                }
+            } else if (expected != nullptr) {
+                decoded = expected;
+            }
+        }
+
+        std::uint32_t index = id - block * blockStrings_;
+        return decoded->data.substr(decoded->offsets[index], decoded->offsets[index + 1] - decoded->offsets[index]);
+    }
+
+    /// Decodes strings of packed block.
+    DecodedBlockPtr decodeBlock(std::uint32_t block) const
+    {
+        const char* data = packedData_ + packedOffsets_[block];
+        std::uint32_t rawSize, compressedSize;
+        std::memcpy(&rawSize, data, sizeof(rawSize));
+        std::memcpy(&compressedSize, data + sizeof(rawSize), sizeof(compressedSize));
+        data += sizeof(rawSize) + sizeof(compressedSize);
+
+        std::string raw;
+        if (compressedSize == 0)
+            raw.assign(data, rawSize);
+        else {
+            raw.resize(rawSize);
+            uLongf size = rawSize;
+            if (uncompress(reinterpret_cast<Bytef*>(&raw[0]), &size, reinterpret_cast<const Bytef*>(data), compressedSize) != Z_OK ||
+                size != rawSize)
+                throw std::domain_error("Failed to decompress string block.");
+        }
+
+        auto decoded = std::make_shared<DecodedBlock>();
+        decoded->data.reserve(rawSize);
+        std::uint32_t count = std::min(blockStrings_, packedCount_ - block * blockStrings_);
+        decoded->offsets.reserve(count + 1);
+        decoded->offsets.push_back(0);
+        std::size_t position = 0, previous = 0;
+        for (std::uint32_t i = 0; i < count; ++i) {
+            std::uint64_t prefix, suffix;
+            if (!utymap::utils::readVarint(raw, position, prefix) || !utymap::utils::readVarint(raw, position, suffix) ||
+                prefix > decoded->data.size() - previous || position + suffix > raw.size())
+                throw std::domain_error("Invalid string block.");
+            std::string str = decoded->data.substr(previous, static_cast<std::size_t>(prefix));
+            str.append(raw, position, static_cast<std::size_t>(suffix));
+            position += static_cast<std::size_t>(suffix);
+            previous = decoded->data.size();
+            decoded->data.append(str);
+            decoded->offsets.push_back(static_cast<std::uint32_t>(decoded->data.size()));
+        }
+        return decoded;
+    }
+
+    /// Maps persisted hash index if it is consistent with string index.
+    bool openHashIndex(std::uint32_t count)
+    {
+        std::size_t fileSize = getFileSize(hashPath_);
+        if (fileSize < sizeof(HashIndexHeader))
+            return false;
+
+        HashIndexHeader header;
+        std::ifstream file(hashPath_, ios::in | ios::binary);
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        file.close();
+
+        if (!file || header.magic != HashIndexMagic || header.count != count ||
+            header.capacity == 0 || (header.capacity & (header.capacity - 1)) != 0 ||
+            fileSize != sizeof(header) + header.capacity * sizeof(Slot))
+            return false;
+
+        // NOTE copy on write: changes are kept in memory till index is persisted, untouched
+        // pages are shared with other processes which map the same file.
+        hashRegion_ = mapFile(hashPath_, boost::interprocess::copy_on_write);
+        slots_ = reinterpret_cast<Slot*>(static_cast<char*>(hashRegion_.get_address()) + sizeof(header));
+        capacity_ = header.capacity;
+        slotCount_ = count;
+        return true;
+    }
+
+    /// Builds hash index from mapped string index. Runs in background thread.
+    void buildHashIndex()
+    {
+        // NOTE blocks are decoded without cache as every block is used once.
+        for (std::uint32_t block = 0; block * blockStrings_ < packedCount_; ++block) {
+            auto decoded = decodeBlock(block);
+            for (std::uint32_t i = 0; i + 1 < decoded->offsets.size(); ++i)
+                insertSlot(getHash(decoded->data.data() + decoded->offsets[i], decoded->offsets[i + 1] - decoded->offsets[i]),
+                           block * blockStrings_ + i);
+        }
+        for (std::uint32_t id = 0; id < mappedCount_; ++id)
+            insertSlot(mappedIndex_[id * 2], packedCount_ + id);
+    }
+
+    /// Waits for background build of hash index. Should be called under lock.
+    void waitForHashIndex()
+    {
+        if (indexBuilder_.joinable())
+            indexBuilder_.join();
+    }
+
+    /// Flushes files and persists hash index. Should be called under lock.
+    void flushImpl()
+    {
+        waitForHashIndex();
+        if (isShared_)
+            return;
+
+        // NOTE data is flushed first, so index never refers to data which is not written.
+        dataFile_.flush();
+        indexFile_.flush();
+
+        if (!isDirty_)
+            return;
+
+        // NOTE hash index file cannot be overwritten while it is mapped.
+        detachHashIndex();
+
+        HashIndexHeader header = { HashIndexMagic, size_.load(std::memory_order_relaxed), capacity_, 0 };
+        std::ofstream file(hashPath_, ios::out | ios::binary | ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(slots_), capacity_ * sizeof(Slot));
+        isDirty_ = !file.good();
+    }
+
+    /// Copies mapped hash index to memory and releases mapping.
+    void detachHashIndex()
+    {
+        if (hashRegion_.get_address() == nullptr)
+            return;
+
+        ownedSlots_.assign(slots_, slots_ + capacity_);
+        slots_ = ownedSlots_.data();
+        boost::interprocess::mapped_region().swap(hashRegion_);
+    }
+
+    /// Inserts id into hash index using linear probing. Grows index when load factor exceeds 0.75.
+    void insertSlot(std::uint32_t hash, std::uint32_t id)
+    {
+        if ((slotCount_ + 1) * 4 > static_cast<std::size_t>(capacity_) * 3) {
+            std::vector<Slot> slots(capacity_ * 2, Slot { 0, EmptyId });
+            for (std::uint32_t i = 0; i < capacity_; ++i) {
+                if (slots_[i].id != EmptyId)
+                    placeSlot(slots.data(), capacity_ * 2, slots_[i]);
+            }
+            ownedSlots_.swap(slots);
+            slots_ = ownedSlots_.data();
+            capacity_ *= 2;
+            boost::interprocess::mapped_region().swap(hashRegion_);
+        }
+
+        placeSlot(slots_, capacity_, Slot { hash, id });
+        ++slotCount_;
+    }
+
+    static void placeSlot(Slot* slots, std::uint32_t capacity, const Slot& slot)
+    {
+        std::uint32_t mask = capacity - 1;
+        std::uint32_t i = slot.hash & mask;
+        while (slots[i].id != EmptyId)
+            i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+
+    /// Adds entry with given id. Should be called before id is published.
+    void addEntry(std::uint32_t id, const char* data, std::uint32_t size)
+    {
+        std::uint32_t chunk = id >> ChunkBits;
+        if (chunk >= MaxChunks)
+            throw std::domain_error("String table is full.");
+
+        if (chunks_[chunk] == nullptr)
+            chunks_[chunk].reset(new Entry[ChunkSize]);
+        if (numberChunks_[chunk] == nullptr)
+            addNumberChunk(chunk);
+
+        chunks_[chunk][id & (ChunkSize - 1)] = Entry { data, size };
+    }
+
+    /// Allocates chunk of cached numbers. Should be called before ids of chunk are published.
+    void addNumberChunk(std::uint32_t chunk)
+    {
+        numberChunks_[chunk].reset(new std::atomic<std::uint64_t>[ChunkSize]);
+        for (std::uint32_t i = 0; i < ChunkSize; ++i)
+            numberChunks_[chunk][i].store(NotParsedNumber, std::memory_order_relaxed);
+    }
+
+    /// Copies string to arena and returns pointer to the copy.
+    const char* copyToArena(const char* str, std::size_t length)
+    {
+        std::size_t size = length + 1;
+        if (blockPosition_ + size > BlockSize) {
+            blocks_.push_back(std::unique_ptr<char[]>(new char[size > BlockSize ? size : BlockSize]));
+            blockPosition_ = 0;
+        }
+
+        char* data = blocks_.back().get() + blockPosition_;
+        std::memcpy(data, str, length);
+        data[length] = '\0';
+        // NOTE large string occupies the whole block
+        blockPosition_ = size > BlockSize ? BlockSize : blockPosition_ + size;
+        return data;
+    }
+
+    /// Adds new string and publishes its id.
+    std::uint32_t addString(std::uint32_t hash, const char* str, std::size_t size)
+    {
+        std::uint32_t id = size_.load(std::memory_order_relaxed);
+        const char* data = copyToArena(str, size);
+        addEntry(id, data, static_cast<std::uint32_t>(size));
+        insertSlot(hash, id);
+        if (!isShared_) {
+            writeString(hash, data, size);
+            isDirty_ = true;
+        }
+
+        size_.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    /// Writes string to files.
+    void writeString(std::uint32_t hash, const char* data, std::size_t size)
+    {
+        std::uint32_t offset = dataSize_;
+
+        // write string with null terminator
+        dataFile_.write(data, size + 1);
+        dataSize_ += static_cast<std::uint32_t>(size + 1);
 
         // write index entry
-        indexFile_.seekp(0, ios::end);
         indexFile_.write(reinterpret_cast<char*>(&hash), sizeof(hash));
         indexFile_.write(reinterpret_cast<char*>(&offset), sizeof(offset));
-
-        map_[hash].push_back(nextId_);
-        offsets_.push_back(offset);
     }
 
     std::fstream indexFile_;
     std::fstream dataFile_;
+    const std::string hashPath_;
     std::uint32_t seed_;
-    std::uint32_t nextId_;
+    const bool isShared_;
+    /// Amount of published strings.
+    std::atomic<std::uint32_t> size_;
 
-    /// TODO think about better data structure alternatives
-    HashIdMap map_;
-    std::vector<std::uint32_t> offsets_;
+    /// Strings which exist on startup are read directly from mapped files.
+    boost::interprocess::mapped_region indexRegion_;
+    boost::interprocess::mapped_region dataRegion_;
+    boost::interprocess::mapped_region hashRegion_;
+    const std::uint32_t* mappedIndex_;
+    const char* mappedData_;
+    std::uint32_t mappedCount_;
+    std::uint32_t mappedDataSize_;
+
+    /// Strings which are packed to front coded data file.
+    boost::interprocess::mapped_region packedRegion_;
+    const char* packedData_;
+    const std::uint32_t* packedOffsets_;
+    std::uint32_t packedCount_;
+    std::uint32_t blockStrings_;
+    std::uint32_t packedIndexSize_;
+    std::uint32_t packedIndexHash_;
+    /// Slot of decoded block for every packed block, accessed by atomic_load and atomic_store only.
+    std::unique_ptr<DecodedBlockPtr[]> cachedBlocks_;
+    /// Blocks which have decoded slots in order of decoding, the oldest one is evicted first.
+    mutable std::deque<std::uint32_t> blockOrder_;
+    mutable std::mutex cacheLock_;
+
+    /// Open addressing hash index: hash and id are stored inline. Slots point
+    /// either to mapped hash index file or to owned slots.
+    std::vector<Slot> ownedSlots_;
+    Slot* slots_;
+    std::uint32_t capacity_;
+    std::size_t slotCount_;
+    bool isDirty_;
+    std::thread indexBuilder_;
+
+    std::vector<std::unique_ptr<Entry[]>> chunks_;
+    /// Numeric values of strings parsed on demand, allocated together with entry chunks.
+    std::vector<std::unique_ptr<std::atomic<std::uint64_t>[]>> numberChunks_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::size_t blockPosition_;
+    std::uint32_t dataSize_;
 
     std::mutex lock_;
 };
 
-StringTable::StringTable(const std::string& path) :
-    pimpl_(utymap::utils::make_unique<StringTableImpl>(path + "string.idx", path + "string.dat", 0))
+StringTable::StringTable(const std::string& path, bool isShared) :
+    pimpl_(utymap::utils::make_unique<StringTableImpl>(path + "string.idx", path + "string.dat", path + "string.hsh",
+                                                       path + PackedFileName, 0, isShared))
+{
+}
+
+void StringTable::pack(const std::string& path)
 {
+    std::vector<std::string> strings;
+    {
+        // NOTE hash index is persisted when table is closed: ids are not changed by packing.
+        StringTable stringTable(path);
+        strings.reserve(stringTable.size());
+        for (std::uint32_t id = 0; id < stringTable.size(); ++id)
+            strings.push_back(stringTable.getString(id));
+    }
+
+    // NOTE if packing is interrupted before index file is truncated, it is truncated on next open.
+    // Index file is truncated first: data file which is not truncated only wastes space.
+    writePackedFile(path + PackedFileName, strings, readFile(path + "string.idx"));
+    std::ofstream(path + "string.idx", ios::out | ios::binary | ios::trunc);
+    std::ofstream(path + "string.dat", ios::out | ios::binary | ios::trunc);
 }
 
 StringTable::~StringTable() { }
@@ -134,11 +807,36 @@ std::uint32_t StringTable::getId(const std::string& str) const
     return pimpl_->getId(str);
 }
 
+std::vector<std::uint32_t> StringTable::getIds(const std::vector<const char*>& strings) const
+{
+    return pimpl_->getIds(strings);
+}
+
 std::string StringTable::getString(std::uint32_t id) const
 {
     return pimpl_->getString(id);
 }
 
+double StringTable::getNumber(std::uint32_t id) const
+{
+    return pimpl_->getNumber(id);
+}
+
+std::uint32_t StringTable::size() const
+{
+    return pimpl_->size();
+}
+
+bool StringTable::isPersistent(std::uint32_t id) const
+{
+    return pimpl_->isPersistent(id);
+}
+
+std::size_t StringTable::getMemoryUsage() const
+{
+    return pimpl_->getMemoryUsage();
+}
+
 void StringTable::flush() const
 {
     pimpl_->flush();
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace utymap { namespace index {
 
@@ -11,12 +12,16 @@ namespace utymap { namespace index {
 /// Index file consists of id-offset pairs where id - string id,
 /// offset - first character of the string inside data file.
 /// data file contains list of null terminated strings.
+/// Strings can be packed to front coded data file which is split into small compressed blocks:
+/// they keep their ids and are decoded on demand, new strings are still added to index and data files.
 class StringTable final
 {
 public:
 
-    /// Creates instance of StringTable using file path provided.
-    explicit StringTable(const std::string& path);
+    /// Creates instance of StringTable using file path provided. If isShared is set, files are
+    /// only mapped read only, so pages of many processes which open the same table are shared:
+    /// strings missing in files are kept in process memory and never written.
+    explicit StringTable(const std::string& path, bool isShared = false);
 
     StringTable(const StringTable&) = delete;
     StringTable& operator=(StringTable const&) = delete;
@@ -26,12 +31,34 @@ public:
     /// Gets id of given string.
     std::uint32_t getId(const std::string& str) const;
 
+    /// Gets ids of given null terminated strings. Lock is taken once for the whole batch.
+    std::vector<std::uint32_t> getIds(const std::vector<const char*>& strings) const;
+
     /// Gets original string by id.
     std::string getString(std::uint32_t id) const;
 
-    /// Flushes changes to disk.
+    /// Gets string by id parsed as double or zero if it is not a number.
+    /// Value is parsed once and cached, lookups do not take lock.
+    double getNumber(std::uint32_t id) const;
+
+    /// Gets amount of strings: every id below it refers to existing string.
+    std::uint32_t size() const;
+
+    /// Checks whether string with given id is kept in files, so its id is the same in every
+    /// process which opens table. Strings added to shared table are known only to this process.
+    bool isPersistent(std::uint32_t id) const;
+
+    /// Returns approximate amount of heap bytes used by strings, entries and hash index.
+    /// Memory mapped files are not included.
+    std::size_t getMemoryUsage() const;
+
+    /// Flushes changes to disk. Does nothing for shared table.
     void flush() const;
 
+    /// Packs all strings of table at given path to front coded data file. Table should not be
+    /// opened by anyone while it is packed.
+    static void pack(const std::string& path);
+
 private:
     class StringTableImpl;
     std::unique_ptr<StringTableImpl> pimpl_;
@@ -0,0 +1,31 @@
+#ifndef INDEX_STYLEFINGERPRINT_HPP_DEFINED
+#define INDEX_STYLEFINGERPRINT_HPP_DEFINED
+
+#include "entities/ElementVisitor.hpp"
+
+#include <cstdint>
+
+namespace utymap { namespace index {
+
+/// Style of element resolved when element is stored. It is restored by style provider whose
+/// fingerprint version is the same.
+struct StyleFingerprint final
+{
+    /// Fingerprint version of style provider.
+    std::uint64_t version;
+    /// Id of style in style provider.
+    std::uint32_t id;
+};
+
+/// Visitor which receives fingerprint of element before it is visited, so it can use style
+/// resolved at import time instead of matching element again.
+class FingerprintElementVisitor : public utymap::entities::ElementVisitor
+{
+public:
+    /// Sets fingerprint of element which is visited next. Null means that it is unknown.
+    virtual void setFingerprint(const StyleFingerprint* fingerprint) = 0;
+};
+
+}}
+
+#endif // INDEX_STYLEFINGERPRINT_HPP_DEFINED
@@ -0,0 +1,89 @@
+#include "index/TagIndex.hpp"
+#include "utils/VarintUtils.hpp"
+
+#include <algorithm>
+
+using namespace utymap::entities;
+using namespace utymap::index;
+
+namespace {
+    std::uint64_t getKey(const Tag& tag)
+    {
+        return static_cast<std::uint64_t>(tag.key) << 32 | tag.value;
+    }
+
+    /// Reads delta of position from postings which are written by the index itself.
+    std::uint32_t readDelta(const std::string& data, std::size_t& offset)
+    {
+        std::uint64_t delta = 0;
+        utymap::utils::readVarint(data, offset, delta);
+        return static_cast<std::uint32_t>(delta);
+    }
+}
+
+void TagIndex::add(std::uint32_t position, const std::vector<Tag>& tags)
+{
+    for (const auto& tag : tags) {
+        Postings& postings = postings_[getKey(tag)];
+        // NOTE the same tag can be repeated by element.
+        if (postings.count > 0 && postings.last == position)
+            continue;
+
+        utymap::utils::writeVarint(postings.data, postings.count == 0 ? position : position - postings.last);
+        postings.last = position;
+        ++postings.count;
+    }
+}
+
+std::vector<std::uint32_t> TagIndex::find(const std::vector<Tag>& tags) const
+{
+    std::vector<const Postings*> lists;
+    lists.reserve(tags.size());
+    for (const auto& tag : tags) {
+        auto postings = postings_.find(getKey(tag));
+        if (postings == postings_.end())
+            return {};
+        lists.push_back(&postings->second);
+    }
+    if (lists.empty())
+        return {};
+
+    // NOTE intersection starts from the shortest list, so result only shrinks.
+    std::sort(lists.begin(), lists.end(), [](const Postings* left, const Postings* right) {
+        return left->count < right->count;
+    });
+
+    std::vector<std::uint32_t> positions;
+    positions.reserve(lists.front()->count);
+    std::size_t offset = 0;
+    std::uint32_t position = 0;
+    for (std::uint32_t i = 0; i < lists.front()->count; ++i) {
+        position += readDelta(lists.front()->data, offset);
+        positions.push_back(position);
+    }
+
+    std::vector<std::uint32_t> intersection;
+    for (std::size_t k = 1; k < lists.size() && !positions.empty(); ++k) {
+        intersection.clear();
+        offset = 0;
+        position = 0;
+        std::size_t current = 0;
+        for (std::uint32_t i = 0; i < lists[k]->count && current < positions.size(); ++i) {
+            position += readDelta(lists[k]->data, offset);
+            while (current < positions.size() && positions[current] < position)
+                ++current;
+            if (current < positions.size() && positions[current] == position)
+                intersection.push_back(positions[current++]);
+        }
+        positions.swap(intersection);
+    }
+    return positions;
+}
+
+std::size_t TagIndex::getMemoryUsage() const
+{
+    std::size_t usage = postings_.size() * (sizeof(std::uint64_t) + sizeof(Postings) + sizeof(void*));
+    for (const auto& pair : postings_)
+        usage += pair.second.data.capacity();
+    return usage;
+}
@@ -0,0 +1,45 @@
+#ifndef INDEX_TAGINDEX_HPP_DEFINED
+#define INDEX_TAGINDEX_HPP_DEFINED
+
+#include "entities/Element.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace utymap { namespace index {
+
+/// Inverted index from tag to positions of elements which have it. Positions should be added
+/// in ascending order, postings of every tag are kept as delta encoded varints.
+class TagIndex final
+{
+public:
+    /// Adds element at given position with given tags.
+    void add(std::uint32_t position, const std::vector<utymap::entities::Tag>& tags);
+
+    /// Returns ascending positions of elements which have all given tags.
+    std::vector<std::uint32_t> find(const std::vector<utymap::entities::Tag>& tags) const;
+
+    /// Returns approximate amount of bytes used by index.
+    std::size_t getMemoryUsage() const;
+
+private:
+    struct Postings final
+    {
+        /// Deltas of positions as varints.
+        std::string data;
+        /// Last added position.
+        std::uint32_t last;
+        /// Amount of positions.
+        std::uint32_t count;
+    };
+
+    /// Key: key and value string ids of tag, value: positions of elements.
+    std::unordered_map<std::uint64_t, Postings> postings_;
+};
+
+}}
+
+#endif // INDEX_TAGINDEX_HPP_DEFINED
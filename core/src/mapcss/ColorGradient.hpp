@@ -3,6 +3,7 @@
 
 #include "mapcss/Color.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 #include <utility>
@@ -17,22 +18,34 @@ public:
     /// gradient data: first - time, second - color.
     typedef std::vector<std::pair<double, utymap::mapcss::Color>> GradientData;
 
+    /// Amount of precomputed colors used by lookup.
+    static const std::size_t LookupSize = 256;
+
     ColorGradient() {}
 
     explicit ColorGradient(const GradientData& colors) :
         colors_(colors)
     {
+        if (colors_.empty())
+            return;
+
+        lookup_.reserve(LookupSize);
+        for (std::size_t i = 0; i < LookupSize; ++i)
+            lookup_.push_back(evaluate(static_cast<double>(i) / (LookupSize - 1)));
     }
 
     ColorGradient(ColorGradient&& other) :
-        colors_(std::move(other.colors_))
+        colors_(std::move(other.colors_)),
+        lookup_(std::move(other.lookup_))
     {
     }
 
     ColorGradient& operator=(ColorGradient&& other)
     {
-        if (this != &other)
+        if (this != &other) {
             colors_ = std::move(other.colors_);
+            lookup_ = std::move(other.lookup_);
+        }
 
         return *this;
     }
@@ -56,6 +69,17 @@ public:
         return interpolate(pairA.second, pairB.second, mu);
     }
 
+    /// Returns packed RGBA color from precomputed table. Time is clamped to [0, 1]
+    /// and rounded to the nearest of LookupSize points.
+    std::uint32_t lookup(double time) const
+    {
+        if (lookup_.empty())
+            return 0;
+
+        double position = std::max(0., std::min(time, 1.)) * (LookupSize - 1);
+        return lookup_[static_cast<std::size_t>(position + 0.5)];
+    }
+
     /// Returns true if there is no color specified.
     bool empty() const { return colors_.empty(); }
 
@@ -70,6 +94,7 @@ private:
     }
 
     GradientData colors_;
+    std::vector<std::uint32_t> lookup_;
 };
 
 }}
@@ -0,0 +1,284 @@
+#include "mapcss/CompiledStyleSheet.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+using namespace utymap::mapcss;
+
+namespace {
+    ///                                Compiled stylesheet file format
+    ///------------------------------------------------------------------------------------------------------|
+    ///   DESCRIPTION    |                       DETAILS                                                     |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Header       |  Magic (4b), version (4b)                                                         |
+    ///------------------------------------------------------------------------------------------------------|
+    ///  String table    |  Amount of strings (4b), each is represented by its size (4b) and data            |
+    ///------------------------------------------------------------------------------------------------------|
+    ///    Textures      |  Amount of atlases (4b), each is name, amount of groups and groups: key, amount   |
+    ///                  |  of regions and regions as six 2b values                                          |
+    ///------------------------------------------------------------------------------------------------------|
+    ///      Rules       |  Amount of rules (4b), each is amount of selectors and selectors: names, zoom     |
+    ///                  |  start and end (1b each), conditions as key, operation and value; then amount of  |
+    ///                  |  declarations and declarations as key and value                                   |
+    ///------------------------------------------------------------------------------------------------------|
+    /// All strings are 4b indices in string table, all amounts are 4b. Values are in host byte order.
+    const std::uint32_t CompiledMagic = 0x43535455;
+
+    boost::interprocess::mapped_region mapFile(const std::string& path)
+    {
+        using namespace boost::interprocess;
+        file_mapping mapping(path.c_str(), read_only);
+        return mapped_region(mapping, read_only);
+    }
+}
+
+/// Encodes stylesheet replacing strings with indices in string table.
+class CompiledStyleSheet::Encoder final
+{
+public:
+    void writeStyleSheet(const StyleSheet& stylesheet, std::ostream& output)
+    {
+        std::string body;
+        writeTextures(body, stylesheet.textures);
+        writeRules(body, stylesheet.rules);
+
+        std::string header;
+        writeValue(header, CompiledMagic);
+        writeValue(header, CompiledStyleSheet::Version);
+        writeValue(header, static_cast<std::uint32_t>(strings_.size()));
+        for (const auto& str : strings_) {
+            writeValue(header, static_cast<std::uint32_t>(str.size()));
+            header.append(str);
+        }
+
+        output.write(header.data(), header.size());
+        output.write(body.data(), body.size());
+    }
+
+private:
+    template <typename T>
+    static void writeValue(std::string& buffer, T value)
+    {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    static void writeSize(std::string& buffer, std::size_t size)
+    {
+        writeValue(buffer, static_cast<std::uint32_t>(size));
+    }
+
+    void writeString(std::string& buffer, const std::string& str)
+    {
+        auto pair = indices_.find(str);
+        if (pair == indices_.end()) {
+            pair = indices_.emplace(str, static_cast<std::uint32_t>(strings_.size())).first;
+            strings_.push_back(str);
+        }
+        writeValue(buffer, pair->second);
+    }
+
+    void writeTextures(std::string& buffer, const std::vector<TextureAtlas>& textures)
+    {
+        writeSize(buffer, textures.size());
+        for (const auto& atlas : textures) {
+            writeString(buffer, atlas.name_);
+            writeSize(buffer, atlas.textureGroups_.size());
+            for (const auto& group : atlas.textureGroups_) {
+                writeString(buffer, group.first);
+                writeSize(buffer, group.second.regions_.size());
+                for (const auto& region : group.second.regions_) {
+                    for (std::uint16_t value : { region.atlasWidth_, region.atlasHeight_,
+                                                 region.x_, region.y_, region.width_, region.height_ })
+                        writeValue(buffer, value);
+                }
+            }
+        }
+    }
+
+    void writeRules(std::string& buffer, const std::vector<Rule>& rules)
+    {
+        writeSize(buffer, rules.size());
+        for (const auto& rule : rules) {
+            writeSize(buffer, rule.selectors.size());
+            for (const auto& selector : rule.selectors) {
+                writeSize(buffer, selector.names.size());
+                for (const auto& name : selector.names)
+                    writeString(buffer, name);
+                writeValue(buffer, selector.zoom.start);
+                writeValue(buffer, selector.zoom.end);
+                writeSize(buffer, selector.conditions.size());
+                for (const auto& condition : selector.conditions) {
+                    writeString(buffer, condition.key);
+                    writeString(buffer, condition.operation);
+                    writeString(buffer, condition.value);
+                }
+            }
+            writeSize(buffer, rule.declarations.size());
+            for (const auto& declaration : rule.declarations) {
+                writeString(buffer, declaration.key);
+                writeString(buffer, declaration.value);
+            }
+        }
+    }
+
+    std::unordered_map<std::string, std::uint32_t> indices_;
+    std::vector<std::string> strings_;
+};
+
+/// Decodes stylesheet from mapped memory. Every read is checked against end of data.
+class CompiledStyleSheet::Decoder final
+{
+public:
+    Decoder(const char* data, std::size_t size) :
+        current_(data), end_(data + size)
+    {
+    }
+
+    StyleSheet readStyleSheet()
+    {
+        if (readValue<std::uint32_t>() != CompiledMagic)
+            throw std::domain_error("Not a compiled stylesheet.");
+        if (readValue<std::uint32_t>() != CompiledStyleSheet::Version)
+            throw std::domain_error("Unsupported version of compiled stylesheet.");
+
+        std::uint32_t count = readSize(sizeof(std::uint32_t));
+        strings_.reserve(count);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            std::uint32_t size = readValue<std::uint32_t>();
+            ensure(size);
+            strings_.emplace_back(current_, size);
+            current_ += size;
+        }
+
+        StyleSheet stylesheet;
+        readTextures(stylesheet.textures);
+        readRules(stylesheet.rules);
+        return stylesheet;
+    }
+
+    template <typename T>
+    T readValue()
+    {
+        ensure(sizeof(T));
+        T value;
+        std::memcpy(&value, current_, sizeof(T));
+        current_ += sizeof(T);
+        return value;
+    }
+
+    /// Reads amount of items guarding against sizes which do not fit into remaining data.
+    std::uint32_t readSize(std::size_t minItemSize)
+    {
+        std::uint32_t size = readValue<std::uint32_t>();
+        ensure(static_cast<std::size_t>(size) * minItemSize);
+        return size;
+    }
+
+    const std::string& readString()
+    {
+        std::uint32_t index = readValue<std::uint32_t>();
+        if (index >= strings_.size())
+            throw std::domain_error("Invalid string index in compiled stylesheet.");
+        return strings_[index];
+    }
+
+private:
+    void ensure(std::size_t size) const
+    {
+        if (static_cast<std::size_t>(end_ - current_) < size)
+            throw std::domain_error("Compiled stylesheet is truncated.");
+    }
+
+    void readTextures(std::vector<TextureAtlas>& textures)
+    {
+        std::uint32_t atlasCount = readSize(2 * sizeof(std::uint32_t));
+        textures.reserve(atlasCount);
+        for (std::uint32_t i = 0; i < atlasCount; ++i) {
+            std::string name = readString();
+            TextureAtlas::Groups groups;
+            std::uint32_t groupCount = readSize(2 * sizeof(std::uint32_t));
+            for (std::uint32_t j = 0; j < groupCount; ++j) {
+                TextureGroup& group = groups[readString()];
+                std::uint32_t regionCount = readSize(6 * sizeof(std::uint16_t));
+                group.regions_.reserve(regionCount);
+                for (std::uint32_t k = 0; k < regionCount; ++k) {
+                    std::uint16_t values[6];
+                    for (auto& value : values)
+                        value = readValue<std::uint16_t>();
+                    group.regions_.emplace_back(values[0], values[1], values[2], values[3], values[4], values[5]);
+                }
+            }
+            textures.emplace_back(name, groups);
+        }
+    }
+
+    void readRules(std::vector<Rule>& rules)
+    {
+        std::uint32_t ruleCount = readSize(2 * sizeof(std::uint32_t));
+        rules.reserve(ruleCount);
+        for (std::uint32_t i = 0; i < ruleCount; ++i) {
+            Rule rule;
+            std::uint32_t selectorCount = readSize(2 * sizeof(std::uint32_t));
+            rule.selectors.reserve(selectorCount);
+            for (std::uint32_t j = 0; j < selectorCount; ++j) {
+                Selector selector;
+                std::uint32_t nameCount = readSize(sizeof(std::uint32_t));
+                for (std::uint32_t k = 0; k < nameCount; ++k)
+                    selector.names.push_back(readString());
+                selector.zoom.start = readValue<std::uint8_t>();
+                selector.zoom.end = readValue<std::uint8_t>();
+                std::uint32_t conditionCount = readSize(3 * sizeof(std::uint32_t));
+                selector.conditions.reserve(conditionCount);
+                for (std::uint32_t k = 0; k < conditionCount; ++k) {
+                    Condition condition;
+                    condition.key = readString();
+                    condition.operation = readString();
+                    condition.value = readString();
+                    selector.conditions.push_back(std::move(condition));
+                }
+                rule.selectors.push_back(std::move(selector));
+            }
+            std::uint32_t declarationCount = readSize(2 * sizeof(std::uint32_t));
+            rule.declarations.reserve(declarationCount);
+            for (std::uint32_t j = 0; j < declarationCount; ++j) {
+                Declaration declaration;
+                declaration.key = readString();
+                declaration.value = readString();
+                rule.declarations.push_back(std::move(declaration));
+            }
+            rules.push_back(std::move(rule));
+        }
+    }
+
+    const char* current_;
+    const char* end_;
+    std::vector<std::string> strings_;
+};
+
+void CompiledStyleSheet::write(const StyleSheet& stylesheet, const std::string& path)
+{
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    if (!output.good())
+        throw std::domain_error("Cannot write compiled stylesheet: " + path);
+    Encoder().writeStyleSheet(stylesheet, output);
+}
+
+bool CompiledStyleSheet::isCompiled(const std::string& path)
+{
+    std::ifstream input(path, std::ios::binary);
+    std::uint32_t magic = 0;
+    input.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    return input.good() && magic == CompiledMagic;
+}
+
+StyleSheet CompiledStyleSheet::read(const std::string& path)
+{
+    auto region = mapFile(path);
+    return Decoder(static_cast<const char*>(region.get_address()), region.get_size()).readStyleSheet();
+}
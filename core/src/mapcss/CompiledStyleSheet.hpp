@@ -0,0 +1,37 @@
+#ifndef MAPCSS_COMPILEDSTYLESHEET_HPP_DEFINED
+#define MAPCSS_COMPILEDSTYLESHEET_HPP_DEFINED
+
+#include "mapcss/StyleSheet.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace utymap { namespace mapcss {
+
+/// Stores parsed stylesheet in versioned binary file which can be produced offline and
+/// loaded using memory mapping without running mapcss grammar.
+class CompiledStyleSheet final
+{
+public:
+    /// Version of format. Files of other versions are rejected.
+    static const std::uint32_t Version = 1;
+
+    CompiledStyleSheet() = delete;
+
+    /// Writes stylesheet to file at given path.
+    static void write(const StyleSheet& stylesheet, const std::string& path);
+
+    /// Checks whether file at given path is compiled stylesheet.
+    static bool isCompiled(const std::string& path);
+
+    /// Reads stylesheet from file at given path.
+    static StyleSheet read(const std::string& path);
+
+private:
+    class Encoder;
+    class Decoder;
+};
+
+}}
+
+#endif // MAPCSS_COMPILEDSTYLESHEET_HPP_DEFINED
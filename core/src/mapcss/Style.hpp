@@ -7,26 +7,43 @@
 #include "index/StringTable.hpp"
 #include "utils/CoreUtils.hpp"
 #include "utils/GeoUtils.hpp"
+#include "utils/MetricScale.hpp"
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <string>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace utymap { namespace mapcss {
 
 /// Represents style for element.
 struct Style final
-{    
+{
+    /// Declarations with their keys sorted by key. Styles have just a few declarations,
+    /// so flat array is cheaper to build and search than hash map.
+    typedef std::vector<std::pair<std::uint32_t, const StyleDeclaration*>> Declarations;
+    typedef std::shared_ptr<const Declarations> DeclarationsPtr;
+
     Style(const std::vector<utymap::entities::Tag>& tags,
           utymap::index::StringTable& stringTable) :
           stringTable_(stringTable), tags_(tags), declarations_()
     {
     }
 
+    /// Creates style which shares given immutable declarations. Null means no declarations.
+    Style(const std::vector<utymap::entities::Tag>& tags,
+          utymap::index::StringTable& stringTable,
+          DeclarationsPtr declarations) :
+          stringTable_(stringTable), tags_(tags), declarations_(std::move(declarations))
+    {
+    }
+
     Style(Style&& other) :
             stringTable_(other.stringTable_),
-            declarations_(std::move(other.declarations_)),
-            tags_(std::move(other.tags_))
+            tags_(std::move(other.tags_)),
+            declarations_(std::move(other.declarations_))
     {
     }
 
@@ -35,43 +52,63 @@ struct Style final
     Style& operator=(const Style&) = delete;
     Style& operator=(Style&&) = delete;
 
+    /// Adds declaration to sorted declarations replacing declaration with the same key.
+    static void merge(Declarations& declarations, const StyleDeclaration& declaration)
+    {
+        auto it = std::lower_bound(declarations.begin(), declarations.end(), declaration.key(),
+            [](const Declarations::value_type& pair, std::uint32_t key) { return pair.first < key; });
+        if (it != declarations.end() && it->first == declaration.key())
+            it->second = &declaration;
+        else
+            declarations.insert(it, std::make_pair(declaration.key(), &declaration));
+    }
+
     bool has(std::uint32_t key) const
     {
-        return declarations_.find(key) != declarations_.end();
+        return find(key) != nullptr;
     }
 
     bool has(std::uint32_t key, const std::string& value) const
     {
-        auto it = declarations_.find(key);
-        return it != declarations_.end() && it->second->value() == value;
+        const StyleDeclaration* declaration = find(key);
+        return declaration != nullptr && declaration->value() == value;
     }
 
+    /// Adds declaration. Declarations shared with other styles are copied first.
     void put(const StyleDeclaration& declaration)
     {
-        declarations_[declaration.key()] = &declaration;
+        std::shared_ptr<Declarations> declarations = declarations_ == nullptr
+            ? std::make_shared<Declarations>()
+            : std::make_shared<Declarations>(*declarations_);
+        merge(*declarations, declaration);
+        declarations_ = std::move(declarations);
     }
 
     const StyleDeclaration& get(std::uint32_t key) const
     {
-        auto it = declarations_.find(key);
-        if (it == declarations_.end())
+        const StyleDeclaration* declaration = find(key);
+        if (declaration == nullptr)
             throw MapCssException(std::string("Cannot find declaration with the key: ") + stringTable_.getString(key));
 
-        return *it->second;
+        return *declaration;
     }
 
     std::vector<const StyleDeclaration*> declarations() const
     {
         std::vector<const StyleDeclaration*> decs;
-        std::transform(std::begin(declarations_), std::end(declarations_), std::back_inserter(decs),
-            [](std::unordered_map<std::uint32_t, const StyleDeclaration*>::value_type const& pair) {
+        if (declarations_ == nullptr)
+            return decs;
+
+        std::transform(std::begin(*declarations_), std::end(*declarations_), std::back_inserter(decs),
+            [](Declarations::value_type const& pair) {
             return pair.second;
         });
 
         return decs;
     }
 
-    /// Gets string by given key. Empty string by default
+    /// Gets string by given key. Empty string by default.
+    /// NOTE interns key in string table on each call, prefer key id overload on hot paths.
     std::string getString(const std::string& key) const
     {
         std::uint32_t keyId = stringTable_.getId(key);
@@ -92,6 +129,7 @@ struct Style final
     }
 
     /// Gets double value or zero.
+    /// NOTE interns key in string table on each call, prefer key id overload on hot paths.
     double getValue(const std::string& key,
                     double size = 1,
                     const utymap::GeoCoordinate& coordinate = GeoCoordinate()) const
@@ -104,36 +142,71 @@ struct Style final
     double getValue(std::uint32_t keyId,
                     double size = 1,
                     const utymap::GeoCoordinate& coordinate = GeoCoordinate()) const
+    {
+        return getValue(keyId, size, coordinate, nullptr);
+    }
+
+    /// Gets double value or zero converting meters to degrees at coordinate with scale of tile.
+    /// NOTE interns key in string table on each call, prefer key id overload on hot paths.
+    double getValue(const std::string& key,
+                    double size,
+                    const utymap::GeoCoordinate& coordinate,
+                    const utymap::utils::MetricScale& scale) const
+    {
+        return getValue(stringTable_.getId(key), size, coordinate, &scale);
+    }
+
+    /// Gets double value or zero converting meters to degrees at coordinate with scale of tile.
+    double getValue(std::uint32_t keyId,
+                    double size,
+                    const utymap::GeoCoordinate& coordinate,
+                    const utymap::utils::MetricScale& scale) const
+    {
+        return getValue(keyId, size, coordinate, &scale);
+    }
+
+private:
+    double getValue(std::uint32_t keyId,
+                    double size,
+                    const utymap::GeoCoordinate& coordinate,
+                    const utymap::utils::MetricScale* scale) const
     {
         if (!has(keyId))
             return 0;
 
         const auto& declaration = get(keyId);
-        const auto& rawValue = declaration.value();
-        char dimen = rawValue[rawValue.size() - 1];
-
-        if (dimen == 'm') {
-            double value = utymap::utils::parseDouble(rawValue.substr(0, rawValue.size() - 1));
-            return coordinate.isValid()
-                ? utymap::utils::GeoUtils::getOffset(coordinate, value)
-                : value;
+        switch (declaration.unit()) {
+            case StyleDeclaration::Unit::Meters:
+                if (!coordinate.isValid())
+                    return declaration.number();
+                return scale != nullptr
+                    ? scale->toDegrees(coordinate, declaration.number())
+                    : utymap::utils::GeoUtils::getOffset(coordinate, declaration.number());
+            // relative to size
+            case StyleDeclaration::Unit::Percent:
+                return size * declaration.number() * 0.01;
+            default:
+                return declaration.isEval()
+                    ? declaration.evaluate<double>(tags_, stringTable_)
+                    : declaration.number();
         }
+    }
 
-        // relative to size
-        if (dimen == '%') {
-            double value = utymap::utils::parseDouble(rawValue.substr(0, rawValue.size() - 1));
-            return size * value * 0.01;
-        }
+    /// Finds declaration using binary search. Returns null if there is no declaration.
+    const StyleDeclaration* find(std::uint32_t key) const
+    {
+        if (declarations_ == nullptr)
+            return nullptr;
 
-        return declaration.isEval()
-                ? declaration.evaluate<double>(tags_, stringTable_)
-                : utymap::utils::parseDouble(rawValue);
+        auto it = std::lower_bound(declarations_->begin(), declarations_->end(), key,
+            [](const Declarations::value_type& pair, std::uint32_t key) { return pair.first < key; });
+        return it != declarations_->end() && it->first == key ? it->second : nullptr;
     }
 
-private:
     utymap::index::StringTable& stringTable_;
     std::vector<utymap::entities::Tag> tags_;
-    std::unordered_map<std::uint32_t, const StyleDeclaration*> declarations_;
+    /// Immutable declarations which can be shared between styles of elements with the same tags.
+    DeclarationsPtr declarations_;
 };
 
 }}
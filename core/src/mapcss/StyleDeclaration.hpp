@@ -5,6 +5,7 @@
 #include "entities/Element.hpp"
 #include "index/StringTable.hpp"
 #include "mapcss/StyleEvaluator.hpp"
+#include "utils/CoreUtils.hpp"
 #include "utils/ElementUtils.hpp"
 
 #include <cstdint>
@@ -17,16 +18,25 @@ namespace utymap { namespace mapcss {
 /// Represents style declaration which support evaluation.
 struct StyleDeclaration final
 {
-    StyleDeclaration(std::uint32_t key, const std::string& value) :
+    /// Specifies unit of numeric value.
+    enum class Unit { None, Meters, Percent };
+
+    StyleDeclaration(std::uint32_t key, const std::string& value,
+                     utymap::index::StringTable& stringTable) :
         key_(key),
         value_(value),
-        tree_(StyleEvaluator::parse(value))
+        program_(StyleEvaluator::compile(value, stringTable)),
+        unit_(Unit::None),
+        number_(0)
     {
+        if (!isEval())
+            parseNumber();
     }
 
     ~StyleDeclaration() {};
     StyleDeclaration(StyleDeclaration&& other) : 
-        key_(other.key_), value_(other.value_), tree_(std::move(other.tree_))
+        key_(other.key_), value_(other.value_), program_(std::move(other.program_)),
+        unit_(other.unit_), number_(other.number_)
     {
     }
 
@@ -41,7 +51,13 @@ struct StyleDeclaration final
     const std::string& value() const { return value_; };
 
     /// Gets true if declaration should be evaluated
-    bool isEval() const { return tree_ != nullptr; }
+    bool isEval() const { return program_ != nullptr; }
+
+    /// Gets unit of raw value parsed on construction.
+    Unit unit() const { return unit_; }
+
+    /// Gets raw value parsed as number without unit suffix. Zero if value is not a number.
+    double number() const { return number_; }
 
     /// Evaluates expression using tags
     template <typename T>
@@ -51,14 +67,32 @@ struct StyleDeclaration final
         if (!isEval())
             throw utymap::MapCssException("Cannot evaluate raw value.");
 
-        return StyleEvaluator::evaluate<T>(*tree_, tags, stringTable);
+        return StyleEvaluator::evaluate<T>(*program_, tags, stringTable);
     }
 
 private:
 
+    void parseNumber()
+    {
+        if (value_.empty())
+            return;
+
+        char dimen = value_[value_.size() - 1];
+        if (dimen == 'm')
+            unit_ = Unit::Meters;
+        else if (dimen == '%')
+            unit_ = Unit::Percent;
+
+        number_ = unit_ == Unit::None
+            ? utymap::utils::parseDouble(value_)
+            : utymap::utils::parseDouble(value_.substr(0, value_.size() - 1));
+    }
+
     std::uint32_t key_;
     std::string value_;
-    std::unique_ptr<StyleEvaluator::Tree> tree_;
+    std::unique_ptr<const StyleEvaluator::Program> program_;
+    Unit unit_;
+    double number_;
 };
 
 }}
@@ -1,9 +1,14 @@
 #include "mapcss/StyleEvaluator.hpp"
 #include "utils/CoreUtils.hpp"
+#include "utils/ElementUtils.hpp"
 
 #include <boost/config/warning_disable.hpp>
 #include <boost/spirit/include/qi.hpp>
 #include <boost/fusion/include/adapt_struct.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include <algorithm>
+#include <stdexcept>
 
 using namespace utymap::entities;
 using namespace utymap::index;
@@ -16,6 +21,12 @@ namespace {
     typedef StyleEvaluator::Tree Tree;
     typedef StyleEvaluator::Operation Operation;
     typedef StyleEvaluator::Operand Operand;
+    typedef StyleEvaluator::OpCode OpCode;
+    typedef StyleEvaluator::Instruction Instruction;
+    typedef StyleEvaluator::Program Program;
+
+    /// Max stack depth which is evaluated without heap allocation.
+    const std::size_t MaxLocalStackSize = 32;
 
     namespace qi = boost::spirit::qi;
     namespace ascii = boost::spirit::ascii;
@@ -55,6 +66,118 @@ namespace {
         qi::rule<Iterator, Tree(), ascii::space_type> term;
         qi::rule<Iterator, Operand(), ascii::space_type> factor;
     };
+
+    /// Compiles AST into bytecode in postfix order tracking depth of the stack.
+    struct Compiler
+    {
+        typedef void result_type;
+
+        Compiler(Program& program, StringTable& stringTable) :
+            program_(program), stringTable_(stringTable), depth_(0)
+        {
+        }
+
+        void operator()(Nil) { push(Instruction { OpCode::Push, 0, 0 }); }
+
+        void operator()(double n) { push(Instruction { OpCode::Push, 0, n }); }
+
+        void operator()(const std::string& tagKey) { push(Instruction { OpCode::Tag, stringTable_.getId(tagKey), 0 }); }
+
+        void operator()(const Signed& s)
+        {
+            boost::apply_visitor(*this, s.operand);
+            if (s.sign == '-')
+                program_.instructions.push_back(Instruction { OpCode::Negate, 0, 0 });
+        }
+
+        void operator()(const Tree& tree)
+        {
+            boost::apply_visitor(*this, tree.first);
+            for (const Operation& operation : tree.rest) {
+                boost::apply_visitor(*this, operation.operand);
+                program_.instructions.push_back(Instruction { getOpCode(operation.operator_), 0, 0 });
+                --depth_;
+            }
+        }
+
+    private:
+        static OpCode getOpCode(char operator_)
+        {
+            switch (operator_) {
+                case '+': return OpCode::Add;
+                case '-': return OpCode::Subtract;
+                case '*': return OpCode::Multiply;
+                case '/': return OpCode::Divide;
+                default: throw std::domain_error(std::string("Evaluator: unsupported operator ") + operator_);
+            }
+        }
+
+        void push(const Instruction& instruction)
+        {
+            program_.instructions.push_back(instruction);
+            program_.stackSize = std::max(program_.stackSize, ++depth_);
+        }
+
+        Program& program_;
+        StringTable& stringTable_;
+        std::size_t depth_;
+    };
+
+    /// Finds key of tag which is used as string value of the tree.
+    struct StringKeyFinder
+    {
+        typedef const std::string* result_type;
+
+        const std::string* operator()(const std::string& tagKey) const { return &tagKey; }
+
+        const std::string* operator()(const Tree& tree) const { return boost::apply_visitor(*this, tree.first); }
+
+        template <typename T>
+        const std::string* operator()(const T&) const { return nullptr; }
+    };
+
+    /// Finds value id of tag with given key using binary search. Returns false if there is no such tag.
+    bool findTagValue(std::uint32_t key, const std::vector<Tag>& tags, std::uint32_t& value)
+    {
+        auto begin = tags.begin();
+        auto end = tags.end();
+        while (begin < end) {
+            const auto middle = begin + (std::distance(begin, end) / 2);
+            if (middle->key == key) {
+                value = middle->value;
+                return true;
+            }
+
+            if (middle->key > key)
+                end = middle;
+            else
+                begin = middle + 1;
+        }
+        return false;
+    }
+
+    double run(const Program& program, const std::vector<Tag>& tags, StringTable& stringTable, double* stack)
+    {
+        std::size_t top = 0;
+        for (const Instruction& instruction : program.instructions) {
+            switch (instruction.code) {
+                case OpCode::Push:
+                    stack[top++] = instruction.value;
+                    break;
+                case OpCode::Tag: {
+                    std::uint32_t value;
+                    stack[top++] = findTagValue(instruction.key, tags, value) ? stringTable.getNumber(value) : 0;
+                    break;
+                }
+                case OpCode::Add: --top; stack[top - 1] += stack[top]; break;
+                case OpCode::Subtract: --top; stack[top - 1] -= stack[top]; break;
+                case OpCode::Multiply: --top; stack[top - 1] *= stack[top]; break;
+                case OpCode::Divide: --top; stack[top - 1] /= stack[top]; break;
+                case OpCode::Negate: stack[top - 1] = -stack[top - 1]; break;
+            }
+        }
+        return top > 0 ? stack[top - 1] : 0;
+    }
 }
 
 BOOST_FUSION_ADAPT_STRUCT(
@@ -90,4 +213,48 @@ std::unique_ptr<Tree> StyleEvaluator::parse(const std::string& expression)
         tree.reset();
     
     return tree;
-}
\ No newline at end of file
+}
+
+std::unique_ptr<const Program> StyleEvaluator::compile(const std::string& expression, StringTable& stringTable)
+{
+    // Most of declarations are plain values: skip grammar for them.
+    std::size_t start = expression.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos || expression.compare(start, 4, "eval") != 0)
+        return nullptr;
+
+    auto tree = parse(expression);
+    if (tree == nullptr)
+        return nullptr;
+
+    auto program = utymap::utils::make_unique<Program>();
+    program->stackSize = 0;
+    Compiler compiler(*program, stringTable);
+    compiler(*tree);
+
+    const std::string* stringKey = StringKeyFinder()(*tree);
+    program->hasStringKey = stringKey != nullptr;
+    program->stringKey = program->hasStringKey ? stringTable.getId(*stringKey) : 0;
+
+    return std::move(program);
+}
+
+template <>
+double StyleEvaluator::evaluate<double>(const Program& program, const std::vector<Tag>& tags, StringTable& stringTable)
+{
+    if (program.stackSize <= MaxLocalStackSize) {
+        double stack[MaxLocalStackSize];
+        return run(program, tags, stringTable, stack);
+    }
+
+    std::vector<double> stack(program.stackSize);
+    return run(program, tags, stringTable, stack.data());
+}
+
+template <>
+std::string StyleEvaluator::evaluate<std::string>(const Program& program, const std::vector<Tag>& tags, StringTable& stringTable)
+{
+    if (!program.hasStringKey)
+        throw std::domain_error("Evaluator: unsupported operation.");
+
+    return utymap::utils::getTagValue(program.stringKey, tags, stringTable);
+}
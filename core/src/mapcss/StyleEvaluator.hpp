@@ -3,11 +3,8 @@
 
 #include "entities/Element.hpp"
 #include "index/StringTable.hpp"
-#include "utils/CoreUtils.hpp"
-#include "utils/ElementUtils.hpp"
 
 #include <boost/variant/recursive_variant.hpp>
-#include <boost/variant/apply_visitor.hpp>
 
 #include <cstdint>
 #include <string>
@@ -44,115 +41,55 @@ struct StyleEvaluator final
         std::list<Operation> rest;
     };
 
-    StyleEvaluator() = delete;
-
-    /// Parses expression into AST.
-    static std::unique_ptr<Tree> parse(const std::string& expression);
-
-    /// Evaluates expression using tags.
-    template <typename T>
-    static T evaluate(const Tree& tree,
-                      const std::vector<utymap::entities::Tag>& tags,
-                      utymap::index::StringTable& stringTable)
-    {
-        typedef typename std::conditional<std::is_same<T, std::string>::value, StringEvaluator, DoubleEvaluator>::type EvaluatorType;
-        return EvaluatorType(tags, stringTable)(tree);
-    }
-
-private:
+    /// Specifies instruction of compiled expression.
+    enum class OpCode : std::uint8_t { Push, Tag, Add, Subtract, Multiply, Divide, Negate };
 
-    /// Specifies default AST evaluator behaviour.
-    template <typename T>
-    struct Evaluator
+    /// Represents single instruction of stack machine.
+    struct Instruction
     {
-        typedef T result_type;
-
-        Evaluator(const std::vector<utymap::entities::Tag>& tags,
-                  utymap::index::StringTable& stringTable) :
-            tags_(tags), stringTable_(stringTable)  { }
-
-    protected:
-        static std::string throwException() { throw std::domain_error("Evaluator: unsupported operation."); }
-
-        const std::vector<utymap::entities::Tag>& tags_;
-        utymap::index::StringTable& stringTable_;
+        OpCode code;
+        /// Key id of tag for Tag instruction.
+        std::uint32_t key;
+        /// Value for Push instruction.
+        double value;
     };
 
-    /// Evaluates double from AST.
-    struct DoubleEvaluator : public Evaluator<double>
+    /// Represents expression compiled into flat bytecode with tag keys resolved to ids.
+    struct Program
     {
-        DoubleEvaluator(const std::vector<utymap::entities::Tag>& tags,
-                        utymap::index::StringTable& stringTable) :
-            Evaluator(tags, stringTable) { }
-
-        double operator()(Nil) const { return 0; }
-        double operator()(double n) const { return n; }
-
-        double operator()(const Operation& o, double lhs) const
-        {
-            double rhs = boost::apply_visitor(*this, o.operand);
-            switch (o.operator_) {
-                case '+': return lhs + rhs;
-                case '-': return lhs - rhs;
-                case '*': return lhs * rhs;
-                case '/': return lhs / rhs;
-                default: return 0;
-            }
-        }
-
-        double operator()(const std::string& tagKey) const
-        {
-            auto keyId = stringTable_.getId(tagKey);
-            return utymap::utils::parseDouble(utymap::utils::getTagValue(keyId, tags_, stringTable_));
-        }
-
-        double operator()(const Signed& s) const
-        {
-            double rhs = boost::apply_visitor(*this, s.operand);
-            switch (s.sign) {
-                case '-': return -rhs;
-                case '+': return +rhs;
-                default: return 0;
-            }
-        }
-
-        double operator()(const Tree& tree) const
-        {
-            double state = boost::apply_visitor(*this, tree.first);
-            for (const Operation& oper : tree.rest)
-                state = (*this)(oper, state);
-            return state;
-        }
+        std::vector<Instruction> instructions;
+        /// Max depth of evaluation stack.
+        std::size_t stackSize;
+        /// Whether expression starts with tag, so that it can be evaluated as string.
+        bool hasStringKey;
+        std::uint32_t stringKey;
     };
 
-    /// Evaluates string from AST.
-    struct StringEvaluator : public Evaluator<std::string>
-    {
-        StringEvaluator(const std::vector<utymap::entities::Tag>& tags,
-            utymap::index::StringTable& stringTable)
-            : Evaluator(tags, stringTable) { }
-
-        std::string operator()(Nil) const { return throwException(); }
-        std::string operator()(double n) const { return throwException(); }
+    StyleEvaluator() = delete;
 
-        std::string operator()(const Operation& o, double lhs) const { return throwException(); }
+    /// Parses expression into AST.
+    static std::unique_ptr<Tree> parse(const std::string& expression);
 
-        std::string operator()(const std::string& tagKey) const
-        {
-            return utymap::utils::getTagValue(stringTable_.getId(tagKey), tags_, stringTable_);
-        }
+    /// Parses expression and compiles it into bytecode. Returns null if expression is not eval.
+    static std::unique_ptr<const Program> compile(const std::string& expression,
+                                                  utymap::index::StringTable& stringTable);
 
-        std::string operator()(const Signed& s) const { return throwException(); }
+    /// Evaluates compiled expression using tags.
+    template <typename T>
+    static T evaluate(const Program& program,
+                      const std::vector<utymap::entities::Tag>& tags,
+                      utymap::index::StringTable& stringTable);
+};
 
-        std::string operator()(const Tree& tree) const
-        {
-            return boost::apply_visitor(*this, tree.first);
-        }
-    };
+template <>
+double StyleEvaluator::evaluate<double>(const Program& program,
+                                        const std::vector<utymap::entities::Tag>& tags,
+                                        utymap::index::StringTable& stringTable);
 
-    std::string value_;
-    std::unique_ptr<Tree> tree_;
-};
+template <>
+std::string StyleEvaluator::evaluate<std::string>(const Program& program,
+                                                  const std::vector<utymap::entities::Tag>& tags,
+                                                  utymap::index::StringTable& stringTable);
 
 } }
 #endif  // MAPCSS_STYLEEVALUATOR_HPP_INCLUDED
@@ -1,3 +1,4 @@
+#include "entities/ElementDispatch.hpp"
 #include "entities/ElementVisitor.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
@@ -7,9 +8,20 @@
 #include "mapcss/StyleProvider.hpp"
 #include "utils/CoreUtils.hpp"
 #include "utils/GradientUtils.hpp"
+#include "utils/Statistics.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <set>
+#include <sstream>
+#include <unordered_set>
 
 using namespace utymap::entities;
 using namespace utymap::index;
@@ -29,23 +41,200 @@ struct ConditionType final
     OpType type;
 };
 
+/// Bitmask of levels of details: bit is set for every level of details filter is defined for.
+typedef std::uint64_t LodMask;
+
+/// Compiled declarations of rule: shared by filters of its selectors and by other rules with
+/// the same declarations.
+typedef std::unordered_map<uint32_t, std::unique_ptr<const StyleDeclaration>> RuleDeclarations;
+
 struct Filter final
 {
     std::vector<ConditionType> conditions;
-    std::unordered_map<uint32_t, std::unique_ptr<const StyleDeclaration>> declarations;
+    std::shared_ptr<const RuleDeclarations> declarations;
+    LodMask levelOfDetails;
 
-    Filter() = default;
+    Filter() : levelOfDetails(0) {}
     Filter(const Filter& other) = delete;
 
     Filter(Filter&& other) :
         conditions(std::move(other.conditions)),
-        declarations(std::move(other.declarations))
+        declarations(std::move(other.declarations)),
+        levelOfDetails(other.levelOfDetails)
     {
     }
 };
 
-/// Key: level of details, value: filters for specific element type.
-typedef std::unordered_map<int, std::vector<Filter>> FilterMap;
+/// Filters of single level of details and element type with index which maps tags to filters
+/// which can match them. Every condition requires tag key, so filter can match only elements
+/// which have tag of its anchor condition: (key, value) for equality, (key, any value) otherwise.
+/// Keys of anchors are also hashed into signature, so most elements which have none of them are
+/// rejected by single AND with signature of their tag keys.
+struct FilterGroup final
+{
+    typedef std::vector<std::uint64_t> Bitset;
+
+    /// Value id used in index for conditions which do not depend on value.
+    static const std::uint32_t AnyValue = std::numeric_limits<std::uint32_t>::max();
+
+    /// Indices of filters in storage of element type in order of their registration.
+    std::vector<std::uint32_t> filters;
+    /// Filters without conditions.
+    Bitset unconditional;
+    /// Key: tag key and value ids, value: candidate filters.
+    std::unordered_map<std::uint64_t, Bitset> candidates;
+    /// Bits of anchor keys or all bits if there is filter without conditions.
+    std::uint64_t keySignature = 0;
+
+    /// Returns signature of tag keys: every key sets one of 64 bits.
+    static std::uint64_t getSignature(const std::vector<Tag>& tags)
+    {
+        std::uint64_t signature = 0;
+        for (const auto& tag : tags)
+            signature |= getKeyBit(tag.key);
+        return signature;
+    }
+
+    /// Checks whether element with given signature of tag keys can match any filter.
+    bool mayMatch(std::uint64_t signature) const
+    {
+        return (keySignature & signature) != 0 || keySignature == std::numeric_limits<std::uint64_t>::max();
+    }
+
+    /// Builds index. Should be called once all filters are added.
+    void compile(const std::vector<Filter>& storage)
+    {
+        std::size_t words = (filters.size() + 63) / 64;
+        unconditional.assign(words, 0);
+        candidates.clear();
+        keySignature = 0;
+        for (std::size_t i = 0; i < filters.size(); ++i) {
+            const auto& conditions = storage[filters[i]].conditions;
+            if (conditions.empty()) {
+                setBit(unconditional, i);
+                keySignature = std::numeric_limits<std::uint64_t>::max();
+                continue;
+            }
+
+            auto anchor = std::find_if(conditions.begin(), conditions.end(),
+                [](const ConditionType& c) { return c.type == OpType::Equals; });
+            std::uint64_t key = anchor != conditions.end()
+                ? toKey(anchor->key, anchor->value)
+                : toKey(conditions.front().key, AnyValue);
+            keySignature |= getKeyBit(anchor != conditions.end() ? anchor->key : conditions.front().key);
+
+            auto& bitset = candidates[key];
+            bitset.resize(words, 0);
+            setBit(bitset, i);
+        }
+    }
+
+    /// Collects candidate filters for given tags in one pass over them.
+    Bitset getCandidates(const std::vector<Tag>& tags) const
+    {
+        Bitset bitset(unconditional);
+        if (candidates.empty())
+            return bitset;
+
+        for (const auto& tag : tags) {
+            merge(bitset, toKey(tag.key, tag.value));
+            merge(bitset, toKey(tag.key, AnyValue));
+        }
+        return bitset;
+    }
+
+private:
+    /// Uses the highest bits of multiplicative hash as ids of keys are dense.
+    static std::uint64_t getKeyBit(std::uint32_t key)
+    {
+        return std::uint64_t(1) << ((key * 2654435761u) >> 26);
+    }
+
+    static std::uint64_t toKey(std::uint32_t key, std::uint32_t value)
+    {
+        return (static_cast<std::uint64_t>(key) << 32) | value;
+    }
+
+    static void setBit(Bitset& bitset, std::size_t index)
+    {
+        bitset[index / 64] |= std::uint64_t(1) << (index % 64);
+    }
+
+    void merge(Bitset& bitset, std::uint64_t key) const
+    {
+        auto candidatePair = candidates.find(key);
+        if (candidatePair == candidates.end())
+            return;
+        for (std::size_t i = 0; i < bitset.size(); ++i)
+            bitset[i] |= candidatePair->second[i];
+    }
+};
+
+/// Filters for specific element type. Every filter is stored once and groups of levels of details
+/// refer to it by index.
+struct FilterMap final
+{
+    /// Max level of details which fits into mask.
+    static const int MaxLevelOfDetails = std::numeric_limits<LodMask>::digits - 1;
+
+    std::vector<Filter> filters;
+    /// Key: level of details, value: filters defined for it.
+    std::unordered_map<int, FilterGroup> groups;
+
+    /// Adds filter to groups of its levels of details.
+    void add(Filter&& filter)
+    {
+        auto index = static_cast<std::uint32_t>(filters.size());
+        for (int lod = 0; lod <= MaxLevelOfDetails; ++lod) {
+            if ((filter.levelOfDetails & (LodMask(1) << lod)) != 0)
+                groups[lod].filters.push_back(index);
+        }
+        filters.push_back(std::move(filter));
+    }
+
+    /// Returns group for given level of details or null.
+    const FilterGroup* find(int levelOfDetails) const
+    {
+        auto groupPair = groups.find(levelOfDetails);
+        return groupPair != groups.end() ? &groupPair->second : nullptr;
+    }
+
+    /// Builds indices of groups. Should be called once all filters are added.
+    void compile()
+    {
+        for (auto& groupPair : groups)
+            groupPair.second.compile(filters);
+    }
+
+    /// Returns approximate amount of bytes used by filters and their indices. Declarations are
+    /// counted once: counted ones are skipped and added to given set.
+    std::size_t getMemoryUsage(std::unordered_set<const RuleDeclarations*>& counted) const
+    {
+        std::size_t usage = filters.capacity() * sizeof(Filter);
+        for (const auto& filter : filters) {
+            usage += filter.conditions.capacity() * sizeof(ConditionType);
+            if (counted.insert(filter.declarations.get()).second)
+                usage += getMemoryUsage(*filter.declarations);
+        }
+        for (const auto& groupPair : groups) {
+            const auto& group = groupPair.second;
+            usage += sizeof(groupPair) + group.filters.capacity() * sizeof(std::uint32_t) +
+                group.unconditional.capacity() * sizeof(std::uint64_t);
+            for (const auto& candidate : group.candidates)
+                usage += sizeof(candidate) + candidate.second.capacity() * sizeof(std::uint64_t);
+        }
+        return usage;
+    }
+
+    /// Returns approximate amount of bytes used by declarations.
+    static std::size_t getMemoryUsage(const RuleDeclarations& declarations)
+    {
+        std::size_t usage = sizeof(RuleDeclarations);
+        for (const auto& declaration : declarations)
+            usage += sizeof(declaration) + sizeof(StyleDeclaration) + declaration.second->value().capacity();
+        return usage;
+    }
+};
 
 struct FilterCollection final
 {
@@ -56,19 +245,343 @@ struct FilterCollection final
     FilterMap canvases;
 };
 
+/// Checks whether filters have the same conditions and declarations.
+bool isSame(const Filter& left, const Filter& right)
+{
+    if (left.conditions.size() != right.conditions.size() ||
+        left.declarations->size() != right.declarations->size())
+        return false;
+
+    for (std::size_t i = 0; i < left.conditions.size(); ++i) {
+        const auto& l = left.conditions[i];
+        const auto& r = right.conditions[i];
+        if (l.key != r.key || l.value != r.value || l.type != r.type)
+            return false;
+    }
+
+    if (left.declarations == right.declarations)
+        return true;
+
+    for (const auto& declaration : *left.declarations) {
+        auto other = right.declarations->find(declaration.first);
+        if (other == right.declarations->end() || other->second->value() != declaration.second->value())
+            return false;
+    }
+    return true;
+}
+
+/// Checks whether groups have the same filters in the same order.
+bool isSame(const FilterMap& leftMap, const FilterGroup& left, const FilterMap& rightMap, const FilterGroup& right)
+{
+    if (left.filters.size() != right.filters.size())
+        return false;
+
+    for (std::size_t i = 0; i < left.filters.size(); ++i) {
+        if (!isSame(leftMap.filters[left.filters[i]], rightMap.filters[right.filters[i]]))
+            return false;
+    }
+    return true;
+}
+
+/// Gets FNV-1a hash of rules as they are written by stylesheet output.
+std::uint64_t hashRules(const StyleSheet& stylesheet)
+{
+    std::ostringstream stream;
+    stream << stylesheet;
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : stream.str()) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/// Filters matched at single level of details.
+typedef std::vector<const Filter*> MatchedFilters;
+
+/// Caches declarations built for elements of the same type with the same tags at the same level of details.
+/// Declarations are immutable, so they are shared between styles. Thread safe.
+class StyleCache final
+{
+    /// Amount of independently locked parts.
+    static const std::size_t ShardCount = 16;
+    /// Max amount of entries in part. Part is cleared when it is exceeded.
+    static const std::size_t MaxShardSize = 4096;
+
+    struct Entry final
+    {
+        const FilterMap* filters;
+        int levelOfDetails;
+        std::vector<Tag> tags;
+        Style::DeclarationsPtr declarations;
+    };
+
+    struct Shard final
+    {
+        std::mutex lock;
+        std::unordered_map<std::size_t, std::vector<Entry>> entries;
+        std::size_t size = 0;
+    };
+
+public:
+    /// Finds declarations cached for given key. Null declarations mean that there is no style.
+    bool tryGet(const FilterMap& filters, int levelOfDetails, const std::vector<Tag>& tags,
+                Style::DeclarationsPtr& declarations)
+    {
+        std::size_t hash = getHash(filters, levelOfDetails, tags);
+        Shard& shard = shards_[hash % ShardCount];
+        std::lock_guard<std::mutex> lock(shard.lock);
+        auto bucket = shard.entries.find(hash);
+        if (bucket == shard.entries.end())
+            return false;
+
+        for (const auto& entry : bucket->second) {
+            if (isSame(entry, filters, levelOfDetails, tags)) {
+                declarations = entry.declarations;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void put(const FilterMap& filters, int levelOfDetails, const std::vector<Tag>& tags,
+             const Style::DeclarationsPtr& declarations)
+    {
+        std::size_t hash = getHash(filters, levelOfDetails, tags);
+        Shard& shard = shards_[hash % ShardCount];
+        std::lock_guard<std::mutex> lock(shard.lock);
+        if (shard.size >= MaxShardSize) {
+            shard.entries.clear();
+            shard.size = 0;
+        }
+
+        auto& bucket = shard.entries[hash];
+        for (const auto& entry : bucket) {
+            if (isSame(entry, filters, levelOfDetails, tags))
+                return;
+        }
+        bucket.push_back(Entry { &filters, levelOfDetails, tags, declarations });
+        ++shard.size;
+    }
+
+    /// Removes all entries.
+    void clear()
+    {
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.lock);
+            shard.entries.clear();
+            shard.size = 0;
+        }
+    }
+
+    /// Returns approximate amount of bytes used by entries. Shared declarations are counted per entry.
+    std::size_t getMemoryUsage()
+    {
+        std::size_t usage = 0;
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.lock);
+            for (const auto& bucket : shard.entries) {
+                usage += sizeof(bucket) + bucket.second.capacity() * sizeof(Entry);
+                for (const auto& entry : bucket.second) {
+                    usage += entry.tags.capacity() * sizeof(Tag);
+                    if (entry.declarations != nullptr)
+                        usage += entry.declarations->capacity() * sizeof(Style::Declarations::value_type);
+                }
+            }
+        }
+        return usage;
+    }
+
+private:
+
+    static std::size_t getHash(const FilterMap& filters, int levelOfDetails, const std::vector<Tag>& tags)
+    {
+        std::size_t hash = std::hash<const FilterMap*>()(&filters) ^ static_cast<std::size_t>(levelOfDetails);
+        for (const auto& tag : tags) {
+            std::uint64_t value = (static_cast<std::uint64_t>(tag.key) << 32) | tag.value;
+            hash ^= std::hash<std::uint64_t>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+
+    static bool isSame(const Entry& entry, const FilterMap& filters, int levelOfDetails, const std::vector<Tag>& tags)
+    {
+        return entry.filters == &filters &&
+               entry.levelOfDetails == levelOfDetails &&
+               entry.tags.size() == tags.size() &&
+               std::equal(entry.tags.begin(), entry.tags.end(), tags.begin(),
+                   [](const Tag& left, const Tag& right) {
+                       return left.key == right.key && left.value == right.value;
+                   });
+    }
+
+    std::array<Shard, ShardCount> shards_;
+};
+
+/// Assigns ids to distinct sets of matched filters, so styles resolved at import time can be
+/// restored without matching. Ids are valid only for registry version. Thread safe.
+class FingerprintRegistry final
+{
+public:
+    FingerprintRegistry() : version_(nextVersion()) {}
+
+    /// Returns id of declarations built from given filters registering them if necessary.
+    std::uint32_t add(const MatchedFilters& filters, const Style::DeclarationsPtr& declarations)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto pair = ids_.find(filters);
+        if (pair != ids_.end())
+            return pair->second;
+
+        declarations_.push_back(declarations);
+        auto id = static_cast<std::uint32_t>(declarations_.size());
+        ids_.emplace(filters, id);
+        return id;
+    }
+
+    /// Returns declarations registered with given id.
+    Style::DeclarationsPtr get(std::uint32_t id) const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (id == 0 || id > declarations_.size())
+            throw utymap::MapCssException("Unknown style fingerprint: " + utymap::utils::toString(id));
+        return declarations_[id - 1];
+    }
+
+    std::uint64_t getVersion() const { return version_; }
+
+    /// Removes all ids and changes version, so ids given before are not resolved anymore.
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        ids_.clear();
+        declarations_.clear();
+        version_ = nextVersion();
+    }
+
+private:
+    /// Returns version which is unique for all registries of process.
+    static std::uint64_t nextVersion()
+    {
+        static std::atomic<std::uint64_t> version(0);
+        return ++version;
+    }
+
+    mutable std::mutex lock_;
+    std::map<MatchedFilters, std::uint32_t> ids_;
+    std::vector<Style::DeclarationsPtr> declarations_;
+    std::atomic<std::uint64_t> version_;
+};
+
+/// Insert only registry of gradients which are not known on stylesheet load. Buckets are
+/// lock free singly linked lists: nodes are published by compare and swap and never removed.
+class GradientRegistry final
+{
+    static const std::size_t BucketCount = 256;
+
+    struct Node final
+    {
+        std::string key;
+        std::unique_ptr<const ColorGradient> gradient;
+        Node* next;
+    };
+
+public:
+    GradientRegistry()
+    {
+        for (auto& bucket : buckets_)
+            bucket.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~GradientRegistry()
+    {
+        for (auto& bucket : buckets_) {
+            Node* node = bucket.load(std::memory_order_relaxed);
+            while (node != nullptr) {
+                Node* next = node->next;
+                delete node;
+                node = next;
+            }
+        }
+    }
+
+    /// Finds gradient by key. Returns null if there is no gradient.
+    const ColorGradient* find(const std::string& key) const
+    {
+        return find(getBucket(key).load(std::memory_order_acquire), nullptr, key);
+    }
+
+    /// Adds gradient if there is no gradient with the same key and returns registered one.
+    const ColorGradient& add(const std::string& key, std::unique_ptr<const ColorGradient> gradient)
+    {
+        auto& bucket = getBucket(key);
+        std::unique_ptr<Node> node(new Node { key, std::move(gradient), bucket.load(std::memory_order_acquire) });
+        const ColorGradient* existing = find(node->next, nullptr, key);
+        while (existing == nullptr) {
+            Node* head = node->next;
+            if (bucket.compare_exchange_weak(node->next, node.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+                return *node.release()->gradient;
+            // NOTE check only nodes which are added since previous attempt.
+            existing = find(node->next, head, key);
+        }
+        return *existing;
+    }
+
+private:
+    std::atomic<Node*>& getBucket(const std::string& key)
+    {
+        return buckets_[std::hash<std::string>()(key) % BucketCount];
+    }
+
+    const std::atomic<Node*>& getBucket(const std::string& key) const
+    {
+        return buckets_[std::hash<std::string>()(key) % BucketCount];
+    }
+
+    /// Searches nodes from begin until end.
+    static const ColorGradient* find(const Node* begin, const Node* end, const std::string& key)
+    {
+        for (const Node* node = begin; node != end; node = node->next) {
+            if (node->key == key)
+                return node->gradient.get();
+        }
+        return nullptr;
+    }
+
+    std::array<std::atomic<Node*>, BucketCount> buckets_;
+};
+
 class StyleBuilder final : public ElementVisitor
 {
     typedef std::vector<Tag>::const_iterator TagIterator;
 public:
 
-    StyleBuilder(std::vector<Tag> tags, StringTable& stringTable,
-                 const FilterCollection& filters, int levelOfDetails, bool onlyCheck = false) :
-            style(tags, stringTable),
+    StyleBuilder(StringTable& stringTable, const FilterCollection& filters, StyleCache& cache,
+                 int levelOfDetails, bool onlyCheck = false) :
+            declarations(),
             filters_(filters),
+            cache_(&cache),
             levelOfDetails_(levelOfDetails),
             onlyCheck_(onlyCheck),
             canBuild_(false),
-            stringTable_(stringTable)
+            stringTable_(stringTable),
+            range_(levelOfDetails, levelOfDetails),
+            matchedFilters_(nullptr)
+    {
+    }
+
+    /// Creates builder which only collects matched filters for every level of details in range.
+    StyleBuilder(StringTable& stringTable, const FilterCollection& filters,
+                 const utymap::LodRange& range, std::vector<MatchedFilters>& matchedFilters) :
+            declarations(),
+            filters_(filters),
+            cache_(nullptr),
+            levelOfDetails_(range.start),
+            onlyCheck_(true),
+            canBuild_(false),
+            stringTable_(stringTable),
+            range_(range),
+            matchedFilters_(&matchedFilters)
     {
     }
 
@@ -82,13 +595,16 @@ public:
 
     bool canBuild() const { return canBuild_; }
 
-    Style style;
+    /// Declarations of built style. Null if there is no style.
+    Style::DeclarationsPtr declarations;
 
 private:
 
     void checkOrBuild(const std::vector<Tag>& tags, const FilterMap& filters)
     {
-        if (onlyCheck_)
+        if (matchedFilters_ != nullptr)
+            collect(tags, filters);
+        else if (onlyCheck_)
             check(tags, filters);
         else
             build(tags, filters);
@@ -115,10 +631,7 @@ private:
     template<typename Func>
     bool compareDoubles(std::uint32_t left, std::uint32_t right, Func binaryOp)
     {
-        double leftValue = utymap::utils::parseDouble(stringTable_.getString(left));
-        double rightValue = utymap::utils::parseDouble(stringTable_.getString(right));
-
-        return binaryOp(leftValue, rightValue);
+        return binaryOp(stringTable_.getNumber(left), stringTable_.getNumber(right));
     }
 
     /// Tries to find tag which satisfy condition using binary search.
@@ -136,54 +649,201 @@ private:
         return false;
     }
 
-    /// Builds style object. More expensive to call than check.
-    void build(const std::vector<Tag>& tags, const FilterMap& filters)
+    /// Calls handler for filters of group matching tags in order of their registration.
+    /// Stops when handler returns false.
+    template<typename Handler>
+    void matchFilters(const std::vector<Tag>& tags, const FilterMap& filters,
+                      const FilterGroup& group, const Handler& handler)
     {
-        FilterMap::const_iterator iter = filters.find(levelOfDetails_);
-        if (iter != filters.end()) {
-            for (const Filter& filter : iter->second) {
+        FilterGroup::Bitset bitset = group.getCandidates(tags);
+        for (std::size_t word = 0; word < bitset.size(); ++word) {
+            std::uint64_t bits = bitset[word];
+            for (std::size_t bit = 0; bits != 0; ++bit, bits >>= 1) {
+                if ((bits & 1) == 0)
+                    continue;
+
+                const Filter& filter = filters.filters[group.filters[word * 64 + bit]];
                 bool isMatched = true;
                 for (auto it = filter.conditions.cbegin(); it != filter.conditions.cend() && isMatched; ++it) {
                     isMatched &= matchTags(tags.cbegin(), tags.cend(), *it);
                 }
-                // merge declarations to style
-                if (isMatched) {
-                    canBuild_ = true;
-                    for (const auto& d : filter.declarations) {
-                        style.put(*d.second);
-                    }
-                }
+                if (isMatched && !handler(filter))
+                    return;
             }
         }
     }
 
+    /// Builds style object. More expensive to call than check.
+    void build(const std::vector<Tag>& tags, const FilterMap& filters)
+    {
+        const FilterGroup* group = filters.find(levelOfDetails_);
+        if (group == nullptr || !group->mayMatch(FilterGroup::getSignature(tags)))
+            return;
+
+        if (cache_->tryGet(filters, levelOfDetails_, tags, declarations)) {
+            canBuild_ = declarations != nullptr;
+            return;
+        }
+
+        auto built = std::make_shared<Style::Declarations>();
+        matchFilters(tags, filters, *group, [&](const Filter& filter) {
+            // merge declarations to style
+            canBuild_ = true;
+            for (const auto& d : *filter.declarations) {
+                Style::merge(*built, *d.second);
+            }
+            return true;
+        });
+        if (canBuild_)
+            declarations = std::move(built);
+        cache_->put(filters, levelOfDetails_, tags, declarations);
+    }
+
     /// Just checks whether style can be created without constructing actual style.
     void check(const std::vector<Tag>& tags, const FilterMap& filters)
     {
-        FilterMap::const_iterator iter = filters.find(levelOfDetails_);
-        if (iter != filters.end()) {
-            for (const Filter& filter : iter->second) {
-                bool isMatched = true;
-                for (auto it = filter.conditions.cbegin(); it != filter.conditions.cend() && isMatched; ++it) {
-                    isMatched &= matchTags(tags.cbegin(), tags.cend(), *it);
-                }
-                if (isMatched) {
-                    canBuild_ = true;
-                    return;
-                }
-            }
+        const FilterGroup* group = filters.find(levelOfDetails_);
+        if (group == nullptr || !group->mayMatch(FilterGroup::getSignature(tags)))
+            return;
+
+        Style::DeclarationsPtr cached;
+        if (cache_->tryGet(filters, levelOfDetails_, tags, cached)) {
+            canBuild_ = cached != nullptr;
+            return;
+        }
+
+        matchFilters(tags, filters, *group, [&](const Filter&) {
+            canBuild_ = true;
+            return false;
+        });
+    }
+
+    /// Collects matched filters for every level of details in range.
+    void collect(const std::vector<Tag>& tags, const FilterMap& filters)
+    {
+        std::uint64_t signature = FilterGroup::getSignature(tags);
+        for (int lod = range_.start; lod <= range_.end; ++lod) {
+            matchedFilters_->push_back(MatchedFilters());
+            const FilterGroup* group = filters.find(lod);
+            if (group == nullptr || !group->mayMatch(signature))
+                continue;
+
+            matchFilters(tags, filters, *group, [&](const Filter& filter) {
+                canBuild_ = true;
+                matchedFilters_->back().push_back(&filter);
+                return true;
+            });
         }
     }
 
     const FilterCollection &filters_;
+    StyleCache* cache_;
     int levelOfDetails_;
     bool onlyCheck_;
     bool canBuild_;
     StringTable& stringTable_;
+    const utymap::LodRange range_;
+    std::vector<MatchedFilters>* matchedFilters_;
 };
 
 }
 
+class SharedStyleRules::SharedStyleRulesImpl final
+{
+public:
+    explicit SharedStyleRulesImpl(StringTable& stringTable) :
+        stringTable(stringTable)
+    {
+    }
+
+    /// Returns declarations registered with given key or registers ones created by factory.
+    template<typename Factory>
+    std::shared_ptr<const RuleDeclarations> getDeclarations(const std::string& key, const Factory& factory)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto declarations = find(declarations_, key);
+        if (declarations != nullptr)
+            return declarations;
+
+        declarations = factory();
+        declarations_[key] = declarations;
+        return declarations;
+    }
+
+    /// Returns gradient registered with given key or registers parsed one. Returns null if
+    /// key is not valid gradient.
+    std::shared_ptr<const ColorGradient> getGradient(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto gradient = find(gradients_, key);
+        if (gradient != nullptr)
+            return gradient;
+
+        gradient = utymap::utils::GradientUtils::parseGradient(key);
+        if (gradient->empty())
+            return nullptr;
+        gradients_[key] = gradient;
+        return gradient;
+    }
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        std::size_t count = 0;
+        for (const auto& pair : declarations_)
+            count += pair.second.expired() ? 0 : 1;
+        return count;
+    }
+
+    /// Adds shared declarations to given set.
+    void collect(std::unordered_set<const RuleDeclarations*>& declarations) const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        for (const auto& pair : declarations_) {
+            auto alive = pair.second.lock();
+            if (alive != nullptr)
+                declarations.insert(alive.get());
+        }
+    }
+
+    std::size_t getMemoryUsage() const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        std::size_t usage = 0;
+        for (const auto& pair : declarations_) {
+            auto alive = pair.second.lock();
+            if (alive != nullptr)
+                usage += pair.first.capacity() + FilterMap::getMemoryUsage(*alive);
+        }
+        for (const auto& pair : gradients_)
+            usage += pair.second.expired() ? 0 : pair.first.capacity() + sizeof(ColorGradient);
+        return usage;
+    }
+
+    StringTable& stringTable;
+
+private:
+    /// Returns alive value with given key. Expired values are removed from map: they are
+    /// released when the last provider which uses them is replaced, e.g. by stylesheet reload.
+    template<typename T>
+    static std::shared_ptr<const T> find(std::unordered_map<std::string, std::weak_ptr<const T>>& map, const std::string& key)
+    {
+        for (auto it = map.begin(); it != map.end();) {
+            if (it->second.expired())
+                it = map.erase(it);
+            else
+                ++it;
+        }
+        auto pair = map.find(key);
+        return pair != map.end() ? pair->second.lock() : nullptr;
+    }
+
+    mutable std::mutex lock_;
+    /// Key: declarations of rule as they are written in stylesheet. Values are owned by providers.
+    std::unordered_map<std::string, std::weak_ptr<const RuleDeclarations>> declarations_;
+    std::unordered_map<std::string, std::weak_ptr<const ColorGradient>> gradients_;
+};
+
 /// Converts mapcss stylesheet to index optimized representation to speed search query up.
 class StyleProvider::StyleProviderImpl
 {
@@ -191,32 +851,117 @@ public:
 
     FilterCollection filters;
     StringTable& stringTable;
+    StyleCache cache;
+    FingerprintRegistry fingerprints;
+    std::uint64_t stylesheetHash;
 
-    std::unordered_map<std::string, std::unique_ptr<const ColorGradient>> gradients;
+    std::unordered_map<std::string, std::shared_ptr<const ColorGradient>> gradients;
     std::unordered_map<std::string, std::unique_ptr<const TextureAtlas>> textures;
 
     StyleProviderImpl(const StyleSheet& stylesheet, 
-                      StringTable& stringTable) :
+                      StringTable& stringTable,
+                      const std::shared_ptr<SharedStyleRules>& sharedRules) :
         filters(),
         stringTable(stringTable),
+        cache(),
+        fingerprints(),
+        stylesheetHash(hashRules(stylesheet)),
         gradients(),
-        textures()
+        textures(),
+        sharedRules_(sharedRules)
+    {
+        if (sharedRules_ != nullptr && &sharedRules_->pimpl_->stringTable != &stringTable)
+            throw std::domain_error("Shared style rules use different string table.");
+
+        addRules(stylesheet, filters);
+
+        textures.emplace(DefaultTextureName, utymap::utils::make_unique<const TextureAtlas>());
+        for (const auto& texture: stylesheet.textures) {
+            textures.emplace(texture.name(), utymap::utils::make_unique<const TextureAtlas>(texture));
+        }
+    }
+
+    const ColorGradient& getGradient(const std::string& key)
+    {
+        // NOTE gradients of stylesheet are not modified after load, so they are read without lock.
+        auto gradientPair = gradients.find(key);
+        if (gradientPair != gradients.end())
+            return *gradientPair->second;
+
+        const ColorGradient* registered = evaluatedGradients_.find(key);
+        if (registered != nullptr)
+            return *registered;
+
+        auto gradient = utymap::utils::GradientUtils::parseGradient(key);
+        if (gradient->empty())
+            throw MapCssException("Invalid gradient: " + key);
+        return evaluatedGradients_.add(key, std::move(gradient));
+    }
+
+    std::size_t getMemoryUsage()
     {
-        filters.nodes.reserve(24);
-        filters.ways.reserve(24);
-        filters.areas.reserve(24);
-        filters.relations.reserve(24);
-        filters.canvases.reserve(24);
+        // NOTE shared declarations are accounted by shared rules.
+        std::unordered_set<const RuleDeclarations*> counted;
+        if (sharedRules_ != nullptr)
+            sharedRules_->pimpl_->collect(counted);
+
+        std::size_t usage = cache.getMemoryUsage();
+        for (const FilterMap* filterMap : { &filters.nodes, &filters.ways, &filters.areas, &filters.relations, &filters.canvases })
+            usage += filterMap->getMemoryUsage(counted);
+        return usage;
+    }
+
+    const TextureGroup& getTexture(const std::string& texture, const std::string& key) const
+    {
+        auto texturePair = textures.find(texture);
+        if (texturePair == textures.end()) {
+            texturePair = textures.find(DefaultTextureName);
+        }
+
+        return texturePair->second->get(key);
+    }
+
+    /// Replaces filters of levels of details and element types which are changed in given stylesheet.
+    /// Returns sorted levels of details which are affected.
+    std::vector<int> reload(const StyleSheet& stylesheet)
+    {
+        FilterCollection updated;
+        addRules(stylesheet, updated);
+        stylesheetHash = hashRules(stylesheet);
+
+        std::set<int> levelOfDetails;
+        replaceChanged(filters.nodes, updated.nodes, levelOfDetails);
+        replaceChanged(filters.ways, updated.ways, levelOfDetails);
+        replaceChanged(filters.areas, updated.areas, levelOfDetails);
+        replaceChanged(filters.relations, updated.relations, levelOfDetails);
+        replaceChanged(filters.canvases, updated.canvases, levelOfDetails);
+
+        if (!levelOfDetails.empty()) {
+            cache.clear();
+            fingerprints.clear();
+        }
+
+        return std::vector<int>(levelOfDetails.begin(), levelOfDetails.end());
+    }
+
+private:
+
+    /// Converts rules of stylesheet to filters.
+    void addRules(const StyleSheet& stylesheet, FilterCollection& collection)
+    {
+        for (FilterMap* filterMap : { &collection.nodes, &collection.ways, &collection.areas, &collection.relations, &collection.canvases })
+            filterMap->groups.reserve(24);
 
         for (const Rule& rule : stylesheet.rules) {
+            auto declarations = getDeclarations(rule);
             for (const Selector& selector : rule.selectors) {
                 for (const std::string& name : selector.names) {
                     FilterMap* filtersPtr = nullptr;
-                    if (name == "node") filtersPtr = &filters.nodes;
-                    else if (name == "way") filtersPtr = &filters.ways;
-                    else if (name == "area") filtersPtr = &filters.areas;
-                    else if (name == "relation") filtersPtr = &filters.relations;
-                    else if (name == "canvas") filtersPtr = &filters.canvases;
+                    if (name == "node") filtersPtr = &collection.nodes;
+                    else if (name == "way") filtersPtr = &collection.ways;
+                    else if (name == "area") filtersPtr = &collection.areas;
+                    else if (name == "relation") filtersPtr = &collection.relations;
+                    else if (name == "canvas") filtersPtr = &collection.canvases;
                     else
                         throw std::domain_error("Unexpected selector name:" + name);
 
@@ -237,72 +982,124 @@ public:
                         filter.conditions.push_back(c);
                     }
 
-                    filter.declarations.reserve(rule.declarations.size());
-                    for (auto i = 0; i < rule.declarations.size(); ++i) {
-                        Declaration declaration = rule.declarations[i];
-                        uint32_t key = stringTable.getId(declaration.key);
-
-                        if (utymap::utils::GradientUtils::isGradient(declaration.value))
-                            addGradient(declaration.value);
-
-                        filter.declarations[key] = utymap::utils::make_unique<const StyleDeclaration>(key, declaration.value);
-                    }
+                    filter.declarations = declarations;
 
                     std::sort(filter.conditions.begin(), filter.conditions.end(),
                         [](const ConditionType& c1, const ConditionType& c2) { return c1.key > c2.key; });
-                    for (int i = selector.zoom.start; i <= selector.zoom.end; ++i) {
-                        (*filtersPtr)[i].push_back(std::move(filter));
-                    }
+                    if (selector.zoom.end > FilterMap::MaxLevelOfDetails)
+                        throw std::domain_error("Unexpected zoom level:" + utymap::utils::toString(static_cast<int>(selector.zoom.end)));
+                    for (int i = selector.zoom.start; i <= selector.zoom.end; ++i)
+                        filter.levelOfDetails |= LodMask(1) << i;
+                    filtersPtr->add(std::move(filter));
                 }
             }
         }
 
-        textures.emplace(DefaultTextureName, utymap::utils::make_unique<const TextureAtlas>());
-        for (const auto& texture: stylesheet.textures) {
-            textures.emplace(texture.name(), utymap::utils::make_unique<const TextureAtlas>(texture));
-        }
+        for (FilterMap* filterMap : { &collection.nodes, &collection.ways, &collection.areas, &collection.relations, &collection.canvases })
+            filterMap->compile();
     }
 
-    const ColorGradient& getGradient(const std::string& key)
+    /// Tracks levels of details which filter groups differ from current ones and replaces
+    /// filters of element type if there is any. Filters are shared by groups, so they are
+    /// replaced together while styles of unchanged levels of details stay the same.
+    static void replaceChanged(FilterMap& current, FilterMap& updated, std::set<int>& levelOfDetails)
     {
-        auto gradientPair = gradients.find(key);
-        if (gradientPair == gradients.end()) {
-            auto gradient = utymap::utils::GradientUtils::parseGradient(key);
-            if (gradient->empty())
-                throw MapCssException("Invalid gradient: " + key);
-            std::lock_guard<std::mutex> lock(lock_);
-            gradients.emplace(key, std::move(gradient));
-            gradientPair = gradients.find(key);
+        bool isChanged = false;
+        for (const auto& groupPair : current.groups) {
+            if (updated.find(groupPair.first) == nullptr) {
+                levelOfDetails.insert(groupPair.first);
+                isChanged = true;
+            }
         }
-        return *gradientPair->second;
-    }
 
-    const TextureGroup& getTexture(const std::string& texture, const std::string& key) const
-    {
-        auto texturePair = textures.find(texture);
-        if (texturePair == textures.end()) {
-            texturePair = textures.find(DefaultTextureName);
+        for (const auto& groupPair : updated.groups) {
+            const FilterGroup* currentGroup = current.find(groupPair.first);
+            if (currentGroup != nullptr && isSame(current, *currentGroup, updated, groupPair.second))
+                continue;
+
+            levelOfDetails.insert(groupPair.first);
+            isChanged = true;
         }
 
-        return texturePair->second->get(key);
+        if (isChanged)
+            current = std::move(updated);
     }
 
-private:
+    /// Compiles declarations of rule once for all its selectors or takes shared ones.
+    std::shared_ptr<const RuleDeclarations> getDeclarations(const Rule& rule)
+    {
+        for (const auto& declaration : rule.declarations)
+            if (utymap::utils::GradientUtils::isGradient(declaration.value))
+                addGradient(declaration.value);
+
+        auto factory = [&]() {
+            auto declarations = std::make_shared<RuleDeclarations>();
+            declarations->reserve(rule.declarations.size());
+            for (const auto& declaration : rule.declarations) {
+                uint32_t key = stringTable.getId(declaration.key);
+                (*declarations)[key] = utymap::utils::make_unique<const StyleDeclaration>(key, declaration.value, stringTable);
+            }
+            return std::shared_ptr<const RuleDeclarations>(std::move(declarations));
+        };
+        if (sharedRules_ == nullptr)
+            return factory();
+
+        std::string key;
+        for (const auto& declaration : rule.declarations)
+            key.append(declaration.key).append(1, '\0').append(declaration.value).append(1, '\0');
+        return sharedRules_->pimpl_->getDeclarations(key, factory);
+    }
 
     void addGradient(const std::string& key)
     {
-        if (gradients.find(key) == gradients.end()) {
-            auto gradient = utymap::utils::GradientUtils::parseGradient(key);
-            if (!gradient->empty())
+        if (gradients.find(key) != gradients.end())
+            return;
+
+        if (sharedRules_ != nullptr) {
+            auto gradient = sharedRules_->pimpl_->getGradient(key);
+            if (gradient != nullptr)
                 gradients.emplace(key, std::move(gradient));
+            return;
         }
+
+        std::shared_ptr<const ColorGradient> gradient = utymap::utils::GradientUtils::parseGradient(key);
+        if (!gradient->empty())
+            gradients.emplace(key, std::move(gradient));
     }
 
-    std::mutex lock_;
+    const std::shared_ptr<SharedStyleRules> sharedRules_;
+
+    /// Gradients which are not defined in stylesheet.
+    GradientRegistry evaluatedGradients_;
 };
 
+SharedStyleRules::SharedStyleRules(StringTable& stringTable) :
+    pimpl_(utymap::utils::make_unique<SharedStyleRulesImpl>(stringTable))
+{
+}
+
+SharedStyleRules::~SharedStyleRules()
+{
+}
+
+std::size_t SharedStyleRules::size() const
+{
+    return pimpl_->size();
+}
+
+std::size_t SharedStyleRules::getMemoryUsage() const
+{
+    return pimpl_->getMemoryUsage();
+}
+
 StyleProvider::StyleProvider(const StyleSheet& stylesheet, StringTable& stringTable) :
-    pimpl_(utymap::utils::make_unique<StyleProviderImpl>(stylesheet, stringTable))
+    pimpl_(utymap::utils::make_unique<StyleProviderImpl>(stylesheet, stringTable, nullptr))
+{
+}
+
+StyleProvider::StyleProvider(const StyleSheet& stylesheet, StringTable& stringTable,
+                             const std::shared_ptr<SharedStyleRules>& sharedRules) :
+    pimpl_(utymap::utils::make_unique<StyleProviderImpl>(stylesheet, stringTable, sharedRules))
 {
 }
 
@@ -316,27 +1113,91 @@ StyleProvider::StyleProvider(StyleProvider&& other) : pimpl_(std::move(other.pim
 
 bool StyleProvider::hasStyle(const utymap::entities::Element& element, int levelOfDetails) const
 {
-    StyleBuilder builder(element.tags, pimpl_->stringTable, pimpl_->filters, levelOfDetails, true);
-    element.accept(builder);
+    StyleBuilder builder(pimpl_->stringTable, pimpl_->filters, pimpl_->cache, levelOfDetails, true);
+    visit(element, builder);
     return builder.canBuild();
 }
 
 Style StyleProvider::forElement(const Element& element, int levelOfDetails) const
 {
-    StyleBuilder builder(element.tags, pimpl_->stringTable, pimpl_->filters, levelOfDetails);
-    element.accept(builder);
-    return std::move(builder.style);
+    UTYMAP_STATISTICS_SCOPE(StyleMatching);
+    StyleBuilder builder(pimpl_->stringTable, pimpl_->filters, pimpl_->cache, levelOfDetails);
+    visit(element, builder);
+    return Style(element.tags, pimpl_->stringTable, std::move(builder.declarations));
+}
+
+LodStyles StyleProvider::forElement(const Element& element, const utymap::LodRange& range) const
+{
+    UTYMAP_STATISTICS_SCOPE(StyleMatching);
+    std::vector<MatchedFilters> matchedFilters;
+    matchedFilters.reserve(static_cast<std::size_t>(range.end - range.start + 1));
+    StyleBuilder builder(pimpl_->stringTable, pimpl_->filters, range, matchedFilters);
+    visit(element, builder);
+
+    LodStyles lodStyles;
+    lodStyles.indices.reserve(matchedFilters.size());
+    std::vector<const MatchedFilters*> distinctFilters;
+    for (const auto& filters : matchedFilters) {
+        if (filters.empty()) {
+            lodStyles.indices.push_back(-1);
+            continue;
+        }
+
+        auto distinct = std::find_if(distinctFilters.begin(), distinctFilters.end(),
+            [&](const MatchedFilters* other) { return *other == filters; });
+        if (distinct != distinctFilters.end()) {
+            lodStyles.indices.push_back(static_cast<int>(std::distance(distinctFilters.begin(), distinct)));
+            continue;
+        }
+
+        // merge declarations to style in the same order as for single level of details.
+        auto declarations = std::make_shared<Style::Declarations>();
+        for (const Filter* filter : filters) {
+            for (const auto& d : *filter->declarations)
+                Style::merge(*declarations, *d.second);
+        }
+        lodStyles.indices.push_back(static_cast<int>(distinctFilters.size()));
+        lodStyles.fingerprints.push_back(pimpl_->fingerprints.add(filters, declarations));
+        lodStyles.styles.push_back(Style(element.tags, pimpl_->stringTable, std::move(declarations)));
+        distinctFilters.push_back(&filters);
+    }
+
+    return lodStyles;
+}
+
+std::uint64_t StyleProvider::getFingerprintVersion() const
+{
+    return pimpl_->fingerprints.getVersion();
+}
+
+std::uint64_t StyleProvider::getStylesheetHash() const
+{
+    return pimpl_->stylesheetHash;
+}
+
+Style StyleProvider::forFingerprint(const Element& element, std::uint32_t fingerprint) const
+{
+    return Style(element.tags, pimpl_->stringTable, pimpl_->fingerprints.get(fingerprint));
 }
 
 Style StyleProvider::forCanvas(int levelOfDetails) const
 {
-    Style style({}, pimpl_->stringTable);
-    for (const auto &filter : pimpl_->filters.canvases[levelOfDetails]) {
-        for (const auto &declaration : filter.declarations) {
-            style.put(*declaration.second);
+    auto declarations = std::make_shared<Style::Declarations>();
+    const FilterMap& canvases = pimpl_->filters.canvases;
+    const FilterGroup* group = canvases.find(levelOfDetails);
+    if (group != nullptr) {
+        for (std::uint32_t index : group->filters) {
+            for (const auto &declaration : *canvases.filters[index].declarations) {
+                Style::merge(*declarations, *declaration.second);
+            }
         }
     }
-    return std::move(style);
+    return Style({}, pimpl_->stringTable, std::move(declarations));
+}
+
+std::vector<int> StyleProvider::reload(const StyleSheet& stylesheet)
+{
+    return pimpl_->reload(stylesheet);
 }
 
 const ColorGradient& StyleProvider::getGradient(const std::string& key) const
@@ -348,3 +1209,8 @@ const TextureGroup& StyleProvider::getTexture(const std::string& texture, const
 {
     return pimpl_->getTexture(texture, key);
 }
+
+std::size_t StyleProvider::getMemoryUsage() const
+{
+    return pimpl_->getMemoryUsage();
+}
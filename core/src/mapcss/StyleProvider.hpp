@@ -1,17 +1,55 @@
 #ifndef INDEX_STYLEPROVIDER_HPP_DEFINED
 #define INDEX_STYLEPROVIDER_HPP_DEFINED
 
+#include "LodRange.hpp"
 #include "index/StringTable.hpp"
 #include "entities/Element.hpp"
 #include "mapcss/ColorGradient.hpp"
 #include "mapcss/StyleSheet.hpp"
 #include "mapcss/Style.hpp"
 
+#include <cstdint>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace utymap { namespace mapcss {
 
+/// Contains styles of element for level of details range.
+struct LodStyles final
+{
+    /// Distinct styles: levels of details with the same matched filters share style.
+    std::vector<utymap::mapcss::Style> styles;
+    /// Style index for every level of details in range or -1 if element has no style there.
+    std::vector<int> indices;
+    /// Fingerprint of every distinct style which restores it by StyleProvider::forFingerprint.
+    std::vector<std::uint32_t> fingerprints;
+};
+
+/// Compiled rule declarations and gradients shared by style providers of related stylesheets,
+/// e.g. themes which differ only in some rules. Rules with the same declarations are compiled
+/// once, so provider keeps only its filters and rules which differ. Rules are owned by providers:
+/// they are released when the last provider which uses them is replaced or reloaded. Thread safe.
+class SharedStyleRules final
+{
+public:
+    /// Creates rules compiled with given string table: providers should use the same one.
+    explicit SharedStyleRules(utymap::index::StringTable&);
+
+    ~SharedStyleRules();
+
+    /// Returns amount of distinct compiled rule declarations.
+    std::size_t size() const;
+
+    /// Returns approximate amount of bytes used by shared declarations and gradients.
+    std::size_t getMemoryUsage() const;
+
+private:
+    friend class StyleProvider;
+    class SharedStyleRulesImpl;
+    std::unique_ptr<SharedStyleRulesImpl> pimpl_;
+};
+
 /// This class responsible for filtering elements.
 class StyleProvider final
 {
@@ -20,6 +58,12 @@ public:
     StyleProvider(const StyleSheet&, 
                   utymap::index::StringTable&);
 
+    /// Creates provider which takes compiled declarations and gradients from shared rules
+    /// adding ones of stylesheet which are not there yet.
+    StyleProvider(const StyleSheet&,
+                  utymap::index::StringTable&,
+                  const std::shared_ptr<SharedStyleRules>& sharedRules);
+
     ~StyleProvider();
     StyleProvider(StyleProvider&&);
 
@@ -33,15 +77,41 @@ public:
     /// Returns style for given element at given level of details.
     utymap::mapcss::Style forElement(const utymap::entities::Element&, int levelOfDetails) const;
 
+    /// Returns styles for given element at every level of details in range. Tags
+    /// are matched once per level of details and style is built once per distinct set
+    /// of matched filters.
+    LodStyles forElement(const utymap::entities::Element&, const utymap::LodRange& range) const;
+
+    /// Returns version of style fingerprints. It is unique for provider and changes when
+    /// stylesheet reload changes styles, so fingerprints of other versions are invalid.
+    std::uint64_t getFingerprintVersion() const;
+
+    /// Returns hash of rules of stylesheet used by provider. Unlike fingerprint version, it is
+    /// the same for the same rules in every process, so it can be persisted.
+    std::uint64_t getStylesheetHash() const;
+
+    /// Returns style of element with given fingerprint of current version without matching.
+    utymap::mapcss::Style forFingerprint(const utymap::entities::Element&, std::uint32_t fingerprint) const;
+
     /// Returns style for canvas at given level of details.
     utymap::mapcss::Style forCanvas(int levelOfDetails) const;
 
+    /// Rebuilds filters from updated stylesheet replacing only those level of details and element type
+    /// buckets which are changed. Returns sorted levels of details whose styles are changed.
+    /// NOTE should not be called concurrently with other methods. Styles created before call
+    /// may refer to replaced declarations. Textures are not reloaded.
+    std::vector<int> reload(const StyleSheet& stylesheet);
+
     /// Returns color gradient for given key.
     const ColorGradient& getGradient(const std::string& key) const;
 
     /// Returns texture group from given atlas using key.
     const TextureGroup& getTexture(const std::string& atlas, const std::string& key) const;
 
+    /// Returns approximate amount of bytes used by filters and cached styles. Shared rules are
+    /// not included.
+    std::size_t getMemoryUsage() const;
+
 private:
     class StyleProviderImpl;
     std::unique_ptr<StyleProviderImpl> pimpl_;
@@ -10,6 +10,8 @@
 
 namespace utymap { namespace mapcss {
 
+class CompiledStyleSheet;
+
 /// Represents a single texture region inside texture atlas.
 struct TextureRegion final
 {
@@ -41,6 +43,7 @@ struct TextureRegion final
     }
 
 private:
+    friend class CompiledStyleSheet;
     std::uint16_t atlasWidth_, atlasHeight_, x_, y_, width_, height_;
 };
 
@@ -66,6 +69,7 @@ struct TextureGroup final
     }
 
 private:
+    friend class CompiledStyleSheet;
     std::vector<TextureRegion> regions_;
 };
 
@@ -105,6 +109,7 @@ struct TextureAtlas final
     }
 
 private:
+    friend class CompiledStyleSheet;
     const std::string name_;
     Groups textureGroups_;
     TextureGroup emptyGroup_;
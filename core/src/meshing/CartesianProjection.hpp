@@ -0,0 +1,84 @@
+#ifndef MESHING_CARTESIANPROJECTION_HPP_DEFINED
+#define MESHING_CARTESIANPROJECTION_HPP_DEFINED
+
+#include "GeoCoordinate.hpp"
+#include "meshing/MeshTypes.hpp"
+#include "utils/MathUtils.hpp"
+
+#include <cmath>
+#include <vector>
+
+namespace utymap { namespace meshing {
+
+/// Projects geo coordinates to local metric plane which has origin at given point. Result
+/// matches cartesian projection of Unity side: x points to east, y is up and z points to north.
+class CartesianProjection final
+{
+public:
+    /// Length of equator in meters.
+    static constexpr double EquatorLength = 40075160;
+    /// Length of meridian circle in meters.
+    static constexpr double MeridianLength = 40008000;
+
+    /// Creates projection with given origin. Scale is applied to all axes of projected point.
+    CartesianProjection(const utymap::GeoCoordinate& origin, double scale) :
+        origin_(origin),
+        longitudeScale_(EquatorLength * std::cos(utymap::utils::deg2Rad(origin.latitude)) / 360 * scale),
+        latitudeScale_(MeridianLength / 360 * scale),
+        scale_(scale)
+    {
+    }
+
+    /// Projects mesh vertices writing interleaved x, y, z floats to result.
+    void project(const Mesh& mesh, std::vector<float>& result) const
+    {
+        result.resize(mesh.vertices.size());
+        for (std::size_t i = 0; i + 2 < mesh.vertices.size(); i += 3) {
+            result[i] = static_cast<float>((mesh.vertices[i] - origin_.longitude) * longitudeScale_);
+            result[i + 1] = static_cast<float>(mesh.vertices[i + 2] * scale_);
+            result[i + 2] = static_cast<float>((mesh.vertices[i + 1] - origin_.latitude) * latitudeScale_);
+        }
+    }
+
+    /// Calculates normals of projected vertices in the same way as Unity does: every normal is
+    /// sum of cross products of edges of triangles which use the vertex, so larger triangles
+    /// have more weight. Builders do not share vertices on sharp edges, so they stay sharp.
+    static void calculateNormals(const std::vector<float>& vertices, const std::vector<int>& triangles,
+                                 std::vector<float>& normals)
+    {
+        normals.assign(vertices.size(), 0);
+        for (std::size_t i = 0; i + 2 < triangles.size(); i += 3) {
+            const float* v0 = &vertices[triangles[i] * 3];
+            const float* v1 = &vertices[triangles[i + 1] * 3];
+            const float* v2 = &vertices[triangles[i + 2] * 3];
+            float ax = v1[0] - v0[0], ay = v1[1] - v0[1], az = v1[2] - v0[2];
+            float bx = v2[0] - v0[0], by = v2[1] - v0[1], bz = v2[2] - v0[2];
+            float nx = ay * bz - az * by, ny = az * bx - ax * bz, nz = ax * by - ay * bx;
+            for (std::size_t corner = 0; corner < 3; ++corner) {
+                float* normal = &normals[triangles[i + corner] * 3];
+                normal[0] += nx;
+                normal[1] += ny;
+                normal[2] += nz;
+            }
+        }
+
+        for (std::size_t i = 0; i + 2 < normals.size(); i += 3) {
+            float length = std::sqrt(normals[i] * normals[i] + normals[i + 1] * normals[i + 1] + normals[i + 2] * normals[i + 2]);
+            if (length > 0) {
+                normals[i] /= length;
+                normals[i + 1] /= length;
+                normals[i + 2] /= length;
+            }
+        }
+    }
+
+private:
+    const utymap::GeoCoordinate origin_;
+    const double longitudeScale_;
+    const double latitudeScale_;
+    const double scale_;
+};
+
+}}
+
+#endif // MESHING_CARTESIANPROJECTION_HPP_DEFINED
@@ -0,0 +1,211 @@
+#include "meshing/GlbWriter.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+using namespace utymap;
+using namespace utymap::meshing;
+
+namespace {
+    const std::uint32_t GlbMagic = 0x46546C67;
+    const std::uint32_t GlbVersion = 2;
+    const std::uint32_t JsonChunkType = 0x4E4F534A;
+    const std::uint32_t BinChunkType = 0x004E4942;
+
+    const int UnsignedByteType = 5121;
+    const int UnsignedIntType = 5125;
+    const int FloatType = 5126;
+    const int ArrayBufferTarget = 34962;
+    const int ElementArrayBufferTarget = 34963;
+
+    template <typename T>
+    void append(std::vector<char>& buffer, const T& value)
+    {
+        const char* data = reinterpret_cast<const char*>(&value);
+        buffer.insert(buffer.end(), data, data + sizeof(T));
+    }
+
+    template <typename T>
+    void writeValue(std::ostream& stream, const T& value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    /// Writes string as JSON string literal.
+    void writeString(std::ostream& stream, const std::string& value)
+    {
+        stream << '"';
+        for (char c : value) {
+            if (c == '"' || c == '\\')
+                stream << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20)
+                stream << ' ';
+            else
+                stream << c;
+        }
+        stream << '"';
+    }
+
+    /// Accessor and its buffer view.
+    struct Accessor final
+    {
+        std::size_t offset, length, count;
+        int componentType;
+        const char* type;
+        bool isNormalized;
+        int target;
+        /// Bounds of values which are required for positions only.
+        const float* min;
+        const float* max;
+    };
+}
+
+GlbWriter::GlbWriter(const GeoCoordinate& origin) :
+    projection_(origin, 1)
+{
+}
+
+void GlbWriter::add(const Mesh& mesh)
+{
+    std::size_t vertexCount = mesh.vertices.size() / 3;
+    if (vertexCount == 0 || mesh.triangles.empty())
+        return;
+
+    MeshEntry entry;
+    entry.name = mesh.name;
+    entry.vertexCount = vertexCount;
+    entry.indexCount = mesh.triangles.size() - mesh.triangles.size() % 3;
+    entry.hasColors = mesh.colors.size() == vertexCount;
+    entry.hasUvs = mesh.uvs.size() == vertexCount * 2;
+    std::fill(entry.min, entry.min + 3, std::numeric_limits<float>::max());
+    std::fill(entry.max, entry.max + 3, std::numeric_limits<float>::lowest());
+
+    // NOTE glTF is right handed: north is mapped to negative z and winding is reversed.
+    std::vector<float> positions;
+    projection_.project(mesh, positions);
+    entry.positionOffset = buffer_.size();
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        float value = i % 3 == 2 ? -positions[i] : positions[i];
+        entry.min[i % 3] = std::min(entry.min[i % 3], value);
+        entry.max[i % 3] = std::max(entry.max[i % 3], value);
+        append(buffer_, value);
+    }
+
+    entry.colorOffset = buffer_.size();
+    if (entry.hasColors) {
+        for (int color : mesh.colors) {
+            auto rgba = static_cast<std::uint32_t>(color);
+            for (int shift = 24; shift >= 0; shift -= 8)
+                append(buffer_, static_cast<std::uint8_t>(rgba >> shift));
+        }
+    }
+
+    // NOTE origin of texture coordinates is top left corner in glTF.
+    entry.uvOffset = buffer_.size();
+    if (entry.hasUvs) {
+        for (std::size_t i = 0; i < mesh.uvs.size(); i += 2) {
+            append(buffer_, static_cast<float>(mesh.uvs[i]));
+            append(buffer_, static_cast<float>(1 - mesh.uvs[i + 1]));
+        }
+    }
+
+    entry.indexOffset = buffer_.size();
+    for (std::size_t i = 0; i < entry.indexCount; i += 3) {
+        append(buffer_, static_cast<std::uint32_t>(mesh.triangles[i]));
+        append(buffer_, static_cast<std::uint32_t>(mesh.triangles[i + 2]));
+        append(buffer_, static_cast<std::uint32_t>(mesh.triangles[i + 1]));
+    }
+
+    meshes_.push_back(entry);
+}
+
+void GlbWriter::write(std::ostream& stream) const
+{
+    std::string json = getJson();
+    json.append((4 - json.size() % 4) % 4, ' ');
+    std::size_t binarySize = buffer_.size();
+
+    auto length = static_cast<std::uint32_t>(12 + 8 + json.size() + (binarySize > 0 ? 8 + binarySize : 0));
+    writeValue(stream, GlbMagic);
+    writeValue(stream, GlbVersion);
+    writeValue(stream, length);
+
+    writeValue(stream, static_cast<std::uint32_t>(json.size()));
+    writeValue(stream, JsonChunkType);
+    stream.write(json.data(), json.size());
+
+    if (binarySize > 0) {
+        writeValue(stream, static_cast<std::uint32_t>(binarySize));
+        writeValue(stream, BinChunkType);
+        stream.write(buffer_.data(), binarySize);
+    }
+}
+
+std::string GlbWriter::getJson() const
+{
+    std::vector<Accessor> accessors;
+    std::stringstream meshes, nodes;
+    for (std::size_t i = 0; i < meshes_.size(); ++i) {
+        const MeshEntry& entry = meshes_[i];
+        std::size_t position = accessors.size();
+        accessors.push_back(Accessor { entry.positionOffset, entry.vertexCount * 12, entry.vertexCount,
+                                       FloatType, "VEC3", false, ArrayBufferTarget, entry.min, entry.max });
+
+        meshes << (i == 0 ? "" : ",") << "{\"name\":";
+        writeString(meshes, entry.name);
+        meshes << ",\"primitives\":[{\"attributes\":{\"POSITION\":" << position;
+        if (entry.hasColors) {
+            meshes << ",\"COLOR_0\":" << accessors.size();
+            accessors.push_back(Accessor { entry.colorOffset, entry.vertexCount * 4, entry.vertexCount,
+                                           UnsignedByteType, "VEC4", true, ArrayBufferTarget, nullptr, nullptr });
+        }
+        if (entry.hasUvs) {
+            meshes << ",\"TEXCOORD_0\":" << accessors.size();
+            accessors.push_back(Accessor { entry.uvOffset, entry.vertexCount * 8, entry.vertexCount,
+                                           FloatType, "VEC2", false, ArrayBufferTarget, nullptr, nullptr });
+        }
+        meshes << "},\"indices\":" << accessors.size() << ",\"material\":0}]}";
+        accessors.push_back(Accessor { entry.indexOffset, entry.indexCount * 4, entry.indexCount,
+                                       UnsignedIntType, "SCALAR", false, ElementArrayBufferTarget, nullptr, nullptr });
+
+        nodes << (i == 0 ? "" : ",") << "{\"mesh\":" << i << ",\"name\":";
+        writeString(nodes, entry.name);
+        nodes << "}";
+    }
+
+    std::stringstream json;
+    json << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"utymap\"},\"scene\":0,\"scenes\":[{\"nodes\":[";
+    for (std::size_t i = 0; i < meshes_.size(); ++i)
+        json << (i == 0 ? "" : ",") << i;
+    json << "]}],\"nodes\":[" << nodes.str() << "]";
+    if (meshes_.empty()) {
+        json << "}";
+        return json.str();
+    }
+
+    json << ",\"meshes\":[" << meshes.str() << "]"
+         << ",\"materials\":[{\"pbrMetallicRoughness\":{\"baseColorFactor\":[1,1,1,1],"
+         << "\"metallicFactor\":0,\"roughnessFactor\":1}}]";
+
+    std::stringstream views, items;
+    items << std::setprecision(std::numeric_limits<float>::max_digits10);
+    for (std::size_t i = 0; i < accessors.size(); ++i) {
+        const Accessor& accessor = accessors[i];
+        views << (i == 0 ? "" : ",") << "{\"buffer\":0,\"byteOffset\":" << accessor.offset
+              << ",\"byteLength\":" << accessor.length << ",\"target\":" << accessor.target << "}";
+        items << (i == 0 ? "" : ",") << "{\"bufferView\":" << i << ",\"componentType\":" << accessor.componentType
+              << ",\"count\":" << accessor.count << ",\"type\":\"" << accessor.type << "\"";
+        if (accessor.isNormalized)
+            items << ",\"normalized\":true";
+        if (accessor.min != nullptr) {
+            items << ",\"min\":[" << accessor.min[0] << "," << accessor.min[1] << "," << accessor.min[2] << "]"
+                  << ",\"max\":[" << accessor.max[0] << "," << accessor.max[1] << "," << accessor.max[2] << "]";
+        }
+        items << "}";
+    }
+    json << ",\"accessors\":[" << items.str() << "],\"bufferViews\":[" << views.str() << "]"
+         << ",\"buffers\":[{\"byteLength\":" << buffer_.size() << "}]}";
+    return json.str();
+}
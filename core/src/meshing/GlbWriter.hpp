@@ -0,0 +1,54 @@
+#ifndef MESHING_GLBWRITER_HPP_DEFINED
+#define MESHING_GLBWRITER_HPP_DEFINED
+
+#include "GeoCoordinate.hpp"
+#include "meshing/CartesianProjection.hpp"
+#include "meshing/MeshTypes.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace utymap { namespace meshing {
+
+/// Collects meshes and writes them as binary glTF 2.0: every mesh is node with one primitive
+/// which has positions in meters relative to origin, vertex colors, texture coordinates if
+/// mesh has them and 32 bit indices. All primitives share single material which uses vertex
+/// colors, so colors of gradients are kept.
+class GlbWriter final
+{
+public:
+    /// Creates writer which places origin of scene at given coordinate.
+    explicit GlbWriter(const utymap::GeoCoordinate& origin);
+
+    /// Adds copy of mesh data. Empty meshes are skipped.
+    void add(const Mesh& mesh);
+
+    /// Returns amount of added meshes.
+    std::size_t size() const { return meshes_.size(); }
+
+    /// Writes binary glTF with all added meshes.
+    void write(std::ostream& stream) const;
+
+private:
+    /// Location of mesh data in binary buffer.
+    struct MeshEntry final
+    {
+        std::string name;
+        std::size_t vertexCount, indexCount;
+        std::size_t positionOffset, colorOffset, uvOffset, indexOffset;
+        float min[3], max[3];
+        bool hasColors, hasUvs;
+    };
+
+    std::string getJson() const;
+
+    const CartesianProjection projection_;
+    std::vector<MeshEntry> meshes_;
+    std::vector<char> buffer_;
+};
+
+}}
+
+#endif // MESHING_GLBWRITER_HPP_DEFINED
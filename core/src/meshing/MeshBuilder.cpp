@@ -6,23 +6,295 @@
 #include "triangle/triangle.h"
 #include "utils/CoreUtils.hpp"
 #include "utils/GeoUtils.hpp"
+#include "utils/GeometryUtils.hpp"
 #include "utils/GradientUtils.hpp"
+#include "utils/NoiseUtils.hpp"
+#include "utils/Statistics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <vector>
 
 using namespace utymap::heightmap;
 using namespace utymap::meshing;
 using namespace utymap::utils;
 
+namespace {
+
+/// Keeps memory blocks released by triangulation on calling thread, so subsequent triangulation
+/// calls reuse buffers and memory pools of previous ones instead of going to allocator.
+class TriangulationWorkspace final
+{
+    /// Blocks are cached in power of two size classes in range [2^MinClass, 2^MaxClass].
+    static const int MinClass = 6;
+    static const int MaxClass = 22;
+    /// Max amount of bytes kept in cache. Released blocks which do not fit are freed.
+    static const std::size_t MaxCachedBytes = 16 * 1024 * 1024;
+    /// Size of block header which stores size class. Keeps malloc alignment of returned memory.
+    static const std::size_t HeaderSize = 16;
+
+public:
+    /// Returns workspace of calling thread.
+    static TriangulationWorkspace& current()
+    {
+        static thread_local TriangulationWorkspace workspace;
+        return workspace;
+    }
+
+    TriangulationWorkspace() : cachedBytes_(0) {}
+
+    TriangulationWorkspace(const TriangulationWorkspace&) = delete;
+    TriangulationWorkspace& operator=(const TriangulationWorkspace&) = delete;
+
+    ~TriangulationWorkspace()
+    {
+        for (auto& blocks : freeBlocks_) {
+            for (char* block : blocks)
+                std::free(block);
+        }
+    }
+
+    void* allocate(std::size_t size)
+    {
+        int sizeClass = getClass(size);
+        char* block = nullptr;
+        if (sizeClass <= MaxClass) {
+            auto& blocks = freeBlocks_[sizeClass - MinClass];
+            if (!blocks.empty()) {
+                block = blocks.back();
+                blocks.pop_back();
+                cachedBytes_ -= std::size_t(1) << sizeClass;
+            }
+            else
+                block = static_cast<char*>(std::malloc(HeaderSize + (std::size_t(1) << sizeClass)));
+        }
+        else
+            block = static_cast<char*>(std::malloc(HeaderSize + size));
+
+        if (block == nullptr)
+            return nullptr;
+
+        *reinterpret_cast<int*>(block) = sizeClass;
+        return block + HeaderSize;
+    }
+
+    void release(void* memory)
+    {
+        if (memory == nullptr)
+            return;
+
+        char* block = static_cast<char*>(memory) - HeaderSize;
+        int sizeClass = *reinterpret_cast<int*>(block);
+        std::size_t classSize = std::size_t(1) << sizeClass;
+        if (sizeClass > MaxClass || cachedBytes_ + classSize > MaxCachedBytes) {
+            std::free(block);
+            return;
+        }
+
+        freeBlocks_[sizeClass - MinClass].push_back(block);
+        cachedBytes_ += classSize;
+    }
+
+    /// Buffer for max triangle areas used by refinement.
+    std::vector<REAL> areas;
+    /// Buffer for triangles of simple polygons.
+    std::vector<int> triangles;
+
+private:
+    static int getClass(std::size_t size)
+    {
+        int sizeClass = MinClass;
+        while ((std::size_t(1) << sizeClass) < size && sizeClass <= MaxClass)
+            ++sizeClass;
+        return sizeClass;
+    }
+
+    std::vector<char*> freeBlocks_[MaxClass - MinClass + 1];
+    std::size_t cachedBytes_;
+};
+
+/// Ratio between amount of triangles produced by quality refinement and polygon area divided by max area.
+/// Refined triangles are smaller than max area, so estimate is conservative.
+const double RefinementRatio = 2;
+
+/// Returns area of triangulated polygon.
+double getArea(const triangulateio& io)
+{
+    double area = 0;
+    for (int i = 0; i < io.numberoftriangles; ++i) {
+        const int* corners = io.trianglelist + i * io.numberofcorners;
+        const REAL* a = io.pointlist + corners[0] * 2;
+        const REAL* b = io.pointlist + corners[1] * 2;
+        const REAL* c = io.pointlist + corners[2] * 2;
+        area += std::abs((b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1])) / 2;
+    }
+    return area;
+}
+
+/// Max amount of points in polygon which is triangulated by ear clipping.
+const std::size_t MaxSimplePolygonSize = 32;
+
+int* allocateTriangleMemory(int size)
+{
+    return static_cast<int*>(TriangulationWorkspace::current().allocate(static_cast<std::size_t>(size)));
+}
+
+void releaseTriangleMemory(int* memory)
+{
+    TriangulationWorkspace::current().release(memory);
+}
+
+/// Makes triangle library to use workspace of calling thread for all its allocations.
+void installTriangleAllocator()
+{
+    static const bool isInstalled = (::trisetallocator(allocateTriangleMemory, releaseTriangleMemory), true);
+    (void) isInstalled;
+}
+
+/// Maps geo coordinates of tile to texture atlas region.
+class TextureMapper final
+{
+public:
+    TextureMapper(const utymap::BoundingBox& bbox, const MeshBuilder::AppearanceOptions& appearanceOptions) :
+        geoX_(bbox.minPoint.longitude), geoY_(bbox.minPoint.latitude),
+        geoWidth_(bbox.maxPoint.longitude - bbox.minPoint.longitude),
+        geoHeight_(bbox.maxPoint.latitude - bbox.minPoint.latitude),
+        scale_(appearanceOptions.textureScale), region_(appearanceOptions.textureRegion)
+    {
+    }
+
+    Vector2 map(double x, double y) const
+    {
+        return region_.map(Vector2((x - geoX_) / geoWidth_ * scale_, (y - geoY_) / geoHeight_ * scale_));
+    }
+
+private:
+    const double geoX_, geoY_, geoWidth_, geoHeight_, scale_;
+    const utymap::mapcss::TextureRegion region_;
+};
+
+/// Writes triangulation result to mesh. Features are template arguments, so loops have no
+/// per vertex branches or indirect calls.
+struct MeshFiller final
+{
+    const triangulateio& io;
+    Mesh& mesh;
+    const MeshBuilder::GeometryOptions& geometryOptions;
+    const MeshBuilder::AppearanceOptions& appearanceOptions;
+    const TextureMapper& mapper;
+    const double* elevations;
+    const double* eleNoise;
+    const double* colorNoise;
+
+    template <bool HasElevation, bool HasNoise, bool HasTexture, bool IsFlipped>
+    void fill() const
+    {
+        auto pointCount = static_cast<std::size_t>(io.numberofpoints);
+        auto triangleCount = static_cast<std::size_t>(io.numberoftriangles);
+        std::size_t startIndex = mesh.vertices.size() / 3;
+        std::size_t triStart = mesh.triangles.size();
+
+        mesh.vertices.resize((startIndex + pointCount) * 3);
+        mesh.colors.resize(startIndex + pointCount);
+        mesh.uvs.resize((startIndex + pointCount) * 2);
+        mesh.triangles.resize(triStart + triangleCount * 3);
+
+        double* vertices = mesh.vertices.data() + startIndex * 3;
+        int* colors = mesh.colors.data() + startIndex;
+        double* uvs = mesh.uvs.data() + startIndex * 2;
+        const double* points = io.pointlist;
+        const int* markers = io.pointmarkerlist;
+        double heightOffset = geometryOptions.heightOffset;
+        double elevation = geometryOptions.elevation;
+
+        for (std::size_t i = 0; i < pointCount; ++i) {
+            double x = points[i * 2];
+            double y = points[i * 2 + 1];
+            double ele = heightOffset + (HasElevation ? elevation : elevations[i]);
+            // do no apply noise on boundaries
+            if (HasNoise)
+                ele += markers[i] != 1 ? eleNoise[i] : 0;
+
+            vertices[i * 3] = x;
+            vertices[i * 3 + 1] = y;
+            vertices[i * 3 + 2] = ele;
+            colors[i] = static_cast<int>(appearanceOptions.gradient.lookup((colorNoise[i] + 1) / 2));
+
+            const Vector2 uv = HasTexture ? mapper.map(x, y) : Vector2();
+            uvs[i * 2] = uv.x;
+            uvs[i * 2 + 1] = uv.y;
+        }
+
+        const int first = IsFlipped ? 2 : 1;
+        const int third = IsFlipped ? 1 : 2;
+        const int* corners = io.trianglelist;
+        auto cornerCount = static_cast<std::size_t>(io.numberofcorners);
+        auto offset = static_cast<int>(startIndex);
+        int* triangles = mesh.triangles.data() + triStart;
+        for (std::size_t i = 0; i < triangleCount; ++i) {
+            triangles[i * 3] = offset + corners[i * cornerCount + first];
+            triangles[i * 3 + 1] = offset + corners[i * cornerCount];
+            triangles[i * 3 + 2] = offset + corners[i * cornerCount + third];
+        }
+    }
+};
+
+/// Converts runtime flags to template arguments of filler one by one, so dispatch happens
+/// once per polygon.
+template <bool... Flags>
+struct FillDispatcher final
+{
+    static void dispatch(const MeshFiller& filler)
+    {
+        filler.fill<Flags...>();
+    }
+
+    template <typename... Rest>
+    static void dispatch(const MeshFiller& filler, bool flag, Rest... rest)
+    {
+        if (flag)
+            FillDispatcher<Flags..., true>::dispatch(filler, rest...);
+        else
+            FillDispatcher<Flags..., false>::dispatch(filler, rest...);
+    }
+};
+
+}
+
 class MeshBuilder::MeshBuilderImpl
 {
 public:
 
-    MeshBuilderImpl(const utymap::QuadKey& quadKey, const ElevationProvider& eleProvider) :
-        bbox(GeoUtils::quadKeyToBoundingBox(quadKey)), eleProvider_(eleProvider)
+    MeshBuilderImpl(const utymap::QuadKey& quadKey, const ElevationProvider& eleProvider, const TriangleBudget& budget) :
+        bbox(GeoUtils::quadKeyToBoundingBox(quadKey)), eleProvider_(eleProvider), budget_(budget),
+        polygons_(0), triangles_(0), relaxedPolygons_(0)
     {
+        installTriangleAllocator();
     }
      
     void addPolygon(Mesh& mesh, Polygon& polygon, const GeometryOptions& geometryOptions, const AppearanceOptions& appearanceOptions) const
     {
+        polygons_.fetch_add(1, std::memory_order_relaxed);
+        std::size_t triangleCount = mesh.triangles.size();
+        addTriangulatedPolygon(mesh, polygon, geometryOptions, appearanceOptions);
+        triangles_.fetch_add((mesh.triangles.size() - triangleCount) / 3, std::memory_order_relaxed);
+    }
+
+    TriangulationStatistics getStatistics() const
+    {
+        return TriangulationStatistics {
+            polygons_.load(std::memory_order_relaxed),
+            triangles_.load(std::memory_order_relaxed),
+            relaxedPolygons_.load(std::memory_order_relaxed)
+        };
+    }
+
+    void addTriangulatedPolygon(Mesh& mesh, Polygon& polygon, const GeometryOptions& geometryOptions, const AppearanceOptions& appearanceOptions) const
+    {
+        if (addSimplePolygon(mesh, polygon, geometryOptions, appearanceOptions))
+            return;
+
         triangulateio in, mid;
 
         in.numberofpoints = static_cast<int>(polygon.points.size() / 2);
@@ -42,20 +314,19 @@ public:
         mid.trianglelist = nullptr;
         mid.segmentlist = nullptr;
         mid.segmentmarkerlist = nullptr;
+        mid.trianglearealist = nullptr;
 
         ::triangulate(const_cast<char*>("pzBQ"), &in, &mid, nullptr);
 
-        // do not refine mesh if area is not set.
-        if (std::abs(geometryOptions.area) < std::numeric_limits<double>::epsilon()) {
+        // do not refine mesh if area is not set or budget is already spent.
+        double maxArea = getRefinementArea(mid, geometryOptions.area);
+        if (maxArea < std::numeric_limits<double>::epsilon()) {
             fillMesh(&mid, mesh, geometryOptions, appearanceOptions);
-            mid.trianglearealist = nullptr;
         }
         else {
-
-            mid.trianglearealist = static_cast<REAL *>(malloc(mid.numberoftriangles * sizeof(REAL)));
-            for (int i = 0; i < mid.numberoftriangles; ++i) {
-                mid.trianglearealist[i] = geometryOptions.area;
-            }
+            auto& areas = TriangulationWorkspace::current().areas;
+            areas.assign(static_cast<std::size_t>(mid.numberoftriangles), maxArea);
+            mid.trianglearealist = areas.data();
 
             triangulateio out;
             out.pointlist = nullptr;
@@ -72,21 +343,19 @@ public:
 
             fillMesh(&out, mesh, geometryOptions, appearanceOptions);
 
-            free(out.pointlist);
-            free(out.pointattributelist);
-            free(out.trianglelist);
-            free(out.triangleattributelist);
-            free(out.pointmarkerlist);
+            ::trifree(reinterpret_cast<int*>(out.pointlist));
+            ::trifree(reinterpret_cast<int*>(out.pointattributelist));
+            ::trifree(out.trianglelist);
+            ::trifree(reinterpret_cast<int*>(out.triangleattributelist));
+            ::trifree(out.pointmarkerlist);
         }
 
-        free(in.pointmarkerlist);
-
-        free(mid.pointlist);
-        free(mid.pointmarkerlist);
-        free(mid.trianglelist);
-        free(mid.trianglearealist);
-        free(mid.segmentlist);
-        free(mid.segmentmarkerlist);
+        // NOTE lists allocated by triangle should be released by it as it uses workspace.
+        ::trifree(reinterpret_cast<int*>(mid.pointlist));
+        ::trifree(mid.pointmarkerlist);
+        ::trifree(mid.trianglelist);
+        ::trifree(mid.segmentlist);
+        ::trifree(mid.segmentmarkerlist);
     }
 
     void addPlane(Mesh& mesh, const Vector2& p1, const Vector2& p2, const GeometryOptions& geometryOptions, const AppearanceOptions& appearanceOptions) const
@@ -102,22 +371,137 @@ public:
 
     void addPlane(Mesh& mesh, const Vector2& p1, const Vector2& p2, double ele1, double ele2, const GeometryOptions& geometryOptions, const AppearanceOptions& appearanceOptions) const
     {
-        auto color = appearanceOptions.gradient.evaluate((NoiseUtils::perlin2D(p1.x, p1.y, appearanceOptions.colorNoiseFreq) + 1) / 2);
+        int color = static_cast<int>(appearanceOptions.gradient.lookup((NoiseUtils::perlin2D(p1.x, p1.y, appearanceOptions.colorNoiseFreq) + 1) / 2));
+
+        // NOTE texture is repeated along wall: texture scale is size of texture region in meters.
+        Vector2 uv1, uv2, uv3, uv4;
+        if (!appearanceOptions.textureRegion.isEmpty()) {
+            double scale = appearanceOptions.textureScale > 0 ? appearanceOptions.textureScale : 1;
+            double length = GeoUtils::distance(utymap::GeoCoordinate(p1.y, p1.x), utymap::GeoCoordinate(p2.y, p2.x)) / scale;
+            double height = geometryOptions.heightOffset / scale;
+            const auto& region = appearanceOptions.textureRegion;
+            uv1 = region.map(Vector2(0, 0));
+            uv2 = region.map(Vector2(length, 0));
+            uv3 = region.map(Vector2(length, height));
+            uv4 = region.map(Vector2(0, height));
+        }
+
+        if (mesh.isIndexed) {
+            int v1 = addIndexedVertex(mesh, p1, ele1, color, uv1);
+            int v2 = addIndexedVertex(mesh, p2, ele2, color, uv2);
+            int v3 = addIndexedVertex(mesh, p2, ele2 + geometryOptions.heightOffset, color, uv3);
+            int v4 = addIndexedVertex(mesh, p1, ele1 + geometryOptions.heightOffset, color, uv4);
+            addTriangle(mesh, v1, v3, v2);
+            addTriangle(mesh, v4, v3, v1);
+            return;
+        }
+
         int index = static_cast<int>(mesh.vertices.size() / 3);
 
-        addVertex(mesh, p1, ele1, color, index);
-        addVertex(mesh, p2, ele2, color, index + 2);
-        addVertex(mesh, p2, ele2 + geometryOptions.heightOffset, color, index + 1);
+        addVertex(mesh, p1, ele1, color, uv1, index);
+        addVertex(mesh, p2, ele2, color, uv2, index + 2);
+        addVertex(mesh, p2, ele2 + geometryOptions.heightOffset, color, uv3, index + 1);
         index += 3;
 
-        addVertex(mesh, p1, ele1 + geometryOptions.heightOffset, color, index);
-        addVertex(mesh, p1, ele1, color, index + 2);
-        addVertex(mesh, p2, ele2 + geometryOptions.heightOffset, color, index + 1);
+        addVertex(mesh, p1, ele1 + geometryOptions.heightOffset, color, uv4, index);
+        addVertex(mesh, p1, ele1, color, uv1, index + 2);
+        addVertex(mesh, p2, ele2 + geometryOptions.heightOffset, color, uv3, index + 1);
+    }
+
+    void addWalls(Mesh& mesh, const std::vector<Vector2>& ring, const GeometryOptions& geometryOptions,
+                  const AppearanceOptions& appearanceOptions, const EdgeFilter& filter) const
+    {
+        std::size_t count = ring.size();
+        if (count < 2)
+            return;
+
+        // sample all ring points at once
+        auto& points = getBuffer(PointBuffer, count * 2);
+        for (std::size_t i = 0; i < count; ++i) {
+            points[i * 2] = ring[i].x;
+            points[i * 2 + 1] = ring[i].y;
+        }
+        auto& elevations = getBuffer(ElevationBuffer, count);
+        auto& eleNoise = getBuffer(EleNoiseBuffer, count);
+        auto& colorNoise = getBuffer(ColorNoiseBuffer, count);
+        eleProvider_.getElevations(points.data(), count, elevations.data());
+        NoiseUtils::perlin2D(points.data(), count, geometryOptions.eleNoiseFreq, eleNoise.data());
+        NoiseUtils::perlin2D(points.data(), count, appearanceOptions.colorNoiseFreq, colorNoise.data());
+
+        // NOTE texture is repeated along walls: u is distance from ring start in texture scales.
+        bool hasTexture = !appearanceOptions.textureRegion.isEmpty();
+        double scale = appearanceOptions.textureScale > 0 ? appearanceOptions.textureScale : 1;
+        double height = geometryOptions.heightOffset / scale;
+        const auto& region = appearanceOptions.textureRegion;
+
+        mesh.vertices.reserve(mesh.vertices.size() + (count + 1) * 6);
+        mesh.colors.reserve(mesh.colors.size() + (count + 1) * 2);
+        mesh.uvs.reserve(mesh.uvs.size() + (count + 1) * 4);
+        mesh.triangles.reserve(mesh.triangles.size() + count * 6);
+
+        // adds bottom and top vertices of point returning index of bottom one.
+        auto addColumn = [&](std::size_t i, double u) {
+            double ele = elevations[i] + eleNoise[i];
+            int color = static_cast<int>(appearanceOptions.gradient.lookup((colorNoise[i] + 1) / 2));
+            Vector2 bottomUv = hasTexture ? region.map(Vector2(u, 0)) : Vector2();
+            Vector2 topUv = hasTexture ? region.map(Vector2(u, height)) : Vector2();
+            if (mesh.isIndexed) {
+                int bottom = addIndexedVertex(mesh, ring[i], ele, color, bottomUv);
+                int top = addIndexedVertex(mesh, ring[i], ele + geometryOptions.heightOffset, color, topUv);
+                return std::make_pair(bottom, top);
+            }
+            int bottom = static_cast<int>(mesh.vertices.size() / 3);
+            mesh.vertices.insert(mesh.vertices.end(), { ring[i].x, ring[i].y, ele,
+                                                        ring[i].x, ring[i].y, ele + geometryOptions.heightOffset });
+            mesh.colors.insert(mesh.colors.end(), { color, color });
+            mesh.uvs.insert(mesh.uvs.end(), { bottomUv.x, bottomUv.y, topUv.x, topUv.y });
+            return std::make_pair(bottom, bottom + 1);
+        };
+
+        double u = 0;
+        bool hasColumn = false;
+        std::pair<int, int> column, firstColumn(-1, -1);
+        for (std::size_t i = 0; i < count; ++i) {
+            std::size_t next = i == count - 1 ? 0 : i + 1;
+            const Vector2& p1 = ring[i];
+            const Vector2& p2 = ring[next];
+            if (filter && !filter(p1, p2)) {
+                hasColumn = false;
+                continue;
+            }
+
+            if (!hasColumn)
+                column = addColumn(i, u);
+            if (i == 0)
+                firstColumn = column;
+            if (hasTexture)
+                u += GeoUtils::distance(utymap::GeoCoordinate(p1.y, p1.x), utymap::GeoCoordinate(p2.y, p2.x)) / scale;
+
+            // NOTE closing column is shared only without texture as it has different u.
+            auto nextColumn = next == 0 && firstColumn.first >= 0 && !hasTexture
+                ? firstColumn
+                : addColumn(next, u);
+            addTriangle(mesh, column.first, nextColumn.second, nextColumn.first);
+            addTriangle(mesh, column.second, nextColumn.second, column.first);
+            column = nextColumn;
+            hasColumn = true;
+        }
     }
 
     void addTriangle(Mesh& mesh, const Vector3& v0, const Vector3& v1, const Vector3& v2, const GeometryOptions& geometryOptions, const AppearanceOptions& apperanceOptions) const
     {
-        auto color = apperanceOptions.gradient.evaluate((NoiseUtils::perlin2D(v0.x, v0.z, apperanceOptions.colorNoiseFreq) + 1) / 2);
+        int color = static_cast<int>(apperanceOptions.gradient.lookup((NoiseUtils::perlin2D(v0.x, v0.z, apperanceOptions.colorNoiseFreq) + 1) / 2));
+
+        if (mesh.isIndexed) {
+            int i0 = addIndexedVertex(mesh, Vector2(v0.x, v0.z), v0.y, color);
+            int i1 = addIndexedVertex(mesh, Vector2(v1.x, v1.z), v1.y, color);
+            int i2 = addIndexedVertex(mesh, Vector2(v2.x, v2.z), v2.y, color);
+            addTriangle(mesh, i0, i1, i2);
+            if (geometryOptions.hasBackSide)
+                addTriangle(mesh, i2, i1, i0);
+            return;
+        }
+
         int startIndex = static_cast<int>(mesh.vertices.size() / 3);
 
         addVertex(mesh, v0, color, startIndex);
@@ -134,16 +518,68 @@ public:
 
 private:
 
+    /// Returns max triangle area used by refinement of triangulated polygon: requested area is
+    /// increased when estimated amount of triangles exceeds polygon or remaining tile budget.
+    /// Zero means that polygon should not be refined.
+    double getRefinementArea(const triangulateio& io, double area) const
+    {
+        if (std::abs(area) < std::numeric_limits<double>::epsilon())
+            return 0;
+
+        std::size_t used = triangles_.load(std::memory_order_relaxed);
+        std::size_t remaining = used < budget_.perTile ? budget_.perTile - used : 0;
+        std::size_t budget = std::min(budget_.perPolygon, remaining);
+        if (budget <= static_cast<std::size_t>(io.numberoftriangles)) {
+            relaxedPolygons_.fetch_add(1, std::memory_order_relaxed);
+            return 0;
+        }
+
+        double polygonArea = getArea(io);
+        if (polygonArea / area * RefinementRatio <= budget)
+            return area;
+
+        relaxedPolygons_.fetch_add(1, std::memory_order_relaxed);
+        return polygonArea * RefinementRatio / budget;
+    }
+
+    /// Triangulates small polygons without holes which do not need refinement by ear clipping
+    /// instead of constrained Delaunay triangulation. Returns false if polygon is not suitable.
+    bool addSimplePolygon(Mesh& mesh, Polygon& polygon, const GeometryOptions& geometryOptions, const AppearanceOptions& appearanceOptions) const
+    {
+        if (std::abs(geometryOptions.area) >= std::numeric_limits<double>::epsilon() ||
+            polygon.outers.size() != 1 || !polygon.inners.empty() || !polygon.holes.empty() ||
+            polygon.points.size() / 2 > MaxSimplePolygonSize)
+            return false;
+
+        auto& triangles = TriangulationWorkspace::current().triangles;
+        if (!utymap::utils::triangulateSimplePolygon(polygon.points, triangles))
+            return false;
+
+        // NOTE the same as output of triangle without boundary markers.
+        triangulateio io;
+        io.pointlist = polygon.points.data();
+        io.pointmarkerlist = nullptr;
+        io.numberofpoints = static_cast<int>(polygon.points.size() / 2);
+        io.trianglelist = triangles.data();
+        io.numberoftriangles = static_cast<int>(triangles.size() / 3);
+        io.numberofcorners = 3;
+        fillMesh(&io, mesh, geometryOptions, appearanceOptions);
+        return true;
+    }
+
     static void addVertex(Mesh& mesh, const Vector2& p, double ele, int color, int triIndex)
+    {
+        addVertex(mesh, p, ele, color, Vector2(), triIndex);
+    }
+
+    static void addVertex(Mesh& mesh, const Vector2& p, double ele, int color, const Vector2& uv, int triIndex)
     {
         mesh.vertices.push_back(p.x);
         mesh.vertices.push_back(p.y);
         mesh.vertices.push_back(ele);
         mesh.colors.push_back(color);
-        
-        // TODO
-        mesh.uvs.push_back(0);
-        mesh.uvs.push_back(0);
+        mesh.uvs.push_back(uv.x);
+        mesh.uvs.push_back(uv.y);
 
         mesh.triangles.push_back(triIndex);
     }
@@ -153,93 +589,87 @@ private:
         addVertex(mesh, Vector2(vertex.x, vertex.z), vertex.y, color, triIndex);
     }
 
-    void fillMesh(triangulateio* io, Mesh& mesh, const GeometryOptions& geometryOptions, const AppearanceOptions& appearanceOptions) const
+    /// Returns index of vertex with the same attributes or adds new one.
+    static int addIndexedVertex(Mesh& mesh, const Vector2& p, double ele, int color, const Vector2& uv = Vector2())
     {
-        int triStartIndex = static_cast<int>(mesh.vertices.size() / 3);
-
-        // prepare texture data
-        const auto map = createMapFunc(appearanceOptions);
-
-        ensureMeshCapacity(mesh, static_cast<std::size_t>(io->numberofpoints), 
-            static_cast<std::size_t>(io->numberoftriangles));
-
-        for (int i = 0; i < io->numberofpoints; i++) {
-            // get coordinates
-            double x = io->pointlist[i * 2 + 0];
-            double y = io->pointlist[i * 2 + 1];
-            double ele = geometryOptions.heightOffset + (geometryOptions.elevation > std::numeric_limits<double>::lowest()
-                ? geometryOptions.elevation
-                : eleProvider_.getElevation(y, x));
-
-            // do no apply noise on boundaries
-            if (io->pointmarkerlist != nullptr && io->pointmarkerlist[i] != 1)
-                ele += NoiseUtils::perlin2D(x, y, geometryOptions.eleNoiseFreq);
-
-            // set vertices
-            mesh.vertices.push_back(x);
-            mesh.vertices.push_back(y);
-            mesh.vertices.push_back(ele);
-
-            // set colors
-            int color = GradientUtils::getColor(appearanceOptions.gradient, x, y, appearanceOptions.colorNoiseFreq);
-            mesh.colors.push_back(color);
-
-            // set textures
-            const auto uv = map(x, y);
-            mesh.uvs.push_back(uv.x);
-            mesh.uvs.push_back(uv.y);
+        std::size_t hash = std::hash<double>()(p.x);
+        for (std::size_t value : { std::hash<double>()(p.y), std::hash<double>()(ele), std::hash<int>()(color),
+                                   std::hash<double>()(uv.x), std::hash<double>()(uv.y) })
+            hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+
+        auto& candidates = mesh.vertexIndex[hash];
+        for (int index : candidates) {
+            if (mesh.vertices[index * 3] == p.x && mesh.vertices[index * 3 + 1] == p.y &&
+                mesh.vertices[index * 3 + 2] == ele && mesh.colors[index] == color &&
+                mesh.uvs[index * 2] == uv.x && mesh.uvs[index * 2 + 1] == uv.y)
+                return index;
         }
 
-        // set triangles
-        int first = geometryOptions.flipSide ? 2 : 1;
-        int second = 0;
-        int third = geometryOptions.flipSide ? 1 : 2;
-
-        for (std::size_t i = 0; i < io->numberoftriangles; i++) {
-            mesh.triangles.push_back(triStartIndex + io->trianglelist[i * io->numberofcorners + first]);
-            mesh.triangles.push_back(triStartIndex + io->trianglelist[i * io->numberofcorners + second]);
-            mesh.triangles.push_back(triStartIndex + io->trianglelist[i * io->numberofcorners + third]);
-          }
+        int index = static_cast<int>(mesh.vertices.size() / 3);
+        mesh.vertices.push_back(p.x);
+        mesh.vertices.push_back(p.y);
+        mesh.vertices.push_back(ele);
+        mesh.colors.push_back(color);
+        mesh.uvs.push_back(uv.x);
+        mesh.uvs.push_back(uv.y);
+        candidates.push_back(index);
+        return index;
     }
 
-    /// Creates texture mapping function.
-    std::function<Vector2(double, double)> createMapFunc(const AppearanceOptions& appearanceOptions) const
+    static void addTriangle(Mesh& mesh, int v0, int v1, int v2)
     {
-        if (appearanceOptions.textureRegion.isEmpty()) {
-            return [](double x, double y) {
-                return Vector2(0, 0);
-            };
-        }
-
-        double geoHeight = bbox.maxPoint.latitude - bbox.minPoint.latitude;
-        double geoWidth = bbox.maxPoint.longitude - bbox.minPoint.longitude;
-        double geoX = bbox.minPoint.longitude;
-        double geoY = bbox.minPoint.latitude;
-
-        auto region = appearanceOptions.textureRegion;
-        auto scale = appearanceOptions.textureScale;
+        mesh.triangles.push_back(v0);
+        mesh.triangles.push_back(v1);
+        mesh.triangles.push_back(v2);
+    }
 
-        return [=](double x, double y) {
-            double relX = (x - geoX) / geoWidth * scale;
-            double relY = (y - geoY) / geoHeight * scale;
-            return region.map(Vector2(relX, relY));
-        };
+    void fillMesh(triangulateio* io, Mesh& mesh, const GeometryOptions& geometryOptions, const AppearanceOptions& appearanceOptions) const
+    {
+        // calculate noise for all points at once
+        auto pointCount = static_cast<std::size_t>(io->numberofpoints);
+        bool hasNoise = io->pointmarkerlist != nullptr && geometryOptions.eleNoiseFreq >= 1E-5;
+        auto& eleNoise = getBuffer(EleNoiseBuffer, hasNoise ? pointCount : 0);
+        auto& colorNoise = getBuffer(ColorNoiseBuffer, pointCount);
+        if (hasNoise)
+            NoiseUtils::perlin2D(io->pointlist, pointCount, geometryOptions.eleNoiseFreq, eleNoise.data());
+        NoiseUtils::perlin2D(io->pointlist, pointCount, appearanceOptions.colorNoiseFreq, colorNoise.data());
+
+        bool hasElevation = geometryOptions.elevation > std::numeric_limits<double>::lowest();
+        auto& elevations = getBuffer(ElevationBuffer, hasElevation ? 0 : pointCount);
+        if (!hasElevation)
+            eleProvider_.getElevations(io->pointlist, pointCount, elevations.data());
+
+        bool hasTexture = !appearanceOptions.textureRegion.isEmpty();
+        TextureMapper mapper(bbox, appearanceOptions);
+        MeshFiller filler { *io, mesh, geometryOptions, appearanceOptions, mapper,
+                            elevations.data(), eleNoise.data(), colorNoise.data() };
+        FillDispatcher<>::dispatch(filler, hasElevation, hasNoise, hasTexture, geometryOptions.flipSide);
     }
 
-    static void ensureMeshCapacity(Mesh& mesh, std::size_t pointCount, std::size_t triCount)
+    /// Slots of thread local scratch buffers.
+    enum BufferSlot { EleNoiseBuffer, ColorNoiseBuffer, ElevationBuffer, PointBuffer, BufferCount };
+
+    /// Returns thread local buffer of given slot which has at least given size.
+    static std::vector<double>& getBuffer(BufferSlot slot, std::size_t size)
     {
-        mesh.vertices.reserve(mesh.vertices.size() + pointCount * 3 / 2);
-        mesh.triangles.reserve(mesh.triangles.size() + triCount * 3);
-        mesh.colors.reserve(mesh.colors.size() + pointCount);
-        mesh.uvs.reserve(mesh.uvs.size() + pointCount * 2);
+        static thread_local std::vector<double> buffers[BufferCount];
+        auto& buffer = buffers[slot];
+        if (buffer.size() < size)
+            buffer.resize(size);
+        return buffer;
     }
 
     const utymap::BoundingBox bbox;
     const ElevationProvider& eleProvider_;
+    const TriangleBudget budget_;
+
+    mutable std::atomic<std::size_t> polygons_;
+    mutable std::atomic<std::size_t> triangles_;
+    mutable std::atomic<std::size_t> relaxedPolygons_;
 };
 
-MeshBuilder::MeshBuilder(const utymap::QuadKey& quadKey, const ElevationProvider& eleProvider) :
-    pimpl_(utymap::utils::make_unique<MeshBuilderImpl>(quadKey, eleProvider))
+MeshBuilder::MeshBuilder(const utymap::QuadKey& quadKey, const ElevationProvider& eleProvider, const TriangleBudget& budget) :
+    pimpl_(utymap::utils::make_unique<MeshBuilderImpl>(quadKey, eleProvider, budget))
 {
 }
 
@@ -247,6 +677,7 @@ MeshBuilder::~MeshBuilder() { }
 
 void MeshBuilder::addPolygon(Mesh& mesh, Polygon& polygon, const GeometryOptions& geometryOptions, const AppearanceOptions& appearanceOptions) const
 {
+    UTYMAP_STATISTICS_SCOPE(Triangulation);
     pimpl_->addPolygon(mesh, polygon, geometryOptions, appearanceOptions);
 }
 
@@ -260,7 +691,18 @@ void MeshBuilder::addPlane(Mesh& mesh, const Vector2& p1, const Vector2& p2, dou
     pimpl_->addPlane(mesh, p1, p2, ele1, ele2, geometryOptions, appearanceOptions);
 }
 
+void MeshBuilder::addWalls(Mesh& mesh, const std::vector<Vector2>& ring, const GeometryOptions& geometryOptions,
+                           const AppearanceOptions& appearanceOptions, const EdgeFilter& filter) const
+{
+    pimpl_->addWalls(mesh, ring, geometryOptions, appearanceOptions, filter);
+}
+
 void MeshBuilder::addTriangle(Mesh& mesh, const utymap::meshing::Vector3& v0, const utymap::meshing::Vector3& v1, const utymap::meshing::Vector3& v2, const GeometryOptions& geometryOptions, const AppearanceOptions& appearanceOptions) const
 {
     pimpl_->addTriangle(mesh, v0, v1, v2, geometryOptions, appearanceOptions);
 }
+
+MeshBuilder::TriangulationStatistics MeshBuilder::getStatistics() const
+{
+    return pimpl_->getStatistics();
+}
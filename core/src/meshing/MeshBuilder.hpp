@@ -8,7 +8,10 @@
 #include "meshing/MeshTypes.hpp"
 #include "meshing/Polygon.hpp"
 
+#include <cstddef>
+#include <functional>
 #include <memory>
+#include <vector>
 
 namespace utymap { namespace meshing {
 
@@ -82,9 +85,42 @@ public:
         }
     };
 
-    /// Creates builder with given elevation provider.
+    /// Limits amount of triangles produced by refinement. If refinement with requested max area
+    /// would exceed budget, max area is increased to fit it.
+    struct TriangleBudget final
+    {
+        TriangleBudget(std::size_t perPolygon = 250000, std::size_t perTile = 1000000) :
+            perPolygon(perPolygon), perTile(perTile)
+        {
+        }
+
+        /// Max amount of triangles produced by single polygon.
+        std::size_t perPolygon;
+
+        /// Max amount of triangles produced by all polygons of builder's tile.
+        std::size_t perTile;
+    };
+
+    /// Counters of polygons triangulated by builder.
+    struct TriangulationStatistics final
+    {
+        /// Amount of polygons added.
+        std::size_t polygons;
+
+        /// Amount of triangles produced by polygons.
+        std::size_t triangles;
+
+        /// Amount of polygons which refinement was relaxed to fit budget.
+        std::size_t relaxedPolygons;
+    };
+
+    /// Returns false for edge of ring which should have no wall.
+    typedef std::function<bool(const Vector2&, const Vector2&)> EdgeFilter;
+
+    /// Creates builder with given elevation provider and triangle budget.
     MeshBuilder(const utymap::QuadKey& quadKey, 
-                const utymap::heightmap::ElevationProvider& eleProvider);
+                const utymap::heightmap::ElevationProvider& eleProvider,
+                const TriangleBudget& budget = TriangleBudget());
 
     ~MeshBuilder();
 
@@ -110,6 +146,14 @@ public:
                   const GeometryOptions& geometryOptions, 
                   const AppearanceOptions& appearanceOptions) const;
 
+    /// Adds walls along closed ring using options provided. Elevation, noise and color are
+    /// calculated once per ring point and neighbouring walls share their corner vertices.
+    void addWalls(Mesh& mesh,
+                  const std::vector<Vector2>& ring,
+                  const GeometryOptions& geometryOptions,
+                  const AppearanceOptions& appearanceOptions,
+                  const EdgeFilter& filter = EdgeFilter()) const;
+
     /// Adds triangle to mesh using options provided.
     void addTriangle(Mesh& mesh,
                      const utymap::meshing::Vector3& v0,
@@ -118,6 +162,9 @@ public:
                      const GeometryOptions& geometryOptions,
                      const AppearanceOptions& appearanceOptions) const;
 
+    /// Returns counters of polygons added so far. Thread safe.
+    TriangulationStatistics getStatistics() const;
+
 private:
     class MeshBuilderImpl;
     std::unique_ptr<MeshBuilderImpl> pimpl_;
@@ -0,0 +1,242 @@
+#include "meshing/MeshBvh.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+using namespace utymap;
+using namespace utymap::meshing;
+
+namespace {
+    const std::size_t MaxLeafSize = 4;
+
+    /// Gets element id from name of single element mesh which ends with it, e.g. "building:42".
+    bool getElementId(const std::string& name, std::uint64_t& id)
+    {
+        auto separator = name.rfind(':');
+        if (separator == std::string::npos || separator + 1 == name.size())
+            return false;
+        for (auto i = separator + 1; i < name.size(); ++i)
+            if (name[i] < '0' || name[i] > '9')
+                return false;
+        id = std::strtoull(name.c_str() + separator + 1, nullptr, 10);
+        return true;
+    }
+
+    inline void cross(const double* a, const double* b, double* result)
+    {
+        result[0] = a[1] * b[2] - a[2] * b[1];
+        result[1] = a[2] * b[0] - a[0] * b[2];
+        result[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    inline double dot(const double* a, const double* b)
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    /// Intersects ray with triangle using Moller-Trumbore algorithm.
+    bool intersect(const double* origin, const double* direction, const double* vertices, double& distance)
+    {
+        double edge1[3], edge2[3], offset[3], p[3], q[3];
+        for (int i = 0; i < 3; ++i) {
+            edge1[i] = vertices[3 + i] - vertices[i];
+            edge2[i] = vertices[6 + i] - vertices[i];
+            offset[i] = origin[i] - vertices[i];
+        }
+        cross(direction, edge2, p);
+        double determinant = dot(edge1, p);
+        // NOTE ray is parallel to triangle, e.g. vertical ray and wall.
+        if (determinant == 0)
+            return false;
+
+        double inverse = 1 / determinant;
+        double u = dot(offset, p) * inverse;
+        if (u < 0 || u > 1)
+            return false;
+
+        cross(offset, edge1, q);
+        double v = dot(direction, q) * inverse;
+        if (v < 0 || u + v > 1)
+            return false;
+
+        distance = dot(edge2, q) * inverse;
+        return distance >= 0;
+    }
+
+    /// Intersects ray with box returning distance to its entry point.
+    bool intersect(const double* origin, const double* inverse, const double* min, const double* max, double& distance)
+    {
+        double near = 0;
+        double far = std::numeric_limits<double>::max();
+        for (int i = 0; i < 3; ++i) {
+            double t1 = (min[i] - origin[i]) * inverse[i];
+            double t2 = (max[i] - origin[i]) * inverse[i];
+            // NOTE comparisons are written so NaN of ray on box plane does not reject box.
+            near = std::max(near, std::min(t1, t2));
+            far = std::min(far, std::max(t1, t2));
+        }
+        distance = near;
+        return near <= far;
+    }
+
+    inline double getCentroid(const double* vertices, int axis)
+    {
+        return vertices[axis] + vertices[3 + axis] + vertices[6 + axis];
+    }
+}
+
+MeshBvh::MeshBvh() : triangles_(), nodes_()
+{
+}
+
+void MeshBvh::add(const Mesh& mesh)
+{
+    if (!mesh.elementRanges.empty()) {
+        for (std::size_t i = 0; i + 2 < mesh.elementRanges.size(); i += 3)
+            addTriangles(mesh, static_cast<std::size_t>(mesh.elementRanges[i + 1]),
+                         static_cast<std::size_t>(mesh.elementRanges[i + 2]), mesh.elementRanges[i]);
+        return;
+    }
+
+    std::uint64_t id;
+    if (getElementId(mesh.name, id))
+        addTriangles(mesh, 0, mesh.triangles.size() / 3, id);
+}
+
+void MeshBvh::build()
+{
+    nodes_.clear();
+    if (triangles_.empty())
+        return;
+
+    nodes_.reserve(2 * (triangles_.size() / MaxLeafSize + 1));
+    nodes_.push_back(Node());
+    build(0, 0, triangles_.size());
+    nodes_.shrink_to_fit();
+}
+
+bool MeshBvh::pick(const double origin[3], const double direction[3], Hit& hit) const
+{
+    if (nodes_.empty())
+        return false;
+
+    double inverse[3];
+    for (int i = 0; i < 3; ++i)
+        inverse[i] = 1 / direction[i];
+
+    bool isFound = false;
+    hit.distance = std::numeric_limits<double>::max();
+    std::vector<std::uint32_t> stack = { 0 };
+    while (!stack.empty()) {
+        const Node& node = nodes_[stack.back()];
+        stack.pop_back();
+
+        double distance;
+        if (!intersect(origin, inverse, node.min, node.max, distance) || distance > hit.distance)
+            continue;
+
+        if (node.count == 0) {
+            stack.push_back(node.first);
+            stack.push_back(node.first + 1);
+            continue;
+        }
+
+        for (auto i = node.first; i < node.first + node.count; ++i) {
+            const Triangle& triangle = triangles_[i];
+            if (intersect(origin, direction, triangle.vertices, distance) && distance < hit.distance) {
+                hit.distance = distance;
+                hit.id = triangle.id;
+                isFound = true;
+            }
+        }
+    }
+    return isFound;
+}
+
+bool MeshBvh::pick(const GeoCoordinate& coordinate, Hit& hit) const
+{
+    if (nodes_.empty())
+        return false;
+
+    const double origin[3] = { coordinate.longitude, coordinate.latitude, nodes_[0].max[2] + 1 };
+    const double direction[3] = { 0, 0, -1 };
+    return pick(origin, direction, hit);
+}
+
+std::size_t MeshBvh::getMemoryUsage() const
+{
+    return sizeof(MeshBvh) + triangles_.capacity() * sizeof(Triangle) + nodes_.capacity() * sizeof(Node);
+}
+
+void MeshBvh::addTriangles(const Mesh& mesh, std::size_t first, std::size_t count, std::uint64_t id)
+{
+    std::size_t last = std::min(first + count, mesh.triangles.size() / 3);
+    for (std::size_t i = first; i < last; ++i) {
+        Triangle triangle;
+        triangle.id = id;
+        for (std::size_t j = 0; j < 3; ++j) {
+            auto index = static_cast<std::size_t>(mesh.triangles[i * 3 + j]) * 3;
+            if (index + 2 >= mesh.vertices.size())
+                return;
+            std::copy(mesh.vertices.begin() + index, mesh.vertices.begin() + index + 3, triangle.vertices + j * 3);
+        }
+        triangles_.push_back(triangle);
+    }
+}
+
+void MeshBvh::build(std::uint32_t nodeIndex, std::size_t first, std::size_t last)
+{
+    double min[3], max[3], centroidMin[3], centroidMax[3];
+    std::fill(min, min + 3, std::numeric_limits<double>::max());
+    std::fill(max, max + 3, std::numeric_limits<double>::lowest());
+    std::copy(min, min + 3, centroidMin);
+    std::copy(max, max + 3, centroidMax);
+    for (std::size_t i = first; i < last; ++i) {
+        const double* vertices = triangles_[i].vertices;
+        for (int axis = 0; axis < 3; ++axis) {
+            for (int j = 0; j < 3; ++j) {
+                min[axis] = std::min(min[axis], vertices[j * 3 + axis]);
+                max[axis] = std::max(max[axis], vertices[j * 3 + axis]);
+            }
+            double centroid = getCentroid(vertices, axis);
+            centroidMin[axis] = std::min(centroidMin[axis], centroid);
+            centroidMax[axis] = std::max(centroidMax[axis], centroid);
+        }
+    }
+
+    Node& node = nodes_[nodeIndex];
+    std::copy(min, min + 3, node.min);
+    std::copy(max, max + 3, node.max);
+    node.first = static_cast<std::uint32_t>(first);
+    node.count = static_cast<std::uint32_t>(last - first);
+
+    // NOTE degrees and meters are not comparable, so extents are relative to root ones.
+    const Node& root = nodes_[0];
+    int axis = -1;
+    double maxExtent = 0;
+    for (int i = 0; i < 3; ++i) {
+        double rootExtent = root.max[i] - root.min[i];
+        double extent = rootExtent > 0 ? (centroidMax[i] - centroidMin[i]) / rootExtent : 0;
+        if (extent > maxExtent) {
+            maxExtent = extent;
+            axis = i;
+        }
+    }
+    if (last - first <= MaxLeafSize || axis < 0)
+        return;
+
+    std::size_t middle = first + (last - first) / 2;
+    std::nth_element(triangles_.begin() + first, triangles_.begin() + middle, triangles_.begin() + last,
+        [axis](const Triangle& left, const Triangle& right) {
+            return getCentroid(left.vertices, axis) < getCentroid(right.vertices, axis);
+    });
+
+    auto left = static_cast<std::uint32_t>(nodes_.size());
+    nodes_[nodeIndex].first = left;
+    nodes_[nodeIndex].count = 0;
+    nodes_.push_back(Node());
+    nodes_.push_back(Node());
+    build(left, first, middle);
+    build(left + 1, middle, last);
+}
@@ -0,0 +1,75 @@
+#ifndef MESHING_MESHBVH_HPP_DEFINED
+#define MESHING_MESHBVH_HPP_DEFINED
+
+#include "GeoCoordinate.hpp"
+#include "meshing/MeshTypes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utymap { namespace meshing {
+
+/// Bounding volume hierarchy of mesh triangles which maps them to ids of elements they are
+/// built for, so element can be picked by ray without mesh colliders on client side.
+/// Coordinates are the same as in mesh: longitude, latitude and elevation.
+class MeshBvh final
+{
+public:
+    /// Result of picking.
+    struct Hit final
+    {
+        /// Id of element which triangle is hit.
+        std::uint64_t id;
+        /// Distance along ray in units of its direction.
+        double distance;
+    };
+
+    MeshBvh();
+
+    /// Adds triangles of given mesh. Element ids are taken from element ranges or from name
+    /// of single element mesh. Meshes which are not built for elements are skipped.
+    void add(const Mesh& mesh);
+
+    /// Builds hierarchy of added triangles. Should be called before picking.
+    void build();
+
+    /// Finds closest triangle hit by ray with given origin and direction.
+    bool pick(const double origin[3], const double direction[3], Hit& hit) const;
+
+    /// Finds topmost triangle which is above or below given point, e.g. roof of building.
+    bool pick(const utymap::GeoCoordinate& coordinate, Hit& hit) const;
+
+    /// Returns amount of triangles.
+    std::size_t size() const { return triangles_.size(); }
+
+    /// Returns amount of bytes used by hierarchy.
+    std::size_t getMemoryUsage() const;
+
+private:
+    struct Triangle final
+    {
+        double vertices[9];
+        std::uint64_t id;
+    };
+
+    struct Node final
+    {
+        double min[3];
+        double max[3];
+        /// Index of first triangle for leaf or index of left child which is followed by right one.
+        std::uint32_t first;
+        /// Amount of triangles for leaf, zero for inner node.
+        std::uint32_t count;
+    };
+
+    void addTriangles(const Mesh& mesh, std::size_t first, std::size_t count, std::uint64_t id);
+    void build(std::uint32_t nodeIndex, std::size_t first, std::size_t last);
+
+    std::vector<Triangle> triangles_;
+    std::vector<Node> nodes_;
+};
+
+}}
+
+#endif // MESHING_MESHBVH_HPP_DEFINED
@@ -0,0 +1,320 @@
+#include "meshing/MeshCodec.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/VarintUtils.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+using namespace utymap::meshing;
+using namespace utymap::utils;
+
+namespace {
+    ///                                     Encoded mesh format
+    ///------------------------------------------------------------------------------------------------------|
+    ///   DESCRIPTION    |                       DETAILS                                                     |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Header       |  Magic (4b), version (1b), flags (1b), padding (2b) and payload size before      |
+    ///                  |  compression (4b). Payload is deflated if the lowest bit of flags is set          |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Name         |  Length (varint) and characters                                                   |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Positions    |  Amount of vertices (varint). If not zero, min and max of x, y and elevation     |
+    ///                  |  (6 doubles) and zigzag deltas of quantized x, y, elevation of every vertex.     |
+    ///                  |  Min and max of x and y are either bounds of vertices or bounds of tile          |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Colors       |  Amount of colors (varint) and colors (4b each)                                   |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Uvs          |  Amount of values (varint). If not zero, min and max of u and v (4 doubles) and  |
+    ///                  |  zigzag deltas of quantized u, v of every vertex                                  |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Triangles    |  Amount of indices (varint) and zigzag distances (varint) from the highest index |
+    ///                  |  so far: indices of vertices ordered by first use are mostly encoded by one byte  |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Ranges       |  Amount of values (varint) and every range as zigzag delta of element id, zigzag |
+    ///                  |  delta of first triangle from end of previous range and amount of triangles      |
+    ///------------------------------------------------------------------------------------------------------|
+
+    const std::uint32_t MeshCodecMagic = 0x514D5955;
+    const std::uint8_t MeshCodecVersion = 1;
+    const std::uint8_t CompressedFlag = 0x1;
+    const std::size_t HeaderSize = 12;
+    const double QuantizationRange = 65535;
+    /// Max ratio of payload size to deflated size which zlib can produce.
+    const std::uint64_t MaxCompressionRatio = 1032;
+
+    /// Appends values to payload.
+    class PayloadWriter final
+    {
+    public:
+        explicit PayloadWriter(std::string& buffer) : buffer_(buffer) {}
+
+        void writeVarint(std::uint64_t value)
+        {
+            utymap::utils::writeVarint(buffer_, value);
+        }
+
+        template <typename T>
+        void write(const T& value)
+        {
+            buffer_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        /// Writes bounds of every component of interleaved values and their quantized deltas.
+        /// Bounds of the first components can be given, others are taken from values.
+        void writeQuantized(const std::vector<double>& values, std::size_t components,
+                            const std::vector<double>& givenMins = {}, const std::vector<double>& givenMaxs = {})
+        {
+            std::vector<double> mins(components, std::numeric_limits<double>::max());
+            std::vector<double> maxs(components, std::numeric_limits<double>::lowest());
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                mins[i % components] = std::min(mins[i % components], values[i]);
+                maxs[i % components] = std::max(maxs[i % components], values[i]);
+            }
+            std::copy(givenMins.begin(), givenMins.end(), mins.begin());
+            std::copy(givenMaxs.begin(), givenMaxs.end(), maxs.begin());
+            for (std::size_t i = 0; i < components; ++i) {
+                write(mins[i]);
+                write(maxs[i]);
+            }
+
+            std::vector<std::int64_t> previous(components, 0);
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                std::size_t component = i % components;
+                double range = maxs[component] - mins[component];
+                auto quantized = static_cast<std::int64_t>(range > 0
+                    ? std::round((values[i] - mins[component]) / range * QuantizationRange)
+                    : 0);
+                writeVarint(zigzag(quantized - previous[component]));
+                previous[component] = quantized;
+            }
+        }
+
+    private:
+        std::string& buffer_;
+    };
+
+    /// Reads values from payload checking its bounds.
+    class PayloadReader final
+    {
+    public:
+        PayloadReader(const char* data, std::size_t size) : data_(data), size_(size), position_(0) {}
+
+        std::uint64_t readVarint()
+        {
+            std::uint64_t value;
+            if (!utymap::utils::readVarint(data_, size_, position_, value))
+                throw std::domain_error("Invalid varint in encoded mesh.");
+            return value;
+        }
+
+        /// Reads amount of items which take at least one byte each.
+        std::size_t readSize()
+        {
+            std::uint64_t size = readVarint();
+            if (size > size_ - position_)
+                throw std::domain_error("Invalid size in encoded mesh.");
+            return static_cast<std::size_t>(size);
+        }
+
+        template <typename T>
+        T read()
+        {
+            if (position_ + sizeof(T) > size_)
+                throw std::domain_error("Unexpected end of encoded mesh.");
+            T value;
+            std::memcpy(&value, data_ + position_, sizeof(T));
+            position_ += sizeof(T);
+            return value;
+        }
+
+        void readQuantized(std::vector<double>& values, std::size_t count, std::size_t components)
+        {
+            std::vector<double> mins(components), steps(components);
+            for (std::size_t i = 0; i < components; ++i) {
+                mins[i] = read<double>();
+                steps[i] = (read<double>() - mins[i]) / QuantizationRange;
+            }
+
+            std::vector<std::int64_t> previous(components, 0);
+            values.resize(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                std::size_t component = i % components;
+                previous[component] += unzigzag(readVarint());
+                values[i] = mins[component] + previous[component] * steps[component];
+            }
+        }
+
+        std::string readString(std::size_t size)
+        {
+            if (position_ + size > size_)
+                throw std::domain_error("Unexpected end of encoded mesh.");
+            std::string value(data_ + position_, size);
+            position_ += size;
+            return value;
+        }
+
+    private:
+        const char* data_;
+        const std::size_t size_;
+        std::size_t position_;
+    };
+
+    /// Writes payload of mesh. Bounds of longitude and latitude are taken from tile if it is given.
+    std::string writePayload(const Mesh& mesh, const utymap::BoundingBox* tileBounds)
+    {
+        std::string payload;
+        PayloadWriter writer(payload);
+
+        writer.writeVarint(mesh.name.size());
+        payload.append(mesh.name);
+
+        writer.writeVarint(mesh.vertices.size() / 3);
+        if (!mesh.vertices.empty() && tileBounds != nullptr)
+            writer.writeQuantized(mesh.vertices, 3,
+                { tileBounds->minPoint.longitude, tileBounds->minPoint.latitude },
+                { tileBounds->maxPoint.longitude, tileBounds->maxPoint.latitude });
+        else if (!mesh.vertices.empty())
+            writer.writeQuantized(mesh.vertices, 3);
+
+        writer.writeVarint(mesh.colors.size());
+        for (int color : mesh.colors)
+            writer.write(static_cast<std::uint32_t>(color));
+
+        writer.writeVarint(mesh.uvs.size());
+        if (!mesh.uvs.empty())
+            writer.writeQuantized(mesh.uvs, 2);
+
+        writer.writeVarint(mesh.triangles.size());
+        std::int64_t highest = 0;
+        for (int index : mesh.triangles) {
+            writer.writeVarint(zigzag(highest - index));
+            highest = std::max<std::int64_t>(highest, index + 1);
+        }
+
+        writer.writeVarint(mesh.elementRanges.size());
+        std::uint64_t previousId = 0, previousEnd = 0;
+        for (std::size_t i = 0; i + 2 < mesh.elementRanges.size(); i += 3) {
+            writer.writeVarint(zigzag(static_cast<std::int64_t>(mesh.elementRanges[i] - previousId)));
+            writer.writeVarint(zigzag(static_cast<std::int64_t>(mesh.elementRanges[i + 1] - previousEnd)));
+            writer.writeVarint(mesh.elementRanges[i + 2]);
+            previousId = mesh.elementRanges[i];
+            previousEnd = mesh.elementRanges[i + 1] + mesh.elementRanges[i + 2];
+        }
+        return payload;
+    }
+
+    std::unique_ptr<Mesh> readPayload(const char* data, std::size_t size)
+    {
+        PayloadReader reader(data, size);
+        auto mesh = utymap::utils::make_unique<Mesh>(reader.readString(reader.readSize()));
+
+        std::size_t vertexCount = reader.readSize();
+        if (vertexCount > 0)
+            reader.readQuantized(mesh->vertices, vertexCount * 3, 3);
+
+        std::size_t colorCount = reader.readSize();
+        mesh->colors.reserve(colorCount);
+        for (std::size_t i = 0; i < colorCount; ++i)
+            mesh->colors.push_back(static_cast<int>(reader.read<std::uint32_t>()));
+
+        std::size_t uvCount = reader.readSize();
+        if (uvCount > 0)
+            reader.readQuantized(mesh->uvs, uvCount, 2);
+
+        std::size_t indexCount = reader.readSize();
+        mesh->triangles.reserve(indexCount);
+        std::int64_t highest = 0;
+        for (std::size_t i = 0; i < indexCount; ++i) {
+            std::int64_t index = highest - unzigzag(reader.readVarint());
+            if (index < 0 || index >= static_cast<std::int64_t>(vertexCount))
+                throw std::domain_error("Invalid triangle index in encoded mesh.");
+            mesh->triangles.push_back(static_cast<int>(index));
+            highest = std::max(highest, index + 1);
+        }
+
+        std::size_t rangeSize = reader.readSize();
+        mesh->elementRanges.reserve(rangeSize);
+        std::uint64_t id = 0, end = 0;
+        for (std::size_t i = 0; i + 2 < rangeSize; i += 3) {
+            id += static_cast<std::uint64_t>(unzigzag(reader.readVarint()));
+            std::uint64_t first = end + static_cast<std::uint64_t>(unzigzag(reader.readVarint()));
+            std::uint64_t count = reader.readVarint();
+            mesh->elementRanges.insert(mesh->elementRanges.end(), { id, first, count });
+            end = first + count;
+        }
+        return mesh;
+    }
+
+    /// Encodes mesh with header. Bounds of longitude and latitude are taken from tile if it is given.
+    std::string encodePayload(const Mesh& mesh, const utymap::BoundingBox* tileBounds, bool isCompressed)
+    {
+        std::string payload = writePayload(mesh, tileBounds);
+
+        std::string result(HeaderSize, '\0');
+        std::uint8_t flags = isCompressed ? CompressedFlag : 0;
+        auto payloadSize = static_cast<std::uint32_t>(payload.size());
+        std::memcpy(&result[0], &MeshCodecMagic, sizeof(MeshCodecMagic));
+        std::memcpy(&result[4], &MeshCodecVersion, sizeof(MeshCodecVersion));
+        std::memcpy(&result[5], &flags, sizeof(flags));
+        std::memcpy(&result[8], &payloadSize, sizeof(payloadSize));
+
+        if (!isCompressed)
+            return result + payload;
+
+        uLongf compressedSize = compressBound(static_cast<uLong>(payload.size()));
+        result.resize(HeaderSize + compressedSize);
+        if (compress(reinterpret_cast<Bytef*>(&result[HeaderSize]), &compressedSize,
+                     reinterpret_cast<const Bytef*>(payload.data()), static_cast<uLong>(payload.size())) != Z_OK)
+            throw std::domain_error("Failed to compress mesh: " + mesh.name);
+        result.resize(HeaderSize + compressedSize);
+        return result;
+    }
+}
+
+std::string MeshCodec::encode(const Mesh& mesh, bool isCompressed)
+{
+    return encodePayload(mesh, nullptr, isCompressed);
+}
+
+std::string MeshCodec::encode(const Mesh& mesh, const utymap::BoundingBox& tileBounds, bool isCompressed)
+{
+    return encodePayload(mesh, &tileBounds, isCompressed);
+}
+
+std::unique_ptr<Mesh> MeshCodec::decode(const char* data, std::size_t size)
+{
+    std::uint32_t magic = 0, payloadSize = 0;
+    std::uint8_t version = 0, flags = 0;
+    if (size >= HeaderSize) {
+        std::memcpy(&magic, data, sizeof(magic));
+        std::memcpy(&version, data + 4, sizeof(version));
+        std::memcpy(&flags, data + 5, sizeof(flags));
+        std::memcpy(&payloadSize, data + 8, sizeof(payloadSize));
+    }
+    if (magic != MeshCodecMagic || version != MeshCodecVersion)
+        throw std::domain_error("Invalid encoded mesh header.");
+
+    if ((flags & CompressedFlag) == 0) {
+        if (payloadSize != size - HeaderSize)
+            throw std::domain_error("Invalid encoded mesh size.");
+        return readPayload(data + HeaderSize, payloadSize);
+    }
+
+    // NOTE payload size is checked before it is allocated.
+    if (payloadSize > (size - HeaderSize) * MaxCompressionRatio)
+        throw std::domain_error("Invalid encoded mesh size.");
+
+    std::string payload(payloadSize, '\0');
+    uLongf destSize = payloadSize;
+    if (uncompress(reinterpret_cast<Bytef*>(&payload[0]), &destSize,
+                   reinterpret_cast<const Bytef*>(data + HeaderSize), static_cast<uLong>(size - HeaderSize)) != Z_OK ||
+        destSize != payloadSize)
+        throw std::domain_error("Failed to uncompress encoded mesh.");
+    return readPayload(payload.data(), payload.size());
+}
@@ -0,0 +1,34 @@
+#ifndef MESHING_MESHCODEC_HPP_DEFINED
+#define MESHING_MESHCODEC_HPP_DEFINED
+
+#include "BoundingBox.hpp"
+#include "meshing/MeshTypes.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace utymap { namespace meshing {
+
+/// Encodes mesh into compact format for storage and transfer. Positions and texture coordinates
+/// are quantized to 16 bits relative to their bounds, indices and element ranges are delta coded
+/// and the whole payload is optionally deflated. Quantization error of position is bounds size
+/// divided by 65535, so meshes of one tile keep centimeter precision. Meshes encoded with bounds
+/// of their tile share its grid: vertices on common edges are decoded to the same positions.
+class MeshCodec final
+{
+public:
+    /// Encodes mesh. If compression is set, payload is compressed by zlib.
+    static std::string encode(const Mesh& mesh, bool isCompressed = true);
+
+    /// Encodes mesh quantizing longitude and latitude on grid of given tile bounds. Vertices
+    /// outside of bounds are kept with the same step.
+    static std::string encode(const Mesh& mesh, const utymap::BoundingBox& tileBounds, bool isCompressed = true);
+
+    /// Decodes mesh encoded by encode. Throws domain_error if data is malformed.
+    static std::unique_ptr<Mesh> decode(const char* data, std::size_t size);
+};
+
+}}
+
+#endif // MESHING_MESHCODEC_HPP_DEFINED
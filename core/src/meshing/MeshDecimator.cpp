@@ -0,0 +1,386 @@
+#include "meshing/MeshDecimator.hpp"
+#include "meshing/CartesianProjection.hpp"
+#include "utils/MathUtils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::meshing;
+
+namespace {
+    /// Max distance in degrees from tile border to vertex which is kept as border one.
+    const double BorderEpsilon = 1E-9;
+
+    struct Point final
+    {
+        double x, y, z;
+    };
+
+    Point subtract(const Point& lhs, const Point& rhs)
+    {
+        return Point { lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z };
+    }
+
+    Point cross(const Point& lhs, const Point& rhs)
+    {
+        return Point { lhs.y * rhs.z - lhs.z * rhs.y, lhs.z * rhs.x - lhs.x * rhs.z, lhs.x * rhs.y - lhs.y * rhs.x };
+    }
+
+    double dot(const Point& lhs, const Point& rhs)
+    {
+        return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+    }
+
+    /// Symmetric 4x4 matrix which sums squared distances to planes.
+    struct Quadric final
+    {
+        double a[10];
+
+        Quadric() { std::fill(a, a + 10, 0); }
+
+        void add(const Point& n, double d)
+        {
+            a[0] += n.x * n.x; a[1] += n.x * n.y; a[2] += n.x * n.z; a[3] += n.x * d;
+            a[4] += n.y * n.y; a[5] += n.y * n.z; a[6] += n.y * d;
+            a[7] += n.z * n.z; a[8] += n.z * d;
+            a[9] += d * d;
+        }
+
+        Quadric& operator+=(const Quadric& other)
+        {
+            for (int i = 0; i < 10; ++i)
+                a[i] += other.a[i];
+            return *this;
+        }
+
+        double evaluate(const Point& p) const
+        {
+            return a[0] * p.x * p.x + 2 * a[1] * p.x * p.y + 2 * a[2] * p.x * p.z + 2 * a[3] * p.x +
+                   a[4] * p.y * p.y + 2 * a[5] * p.y * p.z + 2 * a[6] * p.y +
+                   a[7] * p.z * p.z + 2 * a[8] * p.z + a[9];
+        }
+    };
+
+    /// Collapse of source vertex into target one. Versions are used to skip stale collapses.
+    struct Collapse final
+    {
+        double cost;
+        int source, target;
+        std::uint32_t sourceVersion, targetVersion;
+
+        bool operator>(const Collapse& other) const { return cost > other.cost; }
+    };
+
+    /// Keeps state of decimation of one mesh.
+    class Decimation final
+    {
+    public:
+        Decimation(const Mesh& mesh, const BoundingBox& bbox) :
+            triangles_(mesh.triangles),
+            points_(mesh.vertices.size() / 3),
+            locked_(points_.size(), false),
+            removed_(points_.size(), false),
+            versions_(points_.size(), 0),
+            removedTriangles_(triangles_.size() / 3, false),
+            quadrics_(points_.size()),
+            trianglesOf_(points_.size())
+        {
+            project(mesh, bbox);
+            lockSeams();
+            lockBoundaries();
+
+            for (std::size_t triangle = 0; triangle < removedTriangles_.size(); ++triangle) {
+                const int* corners = &triangles_[triangle * 3];
+                Point normal = getNormal(points_[corners[0]], points_[corners[1]], points_[corners[2]]);
+                double length = std::sqrt(dot(normal, normal));
+                // NOTE degenerate triangles are removed: they are not visible.
+                if (length == 0 || corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2]) {
+                    removedTriangles_[triangle] = true;
+                    continue;
+                }
+                normal = Point { normal.x / length, normal.y / length, normal.z / length };
+                double d = -dot(normal, points_[corners[0]]);
+                for (std::size_t corner = 0; corner < 3; ++corner) {
+                    quadrics_[corners[corner]].add(normal, d);
+                    trianglesOf_[corners[corner]].push_back(triangle);
+                }
+            }
+        }
+
+        /// Collapses edges while their cost is below max cost.
+        void run(double maxCost)
+        {
+            for (std::size_t triangle = 0; triangle < removedTriangles_.size(); ++triangle) {
+                if (!removedTriangles_[triangle])
+                    addCollapses(triangle);
+            }
+
+            while (!queue_.empty()) {
+                Collapse collapse = queue_.top();
+                queue_.pop();
+                if (collapse.cost > maxCost)
+                    break;
+                if (removed_[collapse.source] || removed_[collapse.target] ||
+                    versions_[collapse.source] != collapse.sourceVersion ||
+                    versions_[collapse.target] != collapse.targetVersion ||
+                    !canCollapse(collapse.source, collapse.target))
+                    continue;
+                apply(collapse.source, collapse.target);
+            }
+        }
+
+        /// Writes remaining triangles and vertices which are used by them.
+        void write(const Mesh& source, Mesh& target) const
+        {
+            std::vector<int> remap(points_.size(), -1);
+            std::vector<std::uint32_t> alive(removedTriangles_.size() + 1, 0);
+            for (std::size_t triangle = 0; triangle < removedTriangles_.size(); ++triangle) {
+                alive[triangle + 1] = alive[triangle] + (removedTriangles_[triangle] ? 0 : 1);
+                if (!removedTriangles_[triangle]) {
+                    for (std::size_t corner = 0; corner < 3; ++corner)
+                        remap[triangles_[triangle * 3 + corner]] = 0;
+                }
+            }
+
+            int next = 0;
+            for (std::size_t vertex = 0; vertex < remap.size(); ++vertex) {
+                if (remap[vertex] < 0)
+                    continue;
+                remap[vertex] = next++;
+                target.vertices.insert(target.vertices.end(), source.vertices.begin() + vertex * 3,
+                                       source.vertices.begin() + vertex * 3 + 3);
+                if (!source.colors.empty())
+                    target.colors.push_back(vertex < source.colors.size() ? source.colors[vertex] : 0);
+                if (!source.uvs.empty()) {
+                    bool hasUv = vertex * 2 + 1 < source.uvs.size();
+                    target.uvs.push_back(hasUv ? source.uvs[vertex * 2] : 0);
+                    target.uvs.push_back(hasUv ? source.uvs[vertex * 2 + 1] : 0);
+                }
+            }
+
+            target.triangles.reserve(alive.back() * 3);
+            for (std::size_t triangle = 0; triangle < removedTriangles_.size(); ++triangle) {
+                if (!removedTriangles_[triangle]) {
+                    for (std::size_t corner = 0; corner < 3; ++corner)
+                        target.triangles.push_back(remap[triangles_[triangle * 3 + corner]]);
+                }
+            }
+
+            for (std::size_t i = 0; i + 2 < source.elementRanges.size(); i += 3) {
+                std::size_t first = std::min<std::size_t>(source.elementRanges[i + 1], removedTriangles_.size());
+                std::size_t end = std::min<std::size_t>(first + source.elementRanges[i + 2], removedTriangles_.size());
+                target.elementRanges.insert(target.elementRanges.end(),
+                    { source.elementRanges[i], alive[first], alive[end] - alive[first] });
+            }
+        }
+
+    private:
+        /// Converts vertices to meters relative to tile corner and locks ones on tile border.
+        void project(const Mesh& mesh, const BoundingBox& bbox)
+        {
+            double centerLatitude = (bbox.minPoint.latitude + bbox.maxPoint.latitude) / 2;
+            double longitudeScale = CartesianProjection::EquatorLength * std::cos(utymap::utils::deg2Rad(centerLatitude)) / 360;
+            double latitudeScale = CartesianProjection::MeridianLength / 360;
+            for (std::size_t i = 0; i < points_.size(); ++i) {
+                double longitude = mesh.vertices[i * 3], latitude = mesh.vertices[i * 3 + 1];
+                points_[i] = Point { (longitude - bbox.minPoint.longitude) * longitudeScale,
+                                     (latitude - bbox.minPoint.latitude) * latitudeScale,
+                                     mesh.vertices[i * 3 + 2] };
+                locked_[i] = std::abs(longitude - bbox.minPoint.longitude) < BorderEpsilon ||
+                             std::abs(longitude - bbox.maxPoint.longitude) < BorderEpsilon ||
+                             std::abs(latitude - bbox.minPoint.latitude) < BorderEpsilon ||
+                             std::abs(latitude - bbox.maxPoint.latitude) < BorderEpsilon;
+            }
+        }
+
+        /// Locks vertices which share position with other ones: they are seams of attributes
+        /// or of separately built parts. Others are mapped to position classes.
+        void lockSeams()
+        {
+            std::vector<int> order(points_.size());
+            for (std::size_t i = 0; i < order.size(); ++i)
+                order[i] = static_cast<int>(i);
+            auto less = [&](int lhs, int rhs) {
+                const Point& l = points_[lhs];
+                const Point& r = points_[rhs];
+                return l.x != r.x ? l.x < r.x : (l.y != r.y ? l.y < r.y : l.z < r.z);
+            };
+            std::sort(order.begin(), order.end(), less);
+
+            classes_.resize(points_.size());
+            for (std::size_t begin = 0, end = 0; begin < order.size(); begin = end) {
+                for (end = begin + 1; end < order.size() && !less(order[begin], order[end]); ++end) {}
+                for (std::size_t i = begin; i < end; ++i) {
+                    classes_[order[i]] = order[begin];
+                    if (end - begin > 1)
+                        locked_[order[i]] = true;
+                }
+            }
+        }
+
+        /// Locks vertices of edges which are used by single triangle.
+        void lockBoundaries()
+        {
+            std::unordered_map<std::uint64_t, int> edges;
+            forEachEdge([&](int from, int to) { ++edges[getEdgeKey(from, to)]; });
+            forEachEdge([&](int from, int to) {
+                if (edges[getEdgeKey(from, to)] == 1) {
+                    locked_[from] = true;
+                    locked_[to] = true;
+                }
+            });
+        }
+
+        void forEachEdge(const std::function<void(int, int)>& function) const
+        {
+            for (std::size_t i = 0; i + 2 < triangles_.size(); i += 3) {
+                function(triangles_[i], triangles_[i + 1]);
+                function(triangles_[i + 1], triangles_[i + 2]);
+                function(triangles_[i + 2], triangles_[i]);
+            }
+        }
+
+        std::uint64_t getEdgeKey(int from, int to) const
+        {
+            auto first = static_cast<std::uint64_t>(classes_[from]);
+            auto second = static_cast<std::uint64_t>(classes_[to]);
+            return first < second ? (first << 32) | second : (second << 32) | first;
+        }
+
+        static Point getNormal(const Point& p0, const Point& p1, const Point& p2)
+        {
+            return cross(subtract(p1, p0), subtract(p2, p0));
+        }
+
+        void addCollapses(std::size_t triangle)
+        {
+            for (std::size_t corner = 0; corner < 3; ++corner) {
+                int from = triangles_[triangle * 3 + corner];
+                int to = triangles_[triangle * 3 + (corner + 1) % 3];
+                addCollapse(from, to);
+                addCollapse(to, from);
+            }
+        }
+
+        void addCollapse(int source, int target)
+        {
+            if (locked_[source])
+                return;
+            Quadric quadric = quadrics_[source];
+            quadric += quadrics_[target];
+            queue_.push(Collapse { std::max(quadric.evaluate(points_[target]), 0.), source, target,
+                                   versions_[source], versions_[target] });
+        }
+
+        /// Checks that collapse keeps surface manifold and does not flip triangles.
+        bool canCollapse(int source, int target)
+        {
+            sourceNeighbours_.clear();
+            targetNeighbours_.clear();
+            collectNeighbours(source, sourceNeighbours_);
+            collectNeighbours(target, targetNeighbours_);
+            std::size_t common = 0;
+            for (int neighbour : sourceNeighbours_)
+                common += std::count(targetNeighbours_.begin(), targetNeighbours_.end(), neighbour) > 0 ? 1 : 0;
+            if (common > 2)
+                return false;
+
+            for (std::size_t triangle : trianglesOf_[source]) {
+                const int* corners = &triangles_[triangle * 3];
+                if (removedTriangles_[triangle] || corners[0] == target || corners[1] == target || corners[2] == target)
+                    continue;
+                Point moved[3];
+                for (std::size_t corner = 0; corner < 3; ++corner)
+                    moved[corner] = points_[corners[corner] == source ? target : corners[corner]];
+                Point before = getNormal(points_[corners[0]], points_[corners[1]], points_[corners[2]]);
+                Point after = getNormal(moved[0], moved[1], moved[2]);
+                if (dot(after, after) == 0 || dot(before, after) <= 0)
+                    return false;
+            }
+            return true;
+        }
+
+        /// Collects position classes of vertices which share alive triangle with given one.
+        void collectNeighbours(int vertex, std::vector<int>& neighbours) const
+        {
+            for (std::size_t triangle : trianglesOf_[vertex]) {
+                if (removedTriangles_[triangle])
+                    continue;
+                for (std::size_t corner = 0; corner < 3; ++corner) {
+                    int neighbour = classes_[triangles_[triangle * 3 + corner]];
+                    if (neighbour != classes_[vertex] &&
+                        std::find(neighbours.begin(), neighbours.end(), neighbour) == neighbours.end())
+                        neighbours.push_back(neighbour);
+                }
+            }
+        }
+
+        void apply(int source, int target)
+        {
+            for (std::size_t triangle : trianglesOf_[source]) {
+                if (removedTriangles_[triangle])
+                    continue;
+                int* corners = &triangles_[triangle * 3];
+                if (corners[0] == target || corners[1] == target || corners[2] == target) {
+                    removedTriangles_[triangle] = true;
+                    continue;
+                }
+                for (std::size_t corner = 0; corner < 3; ++corner) {
+                    if (corners[corner] == source)
+                        corners[corner] = target;
+                }
+                trianglesOf_[target].push_back(triangle);
+            }
+
+            removed_[source] = true;
+            quadrics_[target] += quadrics_[source];
+            ++versions_[target];
+            for (std::size_t triangle : trianglesOf_[target]) {
+                if (!removedTriangles_[triangle])
+                    addCollapses(triangle);
+            }
+        }
+
+        std::vector<int> triangles_;
+        std::vector<Point> points_;
+        /// First vertex which has the same position.
+        std::vector<int> classes_;
+        std::vector<bool> locked_;
+        std::vector<bool> removed_;
+        std::vector<std::uint32_t> versions_;
+        std::vector<bool> removedTriangles_;
+        std::vector<Quadric> quadrics_;
+        std::vector<std::vector<std::size_t>> trianglesOf_;
+        std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue_;
+        std::vector<int> sourceNeighbours_;
+        std::vector<int> targetNeighbours_;
+    };
+}
+
+MeshDecimator::MeshDecimator(const BoundingBox& bbox, double maxError) :
+    bbox_(bbox), maxError_(maxError)
+{
+}
+
+void MeshDecimator::decimate(const Mesh& source, Mesh& target) const
+{
+    // NOTE every vertex of non-indexed mesh is locked as seam, so decimation cannot remove any.
+    if (!source.isIndexed) {
+        target.vertices = source.vertices;
+        target.triangles = source.triangles;
+        target.colors = source.colors;
+        target.uvs = source.uvs;
+        target.elementRanges = source.elementRanges;
+        return;
+    }
+
+    Decimation decimation(source, bbox_);
+    decimation.run(maxError_ * maxError_);
+    decimation.write(source, target);
+}
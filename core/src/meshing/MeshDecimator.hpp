@@ -0,0 +1,35 @@
+#ifndef MESHING_MESHDECIMATOR_HPP_DEFINED
+#define MESHING_MESHDECIMATOR_HPP_DEFINED
+
+#include "BoundingBox.hpp"
+#include "meshing/MeshTypes.hpp"
+
+namespace utymap { namespace meshing {
+
+/// Simplifies meshes using quadric error metrics: edges are collapsed into one of their vertices
+/// while distance from new surface to planes of original triangles is below max error. Vertices
+/// on mesh boundaries, attribute seams and tile border are kept, so neighbouring tiles stay
+/// crack free and vertex attributes are not interpolated. Vertices which share position with
+/// other ones are kept too. Triangles of non-indexed mesh have own vertices for flat shading,
+/// so all their vertices are such seams: non-indexed meshes are copied without simplification.
+class MeshDecimator final
+{
+public:
+    /// Creates decimator for meshes of tile with given bounding box. Max error is in meters.
+    MeshDecimator(const utymap::BoundingBox& bbox, double maxError);
+
+    /// Checks whether decimation is requested.
+    bool isEnabled() const { return maxError_ > 0; }
+
+    /// Writes simplified copy of source mesh to target. Triangles keep their order, so element
+    /// ranges are only shrunk. Vertex index is not copied. Non-indexed mesh is copied as is.
+    void decimate(const Mesh& source, Mesh& target) const;
+
+private:
+    const utymap::BoundingBox bbox_;
+    const double maxError_;
+};
+
+}}
+
+#endif // MESHING_MESHDECIMATOR_HPP_DEFINED
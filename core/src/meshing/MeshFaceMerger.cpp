@@ -0,0 +1,373 @@
+#include "meshing/MeshFaceMerger.hpp"
+#include "meshing/CartesianProjection.hpp"
+#include "utils/MathUtils.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::meshing;
+
+namespace {
+    /// Max difference between unit normals of triangles of the same patch.
+    const double NormalTolerance = 1E-6;
+    /// Max distance in meters from outline vertex to line of its neighbours to remove it.
+    const double CollinearTolerance = 1E-6;
+
+    struct Point final
+    {
+        double x, y, z;
+    };
+
+    Point subtract(const Point& lhs, const Point& rhs)
+    {
+        return Point { lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z };
+    }
+
+    Point cross(const Point& lhs, const Point& rhs)
+    {
+        return Point { lhs.y * rhs.z - lhs.z * rhs.y, lhs.z * rhs.x - lhs.x * rhs.z, lhs.x * rhs.y - lhs.y * rhs.x };
+    }
+
+    double dot(const Point& lhs, const Point& rhs)
+    {
+        return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+    }
+
+    std::uint64_t getEdgeKey(int from, int to)
+    {
+        return static_cast<std::uint64_t>(static_cast<std::uint32_t>(from)) << 32 | static_cast<std::uint32_t>(to);
+    }
+
+    struct PositionHash final
+    {
+        std::size_t operator()(const Point& point) const
+        {
+            std::size_t hash = std::hash<double>()(point.x);
+            for (std::size_t value : { std::hash<double>()(point.y), std::hash<double>()(point.z) })
+                hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            return hash;
+        }
+    };
+
+    struct PositionEqual final
+    {
+        bool operator()(const Point& lhs, const Point& rhs) const
+        {
+            return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
+        }
+    };
+
+    /// Keeps state of merging of one mesh.
+    class Merge final
+    {
+        /// Marks directed edge which is used by more than one triangle.
+        static const int SharedEdge = -1;
+
+    public:
+        Merge(const Mesh& mesh, double maxDistance) :
+            mesh_(mesh),
+            maxDistance_(maxDistance),
+            positions_(mesh.vertices.size() / 3),
+            points_(),
+            usage_(),
+            normals_(mesh.triangles.size() / 3),
+            isMergeable_(mesh.triangles.size() / 3, false),
+            patches_(mesh.triangles.size() / 3, -1)
+        {
+            weld();
+            for (std::size_t triangle = 0; triangle < normals_.size(); ++triangle)
+                classify(triangle);
+            for (std::size_t triangle = 0; triangle < normals_.size(); ++triangle) {
+                if (isMergeable_[triangle] && patches_[triangle] < 0)
+                    buildPatch(triangle);
+            }
+        }
+
+        /// Writes merged patches in place of their first triangles and other triangles as is.
+        void write(Mesh& target) const
+        {
+            std::vector<int> vertexMap(positions_.size(), -1);
+            auto addVertex = [&](int index) {
+                if (vertexMap[index] < 0) {
+                    vertexMap[index] = static_cast<int>(target.vertices.size() / 3);
+                    target.vertices.insert(target.vertices.end(), &mesh_.vertices[index * 3], &mesh_.vertices[index * 3] + 3);
+                    target.colors.push_back(mesh_.colors[index]);
+                    target.uvs.insert(target.uvs.end(), &mesh_.uvs[index * 2], &mesh_.uvs[index * 2] + 2);
+                }
+                target.triangles.push_back(vertexMap[index]);
+            };
+
+            for (std::size_t triangle = 0; triangle < normals_.size(); ++triangle) {
+                int patch = patches_[triangle];
+                if (patch < 0 || merged_[patch].empty()) {
+                    for (std::size_t corner = 0; corner < 3; ++corner)
+                        addVertex(mesh_.triangles[triangle * 3 + corner]);
+                }
+                else if (triangles_[patch].front() == triangle) {
+                    for (int index : merged_[patch])
+                        addVertex(index);
+                }
+            }
+        }
+
+    private:
+        /// Projects vertices to metric space and assigns the same position id to equal positions.
+        void weld()
+        {
+            if (positions_.empty())
+                return;
+
+            double longitudeScale = CartesianProjection::EquatorLength * std::cos(utymap::utils::deg2Rad(mesh_.vertices[1])) / 360;
+            double latitudeScale = CartesianProjection::MeridianLength / 360;
+            std::unordered_map<Point, int, PositionHash, PositionEqual> ids;
+            for (std::size_t i = 0; i < positions_.size(); ++i) {
+                const double* vertex = &mesh_.vertices[i * 3];
+                auto result = ids.emplace(Point { vertex[0], vertex[1], vertex[2] }, static_cast<int>(points_.size()));
+                positions_[i] = result.first->second;
+                if (result.second)
+                    points_.push_back(Point { (vertex[0] - mesh_.vertices[0]) * longitudeScale, vertex[2],
+                                              (vertex[1] - mesh_.vertices[1]) * latitudeScale });
+            }
+            usage_.assign(points_.size(), 0);
+        }
+
+        /// Calculates normal and registers edges of triangle. Triangle is mergeable if it is not
+        /// degenerate and all its corners have the same attributes.
+        void classify(std::size_t triangle)
+        {
+            const int* corners = &mesh_.triangles[triangle * 3];
+            int p0 = positions_[corners[0]], p1 = positions_[corners[1]], p2 = positions_[corners[2]];
+            for (int position : { p0, p1, p2 })
+                ++usage_[position];
+
+            Point normal = cross(subtract(points_[p1], points_[p0]), subtract(points_[p2], points_[p0]));
+            double length = std::sqrt(dot(normal, normal));
+            if (length == 0 || p0 == p1 || p1 == p2 || p0 == p2 ||
+                !hasSameAttributes(corners[0], corners[1]) || !hasSameAttributes(corners[0], corners[2]))
+                return;
+
+            normals_[triangle] = Point { normal.x / length, normal.y / length, normal.z / length };
+            isMergeable_[triangle] = true;
+            for (std::size_t corner = 0; corner < 3; ++corner) {
+                auto result = edges_.emplace(getEdgeKey(positions_[corners[corner]], positions_[corners[(corner + 1) % 3]]),
+                                             static_cast<int>(triangle));
+                if (!result.second)
+                    result.first->second = SharedEdge;
+            }
+        }
+
+        bool hasSameAttributes(int lhs, int rhs) const
+        {
+            return mesh_.colors[lhs] == mesh_.colors[rhs] &&
+                   mesh_.uvs[lhs * 2] == mesh_.uvs[rhs * 2] && mesh_.uvs[lhs * 2 + 1] == mesh_.uvs[rhs * 2 + 1];
+        }
+
+        /// Collects connected triangles which lie on plane of seed one and merges them.
+        void buildPatch(std::size_t seed)
+        {
+            int patch = static_cast<int>(triangles_.size());
+            triangles_.push_back(std::vector<std::size_t> { seed });
+            patches_[seed] = patch;
+
+            const Point& normal = normals_[seed];
+            double d = dot(normal, points_[positions_[mesh_.triangles[seed * 3]]]);
+            int seedCorner = mesh_.triangles[seed * 3];
+            for (std::size_t i = 0; i < triangles_[patch].size(); ++i) {
+                std::size_t triangle = triangles_[patch][i];
+                const int* corners = &mesh_.triangles[triangle * 3];
+                for (std::size_t corner = 0; corner < 3; ++corner) {
+                    int from = positions_[corners[corner]], to = positions_[corners[(corner + 1) % 3]];
+                    auto forward = edges_.find(getEdgeKey(from, to));
+                    auto reverse = edges_.find(getEdgeKey(to, from));
+                    if (forward->second == SharedEdge || reverse == edges_.end() || reverse->second == SharedEdge)
+                        continue;
+
+                    auto neighbour = static_cast<std::size_t>(reverse->second);
+                    if (patches_[neighbour] >= 0 || !isMergeable_[neighbour] ||
+                        !hasSameAttributes(seedCorner, mesh_.triangles[neighbour * 3]) ||
+                        dot(normal, normals_[neighbour]) < 1 - NormalTolerance ||
+                        !isOnPlane(neighbour, normal, d))
+                        continue;
+
+                    patches_[neighbour] = patch;
+                    triangles_[patch].push_back(neighbour);
+                }
+            }
+
+            merged_.push_back(std::vector<int>());
+            if (triangles_[patch].size() > 1)
+                triangulate(patch, normal);
+        }
+
+        bool isOnPlane(std::size_t triangle, const Point& normal, double d) const
+        {
+            for (std::size_t corner = 0; corner < 3; ++corner) {
+                if (std::abs(dot(normal, points_[positions_[mesh_.triangles[triangle * 3 + corner]]]) - d) > maxDistance_)
+                    return false;
+            }
+            return true;
+        }
+
+        /// Triangulates outline of patch by ear clipping. Leaves patch as is if outline is not
+        /// single loop, if inner vertices are used outside of patch or if it gives no gain.
+        void triangulate(int patch, const Point& normal)
+        {
+            // NOTE outline edges are the ones which reverse edge is not in patch.
+            std::unordered_map<int, int> next, corners, patchUsage;
+            std::size_t outlineEdges = 0;
+            for (std::size_t triangle : triangles_[patch]) {
+                const int* triangleCorners = &mesh_.triangles[triangle * 3];
+                for (std::size_t corner = 0; corner < 3; ++corner) {
+                    int from = positions_[triangleCorners[corner]], to = positions_[triangleCorners[(corner + 1) % 3]];
+                    corners.emplace(from, triangleCorners[corner]);
+                    ++patchUsage[from];
+                    auto reverse = edges_.find(getEdgeKey(to, from));
+                    if (reverse != edges_.end() && reverse->second >= 0 && patches_[reverse->second] == patch)
+                        continue;
+                    if (!next.emplace(from, to).second)
+                        return;
+                    ++outlineEdges;
+                }
+            }
+
+            std::vector<int> outline;
+            int start = next.begin()->first;
+            for (int current = start; outline.size() <= outlineEdges;) {
+                outline.push_back(current);
+                auto edge = next.find(current);
+                if (edge == next.end())
+                    return;
+                current = edge->second;
+                if (current == start)
+                    break;
+            }
+            if (outline.size() != outlineEdges)
+                return;
+
+            // NOTE vertices which are used outside of patch are kept to avoid T-junctions.
+            for (const auto& pair : patchUsage) {
+                if (next.find(pair.first) == next.end() && usage_[pair.first] != pair.second)
+                    return;
+            }
+            removeCollinear(outline, patchUsage);
+            if (outline.size() < 3 || outline.size() - 2 >= triangles_[patch].size())
+                return;
+
+            std::vector<int> result;
+            if (!clipEars(outline, normal, result))
+                return;
+
+            for (int& position : result)
+                position = corners[position];
+            merged_[patch].swap(result);
+        }
+
+        /// Removes outline vertices which are used only by patch and lie on line of neighbours.
+        void removeCollinear(std::vector<int>& outline, const std::unordered_map<int, int>& patchUsage) const
+        {
+            for (std::size_t i = 0; i < outline.size() && outline.size() > 3;) {
+                const Point& previous = points_[outline[(i + outline.size() - 1) % outline.size()]];
+                const Point& current = points_[outline[i]];
+                const Point& following = points_[outline[(i + 1) % outline.size()]];
+                Point direction = subtract(following, previous);
+                Point offset = subtract(current, previous);
+                double length = std::sqrt(dot(direction, direction));
+                Point distance = cross(direction, offset);
+                bool isCollinear = length > 0 && std::sqrt(dot(distance, distance)) / length < CollinearTolerance &&
+                                   dot(direction, offset) > 0 && dot(direction, subtract(following, current)) > 0;
+                if (isCollinear && usage_[outline[i]] == patchUsage.at(outline[i]))
+                    outline.erase(outline.begin() + i);
+                else
+                    ++i;
+            }
+        }
+
+        /// Triangulates simple polygon which follows orientation of normal.
+        bool clipEars(std::vector<int> polygon, const Point& normal, std::vector<int>& result) const
+        {
+            while (polygon.size() > 3) {
+                bool isClipped = false;
+                for (std::size_t i = 0; i < polygon.size(); ++i) {
+                    int previous = polygon[(i + polygon.size() - 1) % polygon.size()];
+                    int current = polygon[i];
+                    int following = polygon[(i + 1) % polygon.size()];
+                    if (!isEar(polygon, previous, current, following, normal))
+                        continue;
+
+                    result.insert(result.end(), { previous, current, following });
+                    polygon.erase(polygon.begin() + i);
+                    isClipped = true;
+                    break;
+                }
+                if (!isClipped)
+                    return false;
+            }
+            result.insert(result.end(), polygon.begin(), polygon.end());
+            return true;
+        }
+
+        bool isEar(const std::vector<int>& polygon, int previous, int current, int following, const Point& normal) const
+        {
+            const Point& a = points_[previous];
+            const Point& b = points_[current];
+            const Point& c = points_[following];
+            if (dot(cross(subtract(b, a), subtract(c, a)), normal) <= 0)
+                return false;
+
+            // NOTE vertex on border of ear also makes it invalid.
+            for (int position : polygon) {
+                if (position == previous || position == current || position == following)
+                    continue;
+                const Point& p = points_[position];
+                if (dot(cross(subtract(b, a), subtract(p, a)), normal) >= 0 &&
+                    dot(cross(subtract(c, b), subtract(p, b)), normal) >= 0 &&
+                    dot(cross(subtract(a, c), subtract(p, c)), normal) >= 0)
+                    return false;
+            }
+            return true;
+        }
+
+        const Mesh& mesh_;
+        const double maxDistance_;
+        /// Position id of every vertex.
+        std::vector<int> positions_;
+        /// Metric coordinates of positions.
+        std::vector<Point> points_;
+        /// Amount of triangles which use position.
+        std::vector<int> usage_;
+        std::vector<Point> normals_;
+        std::vector<bool> isMergeable_;
+        /// Key: directed edge of mergeable triangle, value: triangle or shared edge mark.
+        std::unordered_map<std::uint64_t, int> edges_;
+        /// Patch of every triangle or -1 if triangle is not mergeable.
+        std::vector<int> patches_;
+        /// Triangles of every patch starting from seed one.
+        std::vector<std::vector<std::size_t>> triangles_;
+        /// Vertex indices of merged triangles of every patch or empty if patch is kept as is.
+        std::vector<std::vector<int>> merged_;
+    };
+}
+
+MeshFaceMerger::MeshFaceMerger(double maxDistance) : maxDistance_(maxDistance)
+{
+}
+
+void MeshFaceMerger::merge(const Mesh& source, Mesh& target) const
+{
+    std::size_t vertexCount = source.vertices.size() / 3;
+    if (!source.elementRanges.empty() || source.colors.size() != vertexCount || source.uvs.size() != vertexCount * 2) {
+        target.vertices = source.vertices;
+        target.triangles = source.triangles;
+        target.colors = source.colors;
+        target.uvs = source.uvs;
+        target.elementRanges = source.elementRanges;
+        return;
+    }
+
+    Merge merge(source, maxDistance_);
+    merge.write(target);
+}
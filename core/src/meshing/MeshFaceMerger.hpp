@@ -0,0 +1,30 @@
+#ifndef MESHING_MESHFACEMERGER_HPP_DEFINED
+#define MESHING_MESHFACEMERGER_HPP_DEFINED
+
+#include "meshing/MeshTypes.hpp"
+
+namespace utymap { namespace meshing {
+
+/// Merges adjacent coplanar triangles which have the same color and texture coordinates, e.g.
+/// of flat roofs and walls, into polygons and triangulates them with minimal amount of
+/// triangles. Patch is merged only if its outline is single loop and its vertices are not
+/// used by other triangles except outline ones, so no cracks appear and look is the same.
+class MeshFaceMerger final
+{
+public:
+    /// Creates merger which treats vertices closer than max distance (in meters) to plane
+    /// of patch as lying on it.
+    explicit MeshFaceMerger(double maxDistance = 0.01);
+
+    /// Writes merged copy of source mesh to target. Triangles which are not merged keep their
+    /// order. Meshes with element ranges or without color and texture coordinate of every
+    /// vertex are copied as is. Vertex index is not copied.
+    void merge(const Mesh& source, Mesh& target) const;
+
+private:
+    const double maxDistance_;
+};
+
+}}
+
+#endif // MESHING_MESHFACEMERGER_HPP_DEFINED
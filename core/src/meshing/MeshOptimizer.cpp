@@ -0,0 +1,220 @@
+#include "meshing/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <sstream>
+
+using namespace utymap::meshing;
+
+namespace {
+    /// Orders triangles using Tipsify: triangles are emitted as fans around vertices which
+    /// are likely still in cache, dead ends are resolved by recently used vertices.
+    /// See "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", Sander et al.
+    class TriangleOrderer final
+    {
+    public:
+        TriangleOrderer(std::size_t vertexCount, std::size_t cacheSize) :
+            localIds_(vertexCount, -1), cacheSize_(cacheSize)
+        {
+        }
+
+        /// Appends indices of reordered triangles from given range to result.
+        void order(const std::vector<int>& triangles, std::size_t first, std::size_t count, std::vector<int>& result)
+        {
+            // NOTE vertices are mapped to local ids, so buffers depend on range size only.
+            vertices_.clear();
+            for (std::size_t i = first * 3; i < (first + count) * 3; ++i) {
+                int& localId = localIds_[triangles[i]];
+                if (localId < 0) {
+                    localId = static_cast<int>(vertices_.size());
+                    vertices_.push_back(triangles[i]);
+                }
+            }
+
+            buildAdjacency(triangles, first, count);
+
+            timestamps_.assign(vertices_.size(), 0);
+            emitted_.assign(count, false);
+            deadEnd_.clear();
+            std::size_t time = cacheSize_ + 1;
+            std::size_t cursor = 0;
+            int fan = vertices_.empty() ? -1 : 0;
+
+            while (fan >= 0) {
+                candidates_.clear();
+                for (std::size_t i = offsets_[fan]; i < offsets_[fan + 1]; ++i) {
+                    std::size_t triangle = adjacency_[i];
+                    if (emitted_[triangle])
+                        continue;
+                    emitted_[triangle] = true;
+
+                    for (std::size_t corner = 0; corner < 3; ++corner) {
+                        int vertex = triangles[(first + triangle) * 3 + corner];
+                        int localId = localIds_[vertex];
+                        result.push_back(vertex);
+                        deadEnd_.push_back(localId);
+                        candidates_.push_back(localId);
+                        --live_[localId];
+                        if (time - timestamps_[localId] > cacheSize_)
+                            timestamps_[localId] = time++;
+                    }
+                }
+                fan = getNextVertex(time, cursor);
+            }
+
+            for (int vertex : vertices_)
+                localIds_[vertex] = -1;
+        }
+
+    private:
+        /// Builds lists of triangles which use every vertex and counts its live triangles.
+        void buildAdjacency(const std::vector<int>& triangles, std::size_t first, std::size_t count)
+        {
+            offsets_.assign(vertices_.size() + 1, 0);
+            for (std::size_t i = first * 3; i < (first + count) * 3; ++i)
+                ++offsets_[localIds_[triangles[i]] + 1];
+            for (std::size_t i = 1; i < offsets_.size(); ++i)
+                offsets_[i] += offsets_[i - 1];
+
+            live_.assign(vertices_.size(), 0);
+            adjacency_.resize(count * 3);
+            for (std::size_t i = first * 3; i < (first + count) * 3; ++i) {
+                int localId = localIds_[triangles[i]];
+                adjacency_[offsets_[localId] + live_[localId]++] = i / 3 - first;
+            }
+        }
+
+        /// Returns next fan vertex: one of the last candidates which stays in cache after its
+        /// fan is emitted, otherwise dead end vertex or next vertex with live triangles.
+        int getNextVertex(std::size_t time, std::size_t& cursor)
+        {
+            int best = -1;
+            std::size_t bestPriority = 0;
+            for (int localId : candidates_) {
+                if (live_[localId] == 0)
+                    continue;
+                std::size_t age = time - timestamps_[localId];
+                std::size_t priority = age + 2 * live_[localId] <= cacheSize_ ? age + 1 : 1;
+                if (priority > bestPriority) {
+                    best = localId;
+                    bestPriority = priority;
+                }
+            }
+            if (best >= 0)
+                return best;
+
+            while (!deadEnd_.empty()) {
+                int localId = deadEnd_.back();
+                deadEnd_.pop_back();
+                if (live_[localId] > 0)
+                    return localId;
+            }
+
+            for (; cursor < vertices_.size(); ++cursor) {
+                if (live_[cursor] > 0)
+                    return static_cast<int>(cursor);
+            }
+            return -1;
+        }
+
+        /// Local id of mesh vertex or -1 if it is not used by current range.
+        std::vector<int> localIds_;
+        /// Mesh vertices of current range by local id.
+        std::vector<int> vertices_;
+        std::vector<std::size_t> offsets_;
+        std::vector<std::size_t> adjacency_;
+        std::vector<std::size_t> live_;
+        std::vector<std::size_t> timestamps_;
+        std::vector<bool> emitted_;
+        std::vector<int> deadEnd_;
+        std::vector<int> candidates_;
+        const std::size_t cacheSize_;
+    };
+
+    /// Copies attributes of every vertex to its new position. Missing attributes are zero.
+    template <typename T>
+    void remapAttributes(const std::vector<T>& source, std::size_t size, const std::vector<int>& remap, std::vector<T>& target)
+    {
+        if (source.empty())
+            return;
+
+        target.assign(remap.size() * size, 0);
+        for (std::size_t vertex = 0; vertex < remap.size() && (vertex + 1) * size <= source.size(); ++vertex)
+            std::copy_n(source.begin() + vertex * size, size, target.begin() + remap[vertex] * size);
+    }
+}
+
+MeshOptimizer::MeshOptimizer(const std::string& meshNames, std::size_t cacheSize) :
+    cacheSize_(cacheSize)
+{
+    std::stringstream ss(meshNames);
+    std::string prefix;
+    while (getline(ss, prefix, ',')) {
+        if (!prefix.empty())
+            prefixes_.push_back(prefix);
+    }
+}
+
+bool MeshOptimizer::canOptimize(const std::string& name) const
+{
+    return std::any_of(prefixes_.begin(), prefixes_.end(), [&](const std::string& prefix) {
+        return name.compare(0, prefix.size(), prefix) == 0;
+    });
+}
+
+void MeshOptimizer::optimize(const Mesh& source, Mesh& target) const
+{
+    std::size_t vertexCount = source.vertices.size() / 3;
+    std::size_t triangleCount = source.triangles.size() / 3;
+    TriangleOrderer orderer(vertexCount, cacheSize_);
+    target.triangles.reserve(source.triangles.size());
+
+    // NOTE triangles which are not covered by element ranges are ordered as separate ranges.
+    std::size_t next = 0;
+    for (std::size_t i = 0; i + 2 < source.elementRanges.size(); i += 3) {
+        auto first = static_cast<std::size_t>(source.elementRanges[i + 1]);
+        auto count = static_cast<std::size_t>(source.elementRanges[i + 2]);
+        if (first > next)
+            orderer.order(source.triangles, next, first - next, target.triangles);
+        orderer.order(source.triangles, first, count, target.triangles);
+        next = first + count;
+    }
+    if (triangleCount > next)
+        orderer.order(source.triangles, next, triangleCount - next, target.triangles);
+
+    std::vector<int> remap(vertexCount, -1);
+    int nextVertex = 0;
+    for (int& index : target.triangles) {
+        if (remap[index] < 0)
+            remap[index] = nextVertex++;
+        index = remap[index];
+    }
+    // NOTE unused vertices are kept at the end.
+    for (int& index : remap) {
+        if (index < 0)
+            index = nextVertex++;
+    }
+
+    remapAttributes(source.vertices, 3, remap, target.vertices);
+    remapAttributes(source.colors, 1, remap, target.colors);
+    remapAttributes(source.uvs, 2, remap, target.uvs);
+    target.elementRanges = source.elementRanges;
+}
+
+double MeshOptimizer::getAverageCacheMissRatio(const std::vector<int>& triangles, std::size_t cacheSize)
+{
+    if (triangles.size() < 3)
+        return 0;
+
+    std::deque<int> cache;
+    std::size_t misses = 0;
+    for (int index : triangles) {
+        if (std::find(cache.begin(), cache.end(), index) != cache.end())
+            continue;
+        ++misses;
+        cache.push_back(index);
+        if (cache.size() > cacheSize)
+            cache.pop_front();
+    }
+    return static_cast<double>(misses) / (triangles.size() / 3);
+}
@@ -0,0 +1,40 @@
+#ifndef MESHING_MESHOPTIMIZER_HPP_DEFINED
+#define MESHING_MESHOPTIMIZER_HPP_DEFINED
+
+#include "meshing/MeshTypes.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace utymap { namespace meshing {
+
+/// Reorders mesh data for rendering: triangles are reordered using Tipsify algorithm to reuse
+/// post transform vertex cache and vertices are reordered by first use to improve fetch locality.
+class MeshOptimizer final
+{
+public:
+    /// Size of vertex cache which is assumed by default.
+    static const std::size_t DefaultCacheSize = 16;
+
+    /// Creates optimizer for meshes which names start with one of comma separated prefixes.
+    explicit MeshOptimizer(const std::string& meshNames, std::size_t cacheSize = DefaultCacheSize);
+
+    /// Checks whether mesh with given name should be optimized.
+    bool canOptimize(const std::string& name) const;
+
+    /// Writes optimized copy of source mesh to target. Triangles are reordered only inside of
+    /// their element range, so element ranges are copied as is. Vertex index is not copied.
+    void optimize(const Mesh& source, Mesh& target) const;
+
+    /// Returns average amount of vertex cache misses per triangle for FIFO cache of given size.
+    static double getAverageCacheMissRatio(const std::vector<int>& triangles, std::size_t cacheSize);
+
+private:
+    std::vector<std::string> prefixes_;
+    const std::size_t cacheSize_;
+};
+
+}}
+
+#endif // MESHING_MESHOPTIMIZER_HPP_DEFINED
@@ -0,0 +1,275 @@
+#include "meshing/MeshPackage.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+
+using namespace utymap;
+using namespace utymap::meshing;
+
+namespace {
+    ///                                     Package file format
+    ///------------------------------------------------------------------------------------------------------|
+    ///   DESCRIPTION    |                       DETAILS                                                     |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Header       |  Magic (4b) and padding (4b)                                                      |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Tiles        |  List of tiles, each is represented by amount of meshes (8b) and meshes           |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Index        |  Entries sorted by quadkey: level of detail, x, y (4b each), padding (4b) and     |
+    ///                  |  offset of tile (8b)                                                              |
+    ///------------------------------------------------------------------------------------------------------|
+    ///     Footer       |  Offset of index (8b), amount of tiles (8b), magic (4b) and padding (4b)          |
+    ///------------------------------------------------------------------------------------------------------|
+    /// Mesh: origin longitude and latitude (8b each), name size with terminating zero, vertex count and
+    /// triangle count (4b each), padding (4b), name, packed vertices (24b each) and triangle indices (4b
+    /// each). Name and triangles are padded to 8 bytes, so every mesh is aligned in mapped file.
+    const std::uint32_t PackageMagic = 0x31504D55;
+    const std::size_t Alignment = 8;
+
+    struct MeshHeader final
+    {
+        double longitude;
+        double latitude;
+        std::uint32_t nameSize;
+        std::uint32_t vertexCount;
+        std::uint32_t triangleCount;
+        std::uint32_t padding;
+    };
+
+    struct IndexEntry final
+    {
+        std::int32_t levelOfDetail;
+        std::int32_t tileX;
+        std::int32_t tileY;
+        std::uint32_t padding;
+        std::uint64_t offset;
+    };
+
+    struct Footer final
+    {
+        std::uint64_t indexOffset;
+        std::uint64_t tileCount;
+        std::uint32_t magic;
+        std::uint32_t padding;
+    };
+
+    inline bool lessQuadKey(const IndexEntry& entry, const QuadKey& quadKey)
+    {
+        return std::tie(entry.levelOfDetail, entry.tileX, entry.tileY) <
+            std::tie(quadKey.levelOfDetail, quadKey.tileX, quadKey.tileY);
+    }
+
+    inline std::size_t align(std::size_t size)
+    {
+        return (size + Alignment - 1) / Alignment * Alignment;
+    }
+
+    template <typename T>
+    inline void append(std::string& buffer, const T& value)
+    {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    inline void appendAligned(std::string& buffer, const void* data, std::size_t size)
+    {
+        buffer.append(static_cast<const char*>(data), size);
+        buffer.append(align(size) - size, '\0');
+    }
+}
+
+class MeshPackageWriter::MeshPackageWriterImpl
+{
+public:
+    explicit MeshPackageWriterImpl(const std::string& path) :
+        file_(path, std::ios::out | std::ios::binary | std::ios::trunc),
+        index_(), offset_(0), isFinished_(false)
+    {
+        if (!file_.good())
+            throw std::domain_error("Cannot create mesh package file: " + path);
+        std::string header;
+        append(header, PackageMagic);
+        append(header, std::uint32_t(0));
+        write(header);
+    }
+
+    void add(const QuadKey& quadKey, const std::vector<PackedMesh>& meshes)
+    {
+        // NOTE tile is encoded outside of lock: only file write is serialized.
+        std::string buffer;
+        append(buffer, static_cast<std::uint64_t>(meshes.size()));
+        for (const auto& mesh : meshes) {
+            append(buffer, MeshHeader {
+                mesh.origin.longitude, mesh.origin.latitude,
+                static_cast<std::uint32_t>(mesh.name.size() + 1),
+                static_cast<std::uint32_t>(mesh.vertices.size()),
+                static_cast<std::uint32_t>(mesh.triangles.size()), 0 });
+            appendAligned(buffer, mesh.name.c_str(), mesh.name.size() + 1);
+            appendAligned(buffer, mesh.vertices.data(), mesh.vertices.size() * sizeof(PackedVertex));
+            appendAligned(buffer, mesh.triangles.data(), mesh.triangles.size() * sizeof(int));
+        }
+
+        std::lock_guard<std::mutex> lock(lock_);
+        if (isFinished_)
+            throw std::domain_error("Mesh package is already finished.");
+        index_.push_back(IndexEntry { quadKey.levelOfDetail, quadKey.tileX, quadKey.tileY, 0, offset_ });
+        write(buffer);
+    }
+
+    void finish()
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (isFinished_)
+            return;
+        isFinished_ = true;
+
+        std::sort(index_.begin(), index_.end(), [](const IndexEntry& a, const IndexEntry& b) {
+            return std::tie(a.levelOfDetail, a.tileX, a.tileY) < std::tie(b.levelOfDetail, b.tileX, b.tileY);
+        });
+
+        std::string buffer;
+        Footer footer { offset_, index_.size(), PackageMagic, 0 };
+        appendAligned(buffer, index_.data(), index_.size() * sizeof(IndexEntry));
+        append(buffer, footer);
+        write(buffer);
+        file_.close();
+        if (file_.fail())
+            throw std::domain_error("Cannot write mesh package file.");
+    }
+
+private:
+    void write(const std::string& buffer)
+    {
+        file_.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        offset_ += buffer.size();
+    }
+
+    std::mutex lock_;
+    std::ofstream file_;
+    std::vector<IndexEntry> index_;
+    std::uint64_t offset_;
+    bool isFinished_;
+};
+
+class MeshPackageReader::MeshPackageReaderImpl
+{
+public:
+    explicit MeshPackageReaderImpl(const std::string& path) :
+        mapping_(path.c_str(), boost::interprocess::read_only),
+        region_(mapping_, boost::interprocess::read_only),
+        data_(static_cast<const char*>(region_.get_address())),
+        size_(region_.get_size()),
+        index_(nullptr), tileCount_(0)
+    {
+        Footer footer;
+        if (size_ < sizeof(std::uint64_t) + sizeof(Footer))
+            throw std::domain_error("Invalid mesh package file: " + path);
+        std::memcpy(&footer, data_ + size_ - sizeof(Footer), sizeof(Footer));
+        if (footer.magic != PackageMagic ||
+            footer.indexOffset + footer.tileCount * sizeof(IndexEntry) > size_ - sizeof(Footer))
+            throw std::domain_error("Mesh package file is not finished: " + path);
+
+        index_ = reinterpret_cast<const IndexEntry*>(data_ + footer.indexOffset);
+        tileCount_ = static_cast<std::size_t>(footer.tileCount);
+    }
+
+    bool contains(const QuadKey& quadKey) const
+    {
+        return find(quadKey) != nullptr;
+    }
+
+    bool read(const QuadKey& quadKey, const MeshCallback& callback) const
+    {
+        const IndexEntry* entry = find(quadKey);
+        if (entry == nullptr)
+            return false;
+
+        const char* position = data_ + entry->offset;
+        std::uint64_t meshCount = *reinterpret_cast<const std::uint64_t*>(position);
+        position += sizeof(std::uint64_t);
+        for (std::uint64_t i = 0; i < meshCount; ++i) {
+            const auto& header = *reinterpret_cast<const MeshHeader*>(position);
+            position += sizeof(MeshHeader);
+            const char* name = position;
+            position += align(header.nameSize);
+            const auto* vertices = reinterpret_cast<const PackedVertex*>(position);
+            position += align(header.vertexCount * sizeof(PackedVertex));
+            const auto* triangles = reinterpret_cast<const int*>(position);
+            position += align(header.triangleCount * sizeof(int));
+
+            callback(name, GeoCoordinate(header.latitude, header.longitude),
+                     vertices, header.vertexCount, triangles, header.triangleCount);
+        }
+        return true;
+    }
+
+private:
+    const IndexEntry* find(const QuadKey& quadKey) const
+    {
+        const IndexEntry* end = index_ + tileCount_;
+        const IndexEntry* entry = std::lower_bound(index_, end, quadKey, lessQuadKey);
+        if (entry == end || entry->levelOfDetail != quadKey.levelOfDetail ||
+            entry->tileX != quadKey.tileX || entry->tileY != quadKey.tileY)
+            return nullptr;
+        return entry;
+    }
+
+    boost::interprocess::file_mapping mapping_;
+    boost::interprocess::mapped_region region_;
+    const char* data_;
+    std::size_t size_;
+    const IndexEntry* index_;
+    std::size_t tileCount_;
+};
+
+MeshPackageWriter::MeshPackageWriter(const std::string& path) :
+    pimpl_(utymap::utils::make_unique<MeshPackageWriterImpl>(path))
+{
+}
+
+MeshPackageWriter::~MeshPackageWriter()
+{
+    try {
+        pimpl_->finish();
+    }
+    catch (...) {
+        // NOTE destructor must not throw: call finish explicitly to get errors.
+    }
+}
+
+void MeshPackageWriter::add(const QuadKey& quadKey, const std::vector<PackedMesh>& meshes)
+{
+    pimpl_->add(quadKey, meshes);
+}
+
+void MeshPackageWriter::finish()
+{
+    pimpl_->finish();
+}
+
+MeshPackageReader::MeshPackageReader(const std::string& path) :
+    pimpl_(utymap::utils::make_unique<MeshPackageReaderImpl>(path))
+{
+}
+
+MeshPackageReader::~MeshPackageReader()
+{
+}
+
+bool MeshPackageReader::contains(const QuadKey& quadKey) const
+{
+    return pimpl_->contains(quadKey);
+}
+
+bool MeshPackageReader::read(const QuadKey& quadKey, const MeshCallback& callback) const
+{
+    return pimpl_->read(quadKey, callback);
+}
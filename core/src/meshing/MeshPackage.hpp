@@ -0,0 +1,66 @@
+#ifndef MESHING_MESHPACKAGE_HPP_DEFINED
+#define MESHING_MESHPACKAGE_HPP_DEFINED
+
+#include "GeoCoordinate.hpp"
+#include "QuadKey.hpp"
+#include "meshing/PackedMesh.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace utymap { namespace meshing {
+
+/// Writes packed meshes of many quadkeys to single package file which is read using memory
+/// mapping. Quadkeys can be added from different threads.
+class MeshPackageWriter final
+{
+public:
+    explicit MeshPackageWriter(const std::string& path);
+
+    MeshPackageWriter(const MeshPackageWriter&) = delete;
+    MeshPackageWriter& operator=(const MeshPackageWriter&) = delete;
+
+    /// Finishes package if it is not finished yet.
+    ~MeshPackageWriter();
+
+    /// Appends meshes of quadkey. Quadkey should be added only once.
+    void add(const utymap::QuadKey& quadKey, const std::vector<PackedMesh>& meshes);
+
+    /// Writes index of quadkeys and closes file. No quadkeys can be added after that.
+    void finish();
+
+private:
+    class MeshPackageWriterImpl;
+    std::unique_ptr<MeshPackageWriterImpl> pimpl_;
+};
+
+/// Reads meshes of package file without copying: pointers refer to mapped file and are
+/// valid only inside callback. Thread safe.
+class MeshPackageReader final
+{
+public:
+    /// Receives mesh name, origin, vertices with their count and triangle indices with their count.
+    typedef std::function<void(const char*, const utymap::GeoCoordinate&,
+                               const PackedVertex*, std::size_t,
+                               const int*, std::size_t)> MeshCallback;
+
+    explicit MeshPackageReader(const std::string& path);
+
+    ~MeshPackageReader();
+
+    /// Checks whether package contains given quadkey.
+    bool contains(const utymap::QuadKey& quadKey) const;
+
+    /// Calls callback for every mesh of quadkey. Returns false if there is no such quadkey.
+    bool read(const utymap::QuadKey& quadKey, const MeshCallback& callback) const;
+
+private:
+    class MeshPackageReaderImpl;
+    std::unique_ptr<MeshPackageReaderImpl> pimpl_;
+};
+
+}}
+
+#endif // MESHING_MESHPACKAGE_HPP_DEFINED
@@ -0,0 +1,86 @@
+#include "meshing/MeshPool.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <algorithm>
+
+using namespace utymap::meshing;
+
+namespace {
+    /// Returns expected size which follows growth immediately and decays slowly, so one
+    /// small mesh does not make next large one regrow its buffers.
+    std::size_t getExpected(std::size_t expected, std::size_t observed)
+    {
+        return std::max(observed, expected - expected / 8);
+    }
+}
+
+const std::size_t MeshPool::MaxFreeMeshes;
+
+void MeshPool::Releaser::operator()(Mesh* mesh) const
+{
+    MeshPool::local().release(mesh);
+}
+
+MeshPool& MeshPool::local()
+{
+    static thread_local MeshPool pool;
+    return pool;
+}
+
+MeshPool::MeshPtr MeshPool::acquire(const std::string& name, bool isIndexed)
+{
+    Entry& entry = entries_[getKind(name)];
+    if (entry.meshes.empty()) {
+        auto mesh = utymap::utils::make_unique<Mesh>(name, isIndexed);
+        mesh->vertices.reserve(entry.sizes.vertices);
+        mesh->triangles.reserve(entry.sizes.triangles);
+        mesh->colors.reserve(entry.sizes.colors);
+        mesh->uvs.reserve(entry.sizes.uvs);
+        mesh->elementRanges.reserve(entry.sizes.elementRanges);
+        return MeshPtr(mesh.release());
+    }
+
+    MeshPtr mesh(entry.meshes.back().release());
+    entry.meshes.pop_back();
+    mesh->name = name;
+    mesh->isIndexed = isIndexed;
+    return mesh;
+}
+
+void MeshPool::release(Mesh* mesh)
+{
+    std::unique_ptr<Mesh> owned(mesh);
+    if (owned == nullptr)
+        return;
+
+    Entry& entry = entries_[getKind(owned->name)];
+    entry.sizes.vertices = getExpected(entry.sizes.vertices, owned->vertices.size());
+    entry.sizes.triangles = getExpected(entry.sizes.triangles, owned->triangles.size());
+    entry.sizes.colors = getExpected(entry.sizes.colors, owned->colors.size());
+    entry.sizes.uvs = getExpected(entry.sizes.uvs, owned->uvs.size());
+    entry.sizes.elementRanges = getExpected(entry.sizes.elementRanges, owned->elementRanges.size());
+
+    if (entry.meshes.size() >= MaxFreeMeshes)
+        return;
+
+    owned->vertices.clear();
+    owned->triangles.clear();
+    owned->colors.clear();
+    owned->uvs.clear();
+    owned->elementRanges.clear();
+    owned->vertexIndex.clear();
+    entry.meshes.push_back(std::move(owned));
+}
+
+std::size_t MeshPool::freeCount(const std::string& name) const
+{
+    auto entry = entries_.find(name.substr(0, name.find(':')));
+    return entry == entries_.end() ? 0 : entry->second.meshes.size();
+}
+
+const std::string& MeshPool::getKind(const std::string& name)
+{
+    // NOTE kind buffer is reused, so lookup of known kind does not allocate.
+    kind_.assign(name, 0, name.find(':'));
+    return kind_;
+}
@@ -0,0 +1,65 @@
+#ifndef MESHING_MESHPOOL_HPP_DEFINED
+#define MESHING_MESHPOOL_HPP_DEFINED
+
+#include "meshing/MeshTypes.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace utymap { namespace meshing {
+
+/// Keeps buffers of meshes which are already reported, so next tile builds reuse them instead
+/// of allocating new ones. Meshes are grouped by kind which is name part before first colon,
+/// e.g. "building" for "building:42". Fresh meshes are reserved using sizes of meshes of the
+/// same kind seen recently. Pool is not thread safe: use pool of current thread.
+class MeshPool final
+{
+public:
+    /// Returns mesh to pool of thread which destroys pointer.
+    struct Releaser final
+    {
+        void operator()(Mesh* mesh) const;
+    };
+
+    typedef std::unique_ptr<Mesh, Releaser> MeshPtr;
+
+    /// Max amount of free meshes kept for one kind.
+    static const std::size_t MaxFreeMeshes = 4;
+
+    /// Returns pool of current thread.
+    static MeshPool& local();
+
+    /// Checks out empty mesh with given name.
+    MeshPtr acquire(const std::string& name, bool isIndexed = false);
+
+    /// Takes ownership of mesh: records its sizes and keeps its buffers if there is a room.
+    void release(Mesh* mesh);
+
+    /// Returns amount of free meshes kept for kind of given mesh name.
+    std::size_t freeCount(const std::string& name) const;
+
+private:
+    /// Expected sizes of mesh buffers.
+    struct Sizes final
+    {
+        std::size_t vertices = 0, triangles = 0, colors = 0, uvs = 0, elementRanges = 0;
+    };
+
+    struct Entry final
+    {
+        Sizes sizes;
+        std::vector<std::unique_ptr<Mesh>> meshes;
+    };
+
+    const std::string& getKind(const std::string& name);
+
+    std::unordered_map<std::string, Entry> entries_;
+    std::string kind_;
+};
+
+}}
+
+#endif // MESHING_MESHPOOL_HPP_DEFINED
@@ -0,0 +1,131 @@
+#ifndef MESHING_MESHSPLITTER_HPP_DEFINED
+#define MESHING_MESHSPLITTER_HPP_DEFINED
+
+#include "meshing/PackedMesh.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace utymap { namespace meshing {
+
+/// Splits packed mesh into chunks which can be indexed by 16 bit indices. If mesh does not
+/// fit, its triangles are split recursively by median of their centers along the longer side
+/// of their bounds, so every chunk covers compact part of the mesh.
+class MeshSplitter final
+{
+public:
+    /// Max amount of vertices in chunk by default: the largest index is kept free, so it can
+    /// be used as primitive restart one.
+    static const std::size_t MaxVertices = 65535;
+
+    /// Callback which receives vertices and triangles of chunk. Buffers are reused for next chunk.
+    typedef std::function<void(const PackedVertex*, std::size_t, const std::uint16_t*, std::size_t)> ChunkCallback;
+
+    explicit MeshSplitter(std::size_t maxVertices = MaxVertices) :
+        maxVertices_(std::max<std::size_t>(3, std::min<std::size_t>(maxVertices, MaxVertices + 1)))
+    {
+    }
+
+    /// Splits mesh given by vertices and triangle indices calling callback for every chunk.
+    void split(const PackedVertex* vertices, std::size_t vertexCount,
+               const int* triangles, std::size_t triangleSize,
+               const ChunkCallback& callback)
+    {
+        if (vertexCount <= maxVertices_) {
+            chunkTriangles_.assign(triangles, triangles + triangleSize);
+            callback(vertices, vertexCount, chunkTriangles_.data(), chunkTriangles_.size());
+            return;
+        }
+
+        centers_.clear();
+        centers_.reserve(triangleSize / 3);
+        for (std::size_t i = 0; i + 2 < triangleSize; i += 3) {
+            const PackedVertex& v1 = vertices[triangles[i]];
+            const PackedVertex& v2 = vertices[triangles[i + 1]];
+            const PackedVertex& v3 = vertices[triangles[i + 2]];
+            centers_.push_back(Center { (v1.x + v2.x + v3.x) / 3, (v1.y + v2.y + v3.y) / 3, i / 3 });
+        }
+        chunkSources_.clear();
+        remap_.assign(vertexCount, -1);
+        split(vertices, triangles, 0, centers_.size(), callback);
+    }
+
+private:
+    /// Center of triangle with its index.
+    struct Center final
+    {
+        float x, y;
+        std::size_t triangle;
+    };
+
+    /// Reports triangles of given range as chunk if their vertices fit, otherwise splits range in halves.
+    void split(const PackedVertex* vertices, const int* triangles, std::size_t begin, std::size_t end,
+               const ChunkCallback& callback)
+    {
+        if (collect(vertices, triangles, begin, end) || end - begin < 2) {
+            callback(chunkVertices_.data(), chunkVertices_.size(), chunkTriangles_.data(), chunkTriangles_.size());
+            return;
+        }
+
+        float minX = std::numeric_limits<float>::max(), minY = minX;
+        float maxX = std::numeric_limits<float>::lowest(), maxY = maxX;
+        for (std::size_t i = begin; i < end; ++i) {
+            minX = std::min(minX, centers_[i].x);
+            minY = std::min(minY, centers_[i].y);
+            maxX = std::max(maxX, centers_[i].x);
+            maxY = std::max(maxY, centers_[i].y);
+        }
+
+        bool isVertical = maxY - minY > maxX - minX;
+        std::size_t middle = begin + (end - begin) / 2;
+        std::nth_element(centers_.begin() + begin, centers_.begin() + middle, centers_.begin() + end,
+            [isVertical](const Center& lhs, const Center& rhs) {
+                return isVertical ? lhs.y < rhs.y : lhs.x < rhs.x;
+            });
+        split(vertices, triangles, begin, middle, callback);
+        split(vertices, triangles, middle, end, callback);
+    }
+
+    /// Copies vertices and triangles of given range to chunk buffers. Returns false and
+    /// stops as soon as vertices do not fit.
+    bool collect(const PackedVertex* vertices, const int* triangles, std::size_t begin, std::size_t end)
+    {
+        for (int source : chunkSources_)
+            remap_[source] = -1;
+        chunkVertices_.clear();
+        chunkTriangles_.clear();
+        chunkSources_.clear();
+
+        for (std::size_t i = begin; i < end; ++i) {
+            const int* triangle = triangles + centers_[i].triangle * 3;
+            for (std::size_t corner = 0; corner < 3; ++corner) {
+                int& index = remap_[triangle[corner]];
+                if (index < 0) {
+                    if (chunkVertices_.size() == maxVertices_)
+                        return false;
+                    index = static_cast<int>(chunkVertices_.size());
+                    chunkVertices_.push_back(vertices[triangle[corner]]);
+                    chunkSources_.push_back(triangle[corner]);
+                }
+                chunkTriangles_.push_back(static_cast<std::uint16_t>(index));
+            }
+        }
+        return true;
+    }
+
+    const std::size_t maxVertices_;
+    std::vector<Center> centers_;
+    /// Index of mesh vertex in current chunk or -1.
+    std::vector<int> remap_;
+    std::vector<PackedVertex> chunkVertices_;
+    /// Mesh vertices which are copied to current chunk.
+    std::vector<int> chunkSources_;
+    std::vector<std::uint16_t> chunkTriangles_;
+};
+
+}}
+
+#endif // MESHING_MESHSPLITTER_HPP_DEFINED
@@ -3,8 +3,10 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <limits>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace utymap { namespace meshing {
@@ -193,15 +195,55 @@ struct Mesh final
     std::vector<int> triangles;
     std::vector<int> colors;
     std::vector<double> uvs;
+    /// If set, mesh builder reuses existing vertex with the same position, color and texture
+    /// coordinates instead of adding new one.
+    bool isIndexed;
+    /// Key: hash of vertex attributes, value: indices of vertices which have it. Used only by indexed mesh.
+    std::unordered_map<std::size_t, std::vector<int>> vertexIndex;
+    /// Triangle ranges of elements merged into the mesh: interleaved element id, index of
+    /// first triangle and amount of triangles. Empty if mesh represents single element.
+    std::vector<std::uint64_t> elementRanges;
 
-    explicit Mesh(const std::string& name) :
-       name(name)
+    explicit Mesh(const std::string& name, bool isIndexed = false) :
+       name(name), isIndexed(isIndexed)
     {
     }
 
     /// disable copying to prevent accidental copy
     Mesh(const Mesh&) = delete;
     Mesh& operator=(const Mesh&) = delete;
+
+    /// Returns amount of bytes allocated by mesh buffers.
+    std::size_t memoryUsage() const
+    {
+        std::size_t usage = sizeof(Mesh) + name.capacity() +
+            vertices.capacity() * sizeof(double) + triangles.capacity() * sizeof(int) +
+            colors.capacity() * sizeof(int) + uvs.capacity() * sizeof(double) +
+            elementRanges.capacity() * sizeof(std::uint64_t);
+        for (const auto& pair : vertexIndex)
+            usage += sizeof(pair) + pair.second.capacity() * sizeof(int);
+        return usage;
+    }
+};
+
+/// Represents many copies of the same prototype mesh placed by transforms.
+struct MeshInstances final
+{
+    /// Amount of values in one instance transform.
+    static const std::size_t TransformSize = 6;
+
+    /// Prototype geometry: vertices are relative to instance position.
+    Mesh prototype;
+    /// Interleaved instance transforms: longitude, latitude, elevation, scale, rotation
+    /// around vertical axis in radians and color seed in [0, 1).
+    std::vector<double> transforms;
+
+    explicit MeshInstances(const std::string& name) : prototype(name)
+    {
+    }
+
+    /// Returns amount of instances.
+    std::size_t size() const { return transforms.size() / TransformSize; }
 };
 
 using Contour = std::vector<utymap::meshing::Vector2>;
@@ -0,0 +1,70 @@
+#ifndef MESHING_PACKEDMESH_HPP_DEFINED
+#define MESHING_PACKEDMESH_HPP_DEFINED
+
+#include "GeoCoordinate.hpp"
+#include "meshing/MeshTypes.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace utymap { namespace meshing {
+
+/// Single precision vertex with all attributes interleaved. Layout matches what consumers
+/// like Unity use directly: position, RGBA8 color and texture coordinates.
+struct PackedVertex final
+{
+    /// Position relative to mesh origin: longitude, latitude and elevation.
+    float x, y, z;
+    /// Color components in r, g, b, a order.
+    std::uint8_t r, g, b, a;
+    /// Texture coordinates.
+    float u, v;
+};
+
+static_assert(sizeof(PackedVertex) == 24, "Packed vertex should not have padding.");
+
+/// Compact representation of mesh which is more than twice smaller than mesh and can be
+/// marshalled without conversion.
+struct PackedMesh final
+{
+    std::string name;
+    /// Origin which vertex positions are relative to.
+    utymap::GeoCoordinate origin;
+    std::vector<PackedVertex> vertices;
+    std::vector<int> triangles;
+
+    /// Packs mesh using given origin. Usually origin is corner of tile, so relative positions
+    /// keep enough precision for single precision floats.
+    static PackedMesh pack(const Mesh& mesh, const utymap::GeoCoordinate& origin)
+    {
+        PackedMesh packed;
+        packed.name = mesh.name;
+        packed.origin = origin;
+        packed.triangles = mesh.triangles;
+
+        std::size_t count = mesh.vertices.size() / 3;
+        packed.vertices.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            // NOTE some of builders do not produce colors or texture coordinates for copied vertices.
+            auto color = static_cast<std::uint32_t>(i < mesh.colors.size() ? mesh.colors[i] : 0);
+            bool hasUv = i * 2 + 1 < mesh.uvs.size();
+            packed.vertices.push_back(PackedVertex {
+                static_cast<float>(mesh.vertices[i * 3] - origin.longitude),
+                static_cast<float>(mesh.vertices[i * 3 + 1] - origin.latitude),
+                static_cast<float>(mesh.vertices[i * 3 + 2]),
+                static_cast<std::uint8_t>(color >> 24),
+                static_cast<std::uint8_t>(color >> 16),
+                static_cast<std::uint8_t>(color >> 8),
+                static_cast<std::uint8_t>(color),
+                hasUv ? static_cast<float>(mesh.uvs[i * 2]) : 0.f,
+                hasUv ? static_cast<float>(mesh.uvs[i * 2 + 1]) : 0.f
+            });
+        }
+        return packed;
+    }
+};
+
+}}
+
+#endif // MESHING_PACKEDMESH_HPP_DEFINED
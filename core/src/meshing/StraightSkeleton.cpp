@@ -0,0 +1,374 @@
+#include "meshing/StraightSkeleton.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+using namespace utymap::meshing;
+
+namespace {
+
+/// Sine of angle between edges which is still considered as turn.
+const double AngleEpsilon = 1E-9;
+
+inline Vector2 add(const Vector2& a, const Vector2& b) { return Vector2(a.x + b.x, a.y + b.y); }
+inline Vector2 sub(const Vector2& a, const Vector2& b) { return Vector2(a.x - b.x, a.y - b.y); }
+inline Vector2 scale(const Vector2& v, double s) { return Vector2(v.x * s, v.y * s); }
+inline double dot(const Vector2& a, const Vector2& b) { return a.x * b.x + a.y * b.y; }
+inline double cross(const Vector2& a, const Vector2& b) { return a.x * b.y - a.y * b.x; }
+
+/// Contour edge: its wavefront moves along inward normal with unit speed.
+struct Edge
+{
+    Vector2 start;
+    Vector2 direction;
+    Vector2 normal;
+};
+
+/// Vertex of list of active vertices: moves along bisector of its edges.
+struct Vertex
+{
+    Vector2 position;
+    double time;
+    Vector2 velocity;
+    std::size_t prevEdge;
+    std::size_t nextEdge;
+    std::size_t prev;
+    std::size_t next;
+    std::size_t node;
+    bool isActive;
+    bool isReflex;
+
+    /// Returns position at given time.
+    Vector2 at(double t) const { return add(position, scale(velocity, t - time)); }
+    /// Returns position at zero time if vertex has always been moving.
+    Vector2 origin() const { return sub(position, scale(velocity, time)); }
+};
+
+enum class EventType { Edge = 0, Split = 1 };
+
+/// Edge event collapses edge between vertex and other vertex.
+/// Split event hits edge with index other by reflex vertex.
+struct Event
+{
+    double time;
+    EventType type;
+    std::size_t vertex;
+    std::size_t other;
+};
+
+struct EventGreater
+{
+    bool operator()(const Event& a, const Event& b) const
+    {
+        if (a.time != b.time) return a.time > b.time;
+        if (a.type != b.type) return a.type > b.type;
+        if (a.vertex != b.vertex) return a.vertex > b.vertex;
+        return a.other > b.other;
+    }
+};
+
+/// Skeleton arc traced by vertex between two nodes: separates faces of its edges.
+struct Arc
+{
+    std::size_t from;
+    std::size_t to;
+    std::size_t leftEdge;
+    std::size_t rightEdge;
+};
+
+/// Runs wavefront propagation. Events are validated lazily when they are popped from queue.
+class SkeletonBuilder final
+{
+public:
+    SkeletonBuilder(const std::vector<Vector2>& points, std::vector<StraightSkeleton::Node>& nodes) :
+        nodes_(nodes), edgeVertices_(points.size())
+    {
+        double minX = points[0].x, maxX = points[0].x, minY = points[0].y, maxY = points[0].y;
+        for (const auto& point : points) {
+            minX = std::min(minX, point.x);
+            maxX = std::max(maxX, point.x);
+            minY = std::min(minY, point.y);
+            maxY = std::max(maxY, point.y);
+        }
+        epsilon_ = std::max(maxX - minX, maxY - minY) * 1E-9;
+
+        std::size_t count = points.size();
+        edges_.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            Vector2 delta = sub(points[(i + 1) % count], points[i]);
+            Vector2 direction = scale(delta, 1 / std::sqrt(dot(delta, delta)));
+            edges_.push_back(Edge { points[i], direction, Vector2(-direction.y, direction.x) });
+        }
+
+        vertices_.reserve(count * 2);
+        nodes_.reserve(count * 2);
+        for (std::size_t i = 0; i < count; ++i) {
+            std::size_t prev = (i + count - 1) % count;
+            nodes_.push_back(StraightSkeleton::Node { points[i], 0 });
+            addVertex(points[i], 0, prev, i, prev, (i + 1) % count, i);
+        }
+    }
+
+    /// Processes all events. Returns max event time or negative value if propagation failed.
+    double run()
+    {
+        for (std::size_t i = 0; i < vertices_.size(); ++i) {
+            pushEdgeEvent(i);
+            if (vertices_[i].isReflex)
+                pushSplitEvents(i);
+        }
+
+        double maxTime = 0;
+        while (!events_.empty()) {
+            Event event = events_.top();
+            events_.pop();
+            bool isProcessed = event.type == EventType::Edge
+                ? processEdgeEvent(event)
+                : processSplitEvent(event);
+            if (isProcessed)
+                maxTime = std::max(maxTime, event.time);
+        }
+
+        for (const auto& vertex : vertices_)
+            if (vertex.isActive)
+                return -1;
+        return maxTime;
+    }
+
+    /// Assembles face of every edge from arcs. Returns false if some face is not closed.
+    bool buildFaces(std::vector<StraightSkeleton::Face>& faces) const
+    {
+        std::size_t count = edges_.size();
+        std::vector<std::vector<std::size_t>> edgeArcs(count);
+        for (std::size_t i = 0; i < arcs_.size(); ++i) {
+            edgeArcs[arcs_[i].leftEdge].push_back(i);
+            if (arcs_[i].rightEdge != arcs_[i].leftEdge)
+                edgeArcs[arcs_[i].rightEdge].push_back(i);
+        }
+
+        faces.resize(count);
+        std::vector<bool> isUsed;
+        for (std::size_t edge = 0; edge < count; ++edge) {
+            const auto& candidates = edgeArcs[edge];
+            isUsed.assign(candidates.size(), false);
+            std::size_t first = edge, current = (edge + 1) % count;
+            auto& face = faces[edge];
+            face.push_back(first);
+            face.push_back(current);
+            while (true) {
+                std::size_t next = std::numeric_limits<std::size_t>::max();
+                for (std::size_t i = 0; i < candidates.size() && next == std::numeric_limits<std::size_t>::max(); ++i) {
+                    if (isUsed[i]) continue;
+                    const Arc& arc = arcs_[candidates[i]];
+                    if (arc.from == current) next = arc.to;
+                    else if (arc.to == current) next = arc.from;
+                    if (next != std::numeric_limits<std::size_t>::max()) isUsed[i] = true;
+                }
+                if (next == std::numeric_limits<std::size_t>::max() || face.size() > candidates.size() + 1)
+                    return false;
+                if (next == first)
+                    break;
+                face.push_back(next);
+                current = next;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::size_t addVertex(const Vector2& position, double time, std::size_t prevEdge, std::size_t nextEdge,
+                          std::size_t prev, std::size_t next, std::size_t node)
+    {
+        const Edge& e1 = edges_[prevEdge];
+        const Edge& e2 = edges_[nextEdge];
+        // velocity has unit speed projection on both edge normals.
+        double det = cross(e1.normal, e2.normal);
+        Vector2 velocity = std::fabs(det) < AngleEpsilon
+            ? (dot(e1.normal, e2.normal) > 0 ? e1.normal : Vector2())
+            : Vector2((e2.normal.y - e1.normal.y) / det, (e1.normal.x - e2.normal.x) / det);
+
+        std::size_t index = vertices_.size();
+        vertices_.push_back(Vertex { position, time, velocity, prevEdge, nextEdge, prev, next, node,
+                                     true, cross(e1.direction, e2.direction) < -AngleEpsilon });
+        edgeVertices_[nextEdge].push_back(index);
+        return index;
+    }
+
+    std::size_t addNode(const Vector2& position, double time)
+    {
+        nodes_.push_back(StraightSkeleton::Node { position, time });
+        return nodes_.size() - 1;
+    }
+
+    /// Finishes vertex in given node.
+    void finish(std::size_t index, std::size_t node)
+    {
+        Vertex& vertex = vertices_[index];
+        arcs_.push_back(Arc { vertex.node, node, vertex.prevEdge, vertex.nextEdge });
+        vertex.isActive = false;
+    }
+
+    void pushEdgeEvent(std::size_t index)
+    {
+        const Vertex& a = vertices_[index];
+        const Vertex& b = vertices_[a.next];
+        const Vector2& direction = edges_[a.nextEdge].direction;
+        double time = std::max(a.time, b.time);
+        double length = dot(sub(b.at(time), a.at(time)), direction);
+        // NOTE edge which already has zero length collapses immediately.
+        if (length > epsilon_) {
+            double speed = dot(sub(b.velocity, a.velocity), direction);
+            if (speed > -AngleEpsilon)
+                return;
+            time -= length / speed;
+        }
+        events_.push(Event { time, EventType::Edge, index, a.next });
+    }
+
+    void pushSplitEvents(std::size_t index)
+    {
+        const Vertex& vertex = vertices_[index];
+        Vector2 origin = vertex.origin();
+        for (std::size_t i = 0; i < edges_.size(); ++i) {
+            if (i == vertex.prevEdge || i == vertex.nextEdge)
+                continue;
+
+            const Edge& edge = edges_[i];
+            double speed = 1 - dot(edge.normal, vertex.velocity);
+            if (speed < AngleEpsilon)
+                continue;
+
+            double time = dot(edge.normal, sub(origin, edge.start)) / speed;
+            if (time > vertex.time + epsilon_)
+                events_.push(Event { time, EventType::Split, index, i });
+        }
+    }
+
+    /// Pushes events of vertex created at time of collapse. Closes degenerated lists.
+    void schedule(std::size_t index)
+    {
+        Vertex& vertex = vertices_[index];
+        if (vertex.next == vertex.prev) {
+            finish(vertex.next, vertex.node);
+            vertex.isActive = false;
+            return;
+        }
+        pushEdgeEvent(vertex.prev);
+        pushEdgeEvent(index);
+        if (vertex.isReflex)
+            pushSplitEvents(index);
+    }
+
+    bool processEdgeEvent(const Event& event)
+    {
+        std::size_t ia = event.vertex, ib = event.other;
+        if (!vertices_[ia].isActive || !vertices_[ib].isActive || vertices_[ia].next != ib)
+            return false;
+
+        Vertex a = vertices_[ia], b = vertices_[ib];
+        Vector2 position = scale(add(a.at(event.time), b.at(event.time)), 0.5);
+        std::size_t node = addNode(position, event.time);
+        finish(ia, node);
+        finish(ib, node);
+
+        if (a.prev == ib)
+            return true;
+
+        if (a.prev == b.next) {
+            finish(a.prev, node);
+            return true;
+        }
+
+        std::size_t index = addVertex(position, event.time, a.prevEdge, b.nextEdge, a.prev, b.next, node);
+        vertices_[a.prev].next = index;
+        vertices_[b.next].prev = index;
+        schedule(index);
+        return true;
+    }
+
+    bool processSplitEvent(const Event& event)
+    {
+        std::size_t iv = event.vertex;
+        if (!vertices_[iv].isActive)
+            return false;
+
+        Vertex v = vertices_[iv];
+        Vector2 position = v.at(event.time);
+        const Edge& edge = edges_[event.other];
+
+        // find active wavefront segment of the edge which contains split point.
+        std::size_t ix = vertices_.size();
+        for (std::size_t candidate : edgeVertices_[event.other]) {
+            const Vertex& x = vertices_[candidate];
+            if (!x.isActive || x.nextEdge != event.other || candidate == iv || x.next == iv)
+                continue;
+            Vector2 start = x.at(event.time);
+            double length = dot(sub(vertices_[x.next].at(event.time), start), edge.direction);
+            double offset = dot(sub(position, start), edge.direction);
+            if (offset > -epsilon_ && offset < length + epsilon_) {
+                ix = candidate;
+                break;
+            }
+        }
+        if (ix == vertices_.size())
+            return false;
+
+        std::size_t iy = vertices_[ix].next;
+        std::size_t node = addNode(position, event.time);
+        finish(iv, node);
+
+        std::size_t v1 = addVertex(position, event.time, v.prevEdge, event.other, v.prev, iy, node);
+        vertices_[v.prev].next = v1;
+        vertices_[iy].prev = v1;
+
+        std::size_t v2 = addVertex(position, event.time, event.other, v.nextEdge, ix, v.next, node);
+        vertices_[ix].next = v2;
+        vertices_[v.next].prev = v2;
+
+        schedule(v1);
+        schedule(v2);
+        return true;
+    }
+
+    std::vector<StraightSkeleton::Node>& nodes_;
+    std::vector<Edge> edges_;
+    std::vector<Vertex> vertices_;
+    /// Vertices which start wavefront segments of every edge.
+    std::vector<std::vector<std::size_t>> edgeVertices_;
+    std::vector<Arc> arcs_;
+    std::priority_queue<Event, std::vector<Event>, EventGreater> events_;
+    double epsilon_;
+};
+
+}
+
+StraightSkeleton::StraightSkeleton(const std::vector<Vector2>& contour) :
+    maxTime_(0), isValid_(false)
+{
+    // remove repeated points which produce zero length edges.
+    std::vector<Vector2> points;
+    points.reserve(contour.size());
+    for (const auto& point : contour)
+        if (points.empty() || std::fabs(point.x - points.back().x) + std::fabs(point.y - points.back().y) > 0)
+            points.push_back(point);
+    while (points.size() > 1 && points.front().x == points.back().x && points.front().y == points.back().y)
+        points.pop_back();
+    if (points.size() < 3)
+        return;
+
+    double area = 0;
+    for (std::size_t i = 0; i < points.size(); ++i)
+        area += cross(points[i], points[(i + 1) % points.size()]);
+    if (area == 0)
+        return;
+    if (area < 0)
+        std::reverse(points.begin(), points.end());
+
+    SkeletonBuilder builder(points, nodes_);
+    maxTime_ = builder.run();
+    isValid_ = maxTime_ > 0 && builder.buildFaces(faces_);
+    if (!isValid_)
+        faces_.clear();
+}
@@ -0,0 +1,54 @@
+#ifndef MESHING_STRAIGHTSKELETON_HPP_DEFINED
+#define MESHING_STRAIGHTSKELETON_HPP_DEFINED
+
+#include "meshing/MeshTypes.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace utymap { namespace meshing {
+
+/// Computes straight skeleton of simple polygon without holes by shrinking its edges with
+/// unit speed and processing edge and split events in time order.
+/// Every contour edge gets face which is bounded by the edge and skeleton arcs, so roofs
+/// can be built from faces using node times as distances to the edge.
+class StraightSkeleton final
+{
+public:
+    /// Skeleton node. Contour vertices are the first nodes and have zero time.
+    struct Node
+    {
+        Vector2 position;
+        /// Time when node is reached by shrinking edges: distance to edges of its faces.
+        double time;
+    };
+
+    /// Indices of face nodes in counter clockwise order. First two nodes are contour edge.
+    typedef std::vector<std::size_t> Face;
+
+    /// Computes skeleton of contour with any orientation. Contour should not repeat its
+    /// first point. NOTE contour is reordered counter clockwise if necessary.
+    explicit StraightSkeleton(const std::vector<Vector2>& contour);
+
+    /// Returns true if skeleton is computed and every edge has closed face.
+    bool isValid() const { return isValid_; }
+
+    /// Returns all nodes: contour vertices followed by skeleton nodes.
+    const std::vector<Node>& getNodes() const { return nodes_; }
+
+    /// Returns faces of contour edges.
+    const std::vector<Face>& getFaces() const { return faces_; }
+
+    /// Returns time of the last event: half of the width of the widest part of polygon.
+    double getMaxTime() const { return maxTime_; }
+
+private:
+    std::vector<Node> nodes_;
+    std::vector<Face> faces_;
+    double maxTime_;
+    bool isValid_;
+};
+
+}}
+
+#endif // MESHING_STRAIGHTSKELETON_HPP_DEFINED
@@ -0,0 +1,66 @@
+#include "utils/AllocationCounter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace utymap::utils;
+
+namespace {
+    /// NOTE trivial thread local does not allocate, so it is safe to use from operator new.
+    thread_local std::uint64_t allocations = 0;
+    /// NOTE atomic is lock free and constant initialized, so it does not allocate too.
+    std::atomic<std::uint64_t> totalAllocations { 0 };
+}
+
+#ifdef UTYMAP_ALLOCATION_STATISTICS
+
+namespace {
+    void* allocate(std::size_t size)
+    {
+        ++allocations;
+        totalAllocations.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void* allocateOrThrow(std::size_t size)
+    {
+        void* memory = allocate(size);
+        while (memory == nullptr) {
+            std::new_handler handler = std::get_new_handler();
+            if (handler == nullptr)
+                throw std::bad_alloc();
+            handler();
+            memory = std::malloc(size == 0 ? 1 : size);
+        }
+        return memory;
+    }
+}
+
+void* operator new(std::size_t size) { return allocateOrThrow(size); }
+void* operator new[](std::size_t size) { return allocateOrThrow(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+
+bool AllocationCounter::isEnabled() { return true; }
+
+#else
+
+bool AllocationCounter::isEnabled() { return false; }
+
+#endif
+
+std::uint64_t AllocationCounter::current()
+{
+    return allocations;
+}
+
+std::uint64_t AllocationCounter::total()
+{
+    return totalAllocations.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,28 @@
+#ifndef UTILS_ALLOCATIONCOUNTER_HPP_DEFINED
+#define UTILS_ALLOCATIONCOUNTER_HPP_DEFINED
+
+#include <cstdint>
+
+namespace utymap { namespace utils {
+
+/// Counts heap allocations made by calling thread and by all threads of process. Counting is enabled
+/// by UTYMAP_ALLOCATION_STATISTICS definition which replaces global operator new, otherwise counts stay zero.
+class AllocationCounter final
+{
+public:
+    AllocationCounter() = delete;
+
+    /// Returns whether allocations are counted.
+    static bool isEnabled();
+
+    /// Returns amount of allocations made by calling thread since it is started.
+    static std::uint64_t current();
+
+    /// Returns amount of allocations made by all threads since process is started. Use it
+    /// to measure work which is spread over worker threads, e.g. parallel tile build.
+    static std::uint64_t total();
+};
+
+}}
+
+#endif // UTILS_ALLOCATIONCOUNTER_HPP_DEFINED
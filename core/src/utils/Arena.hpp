@@ -0,0 +1,162 @@
+#ifndef UTILS_ARENA_HPP_DEFINED
+#define UTILS_ARENA_HPP_DEFINED
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace utymap { namespace utils {
+
+/// Monotonic memory arena for transient objects of one build: allocation moves pointer inside
+/// current block and deallocation does nothing. All memory is released at once by reset which
+/// keeps single block of used size, so next build of similar tile does not allocate at all.
+/// Arena is not thread safe.
+class Arena final
+{
+public:
+    /// Keeps arena in use: arena is reset when the last scope is destroyed.
+    class Scope final
+    {
+    public:
+        explicit Scope(Arena& arena) : arena_(arena) { ++arena_.scopes_; }
+
+        ~Scope()
+        {
+            if (--arena_.scopes_ == 0)
+                arena_.reset();
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Arena& arena_;
+    };
+
+    /// Default size of block.
+    static const std::size_t BlockSize = 64 * 1024;
+    /// Max size of block kept by reset.
+    static const std::size_t MaxRetainedSize = 16 * 1024 * 1024;
+
+    explicit Arena(std::size_t blockSize = BlockSize) :
+        blockSize_(std::max<std::size_t>(blockSize, 256)), blocks_(), offset_(0), used_(0), scopes_(0)
+    {
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /// Returns arena of current thread.
+    static Arena& local()
+    {
+        static thread_local Arena arena;
+        return arena;
+    }
+
+    /// Allocates memory of given size and alignment which is not greater than alignment of max_align_t.
+    void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t))
+    {
+        used_ += size;
+        if (!blocks_.empty()) {
+            std::size_t start = (offset_ + alignment - 1) & ~(alignment - 1);
+            if (start + size <= blocks_.back().size) {
+                offset_ = start + size;
+                return blocks_.back().data.get() + start;
+            }
+        }
+
+        // NOTE large objects get own block before current one, so its free space is not wasted.
+        if (size > blockSize_ / 4) {
+            char* data = new char[size];
+            blocks_.insert(blocks_.empty() ? blocks_.end() : blocks_.end() - 1,
+                           Block { std::unique_ptr<char[]>(data), size });
+            if (blocks_.size() == 1)
+                offset_ = size;
+            return data;
+        }
+
+        char* data = new char[blockSize_];
+        blocks_.push_back(Block { std::unique_ptr<char[]>(data), blockSize_ });
+        offset_ = size;
+        return data;
+    }
+
+    /// Releases all allocated memory. Objects should not be used after reset.
+    void reset()
+    {
+        std::size_t size = getCapacity();
+        // NOTE single block is reallocated too if it is larger than retained size, e.g. it was
+        // taken by large object.
+        if (blocks_.size() > 1 || size > MaxRetainedSize) {
+            blocks_.clear();
+            if (size > MaxRetainedSize)
+                size = MaxRetainedSize;
+            blocks_.push_back(Block { std::unique_ptr<char[]>(new char[size]), size });
+        }
+        offset_ = 0;
+        used_ = 0;
+    }
+
+    /// Returns amount of bytes allocated since last reset.
+    std::size_t getUsed() const { return used_; }
+
+    /// Returns amount of bytes reserved by blocks.
+    std::size_t getCapacity() const
+    {
+        std::size_t capacity = 0;
+        for (const auto& block : blocks_)
+            capacity += block.size;
+        return capacity;
+    }
+
+private:
+    struct Block final
+    {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    const std::size_t blockSize_;
+    std::vector<Block> blocks_;
+    std::size_t offset_;
+    std::size_t used_;
+    int scopes_;
+};
+
+/// Allocator which takes memory from arena, so it can be used by standard containers. NOTE it is
+/// not final as containers derive from allocator to store it.
+template <typename T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    explicit ArenaAllocator(Arena& arena) : arena_(&arena) { }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena_) { }
+
+    T* allocate(std::size_t count)
+    {
+        return static_cast<T*>(arena_->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, std::size_t) { }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena_ == other.arena_; }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena_ != other.arena_; }
+
+private:
+    template <typename U> friend class ArenaAllocator;
+
+    Arena* arena_;
+};
+
+}}
+
+#endif // UTILS_ARENA_HPP_DEFINED
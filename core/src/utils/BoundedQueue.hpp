@@ -0,0 +1,81 @@
+#ifndef UTILS_BOUNDEDQUEUE_HPP_DEFINED
+#define UTILS_BOUNDEDQUEUE_HPP_DEFINED
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace utymap { namespace utils {
+
+/// Blocking queue with limited capacity which connects producer and consumer threads.
+template <typename T>
+class BoundedQueue final
+{
+public:
+    explicit BoundedQueue(std::size_t capacity) :
+        capacity_(capacity > 0 ? capacity : 1), items_(), isClosed_(false)
+    {
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /// Adds item waiting while queue is full. Returns false if queue is closed.
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        notFull_.wait(lock, [&]() { return isClosed_ || items_.size() < capacity_; });
+        if (isClosed_)
+            return false;
+
+        items_.push_back(std::move(item));
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    /// Takes item waiting while queue is empty. Returns false if queue is closed and empty.
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        notEmpty_.wait(lock, [&]() { return isClosed_ || !items_.empty(); });
+        if (items_.empty())
+            return false;
+
+        item = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    /// Closes queue: new items are rejected, existing ones can still be taken.
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        isClosed_ = true;
+        notFull_.notify_all();
+        notEmpty_.notify_all();
+    }
+
+    /// Closes queue and drops pending items.
+    void cancel()
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        isClosed_ = true;
+        items_.clear();
+        notFull_.notify_all();
+        notEmpty_.notify_all();
+    }
+
+private:
+    const std::size_t capacity_;
+    std::deque<T> items_;
+    bool isClosed_;
+    std::mutex lock_;
+    std::condition_variable notFull_;
+    std::condition_variable notEmpty_;
+};
+
+}}
+
+#endif // UTILS_BOUNDEDQUEUE_HPP_DEFINED
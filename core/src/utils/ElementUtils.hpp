@@ -12,33 +12,36 @@
 
 namespace utymap { namespace utils {
 
-/// Sets tags to element.
-inline void setTags(utymap::index::StringTable& stringTable,
-                    utymap::entities::Element& element,
-                    const utymap::formats::Tags& tags)
-{
-    for (const auto& tag : tags) {
-        std::uint32_t key = stringTable.getId(tag.key);
-        std::uint32_t value = stringTable.getId(tag.value);
-        element.tags.push_back(utymap::entities::Tag(key, value));
-    }
-    stringTable.flush();
-    // NOTE: tags should be sorted to speed up mapcss styling
-    std::sort(element.tags.begin(), element.tags.end());
-}
-
 /// Convert format specific tags to entity ones.
 inline std::vector<utymap::entities::Tag> convertTags(utymap::index::StringTable& stringTable, 
                                                       const utymap::formats::Tags& tags)
 {
-    std::vector<utymap::entities::Tag> convertedTags(tags.size());
-    std::transform(tags.begin(), tags.end(), convertedTags.begin(), [&](const utymap::formats::Tag& tag) {
-        return utymap::entities::Tag(stringTable.getId(tag.key), stringTable.getId(tag.value));
-    });
+    // NOTE keys and values are interned in one batch.
+    std::vector<const char*> strings;
+    strings.reserve(tags.size() * 2);
+    for (const auto& tag : tags) {
+        strings.push_back(tag.key.c_str());
+        strings.push_back(tag.value.c_str());
+    }
+    std::vector<std::uint32_t> ids = stringTable.getIds(strings);
+
+    std::vector<utymap::entities::Tag> convertedTags;
+    convertedTags.reserve(tags.size());
+    for (std::size_t i = 0; i < ids.size(); i += 2)
+        convertedTags.push_back(utymap::entities::Tag(ids[i], ids[i + 1]));
 
+    // NOTE: tags should be sorted to speed up mapcss styling
     std::sort(convertedTags.begin(), convertedTags.end());
 
-    return std::move(convertedTags);
+    return convertedTags;
+}
+
+/// Sets tags to element.
+inline void setTags(utymap::index::StringTable& stringTable,
+                    utymap::entities::Element& element,
+                    const utymap::formats::Tags& tags)
+{
+    element.tags = convertTags(stringTable, tags);
 }
 
 inline bool hasTag(std::uint32_t key,
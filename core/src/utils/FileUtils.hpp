@@ -0,0 +1,59 @@
+#ifndef UTILS_FILEUTILS_HPP_DEFINED
+#define UTILS_FILEUTILS_HPP_DEFINED
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace utymap { namespace utils {
+
+/// Gets size of file. Missing file has zero size.
+inline std::uint64_t getFileSize(const std::string& path)
+{
+    struct stat status;
+    return stat(path.c_str(), &status) == 0 ? static_cast<std::uint64_t>(status.st_size) : 0;
+}
+
+/// Gets version of file from its size and modification time. It is the same in every process
+/// till file is written again. Missing file has zero version.
+inline std::uint64_t getFileVersion(const std::string& path)
+{
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0)
+        return 0;
+
+    std::uint64_t version = static_cast<std::uint64_t>(status.st_size);
+    std::uint64_t time = static_cast<std::uint64_t>(status.st_mtime);
+#ifdef __linux__
+    // NOTE files can be written several times per second.
+    time = time * 1000000000ULL + static_cast<std::uint64_t>(status.st_mtim.tv_nsec);
+#endif
+    version ^= time + 0x9e3779b97f4a7c15ULL + (version << 6) + (version >> 2);
+    version ^= static_cast<std::uint64_t>(status.st_ino) + 0x9e3779b97f4a7c15ULL + (version << 6) + (version >> 2);
+    return version;
+}
+
+/// Renames file over existing one, so readers which open it see either old or new file, but
+/// never miss it. Returns false if file cannot be renamed.
+inline bool replaceFile(const std::string& from, const std::string& to)
+{
+#ifdef _WIN32
+    // NOTE rename fails on windows if target file exists.
+    return ::MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+}}
+
+#endif // UTILS_FILEUTILS_HPP_DEFINED
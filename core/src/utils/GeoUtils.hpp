@@ -3,11 +3,13 @@
 
 #include "BoundingBox.hpp"
 #include "QuadKey.hpp"
+#include "utils/GeometryKernels.hpp"
 #include "utils/MathUtils.hpp"
 
 #include <algorithm>
 #include <cmath>
 #include <string>
+#include <vector>
 
 namespace utymap { namespace utils {
 
@@ -40,22 +42,25 @@ public:
 
     static std::string quadKeyToString(const QuadKey& quadKey)
     {
-        std::string code;
-        code.reserve(static_cast<std::size_t>(quadKey.levelOfDetail));
-        for (int i = quadKey.levelOfDetail; i > 0; --i) {
-            char digit = '0';
-            int mask = 1 << (i - 1);
-            if ((quadKey.tileX & mask) != 0)
-                digit++;
-            if ((quadKey.tileY & mask) != 0) {
-                digit++;
-                digit++;
-            }
-            code += digit;
-        }
+        std::string code(static_cast<std::size_t>(quadKey.levelOfDetail), '0');
+        writeQuadKeyDigits(PackedQuadKey(quadKey), &code[0]);
         return code;
     }
 
+    /// Writes quadkey digits of packed key to buffer which should have level of details size.
+    static void writeQuadKeyDigits(const PackedQuadKey& quadKey, char* buffer)
+    {
+        int levelOfDetail = quadKey.levelOfDetail();
+        for (int i = 1; i <= levelOfDetail; ++i)
+            buffer[i - 1] = static_cast<char>('0' + quadKey.digit(i));
+    }
+
+    /// Returns width of tile at given level of details in degrees.
+    static double getTileWidth(int levelOfDetail)
+    {
+        return std::ldexp(360.0, -levelOfDetail);
+    }
+
     /// Visits all tiles which are intersecting with given bounding box at given level of details
     template<typename Visitor>
     static void visitTileRange(const BoundingBox& bbox, int levelOfDetail, const Visitor& visitor)
@@ -65,10 +70,19 @@ public:
         QuadKey start = latLonToQuadKey(bbox.minPoint, levelOfDetail);
         QuadKey end = latLonToQuadKey(bbox.maxPoint, levelOfDetail);
 
+        // NOTE tile edges are computed once per row and column, not per tile.
+        std::vector<double> longitudes;
+        longitudes.reserve(static_cast<std::size_t>(end.tileX - start.tileX + 2));
+        for (int x = start.tileX; x <= end.tileX + 1; x++)
+            longitudes.push_back(tileXToLon(x, levelOfDetail));
+
         for (int y = end.tileY; y < start.tileY + 1; y++) {
+            double maxLatitude = tileYToLat(y, levelOfDetail);
+            double minLatitude = tileYToLat(y + 1, levelOfDetail);
             for (int x = start.tileX; x < end.tileX + 1; x++) {
                 const QuadKey currentQuadKey = { levelOfDetail, x, y };
-                const BoundingBox currentBbox = quadKeyToBoundingBox(currentQuadKey);
+                const BoundingBox currentBbox(GeoCoordinate(minLatitude, longitudes[x - start.tileX]),
+                                              GeoCoordinate(maxLatitude, longitudes[x - start.tileX + 1]));
                 if (bbox.intersects(currentBbox)) {
                     visitor(currentQuadKey, currentBbox);
                 }
@@ -90,6 +104,23 @@ public:
         return c;
     }
 
+    /// Checks whether given point inside polygon stored in contiguous array.
+    static bool isPointInPolygon(const GeoCoordinate& point,
+                                 std::vector<GeoCoordinate>::const_iterator begin,
+                                 std::vector<GeoCoordinate>::const_iterator end)
+    {
+        return begin != end && utymap::utils::isPointInPolygon(point, &*begin, static_cast<std::size_t>(end - begin));
+    }
+
+    /// Checks whether given point inside polygon stored in contiguous array.
+    static bool isPointInPolygon(const GeoCoordinate& point,
+                                 std::vector<GeoCoordinate>::iterator begin,
+                                 std::vector<GeoCoordinate>::iterator end)
+    {
+        return isPointInPolygon(point, std::vector<GeoCoordinate>::const_iterator(begin),
+                                       std::vector<GeoCoordinate>::const_iterator(end));
+    }
+
     /// Gets offset in degrees
     static double getOffset(const GeoCoordinate& point, double offsetInMeters)
     {
@@ -137,17 +168,41 @@ private:
         return static_cast<int>(std::floor((1.0 - log(tan(lat * pi / 180.0) + 1.0 / cos(lat * pi / 180.0)) / pi) / 2.0 * pow(2.0, levelOfDetail)));
     }
 
+    /// Max level of details which tile edge latitudes are precomputed for. Edges of coarser
+    /// levels are subset of its edges, so the same table is used for them.
+    static const int LatitudeTableLevelOfDetails = 16;
+
     static double tileXToLon(int x, int levelOfDetail)
     {
-        return x / pow(2.0, levelOfDetail) * 360.0 - 180;
+        return std::ldexp(static_cast<double>(x), -levelOfDetail) * 360.0 - 180;
     }
 
     static double tileYToLat(int y, int levelOfDetail)
+    {
+        if (levelOfDetail <= LatitudeTableLevelOfDetails && y >= 0 && y <= (1 << levelOfDetail))
+            return getLatitudeTable()[static_cast<std::size_t>(y) << (LatitudeTableLevelOfDetails - levelOfDetail)];
+        return computeTileYToLat(y, levelOfDetail);
+    }
+
+    static double computeTileYToLat(int y, int levelOfDetail)
     {
         double n = pi - 2.0 * pi * y / pow(2.0, levelOfDetail);
         return 180.0 / pi * atan(0.5 * (exp(n) - exp(-n)));
     }
 
+    /// Returns latitudes of tile edges at table level of details.
+    static const std::vector<double>& getLatitudeTable()
+    {
+        static const std::vector<double> latitudes = [] {
+            std::vector<double> values;
+            values.reserve((1 << LatitudeTableLevelOfDetails) + 1);
+            for (int y = 0; y <= (1 << LatitudeTableLevelOfDetails); ++y)
+                values.push_back(computeTileYToLat(y, LatitudeTableLevelOfDetails));
+            return values;
+        }();
+        return latitudes;
+    }
+
     /// Earth radius at a given latitude, according to the WGS-84 ellipsoid [m].
     static double wgs84EarthRadius(double lat)
     {
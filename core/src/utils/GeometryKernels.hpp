@@ -0,0 +1,172 @@
+#ifndef UTILS_GEOMETRYKERNELS_HPP_DEFINED
+#define UTILS_GEOMETRYKERNELS_HPP_DEFINED
+
+#include "GeoCoordinate.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+#if defined(UTYMAP_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+    #include <emmintrin.h>
+    #define UTYMAP_SIMD_SSE2
+#elif defined(UTYMAP_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define UTYMAP_SIMD_NEON
+#endif
+
+namespace utymap { namespace utils {
+
+/// Kernels of geometry primitives which run over contiguous coordinate arrays. Coordinate is pair
+/// of doubles, so it is loaded as one 128 bit vector: latitude and longitude are processed at once
+/// by SSE2 or NEON if UTYMAP_SIMD is defined, otherwise scalar loops are used.
+
+/// Expands min and max points by given coordinates. NaN coordinates are ignored.
+inline void expandBounds(const utymap::GeoCoordinate* coordinates, std::size_t count,
+                         utymap::GeoCoordinate& minPoint, utymap::GeoCoordinate& maxPoint)
+{
+    static_assert(sizeof(utymap::GeoCoordinate) == 2 * sizeof(double), "Coordinate should be pair of doubles.");
+    std::size_t i = 0;
+#if defined(UTYMAP_SIMD_SSE2)
+    const double* values = &coordinates->latitude;
+    // NOTE min and max return second operand when first one is NaN.
+    __m128d min0 = _mm_loadu_pd(&minPoint.latitude), min1 = min0;
+    __m128d max0 = _mm_loadu_pd(&maxPoint.latitude), max1 = max0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d first = _mm_loadu_pd(values + i * 2), second = _mm_loadu_pd(values + i * 2 + 2);
+        min0 = _mm_min_pd(first, min0);
+        max0 = _mm_max_pd(first, max0);
+        min1 = _mm_min_pd(second, min1);
+        max1 = _mm_max_pd(second, max1);
+    }
+    _mm_storeu_pd(&minPoint.latitude, _mm_min_pd(min1, min0));
+    _mm_storeu_pd(&maxPoint.latitude, _mm_max_pd(max1, max0));
+#elif defined(UTYMAP_SIMD_NEON)
+    // NOTE NEON min and max propagate NaN, so NaN lanes are replaced by current bounds.
+    const double* values = &coordinates->latitude;
+    float64x2_t min0 = vld1q_f64(&minPoint.latitude), max0 = vld1q_f64(&maxPoint.latitude);
+    for (; i < count; ++i) {
+        float64x2_t value = vld1q_f64(values + i * 2);
+        uint64x2_t isNumber = vceqq_f64(value, value);
+        min0 = vminq_f64(min0, vbslq_f64(isNumber, value, min0));
+        max0 = vmaxq_f64(max0, vbslq_f64(isNumber, value, max0));
+    }
+    vst1q_f64(&minPoint.latitude, min0);
+    vst1q_f64(&maxPoint.latitude, max0);
+#endif
+    for (; i < count; ++i) {
+        minPoint = utymap::GeoCoordinate(std::min(minPoint.latitude, coordinates[i].latitude),
+                                         std::min(minPoint.longitude, coordinates[i].longitude));
+        maxPoint = utymap::GeoCoordinate(std::max(maxPoint.latitude, coordinates[i].latitude),
+                                         std::max(maxPoint.longitude, coordinates[i].longitude));
+    }
+}
+
+/// Returns doubled signed area of closed polygon: positive if it is counterclockwise. Coordinates
+/// are taken relative to the first one, so products of large values do not cancel each other.
+inline double getSignedArea(const utymap::GeoCoordinate* coordinates, std::size_t count)
+{
+    if (count < 3)
+        return 0;
+
+    const double* values = &coordinates->latitude;
+#if defined(UTYMAP_SIMD_SSE2)
+    // NOTE lanes accumulate latitude(p) * longitude(q) and longitude(p) * latitude(q).
+    __m128d origin = _mm_loadu_pd(values);
+    __m128d previous = _mm_setzero_pd();
+    __m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+    std::size_t i = 1;
+    for (; i + 2 <= count; i += 2) {
+        __m128d first = _mm_sub_pd(_mm_loadu_pd(values + i * 2), origin);
+        __m128d second = _mm_sub_pd(_mm_loadu_pd(values + i * 2 + 2), origin);
+        sum0 = _mm_add_pd(sum0, _mm_mul_pd(previous, _mm_shuffle_pd(first, first, 1)));
+        sum1 = _mm_add_pd(sum1, _mm_mul_pd(first, _mm_shuffle_pd(second, second, 1)));
+        previous = second;
+    }
+    for (; i < count; ++i) {
+        __m128d current = _mm_sub_pd(_mm_loadu_pd(values + i * 2), origin);
+        sum0 = _mm_add_pd(sum0, _mm_mul_pd(previous, _mm_shuffle_pd(current, current, 1)));
+        previous = current;
+    }
+    // NOTE closing edge ends at origin, so its product is zero.
+    double sums[2];
+    _mm_storeu_pd(sums, _mm_add_pd(sum0, sum1));
+    return sums[1] - sums[0];
+#elif defined(UTYMAP_SIMD_NEON)
+    float64x2_t origin = vld1q_f64(values);
+    float64x2_t previous = vdupq_n_f64(0);
+    float64x2_t sum = vdupq_n_f64(0);
+    for (std::size_t i = 1; i < count; ++i) {
+        float64x2_t current = vsubq_f64(vld1q_f64(values + i * 2), origin);
+        sum = vfmaq_f64(sum, previous, vextq_f64(current, current, 1));
+        previous = current;
+    }
+    return vgetq_lane_f64(sum, 1) - vgetq_lane_f64(sum, 0);
+#else
+    double originLatitude = coordinates[0].latitude, originLongitude = coordinates[0].longitude;
+    double area = 0;
+    double previousLatitude = 0, previousLongitude = 0;
+    for (std::size_t i = 1; i < count; ++i) {
+        double latitude = values[i * 2] - originLatitude, longitude = values[i * 2 + 1] - originLongitude;
+        area += previousLongitude * latitude - longitude * previousLatitude;
+        previousLatitude = latitude;
+        previousLongitude = longitude;
+    }
+    return area;
+#endif
+}
+
+/// Checks whether point is inside polygon using crossing number: edges are tested in pairs.
+inline bool isPointInPolygon(const utymap::GeoCoordinate& point, const utymap::GeoCoordinate* coordinates, std::size_t count)
+{
+    if (count == 0)
+        return false;
+
+    auto crosses = [&](const utymap::GeoCoordinate& current, const utymap::GeoCoordinate& previous) {
+        return ((current.latitude > point.latitude) != (previous.latitude > point.latitude)) &&
+               (point.longitude < (previous.longitude - current.longitude) * (point.latitude - current.latitude) /
+               (previous.latitude - current.latitude) + current.longitude);
+    };
+
+    bool isInside = crosses(coordinates[0], coordinates[count - 1]);
+    std::size_t i = 1;
+#if defined(UTYMAP_SIMD_SSE2)
+    const double* values = &coordinates->latitude;
+    __m128d latitude = _mm_set1_pd(point.latitude), longitude = _mm_set1_pd(point.longitude);
+    int parity = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d a = _mm_loadu_pd(values + i * 2 - 2), b = _mm_loadu_pd(values + i * 2), c = _mm_loadu_pd(values + i * 2 + 2);
+        __m128d currentLat = _mm_unpacklo_pd(b, c), currentLon = _mm_unpackhi_pd(b, c);
+        __m128d previousLat = _mm_unpacklo_pd(a, b), previousLon = _mm_unpackhi_pd(a, b);
+        int isCrossed = _mm_movemask_pd(_mm_cmpgt_pd(currentLat, latitude)) ^
+                        _mm_movemask_pd(_mm_cmpgt_pd(previousLat, latitude));
+        __m128d x = _mm_add_pd(_mm_div_pd(_mm_mul_pd(_mm_sub_pd(previousLon, currentLon), _mm_sub_pd(latitude, currentLat)),
+                                          _mm_sub_pd(previousLat, currentLat)), currentLon);
+        int mask = isCrossed & _mm_movemask_pd(_mm_cmplt_pd(longitude, x));
+        parity ^= (mask & 1) ^ (mask >> 1);
+    }
+    isInside ^= parity != 0;
+#elif defined(UTYMAP_SIMD_NEON)
+    const double* values = &coordinates->latitude;
+    float64x2_t latitude = vdupq_n_f64(point.latitude), longitude = vdupq_n_f64(point.longitude);
+    uint64x2_t parity = vdupq_n_u64(0);
+    for (; i + 2 <= count; i += 2) {
+        float64x2_t a = vld1q_f64(values + i * 2 - 2), b = vld1q_f64(values + i * 2), c = vld1q_f64(values + i * 2 + 2);
+        float64x2_t currentLat = vzip1q_f64(b, c), currentLon = vzip2q_f64(b, c);
+        float64x2_t previousLat = vzip1q_f64(a, b), previousLon = vzip2q_f64(a, b);
+        uint64x2_t isCrossed = veorq_u64(vcgtq_f64(currentLat, latitude), vcgtq_f64(previousLat, latitude));
+        float64x2_t x = vaddq_f64(vdivq_f64(vmulq_f64(vsubq_f64(previousLon, currentLon), vsubq_f64(latitude, currentLat)),
+                                            vsubq_f64(previousLat, currentLat)), currentLon);
+        parity = veorq_u64(parity, vandq_u64(isCrossed, vcltq_f64(longitude, x)));
+    }
+    isInside ^= ((vgetq_lane_u64(parity, 0) ^ vgetq_lane_u64(parity, 1)) & 1) != 0;
+#endif
+    for (; i < count; ++i) {
+        if (crosses(coordinates[i], coordinates[i - 1]))
+            isInside = !isInside;
+    }
+    return isInside;
+}
+
+}}
+
+#endif // UTILS_GEOMETRYKERNELS_HPP_DEFINED
@@ -4,8 +4,11 @@
 #include "GeoCoordinate.hpp"
 #include "meshing/MeshTypes.hpp"
 #include "meshing/Polygon.hpp"
+#include "utils/GeometryKernels.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <numeric>
 #include <vector>
 
 namespace utymap { namespace utils {
@@ -21,6 +24,12 @@ double getArea(const T& coordinates)
     return area;
 }
 
+/// Gets area of polygon stored in contiguous array.
+inline double getArea(const std::vector<utymap::GeoCoordinate>& coordinates)
+{
+    return getSignedArea(coordinates.data(), coordinates.size());
+}
+
 /// Checks whether geocoordinates are in clockwise oreder
 template <typename T>
 bool isClockwise(const T& coordinates)
@@ -96,6 +105,287 @@ void outerRectangles(const utymap::meshing::Polygon& polygon, const Visitor& vis
         visitor(rectangle);
     }
 }
+
+/// Triangulates simple polygon without holes given as interleaved x and y values using ear clipping.
+/// Returns false if polygon is degenerate, self intersecting or has duplicated points: such polygons
+/// should be triangulated by more robust algorithm. Triangles are in counterclockwise order.
+inline bool triangulateSimplePolygon(const std::vector<double>& points, std::vector<int>& triangles)
+{
+    auto count = static_cast<int>(points.size() / 2);
+    if (count < 3)
+        return false;
+
+    auto cross = [&](int a, int b, int c) {
+        return (points[b * 2] - points[a * 2]) * (points[c * 2 + 1] - points[a * 2 + 1]) -
+               (points[b * 2 + 1] - points[a * 2 + 1]) * (points[c * 2] - points[a * 2]);
+    };
+
+    utymap::meshing::Rectangle bounds;
+    double area = 0;
+    for (int p = count - 1, q = 0; q < count; p = q++) {
+        bounds.expand(utymap::meshing::Vector2(points[q * 2], points[q * 2 + 1]));
+        area += points[p * 2] * points[q * 2 + 1] - points[q * 2] * points[p * 2 + 1];
+    }
+    double scale = std::max(bounds.width(), bounds.height());
+    double eps = 1E-12 * scale * scale;
+    if (std::abs(area) <= eps)
+        return false;
+
+    // reject polygons with intersecting or touching non adjacent edges.
+    auto isOnSegment = [&](int a, int b, int c) {
+        return std::min(points[a * 2], points[b * 2]) <= points[c * 2] &&
+               points[c * 2] <= std::max(points[a * 2], points[b * 2]) &&
+               std::min(points[a * 2 + 1], points[b * 2 + 1]) <= points[c * 2 + 1] &&
+               points[c * 2 + 1] <= std::max(points[a * 2 + 1], points[b * 2 + 1]);
+    };
+    for (int i = 0; i < count; ++i) {
+        int a = i, b = (i + 1) % count;
+        for (int j = i + 2; j < count; ++j) {
+            int c = j, d = (j + 1) % count;
+            if (d == a)
+                continue;
+            double d1 = cross(a, b, c), d2 = cross(a, b, d), d3 = cross(c, d, a), d4 = cross(c, d, b);
+            if (((d1 > eps && d2 < -eps) || (d1 < -eps && d2 > eps)) &&
+                ((d3 > eps && d4 < -eps) || (d3 < -eps && d4 > eps)))
+                return false;
+            if ((std::abs(d1) <= eps && isOnSegment(a, b, c)) || (std::abs(d2) <= eps && isOnSegment(a, b, d)) ||
+                (std::abs(d3) <= eps && isOnSegment(c, d, a)) || (std::abs(d4) <= eps && isOnSegment(c, d, b)))
+                return false;
+        }
+    }
+
+    std::vector<int> indices(static_cast<std::size_t>(count));
+    std::iota(indices.begin(), indices.end(), 0);
+    if (area < 0)
+        std::reverse(indices.begin(), indices.end());
+
+    std::vector<int> result;
+    result.reserve(static_cast<std::size_t>(count - 2) * 3);
+    while (indices.size() > 3) {
+        bool isClipped = false;
+        for (std::size_t i = 0; i < indices.size() && !isClipped; ++i) {
+            int prev = indices[(i + indices.size() - 1) % indices.size()];
+            int current = indices[i];
+            int next = indices[(i + 1) % indices.size()];
+
+            // skip reflex vertices and remove collinear ones which do not form any triangle.
+            double turn = cross(prev, current, next);
+            if (turn <= eps) {
+                if (std::abs(turn) <= eps) {
+                    indices.erase(indices.begin() + i);
+                    isClipped = true;
+                }
+                continue;
+            }
+
+            bool isEar = std::none_of(indices.begin(), indices.end(), [&](int other) {
+                return other != prev && other != current && other != next &&
+                       cross(prev, current, other) >= -eps &&
+                       cross(current, next, other) >= -eps &&
+                       cross(next, prev, other) >= -eps;
+            });
+            if (!isEar)
+                continue;
+
+            result.push_back(prev);
+            result.push_back(current);
+            result.push_back(next);
+            indices.erase(indices.begin() + i);
+            isClipped = true;
+        }
+
+        if (!isClipped)
+            return false;
+    }
+
+    if (cross(indices[0], indices[1], indices[2]) <= eps)
+        return false;
+    result.insert(result.end(), indices.begin(), indices.end());
+
+    triangles.swap(result);
+    return true;
+}
+
+/// Simplifies closed contour using Douglas-Peucker algorithm: removes points which are closer
+/// than tolerance to simplified shape. Returns contour as is if it would degenerate.
+inline std::vector<utymap::meshing::Vector2> simplifyContour(const std::vector<utymap::meshing::Vector2>& contour, double tolerance)
+{
+    std::size_t count = contour.size();
+    if (count > 1 && contour[0] == contour[count - 1])
+        --count;
+    if (count <= 3 || tolerance <= 0)
+        return contour;
+
+    auto getDistance = [&](std::size_t a, std::size_t b, std::size_t p) {
+        double dx = contour[b].x - contour[a].x, dy = contour[b].y - contour[a].y;
+        double px = contour[p].x - contour[a].x, py = contour[p].y - contour[a].y;
+        double length = dx * dx + dy * dy;
+        double ratio = length > 0 ? std::max(0., std::min(1., (px * dx + py * dy) / length)) : 0;
+        return std::sqrt((px - dx * ratio) * (px - dx * ratio) + (py - dy * ratio) * (py - dy * ratio));
+    };
+
+    // NOTE closed contour is split at the first point and the point which is the farthest from it.
+    std::size_t farthest = 1;
+    for (std::size_t i = 2; i < count; ++i)
+        if (getDistance(0, 0, i) > getDistance(0, 0, farthest))
+            farthest = i;
+
+    std::vector<bool> isKept(count, false);
+    isKept[0] = isKept[farthest] = true;
+    std::vector<std::pair<std::size_t, std::size_t>> ranges = { { 0, farthest }, { farthest, count } };
+    while (!ranges.empty()) {
+        auto range = ranges.back();
+        ranges.pop_back();
+        std::size_t end = range.second % count;
+        std::size_t index = 0;
+        double maxDistance = tolerance;
+        for (std::size_t i = range.first + 1; i < range.second; ++i) {
+            double distance = getDistance(range.first, end, i);
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                index = i;
+            }
+        }
+        if (index == 0)
+            continue;
+        isKept[index] = true;
+        ranges.push_back(std::make_pair(range.first, index));
+        ranges.push_back(std::make_pair(index, range.second));
+    }
+
+    std::vector<utymap::meshing::Vector2> result;
+    for (std::size_t i = 0; i < count; ++i)
+        if (isKept[i])
+            result.push_back(contour[i]);
+
+    return result.size() < 3 ? contour : result;
+}
+
+/// Simplifies path of geocoordinates using Douglas-Peucker algorithm: removes points which are
+/// closer than tolerance (in degrees) to simplified path. Ends of open path are kept, closed path
+/// is split at the first point and the point which is the farthest from it. Returns false if no
+/// point is removed: result is not filled then.
+inline bool simplifyPath(const std::vector<utymap::GeoCoordinate>& path, double tolerance, bool isClosed,
+                         std::vector<utymap::GeoCoordinate>& result)
+{
+    std::size_t count = path.size();
+    if (isClosed && count > 1 && path[0] == path[count - 1])
+        --count;
+    if (count <= (isClosed ? 3u : 2u) || tolerance <= 0)
+        return false;
+
+    auto getDistance = [&](std::size_t a, std::size_t b, std::size_t p) {
+        double dx = path[b].longitude - path[a].longitude, dy = path[b].latitude - path[a].latitude;
+        double px = path[p].longitude - path[a].longitude, py = path[p].latitude - path[a].latitude;
+        double length = dx * dx + dy * dy;
+        double ratio = length > 0 ? std::max(0., std::min(1., (px * dx + py * dy) / length)) : 0;
+        return std::sqrt((px - dx * ratio) * (px - dx * ratio) + (py - dy * ratio) * (py - dy * ratio));
+    };
+
+    std::vector<bool> isKept(count, false);
+    std::vector<std::pair<std::size_t, std::size_t>> ranges;
+    isKept[0] = true;
+    if (isClosed) {
+        std::size_t farthest = 1;
+        for (std::size_t i = 2; i < count; ++i)
+            if (getDistance(0, 0, i) > getDistance(0, 0, farthest))
+                farthest = i;
+        isKept[farthest] = true;
+        ranges = { { 0, farthest }, { farthest, count } };
+    } else {
+        isKept[count - 1] = true;
+        ranges = { { 0, count - 1 } };
+    }
+
+    std::size_t keptCount = 2;
+    while (!ranges.empty()) {
+        auto range = ranges.back();
+        ranges.pop_back();
+        std::size_t end = range.second % count;
+        std::size_t index = 0;
+        double maxDistance = tolerance;
+        for (std::size_t i = range.first + 1; i < range.second; ++i) {
+            double distance = getDistance(range.first, end, i);
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                index = i;
+            }
+        }
+        if (index == 0)
+            continue;
+        isKept[index] = true;
+        ++keptCount;
+        ranges.push_back(std::make_pair(range.first, index));
+        ranges.push_back(std::make_pair(index, range.second));
+    }
+
+    if (keptCount == count)
+        return false;
+
+    result.clear();
+    result.reserve(keptCount);
+    for (std::size_t i = 0; i < count; ++i)
+        if (isKept[i])
+            result.push_back(path[i]);
+    return true;
+}
+
+/// Checks whether closed polygon has no intersecting or touching non adjacent edges.
+/// Edges are sorted by their min longitude, so only edges which overlap in longitude are tested.
+inline bool isSimplePolygon(const std::vector<utymap::GeoCoordinate>& polygon)
+{
+    std::size_t count = polygon.size();
+    if (count > 1 && polygon[0] == polygon[count - 1])
+        --count;
+    if (count < 3)
+        return false;
+
+    auto getMinLongitude = [&](std::size_t edge) {
+        return std::min(polygon[edge].longitude, polygon[(edge + 1) % count].longitude);
+    };
+    auto getMaxLongitude = [&](std::size_t edge) {
+        return std::max(polygon[edge].longitude, polygon[(edge + 1) % count].longitude);
+    };
+    auto getOrientation = [&](const utymap::GeoCoordinate& a, const utymap::GeoCoordinate& b, const utymap::GeoCoordinate& c) {
+        double value = (b.longitude - a.longitude) * (c.latitude - a.latitude) -
+                       (b.latitude - a.latitude) * (c.longitude - a.longitude);
+        return value > 0 ? 1 : (value < 0 ? -1 : 0);
+    };
+    auto isOnSegment = [](const utymap::GeoCoordinate& a, const utymap::GeoCoordinate& b, const utymap::GeoCoordinate& p) {
+        return p.longitude >= std::min(a.longitude, b.longitude) && p.longitude <= std::max(a.longitude, b.longitude) &&
+               p.latitude >= std::min(a.latitude, b.latitude) && p.latitude <= std::max(a.latitude, b.latitude);
+    };
+    auto isIntersecting = [&](std::size_t first, std::size_t second) {
+        const auto& a = polygon[first], & b = polygon[(first + 1) % count];
+        const auto& c = polygon[second], & d = polygon[(second + 1) % count];
+        int o1 = getOrientation(a, b, c), o2 = getOrientation(a, b, d);
+        int o3 = getOrientation(c, d, a), o4 = getOrientation(c, d, b);
+        if (o1 != o2 && o3 != o4)
+            return true;
+        return (o1 == 0 && isOnSegment(a, b, c)) || (o2 == 0 && isOnSegment(a, b, d)) ||
+               (o3 == 0 && isOnSegment(c, d, a)) || (o4 == 0 && isOnSegment(c, d, b));
+    };
+
+    std::vector<std::size_t> edges(count);
+    std::iota(edges.begin(), edges.end(), 0);
+    std::sort(edges.begin(), edges.end(), [&](std::size_t left, std::size_t right) {
+        return getMinLongitude(left) < getMinLongitude(right);
+    });
+
+    for (std::size_t i = 0; i < count; ++i) {
+        double maxLongitude = getMaxLongitude(edges[i]);
+        for (std::size_t j = i + 1; j < count && getMinLongitude(edges[j]) <= maxLongitude; ++j) {
+            std::size_t first = std::min(edges[i], edges[j]), second = std::max(edges[i], edges[j]);
+            // NOTE adjacent edges share vertex.
+            if (second == first + 1 || (first == 0 && second == count - 1))
+                continue;
+            if (isIntersecting(first, second))
+                return false;
+        }
+    }
+    return true;
+}
+
 }}
 
 #endif // UTILS_GEOMETRYUTILS_HPP_DEFINED
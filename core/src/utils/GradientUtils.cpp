@@ -305,3 +305,10 @@ const ColorGradient& GradientUtils::evaluateGradient(const StyleProvider& styleP
     // TODO evaluate gradient using tags
     return styleProvider.getGradient(style.getString(key));
 }
+
+const ColorGradient& GradientUtils::evaluateGradient(const StyleProvider& styleProvider,
+                                                     const Style &style,
+                                                     std::uint32_t keyId)
+{
+    return styleProvider.getGradient(style.getString(keyId));
+}
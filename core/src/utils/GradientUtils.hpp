@@ -33,12 +33,17 @@ public:
                                                                  const utymap::mapcss::Style& style,
                                                                  const std::string& key);
 
+    /// Gets gradient using key id.
+    static const utymap::mapcss::ColorGradient& evaluateGradient(const utymap::mapcss::StyleProvider& styleProvider,
+                                                                 const utymap::mapcss::Style& style,
+                                                                 std::uint32_t keyId);
+
     /// Gets color for specific coordinate using coherent noise function
     static utymap::mapcss::Color getColor(const utymap::mapcss::ColorGradient& gradient,
                                           double x, double y, double noise)
     {
         double colorTime = (NoiseUtils::perlin2D(x, y, noise) + 1) / 2;
-        return gradient.evaluate(colorTime);
+        return utymap::mapcss::Color(static_cast<int>(gradient.lookup(colorTime)));
     }
 
 private:
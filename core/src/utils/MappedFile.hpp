@@ -0,0 +1,43 @@
+#ifndef UTILS_MAPPEDFILE_HPP_DEFINED
+#define UTILS_MAPPEDFILE_HPP_DEFINED
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+namespace utymap { namespace utils {
+
+/// Provides read only access to file content using memory mapping.
+class MappedFile final
+{
+public:
+    explicit MappedFile(const std::string& path) : mapping_(), region_()
+    {
+        // NOTE mapping of empty or non existing file is not possible.
+        std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!file.good() || file.tellg() <= 0)
+            return;
+        file.close();
+
+        using namespace boost::interprocess;
+        file_mapping mapping(path.c_str(), read_only);
+        mapped_region region(mapping, read_only);
+        mapping_.swap(mapping);
+        region_.swap(region);
+    }
+
+    const char* data() const { return static_cast<const char*>(region_.get_address()); }
+
+    std::size_t size() const { return region_.get_size(); }
+
+private:
+    boost::interprocess::file_mapping mapping_;
+    boost::interprocess::mapped_region region_;
+};
+
+}}
+
+#endif // UTILS_MAPPEDFILE_HPP_DEFINED
@@ -0,0 +1,50 @@
+#ifndef UTILS_METRICSCALE_HPP_DEFINED
+#define UTILS_METRICSCALE_HPP_DEFINED
+
+#include "BoundingBox.hpp"
+#include "GeoCoordinate.hpp"
+#include "utils/GeoUtils.hpp"
+
+namespace utymap { namespace utils {
+
+/// Converts meters to degrees inside bounding box of tile without trigonometry per conversion:
+/// degrees per meter are computed once for small grid of latitudes and interpolated between them.
+/// Latitudes of grid include tile center, so conversion at center matches GeoUtils::getOffset.
+class MetricScale final
+{
+public:
+    /// Amount of latitude intervals of grid.
+    static const int Rows = 8;
+
+    explicit MetricScale(const utymap::BoundingBox& bbox) :
+        minLatitude_(bbox.minPoint.latitude),
+        maxLatitude_(bbox.maxPoint.latitude),
+        step_((bbox.maxPoint.latitude - bbox.minPoint.latitude) / Rows)
+    {
+        for (int i = 0; i <= Rows; ++i)
+            degreesPerMeter_[i] = GeoUtils::getOffset(GeoCoordinate(minLatitude_ + i * step_, 0), 1);
+    }
+
+    /// Returns offset in degrees of given meters at coordinate. Coordinates outside of bounding
+    /// box are converted directly.
+    double toDegrees(const utymap::GeoCoordinate& coordinate, double meters) const
+    {
+        if (step_ <= 0 || coordinate.latitude < minLatitude_ || coordinate.latitude > maxLatitude_)
+            return GeoUtils::getOffset(coordinate, meters);
+
+        double position = (coordinate.latitude - minLatitude_) / step_;
+        int row = position < Rows ? static_cast<int>(position) : Rows - 1;
+        double ratio = position - row;
+        return meters * (degreesPerMeter_[row] + (degreesPerMeter_[row + 1] - degreesPerMeter_[row]) * ratio);
+    }
+
+private:
+    const double minLatitude_;
+    const double maxLatitude_;
+    const double step_;
+    double degreesPerMeter_[Rows + 1];
+};
+
+}}
+
+#endif // UTILS_METRICSCALE_HPP_DEFINED
@@ -1,5 +1,6 @@
 #include "utils/NoiseUtils.hpp"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace utymap::meshing;
@@ -7,6 +8,8 @@ using namespace utymap::utils;
 
 const double Sqr2 = std::sqrt(2);
 
+const std::size_t NoiseUtils::BlockSize;
+
 const int NoiseUtils::Hash[] =
 {
     151, 160, 137, 91, 90, 15, 131, 13, 201, 95, 96, 53, 194, 233, 7, 225,
@@ -115,6 +118,68 @@ double NoiseUtils::perlin2D(double x, double y, double frequency)
     return (a + b * tx + (c + d * tx) * ty) * Sqr2;
 }
 
+void NoiseUtils::perlin2D(const double* points, std::size_t count, double frequency, double* noise)
+{
+    if (frequency < 1E-5) {
+        std::fill(noise, noise + count, 0);
+        return;
+    }
+
+    double tx0[BlockSize], ty0[BlockSize];
+    double g00x[BlockSize], g00y[BlockSize], g10x[BlockSize], g10y[BlockSize];
+    double g01x[BlockSize], g01y[BlockSize], g11x[BlockSize], g11y[BlockSize];
+
+    for (std::size_t start = 0; start < count; start += BlockSize) {
+        std::size_t size = std::min(BlockSize, count - start);
+        const double* block = points + start * 2;
+
+        // lookup pass: hash table access cannot be vectorized.
+        for (std::size_t i = 0; i < size; ++i) {
+            double x = block[i * 2] * frequency;
+            double y = block[i * 2 + 1] * frequency;
+            int ix0 = static_cast<int>(std::floor(x));
+            int iy0 = static_cast<int>(std::floor(y));
+            tx0[i] = x - ix0;
+            ty0[i] = y - iy0;
+            ix0 &= HashMask;
+            iy0 &= HashMask;
+
+            int h0 = Hash[ix0];
+            int h1 = Hash[ix0 + 1];
+            const Vector2& g00 = Gradients2D[Hash[h0 + iy0] & GradientsMask2D];
+            const Vector2& g10 = Gradients2D[Hash[h1 + iy0] & GradientsMask2D];
+            const Vector2& g01 = Gradients2D[Hash[h0 + iy0 + 1] & GradientsMask2D];
+            const Vector2& g11 = Gradients2D[Hash[h1 + iy0 + 1] & GradientsMask2D];
+            g00x[i] = g00.x; g00y[i] = g00.y;
+            g10x[i] = g10.x; g10y[i] = g10.y;
+            g01x[i] = g01.x; g01y[i] = g01.y;
+            g11x[i] = g11.x; g11y[i] = g11.y;
+        }
+
+        // arithmetic pass: no branches and table accesses.
+        double* result = noise + start;
+        for (std::size_t i = 0; i < size; ++i) {
+            double tx1 = tx0[i] - 1;
+            double ty1 = ty0[i] - 1;
+
+            double v00 = g00x[i] * tx0[i] + g00y[i] * ty0[i];
+            double v10 = g10x[i] * tx1 + g10y[i] * ty0[i];
+            double v01 = g01x[i] * tx0[i] + g01y[i] * ty1;
+            double v11 = g11x[i] * tx1 + g11y[i] * ty1;
+
+            double tx = smooth(tx0[i]);
+            double ty = smooth(ty0[i]);
+
+            double a = v00;
+            double b = v10 - v00;
+            double c = v01 - v00;
+            double d = v11 - v01 - v10 + v00;
+
+            result[i] = (a + b * tx + (c + d * tx) * ty) * Sqr2;
+        }
+    }
+}
+
 double NoiseUtils::perlin3D(double x, double y, double z, double frequency)
 {
     if (frequency < 1E-5) return 0;
@@ -175,3 +240,13 @@ double NoiseUtils::perlin3D(double x, double y, double z, double frequency)
 
     return a + b * tx + (c + e * tx) * ty + (d + f * tx + (g + h * tx) * ty) * tz;
 }
+
+double NoiseUtils::random(double x, double y, std::uint64_t salt)
+{
+    std::uint64_t hash = static_cast<std::uint64_t>(static_cast<std::int64_t>(x * 1E7)) * 0x9E3779B97F4A7C15ULL ^
+                         static_cast<std::uint64_t>(static_cast<std::int64_t>(y * 1E7)) * 0xC2B2AE3D27D4EB4FULL ^ salt;
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return static_cast<double>(hash >> 11) / 9007199254740992.;
+}
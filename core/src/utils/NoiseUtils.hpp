@@ -3,6 +3,9 @@
 
 #include "meshing/MeshTypes.hpp"
 
+#include <cstddef>
+#include <cstdint>
+
 namespace utymap { namespace utils {
 
 /// Provides noise generation functions.
@@ -13,9 +16,18 @@ public:
     /// Calculates perlin 2D noise.
     static double perlin2D(double x, double y, double frequency);
 
+    /// Calculates perlin 2D noise for given amount of points stored as interleaved x and y values.
+    /// Produces the same values as scalar version, but separates table lookups from arithmetic
+    /// which is done over contiguous blocks, so compiler can vectorize it.
+    static void perlin2D(const double* points, std::size_t count, double frequency, double* noise);
+
     /// Calculates perlin 3D noise.
     static double perlin3D(double x, double y, double z, double freq);
 
+    /// Returns pseudo random value in [0, 1) which depends only on coordinates and salt,
+    /// so the same object gets the same value when tile is rebuilt.
+    static double random(double x, double y, std::uint64_t salt);
+
 private:
 
     static double dot(const utymap::meshing::Vector3& g, double x, double y, double z)
@@ -33,6 +45,8 @@ private:
         return t*t*t*(t*(t * 6 - 15) + 10);
     }
 
+    /// Amount of points processed at once by batched version.
+    static const std::size_t BlockSize = 64;
     static const int HashMask = 255;
     static const int GradientsMask2D = 7;
     static const int GradientsMask3D = 15;
@@ -0,0 +1,91 @@
+#ifndef UTILS_SHAREDMUTEX_HPP_DEFINED
+#define UTILS_SHAREDMUTEX_HPP_DEFINED
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace utymap { namespace utils {
+
+/// Mutex which is owned either by many readers or by single writer. Waiting writer blocks
+/// new readers, so it is not starved by continuous reads. Not recursive.
+class SharedMutex final
+{
+public:
+    SharedMutex() : readers_(0), waitingWriters_(0), isWriting_(false)
+    {
+    }
+
+    SharedMutex(const SharedMutex&) = delete;
+    SharedMutex& operator=(const SharedMutex&) = delete;
+
+    /// Acquires exclusive ownership.
+    void lock()
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        ++waitingWriters_;
+        condition_.wait(lock, [&]() { return !isWriting_ && readers_ == 0; });
+        --waitingWriters_;
+        isWriting_ = true;
+    }
+
+    void unlock()
+    {
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            isWriting_ = false;
+        }
+        condition_.notify_all();
+    }
+
+    /// Acquires shared ownership.
+    void lock_shared()
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        condition_.wait(lock, [&]() { return !isWriting_ && waitingWriters_ == 0; });
+        ++readers_;
+    }
+
+    void unlock_shared()
+    {
+        bool isLast;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            isLast = --readers_ == 0;
+        }
+        if (isLast)
+            condition_.notify_all();
+    }
+
+private:
+    std::size_t readers_;
+    std::size_t waitingWriters_;
+    bool isWriting_;
+    std::mutex lock_;
+    std::condition_variable condition_;
+};
+
+/// Holds shared ownership of mutex in scope.
+class SharedLock final
+{
+public:
+    explicit SharedLock(SharedMutex& mutex) : mutex_(mutex)
+    {
+        mutex_.lock_shared();
+    }
+
+    SharedLock(const SharedLock&) = delete;
+    SharedLock& operator=(const SharedLock&) = delete;
+
+    ~SharedLock()
+    {
+        mutex_.unlock_shared();
+    }
+
+private:
+    SharedMutex& mutex_;
+};
+
+}}
+
+#endif // UTILS_SHAREDMUTEX_HPP_DEFINED
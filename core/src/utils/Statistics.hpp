@@ -0,0 +1,170 @@
+#ifndef UTILS_STATISTICS_HPP_DEFINED
+#define UTILS_STATISTICS_HPP_DEFINED
+
+#include "utils/AllocationCounter.hpp"
+#include "utils/TraceRecorder.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace utymap { namespace utils {
+
+/// Collects amount of calls and time spent in stages of quadkey build and import. Stages are nested,
+/// e.g. builder time includes style matching, triangulation and mesh callback. Collecting
+/// is enabled by UTYMAP_STATISTICS definition, otherwise statistics stay empty. Heap allocations
+/// made by stage thread are counted too if allocation counting is enabled: allocations of worker
+/// threads started by stage are not included, use AllocationCounter::total() for them. Stages are
+/// also recorded as trace events when trace recording is started. Thread safe.
+class Statistics final
+{
+public:
+    enum class Stage
+    {
+        QuadKeyBuild,
+        GeoStoreSearch,
+        ElementStoreSearch,
+        StyleMatching,
+        TerrainBuilder,
+        BuildingBuilder,
+        TreeBuilder,
+        BarrierBuilder,
+        OtherBuilder,
+        Triangulation,
+        MeshCallback,
+        Import,
+        Count
+    };
+
+    /// Adds time and allocations of stage to statistics while it is alive.
+    class Scope final
+    {
+    public:
+        explicit Scope(Stage stage) :
+            trace_(getName(stage), "build"), stage_(stage), start_(std::chrono::steady_clock::now()),
+            allocations_(AllocationCounter::current())
+        {
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        ~Scope()
+        {
+            auto elapsed = std::chrono::steady_clock::now() - start_;
+            Statistics::instance().add(stage_,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                AllocationCounter::current() - allocations_);
+        }
+
+    private:
+        const TraceRecorder::Scope trace_;
+        const Stage stage_;
+        const std::chrono::steady_clock::time_point start_;
+        const std::uint64_t allocations_;
+    };
+
+    static Statistics& instance()
+    {
+        static Statistics statistics;
+        return statistics;
+    }
+
+    Statistics(const Statistics&) = delete;
+    Statistics& operator=(const Statistics&) = delete;
+
+    void add(Stage stage, std::int64_t nanoseconds, std::uint64_t allocations = 0)
+    {
+        auto& counter = counters_[static_cast<int>(stage)];
+        counter.calls.fetch_add(1, std::memory_order_relaxed);
+        counter.nanoseconds.fetch_add(static_cast<std::uint64_t>(nanoseconds), std::memory_order_relaxed);
+        counter.allocations.fetch_add(allocations, std::memory_order_relaxed);
+    }
+
+    std::uint64_t getCalls(Stage stage) const
+    {
+        return counters_[static_cast<int>(stage)].calls.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t getNanoseconds(Stage stage) const
+    {
+        return counters_[static_cast<int>(stage)].nanoseconds.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t getAllocations(Stage stage) const
+    {
+        return counters_[static_cast<int>(stage)].allocations.load(std::memory_order_relaxed);
+    }
+
+    /// Returns name of stage used in json and trace.
+    static const char* getName(Stage stage)
+    {
+        static const char* names[] = {
+            "quadkey_build", "geostore_search", "element_store_search", "style_matching",
+            "terrain_builder", "building_builder", "tree_builder", "barrier_builder",
+            "other_builder", "triangulation", "mesh_callback", "import"
+        };
+        static_assert(sizeof(names) / sizeof(names[0]) == static_cast<int>(Stage::Count),
+                      "Every stage should have name.");
+        return names[static_cast<int>(stage)];
+    }
+
+    /// Returns statistics as json object where every stage has amount of calls and total time,
+    /// and amount of allocations if they are counted.
+    std::string toJson() const
+    {
+        std::stringstream ss;
+        ss << "{";
+        for (int i = 0; i < static_cast<int>(Stage::Count); ++i) {
+            ss << (i == 0 ? "" : ",") << "\"" << getName(static_cast<Stage>(i)) << "\":{\"calls\":"
+               << getCalls(static_cast<Stage>(i)) << ",\"ms\":"
+               << getNanoseconds(static_cast<Stage>(i)) / 1E6;
+            if (AllocationCounter::isEnabled())
+                ss << ",\"allocations\":" << getAllocations(static_cast<Stage>(i));
+            ss << "}";
+        }
+        ss << "}";
+        return ss.str();
+    }
+
+    void reset()
+    {
+        for (auto& counter : counters_) {
+            counter.calls.store(0, std::memory_order_relaxed);
+            counter.nanoseconds.store(0, std::memory_order_relaxed);
+            counter.allocations.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct Counter final
+    {
+        std::atomic<std::uint64_t> calls;
+        std::atomic<std::uint64_t> nanoseconds;
+        std::atomic<std::uint64_t> allocations;
+    };
+
+    Statistics()
+    {
+        reset();
+    }
+
+    Counter counters_[static_cast<int>(Stage::Count)];
+};
+
+}}
+
+#define UTYMAP_STATISTICS_CONCAT_IMPL(a, b) a##b
+#define UTYMAP_STATISTICS_CONCAT(a, b) UTYMAP_STATISTICS_CONCAT_IMPL(a, b)
+
+/// Measures time of the rest of enclosing scope as given stage.
+#ifdef UTYMAP_STATISTICS
+#define UTYMAP_STATISTICS_SCOPE(stage) \
+    utymap::utils::Statistics::Scope UTYMAP_STATISTICS_CONCAT(statisticsScope, __LINE__)(utymap::utils::Statistics::Stage::stage)
+#else
+#define UTYMAP_STATISTICS_SCOPE(stage)
+#endif
+
+#endif // UTILS_STATISTICS_HPP_DEFINED
@@ -0,0 +1,285 @@
+#include "utils/TaskScheduler.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/SharedMutex.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace utymap::utils;
+
+namespace {
+    const std::size_t PriorityCount = 3;
+
+    /// Binds thread to core with given index.
+    void pin(std::thread& thread, std::size_t index)
+    {
+#ifdef __linux__
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(index % std::max(1u, std::thread::hardware_concurrency()), &cpus);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+#else
+        (void) thread;
+        (void) index;
+#endif
+    }
+}
+
+class TaskScheduler::TaskSchedulerImpl final
+{
+    /// Pending tasks of single worker by priority.
+    struct Queue final
+    {
+        std::mutex lock;
+        std::deque<Task> tasks[PriorityCount];
+    };
+
+public:
+    TaskSchedulerImpl() :
+        queues_(), threads_(), pendingCount_(0), nextQueue_(0), isStopped_(false)
+    {
+    }
+
+    ~TaskSchedulerImpl()
+    {
+        stop();
+    }
+
+    void configure(std::size_t threadCount, bool isPinned)
+    {
+        std::lock_guard<std::mutex> configureLock(configureLock_);
+        stop();
+
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        {
+            std::lock_guard<SharedMutex> lock(queuesLock_);
+            std::vector<std::unique_ptr<Queue>> queues;
+            for (std::size_t i = 0; i < threadCount; ++i)
+                queues.push_back(utymap::utils::make_unique<Queue>());
+            // NOTE pending tasks are moved to the first queue: they are stolen from it.
+            for (auto& queue : queues_) {
+                for (std::size_t priority = 0; priority < PriorityCount; ++priority) {
+                    auto& tasks = queues.front()->tasks[priority];
+                    std::move(queue->tasks[priority].begin(), queue->tasks[priority].end(), std::back_inserter(tasks));
+                }
+            }
+            queues_.swap(queues);
+        }
+
+        isStopped_ = false;
+        for (std::size_t i = 0; i < threadCount; ++i) {
+            threads_.emplace_back([this, i]() { work(i); });
+            if (isPinned)
+                pin(threads_.back(), i);
+        }
+    }
+
+    std::size_t getThreadCount()
+    {
+        SharedLock lock(queuesLock_);
+        return queues_.size();
+    }
+
+    void submit(const Task& task, TaskPriority priority)
+    {
+        {
+            SharedLock lock(queuesLock_);
+            std::size_t index = current_ == this && currentQueue_ < queues_.size()
+                ? currentQueue_ : nextQueue_++ % queues_.size();
+            std::lock_guard<std::mutex> queueLock(queues_[index]->lock);
+            queues_[index]->tasks[static_cast<std::size_t>(priority)].push_back(task);
+            ++pendingCount_;
+        }
+        {
+            // NOTE lock is taken, so notification cannot be missed by worker going to sleep.
+            std::lock_guard<std::mutex> lock(sleepLock_);
+        }
+        wake_.notify_one();
+    }
+
+private:
+    void work(std::size_t index)
+    {
+        current_ = this;
+        currentQueue_ = index;
+        while (true) {
+            Task task;
+            if (take(index, task)) {
+                task();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleepLock_);
+            wake_.wait(lock, [&]() { return isStopped_ || pendingCount_ > 0; });
+            if (isStopped_)
+                return;
+        }
+    }
+
+    /// Takes the newest task of own queue or the oldest task of other queue with highest priority.
+    bool take(std::size_t index, Task& task)
+    {
+        SharedLock lock(queuesLock_);
+        for (std::size_t priority = 0; priority < PriorityCount; ++priority) {
+            for (std::size_t i = 0; i < queues_.size(); ++i) {
+                Queue& queue = *queues_[(index + i) % queues_.size()];
+                std::lock_guard<std::mutex> queueLock(queue.lock);
+                auto& tasks = queue.tasks[priority];
+                if (tasks.empty())
+                    continue;
+                if (i == 0) {
+                    task = std::move(tasks.back());
+                    tasks.pop_back();
+                } else {
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+                --pendingCount_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Stops threads waiting for running tasks.
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepLock_);
+            isStopped_ = true;
+        }
+        wake_.notify_all();
+        for (auto& thread : threads_)
+            thread.join();
+        threads_.clear();
+    }
+
+    static thread_local const TaskSchedulerImpl* current_;
+    static thread_local std::size_t currentQueue_;
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<std::size_t> pendingCount_;
+    std::atomic<std::size_t> nextQueue_;
+    bool isStopped_;
+    /// Shared while queues are used, exclusive when they are replaced.
+    SharedMutex queuesLock_;
+    std::mutex sleepLock_;
+    std::condition_variable wake_;
+    std::mutex configureLock_;
+};
+
+thread_local const TaskScheduler::TaskSchedulerImpl* TaskScheduler::TaskSchedulerImpl::current_ = nullptr;
+thread_local std::size_t TaskScheduler::TaskSchedulerImpl::currentQueue_ = 0;
+
+TaskScheduler::TaskScheduler(std::size_t threadCount, bool isPinned) :
+    pimpl_(utymap::utils::make_unique<TaskSchedulerImpl>())
+{
+    pimpl_->configure(threadCount, isPinned);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+}
+
+TaskScheduler& TaskScheduler::instance()
+{
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+void TaskScheduler::configure(std::size_t threadCount, bool isPinned)
+{
+    pimpl_->configure(threadCount, isPinned);
+}
+
+std::size_t TaskScheduler::getThreadCount() const
+{
+    return pimpl_->getThreadCount();
+}
+
+void TaskScheduler::submit(const Task& task, TaskPriority priority)
+{
+    pimpl_->submit(task, priority);
+}
+
+TaskGroup::TaskGroup(TaskPriority priority, const CancellationToken& token, TaskScheduler& scheduler) :
+    state_(std::make_shared<State>(token)), scheduler_(scheduler), priority_(priority)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    try { wait(); }
+    catch (...) { }
+}
+
+void TaskGroup::run(const TaskScheduler::Task& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(state_->lock);
+        state_->tasks.push_back(task);
+    }
+    // NOTE worker runs one pending task of group, if waiting thread has not run all of them.
+    std::weak_ptr<State> state = state_;
+    scheduler_.submit([state]() {
+        if (auto owner = state.lock())
+            owner->runNext();
+    }, priority_);
+}
+
+void TaskGroup::wait()
+{
+    State& state = *state_;
+    while (true) {
+        while (state.runNext()) { }
+
+        std::unique_lock<std::mutex> lock(state.lock);
+        state.completed.wait(lock, [&]() { return !state.tasks.empty() || state.running == 0; });
+        if (state.tasks.empty() && state.running == 0) {
+            std::exception_ptr exception;
+            std::swap(exception, state.exception);
+            if (exception)
+                std::rethrow_exception(exception);
+            return;
+        }
+    }
+}
+
+bool TaskGroup::State::runNext()
+{
+    TaskScheduler::Task task;
+    bool isSkipped;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (tasks.empty())
+            return false;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+        isSkipped = exception != nullptr || token.isCancelled();
+        ++running;
+    }
+
+    std::exception_ptr thrown;
+    if (!isSkipped) {
+        try { task(); }
+        catch (...) { thrown = std::current_exception(); }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (thrown && !exception)
+            exception = thrown;
+        --running;
+    }
+    completed.notify_all();
+    return true;
+}
@@ -0,0 +1,128 @@
+#ifndef UTILS_TASKSCHEDULER_HPP_DEFINED
+#define UTILS_TASKSCHEDULER_HPP_DEFINED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace utymap { namespace utils {
+
+/// Priority of task: pending tasks with higher priority are taken first.
+enum class TaskPriority
+{
+    High = 0,
+    Normal = 1,
+    Low = 2
+};
+
+/// Flag shared by copies which cancels tasks that are not started yet.
+class CancellationToken final
+{
+public:
+    CancellationToken() : isCancelled_(std::make_shared<std::atomic<bool>>(false))
+    {
+    }
+
+    void cancel() { *isCancelled_ = true; }
+
+    bool isCancelled() const { return *isCancelled_; }
+
+private:
+    std::shared_ptr<std::atomic<bool>> isCancelled_;
+};
+
+/// Work stealing pool of threads shared by parallel paths of library, so they do not
+/// oversubscribe cores. Every worker has own queue: tasks submitted by worker go to its
+/// queue, idle workers steal the oldest tasks of others. Thread safe.
+class TaskScheduler final
+{
+public:
+    typedef std::function<void()> Task;
+
+    /// Creates scheduler with given amount of threads: zero means hardware concurrency.
+    /// If isPinned is set, every thread is bound to single core where it is supported.
+    explicit TaskScheduler(std::size_t threadCount = 0, bool isPinned = false);
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    /// Stops threads waiting for running tasks. Pending tasks are dropped.
+    ~TaskScheduler();
+
+    /// Returns scheduler which is used by library.
+    static TaskScheduler& instance();
+
+    /// Replaces threads waiting for running tasks. Pending tasks are kept.
+    void configure(std::size_t threadCount, bool isPinned);
+
+    /// Returns amount of threads.
+    std::size_t getThreadCount() const;
+
+    /// Adds task to queue. Task should not throw.
+    void submit(const Task& task, TaskPriority priority = TaskPriority::Normal);
+
+private:
+    class TaskSchedulerImpl;
+    std::unique_ptr<TaskSchedulerImpl> pimpl_;
+};
+
+/// Group of tasks which are run by scheduler and waited for together. Waiting thread runs
+/// pending tasks of the group itself, so groups can be waited for from tasks and hold no
+/// worker blocked. The first thrown exception is rethrown by wait: tasks which are not
+/// started after it are skipped as well as tasks after cancellation.
+class TaskGroup final
+{
+public:
+    explicit TaskGroup(TaskPriority priority = TaskPriority::Normal,
+                       const CancellationToken& token = CancellationToken(),
+                       TaskScheduler& scheduler = TaskScheduler::instance());
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    /// Waits for tasks ignoring their exceptions.
+    ~TaskGroup();
+
+    /// Adds task to group.
+    void run(const TaskScheduler::Task& task);
+
+    /// Waits until all tasks are completed or skipped.
+    void wait();
+
+    /// Skips tasks which are not started yet.
+    void cancel() { state_->token.cancel(); }
+
+    bool isCancelled() const { return state_->token.isCancelled(); }
+
+private:
+    struct State final
+    {
+        explicit State(const CancellationToken& token) :
+            tasks(), running(0), exception(), token(token)
+        {
+        }
+
+        /// Runs the oldest pending task. Returns false if there is no pending task.
+        bool runNext();
+
+        std::mutex lock;
+        std::condition_variable completed;
+        std::deque<TaskScheduler::Task> tasks;
+        std::size_t running;
+        std::exception_ptr exception;
+        CancellationToken token;
+    };
+
+    std::shared_ptr<State> state_;
+    TaskScheduler& scheduler_;
+    const TaskPriority priority_;
+};
+
+}}
+
+#endif // UTILS_TASKSCHEDULER_HPP_DEFINED
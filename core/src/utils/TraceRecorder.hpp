@@ -0,0 +1,163 @@
+#ifndef UTILS_TRACERECORDER_HPP_DEFINED
+#define UTILS_TRACERECORDER_HPP_DEFINED
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace utymap { namespace utils {
+
+/// Records timeline of scoped events and writes it in chrome trace event format which is
+/// opened by chrome://tracing and Perfetto. Recording is started and stopped at runtime;
+/// when it is not started, scope costs one atomic load. Thread safe.
+class TraceRecorder final
+{
+public:
+    /// Max amount of kept events: the rest are dropped, so memory stays bounded.
+    static const std::size_t MaxEvents = 1000000;
+
+    /// Records event from construction to destruction if recording is started.
+    /// Name and category should be string literals as they are not copied.
+    class Scope final
+    {
+    public:
+        Scope(const char* name, const char* category) :
+            name_(name), category_(category),
+            isEnabled_(TraceRecorder::instance().isStarted()),
+            start_(isEnabled_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point())
+        {
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        ~Scope()
+        {
+            if (isEnabled_)
+                TraceRecorder::instance().add(name_, category_, start_, std::chrono::steady_clock::now());
+        }
+
+    private:
+        const char* name_;
+        const char* category_;
+        const bool isEnabled_;
+        const std::chrono::steady_clock::time_point start_;
+    };
+
+    static TraceRecorder& instance()
+    {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    bool isStarted() const
+    {
+        return isStarted_.load(std::memory_order_relaxed);
+    }
+
+    /// Starts recording discarding previously recorded events.
+    void start()
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        events_.clear();
+        origin_ = std::chrono::steady_clock::now();
+        isStarted_.store(true, std::memory_order_relaxed);
+    }
+
+    /// Stops recording and writes recorded events to file.
+    void stop(const std::string& path)
+    {
+        std::vector<Event> events;
+        std::chrono::steady_clock::time_point origin;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            isStarted_.store(false, std::memory_order_relaxed);
+            events.swap(events_);
+            origin = origin_;
+        }
+
+        std::ofstream file(path);
+        if (!file.good())
+            throw std::domain_error("Cannot write trace file: " + path);
+
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        for (std::size_t i = 0; i < events.size(); ++i) {
+            const auto& event = events[i];
+            file << (i == 0 ? "\n" : ",\n")
+                 << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+                 << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.threadId
+                 << ",\"ts\":" << toMicroseconds(event.start - origin)
+                 << ",\"dur\":" << toMicroseconds(event.end - event.start) << "}";
+        }
+        file << "\n]}\n";
+        if (file.fail())
+            throw std::domain_error("Cannot write trace file: " + path);
+    }
+
+    void add(const char* name, const char* category,
+             std::chrono::steady_clock::time_point start,
+             std::chrono::steady_clock::time_point end)
+    {
+        std::uint32_t threadId = getThreadId();
+        std::lock_guard<std::mutex> lock(lock_);
+        // NOTE events of scopes which are started before recording is started are dropped.
+        if (!isStarted() || start < origin_ || events_.size() >= MaxEvents)
+            return;
+        events_.push_back(Event { name, category, threadId, start, end });
+    }
+
+private:
+    struct Event final
+    {
+        const char* name;
+        const char* category;
+        std::uint32_t threadId;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point end;
+    };
+
+    TraceRecorder() : isStarted_(false), lock_(), events_(), origin_()
+    {
+    }
+
+    /// Returns small sequential id of calling thread: trace viewers show it as track.
+    static std::uint32_t getThreadId()
+    {
+        static std::atomic<std::uint32_t> nextId(1);
+        static thread_local std::uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    static double toMicroseconds(std::chrono::steady_clock::duration duration)
+    {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+
+    std::atomic<bool> isStarted_;
+    std::mutex lock_;
+    std::vector<Event> events_;
+    std::chrono::steady_clock::time_point origin_;
+};
+
+}}
+
+/// Records the rest of enclosing scope as trace event with given name and category.
+#ifdef UTYMAP_STATISTICS
+#define UTYMAP_TRACE_SCOPE(name, category) \
+    utymap::utils::TraceRecorder::Scope UTYMAP_TRACE_CONCAT(traceScope, __LINE__)(name, category)
+#define UTYMAP_TRACE_CONCAT_IMPL(a, b) a##b
+#define UTYMAP_TRACE_CONCAT(a, b) UTYMAP_TRACE_CONCAT_IMPL(a, b)
+#else
+#define UTYMAP_TRACE_SCOPE(name, category)
+#endif
+
+#endif // UTILS_TRACERECORDER_HPP_DEFINED
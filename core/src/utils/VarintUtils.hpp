@@ -0,0 +1,53 @@
+#ifndef UTILS_VARINTUTILS_HPP_DEFINED
+#define UTILS_VARINTUTILS_HPP_DEFINED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace utymap { namespace utils {
+
+/// Appends value as varint: seven bits per byte starting from the lowest ones, high bit of
+/// byte is set when more bytes follow.
+inline void writeVarint(std::string& data, std::uint64_t value)
+{
+    while (value >= 0x80) {
+        data.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<char>(value));
+}
+
+/// Reads varint at given position moving it past the value. Returns false if data ends
+/// before value or value is longer than 64 bits.
+inline bool readVarint(const char* data, std::size_t size, std::size_t& position, std::uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && position < size; shift += 7) {
+        std::uint8_t byte = static_cast<std::uint8_t>(data[position++]);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+inline bool readVarint(const std::string& data, std::size_t& position, std::uint64_t& value)
+{
+    return readVarint(data.data(), data.size(), position, value);
+}
+
+/// Maps signed value to unsigned one, so values of small magnitude have short varints.
+inline std::uint64_t zigzag(std::int64_t value)
+{
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t unzigzag(std::uint64_t value)
+{
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+}}
+
+#endif // UTILS_VARINTUTILS_HPP_DEFINED
@@ -3,6 +3,13 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
 #include "test_utils/ElementUtils.hpp"
 
 using namespace utymap::entities;
@@ -10,9 +17,23 @@ using namespace utymap::utils;
 
 namespace {
     const char* InMemoryStoreKey = "InMemory";
+    const char* PackageFile = "baked.ump";
+    const char* TraceFile = "trace.json";
+    const char* SessionFile = "session.txt";
 
     // Use global variable as it is used inside lambda which is passed as function.
     bool isCalled;
+    std::atomic<int> completedJobId;
+    std::atomic<int> meshCount;
+    std::atomic<int> errorCount;
+    std::vector<std::pair<int, const double*>> ownedMeshes;
+    int batchCount;
+    std::uint32_t maxStringId;
+    std::vector<std::string> syncedStrings;
+    std::vector<std::string> meshNames;
+    std::vector<int> loadedQuadKeys;
+    std::string statistics;
+    std::string memoryReport;
 
     struct ExportLibFixture {
         ExportLibFixture()
@@ -60,6 +81,11 @@ namespace {
             ::cleanup();
             std::remove((std::string(TEST_ASSETS_PATH) + "string.idx").c_str());
             std::remove((std::string(TEST_ASSETS_PATH) + "string.dat").c_str());
+            std::remove((std::string(TEST_ASSETS_PATH) + "string.hsh").c_str());
+            std::remove((std::string(TEST_ASSETS_PATH) + "tiles.mft").c_str());
+            std::remove((std::string(TEST_ASSETS_PATH) + "names.idx").c_str());
+            std::remove((std::string(TEST_ASSETS_PATH) + "ids.idx").c_str());
+            std::remove((std::string(TEST_ASSETS_PATH) + PackageFile).c_str());
         }
     };
 }
@@ -89,6 +115,14 @@ BOOST_AUTO_TEST_CASE(GivenTestData_WhenDataIsLoadedInLodRangeAtDetailedZoom_Then
     loadQuadKeys(16, 35205, 35205, 21489, 21489);
 }
 
+BOOST_AUTO_TEST_CASE(GivenElevationTilesWithoutFiles_WhenQuadKeyIsLoaded_ThenCallbacksAreCalled)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    ::registerElevationTiles("missing_terrain/", 12);
+
+    loadQuadKeys(16, 35205, 35205, 21489, 21489);
+}
+
 // This case tests dynamic addtion incremental addtion/search to store.
 BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeysAreLoadedInSequenceAtDetailedZoom_ThenCallbacksAreCalled)
 {
@@ -99,6 +133,445 @@ BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeysAreLoadedInSequenceAtDetailedZoom
     loadQuadKeys(16, 35204, 35204, 21490, 21490);
 }
 
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoadedPacked_ThenPackedCallbackIsCalled)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    isCalled = false;
+
+    ::loadQuadKeyPacked(TEST_MAPCSS_DEFAULT, 35205, 21489, 16,
+        [](const char* name, double originLongitude, double originLatitude,
+           const void* vertices, int vertexCount, const int* triangles, int triCount) {
+            isCalled = true;
+            BOOST_CHECK_GT(vertexCount, 0);
+            BOOST_CHECK_GT(triCount, 0);
+        },
+        [](uint64_t id, const char** tags, int size, const double* vertices,
+           int vertexCount, const char** style, int styleSize) {},
+        [](const char* message) { BOOST_FAIL(message); });
+
+    BOOST_CHECK(isCalled);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoadedAsync_ThenCompletionCallbackIsCalled)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    completedJobId = 0;
+
+    ::setCameraPosition(52.53, 13.38);
+    int jobId = ::loadQuadKeyAsync(TEST_MAPCSS_DEFAULT, 35205, 21489, 16,
+        [](const char* name,
+           const double* vertices, int vertexCount,
+           const int* triangles, int triCount,
+           const int* colors, int colorCount,
+           const double* uvs, int uvCount) {},
+        [](uint64_t id, const char** tags, int size, const double* vertices,
+           int vertexCount, const char** style, int styleSize) {},
+        [](const char* message) { BOOST_FAIL(message); },
+        [](int id, bool isCancelled) { if (!isCancelled) completedJobId = id; });
+
+    while (completedJobId == 0)
+        std::this_thread::yield();
+    BOOST_CHECK_EQUAL(completedJobId, jobId);
+    BOOST_CHECK(!::cancelJob(jobId));
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyJobIsSteppedWithZeroBudget_ThenItIsBuiltInSeveralCalls)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    meshCount = 0;
+    auto onError = [](const char* message) { BOOST_FAIL(message); };
+
+    int jobId = ::createQuadKeyJob(TEST_MAPCSS_DEFAULT, 35205, 21489, 16,
+        [](const char* name,
+           const double* vertices, int vertexCount,
+           const int* triangles, int triCount,
+           const int* colors, int colorCount,
+           const double* uvs, int uvCount) { ++meshCount; },
+        [](uint64_t id, const char** tags, int size, const double* vertices,
+           int vertexCount, const char** style, int styleSize) {},
+        onError);
+    int calls = 1;
+    while (!::stepQuadKeyJob(jobId, 0, onError))
+        ++calls;
+
+    BOOST_CHECK_GT(jobId, 0);
+    BOOST_CHECK_GT(calls, 1);
+    BOOST_CHECK_GT(meshCount, 0);
+    BOOST_CHECK(!::releaseQuadKeyJob(jobId));
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenLoadQuadKeyQueuedAndPoll_ThenResultsEndWithCompletion)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    int meshes = 0, elements = 0;
+    bool isCompleted = false;
+    PolledResult results[16];
+
+    int jobId = ::loadQuadKeyQueued(TEST_MAPCSS_DEFAULT, 35205, 21489, 16);
+    while (!isCompleted) {
+        int count = ::pollResults(results, 16);
+        for (int i = 0; i < count; ++i) {
+            BOOST_CHECK_EQUAL(results[i].jobId, jobId);
+            BOOST_CHECK_NE(results[i].kind, ErrorResult);
+            if (results[i].kind == MeshResult) {
+                BOOST_CHECK_GT(results[i].vertexSize, 0);
+                ++meshes;
+            }
+            else if (results[i].kind == ElementResult)
+                ++elements;
+            else if (results[i].kind == JobCompletedResult)
+                isCompleted = !results[i].isCancelled;
+        }
+        if (count == 0)
+            std::this_thread::yield();
+    }
+
+    BOOST_CHECK_GT(meshes, 0);
+    BOOST_CHECK_EQUAL(::pollResults(results, 16), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRegion_WhenWarmup_ThenCompletionIsCalledAndItsQuadKeysAreNotPrefetchedAgain)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    const char* styleFiles[] = { TEST_MAPCSS_DEFAULT };
+    completedJobId = 0;
+
+    int jobId = ::warmup(styleFiles, 1, 52.52, 13.37, 52.54, 13.39, 16,
+        [](const char* message) { BOOST_FAIL(message); },
+        [](int id, bool isCancelled) { if (!isCancelled) completedJobId = id; });
+
+    while (completedJobId == 0)
+        std::this_thread::yield();
+    BOOST_CHECK_EQUAL(completedJobId, jobId);
+    BOOST_CHECK_EQUAL(::setCameraMotion(52.53, 13.38, 0, 0, 16, nullptr), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMovingCamera_WhenSetCameraMotionTwice_ThenQuadKeysAlongPathArePrefetchedOnce)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+
+    int first = ::setCameraMotion(52.53, 13.38, 90, 300, 16, nullptr);
+    int second = ::setCameraMotion(52.53, 13.38, 90, 300, 16, nullptr);
+    int stopped = ::setCameraMotion(52.6, 13.38, 0, 0, 16, nullptr);
+
+    BOOST_CHECK_GT(first, 1);
+    BOOST_CHECK_EQUAL(second, 0);
+    BOOST_CHECK_EQUAL(stopped, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeysAreLoadedInParallelDuringReload_ThenAllAreBuilt)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35204, 21490, 16, callback);
+    meshCount = 0;
+    errorCount = 0;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([i]() {
+            // NOTE boost test assertions are not thread safe, so results are only counted here.
+            ::loadQuadKey(TEST_MAPCSS_DEFAULT, 35204 + i % 2, 21489 + i / 2, 16,
+                [](const char* name,
+                   const double* vertices, int vertexCount,
+                   const int* triangles, int triCount,
+                   const int* colors, int colorCount,
+                   const double* uvs, int uvCount) { ++meshCount; },
+                [](uint64_t id, const char** tags, int size, const double* vertices,
+                   int vertexCount, const char** style, int styleSize) {},
+                [](const char* message) { ++errorCount; });
+        });
+    }
+    for (int i = 0; i < 3; ++i)
+        ::reloadStylesheet(TEST_MAPCSS_DEFAULT, [](const char* message) { ++errorCount; });
+    for (auto& thread : threads)
+        thread.join();
+
+    BOOST_CHECK_EQUAL(errorCount, 0);
+    BOOST_CHECK_GT(meshCount, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenBakedMeshPackage_WhenQuadKeyIsLoadedPacked_ThenMeshesAreReadFromPackage)
+{
+    const std::string packagePath = std::string(TEST_ASSETS_PATH) + PackageFile;
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    auto bbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(utymap::QuadKey(16, 35205, 21489));
+    double latOffset = (bbox.maxPoint.latitude - bbox.minPoint.latitude) / 4, lonOffset = bbox.width() / 4;
+    ::bakeMeshPackage(TEST_MAPCSS_DEFAULT, bbox.minPoint.latitude + latOffset, bbox.minPoint.longitude + lonOffset,
+        bbox.maxPoint.latitude - latOffset, bbox.maxPoint.longitude - lonOffset, 16, 16, packagePath.c_str(), 2,
+        [](const char* message) { BOOST_FAIL(message); });
+    ::registerMeshPackage(packagePath.c_str(), [](const char* message) { BOOST_FAIL(message); });
+    isCalled = false;
+
+    // NOTE elements are not stored in package.
+    ::loadQuadKeyPacked(TEST_MAPCSS_DEFAULT, 35205, 21489, 16,
+        [](const char* name, double originLongitude, double originLatitude,
+           const void* vertices, int vertexCount, const int* triangles, int triCount) {
+            isCalled = true;
+            BOOST_CHECK_GT(vertexCount, 0);
+        },
+        [](uint64_t id, const char** tags, int size, const double* vertices,
+           int vertexCount, const char** style, int styleSize) { BOOST_FAIL("Element is not expected."); },
+        [](const char* message) { BOOST_FAIL(message); });
+
+    BOOST_CHECK(isCalled);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoadedOwned_ThenBuffersAreValidUntilRelease)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    ownedMeshes.clear();
+
+    ::loadQuadKeyOwned(TEST_MAPCSS_DEFAULT, 35205, 21489, 16,
+        [](int handle, const char* name,
+           const double* vertices, int vertexCount,
+           const int* triangles, int triCount,
+           const int* colors, int colorCount,
+           const double* uvs, int uvCount) {
+            BOOST_CHECK_GT(vertexCount, 0);
+            ownedMeshes.push_back(std::make_pair(handle, vertices));
+        },
+        [](uint64_t id, const char** tags, int size, const double* vertices,
+           int vertexCount, const char** style, int styleSize) {},
+        [](const char* message) { BOOST_FAIL(message); });
+
+    BOOST_REQUIRE(!ownedMeshes.empty());
+    for (const auto& mesh : ownedMeshes) {
+        // longitude of the first vertex is still inside of quadkey.
+        BOOST_CHECK_CLOSE(mesh.second[0], 13.39, 0.5);
+        BOOST_CHECK(::releaseMesh(mesh.first));
+    }
+    BOOST_CHECK(!::releaseMesh(ownedMeshes[0].first));
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoadedWithElementBatch_ThenElementsAreReportedOnce)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    batchCount = 0;
+
+    ::loadQuadKeyElementBatch(TEST_MAPCSS_DEFAULT, 35205, 21489, 16,
+        [](const char* name,
+           const double* vertices, int vertexCount,
+           const int* triangles, int triCount,
+           const int* colors, int colorCount,
+           const double* uvs, int uvCount) {},
+        [](const std::uint64_t* ids, const int* records, int elementCount,
+           const int* tags, int tagSize, const double* coordinates, int coordinateSize,
+           const int* styles, int styleSize, const char** strings, int stringCount) {
+            ++batchCount;
+            BOOST_REQUIRE_GT(elementCount, 0);
+            const int* last = records + (elementCount - 1) * 6;
+            BOOST_CHECK_EQUAL(last[0] + last[1], tagSize);
+            BOOST_CHECK_EQUAL(last[2] + last[3], coordinateSize);
+            BOOST_CHECK_EQUAL(last[4] + last[5], styleSize);
+            for (int i = 0; i < tagSize; ++i)
+                BOOST_CHECK_LT(tags[i], stringCount);
+        },
+        [](const char* message) { BOOST_FAIL(message); });
+
+    BOOST_CHECK_EQUAL(batchCount, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoadedWithIds_ThenIdsCanBeResolvedBySyncedStrings)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    maxStringId = 0;
+    syncedStrings.clear();
+
+    ::loadQuadKeyWithIds(TEST_MAPCSS_DEFAULT, 35205, 21489, 16,
+        [](const char* name,
+           const double* vertices, int vertexCount,
+           const int* triangles, int triCount,
+           const int* colors, int colorCount,
+           const double* uvs, int uvCount) {},
+        [](std::uint64_t id, const std::uint32_t* tags, int tagSize,
+           const double* vertices, int vertexSize,
+           const std::uint32_t* styleKeys, const char** styleValues, int styleSize) {
+            for (int i = 0; i < tagSize; ++i)
+                maxStringId = std::max(maxStringId, tags[i]);
+            for (int i = 0; i < styleSize; ++i) {
+                maxStringId = std::max(maxStringId, styleKeys[i]);
+                BOOST_CHECK(styleValues[i] != nullptr);
+            }
+        },
+        [](const char* message) { BOOST_FAIL(message); });
+    int count = ::getStringCount();
+    ::getStrings(0, count / 2, [](const char** strings, int count) {
+        syncedStrings.insert(syncedStrings.end(), strings, strings + count);
+    });
+    ::getStrings(count / 2, count + 10, [](const char** strings, int count) {
+        syncedStrings.insert(syncedStrings.end(), strings, strings + count);
+    });
+
+    BOOST_REQUIRE_EQUAL(syncedStrings.size(), count);
+    BOOST_CHECK_LT(maxStringId, count);
+    BOOST_CHECK(!syncedStrings[maxStringId].empty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoadedProgressive_ThenPreviewIsReportedFirst)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    meshNames.clear();
+
+    ::loadQuadKeyProgressive(TEST_MAPCSS_DEFAULT, 35205, 21489, 16,
+        [](const char* name,
+           const double* vertices, int vertexCount,
+           const int* triangles, int triCount,
+           const int* colors, int colorCount,
+           const double* uvs, int uvCount) { meshNames.push_back(name); },
+        [](std::uint64_t id, const char** tags, int size, const double* vertices,
+           int vertexCount, const char** style, int styleSize) {},
+        [](const char* message) { BOOST_FAIL(message); });
+
+    BOOST_REQUIRE_GT(meshNames.size(), 1);
+    BOOST_CHECK_EQUAL(meshNames[0], "terrain_preview");
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeysAreLoadedInBatch_ThenEveryQuadKeyIsReportedAfterItsResults)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    const std::vector<int> quadKeys = { 35205, 21489, 16, 35206, 21489, 16, 35205, 21490, 16 };
+    loadedQuadKeys.clear();
+    meshCount = 0;
+
+    ::loadQuadKeys(TEST_MAPCSS_DEFAULT, quadKeys.data(), static_cast<int>(quadKeys.size()), 2,
+        [](const char* name,
+           const double* vertices, int vertexCount,
+           const int* triangles, int triCount,
+           const int* colors, int colorCount,
+           const double* uvs, int uvCount) { ++meshCount; },
+        [](std::uint64_t id, const char** tags, int size, const double* vertices,
+           int vertexCount, const char** style, int styleSize) {},
+        [](int tileX, int tileY, int levelOfDetail) {
+            // NOTE first quadkey has data, so its meshes are reported before it.
+            if (tileX == 35205 && tileY == 21489)
+                BOOST_CHECK_GT(meshCount, 0);
+            loadedQuadKeys.insert(loadedQuadKeys.end(), { tileX, tileY, levelOfDetail });
+        },
+        [](const char* message) { BOOST_FAIL(message); });
+
+    BOOST_CHECK_EQUAL(loadedQuadKeys.size(), quadKeys.size());
+}
+
+#ifdef UTYMAP_STATISTICS
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoaded_ThenStatisticsHaveBuildStages)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    ::resetStatistics();
+
+    ::loadQuadKey(TEST_MAPCSS_DEFAULT, 35205, 21489, 16,
+        [](const char* name,
+           const double* vertices, int vertexCount,
+           const int* triangles, int triCount,
+           const int* colors, int colorCount,
+           const double* uvs, int uvCount) {},
+        [](std::uint64_t id, const char** tags, int size, const double* vertices,
+           int vertexCount, const char** style, int styleSize) {},
+        [](const char* message) { BOOST_FAIL(message); });
+    ::getStatistics([](const char* json) { statistics = json; });
+
+    BOOST_CHECK(statistics.find("\"quadkey_build\":{\"calls\":1,") != std::string::npos);
+    BOOST_CHECK(statistics.find("\"terrain_builder\":{\"calls\":0,") == std::string::npos);
+    BOOST_CHECK(statistics.find("\"triangulation\":{\"calls\":0,") == std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTracing_WhenQuadKeyIsLoaded_ThenTraceHasBuildEvents)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    ::startTracing();
+
+    ::loadQuadKey(TEST_MAPCSS_DEFAULT, 35205, 21489, 16,
+        [](const char* name,
+           const double* vertices, int vertexCount,
+           const int* triangles, int triCount,
+           const int* colors, int colorCount,
+           const double* uvs, int uvCount) {},
+        [](std::uint64_t id, const char** tags, int size, const double* vertices,
+           int vertexCount, const char** style, int styleSize) {},
+        [](const char* message) { BOOST_FAIL(message); });
+    ::stopTracing(TraceFile, [](const char* message) { BOOST_FAIL(message); });
+
+    std::ifstream file(TraceFile);
+    std::string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    BOOST_CHECK(trace.find("\"name\":\"quadkey_build\"") != std::string::npos);
+    BOOST_CHECK(trace.find("\"name\":\"terrain_builder\"") != std::string::npos);
+    file.close();
+    std::remove(TraceFile);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(GivenRecording_WhenQuadKeyIsLoaded_ThenSessionHasInputs)
+{
+    ::startRecording(SessionFile, [](const char* message) { BOOST_FAIL(message); });
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    ::loadQuadKey(TEST_MAPCSS_DEFAULT, 35205, 21489, 16,
+        [](const char* name,
+           const double* vertices, int vertexCount,
+           const int* triangles, int triCount,
+           const int* colors, int colorCount,
+           const double* uvs, int uvCount) {},
+        [](std::uint64_t id, const char** tags, int size, const double* vertices,
+           int vertexCount, const char** style, int styleSize) {},
+        [](const char* message) { BOOST_FAIL(message); });
+    const std::vector<int> quadKeys = { 35205, 21489, 16, 35206, 21489, 16 };
+    ::loadQuadKeys(TEST_MAPCSS_DEFAULT, quadKeys.data(), static_cast<int>(quadKeys.size()), 2,
+        [](const char* name,
+           const double* vertices, int vertexCount,
+           const int* triangles, int triCount,
+           const int* colors, int colorCount,
+           const double* uvs, int uvCount) {},
+        [](std::uint64_t id, const char** tags, int size, const double* vertices,
+           int vertexCount, const char** style, int styleSize) {},
+        [](int tileX, int tileY, int levelOfDetail) {},
+        [](const char* message) { BOOST_FAIL(message); });
+    ::stopRecording();
+
+    auto commands = SessionRecorder::read(SessionFile);
+    BOOST_REQUIRE_EQUAL(commands.size(), 4);
+    // NOTE store is registered by fixture before recording is started.
+    BOOST_CHECK_EQUAL(commands[0].name, "store_in_memory");
+    BOOST_CHECK_EQUAL(commands[0].arguments[0], InMemoryStoreKey);
+    BOOST_CHECK_EQUAL(commands[1].name, "add_quadkey");
+    BOOST_CHECK_EQUAL(commands[1].arguments[0], InMemoryStoreKey);
+    BOOST_CHECK_EQUAL(commands[2].name, "load_quadkey");
+    BOOST_CHECK_EQUAL(commands[2].arguments[1], "16");
+    BOOST_CHECK_EQUAL(commands[3].name, "load_quadkeys");
+    BOOST_REQUIRE_EQUAL(commands[3].arguments.size(), 8);
+    BOOST_CHECK_EQUAL(commands[3].arguments[1], "2");
+    BOOST_CHECK_EQUAL(commands[3].arguments[6], "35206");
+    std::remove(SessionFile);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenGetMemoryReport_ThenStoreUsageIsReported)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+
+    ::getMemoryReport([](const char* json) { memoryReport = json; });
+
+    BOOST_CHECK(memoryReport.find("\"element_stores\":{\"InMemory\":") != std::string::npos);
+    BOOST_CHECK(memoryReport.find("\"InMemory\":0") == std::string::npos);
+    BOOST_CHECK(memoryReport.find("\"style_providers\":0") == std::string::npos);
+    BOOST_CHECK(memoryReport.find("\"mesh_registry\":0}") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPickingIsEnabled_WhenQuadKeyIsLoaded_ThenPickIndexIsKeptUntilRelease)
+{
+    ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
+    ::enablePicking(true);
+
+    ::loadQuadKey(TEST_MAPCSS_DEFAULT, 35205, 21489, 16,
+        [](const char*, const double*, int, const int*, int, const int*, int, const double*, int) {},
+        [](std::uint64_t, const char**, int, const double*, int, const char**, int) {},
+        [](const char* message) { BOOST_FAIL(message); });
+    ::getMemoryReport([](const char* json) { memoryReport = json; });
+
+    BOOST_CHECK(memoryReport.find("\"pick_indices\":0") == std::string::npos);
+    BOOST_CHECK(::releasePicking(35205, 21489, 16));
+    BOOST_CHECK(!::releasePicking(35205, 21489, 16));
+    std::uint64_t id;
+    BOOST_CHECK(!::pickPoint(35205, 21489, 16, 52.53, 13.38, &id));
+    ::enablePicking(false);
+}
+
 BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoaded_ThenHasDataReturnsTrue)
 {
     ::addToStoreInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback);
@@ -124,4 +597,100 @@ BOOST_AUTO_TEST_CASE(GivenElement_WhenAddInMemory_ThenItIsAdded)
     BOOST_CHECK(::hasData(1, 0, 1));
 }
 
+BOOST_AUTO_TEST_CASE(GivenLoadedQuadKeyWithRebuild_WhenAddElementAndRebuild_ThenOnlyAffectedMeshesAreReported)
+{
+    const std::vector<double> vertices = { 5, 5, 20, 5, 20, 10, 5, 10, 5, 5 };
+    const std::vector<const char*> tags = { "featurecla", "Lake", "scalerank", "0" };
+    static int removedCount;
+    removedCount = -1;
+    meshNames.clear();
+    ::enableRebuild(true);
+    ::addToStoreElement(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, 1, vertices.data(), 10,
+        const_cast<const char**>(tags.data()), 4, 1, 1, callback);
+    ::loadQuadKey(TEST_MAPCSS_DEFAULT, 1, 0, 1,
+        [](const char* name, const double*, int, const int*, int, const int*, int, const double*, int) {
+            meshNames.push_back(name);
+        }, nullptr, callback);
+    std::size_t loadedCount = meshNames.size();
+    meshNames.clear();
+
+    ::addToStoreElementAndRebuild(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, 2, vertices.data(), 10,
+        const_cast<const char**>(tags.data()), 4, 1, 1, 1, 0, 1,
+        [](const char* name, const double*, int, const int*, int, const int*, int, const double*, int) {
+            meshNames.push_back(name);
+        }, nullptr, [](const std::uint64_t*, int count) { removedCount = count; }, callback);
+
+    BOOST_CHECK_GT(loadedCount, 0);
+    BOOST_CHECK_GT(meshNames.size(), 0);
+    BOOST_CHECK_LE(meshNames.size(), loadedCount);
+    BOOST_CHECK_EQUAL(removedCount, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenElements_WhenAddInMemoryAtOnce_ThenTheyAreAdded)
+{
+    const std::vector<std::uint64_t> ids = { 1, 2 };
+    const std::vector<double> vertices = { 5, 5, 20, 5, 20, 10, 5, 10, 5, 5, -5, -5, -5, -10, -20, -10, -20, -5, -5, -5 };
+    const std::vector<int> vertexOffsets = { 0, 10, 20 };
+    const std::vector<const char*> tags = { "featurecla", "Lake", "scalerank", "0", "featurecla", "Lake", "scalerank", "0" };
+    const std::vector<int> tagOffsets = { 0, 4, 8 };
+
+    ::addToStoreElements(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, ids.data(), 2, vertices.data(), vertexOffsets.data(),
+        const_cast<const char**>(tags.data()), tagOffsets.data(), 1, 1, callback);
+
+    BOOST_CHECK(::hasData(1, 0, 1));
+    BOOST_CHECK(::hasData(0, 1, 1));
+}
+
+BOOST_AUTO_TEST_CASE(GivenNamedElements_WhenSearchByName_ThenClosestAreReportedFirst)
+{
+    const std::vector<std::uint64_t> ids = { 1, 2 };
+    const std::vector<double> vertices = { 5, 5, 20, 5, 20, 10, 5, 10, 5, 5, -5, -5, -5, -10, -20, -10, -20, -5, -5, -5 };
+    const std::vector<int> vertexOffsets = { 0, 10, 20 };
+    const std::vector<const char*> tags = { "featurecla", "Lake", "scalerank", "0", "name", "North Lake",
+                                            "featurecla", "Lake", "scalerank", "0", "name:en", "North-lake Bay" };
+    const std::vector<int> tagOffsets = { 0, 6, 12 };
+    static std::vector<std::uint64_t> foundIds;
+    static std::vector<std::string> foundNames;
+    foundIds.clear();
+    foundNames.clear();
+    ::addToStoreElements(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, ids.data(), 2, vertices.data(), vertexOffsets.data(),
+        const_cast<const char**>(tags.data()), tagOffsets.data(), 1, 1, callback);
+
+    ::searchByName("north la", -10, -10, 5,
+        [](const std::uint64_t* ids, const char** names, const double*, const double* distances, int count) {
+            for (int i = 0; i < count; ++i) {
+                foundIds.push_back(ids[i]);
+                foundNames.push_back(names[i]);
+            }
+            BOOST_CHECK(count < 2 || distances[0] <= distances[1]);
+        }, callback);
+
+    std::vector<std::uint64_t> expected = { 2, 1 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(foundIds.begin(), foundIds.end(), expected.begin(), expected.end());
+    BOOST_REQUIRE_EQUAL(foundNames.size(), 2);
+    BOOST_CHECK_EQUAL(foundNames[0], "North-lake Bay");
+}
+
+BOOST_AUTO_TEST_CASE(GivenElement_WhenGetElementById_ThenItIsReportedWithTags)
+{
+    const std::vector<double> vertices = { 5, 5, 20, 5, 20, 10, 5, 10, 5, 5 };
+    const std::vector<const char*> tags = { "featurecla", "Lake", "scalerank", "0" };
+    static int tagCount;
+    tagCount = 0;
+    ::addToStoreElement(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, 42, vertices.data(), 10,
+        const_cast<const char**>(tags.data()), 4, 1, 1, callback);
+
+    bool isFound = ::getElement(TEST_MAPCSS_DEFAULT, 42, 1,
+        [](uint64_t id, const char**, int size, const double*, int, const char**, int) {
+            BOOST_CHECK_EQUAL(id, 42);
+            tagCount = size;
+        }, callback);
+
+    BOOST_CHECK(isFound);
+    BOOST_CHECK_EQUAL(tagCount, 4);
+    BOOST_CHECK(!::getElement(TEST_MAPCSS_DEFAULT, 43, 1,
+        [](uint64_t, const char**, int, const double*, int, const char**, int) { BOOST_FAIL("Unexpected element."); },
+        callback));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
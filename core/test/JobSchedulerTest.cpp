@@ -0,0 +1,76 @@
+#include "JobScheduler.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace {
+    /// Blocks single worker until released, so jobs can be queued behind it.
+    struct Gate
+    {
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return isOpen; });
+        }
+
+        void open()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                isOpen = true;
+            }
+            condition.notify_all();
+        }
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool isOpen = false;
+    };
+}
+
+BOOST_AUTO_TEST_SUITE(Shared_JobScheduler)
+
+BOOST_AUTO_TEST_CASE(GivenQueuedJobs_WhenWorkerIsFree_ThenJobWithLowestPriorityRunsFirst)
+{
+    Gate gate, done;
+    std::vector<int> order;
+    JobScheduler scheduler(1);
+    scheduler.submit([]() { return 0.; }, [&]() { gate.wait(); }, [](int, bool) {});
+    for (int i = 0; i < 3; ++i) {
+        double priority = i == 1 ? 0 : 10 - i;
+        scheduler.submit([priority]() { return priority; }, [&, i]() { order.push_back(i); }, [](int, bool) {});
+    }
+    scheduler.submit([]() { return 100.; }, [&]() { done.open(); }, [](int, bool) {});
+    gate.open();
+    done.wait();
+
+    BOOST_REQUIRE_EQUAL(order.size(), 3);
+    BOOST_CHECK_EQUAL(order[0], 1);
+    BOOST_CHECK_EQUAL(order[1], 2);
+    BOOST_CHECK_EQUAL(order[2], 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenQueuedJob_WhenCancel_ThenItIsNotRunAndCompletedAsCancelled)
+{
+    Gate gate;
+    std::atomic<bool> isRun(false);
+    std::atomic<int> cancelledId(0);
+    JobScheduler scheduler(1);
+    int first = scheduler.submit([]() { return 0.; }, [&]() { gate.wait(); }, [](int, bool) {});
+    int second = scheduler.submit([]() { return 0.; }, [&]() { isRun = true; },
+        [&](int id, bool isCancelled) { if (isCancelled) cancelledId = id; });
+
+    BOOST_CHECK(scheduler.cancel(second));
+    BOOST_CHECK(!scheduler.cancel(second));
+    gate.open();
+
+    BOOST_CHECK_NE(first, second);
+    BOOST_CHECK_EQUAL(cancelledId, second);
+    BOOST_CHECK(!isRun);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
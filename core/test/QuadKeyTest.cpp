@@ -0,0 +1,60 @@
+#include "QuadKey.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::utils;
+
+BOOST_AUTO_TEST_SUITE(QuadKey_Suite)
+
+BOOST_AUTO_TEST_CASE(GivenQuadKey_WhenPackAndUnpack_ThenItIsTheSame)
+{
+    QuadKey quadKey(19, 281640, 171914);
+
+    QuadKey result = PackedQuadKey(quadKey).unpack();
+
+    BOOST_CHECK(result == quadKey);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPackedQuadKey_WhenGetParentAndChild_ThenTheyMatchTiles)
+{
+    PackedQuadKey quadKey(QuadKey(19, 281640, 171914));
+
+    BOOST_CHECK(quadKey.parent().unpack() == QuadKey(18, 140820, 85957));
+    BOOST_CHECK(quadKey.parent().child(0) == quadKey);
+    BOOST_CHECK(quadKey.child(3).unpack() == QuadKey(20, 563281, 343829));
+}
+
+BOOST_AUTO_TEST_CASE(GivenPackedQuadKey_WhenGetDigits_ThenTheyMatchQuadKeyString)
+{
+    QuadKey quadKey(19, 281640, 171914);
+    PackedQuadKey packed(quadKey);
+    std::string code;
+
+    for (int i = 1; i <= quadKey.levelOfDetail; ++i)
+        code += static_cast<char>('0' + packed.digit(i));
+
+    BOOST_CHECK_EQUAL(code, "1202102332220103020");
+    BOOST_CHECK_EQUAL(GeoUtils::quadKeyToString(quadKey), code);
+}
+
+BOOST_AUTO_TEST_CASE(GivenQuadKeysOfTwoLevels_WhenSort_ThenTheyAreOrderedByLevelAndZCurve)
+{
+    std::vector<PackedQuadKey> keys = {
+        PackedQuadKey(QuadKey(2, 1, 1)), PackedQuadKey(QuadKey(1, 1, 0)),
+        PackedQuadKey(QuadKey(2, 2, 0)), PackedQuadKey(QuadKey(2, 0, 1)) };
+
+    std::sort(keys.begin(), keys.end());
+
+    BOOST_CHECK(keys[0].unpack() == QuadKey(1, 1, 0));
+    BOOST_CHECK(keys[1].unpack() == QuadKey(2, 0, 1));
+    BOOST_CHECK(keys[2].unpack() == QuadKey(2, 1, 1));
+    BOOST_CHECK(keys[3].unpack() == QuadKey(2, 2, 0));
+    BOOST_CHECK(QuadKeyHash()(QuadKey(2, 1, 1)) == QuadKeyHash()(keys[2]));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
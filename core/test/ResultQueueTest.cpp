@@ -0,0 +1,70 @@
+#include "ResultQueue.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(Shared_ResultQueue)
+
+BOOST_AUTO_TEST_CASE(GivenMesh_WhenPushAndPoll_ThenItsBuffersAreReturned)
+{
+    ResultQueue queue;
+    utymap::meshing::Mesh mesh("mesh");
+    mesh.vertices = { 1, 2, 3 };
+    mesh.triangles = { 0, 0, 0 };
+    mesh.colors = { 7 };
+    PolledResult results[2];
+
+    queue.pushMesh(5, mesh);
+    queue.pushCompleted(5, false);
+    int count = queue.poll(results, 2);
+
+    BOOST_REQUIRE_EQUAL(count, 2);
+    BOOST_CHECK(mesh.vertices.empty());
+    BOOST_CHECK_EQUAL(results[0].kind, MeshResult);
+    BOOST_CHECK_EQUAL(results[0].jobId, 5);
+    BOOST_CHECK_EQUAL(std::string(results[0].name), "mesh");
+    BOOST_CHECK_EQUAL(results[0].vertexSize, 3);
+    BOOST_CHECK_EQUAL(results[0].vertices[2], 3);
+    BOOST_CHECK_EQUAL(results[0].triSize, 3);
+    BOOST_CHECK_EQUAL(results[0].colorSize, 1);
+    BOOST_CHECK_EQUAL(results[1].kind, JobCompletedResult);
+    BOOST_CHECK(!results[1].isCancelled);
+    BOOST_CHECK_EQUAL(queue.poll(results, 2), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSeveralProducers_WhenPollInBatches_ThenAllResultsAreReturnedInOrderOfThread)
+{
+    const int threadCount = 4, resultCount = 1000;
+    ResultQueue queue;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back([&queue, i]() {
+            for (int j = 0; j < resultCount; ++j)
+                queue.pushCompleted(i * resultCount + j, false);
+        });
+    }
+
+    std::vector<int> last(threadCount, -1);
+    int total = 0;
+    PolledResult results[64];
+    while (total < threadCount * resultCount) {
+        int count = queue.poll(results, 64);
+        for (int i = 0; i < count; ++i) {
+            int thread = results[i].jobId / resultCount;
+            BOOST_CHECK_LT(last[thread], results[i].jobId);
+            last[thread] = results[i].jobId;
+        }
+        total += count;
+        if (count == 0)
+            std::this_thread::yield();
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    BOOST_CHECK_EQUAL(total, threadCount * resultCount);
+    BOOST_CHECK_EQUAL(queue.poll(results, 64), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,65 @@
+#include "SessionRecorder.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+
+namespace {
+    const char* SessionFile = "session.txt";
+}
+
+BOOST_AUTO_TEST_SUITE(Shared_SessionRecorder)
+
+BOOST_AUTO_TEST_CASE(GivenRecordedCommands_WhenRead_ThenTheyAreReturnedInOrder)
+{
+    SessionRecorder recorder;
+    recorder.start(SessionFile);
+    recorder.record("store_in_memory", { "key" });
+    recorder.record("load_quadkey", { "style with spaces.mapcss", "16", "35205", "21489" });
+    recorder.stop();
+    recorder.record("ignored", {});
+
+    auto commands = SessionRecorder::read(SessionFile);
+
+    BOOST_REQUIRE_EQUAL(commands.size(), 2);
+    BOOST_CHECK_EQUAL(commands[0].name, "store_in_memory");
+    BOOST_CHECK_EQUAL(commands[1].name, "load_quadkey");
+    BOOST_REQUIRE_EQUAL(commands[1].arguments.size(), 4);
+    BOOST_CHECK_EQUAL(commands[1].arguments[0], "style with spaces.mapcss");
+    BOOST_CHECK_EQUAL(commands[1].arguments[3], "21489");
+    BOOST_CHECK_LE(commands[0].time, commands[1].time);
+    std::remove(SessionFile);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSetupCommandsBeforeStart_WhenStart_ThenSessionBeginsWithThem)
+{
+    SessionRecorder recorder;
+    recorder.recordSetup("store_in_memory", { "key" });
+    recorder.record("ignored", {});
+    recorder.start(SessionFile);
+    recorder.recordSetup("store_persistent", { "other", "path" });
+    recorder.record("load_quadkey", { "style.mapcss", "16", "35205", "21489" });
+    recorder.stop();
+
+    auto commands = SessionRecorder::read(SessionFile);
+
+    BOOST_REQUIRE_EQUAL(commands.size(), 3);
+    BOOST_CHECK_EQUAL(commands[0].name, "store_in_memory");
+    BOOST_CHECK_EQUAL(commands[0].arguments[0], "key");
+    BOOST_CHECK_EQUAL(commands[1].name, "store_persistent");
+    BOOST_CHECK_EQUAL(commands[2].name, "load_quadkey");
+    std::remove(SessionFile);
+}
+
+BOOST_AUTO_TEST_CASE(GivenFileWithoutHeader_WhenRead_ThenThrows)
+{
+    {
+        std::ofstream file(SessionFile);
+        file << "0\tload_quadkey\n";
+    }
+
+    BOOST_CHECK_THROW(SessionRecorder::read(SessionFile), std::domain_error);
+    std::remove(SessionFile);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
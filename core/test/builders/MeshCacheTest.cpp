@@ -0,0 +1,128 @@
+#include "builders/MeshCache.hpp"
+#include "entities/Node.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include "test_utils/DependencyProvider.hpp"
+#include "test_utils/ElementUtils.hpp"
+
+#include <boost/filesystem/operations.hpp>
+
+using namespace utymap;
+using namespace utymap::builders;
+using namespace utymap::entities;
+using namespace utymap::meshing;
+
+namespace {
+    const std::string CacheDirectory = "mesh_cache";
+    const std::string Key = "16_35205_21489_1";
+
+    struct Builders_MeshCacheFixture
+    {
+        Builders_MeshCacheFixture() : buildCount(0), meshCount(0), elementIds()
+        {
+            boost::filesystem::create_directory(CacheDirectory);
+        }
+
+        ~Builders_MeshCacheFixture()
+        {
+            boost::filesystem::remove_all(CacheDirectory);
+        }
+
+        /// Builds tile with one mesh and one node counting calls of build function.
+        void build(MeshCache& cache, const std::string& key, bool isPersistentKey = true)
+        {
+            cache.build(key, [&](const Mesh& mesh) {
+                BOOST_CHECK_EQUAL(mesh.name, "terrain");
+                BOOST_CHECK_EQUAL(mesh.vertices.size(), 3);
+                BOOST_CHECK_EQUAL(mesh.triangles.size(), 3);
+                ++meshCount;
+            }, [&](const Element& element) {
+                elementIds.push_back(element.id);
+            }, [&](const QuadKeyBuilder::MeshCallback& meshFunc, const QuadKeyBuilder::ElementCallback& elementFunc) {
+                ++buildCount;
+                Mesh mesh("terrain");
+                mesh.vertices = { 13.4, 52.5, 0 };
+                mesh.triangles = { 0, 0, 0 };
+                meshFunc(mesh);
+                auto node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 7, { { "amenity", "bench" } });
+                elementFunc(node);
+            }, isPersistentKey);
+        }
+
+        DependencyProvider dependencyProvider;
+        int buildCount;
+        int meshCount;
+        std::vector<std::uint64_t> elementIds;
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(Builders_MeshCache, Builders_MeshCacheFixture)
+
+BOOST_AUTO_TEST_CASE(GivenBuiltTile_WhenBuildAgain_ThenResultsAreReplayed)
+{
+    MeshCache cache(*dependencyProvider.getStringTable(), "", 4);
+
+    build(cache, Key);
+    build(cache, Key);
+
+    BOOST_CHECK_EQUAL(buildCount, 1);
+    BOOST_CHECK_EQUAL(meshCount, 2);
+    BOOST_REQUIRE_EQUAL(elementIds.size(), 2);
+    BOOST_CHECK_EQUAL(elementIds[1], 7);
+}
+
+BOOST_AUTO_TEST_CASE(GivenFullCache_WhenBuildNewTile_ThenLeastRecentlyUsedIsEvicted)
+{
+    MeshCache cache(*dependencyProvider.getStringTable(), "", 1);
+
+    build(cache, Key);
+    build(cache, "other");
+    build(cache, Key);
+
+    BOOST_CHECK_EQUAL(buildCount, 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenBuiltTile_WhenClear_ThenMemoryIsReleased)
+{
+    MeshCache cache(*dependencyProvider.getStringTable(), "", 4);
+    build(cache, Key);
+    std::size_t usage = cache.getMemoryUsage();
+
+    cache.clear();
+
+    BOOST_CHECK_GT(usage, 0);
+    BOOST_CHECK_EQUAL(cache.getMemoryUsage(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTileCachedOnDisk_WhenBuildWithNewCache_ThenResultsAreReadFromDisk)
+{
+    {
+        MeshCache cache(*dependencyProvider.getStringTable(), CacheDirectory, 4);
+        build(cache, Key);
+    }
+    MeshCache cache(*dependencyProvider.getStringTable(), CacheDirectory, 4);
+
+    build(cache, Key);
+
+    BOOST_CHECK_EQUAL(buildCount, 1);
+    BOOST_CHECK_EQUAL(meshCount, 2);
+    BOOST_REQUIRE_EQUAL(elementIds.size(), 2);
+    BOOST_CHECK_EQUAL(elementIds[1], 7);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNotPersistentKey_WhenBuildWithNewCache_ThenTileIsBuiltAgain)
+{
+    {
+        MeshCache cache(*dependencyProvider.getStringTable(), CacheDirectory, 4);
+        build(cache, Key, false);
+        build(cache, Key, false);
+    }
+    MeshCache cache(*dependencyProvider.getStringTable(), CacheDirectory, 4);
+
+    build(cache, Key, false);
+
+    BOOST_CHECK_EQUAL(buildCount, 2);
+    BOOST_CHECK(boost::filesystem::is_empty(CacheDirectory));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,211 @@
+#include "builders/QuadKeyBuilder.hpp"
+#include "entities/Node.hpp"
+#include "index/GeoStore.hpp"
+#include "index/InMemoryElementStore.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include "test_utils/DependencyProvider.hpp"
+#include "test_utils/ElementUtils.hpp"
+
+using namespace utymap;
+using namespace utymap::builders;
+using namespace utymap::entities;
+using namespace utymap::index;
+using namespace utymap::meshing;
+
+namespace {
+    const std::string StoreKey = "test";
+    const std::string stylesheet =
+        "node|z1[any] { builders: counter; clip: false; }"
+        "node|z1[single] { builders: counter,single; clip: false; }";
+
+    /// Reports single mesh with amount of visited elements as its name on completion.
+    class CounterBuilder final : public ElementBuilder
+    {
+    public:
+        explicit CounterBuilder(const BuilderContext& context) : ElementBuilder(context), count_(0) { }
+
+        void visitNode(const Node&) override { ++count_; }
+        void visitWay(const Way&) override { }
+        void visitArea(const Area&) override { }
+        void visitRelation(const Relation&) override { }
+
+        void complete() override { context_.meshCallback(Mesh(std::to_string(count_))); }
+
+    private:
+        int count_;
+    };
+
+    /// Reports separate mesh per visited element.
+    class SingleBuilder final : public ElementBuilder
+    {
+    public:
+        explicit SingleBuilder(const BuilderContext& context) : ElementBuilder(context) { }
+
+        void visitNode(const Node& node) override { context_.meshCallback(Mesh("single:" + std::to_string(node.id))); }
+        void visitWay(const Way&) override { }
+        void visitArea(const Area&) override { }
+        void visitRelation(const Relation&) override { }
+
+        void complete() override { }
+
+        bool hasElementMeshes() const override { return true; }
+    };
+
+    struct Builders_QuadKeyBuilderFixture
+    {
+        Builders_QuadKeyBuilderFixture() :
+            dependencyProvider(),
+            geoStore(*dependencyProvider.getStringTable()),
+            builder(geoStore, *dependencyProvider.getStringTable())
+        {
+            geoStore.registerStore(StoreKey, utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+            builder.registerElementBuilder("counter", [](const BuilderContext& context) {
+                return utymap::utils::make_unique<CounterBuilder>(context);
+            });
+            builder.registerElementBuilder("single", [](const BuilderContext& context) {
+                return utymap::utils::make_unique<SingleBuilder>(context);
+            });
+            builder.enableDependencyTracking(true);
+
+            auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+            for (std::uint64_t id = 1; id <= 10; ++id) {
+                Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), id, { { "any", "true" } });
+                node.coordinate = { 5, -5 };
+                geoStore.add(StoreKey, node, LodRange(1, 1), *styleProvider);
+            }
+        }
+
+        /// Builds tile and returns names of reported meshes.
+        std::vector<std::string> build()
+        {
+            std::vector<std::string> meshes;
+            builder.build(QuadKey(1, 0, 0), *dependencyProvider.getStyleProvider(stylesheet),
+                *dependencyProvider.getElevationProvider(),
+                [&](const Mesh& mesh) { meshes.push_back(mesh.name); },
+                [](const Element&) {});
+            return meshes;
+        }
+
+        /// Rebuilds given elements and returns names of reported meshes.
+        std::vector<std::string> rebuild(const std::vector<std::uint64_t>& ids, std::vector<std::uint64_t>& removed)
+        {
+            std::vector<std::string> meshes;
+            removed = builder.rebuild(QuadKey(1, 0, 0), ids, *dependencyProvider.getStyleProvider(stylesheet),
+                *dependencyProvider.getElevationProvider(),
+                [&](const Mesh& mesh) { meshes.push_back(mesh.name); },
+                [](const Element&) {});
+            return meshes;
+        }
+
+        /// Replaces node with given id in store.
+        void update(std::uint64_t id, const std::string& key)
+        {
+            Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), id, { { key.c_str(), "true" } });
+            node.coordinate = { 5, -5 };
+            geoStore.update(StoreKey, node, LodRange(1, 1), *dependencyProvider.getStyleProvider(stylesheet));
+        }
+
+        DependencyProvider dependencyProvider;
+        GeoStore geoStore;
+        QuadKeyBuilder builder;
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(Builders_QuadKeyBuilder, Builders_QuadKeyBuilderFixture)
+
+BOOST_AUTO_TEST_CASE(GivenZeroBudget_WhenStepJob_ThenItIsCompletedInSeveralCallsWithBuildResult)
+{
+    std::vector<std::string> meshes;
+    int elements = 0;
+    auto job = builder.createJob(QuadKey(1, 0, 0), *dependencyProvider.getStyleProvider(stylesheet),
+        *dependencyProvider.getElevationProvider(),
+        [&](const Mesh& mesh) { meshes.push_back(mesh.name); },
+        [&](const Element&) { ++elements; });
+
+    int calls = 1;
+    while (!job->step(0))
+        ++calls;
+
+    BOOST_CHECK(job->isCompleted());
+    // NOTE search and every element are separate steps.
+    BOOST_CHECK_GT(calls, 11);
+    BOOST_REQUIRE_EQUAL(meshes.size(), 1);
+    BOOST_CHECK_EQUAL(meshes[0], "10");
+}
+
+BOOST_AUTO_TEST_CASE(GivenLargeBudget_WhenStepJob_ThenItIsCompletedAtOnce)
+{
+    std::vector<std::string> meshes;
+    auto job = builder.createJob(QuadKey(1, 0, 0), *dependencyProvider.getStyleProvider(stylesheet),
+        *dependencyProvider.getElevationProvider(),
+        [&](const Mesh& mesh) { meshes.push_back(mesh.name); },
+        [&](const Element&) {});
+
+    BOOST_CHECK(job->step(1E6));
+    BOOST_REQUIRE_EQUAL(meshes.size(), 1);
+    BOOST_CHECK_EQUAL(meshes[0], "10");
+}
+
+BOOST_AUTO_TEST_CASE(GivenBuiltTile_WhenRebuildChangedElement_ThenOnlyItsBuildersAreRun)
+{
+    update(3, "single");
+    update(4, "single");
+    BOOST_CHECK_EQUAL(build().size(), 3);
+    update(3, "single");
+    std::vector<std::uint64_t> removed;
+
+    std::vector<std::string> meshes = rebuild({ 3 }, removed);
+
+    // NOTE counter merges all elements, so it is run with all of them.
+    std::sort(meshes.begin(), meshes.end());
+    BOOST_REQUIRE_EQUAL(meshes.size(), 2);
+    BOOST_CHECK_EQUAL(meshes[0], "10");
+    BOOST_CHECK_EQUAL(meshes[1], "single:3");
+    BOOST_CHECK(removed.empty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenBuiltTile_WhenRebuildElementWhichLostMesh_ThenItIsReportedAsRemoved)
+{
+    update(3, "single");
+    build();
+    update(3, "any");
+    std::vector<std::uint64_t> removed;
+
+    std::vector<std::string> meshes = rebuild({ 3 }, removed);
+
+    BOOST_REQUIRE_EQUAL(meshes.size(), 1);
+    BOOST_CHECK_EQUAL(meshes[0], "10");
+    BOOST_REQUIRE_EQUAL(removed.size(), 1);
+    BOOST_CHECK_EQUAL(removed[0], 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNotBuiltTile_WhenRebuild_ThenWholeTileIsBuilt)
+{
+    update(3, "single");
+    std::vector<std::uint64_t> removed;
+
+    std::vector<std::string> meshes = rebuild({ 3 }, removed);
+
+    BOOST_CHECK_EQUAL(meshes.size(), 2);
+    BOOST_CHECK(removed.empty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenBuiltTileWithoutDependencyTracking_WhenRebuild_ThenWholeTileIsBuilt)
+{
+    builder.enableDependencyTracking(false);
+    update(3, "single");
+    update(4, "single");
+    build();
+    update(3, "single");
+    std::vector<std::uint64_t> removed;
+
+    std::vector<std::string> meshes = rebuild({ 3 }, removed);
+
+    BOOST_CHECK_EQUAL(meshes.size(), 3);
+    BOOST_CHECK(removed.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
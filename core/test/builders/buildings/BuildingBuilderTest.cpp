@@ -3,6 +3,7 @@
 #include "builders/buildings/BuildingBuilder.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
+#include "mapcss/MapCssParser.hpp"
 
 #include <boost/test/unit_test.hpp>
 
@@ -31,7 +32,39 @@ namespace {
                                     "};";
     struct Builders_Buildings_BuildingsBuilderFixture
     {
+        /// Builds a few buildings and returns names and geometry of reported meshes.
+        std::vector<std::pair<std::string, std::vector<double>>> buildMany(const std::string& stylesheet)
+        {
+            std::vector<std::pair<std::string, std::vector<double>>> meshes;
+            auto context = createContext(stylesheet,
+                [&](const Mesh& mesh) {
+                    std::vector<double> geometry(mesh.vertices.begin(), mesh.vertices.end());
+                    geometry.insert(geometry.end(), mesh.triangles.begin(), mesh.triangles.end());
+                    geometry.insert(geometry.end(), mesh.colors.begin(), mesh.colors.end());
+                    meshes.push_back(std::make_pair(mesh.name, geometry));
+            });
+            BuildingBuilder builder(*context);
+            for (std::uint64_t id = 1; id <= 5; ++id) {
+                double offset = static_cast<double>(id) * 20;
+                builder.visitArea(ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), id, { { "building", "yes" } },
+                    { { offset + 10, 0 }, { offset + 10, 10 }, { offset, 10 }, { offset, 0 } }));
+            }
+            builder.complete();
+            return meshes;
+        }
+
+        /// Creates context with own style provider: dependency provider keeps the first one only.
+        std::shared_ptr<BuilderContext> createContext(const std::string& stylesheet,
+                                                      std::function<void(const Mesh&)> meshCallback)
+        {
+            styleProviders.push_back(std::make_shared<utymap::mapcss::StyleProvider>(
+                utymap::mapcss::MapCssParser().parse(stylesheet), *dependencyProvider.getStringTable()));
+            return std::make_shared<BuilderContext>(QuadKey(1, 1, 0), *styleProviders.back(),
+                *dependencyProvider.getStringTable(), *dependencyProvider.getElevationProvider(), meshCallback, nullptr);
+        }
+
         DependencyProvider dependencyProvider;
+        std::vector<std::shared_ptr<utymap::mapcss::StyleProvider>> styleProviders;
     };
 }
 
@@ -90,4 +123,146 @@ BOOST_AUTO_TEST_CASE(GivenRelationWithHole_WhenVisitRelation_ThenMeshIsBuilt)
     BOOST_CHECK(isCalled);
 }
 
+BOOST_AUTO_TEST_CASE(GivenBatchedBuildings_WhenComplete_ThenBatchMeshesHaveElementRanges)
+{
+    std::string batchStylesheet = stylesheet;
+    batchStylesheet.insert(batchStylesheet.find('{') + 1, "mesh-batch: city; mesh-batch-size: 60;");
+    std::vector<std::size_t> vertexCounts;
+    std::vector<std::uint64_t> ids;
+    auto context = dependencyProvider.createBuilderContext(
+        QuadKey(1, 1, 0),
+        batchStylesheet,
+        [&](const Mesh& mesh) {
+            vertexCounts.push_back(mesh.vertices.size() / 3);
+            std::size_t triangles = 0;
+            for (std::size_t i = 0; i < mesh.elementRanges.size(); i += 3) {
+                ids.push_back(mesh.elementRanges[i]);
+                BOOST_CHECK_EQUAL(mesh.elementRanges[i + 1], triangles);
+                triangles += mesh.elementRanges[i + 2];
+            }
+            BOOST_CHECK_EQUAL(triangles, mesh.triangles.size() / 3);
+    });
+    BuildingBuilder builder(*context);
+
+    for (std::uint64_t id = 1; id <= 3; ++id)
+        builder.visitArea(ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), id, { { "building", "yes" } },
+            { { 10, 0 }, { 10, 10 }, { 0, 10 }, { 0, 0 } }));
+    BOOST_CHECK_EQUAL(vertexCounts.size(), 1);
+
+    builder.complete();
+
+    BOOST_REQUIRE_EQUAL(vertexCounts.size(), 2);
+    BOOST_CHECK(vertexCounts[0] <= 60);
+    BOOST_CHECK_GT(vertexCounts[0], vertexCounts[1]);
+    BOOST_CHECK(ids == std::vector<std::uint64_t>({ 1, 2, 3 }));
+}
+
+BOOST_AUTO_TEST_CASE(GivenUnknownRoofType_WhenVisitArea_ThenThrows)
+{
+    std::string unknownStylesheet = stylesheet;
+    unknownStylesheet.replace(unknownStylesheet.find("roof-type: flat"), 15, "roof-type: gothic");
+    auto context = dependencyProvider.createBuilderContext(QuadKey(1, 1, 0), unknownStylesheet, [](const Mesh&) {});
+    BuildingBuilder builder(*context);
+
+    BOOST_CHECK_THROW(builder.visitArea(ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 0,
+        { { "building", "yes" } }, { { 10, 0 }, { 10, 10 }, { 0, 10 }, { 0, 0 } })), MapCssException);
+}
+
+BOOST_AUTO_TEST_CASE(GivenBuildingTasks_WhenComplete_ThenMeshesAreSameAsSequential)
+{
+    auto sequential = buildMany(stylesheet);
+
+    auto parallel = buildMany("canvas|z1 { building-tasks: 3; }" + stylesheet);
+
+    BOOST_CHECK_EQUAL(sequential.size(), 5);
+    BOOST_CHECK(sequential == parallel);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRelationWithAdjacentParts_WhenVisitRelation_ThenSharedWallIsNotBuilt)
+{
+    std::size_t vertexCount = 0;
+    auto context = dependencyProvider.createBuilderContext(QuadKey(1, 1, 0), stylesheet,
+        [&](const Mesh& mesh) { vertexCount += mesh.vertices.size() / 3; });
+    auto& stringTable = *dependencyProvider.getStringTable();
+    auto left = std::make_shared<Area>(ElementUtils::createElement<Area>(stringTable, 1, { { "building", "yes" } },
+        { { 10, 0 }, { 10, 10 }, { 0, 10 }, { 0, 0 } }));
+    auto right = std::make_shared<Area>(ElementUtils::createElement<Area>(stringTable, 2, { { "building", "yes" } },
+        { { 10, 0 }, { 20, 0 }, { 20, 10 }, { 10, 10 } }));
+    BuildingBuilder builder(*context);
+    builder.visitArea(*left);
+    builder.visitArea(*right);
+    std::size_t separateCount = vertexCount;
+    vertexCount = 0;
+    Relation relation;
+    relation.tags = { ElementUtils::createTag(stringTable, "building", "yes") };
+    relation.elements.push_back(left);
+    relation.elements.push_back(right);
+
+    builder.visitRelation(relation);
+
+    // each part loses one wall which has two triangles.
+    BOOST_CHECK_EQUAL(vertexCount, separateCount - 2 * 6);
+}
+
+BOOST_AUTO_TEST_CASE(GivenLowLevelOfDetailSettings_WhenVisitArea_ThenFootprintAndRoofAreSimplified)
+{
+    auto countVertices = [&](const std::string& stylesheet) {
+        std::size_t count = 0;
+        auto context = createContext(stylesheet, [&](const Mesh& mesh) { count += mesh.vertices.size() / 3; });
+        BuildingBuilder builder(*context);
+        builder.visitArea(ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 0, { { "building", "yes" } },
+            { { 10, 0 }, { 10, 5 }, { 10.1, 7 }, { 10, 10 }, { 0, 10 }, { 0, 0 } }));
+        return count;
+    };
+    std::string pyramidal = stylesheet;
+    pyramidal.replace(pyramidal.find("roof-type: flat"), 15, "roof-type: pyramidal");
+    std::string simplified = "area|z1[building=yes] { footprint-tolerance: 1; flat-roof-lod: 2; }" + pyramidal;
+
+    // pyramidal roof is not flat and almost collinear point is removed from footprint.
+    BOOST_CHECK_NE(countVertices(pyramidal), countVertices(stylesheet));
+    BOOST_CHECK_LT(countVertices(simplified), countVertices(stylesheet));
+}
+
+BOOST_AUTO_TEST_CASE(GivenBlockArea_WhenComplete_ThenTinyBuildingsAreMergedIntoBlocks)
+{
+    std::vector<std::string> names;
+    std::vector<std::uint64_t> ranges;
+    auto context = createContext("area|z1[building=yes] { block-area: 300; }" + stylesheet,
+        [&](const Mesh& mesh) {
+            names.push_back(mesh.name);
+            ranges = mesh.elementRanges;
+        });
+    BuildingBuilder builder(*context);
+    builder.visitArea(ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 1, { { "building", "yes" } },
+        { { 10, 0 }, { 10, 5 }, { 8, 7 }, { 10, 10 }, { 0, 10 }, { 0, 0 } }));
+    builder.visitArea(ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 2, { { "building", "yes" } },
+        { { 20, 0 }, { 20, 10 }, { 15, 10 }, { 15, 0 } }));
+
+    builder.complete();
+
+    BOOST_REQUIRE_EQUAL(names.size(), 1);
+    BOOST_CHECK_EQUAL(names[0], "buildings:blocks:0");
+    BOOST_CHECK(ranges == std::vector<std::uint64_t>({ 1, 0, 10, 2, 10, 10 }));
+}
+
+BOOST_AUTO_TEST_CASE(GivenMergeFaces_WhenVisitArea_ThenCoplanarFacesAreMerged)
+{
+    const std::string mergeStylesheet = "area|z1[building=yes] { builders: building; building: true;"
+        "facade-color: gradient(blue); facade-type: flat; roof-color: gradient(red); roof-type: flat;"
+        "roof-height: 0m; height: 12m; min-height: 0m; merge-faces: true; }";
+    std::vector<std::size_t> triangles;
+    for (const auto& current : { stylesheet, mergeStylesheet }) {
+        auto context = createContext(current, [&](const Mesh& mesh) { triangles.push_back(mesh.triangles.size() / 3); });
+        BuildingBuilder builder(*context);
+        // NOTE points on sides produce coplanar roof triangles and wall quads.
+        builder.visitArea(ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 1, { { "building", "yes" } },
+            { { 10, 0 }, { 10, 5 }, { 10, 10 }, { 5, 10 }, { 0, 10 }, { 0, 5 }, { 0, 0 }, { 5, 0 } }));
+        builder.complete();
+    }
+
+    BOOST_REQUIRE_EQUAL(triangles.size(), 2);
+    BOOST_CHECK_GT(triangles[1], 0);
+    BOOST_CHECK_LT(triangles[1], triangles[0]);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -2,6 +2,7 @@
 #include "builders/BuilderContext.hpp"
 #include "builders/buildings/roofs/DomeRoofBuilder.hpp"
 #include "builders/buildings/roofs/MansardRoofBuilder.hpp"
+#include "builders/buildings/roofs/SkeletonRoofBuilder.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
 
@@ -76,4 +77,42 @@ BOOST_AUTO_TEST_CASE(GivenMansard_WhenBuilds_ThenMeshIsBuilt)
     BOOST_CHECK_GT(mesh->colors.size(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(GivenGabled_WhenBuilds_ThenGablesAreVertical)
+{
+    auto builder = createRoofBuilder<SkeletonRoofBuilder>();
+    SkeletonRoofBuilder gabledBuilder(*builderContext, *meshContext, SkeletonRoofBuilder::Form::Gabled);
+    gabledBuilder.setMinHeight(10);
+    gabledBuilder.setHeight(5);
+    gabledBuilder.setColorNoiseFreq(0);
+    Polygon polygon(0, 0);
+    polygon.addContour({ { 0, 0 }, { 0.001, 0 }, { 0.001, 0.0004 }, { 0, 0.0004 } });
+
+    gabledBuilder.build(polygon);
+
+    // two gables and two slopes.
+    BOOST_CHECK_EQUAL(mesh->triangles.size() / 3, 2 + 2 * 2);
+    bool hasGableTop = false;
+    for (std::size_t i = 0; i < mesh->vertices.size(); i += 3)
+        hasGableTop |= mesh->vertices[i] == 0 && std::abs(mesh->vertices[i + 2] - 15) < 1E-6;
+    BOOST_CHECK(hasGableTop);
+}
+
+BOOST_AUTO_TEST_CASE(GivenHippedComplexFootprint_WhenBuilds_ThenMeshIsBuilt)
+{
+    auto builder = createRoofBuilder<SkeletonRoofBuilder>();
+    builder.setMinHeight(10);
+    builder.setHeight(5);
+    builder.setColorNoiseFreq(0);
+    Polygon polygon(0, 0);
+    polygon.addContour({ { 0, 0 }, { 0, 0.001 }, { 0.0004, 0.001 }, { 0.0004, 0.0004 }, { 0.001, 0.0004 }, { 0.001, 0 } });
+
+    builder.build(polygon);
+
+    double maxHeight = 0;
+    for (std::size_t i = 2; i < mesh->vertices.size(); i += 3)
+        maxHeight = std::max(maxHeight, mesh->vertices[i]);
+    BOOST_CHECK_GT(mesh->triangles.size(), 0);
+    BOOST_CHECK_CLOSE(maxHeight, 15, 1E-6);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,4 +1,5 @@
 #include "builders/generators/CylinderGenerator.hpp"
+#include "builders/generators/ExtrudedLineGenerator.hpp"
 #include "builders/generators/IcoSphereGenerator.hpp"
 #include "builders/generators/TreeGenerator.hpp"
 #include "entities/Node.hpp"
@@ -9,6 +10,7 @@
 #include "test_utils/DependencyProvider.hpp"
 #include "test_utils/ElementUtils.hpp"
 
+#include <algorithm>
 #include <cstdio>
 
 using namespace utymap;
@@ -69,6 +71,23 @@ BOOST_AUTO_TEST_CASE(GivenIcoSphereGeneratorWithSimpleData_WhenGenerate_ThenCanG
     BOOST_CHECK_GT(mesh.colors.size(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(GivenIcoSphereGenerator_WhenGenerateTwice_ThenCachedTemplateGivesSameGeometry)
+{
+    IcoSphereGenerator icoSphereGenerator(builderContext, meshContext);
+    icoSphereGenerator
+        .setCenter(Vector3(0, 0, 0))
+        .setRadius(10)
+        .setRecursionLevel(1)
+        .isSemiSphere(true);
+
+    icoSphereGenerator.generate();
+    std::vector<double> first(mesh.vertices.begin(), mesh.vertices.end());
+    icoSphereGenerator.generate();
+
+    BOOST_REQUIRE_EQUAL(mesh.vertices.size(), first.size() * 2);
+    BOOST_CHECK(std::equal(first.begin(), first.end(), mesh.vertices.begin() + first.size()));
+}
+
 BOOST_AUTO_TEST_CASE(GivenCylinderGeneratorWithSimpleData_WhenGenerate_ThenCanGenerateMesh)
 {
     CylinderGenerator cylinderGenerator(builderContext, meshContext);
@@ -103,4 +122,58 @@ BOOST_AUTO_TEST_CASE(GivenTreeGeneratorWithSimpleData_WhenGenerate_ThenCanGenera
     BOOST_CHECK_GT(mesh.colors.size(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(GivenTreeGeneratorWithBillboard_WhenGenerate_ThenQuadsAreGenerated)
+{
+    TreeGenerator treeGenerator(builderContext, meshContext, ColorGradient(), ColorGradient());
+    treeGenerator
+            .setPosition(Vector3(0, 0, 0))
+            .setTrunkHeight(5)
+            .setTrunkRadius(0.5)
+            .setFoliageRadius(4, 4)
+            .setBillboard(true)
+            .generate();
+
+    // two double sided quads for trunk and foliage.
+    BOOST_CHECK_EQUAL(mesh.triangles.size() / 3, 2 * 2 * 4);
+    BOOST_CHECK_GT(mesh.colors.size(), 0);
+    double maxHeight = 0;
+    for (std::size_t i = 2; i < mesh.vertices.size(); i += 3)
+        maxHeight = std::max(maxHeight, mesh.vertices[i]);
+    BOOST_CHECK_CLOSE(maxHeight, 5 + 4 + 4, 1E-9);
+}
+
+BOOST_AUTO_TEST_CASE(GivenExtrudedLineGeneratorWithOpenLine_WhenGenerate_ThenVerticesAreShared)
+{
+    ExtrudedLineGenerator generator(builderContext, meshContext);
+    generator
+        .setPoints({ { 0, 0 }, { 10, 0 }, { 10, 10 } })
+        .setOffset(1)
+        .setHeight(2)
+        .setMinHeight(1);
+
+    generator.generate();
+
+    // four vertices per point, two sides and top per segment and two caps.
+    BOOST_CHECK_EQUAL(mesh.vertices.size() / 3, 3 * 4);
+    BOOST_CHECK_EQUAL(mesh.triangles.size() / 3, 2 * 6 + 2 * 2);
+    BOOST_CHECK_EQUAL(mesh.colors.size(), 3 * 4);
+    // right side of miter join is pushed outside of corner.
+    BOOST_CHECK_CLOSE(mesh.vertices[4 * 3 + 2 * 3], 11, 1E-9);
+    BOOST_CHECK_CLOSE(mesh.vertices[4 * 3 + 2 * 3 + 1], -1, 1E-9);
+}
+
+BOOST_AUTO_TEST_CASE(GivenExtrudedLineGeneratorWithClosedLine_WhenGenerate_ThenThereAreNoCaps)
+{
+    ExtrudedLineGenerator generator(builderContext, meshContext);
+    generator
+        .setPoints({ { 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 }, { 0, 0 } })
+        .setOffset(1)
+        .setHeight(2);
+
+    generator.generate();
+
+    BOOST_CHECK_EQUAL(mesh.vertices.size() / 3, 4 * 4);
+    BOOST_CHECK_EQUAL(mesh.triangles.size() / 3, 4 * 6);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
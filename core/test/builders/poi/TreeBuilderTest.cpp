@@ -19,7 +19,8 @@ namespace {
                                         "foliage-color: gradient(green);"
                                         "trunk-color:gradient(red); foliage-radius:2.5m;"
                                         "trunk-radius:0.2m; trunk-height:4m;"
-                                        "tree-step: 3m; }";
+                                        "tree-step: 3m; }"
+                                   "node|z16[natural=tree][billboard] { tree-billboard-lod: 16; }";
 
     struct Builders_Poi_TreeBuilderFixture
     {
@@ -71,4 +72,55 @@ BOOST_AUTO_TEST_CASE(GivenTreeRow_WhenVisitWay_ThenMeshIsBuilt)
     BOOST_CHECK(isCalled);
 }
 
+BOOST_AUTO_TEST_CASE(GivenInstancesCallback_WhenVisitTrees_ThenPrototypeIsShared)
+{
+    std::vector<std::size_t> instanceCounts;
+    BuilderContext instancesContext(QuadKey(16, 35204, 21494),
+        *dependencyProvider.getStyleProvider(stylesheet),
+        *dependencyProvider.getStringTable(),
+        *dependencyProvider.getElevationProvider(),
+        [](const Mesh&) { BOOST_FAIL("Trees should not be reported as meshes."); },
+        nullptr,
+        [&](const MeshInstances& instances) {
+            BOOST_CHECK_GT(instances.prototype.vertices.size(), 0);
+            instanceCounts.push_back(instances.size());
+        });
+    Node tree = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0, { { "natural", "tree" } });
+    tree.coordinate = GeoCoordinate(52.5137977, 13.3818357);
+    Way treeRow = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 1,
+        { { "natural", "tree_row" } },
+        { { 52.5137977, 13.3818357 }, { 52.5130465, 13.3822282 } });
+    TreeBuilder builder(instancesContext);
+
+    builder.visitNode(tree);
+    builder.visitWay(treeRow);
+    builder.complete();
+
+    BOOST_REQUIRE_EQUAL(instanceCounts.size(), 1);
+    BOOST_CHECK_GT(instanceCounts[0], 10);
+}
+
+BOOST_AUTO_TEST_CASE(GivenBillboardLod_WhenVisitNode_ThenTreeHasLessTriangles)
+{
+    std::vector<std::size_t> triangles;
+    BuilderContext countingContext(QuadKey(16, 35204, 21494),
+        *dependencyProvider.getStyleProvider(stylesheet),
+        *dependencyProvider.getStringTable(),
+        *dependencyProvider.getElevationProvider(),
+        [&](const Mesh& mesh) { triangles.push_back(mesh.triangles.size()); },
+        nullptr);
+    Node tree = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0, { { "natural", "tree" } });
+    Node billboard = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1,
+        { { "natural", "tree" }, { "billboard", "yes" } });
+    tree.coordinate = billboard.coordinate = GeoCoordinate(52.5137977, 13.3818357);
+    TreeBuilder builder(countingContext);
+
+    builder.visitNode(tree);
+    builder.visitNode(billboard);
+
+    BOOST_REQUIRE_EQUAL(triangles.size(), 2);
+    BOOST_CHECK_EQUAL(triangles[1], 3 * 2 * 2 * 4);
+    BOOST_CHECK_LT(triangles[1] * 5, triangles[0]);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "builders/terrain/ClipPathIndex.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace ClipperLib;
+using namespace utymap::builders;
+
+namespace {
+    Path createSquare(cInt x, cInt y, cInt size)
+    {
+        return { IntPoint(x, y), IntPoint(x + size, y), IntPoint(x + size, y + size), IntPoint(x, y + size) };
+    }
+
+    IntRect createRect(cInt left, cInt top, cInt right, cInt bottom)
+    {
+        IntRect rect;
+        rect.left = left;
+        rect.top = top;
+        rect.right = right;
+        rect.bottom = bottom;
+        return rect;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(Builders_Terrain_ClipPathIndex)
+
+BOOST_AUTO_TEST_CASE(GivenPaths_WhenQuery_ThenReturnsOnlyOverlappingInAddingOrder)
+{
+    ClipPathIndex index(createRect(0, 0, 100, 100), 4);
+    index.add({ createSquare(60, 60, 30), createSquare(0, 0, 10), createSquare(5, 5, 50) });
+
+    Paths result;
+    index.query(createRect(0, 0, 20, 20), result);
+
+    BOOST_REQUIRE_EQUAL(result.size(), 2);
+    BOOST_CHECK(result[0] == createSquare(0, 0, 10));
+    BOOST_CHECK(result[1] == createSquare(5, 5, 50));
+}
+
+BOOST_AUTO_TEST_CASE(GivenPathOutsideBounds_WhenQuery_ThenItIsFound)
+{
+    ClipPathIndex index(createRect(0, 0, 100, 100), 4);
+    index.add({ createSquare(150, -50, 10) });
+
+    Paths result;
+    index.query(createRect(140, -60, 170, -30), result);
+
+    BOOST_CHECK_EQUAL(result.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPathInManyCells_WhenQuery_ThenItIsReturnedOnce)
+{
+    ClipPathIndex index(createRect(0, 0, 100, 100), 8);
+    index.add({ createSquare(0, 0, 100) });
+
+    Paths result;
+    index.query(createRect(10, 10, 90, 90), result);
+    index.query(createRect(10, 10, 90, 90), result);
+
+    BOOST_CHECK_EQUAL(result.size(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -74,6 +74,24 @@ BOOST_AUTO_TEST_CASE(Given45Angle_WhenSplitWithHighLoD_ThenCanSplit)
     }
 }
 
+BOOST_AUTO_TEST_CASE(GivenLineThroughGridCorner_WhenSplit_ThenPointsAreOrderedWithoutDuplicates)
+{
+    LineGridSplitter splitter;
+    IntPoint start(30, 15);
+    IntPoint end(0, 0);
+    splitter.setParams(10, 1);
+    DoublePoints result;
+
+    splitter.split(start, end, result);
+
+    DoublePoints expected = { Vector2(3, 1.5), Vector2(2, 1), Vector2(1, 0.5), Vector2(0, 0) };
+    BOOST_REQUIRE_EQUAL(result.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        BOOST_CHECK_CLOSE(expected[i].x, result[i].x, Precision);
+        BOOST_CHECK_CLOSE(expected[i].y, result[i].y, Precision);
+    }
+}
+
 // These tests are for some bugs observed for real data
 BOOST_AUTO_TEST_CASE(GivenSpecificCase1_WhenSplit_ThenCanSplit)
 {
@@ -0,0 +1,52 @@
+#include "builders/terrain/OffsetPathCache.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace ClipperLib;
+using namespace utymap::builders;
+
+namespace {
+    const Paths Line = { { IntPoint(0, 0), IntPoint(10, 0) } };
+    const Paths Square = { { IntPoint(0, 0), IntPoint(10, 0), IntPoint(10, 10), IntPoint(0, 10) } };
+}
+
+BOOST_AUTO_TEST_SUITE(Builders_Terrain_OffsetPathCache)
+
+BOOST_AUTO_TEST_CASE(GivenDifferentParameters_WhenCreateKey_ThenKeysAreDifferent)
+{
+    auto key = OffsetPathCache::createKey(1, 16, 5, Line);
+
+    BOOST_CHECK_EQUAL(key, OffsetPathCache::createKey(1, 16, 5, Line));
+    BOOST_CHECK_NE(key, OffsetPathCache::createKey(2, 16, 5, Line));
+    BOOST_CHECK_NE(key, OffsetPathCache::createKey(1, 15, 5, Line));
+    BOOST_CHECK_NE(key, OffsetPathCache::createKey(1, 16, 6, Line));
+    BOOST_CHECK_NE(key, OffsetPathCache::createKey(1, 16, 5, Square));
+}
+
+BOOST_AUTO_TEST_CASE(GivenCachedPaths_WhenGet_ThenReturnsThem)
+{
+    OffsetPathCache cache(100);
+    cache.put(1, Square);
+    Paths result;
+
+    BOOST_CHECK(cache.get(1, result));
+    BOOST_CHECK(result == Square);
+    BOOST_CHECK(!cache.get(2, result));
+}
+
+BOOST_AUTO_TEST_CASE(GivenMaxPoints_WhenPutMore_ThenLeastRecentlyUsedAreRemoved)
+{
+    OffsetPathCache cache(8);
+    Paths result;
+    cache.put(1, Square);
+    cache.put(2, Square);
+    cache.get(1, result);
+
+    cache.put(3, Square);
+
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+    BOOST_CHECK(cache.get(1, result));
+    BOOST_CHECK(!cache.get(2, result));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
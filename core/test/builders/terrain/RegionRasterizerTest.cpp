@@ -0,0 +1,63 @@
+#include "builders/terrain/RegionRasterizer.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace ClipperLib;
+using namespace utymap::builders;
+
+namespace {
+    Path createSquare(cInt x, cInt y, cInt size)
+    {
+        return { IntPoint(x, y), IntPoint(x + size, y), IntPoint(x + size, y + size), IntPoint(x, y + size) };
+    }
+
+    IntRect createRect(cInt left, cInt top, cInt right, cInt bottom)
+    {
+        IntRect rect;
+        rect.left = left;
+        rect.top = top;
+        rect.right = right;
+        rect.bottom = bottom;
+        return rect;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(Builders_Terrain_RegionRasterizer)
+
+BOOST_AUTO_TEST_CASE(GivenSquare_WhenFill_ThenOnlyInnerVerticesHaveId)
+{
+    RegionRasterizer rasterizer(createRect(0, 0, 10, 10), 10, 10);
+
+    rasterizer.fill({ createSquare(2, 2, 5) }, 0);
+
+    BOOST_CHECK_EQUAL(rasterizer.get(2, 2), 0);
+    BOOST_CHECK_EQUAL(rasterizer.get(6, 6), 0);
+    BOOST_CHECK(rasterizer.get(1, 4) == RegionRasterizer::NoRegion);
+    BOOST_CHECK(rasterizer.get(8, 4) == RegionRasterizer::NoRegion);
+    BOOST_CHECK(rasterizer.get(4, 8) == RegionRasterizer::NoRegion);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSquareWithHole_WhenFill_ThenHoleIsNotCovered)
+{
+    RegionRasterizer rasterizer(createRect(0, 0, 10, 10), 10, 10);
+    Path hole = createSquare(4, 4, 2);
+    ReversePath(hole);
+
+    rasterizer.fill({ createSquare(1, 1, 8), hole }, 0);
+
+    BOOST_CHECK_EQUAL(rasterizer.get(2, 5), 0);
+    BOOST_CHECK(rasterizer.get(5, 5) == RegionRasterizer::NoRegion);
+}
+
+BOOST_AUTO_TEST_CASE(GivenOverlappingRegions_WhenFill_ThenFirstRegionWins)
+{
+    RegionRasterizer rasterizer(createRect(0, 0, 10, 10), 10, 10);
+
+    rasterizer.fill({ createSquare(0, 0, 5) }, 0);
+    rasterizer.fill({ createSquare(3, 3, 5) }, 1);
+
+    BOOST_CHECK_EQUAL(rasterizer.get(4, 4), 0);
+    BOOST_CHECK_EQUAL(rasterizer.get(7, 7), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,9 +3,18 @@
 #include "builders/terrain/TerraBuilder.hpp"
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "mapcss/MapCssParser.hpp"
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "test_utils/DependencyProvider.hpp"
 #include "test_utils/ElementUtils.hpp"
 
@@ -20,8 +29,87 @@ namespace {
         "water-ele-noise-freq: 0.05; water-color-noise-freq: 0.1; water-color:gradient(red);  water-max-area: 5%;}"
         "area|z1[natural=water] { builders:terrain; terrain-layer:water; }";
 
+    const std::string layersStylesheet =
+        "canvas|z1 { grid-cell-size: 1%; layer-priority: water,park; ele-noise-freq: 0.05; color-noise-freq: 0.1; color:gradient(red); max-area: 5%;"
+        "water-ele-noise-freq: 0.05; water-color-noise-freq: 0.1; water-color:gradient(blue); water-max-area: 5%;"
+        "park-ele-noise-freq: 0.05; park-color-noise-freq: 0.1; park-color:gradient(green); park-max-area: 5%; park-height-offset: 1m;}"
+        "area|z1[natural=water] { builders:terrain; terrain-layer:water; }"
+        "area|z1[leisure=park] { builders:terrain; terrain-layer:park; }";
+
+    const std::string lodStylesheet =
+        "canvas|z3 { grid-lod: 5; skirt-depth: 10; ele-noise-freq: 0; color-noise-freq: 0.1; color:gradient(red); max-area: 5%; }";
+
     struct Builders_Terrain_TerraBuilderFixture
     {
+        /// Builds terrain background of given quadkey and returns its vertices.
+        std::vector<double> buildBackground(const QuadKey& quadKey)
+        {
+            std::vector<double> vertices;
+            BuilderContext context(quadKey, *dependencyProvider.getStyleProvider(lodStylesheet),
+                *dependencyProvider.getStringTable(), *dependencyProvider.getElevationProvider(),
+                [&](const Mesh& mesh) { vertices = mesh.vertices; }, nullptr);
+            TerraBuilder terraBuilder(context);
+            terraBuilder.complete();
+            return vertices;
+        }
+
+        /// Builds terrain from two layers and returns geometry of terrain mesh.
+        std::vector<double> buildLayers(const std::string& stylesheet)
+        {
+            utymap::mapcss::StyleProvider styleProvider(utymap::mapcss::MapCssParser().parse(stylesheet),
+                                                        *dependencyProvider.getStringTable());
+            return buildLayers(styleProvider, 30);
+        }
+
+        /// Builds terrain from two layers using park with given max coordinate. If steps is set,
+        /// terrain is completed step by step and amount of steps is returned there.
+        std::vector<double> buildLayers(const utymap::mapcss::StyleProvider& styleProvider, double parkMax, int* steps = nullptr)
+        {
+            auto& stringTable = *dependencyProvider.getStringTable();
+            std::vector<double> geometry;
+            BuilderContext context(QuadKey(1, 0, 0), styleProvider, stringTable,
+                *dependencyProvider.getElevationProvider(),
+                [&](const Mesh& mesh) {
+                    geometry.insert(geometry.end(), mesh.vertices.begin(), mesh.vertices.end());
+                    geometry.insert(geometry.end(), mesh.triangles.begin(), mesh.triangles.end());
+                    geometry.insert(geometry.end(), mesh.colors.begin(), mesh.colors.end());
+                }, nullptr);
+            TerraBuilder terraBuilder(context);
+            ElementUtils::createElement<Area>(stringTable,
+                0, { { "natural", "water" } }, { { 0, 0 }, { 20, 0 }, { 20, 20 }, { 0, 20 } })
+                .accept(terraBuilder);
+            ElementUtils::createElement<Area>(stringTable,
+                1, { { "leisure", "park" } }, { { 10, 10 }, { parkMax, 10 }, { parkMax, parkMax }, { 10, parkMax } })
+                .accept(terraBuilder);
+
+            if (steps == nullptr)
+                terraBuilder.complete();
+            else
+                for (*steps = 1; terraBuilder.completeStep(); ++*steps) { }
+            return geometry;
+        }
+
+        /// Builds terrain from two layers and returns names and vertices of reported meshes.
+        std::vector<std::pair<std::string, std::vector<double>>> buildMeshes(const std::string& stylesheet)
+        {
+            auto& stringTable = *dependencyProvider.getStringTable();
+            utymap::mapcss::StyleProvider styleProvider(utymap::mapcss::MapCssParser().parse(stylesheet), stringTable);
+            std::vector<std::pair<std::string, std::vector<double>>> meshes;
+            BuilderContext context(QuadKey(1, 0, 0), styleProvider, stringTable,
+                *dependencyProvider.getElevationProvider(),
+                [&](const Mesh& mesh) { meshes.push_back(std::make_pair(mesh.name, mesh.vertices)); }, nullptr);
+            TerraBuilder terraBuilder(context);
+            ElementUtils::createElement<Area>(stringTable,
+                0, { { "natural", "water" } }, { { 0, 0 }, { 20, 0 }, { 20, 20 }, { 0, 20 } })
+                .accept(terraBuilder);
+            ElementUtils::createElement<Area>(stringTable,
+                1, { { "leisure", "park" } }, { { 10, 10 }, { 30, 10 }, { 30, 30 }, { 10, 30 } })
+                .accept(terraBuilder);
+
+            terraBuilder.complete();
+            return meshes;
+        }
+
         DependencyProvider dependencyProvider;
         std::shared_ptr<TerraBuilder> terraBuilder;
     };
@@ -52,4 +140,193 @@ BOOST_AUTO_TEST_CASE(GivenLargeWater_WhenComplete_ThenMeshIsNotEmpty)
     BOOST_CHECK(isCalled);
 }
 
+BOOST_AUTO_TEST_CASE(GivenSplitPolygonInLayer_WhenComplete_ThenPiecesAreMeshedSeparately)
+{
+    const std::string pieceStylesheet =
+        "canvas|z1 { grid-cell-size: 1%; layer-priority: water; ele-noise-freq: 0; color-noise-freq: 0; color:gradient(red); max-area: 5%;"
+        "water-ele-noise-freq: 0; water-color-noise-freq: 0; water-color:gradient(blue); water-max-area: 5%; water-mesh-name: water; }"
+        "relation|z1[natural=water], area|z1[natural=water] { builders:terrain; terrain-layer:water; }";
+    auto& stringTable = *dependencyProvider.getStringTable();
+    utymap::mapcss::StyleProvider styleProvider(utymap::mapcss::MapCssParser().parse(pieceStylesheet), stringTable);
+    int waterMeshes = 0;
+    double waterArea = 0;
+    BuilderContext context(QuadKey(1, 0, 0), styleProvider, stringTable, *dependencyProvider.getElevationProvider(),
+        [&](const Mesh& mesh) {
+            if (mesh.name != "water")
+                return;
+            ++waterMeshes;
+            for (std::size_t i = 0; i < mesh.triangles.size(); i += 3) {
+                const double* a = &mesh.vertices[mesh.triangles[i] * 3];
+                const double* b = &mesh.vertices[mesh.triangles[i + 1] * 3];
+                const double* c = &mesh.vertices[mesh.triangles[i + 2] * 3];
+                waterArea += std::abs((b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1])) / 2;
+            }
+        }, nullptr);
+    TerraBuilder terraBuilder(context);
+    Relation polygon = ElementUtils::createElement<Relation>(stringTable, 0, { { "natural", "water" } });
+    for (double latitude : { 10., 20. }) {
+        auto piece = std::make_shared<Relation>(ElementUtils::createElement<Relation>(stringTable, 0, { { "natural", "water" } }));
+        piece->elements.push_back(std::make_shared<Area>(ElementUtils::createElement<Area>(stringTable, 0, {},
+            { { latitude, -30 }, { latitude + 10, -30 }, { latitude + 10, -10 }, { latitude, -10 } })));
+        polygon.elements.push_back(piece);
+    }
+
+    polygon.accept(terraBuilder);
+    terraBuilder.complete();
+
+    BOOST_CHECK_EQUAL(waterMeshes, 2);
+    BOOST_CHECK_CLOSE(waterArea, 400, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMeshTasks_WhenComplete_ThenMeshIsSameAsSequential)
+{
+    std::vector<double> sequential = buildLayers(layersStylesheet);
+    std::string parallelStylesheet = layersStylesheet;
+    parallelStylesheet.insert(parallelStylesheet.find('{') + 1, " mesh-tasks: 2;");
+
+    std::vector<double> parallel = buildLayers(parallelStylesheet);
+
+    BOOST_CHECK(!sequential.empty());
+    BOOST_CHECK(sequential == parallel);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTwoLayers_WhenCompleteStepByStep_ThenMeshIsSameAsCompletedAtOnce)
+{
+    utymap::mapcss::StyleProvider styleProvider(utymap::mapcss::MapCssParser().parse(layersStylesheet),
+                                                *dependencyProvider.getStringTable());
+    int steps = 0;
+
+    std::vector<double> completed = buildLayers(styleProvider, 30);
+    std::vector<double> stepped = buildLayers(styleProvider, 30, &steps);
+
+    BOOST_CHECK(!completed.empty());
+    BOOST_CHECK(completed == stepped);
+    // NOTE every layer is separate step between setup and background.
+    BOOST_CHECK_GE(steps, 4);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTerrainCache_WhenRebuildAfterEdit_ThenMeshIsSameAsWithoutCache)
+{
+    std::string cachedStylesheet = layersStylesheet;
+    cachedStylesheet.insert(cachedStylesheet.find('{') + 1, " terrain-cache: 1;");
+    auto& stringTable = *dependencyProvider.getStringTable();
+    utymap::mapcss::StyleProvider styleProvider(utymap::mapcss::MapCssParser().parse(layersStylesheet), stringTable);
+    utymap::mapcss::StyleProvider cachedStyleProvider(utymap::mapcss::MapCssParser().parse(cachedStylesheet), stringTable);
+
+    std::vector<double> first = buildLayers(cachedStyleProvider, 30);
+    std::vector<double> second = buildLayers(cachedStyleProvider, 30);
+    std::vector<double> edited = buildLayers(cachedStyleProvider, 25);
+
+    BOOST_CHECK(first == buildLayers(styleProvider, 30));
+    BOOST_CHECK(second == first);
+    BOOST_CHECK(edited == buildLayers(styleProvider, 25));
+    BOOST_CHECK(edited != first);
+}
+
+BOOST_AUTO_TEST_CASE(GivenGridLod_WhenBuildNeighbours_ThenSharedEdgeHasSameVertices)
+{
+    double edgeLatitude = utymap::utils::GeoUtils::quadKeyToBoundingBox(QuadKey(3, 2, 2)).minPoint.latitude;
+    auto getEdgeLongitudes = [&](const std::vector<double>& vertices) {
+        std::set<double> longitudes;
+        for (std::size_t i = 0; i < vertices.size(); i += 3)
+            if (std::abs(vertices[i + 1] - edgeLatitude) < 1E-6 && vertices[i + 2] == 0)
+                longitudes.insert(std::round(vertices[i] * 1E6) / 1E6);
+        return longitudes;
+    };
+
+    auto upper = getEdgeLongitudes(buildBackground(QuadKey(3, 2, 2)));
+    auto lower = getEdgeLongitudes(buildBackground(QuadKey(3, 2, 3)));
+
+    BOOST_CHECK_GT(upper.size(), 2);
+    BOOST_CHECK(upper == lower);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMeshChunkSize_WhenComplete_ThenTerrainIsReportedInNamedChunks)
+{
+    std::string chunkedStylesheet = layersStylesheet;
+    chunkedStylesheet.insert(chunkedStylesheet.find('{') + 1, " mesh-chunk-size: 1;");
+
+    auto meshes = buildMeshes(layersStylesheet);
+    auto chunks = buildMeshes(chunkedStylesheet);
+
+    BOOST_REQUIRE_EQUAL(meshes.size(), 1);
+    BOOST_CHECK_EQUAL(meshes[0].first, "terrain");
+    BOOST_REQUIRE_GT(chunks.size(), 1);
+    std::vector<double> vertices;
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        BOOST_CHECK_EQUAL(chunks[i].first, "terrain#" + std::to_string(i));
+        BOOST_CHECK(!chunks[i].second.empty());
+        vertices.insert(vertices.end(), chunks[i].second.begin(), chunks[i].second.end());
+    }
+    BOOST_CHECK(vertices == meshes[0].second);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSkirtDepth_WhenComplete_ThenSkirtIsBelowSurface)
+{
+    std::vector<double> vertices = buildBackground(QuadKey(3, 2, 2));
+
+    double minElevation = 0;
+    for (std::size_t i = 2; i < vertices.size(); i += 3)
+        minElevation = std::min(minElevation, vertices[i]);
+
+    BOOST_CHECK_EQUAL(minElevation, -10);
+}
+
+BOOST_AUTO_TEST_CASE(GivenGridMode_WhenComplete_ThenRegularGridIsBuilt)
+{
+    std::string gridStylesheet = layersStylesheet;
+    gridStylesheet.insert(gridStylesheet.find('{') + 1, " terrain-mode: grid;");
+    std::size_t vertexCount = 0, triangleCount = 0;
+    std::set<int> colors;
+    auto& stringTable = *dependencyProvider.getStringTable();
+    utymap::mapcss::StyleProvider styleProvider(utymap::mapcss::MapCssParser().parse(gridStylesheet), stringTable);
+    BuilderContext context(QuadKey(1, 0, 0), styleProvider, stringTable,
+        *dependencyProvider.getElevationProvider(),
+        [&](const Mesh& mesh) {
+            vertexCount = mesh.vertices.size() / 3;
+            triangleCount = mesh.triangles.size() / 3;
+            colors.insert(mesh.colors.begin(), mesh.colors.end());
+        }, nullptr);
+    TerraBuilder terraBuilder(context);
+    ElementUtils::createElement<Area>(stringTable,
+        0, { { "natural", "water" } }, { { 0, 0 }, { 20, 0 }, { 20, 20 }, { 0, 20 } })
+        .accept(terraBuilder);
+
+    terraBuilder.complete();
+
+    // grid cell size is 1% of tile height: tile is 180 degrees wide and about 85 degrees high.
+    BOOST_CHECK_EQUAL(vertexCount, 213 * 101);
+    BOOST_CHECK_EQUAL(triangleCount, 212 * 100 * 2);
+    BOOST_CHECK_GT(colors.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCanvas_WhenBuildPreview_ThenCoarseMeshCoversQuadKey)
+{
+    QuadKey quadKey(3, 2, 3);
+    auto bbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey);
+    std::vector<std::string> names;
+    std::vector<double> vertices;
+    BuilderContext context(quadKey, *dependencyProvider.getStyleProvider(lodStylesheet),
+        *dependencyProvider.getStringTable(), *dependencyProvider.getElevationProvider(),
+        [&](const Mesh& mesh) {
+            names.push_back(mesh.name);
+            vertices = mesh.vertices;
+        }, nullptr);
+
+    TerraBuilder::buildPreview(context);
+
+    BOOST_REQUIRE_EQUAL(names.size(), 1);
+    BOOST_CHECK_EQUAL(names[0], "terrain_preview");
+    BOOST_REQUIRE_GT(vertices.size(), 4 * 3);
+    double minLon = vertices[0], maxLon = vertices[0];
+    for (std::size_t i = 0; i < vertices.size(); i += 3) {
+        minLon = std::min(minLon, vertices[i]);
+        maxLon = std::max(maxLon, vertices[i]);
+    }
+    BOOST_CHECK_CLOSE(minLon, bbox.minPoint.longitude, 1E-6);
+    BOOST_CHECK_CLOSE(maxLon, bbox.maxPoint.longitude, 1E-6);
+    // NOTE preview should stay coarse: triangles are not smaller than grid cell of 4x4.
+    BOOST_CHECK_LT(vertices.size() / 3, 100);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
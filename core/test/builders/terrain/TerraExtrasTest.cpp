@@ -88,4 +88,35 @@ BOOST_AUTO_TEST_CASE(GivenMesh_WhenAddForest_ThenTreesAreAdded)
     BOOST_CHECK(isVerified);
 }
 
+BOOST_AUTO_TEST_CASE(GivenInstancesCallback_WhenAddForest_ThenTreesAreInstances)
+{
+    std::size_t prototypeVertices = 0;
+    std::vector<double> transforms;
+    BuilderContext context(QuadKey(16, 0, 0),
+        *dependencyProvider.getStyleProvider(stylesheet),
+        *dependencyProvider.getStringTable(),
+        *dependencyProvider.getElevationProvider(),
+        [](const Mesh&) { BOOST_FAIL("Trees should not be merged into mesh."); },
+        nullptr,
+        [&](const MeshInstances& instances) {
+            prototypeVertices = instances.prototype.vertices.size();
+            transforms = instances.transforms;
+        });
+    auto mesh = generateMesh();
+    auto style = generateStyle();
+    std::size_t triangleCount = mesh->triangles.size() / 3;
+    TerraExtras::Context extrasContext(*mesh, style);
+    extrasContext.startVertex = 0, extrasContext.startTriangle = 0,
+        extrasContext.startColor = 0;
+
+    TerraExtras::addForestInstances(context, extrasContext);
+
+    BOOST_CHECK_GT(prototypeVertices, 0);
+    BOOST_CHECK_EQUAL(transforms.size(), triangleCount * 6);
+    for (std::size_t i = 0; i < transforms.size(); i += 6) {
+        BOOST_CHECK_EQUAL(transforms[i + 3], 1);
+        BOOST_CHECK(transforms[i + 5] >= 0 && transforms[i + 5] < 1);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "entities/ElementBatch.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_utils/DependencyProvider.hpp"
+#include "test_utils/ElementUtils.hpp"
+
+using namespace utymap::entities;
+
+namespace {
+    /// Records ids of visited elements in visit order.
+    struct IdCollector : public ElementVisitor
+    {
+        std::vector<std::uint64_t> ids;
+        std::vector<std::size_t> sizes;
+
+        void visitNode(const Node& node) override { add(node, 1); }
+        void visitWay(const Way& way) override { add(way, way.coordinates.size()); }
+        void visitArea(const Area& area) override { add(area, area.coordinates.size()); }
+        void visitRelation(const Relation& relation) override { add(relation, relation.elements.size()); }
+
+    private:
+        void add(const Element& element, std::size_t size)
+        {
+            ids.push_back(element.id);
+            sizes.push_back(size);
+        }
+    };
+
+    struct Entities_ElementBatchFixture
+    {
+        Entities_ElementBatchFixture()
+        {
+            auto& stringTable = *dependencyProvider.getStringTable();
+            Node node = ElementUtils::createElement<Node>(stringTable, 1, { { "n", "1" } });
+            node.coordinate = { 5, -5 };
+            Way way = ElementUtils::createElement<Way>(stringTable, 2, { { "w", "2" } }, { { 5, -5 }, { 5, -10 } });
+            Area area = ElementUtils::createElement<Area>(stringTable, 3, { { "a", "3" } },
+                { { 5, -5 }, { 5, -10 }, { 10, -10 } });
+            Relation relation = ElementUtils::createElement<Relation>(stringTable, 4, { { "r", "4" }, { "type", "multipolygon" } });
+            relation.elements.push_back(std::make_shared<Node>(node));
+            relation.elements.push_back(std::make_shared<Area>(area));
+
+            batch.add(node);
+            batch.add(relation);
+            batch.add(way);
+            batch.add(area);
+        }
+
+        DependencyProvider dependencyProvider;
+        ElementBatch batch;
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(Entities_ElementBatch, Entities_ElementBatchFixture)
+
+BOOST_AUTO_TEST_CASE(GivenElements_WhenAccept_ThenTheyAreVisitedInOrderWithoutMembers)
+{
+    IdCollector collector;
+
+    batch.accept(collector);
+
+    BOOST_CHECK_EQUAL(batch.size(), 4);
+    BOOST_CHECK(collector.ids == std::vector<std::uint64_t>({ 1, 4, 2, 3 }));
+    BOOST_CHECK(collector.sizes == std::vector<std::size_t>({ 1, 2, 2, 3 }));
+}
+
+BOOST_AUTO_TEST_CASE(GivenRelation_WhenForEach_ThenItIsReadBackWithMembersAndTags)
+{
+    std::shared_ptr<Relation> relation;
+
+    batch.forEach([&](Element& element) {
+        if (element.id == 4)
+            relation = std::make_shared<Relation>(static_cast<Relation&>(element));
+    });
+
+    BOOST_REQUIRE(relation != nullptr);
+    BOOST_CHECK_EQUAL(relation->tags.size(), 2);
+    BOOST_REQUIRE_EQUAL(relation->elements.size(), 2);
+    BOOST_CHECK_EQUAL(relation->elements[0]->tags.size(), 1);
+    auto area = std::dynamic_pointer_cast<Area>(relation->elements[1]);
+    BOOST_REQUIRE(area != nullptr);
+    BOOST_CHECK_EQUAL(area->id, 3);
+    BOOST_CHECK_EQUAL(area->coordinates[2].latitude, 10);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRelationBeforeWay_WhenEraseRelation_ThenOthersAreKept)
+{
+    std::size_t size = batch.getSize();
+    IdCollector collector;
+
+    BOOST_CHECK(batch.erase(4));
+    batch.accept(collector);
+
+    BOOST_CHECK_EQUAL(batch.size(), 3);
+    BOOST_CHECK(batch.getSize() < size);
+    BOOST_CHECK(collector.ids == std::vector<std::uint64_t>({ 1, 2, 3 }));
+    BOOST_CHECK(collector.sizes == std::vector<std::size_t>({ 1, 2, 3 }));
+}
+
+BOOST_AUTO_TEST_CASE(GivenWayAfterRelation_WhenEraseIt_ThenRelationMembersAreKept)
+{
+    std::shared_ptr<Relation> relation;
+
+    BOOST_CHECK(batch.erase(2));
+    BOOST_CHECK(!batch.erase(2));
+    batch.forEach([&](Element& element) {
+        if (element.id == 4)
+            relation = std::make_shared<Relation>(static_cast<Relation&>(element));
+    });
+
+    BOOST_CHECK_EQUAL(batch.size(), 3);
+    BOOST_REQUIRE(relation != nullptr);
+    BOOST_CHECK_EQUAL(relation->elements.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenElements_WhenClear_ThenBatchIsEmpty)
+{
+    batch.clear();
+
+    BOOST_CHECK(batch.empty());
+    BOOST_CHECK_EQUAL(batch.getSize(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenOsmPrecisionCoordinate_WhenReadBack_ThenItIsKeptAndInvalidStaysInvalid)
+{
+    batch.clear();
+    Way way;
+    way.id = 5;
+    way.coordinates = { { 52.5305539, 13.3830990 }, { -85.0511287, -179.9999999 }, utymap::GeoCoordinate() };
+    std::vector<utymap::GeoCoordinate> coordinates;
+
+    batch.add(way);
+    batch.forEach([&](Element& element) { coordinates = static_cast<Way&>(element).coordinates; });
+
+    BOOST_REQUIRE_EQUAL(coordinates.size(), 3);
+    BOOST_CHECK_CLOSE(coordinates[0].latitude, 52.5305539, 1E-10);
+    BOOST_CHECK_CLOSE(coordinates[1].longitude, -179.9999999, 1E-10);
+    BOOST_CHECK(!coordinates[2].isValid());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,6 +2,7 @@
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
+#include "entities/ElementDispatch.hpp"
 
 #include <boost/test/unit_test.hpp>
 
@@ -93,4 +94,32 @@ BOOST_AUTO_TEST_CASE(GivenRelation_WhenVisit_ThenIncrementsCounter)
     BOOST_CHECK_EQUAL(counter.relations, 1);
 }
 
+BOOST_AUTO_TEST_CASE(GivenElementsAsBase_WhenStaticVisit_ThenDispatchesByType)
+{
+    Counter counter;
+    Node node;
+    Way way;
+    Area area;
+    Relation relation;
+    std::vector<const Element*> elements = { &node, &way, &area, &relation, &area };
+
+    for (const auto* element : elements)
+        visit(*element, counter);
+
+    BOOST_CHECK_EQUAL(counter.nodes, 1);
+    BOOST_CHECK_EQUAL(counter.ways, 1);
+    BOOST_CHECK_EQUAL(counter.areas, 2);
+    BOOST_CHECK_EQUAL(counter.relations, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCopiedElement_WhenGetType_ThenTypeIsKept)
+{
+    Area area;
+    Area copy = area;
+    std::shared_ptr<Element> shared = std::make_shared<Area>(copy);
+
+    BOOST_CHECK(copy.type == ElementType::Area);
+    BOOST_CHECK(shared->type == ElementType::Area);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -9,6 +9,7 @@
 #include <boost/test/unit_test.hpp>
 #include "test_utils/DependencyProvider.hpp"
 
+#include <cmath>
 #include <functional>
 
 using namespace utymap;
@@ -144,6 +145,39 @@ BOOST_AUTO_TEST_CASE(GivenOneOuterNonClosed_WhenProcess_ThenReturnCorrectResult)
     BOOST_CHECK(ensureExpectedOrientation(expected) == reinterpret_cast<const Area&>(*relation->elements[0]).coordinates);
 }
 
+BOOST_AUTO_TEST_CASE(GivenManyOuterWaysInMixedOrderAndDirection_WhenProcess_ThenRingsAreAssembled)
+{
+    const std::uint64_t count = 2000;
+    const double pi = std::acos(-1.0);
+    auto point = [&](std::uint64_t i) {
+        double angle = 2 * pi * static_cast<double>(i % count) / count;
+        return GeoCoordinate(10 * std::sin(angle), 10 * std::cos(angle));
+    };
+    RelationMembers relationMembers;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        // NOTE ways are listed in interleaved order and every third one is reversed.
+        std::uint64_t index = (i * 7) % count;
+        auto way = std::make_shared<Way>();
+        way->id = index + 1;
+        way->coordinates = { point(index), point(index + 1) };
+        if (i % 3 == 0)
+            std::reverse(way->coordinates.begin(), way->coordinates.end());
+        context.wayMap[way->id] = way;
+        relationMembers.push_back(RelationMember{ way->id, "w", "outer" });
+    }
+    context.areaMap[count + 1] = createElement<Area>({ { -1, -1 }, { -1, 1 }, { 1, 1 }, { 1, -1 } });
+    relationMembers.push_back(RelationMember{ count + 1, "w", "inner" });
+    MultipolygonProcessor processor(*createRelation(), relationMembers, context,
+        std::bind(&Formats_Osm_MultipolygonProcessorFixture::resolve, this, std::placeholders::_1));
+
+    processor.process();
+
+    auto relation = context.relationMap[0];
+    BOOST_REQUIRE_EQUAL(2, relation->elements.size());
+    BOOST_CHECK_EQUAL(count, reinterpret_cast<const Area&>(*relation->elements[0]).coordinates.size());
+    BOOST_CHECK_EQUAL(4, reinterpret_cast<const Area&>(*relation->elements[1]).coordinates.size());
+}
+
 BOOST_AUTO_TEST_CASE(GivenTwoOuterClosed_WhenProcess_ThenReturnCorrectResult)
 {
     RelationMembers relationMembers = createRelationMembers({
@@ -1,8 +1,14 @@
 #include "entities/Relation.hpp"
+#include "entities/Way.hpp"
 #include "formats/osm/OsmDataVisitor.hpp"
+#include "formats/osm/OsmElementId.hpp"
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <map>
+#include <vector>
+
 #include "test_utils/DependencyProvider.hpp"
 
 using namespace utymap::entities;
@@ -22,6 +28,38 @@ namespace {
         }
 
         bool add(utymap::entities::Element&) { return false; }
+
+        /// Visits independent multipolygons and nested relations returning amount of resolved elements per relation.
+        std::map<std::uint64_t, std::size_t> resolveRelations(std::size_t threads)
+        {
+            std::map<std::uint64_t, std::size_t> sizes;
+            OsmDataVisitor relationVisitor(*dependencyProvider.getStringTable(), [&](Element& element) {
+                if (auto relation = dynamic_cast<Relation*>(&element))
+                    sizes[relation->id] = relation->elements.size();
+                return true;
+            });
+            relationVisitor.setConcurrency(threads);
+            Tags noTags = {};
+            Tags multipolygon = { { "type", "multipolygon" }, { "landuse", "grass" } };
+            Tags route = { { "type", "route" } };
+            for (std::uint64_t i = 0; i < 10; ++i) {
+                utymap::GeoCoordinate coordinates[] = { { 0, 0 }, { 0, 1 }, { 1, 1 } };
+                for (std::uint64_t j = 0; j < 3; ++j) {
+                    coordinates[j].longitude += i * 2;
+                    relationVisitor.visitNode(i * 10 + j + 1, coordinates[j], noTags);
+                }
+                std::vector<std::uint64_t> ring = { i * 10 + 1, i * 10 + 2, i * 10 + 3, i * 10 + 1 };
+                relationVisitor.visitWay(1000 + i, ring, noTags);
+                RelationMembers members = { { 1000 + i, "w", "outer" } };
+                relationVisitor.visitRelation(2000 + i, members, multipolygon);
+            }
+            RelationMembers parentMembers = { { 2000, "r", "" }, { 2001, "r", "" }, { 3001, "r", "" } };
+            RelationMembers childMembers = { { 2002, "r", "" }, { 1, "n", "" } };
+            relationVisitor.visitRelation(3000, parentMembers, route);
+            relationVisitor.visitRelation(3001, childMembers, route);
+            relationVisitor.complete();
+            return sizes;
+        }
     };
 }
 
@@ -30,8 +68,8 @@ BOOST_FIXTURE_TEST_SUITE(Formats_Osm_OsmDataVisitor, Formats_Osm_OsmDataVisitorF
 BOOST_AUTO_TEST_CASE(GivenRelationWithRecursion_WhenComplete_ThenDoesNotCrash)
 {
     Tags tags = {};
-    RelationMembers parentMembers = { {2, "", ""} };
-    RelationMembers childMembers = { {1, "", ""} };
+    RelationMembers parentMembers = { {2, "r", ""} };
+    RelationMembers childMembers = { {1, "r", ""} };
 
     visitor.visitRelation(1, parentMembers, tags);
     visitor.visitRelation(2, childMembers, tags);
@@ -39,4 +77,127 @@ BOOST_AUTO_TEST_CASE(GivenRelationWithRecursion_WhenComplete_ThenDoesNotCrash)
     visitor.complete();
 }
 
+BOOST_AUTO_TEST_CASE(GivenConcurrency_WhenComplete_ThenRelationsAreResolvedAsSequentially)
+{
+    auto expected = resolveRelations(0);
+    auto actual = resolveRelations(4);
+
+    BOOST_CHECK_EQUAL(expected.size(), 12);
+    BOOST_CHECK_EQUAL(expected.at(OsmElementId::relation(3000)), 3);
+    BOOST_CHECK_EQUAL(expected.at(OsmElementId::relation(3001)), 2);
+    BOOST_CHECK(expected == actual);
+}
+
+BOOST_AUTO_TEST_CASE(GivenFilter_WhenComplete_ThenOnlyElementsInsideWithTagsAreAdded)
+{
+    std::vector<std::uint64_t> ids;
+    OsmDataVisitor filteredVisitor(*dependencyProvider.getStringTable(), [&](Element& element) {
+        ids.push_back(element.id);
+        return true;
+    });
+    filteredVisitor.setFilter(utymap::BoundingBox({ 0, 0 }, { 10, 10 }), [](const Element&) { return true; });
+    Tags tags = { { "any", "true" } };
+    Tags noTags = {};
+    utymap::GeoCoordinate inside(5, 5), outside(20, 20), farOutside(30, 30);
+    std::vector<std::uint64_t> crossingWay = { 2, 3 }, outsideWay = { 2, 4 };
+
+    filteredVisitor.visitNode(1, inside, tags);
+    filteredVisitor.visitNode(2, outside, tags);
+    filteredVisitor.visitNode(3, inside, noTags);
+    filteredVisitor.visitNode(4, farOutside, noTags);
+    filteredVisitor.visitWay(10, crossingWay, tags);
+    filteredVisitor.visitWay(11, outsideWay, tags);
+    filteredVisitor.complete();
+
+    std::sort(ids.begin(), ids.end());
+    std::vector<std::uint64_t> expected = { 1, OsmElementId::way(10) };
+    BOOST_CHECK_EQUAL_COLLECTIONS(ids.begin(), ids.end(), expected.begin(), expected.end());
+    BOOST_CHECK(filteredVisitor.needsTags(inside));
+    BOOST_CHECK(!filteredVisitor.needsTags(outside));
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodeCoordinateFile_WhenComplete_ThenWaysAreBuiltAndOnlyTaggedNodesAdded)
+{
+    std::vector<std::uint64_t> ids;
+    std::vector<utymap::GeoCoordinate> coordinates;
+    OsmDataVisitor fileVisitor(*dependencyProvider.getStringTable(), [&](Element& element) {
+        ids.push_back(element.id);
+        if (auto way = dynamic_cast<Way*>(&element))
+            coordinates = way->coordinates;
+        return true;
+    });
+    fileVisitor.setNodeCoordinateFile("nodes.bin");
+    Tags tags = { { "any", "true" } };
+    Tags noTags = {};
+    utymap::GeoCoordinate first(52.5200001, 13.4049999), second(-33.8688197, -151.2092955);
+    std::uint64_t largeId = 100000000ull;
+    std::vector<std::uint64_t> way = { 1, largeId };
+
+    fileVisitor.visitNode(1, first, tags);
+    fileVisitor.visitNode(largeId, second, noTags);
+    fileVisitor.visitWay(10, way, tags);
+    fileVisitor.complete();
+
+    std::sort(ids.begin(), ids.end());
+    std::vector<std::uint64_t> expected = { 1, OsmElementId::way(10) };
+    BOOST_CHECK_EQUAL_COLLECTIONS(ids.begin(), ids.end(), expected.begin(), expected.end());
+    BOOST_REQUIRE_EQUAL(coordinates.size(), 2);
+    BOOST_CHECK_CLOSE(coordinates[1].latitude, second.latitude, 1E-6);
+    BOOST_CHECK_CLOSE(coordinates[1].longitude, second.longitude, 1E-6);
+}
+
+BOOST_AUTO_TEST_CASE(GivenReferencedNodes_WhenComplete_ThenOnlyTaggedAndRelationNodesAreAdded)
+{
+    std::vector<std::uint64_t> ids;
+    OsmDataVisitor referenceVisitor(*dependencyProvider.getStringTable(), [&](Element& element) {
+        ids.push_back(element.id);
+        return true;
+    });
+    Tags tags = { { "any", "true" } };
+    Tags noTags = {};
+    utymap::GeoCoordinate first(5, 5), second(6, 6);
+    std::vector<std::uint64_t> way = { 1, 3 };
+    RelationMembers members = { { 4, "n", "" } };
+    NodeReferenceVisitor references;
+    std::vector<utymap::entities::Tag> noIdTags;
+    references.visitWay(10, way, noIdTags);
+    references.visitRelation(20, members, noIdTags);
+    referenceVisitor.setReferencedNodes(references.wayNodes, references.relationNodes);
+
+    referenceVisitor.visitNode(1, first, noTags);
+    referenceVisitor.visitNode(2, first, noTags);
+    referenceVisitor.visitNode(3, second, tags);
+    referenceVisitor.visitNode(4, second, noTags);
+    referenceVisitor.visitWay(10, way, tags);
+    referenceVisitor.visitRelation(20, members, tags);
+    referenceVisitor.complete();
+
+    std::sort(ids.begin(), ids.end());
+    std::vector<std::uint64_t> expected = { 3, 4, OsmElementId::way(10), OsmElementId::relation(20) };
+    BOOST_CHECK_EQUAL_COLLECTIONS(ids.begin(), ids.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodeAndWayWithSameId_WhenComplete_ThenBothAreAddedWithDifferentIds)
+{
+    std::vector<std::uint64_t> ids;
+    OsmDataVisitor idVisitor(*dependencyProvider.getStringTable(), [&](Element& element) {
+        ids.push_back(element.id);
+        return true;
+    });
+    Tags tags = { { "any", "true" } };
+    utymap::GeoCoordinate first(5, 5), second(6, 6);
+    std::vector<std::uint64_t> way = { 1, 2 };
+    RelationMembers members = { { 1, "w", "" }, { 1, "n", "" } };
+
+    idVisitor.visitNode(1, first, tags);
+    idVisitor.visitNode(2, second, tags);
+    idVisitor.visitWay(1, way, tags);
+    idVisitor.visitRelation(1, members, tags);
+    idVisitor.complete();
+
+    std::sort(ids.begin(), ids.end());
+    std::vector<std::uint64_t> expected = { 1, 2, OsmElementId::way(1), OsmElementId::relation(1) };
+    BOOST_CHECK_EQUAL_COLLECTIONS(ids.begin(), ids.end(), expected.begin(), expected.end());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
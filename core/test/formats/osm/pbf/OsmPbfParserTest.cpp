@@ -1,15 +1,96 @@
 #include "formats/osm/pbf/OsmPbfParser.hpp"
 #include "formats/osm/CountableOsmDataVisitor.hpp"
+#include "formats/osm/NodeReferenceVisitor.hpp"
 #include "config.hpp"
+#include "entities/Element.hpp"
+#include "index/StringTable.hpp"
+#include "test_utils/DependencyProvider.hpp"
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
 #include <fstream>
+#include <set>
+#include <string>
 
 using namespace utymap::formats;
 
 namespace {
 
+    struct IdCollector
+    {
+        std::vector<std::uint64_t> ids;
+
+        void visitNode(std::uint64_t id, utymap::GeoCoordinate&, Tags&) { ids.push_back(id); }
+        void visitWay(std::uint64_t id, std::vector<std::uint64_t>&, Tags&) { ids.push_back(id); }
+        void visitRelation(std::uint64_t id, RelationMembers&, Tags&) { ids.push_back(id); }
+    };
+
+    /// Collects way tags received as strings.
+    struct WayTagCollector
+    {
+        std::vector<std::string> tags;
+
+        void visitNode(std::uint64_t, utymap::GeoCoordinate&, Tags&) { }
+        void visitWay(std::uint64_t, std::vector<std::uint64_t>&, Tags& wayTags)
+        {
+            for (const auto& tag : wayTags)
+                tags.push_back(tag.key + "=" + tag.value);
+        }
+        void visitRelation(std::uint64_t, RelationMembers&, Tags&) { }
+    };
+
+    /// Collects way tags received as string ids.
+    struct WayTagIdCollector
+    {
+        utymap::index::StringTable& stringTable;
+        std::vector<std::string> tags;
+
+        std::vector<std::uint32_t> getStringIds(const std::vector<const char*>& strings)
+        {
+            return stringTable.getIds(strings);
+        }
+
+        void visitNode(std::uint64_t, utymap::GeoCoordinate&, std::vector<utymap::entities::Tag>&) { }
+        void visitWay(std::uint64_t, std::vector<std::uint64_t>&, std::vector<utymap::entities::Tag>& wayTags)
+        {
+            for (const auto& tag : wayTags)
+                tags.push_back(stringTable.getString(tag.key) + "=" + stringTable.getString(tag.value));
+        }
+        void visitRelation(std::uint64_t, RelationMembers&, std::vector<utymap::entities::Tag>&) { }
+    };
+
+    /// Records strings which are mapped to ids and strings of visited tags. Node tags are skipped.
+    struct MappedStringCollector
+    {
+        utymap::index::StringTable& stringTable;
+        std::set<std::string> mapped;
+        std::set<std::string> used;
+
+        std::vector<std::uint32_t> getStringIds(const std::vector<const char*>& strings)
+        {
+            mapped.insert(strings.begin(), strings.end());
+            return stringTable.getIds(strings);
+        }
+
+        bool needsTags(const utymap::GeoCoordinate&) const { return false; }
+
+        void visitNode(std::uint64_t, utymap::GeoCoordinate&, std::vector<utymap::entities::Tag>& tags)
+        {
+            BOOST_CHECK(tags.empty());
+        }
+        void visitWay(std::uint64_t, std::vector<std::uint64_t>&, std::vector<utymap::entities::Tag>& tags) { use(tags); }
+        void visitRelation(std::uint64_t, RelationMembers&, std::vector<utymap::entities::Tag>& tags) { use(tags); }
+
+        void use(const std::vector<utymap::entities::Tag>& tags)
+        {
+            for (const auto& tag : tags) {
+                used.insert(stringTable.getString(tag.key));
+                used.insert(stringTable.getString(tag.value));
+            }
+        }
+    };
+
     struct Formats_Osm_Pbf_OsmPbfParserFixture
     {
         Formats_Osm_Pbf_OsmPbfParserFixture() :
@@ -41,4 +122,71 @@ BOOST_AUTO_TEST_CASE(GivenDefaultPbf_WhenParserParse_ThenHasExpectedElementCount
     BOOST_CHECK_EQUAL(visitor.relations, 3064);
 }
 
+BOOST_AUTO_TEST_CASE(GivenConcurrentDecoding_WhenParserParse_ThenHasExpectedElementCount)
+{
+    parser.setConcurrency(2);
+
+    parser.parse(istream, visitor);
+
+    BOOST_CHECK_EQUAL(visitor.nodes, 562170);
+    BOOST_CHECK_EQUAL(visitor.ways, 82731);
+    BOOST_CHECK_EQUAL(visitor.relations, 3064);
+}
+
+BOOST_AUTO_TEST_CASE(GivenConcurrentDecoding_WhenParserParse_ThenElementsAreVisitedInFileOrder)
+{
+    OsmPbfParser<IdCollector> sequentialParser, concurrentParser;
+    IdCollector expected, actual;
+    std::ifstream concurrentStream(TEST_PBF_FILE, std::ios::binary);
+    concurrentParser.setConcurrency(3);
+
+    sequentialParser.parse(istream, expected);
+    concurrentParser.parse(concurrentStream, actual);
+
+    BOOST_CHECK(expected.ids == actual.ids);
+}
+
+BOOST_AUTO_TEST_CASE(GivenVisitorWithStringIds_WhenParserParse_ThenTagsAreTheSameAsStrings)
+{
+    DependencyProvider dependencyProvider;
+    OsmPbfParser<WayTagCollector> stringParser;
+    OsmPbfParser<WayTagIdCollector> idParser;
+    WayTagCollector expected;
+    WayTagIdCollector actual { *dependencyProvider.getStringTable(), {} };
+    std::ifstream idStream(TEST_PBF_FILE, std::ios::binary);
+
+    stringParser.parse(istream, expected);
+    idParser.parse(idStream, actual);
+
+    std::sort(expected.tags.begin(), expected.tags.end());
+    std::sort(actual.tags.begin(), actual.tags.end());
+    BOOST_CHECK(!actual.tags.empty());
+    BOOST_CHECK(expected.tags == actual.tags);
+}
+
+BOOST_AUTO_TEST_CASE(GivenVisitorWithStringIds_WhenParserParse_ThenOnlyStringsOfVisitedTagsAreMapped)
+{
+    DependencyProvider dependencyProvider;
+    OsmPbfParser<MappedStringCollector> idParser;
+    MappedStringCollector collector { *dependencyProvider.getStringTable(), {}, {} };
+
+    idParser.parse(istream, collector);
+
+    BOOST_CHECK(!collector.used.empty());
+    BOOST_CHECK(collector.mapped == collector.used);
+}
+
+BOOST_AUTO_TEST_CASE(GivenReferenceVisitor_WhenParserParse_ThenReferencedNodesAreCollected)
+{
+    OsmPbfParser<NodeReferenceVisitor> referenceParser;
+    NodeReferenceVisitor references;
+    referenceParser.setConcurrency(2);
+
+    referenceParser.parse(istream, references);
+
+    BOOST_CHECK(references.wayNodes.size() > 0);
+    BOOST_CHECK(references.wayNodes.size() < 562170);
+    BOOST_CHECK(references.relationNodes.size() > 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
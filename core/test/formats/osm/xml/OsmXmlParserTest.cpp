@@ -5,9 +5,54 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
 using namespace utymap::formats;
 
 namespace {
+    /// Records visited elements as strings.
+    struct RecordingVisitor
+    {
+        std::vector<std::string> elements;
+
+        void visitBounds(utymap::BoundingBox) { elements.push_back("bounds"); }
+        void visitNode(std::uint64_t id, utymap::GeoCoordinate& coordinate, Tags& tags)
+        {
+            std::ostringstream stream;
+            stream << "n" << id << "(" << coordinate.latitude << "," << coordinate.longitude << ")" << toString(tags);
+            elements.push_back(stream.str());
+        }
+        void visitWay(std::uint64_t id, std::vector<std::uint64_t>& nodeIds, Tags& tags)
+        {
+            std::ostringstream stream;
+            stream << "w" << id << "(";
+            for (auto nodeId : nodeIds)
+                stream << nodeId << ";";
+            stream << ")" << toString(tags);
+            elements.push_back(stream.str());
+        }
+        void visitRelation(std::uint64_t id, RelationMembers& members, Tags& tags)
+        {
+            std::ostringstream stream;
+            stream << "r" << id << "(";
+            for (const auto& member : members)
+                stream << member.type << member.refId << ":" << member.role << ";";
+            stream << ")" << toString(tags);
+            elements.push_back(stream.str());
+        }
+
+        static std::string toString(const Tags& tags)
+        {
+            std::string result;
+            for (const auto& tag : tags)
+                result += "[" + tag.key + "=" + tag.value + "]";
+            return result;
+        }
+    };
+
     struct Formats_Osm_Xml_OsmXmlParserFixture
     {
         Formats_Osm_Xml_OsmXmlParserFixture() :
@@ -33,4 +78,37 @@ BOOST_AUTO_TEST_CASE(GivenDefaultXml_WhenParserParse_ThenHasExpectedElementCount
     BOOST_CHECK_EQUAL(92, visitor.relations);
 }
 
+BOOST_AUTO_TEST_CASE(GivenXmlWithMarkup_WhenParserParse_ThenElementsAreVisitedWithDecodedValues)
+{
+    std::istringstream xml(
+        "<?xml version='1.0' encoding='UTF-8'?>\n"
+        "<!-- comment with <node> -->\n"
+        "<osm version=\"0.6\">\n"
+        "  <bounds minlat=\"1\" minlon=\"2\" maxlat=\"3\" maxlon=\"4\"/>\n"
+        "  <node id=\"1\" lat=\"1.5\" lon='2.5'/>\n"
+        "  <node id=\"2\" lat=\"-1\" lon=\"-2\">\n"
+        "    <tag k=\"name\" v=\"A &amp; B &lt;&#65;&#x42;&gt; &quot;q&quot;\"/>\n"
+        "  </node>\n"
+        "  <way id=\"3\"><nd ref=\"1\"/><nd ref=\"2\"/><tag k=\"highway\" v=\"road\"/></way>\n"
+        "  <relation id=\"4\">\n"
+        "    <member type=\"way\" ref=\"3\" role=\"outer\"/>\n"
+        "    <member type=\"node\" ref=\"1\" role=\"\"/>\n"
+        "    <tag k=\"type\" v=\"multipolygon\"/>\n"
+        "  </relation>\n"
+        "</osm>\n");
+    OsmXmlParser<RecordingVisitor> recordingParser;
+    RecordingVisitor recorder;
+
+    recordingParser.parse(xml, recorder);
+
+    std::vector<std::string> expected = {
+        "bounds",
+        "n1(1.5,2.5)",
+        "n2(-1,-2)[name=A & B <AB> \"q\"]",
+        "w3(1;2;)[highway=road]",
+        "r4(w3:outer;n1:;)[type=multipolygon]"
+    };
+    BOOST_CHECK_EQUAL_COLLECTIONS(recorder.elements.begin(), recorder.elements.end(), expected.begin(), expected.end());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,11 @@
 #include "formats/shape/CountableShapeDataVisitor.hpp"
 
 #include <boost/test/unit_test.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
 
 using namespace utymap::formats;
 using namespace utymap::index;
@@ -10,6 +15,23 @@ using namespace utymap::index;
 namespace {
     const double Precision = 0.1e-7;
 
+    /// Records visited points with their tags.
+    struct PointCollector
+    {
+        std::vector<std::string> points;
+
+        void visitNode(utymap::GeoCoordinate& coordinate, Tags& tags)
+        {
+            std::ostringstream stream;
+            stream << coordinate.latitude << "," << coordinate.longitude;
+            for (const auto& tag : tags)
+                stream << "[" << tag.key << "=" << tag.value << "]";
+            points.push_back(stream.str());
+        }
+        void visitWay(Coordinates&, Tags&, bool) { }
+        void visitRelation(PolygonMembers&, Tags&) { }
+    };
+
     struct Formats_Shape_ShapeParserFixture
     {
         ShapeParser<CountableShapeDataVisitor> parser;
@@ -43,6 +65,49 @@ BOOST_AUTO_TEST_CASE(GivenTestPointFile_WhenParse_ThenHasCorrectTags)
     BOOST_CHECK_EQUAL(visitor.lastTags[0].value, "test4");
 }
 
+BOOST_AUTO_TEST_CASE(GivenConcurrentReading_WhenParse_ThenRecordsAreVisitedInFileOrder)
+{
+    ShapeParser<PointCollector> sequentialParser, concurrentParser;
+    PointCollector expected, actual;
+    concurrentParser.setConcurrency(3, 1);
+
+    sequentialParser.parse(TEST_SHAPE_POINT_FILE, expected);
+    concurrentParser.parse(TEST_SHAPE_POINT_FILE, actual);
+
+    BOOST_CHECK_EQUAL(expected.points.size(), 4);
+    BOOST_CHECK(expected.points == actual.points);
+}
+
+BOOST_AUTO_TEST_CASE(GivenBoundingBoxAndNoIndex_WhenParseTwice_ThenIndexIsBuiltAndOnlyIntersectingRecordsAreVisited)
+{
+    const std::string directory = "shape_index";
+    boost::filesystem::create_directory(directory);
+    for (const auto& extension : { ".shp", ".shx", ".dbf" })
+        boost::filesystem::copy_file(std::string(TEST_SHAPE_POINT_FILE) + extension, directory + "/point" + extension,
+                                     boost::filesystem::copy_option::overwrite_if_exists);
+    parser.setBoundingBox(utymap::BoundingBox(utymap::GeoCoordinate(0.6, 0.1), utymap::GeoCoordinate(1, 1.2)));
+    CountableShapeDataVisitor indexed;
+
+    parser.parse(directory + "/point", visitor);
+    bool isIndexBuilt = boost::filesystem::exists(directory + "/point.qix");
+    parser.parse(directory + "/point", indexed);
+    boost::filesystem::remove_all(directory);
+
+    BOOST_CHECK(isIndexBuilt);
+    BOOST_CHECK_EQUAL(visitor.nodes, 2);
+    BOOST_CHECK_EQUAL(indexed.nodes, 2);
+    BOOST_CHECK_CLOSE(indexed.lastCoordinate.longitude, 1.14, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenBoundingBoxAndStaleIndex_WhenParse_ThenAllIntersectingRecordsAreVisited)
+{
+    parser.setBoundingBox(utymap::BoundingBox(utymap::GeoCoordinate(-1, -2), utymap::GeoCoordinate(1, 2)));
+
+    parser.parse(TEST_SHAPE_POLY_FILE, visitor);
+
+    BOOST_CHECK_EQUAL(visitor.relations, 3);
+}
+
 BOOST_AUTO_TEST_CASE(GivenTestLineFile_WhenParse_ThenVisitsAllRecords)
 {
     parser.parse(TEST_SHAPE_LINE_FILE, visitor);
@@ -0,0 +1,81 @@
+#include "heightmap/GridElevationProvider.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap;
+using namespace utymap::heightmap;
+using namespace utymap::utils;
+
+namespace {
+    const double Precision = 1e-6;
+    const QuadKey TestQuadKey(16, 35205, 21489);
+
+    /// Provides linear relief and counts requests.
+    class LinearElevationProvider final : public ElevationProvider
+    {
+    public:
+        LinearElevationProvider() : requests(0) { }
+
+        void preload(const BoundingBox&) override { }
+
+        double getElevation(const GeoCoordinate& coordinate) const override
+        {
+            return getElevation(coordinate.latitude, coordinate.longitude);
+        }
+
+        double getElevation(double latitude, double longitude) const override
+        {
+            ++requests;
+            return 1000 * latitude - 500 * longitude;
+        }
+
+        void getElevations(const double* points, std::size_t count, double* elevations) const override
+        {
+            ElevationProvider::getElevations(points, count, elevations);
+            requests -= count - 1;
+        }
+
+        mutable std::size_t requests;
+    };
+}
+
+BOOST_AUTO_TEST_SUITE(Heightmap_GridElevationProvider)
+
+BOOST_AUTO_TEST_CASE(GivenPointInsideGrid_WhenGetElevation_ThenSourceIsNotQueried)
+{
+    LinearElevationProvider source;
+    BoundingBox bbox = GeoUtils::quadKeyToBoundingBox(TestQuadKey);
+    GridElevationProvider grid(source, bbox, TestQuadKey.levelOfDetail);
+    GeoCoordinate point(bbox.minPoint.latitude * 0.3 + bbox.maxPoint.latitude * 0.7,
+                        bbox.minPoint.longitude * 0.6 + bbox.maxPoint.longitude * 0.4);
+
+    double ele = grid.getElevation(point);
+
+    BOOST_CHECK_EQUAL(source.requests, 1);
+    BOOST_CHECK_CLOSE(ele, source.getElevation(point), Precision);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPointOutsideGrid_WhenGetElevation_ThenSourceIsQueried)
+{
+    LinearElevationProvider source;
+    BoundingBox bbox = GeoUtils::quadKeyToBoundingBox(TestQuadKey);
+    GridElevationProvider grid(source, bbox, TestQuadKey.levelOfDetail);
+    GeoCoordinate point(bbox.maxPoint.latitude + 0.01, bbox.maxPoint.longitude);
+
+    double ele = grid.getElevation(point);
+
+    BOOST_CHECK_EQUAL(source.requests, 2);
+    BOOST_CHECK_CLOSE(ele, 1000 * point.latitude - 500 * point.longitude, Precision);
+}
+
+BOOST_AUTO_TEST_CASE(GivenLevelsOfDetail_WhenCreateGrid_ThenResolutionIsBounded)
+{
+    LinearElevationProvider source;
+    BoundingBox bbox = GeoUtils::quadKeyToBoundingBox(TestQuadKey);
+
+    BOOST_CHECK_EQUAL(GridElevationProvider(source, bbox, 1).getResolution(), 257);
+    BOOST_CHECK_EQUAL(GridElevationProvider(source, bbox, 19).getResolution(), 17);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,116 @@
+#include "heightmap/PyramidElevationProvider.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::heightmap;
+using namespace utymap::utils;
+
+namespace {
+    const QuadKey ParentQuadKey(9, 275, 167);
+    const QuadKey ChildQuadKey(10, 550, 334);
+
+    /// Provides smooth relief with large elevation range.
+    class ReliefElevationProvider final : public ElevationProvider
+    {
+    public:
+        void preload(const BoundingBox&) override { }
+
+        double getElevation(const GeoCoordinate& coordinate) const override
+        {
+            return getElevation(coordinate.latitude, coordinate.longitude);
+        }
+
+        double getElevation(double latitude, double longitude) const override
+        {
+            return 4000 * std::sin(latitude * 10) + 300 * longitude;
+        }
+    };
+
+    struct Heightmap_PyramidElevationProviderFixture
+    {
+        ~Heightmap_PyramidElevationProviderFixture()
+        {
+            for (const auto& quadKey : { ParentQuadKey, ChildQuadKey })
+                std::remove((GeoUtils::quadKeyToString(quadKey) + ".ele").c_str());
+        }
+
+        ReliefElevationProvider source;
+    };
+
+    GeoCoordinate getCenter(const QuadKey& quadKey)
+    {
+        BoundingBox bbox = GeoUtils::quadKeyToBoundingBox(quadKey);
+        return GeoCoordinate((bbox.minPoint.latitude + bbox.maxPoint.latitude) / 2,
+                             (bbox.minPoint.longitude + bbox.maxPoint.longitude) / 2);
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(Heightmap_PyramidElevationProvider, Heightmap_PyramidElevationProviderFixture)
+
+BOOST_AUTO_TEST_CASE(GivenTile_WhenGetElevation_ThenReturnsCloseToSource)
+{
+    PyramidElevationProvider::buildTile(source, ChildQuadKey, "");
+    PyramidElevationProvider eleProvider("", ChildQuadKey.levelOfDetail);
+    GeoCoordinate center = getCenter(ChildQuadKey);
+
+    double ele = eleProvider.getElevation(center);
+
+    BOOST_CHECK_CLOSE(ele, source.getElevation(center), 0.1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTile_WhenGetElevations_ThenReturnsSameValuesAsSingleCalls)
+{
+    PyramidElevationProvider::buildTile(source, ChildQuadKey, "");
+    PyramidElevationProvider eleProvider("", ChildQuadKey.levelOfDetail);
+    GeoCoordinate center = getCenter(ChildQuadKey);
+    std::vector<double> points;
+    for (int i = 0; i < 50; ++i) {
+        points.push_back(center.longitude + i * 0.0011);
+        points.push_back(center.latitude + i * 0.0007);
+    }
+    std::vector<double> elevations(points.size() / 2);
+
+    eleProvider.getElevations(points.data(), elevations.size(), elevations.data());
+
+    for (std::size_t i = 0; i < elevations.size(); ++i)
+        BOOST_CHECK_EQUAL(elevations[i], eleProvider.getElevation(points[i * 2 + 1], points[i * 2]));
+}
+
+BOOST_AUTO_TEST_CASE(GivenOnlyParentTile_WhenGetElevation_ThenParentTileIsUsed)
+{
+    PyramidElevationProvider::buildTile(source, ParentQuadKey, "");
+    PyramidElevationProvider eleProvider("", ChildQuadKey.levelOfDetail);
+    GeoCoordinate center = getCenter(ChildQuadKey);
+
+    double ele = eleProvider.getElevation(center);
+
+    BOOST_CHECK_CLOSE(ele, source.getElevation(center), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNoTiles_WhenGetElevation_ThenReturnsZero)
+{
+    PyramidElevationProvider eleProvider("missing/", ChildQuadKey.levelOfDetail);
+
+    BOOST_CHECK_EQUAL(eleProvider.getElevation(getCenter(ChildQuadKey)), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCorruptedTile_WhenGetElevation_ThenThrowsDomainError)
+{
+    std::ofstream file(GeoUtils::quadKeyToString(ChildQuadKey) + ".ele", std::ios::binary | std::ios::trunc);
+    file << "corrupted";
+    file.close();
+    PyramidElevationProvider eleProvider("", ChildQuadKey.levelOfDetail);
+
+    BOOST_CHECK_THROW(eleProvider.getElevation(getCenter(ChildQuadKey)), std::domain_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
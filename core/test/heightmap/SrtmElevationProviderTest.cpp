@@ -3,9 +3,38 @@
 #include "config.hpp"
 #include <boost/test/unit_test.hpp>
 
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <string>
+#include <vector>
+
 using namespace utymap;
 using namespace utymap::heightmap;
 
+namespace {
+    const std::vector<std::string> SyntheticCells = { "N10E010.hgt", "N10E011.hgt", "N10E012.hgt" };
+
+    /// Creates flat SRTM-3 cells in working directory.
+    struct Heightmap_SrtmElevationProviderFixture
+    {
+        Heightmap_SrtmElevationProviderFixture()
+        {
+            for (const auto& name : SyntheticCells) {
+                std::ofstream file(name, std::ios::binary | std::ios::trunc);
+                file.seekp(1201 * 1201 * 2 - 1);
+                file.put(0);
+            }
+        }
+
+        ~Heightmap_SrtmElevationProviderFixture()
+        {
+            for (const auto& name : SyntheticCells)
+                std::remove(name.c_str());
+        }
+    };
+}
+
 BOOST_AUTO_TEST_SUITE(Heightmap_SrtmElevationProvider)
 
 BOOST_AUTO_TEST_CASE(GivenTestLocation_WhenGetElevation_ThenReturnExpectedInteger)
@@ -18,4 +47,71 @@ BOOST_AUTO_TEST_CASE(GivenTestLocation_WhenGetElevation_ThenReturnExpectedIntege
     BOOST_CHECK_CLOSE(ele, 34.853, 0.01);
 }
 
+BOOST_AUTO_TEST_CASE(GivenTestLocations_WhenGetElevations_ThenReturnSameValuesAsSingleCalls)
+{
+    SrtmElevationProvider eleProvider(TEST_ELEVATION_DIRECTORY);
+    eleProvider.preload(BoundingBox(GeoCoordinate(52, 13), GeoCoordinate(52, 13)));
+    std::vector<double> points;
+    for (int i = 0; i < 100; ++i) {
+        points.push_back(13.3871987 + i * 0.0013);
+        points.push_back(52.5317429 + i * 0.0007);
+    }
+    std::vector<double> elevations(points.size() / 2);
+
+    eleProvider.getElevations(points.data(), elevations.size(), elevations.data());
+
+    for (std::size_t i = 0; i < elevations.size(); ++i)
+        BOOST_CHECK_EQUAL(elevations[i], eleProvider.getElevation(points[i * 2 + 1], points[i * 2]));
+}
+
+BOOST_FIXTURE_TEST_CASE(GivenCacheSize_WhenPreloadMoreCells_ThenLeastRecentlyUsedAreUnmapped, Heightmap_SrtmElevationProviderFixture)
+{
+    SrtmElevationProvider eleProvider("", 2);
+
+    eleProvider.preload(BoundingBox(GeoCoordinate(10.5, 10.5), GeoCoordinate(10.5, 10.5)));
+    eleProvider.preload(BoundingBox(GeoCoordinate(10.5, 11.5), GeoCoordinate(10.5, 11.5)));
+    eleProvider.preload(BoundingBox(GeoCoordinate(10.5, 12.5), GeoCoordinate(10.5, 12.5)));
+
+    BOOST_CHECK_EQUAL(eleProvider.getCellCount(), 2);
+    BOOST_CHECK_EQUAL(eleProvider.getElevation(10.5, 12.5), 0);
+
+    eleProvider.preload(BoundingBox(GeoCoordinate(10.5, 10.5), GeoCoordinate(10.5, 12.5)));
+
+    BOOST_CHECK_EQUAL(eleProvider.getCellCount(), 3);
+    BOOST_CHECK_EQUAL(eleProvider.getElevation(10.5, 10.5), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(GivenNoPreload_WhenGetElevation_ThenCellIsLoadedOnDemand, Heightmap_SrtmElevationProviderFixture)
+{
+    SrtmElevationProvider eleProvider("", 2);
+
+    BOOST_CHECK_EQUAL(eleProvider.getElevation(10.5, 11.5), 0);
+    BOOST_CHECK_EQUAL(eleProvider.getCellCount(), 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(GivenSeveralThreads_WhenGetElevation_ThenCellsAreSharedAndBounded, Heightmap_SrtmElevationProviderFixture)
+{
+    SrtmElevationProvider eleProvider("", 2);
+    std::vector<std::future<double>> results;
+
+    for (int i = 0; i < 8; ++i)
+        results.push_back(std::async(std::launch::async, [&eleProvider, i]() {
+            double sum = 0;
+            for (int j = 0; j < 100; ++j)
+                sum += eleProvider.getElevation(10.5, 10.5 + (i + j) % 3);
+            return sum;
+        }));
+
+    for (auto& result : results)
+        BOOST_CHECK_EQUAL(result.get(), 0);
+    BOOST_CHECK_LE(eleProvider.getCellCount(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMissingFile_WhenPreload_ThenThrowsDomainError)
+{
+    SrtmElevationProvider eleProvider("missing/");
+
+    BOOST_CHECK_THROW(eleProvider.preload(BoundingBox(GeoCoordinate(1.5, 1.5), GeoCoordinate(1.5, 1.5))), std::domain_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,172 @@
+#include "heightmap/TerrainRgbElevationProvider.hpp"
+#include "utils/MathUtils.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <zlib.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::heightmap;
+
+namespace {
+    const std::string Directory = "terrain/";
+    const int Zoom = 10;
+    const int TileX = 550, TileY = 335;
+    const int Size = 64;
+
+    /// Height of pixel center relative to test tile which changes linearly, so interpolation is exact.
+    double getHeight(double x, double y) { return 120 + 2 * x + 0.5 * y; }
+
+    void appendBigEndian(std::string& data, std::uint32_t value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8)
+            data.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+
+    void appendChunk(std::string& data, const std::string& type, const std::string& content)
+    {
+        appendBigEndian(data, static_cast<std::uint32_t>(content.size()));
+        std::string chunk = type + content;
+        data.append(chunk);
+        appendBigEndian(data, static_cast<std::uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(chunk.data()),
+                                                               static_cast<uInt>(chunk.size()))));
+    }
+
+    int paeth(int left, int up, int upLeft)
+    {
+        int p = left + up - upLeft;
+        int pa = std::abs(p - left), pb = std::abs(p - up), pc = std::abs(p - upLeft);
+        return pa <= pb && pa <= pc ? left : (pb <= pc ? up : upLeft);
+    }
+
+    /// Writes terrain-RGB png tile using all filter types.
+    void writeTile(int tileX = TileX, int tileY = TileY)
+    {
+        const int Bpp = 3, Stride = Size * Bpp;
+        std::vector<unsigned char> pixels(Stride * Size);
+        for (int y = 0; y < Size; ++y)
+            for (int x = 0; x < Size; ++x) {
+                double height = getHeight(x + (tileX - TileX) * Size, y + (tileY - TileY) * Size);
+                auto value = static_cast<std::uint32_t>(std::lround((height + 10000) * 10));
+                unsigned char* pixel = pixels.data() + y * Stride + x * Bpp;
+                pixel[0] = static_cast<unsigned char>(value >> 16);
+                pixel[1] = static_cast<unsigned char>(value >> 8);
+                pixel[2] = static_cast<unsigned char>(value);
+            }
+
+        std::string raw;
+        for (int y = 0; y < Size; ++y) {
+            int filter = y % 5;
+            raw.push_back(static_cast<char>(filter));
+            for (int i = 0; i < Stride; ++i) {
+                int current = pixels[y * Stride + i];
+                int left = i >= Bpp ? pixels[y * Stride + i - Bpp] : 0;
+                int up = y > 0 ? pixels[(y - 1) * Stride + i] : 0;
+                int upLeft = y > 0 && i >= Bpp ? pixels[(y - 1) * Stride + i - Bpp] : 0;
+                int predicted[] = { 0, left, up, (left + up) / 2, paeth(left, up, upLeft) };
+                raw.push_back(static_cast<char>((current - predicted[filter]) & 0xFF));
+            }
+        }
+
+        uLongf compressedSize = compressBound(static_cast<uLong>(raw.size()));
+        std::string compressed(compressedSize, '\0');
+        compress(reinterpret_cast<Bytef*>(&compressed[0]), &compressedSize,
+                 reinterpret_cast<const Bytef*>(raw.data()), static_cast<uLong>(raw.size()));
+        compressed.resize(compressedSize);
+
+        std::string header;
+        appendBigEndian(header, Size);
+        appendBigEndian(header, Size);
+        header.append({ 8, 2, 0, 0, 0 });
+
+        std::string png = "\x89PNG\r\n\x1A\n";
+        appendChunk(png, "IHDR", header);
+        appendChunk(png, "IDAT", compressed);
+        appendChunk(png, "IEND", "");
+
+        std::string directory = Directory + std::to_string(Zoom) + "/" + std::to_string(tileX) + "/";
+        boost::filesystem::create_directories(directory);
+        std::ofstream file(directory + std::to_string(tileY) + ".png", std::ios::out | std::ios::binary);
+        file.write(png.data(), png.size());
+    }
+
+    /// Returns coordinate of given position in pixels inside tile.
+    GeoCoordinate getCoordinate(double x, double y)
+    {
+        double tiles = std::ldexp(1., Zoom);
+        double longitude = (TileX + x / Size) / tiles * 360 - 180;
+        double n = pi - 2 * pi * (TileY + y / Size) / tiles;
+        double latitude = 180 / pi * std::atan(0.5 * (std::exp(n) - std::exp(-n)));
+        return GeoCoordinate(latitude, longitude);
+    }
+
+    struct Heightmap_TerrainRgbElevationProviderFixture
+    {
+        Heightmap_TerrainRgbElevationProviderFixture() { writeTile(); }
+
+        ~Heightmap_TerrainRgbElevationProviderFixture() { boost::filesystem::remove_all(Directory); }
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(Heightmap_TerrainRgbElevationProvider, Heightmap_TerrainRgbElevationProviderFixture)
+
+BOOST_AUTO_TEST_CASE(GivenTile_WhenGetElevation_ThenReturnsInterpolatedHeight)
+{
+    TerrainRgbElevationProvider provider(Directory, Zoom);
+
+    for (const auto& point : std::vector<std::pair<double, double>> { { 10.5, 20.5 }, { 31.25, 5.75 }, { 40, 60 } }) {
+        double elevation = provider.getElevation(getCoordinate(point.first, point.second));
+
+        BOOST_CHECK_CLOSE(elevation, getHeight(point.first - 0.5, point.second - 0.5), 0.05);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GivenPoints_WhenGetElevations_ThenMatchesSinglePointsAndDecodesTileOnce)
+{
+    TerrainRgbElevationProvider provider(Directory, Zoom);
+    std::vector<double> points;
+    for (int i = 1; i < Size; i += 7) {
+        GeoCoordinate coordinate = getCoordinate(i, Size - i);
+        points.push_back(coordinate.longitude);
+        points.push_back(coordinate.latitude);
+    }
+    std::vector<double> elevations(points.size() / 2);
+
+    provider.getElevations(points.data(), elevations.size(), elevations.data());
+
+    for (std::size_t i = 0; i < elevations.size(); ++i)
+        BOOST_CHECK_CLOSE(elevations[i], provider.getElevation(points[i * 2 + 1], points[i * 2]), 1E-9);
+    BOOST_CHECK_EQUAL(provider.getTileCount(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNeighbourTiles_WhenGetElevationNearEdges_ThenInterpolatesAcrossThem)
+{
+    writeTile(TileX + 1, TileY);
+    writeTile(TileX, TileY + 1);
+    writeTile(TileX + 1, TileY + 1);
+    TerrainRgbElevationProvider provider(Directory, Zoom);
+
+    for (const auto& point : std::vector<std::pair<double, double>> { { Size - 0.25, 20.5 }, { Size + 0.25, 20.5 },
+                                                                       { 10.5, Size - 0.1 }, { Size - 0.2, Size + 0.3 } }) {
+        double elevation = provider.getElevation(getCoordinate(point.first, point.second));
+
+        BOOST_CHECK_CLOSE(elevation, getHeight(point.first - 0.5, point.second - 0.5), 0.05);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GivenMissingTile_WhenGetElevation_ThenReturnsZero)
+{
+    TerrainRgbElevationProvider provider(Directory, Zoom);
+
+    BOOST_CHECK_EQUAL(provider.getElevation(GeoCoordinate(-33, 151)), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,76 @@
+#include "QuadKey.hpp"
+#include "index/ElementIdIndex.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+
+using namespace utymap;
+using namespace utymap::index;
+
+namespace {
+    const std::string IndexPath = "ids_test.idx";
+
+    struct Index_ElementIdIndexFixture
+    {
+        ~Index_ElementIdIndexFixture()
+        {
+            std::remove(IndexPath.c_str());
+        }
+
+        ElementIdIndex idIndex;
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(Index_ElementIdIndex, Index_ElementIdIndexFixture)
+
+BOOST_AUTO_TEST_CASE(GivenElementInSeveralQuadKeys_WhenFind_ThenQuadKeysAreOrderedByLevelOfDetail)
+{
+    idIndex.add(7, QuadKey(2, 1, 1));
+    idIndex.add(7, QuadKey(1, 0, 0));
+    idIndex.add(8, QuadKey(1, 1, 0));
+    idIndex.add(7, QuadKey(1, 0, 0));
+
+    auto quadKeys = idIndex.find(7);
+
+    BOOST_REQUIRE_EQUAL(quadKeys.size(), 2);
+    BOOST_CHECK(quadKeys[0] == QuadKey(1, 0, 0));
+    BOOST_CHECK(quadKeys[1] == QuadKey(2, 1, 1));
+    BOOST_CHECK(idIndex.find(9).empty());
+    BOOST_CHECK_EQUAL(idIndex.size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRemovedAndStoredAgainElement_WhenFind_ThenOnlyLatestQuadKeysAreReturned)
+{
+    idIndex.add(7, QuadKey(1, 0, 0));
+    idIndex.add(7, QuadKey(1, 1, 0));
+    BOOST_CHECK_EQUAL(idIndex.find(7).size(), 2);
+
+    idIndex.remove(7, QuadKey(1, 0, 0));
+    idIndex.remove(7, QuadKey(1, 1, 0));
+    idIndex.add(7, QuadKey(1, 1, 0));
+    auto quadKeys = idIndex.find(7);
+
+    BOOST_REQUIRE_EQUAL(quadKeys.size(), 1);
+    BOOST_CHECK(quadKeys[0] == QuadKey(1, 1, 0));
+}
+
+BOOST_AUTO_TEST_CASE(GivenIndex_WhenWriteAndRead_ThenQuadKeysAreRestored)
+{
+    idIndex.add(1, QuadKey(1, 0, 0));
+    idIndex.add(300000000000, QuadKey(16, 35205, 21489));
+    idIndex.add(5, QuadKey(3, 2, 1));
+    idIndex.write(IndexPath);
+
+    ElementIdIndex restored;
+    BOOST_REQUIRE(restored.read(IndexPath));
+    restored.add(2, QuadKey(1, 1, 1));
+
+    BOOST_CHECK_EQUAL(restored.size(), 4);
+    BOOST_REQUIRE_EQUAL(restored.find(300000000000).size(), 1);
+    BOOST_CHECK(restored.find(300000000000)[0] == QuadKey(16, 35205, 21489));
+    BOOST_CHECK(restored.find(5)[0] == QuadKey(3, 2, 1));
+    BOOST_CHECK(!restored.read("missing.idx"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,10 +4,18 @@
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
+#include "index/ElementGeometryClipper.hpp"
 #include "index/ElementStore.hpp"
+#include "utils/GeometryUtils.hpp"
 
 #include <boost/test/unit_test.hpp>
 
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <set>
+#include <tuple>
+
 #include "test_utils/DependencyProvider.hpp"
 #include "test_utils/ElementUtils.hpp"
 
@@ -39,11 +47,13 @@ namespace {
 
     protected:
 
-        void storeImpl(const Element& element, const QuadKey& quadKey) override
+        void storeImpl(const Element& element, const QuadKey& quadKey, const Style&) override
         {
             times++;
             function_(element, quadKey);
         }
+
+        void removeImpl(std::uint64_t, const QuadKey&) override { }
     private:
         StoreCallback function_;
     };
@@ -81,10 +91,10 @@ BOOST_AUTO_TEST_CASE(GivenWayIntersectsTwoTilesOnce_WhenStore_GeometryIsClipped)
     TestElementStore elementStore(*dependencyProvider.getStringTable(),
         [&](const Element& element, const QuadKey& quadKey) {
         if (checkQuadKey(quadKey, 1, 0, 0)) {
-            checkGeometry<Way>(static_cast<const Way&>(element), { { 10, -10 }, { 10, 0 } });
+            checkGeometry<Way>(static_cast<const Way&>(element), { { 10, 0 }, { 10, -10 } });
         }
         else if (checkQuadKey(quadKey, 1, 1, 0)) {
-            checkGeometry<Way>(static_cast<const Way&>(element), { { 10, 0 }, { 10, 10 } });
+            checkGeometry<Way>(static_cast<const Way&>(element), { { 10, 10 }, { 10, 0 } });
         }
         else {
             BOOST_FAIL("Unexpected quadKey!");
@@ -105,13 +115,13 @@ BOOST_AUTO_TEST_CASE(GivenWayIntersectsTwoTilesTwice_WhenStore_GeometryIsClipped
     TestElementStore elementStore(*dependencyProvider.getStringTable(),
         [&](const Element& element, const QuadKey& quadKey) {
         if (checkQuadKey(quadKey, 1, 0, 0)) {
-            checkGeometry<Way>(static_cast<const Way&>(element), { { 20, 0 }, { 20, -10 }, { 10, -10 }, { 10, 0 } });
+            checkGeometry<Way>(static_cast<const Way&>(element), { { 10, 0 }, { 10, -10 }, { 20, -10 }, { 20, 0 } });
         }
         else if (checkQuadKey(quadKey, 1, 1, 0)) {
             const Relation& relation = static_cast<const Relation&>(element);
             BOOST_CHECK_EQUAL(relation.elements.size(), 2);
-            checkGeometry<Way>(static_cast<const Way&>(*relation.elements[0]), { { 20, 10 }, { 20, 0 } });
-            checkGeometry<Way>(static_cast<const Way&>(*relation.elements[1]), { { 10, 0 }, { 10, 10 } });
+            checkGeometry<Way>(static_cast<const Way&>(*relation.elements[0]), { { 10, 10 }, { 10, 0 } });
+            checkGeometry<Way>(static_cast<const Way&>(*relation.elements[1]), { { 20, 0 }, { 20, 10 } });
         }
         else {
             BOOST_FAIL("Unexpected quadKey!");
@@ -158,10 +168,10 @@ BOOST_AUTO_TEST_CASE(GivenAreaIntersectsTwoTilesOnce_WhenStore_GeometryIsClipped
     TestElementStore elementStore(*dependencyProvider.getStringTable(),
         [&](const Element& element, const QuadKey& quadKey) {
         if (checkQuadKey(quadKey, 1, 0, 0)) {
-            checkGeometry<Area>(static_cast<const Area&>(element), { { 20, 0 }, { 20, -10 }, { 10, -10 }, { 10, 0 } });
+            checkGeometry<Area>(static_cast<const Area&>(element), { { 10, 0 }, { 20, 0 }, { 20, -10 }, { 10, -10 } });
         }
         else if (checkQuadKey(quadKey, 1, 1, 0)) {
-            checkGeometry<Area>(static_cast<const Area&>(element), { { 20, 10 }, { 20, 0 }, { 10, 0 }, { 10, 10 } });
+            checkGeometry<Area>(static_cast<const Area&>(element), { { 10, 0 }, { 10, 10 }, { 20, 10 }, { 20, 0 } });
         }
         else {
             BOOST_FAIL("Unexpected quadKey!");
@@ -303,6 +313,47 @@ BOOST_AUTO_TEST_CASE(GivenWay_WhenStoreInsideQuadKey_IsStored)
     BOOST_CHECK_EQUAL(elementStore.times, 1);
 }
 
+BOOST_AUTO_TEST_CASE(GivenWayInsideQuadKey_WhenStoreWithClip_ElementIsNotCopied)
+{
+    Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 0,
+    { { "test", "Foo" } }, { { 5, 5 }, { 10, 10 } });
+    TestElementStore elementStore(*dependencyProvider.getStringTable(),
+        [&](const Element& element, const QuadKey& quadKey) {
+        BOOST_CHECK_EQUAL(&element, &way);
+    });
+
+    elementStore.store(way, LodRange(1, 1),
+        *dependencyProvider.getStyleProvider("way|z1[test=Foo] { key:val; clip: true;}"));
+
+    BOOST_CHECK_EQUAL(elementStore.times, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTriangleCrossingCorner_WhenStore_AreaIsClippedCounterclockwise)
+{
+    Area area = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 0,
+    { { "test", "Foo" } },
+    { { 10, -10 }, { 10, 10 }, { -10, 10 } });
+    TestElementStore elementStore(*dependencyProvider.getStringTable(),
+        [&](const Element& element, const QuadKey& quadKey) {
+        const auto& coordinates = static_cast<const Area&>(element).coordinates;
+        BOOST_CHECK(!utymap::utils::isClockwise(coordinates));
+        if (checkQuadKey(quadKey, 1, 1, 0)) {
+            BOOST_CHECK_EQUAL(coordinates.size(), 4);
+        }
+        else if (checkQuadKey(quadKey, 1, 0, 0) || checkQuadKey(quadKey, 1, 1, 1)) {
+            BOOST_CHECK_EQUAL(coordinates.size(), 3);
+        }
+        else {
+            BOOST_FAIL("Unexpected quadKey!");
+        }
+    });
+
+    elementStore.store(area, LodRange(1, 1),
+        *dependencyProvider.getStyleProvider("area|z1[test=Foo] { key:val; clip: true;}"));
+
+    BOOST_CHECK_EQUAL(elementStore.times, 3);
+}
+
 BOOST_AUTO_TEST_CASE(GivenWayWithSmallSize_WhenStore_IsSkipped)
 {
     Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 0,
@@ -329,4 +380,145 @@ BOOST_AUTO_TEST_CASE(GivenWayWithLargeSize_WhenStore_IsStored)
     BOOST_CHECK_EQUAL(elementStore.times, 1);
 }
 
+BOOST_AUTO_TEST_CASE(GivenAreaInManyTilesAndConcurrency_WhenStore_ThenStoredInSameTilesAsSequentially)
+{
+    Area area = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 0,
+        { { "test", "Foo" } }, { { 10, 10 }, { 10, 40 }, { 40, 40 }, { 40, 10 } });
+    auto styleProvider = dependencyProvider.getStyleProvider("area|z6[test=Foo] { key:val; clip: true;}");
+    std::mutex lock;
+    std::set<std::pair<int, int>> expected, actual;
+    TestElementStore sequentialStore(*dependencyProvider.getStringTable(),
+        [&](const Element&, const QuadKey& quadKey) { expected.insert(std::make_pair(quadKey.tileX, quadKey.tileY)); });
+    TestElementStore concurrentStore(*dependencyProvider.getStringTable(),
+        [&](const Element&, const QuadKey& quadKey) {
+            std::lock_guard<std::mutex> guard(lock);
+            actual.insert(std::make_pair(quadKey.tileX, quadKey.tileY));
+        });
+    concurrentStore.setConcurrency(4);
+
+    sequentialStore.store(area, LodRange(6, 6), *styleProvider);
+    concurrentStore.store(area, LodRange(6, 6), *styleProvider);
+
+    BOOST_CHECK(expected.size() > 8);
+    BOOST_CHECK(expected == actual);
+}
+
+BOOST_AUTO_TEST_CASE(GivenWayInLodRange_WhenStore_EveryLevelIsClipped)
+{
+    Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 0,
+        { { "test", "Foo" } }, { { 10, 10 }, { 10, -10 } });
+    TestElementStore elementStore(*dependencyProvider.getStringTable(),
+        [&](const Element& element, const QuadKey& quadKey) {
+        if (checkQuadKey(quadKey, 1, 0, 0) || checkQuadKey(quadKey, 2, 1, 1)) {
+            checkGeometry<Way>(static_cast<const Way&>(element), { { 10, 0 }, { 10, -10 } });
+        }
+        else if (checkQuadKey(quadKey, 1, 1, 0) || checkQuadKey(quadKey, 2, 2, 1)) {
+            checkGeometry<Way>(static_cast<const Way&>(element), { { 10, 10 }, { 10, 0 } });
+        }
+        else {
+            BOOST_FAIL("Unexpected quadKey!");
+        }
+    });
+
+    elementStore.store(way, LodRange(1, 2),
+        *dependencyProvider.getStyleProvider("way|z1-2[test=Foo] { key:val; clip: true;}"));
+
+    BOOST_CHECK_EQUAL(elementStore.times, 4);
+}
+
+BOOST_AUTO_TEST_CASE(GivenAreaInManyLevels_WhenStore_ThenStoredInSameTilesAsClippedSeparately)
+{
+    Area area = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 0,
+        { { "test", "Foo" } }, { { 10, 10 }, { 10, 40 }, { 40, 40 }, { 40, 10 } });
+    auto styleProvider = dependencyProvider.getStyleProvider("area|z4-6[test=Foo] { key:val; clip: true;}");
+    std::map<std::tuple<int, int, int>, std::size_t> expected, actual;
+    TestElementStore elementStore(*dependencyProvider.getStringTable(),
+        [&](const Element& element, const QuadKey& quadKey) {
+            actual[std::make_tuple(quadKey.levelOfDetail, quadKey.tileX, quadKey.tileY)] =
+                static_cast<const Area&>(element).coordinates.size();
+        });
+    ElementGeometryClipper clipper([&](const Element& element, const QuadKey& quadKey) {
+        expected[std::make_tuple(quadKey.levelOfDetail, quadKey.tileX, quadKey.tileY)] =
+            static_cast<const Area&>(element).coordinates.size();
+    });
+
+    elementStore.store(area, LodRange(4, 6), *styleProvider);
+    for (int lod = 4; lod <= 6; ++lod) {
+        utymap::utils::GeoUtils::visitTileRange(utymap::BoundingBox(GeoCoordinate(10, 10), GeoCoordinate(40, 40)), lod,
+            [&](const QuadKey& quadKey, const BoundingBox& quadKeyBbox) { clipper.clipAndCall(area, quadKey, quadKeyBbox); });
+    }
+
+    BOOST_CHECK(expected.size() > 20);
+    BOOST_CHECK(expected == actual);
+}
+
+BOOST_AUTO_TEST_CASE(GivenWayInManyTiles_WhenStoreInQuadKey_OnlyThisQuadKeyIsStored)
+{
+    Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 0,
+        { { "test", "Foo" } }, { { 10, 10 }, { 10, 40 } });
+    TestElementStore elementStore(*dependencyProvider.getStringTable(),
+        [&](const Element& element, const QuadKey& quadKey) {
+        BOOST_CHECK(checkQuadKey(quadKey, 5, 17, 15));
+    });
+
+    elementStore.store(way, QuadKey(5, 17, 15),
+        *dependencyProvider.getStyleProvider("way|z5[test=Foo] { key:val; clip: true;}"));
+
+    BOOST_CHECK_EQUAL(elementStore.times, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenWayWithSimplification_WhenStoreInLodRange_ThenOnlyLowLevelIsSimplified)
+{
+    Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 0,
+        { { "test", "Foo" } }, { { 10, 0.1 }, { 10.3, 0.5 }, { 10, 0.9 } });
+    std::map<int, std::size_t> sizes;
+    TestElementStore elementStore(*dependencyProvider.getStringTable(),
+        [&](const Element& element, const QuadKey& quadKey) {
+            sizes[quadKey.levelOfDetail] = static_cast<const Way&>(element).coordinates.size();
+        });
+
+    elementStore.store(way, LodRange(1, 8),
+        *dependencyProvider.getStyleProvider("way|z1-8[test=Foo] { simplify: 1%; }"));
+
+    BOOST_CHECK_EQUAL(sizes[1], 2);
+    BOOST_CHECK_EQUAL(sizes[8], 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenClippedAreaWithSimplification_WhenStore_ThenSimplifiedAreaIsStored)
+{
+    Area area = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 0,
+        { { "test", "Foo" } }, { { 10, 10 }, { 10.2, 25 }, { 10, 40 }, { 40, 40 }, { 40, 10 } });
+    TestElementStore elementStore(*dependencyProvider.getStringTable(),
+        [&](const Element& element, const QuadKey& quadKey) {
+            BOOST_CHECK(checkQuadKey(quadKey, 1, 1, 0));
+            checkGeometry<Area>(static_cast<const Area&>(element), { { 10, 10 }, { 10, 40 }, { 40, 40 }, { 40, 10 } });
+        });
+
+    elementStore.store(area, LodRange(1, 1),
+        *dependencyProvider.getStyleProvider("area|z1[test=Foo] { clip: true; simplify: 1%; }"));
+
+    BOOST_CHECK_EQUAL(elementStore.times, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenClippedAreaWithSplitVertices_WhenStore_ThenPiecesAreStoredAsRelation)
+{
+    Area area = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 1, { { "test", "Foo" } });
+    for (int i = 0; i < 100; ++i) {
+        double angle = 2 * std::acos(-1) * i / 100;
+        area.coordinates.push_back(GeoCoordinate(40 + 30 * std::sin(angle), 90 + 30 * std::cos(angle)));
+    }
+    TestElementStore elementStore(*dependencyProvider.getStringTable(),
+        [&](const Element& element, const QuadKey& quadKey) {
+            BOOST_CHECK(checkQuadKey(quadKey, 1, 1, 0));
+            BOOST_REQUIRE(element.type == ElementType::Relation);
+            BOOST_CHECK_EQUAL(element.id, 1);
+            BOOST_CHECK_GT(static_cast<const Relation&>(element).elements.size(), 1);
+        });
+
+    elementStore.store(area, LodRange(1, 1),
+        *dependencyProvider.getStyleProvider("area|z1[test=Foo] { clip: true; split-vertices: 30; }"));
+
+    BOOST_CHECK_EQUAL(elementStore.times, 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,619 @@
+#include "QuadKey.hpp"
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "index/GeoStore.hpp"
+#include "index/InMemoryElementStore.hpp"
+#include "formats/osm/OsmElementId.hpp"
+#include "index/SearchControl.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+
+#include "config.hpp"
+#include "test_utils/DependencyProvider.hpp"
+#include "test_utils/ElementUtils.hpp"
+
+using namespace utymap;
+using namespace utymap::entities;
+using namespace utymap::index;
+using namespace utymap::mapcss;
+
+namespace {
+    const std::string stylesheet = "node|z1[any],way|z1[any] { clip: false; }";
+
+    struct Index_GeoStoreFixture
+    {
+        Index_GeoStoreFixture() :
+            dependencyProvider(),
+            geoStore(*dependencyProvider.getStringTable())
+        {
+        }
+
+        void addNode(const std::string& storeKey, std::uint64_t id, const GeoCoordinate& coordinate = { 5, -5 })
+        {
+            Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), id,
+                { { "any", "true" } });
+            node.coordinate = coordinate;
+            geoStore.add(storeKey, node, LodRange(1, 1), *dependencyProvider.getStyleProvider(stylesheet));
+        }
+
+        DependencyProvider dependencyProvider;
+        GeoStore geoStore;
+    };
+
+    /// Keeps ids of committed elements and fails when given amount of elements is stored.
+    class FailingElementStore final : public ElementStore
+    {
+    public:
+        FailingElementStore(StringTable& stringTable, std::vector<std::uint64_t>& committed, std::size_t failAfter) :
+            ElementStore(stringTable), committed_(committed), pending_(), failAfter_(failAfter), stored_(0)
+        {
+        }
+
+        void search(const QuadKey&, ElementVisitor&) override { }
+        bool hasData(const QuadKey&) const override { return false; }
+
+        void commit() override
+        {
+            committed_.insert(committed_.end(), pending_.begin(), pending_.end());
+            pending_.clear();
+        }
+
+    protected:
+        void storeImpl(const Element& element, const QuadKey&, const Style&) override
+        {
+            // NOTE pending elements are lost by failure as they are not committed.
+            if (stored_++ == failAfter_) {
+                pending_.clear();
+                throw std::domain_error("Store failed.");
+            }
+            pending_.push_back(element.id);
+        }
+
+        void removeImpl(std::uint64_t, const QuadKey&) override { }
+
+    private:
+        std::vector<std::uint64_t>& committed_;
+        std::vector<std::uint64_t> pending_;
+        const std::size_t failAfter_;
+        std::size_t stored_;
+    };
+
+    /// Counts compactions.
+    class CompactingElementStore final : public ElementStore
+    {
+    public:
+        CompactingElementStore(StringTable& stringTable, int& compactions) :
+            ElementStore(stringTable), compactions_(compactions)
+        {
+        }
+
+        void search(const QuadKey&, ElementVisitor&) override { }
+        bool hasData(const QuadKey&) const override { return false; }
+        void commit() override { }
+        void compact() override { ++compactions_; }
+
+    protected:
+        void storeImpl(const Element&, const QuadKey&, const Style&) override { }
+        void removeImpl(std::uint64_t, const QuadKey&) override { }
+
+    private:
+        int& compactions_;
+    };
+
+    struct IdCollector : public ElementVisitor
+    {
+        std::vector<std::uint64_t> ids;
+
+        void visitNode(const Node& node) override { ids.push_back(node.id); }
+        void visitWay(const Way& way) override { ids.push_back(way.id); }
+        void visitArea(const Area& area) override { ids.push_back(area.id); }
+        void visitRelation(const Relation& relation) override { ids.push_back(relation.id); }
+    };
+
+    /// Returns names of import checkpoint and snapshot files in current directory.
+    std::vector<std::string> getCheckpointFiles()
+    {
+        std::vector<std::string> files;
+        for (boost::filesystem::directory_iterator end, it("."); it != end; ++it) {
+            std::string name = it->path().filename().string();
+            std::string extension = it->path().extension().string();
+            if (name.compare(0, 7, "import.") == 0 && (extension == ".chk" || extension == ".uts"))
+                files.push_back(name);
+        }
+        return files;
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(Index_GeoStore, Index_GeoStoreFixture)
+
+BOOST_AUTO_TEST_CASE(GivenParallelSearch_WhenSearchMultipleStores_ThenElementsAreVisitedInStoreOrder)
+{
+    for (const auto& storeKey : { "a", "b", "c" })
+        geoStore.registerStore(storeKey,
+            utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    addNode("c", 3);
+    addNode("a", 1);
+    addNode("b", 2);
+    geoStore.setParallelSearch(true);
+    IdCollector collector;
+    std::vector<std::uint64_t> expected = { 1, 2, 3 };
+
+    geoStore.search(utymap::utils::GeoUtils::latLonToQuadKey({ 5, -5 }, 1),
+                    *dependencyProvider.getStyleProvider(stylesheet), collector);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(collector.ids.begin(), collector.ids.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenSameElementInMultipleStores_WhenSearch_ThenElementIsVisitedOnce)
+{
+    for (const auto& storeKey : { "a", "b" })
+        geoStore.registerStore(storeKey,
+            utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    addNode("a", 1);
+    addNode("b", 1);
+    addNode("b", 2);
+    IdCollector collector;
+    std::vector<std::uint64_t> expected = { 1, 2 };
+
+    geoStore.search(utymap::utils::GeoUtils::latLonToQuadKey({ 5, -5 }, 1),
+                    *dependencyProvider.getStyleProvider(stylesheet), collector);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(collector.ids.begin(), collector.ids.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenNestedSearch_WhenSearchSameTile_ThenOuterSearchStillVisitsElementOnce)
+{
+    for (const auto& storeKey : { "a", "b" })
+        geoStore.registerStore(storeKey,
+            utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    addNode("a", 1);
+    addNode("b", 1);
+    addNode("b", 2);
+    QuadKey quadKey = utymap::utils::GeoUtils::latLonToQuadKey({ 5, -5 }, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    struct NestedSearchVisitor : public IdCollector
+    {
+        std::function<void()> search;
+        void visitNode(const Node& node) override
+        {
+            IdCollector::visitNode(node);
+            if (search != nullptr) {
+                auto action = search;
+                search = nullptr;
+                action();
+            }
+        }
+    };
+    NestedSearchVisitor visitor;
+    IdCollector inner;
+    visitor.search = [&]() { geoStore.search(quadKey, *styleProvider, inner); };
+    std::vector<std::uint64_t> expected = { 1, 2 };
+
+    geoStore.search(quadKey, *styleProvider, visitor);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(visitor.ids.begin(), visitor.ids.end(), expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(inner.ids.begin(), inner.ids.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenElementsInMultipleStores_WhenSearchWithLimit_ThenSearchStopsAfterLimit)
+{
+    for (const auto& storeKey : { "a", "b" })
+        geoStore.registerStore(storeKey,
+            utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    addNode("a", 1);
+    addNode("a", 2);
+    addNode("b", 3);
+    IdCollector collector;
+    LimitedElementVisitor limited(collector, 1);
+    std::vector<std::uint64_t> expected = { 1 };
+
+    geoStore.search(utymap::utils::GeoUtils::latLonToQuadKey({ 5, -5 }, 1),
+                    *dependencyProvider.getStyleProvider(stylesheet), limited);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(collector.ids.begin(), collector.ids.end(), expected.begin(), expected.end());
+    BOOST_CHECK(limited.isStopped());
+}
+
+BOOST_AUTO_TEST_CASE(GivenParallelSearchWithLimit_WhenSearchMultipleStores_ThenStoreSearchesStopAfterLimit)
+{
+    for (const auto& storeKey : { "a", "b" })
+        geoStore.registerStore(storeKey,
+            utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    addNode("a", 1);
+    for (std::uint64_t id = 1; id <= 4; ++id)
+        addNode("b", id);
+    geoStore.setParallelSearch(true);
+    IdCollector collector;
+    LimitedElementVisitor limited(collector, 3);
+    std::vector<std::uint64_t> expected = { 1, 2, 3 };
+
+    geoStore.search(utymap::utils::GeoUtils::latLonToQuadKey({ 5, -5 }, 1),
+                    *dependencyProvider.getStyleProvider(stylesheet), limited);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(collector.ids.begin(), collector.ids.end(), expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(limited.getRemaining(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCancelledToken_WhenSearchRadius_ThenNothingIsVisited)
+{
+    geoStore.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    addNode("a", 1);
+    utymap::utils::CancellationToken token;
+    token.cancel();
+    IdCollector collector;
+    LimitedElementVisitor limited(collector, 10, token);
+
+    geoStore.search({ 5, -5 }, 1000, 1, *dependencyProvider.getStyleProvider(stylesheet), limited);
+
+    BOOST_CHECK(collector.ids.empty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenElementsInMultipleStores_WhenSearchRadius_ThenOnlyCloseElementsAreVisited)
+{
+    for (const auto& storeKey : { "a", "b" })
+        geoStore.registerStore(storeKey,
+            utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    addNode("a", 1, { 5, -5 });
+    addNode("a", 2, { 5.01, -5 });
+    addNode("b", 1, { 5, -5 });
+    geoStore.add("b", ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 3,
+        { { "any", "true" } }, { { 4.999, -5.01 }, { 4.999, -4.99 } }), LodRange(1, 1),
+        *dependencyProvider.getStyleProvider(stylesheet));
+    IdCollector collector;
+    std::vector<std::uint64_t> expected = { 1, 3 };
+
+    geoStore.search(GeoCoordinate(5, -5), 200, 1, *dependencyProvider.getStyleProvider(stylesheet), collector);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(collector.ids.begin(), collector.ids.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenElementsInMultipleStores_WhenSearchByTag_ThenElementsInsideBoundingBoxAreVisitedOnce)
+{
+    auto& stringTable = *dependencyProvider.getStringTable();
+    for (const auto& storeKey : { "a", "b" })
+        geoStore.registerStore(storeKey, utymap::utils::make_unique<InMemoryElementStore>(stringTable));
+    addNode("a", 1, { 5, -5 });
+    addNode("a", 2, { 50, -50 });
+    addNode("b", 1, { 5, -5 });
+    IdCollector collector;
+    std::vector<std::uint64_t> expected = { 1 };
+
+    geoStore.searchByTag(BoundingBox(GeoCoordinate(1, -10), GeoCoordinate(10, -1)), 1,
+                         { Tag(stringTable.getId("any"), stringTable.getId("true")) }, collector);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(collector.ids.begin(), collector.ids.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenWayInSeveralTiles_WhenGetElement_ThenItIsVisitedOnceTillRemoved)
+{
+    geoStore.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    addNode("a", 1);
+    geoStore.add("a", ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 3,
+        { { "any", "true" } }, { { 5, -5 }, { 5, 5 } }), LodRange(1, 1),
+        *dependencyProvider.getStyleProvider(stylesheet));
+    IdCollector collector;
+    std::vector<std::uint64_t> expected = { 3 };
+
+    BOOST_CHECK(geoStore.getElement(3, 1, collector));
+    BOOST_CHECK(!geoStore.getElement(3, 2, collector));
+    BOOST_CHECK(!geoStore.getElement(4, 1, collector));
+    BOOST_CHECK_EQUAL_COLLECTIONS(collector.ids.begin(), collector.ids.end(), expected.begin(), expected.end());
+
+    geoStore.remove("a", 3, BoundingBox(GeoCoordinate(4, -6), GeoCoordinate(6, 6)), LodRange(1, 1));
+    BOOST_CHECK(!geoStore.getElement(3, 1, collector));
+}
+
+BOOST_AUTO_TEST_CASE(GivenImportPipeline_WhenAddFile_ThenAllParsedElementsAreStored)
+{
+    geoStore.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    std::vector<ImportStageStatistics> statistics;
+    geoStore.setImportPipeline(2, 1, [&](const std::vector<ImportStageStatistics>& s) { statistics = s; });
+
+    geoStore.add("a", TEST_SHAPE_LINE_FILE, LodRange(1, 1), *dependencyProvider.getStyleProvider(stylesheet));
+
+    BOOST_REQUIRE_EQUAL(statistics.size(), 2);
+    BOOST_CHECK_EQUAL(statistics[0].name, "parse");
+    BOOST_CHECK(statistics[0].elements > 0);
+    BOOST_CHECK_EQUAL(statistics[0].elements, statistics[1].elements);
+}
+
+BOOST_AUTO_TEST_CASE(GivenImportProfiling_WhenAddFile_ThenTileSizesAreReported)
+{
+    geoStore.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    std::size_t ways = 0, fragments = 0;
+    std::vector<TileImportSize> tiles;
+    std::string json;
+    geoStore.setImportProfileCallback([&](const ImportProfile& profile) {
+        ways = profile.getElementCount(ImportProfile::ElementType::Way);
+        fragments = profile.getFragmentCount(1);
+        tiles = profile.getHeaviestTiles(2);
+        json = profile.toJson(2);
+    });
+
+    geoStore.add("a", TEST_SHAPE_LINE_FILE, LodRange(1, 1), *dependencyProvider.getStyleProvider("way|z1[test=Foo] { clip: true; }"));
+
+    BOOST_CHECK(ways > 0);
+    BOOST_CHECK(fragments >= ways);
+    BOOST_REQUIRE(!tiles.empty());
+    BOOST_CHECK_EQUAL(tiles[0].quadKey.levelOfDetail, 1);
+    BOOST_CHECK(tiles[0].bytes > 0);
+    BOOST_CHECK(tiles.size() == 1 || tiles[0].bytes >= tiles[1].bytes);
+    BOOST_CHECK(json.find("\"heaviest_tiles\":[{\"lod\":1,") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSeveralFiles_WhenAddConcurrently_ThenAllElementsAreStoredWithSingleProfile)
+{
+    geoStore.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    std::vector<std::size_t> ways, nodes;
+    geoStore.setImportProfileCallback([&](const ImportProfile& profile) {
+        ways.push_back(profile.getElementCount(ImportProfile::ElementType::Way));
+        nodes.push_back(profile.getElementCount(ImportProfile::ElementType::Node));
+    });
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+
+    geoStore.add("a", TEST_SHAPE_LINE_FILE, LodRange(1, 1), *styleProvider);
+    geoStore.add("a", { TEST_SHAPE_LINE_FILE, TEST_SHAPE_POINT_FILE, TEST_SHAPE_LINE_FILE }, LodRange(1, 1), *styleProvider, 2);
+
+    BOOST_REQUIRE_EQUAL(ways.size(), 2);
+    BOOST_CHECK(ways[0] > 0);
+    BOOST_CHECK_EQUAL(ways[1], 2 * ways[0]);
+    BOOST_CHECK(nodes[1] > 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodeCoordinateFile_WhenAddSeveralOsmFilesConcurrently_ThenWaysUseNodesOfOwnFile)
+{
+    const std::vector<std::string> paths = { "first.xml", "second.xml" };
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        std::ofstream file(paths[i]);
+        file << "<osm version=\"0.6\">";
+        for (int j = 1; j <= 100; ++j)
+            file << "<node id=\"" << j << "\" lat=\"" << (i + 1) << "\" lon=\"" << -j * 0.01 << "\"/>";
+        file << "<way id=\"" << (i + 1) << "\">";
+        for (int j = 1; j <= 100; ++j)
+            file << "<nd ref=\"" << j << "\"/>";
+        file << "<tag k=\"any\" v=\"true\"/></way></osm>";
+    }
+    geoStore.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    geoStore.setNodeCoordinateFile("nodes.bin");
+    std::map<std::uint64_t, std::vector<GeoCoordinate>> ways;
+    struct WayCollector : public ElementVisitor
+    {
+        std::map<std::uint64_t, std::vector<GeoCoordinate>>& ways;
+        explicit WayCollector(std::map<std::uint64_t, std::vector<GeoCoordinate>>& ways) : ways(ways) {}
+        void visitNode(const Node&) override {}
+        void visitWay(const Way& way) override { ways[way.id] = way.coordinates; }
+        void visitArea(const Area&) override {}
+        void visitRelation(const Relation&) override {}
+    } collector(ways);
+
+    geoStore.add("a", paths, LodRange(1, 1), *dependencyProvider.getStyleProvider(stylesheet), 2);
+    geoStore.search(utymap::utils::GeoUtils::latLonToQuadKey({ 1, -0.5 }, 1),
+                    *dependencyProvider.getStyleProvider(stylesheet), collector);
+
+    BOOST_REQUIRE_EQUAL(ways.size(), 2);
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        const auto& coordinates = ways[utymap::formats::OsmElementId::way(i + 1)];
+        BOOST_REQUIRE_EQUAL(coordinates.size(), 100);
+        for (const auto& coordinate : coordinates)
+            BOOST_CHECK_CLOSE(coordinate.latitude, i + 1, 1E-6);
+        std::remove(paths[i].c_str());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GivenRegisteredStores_WhenCompactOne_ThenOnlyItIsCompactedAndVersionIsChanged)
+{
+    int compactionsA = 0, compactionsB = 0;
+    geoStore.registerStore("a", utymap::utils::make_unique<CompactingElementStore>(*dependencyProvider.getStringTable(), compactionsA));
+    geoStore.registerStore("b", utymap::utils::make_unique<CompactingElementStore>(*dependencyProvider.getStringTable(), compactionsB));
+    std::uint64_t version = geoStore.getVersion();
+
+    geoStore.compact("b");
+
+    BOOST_CHECK_EQUAL(compactionsA, 0);
+    BOOST_CHECK_EQUAL(compactionsB, 1);
+    BOOST_CHECK_NE(geoStore.getVersion(), version);
+}
+
+BOOST_AUTO_TEST_CASE(GivenInMemoryStore_WhenGetDataVersion_ThenOnlyQuadKeyWithoutDataHasIt)
+{
+    geoStore.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    addNode("a", 1);
+    std::uint64_t version;
+
+    BOOST_CHECK(!geoStore.getDataVersion(utymap::utils::GeoUtils::latLonToQuadKey({ 5, -5 }, 1), version));
+    BOOST_CHECK(geoStore.getDataVersion(utymap::utils::GeoUtils::latLonToQuadKey({ -5, 5 }, 1), version));
+}
+
+BOOST_AUTO_TEST_CASE(GivenChangeFile_WhenAdd_ThenOnlyChangedElementsAreAffected)
+{
+    const std::string changePath = "test.osc";
+    std::ofstream(changePath) <<
+        "<osmChange version=\"0.6\">"
+        "<delete><node id=\"1\" lat=\"5\" lon=\"-5\"/></delete>"
+        "<modify><node id=\"2\" lat=\"6\" lon=\"-6\"><tag k=\"any\" v=\"true\"/></node></modify>"
+        "<create>"
+        "<node id=\"4\" lat=\"7\" lon=\"-7\"><tag k=\"any\" v=\"true\"/></node>"
+        "<node id=\"5\" lat=\"8\" lon=\"-8\"/>"
+        "<way id=\"6\"><nd ref=\"4\"/><nd ref=\"5\"/><tag k=\"any\" v=\"true\"/></way>"
+        "</create>"
+        "</osmChange>";
+    geoStore.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    addNode("a", 1);
+    addNode("a", 2);
+    addNode("a", 3);
+    IdCollector collector;
+    std::vector<std::uint64_t> expected = { 2, 3, 4, utymap::formats::OsmElementId::way(6) };
+
+    geoStore.add("a", changePath, LodRange(1, 1), *dependencyProvider.getStyleProvider(stylesheet));
+    geoStore.search(utymap::utils::GeoUtils::latLonToQuadKey({ 5, -5 }, 1),
+                    *dependencyProvider.getStyleProvider(stylesheet), collector);
+
+    std::sort(collector.ids.begin(), collector.ids.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(collector.ids.begin(), collector.ids.end(), expected.begin(), expected.end());
+    std::remove(changePath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(GivenChangeFileWithWayAndNodeOfSameId_WhenAdd_ThenOnlyDeletedNodeIsRemoved)
+{
+    const std::string changePath = "test.osc";
+    std::ofstream(changePath) <<
+        "<osmChange version=\"0.6\">"
+        "<create>"
+        "<node id=\"7\" lat=\"7\" lon=\"-7\"><tag k=\"any\" v=\"true\"/></node>"
+        "<node id=\"8\" lat=\"8\" lon=\"-8\"/>"
+        "</create>"
+        "<modify><way id=\"42\"><nd ref=\"7\"/><nd ref=\"8\"/><tag k=\"any\" v=\"true\"/></way></modify>"
+        "<delete><node id=\"42\" lat=\"5\" lon=\"-5\"/></delete>"
+        "</osmChange>";
+    geoStore.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    addNode("a", 3);
+    addNode("a", 42);
+    IdCollector collector;
+    std::vector<std::uint64_t> expected = { 3, 7, utymap::formats::OsmElementId::way(42) };
+
+    geoStore.add("a", changePath, LodRange(1, 1), *dependencyProvider.getStyleProvider(stylesheet));
+    geoStore.search(utymap::utils::GeoUtils::latLonToQuadKey({ 5, -5 }, 1),
+                    *dependencyProvider.getStyleProvider(stylesheet), collector);
+
+    std::sort(collector.ids.begin(), collector.ids.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(collector.ids.begin(), collector.ids.end(), expected.begin(), expected.end());
+    std::remove(changePath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(GivenChangeFileWithWayOfStoredNode_WhenAdd_ThenWayIsBuiltWithStoredNode)
+{
+    const std::string changePath = "test.osc";
+    std::ofstream(changePath) <<
+        "<osmChange version=\"0.6\">"
+        "<create>"
+        "<node id=\"8\" lat=\"8\" lon=\"-8\"/>"
+        "<way id=\"6\"><nd ref=\"3\"/><nd ref=\"8\"/><tag k=\"any\" v=\"true\"/></way>"
+        "</create>"
+        "</osmChange>";
+    geoStore.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    addNode("a", 3, { 7, -7 });
+    IdCollector collector;
+    std::vector<std::uint64_t> expected = { 3, utymap::formats::OsmElementId::way(6) };
+
+    geoStore.add("a", changePath, LodRange(1, 1), *dependencyProvider.getStyleProvider(stylesheet));
+    geoStore.search(utymap::utils::GeoUtils::latLonToQuadKey({ 5, -5 }, 1),
+                    *dependencyProvider.getStyleProvider(stylesheet), collector);
+
+    std::sort(collector.ids.begin(), collector.ids.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(collector.ids.begin(), collector.ids.end(), expected.begin(), expected.end());
+    std::remove(changePath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodeMovedToOtherTile_WhenDeleteByChangeFile_ThenItIsRemovedFromOldTile)
+{
+    const std::string changePath = "test.osc";
+    std::ofstream(changePath) <<
+        "<osmChange version=\"0.6\">"
+        "<delete><node id=\"3\" lat=\"-5\" lon=\"5\"/></delete>"
+        "</osmChange>";
+    geoStore.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    addNode("a", 3);
+    IdCollector collector;
+
+    geoStore.add("a", changePath, LodRange(1, 1), *dependencyProvider.getStyleProvider(stylesheet));
+    geoStore.search(utymap::utils::GeoUtils::latLonToQuadKey({ 5, -5 }, 1),
+                    *dependencyProvider.getStyleProvider(stylesheet), collector);
+
+    BOOST_CHECK(collector.ids.empty());
+    std::remove(changePath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(GivenSnapshot_WhenAdd_ThenElementsAreTheSameAsFromSourceFile)
+{
+    const std::string sourcePath = "snapshot.xml";
+    const std::string snapshotPath = "snapshot.uts";
+    std::ofstream(sourcePath) <<
+        "<osm version=\"0.6\">"
+        "<node id=\"1\" lat=\"5\" lon=\"-5\"><tag k=\"any\" v=\"true\"/></node>"
+        "<node id=\"2\" lat=\"6\" lon=\"-6\"/>"
+        "<node id=\"3\" lat=\"7\" lon=\"-7\"><tag k=\"other\" v=\"true\"/></node>"
+        "<way id=\"4\"><nd ref=\"1\"/><nd ref=\"2\"/><tag k=\"any\" v=\"true\"/></way>"
+        "<relation id=\"5\"><member type=\"node\" ref=\"1\" role=\"\"/><tag k=\"any\" v=\"true\"/></relation>"
+        "</osm>";
+    geoStore.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    IdCollector collector;
+    std::vector<std::uint64_t> expected = { 1, utymap::formats::OsmElementId::way(4) };
+
+    geoStore.createSnapshot(sourcePath, snapshotPath);
+    std::remove(sourcePath.c_str());
+    geoStore.add("a", snapshotPath, LodRange(1, 1), *dependencyProvider.getStyleProvider(stylesheet));
+    geoStore.search(utymap::utils::GeoUtils::latLonToQuadKey({ 5, -5 }, 1),
+                    *dependencyProvider.getStyleProvider(stylesheet), collector);
+
+    std::sort(collector.ids.begin(), collector.ids.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(collector.ids.begin(), collector.ids.end(), expected.begin(), expected.end());
+    std::remove(snapshotPath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(GivenFailedCheckpointedImport_WhenAddAgain_ThenImportContinuesAfterCheckpoint)
+{
+    const std::string sourcePath = "checkpoint.xml";
+    std::ofstream(sourcePath) <<
+        "<osm version=\"0.6\">"
+        "<node id=\"1\" lat=\"5\" lon=\"-5\"><tag k=\"any\" v=\"true\"/></node>"
+        "<node id=\"2\" lat=\"6\" lon=\"-6\"><tag k=\"any\" v=\"true\"/></node>"
+        "<node id=\"3\" lat=\"7\" lon=\"-7\"><tag k=\"any\" v=\"true\"/></node>"
+        "<node id=\"4\" lat=\"8\" lon=\"-8\"><tag k=\"any\" v=\"true\"/></node>"
+        "<node id=\"5\" lat=\"9\" lon=\"-9\"><tag k=\"any\" v=\"true\"/></node>"
+        "</osm>";
+    std::vector<std::uint64_t> committed;
+    auto& stringTable = *dependencyProvider.getStringTable();
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    geoStore.setImportCheckpoint("./", 2);
+    geoStore.registerStore("a", utymap::utils::make_unique<FailingElementStore>(stringTable, committed, 3));
+
+    BOOST_CHECK_THROW(geoStore.add("a", sourcePath, LodRange(1, 1), *styleProvider), std::domain_error);
+    BOOST_CHECK_EQUAL(committed.size(), 2);
+    geoStore.add("a", sourcePath, LodRange(1, 1), *styleProvider);
+
+    std::sort(committed.begin(), committed.end());
+    std::vector<std::uint64_t> expected = { 1, 2, 3, 4, 5 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(committed.begin(), committed.end(), expected.begin(), expected.end());
+    BOOST_CHECK(getCheckpointFiles().empty());
+    std::remove(sourcePath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(GivenFailedCheckpointedImport_WhenAddToOtherStore_ThenWholeFileIsImported)
+{
+    const std::string sourcePath = "checkpoint.xml";
+    std::ofstream(sourcePath) <<
+        "<osm version=\"0.6\">"
+        "<node id=\"1\" lat=\"5\" lon=\"-5\"><tag k=\"any\" v=\"true\"/></node>"
+        "<node id=\"2\" lat=\"6\" lon=\"-6\"><tag k=\"any\" v=\"true\"/></node>"
+        "<node id=\"3\" lat=\"7\" lon=\"-7\"><tag k=\"any\" v=\"true\"/></node>"
+        "</osm>";
+    std::vector<std::uint64_t> committedA, committedB;
+    auto& stringTable = *dependencyProvider.getStringTable();
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    geoStore.setImportCheckpoint("./", 2);
+    geoStore.registerStore("a", utymap::utils::make_unique<FailingElementStore>(stringTable, committedA, 2));
+    geoStore.registerStore("b", utymap::utils::make_unique<FailingElementStore>(stringTable, committedB, 100));
+
+    BOOST_CHECK_THROW(geoStore.add("a", sourcePath, LodRange(1, 1), *styleProvider), std::domain_error);
+    geoStore.add("b", sourcePath, LodRange(1, 1), *styleProvider);
+
+    std::sort(committedB.begin(), committedB.end());
+    std::vector<std::uint64_t> expected = { 1, 2, 3 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(committedB.begin(), committedB.end(), expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(getCheckpointFiles().size(), 2);
+    geoStore.add("a", sourcePath, LodRange(1, 1), *styleProvider);
+    BOOST_CHECK(getCheckpointFiles().empty());
+    std::remove(sourcePath.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
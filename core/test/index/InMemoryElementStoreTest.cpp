@@ -3,10 +3,15 @@
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
+#include "entities/Relation.hpp"
 #include "index/InMemoryElementStore.hpp"
+#include "index/SearchControl.hpp"
+#include "utils/GeoUtils.hpp"
 
 #include <boost/test/unit_test.hpp>
 
+#include <functional>
+
 #include "test_utils/DependencyProvider.hpp"
 #include "test_utils/ElementUtils.hpp"
 
@@ -52,6 +57,16 @@ namespace {
         void visitArea(const Area&) override { ++times; }
         void visitRelation(const Relation&) override { ++times; }
     };
+
+    struct RelationCollector : public ElementVisitor
+    {
+        std::shared_ptr<Relation> relation;
+
+        void visitNode(const Node&) override { }
+        void visitWay(const Way&) override { }
+        void visitArea(const Area&) override { }
+        void visitRelation(const Relation& r) override { relation = std::make_shared<Relation>(r); }
+    };
 }
 
 BOOST_FIXTURE_TEST_SUITE(Index_InMemoryElementStore, Index_InMemoryElementStoreFixture)
@@ -66,6 +81,30 @@ BOOST_AUTO_TEST_CASE(GivenNodeWayArea_WhenSearch_ThenAllFound)
     BOOST_CHECK_EQUAL(counter.times, 3);
 }
 
+BOOST_AUTO_TEST_CASE(GivenNodeWayArea_WhenSearchWithLimit_ThenOnlyLimitedAmountIsRead)
+{
+    QuadKey quadKey(1, 0, 0);
+    ElementCounter counter;
+    LimitedElementVisitor limited(counter, 2);
+
+    elementStore.search(quadKey, limited);
+
+    BOOST_CHECK_EQUAL(counter.times, 2);
+    BOOST_CHECK_EQUAL(limited.getCount(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodeWayArea_WhenRemove_ThenNothingIsFound)
+{
+    QuadKey quadKey(1, 0, 0);
+    ElementCounter counter;
+
+    elementStore.remove(0, utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey), LodRange(1, 2));
+    elementStore.search(quadKey, counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 0);
+    BOOST_CHECK(!elementStore.hasData(quadKey));
+}
+
 BOOST_AUTO_TEST_CASE(GivenNodeWayArea_WhenSearch_ThenAllSkipped)
 {
     QuadKey quadKey(2, 0, 0);
@@ -76,4 +115,184 @@ BOOST_AUTO_TEST_CASE(GivenNodeWayArea_WhenSearch_ThenAllSkipped)
     BOOST_CHECK_EQUAL(counter.times, 0);
 }
 
+BOOST_AUTO_TEST_CASE(GivenRelation_WhenSearch_ThenItIsReadBackWithMembers)
+{
+    const std::string relationStylesheet = "relation|z1[any] { clip: false; }";
+    QuadKey quadKey(1, 0, 0);
+    InMemoryElementStore store(*dependencyProvider.getStringTable());
+    MapCssParser parser;
+    StyleProvider styleProvider(parser.parse(relationStylesheet), *dependencyProvider.getStringTable());
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "n", "1" } });
+    node.coordinate = { 5, -5 };
+    Area area = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 2,
+        { { "a", "2" } }, { { 5, -5 }, { 5, -10 }, { 10, -10 } });
+    Relation relation = ElementUtils::createElement<Relation>(*dependencyProvider.getStringTable(), 3, { { "any", "true" } });
+    relation.elements.push_back(std::make_shared<Node>(node));
+    relation.elements.push_back(std::make_shared<Area>(area));
+    RelationCollector collector;
+
+    store.store(relation, LodRange(1, 1), styleProvider);
+    store.search(quadKey, collector);
+
+    auto result = collector.relation;
+    BOOST_REQUIRE(result != nullptr);
+    BOOST_CHECK_EQUAL(result->id, 3);
+    BOOST_CHECK_EQUAL(result->elements.size(), 2);
+    BOOST_CHECK_EQUAL(result->elements[0]->id, 1);
+    BOOST_CHECK_EQUAL(std::dynamic_pointer_cast<Area>(result->elements[1])->coordinates.size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNode_WhenFindFingerprint_ThenStyleOfImportIsRestored)
+{
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    InMemoryElementStore store(*dependencyProvider.getStringTable());
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 7, { { "any", "true" } });
+    node.coordinate = { 5, -5 };
+    QuadKey quadKey(1, 0, 0);
+    store.store(node, LodRange(1, 1), *styleProvider);
+
+    StyleFingerprint fingerprint;
+    BOOST_REQUIRE(store.findFingerprint(quadKey, 7, fingerprint));
+    BOOST_CHECK_EQUAL(fingerprint.version, styleProvider->getFingerprintVersion());
+    BOOST_CHECK_EQUAL(styleProvider->forFingerprint(node, fingerprint.id).getString("clip"), "true");
+    BOOST_CHECK(!store.findFingerprint(quadKey, 8, fingerprint));
+
+    store.remove(7, utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey), LodRange(1, 1));
+    BOOST_CHECK(!store.findFingerprint(quadKey, 7, fingerprint));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoreWithMemoryLimit_WhenStoreInDifferentTiles_ThenLeastRecentlyUsedIsSpilled)
+{
+    std::vector<QuadKey> spilled;
+    InMemoryElementStore store(*dependencyProvider.getStringTable(), 1, [&](const Element&, const QuadKey& quadKey) {
+        spilled.push_back(quadKey);
+    });
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } });
+    node1.coordinate = { 5, -5 };
+    Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, { { "any", "true" } });
+    node2.coordinate = { 5, 5 };
+
+    store.store(node1, LodRange(1, 1), *styleProvider);
+    store.store(node2, LodRange(1, 1), *styleProvider);
+
+    BOOST_CHECK_EQUAL(spilled.size(), 1);
+    BOOST_CHECK(spilled[0] == QuadKey(1, 0, 0));
+    BOOST_CHECK(!store.hasData(QuadKey(1, 0, 0)));
+    BOOST_CHECK(store.hasData(QuadKey(1, 1, 0)));
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodesWithDifferentTags_WhenSearchByTag_ThenOnlyMatchedAreFound)
+{
+    auto& stringTable = *dependencyProvider.getStringTable();
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    InMemoryElementStore store(stringTable);
+    QuadKey quadKey(1, 0, 0);
+    BoundingBox bbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey);
+    std::vector<Tag> tags = { Tag(stringTable.getId("amenity"), stringTable.getId("cafe")) };
+    for (std::uint64_t id = 1; id <= 3; ++id) {
+        Node node = ElementUtils::createElement<Node>(stringTable, id,
+            { { "any", "true" }, { "amenity", id == 2 ? "bench" : "cafe" } });
+        node.coordinate = { 5, -5 };
+        store.store(node, LodRange(1, 1), *styleProvider);
+    }
+    ElementCounter first, second;
+
+    store.searchByTag(quadKey, bbox, tags, first);
+    store.remove(1, bbox, LodRange(1, 1));
+    store.searchByTag(quadKey, bbox, tags, second);
+
+    BOOST_CHECK_EQUAL(first.times, 2);
+    BOOST_CHECK_EQUAL(second.times, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSearchInProgress_WhenStoreAndRemoveInSameTile_ThenSearchVisitsUnchangedElements)
+{
+    auto& stringTable = *dependencyProvider.getStringTable();
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    QuadKey quadKey(1, 0, 0);
+    BoundingBox bbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey);
+    std::vector<Tag> tags = { Tag(stringTable.getId("any"), stringTable.getId("true")) };
+    Node node = ElementUtils::createElement<Node>(stringTable, 1, { { "any", "true" } });
+    node.coordinate = { 5, -5 };
+    struct ChangingVisitor : public ElementCounter
+    {
+        std::function<void()> change;
+
+        void visitNode(const Node& node) override
+        {
+            ElementCounter::visitNode(node);
+            if (change != nullptr) {
+                auto action = change;
+                change = nullptr;
+                action();
+            }
+        }
+    };
+    ChangingVisitor tagVisitor, visitor;
+    tagVisitor.change = [&]() { elementStore.store(node, LodRange(1, 1), *styleProvider); };
+    visitor.change = [&]() { elementStore.remove(0, bbox, LodRange(1, 2)); };
+
+    elementStore.searchByTag(quadKey, bbox, tags, tagVisitor);
+    elementStore.search(quadKey, visitor);
+    ElementCounter counter;
+    elementStore.search(quadKey, counter);
+
+    BOOST_CHECK_EQUAL(tagVisitor.times, 3);
+    BOOST_CHECK_EQUAL(visitor.times, 4);
+    BOOST_CHECK_EQUAL(counter.times, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoresDuringSearches_WhenSearchByTag_ThenElementsOfAllSegmentsAreFound)
+{
+    auto& stringTable = *dependencyProvider.getStringTable();
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    QuadKey quadKey(1, 0, 0);
+    BoundingBox bbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey);
+    struct StoringVisitor : public ElementCounter
+    {
+        std::function<void()> store;
+        bool isStored = false;
+
+        void visitNode(const Node&) override
+        {
+            if (!isStored)
+                store();
+            isStored = true;
+        }
+    };
+    std::uint64_t id = 1;
+    StoringVisitor visitor;
+    visitor.store = [&]() {
+        Node node = ElementUtils::createElement<Node>(stringTable, id,
+            { { "any", "true" }, { "amenity", id % 2 == 0 ? "bench" : "cafe" } });
+        node.coordinate = { 5, -5 };
+        ++id;
+        elementStore.store(node, LodRange(1, 1), *styleProvider);
+    };
+
+    // NOTE every store is made while search pins tile, so elements are spread over segments.
+    for (int i = 0; i < 20; ++i) {
+        visitor.isStored = false;
+        elementStore.search(quadKey, visitor);
+    }
+    ElementCounter cafes, all;
+    elementStore.searchByTag(quadKey, bbox, { Tag(stringTable.getId("amenity"), stringTable.getId("cafe")) }, cafes);
+    elementStore.search(quadKey, all);
+
+    BOOST_CHECK_EQUAL(all.times, 3 + 20);
+    BOOST_CHECK_EQUAL(cafes.times, 10);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodeWayArea_WhenGetMemoryUsage_ThenItIsTrackedPerLevelOfDetail)
+{
+    BOOST_CHECK(elementStore.getMemoryUsage(1) > 0);
+    BOOST_CHECK_EQUAL(elementStore.getMemoryUsage(2), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodeWayArea_WhenGetTotalMemoryUsage_ThenItIncludesAllLevelsOfDetail)
+{
+    BOOST_CHECK_EQUAL(elementStore.getMemoryUsage(), elementStore.getMemoryUsage(1));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,104 @@
+#include "entities/Node.hpp"
+#include "index/NameIndex.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_utils/DependencyProvider.hpp"
+#include "test_utils/ElementUtils.hpp"
+
+#include <cstdio>
+
+using namespace utymap;
+using namespace utymap::entities;
+using namespace utymap::index;
+
+namespace {
+    const std::string IndexPath = "names_test.idx";
+
+    struct Index_NameIndexFixture
+    {
+        Index_NameIndexFixture() :
+            dependencyProvider(),
+            nameIndex(*dependencyProvider.getStringTable())
+        {
+        }
+
+        ~Index_NameIndexFixture()
+        {
+            std::remove(IndexPath.c_str());
+        }
+
+        void add(std::uint64_t id, const std::string& key, const std::string& name, const GeoCoordinate& coordinate)
+        {
+            Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), id,
+                { { "amenity", "cafe" }, { key.c_str(), name.c_str() } });
+            nameIndex.add(node, coordinate);
+        }
+
+        DependencyProvider dependencyProvider;
+        NameIndex nameIndex;
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(Index_NameIndex, Index_NameIndexFixture)
+
+BOOST_AUTO_TEST_CASE(GivenName_WhenNormalize_ThenCaseAndSeparatorsAreIgnored)
+{
+    BOOST_CHECK_EQUAL(NameIndex::normalize("  Caf\xC3\xA9 -- Central_Park. "), "caf\xC3\xA9 central park");
+    BOOST_CHECK_EQUAL(NameIndex::normalize("--"), "");
+}
+
+BOOST_AUTO_TEST_CASE(GivenNames_WhenFindByPrefix_ThenClosestElementsAreReturnedOnce)
+{
+    add(1, "name", "Central Cafe", { 10, 10 });
+    add(2, "name", "CENTRAL-Station", { 1, 1 });
+    add(2, "name:en", "Central station", { 1, 1 });
+    add(3, "name", "Centre", { 0, 0 });
+    add(4, "amenity", "Central", { 0, 0 });
+
+    auto matches = nameIndex.find("central", GeoCoordinate(0, 0), 10);
+
+    BOOST_REQUIRE_EQUAL(matches.size(), 2);
+    BOOST_CHECK_EQUAL(matches[0].id, 2);
+    BOOST_CHECK_EQUAL(matches[1].id, 1);
+    BOOST_CHECK_EQUAL(matches[1].name, "Central Cafe");
+    BOOST_CHECK(matches[0].distance < matches[1].distance);
+    BOOST_CHECK_EQUAL(nameIndex.find("central", GeoCoordinate(0, 0), 1).size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRemovedAndUpdatedElements_WhenFind_ThenOnlyLatestNamesAreReturned)
+{
+    add(1, "name", "Old Bridge", { 1, 1 });
+    add(2, "name", "Old Mill", { 2, 2 });
+    nameIndex.remove(1);
+    nameIndex.remove(2);
+    add(2, "name", "Old Mill", { 3, 3 });
+
+    auto matches = nameIndex.find("old", GeoCoordinate(0, 0), 10);
+
+    BOOST_REQUIRE_EQUAL(matches.size(), 1);
+    BOOST_CHECK_EQUAL(matches[0].id, 2);
+    BOOST_CHECK_EQUAL(matches[0].coordinate.latitude, 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenIndex_WhenWriteAndRead_ThenNamesAreRestored)
+{
+    add(1, "name", "Main Street", { 52.5, 13.4 });
+    add(2, "name", "main square", { -33.9, 151.2 });
+    add(3, "name:de", "Mainbr\xC3\xBC" "cke", { 50.1, 8.7 });
+    nameIndex.write(IndexPath);
+
+    NameIndex restored(*dependencyProvider.getStringTable());
+    BOOST_REQUIRE(restored.read(IndexPath));
+    auto matches = restored.find("MAIN", GeoCoordinate(52.5, 13.4), 10);
+
+    BOOST_CHECK_EQUAL(restored.size(), 3);
+    BOOST_REQUIRE_EQUAL(matches.size(), 3);
+    BOOST_CHECK_EQUAL(matches[0].id, 1);
+    BOOST_CHECK_EQUAL(matches[0].name, "Main Street");
+    BOOST_CHECK_CLOSE(matches[0].coordinate.longitude, 13.4, 1E-6);
+    BOOST_CHECK_EQUAL(matches[2].name, "main square");
+    BOOST_CHECK(!restored.read("missing.idx"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,271 @@
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "index/PackageElementStore.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include "test_utils/DependencyProvider.hpp"
+#include "test_utils/ElementUtils.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+using namespace utymap;
+using namespace utymap::entities;
+using namespace utymap::index;
+using namespace utymap::mapcss;
+
+namespace {
+    const std::string PackagePath = "test.pkg";
+
+    const std::string stylesheet = "node|z1[any], way|z1[any], area|z1[any], relation|z1[any] { clip: false; }";
+
+    struct Index_PackageElementStoreFixture
+    {
+        Index_PackageElementStoreFixture() :
+            dependencyProvider(),
+            elementStore(utymap::utils::make_unique<PackageElementStore>(PackagePath, *dependencyProvider.getStringTable()))
+        {
+        }
+
+        ~Index_PackageElementStoreFixture()
+        {
+            elementStore.reset();
+            std::remove(PackagePath.c_str());
+        }
+
+        /// Closes store and opens it again using the same package.
+        void reopen()
+        {
+            elementStore.reset();
+            elementStore = utymap::utils::make_unique<PackageElementStore>(PackagePath, *dependencyProvider.getStringTable());
+        }
+
+        Node createNode(std::uint64_t id, double latitude, double longitude)
+        {
+            Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), id, { { "any", "true" } });
+            node.coordinate = { latitude, longitude };
+            return node;
+        }
+
+        DependencyProvider dependencyProvider;
+        std::unique_ptr<PackageElementStore> elementStore;
+    };
+
+    struct ElementCounter : public ElementVisitor
+    {
+        int times = 0;
+        std::shared_ptr<Element> element;
+
+        void visitNode(const Node& node) override
+        {
+            ++times;
+            element = std::make_shared<Node>(node);
+        }
+
+        void visitWay(const Way& way) override
+        {
+            ++times;
+            element = std::make_shared<Way>(way);
+        }
+
+        void visitArea(const Area& area) override
+        {
+            ++times;
+            element = std::make_shared<Area>(area);
+        }
+
+        void visitRelation(const Relation& relation) override
+        {
+            ++times;
+            element = std::make_shared<Relation>(relation);
+        }
+    };
+
+    void assertNode(const Node& expected, const Node& actual)
+    {
+        BOOST_CHECK_EQUAL(expected.id, actual.id);
+        BOOST_CHECK_EQUAL(expected.tags.size(), actual.tags.size());
+        BOOST_CHECK_EQUAL(expected.coordinate.latitude, actual.coordinate.latitude);
+        BOOST_CHECK_EQUAL(expected.coordinate.longitude, actual.coordinate.longitude);
+    }
+
+    std::size_t getFileSize(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+        return static_cast<std::size_t>(file.tellg());
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(Index_PackageElementStore, Index_PackageElementStoreFixture)
+
+BOOST_AUTO_TEST_CASE(GivenWay_WhenStoreAndSearch_ThenItIsStoredAndReadBack)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 7, { { "any", "true" } }, { { 1, -1 }, { 5, -5 } });
+    ElementCounter counter;
+
+    elementStore->store(way, range, *styleProvider);
+    elementStore->commit();
+    elementStore->search(QuadKey(1, 0, 0), counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 1);
+    auto result = std::dynamic_pointer_cast<Way>(counter.element);
+    BOOST_CHECK_EQUAL(result->id, 7);
+    BOOST_CHECK_EQUAL(result->coordinates.size(), 2);
+    BOOST_CHECK_EQUAL(result->coordinates[1].latitude, 5);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodesInDifferentQuadKeys_WhenReopenStore_ThenTheyAreReadFromPackage)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node1 = createNode(1, 5, -5);
+    Node node2 = createNode(2, -5, 5);
+    elementStore->store(node1, range, *styleProvider);
+    elementStore->store(node2, range, *styleProvider);
+    elementStore->commit();
+    ElementCounter counter1, counter2;
+
+    reopen();
+    elementStore->search(QuadKey(1, 0, 0), counter1);
+    elementStore->search(QuadKey(1, 1, 1), counter2);
+
+    BOOST_CHECK(elementStore->hasData(QuadKey(1, 0, 0)));
+    BOOST_CHECK(!elementStore->hasData(QuadKey(1, 1, 0)));
+    BOOST_CHECK_EQUAL(counter1.times, 1);
+    BOOST_CHECK_EQUAL(counter2.times, 1);
+    assertNode(node1, *std::dynamic_pointer_cast<Node>(counter1.element));
+    assertNode(node2, *std::dynamic_pointer_cast<Node>(counter2.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenNode_WhenStoreAndSearchWithoutCommit_ThenItIsReadBack)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node = createNode(1, 5, -5);
+    ElementCounter counter;
+
+    elementStore->store(node, range, *styleProvider);
+    elementStore->search(QuadKey(1, 0, 0), counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 1);
+    BOOST_CHECK(elementStore->getMemoryUsage() > 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenUnwritablePackage_WhenCommitAndDestroy_ThenOnlyCommitThrows)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    auto store = utymap::utils::make_unique<PackageElementStore>("missing/test.pkg", *dependencyProvider.getStringTable());
+    Node node = createNode(1, 5, -5);
+
+    store->store(node, range, *styleProvider);
+
+    BOOST_CHECK_THROW(store->commit(), std::domain_error);
+    BOOST_CHECK_NO_THROW(store.reset());
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNode_WhenUpdateAndReopen_ThenOnlyNewVersionIsReturned)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node = createNode(1, 5, -5);
+    Node updated = createNode(1, 6, -6);
+    ElementCounter counter;
+
+    elementStore->store(node, range, *styleProvider);
+    elementStore->commit();
+    elementStore->update(updated, range, *styleProvider);
+    elementStore->commit();
+    reopen();
+    elementStore->search(QuadKey(1, 0, 0), counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 1);
+    assertNode(updated, *std::dynamic_pointer_cast<Node>(counter.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenRemovedNodes_WhenCompact_ThenPackageIsSmallerAndLiveNodeIsReturned)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node1 = createNode(1, 5, -5);
+    Node node2 = createNode(2, 6, -6);
+    Node node3 = createNode(3, -5, 5);
+    elementStore->store(node1, range, *styleProvider);
+    elementStore->store(node2, range, *styleProvider);
+    elementStore->store(node3, range, *styleProvider);
+    elementStore->commit();
+    elementStore->remove(1, BoundingBox(GeoCoordinate(4, -6), GeoCoordinate(6, -4)), range);
+    elementStore->remove(3, BoundingBox(GeoCoordinate(-6, 4), GeoCoordinate(-4, 6)), range);
+    elementStore->commit();
+    std::size_t sizeBeforeCompaction = getFileSize(PackagePath);
+    ElementCounter counter;
+
+    elementStore->compact();
+    elementStore->search(QuadKey(1, 0, 0), counter);
+
+    BOOST_CHECK(getFileSize(PackagePath) < sizeBeforeCompaction);
+    BOOST_CHECK(!elementStore->hasData(QuadKey(1, 1, 1)));
+    BOOST_CHECK_EQUAL(counter.times, 1);
+    assertNode(node2, *std::dynamic_pointer_cast<Node>(counter.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNode_WhenStoreAnotherInSameTile_ThenOnlyNewBlockIsAppended)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    elementStore->store(createNode(1, 5, -5), range, *styleProvider);
+    elementStore->commit();
+    std::size_t firstSize = getFileSize(PackagePath);
+
+    elementStore->store(createNode(2, 6, -6), range, *styleProvider);
+    elementStore->commit();
+
+    BOOST_CHECK_LT(getFileSize(PackagePath) - firstSize, firstSize);
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyCommitsToSameTile_WhenReopen_ThenLiveNodesAreReturned)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    for (std::uint64_t id = 1; id <= 12; ++id) {
+        elementStore->store(createNode(id, 5, -5), range, *styleProvider);
+        if (id % 3 == 0)
+            elementStore->remove(id - 1, BoundingBox(GeoCoordinate(4, -6), GeoCoordinate(6, -4)), range);
+        elementStore->commit();
+    }
+    ElementCounter counter;
+
+    reopen();
+    elementStore->search(QuadKey(1, 0, 0), counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 8);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCommittedNode_WhenRemoveWithoutCommit_ThenTileHasNoData)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    elementStore->store(createNode(1, 5, -5), range, *styleProvider);
+    elementStore->commit();
+
+    elementStore->remove(1, BoundingBox(GeoCoordinate(4, -6), GeoCoordinate(6, -4)), range);
+
+    BOOST_CHECK(!elementStore->hasData(QuadKey(1, 0, 0)));
+}
+
+BOOST_AUTO_TEST_CASE(GivenEmptyStore_WhenSearch_ThenNothingIsReturned)
+{
+    ElementCounter counter;
+
+    elementStore->search(QuadKey(1, 1, 1), counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 0);
+    BOOST_CHECK(!elementStore->hasData(QuadKey(1, 1, 1)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
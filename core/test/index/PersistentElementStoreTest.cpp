@@ -2,14 +2,22 @@
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
+#include "formats/osm/OsmElementId.hpp"
+#include "index/ElementPrefilter.hpp"
 #include "index/PersistentElementStore.hpp"
+#include "index/SearchControl.hpp"
+#include "index/StringTable.hpp"
+#include "mapcss/MapCssParser.hpp"
 
 #include <boost/test/unit_test.hpp>
 #include "test_utils/DependencyProvider.hpp"
 #include "test_utils/ElementUtils.hpp"
 
 #include <boost/filesystem/operations.hpp>
+#include <atomic>
 #include <cstdio>
+#include <fstream>
+#include <thread>
 
 using namespace utymap;
 using namespace utymap::entities;
@@ -39,6 +47,10 @@ namespace {
                 boost::filesystem::remove_all(it->path());
             }
             boost::filesystem::remove(TestZoomDirectory);
+            std::remove("tiles.mft");
+            std::remove("names.idx");
+            std::remove("ids.idx");
+            std::remove("files.jrn");
         }
 
         DependencyProvider dependencyProvider;
@@ -73,6 +85,27 @@ namespace {
         }
     };
 
+    /// Accepts only elements with given tag key and records geometry seen by prefilter.
+    struct PrefilterCounter : public ElementCounter, public ElementPrefilter
+    {
+        explicit PrefilterCounter(std::uint32_t key) : key(key) { }
+
+        bool accepts(const Element& element) override
+        {
+            ++checked;
+            if (auto way = dynamic_cast<const Way*>(&element))
+                coordinates += way->coordinates.size();
+            for (const auto& tag : element.tags)
+                if (tag.key == key)
+                    return true;
+            return false;
+        }
+
+        std::uint32_t key;
+        int checked = 0;
+        std::size_t coordinates = 0;
+    };
+
     void assertGeometry(const GeoCoordinate& expected, const GeoCoordinate& actual)
     {
         BOOST_CHECK_EQUAL(expected.latitude, actual.latitude);
@@ -126,6 +159,39 @@ BOOST_AUTO_TEST_CASE(GivenNode_WhenStoreAndSearch_ThenItIsStoredAndReadBack)
     assertNode(node, *std::dynamic_pointer_cast<Node>(counter.element));
 }
 
+BOOST_AUTO_TEST_CASE(GivenStoredNode_WhenPrefetchAndSearch_ThenItIsReadBack)
+{
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 7, { { "any", "true" } });
+    node.coordinate = { 5, -5 };
+    ElementCounter counter;
+    elementStore.store(node, LodRange(1, 1), *styleProvider);
+    elementStore.commit();
+
+    elementStore.prefetch(quadKey);
+    elementStore.prefetch(QuadKey(1, 1, 1));
+    elementStore.search(quadKey, counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSharedWay_WhenPrefetchAndSearch_ThenItIsReadBack)
+{
+    QuadKey quadKey(1, 1, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 7, { { "any", "true" } }, { { 5, -5 }, { 5, 5 } });
+    ElementCounter counter;
+    elementStore.store(way, LodRange(1, 1), *styleProvider);
+    elementStore.commit();
+
+    elementStore.prefetch(quadKey);
+    elementStore.search(quadKey, counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 1);
+    assertWayOrArea(way, *std::dynamic_pointer_cast<Way>(counter.element));
+}
+
 BOOST_AUTO_TEST_CASE(GivenWay_WhenStoreAndSearch_ThenItIsStoredAndReadBack)
 {
     LodRange range(1, 2);
@@ -141,6 +207,47 @@ BOOST_AUTO_TEST_CASE(GivenWay_WhenStoreAndSearch_ThenItIsStoredAndReadBack)
     assertWayOrArea(way, *std::dynamic_pointer_cast<Way>(counter.element));
 }
 
+BOOST_AUTO_TEST_CASE(GivenTwoWays_WhenSearchWithPrefilter_ThenOnlyAcceptedIsDecoded)
+{
+    auto& stringTable = *dependencyProvider.getStringTable();
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Way way1 = ElementUtils::createElement<Way>(stringTable, 1, { { "any", "true" } }, { { 1, -1 }, { 5, -5 } });
+    Way way2 = ElementUtils::createElement<Way>(stringTable, 2, { { "any", "true" }, { "highway", "primary" } }, { { 2, -2 }, { 6, -6 } });
+    PrefilterCounter counter(stringTable.getId("highway"));
+
+    elementStore.store(way1, range, *styleProvider);
+    elementStore.store(way2, range, *styleProvider);
+    elementStore.commit();
+    elementStore.search(quadKey, counter);
+
+    BOOST_CHECK_EQUAL(counter.checked, 2);
+    BOOST_CHECK_EQUAL(counter.coordinates, 0);
+    BOOST_CHECK_EQUAL(counter.times, 1);
+    assertWayOrArea(way2, *std::dynamic_pointer_cast<Way>(counter.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenTwoWays_WhenSearchWithLimit_ThenOnlyFirstIsRead)
+{
+    auto& stringTable = *dependencyProvider.getStringTable();
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Way way1 = ElementUtils::createElement<Way>(stringTable, 1, { { "any", "true" } }, { { 1, -1 }, { 5, -5 } });
+    Way way2 = ElementUtils::createElement<Way>(stringTable, 2, { { "any", "true" } }, { { 2, -2 }, { 6, -6 } });
+    ElementCounter counter;
+    LimitedElementVisitor limited(counter, 1);
+
+    elementStore.store(way1, range, *styleProvider);
+    elementStore.store(way2, range, *styleProvider);
+    elementStore.commit();
+    elementStore.search(quadKey, limited);
+
+    BOOST_CHECK_EQUAL(counter.times, 1);
+    assertWayOrArea(way1, *std::dynamic_pointer_cast<Way>(counter.element));
+}
+
 BOOST_AUTO_TEST_CASE(GivenArea_WhenStoreAndSearch_ThenItIsStoredAndReadBack)
 {
     LodRange range(1, 2);
@@ -180,6 +287,33 @@ BOOST_AUTO_TEST_CASE(GivenRelationWithDifferentElements_WhenStoreAndSearch_ThenI
     assertElement(relation, result);
 }
 
+BOOST_AUTO_TEST_CASE(GivenMultipolygonRelation_WhenStoreAndSearch_ThenRingsAreReadBack)
+{
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    auto outer = std::make_shared<Area>();
+    outer->id = 2;
+    outer->coordinates = { { 1, -1 }, { 1, -9 }, { 9, -9 }, { 9, -1 } };
+    auto inner = std::make_shared<Area>();
+    inner->id = 0;
+    inner->coordinates = { { 4, -4 }, { 5, -4 }, { 5, -5 }, { 4, -5 } };
+    Relation relation = ElementUtils::createElement<Relation>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } });
+    relation.elements = { outer, inner };
+    ElementCounter counter;
+
+    elementStore.store(relation, range, *styleProvider);
+    elementStore.commit();
+    elementStore.search(quadKey, counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 1);
+    Relation result = *std::dynamic_pointer_cast<Relation>(counter.element);
+    assertElement(relation, result);
+    BOOST_REQUIRE_EQUAL(result.elements.size(), 2);
+    assertWayOrArea(*outer, *std::dynamic_pointer_cast<Area>(result.elements[0]));
+    assertWayOrArea(*inner, *std::dynamic_pointer_cast<Area>(result.elements[1]));
+}
+
 BOOST_AUTO_TEST_CASE(GivenTwoAreas_WhenStoreAndSearchOnce_ThenTheyStoredTwiceAndSecondReturnedLast)
 {
     LodRange range(1, 2);
@@ -198,4 +332,632 @@ BOOST_AUTO_TEST_CASE(GivenTwoAreas_WhenStoreAndSearchOnce_ThenTheyStoredTwiceAnd
     assertWayOrArea(area2, *std::dynamic_pointer_cast<Area>(counter.element));
 }
 
+BOOST_AUTO_TEST_CASE(GivenArea_WhenStoreAndSearchWithoutCommit_ThenItIsReadBackOnlyAfterCommit)
+{
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Area area = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 7, { { "any", "true" } }, { { 1, -1 }, { 5, -5 }, { 10, -10 } });
+    ElementCounter beforeCommit, afterCommit;
+
+    elementStore.store(area, range, *styleProvider);
+    elementStore.search(quadKey, beforeCommit);
+    elementStore.commit();
+    elementStore.search(quadKey, afterCommit);
+
+    BOOST_CHECK_EQUAL(beforeCommit.times, 0);
+    BOOST_REQUIRE_EQUAL(afterCommit.times, 1);
+    assertWayOrArea(area, *std::dynamic_pointer_cast<Area>(afterCommit.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenImportInBackground_WhenSearch_ThenOnlyCommittedBatchesAreReturned)
+{
+    const int BatchSize = 50;
+    const int BatchCount = 20;
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    std::vector<Node> nodes;
+    for (int i = 0; i < BatchSize * BatchCount; ++i) {
+        nodes.push_back(ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), i + 1, { { "any", "true" } }));
+        nodes.back().coordinate = { 5, -5 };
+    }
+    std::atomic<bool> isImported(false);
+
+    std::thread writer([&]() {
+        for (int i = 0; i < BatchSize * BatchCount; ++i) {
+            elementStore.store(nodes[i], range, *styleProvider);
+            if ((i + 1) % BatchSize == 0)
+                elementStore.commit();
+        }
+        isImported = true;
+    });
+    int lastCount = 0;
+    bool isConsistent = true;
+    while (!isImported) {
+        ElementCounter counter;
+        elementStore.search(quadKey, counter);
+        isConsistent &= counter.times % BatchSize == 0 && counter.times >= lastCount;
+        lastCount = counter.times;
+    }
+    writer.join();
+    ElementCounter counter;
+    elementStore.search(quadKey, counter);
+
+    BOOST_CHECK(isConsistent);
+    BOOST_CHECK_EQUAL(counter.times, BatchSize * BatchCount);
+}
+
+BOOST_AUTO_TEST_CASE(GivenElementsInDifferentQuadKeys_WhenStoreInterleavedAndSearch_ThenAllAreReadBack)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } });
+    node1.coordinate = { 5, -5 };
+    Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, { { "any", "true" } });
+    node2.coordinate = { 5, 5 };
+    ElementCounter counter1, counter2;
+
+    elementStore.store(node1, range, *styleProvider);
+    elementStore.store(node2, range, *styleProvider);
+    elementStore.store(node1, range, *styleProvider);
+    elementStore.commit();
+    elementStore.search(QuadKey(1, 0, 0), counter1);
+    elementStore.search(QuadKey(1, 1, 0), counter2);
+
+    BOOST_CHECK_EQUAL(counter1.times, 2);
+    BOOST_CHECK_EQUAL(counter2.times, 1);
+    assertNode(node2, *std::dynamic_pointer_cast<Node>(counter2.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenWayInTwoQuadKeys_WhenStoreAndSearch_ThenItIsWrittenOnceAndReadBackFromBoth)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 7, { { "any", "true" } }, { { 5, -5 }, { 5.1234567, 5 } });
+    ElementCounter counter1, counter2;
+
+    elementStore.store(way, range, *styleProvider);
+    elementStore.commit();
+    elementStore.search(QuadKey(1, 0, 0), counter1);
+    elementStore.search(QuadKey(1, 1, 0), counter2);
+
+    BOOST_CHECK_EQUAL(counter1.times, 1);
+    BOOST_CHECK_EQUAL(counter2.times, 1);
+    assertWayOrArea(way, *std::dynamic_pointer_cast<Way>(counter1.element));
+    assertWayOrArea(way, *std::dynamic_pointer_cast<Way>(counter2.element));
+    BOOST_CHECK(boost::filesystem::exists(TestZoomDirectory + "/shared.dat"));
+    BOOST_CHECK(!boost::filesystem::exists(TestZoomDirectory + "/0.dat") ||
+                boost::filesystem::file_size(TestZoomDirectory + "/0.dat") == 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSharedWay_WhenRemoveFromOneQuadKeyAndCompact_ThenItIsReadBackFromOther)
+{
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 7, { { "any", "true" } }, { { 5, -5 }, { 5, 5 } });
+    ElementCounter counter1, counter2;
+
+    elementStore.store(way, range, *styleProvider);
+    elementStore.remove(7, BoundingBox(GeoCoordinate(1, -10), GeoCoordinate(10, -1)), range);
+    elementStore.compact();
+    elementStore.search(quadKey, counter1);
+    elementStore.search(QuadKey(1, 1, 0), counter2);
+
+    BOOST_CHECK_EQUAL(counter1.times, 0);
+    BOOST_CHECK_EQUAL(counter2.times, 1);
+    assertWayOrArea(way, *std::dynamic_pointer_cast<Way>(counter2.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenSharedWays_WhenRemoveLargerOneAndCompact_ThenSharedDataIsCompacted)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Way removed = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 7, { { "any", "true" } }, {});
+    for (int i = 0; i < 64; ++i)
+        removed.coordinates.push_back(GeoCoordinate(5 + i * 0.01, i % 2 == 0 ? -5 : 5));
+    Way kept = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 8, { { "any", "true" } }, { { 5, -5 }, { 5, 5 } });
+    ElementCounter counter1, counter2, reopenedCounter;
+    elementStore.store(removed, range, *styleProvider);
+    elementStore.store(kept, range, *styleProvider);
+    elementStore.commit();
+    auto sharedSize = boost::filesystem::file_size(TestZoomDirectory + "/shared.dat");
+
+    elementStore.remove(7, BoundingBox(GeoCoordinate(1, -10), GeoCoordinate(10, 10)), range);
+    elementStore.compact();
+    elementStore.search(QuadKey(1, 0, 0), counter1);
+    elementStore.search(QuadKey(1, 1, 0), counter2);
+    PersistentElementStore reopenedStore("", *dependencyProvider.getStringTable());
+    reopenedStore.search(QuadKey(1, 1, 0), reopenedCounter);
+
+    BOOST_CHECK_LT(boost::filesystem::file_size(TestZoomDirectory + "/shared.dat"), sharedSize / 2);
+    BOOST_CHECK(!boost::filesystem::exists("shared.jrn"));
+    BOOST_CHECK_EQUAL(counter1.times, 1);
+    BOOST_CHECK_EQUAL(counter2.times, 1);
+    BOOST_CHECK_EQUAL(reopenedCounter.times, 1);
+    assertWayOrArea(kept, *std::dynamic_pointer_cast<Way>(counter1.element));
+    assertWayOrArea(kept, *std::dynamic_pointer_cast<Way>(reopenedCounter.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenIndexWithSharedOffsetFlags_WhenReopenStore_ThenSharedWayIsReadBack)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 7, { { "any", "true" } }, { { 5, -5 }, { 5, 5 } });
+    ElementCounter counter1, counter2;
+    elementStore.store(way, range, *styleProvider);
+    elementStore.commit();
+    {
+        // NOTE previous version marks shared entry by offset bit 31 and keeps element type bit.
+        for (const std::string& name : { "/0.idx", "/1.idx" }) {
+            std::fstream index(TestZoomDirectory + name, std::ios::in | std::ios::out | std::ios::binary);
+            std::uint32_t values[2];
+            index.seekg(8);
+            index.read(reinterpret_cast<char*>(values), sizeof(values));
+            values[0] |= 0x80000000;
+            values[1] |= 0x2;
+            index.seekp(8);
+            index.write(reinterpret_cast<const char*>(values), sizeof(values));
+        }
+        std::uint32_t magic = 0x3346544D;
+        std::fstream manifest("tiles.mft", std::ios::in | std::ios::out | std::ios::binary);
+        manifest.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+    }
+
+    PersistentElementStore reopenedStore("", *dependencyProvider.getStringTable());
+    reopenedStore.search(QuadKey(1, 0, 0), counter1);
+    reopenedStore.search(QuadKey(1, 1, 0), counter2);
+
+    BOOST_CHECK_EQUAL(counter1.times, 1);
+    BOOST_CHECK_EQUAL(counter2.times, 1);
+    assertWayOrArea(way, *std::dynamic_pointer_cast<Way>(counter1.element));
+    assertWayOrArea(way, *std::dynamic_pointer_cast<Way>(counter2.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenWayWithFractionalCoordinates_WhenStoreAndSearch_ThenPrecisionIsPreserved)
+{
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 7, { { "any", "true" } },
+        { { 52.5316352, -13.3891739 }, { 52.5316866, -13.3880147 } });
+    ElementCounter counter;
+
+    elementStore.store(way, range, *styleProvider);
+    elementStore.commit();
+    elementStore.search(quadKey, counter);
+
+    auto result = std::dynamic_pointer_cast<Way>(counter.element);
+    BOOST_CHECK_EQUAL(result->coordinates.size(), 2);
+    for (std::size_t i = 0; i < way.coordinates.size(); ++i) {
+        BOOST_CHECK_CLOSE(way.coordinates[i].latitude, result->coordinates[i].latitude, 1E-7);
+        BOOST_CHECK_CLOSE(way.coordinates[i].longitude, result->coordinates[i].longitude, 1E-7);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GivenCompressedStore_WhenStoreTwiceAndSearch_ThenAllElementsAreReadBack)
+{
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Area area1 = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } }, { { 4, -4 }, { 5, -5 }, { 6, -6 } });
+    Area area2 = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 2, { { "any", "true" } }, { { 1, -1 }, { 2, -2 }, { 3, -3 } });
+    PersistentElementStore compressedStore("", *dependencyProvider.getStringTable(), true);
+    ElementCounter counter;
+
+    compressedStore.store(area1, range, *styleProvider);
+    compressedStore.commit();
+    compressedStore.store(area2, range, *styleProvider);
+    compressedStore.commit();
+    compressedStore.search(quadKey, counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 2);
+    assertWayOrArea(area2, *std::dynamic_pointer_cast<Area>(counter.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenTwoNodes_WhenSearchInBoundingBox_ThenOnlyIntersectingIsReturned)
+{
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } });
+    node1.coordinate = { 5, -5 };
+    Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, { { "any", "true" } });
+    node2.coordinate = { 50, -50 };
+    ElementCounter counter;
+
+    elementStore.store(node1, range, *styleProvider);
+    elementStore.store(node2, range, *styleProvider);
+    elementStore.commit();
+    elementStore.search(quadKey, BoundingBox(GeoCoordinate(40, -60), GeoCoordinate(60, -40)), "", counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 1);
+    assertNode(node2, *std::dynamic_pointer_cast<Node>(counter.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodesWithDifferentTags_WhenSearchByTag_ThenOnlyMatchedIsReturned)
+{
+    auto& stringTable = *dependencyProvider.getStringTable();
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    BoundingBox bbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    std::vector<Tag> tags = { Tag(stringTable.getId("amenity"), stringTable.getId("cafe")) };
+    Node node1 = ElementUtils::createElement<Node>(stringTable, 1, { { "any", "true" }, { "amenity", "bench" } });
+    node1.coordinate = { 5, -5 };
+    Node node2 = ElementUtils::createElement<Node>(stringTable, 2, { { "any", "true" }, { "amenity", "cafe" } });
+    node2.coordinate = { 6, -6 };
+    ElementCounter first, second;
+
+    elementStore.store(node1, range, *styleProvider);
+    elementStore.store(node2, range, *styleProvider);
+    elementStore.commit();
+    elementStore.searchByTag(quadKey, bbox, tags, first);
+    elementStore.store(node2, range, *styleProvider);
+    elementStore.commit();
+    elementStore.searchByTag(quadKey, bbox, tags, second);
+
+    BOOST_CHECK_EQUAL(first.times, 1);
+    assertNode(node2, *std::dynamic_pointer_cast<Node>(first.element));
+    BOOST_CHECK_EQUAL(second.times, 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodesWithDifferentBuilders_WhenSearchByBuilder_ThenOnlyMatchedIsReturned)
+{
+    const std::string builderStylesheet = "node|z1[kind=tree] { builders: tree; } node|z1[kind=bench] { builders: bench; }";
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(builderStylesheet);
+    Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "kind", "tree" } });
+    node1.coordinate = { 5, -5 };
+    Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, { { "kind", "bench" } });
+    node2.coordinate = { 6, -6 };
+    ElementCounter counter;
+
+    elementStore.store(node1, range, *styleProvider);
+    elementStore.store(node2, range, *styleProvider);
+    elementStore.commit();
+    elementStore.search(quadKey, utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey), "tree", counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 1);
+    assertNode(node1, *std::dynamic_pointer_cast<Node>(counter.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNode_WhenUpdate_ThenOnlyNewVersionIsReturned)
+{
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } });
+    node.coordinate = { 5, -5 };
+    Node updated = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } });
+    updated.coordinate = { 6, -6 };
+    ElementCounter counter;
+
+    elementStore.store(node, range, *styleProvider);
+    elementStore.commit();
+    elementStore.update(updated, range, *styleProvider);
+    elementStore.commit();
+    elementStore.search(quadKey, counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 1);
+    assertNode(updated, *std::dynamic_pointer_cast<Node>(counter.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenRemovedNode_WhenCompactAndSearch_ThenOnlyOtherNodeIsReturned)
+{
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } });
+    node1.coordinate = { 5, -5 };
+    Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, { { "any", "true" } });
+    node2.coordinate = { 6, -6 };
+    ElementCounter beforeCompaction, afterCompaction;
+
+    elementStore.store(node1, range, *styleProvider);
+    elementStore.store(node2, range, *styleProvider);
+    elementStore.remove(1, utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey), range);
+    elementStore.commit();
+    elementStore.search(quadKey, beforeCompaction);
+    elementStore.compact();
+    elementStore.search(quadKey, afterCompaction);
+
+    BOOST_CHECK_EQUAL(beforeCompaction.times, 1);
+    BOOST_CHECK_EQUAL(afterCompaction.times, 1);
+    assertNode(node2, *std::dynamic_pointer_cast<Node>(afterCompaction.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNodes_WhenReopenStoreAndCompact_ThenFingerprintsOfLiveNodesAreFound)
+{
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } });
+    node1.coordinate = { 5, -5 };
+    Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, { { "any", "true" } });
+    node2.coordinate = { 6, -6 };
+    elementStore.store(node1, range, *styleProvider);
+    elementStore.store(node2, range, *styleProvider);
+    elementStore.commit();
+    StyleFingerprint fingerprint;
+
+    PersistentElementStore reopenedStore("", *dependencyProvider.getStringTable());
+
+    BOOST_REQUIRE(reopenedStore.findFingerprint(quadKey, 1, fingerprint));
+    BOOST_CHECK_EQUAL(fingerprint.version, styleProvider->getFingerprintVersion());
+    BOOST_CHECK_EQUAL(styleProvider->forFingerprint(node1, fingerprint.id).getString("clip"), "false");
+    BOOST_CHECK(!reopenedStore.findFingerprint(quadKey, 3, fingerprint));
+    reopenedStore.remove(1, utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey), range);
+    reopenedStore.compact();
+    BOOST_CHECK(!reopenedStore.findFingerprint(quadKey, 1, fingerprint));
+    BOOST_CHECK(reopenedStore.findFingerprint(quadKey, 2, fingerprint));
+}
+
+BOOST_AUTO_TEST_CASE(GivenLargeCompressedTile_WhenCompactAndSearchInBoundingBox_ThenItIsSplitAndOnlyIntersectingIsReturned)
+{
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    PersistentElementStore compressedStore("", *dependencyProvider.getStringTable(), true);
+    compressedStore.setSplitSize(64);
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1 + i * 8 + j, { { "any", "true" } });
+            node.coordinate = GeoCoordinate(1 + i * 10, -1 - j * 20);
+            compressedStore.store(node, range, *styleProvider);
+        }
+    }
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 100, { { "any", "true" } });
+    node.coordinate = { 2, -2 };
+    ElementCounter all, intersecting, appended;
+
+    compressedStore.commit();
+    compressedStore.compact();
+    compressedStore.search(quadKey, all);
+    compressedStore.search(quadKey, BoundingBox(GeoCoordinate(0, -10), GeoCoordinate(10, 0)), intersecting);
+    compressedStore.store(node, range, *styleProvider);
+    compressedStore.commit();
+    compressedStore.search(quadKey, BoundingBox(GeoCoordinate(0, -10), GeoCoordinate(10, 0)), appended);
+
+    BOOST_CHECK(boost::filesystem::exists(TestZoomDirectory + "/0.bkt"));
+    BOOST_CHECK_EQUAL(all.times, 64);
+    BOOST_CHECK_EQUAL(intersecting.times, 1);
+    BOOST_CHECK_EQUAL(intersecting.element->id, 1);
+    BOOST_CHECK_EQUAL(appended.times, 2);
+    assertNode(node, *std::dynamic_pointer_cast<Node>(appended.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNode_WhenReopenStore_ThenHasDataIsAnsweredFromManifest)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } });
+    node.coordinate = { 5, -5 };
+    elementStore.store(node, range, *styleProvider);
+    elementStore.commit();
+
+    PersistentElementStore reopenedStore("", *dependencyProvider.getStringTable());
+
+    BOOST_CHECK(reopenedStore.hasData(QuadKey(1, 0, 0)));
+    BOOST_CHECK(!reopenedStore.hasData(QuadKey(1, 1, 1)));
+    std::ifstream manifest("tiles.mft");
+    BOOST_CHECK(manifest.good());
+}
+
+BOOST_AUTO_TEST_CASE(GivenNamedNode_WhenReopenStoreAndSearchByName_ThenItIsFound)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 7,
+        { { "any", "true" }, { "name", "Harbour Cafe" } });
+    node.coordinate = { 5, -5 };
+    elementStore.store(node, range, *styleProvider);
+    elementStore.commit();
+
+    PersistentElementStore reopenedStore("", *dependencyProvider.getStringTable());
+    auto matches = reopenedStore.searchByName("harb", GeoCoordinate(5, -5), 10);
+
+    BOOST_REQUIRE_EQUAL(matches.size(), 1);
+    BOOST_CHECK_EQUAL(matches[0].id, 7);
+    BOOST_CHECK_EQUAL(matches[0].name, "Harbour Cafe");
+    BOOST_CHECK_SMALL(matches[0].distance, 1E-3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNode_WhenReopenStoreAndSearchById_ThenItIsFoundThroughIdIndex)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } });
+    node1.coordinate = { 5, -5 };
+    Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, { { "any", "true" } });
+    node2.coordinate = { 6, -6 };
+    elementStore.store(node1, range, *styleProvider);
+    elementStore.store(node2, range, *styleProvider);
+    elementStore.commit();
+
+    PersistentElementStore reopenedStore("", *dependencyProvider.getStringTable());
+    auto quadKeys = reopenedStore.findQuadKeys(2);
+    ElementCounter counter;
+    BOOST_REQUIRE_EQUAL(quadKeys.size(), 1);
+    reopenedStore.searchById(quadKeys[0], 2, counter);
+
+    BOOST_CHECK(quadKeys[0] == QuadKey(1, 0, 0));
+    BOOST_CHECK_EQUAL(counter.times, 1);
+    assertNode(node2, *std::dynamic_pointer_cast<Node>(counter.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenMissingNameAndIdIndices_WhenReopenStore_ThenTheyAreRebuilt)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 7,
+        { { "any", "true" }, { "name", "Harbour Cafe" } });
+    node.coordinate = { 5, -5 };
+    elementStore.store(node, range, *styleProvider);
+    elementStore.commit();
+    BOOST_CHECK(!boost::filesystem::exists("names.idx.tmp"));
+    BOOST_CHECK(!boost::filesystem::exists("ids.idx.tmp"));
+    std::remove("names.idx");
+    std::remove("ids.idx");
+
+    PersistentElementStore reopenedStore("", *dependencyProvider.getStringTable());
+    auto matches = reopenedStore.searchByName("harb", GeoCoordinate(5, -5), 10);
+    auto quadKeys = reopenedStore.findQuadKeys(7);
+
+    BOOST_REQUIRE_EQUAL(matches.size(), 1);
+    BOOST_CHECK_EQUAL(matches[0].id, 7);
+    BOOST_CHECK_SMALL(matches[0].distance, 1E-3);
+    BOOST_REQUIRE_EQUAL(quadKeys.size(), 1);
+    BOOST_CHECK(quadKeys[0] == QuadKey(1, 0, 0));
+}
+
+BOOST_AUTO_TEST_CASE(GivenInterruptedCompaction_WhenReopenStore_ThenReplacementIsFinished)
+{
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } });
+    node1.coordinate = { 5, -5 };
+    Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, { { "any", "true" } });
+    node2.coordinate = { 6, -6 };
+    elementStore.store(node1, range, *styleProvider);
+    elementStore.store(node2, range, *styleProvider);
+    elementStore.commit();
+    std::string indexPath;
+    for (boost::filesystem::directory_iterator dirEnd, it(TestZoomDirectory); it != dirEnd; ++it) {
+        if (it->path().extension() == ".idx")
+            indexPath = it->path().generic_string();
+    }
+    BOOST_REQUIRE(!indexPath.empty());
+    boost::filesystem::copy_file(indexPath, indexPath + ".tmp");
+    // NOTE published index is damaged, so test fails if it is not replaced on open.
+    std::ofstream(indexPath, std::ios::out | std::ios::binary | std::ios::trunc).close();
+    {
+        std::ofstream journal("files.jrn", std::ios::out | std::ios::binary | std::ios::trunc);
+        std::uint32_t size = static_cast<std::uint32_t>(indexPath.size());
+        journal.put(0);
+        journal.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        journal.write(indexPath.data(), size);
+    }
+    ElementCounter counter;
+
+    PersistentElementStore reopenedStore("", *dependencyProvider.getStringTable());
+    reopenedStore.search(quadKey, counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 2);
+    BOOST_CHECK(!boost::filesystem::exists(indexPath + ".tmp"));
+    BOOST_CHECK(!boost::filesystem::exists("files.jrn"));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNode_WhenGetDataVersion_ThenItChangesOnlyWithCommittedData)
+{
+    LodRange range(1, 1);
+    QuadKey quadKey(1, 0, 0);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } });
+    node.coordinate = { 5, -5 };
+    std::uint64_t emptyVersion, version, reopenedVersion, updatedVersion;
+    BOOST_REQUIRE(elementStore.getDataVersion(quadKey, emptyVersion));
+    elementStore.store(node, range, *styleProvider);
+    elementStore.commit();
+    elementStore.getDataVersion(quadKey, version);
+
+    PersistentElementStore reopenedStore("", *dependencyProvider.getStringTable());
+    reopenedStore.getDataVersion(quadKey, reopenedVersion);
+    node.id = 2;
+    reopenedStore.store(node, range, *styleProvider);
+    reopenedStore.commit();
+    reopenedStore.getDataVersion(quadKey, updatedVersion);
+
+    BOOST_CHECK(version != emptyVersion);
+    BOOST_CHECK_EQUAL(reopenedVersion, version);
+    BOOST_CHECK(updatedVersion != version);
+}
+
+BOOST_AUTO_TEST_CASE(GivenLegacyManifest_WhenReopenStore_ThenHasDataIsAnsweredFromManifest)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } });
+    node.coordinate = { -5, 5 };
+    elementStore.store(node, range, *styleProvider);
+    elementStore.commit();
+    {
+        std::uint32_t header[2] = { 0x3146544D, 1 };
+        std::int32_t keys[3] = { 1, 1, 1 };
+        std::ofstream manifest("tiles.mft", std::ios::out | std::ios::binary | std::ios::trunc);
+        manifest.write(reinterpret_cast<const char*>(header), sizeof(header));
+        manifest.write(reinterpret_cast<const char*>(keys), sizeof(keys));
+    }
+
+    PersistentElementStore reopenedStore("", *dependencyProvider.getStringTable());
+
+    BOOST_CHECK(reopenedStore.hasData(QuadKey(1, 1, 1)));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoreWithUntypedIds_WhenReopenStore_ThenWayIdHasTypeBit)
+{
+    LodRange range(1, 1);
+    auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+    Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 7,
+        { { "any", "true" }, { "name", "Harbour Road" } });
+    way.coordinates = { { 5, -5 }, { 6, -6 } };
+    elementStore.store(way, range, *styleProvider);
+    elementStore.commit();
+    {
+        // NOTE previous version differs by manifest magic only.
+        std::uint32_t magic = 0x3246544D;
+        std::fstream manifest("tiles.mft", std::ios::in | std::ios::out | std::ios::binary);
+        manifest.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+    }
+
+    PersistentElementStore reopenedStore("", *dependencyProvider.getStringTable());
+    std::uint64_t id = utymap::formats::OsmElementId::way(7);
+    auto quadKeys = reopenedStore.findQuadKeys(id);
+    ElementCounter counter;
+    BOOST_REQUIRE_EQUAL(quadKeys.size(), 1);
+    reopenedStore.searchById(quadKeys[0], id, counter);
+    auto matches = reopenedStore.searchByName("harb", GeoCoordinate(5.5, -5.5), 10);
+
+    BOOST_CHECK(reopenedStore.findQuadKeys(7).empty());
+    BOOST_CHECK_EQUAL(counter.times, 1);
+    BOOST_CHECK_EQUAL(counter.element->id, id);
+    BOOST_REQUIRE_EQUAL(matches.size(), 1);
+    BOOST_CHECK_EQUAL(matches[0].id, id);
+}
+
+BOOST_AUTO_TEST_CASE(GivenEmptyStore_WhenSearch_ThenNothingIsReturned)
+{
+    ElementCounter counter;
+
+    elementStore.search(QuadKey(1, 1, 1), counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSharedStringTable_WhenStoreElementWithNewString_ThenThrows)
+{
+    const std::string sharedDirectory = "shared_strings/";
+    boost::filesystem::create_directories(sharedDirectory + TestZoomDirectory);
+    {
+        StringTable stringTable(sharedDirectory);
+        stringTable.getId("any");
+        stringTable.getId("true");
+    }
+    {
+        StringTable stringTable(sharedDirectory, true);
+        StyleProvider styleProvider(MapCssParser().parse(stylesheet), stringTable);
+        PersistentElementStore store(sharedDirectory, stringTable);
+        Node known = ElementUtils::createElement<Node>(stringTable, 1, { { "any", "true" } });
+        Node unknown = ElementUtils::createElement<Node>(stringTable, 2, { { "any", "new" } });
+        known.coordinate = unknown.coordinate = { 5, -5 };
+
+        BOOST_CHECK(store.store(known, LodRange(1, 1), styleProvider));
+        BOOST_CHECK_THROW(store.store(unknown, LodRange(1, 1), styleProvider), std::domain_error);
+    }
+    boost::filesystem::remove_all(sharedDirectory);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "index/PolygonSplitter.hpp"
+#include "utils/GeometryUtils.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+#include "test_utils/DependencyProvider.hpp"
+#include "test_utils/ElementUtils.hpp"
+
+using namespace utymap;
+using namespace utymap::entities;
+using namespace utymap::index;
+
+namespace {
+    const QuadKey TileQuadKey(1, 1, 0);
+
+    /// Returns counterclockwise circle inside tile.
+    std::vector<GeoCoordinate> createCircle(std::size_t points)
+    {
+        std::vector<GeoCoordinate> coordinates;
+        for (std::size_t i = 0; i < points; ++i) {
+            double angle = 2 * std::acos(-1) * i / points;
+            coordinates.push_back(GeoCoordinate(40 + 30 * std::sin(angle), 90 + 30 * std::cos(angle)));
+        }
+        return coordinates;
+    }
+
+    double getTotalArea(const Relation& relation)
+    {
+        double area = 0;
+        for (const auto& piece : relation.elements)
+            for (const auto& member : static_cast<const Relation&>(*piece).elements)
+                area += utymap::utils::getArea(static_cast<const Area&>(*member).coordinates);
+        return area;
+    }
+
+    struct Index_PolygonSplitterFixture
+    {
+        DependencyProvider dependencyProvider;
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(Index_PolygonSplitter, Index_PolygonSplitterFixture)
+
+BOOST_AUTO_TEST_CASE(GivenLargeArea_WhenSplit_ThenPiecesAreSmallAndCoverArea)
+{
+    Area area = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 7, { { "natural", "water" } });
+    area.coordinates = createCircle(400);
+
+    auto result = PolygonSplitter(100).split(area, TileQuadKey);
+
+    BOOST_REQUIRE(result != nullptr);
+    BOOST_REQUIRE(result->type == ElementType::Relation);
+    const auto& relation = static_cast<const Relation&>(*result);
+    BOOST_CHECK_EQUAL(relation.id, 7);
+    BOOST_CHECK_EQUAL(relation.tags.size(), 1);
+    BOOST_CHECK_GT(relation.elements.size(), 4);
+    for (const auto& piece : relation.elements) {
+        BOOST_CHECK(piece->type == ElementType::Relation);
+        BOOST_CHECK_EQUAL(piece->tags.size(), 1);
+        BOOST_CHECK_LE(PolygonSplitter::countVertices(*piece), 100);
+    }
+    BOOST_CHECK_CLOSE(getTotalArea(relation), utymap::utils::getArea(area.coordinates), 0.1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSmallArea_WhenSplit_ThenReturnsNull)
+{
+    Area area = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 7, { { "natural", "water" } });
+    area.coordinates = createCircle(50);
+
+    BOOST_CHECK(PolygonSplitter(100).split(area, TileQuadKey) == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
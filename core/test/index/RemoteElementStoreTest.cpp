@@ -0,0 +1,229 @@
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "index/PersistentElementStore.hpp"
+#include "index/RemoteElementStore.hpp"
+#include "index/StringTable.hpp"
+#include "mapcss/MapCssParser.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include "test_utils/DependencyProvider.hpp"
+#include "test_utils/ElementUtils.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::entities;
+using namespace utymap::index;
+
+namespace {
+    const std::string RemoteDirectory = "remote/";
+    const std::string CacheDirectory = "cache/";
+    const std::string TileFile = "1/0.dat";
+
+    const std::string stylesheet = "node|z1[any], way|z1[any] { clip: false; }";
+
+    struct Index_RemoteElementStoreFixture
+    {
+        Index_RemoteElementStoreFixture() :
+            dependencyProvider(), requests(), requestsLock()
+        {
+            boost::filesystem::create_directories(RemoteDirectory + "1");
+            boost::filesystem::create_directories(CacheDirectory + "1");
+            // NOTE remote strings get ids which differ from ids of local table.
+            remoteStringTable = utymap::utils::make_unique<StringTable>(RemoteDirectory);
+            remoteStringTable->getId("remote only");
+
+            PersistentElementStore remoteStore(RemoteDirectory, *remoteStringTable);
+            Node node = ElementUtils::createElement<Node>(*remoteStringTable, 7, { { "any", "true" } });
+            node.coordinate = { 5, -5 };
+            remoteStore.store(node, LodRange(1, 1), *getRemoteStyleProvider());
+            remoteStore.commit();
+            remoteStringTable->flush();
+        }
+
+        ~Index_RemoteElementStoreFixture()
+        {
+            remoteStringTable.reset();
+            boost::filesystem::remove_all(RemoteDirectory);
+            boost::filesystem::remove_all(CacheDirectory);
+        }
+
+        /// Copies file of remote directory counting requests.
+        RemoteElementStore::Fetcher createFetcher()
+        {
+            return [this](const std::string& path, const std::string& destinationPath) {
+                {
+                    std::lock_guard<std::mutex> lock(requestsLock);
+                    ++requests[path];
+                }
+                boost::system::error_code error;
+                boost::filesystem::copy_file(RemoteDirectory + path, destinationPath,
+                                             boost::filesystem::copy_option::overwrite_if_exists, error);
+                return !error;
+            };
+        }
+
+        int getRequests(const std::string& path)
+        {
+            std::lock_guard<std::mutex> lock(requestsLock);
+            return requests[path];
+        }
+
+        /// Returns style provider which uses string table of remote store.
+        std::shared_ptr<mapcss::StyleProvider> getRemoteStyleProvider()
+        {
+            mapcss::StyleSheet styleSheet = mapcss::MapCssParser().parse(stylesheet);
+            return std::make_shared<mapcss::StyleProvider>(styleSheet, *remoteStringTable);
+        }
+
+        DependencyProvider dependencyProvider;
+        std::unique_ptr<StringTable> remoteStringTable;
+        std::map<std::string, int> requests;
+        std::mutex requestsLock;
+    };
+
+    struct ElementCounter : public ElementVisitor
+    {
+        int times = 0;
+        std::uint64_t id = 0;
+
+        void visitNode(const Node& node) override { ++times; id = node.id; }
+        void visitWay(const Way& way) override { ++times; }
+        void visitArea(const Area& area) override { ++times; }
+        void visitRelation(const Relation& relation) override { ++times; }
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(Index_RemoteElementStore, Index_RemoteElementStoreFixture)
+
+BOOST_AUTO_TEST_CASE(GivenRemoteManifest_WhenHasData_ThenTilesAreNotFetched)
+{
+    RemoteElementStore store(CacheDirectory, *dependencyProvider.getStringTable(), createFetcher());
+
+    BOOST_CHECK(store.hasData(QuadKey(1, 0, 0)));
+    BOOST_CHECK(!store.hasData(QuadKey(1, 1, 1)));
+    BOOST_CHECK_EQUAL(getRequests("tiles.mft"), 1);
+    BOOST_CHECK_EQUAL(getRequests(TileFile), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRemoteTile_WhenSearchTwice_ThenItIsFetchedOnceAndReadBack)
+{
+    RemoteElementStore store(CacheDirectory, *dependencyProvider.getStringTable(), createFetcher());
+    ElementCounter first, second;
+
+    store.search(QuadKey(1, 0, 0), first);
+    store.search(QuadKey(1, 0, 0), second);
+
+    BOOST_CHECK_EQUAL(first.times, 1);
+    BOOST_CHECK_EQUAL(first.id, 7);
+    BOOST_CHECK_EQUAL(second.times, 1);
+    BOOST_CHECK_EQUAL(getRequests(TileFile), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenConcurrentPrefetchesAndSearches_WhenWait_ThenTileIsFetchedOnce)
+{
+    RemoteElementStore store(CacheDirectory, *dependencyProvider.getStringTable(), createFetcher());
+    std::vector<ElementCounter> counters(4);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < 4; ++i)
+        store.prefetch(QuadKey(1, 0, 0));
+    for (auto& counter : counters)
+        threads.emplace_back([&]() { store.search(QuadKey(1, 0, 0), counter); });
+    for (auto& thread : threads)
+        thread.join();
+
+    for (const auto& counter : counters)
+        BOOST_CHECK_EQUAL(counter.times, 1);
+    BOOST_CHECK_EQUAL(getRequests(TileFile), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCachedTile_WhenSearchAgainWithNewStore_ThenItIsNotFetched)
+{
+    {
+        RemoteElementStore store(CacheDirectory, *dependencyProvider.getStringTable(), createFetcher());
+        store.prefetch(QuadKey(1, 0, 0));
+    }
+    RemoteElementStore store(CacheDirectory, *dependencyProvider.getStringTable(), createFetcher());
+    ElementCounter counter;
+
+    store.search(QuadKey(1, 0, 0), counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 1);
+    BOOST_CHECK(getRequests(TileFile) <= 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCachedTile_WhenRemoteStoreIsRegenerated_ThenTileIsFetchedAgain)
+{
+    {
+        RemoteElementStore store(CacheDirectory, *dependencyProvider.getStringTable(), createFetcher());
+        ElementCounter counter;
+        store.search(QuadKey(1, 0, 0), counter);
+    }
+    boost::filesystem::remove_all(RemoteDirectory);
+    boost::filesystem::create_directories(RemoteDirectory + "1");
+    {
+        PersistentElementStore remoteStore(RemoteDirectory, *remoteStringTable);
+        Way way = ElementUtils::createElement<Way>(*remoteStringTable, 9, { { "any", "true" } });
+        way.coordinates = { { 5, -5 }, { 5, 5 } };
+        remoteStore.store(way, LodRange(1, 1), *getRemoteStyleProvider());
+        remoteStore.commit();
+        remoteStringTable->flush();
+    }
+    BOOST_REQUIRE(boost::filesystem::exists(RemoteDirectory + "1/shared.dat"));
+    RemoteElementStore store(CacheDirectory, *dependencyProvider.getStringTable(), createFetcher());
+    ElementCounter counter;
+
+    store.search(QuadKey(1, 0, 0), counter);
+
+    BOOST_CHECK_EQUAL(counter.times, 1);
+    BOOST_CHECK_EQUAL(counter.id, 0);
+    BOOST_CHECK_EQUAL(getRequests(TileFile), 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSeparateStringTables_WhenSearch_ThenTagsHaveLocalIds)
+{
+    StringTable& localStringTable = *dependencyProvider.getStringTable();
+    localStringTable.getId("local only");
+    localStringTable.getId("another local only");
+    RemoteElementStore store(CacheDirectory, localStringTable, createFetcher());
+    ElementCounter counter;
+    std::vector<Tag> tags;
+    struct : public ElementVisitor
+    {
+        std::vector<Tag>* tags;
+        void visitNode(const Node& node) override { *tags = node.tags; }
+        void visitWay(const Way&) override {}
+        void visitArea(const Area&) override {}
+        void visitRelation(const Relation&) override {}
+    } tagVisitor;
+    tagVisitor.tags = &tags;
+
+    store.search(QuadKey(1, 0, 0), tagVisitor);
+    store.searchByTag(QuadKey(1, 0, 0), BoundingBox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180)),
+                      { Tag(localStringTable.getId("any"), localStringTable.getId("true")) }, counter);
+
+    BOOST_REQUIRE_EQUAL(tags.size(), 1);
+    BOOST_CHECK_NE(localStringTable.getId("any"), remoteStringTable->getId("any"));
+    BOOST_CHECK_EQUAL(localStringTable.getString(tags[0].key), "any");
+    BOOST_CHECK_EQUAL(localStringTable.getString(tags[0].value), "true");
+    BOOST_CHECK_EQUAL(counter.times, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRemoteStore_WhenStore_ThenThrows)
+{
+    RemoteElementStore store(CacheDirectory, *dependencyProvider.getStringTable(), createFetcher());
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 8, { { "any", "true" } });
+    node.coordinate = { 5, -5 };
+
+    BOOST_CHECK_THROW(store.store(node, LodRange(1, 1), *dependencyProvider.getStyleProvider(stylesheet)),
+                      std::domain_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
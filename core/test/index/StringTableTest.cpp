@@ -4,6 +4,9 @@
 #include "test_utils/DependencyProvider.hpp"
 
 #include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
 
 using namespace utymap::index;
 
@@ -56,4 +59,238 @@ BOOST_AUTO_TEST_CASE(GivenThreeStrings_WhenGetStringOfSecond_ThenReturnValidStri
     BOOST_CHECK_EQUAL( str, "string2" );
 }
 
+BOOST_AUTO_TEST_CASE(GivenBatchWithDuplicates_WhenGetIds_ThenReturnSameIdsAsGetId)
+{
+    depedencyProvider.getStringTable()->getId("string1");
+    std::vector<const char*> strings = { "string2", "string1", "string2", "" };
+
+    std::vector<std::uint32_t> ids = depedencyProvider.getStringTable()->getIds(strings);
+
+    BOOST_CHECK_EQUAL(ids.size(), 4);
+    BOOST_CHECK_EQUAL(ids[0], 1);
+    BOOST_CHECK_EQUAL(ids[1], 0);
+    BOOST_CHECK_EQUAL(ids[2], 1);
+    BOOST_CHECK_EQUAL(ids[3], depedencyProvider.getStringTable()->getId(""));
+    BOOST_CHECK_EQUAL(depedencyProvider.getStringTable()->getString(ids[0]), "string2");
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredStrings_WhenReopen_ThenReturnSameIdsAndStrings)
+{
+    {
+        StringTable stringTable("");
+        stringTable.getId("string1");
+        stringTable.getId("string2");
+    }
+
+    StringTable stringTable("");
+
+    BOOST_CHECK_EQUAL(stringTable.getString(1), "string2");
+    BOOST_CHECK_EQUAL(stringTable.getId("string1"), 0);
+    BOOST_CHECK_EQUAL(stringTable.getId("string3"), 2);
+    std::remove("string.idx");
+    std::remove("string.dat");
+    std::remove("string.hsh");
+}
+
+BOOST_AUTO_TEST_CASE(GivenStringWithNullCharacter_WhenReopen_ThenItIsNotTruncated)
+{
+    const std::string withNull("first\0second", 12);
+    {
+        StringTable stringTable("");
+        stringTable.getId("first");
+        stringTable.getId(withNull);
+        stringTable.getId("last");
+    }
+
+    StringTable stringTable("");
+
+    BOOST_CHECK(stringTable.getString(1) == withNull);
+    BOOST_CHECK_EQUAL(stringTable.getString(2), "last");
+    BOOST_CHECK_EQUAL(stringTable.getId(withNull), 1);
+    BOOST_CHECK_EQUAL(stringTable.getId("first"), 0);
+    std::remove("string.idx");
+    std::remove("string.dat");
+    std::remove("string.hsh");
+}
+
+BOOST_AUTO_TEST_CASE(GivenStaleHashIndex_WhenReopen_ThenReturnSameIds)
+{
+    {
+        StringTable stringTable("");
+        stringTable.getId("string1");
+        stringTable.getId("string2");
+    }
+    std::remove("string.hsh");
+
+    StringTable stringTable("");
+
+    BOOST_CHECK_EQUAL(stringTable.getId("string2"), 1);
+    BOOST_CHECK_EQUAL(stringTable.getId("string1"), 0);
+    BOOST_CHECK_EQUAL(stringTable.getString(0), "string1");
+    std::remove("string.idx");
+    std::remove("string.dat");
+    std::remove("string.hsh");
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredStrings_WhenOpenSharedTables_ThenNewStringsAreNotWritten)
+{
+    {
+        StringTable stringTable("");
+        stringTable.getId("string1");
+        stringTable.getId("string2");
+    }
+
+    {
+        StringTable first("", true);
+        StringTable second("", true);
+
+        BOOST_CHECK_EQUAL(first.getId("string2"), 1);
+        BOOST_CHECK_EQUAL(second.getString(0), "string1");
+        BOOST_CHECK_EQUAL(first.getId("string3"), 2);
+        BOOST_CHECK_EQUAL(first.getString(2), "string3");
+        BOOST_CHECK_EQUAL(second.size(), 2);
+        BOOST_CHECK(first.isPersistent(1));
+        BOOST_CHECK(!first.isPersistent(2));
+        first.flush();
+    }
+
+    StringTable stringTable("");
+    BOOST_CHECK_EQUAL(stringTable.size(), 2);
+    std::remove("string.idx");
+    std::remove("string.dat");
+    std::remove("string.hsh");
+}
+
+BOOST_AUTO_TEST_CASE(GivenPackedStrings_WhenReopen_ThenReturnSameIdsAndStringsUsingSmallerFile)
+{
+    const std::uint32_t count = 1000;
+    auto createString = [](std::uint32_t i) {
+        return (i % 2 == 0 ? "addr:street:" : "name:") + std::to_string(i);
+    };
+    {
+        StringTable stringTable("");
+        for (std::uint32_t i = 0; i < count; ++i)
+            stringTable.getId(createString(i));
+    }
+    std::ifstream dataFile("string.dat", std::ios::binary | std::ios::ate);
+    auto dataSize = static_cast<std::size_t>(dataFile.tellg());
+    dataFile.close();
+
+    StringTable::pack("");
+    std::remove("string.hsh");
+
+    {
+        StringTable stringTable("");
+        BOOST_CHECK_EQUAL(stringTable.size(), count);
+        BOOST_CHECK_EQUAL(stringTable.getString(999), createString(999));
+        for (std::uint32_t i = 0; i < count; i += 7)
+            BOOST_CHECK_EQUAL(stringTable.getString(i), createString(i));
+        BOOST_CHECK_EQUAL(stringTable.getId(createString(500)), 500);
+        BOOST_CHECK_EQUAL(stringTable.getNumber(stringTable.getId("42")), 42);
+    }
+    std::ifstream packedFile("string.fcd", std::ios::binary | std::ios::ate);
+    BOOST_CHECK_LT(static_cast<std::size_t>(packedFile.tellg()), dataSize / 2);
+    packedFile.close();
+
+    StringTable stringTable("");
+    BOOST_CHECK_EQUAL(stringTable.getId("42"), count);
+    BOOST_CHECK_EQUAL(stringTable.getId(createString(1)), 1);
+    std::remove("string.idx");
+    std::remove("string.dat");
+    std::remove("string.hsh");
+    std::remove("string.fcd");
+}
+
+BOOST_AUTO_TEST_CASE(GivenPackingInterruptedBeforeTruncation_WhenReopen_ThenPackedStringsAreNotDuplicated)
+{
+    {
+        StringTable stringTable("");
+        stringTable.getId("string0");
+        stringTable.getId("string1");
+    }
+    auto readFile = [](const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+    std::string index = readFile("string.idx"), data = readFile("string.dat");
+    StringTable::pack("");
+    std::ofstream("string.idx", std::ios::binary | std::ios::trunc) << index;
+    std::ofstream("string.dat", std::ios::binary | std::ios::trunc) << data;
+    std::remove("string.hsh");
+
+    {
+        StringTable stringTable("");
+        BOOST_CHECK_EQUAL(stringTable.size(), 2);
+        BOOST_CHECK_EQUAL(stringTable.getId("string1"), 1);
+        BOOST_CHECK_EQUAL(stringTable.getId("string2"), 2);
+    }
+    StringTable stringTable("");
+    BOOST_CHECK_EQUAL(stringTable.size(), 3);
+    BOOST_CHECK_EQUAL(stringTable.getString(2), "string2");
+    std::remove("string.idx");
+    std::remove("string.dat");
+    std::remove("string.hsh");
+    std::remove("string.fcd");
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyStrings_WhenGetIdAgain_ThenReturnSameIds)
+{
+    const std::uint32_t count = 100000;
+    for (std::uint32_t i = 0; i < count; ++i)
+        depedencyProvider.getStringTable()->getId("string" + std::to_string(i));
+
+    for (std::uint32_t i = 0; i < count; i += 997)
+        BOOST_CHECK_EQUAL(depedencyProvider.getStringTable()->getId("string" + std::to_string(i)), i);
+    BOOST_CHECK_EQUAL(depedencyProvider.getStringTable()->getString(count - 1), "string" + std::to_string(count - 1));
+}
+
+BOOST_AUTO_TEST_CASE(GivenThreeStrings_WhenGetSize_ThenReturnThree)
+{
+    depedencyProvider.getStringTable()->getId("string1");
+    depedencyProvider.getStringTable()->getId("string2");
+    depedencyProvider.getStringTable()->getId("string1");
+    depedencyProvider.getStringTable()->getId("string3");
+
+    BOOST_CHECK_EQUAL(depedencyProvider.getStringTable()->size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNewStrings_WhenGetMemoryUsage_ThenItGrows)
+{
+    std::size_t initialUsage = depedencyProvider.getStringTable()->getMemoryUsage();
+
+    depedencyProvider.getStringTable()->getId("string1");
+
+    BOOST_CHECK_GT(depedencyProvider.getStringTable()->getMemoryUsage(), initialUsage);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNonExistingId_WhenGetString_ThenReturnEmptyString)
+{
+    depedencyProvider.getStringTable()->getId("string1");
+
+    std::string str = depedencyProvider.getStringTable()->getString(1);
+
+    BOOST_CHECK(str.empty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenNumericAndTextStrings_WhenGetNumber_ThenReturnParsedValues)
+{
+    {
+        StringTable stringTable("");
+        stringTable.getId("5");
+    }
+    StringTable stringTable("");
+    std::uint32_t mappedId = stringTable.getId("5");
+    std::uint32_t newId = stringTable.getId("2.5");
+    std::uint32_t textId = stringTable.getId("text");
+
+    BOOST_CHECK_EQUAL(stringTable.getNumber(mappedId), 5);
+    BOOST_CHECK_EQUAL(stringTable.getNumber(newId), 2.5);
+    BOOST_CHECK_EQUAL(stringTable.getNumber(newId), 2.5);
+    BOOST_CHECK_EQUAL(stringTable.getNumber(textId), 0);
+    BOOST_CHECK_EQUAL(stringTable.getNumber(textId + 1), 0);
+    std::remove("string.idx");
+    std::remove("string.dat");
+    std::remove("string.hsh");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
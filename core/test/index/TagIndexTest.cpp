@@ -0,0 +1,37 @@
+#include "index/TagIndex.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap::entities;
+using namespace utymap::index;
+
+BOOST_AUTO_TEST_SUITE(Index_TagIndex)
+
+BOOST_AUTO_TEST_CASE(GivenElementsWithTags_WhenFindByOneTag_ThenAllPositionsAreReturned)
+{
+    TagIndex index;
+    index.add(0, { Tag(1, 2) });
+    index.add(3, { Tag(1, 2), Tag(1, 2) });
+    index.add(200, { Tag(1, 3) });
+    index.add(70000, { Tag(1, 2) });
+
+    auto positions = index.find({ Tag(1, 2) });
+
+    BOOST_CHECK((positions == std::vector<std::uint32_t> { 0, 3, 70000 }));
+    BOOST_CHECK(index.getMemoryUsage() > 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenElementsWithTags_WhenFindBySeveralTags_ThenIntersectionIsReturned)
+{
+    TagIndex index;
+    index.add(1, { Tag(1, 2), Tag(5, 6) });
+    index.add(2, { Tag(1, 2) });
+    index.add(4, { Tag(5, 6), Tag(1, 2) });
+    index.add(8, { Tag(5, 6) });
+
+    BOOST_CHECK((index.find({ Tag(1, 2), Tag(5, 6) }) == std::vector<std::uint32_t> { 1, 4 }));
+    BOOST_CHECK(index.find({ Tag(1, 2), Tag(7, 7) }).empty());
+    BOOST_CHECK(index.find({}).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
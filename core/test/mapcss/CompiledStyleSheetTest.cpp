@@ -0,0 +1,80 @@
+#include "config.hpp"
+#include "mapcss/CompiledStyleSheet.hpp"
+#include "mapcss/MapCssParser.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+using namespace utymap::mapcss;
+using namespace utymap::meshing;
+
+namespace {
+    const double precision = 1E-9;
+    const std::string CompiledPath = "import.mapcss.bin";
+
+    struct MapCss_CompiledStyleSheetFixture
+    {
+        MapCss_CompiledStyleSheetFixture()
+        {
+            std::ifstream styleFile(TEST_MAPCSS_PATH "import.mapcss");
+            MapCssParser parser(TEST_MAPCSS_PATH);
+            stylesheet = parser.parse(styleFile);
+            CompiledStyleSheet::write(stylesheet, CompiledPath);
+        }
+
+        ~MapCss_CompiledStyleSheetFixture()
+        {
+            std::remove(CompiledPath.c_str());
+        }
+
+        StyleSheet stylesheet;
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(MapCss_CompiledStyleSheet, MapCss_CompiledStyleSheetFixture)
+
+BOOST_AUTO_TEST_CASE(GivenCompiledStyleSheet_WhenRead_ThenRulesAreSame)
+{
+    StyleSheet compiled = CompiledStyleSheet::read(CompiledPath);
+
+    BOOST_REQUIRE_EQUAL(compiled.rules.size(), stylesheet.rules.size());
+    for (std::size_t i = 0; i < stylesheet.rules.size(); ++i)
+        BOOST_CHECK_EQUAL(utymap::utils::toString(compiled.rules[i]), utymap::utils::toString(stylesheet.rules[i]));
+}
+
+BOOST_AUTO_TEST_CASE(GivenCompiledStyleSheet_WhenRead_ThenTexturesAreSame)
+{
+    StyleSheet compiled = CompiledStyleSheet::read(CompiledPath);
+
+    BOOST_REQUIRE_EQUAL(compiled.textures.size(), stylesheet.textures.size());
+    for (std::uint32_t seed = 0; seed < 2; ++seed) {
+        auto expected = stylesheet.textures[0].get("simple").random(seed).map(Vector2(0.5, 0.5));
+        auto actual = compiled.textures[0].get("simple").random(seed).map(Vector2(0.5, 0.5));
+        BOOST_CHECK_CLOSE(actual.x, expected.x, precision);
+        BOOST_CHECK_CLOSE(actual.y, expected.y, precision);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GivenFiles_WhenIsCompiled_ThenOnlyCompiledIsDetected)
+{
+    BOOST_CHECK(CompiledStyleSheet::isCompiled(CompiledPath));
+    BOOST_CHECK(!CompiledStyleSheet::isCompiled(TEST_MAPCSS_PATH "import.mapcss"));
+}
+
+BOOST_AUTO_TEST_CASE(GivenTruncatedFile_WhenRead_ThenThrowsException)
+{
+    std::ifstream input(CompiledPath, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    input.close();
+    std::ofstream output(CompiledPath, std::ios::binary | std::ios::trunc);
+    output.write(data.data(), data.size() / 2);
+    output.close();
+
+    BOOST_CHECK_THROW(CompiledStyleSheet::read(CompiledPath), std::domain_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
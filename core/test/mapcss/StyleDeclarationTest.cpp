@@ -23,7 +23,7 @@ BOOST_FIXTURE_TEST_SUITE(MapCss_StyleDeclaration, MapCss_StyleDeclarationFixture
 
 BOOST_AUTO_TEST_CASE(GivenOnlySingleTag_WhenDoubleEvaluate_ThenReturnValue)
 {
-    StyleDeclaration styleDeclaration(0, "eval(\"tag('height')\")");
+    StyleDeclaration styleDeclaration(0, "eval(\"tag('height')\")", *dependencyProvider.getStringTable());
 
     double result = styleDeclaration.evaluate<double>(
         ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0, { { "height", "2.5" } }).tags,
@@ -34,7 +34,7 @@ BOOST_AUTO_TEST_CASE(GivenOnlySingleTag_WhenDoubleEvaluate_ThenReturnValue)
 
 BOOST_AUTO_TEST_CASE(GiveTwoTags_WhenDoubleEvaluate_ThenReturnValue)
 {
-    StyleDeclaration styleDeclaration(0, "eval(\"tag('building:height') - tag('roof:height')\")");
+    StyleDeclaration styleDeclaration(0, "eval(\"tag('building:height') - tag('roof:height')\")", *dependencyProvider.getStringTable());
 
     double result = styleDeclaration.evaluate<double>(ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(),
         0, { { "building:height", "10" }, { "roof:height", "2.5" } }).tags,
@@ -45,7 +45,7 @@ BOOST_AUTO_TEST_CASE(GiveTwoTags_WhenDoubleEvaluate_ThenReturnValue)
 
 BOOST_AUTO_TEST_CASE(GiveOneTagOneNumber_WhenDoubleEvaluate_ThenReturnValue)
 {
-    StyleDeclaration styleDeclaration(0, "eval(\"tag('building:levels') * 3\")");
+    StyleDeclaration styleDeclaration(0, "eval(\"tag('building:levels') * 3\")", *dependencyProvider.getStringTable());
 
     double result = styleDeclaration.evaluate<double>(ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 
         0, { { "building:levels", "5" } }).tags,
@@ -56,7 +56,7 @@ BOOST_AUTO_TEST_CASE(GiveOneTagOneNumber_WhenDoubleEvaluate_ThenReturnValue)
 
 BOOST_AUTO_TEST_CASE(GiveRawValue_WhenDoubleEvaluate_ThenThrowsException)
 {
-    StyleDeclaration styleDeclaration(0, "13");
+    StyleDeclaration styleDeclaration(0, "13", *dependencyProvider.getStringTable());
 
     BOOST_CHECK_THROW(styleDeclaration.evaluate<double>(ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(),
         0, { { "building:levels", "5" } }).tags, *dependencyProvider.getStringTable()),
@@ -65,7 +65,7 @@ BOOST_AUTO_TEST_CASE(GiveRawValue_WhenDoubleEvaluate_ThenThrowsException)
 
 BOOST_AUTO_TEST_CASE(GiveOneTagOneNumber_WhenStringEvaluate_ThenReturnValue)
 {
-    StyleDeclaration styleDeclaration(0, "eval(\"tag('color')\")");
+    StyleDeclaration styleDeclaration(0, "eval(\"tag('color')\")", *dependencyProvider.getStringTable());
 
     std::string result = styleDeclaration.evaluate<std::string>(ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(),
         0, { { "color", "red" } }).tags,
@@ -74,4 +74,43 @@ BOOST_AUTO_TEST_CASE(GiveOneTagOneNumber_WhenStringEvaluate_ThenReturnValue)
     BOOST_CHECK_EQUAL(result, "red");
 }
 
+BOOST_AUTO_TEST_CASE(GivenRawValuesWithUnits_WhenConstruct_ThenNumberAndUnitAreParsed)
+{
+    StringTable& stringTable = *dependencyProvider.getStringTable();
+    StyleDeclaration meters(0, "12.5m", stringTable), percent(0, "40%", stringTable),
+        number(0, "3", stringTable), text(0, "red", stringTable);
+
+    BOOST_CHECK(meters.unit() == StyleDeclaration::Unit::Meters);
+    BOOST_CHECK_EQUAL(meters.number(), 12.5);
+    BOOST_CHECK(percent.unit() == StyleDeclaration::Unit::Percent);
+    BOOST_CHECK_EQUAL(percent.number(), 40);
+    BOOST_CHECK(number.unit() == StyleDeclaration::Unit::None);
+    BOOST_CHECK_EQUAL(number.number(), 3);
+    BOOST_CHECK_EQUAL(text.number(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNestedSignedExpression_WhenDoubleEvaluate_ThenReturnValue)
+{
+    StyleDeclaration styleDeclaration(0, "eval(\"-tag('height') * 2 + (eval(\"tag('min_height') - 1\")) / 4\")",
+        *dependencyProvider.getStringTable());
+
+    double result = styleDeclaration.evaluate<double>(ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(),
+        0, { { "height", "3" }, { "min_height", "9" } }).tags,
+        *dependencyProvider.getStringTable());
+
+    BOOST_CHECK(styleDeclaration.isEval());
+    BOOST_CHECK_EQUAL(result, -4);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMissingTag_WhenDoubleEvaluate_ThenTagIsZero)
+{
+    StyleDeclaration styleDeclaration(0, "eval(\"tag('height') + 1\")", *dependencyProvider.getStringTable());
+
+    double result = styleDeclaration.evaluate<double>(ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(),
+        0, { { "name", "tower" } }).tags,
+        *dependencyProvider.getStringTable());
+
+    BOOST_CHECK_EQUAL(result, 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -2,10 +2,14 @@
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
 #include "entities/Relation.hpp"
+#include "mapcss/MapCssParser.hpp"
 #include "mapcss/StyleProvider.hpp"
 #include "test_utils/ElementUtils.hpp"
 
 #include <boost/test/unit_test.hpp>
+
+#include <future>
+#include <vector>
 #include "test_utils/DependencyProvider.hpp"
 
 using namespace utymap::entities;
@@ -110,6 +114,30 @@ BOOST_AUTO_TEST_CASE(GivenSimpleEqualsConditionButDifferentZoomLevel_WhenHasStyl
     BOOST_CHECK(!styleProvider->hasStyle(node, 2));
 }
 
+BOOST_AUTO_TEST_CASE(GivenElementWithoutRequiredKey_WhenHasStyle_ThenReturnFalse)
+{
+    int zoomLevel = 1;
+    setSingleSelector(zoomLevel, zoomLevel, { "node" }, { { "amenity", "=", "biergarten" } });
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0,
+    {
+        std::make_pair("building", "yes"),
+        std::make_pair("highway", "primary"),
+        std::make_pair("name", "biergarten")
+    });
+
+    BOOST_CHECK(!styleProvider->hasStyle(node, zoomLevel));
+    BOOST_CHECK(styleProvider->forElement(node, zoomLevel).declarations().empty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenSelectorWithoutConditions_WhenHasStyleForElementWithoutTags_ThenReturnTrue)
+{
+    int zoomLevel = 1;
+    setSingleSelector(zoomLevel, zoomLevel, { "node" }, { });
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0, { });
+
+    BOOST_CHECK(styleProvider->hasStyle(node, zoomLevel));
+}
+
 BOOST_AUTO_TEST_CASE(GivenTwoEqualsConditions_WhenHasStyle_ThenReturnTrue)
 {
     int zoomLevel = 1;
@@ -144,4 +172,209 @@ BOOST_AUTO_TEST_CASE(GivenTwoNotEqualsConditions_WhenHasStyle_ThenReturnFalse)
     BOOST_CHECK(!styleProvider->hasStyle(node, zoomLevel));
 }
 
+BOOST_AUTO_TEST_CASE(GivenLodRange_WhenForElement_ThenReturnStylesOnlyForMatchedLods)
+{
+    auto provider = dependencyProvider.getStyleProvider(
+        "node|z1[amenity] { a: b; } node|z3[amenity] { c: d; } node|z2[shop] { e: f; }");
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0,
+        { std::make_pair("amenity", "biergarten") });
+
+    LodStyles lodStyles = provider->forElement(node, utymap::LodRange(1, 3));
+
+    BOOST_CHECK_EQUAL(lodStyles.styles.size(), 2);
+    BOOST_CHECK_EQUAL(lodStyles.indices.size(), 3);
+    BOOST_CHECK_EQUAL(lodStyles.indices[0], 0);
+    BOOST_CHECK_EQUAL(lodStyles.indices[1], -1);
+    BOOST_CHECK_EQUAL(lodStyles.indices[2], 1);
+    BOOST_CHECK_EQUAL(lodStyles.styles[0].getString("a"), "b");
+    BOOST_CHECK_EQUAL(lodStyles.styles[1].getString("c"), "d");
+}
+
+BOOST_AUTO_TEST_CASE(GivenRuleWithZoomRange_WhenForElement_ThenEveryLodHasSameFiltersAndStyle)
+{
+    auto provider = dependencyProvider.getStyleProvider("node|z1-3[amenity=biergarten] { a: b; }");
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0,
+        { std::make_pair("amenity", "biergarten") });
+    Node other = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1,
+        { std::make_pair("shop", "bakery") });
+
+    LodStyles lodStyles = provider->forElement(node, utymap::LodRange(1, 3));
+
+    BOOST_CHECK_EQUAL(provider->forElement(node, 3).getString("a"), "b");
+    BOOST_CHECK(!provider->hasStyle(other, 2));
+    BOOST_CHECK(!provider->hasStyle(other, 3));
+    BOOST_REQUIRE_EQUAL(lodStyles.styles.size(), 1);
+    std::vector<int> expected = { 0, 0, 0 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(lodStyles.indices.begin(), lodStyles.indices.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenRulesWithDifferentAnchors_WhenForElement_ThenDeclarationsAreMergedInRuleOrder)
+{
+    auto provider = dependencyProvider.getStyleProvider(
+        "way|z1[highway] { width: 1; color: red; }"
+        "way|z1[highway=primary][lanes>1] { width: 2; }"
+        "way|z1[highway=secondary] { width: 3; }"
+        "way|z1[lanes] { color: blue; }");
+    Way primary = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 0,
+        { { "highway", "primary" }, { "lanes", "2" } });
+    Way narrowPrimary = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 0,
+        { { "highway", "primary" }, { "lanes", "1" } });
+    Way other = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 0,
+        { { "name", "primary" } });
+
+    Style primaryStyle = provider->forElement(primary, 1);
+    Style narrowStyle = provider->forElement(narrowPrimary, 1);
+
+    BOOST_CHECK_EQUAL(primaryStyle.getString("width"), "2");
+    BOOST_CHECK_EQUAL(primaryStyle.getString("color"), "blue");
+    BOOST_CHECK_EQUAL(narrowStyle.getString("width"), "1");
+    BOOST_CHECK(!provider->hasStyle(other, 1));
+}
+
+BOOST_AUTO_TEST_CASE(GivenElementsWithSameTags_WhenForElement_ThenCachedStylesDependOnTypeAndLod)
+{
+    auto provider = dependencyProvider.getStyleProvider(
+        "node|z1[amenity] { a: b; } way|z1[amenity] { c: d; } node|z2[amenity] { e: f; }");
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0,
+        { std::make_pair("amenity", "biergarten") });
+    Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 1,
+        { std::make_pair("amenity", "biergarten") });
+    Node other = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2,
+        { std::make_pair("amenity", "biergarten") });
+
+    Style nodeStyle = provider->forElement(node, 1);
+    Style wayStyle = provider->forElement(way, 1);
+    Style otherStyle = provider->forElement(other, 1);
+    Style otherLodStyle = provider->forElement(other, 2);
+
+    BOOST_CHECK_EQUAL(nodeStyle.getString("a"), "b");
+    BOOST_CHECK_EQUAL(otherStyle.getString("a"), "b");
+    BOOST_CHECK(!wayStyle.has(dependencyProvider.getStringTable()->getId("a")));
+    BOOST_CHECK_EQUAL(wayStyle.getString("c"), "d");
+    BOOST_CHECK_EQUAL(otherLodStyle.getString("e"), "f");
+    BOOST_CHECK(provider->hasStyle(other, 1));
+    BOOST_CHECK(!provider->hasStyle(other, 3));
+}
+
+BOOST_AUTO_TEST_CASE(GivenChangedStylesheet_WhenReload_ThenOnlyChangedLodsAreReturnedAndStylesUpdated)
+{
+    auto provider = dependencyProvider.getStyleProvider(
+        "node|z1[amenity] { a: b; } way|z2[highway] { c: d; } area|z3[building] { e: f; }");
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0,
+        { std::make_pair("amenity", "biergarten") });
+    BOOST_CHECK_EQUAL(provider->forElement(node, 1).getString("a"), "b");
+
+    std::vector<int> lods = provider->reload(MapCssParser().parse(
+        "node|z1[amenity] { a: g; } way|z2[highway] { c: d; } area|z4[building] { e: f; }"));
+
+    std::vector<int> expected = { 1, 3, 4 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(lods.begin(), lods.end(), expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(provider->forElement(node, 1).getString("a"), "g");
+    BOOST_CHECK(provider->reload(MapCssParser().parse(
+        "node|z1[amenity] { a: g; } way|z2[highway] { c: d; } area|z4[building] { e: f; }")).empty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenLodStyles_WhenForFingerprint_ThenSameStyleIsRestoredUntilReload)
+{
+    auto provider = dependencyProvider.getStyleProvider(
+        "node|z1[amenity] { a: b; } node|z2[amenity] { c: d; }");
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0,
+        { std::make_pair("amenity", "biergarten") });
+    Node other = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1,
+        { std::make_pair("amenity", "cafe") });
+
+    LodStyles lodStyles = provider->forElement(node, utymap::LodRange(1, 2));
+    LodStyles otherStyles = provider->forElement(other, utymap::LodRange(1, 2));
+    std::uint64_t version = provider->getFingerprintVersion();
+
+    BOOST_REQUIRE_EQUAL(lodStyles.fingerprints.size(), 2);
+    BOOST_CHECK(lodStyles.fingerprints[0] != lodStyles.fingerprints[1]);
+    BOOST_CHECK_EQUAL(otherStyles.fingerprints[0], lodStyles.fingerprints[0]);
+    BOOST_CHECK_EQUAL(provider->forFingerprint(other, lodStyles.fingerprints[0]).getString("a"), "b");
+    BOOST_CHECK_EQUAL(provider->forFingerprint(other, lodStyles.fingerprints[1]).getString("c"), "d");
+    provider->reload(MapCssParser().parse("node|z1[amenity] { a: g; }"));
+    BOOST_CHECK(provider->getFingerprintVersion() != version);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSameStylesheet_WhenGetStylesheetHash_ThenItIsSameForProvidersTillReload)
+{
+    const std::string content = "node|z1[amenity] { a: b; }";
+    StyleProvider provider1(MapCssParser().parse(content), *dependencyProvider.getStringTable());
+    StyleProvider provider2(MapCssParser().parse(content), *dependencyProvider.getStringTable());
+    std::uint64_t hash = provider2.getStylesheetHash();
+
+    provider2.reload(MapCssParser().parse("node|z1[amenity] { a: c; }"));
+
+    BOOST_CHECK_EQUAL(provider1.getStylesheetHash(), hash);
+    BOOST_CHECK(provider2.getStylesheetHash() != hash);
+}
+
+BOOST_AUTO_TEST_CASE(GivenConcurrentCalls_WhenGetGradient_ThenSameGradientIsReturned)
+{
+    auto provider = dependencyProvider.getStyleProvider("node|z1[amenity] { color: gradient(#ffffff, #000000); }");
+    std::vector<std::future<const ColorGradient*>> results;
+
+    for (int i = 0; i < 4; ++i) {
+        results.push_back(std::async(std::launch::async, [&provider]() {
+            for (int j = 0; j < 100; ++j)
+                provider->getGradient(j % 2 == 0 ? "gradient(#ff0000, #00ff00)" : "gradient(#ffffff, #000000)");
+            return &provider->getGradient("gradient(#ff0000, #00ff00)");
+        }));
+    }
+
+    const ColorGradient* expected = &provider->getGradient("gradient(#ff0000, #00ff00)");
+    for (auto& result : results)
+        BOOST_CHECK_EQUAL(result.get(), expected);
+    BOOST_CHECK_EQUAL(expected->lookup(0), 0xFF0000FF);
+}
+
+BOOST_AUTO_TEST_CASE(GivenThemesWithSharedRules_WhenCreateProviders_ThenOnlyDifferentRulesAreAddedAndStylesAreKept)
+{
+    auto& stringTable = *dependencyProvider.getStringTable();
+    auto sharedRules = std::make_shared<SharedStyleRules>(stringTable);
+    StyleProvider day(MapCssParser().parse(
+        "node|z1[amenity] { a: b; color: gradient(#ff0000, #00ff00); } way|z1[highway] { c: d; }"), stringTable, sharedRules);
+    StyleProvider night(MapCssParser().parse(
+        "node|z1[amenity] { a: b; color: gradient(#ff0000, #00ff00); } way|z1[highway] { c: e; }"), stringTable, sharedRules);
+    Node node = ElementUtils::createElement<Node>(stringTable, 0, { std::make_pair("amenity", "biergarten") });
+    Way way = ElementUtils::createElement<Way>(stringTable, 1, { std::make_pair("highway", "primary") });
+
+    BOOST_CHECK_EQUAL(sharedRules->size(), 3);
+    BOOST_CHECK_EQUAL(day.forElement(node, 1).getString("a"), "b");
+    BOOST_CHECK_EQUAL(night.forElement(node, 1).getString("a"), "b");
+    BOOST_CHECK_EQUAL(day.forElement(way, 1).getString("c"), "d");
+    BOOST_CHECK_EQUAL(night.forElement(way, 1).getString("c"), "e");
+    BOOST_CHECK_EQUAL(&day.getGradient("gradient(#ff0000, #00ff00)"), &night.getGradient("gradient(#ff0000, #00ff00)"));
+    BOOST_CHECK_GT(sharedRules->getMemoryUsage(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSharedRules_WhenProviderIsReplaced_ThenItsRulesAreReleased)
+{
+    auto& stringTable = *dependencyProvider.getStringTable();
+    auto sharedRules = std::make_shared<SharedStyleRules>(stringTable);
+    StyleProvider day(MapCssParser().parse("node|z1[amenity] { a: b; }"), stringTable, sharedRules);
+
+    for (int i = 0; i < 10; ++i) {
+        StyleProvider reloaded(MapCssParser().parse(
+            "node|z1[amenity] { a: b; } way|z1[highway] { c: " + std::to_string(i) + "; }"), stringTable, sharedRules);
+        BOOST_CHECK_EQUAL(sharedRules->size(), 2);
+    }
+
+    BOOST_CHECK_EQUAL(sharedRules->size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSharedRules_WhenReloadStylesheetManyTimes_ThenOldRulesAreReleased)
+{
+    auto& stringTable = *dependencyProvider.getStringTable();
+    auto sharedRules = std::make_shared<SharedStyleRules>(stringTable);
+    StyleProvider provider(MapCssParser().parse("node|z1[amenity] { a: b; }"), stringTable, sharedRules);
+
+    for (int i = 0; i < 10; ++i)
+        provider.reload(MapCssParser().parse("node|z1[amenity] { a: " + std::to_string(i) + "; }"));
+
+    BOOST_CHECK_EQUAL(sharedRules->size(), 1);
+    BOOST_CHECK_EQUAL(provider.forElement(ElementUtils::createElement<Node>(stringTable, 0,
+        { std::make_pair("amenity", "bench") }), 1).getString("a"), "9");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -59,5 +59,22 @@ BOOST_AUTO_TEST_CASE(GivenNegativeValueInMeters_WhenGetValue_ThenReturnExpectedV
     BOOST_CHECK_EQUAL(width, -1);
 }
 
+BOOST_AUTO_TEST_CASE(GivenUnsortedDeclarations_WhenMerge_ThenTheyAreSortedAndLastWins)
+{
+    StringTable& stringTable = *dependencyProvider.getStringTable();
+    StyleDeclaration first(3, "a", stringTable), second(1, "b", stringTable), third(3, "c", stringTable);
+    auto declarations = std::make_shared<Style::Declarations>();
+
+    Style::merge(*declarations, first);
+    Style::merge(*declarations, second);
+    Style::merge(*declarations, third);
+    Style style({}, stringTable, declarations);
+
+    BOOST_CHECK_EQUAL(declarations->size(), 2);
+    BOOST_CHECK_EQUAL(declarations->front().first, 1);
+    BOOST_CHECK_EQUAL(style.get(3).value(), "c");
+    BOOST_CHECK(style.has(1, "b"));
+    BOOST_CHECK(!style.has(2));
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,74 @@
+#include "meshing/CartesianProjection.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap;
+using namespace utymap::meshing;
+
+namespace {
+    const double Precision = 1E-3;
+}
+
+BOOST_AUTO_TEST_SUITE(Meshing_CartesianProjection)
+
+BOOST_AUTO_TEST_CASE(GivenMeshAtOrigin_WhenProject_ThenVertexIsZeroWithScaledElevation)
+{
+    Mesh mesh("name");
+    mesh.vertices = { 13.405, 52.52, 10 };
+    std::vector<float> vertices;
+
+    CartesianProjection(GeoCoordinate(52.52, 13.405), 0.5).project(mesh, vertices);
+
+    BOOST_REQUIRE_EQUAL(vertices.size(), 3);
+    BOOST_CHECK_SMALL(vertices[0], 1E-6f);
+    BOOST_CHECK_EQUAL(vertices[1], 5);
+    BOOST_CHECK_SMALL(vertices[2], 1E-6f);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMesh_WhenProject_ThenVerticesAreInMetersFromOrigin)
+{
+    Mesh mesh("name");
+    mesh.vertices = { 0.001, 0, 0, 0, 0.001, 0 };
+    std::vector<float> vertices;
+
+    CartesianProjection(GeoCoordinate(0, 0), 1).project(mesh, vertices);
+
+    BOOST_REQUIRE_EQUAL(vertices.size(), 6);
+    BOOST_CHECK_CLOSE(vertices[0], 111.3199, Precision);
+    BOOST_CHECK_SMALL(vertices[2], 1E-6f);
+    BOOST_CHECK_SMALL(vertices[3], 1E-6f);
+    BOOST_CHECK_CLOSE(vertices[5], 111.1333, Precision);
+}
+
+BOOST_AUTO_TEST_CASE(GivenClockwiseFlatTriangles_WhenCalculateNormals_ThenNormalsPointUp)
+{
+    std::vector<float> vertices = { 0, 0, 0, 0, 0, 1, 1, 0, 0, 1, 0, 1 };
+    std::vector<int> triangles = { 0, 1, 2, 2, 1, 3 };
+    std::vector<float> normals;
+
+    CartesianProjection::calculateNormals(vertices, triangles, normals);
+
+    BOOST_REQUIRE_EQUAL(normals.size(), vertices.size());
+    for (std::size_t i = 0; i < normals.size(); i += 3) {
+        BOOST_CHECK_SMALL(normals[i], 1E-6f);
+        BOOST_CHECK_CLOSE(normals[i + 1], 1, Precision);
+        BOOST_CHECK_SMALL(normals[i + 2], 1E-6f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GivenSharedRidgeVertex_WhenCalculateNormals_ThenNormalIsAverageOfFaces)
+{
+    // two slopes of a roof which share ridge vertices.
+    std::vector<float> vertices = { -1, 0, 0, -1, 0, 1, 0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0, 1 };
+    std::vector<int> triangles = { 0, 1, 2, 2, 1, 3, 2, 3, 5, 2, 5, 4 };
+    std::vector<float> normals;
+
+    CartesianProjection::calculateNormals(vertices, triangles, normals);
+
+    BOOST_CHECK_SMALL(normals[6], 1E-6f);
+    BOOST_CHECK_CLOSE(normals[7], 1, Precision);
+    BOOST_CHECK_CLOSE(normals[0], -std::sqrt(0.5f), Precision);
+    BOOST_CHECK_CLOSE(normals[1], std::sqrt(0.5f), Precision);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,78 @@
+#include "meshing/GlbWriter.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <sstream>
+
+using namespace utymap;
+using namespace utymap::meshing;
+
+namespace {
+    template <typename T>
+    T read(const std::string& data, std::size_t offset)
+    {
+        T value;
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        return value;
+    }
+
+    std::string write(const GlbWriter& writer)
+    {
+        std::stringstream stream;
+        writer.write(stream);
+        return stream.str();
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(Meshing_GlbWriter)
+
+BOOST_AUTO_TEST_CASE(GivenMesh_WhenWrite_ThenGlbHasJsonAndBinaryChunks)
+{
+    Mesh mesh("terrain");
+    mesh.vertices = { 13.4, 52.5, 0, 13.4, 52.501, 0, 13.401, 52.5, 10 };
+    mesh.triangles = { 0, 1, 2 };
+    mesh.colors = { static_cast<int>(0xFF0000FF), 0, 0 };
+    GlbWriter writer(GeoCoordinate(52.5, 13.4));
+    writer.add(mesh);
+
+    std::string data = write(writer);
+
+    BOOST_REQUIRE(data.size() > 28);
+    BOOST_CHECK_EQUAL(read<std::uint32_t>(data, 0), 0x46546C67);
+    BOOST_CHECK_EQUAL(read<std::uint32_t>(data, 4), 2);
+    BOOST_CHECK_EQUAL(read<std::uint32_t>(data, 8), data.size());
+    auto jsonSize = read<std::uint32_t>(data, 12);
+    BOOST_CHECK_EQUAL(jsonSize % 4, 0);
+    std::string json = data.substr(20, jsonSize);
+    BOOST_CHECK(json.find("\"POSITION\":0,\"COLOR_0\":1}") != std::string::npos);
+    BOOST_CHECK(json.find("\"TEXCOORD_0\"") == std::string::npos);
+    std::size_t binary = 20 + jsonSize;
+    BOOST_REQUIRE_EQUAL(read<std::uint32_t>(data, binary), 3 * 12 + 3 * 4 + 3 * 4);
+    BOOST_CHECK_EQUAL(read<std::uint8_t>(data, binary + 8 + 36), 0xFF);
+    BOOST_CHECK_EQUAL(read<std::uint32_t>(data, binary + 8 + 48 + 4), 2);
+    BOOST_CHECK_CLOSE(read<float>(data, binary + 8 + 7 * 4), 10, 1E-3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMeshes_WhenWrite_ThenEveryNonEmptyMeshIsNode)
+{
+    Mesh mesh("building:\"1\"");
+    mesh.vertices = { 13.4, 52.5, 0, 13.4, 52.501, 0, 13.401, 52.5, 0 };
+    mesh.triangles = { 0, 1, 2 };
+    mesh.uvs = { 0, 0, 0, 1, 1, 0 };
+    Mesh empty("empty");
+    GlbWriter writer(GeoCoordinate(52.5, 13.4));
+    writer.add(mesh);
+    writer.add(empty);
+    writer.add(mesh);
+
+    std::string data = write(writer);
+
+    BOOST_CHECK_EQUAL(writer.size(), 2);
+    std::string json = data.substr(20, read<std::uint32_t>(data, 12));
+    BOOST_CHECK(json.find("\"nodes\":[0,1]") != std::string::npos);
+    BOOST_CHECK(json.find("\"name\":\"building:\\\"1\\\"\"") != std::string::npos);
+    BOOST_CHECK(json.find("\"TEXCOORD_0\":1") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,7 @@
 #include "mapcss/ColorGradient.hpp"
 #include "meshing/Polygon.hpp"
 #include "meshing/MeshBuilder.hpp"
+#include "utils/GeoUtils.hpp"
 
 #include <boost/test/unit_test.hpp>
 
@@ -139,4 +140,156 @@ BOOST_AUTO_TEST_CASE(GivenSimpleSquareWithTextureOptions_WhenAddPolygon_ThenText
     BOOST_CHECK_EQUAL(mesh.vertices.size() * 2 / 3, mesh.uvs.size());
 }
 
+BOOST_AUTO_TEST_CASE(GivenSimplePolygonWithoutRefinement_WhenAddPolygon_ThenAllPointsAreUsed)
+{
+    Mesh mesh("");
+    Polygon polygon(5, 0);
+    polygon.addContour(std::vector<DPoint> { { 0, 0 }, { 10, 0 }, { 10, 10 }, { 5, 5 }, { 0, 10 } });
+
+    builder.addPolygon(mesh, polygon, geometryOptions, appearanceOptions);
+
+    BOOST_CHECK_EQUAL(mesh.vertices.size() / 3, 5);
+    BOOST_CHECK_EQUAL(mesh.triangles.size() / 3, 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSamePolygon_WhenAddPolygonRepeatedly_ThenReusedWorkspaceGivesSameResult)
+{
+    geometryOptions.area = 5;
+    std::vector<std::size_t> vertexCounts, triangleCounts;
+
+    for (int i = 0; i < 3; ++i) {
+        Mesh mesh("");
+        Polygon polygon(4, 0);
+        polygon.addContour(std::vector<DPoint> { DPoint(0, 0), DPoint(10, 0), DPoint(10, 10), DPoint(0, 10) });
+        builder.addPolygon(mesh, polygon, geometryOptions, appearanceOptions);
+        vertexCounts.push_back(mesh.vertices.size());
+        triangleCounts.push_back(mesh.triangles.size());
+    }
+
+    BOOST_CHECK_EQUAL(vertexCounts[0], 23 * 3);
+    BOOST_CHECK(vertexCounts[1] == vertexCounts[0] && vertexCounts[2] == vertexCounts[0]);
+    BOOST_CHECK(triangleCounts[1] == triangleCounts[0] && triangleCounts[2] == triangleCounts[0]);
+}
+
+BOOST_AUTO_TEST_CASE(GivenIndexedMesh_WhenAddPlane_ThenSharedCornersAreReused)
+{
+    Mesh mesh("", true);
+    geometryOptions.heightOffset = 10;
+
+    builder.addPlane(mesh, DPoint(0, 0), DPoint(10, 0), 0, 0, geometryOptions, appearanceOptions);
+    builder.addPlane(mesh, DPoint(10, 0), DPoint(10, 10), 0, 0, geometryOptions, appearanceOptions);
+
+    BOOST_CHECK_EQUAL(mesh.vertices.size() / 3, 6);
+    BOOST_CHECK_EQUAL(mesh.colors.size(), 6);
+    BOOST_CHECK_EQUAL(mesh.uvs.size(), 12);
+    BOOST_CHECK_EQUAL(mesh.triangles.size() / 3, 4);
+}
+
+BOOST_AUTO_TEST_CASE(GivenIndexedMesh_WhenAddTriangleWithBackSide_ThenVerticesAreReused)
+{
+    Mesh mesh("", true);
+    geometryOptions.hasBackSide = true;
+
+    builder.addTriangle(mesh, Vector3(0, 0, 0), Vector3(1, 0, 0), Vector3(0, 0, 1), geometryOptions, appearanceOptions);
+
+    std::vector<int> expected = { 0, 1, 2, 2, 1, 0 };
+    BOOST_CHECK_EQUAL(mesh.vertices.size() / 3, 3);
+    BOOST_CHECK_EQUAL_COLLECTIONS(mesh.triangles.begin(), mesh.triangles.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenTextureOptions_WhenAddPlane_ThenTextureIsRepeatedByWallSize)
+{
+    Mesh mesh("");
+    geometryOptions.heightOffset = 10;
+    appearanceOptions.textureRegion = TextureRegion(100, 100, 0, 0, 50, 50);
+    appearanceOptions.textureScale = 5;
+    double length = utymap::utils::GeoUtils::distance(utymap::GeoCoordinate(0, 0), utymap::GeoCoordinate(0, 0.001));
+
+    builder.addPlane(mesh, DPoint(0, 0), DPoint(0.001, 0), 0, 0, geometryOptions, appearanceOptions);
+
+    BOOST_REQUIRE_EQUAL(mesh.uvs.size(), 6 * 2);
+    // bottom of the second point and top of the first one.
+    BOOST_CHECK_CLOSE(mesh.uvs[2], 0.5 * length / 5, 1E-9);
+    BOOST_CHECK_EQUAL(mesh.uvs[3], 0);
+    BOOST_CHECK_EQUAL(mesh.uvs[6], 0);
+    BOOST_CHECK_CLOSE(mesh.uvs[7], 0.5 * 10 / 5, 1E-9);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRing_WhenAddWalls_ThenCornerVerticesAreShared)
+{
+    Mesh mesh("");
+    geometryOptions.heightOffset = 10;
+    std::vector<DPoint> ring = { DPoint(0, 0), DPoint(10, 0), DPoint(10, 10), DPoint(0, 10) };
+
+    builder.addWalls(mesh, ring, geometryOptions, appearanceOptions);
+
+    BOOST_CHECK_EQUAL(mesh.vertices.size() / 3, 8);
+    BOOST_CHECK_EQUAL(mesh.colors.size(), 8);
+    BOOST_CHECK_EQUAL(mesh.uvs.size(), 16);
+    BOOST_CHECK_EQUAL(mesh.triangles.size() / 3, 8);
+    // the same winding as plane: bottom of first point, top and bottom of second one.
+    BOOST_CHECK_EQUAL(mesh.triangles[0], 0);
+    BOOST_CHECK_EQUAL(mesh.triangles[1], 3);
+    BOOST_CHECK_EQUAL(mesh.triangles[2], 2);
+    BOOST_CHECK_EQUAL(mesh.vertices[5], 10);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRingWithFilteredEdge_WhenAddWalls_ThenEdgeIsSkippedAndTextureIsContinuous)
+{
+    Mesh mesh("");
+    geometryOptions.heightOffset = 10;
+    appearanceOptions.textureRegion = TextureRegion(100, 100, 0, 0, 100, 100);
+    appearanceOptions.textureScale = 1;
+    std::vector<DPoint> ring = { DPoint(0, 0), DPoint(0.001, 0), DPoint(0.001, 0.001), DPoint(0, 0.001) };
+    double length = utymap::utils::GeoUtils::distance(utymap::GeoCoordinate(0, 0), utymap::GeoCoordinate(0, 0.001));
+
+    builder.addWalls(mesh, ring, geometryOptions, appearanceOptions, [](const DPoint& p1, const DPoint& p2) {
+        return p1.x != 0 || p2.x != 0;
+    });
+
+    BOOST_CHECK_EQUAL(mesh.vertices.size() / 3, 8);
+    BOOST_CHECK_EQUAL(mesh.triangles.size() / 3, 6);
+    BOOST_REQUIRE_EQUAL(mesh.uvs.size(), 16);
+    BOOST_CHECK_CLOSE(mesh.uvs[12], 3 * length, 1E-4);
+    BOOST_CHECK_CLOSE(mesh.uvs[15], 10, 1E-9);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPolygonBudgetExceeded_WhenAddPolygon_ThenRefinementIsRelaxed)
+{
+    MeshBuilder budgetBuilder(utymap::QuadKey(1, 1, 0), eleProvider, MeshBuilder::TriangleBudget(20, 1000));
+    Mesh mesh("");
+    Polygon polygon(4, 0);
+    geometryOptions.area = 0.01;
+    polygon.addContour(std::vector<DPoint> { DPoint(0, 0), DPoint(10, 0), DPoint(10, 10), DPoint(0, 10) });
+
+    budgetBuilder.addPolygon(mesh, polygon, geometryOptions, appearanceOptions);
+
+    auto statistics = budgetBuilder.getStatistics();
+    BOOST_CHECK(mesh.triangles.size() / 3 <= 20);
+    BOOST_CHECK_EQUAL(statistics.polygons, 1);
+    BOOST_CHECK_EQUAL(statistics.triangles, mesh.triangles.size() / 3);
+    BOOST_CHECK_EQUAL(statistics.relaxedPolygons, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTileBudgetSpent_WhenAddPolygon_ThenPolygonIsNotRefined)
+{
+    MeshBuilder budgetBuilder(utymap::QuadKey(1, 1, 0), eleProvider, MeshBuilder::TriangleBudget(1000, 40));
+    geometryOptions.area = 5;
+    std::vector<std::size_t> triangleCounts;
+
+    for (int i = 0; i < 2; ++i) {
+        Mesh mesh("");
+        Polygon polygon(4, 0);
+        polygon.addContour(std::vector<DPoint> { DPoint(0, 0), DPoint(10, 0), DPoint(10, 10), DPoint(0, 10) });
+        budgetBuilder.addPolygon(mesh, polygon, geometryOptions, appearanceOptions);
+        triangleCounts.push_back(mesh.triangles.size() / 3);
+    }
+
+    auto statistics = budgetBuilder.getStatistics();
+    BOOST_CHECK_EQUAL(triangleCounts[0], 34);
+    BOOST_CHECK(triangleCounts[1] < triangleCounts[0]);
+    BOOST_CHECK_EQUAL(statistics.triangles, triangleCounts[0] + triangleCounts[1]);
+    BOOST_CHECK_EQUAL(statistics.relaxedPolygons, 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,94 @@
+#include "meshing/MeshBvh.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap;
+using namespace utymap::meshing;
+
+namespace {
+    /// Adds horizontal square with given min corner, size and elevation.
+    void addSquare(Mesh& mesh, double x, double y, double size, double elevation)
+    {
+        int start = static_cast<int>(mesh.vertices.size() / 3);
+        mesh.vertices.insert(mesh.vertices.end(), {
+            x, y, elevation, x + size, y, elevation, x + size, y + size, elevation, x, y + size, elevation });
+        mesh.triangles.insert(mesh.triangles.end(), { start, start + 1, start + 2, start, start + 2, start + 3 });
+    }
+
+    void addRange(Mesh& mesh, std::uint64_t id, std::size_t firstTriangle)
+    {
+        mesh.elementRanges.insert(mesh.elementRanges.end(), { id, firstTriangle, mesh.triangles.size() / 3 - firstTriangle });
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(Meshing_MeshBvh)
+
+BOOST_AUTO_TEST_CASE(GivenBatchedMesh_WhenPickByRay_ThenClosestElementIsReturned)
+{
+    Mesh mesh("buildings:default:0");
+    addSquare(mesh, 0, 0, 1, 10);
+    addRange(mesh, 1, 0);
+    addSquare(mesh, 0, 0, 1, 20);
+    addRange(mesh, 2, 2);
+    MeshBvh bvh;
+    bvh.add(mesh);
+    bvh.build();
+    const double origin[3] = { 0.5, 0.5, 0 };
+    const double up[3] = { 0, 0, 1 };
+    MeshBvh::Hit hit;
+
+    BOOST_REQUIRE(bvh.pick(origin, up, hit));
+
+    BOOST_CHECK_EQUAL(hit.id, 1);
+    BOOST_CHECK_CLOSE(hit.distance, 10, 1e-9);
+    BOOST_REQUIRE(bvh.pick(GeoCoordinate(0.5, 0.5), hit));
+    BOOST_CHECK_EQUAL(hit.id, 2);
+    BOOST_CHECK(!bvh.pick(GeoCoordinate(1.5, 0.5), hit));
+}
+
+BOOST_AUTO_TEST_CASE(GivenSingleElementMeshes_WhenAdd_ThenIdIsTakenFromName)
+{
+    Mesh building("building:42");
+    addSquare(building, 0, 0, 1, 5);
+    Mesh terrain("terrain");
+    addSquare(terrain, 0, 0, 2, 0);
+    Mesh terrainChunk("terrain#3");
+    addSquare(terrainChunk, 0, 0, 2, 0);
+    MeshBvh bvh;
+    bvh.add(building);
+    bvh.add(terrain);
+    bvh.add(terrainChunk);
+    bvh.build();
+    MeshBvh::Hit hit;
+
+    BOOST_CHECK_EQUAL(bvh.size(), 2);
+    BOOST_REQUIRE(bvh.pick(GeoCoordinate(0.5, 0.5), hit));
+    BOOST_CHECK_EQUAL(hit.id, 42);
+    BOOST_CHECK(!bvh.pick(GeoCoordinate(1.5, 1.5), hit));
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyElements_WhenPickByPoint_ThenElementUnderPointIsReturned)
+{
+    Mesh mesh("buildings:default:0");
+    for (int i = 0; i < 32; ++i) {
+        for (int j = 0; j < 32; ++j) {
+            std::size_t first = mesh.triangles.size() / 3;
+            addSquare(mesh, i * 0.001, j * 0.001, 0.0008, 10 + (i + j) % 7);
+            addRange(mesh, static_cast<std::uint64_t>(i * 32 + j + 1), first);
+        }
+    }
+    MeshBvh bvh;
+    bvh.add(mesh);
+    bvh.build();
+    MeshBvh::Hit hit;
+
+    for (int i = 0; i < 32; ++i) {
+        for (int j = 0; j < 32; ++j) {
+            BOOST_REQUIRE(bvh.pick(GeoCoordinate(j * 0.001 + 0.0004, i * 0.001 + 0.0004), hit));
+            BOOST_CHECK_EQUAL(hit.id, static_cast<std::uint64_t>(i * 32 + j + 1));
+        }
+    }
+    BOOST_CHECK(!bvh.pick(GeoCoordinate(0.0009, 0.0009), hit));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
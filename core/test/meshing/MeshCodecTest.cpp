@@ -0,0 +1,114 @@
+#include "meshing/MeshCodec.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace utymap::meshing;
+
+namespace {
+    /// Creates grid of quads with positions inside of tile sized bounds.
+    void createGrid(Mesh& mesh, int size)
+    {
+        for (int y = 0; y <= size; ++y) {
+            for (int x = 0; x <= size; ++x) {
+                mesh.vertices.insert(mesh.vertices.end(), { 13.4 + x * 0.0001, 52.5 + y * 0.0001, 30.0 + x % 3 });
+                mesh.colors.push_back(static_cast<int>(0xFF8040FF));
+                mesh.uvs.insert(mesh.uvs.end(), { x / static_cast<double>(size), y / static_cast<double>(size) });
+            }
+        }
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                int corner = y * (size + 1) + x;
+                mesh.triangles.insert(mesh.triangles.end(), { corner, corner + 1, corner + size + 1 });
+                mesh.triangles.insert(mesh.triangles.end(), { corner + 1, corner + size + 2, corner + size + 1 });
+            }
+        }
+        mesh.elementRanges = { 7, 0, 10, 3, 10, static_cast<std::uint64_t>(size * size * 2 - 10) };
+    }
+
+    /// Checks mesh using given precision of coordinates. Elevation is checked with 0.1 mm precision.
+    void assertMesh(const Mesh& expected, const Mesh& actual, double precision)
+    {
+        BOOST_CHECK_EQUAL(expected.name, actual.name);
+        BOOST_REQUIRE_EQUAL(expected.vertices.size(), actual.vertices.size());
+        for (std::size_t i = 0; i < expected.vertices.size(); ++i)
+            BOOST_CHECK_SMALL(expected.vertices[i] - actual.vertices[i], i % 3 == 2 ? 1E-4 : precision);
+        BOOST_REQUIRE_EQUAL(expected.uvs.size(), actual.uvs.size());
+        for (std::size_t i = 0; i < expected.uvs.size(); ++i)
+            BOOST_CHECK_SMALL(expected.uvs[i] - actual.uvs[i], 1E-4);
+        BOOST_CHECK(expected.colors == actual.colors);
+        BOOST_CHECK(expected.triangles == actual.triangles);
+        BOOST_CHECK(expected.elementRanges == actual.elementRanges);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(Meshing_MeshCodec)
+
+BOOST_AUTO_TEST_CASE(GivenMesh_WhenEncodeAndDecode_ThenMeshIsRestoredWithQuantizationError)
+{
+    Mesh mesh("terrain");
+    createGrid(mesh, 20);
+
+    std::string data = MeshCodec::encode(mesh, false);
+    auto decoded = MeshCodec::decode(data.data(), data.size());
+
+    assertMesh(mesh, *decoded, 1E-7);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMesh_WhenEncodeCompressed_ThenDataIsMuchSmallerThanRawArrays)
+{
+    Mesh mesh("terrain");
+    createGrid(mesh, 20);
+    std::size_t rawSize = mesh.vertices.size() * sizeof(double) + mesh.triangles.size() * sizeof(int) +
+        mesh.colors.size() * sizeof(int) + mesh.uvs.size() * sizeof(double);
+
+    std::string data = MeshCodec::encode(mesh, true);
+    auto decoded = MeshCodec::decode(data.data(), data.size());
+
+    BOOST_CHECK_LT(data.size() * 5, rawSize);
+    assertMesh(mesh, *decoded, 1E-7);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTruncatedData_WhenDecode_ThenExceptionIsThrown)
+{
+    Mesh mesh("terrain");
+    createGrid(mesh, 2);
+    std::string data = MeshCodec::encode(mesh, false);
+
+    BOOST_CHECK_THROW(MeshCodec::decode(data.data(), data.size() - 3), std::domain_error);
+    BOOST_CHECK_THROW(MeshCodec::decode(data.data(), 4), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMeshesOfSameTile_WhenEncodeWithTileBounds_ThenCommonVertexIsDecodedEqually)
+{
+    utymap::BoundingBox tileBounds(utymap::GeoCoordinate(52.5, 13.4), utymap::GeoCoordinate(52.51, 13.41));
+    Mesh first("first"), second("second");
+    first.vertices = { 13.4, 52.5, 0, 13.40123457, 52.50543211, 0, 13.401, 52.5, 0 };
+    first.triangles = { 0, 1, 2 };
+    second.vertices = { 13.40123457, 52.50543211, 0, 13.409, 52.509, 5, 13.4, 52.509, 10 };
+    second.triangles = { 0, 1, 2 };
+
+    std::string firstData = MeshCodec::encode(first, tileBounds, false);
+    std::string secondData = MeshCodec::encode(second, tileBounds, false);
+    auto firstDecoded = MeshCodec::decode(firstData.data(), firstData.size());
+    auto secondDecoded = MeshCodec::decode(secondData.data(), secondData.size());
+
+    BOOST_CHECK_EQUAL(firstDecoded->vertices[3], secondDecoded->vertices[0]);
+    BOOST_CHECK_EQUAL(firstDecoded->vertices[4], secondDecoded->vertices[1]);
+    BOOST_CHECK_SMALL(firstDecoded->vertices[3] - 13.40123457, 1E-6);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCompressedDataWithTooLargePayloadSize_WhenDecode_ThenExceptionIsThrown)
+{
+    Mesh mesh("terrain");
+    createGrid(mesh, 2);
+    std::string data = MeshCodec::encode(mesh, true);
+    const std::uint32_t payloadSize = 0xFFFFFFF0;
+    std::memcpy(&data[8], &payloadSize, sizeof(payloadSize));
+
+    BOOST_CHECK_THROW(MeshCodec::decode(data.data(), data.size()), std::domain_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
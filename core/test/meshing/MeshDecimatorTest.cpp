@@ -0,0 +1,126 @@
+#include "meshing/MeshDecimator.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+
+using namespace utymap;
+using namespace utymap::meshing;
+
+namespace {
+    const double Step = 0.0001;
+    const BoundingBox TileBbox(GeoCoordinate(52.5, 13.4), GeoCoordinate(52.6, 13.5));
+
+    /// Creates grid of quads which shares vertices. Elevation of center vertex is given.
+    void createGrid(Mesh& mesh, const GeoCoordinate& start, int size, double centerElevation)
+    {
+        for (int y = 0; y <= size; ++y) {
+            for (int x = 0; x <= size; ++x) {
+                bool isCenter = x == size / 2 && y == size / 2;
+                mesh.vertices.insert(mesh.vertices.end(), { start.longitude + x * Step, start.latitude + y * Step,
+                                                            isCenter ? centerElevation : 0 });
+                mesh.colors.push_back(0);
+            }
+        }
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                int corner = y * (size + 1) + x;
+                mesh.triangles.insert(mesh.triangles.end(), { corner, corner + size + 1, corner + 1 });
+                mesh.triangles.insert(mesh.triangles.end(), { corner + 1, corner + size + 1, corner + size + 2 });
+            }
+        }
+    }
+
+    bool hasVertex(const Mesh& mesh, double longitude, double latitude, double elevation)
+    {
+        for (std::size_t i = 0; i < mesh.vertices.size(); i += 3) {
+            if (std::abs(mesh.vertices[i] - longitude) < 1E-9 && std::abs(mesh.vertices[i + 1] - latitude) < 1E-9 &&
+                std::abs(mesh.vertices[i + 2] - elevation) < 1E-9)
+                return true;
+        }
+        return false;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(Meshing_MeshDecimator)
+
+BOOST_AUTO_TEST_CASE(GivenFlatGrid_WhenDecimate_ThenInteriorIsSimplifiedAndBoundaryIsKept)
+{
+    const int Size = 20;
+    GeoCoordinate start(52.55, 13.45);
+    Mesh mesh("terrain", true);
+    createGrid(mesh, start, Size, 0);
+    Mesh decimated("terrain", true);
+
+    MeshDecimator(TileBbox, 0.1).decimate(mesh, decimated);
+
+    BOOST_CHECK_LT(decimated.triangles.size() * 5, mesh.triangles.size());
+    BOOST_CHECK_EQUAL(decimated.colors.size() * 3, decimated.vertices.size());
+    for (int i = 0; i <= Size; ++i) {
+        BOOST_CHECK(hasVertex(decimated, start.longitude + i * Step, start.latitude, 0));
+        BOOST_CHECK(hasVertex(decimated, start.longitude, start.latitude + i * Step, 0));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GivenGridWithPeak_WhenDecimate_ThenPeakIsKept)
+{
+    GeoCoordinate start(52.55, 13.45);
+    Mesh mesh("terrain", true);
+    createGrid(mesh, start, 10, 10);
+    Mesh decimated("terrain", true);
+
+    MeshDecimator(TileBbox, 1).decimate(mesh, decimated);
+
+    BOOST_CHECK_LT(decimated.triangles.size(), mesh.triangles.size());
+    BOOST_CHECK(hasVertex(decimated, start.longitude + 5 * Step, start.latitude + 5 * Step, 10));
+}
+
+BOOST_AUTO_TEST_CASE(GivenMeshWithElementRanges_WhenDecimate_ThenRangesCoverRemainingTriangles)
+{
+    GeoCoordinate start(52.55, 13.45);
+    Mesh mesh("terrain", true);
+    createGrid(mesh, start, 10, 0);
+    mesh.elementRanges = { 1, 0, 100, 2, 100, 100 };
+    Mesh decimated("terrain", true);
+
+    MeshDecimator(TileBbox, 0.1).decimate(mesh, decimated);
+
+    BOOST_REQUIRE_EQUAL(decimated.elementRanges.size(), 6);
+    BOOST_CHECK_EQUAL(decimated.elementRanges[1], 0);
+    BOOST_CHECK_EQUAL(decimated.elementRanges[3], 2);
+    BOOST_CHECK_EQUAL(decimated.elementRanges[4], decimated.elementRanges[2]);
+    BOOST_CHECK_EQUAL(decimated.elementRanges[2] + decimated.elementRanges[5], decimated.triangles.size() / 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenGridOnTileBorder_WhenDecimate_ThenBorderVerticesAreKept)
+{
+    Mesh mesh("terrain", true);
+    createGrid(mesh, TileBbox.minPoint, 10, 0);
+    Mesh decimated("terrain", true);
+
+    MeshDecimator(TileBbox, 0.1).decimate(mesh, decimated);
+
+    for (int i = 0; i <= 10; ++i)
+        BOOST_CHECK(hasVertex(decimated, TileBbox.minPoint.longitude + i * Step, TileBbox.minPoint.latitude, 0));
+}
+
+BOOST_AUTO_TEST_CASE(GivenNonIndexedMesh_WhenDecimate_ThenItIsCopiedWithoutSimplification)
+{
+    Mesh indexed("building", true);
+    createGrid(indexed, GeoCoordinate(52.55, 13.45), 4, 0);
+    Mesh mesh("building");
+    for (int vertex : indexed.triangles) {
+        mesh.vertices.insert(mesh.vertices.end(), indexed.vertices.begin() + vertex * 3, indexed.vertices.begin() + vertex * 3 + 3);
+        mesh.colors.push_back(0);
+        mesh.triangles.push_back(static_cast<int>(mesh.triangles.size()));
+    }
+    Mesh decimated("building");
+
+    MeshDecimator(TileBbox, 0.1).decimate(mesh, decimated);
+
+    BOOST_CHECK(decimated.vertices == mesh.vertices);
+    BOOST_CHECK(decimated.triangles == mesh.triangles);
+    BOOST_CHECK(decimated.colors == mesh.colors);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,103 @@
+#include "GeoCoordinate.hpp"
+#include "meshing/MeshFaceMerger.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <utility>
+
+using namespace utymap;
+using namespace utymap::meshing;
+
+namespace {
+    const double Step = 0.0001;
+    const GeoCoordinate Start(52.5, 13.4);
+
+    /// Adds quad of grid as two triangles which do not share vertices with other quads.
+    void addQuad(Mesh& mesh, int x, int y, int color, double elevation = 10)
+    {
+        double x0 = Start.longitude + x * Step, x1 = Start.longitude + (x + 1) * Step;
+        double y0 = Start.latitude + y * Step, y1 = Start.latitude + (y + 1) * Step;
+        for (const auto& corner : { std::make_pair(x0, y0), std::make_pair(x1, y0), std::make_pair(x1, y1),
+                                    std::make_pair(x0, y0), std::make_pair(x1, y1), std::make_pair(x0, y1) }) {
+            mesh.triangles.push_back(static_cast<int>(mesh.vertices.size() / 3));
+            mesh.vertices.insert(mesh.vertices.end(), { corner.first, corner.second, elevation });
+            mesh.colors.push_back(color);
+            mesh.uvs.insert(mesh.uvs.end(), { 0, 0 });
+        }
+    }
+
+    /// Returns sum of signed areas of triangles projected to horizontal plane.
+    double getArea(const Mesh& mesh)
+    {
+        double area = 0;
+        for (std::size_t i = 0; i < mesh.triangles.size(); i += 3) {
+            const double* a = &mesh.vertices[mesh.triangles[i] * 3];
+            const double* b = &mesh.vertices[mesh.triangles[i + 1] * 3];
+            const double* c = &mesh.vertices[mesh.triangles[i + 2] * 3];
+            area += ((b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1])) / 2;
+        }
+        return area;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(Meshing_MeshFaceMerger)
+
+BOOST_AUTO_TEST_CASE(GivenFlatGridOfSameColor_WhenMerge_ThenItIsTwoTriangles)
+{
+    Mesh mesh("roof"), merged("roof");
+    for (int y = 0; y < 3; ++y)
+        for (int x = 0; x < 3; ++x)
+            addQuad(mesh, x, y, 7);
+
+    MeshFaceMerger().merge(mesh, merged);
+
+    BOOST_CHECK_EQUAL(merged.triangles.size() / 3, 2);
+    BOOST_CHECK_EQUAL(merged.vertices.size() / 3, 4);
+    BOOST_CHECK_EQUAL(merged.colors[0], 7);
+    BOOST_CHECK_CLOSE(getArea(merged), getArea(mesh), 1E-6);
+    BOOST_CHECK_GT(getArea(merged), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStripOfTwoColors_WhenMerge_ThenColorsAreMergedSeparately)
+{
+    Mesh mesh("roof"), merged("roof");
+    for (int x = 0; x < 4; ++x)
+        addQuad(mesh, x, 0, x < 2 ? 1 : 2);
+
+    MeshFaceMerger().merge(mesh, merged);
+
+    BOOST_CHECK_EQUAL(merged.triangles.size() / 3, 4);
+    BOOST_CHECK_CLOSE(getArea(merged), getArea(mesh), 1E-6);
+    for (std::size_t i = 0; i < merged.triangles.size(); i += 3) {
+        BOOST_CHECK_EQUAL(merged.colors[merged.triangles[i]], merged.colors[merged.triangles[i + 1]]);
+        BOOST_CHECK_EQUAL(merged.colors[merged.triangles[i]], merged.colors[merged.triangles[i + 2]]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GivenQuadsOnDifferentPlanes_WhenMerge_ThenTheyAreNotMerged)
+{
+    Mesh mesh("roof"), merged("roof");
+    addQuad(mesh, 0, 0, 1, 10);
+    addQuad(mesh, 1, 0, 1, 12);
+
+    MeshFaceMerger().merge(mesh, merged);
+
+    BOOST_CHECK_EQUAL(merged.triangles.size(), mesh.triangles.size());
+    BOOST_CHECK_EQUAL(merged.vertices.size(), mesh.vertices.size());
+}
+
+BOOST_AUTO_TEST_CASE(GivenTexturedQuads_WhenMerge_ThenTheyAreNotMerged)
+{
+    Mesh mesh("facade"), merged("facade");
+    for (int x = 0; x < 3; ++x)
+        addQuad(mesh, x, 0, 1);
+    for (std::size_t i = 0; i < mesh.uvs.size(); ++i)
+        mesh.uvs[i] = static_cast<double>(i % 3);
+
+    MeshFaceMerger().merge(mesh, merged);
+
+    BOOST_CHECK_EQUAL(merged.triangles.size(), mesh.triangles.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,115 @@
+#include "meshing/MeshOptimizer.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+using namespace utymap::meshing;
+
+namespace {
+    const std::size_t CacheSize = 16;
+
+    /// Creates grid of quads with triangles in shuffled order. Color of vertex is its index.
+    void createGrid(Mesh& mesh, int size)
+    {
+        for (int y = 0; y <= size; ++y) {
+            for (int x = 0; x <= size; ++x) {
+                mesh.vertices.insert(mesh.vertices.end(), { static_cast<double>(x), static_cast<double>(y), 0 });
+                mesh.colors.push_back(static_cast<int>(mesh.colors.size()));
+            }
+        }
+
+        std::vector<std::array<int, 3>> triangles;
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                int corner = y * (size + 1) + x;
+                triangles.push_back({ { corner, corner + 1, corner + size + 1 } });
+                triangles.push_back({ { corner + 1, corner + size + 2, corner + size + 1 } });
+            }
+        }
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(42));
+        for (const auto& triangle : triangles)
+            mesh.triangles.insert(mesh.triangles.end(), triangle.begin(), triangle.end());
+    }
+
+    /// Returns triangles as sorted positions of their vertices, so meshes can be compared.
+    std::vector<std::vector<double>> getTriangles(const Mesh& mesh, std::size_t first, std::size_t count)
+    {
+        std::vector<std::vector<double>> triangles;
+        for (std::size_t i = first * 3; i < (first + count) * 3; i += 3) {
+            std::vector<double> triangle;
+            for (std::size_t corner = 0; corner < 3; ++corner) {
+                int index = mesh.triangles[i + corner];
+                triangle.insert(triangle.end(), mesh.vertices.begin() + index * 3, mesh.vertices.begin() + index * 3 + 3);
+            }
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(Meshing_MeshOptimizer)
+
+BOOST_AUTO_TEST_CASE(GivenShuffledGrid_WhenOptimize_ThenCacheMissRatioIsLowerAndTrianglesAreKept)
+{
+    Mesh mesh("terrain");
+    createGrid(mesh, 20);
+    Mesh optimized("terrain");
+
+    MeshOptimizer("terrain", CacheSize).optimize(mesh, optimized);
+
+    BOOST_CHECK_LT(MeshOptimizer::getAverageCacheMissRatio(optimized.triangles, CacheSize),
+                   MeshOptimizer::getAverageCacheMissRatio(mesh.triangles, CacheSize) / 2);
+    BOOST_CHECK_EQUAL(optimized.vertices.size(), mesh.vertices.size());
+    BOOST_CHECK(getTriangles(optimized, 0, 800) == getTriangles(mesh, 0, 800));
+}
+
+BOOST_AUTO_TEST_CASE(GivenMesh_WhenOptimize_ThenVerticesAreOrderedByFirstUseWithTheirAttributes)
+{
+    Mesh mesh("terrain");
+    createGrid(mesh, 4);
+    Mesh optimized("terrain");
+
+    MeshOptimizer("terrain").optimize(mesh, optimized);
+
+    int next = 0;
+    for (int index : optimized.triangles) {
+        BOOST_REQUIRE(index <= next);
+        next = std::max(next, index + 1);
+    }
+    BOOST_REQUIRE_EQUAL(optimized.colors.size(), mesh.colors.size());
+    for (std::size_t i = 0; i < optimized.colors.size(); ++i) {
+        int original = optimized.colors[i];
+        BOOST_CHECK_EQUAL(optimized.vertices[i * 3], mesh.vertices[original * 3]);
+        BOOST_CHECK_EQUAL(optimized.vertices[i * 3 + 1], mesh.vertices[original * 3 + 1]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GivenMeshWithElementRanges_WhenOptimize_ThenTrianglesStayInTheirRanges)
+{
+    Mesh mesh("buildings:1");
+    createGrid(mesh, 4);
+    mesh.elementRanges = { 1, 0, 10, 2, 10, 22 };
+    Mesh optimized("buildings:1");
+
+    MeshOptimizer("building").optimize(mesh, optimized);
+
+    BOOST_CHECK(optimized.elementRanges == mesh.elementRanges);
+    BOOST_CHECK(getTriangles(optimized, 0, 10) == getTriangles(mesh, 0, 10));
+    BOOST_CHECK(getTriangles(optimized, 10, 22) == getTriangles(mesh, 10, 22));
+}
+
+BOOST_AUTO_TEST_CASE(GivenMeshNamePrefixes_WhenCanOptimize_ThenOnlyMatchingNamesAreAccepted)
+{
+    MeshOptimizer optimizer("terrain,building");
+
+    BOOST_CHECK(optimizer.canOptimize("terrain"));
+    BOOST_CHECK(optimizer.canOptimize("buildings:1"));
+    BOOST_CHECK(!optimizer.canOptimize("tree:1"));
+    BOOST_CHECK(!MeshOptimizer("").canOptimize("terrain"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
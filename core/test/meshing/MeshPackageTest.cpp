@@ -0,0 +1,64 @@
+#include "meshing/MeshPackage.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <string>
+
+using namespace utymap;
+using namespace utymap::meshing;
+
+namespace {
+    const std::string PackagePath = "test.ump";
+
+    PackedMesh createMesh(const std::string& name, std::size_t vertexCount)
+    {
+        PackedMesh mesh;
+        mesh.name = name;
+        mesh.origin = GeoCoordinate(52.5, 13.4);
+        for (std::size_t i = 0; i < vertexCount; ++i)
+            mesh.vertices.push_back(PackedVertex { static_cast<float>(i), 1, 2, 255, 0, 0, 255, 0, 1 });
+        mesh.triangles = { 0, 1, 2 };
+        return mesh;
+    }
+
+    struct Meshing_MeshPackageFixture
+    {
+        ~Meshing_MeshPackageFixture() { std::remove(PackagePath.c_str()); }
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(Meshing_MeshPackage, Meshing_MeshPackageFixture)
+
+BOOST_AUTO_TEST_CASE(GivenPackageWithQuadKeys_WhenRead_ThenMeshesAreReturned)
+{
+    {
+        MeshPackageWriter writer(PackagePath);
+        writer.add(QuadKey(16, 2, 1), { createMesh("terrain", 3), createMesh("building", 5) });
+        writer.add(QuadKey(16, 1, 1), { createMesh("tree", 3) });
+        writer.finish();
+    }
+    MeshPackageReader reader(PackagePath);
+    std::vector<std::string> names;
+    std::size_t vertexCount = 0;
+
+    bool isRead = reader.read(QuadKey(16, 2, 1), [&](const char* name, const GeoCoordinate& origin,
+                                                     const PackedVertex* vertices, std::size_t count,
+                                                     const int* triangles, std::size_t triangleCount) {
+        names.push_back(name);
+        vertexCount += count;
+        BOOST_CHECK_EQUAL(origin.latitude, 52.5);
+        BOOST_CHECK_EQUAL(vertices[count - 1].x, count - 1);
+        BOOST_CHECK_EQUAL(triangleCount, 3);
+        BOOST_CHECK_EQUAL(triangles[2], 2);
+    });
+
+    BOOST_CHECK(isRead);
+    BOOST_REQUIRE_EQUAL(names.size(), 2);
+    BOOST_CHECK_EQUAL(names[1], "building");
+    BOOST_CHECK_EQUAL(vertexCount, 8);
+    BOOST_CHECK(reader.contains(QuadKey(16, 1, 1)));
+    BOOST_CHECK(!reader.contains(QuadKey(15, 1, 1)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,73 @@
+#include "meshing/MeshPool.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap::meshing;
+
+namespace {
+    void fill(Mesh& mesh, std::size_t vertexCount)
+    {
+        for (std::size_t i = 0; i < vertexCount; ++i) {
+            mesh.vertices.insert(mesh.vertices.end(), { 1, 2, 3 });
+            mesh.colors.push_back(0);
+            mesh.uvs.insert(mesh.uvs.end(), { 0, 1 });
+        }
+        mesh.triangles.insert(mesh.triangles.end(), vertexCount, 0);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(Meshing_MeshPool)
+
+BOOST_AUTO_TEST_CASE(GivenReleasedMesh_WhenAcquireSameKind_ThenBuffersAreReused)
+{
+    MeshPool pool;
+    auto mesh = pool.acquire("building:1");
+    fill(*mesh, 100);
+    const double* data = mesh->vertices.data();
+    pool.release(mesh.release());
+
+    auto reused = pool.acquire("building:2", true);
+
+    BOOST_CHECK_EQUAL(reused->name, "building:2");
+    BOOST_CHECK(reused->isIndexed);
+    BOOST_CHECK(reused->vertices.empty());
+    BOOST_CHECK(reused->triangles.empty());
+    BOOST_CHECK_EQUAL(reused->vertices.data(), data);
+    BOOST_CHECK_EQUAL(pool.freeCount("building"), 0);
+    pool.release(reused.release());
+}
+
+BOOST_AUTO_TEST_CASE(GivenReleasedMesh_WhenAcquireNewMesh_ThenItIsReservedFromStatistics)
+{
+    MeshPool pool;
+    pool.release(pool.acquire("barrier:1").release());
+    auto first = pool.acquire("barrier:2");
+    fill(*first, 200);
+    pool.release(first.release());
+
+    auto reused = pool.acquire("barrier:3");
+    auto fresh = pool.acquire("barrier:4");
+    auto other = pool.acquire("tree:5");
+
+    BOOST_CHECK_GE(fresh->vertices.capacity(), 600);
+    BOOST_CHECK_GE(fresh->triangles.capacity(), 200);
+    BOOST_CHECK_GE(fresh->uvs.capacity(), 400);
+    BOOST_CHECK_EQUAL(other->vertices.capacity(), 0);
+    for (auto* mesh : { reused.release(), fresh.release(), other.release() })
+        pool.release(mesh);
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyReleasedMeshes_WhenRelease_ThenAmountOfFreeMeshesIsLimited)
+{
+    MeshPool pool;
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    for (int i = 0; i < 10; ++i)
+        meshes.push_back(std::unique_ptr<Mesh>(new Mesh("terrain")));
+
+    for (auto& mesh : meshes)
+        pool.release(mesh.release());
+
+    BOOST_CHECK_EQUAL(pool.freeCount("terrain"), MeshPool::MaxFreeMeshes);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
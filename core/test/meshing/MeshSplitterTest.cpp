@@ -0,0 +1,89 @@
+#include "meshing/MeshSplitter.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <array>
+
+using namespace utymap::meshing;
+
+namespace {
+    /// Creates grid of quads with given amount of cells on every side.
+    void createGrid(int size, std::vector<PackedVertex>& vertices, std::vector<int>& triangles)
+    {
+        for (int y = 0; y <= size; ++y)
+            for (int x = 0; x <= size; ++x)
+                vertices.push_back(PackedVertex { static_cast<float>(x), static_cast<float>(y), 0, 0, 0, 0, 0, 0, 0 });
+
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                int corner = y * (size + 1) + x;
+                triangles.insert(triangles.end(), { corner, corner + 1, corner + size + 1 });
+                triangles.insert(triangles.end(), { corner + 1, corner + size + 2, corner + size + 1 });
+            }
+        }
+    }
+
+    typedef std::array<float, 6> Triangle;
+
+    Triangle getTriangle(const PackedVertex* vertices, int i1, int i2, int i3)
+    {
+        return { { vertices[i1].x, vertices[i1].y, vertices[i2].x, vertices[i2].y, vertices[i3].x, vertices[i3].y } };
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(Meshing_MeshSplitter)
+
+BOOST_AUTO_TEST_CASE(GivenSmallMesh_WhenSplit_ThenSingleChunkWithTheSameIndicesIsReported)
+{
+    std::vector<PackedVertex> vertices;
+    std::vector<int> triangles;
+    createGrid(2, vertices, triangles);
+    int chunks = 0;
+
+    MeshSplitter().split(vertices.data(), vertices.size(), triangles.data(), triangles.size(),
+        [&](const PackedVertex* chunkVertices, std::size_t vertexCount, const std::uint16_t* chunkTriangles, std::size_t triangleCount) {
+        ++chunks;
+        BOOST_CHECK_EQUAL(chunkVertices, vertices.data());
+        BOOST_CHECK_EQUAL(vertexCount, vertices.size());
+        BOOST_CHECK(std::equal(triangles.begin(), triangles.end(), chunkTriangles));
+        BOOST_CHECK_EQUAL(triangleCount, triangles.size());
+    });
+
+    BOOST_CHECK_EQUAL(chunks, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenLargeMesh_WhenSplit_ThenChunksFitLimitAndKeepAllTriangles)
+{
+    const std::size_t MaxVertices = 1000;
+    const int Size = 100;
+    std::vector<PackedVertex> vertices;
+    std::vector<int> triangles;
+    createGrid(Size, vertices, triangles);
+    std::vector<Triangle> expected, actual;
+    for (std::size_t i = 0; i < triangles.size(); i += 3)
+        expected.push_back(getTriangle(vertices.data(), triangles[i], triangles[i + 1], triangles[i + 2]));
+    double chunkArea = 0;
+
+    MeshSplitter(MaxVertices).split(vertices.data(), vertices.size(), triangles.data(), triangles.size(),
+        [&](const PackedVertex* chunkVertices, std::size_t vertexCount, const std::uint16_t* chunkTriangles, std::size_t triangleCount) {
+        BOOST_CHECK(vertexCount <= MaxVertices);
+        float minX = Size, minY = Size, maxX = 0, maxY = 0;
+        for (std::size_t i = 0; i < vertexCount; ++i) {
+            minX = std::min(minX, chunkVertices[i].x);
+            minY = std::min(minY, chunkVertices[i].y);
+            maxX = std::max(maxX, chunkVertices[i].x);
+            maxY = std::max(maxY, chunkVertices[i].y);
+        }
+        chunkArea += (maxX - minX) * (maxY - minY);
+        for (std::size_t i = 0; i < triangleCount; i += 3)
+            actual.push_back(getTriangle(chunkVertices, chunkTriangles[i], chunkTriangles[i + 1], chunkTriangles[i + 2]));
+    });
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    BOOST_CHECK(expected == actual);
+    BOOST_CHECK_LT(chunkArea, 2 * Size * Size);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,52 @@
+#include "meshing/PackedMesh.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap;
+using namespace utymap::meshing;
+
+namespace {
+    const double Precision = 1E-4;
+}
+
+BOOST_AUTO_TEST_SUITE(Meshing_PackedMesh)
+
+BOOST_AUTO_TEST_CASE(GivenMesh_WhenPack_ThenVerticesAreRelativeToOriginAndColorIsSplit)
+{
+    Mesh mesh("name");
+    mesh.vertices = { 13.4051, 52.5201, 10, 13.4061, 52.5211, 20 };
+    mesh.triangles = { 0, 1, 0 };
+    mesh.colors = { static_cast<int>(0xAA0010FF), 0 };
+    mesh.uvs = { 0.5, 0.25, 1, 1 };
+
+    PackedMesh packed = PackedMesh::pack(mesh, GeoCoordinate(52.52, 13.405));
+
+    BOOST_CHECK_EQUAL(packed.name, "name");
+    BOOST_REQUIRE_EQUAL(packed.vertices.size(), 2);
+    BOOST_CHECK_EQUAL(packed.triangles.size(), 3);
+    const PackedVertex& vertex = packed.vertices[0];
+    BOOST_CHECK_CLOSE(vertex.x, 0.0001, Precision * 100);
+    BOOST_CHECK_CLOSE(vertex.y, 0.0001, Precision * 100);
+    BOOST_CHECK_EQUAL(vertex.z, 10);
+    BOOST_CHECK_EQUAL(vertex.r, 0xAA);
+    BOOST_CHECK_EQUAL(vertex.g, 0x00);
+    BOOST_CHECK_EQUAL(vertex.b, 0x10);
+    BOOST_CHECK_EQUAL(vertex.a, 0xFF);
+    BOOST_CHECK_EQUAL(vertex.u, 0.5);
+    BOOST_CHECK_EQUAL(vertex.v, 0.25);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMeshWithoutUvs_WhenPack_ThenUvsAreZero)
+{
+    Mesh mesh("");
+    mesh.vertices = { 1, 2, 3 };
+    mesh.colors = { 0 };
+
+    PackedMesh packed = PackedMesh::pack(mesh, GeoCoordinate(0, 0));
+
+    BOOST_REQUIRE_EQUAL(packed.vertices.size(), 1);
+    BOOST_CHECK_EQUAL(packed.vertices[0].u, 0);
+    BOOST_CHECK_EQUAL(packed.vertices[0].v, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,69 @@
+#include "meshing/StraightSkeleton.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <vector>
+
+using namespace utymap::meshing;
+
+namespace {
+    const double Precision = 1E-9;
+
+    /// Checks that every face starts with its edge and nodes are not farther than max time.
+    void checkFaces(const StraightSkeleton& skeleton, std::size_t edgeCount)
+    {
+        BOOST_REQUIRE_EQUAL(skeleton.getFaces().size(), edgeCount);
+        for (std::size_t i = 0; i < edgeCount; ++i) {
+            const auto& face = skeleton.getFaces()[i];
+            BOOST_REQUIRE_GT(face.size(), 2);
+            BOOST_CHECK_EQUAL(face[0], i);
+            BOOST_CHECK_EQUAL(face[1], (i + 1) % edgeCount);
+            for (std::size_t node : face)
+                BOOST_CHECK_LE(skeleton.getNodes()[node].time, skeleton.getMaxTime() + Precision);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(Meshing_StraightSkeleton)
+
+BOOST_AUTO_TEST_CASE(GivenRectangle_WhenCompute_ThenRidgeIsInTheMiddle)
+{
+    StraightSkeleton skeleton({ { 0, 0 }, { 10, 0 }, { 10, 4 }, { 0, 4 } });
+
+    BOOST_REQUIRE(skeleton.isValid());
+    checkFaces(skeleton, 4);
+    BOOST_CHECK_CLOSE(skeleton.getMaxTime(), 2, Precision);
+    const auto& ends = skeleton.getFaces()[1];
+    BOOST_REQUIRE_EQUAL(ends.size(), 3);
+    BOOST_CHECK_CLOSE(skeleton.getNodes()[ends[2]].position.x, 8, Precision);
+    BOOST_CHECK_CLOSE(skeleton.getNodes()[ends[2]].position.y, 2, Precision);
+}
+
+BOOST_AUTO_TEST_CASE(GivenClockwiseLShape_WhenCompute_ThenFacesAreBuilt)
+{
+    StraightSkeleton skeleton({ { 0, 0 }, { 0, 10 }, { 4, 10 }, { 4, 4 }, { 10, 4 }, { 10, 0 } });
+
+    BOOST_REQUIRE(skeleton.isValid());
+    checkFaces(skeleton, 6);
+    BOOST_CHECK_CLOSE(skeleton.getMaxTime(), 2, Precision);
+}
+
+BOOST_AUTO_TEST_CASE(GivenComplexFootprint_WhenCompute_ThenFacesAreBuilt)
+{
+    // star like footprint with many reflex vertices produces split events.
+    const std::size_t count = 400;
+    std::vector<Vector2> contour;
+    for (std::size_t i = 0; i < count; ++i) {
+        double angle = 2 * std::acos(-1) * i / count;
+        double radius = 100 + (i % 2 == 0 ? 10 : 0) + 20 * std::sin(angle * 7);
+        contour.push_back(Vector2(radius * std::cos(angle), radius * std::sin(angle)));
+    }
+
+    StraightSkeleton skeleton(contour);
+
+    BOOST_REQUIRE(skeleton.isValid());
+    checkFaces(skeleton, count);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
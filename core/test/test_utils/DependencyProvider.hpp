@@ -20,6 +20,7 @@ public:
         stringTable_.reset();
         std::remove("string.idx");
         std::remove("string.dat");
+        std::remove("string.hsh");
     }
 
     std::shared_ptr<utymap::index::StringTable> getStringTable()
@@ -0,0 +1,96 @@
+#include "entities/ElementCopier.hpp"
+#include "utils/Arena.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace utymap::entities;
+using namespace utymap::utils;
+
+BOOST_AUTO_TEST_SUITE(Utils_Arena)
+
+BOOST_AUTO_TEST_CASE(GivenArena_WhenAllocate_ThenMemoryIsAlignedAndNotOverlapped)
+{
+    Arena arena(1024);
+
+    char* first = static_cast<char*>(arena.allocate(3, 1));
+    auto second = static_cast<double*>(arena.allocate(sizeof(double), alignof(double)));
+    char* large = static_cast<char*>(arena.allocate(4096));
+
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(second) % alignof(double), 0);
+    BOOST_CHECK(reinterpret_cast<char*>(second) >= first + 3);
+    BOOST_CHECK(large + 4096 <= first || large >= reinterpret_cast<char*>(second + 1));
+    BOOST_CHECK_EQUAL(arena.getUsed(), 3 + sizeof(double) + 4096);
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyBlocks_WhenReset_ThenSingleBlockIsKept)
+{
+    Arena arena(1024);
+    for (int i = 0; i < 10; ++i)
+        arena.allocate(512);
+    std::size_t capacity = arena.getCapacity();
+
+    arena.reset();
+    arena.allocate(512);
+
+    BOOST_CHECK_EQUAL(arena.getUsed(), 512);
+    BOOST_CHECK_EQUAL(arena.getCapacity(), capacity);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSingleBlockLargerThanRetainedSize_WhenReset_ThenBlockIsTrimmed)
+{
+    const std::size_t retainedSize = Arena::MaxRetainedSize;
+    Arena arena;
+    arena.allocate(retainedSize + 1);
+
+    arena.reset();
+
+    BOOST_CHECK_EQUAL(arena.getCapacity(), retainedSize);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNestedScopes_WhenInnerIsDestroyed_ThenArenaIsResetOnlyByOuter)
+{
+    Arena arena;
+    {
+        Arena::Scope outer(arena);
+        arena.allocate(16);
+        {
+            Arena::Scope inner(arena);
+            arena.allocate(16);
+        }
+        BOOST_CHECK_EQUAL(arena.getUsed(), 32);
+    }
+
+    BOOST_CHECK_EQUAL(arena.getUsed(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenArenaAllocator_WhenFillVector_ThenMemoryIsTakenFromArena)
+{
+    Arena arena;
+    std::vector<int, ArenaAllocator<int>> values((ArenaAllocator<int>(arena)));
+
+    for (int i = 0; i < 100; ++i)
+        values.push_back(i);
+
+    BOOST_CHECK_EQUAL(values[99], 99);
+    BOOST_CHECK_GE(arena.getUsed(), 100 * sizeof(int));
+}
+
+BOOST_AUTO_TEST_CASE(GivenArena_WhenCopyElement_ThenCopyIsAllocatedFromArena)
+{
+    Arena arena;
+    Way way;
+    way.id = 7;
+    way.coordinates = { { 1, 2 }, { 3, 4 } };
+    ElementCopier copier(&arena);
+
+    way.accept(copier);
+
+    BOOST_CHECK_EQUAL(copier.element->id, 7);
+    BOOST_CHECK_EQUAL(static_cast<const Way&>(*copier.element).coordinates.size(), 2);
+    BOOST_CHECK_GE(arena.getUsed(), sizeof(Way));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
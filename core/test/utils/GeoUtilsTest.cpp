@@ -91,4 +91,33 @@ BOOST_AUTO_TEST_CASE(GivenBboxAtLodOne_WhenVisitTileRange_VisitsTwoTiles)
     BOOST_CHECK_EQUAL(2, count);
 }
 
+BOOST_AUTO_TEST_CASE(GivenBboxAtDifferentLods_WhenVisitTileRange_ThenBoundingBoxesMatchQuadKeys)
+{
+    BoundingBox bbox(GeoCoordinate(TestLatitude, TestLongitude), GeoCoordinate(TestLatitude + 0.01, TestLongitude + 0.01));
+
+    for (int lod : { 9, 16, 17, 19 }) {
+        int count = 0;
+        GeoUtils::visitTileRange(bbox, lod, [&](const QuadKey& quadKey, const BoundingBox& quadKeyBbox) {
+            BoundingBox expected = GeoUtils::quadKeyToBoundingBox(quadKey);
+            BOOST_CHECK_EQUAL(quadKeyBbox.minPoint.latitude, expected.minPoint.latitude);
+            BOOST_CHECK_EQUAL(quadKeyBbox.maxPoint.latitude, expected.maxPoint.latitude);
+            BOOST_CHECK_EQUAL(quadKeyBbox.minPoint.longitude, expected.minPoint.longitude);
+            BOOST_CHECK_EQUAL(quadKeyBbox.maxPoint.longitude, expected.maxPoint.longitude);
+            BOOST_CHECK_CLOSE(quadKeyBbox.width(), GeoUtils::getTileWidth(lod), Precision);
+            count++;
+        });
+        BOOST_CHECK(count > 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GivenQuadKeyAtNineLod_WhenGetBoundgingBox_ThenReturnValidBoundingBox)
+{
+    utymap::BoundingBox boundingBox = GeoUtils::quadKeyToBoundingBox(QuadKey(9, 275, 167));
+
+    BOOST_CHECK_CLOSE(boundingBox.minPoint.latitude, 52.48278022207821, Precision);
+    BOOST_CHECK_CLOSE(boundingBox.maxPoint.latitude, 52.908902047770255, Precision);
+    BOOST_CHECK_CLOSE(boundingBox.minPoint.longitude, 13.359375, Precision);
+    BOOST_CHECK_CLOSE(boundingBox.maxPoint.longitude, 14.0625, Precision);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,8 +1,14 @@
 #include "meshing/Polygon.hpp"
+#include "BoundingBox.hpp"
 #include "utils/GeometryUtils.hpp"
+#include "utils/GeoUtils.hpp"
 
 #include <boost/test/unit_test.hpp>
 
+#include <cmath>
+#include <deque>
+#include <limits>
+
 using namespace utymap;
 using namespace utymap::meshing;
 using namespace utymap::utils;
@@ -39,4 +45,106 @@ BOOST_AUTO_TEST_CASE(GivenRectangle_WhenGetCircle_ThenReturnsCorrectCircle)
     BOOST_CHECK_EQUAL(2, radius);
 }
 
+BOOST_AUTO_TEST_CASE(GivenClockwiseConcavePolygon_WhenTriangulateSimplePolygon_ThenReturnsCounterClockwiseTriangles)
+{
+    // L shape
+    std::vector<double> points = { 0, 0, 0, 2, 1, 2, 1, 1, 2, 1, 2, 0 };
+    std::vector<int> triangles;
+
+    BOOST_REQUIRE(triangulateSimplePolygon(points, triangles));
+
+    BOOST_REQUIRE_EQUAL(triangles.size(), 4 * 3);
+    double area = 0;
+    for (std::size_t i = 0; i < triangles.size(); i += 3) {
+        int a = triangles[i], b = triangles[i + 1], c = triangles[i + 2];
+        double cross = (points[b * 2] - points[a * 2]) * (points[c * 2 + 1] - points[a * 2 + 1]) -
+                       (points[b * 2 + 1] - points[a * 2 + 1]) * (points[c * 2] - points[a * 2]);
+        BOOST_CHECK_GT(cross, 0);
+        area += cross / 2;
+    }
+    BOOST_CHECK_CLOSE(area, 3, 1E-9);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSelfIntersectingPolygon_WhenTriangulateSimplePolygon_ThenReturnsFalse)
+{
+    std::vector<double> points = { 0, 0, 2, 2, 2, 0, 0, 2 };
+    std::vector<int> triangles;
+
+    BOOST_CHECK(!triangulateSimplePolygon(points, triangles));
+}
+
+BOOST_AUTO_TEST_CASE(GivenNoisySquare_WhenSimplifyContour_ThenCornersAreKept)
+{
+    std::vector<Vector2> contour = { { 0, 0 }, { 5, 0.01 }, { 10, 0 }, { 10, 5 }, { 9.99, 7 }, { 10, 10 }, { 0, 10 }, { 0, 0 } };
+
+    auto result = simplifyContour(contour, 0.1);
+
+    BOOST_CHECK(result == std::vector<Vector2>({ { 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 } }));
+}
+
+BOOST_AUTO_TEST_CASE(GivenNoisyPath_WhenSimplifyPath_ThenEndsAndFarPointsAreKept)
+{
+    std::vector<GeoCoordinate> path = { { 0, 0 }, { 0.01, 1 }, { 0, 2 }, { 1, 3 }, { 0, 4 } };
+    std::vector<GeoCoordinate> result;
+
+    BOOST_CHECK(simplifyPath(path, 0.1, false, result));
+
+    BOOST_CHECK(result == std::vector<GeoCoordinate>({ { 0, 0 }, { 0, 2 }, { 1, 3 }, { 0, 4 } }));
+    BOOST_CHECK(!simplifyPath(result, 0.1, false, path));
+}
+
+BOOST_AUTO_TEST_CASE(GivenBowTiePolygon_WhenIsSimplePolygon_ThenReturnsFalse)
+{
+    std::vector<GeoCoordinate> square = { { 0, 0 }, { 0, 1 }, { 1, 1 }, { 1, 0 } };
+    std::vector<GeoCoordinate> bowTie = { { 0, 0 }, { 1, 1 }, { 1, 0 }, { 0, 1 } };
+
+    BOOST_CHECK(isSimplePolygon(square));
+    BOOST_CHECK(!isSimplePolygon(bowTie));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStar_WhenUseGeometryKernels_ThenResultsMatchScalarLoops)
+{
+    std::vector<GeoCoordinate> star;
+    for (int i = 0; i < 23; ++i) {
+        double angle = 2 * M_PI * i / 23;
+        double radius = i % 2 == 0 ? 0.01 : 0.004;
+        star.push_back(GeoCoordinate(52.5 + radius * std::sin(angle), 13.4 + radius * std::cos(angle)));
+    }
+    std::deque<GeoCoordinate> scalar(star.begin(), star.end());
+
+    BoundingBox expected, actual;
+    expected.expand(scalar.begin(), scalar.end());
+    actual.expand(star.cbegin(), star.cend());
+    BOOST_CHECK_EQUAL(actual.minPoint.latitude, expected.minPoint.latitude);
+    BOOST_CHECK_EQUAL(actual.minPoint.longitude, expected.minPoint.longitude);
+    BOOST_CHECK_EQUAL(actual.maxPoint.latitude, expected.maxPoint.latitude);
+    BOOST_CHECK_EQUAL(actual.maxPoint.longitude, expected.maxPoint.longitude);
+
+    BOOST_CHECK_CLOSE(getArea(star), getArea(scalar), 1E-6);
+    BOOST_CHECK(getArea(star) > 0);
+    std::reverse(star.begin(), star.end());
+    BOOST_CHECK(isClockwise(star));
+
+    for (int i = -12; i <= 12; ++i) {
+        for (int j = -12; j <= 12; ++j) {
+            GeoCoordinate point(52.5 + i * 0.00083, 13.4 + j * 0.00087);
+            BOOST_CHECK_EQUAL(GeoUtils::isPointInPolygon(point, star.begin(), star.end()),
+                              GeoUtils::isPointInPolygon(point, scalar.rbegin(), scalar.rend()));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GivenNanCoordinate_WhenExpandBoundingBox_ThenItIsIgnored)
+{
+    std::vector<GeoCoordinate> coordinates = { { 1, 2 }, { std::numeric_limits<double>::quiet_NaN(), 5 }, { 3, -1 } };
+    BoundingBox bbox;
+
+    bbox.expand(coordinates.begin(), coordinates.end());
+
+    BOOST_CHECK_EQUAL(bbox.minPoint.latitude, 1);
+    BOOST_CHECK_EQUAL(bbox.minPoint.longitude, -1);
+    BOOST_CHECK_EQUAL(bbox.maxPoint.latitude, 3);
+    BOOST_CHECK_EQUAL(bbox.maxPoint.longitude, 5);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
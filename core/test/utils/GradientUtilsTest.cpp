@@ -58,4 +58,19 @@ BOOST_AUTO_TEST_CASE(GivenColorString_WhenParseGradient_ThenReturnValid)
     BOOST_CHECK_EQUAL(gradient->evaluate(0), 0xEC8859FF);
 }
 
+BOOST_AUTO_TEST_CASE(GivenGradient_WhenLookup_ThenReturnColorCloseToEvaluated)
+{
+    auto gradient = GradientUtils::parseGradient("gradient(#0fffff, #099999 50%, #033333 70%, #000000)");
+
+    BOOST_CHECK_EQUAL(gradient->lookup(0), gradient->evaluate(0));
+    BOOST_CHECK_EQUAL(gradient->lookup(1), gradient->evaluate(1));
+    BOOST_CHECK_EQUAL(gradient->lookup(-1), gradient->evaluate(0));
+    Color expected = gradient->evaluate(0.6);
+    Color actual = static_cast<int>(gradient->lookup(0.6));
+    BOOST_CHECK_LE(std::abs(expected.r - actual.r), 2);
+    BOOST_CHECK_LE(std::abs(expected.g - actual.g), 2);
+    BOOST_CHECK_LE(std::abs(expected.b - actual.b), 2);
+    BOOST_CHECK_EQUAL(ColorGradient().lookup(0.5), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
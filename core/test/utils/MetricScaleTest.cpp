@@ -0,0 +1,36 @@
+#include "BoundingBox.hpp"
+#include "QuadKey.hpp"
+#include "utils/GeoUtils.hpp"
+#include "utils/MetricScale.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap;
+using namespace utymap::utils;
+
+namespace {
+    const double Precision = 1E-9;
+}
+
+BOOST_AUTO_TEST_SUITE(Utils_MetricScale)
+
+BOOST_AUTO_TEST_CASE(GivenTileCenter_WhenToDegrees_ThenOffsetIsTheSameAsDirectConversion)
+{
+    BoundingBox bbox = GeoUtils::quadKeyToBoundingBox(QuadKey(16, 35205, 21489));
+    MetricScale scale(bbox);
+
+    BOOST_CHECK_CLOSE(scale.toDegrees(bbox.center(), 10), GeoUtils::getOffset(bbox.center(), 10), Precision);
+}
+
+BOOST_AUTO_TEST_CASE(GivenLargeTile_WhenToDegreesInsideAndOutside_ThenOffsetIsCloseToDirectConversion)
+{
+    BoundingBox bbox = GeoUtils::quadKeyToBoundingBox(QuadKey(1, 1, 0));
+    MetricScale scale(bbox);
+    GeoCoordinate inside(bbox.minPoint.latitude + 13.7, 10);
+    GeoCoordinate outside(bbox.minPoint.latitude - 10, 10);
+
+    BOOST_CHECK_CLOSE(scale.toDegrees(inside, 100), GeoUtils::getOffset(inside, 100), 1E-2);
+    BOOST_CHECK_EQUAL(scale.toDegrees(outside, 100), GeoUtils::getOffset(outside, 100));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
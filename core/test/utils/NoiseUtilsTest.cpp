@@ -2,6 +2,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <vector>
+
 using namespace utymap::utils;
 
 namespace {
@@ -18,4 +20,19 @@ BOOST_AUTO_TEST_CASE(GivenTestValues_WhenPerlin3d_ThenReturnExpectedValues)
     BOOST_CHECK_CLOSE(NoiseUtils::perlin3D(52, 120, 13, 0.12), -0.1014592, Tolerance);
 }
 
+BOOST_AUTO_TEST_CASE(GivenPoints_WhenPerlin2dBatch_ThenReturnsSameValuesAsScalar)
+{
+    std::vector<double> points;
+    for (int i = 0; i < 150; ++i) {
+        points.push_back(i * 1.37 - 40);
+        points.push_back(i * 0.73 + 12);
+    }
+    std::vector<double> noise(points.size() / 2);
+
+    NoiseUtils::perlin2D(points.data(), noise.size(), 0.1, noise.data());
+
+    for (std::size_t i = 0; i < noise.size(); ++i)
+        BOOST_CHECK_EQUAL(noise[i], NoiseUtils::perlin2D(points[i * 2], points[i * 2 + 1], 0.1));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,74 @@
+#include "utils/Statistics.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <vector>
+
+using namespace utymap::utils;
+
+namespace {
+    struct Utils_StatisticsFixture
+    {
+        Utils_StatisticsFixture() { Statistics::instance().reset(); }
+        ~Utils_StatisticsFixture() { Statistics::instance().reset(); }
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(Utils_Statistics, Utils_StatisticsFixture)
+
+BOOST_AUTO_TEST_CASE(GivenTwoScopes_WhenTheyEnd_ThenCallsAreCounted)
+{
+    {
+        Statistics::Scope first(Statistics::Stage::Triangulation);
+        Statistics::Scope second(Statistics::Stage::Triangulation);
+    }
+
+    BOOST_CHECK_EQUAL(Statistics::instance().getCalls(Statistics::Stage::Triangulation), 2);
+    BOOST_CHECK_EQUAL(Statistics::instance().getCalls(Statistics::Stage::MeshCallback), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenAddedTime_WhenToJson_ThenStageHasCallsAndTime)
+{
+    Statistics::instance().add(Statistics::Stage::StyleMatching, 2500000);
+
+    std::string json = Statistics::instance().toJson();
+
+    BOOST_CHECK(json.find("\"style_matching\":{\"calls\":1,\"ms\":2.5") != std::string::npos);
+    BOOST_CHECK(json.find("\"mesh_callback\":{\"calls\":0,\"ms\":0") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(GivenAddedTime_WhenReset_ThenStatisticsAreEmpty)
+{
+    Statistics::instance().add(Statistics::Stage::QuadKeyBuild, 10);
+
+    Statistics::instance().reset();
+
+    BOOST_CHECK_EQUAL(Statistics::instance().getCalls(Statistics::Stage::QuadKeyBuild), 0);
+    BOOST_CHECK_EQUAL(Statistics::instance().getNanoseconds(Statistics::Stage::QuadKeyBuild), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenAllocationInScope_WhenItEnds_ThenAllocationIsCountedIfEnabled)
+{
+    {
+        Statistics::Scope scope(Statistics::Stage::Import);
+        std::vector<int> values(16);
+    }
+
+    BOOST_CHECK_EQUAL(Statistics::instance().getAllocations(Statistics::Stage::Import),
+                      AllocationCounter::isEnabled() ? 1 : 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenAllocationInOtherThread_WhenTotalIsRead_ThenAllocationIsCountedIfEnabled)
+{
+    std::uint64_t total = AllocationCounter::total();
+
+    std::thread([]() { std::vector<int> values(16); }).join();
+
+    if (AllocationCounter::isEnabled())
+        BOOST_CHECK_GE(AllocationCounter::total() - total, 1);
+    else
+        BOOST_CHECK_EQUAL(AllocationCounter::total(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
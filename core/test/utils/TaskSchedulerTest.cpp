@@ -0,0 +1,86 @@
+#include "utils/TaskScheduler.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <stdexcept>
+
+using namespace utymap::utils;
+
+BOOST_AUTO_TEST_SUITE(Utils_TaskScheduler)
+
+BOOST_AUTO_TEST_CASE(GivenManyTasks_WhenWait_ThenAllOfThemAreRun)
+{
+    TaskScheduler scheduler(4);
+    std::atomic<int> count(0);
+    TaskGroup group(TaskPriority::Normal, CancellationToken(), scheduler);
+
+    for (int i = 0; i < 1000; ++i)
+        group.run([&]() { ++count; });
+    group.wait();
+
+    BOOST_CHECK_EQUAL(count, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNestedGroupsOnSingleThread_WhenWait_ThenTheyDoNotBlockEachOther)
+{
+    TaskScheduler scheduler(1);
+    std::atomic<int> count(0);
+    TaskGroup outer(TaskPriority::Normal, CancellationToken(), scheduler);
+
+    for (int i = 0; i < 10; ++i) {
+        outer.run([&]() {
+            TaskGroup inner(TaskPriority::High, CancellationToken(), scheduler);
+            for (int j = 0; j < 10; ++j)
+                inner.run([&]() { ++count; });
+            inner.wait();
+        });
+    }
+    outer.wait();
+
+    BOOST_CHECK_EQUAL(count, 100);
+}
+
+BOOST_AUTO_TEST_CASE(GivenThrowingTask_WhenWait_ThenExceptionIsRethrown)
+{
+    TaskScheduler scheduler(2);
+    TaskGroup group(TaskPriority::Normal, CancellationToken(), scheduler);
+
+    group.run([]() { throw std::domain_error("Test error."); });
+
+    BOOST_CHECK_THROW(group.wait(), std::domain_error);
+    BOOST_CHECK_NO_THROW(group.wait());
+}
+
+BOOST_AUTO_TEST_CASE(GivenCancelledToken_WhenWait_ThenPendingTasksAreSkipped)
+{
+    TaskScheduler scheduler(1);
+    CancellationToken token;
+    std::atomic<int> count(0);
+    TaskGroup group(TaskPriority::Low, token, scheduler);
+
+    token.cancel();
+    for (int i = 0; i < 10; ++i)
+        group.run([&]() { ++count; });
+    group.wait();
+
+    BOOST_CHECK(group.isCancelled());
+    BOOST_CHECK_EQUAL(count, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPendingTasks_WhenConfigure_ThenTheyAreRunByNewThreads)
+{
+    TaskScheduler scheduler(1);
+    std::atomic<int> count(0);
+    TaskGroup group(TaskPriority::Normal, CancellationToken(), scheduler);
+    for (int i = 0; i < 100; ++i)
+        group.run([&]() { ++count; });
+
+    scheduler.configure(3, true);
+    group.wait();
+
+    BOOST_CHECK_EQUAL(scheduler.getThreadCount(), 3);
+    BOOST_CHECK_EQUAL(count, 100);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,59 @@
+#include "utils/TraceRecorder.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace utymap::utils;
+
+namespace {
+    const std::string TracePath = "trace.json";
+
+    struct Utils_TraceRecorderFixture
+    {
+        ~Utils_TraceRecorderFixture() { std::remove(TracePath.c_str()); }
+
+        std::string readTrace() const
+        {
+            std::ifstream file(TracePath);
+            std::stringstream ss;
+            ss << file.rdbuf();
+            return ss.str();
+        }
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(Utils_TraceRecorder, Utils_TraceRecorderFixture)
+
+BOOST_AUTO_TEST_CASE(GivenStartedRecorder_WhenScopeEnds_ThenEventIsWritten)
+{
+    TraceRecorder::instance().start();
+    {
+        TraceRecorder::Scope scope("test_event", "test");
+    }
+
+    TraceRecorder::instance().stop(TracePath);
+
+    std::string trace = readTrace();
+    BOOST_CHECK(trace.find("\"traceEvents\":[") != std::string::npos);
+    BOOST_CHECK(trace.find("{\"name\":\"test_event\",\"cat\":\"test\",\"ph\":\"X\"") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoppedRecorder_WhenScopeEnds_ThenEventIsNotWritten)
+{
+    TraceRecorder::instance().start();
+    TraceRecorder::instance().stop(TracePath);
+    {
+        TraceRecorder::Scope scope("test_event", "test");
+    }
+    TraceRecorder::instance().start();
+
+    TraceRecorder::instance().stop(TracePath);
+
+    BOOST_CHECK(readTrace().find("test_event") == std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()